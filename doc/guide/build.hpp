@@ -107,6 +107,17 @@ want to build everything in the library:
 $ make pca allknn allkfn
 @endcode
 
+The benchmarks are not built by default.  'mlpack_bench' times the tree-based
+algorithms, k-means, and the optimizers on reproducible random datasets, and
+writes the results as JSON; a previous results file can be given with
+--baseline_file to report regressions:
+
+@code
+$ make mlpack_bench
+$ bin/mlpack_bench -o baseline.json
+$ bin/mlpack_bench -o new.json --baseline_file baseline.json
+@endcode
+
 If the build fails and you cannot figure out why, register an account on Trac
 and submit a ticket and the MLPACK developers will quickly help you figure it
 out:
@@ -0,0 +1,327 @@
+/**
+ * @file benchmark.cpp
+ *
+ * Implementation of the benchmark harness.
+ */
+#include "benchmark.hpp"
+
+#include <mlpack/core/util/profiler.hpp>
+#include <mlpack/core/util/version.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::bench;
+
+namespace {
+
+//! Return the string quoted and escaped for JSON.
+std::string Quote(const std::string& text)
+{
+  std::string quoted = "\"";
+  for (size_t i = 0; i < text.size(); ++i)
+  {
+    if (text[i] == '"' || text[i] == '\\')
+      quoted += '\\';
+    quoted += text[i];
+  }
+
+  return quoted + "\"";
+}
+
+} // anonymous namespace
+
+Benchmark::Benchmark(const std::string& name) :
+    name(name),
+    start(0),
+    items(0)
+{
+  // Nothing to do.
+}
+
+Benchmark& Benchmark::Parameter(const std::string& name, const double value)
+{
+  numericParameters[name] = value;
+  return *this;
+}
+
+Benchmark& Benchmark::Parameter(const std::string& name,
+                                const std::string& value)
+{
+  stringParameters[name] = value;
+  return *this;
+}
+
+void Benchmark::Start()
+{
+  start = Profiler::MonotonicNanoseconds();
+}
+
+void Benchmark::Stop()
+{
+  times.push_back((Profiler::MonotonicNanoseconds() - start) / 1e9);
+}
+
+void Benchmark::Items(const double items, const std::string& unit)
+{
+  this->items = items;
+  this->unit = unit;
+}
+
+std::string Benchmark::Key() const
+{
+  // The parameters are kept sorted by name, so the key does not depend on the
+  // order they were given in.
+  std::ostringstream key;
+  key << name << "(";
+  bool first = true;
+  for (std::map<std::string, double>::const_iterator it =
+      numericParameters.begin(); it != numericParameters.end(); ++it)
+  {
+    key << (first ? "" : ", ") << it->first << "=" << it->second;
+    first = false;
+  }
+  for (std::map<std::string, std::string>::const_iterator it =
+      stringParameters.begin(); it != stringParameters.end(); ++it)
+  {
+    key << (first ? "" : ", ") << it->first << "=" << it->second;
+    first = false;
+  }
+  key << ")";
+
+  return key.str();
+}
+
+double Benchmark::Min() const
+{
+  return times.empty() ? 0.0 : *std::min_element(times.begin(), times.end());
+}
+
+double Benchmark::Median() const
+{
+  if (times.empty())
+    return 0.0;
+
+  std::vector<double> sorted(times);
+  std::sort(sorted.begin(), sorted.end());
+  const size_t middle = sorted.size() / 2;
+  return (sorted.size() % 2 == 1) ? sorted[middle] :
+      (sorted[middle - 1] + sorted[middle]) / 2;
+}
+
+double Benchmark::Mean() const
+{
+  double total = 0.0;
+  for (size_t i = 0; i < times.size(); ++i)
+    total += times[i];
+
+  return times.empty() ? 0.0 : total / times.size();
+}
+
+double Benchmark::ItemsPerSecond() const
+{
+  const double median = Median();
+  return (median > 0) ? items / median : 0.0;
+}
+
+void Benchmark::WriteJSON(std::ostream& stream) const
+{
+  stream << "{\"name\": " << Quote(name) << ", \"key\": " << Quote(Key())
+      << ", \"parameters\": {";
+  bool first = true;
+  for (std::map<std::string, double>::const_iterator it =
+      numericParameters.begin(); it != numericParameters.end(); ++it)
+  {
+    stream << (first ? "" : ", ") << Quote(it->first) << ": " << it->second;
+    first = false;
+  }
+  for (std::map<std::string, std::string>::const_iterator it =
+      stringParameters.begin(); it != stringParameters.end(); ++it)
+  {
+    stream << (first ? "" : ", ") << Quote(it->first) << ": "
+        << Quote(it->second);
+    first = false;
+  }
+
+  stream << "}, \"times\": [";
+  for (size_t i = 0; i < times.size(); ++i)
+    stream << (i == 0 ? "" : ", ") << times[i];
+  stream << "], \"min\": " << Min() << ", \"median\": " << Median()
+      << ", \"mean\": " << Mean();
+  if (!unit.empty())
+    stream << ", \"items\": " << items << ", \"unit\": " << Quote(unit)
+        << ", \"items_per_second\": " << ItemsPerSecond();
+  stream << "}";
+}
+
+Suite::Suite(const size_t trials,
+             const size_t seed,
+             const std::string& filter,
+             const bool quick) :
+    trials(trials),
+    seed(seed),
+    filter(filter),
+    quick(quick)
+{
+  // Nothing to do.
+}
+
+bool Suite::Enabled(const std::string& name) const
+{
+  return filter.empty() || (name.find(filter) != std::string::npos);
+}
+
+void Suite::Seed() const
+{
+  math::RandomSeed(seed);
+}
+
+std::vector<Problem> Suite::Problems() const
+{
+  const size_t scale = quick ? 10 : 1;
+  const Problem defaults = { 10000 / scale, 3, 5, 20 };
+
+  std::vector<Problem> problems;
+  problems.push_back(defaults);
+
+  const size_t ns[] = { 1000, 100000 };
+  for (size_t i = 0; i < 2; ++i)
+  {
+    Problem problem = defaults;
+    problem.n = ns[i] / scale;
+    problems.push_back(problem);
+  }
+
+  const size_t ds[] = { 2, 5, 10, 20 };
+  for (size_t i = 0; i < 4; ++i)
+  {
+    Problem problem = defaults;
+    problem.d = ds[i];
+    problems.push_back(problem);
+  }
+
+  const size_t ks[] = { 1, 20 };
+  for (size_t i = 0; i < 2; ++i)
+  {
+    Problem problem = defaults;
+    problem.k = ks[i];
+    problems.push_back(problem);
+  }
+
+  const size_t leafSizes[] = { 1, 5, 50 };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    Problem problem = defaults;
+    problem.leafSize = leafSizes[i];
+    problems.push_back(problem);
+  }
+
+  return problems;
+}
+
+bool Suite::Contains(const Benchmark& benchmark) const
+{
+  const std::string key = benchmark.Key();
+  for (size_t i = 0; i < benchmarks.size(); ++i)
+    if (benchmarks[i].Key() == key)
+      return true;
+
+  return false;
+}
+
+void Suite::Add(const Benchmark& benchmark)
+{
+  benchmarks.push_back(benchmark);
+
+  Log::Info << benchmark.Key() << ": " << benchmark.Median() << "s median, "
+      << benchmark.Min() << "s min";
+  if (benchmark.ItemsPerSecond() > 0)
+    Log::Info << ", " << benchmark.ItemsPerSecond() << " items/s";
+  Log::Info << "." << std::endl;
+}
+
+bool Suite::WriteJSON(const std::string& filename) const
+{
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::trunc);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << filename << "' to write the benchmark "
+        << "results to." << std::endl;
+    return false;
+  }
+
+  size_t threads = 1;
+#ifdef HAS_OPENMP
+  threads = (size_t) omp_get_max_threads();
+#endif
+
+  stream << std::setprecision(10);
+  stream << "{\"version\": " << Quote(util::GetVersion()) << ",\n"
+      << " \"trials\": " << trials << ",\n"
+      << " \"seed\": " << seed << ",\n"
+      << " \"quick\": " << (quick ? "true" : "false") << ",\n"
+      << " \"threads\": " << threads << ",\n"
+      << " \"benchmarks\": [";
+  for (size_t i = 0; i < benchmarks.size(); ++i)
+  {
+    stream << (i == 0 ? "\n  " : ",\n  ");
+    benchmarks[i].WriteJSON(stream);
+  }
+  stream << "\n]}" << std::endl;
+
+  return stream.good();
+}
+
+int Suite::Compare(const std::string& filename, const double tolerance) const
+{
+  boost::property_tree::ptree baseline;
+  try
+  {
+    boost::property_tree::read_json(filename, baseline);
+  }
+  catch (boost::property_tree::json_parser_error& e)
+  {
+    Log::Warn << "Cannot read baseline file '" << filename << "': " << e.what()
+        << std::endl;
+    return -1;
+  }
+
+  // Collect the baseline median times.
+  std::map<std::string, double> medians;
+  boost::property_tree::ptree empty;
+  const boost::property_tree::ptree& results =
+      baseline.get_child("benchmarks", empty);
+  for (boost::property_tree::ptree::const_iterator it = results.begin();
+       it != results.end(); ++it)
+    medians[it->second.get<std::string>("key", "")] =
+        it->second.get<double>("median", 0.0);
+
+  int regressions = 0;
+  for (size_t i = 0; i < benchmarks.size(); ++i)
+  {
+    std::map<std::string, double>::const_iterator it =
+        medians.find(benchmarks[i].Key());
+    if (it == medians.end() || it->second <= 0)
+      continue;
+
+    const double ratio = benchmarks[i].Median() / it->second;
+    if (ratio > 1 + tolerance)
+    {
+      Log::Warn << benchmarks[i].Key() << " is " << (100 * (ratio - 1))
+          << "% slower than the baseline (" << benchmarks[i].Median()
+          << "s median; baseline " << it->second << "s)." << std::endl;
+      ++regressions;
+    }
+  }
+
+  return regressions;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file benchmark.hpp
+ *
+ * A small harness for timing mlpack's algorithms reproducibly and writing the
+ * results as JSON, used by the mlpack_bench program.
+ */
+#ifndef __MLPACK_BENCH_BENCHMARK_HPP
+#define __MLPACK_BENCH_BENCHMARK_HPP
+
+#include <mlpack/core.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace mlpack {
+namespace bench {
+
+/**
+ * The timings of one benchmark with one set of parameters.  Each trial is
+ * timed separately, between Start() and Stop(), so that setup (such as copying
+ * the dataset) can be left out:
+ *
+ * @code
+ * Benchmark benchmark("tree_build/kd");
+ * benchmark.Parameter("n", n).Parameter("d", d);
+ * for (size_t t = 0; t < suite.Trials(); ++t)
+ * {
+ *   arma::mat data(dataset); // Not timed.
+ *   benchmark.Start();
+ *   KDTree tree(data);
+ *   benchmark.Stop();
+ * }
+ * benchmark.Items(n, "points");
+ * suite.Add(benchmark);
+ * @endcode
+ */
+class Benchmark
+{
+ public:
+  //! Create a benchmark with the given name and no trials.
+  Benchmark(const std::string& name);
+
+  //! Set a numeric parameter of the benchmark.
+  Benchmark& Parameter(const std::string& name, const double value);
+  //! Set a string parameter of the benchmark.
+  Benchmark& Parameter(const std::string& name, const std::string& value);
+
+  //! Start timing a trial.
+  void Start();
+  //! Stop timing a trial, and record it.
+  void Stop();
+
+  /**
+   * Set the number of items (points, queries, iterations, ...) processed in
+   * each trial, so that the throughput can be given.
+   *
+   * @param items Number of items processed in each trial.
+   * @param unit Name of the items, such as "points".
+   */
+  void Items(const double items, const std::string& unit);
+
+  //! Get the name of the benchmark.
+  const std::string& Name() const { return name; }
+  //! Get the key that identifies the benchmark and its parameters, which is
+  //! used to match it against a baseline.
+  std::string Key() const;
+
+  //! Get the time of each trial, in seconds.
+  const std::vector<double>& Times() const { return times; }
+  //! Get the fastest time of any trial, in seconds.
+  double Min() const;
+  //! Get the median time of the trials, in seconds.
+  double Median() const;
+  //! Get the mean time of the trials, in seconds.
+  double Mean() const;
+  //! Get the number of items processed per second (using the median time), or
+  //! 0 if Items() was not given.
+  double ItemsPerSecond() const;
+
+  //! Write the benchmark as a JSON object.
+  void WriteJSON(std::ostream& stream) const;
+
+ private:
+  //! The name of the benchmark.
+  std::string name;
+  //! The numeric parameters.
+  std::map<std::string, double> numericParameters;
+  //! The string parameters.
+  std::map<std::string, std::string> stringParameters;
+  //! The time of each trial, in seconds.
+  std::vector<double> times;
+  //! When the current trial was started, in nanoseconds.
+  boost::uint64_t start;
+  //! The number of items processed in each trial.
+  double items;
+  //! The name of the items.
+  std::string unit;
+};
+
+/**
+ * The size of one problem for the tree-based benchmarks.
+ */
+struct Problem
+{
+  //! Number of points.
+  size_t n;
+  //! Dimensionality.
+  size_t d;
+  //! Number of neighbors (or kernels, or clusters) to find.
+  size_t k;
+  //! Maximum leaf size of the trees.
+  size_t leafSize;
+};
+
+/**
+ * A collection of benchmarks, along with the settings they were run with.  The
+ * benchmarks themselves decide what to run, depending on Enabled() (which
+ * filters by name) and Quick() (which asks for smaller problems).
+ */
+class Suite
+{
+ public:
+  /**
+   * Create an empty suite.
+   *
+   * @param trials Number of timed trials of each benchmark.
+   * @param seed Random seed; each dataset is generated from it, so the same
+   *     datasets are used whichever benchmarks are run.
+   * @param filter Only benchmarks whose names contain this are run (everything
+   *     is run if it is empty).
+   * @param quick Whether to use smaller problems.
+   */
+  Suite(const size_t trials,
+        const size_t seed,
+        const std::string& filter,
+        const bool quick);
+
+  //! Return whether or not the benchmark with the given name should be run.
+  bool Enabled(const std::string& name) const;
+
+  //! Reset the random seed, so the next dataset is reproducible.
+  void Seed() const;
+
+  /**
+   * Return the problems the tree-based benchmarks are run on.  Starting from a
+   * default problem, each of n, d, k and the leaf size is varied in turn (the
+   * others are left at their defaults).
+   */
+  std::vector<Problem> Problems() const;
+
+  //! Return whether or not a benchmark with the same name and parameters has
+  //! already been added (so that it need not be run again).
+  bool Contains(const Benchmark& benchmark) const;
+
+  //! Add the results of a benchmark, and print them to Log::Info.
+  void Add(const Benchmark& benchmark);
+
+  //! Get the number of trials of each benchmark.
+  size_t Trials() const { return trials; }
+  //! Get whether to use smaller problems.
+  bool Quick() const { return quick; }
+  //! Get the results of the benchmarks.
+  const std::vector<Benchmark>& Benchmarks() const { return benchmarks; }
+
+  /**
+   * Write the settings and results as JSON.
+   *
+   * @param filename File to write to.
+   * @return false if the file could not be written.
+   */
+  bool WriteJSON(const std::string& filename) const;
+
+  /**
+   * Compare the median times against those in a JSON file written by
+   * WriteJSON(), and warn about each benchmark that is slower by more than the
+   * given fraction.  Benchmarks not in the baseline are ignored.
+   *
+   * @param filename Baseline file to read.
+   * @param tolerance Fraction by which a benchmark may be slower.
+   * @return The number of benchmarks that were slower (or -1 if the baseline
+   *     could not be read).
+   */
+  int Compare(const std::string& filename, const double tolerance) const;
+
+ private:
+  //! The number of trials of each benchmark.
+  size_t trials;
+  //! The random seed.
+  size_t seed;
+  //! The benchmark name filter.
+  std::string filter;
+  //! Whether to use smaller problems.
+  bool quick;
+  //! The results.
+  std::vector<Benchmark> benchmarks;
+};
+
+//! Benchmark building each type of tree.
+void TreeBenchmarks(Suite& suite);
+//! Benchmark allknn, range search, EMST, and FastMKS.
+void SearchBenchmarks(Suite& suite);
+//! Benchmark each k-means Lloyd step type.
+void KMeansBenchmarks(Suite& suite);
+//! Benchmark the optimizers.
+void OptimizerBenchmarks(Suite& suite);
+//! Benchmark metric and kernel evaluations.
+void KernelBenchmarks(Suite& suite);
+
+}; // namespace bench
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file kernel_bench.cpp
+ *
+ * Benchmarks of the metric and kernel evaluations at the core of the tree-based
+ * algorithms.
+ */
+#include "benchmark.hpp"
+
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/linear_kernel.hpp>
+
+using namespace mlpack;
+using namespace mlpack::bench;
+
+namespace {
+
+//! Time evaluating the given metric or kernel between every pair of points.
+template<typename FunctionType>
+void BenchmarkEvaluations(Suite& suite,
+                          const std::string& name,
+                          FunctionType& function,
+                          const size_t d)
+{
+  Benchmark benchmark(name);
+  const size_t n = suite.Quick() ? 300 : 1000;
+  benchmark.Parameter("n", n).Parameter("d", d);
+  if (!suite.Enabled(name))
+    return;
+
+  suite.Seed();
+  arma::mat dataset(d, n);
+  dataset.randu();
+
+  // Keep the sum, so that the evaluations can't be optimized away.
+  double sum = 0.0;
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    benchmark.Start();
+    for (size_t i = 0; i < n; ++i)
+      for (size_t j = 0; j < n; ++j)
+        sum += function.Evaluate(dataset.unsafe_col(i), dataset.unsafe_col(j));
+    benchmark.Stop();
+  }
+  Log::Debug << name << " sum: " << sum << "." << std::endl;
+
+  benchmark.Items(n * n, "evaluations");
+  suite.Add(benchmark);
+}
+
+} // anonymous namespace
+
+void mlpack::bench::KernelBenchmarks(Suite& suite)
+{
+  const size_t ds[] = { 3, 10, 100 };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    metric::EuclideanDistance euclidean;
+    BenchmarkEvaluations(suite, "metric/euclidean", euclidean, ds[i]);
+
+    metric::SquaredEuclideanDistance squaredEuclidean;
+    BenchmarkEvaluations(suite, "metric/squared_euclidean", squaredEuclidean,
+        ds[i]);
+
+    kernel::GaussianKernel gaussian;
+    BenchmarkEvaluations(suite, "kernel/gaussian", gaussian, ds[i]);
+
+    kernel::LinearKernel linear;
+    BenchmarkEvaluations(suite, "kernel/linear", linear, ds[i]);
+  }
+}
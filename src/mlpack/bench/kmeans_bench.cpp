@@ -0,0 +1,92 @@
+/**
+ * @file kmeans_bench.cpp
+ *
+ * Benchmarks of the iterations of each k-means Lloyd step type.
+ */
+#include "benchmark.hpp"
+
+#include <mlpack/methods/kmeans/naive_kmeans.hpp>
+#include <mlpack/methods/kmeans/elkan_kmeans.hpp>
+#include <mlpack/methods/kmeans/hamerly_kmeans.hpp>
+#include <mlpack/methods/kmeans/pelleg_moore_kmeans.hpp>
+#include <mlpack/methods/kmeans/dual_tree_kmeans.hpp>
+#include <mlpack/methods/kmeans/dtnn_kmeans.hpp>
+#include <mlpack/methods/kmeans/mini_batch_kmeans.hpp>
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::kmeans;
+
+namespace {
+
+//! The number of iterations timed in each trial.
+const size_t iterations = 10;
+
+/**
+ * Time the iterations of the given Lloyd step type, starting from the first k
+ * points as centroids.  Constructing the step type (which may build a tree) is
+ * not timed.  A centroid that loses all of its points is left where it was, as
+ * KMeans would leave it with AllowEmptyClusters.
+ */
+template<template<class, class> class LloydStepType>
+void BenchmarkLloydStep(Suite& suite,
+                        const std::string& name,
+                        const Problem& problem)
+{
+  Benchmark benchmark(name);
+  benchmark.Parameter("n", problem.n).Parameter("d", problem.d)
+      .Parameter("clusters", problem.k);
+  if (!suite.Enabled(name) || suite.Contains(benchmark))
+    return;
+
+  suite.Seed();
+  arma::mat dataset(problem.d, problem.n);
+  dataset.randu();
+
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    metric::EuclideanDistance metric;
+    LloydStepType<metric::EuclideanDistance, arma::mat> step(dataset, metric);
+
+    arma::mat centroids = dataset.cols(0, problem.k - 1);
+    arma::mat newCentroids;
+    arma::Col<size_t> counts(problem.k);
+    counts.zeros();
+
+    benchmark.Start();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+      step.Iterate(centroids, newCentroids, counts);
+      for (size_t c = 0; c < problem.k; ++c)
+        if (counts[c] == 0)
+          newCentroids.col(c) = centroids.col(c);
+      centroids.swap(newCentroids);
+    }
+    benchmark.Stop();
+  }
+
+  benchmark.Items(iterations, "iterations");
+  suite.Add(benchmark);
+}
+
+} // anonymous namespace
+
+void mlpack::bench::KMeansBenchmarks(Suite& suite)
+{
+  const std::vector<Problem> problems = suite.Problems();
+  for (size_t i = 0; i < problems.size(); ++i)
+  {
+    BenchmarkLloydStep<NaiveKMeans>(suite, "kmeans/naive", problems[i]);
+    BenchmarkLloydStep<ElkanKMeans>(suite, "kmeans/elkan", problems[i]);
+    BenchmarkLloydStep<HamerlyKMeans>(suite, "kmeans/hamerly", problems[i]);
+    BenchmarkLloydStep<PellegMooreKMeans>(suite, "kmeans/pelleg-moore",
+        problems[i]);
+    BenchmarkLloydStep<DefaultDTNNKMeans>(suite, "kmeans/dtnn", problems[i]);
+    BenchmarkLloydStep<CoverTreeDTNNKMeans>(suite, "kmeans/dtnn-covertree",
+        problems[i]);
+    BenchmarkLloydStep<DefaultDualTreeKMeans>(suite, "kmeans/dualtree",
+        problems[i]);
+    BenchmarkLloydStep<MiniBatchKMeans>(suite, "kmeans/minibatch",
+        problems[i]);
+  }
+}
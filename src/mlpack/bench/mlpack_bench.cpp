@@ -0,0 +1,90 @@
+/**
+ * @file mlpack_bench.cpp
+ *
+ * Runs reproducible benchmarks of the tree-based algorithms, k-means, the
+ * optimizers, and the core metrics and kernels, and writes the results as JSON
+ * (optionally comparing them against a baseline).
+ */
+#include <mlpack/core.hpp>
+
+#include "benchmark.hpp"
+
+PROGRAM_INFO("mlpack Benchmarks", "This program times tree building, allknn, "
+    "range search, EMST, FastMKS (as the number of points, dimensionality, "
+    "number of neighbors, and leaf size are varied), the iterations of each "
+    "k-means Lloyd step type, the optimizers, and metric and kernel "
+    "evaluations, on random datasets generated from the given seed."
+    "\n\n"
+    "Each benchmark is run for --trials trials, and the time of each trial and "
+    "their minimum, median, and mean (as well as the throughput, where there "
+    "is one) are written as JSON to --output_file.  The benchmarks to run can "
+    "be chosen with --filter; only benchmarks whose names contain it (such as "
+    "'allknn' or 'kmeans/dualtree') are run."
+    "\n\n"
+    "If --baseline_file is given (a file written previously by this program), "
+    "each benchmark whose median time is more than --tolerance slower than in "
+    "the baseline is reported, and the program exits with a nonzero status.");
+
+PARAM_STRING("output_file", "File to write the results to (JSON).", "o",
+    "mlpack_bench.json");
+PARAM_STRING("filter", "Only run benchmarks whose names contain this.", "f",
+    "");
+PARAM_INT("trials", "Number of timed trials of each benchmark.", "t", 5);
+PARAM_INT("seed", "Random seed for the datasets.", "s", 42);
+PARAM_FLAG("quick", "Use smaller problems, for a quick check.", "q");
+PARAM_STRING("baseline_file", "Results to compare against (JSON, written by "
+    "this program).", "b", "");
+PARAM_DOUBLE("tolerance", "Fraction by which a benchmark may be slower than "
+    "the baseline before it is reported.", "T", 0.1);
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace std;
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  if (CLI::GetParam<int>("trials") <= 0)
+    Log::Fatal << "Invalid number of trials (" << CLI::GetParam<int>("trials")
+        << ")!  Must be greater than 0." << endl;
+  if (CLI::GetParam<int>("seed") < 0)
+    Log::Fatal << "Invalid seed (" << CLI::GetParam<int>("seed") << ")!  Must "
+        << "not be negative." << endl;
+
+  Suite suite((size_t) CLI::GetParam<int>("trials"),
+      (size_t) CLI::GetParam<int>("seed"), CLI::GetParam<string>("filter"),
+      CLI::HasParam("quick"));
+
+  TreeBenchmarks(suite);
+  SearchBenchmarks(suite);
+  KMeansBenchmarks(suite);
+  OptimizerBenchmarks(suite);
+  KernelBenchmarks(suite);
+
+  if (suite.Benchmarks().empty())
+    Log::Warn << "No benchmarks match the filter '"
+        << CLI::GetParam<string>("filter") << "'." << endl;
+
+  const string outputFile = CLI::GetParam<string>("output_file");
+  if (!suite.WriteJSON(outputFile))
+    return 1;
+  Log::Info << "Wrote " << suite.Benchmarks().size() << " results to '"
+      << outputFile << "'." << endl;
+
+  const string baselineFile = CLI::GetParam<string>("baseline_file");
+  if (!baselineFile.empty())
+  {
+    const int regressions = suite.Compare(baselineFile,
+        CLI::GetParam<double>("tolerance"));
+    if (regressions < 0)
+      return 1;
+
+    Log::Info << regressions << " benchmarks are slower than the baseline."
+        << endl;
+    if (regressions > 0)
+      return 2;
+  }
+
+  return 0;
+}
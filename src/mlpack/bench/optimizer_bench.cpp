@@ -0,0 +1,161 @@
+/**
+ * @file optimizer_bench.cpp
+ *
+ * Benchmarks of the optimizers.
+ */
+#include "benchmark.hpp"
+
+#include <mlpack/core/optimizers/lbfgs/lbfgs.hpp>
+#include <mlpack/core/optimizers/lbfgs/test_functions.hpp>
+#include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression_function.hpp>
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::optimization;
+
+namespace {
+
+/**
+ * Wraps a function to count how many gradients the optimizer takes, since
+ * L_BFGS does not report how many iterations it ran.
+ */
+template<typename FunctionType>
+class CountingFunction
+{
+ public:
+  CountingFunction(FunctionType& function) : function(function), gradients(0)
+  { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    return function.Evaluate(coordinates);
+  }
+
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  {
+    ++gradients;
+    function.Gradient(coordinates, gradient);
+  }
+
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  double Evaluate(const arma::mat& coordinates, const size_t i)
+  {
+    return function.Evaluate(coordinates, i);
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t i,
+                arma::mat& gradient)
+  {
+    ++gradients;
+    function.Gradient(coordinates, i, gradient);
+  }
+
+  const arma::mat& GetInitialPoint() const
+  {
+    return function.GetInitialPoint();
+  }
+
+  //! Get the number of gradients taken.
+  size_t Gradients() const { return gradients; }
+
+ private:
+  FunctionType& function;
+  size_t gradients;
+};
+
+//! Time 100 iterations of L-BFGS (not stopping at convergence), and give the
+//! number of gradients taken per second.
+template<typename FunctionType>
+void BenchmarkLBFGS(Suite& suite, Benchmark& benchmark, FunctionType& function)
+{
+  size_t gradients = 0;
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    CountingFunction<FunctionType> counter(function);
+    L_BFGS<CountingFunction<FunctionType> > lbfgs(counter, 5, 100, 1e-4, 0.9,
+        0.0);
+    arma::mat coordinates = function.GetInitialPoint();
+
+    benchmark.Start();
+    lbfgs.Optimize(coordinates);
+    benchmark.Stop();
+
+    gradients = counter.Gradients();
+  }
+
+  benchmark.Items(gradients, "gradients");
+  suite.Add(benchmark);
+}
+
+//! Time a fixed number of iterations of SGD (with no tolerance, so it does not
+//! stop early).
+template<typename FunctionType>
+void BenchmarkSGD(Suite& suite,
+                  Benchmark& benchmark,
+                  FunctionType& function,
+                  const size_t maxIterations)
+{
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    SGD<FunctionType> sgd(function, 0.01, maxIterations, -1.0);
+    arma::mat coordinates = function.GetInitialPoint();
+
+    benchmark.Start();
+    sgd.Optimize(coordinates);
+    benchmark.Stop();
+  }
+
+  benchmark.Items(maxIterations, "iterations");
+  suite.Add(benchmark);
+}
+
+} // anonymous namespace
+
+void mlpack::bench::OptimizerBenchmarks(Suite& suite)
+{
+  const size_t scale = suite.Quick() ? 10 : 1;
+
+  const size_t dimensions[] = { 10, 100, 1000 };
+  for (size_t i = 0; i < 3; ++i)
+  {
+    Benchmark benchmark("lbfgs/rosenbrock");
+    benchmark.Parameter("d", dimensions[i]);
+    if (!suite.Enabled(benchmark.Name()))
+      continue;
+
+    test::GeneralizedRosenbrockFunction function((int) dimensions[i]);
+    BenchmarkLBFGS(suite, benchmark, function);
+  }
+
+  const size_t ds[] = { 10, 100 };
+  for (size_t i = 0; i < 2; ++i)
+  {
+    // Label the points by a random hyperplane.
+    suite.Seed();
+    const size_t n = 10000 / scale;
+    arma::mat predictors(ds[i], n);
+    predictors.randn();
+    arma::vec weights(ds[i]);
+    weights.randn();
+    const arma::rowvec margins = weights.t() * predictors;
+    arma::vec responses(n);
+    for (size_t j = 0; j < n; ++j)
+      responses[j] = (margins[j] > 0) ? 1.0 : 0.0;
+
+    regression::LogisticRegressionFunction<> function(predictors, responses,
+        0.001);
+
+    Benchmark lbfgs("lbfgs/logistic_regression");
+    lbfgs.Parameter("n", n).Parameter("d", ds[i]);
+    if (suite.Enabled(lbfgs.Name()))
+      BenchmarkLBFGS(suite, lbfgs, function);
+
+    Benchmark sgd("sgd/logistic_regression");
+    sgd.Parameter("n", n).Parameter("d", ds[i]);
+    if (suite.Enabled(sgd.Name()))
+      BenchmarkSGD(suite, sgd, function, 10 * n);
+  }
+}
@@ -0,0 +1,171 @@
+/**
+ * @file search_bench.cpp
+ *
+ * Benchmarks of the tree-based search algorithms: allknn, range search, EMST,
+ * and FastMKS.
+ */
+#include "benchmark.hpp"
+
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/range_search/range_search.hpp>
+#include <mlpack/methods/emst/dtb.hpp>
+#include <mlpack/methods/fastmks/fastmks.hpp>
+#include <mlpack/core/kernels/linear_kernel.hpp>
+
+#include <boost/math/special_functions/gamma.hpp>
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::tree;
+
+namespace {
+
+typedef BinarySpaceTree<bound::HRectBound<2>,
+    neighbor::NeighborSearchStat<neighbor::NearestNeighborSort> > AllkNNTree;
+typedef BinarySpaceTree<bound::HRectBound<2>, range::RangeSearchStat>
+    RangeSearchTree;
+typedef BinarySpaceTree<bound::HRectBound<2>, emst::DTBStat> DTBTree;
+
+//! Generate the (reproducible) dataset for the given problem.
+arma::mat Dataset(const Suite& suite, const Problem& problem)
+{
+  suite.Seed();
+  arma::mat dataset(problem.d, problem.n);
+  dataset.randu();
+  return dataset;
+}
+
+//! Time finding the k nearest neighbors of every point; the tree is built
+//! before each trial, and is not timed.
+void BenchmarkAllkNN(Suite& suite, const Problem& problem, const bool single)
+{
+  Benchmark benchmark(single ? "allknn/single" : "allknn/dual");
+  benchmark.Parameter("n", problem.n).Parameter("d", problem.d)
+      .Parameter("k", problem.k).Parameter("leaf_size", problem.leafSize);
+  if (!suite.Enabled(benchmark.Name()) || suite.Contains(benchmark))
+    return;
+
+  const arma::mat dataset = Dataset(suite, problem);
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    arma::mat data(dataset);
+    std::vector<size_t> oldFromNew;
+    AllkNNTree tree(data, oldFromNew, problem.leafSize);
+    neighbor::NeighborSearch<neighbor::NearestNeighborSort,
+        metric::EuclideanDistance, AllkNNTree> allknn(&tree, data, single);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    benchmark.Start();
+    allknn.Search(problem.k, neighbors, distances);
+    benchmark.Stop();
+  }
+
+  benchmark.Items(problem.n, "queries");
+  suite.Add(benchmark);
+}
+
+//! Time finding every point within a radius chosen so that each point has
+//! about k neighbors (ignoring the edges of the unit cube).
+void BenchmarkRangeSearch(Suite& suite, const Problem& problem)
+{
+  // Solve n * (volume of a ball of radius r) = k for r.
+  const double d = (double) problem.d;
+  const double unitBallVolume = std::pow(M_PI, d / 2) /
+      boost::math::tgamma(d / 2 + 1);
+  const double radius = std::pow(problem.k / (problem.n * unitBallVolume),
+      1.0 / d);
+
+  Benchmark benchmark("range_search/dual");
+  benchmark.Parameter("n", problem.n).Parameter("d", problem.d)
+      .Parameter("k", problem.k).Parameter("leaf_size", problem.leafSize);
+  if (!suite.Enabled(benchmark.Name()) || suite.Contains(benchmark))
+    return;
+
+  const arma::mat dataset = Dataset(suite, problem);
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    arma::mat data(dataset);
+    std::vector<size_t> oldFromNew;
+    RangeSearchTree tree(data, oldFromNew, problem.leafSize);
+    range::RangeSearch<metric::EuclideanDistance, RangeSearchTree>
+        rangeSearch(&tree, data);
+
+    std::vector<std::vector<size_t> > neighbors;
+    std::vector<std::vector<double> > distances;
+    benchmark.Start();
+    rangeSearch.Search(math::Range(0.0, radius), neighbors, distances);
+    benchmark.Stop();
+  }
+
+  benchmark.Items(problem.n, "queries");
+  suite.Add(benchmark);
+}
+
+//! Time computing the Euclidean minimum spanning tree (k is not used).
+void BenchmarkEMST(Suite& suite, const Problem& problem)
+{
+  Benchmark benchmark("emst/dual");
+  benchmark.Parameter("n", problem.n).Parameter("d", problem.d)
+      .Parameter("leaf_size", problem.leafSize);
+  if (!suite.Enabled(benchmark.Name()) || suite.Contains(benchmark))
+    return;
+
+  const arma::mat dataset = Dataset(suite, problem);
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    arma::mat data(dataset);
+    std::vector<size_t> oldFromNew;
+    DTBTree tree(data, oldFromNew, problem.leafSize);
+    emst::DualTreeBoruvka<metric::EuclideanDistance, DTBTree> dtb(&tree, data);
+
+    arma::mat results;
+    benchmark.Start();
+    dtb.ComputeMST(results);
+    benchmark.Stop();
+  }
+
+  benchmark.Items(problem.n, "points");
+  suite.Add(benchmark);
+}
+
+//! Time finding the k largest linear kernel values for every point, with a
+//! cover tree (so the leaf size is not used).
+void BenchmarkFastMKS(Suite& suite, const Problem& problem)
+{
+  Benchmark benchmark("fastmks/dual");
+  benchmark.Parameter("n", problem.n).Parameter("d", problem.d)
+      .Parameter("k", problem.k);
+  if (!suite.Enabled(benchmark.Name()) || suite.Contains(benchmark))
+    return;
+
+  const arma::mat dataset = Dataset(suite, problem);
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    fastmks::FastMKS<kernel::LinearKernel> fastmks(dataset);
+
+    arma::Mat<size_t> indices;
+    arma::mat products;
+    benchmark.Start();
+    fastmks.Search(problem.k, indices, products);
+    benchmark.Stop();
+  }
+
+  benchmark.Items(problem.n, "queries");
+  suite.Add(benchmark);
+}
+
+} // anonymous namespace
+
+void mlpack::bench::SearchBenchmarks(Suite& suite)
+{
+  const std::vector<Problem> problems = suite.Problems();
+  for (size_t i = 0; i < problems.size(); ++i)
+  {
+    BenchmarkAllkNN(suite, problems[i], false);
+    BenchmarkAllkNN(suite, problems[i], true);
+    BenchmarkRangeSearch(suite, problems[i]);
+    BenchmarkEMST(suite, problems[i]);
+    BenchmarkFastMKS(suite, problems[i]);
+  }
+}
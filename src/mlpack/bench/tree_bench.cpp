@@ -0,0 +1,86 @@
+/**
+ * @file tree_bench.cpp
+ *
+ * Benchmarks of building each type of tree.
+ */
+#include "benchmark.hpp"
+
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+
+using namespace mlpack;
+using namespace mlpack::bench;
+using namespace mlpack::tree;
+
+namespace {
+
+typedef BinarySpaceTree<bound::HRectBound<2>, EmptyStatistic> KDTree;
+typedef BinarySpaceTree<bound::BallBound<>, EmptyStatistic> BallTree;
+typedef CoverTree<metric::EuclideanDistance, FirstPointIsRoot, EmptyStatistic>
+    StandardCoverTree;
+
+//! Time building a binary space tree, which rearranges a copy of the dataset.
+template<typename TreeType>
+void BenchmarkBinarySpaceTree(Suite& suite,
+                              const std::string& name,
+                              const Problem& problem)
+{
+  Benchmark benchmark(name);
+  benchmark.Parameter("n", problem.n).Parameter("d", problem.d)
+      .Parameter("leaf_size", problem.leafSize);
+  if (!suite.Enabled(name) || suite.Contains(benchmark))
+    return;
+
+  suite.Seed();
+  arma::mat dataset(problem.d, problem.n);
+  dataset.randu();
+
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    arma::mat data(dataset);
+    std::vector<size_t> oldFromNew;
+
+    benchmark.Start();
+    TreeType tree(data, oldFromNew, problem.leafSize);
+    benchmark.Stop();
+  }
+
+  benchmark.Items(problem.n, "points");
+  suite.Add(benchmark);
+}
+
+//! Time building a cover tree (which has no leaf size).
+void BenchmarkCoverTree(Suite& suite, const Problem& problem)
+{
+  Benchmark benchmark("tree_build/cover");
+  benchmark.Parameter("n", problem.n).Parameter("d", problem.d);
+  if (!suite.Enabled(benchmark.Name()) || suite.Contains(benchmark))
+    return;
+
+  suite.Seed();
+  arma::mat dataset(problem.d, problem.n);
+  dataset.randu();
+
+  for (size_t t = 0; t < suite.Trials(); ++t)
+  {
+    benchmark.Start();
+    StandardCoverTree tree(dataset);
+    benchmark.Stop();
+  }
+
+  benchmark.Items(problem.n, "points");
+  suite.Add(benchmark);
+}
+
+} // anonymous namespace
+
+void mlpack::bench::TreeBenchmarks(Suite& suite)
+{
+  const std::vector<Problem> problems = suite.Problems();
+  for (size_t i = 0; i < problems.size(); ++i)
+  {
+    BenchmarkBinarySpaceTree<KDTree>(suite, "tree_build/kd", problems[i]);
+    BenchmarkBinarySpaceTree<BallTree>(suite, "tree_build/ball", problems[i]);
+    BenchmarkCoverTree(suite, problems[i]);
+  }
+}
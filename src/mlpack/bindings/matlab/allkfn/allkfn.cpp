@@ -31,14 +31,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
   size_t numPoints = mxGetN(prhs[0]);
   size_t numDimensions = mxGetM(prhs[0]);
 
-  // Create the reference matrix.
-  arma::mat referenceData(numDimensions, numPoints);
-  // setting the values.
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    referenceData(i) = mexDataPoints[i];
-  }
+  // Create the reference matrix.  The kd-tree rearranges the points it is
+  // built on, so it needs a copy (made with one memcpy()).
+  arma::mat referenceData(mxGetPr(prhs[0]), numDimensions, numPoints);
 
   // getting the leafsize
   int lsInt = (int) mxGetScalar(prhs[3]);
@@ -52,9 +47,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // single mode?
   bool singleMode = (mxGetScalar(prhs[5]) == 1.0);
 
-  // the query matrix
-  double * mexQueryPoints = mxGetPr(prhs[2]);
-  arma::mat queryData;
+  // the query matrix (copied for the same reason)
+  arma::mat queryData(mxGetPr(prhs[2]), mxGetM(prhs[2]), mxGetN(prhs[2]));
   bool hasQueryData = ((mxGetM(prhs[2]) != 0) && (mxGetN(prhs[2]) != 0));
 
   // Sanity check on k value: must be greater than 0, must be less than the
@@ -90,6 +84,14 @@ void mexFunction(int nlhs, mxArray *plhs[],
   arma::Mat<size_t> neighbors;
   arma::mat distances;
 
+  // The remapped results are written directly into the arrays returned to
+  // MATLAB.
+  const size_t numQueries = hasQueryData ? queryData.n_cols : numPoints;
+  plhs[0] = mxCreateDoubleMatrix(k, numQueries, mxREAL);
+  plhs[1] = mxCreateDoubleMatrix(k, numQueries, mxREAL);
+  arma::mat distancesOut(mxGetPr(plhs[0]), k, numQueries, false, true);
+  arma::mat neighborsOut(mxGetPr(plhs[1]), k, numQueries, false, true);
+
   AllkFN* allkfn = NULL;
 
   std::vector<size_t> oldFromNewRefs;
@@ -105,16 +107,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   if (hasQueryData)
   {
-    // setting the values.
-    mexDataPoints = mxGetPr(prhs[2]);
-    numPoints = mxGetN(prhs[2]);
-    numDimensions = mxGetM(prhs[2]);
-    queryData = arma::mat(numDimensions, numPoints);
-    for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-    {
-      queryData(i) = mexDataPoints[i];
-    }
-
     if (naive && leafSize < queryData.n_cols)
       leafSize = queryData.n_cols;
 
@@ -136,9 +128,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   // We have to map back to the original indices from before the tree
   // construction.
-  arma::mat distancesOut(distances.n_rows, distances.n_cols);
-  arma::Mat<size_t> neighborsOut(neighbors.n_rows, neighbors.n_cols);
-
   // Do the actual remapping.
   if (hasQueryData)
   {
@@ -173,22 +162,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
   if (queryTree)
     delete queryTree;
 
-  // constructing matrix to return to matlab
-  plhs[0] = mxCreateDoubleMatrix(distances.n_rows, distances.n_cols, mxREAL);
-  plhs[1] = mxCreateDoubleMatrix(neighbors.n_rows, neighbors.n_cols, mxREAL);
-
-  // setting the values
-  double * out = mxGetPr(plhs[0]);
-  for (int i = 0, n = distances.n_rows * distances.n_cols; i < n; ++i)
-  {
-    out[i] = distances(i);
-  }
-  out = mxGetPr(plhs[1]);
-  for (int i = 0, n = neighbors.n_rows * neighbors.n_cols; i < n; ++i)
-  {
-    out[i] = neighbors(i);
-  }
-
   // More clean up.
   delete allkfn;
 }
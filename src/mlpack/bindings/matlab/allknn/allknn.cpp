@@ -34,14 +34,10 @@ void mexFunction(int nlhs, mxArray *plhs[],
   size_t numPoints = mxGetN(prhs[0]);
   size_t numDimensions = mxGetM(prhs[0]);
 
-  // feeding the referenceData matrix
-  arma::mat referenceData(numDimensions, numPoints);
-  // setting the values.
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    referenceData(i) = mexDataPoints[i];
-  }
+  // The kd-trees rearrange the points they are built on, so they are built on
+  // copies (made with one memcpy() each); cover trees only read the points, so
+  // they use the memory of the mxArrays directly.
+  double * mexReferencePoints = mxGetPr(prhs[0]);
 
   // getting the leafsize
   int lsInt = (int) mxGetScalar(prhs[3]);
@@ -57,7 +53,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   // the query matrix
   double * mexQueryPoints = mxGetPr(prhs[2]);
-  arma::mat queryData;
   bool hasQueryData = ((mxGetM(prhs[2]) != 0) && (mxGetN(prhs[2]) != 0));
 
   // cover-tree?
@@ -65,12 +60,12 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   // Sanity check on k value: must be greater than 0, must be less than the
   // number of reference points.
-  if (k > referenceData.n_cols)
+  if (k > numPoints)
   {
     stringstream os;
     os << "Invalid k: " << k << "; must be greater than 0 and less ";
     os << "than or equal to the number of reference points (";
-    os << referenceData.n_cols << ")." << endl;
+    os << numPoints << ")." << endl;
     mexErrMsgTxt(os.str().c_str());
   }
 
@@ -91,10 +86,14 @@ void mexFunction(int nlhs, mxArray *plhs[],
   }
 
   if (naive)
-    leafSize = referenceData.n_cols;
+    leafSize = numPoints;
 
-  arma::Mat<size_t> neighbors;
-  arma::mat distances;
+  // The results are written directly into the arrays returned to MATLAB.
+  const size_t numQueries = hasQueryData ? mxGetN(prhs[2]) : numPoints;
+  plhs[0] = mxCreateDoubleMatrix(k, numQueries, mxREAL);
+  plhs[1] = mxCreateDoubleMatrix(k, numQueries, mxREAL);
+  arma::mat distances(mxGetPr(plhs[0]), k, numQueries, false, true);
+  arma::mat neighbors(mxGetPr(plhs[1]), k, numQueries, false, true);
 
   //if (!CLI::HasParam("cover_tree"))
   if (usesCoverTree)
@@ -107,7 +106,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
     // Build trees by hand, so we can save memory: if we pass a tree to
     // NeighborSearch, it does not copy the matrix.
-
+    arma::mat referenceData(mexReferencePoints, numDimensions, numPoints);
+    arma::mat queryData(mexQueryPoints, mxGetM(prhs[2]), mxGetN(prhs[2]));
     BinarySpaceTree<bound::HRectBound<2>, QueryStat<NearestNeighborSort> >
       refTree(referenceData, oldFromNewRefs, leafSize);
     BinarySpaceTree<bound::HRectBound<2>, QueryStat<NearestNeighborSort> >*
@@ -117,16 +117,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
     if (hasQueryData)
     {
-      // setting the values.
-      mexDataPoints = mxGetPr(prhs[2]);
-      numPoints = mxGetN(prhs[2]);
-      numDimensions = mxGetM(prhs[2]);
-      queryData = arma::mat(numDimensions, numPoints);
-      for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-      {
-        queryData(i) = mexDataPoints[i];
-      }
-
       if (naive && leafSize < queryData.n_cols)
         leafSize = queryData.n_cols;
 
@@ -154,9 +144,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
     // We have to map back to the original indices from before the tree
     // construction.
-    neighbors.set_size(neighborsOut.n_rows, neighborsOut.n_cols);
-    distances.set_size(distancesOut.n_rows, distancesOut.n_cols);
-
     // Do the actual remapping.
     if ((hasQueryData) && !singleMode)
     {
@@ -207,6 +194,12 @@ void mexFunction(int nlhs, mxArray *plhs[],
   }
   else // Cover trees.
   {
+    // Cover trees do not rearrange the points.
+    const arma::mat referenceData(mexReferencePoints, numDimensions, numPoints,
+        false, true);
+    const arma::mat queryData(mexQueryPoints, mxGetM(prhs[2]), mxGetN(prhs[2]),
+        false, true);
+
     // Build our reference tree.
     CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
         QueryStat<NearestNeighborSort> > referenceTree(referenceData, 1.3);
@@ -220,16 +213,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
     // See if we have query data.
     if (hasQueryData)
     {
-      // setting the values.
-      mexDataPoints = mxGetPr(prhs[2]);
-      numPoints = mxGetN(prhs[2]);
-      numDimensions = mxGetM(prhs[2]);
-      queryData = arma::mat(numDimensions, numPoints);
-      for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-      {
-        queryData(i) = mexDataPoints[i];
-      }
-
       // Build query tree.
       if (!singleMode)
       {
@@ -251,29 +234,14 @@ void mexFunction(int nlhs, mxArray *plhs[],
           singleMode);
     }
 
-    allknn->Search(k, neighbors, distances);
+    // The indices are converted to doubles as they are copied.
+    arma::Mat<size_t> neighborsOut;
+    allknn->Search(k, neighborsOut, distances);
+    std::copy(neighborsOut.begin(), neighborsOut.end(), neighbors.begin());
 
     delete allknn;
 
     if (queryTree)
       delete queryTree;
   }
-
-  // writing back to matlab
-  // constructing matrix to return to matlab
-  plhs[0] = mxCreateDoubleMatrix(distances.n_rows, distances.n_cols, mxREAL);
-  plhs[1] = mxCreateDoubleMatrix(neighbors.n_rows, neighbors.n_cols, mxREAL);
-
-  // setting the values
-  double * out = mxGetPr(plhs[0]);
-  for (int i = 0, n = distances.n_rows * distances.n_cols; i < n; ++i)
-  {
-    out[i] = distances(i);
-  }
-  out = mxGetPr(plhs[1]);
-  for (int i = 0, n = neighbors.n_rows * neighbors.n_cols; i < n; ++i)
-  {
-    out[i] = neighbors(i);
-  }
-
 }
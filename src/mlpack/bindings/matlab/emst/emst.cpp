@@ -33,20 +33,18 @@ void mexFunction(int nlhs, mxArray *plhs[],
   const size_t numPoints = mxGetN(prhs[0]);
   const size_t numDimensions = mxGetM(prhs[0]);
 
-  // Converting from mxArray to armadillo matrix.
-  arma::mat dataPoints(numDimensions, numPoints);
-
-  // Set the values.
-  double* mexDataPoints = mxGetPr(prhs[0]);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    dataPoints(i) = mexDataPoints[i];
-  }
+  // Use the memory of the mxArray for the dataset, without copying it;
+  // DualTreeBoruvka only reads it.
+  const arma::mat dataPoints(mxGetPr(prhs[0]), numDimensions, numPoints, false,
+      true);
 
   const bool isBoruvka = (mxGetScalar(prhs[1]) == 1.0);
 
+  // Compute the MST directly into the matrix returned to MATLAB.
+  plhs[0] = mxCreateDoubleMatrix(3, numPoints - 1, mxREAL);
+  arma::mat result(mxGetPr(plhs[0]), 3, numPoints - 1, false, true);
+
   // Run the computation.
-  arma::mat result;
   if (isBoruvka)
   {
     // Get the number of leaves.
@@ -60,13 +58,4 @@ void mexFunction(int nlhs, mxArray *plhs[],
     DualTreeBoruvka<> naive(dataPoints, true);
     naive.ComputeMST(result);
   }
-
-  // Construct matrix to return to MATLAB.
-  plhs[0] = mxCreateDoubleMatrix(3, numPoints - 1, mxREAL);
-
-  double* out = mxGetPr(plhs[0]);
-  for (int i = 0, n = (numPoints - 1) * 3; i < n; ++i)
-  {
-    out[i] = result(i);
-  }
 }
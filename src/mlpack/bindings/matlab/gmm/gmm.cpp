@@ -34,15 +34,12 @@ void mexFunction(int nlhs, mxArray *plhs[],
   else
     math::RandomSeed((size_t) std::time(NULL));
 
-  // loading the data
-  double * mexDataPoints = mxGetPr(prhs[0]);
+  // Use the memory of the mxArray for the data, without copying it; EM only
+  // reads the observations.
   size_t numPoints = mxGetN(prhs[0]);
   size_t numDimensions = mxGetM(prhs[0]);
-  arma::mat dataPoints(numDimensions, numPoints);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    dataPoints(i) = mexDataPoints[i];
-  }
+  const arma::mat dataPoints(mxGetPr(prhs[0]), numDimensions, numPoints, false,
+      true);
 
   int gaussians = (int) mxGetScalar(prhs[1]);
   if (gaussians <= 0)
@@ -80,11 +77,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   // mixture weights
   field_value = mxCreateDoubleMatrix(gmm.Weights().size(), 1, mxREAL);
-  double * values = mxGetPr(field_value);
-  for (int i=0; i<gmm.Weights().size(); ++i)
-  {
-    values[i] = gmm.Weights()[i];
-  }
+  std::copy(gmm.Weights().begin(), gmm.Weights().end(),
+      mxGetPr(field_value));
   mxSetFieldByNumber(plhs[0], 0, 1, field_value);
 
   // gaussian mean/variances
@@ -98,32 +92,19 @@ void mexFunction(int nlhs, mxArray *plhs[],
   field_value = mxCreateStructArray(ndim, dims, 2, gaussianNames);
   for (int i=0; i<gmm.Gaussians(); ++i)
   {
-    mxArray * tmp;
-    double * values;
-
-    // setting the mean
-    arma::mat mean = gmm.Means()[i];
-    tmp = mxCreateDoubleMatrix(numDimensions, 1, mxREAL);
-    values = mxGetPr(tmp);
-    for (int j = 0; j < numDimensions; ++j)
-    {
-      values[j] = mean(j);
-    }
-    // note: SetField does not copy the data structure.
-    // mxDuplicateArray does the necessary copying.
-    mxSetFieldByNumber(field_value, i, 0, mxDuplicateArray(tmp));
-    mxDestroyArray(tmp);
-
-    // setting the covariance matrix
-    arma::mat covariance = gmm.Covariances()[i];
-    tmp = mxCreateDoubleMatrix(numDimensions, numDimensions, mxREAL);
-    values = mxGetPr(tmp);
-    for (int j = 0; j < numDimensions * numDimensions; ++j)
-    {
-      values[j] = covariance(j);
-    }
-    mxSetFieldByNumber(field_value, i, 1, mxDuplicateArray(tmp));
-    mxDestroyArray(tmp);
+    // The parameters are copied straight into new arrays, which the struct
+    // takes ownership of (mxSetFieldByNumber() does not copy them).
+    const arma::vec& mean = gmm.Component(i).Mean();
+    mxArray* meanArray = mxCreateDoubleMatrix(numDimensions, 1, mxREAL);
+    std::copy(mean.begin(), mean.end(), mxGetPr(meanArray));
+    mxSetFieldByNumber(field_value, i, 0, meanArray);
+
+    const arma::mat& covariance = gmm.Component(i).Covariance();
+    mxArray* covarianceArray = mxCreateDoubleMatrix(numDimensions,
+        numDimensions, mxREAL);
+    std::copy(covariance.begin(), covariance.end(),
+        mxGetPr(covarianceArray));
+    mxSetFieldByNumber(field_value, i, 1, covarianceArray);
   }
   mxSetFieldByNumber(plhs[0], 0, 2, field_value);
 }
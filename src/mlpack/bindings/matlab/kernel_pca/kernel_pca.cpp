@@ -34,10 +34,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
   if (mxDOUBLE_CLASS != mxGetClassID(prhs[0]))
     mexErrMsgTxt("Input dataset must have type mxDOUBLE_CLASS.");
 
-  mat dataset(mxGetM(prhs[0]), mxGetN(prhs[0]));
-  double * values = mxGetPr(prhs[0]);
-  for (int i=0, num=mxGetNumberOfElements(prhs[0]); i<num; ++i)
-    dataset(i) = values[i];
+  // Kernel PCA transforms the dataset in place, so it is copied (with one
+  // memcpy()) rather than using the memory of the mxArray.
+  mat dataset(mxGetPr(prhs[0]), mxGetM(prhs[0]), mxGetN(prhs[0]));
 
   // Get the new dimensionality, if it is necessary.
   size_t newDim = dataset.n_rows;
@@ -127,10 +126,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   // Now returning results to matlab
   plhs[0] = mxCreateDoubleMatrix(dataset.n_rows, dataset.n_cols, mxREAL);
-  values = mxGetPr(plhs[0]);
-  for (int i = 0; i < dataset.n_rows * dataset.n_cols; ++i)
-  {
-    values[i] = dataset(i);
-  }
+  std::copy(dataset.begin(), dataset.end(), mxGetPr(plhs[0]));
 
 }
@@ -85,14 +85,11 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // Load our dataset.
   const size_t numPoints = mxGetN(prhs[0]);
   const size_t numDimensions = mxGetM(prhs[0]);
-  arma::mat dataset(numDimensions, numPoints);
 
-  // setting the values.
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    dataset(i) = mexDataPoints[i];
-  }
+  // Use the memory of the mxArray, without copying it; k-means only reads the
+  // dataset.
+  const arma::mat dataset(mxGetPr(prhs[0]), numDimensions, numPoints, false,
+      true);
 
   // Now create the KMeans object.  Because we could be using different types,
   // it gets a little weird...
@@ -161,15 +158,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
   }
   */
 
-  // constructing matrix to return to matlab
+  // constructing matrix to return to matlab; the assignments are converted to
+  // doubles as they are copied.
   plhs[0] = mxCreateDoubleMatrix(assignments.n_elem, 1, mxREAL);
-
-  // setting the values
-  double * out = mxGetPr(plhs[0]);
-  for (int i = 0, n = assignments.n_elem; i < n; ++i)
-  {
-    out[i] = assignments(i);
-  }
-
+  std::copy(assignments.begin(), assignments.end(), mxGetPr(plhs[0]));
 }
 
@@ -27,17 +27,12 @@ void mexFunction(int nlhs, mxArray *plhs[],
   double lambda2 = mxGetScalar(prhs[3]);
   bool useCholesky = (mxGetScalar(prhs[3]) == 1.0);
 
-  // loading covariates
-  mat matX(mxGetM(prhs[0]), mxGetN(prhs[0]));
-  double * values = mxGetPr(prhs[0]);
-  for (int i=0, num=mxGetNumberOfElements(prhs[0]); i<num; ++i)
-    matX(i) = values[i];
-
-  // loading responses
-  mat matY(mxGetM(prhs[1]), mxGetN(prhs[1]));
-  values = mxGetPr(prhs[1]);
-  for (int i=0, num=mxGetNumberOfElements(prhs[1]); i<num; ++i)
-    matY(i) = values[i];
+  // Use the memory of the covariates and responses, without copying them;
+  // LARS only reads them.
+  const mat matX(mxGetPr(prhs[0]), mxGetM(prhs[0]), mxGetN(prhs[0]), false,
+      true);
+  const mat matY(mxGetPr(prhs[1]), mxGetM(prhs[1]), mxGetN(prhs[1]), false,
+      true);
 
   if (matY.n_cols > 1)
     mexErrMsgTxt("Only one column or row allowed in responses file!");
@@ -45,14 +40,10 @@ void mexFunction(int nlhs, mxArray *plhs[],
   if (matY.n_elem != matX.n_rows)
     mexErrMsgTxt("Number of responses must be equal to number of rows of X!");
 
-  // Do LARS.
+  // Do LARS, with the solution written directly into the returned array.
   LARS lars(useCholesky, lambda1, lambda2);
-  vec beta;
-  lars.Regress(matX, matY.unsafe_col(0), beta, false /* do not transpose */);
-
-  // return to matlab
-  plhs[0] = mxCreateDoubleMatrix(beta.n_elem, 1, mxREAL);
-  values = mxGetPr(plhs[0]);
-  for (int i = 0; i < beta.n_elem; ++i)
-    values[i] = beta(i);
+  const vec responses(mxGetPr(prhs[1]), matY.n_elem, false, true);
+  plhs[0] = mxCreateDoubleMatrix(matX.n_cols, 1, mxREAL);
+  vec beta(mxGetPr(plhs[0]), matX.n_cols, false, true);
+  lars.Regress(matX, responses, beta, false /* do not transpose */);
 }
@@ -26,14 +26,14 @@ void mexFunction(int nlhs, mxArray *plhs[],
   }
 
   // Load data.
-  mat data(mxGetM(prhs[0]), mxGetN(prhs[0]));
-  double * values = mxGetPr(prhs[0]);
-  for (int i=0, num=mxGetNumberOfElements(prhs[0]); i<num; ++i)
-    data(i) = values[i];
+  // Use the memory of the mxArray, without copying it; NCA only reads the
+  // data.
+  const mat data(mxGetPr(prhs[0]), mxGetM(prhs[0]), mxGetN(prhs[0]), false,
+      true);
 
   // load labels
   umat labels(mxGetNumberOfElements(prhs[1]), 1);
-  values = mxGetPr(prhs[1]);
+  const double* values = mxGetPr(prhs[1]);
   for (int i=0, num=mxGetNumberOfElements(prhs[1]); i<num; ++i)
     labels(i) = (int) values[i];
 
@@ -44,12 +44,10 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // Now create the NCA object and run the optimization.
   NCA<LMetric<2> > nca(data, labels.unsafe_col(0));
 
-  mat distance;
+  // Learn the distance directly into the returned array, starting from the
+  // identity (as NCA does when it is given no initial matrix).
+  plhs[0] = mxCreateDoubleMatrix(data.n_rows, data.n_rows, mxREAL);
+  mat distance(mxGetPr(plhs[0]), data.n_rows, data.n_rows, false, true);
+  distance.eye();
   nca.LearnDistance(distance);
-
-  // return to matlab
-  plhs[0] = mxCreateDoubleMatrix(distance.n_rows, distance.n_cols, mxREAL);
-  values = mxGetPr(plhs[0]);
-  for (int i = 0; i < distance.n_elem; ++i)
-    values[i] = distance(i);
 }
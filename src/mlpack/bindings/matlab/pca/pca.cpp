@@ -22,13 +22,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
     mexErrMsgTxt("Output required.");
   }
 
-  // loading the data
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  size_t numPoints = mxGetN(prhs[0]);
-  size_t numDimensions = mxGetM(prhs[0]);
-  arma::mat dataset(numDimensions, numPoints);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-    dataset(i) = mexDataPoints[i];
+  // loading the data; PCA transforms it in place, so it is copied (with one
+  // memcpy()) rather than using the memory of the mxArray.
+  arma::mat dataset(mxGetPr(prhs[0]), mxGetM(prhs[0]), mxGetN(prhs[0]));
 
   // Find out what dimension we want.
   size_t newDimension = dataset.n_rows; // No reduction, by default.
@@ -56,7 +52,5 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   // Now returning results to matlab
   plhs[0] = mxCreateDoubleMatrix(dataset.n_rows, dataset.n_cols, mxREAL);
-  double * values = mxGetPr(plhs[0]);
-  for (int i = 0; i < dataset.n_rows * dataset.n_cols; ++i)
-    values[i] = dataset(i);
+  std::copy(dataset.begin(), dataset.end(), mxGetPr(plhs[0]));
 }
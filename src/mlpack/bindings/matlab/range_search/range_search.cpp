@@ -57,15 +57,11 @@ void mexFunction(int nlhs, mxArray *plhs[],
   bool hasQueryData = ((mxGetM(prhs[3]) != 0) && (mxGetN(prhs[3]) != 0));
   arma::mat queryData;
 
-  // setting the dataset values.
-  double * mexDataPoints = mxGetPr(prhs[0]);
+  // setting the dataset values.  The kd-tree rearranges the points it is built
+  // on, so it needs a copy (made with one memcpy()).
   size_t numPoints = mxGetN(prhs[0]);
   size_t numDimensions = mxGetM(prhs[0]);
-  arma::mat referenceData(numDimensions, numPoints);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    referenceData(i) = mexDataPoints[i];
-  }
+  arma::mat referenceData(mxGetPr(prhs[0]), numDimensions, numPoints);
 
   //if (!data::Load(referenceFile.c_str(), referenceData))
   //  Log::Fatal << "Reference file " << referenceFile << "not found." << endl;
@@ -131,15 +127,10 @@ void mexFunction(int nlhs, mxArray *plhs[],
     //if (!data::Load(queryFile.c_str(), queryData))
     //  Log::Fatal << "Query file " << queryFile << " not found" << endl;
 
-    // setting the values.
-    mexDataPoints = mxGetPr(prhs[3]);
-    numPoints = mxGetN(prhs[3]);
-    numDimensions = mxGetM(prhs[3]);
-    queryData = arma::mat(numDimensions, numPoints);
-    for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-    {
-      queryData(i) = mexDataPoints[i];
-    }
+    // setting the values (copied for the same reason).
+    queryData.set_size(mxGetM(prhs[3]), mxGetN(prhs[3]));
+    std::copy(mxGetPr(prhs[3]), mxGetPr(prhs[3]) + queryData.n_elem,
+        queryData.memptr());
 
     if (naive && leafSize < queryData.n_cols)
       leafSize = queryData.n_cols;
@@ -245,20 +236,14 @@ void mexFunction(int nlhs, mxArray *plhs[],
       // converting to matlab's index offset
       values[j] = neighborsOut[i][j] + 1;
     }
-    // note: SetField does not copy the data structure.
-    // mxDuplicateArray does the necessary copying.
-    mxSetFieldByNumber(plhs[0], i, 0, mxDuplicateArray(tmp));
-    mxDestroyArray(tmp);
+    // note: SetField does not copy the data structure; the struct takes
+    // ownership of it.
+    mxSetFieldByNumber(plhs[0], i, 0, tmp);
 
     // setting the distances
     tmp = mxCreateDoubleMatrix(1, numElements, mxREAL);
-    values = mxGetPr(tmp);
-    for (int j=0; j<numElements; ++j)
-    {
-      values[j] = distancesOut[i][j];
-    }
-    mxSetFieldByNumber(plhs[0], i, 1, mxDuplicateArray(tmp));
-    mxDestroyArray(tmp);
+    std::copy(distancesOut[i].begin(), distancesOut[i].end(), mxGetPr(tmp));
+    mxSetFieldByNumber(plhs[0], i, 1, tmp);
   }
 
   // Clean up.
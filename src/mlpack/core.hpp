@@ -148,16 +148,29 @@
 #include <mlpack/core/util/arma_traits.hpp>
 #include <mlpack/core/util/log.hpp>
 #include <mlpack/core/util/cli.hpp>
+#include <mlpack/core/util/parallel.hpp>
+#include <mlpack/core/util/memory_placement.hpp>
+#include <mlpack/core/util/profiler.hpp>
+#include <mlpack/core/util/memory_tracker.hpp>
+#include <mlpack/core/util/progress_reporter.hpp>
 #include <mlpack/core/util/ostream_extra.hpp>
 #include <mlpack/core/data/load.hpp>
 #include <mlpack/core/data/save.hpp>
+#include <mlpack/core/data/chunked_io.hpp>
+#include <mlpack/core/data/mapped_matrix.hpp>
+#include <mlpack/core/data/quantized_matrix.hpp>
 #include <mlpack/core/data/normalize_labels.hpp>
+#include <mlpack/core/data/label_mapping.hpp>
+#include <mlpack/core/data/unique_points.hpp>
 #include <mlpack/core/math/clamp.hpp>
 #include <mlpack/core/math/random.hpp>
 #include <mlpack/core/math/lin_alg.hpp>
+#include <mlpack/core/math/randomized_svd.hpp>
+#include <mlpack/core/math/power.hpp>
 #include <mlpack/core/math/range.hpp>
 #include <mlpack/core/math/round.hpp>
 #include <mlpack/core/util/save_restore_utility.hpp>
+#include <mlpack/core/dists/diagonal_gaussian_distribution.hpp>
 #include <mlpack/core/dists/discrete_distribution.hpp>
 #include <mlpack/core/dists/gaussian_distribution.hpp>
 #include <mlpack/core/dists/laplace_distribution.hpp>
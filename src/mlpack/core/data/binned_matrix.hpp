@@ -0,0 +1,117 @@
+/**
+ * @file binned_matrix.hpp
+ *
+ * A matrix whose elements are replaced by the number of the bin they fall
+ * into, one byte each, with the bins of each dimension set from the quantiles
+ * of the points.  It is used to search for splits on per-bin histograms
+ * instead of sorted values.
+ */
+#ifndef __MLPACK_CORE_DATA_BINNED_MATRIX_HPP
+#define __MLPACK_CORE_DATA_BINNED_MATRIX_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A matrix of points in which each element is replaced by the number of its
+ * bin, stored as one byte.  The bins of dimension d are separated by the
+ * increasing cut points Cuts(d): bin b holds the values v with
+ *
+ *   Cuts(d)[b - 1] < v <= Cuts(d)[b],
+ *
+ * where the first bin has no lower limit and the last has no upper limit, so a
+ * value is in a bin numbered at most b exactly when it is not more than
+ * Cuts(d)[b].  A split on a cut point therefore sends the same points to each
+ * side whether it is tested on the values or on the bins.
+ *
+ * Each cut point is halfway between two consecutive distinct values of the
+ * points, so no bin of the points is empty.  If a dimension has at most
+ * maxBins distinct values, every one of them gets its own bin; otherwise the
+ * cut points are placed at the quantiles of the dimension (moved past runs of
+ * equal values), so the bins hold about the same number of points.
+ *
+ * The bins are stored with one column per dimension (unlike the points), so
+ * that the bins of one dimension are contiguous: a histogram of a dimension is
+ * one pass over its column.
+ *
+ * @code
+ * extern arma::mat dataset;
+ * data::BinnedMatrix binned(dataset, 64);
+ *
+ * // Count the points in each bin of dimension 2.
+ * arma::Col<size_t> counts(binned.NumBins(2), arma::fill::zeros);
+ * for (size_t i = 0; i < binned.NumPoints(); ++i)
+ *   ++counts[binned.Dimension(2)[i]];
+ * @endcode
+ */
+class BinnedMatrix
+{
+ public:
+  //! Create an empty matrix.
+  BinnedMatrix() { }
+
+  /**
+   * Bin the given points.
+   *
+   * @tparam MatType Type of the matrix of points (arma::mat or arma::fmat).
+   * @param points Points to bin, one per column.
+   * @param maxBins Maximum number of bins of each dimension (2 to 256).
+   */
+  template<typename MatType>
+  BinnedMatrix(const MatType& points, const size_t maxBins = 256)
+  { Bin(points, maxBins); }
+
+  /**
+   * Bin the given points, replacing the contents of the matrix.  The
+   * dimensions are binned in parallel if OpenMP is available.
+   *
+   * @tparam MatType Type of the matrix of points (arma::mat or arma::fmat).
+   * @param points Points to bin, one per column.
+   * @param maxBins Maximum number of bins of each dimension (2 to 256).
+   */
+  template<typename MatType>
+  void Bin(const MatType& points, const size_t maxBins = 256);
+
+  /**
+   * Return the bin of dimension d that the given value falls into.
+   *
+   * @param d Dimension.
+   * @param value Value in that dimension.
+   */
+  size_t FindBin(const size_t d, const double value) const;
+
+  //! Get the number of dimensions of the points.
+  size_t Dimensionality() const { return bins.n_cols; }
+  //! Get the number of points.
+  size_t NumPoints() const { return bins.n_rows; }
+
+  //! Get the number of bins of dimension d.
+  size_t NumBins(const size_t d) const { return cuts[d].n_elem + 1; }
+  //! Get the cut points between the bins of dimension d, in increasing order.
+  const arma::vec& Cuts(const size_t d) const { return cuts[d]; }
+
+  //! Get the bins of dimension d (NumPoints() bytes, one for each point).
+  const unsigned char* Dimension(const size_t d) const
+  { return bins.colptr(d); }
+
+  //! Get the bins of the points, one column per dimension.
+  const arma::Mat<unsigned char>& Bins() const { return bins; }
+
+ private:
+  //! The bins of the points; one row per point and one column per dimension.
+  arma::Mat<unsigned char> bins;
+  //! The cut points of each dimension.
+  std::vector<arma::vec> cuts;
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "binned_matrix_impl.hpp"
+
+#endif
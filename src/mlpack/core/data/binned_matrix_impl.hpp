@@ -0,0 +1,101 @@
+/**
+ * @file binned_matrix_impl.hpp
+ *
+ * Implementation of the BinnedMatrix class.
+ */
+#ifndef __MLPACK_CORE_DATA_BINNED_MATRIX_IMPL_HPP
+#define __MLPACK_CORE_DATA_BINNED_MATRIX_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "binned_matrix.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace data {
+
+template<typename MatType>
+void BinnedMatrix::Bin(const MatType& points, const size_t maxBins)
+{
+  if (maxBins < 2 || maxBins > 256)
+  {
+    Log::Fatal << "BinnedMatrix::Bin(): the maximum number of bins must be "
+        << "between 2 and 256 (" << maxBins << " given)!" << std::endl;
+  }
+
+  const size_t n = points.n_cols;
+  bins.set_size(n, points.n_rows);
+  cuts.clear();
+  cuts.resize(points.n_rows);
+
+  // Each dimension is binned independently.
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t d = 0; d < points.n_rows; ++d)
+  {
+    std::vector<double> sorted(n);
+    for (size_t i = 0; i < n; ++i)
+      sorted[i] = points(d, i);
+    std::sort(sorted.begin(), sorted.end());
+
+    size_t distinct = (n > 0) ? 1 : 0;
+    for (size_t i = 1; i < n; ++i)
+      if (sorted[i] != sorted[i - 1])
+        ++distinct;
+
+    // The index of the first value after each cut.  If the values don't all
+    // get their own bin, the first value after a cut is the first value of a
+    // quantile, moved past the values equal to the one before it.
+    std::vector<size_t> firsts;
+    if (distinct <= maxBins)
+    {
+      for (size_t i = 1; i < n; ++i)
+        if (sorted[i] != sorted[i - 1])
+          firsts.push_back(i);
+    }
+    else
+    {
+      for (size_t k = 1; k < maxBins; ++k)
+      {
+        const size_t quantile = (k * n) / maxBins;
+        firsts.push_back(std::upper_bound(sorted.begin(), sorted.end(),
+            sorted[quantile - 1]) - sorted.begin());
+      }
+    }
+
+    std::vector<double> dimCuts;
+    for (size_t j = 0; j < firsts.size(); ++j)
+    {
+      if (firsts[j] >= n)
+        continue;
+
+      // A cut that rounds down to the value before it would not separate the
+      // two values.
+      const double lo = sorted[firsts[j] - 1];
+      const double cut = (lo + sorted[firsts[j]]) / 2.0;
+      if ((cut > lo) && (dimCuts.empty() || cut > dimCuts.back()))
+        dimCuts.push_back(cut);
+    }
+    cuts[d] = arma::conv_to<arma::vec>::from(dimCuts);
+
+    const double* begin = cuts[d].memptr();
+    const double* end = begin + cuts[d].n_elem;
+    unsigned char* dimBins = bins.colptr(d);
+    for (size_t i = 0; i < n; ++i)
+    {
+      dimBins[i] = (unsigned char) (std::lower_bound(begin, end,
+          (double) points(d, i)) - begin);
+    }
+  }
+}
+
+inline size_t BinnedMatrix::FindBin(const size_t d, const double value) const
+{
+  const double* begin = cuts[d].memptr();
+  const double* end = begin + cuts[d].n_elem;
+  return std::lower_bound(begin, end, value) - begin;
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,272 @@
+/**
+ * @file chunked_io.hpp
+ *
+ * Read and write datasets a fixed number of points at a time, so that programs
+ * can process datasets that do not fit in memory.
+ */
+#ifndef __MLPACK_CORE_DATA_CHUNKED_IO_HPP
+#define __MLPACK_CORE_DATA_CHUNKED_IO_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <string>
+#include <vector>
+#include <fstream>
+#include <boost/cstdint.hpp>
+
+#ifndef _WIN32
+  #include <pthread.h>
+#endif
+
+#include "format_text.hpp"
+#include "hdf5_file.hpp"
+#include "matrix_file.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Reads a dataset a chunk of points at a time, so the file is never held in
+ * memory all at once.  As with data::Load(), each point is returned as a column
+ * of the chunk.  The supported formats are:
+ *
+ *  - CSV (.csv) and ASCII (.txt), with one point per line.  Values may be
+ *    separated by commas or whitespace, and blank lines are skipped.
+ *  - Armadillo binary (.bin), as saved by data::Save() (so each point is a row
+ *    of the stored matrix).
+ *  - mlpack matrix files (.mlb, or .bin files that are matrix files), as saved
+ *    by data::Save(); any labels are ignored.
+ *  - HDF5 (.h5, .hdf5, .hdf or .he5), as saved by data::Save() (so each point
+ *    is a column of the dataset); each chunk is read with a hyperslab (see
+ *    hdf5_file.hpp).
+ *
+ * For Armadillo binary and matrix files, once a chunk has been read the
+ * operating system is asked to start reading the next one in the background,
+ * so that it is (at least partly) in memory by the time it is asked for.  For
+ * text files, the operating system's own read-ahead does the same, and HDF5
+ * keeps its own chunk cache.
+ *
+ * Algorithms that need several passes over the data can call Reset() to start
+ * again from the first point.
+ *
+ * If the parameter 'fatal' is set to true, the program will exit with an error
+ * if the file cannot be opened or a line cannot be parsed.
+ */
+class ChunkReader
+{
+ public:
+  /**
+   * Open the given file for reading.
+   *
+   * @param filename Name of file to read.
+   * @param fatal If an error should be reported as fatal (default false).
+   */
+  ChunkReader(const std::string& filename, const bool fatal = false);
+
+  //! Close the file.
+  ~ChunkReader();
+
+  /**
+   * Read up to maxPoints points into the given matrix.  When the end of the
+   * file has been reached, the matrix is left empty and false is returned.
+   * False is also returned if an error occurs.
+   *
+   * @param chunk Matrix to store the points in.
+   * @param maxPoints Maximum number of points to read.
+   * @return Whether or not any points were read.
+   */
+  template<typename eT>
+  bool Read(arma::Mat<eT>& chunk, const size_t maxPoints);
+
+  /**
+   * Go back to the start of the file, so that the next call to Read() returns
+   * the first points again.
+   *
+   * @return Whether or not the file is open.
+   */
+  bool Reset();
+
+  //! Return whether or not the file was opened successfully.
+  bool IsOpen() const { return stream.is_open() || hdf5.IsOpen(); }
+  //! Return the dimensionality of the points (0 if nothing has been read from a
+  //! text file).
+  size_t Dimensionality() const { return dimensionality; }
+  //! Return the number of points read so far.
+  size_t PointsRead() const { return pointsRead; }
+  //! Return whether or not a line could not be read (so Read() returning false
+  //! does not mean the end of the file was reached).
+  bool Failed() const { return failed; }
+
+ private:
+  //! Name of the file being read.
+  std::string filename;
+  //! Stream to read from.
+  std::ifstream stream;
+  //! Whether or not errors are fatal.
+  bool fatal;
+  //! The dimensionality of the points, given by the first line.
+  size_t dimensionality;
+  //! The number of points read so far.
+  size_t pointsRead;
+  //! The number of lines read so far, for error messages.
+  size_t lineNumber;
+  //! Whether or not a line could not be read.
+  bool failed;
+  //! Buffer for the current line.
+  std::string line;
+  //! Buffer for the values on the current line.
+  std::vector<double> values;
+
+  //! Whether or not the file is in one of the binary formats.
+  bool binary;
+  //! Whether or not the points are the rows of the stored matrix (as they are
+  //! for Armadillo binary files).
+  bool transposed;
+  //! The number of points in a binary file.
+  size_t numPoints;
+  //! The element type of a binary file (see matrix_file::ElementType()).
+  boost::uint64_t elementType;
+  //! The offset of the matrix in a binary file.
+  size_t dataOffset;
+  //! File descriptor used to ask for the next chunk of a binary file to be read
+  //! ahead (-1 if there is none).
+  int prefetchFile;
+  //! The dataset of an HDF5 file.
+  hdf5_file::Dataset hdf5;
+
+  //! Parse the current line into values; return false if it is malformed.
+  bool ParseLine();
+
+  //! Read the header of a binary file; return false if it is invalid.
+  bool ReadBinaryHeader(const bool matrixFile);
+
+  //! Read up to maxPoints points from a binary file.
+  template<typename eT>
+  bool ReadBinary(arma::Mat<eT>& chunk, const size_t maxPoints);
+
+  //! Read up to maxPoints points from an HDF5 file.
+  template<typename eT>
+  bool ReadHDF5(arma::Mat<eT>& chunk, const size_t maxPoints);
+
+  //! Ask the operating system to read the next (up to) the given number of
+  //! points of a binary file in the background.
+  void Prefetch(const size_t points);
+
+  //! Report an error (fatally, if 'fatal' is set) and return false.
+  bool Failure(const std::string& message);
+
+  //! Not copyable, because the file can only be closed once.
+  ChunkReader(const ChunkReader& other);
+  //! Not copyable, because the file can only be closed once.
+  ChunkReader& operator=(const ChunkReader& other);
+};
+
+/**
+ * Writes a matrix to a file a chunk of columns at a time.  Because each call
+ * appends to the file, the result is the same as calling data::Save() once on
+ * all of the chunks joined together (with transposition).  The supported
+ * formats are:
+ *
+ *  - CSV (.csv) and ASCII (.txt), with one point per line, formatted in
+ *    parallel by FormatText().
+ *  - mlpack matrix files (.mlb), with one point per column; the header is
+ *    updated after each chunk, so the file is complete after every Write().
+ *    This is much faster than text for large results such as the indices of
+ *    nearest neighbors, and every chunk must have the same element type and
+ *    number of rows.
+ *
+ * If 'asynchronous' is set, each chunk of a text file is copied and formatted
+ * on a background thread while the caller computes the next chunk; Write()
+ * first waits for the previous chunk to be written.  A failure to write a chunk
+ * in the background is reported by the next call to Write() or Flush().
+ *
+ * If the parameter 'fatal' is set to true, the program will exit with an error
+ * if the file cannot be opened or written to.
+ */
+class ChunkWriter
+{
+ public:
+  /**
+   * Open the given file for writing, replacing its contents.
+   *
+   * @param filename Name of file to write.
+   * @param fatal If an error should be reported as fatal (default false).
+   * @param asynchronous If text should be formatted on a background thread
+   *     (default false).
+   */
+  ChunkWriter(const std::string& filename,
+              const bool fatal = false,
+              const bool asynchronous = false);
+
+  //! Wait for any chunk still being written, and close the file.
+  ~ChunkWriter();
+
+  /**
+   * Append the columns of the given matrix to the file, one per line.
+   *
+   * @param chunk Matrix to write.
+   * @return Boolean value indicating success or failure of the write (in
+   *     asynchronous mode, of the write of the previous chunk).
+   */
+  template<typename eT>
+  bool Write(const arma::Mat<eT>& chunk);
+
+  /**
+   * Wait until every chunk given to Write() is in the file.
+   *
+   * @return Whether or not every chunk was written successfully.
+   */
+  bool Flush();
+
+  //! Return whether or not the file was opened successfully.
+  bool IsOpen() const { return stream.is_open(); }
+
+ private:
+  //! Name of the file being written.
+  std::string filename;
+  //! Stream to write to.
+  std::ofstream stream;
+  //! Whether or not errors are fatal.
+  bool fatal;
+  //! The separator of a text file.
+  char separator;
+  //! Whether or not the file is an mlpack matrix file.
+  bool binary;
+  //! The header of a matrix file, as it will be after the last chunk.
+  matrix_file::Header header;
+
+  //! Whether or not text is formatted on a background thread.
+  bool asynchronous;
+  //! The chunk being formatted in the background (NULL if there is none).
+  format_text::FormatJob* job;
+#ifndef _WIN32
+  //! The thread formatting the chunk.
+  pthread_t thread;
+#endif
+  //! Whether or not the background chunk was written successfully.
+  bool jobSucceeded;
+
+  //! Append a chunk to a matrix file.
+  template<typename eT>
+  bool WriteBinary(const arma::Mat<eT>& chunk);
+
+  //! Wait for the background chunk (if any) to be written; return whether or
+  //! not it was written successfully.
+  bool Wait();
+
+  //! Run the job of the given ChunkWriter (on the background thread).
+  static void* RunJob(void* writer);
+
+  //! Not copyable, because the file can only be closed once.
+  ChunkWriter(const ChunkWriter& other);
+  //! Not copyable, because the file can only be closed once.
+  ChunkWriter& operator=(const ChunkWriter& other);
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "chunked_io_impl.hpp"
+
+#endif
@@ -0,0 +1,584 @@
+/**
+ * @file chunked_io_impl.hpp
+ *
+ * Implementation of ChunkReader and ChunkWriter.
+ */
+#ifndef __MLPACK_CORE_DATA_CHUNKED_IO_IMPL_HPP
+#define __MLPACK_CORE_DATA_CHUNKED_IO_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "chunked_io.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+#include <mlpack/core/util/timers.hpp>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+namespace mlpack {
+namespace data {
+
+inline ChunkReader::ChunkReader(const std::string& filename, const bool fatal) :
+    filename(filename),
+    fatal(fatal),
+    dimensionality(0),
+    pointsRead(0),
+    lineNumber(0),
+    failed(false),
+    binary(false),
+    transposed(false),
+    numPoints(0),
+    elementType(0),
+    dataOffset(0),
+    prefetchFile(-1)
+{
+  const size_t ext = filename.rfind('.');
+  const std::string extension = (ext == std::string::npos) ? "" :
+      filename.substr(ext + 1);
+  if (extension == "h5" || extension == "hdf5" || extension == "hdf" ||
+      extension == "he5")
+  {
+    // HDF5 files are read through the HDF5 library, not the stream.
+    if (hdf5.Open(filename, fatal))
+      dimensionality = hdf5.Dimensionality();
+    return;
+  }
+
+  if (extension != "csv" && extension != "txt" && extension != "bin" &&
+      extension != "mlb")
+  {
+    Failure("Cannot read '" + filename + "' in chunks; only CSV (.csv), ASCII "
+        "(.txt), Armadillo binary (.bin), mlpack matrix (.mlb) and HDF5 files "
+        "are supported.");
+    failed = false;
+    return;
+  }
+
+  binary = (extension == "bin" || extension == "mlb");
+  stream.open(filename.c_str(), binary ? (std::ifstream::in |
+      std::ifstream::binary) : std::ifstream::in);
+  if (!stream.is_open())
+  {
+    if (fatal)
+      Log::Fatal << "Cannot open file '" << filename << "'. " << std::endl;
+    else
+      Log::Warn << "Cannot open file '" << filename << "'; load failed."
+          << std::endl;
+
+    return;
+  }
+
+  if (binary)
+  {
+    // A .bin file may be either format; matrix files start with their magic.
+    char buffer[sizeof(matrix_file::magic)];
+    stream.read(buffer, sizeof(buffer));
+    const bool matrixFile = (extension == "mlb") || (stream.good() &&
+        matrix_file::IsMatrixFile(buffer));
+    stream.clear();
+    stream.seekg(0);
+
+    if (!ReadBinaryHeader(matrixFile))
+    {
+      stream.close();
+      failed = false;
+      return;
+    }
+
+#ifndef _WIN32
+    prefetchFile = ::open(filename.c_str(), O_RDONLY);
+#endif
+  }
+}
+
+inline ChunkReader::~ChunkReader()
+{
+#ifndef _WIN32
+  if (prefetchFile != -1)
+    close(prefetchFile);
+#endif
+}
+
+template<typename eT>
+bool ChunkReader::Read(arma::Mat<eT>& chunk, const size_t maxPoints)
+{
+  chunk.reset();
+  if (!IsOpen() || maxPoints == 0)
+    return false;
+
+  if (hdf5.IsOpen())
+    return ReadHDF5(chunk, maxPoints);
+
+  if (binary)
+    return ReadBinary(chunk, maxPoints);
+
+  Timer::Start("loading_data");
+
+  size_t points = 0;
+  while (points < maxPoints && std::getline(stream, line))
+  {
+    ++lineNumber;
+    if (!ParseLine())
+    {
+      Timer::Stop("loading_data");
+      chunk.reset();
+      failed = true;
+      return false;
+    }
+
+    // Skip blank lines.
+    if (values.size() == 0)
+      continue;
+
+    // The first point decides the dimensionality.
+    if (dimensionality == 0)
+      dimensionality = values.size();
+
+    if (values.size() != dimensionality)
+    {
+      Timer::Stop("loading_data");
+      chunk.reset();
+      failed = true;
+      if (fatal)
+        Log::Fatal << "Line " << lineNumber << " of '" << filename << "' has "
+            << values.size() << " values, but " << dimensionality << " were "
+            << "expected." << std::endl;
+      else
+        Log::Warn << "Line " << lineNumber << " of '" << filename << "' has "
+            << values.size() << " values, but " << dimensionality << " were "
+            << "expected; load failed." << std::endl;
+
+      return false;
+    }
+
+    if (points == 0)
+      chunk.set_size(dimensionality, maxPoints);
+
+    for (size_t i = 0; i < dimensionality; ++i)
+      chunk(i, points) = (eT) values[i];
+    ++points;
+  }
+
+  Timer::Stop("loading_data");
+
+  if (points == 0)
+  {
+    chunk.reset();
+    return false;
+  }
+
+  if (points < maxPoints)
+    chunk.resize(dimensionality, points);
+
+  pointsRead += points;
+  return true;
+}
+
+template<typename eT>
+bool ChunkReader::ReadBinary(arma::Mat<eT>& chunk, const size_t maxPoints)
+{
+  const size_t points = std::min(maxPoints, numPoints - pointsRead);
+  if (points == 0)
+    return false;
+
+  Timer::Start("loading_data");
+
+  const size_t elementSize = matrix_file::ElementSize(elementType);
+  chunk.set_size(dimensionality, points);
+  bool success = true;
+  if (!transposed)
+  {
+    // The points are stored one after another, so the chunk can be read at
+    // once.
+    stream.seekg(dataOffset + pointsRead * dimensionality * elementSize);
+    success = matrix_file::ReadElements(stream, elementType, chunk.memptr(),
+        chunk.n_elem);
+  }
+  else
+  {
+    // Each dimension is stored separately, so read the points' values in each
+    // dimension.
+    arma::Row<eT> values(points);
+    for (size_t d = 0; d < dimensionality && success; ++d)
+    {
+      stream.seekg(dataOffset + (d * numPoints + pointsRead) * elementSize);
+      success = matrix_file::ReadElements(stream, elementType, values.memptr(),
+          points);
+      chunk.row(d) = values;
+    }
+  }
+
+  Timer::Stop("loading_data");
+
+  if (!success)
+  {
+    chunk.reset();
+    std::ostringstream oss;
+    oss << "Cannot read point " << pointsRead << " of '" << filename << "'.";
+    return Failure(oss.str());
+  }
+
+  pointsRead += points;
+  Prefetch(points);
+  return true;
+}
+
+template<typename eT>
+bool ChunkReader::ReadHDF5(arma::Mat<eT>& chunk, const size_t maxPoints)
+{
+  const size_t points = std::min(maxPoints, hdf5.NumPoints() - pointsRead);
+  if (points == 0)
+    return false;
+
+  Timer::Start("loading_data");
+  const bool success = hdf5.Read(pointsRead, points, chunk);
+  Timer::Stop("loading_data");
+
+  if (!success)
+  {
+    chunk.reset();
+    failed = true;
+    return false;
+  }
+
+  pointsRead += points;
+  return true;
+}
+
+inline bool ChunkReader::Reset()
+{
+  if (!IsOpen())
+    return false;
+
+  stream.clear();
+  if (stream.is_open())
+    stream.seekg(0);
+  pointsRead = 0;
+  lineNumber = 0;
+  failed = false;
+
+  return true;
+}
+
+inline bool ChunkReader::ReadBinaryHeader(const bool matrixFile)
+{
+  stream.seekg(0, std::ios::end);
+  const size_t fileSize = (size_t) stream.tellg();
+  stream.seekg(0);
+
+  if (matrixFile)
+  {
+    char buffer[matrix_file::headerSize];
+    stream.read(buffer, std::min(fileSize, matrix_file::headerSize));
+    stream.clear();
+
+    matrix_file::Header header;
+    std::string error;
+    if (!matrix_file::ReadHeader(buffer, std::min(fileSize,
+        matrix_file::headerSize), header, error))
+      return Failure("Cannot read '" + filename + "': " + error + ".");
+
+    if (fileSize != matrix_file::FileSize(header))
+      return Failure("Cannot read '" + filename + "': the file has the wrong "
+          "size for its header.");
+
+    dimensionality = (size_t) header.rows;
+    numPoints = (size_t) header.cols;
+    elementType = header.elementType;
+    dataOffset = matrix_file::HeaderSize(header);
+    transposed = false;
+    return true;
+  }
+
+  // Armadillo binary files start with a line like "ARMA_MAT_BIN_FN008", where
+  // the last five characters give the element type, then a line with the
+  // number of rows and columns.
+  std::string type;
+  size_t rows = 0, cols = 0;
+  std::getline(stream, type);
+  stream >> rows >> cols;
+  stream.get();
+
+  if (!stream.good() || type.size() != 18 ||
+      type.substr(0, 13) != "ARMA_MAT_BIN_")
+    return Failure("Cannot read '" + filename + "': not an Armadillo binary "
+        "matrix file.");
+
+  const std::string kind = type.substr(13, 2);
+  const size_t size = (size_t) atoi(type.substr(15).c_str());
+  if (kind == "FN" && (size == 4 || size == 8))
+    elementType = (1 << 8) | size;
+  else if (kind == "IS" && (size == 1 || size == 2 || size == 4 || size == 8))
+    elementType = (2 << 8) | size;
+  else if (kind == "IU" && (size == 1 || size == 2 || size == 4 || size == 8))
+    elementType = (3 << 8) | size;
+  else
+    return Failure("Cannot read '" + filename + "': unsupported element type '"
+        + type.substr(13) + "'.");
+
+  dataOffset = (size_t) stream.tellg();
+  if (fileSize != dataOffset + rows * cols * size)
+    return Failure("Cannot read '" + filename + "': the file has the wrong "
+        "size for its header.");
+
+  // data::Save() transposes, so each point is a row.
+  dimensionality = cols;
+  numPoints = rows;
+  transposed = true;
+  return true;
+}
+
+inline void ChunkReader::Prefetch(const size_t points)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+  const size_t count = std::min(points, numPoints - pointsRead);
+  if (prefetchFile == -1 || count == 0)
+    return;
+
+  const size_t elementSize = matrix_file::ElementSize(elementType);
+  if (!transposed)
+  {
+    posix_fadvise(prefetchFile, dataOffset + pointsRead * dimensionality *
+        elementSize, count * dimensionality * elementSize,
+        POSIX_FADV_WILLNEED);
+  }
+  else
+  {
+    for (size_t d = 0; d < dimensionality; ++d)
+      posix_fadvise(prefetchFile, dataOffset + (d * numPoints + pointsRead) *
+          elementSize, count * elementSize, POSIX_FADV_WILLNEED);
+  }
+#else
+  (void) points;
+#endif
+}
+
+inline bool ChunkReader::Failure(const std::string& message)
+{
+  failed = true;
+  if (fatal)
+    Log::Fatal << message << std::endl;
+  else
+    Log::Warn << message << std::endl;
+
+  return false;
+}
+
+inline bool ChunkReader::ParseLine()
+{
+  values.clear();
+
+  const char* position = line.c_str();
+  while (true)
+  {
+    while (*position == ',' || isspace(*position))
+      ++position;
+
+    if (*position == '\0')
+      return true;
+
+    char* end;
+    const double value = strtod(position, &end);
+    if (end == position)
+    {
+      if (fatal)
+        Log::Fatal << "Cannot parse line " << lineNumber << " of '"
+            << filename << "'." << std::endl;
+      else
+        Log::Warn << "Cannot parse line " << lineNumber << " of '"
+            << filename << "'; load failed." << std::endl;
+
+      return false;
+    }
+
+    values.push_back(value);
+    position = end;
+  }
+}
+
+inline ChunkWriter::ChunkWriter(const std::string& filename,
+                                const bool fatal,
+                                const bool asynchronous) :
+    filename(filename),
+    fatal(fatal),
+    separator(','),
+    binary(false),
+    asynchronous(asynchronous),
+    job(NULL),
+    jobSucceeded(true)
+{
+  header.version = matrix_file::version;
+  header.rows = 0;
+  header.cols = 0;
+  header.elementType = 0;
+  header.labels = 0;
+
+  const size_t ext = filename.rfind('.');
+  const std::string extension = (ext == std::string::npos) ? "" :
+      filename.substr(ext + 1);
+  if (extension == "txt")
+  {
+    separator = ' ';
+  }
+  else if (extension == "mlb")
+  {
+    binary = true;
+  }
+  else if (extension != "csv")
+  {
+    matrix_file::Failure("Cannot write '" + filename + "' in chunks; only CSV "
+        "(.csv), ASCII (.txt) and mlpack matrix (.mlb) files are supported.",
+        fatal);
+    return;
+  }
+
+  stream.open(filename.c_str(), binary ? (std::ofstream::out |
+      std::ofstream::trunc | std::ofstream::binary) : (std::ofstream::out |
+      std::ofstream::trunc));
+  if (!stream.is_open())
+  {
+    if (fatal)
+      Log::Fatal << "Cannot open file '" << filename << "' for writing. "
+          << "Save failed." << std::endl;
+    else
+      Log::Warn << "Cannot open file '" << filename << "' for writing; save "
+          << "failed." << std::endl;
+
+    return;
+  }
+
+  // The header of an empty matrix, so that the file is valid even if nothing
+  // is written to it.
+  if (binary)
+  {
+    char buffer[matrix_file::headerSize];
+    matrix_file::WriteHeader(header, buffer);
+    stream.write(buffer, matrix_file::headerSize);
+  }
+}
+
+inline ChunkWriter::~ChunkWriter()
+{
+  Flush();
+}
+
+template<typename eT>
+bool ChunkWriter::Write(const arma::Mat<eT>& chunk)
+{
+  if (!stream.is_open())
+    return false;
+
+  Timer::Start("saving_data");
+
+  // Only one chunk is formatted in the background at a time, and the chunks
+  // must reach the file in order.
+  bool success = Wait();
+
+  if (binary)
+  {
+    success = WriteBinary(chunk) && success;
+  }
+#ifndef _WIN32
+  else if (asynchronous)
+  {
+    job = new format_text::MatrixFormatJob<eT>(chunk);
+    if (pthread_create(&thread, NULL, RunJob, this) != 0)
+    {
+      // Fall back to formatting the chunk on this thread.
+      jobSucceeded = job->Run(stream, separator);
+      delete job;
+      job = NULL;
+      if (!jobSucceeded)
+        success = matrix_file::Failure("Save to '" + filename + "' failed.",
+            fatal);
+    }
+  }
+#endif
+  else if (!FormatText(stream, chunk, separator))
+  {
+    success = matrix_file::Failure("Save to '" + filename + "' failed.",
+        fatal);
+  }
+
+  Timer::Stop("saving_data");
+  return success;
+}
+
+template<typename eT>
+bool ChunkWriter::WriteBinary(const arma::Mat<eT>& chunk)
+{
+  if (header.cols == 0)
+  {
+    header.rows = chunk.n_rows;
+    header.elementType = matrix_file::ElementType<eT>();
+  }
+  else if (chunk.n_rows != header.rows ||
+           matrix_file::ElementType<eT>() != header.elementType)
+  {
+    return matrix_file::Failure("Cannot write to '" + filename + "': every "
+        "chunk of a matrix file must have the same number of rows and element "
+        "type.", fatal);
+  }
+
+  if (chunk.n_cols == 0)
+    return true;
+
+  stream.write((const char*) chunk.memptr(), chunk.n_elem * sizeof(eT));
+  header.cols += chunk.n_cols;
+
+  // Rewrite the header, so that the file holds a valid matrix at all times.
+  char buffer[matrix_file::headerSize];
+  matrix_file::WriteHeader(header, buffer);
+  stream.seekp(0);
+  stream.write(buffer, matrix_file::headerSize);
+  stream.seekp(0, std::ios::end);
+
+  if (!stream.good())
+    return matrix_file::Failure("Save to '" + filename + "' failed.", fatal);
+
+  return true;
+}
+
+inline bool ChunkWriter::Flush()
+{
+  if (!stream.is_open())
+    return false;
+
+  const bool success = Wait();
+  stream.flush();
+  return success;
+}
+
+inline bool ChunkWriter::Wait()
+{
+  if (job == NULL)
+    return true;
+
+#ifndef _WIN32
+  pthread_join(thread, NULL);
+#endif
+  delete job;
+  job = NULL;
+
+  if (!jobSucceeded)
+    return matrix_file::Failure("Save to '" + filename + "' failed.", fatal);
+
+  return true;
+}
+
+inline void* ChunkWriter::RunJob(void* writer)
+{
+  ChunkWriter& w = *((ChunkWriter*) writer);
+  w.jobSucceeded = w.job->Run(w.stream, w.separator);
+  return NULL;
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * @file dataset_info.hpp
+ *
+ * The types of the dimensions of a dataset loaded from text, and the mappings
+ * between the strings of its categorical dimensions and the values that stand
+ * for them in the matrix.
+ */
+#ifndef __MLPACK_CORE_DATA_DATASET_INFO_HPP
+#define __MLPACK_CORE_DATA_DATASET_INFO_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/log.hpp>
+
+#include <boost/unordered_map.hpp>
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+//! The type of a dimension of a dataset.
+enum Datatype
+{
+  //! The values of the dimension are numbers.
+  NUMERIC,
+  //! The values of the dimension are strings, each of which is given an index
+  //! in [0, n) in the order they first appear.
+  CATEGORICAL
+};
+
+/**
+ * Holds the type of each dimension of a dataset and, for each categorical
+ * dimension, the mapping between its strings and their indices (which are the
+ * values stored in the matrix).  This is filled in by the overload of
+ * data::Load() that takes a DatasetInfo.
+ */
+class DatasetInfo
+{
+ public:
+  /**
+   * Create the information for a dataset with the given number of dimensions,
+   * all of which are numeric.
+   *
+   * @param dimensionality Number of dimensions.
+   */
+  DatasetInfo(const size_t dimensionality = 0);
+
+  /**
+   * Return the index of the given string in the given dimension, giving it the
+   * next index if it has not been seen.  The dimension becomes categorical.
+   *
+   * @param string String to map.
+   * @param dimension Dimension of the string.
+   */
+  size_t MapString(const std::string& string, const size_t dimension);
+
+  /**
+   * Return the string with the given index in the given categorical dimension.
+   *
+   * @param value Index of the string.
+   * @param dimension Dimension of the string.
+   */
+  const std::string& UnmapString(const size_t value,
+                                 const size_t dimension) const;
+
+  //! Get the type of the given dimension.
+  Datatype Type(const size_t dimension) const { return types[dimension]; }
+
+  //! Get the number of strings of the given dimension (0 if it is numeric).
+  size_t NumMappings(const size_t dimension) const
+  { return strings[dimension].size(); }
+
+  //! Get the number of dimensions.
+  size_t Dimensionality() const { return types.size(); }
+
+ private:
+  //! The type of each dimension.
+  std::vector<Datatype> types;
+  //! The index of each string of each dimension.
+  std::vector<boost::unordered_map<std::string, size_t> > maps;
+  //! The strings of each dimension, by index.
+  std::vector<std::vector<std::string> > strings;
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "dataset_info_impl.hpp"
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ * @file dataset_info_impl.hpp
+ *
+ * Implementation of the DatasetInfo class.
+ */
+#ifndef __MLPACK_CORE_DATA_DATASET_INFO_IMPL_HPP
+#define __MLPACK_CORE_DATA_DATASET_INFO_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dataset_info.hpp"
+
+namespace mlpack {
+namespace data {
+
+inline DatasetInfo::DatasetInfo(const size_t dimensionality) :
+    types(dimensionality, NUMERIC),
+    maps(dimensionality),
+    strings(dimensionality)
+{
+  // Nothing to do.
+}
+
+inline size_t DatasetInfo::MapString(const std::string& string,
+                                     const size_t dimension)
+{
+  types[dimension] = CATEGORICAL;
+
+  const std::pair<boost::unordered_map<std::string, size_t>::iterator, bool>
+      result = maps[dimension].insert(std::make_pair(string,
+      strings[dimension].size()));
+  if (result.second)
+    strings[dimension].push_back(string);
+
+  return result.first->second;
+}
+
+inline const std::string& DatasetInfo::UnmapString(const size_t value,
+                                                   const size_t dimension)
+    const
+{
+  if (value >= strings[dimension].size())
+    Log::Fatal << "DatasetInfo::UnmapString(): dimension " << dimension
+        << " has no string with index " << value << "." << std::endl;
+
+  return strings[dimension][value];
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file format_text.hpp
+ *
+ * A parallel formatter for writing matrices as CSV or whitespace-separated
+ * text, which data::Save() and data::ChunkWriter use in place of Armadillo's
+ * (single-threaded) formatting.
+ */
+#ifndef __MLPACK_CORE_DATA_FORMAT_TEXT_HPP
+#define __MLPACK_CORE_DATA_FORMAT_TEXT_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <ostream>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Write the given matrix to the stream as text, one line per column (if
+ * 'transpose' is true) or per row, with the values separated by the given
+ * character (',' for CSV, ' ' for raw ASCII).
+ *
+ * The lines are formatted a block at a time: the lines of each block are split
+ * into pieces, which are formatted by different threads (if 'parallel' is
+ * true) into their own buffers, and the buffers are written in order.
+ * Integers (and floating-point values that are integers) are written directly;
+ * other floating-point values are written with the fewest of 15 or 17
+ * significant digits (6 or 9 for floats) that reads back as the same value.
+ *
+ * @param stream Stream to write to.
+ * @param matrix Matrix to write.
+ * @param separator Character to separate the values of a line with.
+ * @param transpose If true, write one line per column.
+ * @param parallel If false, format on the calling thread only.
+ * @return false if the stream could not be written to.
+ */
+template<typename eT>
+bool FormatText(std::ostream& stream,
+                const arma::Mat<eT>& matrix,
+                const char separator,
+                const bool transpose = true,
+                const bool parallel = true);
+
+namespace format_text {
+
+/**
+ * A matrix to be formatted and written later, on another thread, by
+ * data::ChunkWriter.  The matrix is copied, so that its owner can reuse it.
+ */
+class FormatJob
+{
+ public:
+  virtual ~FormatJob() { }
+
+  //! Format the matrix (one line per column) to the stream.
+  virtual bool Run(std::ostream& stream, const char separator) = 0;
+};
+
+//! A FormatJob for a matrix of the given element type.
+template<typename eT>
+class MatrixFormatJob : public FormatJob
+{
+ public:
+  MatrixFormatJob(const arma::Mat<eT>& matrix) : matrix(matrix) { }
+
+  bool Run(std::ostream& stream, const char separator)
+  {
+    // The other threads are busy with the computation, so this thread
+    // formats on its own.
+    return FormatText(stream, matrix, separator, true, false);
+  }
+
+ private:
+  //! The copy of the matrix.
+  const arma::Mat<eT> matrix;
+};
+
+}; // namespace format_text
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "format_text_impl.hpp"
+
+#endif
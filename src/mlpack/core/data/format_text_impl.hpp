@@ -0,0 +1,152 @@
+/**
+ * @file format_text_impl.hpp
+ *
+ * Implementation of the parallel text formatter.
+ */
+#ifndef __MLPACK_CORE_DATA_FORMAT_TEXT_IMPL_HPP
+#define __MLPACK_CORE_DATA_FORMAT_TEXT_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "format_text.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace data {
+namespace format_text {
+
+//! Write the given integer (with a '-' if 'negative' is set) into the buffer,
+//! returning the number of characters written.
+inline size_t FormatInteger(unsigned long long value,
+                            const bool negative,
+                            char* buffer)
+{
+  char digits[24];
+  size_t count = 0;
+  do
+  {
+    digits[count++] = (char) ('0' + (value % 10));
+    value /= 10;
+  } while (value != 0);
+
+  size_t length = 0;
+  if (negative)
+    buffer[length++] = '-';
+  while (count > 0)
+    buffer[length++] = digits[--count];
+
+  return length;
+}
+
+/**
+ * Write the given value into the buffer (which holds at least 32 characters),
+ * returning the number of characters written.
+ */
+template<typename eT>
+inline size_t FormatValue(const eT value, char* buffer)
+{
+  if (std::numeric_limits<eT>::is_integer)
+  {
+    if (std::numeric_limits<eT>::is_signed && value < 0)
+      return FormatInteger((unsigned long long) -(long long) value, true,
+          buffer);
+    return FormatInteger((unsigned long long) value, false, buffer);
+  }
+
+  // Whole numbers of up to 15 digits are written as integers.
+  const double v = (double) value;
+  if (v == std::floor(v) && std::abs(v) < 1e15)
+    return FormatInteger((unsigned long long) std::abs(v), v < 0, buffer);
+
+  // Otherwise, use the shorter precision if it reads back as the same value.
+  const int shortDigits = std::numeric_limits<eT>::digits10;
+  const int longDigits = (sizeof(eT) <= sizeof(float)) ? 9 : 17;
+  int length = sprintf(buffer, "%.*g", shortDigits, v);
+  if ((eT) strtod(buffer, NULL) != value)
+    length = sprintf(buffer, "%.*g", longDigits, v);
+
+  return (size_t) length;
+}
+
+}; // namespace format_text
+
+template<typename eT>
+bool FormatText(std::ostream& stream,
+                const arma::Mat<eT>& matrix,
+                const char separator,
+                const bool transpose,
+                const bool parallel)
+{
+  using namespace format_text;
+
+  const size_t lines = transpose ? matrix.n_cols : matrix.n_rows;
+  const size_t values = transpose ? matrix.n_rows : matrix.n_cols;
+  if (lines == 0 || values == 0)
+    return stream.good();
+
+  // Pieces of about 64k values each; each block has a few pieces per thread,
+  // so that only one block of text is held in memory at once.
+  size_t threads = 1;
+#ifdef HAS_OPENMP
+  if (parallel)
+    threads = (size_t) omp_get_max_threads();
+#endif
+  const size_t linesPerPiece = std::max((size_t) 1, 65536 / values);
+  const size_t piecesPerBlock = 4 * threads;
+  std::vector<std::string> pieces(piecesPerBlock);
+
+  for (size_t blockBegin = 0; blockBegin < lines;
+       blockBegin += piecesPerBlock * linesPerPiece)
+  {
+    const size_t blockPieces = std::min(piecesPerBlock, (lines - blockBegin +
+        linesPerPiece - 1) / linesPerPiece);
+
+    #pragma omp parallel for schedule(dynamic, 1) if (parallel)
+    for (size_t p = 0; p < blockPieces; ++p)
+    {
+      const size_t begin = blockBegin + p * linesPerPiece;
+      const size_t end = std::min(begin + linesPerPiece, lines);
+
+      std::string& piece = pieces[p];
+      piece.clear();
+      piece.reserve((end - begin) * values * 8);
+
+      char buffer[32];
+      for (size_t i = begin; i < end; ++i)
+      {
+        for (size_t j = 0; j < values; ++j)
+        {
+          if (j > 0)
+            piece += separator;
+
+          const eT value = transpose ? matrix(j, i) : matrix(i, j);
+          piece.append(buffer, FormatValue(value, buffer));
+        }
+        piece += '\n';
+      }
+    }
+
+    for (size_t p = 0; p < blockPieces; ++p)
+      stream.write(pieces[p].data(), pieces[p].size());
+
+    if (!stream.good())
+      return false;
+  }
+
+  return true;
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
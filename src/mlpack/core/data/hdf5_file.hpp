@@ -0,0 +1,161 @@
+/**
+ * @file hdf5_file.hpp
+ *
+ * Chunked, compressed HDF5 datasets, and reads of ranges of their points
+ * through hyperslabs, so that HDF5 files need never be held in memory whole.
+ * These need Armadillo to have been compiled with HDF5 support; otherwise every
+ * operation fails with an error.
+ */
+#ifndef __MLPACK_CORE_DATA_HDF5_FILE_HPP
+#define __MLPACK_CORE_DATA_HDF5_FILE_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <string>
+
+#ifdef ARMA_USE_HDF5
+  #include <hdf5.h>
+#endif
+
+#include "matrix_file.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * The files are laid out as Armadillo lays out HDF5 files, so that each can
+ * read the other's: the matrix is a two-dimensional dataset named "dataset",
+ * whose rows (in HDF5's row-major order) are the columns of the stored matrix.
+ * Because data::Save() transposes, this means each point of a matrix saved with
+ * data::Save() is a column of the HDF5 dataset, or a row if it was saved
+ * without transposition.
+ */
+namespace hdf5_file {
+
+//! The number of bytes of each chunk of a dataset (roughly).
+static const size_t chunkBytes = 1 << 20;
+//! The deflate level that datasets are compressed with.
+static const unsigned int compressionLevel = 4;
+
+/**
+ * Save a matrix to an HDF5 file as a chunked dataset, compressed with shuffle
+ * and deflate (if the HDF5 library has deflate).  Each chunk holds whole points
+ * (about chunkBytes of them), so reading a range of points decompresses little
+ * more than the range.  The matrix is written a chunk at a time, so when it is
+ * transposed only one chunk is ever copied.
+ *
+ * @param filename Name of the HDF5 file.
+ * @param matrix Matrix to save.
+ * @param transpose If true, transpose the matrix (as data::Save() does).
+ * @param fatal If true, errors are fatal.
+ * @return false if the file could not be saved.
+ */
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::Mat<eT>& matrix,
+          const bool transpose,
+          const bool fatal);
+
+/**
+ * An open dataset of an HDF5 file, from which any range of points can be read
+ * without reading the rest, using a hyperslab.  Since the reads are
+ * independent, several readers (each with its own Dataset) can each take a slab
+ * of the same file; within one process this needs an HDF5 library built to be
+ * thread-safe.
+ *
+ * @code
+ * data::hdf5_file::Dataset dataset("features.h5");
+ * arma::mat points;
+ * dataset.Read(1000000, 5000, points); // Points 1000000 to 1004999.
+ * @endcode
+ */
+class Dataset
+{
+ public:
+  //! Create a Dataset that is not open.
+  Dataset();
+
+  /**
+   * Open the matrix of the given HDF5 file.
+   *
+   * @param filename Name of the HDF5 file.
+   * @param fatal If an error should be reported as fatal (default false).
+   * @param transpose If true (the default), each point is a column of the HDF5
+   *     dataset, as written by data::Save().
+   */
+  Dataset(const std::string& filename,
+          const bool fatal = false,
+          const bool transpose = true);
+
+  //! Close the file.
+  ~Dataset();
+
+  /**
+   * Open the matrix of the given HDF5 file, closing any open file.
+   *
+   * @param filename Name of the HDF5 file.
+   * @param fatal If an error should be reported as fatal (default false).
+   * @param transpose If true (the default), each point is a column of the HDF5
+   *     dataset, as written by data::Save().
+   * @return Whether or not the file was opened successfully.
+   */
+  bool Open(const std::string& filename,
+            const bool fatal = false,
+            const bool transpose = true);
+
+  //! Close the file (if it is open).
+  void Close();
+
+  /**
+   * Read the given number of points, starting at the given point, as the
+   * columns of the given matrix.  The values are converted to eT by HDF5.
+   *
+   * @param begin Index of the first point to read.
+   * @param count Number of points to read.
+   * @param points Matrix to store the points in.
+   * @return false if the points could not be read.
+   */
+  template<typename eT>
+  bool Read(const size_t begin, const size_t count, arma::Mat<eT>& points);
+
+  //! Return whether or not a file is open.
+  bool IsOpen() const { return open; }
+  //! Return the dimensionality of the points.
+  size_t Dimensionality() const { return dimensionality; }
+  //! Return the number of points.
+  size_t NumPoints() const { return numPoints; }
+
+ private:
+  //! Name of the open file.
+  std::string filename;
+  //! Whether or not errors are fatal.
+  bool fatal;
+  //! Whether or not the points are the columns of the HDF5 dataset.
+  bool transpose;
+  //! Whether or not a file is open.
+  bool open;
+  //! The dimensionality of the points.
+  size_t dimensionality;
+  //! The number of points.
+  size_t numPoints;
+#ifdef ARMA_USE_HDF5
+  //! The open file.
+  hid_t file;
+  //! The open dataset.
+  hid_t dataset;
+#endif
+
+  //! Not copyable, because the file can only be closed once.
+  Dataset(const Dataset& other);
+  //! Not copyable, because the file can only be closed once.
+  Dataset& operator=(const Dataset& other);
+};
+
+}; // namespace hdf5_file
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "hdf5_file_impl.hpp"
+
+#endif
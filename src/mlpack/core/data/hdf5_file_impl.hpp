@@ -0,0 +1,351 @@
+/**
+ * @file hdf5_file_impl.hpp
+ *
+ * Implementation of chunked HDF5 saving and hyperslab reads.
+ */
+#ifndef __MLPACK_CORE_DATA_HDF5_FILE_IMPL_HPP
+#define __MLPACK_CORE_DATA_HDF5_FILE_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "hdf5_file.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace mlpack {
+namespace data {
+namespace hdf5_file {
+
+#ifdef ARMA_USE_HDF5
+
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::Mat<eT>& matrix,
+          const bool transpose,
+          const bool fatal)
+{
+  // The points are along the second dimension of the dataset if it is
+  // transposed, and the first otherwise.
+  const size_t pointDim = transpose ? 1 : 0;
+  hsize_t dims[2];
+  dims[1 - pointDim] = matrix.n_rows;
+  dims[pointDim] = matrix.n_cols;
+
+  const hid_t file = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT,
+      H5P_DEFAULT);
+  if (file < 0)
+    return matrix_file::Failure("Cannot open file '" + filename + "' for "
+        "writing; save failed.", fatal);
+
+  Log::Info << "Saving chunked HDF5 data to '" << filename << "'."
+      << std::endl;
+
+  const size_t pointsPerChunk = std::max((size_t) 1, std::min(
+      (size_t) matrix.n_cols, chunkBytes / std::max((size_t) matrix.n_rows *
+      sizeof(eT), (size_t) 1)));
+
+  // Empty datasets cannot be chunked.
+  const hid_t properties = H5Pcreate(H5P_DATASET_CREATE);
+  if (matrix.n_elem > 0)
+  {
+    hsize_t chunk[2];
+    chunk[1 - pointDim] = matrix.n_rows;
+    chunk[pointDim] = pointsPerChunk;
+    H5Pset_chunk(properties, 2, chunk);
+    if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0)
+    {
+      H5Pset_shuffle(properties);
+      H5Pset_deflate(properties, compressionLevel);
+    }
+  }
+
+  const hid_t type = arma::hdf5_misc::get_hdf5_type<eT>();
+  const hid_t space = H5Screate_simple(2, dims, NULL);
+  const hid_t dataset = H5Dcreate2(file, "dataset", type, space, H5P_DEFAULT,
+      properties, H5P_DEFAULT);
+  bool success = (dataset >= 0);
+
+  // Write a chunk of points at a time.
+  arma::Mat<eT> block;
+  for (size_t begin = 0; success && begin < matrix.n_cols;
+       begin += pointsPerChunk)
+  {
+    const size_t count = std::min(pointsPerChunk, matrix.n_cols - begin);
+
+    // Transposed, each row of the dataset holds one dimension of the points,
+    // so the block has to be transposed to be in HDF5's row-major order.
+    // Otherwise each row is a point, which is what the matrix holds.
+    const eT* memory = matrix.colptr(begin);
+    if (transpose)
+    {
+      block = trans(matrix.cols(begin, begin + count - 1));
+      memory = block.memptr();
+    }
+
+    hsize_t start[2], counts[2];
+    start[1 - pointDim] = 0;
+    start[pointDim] = begin;
+    counts[1 - pointDim] = matrix.n_rows;
+    counts[pointDim] = count;
+
+    const hid_t memorySpace = H5Screate_simple(2, counts, NULL);
+    H5Sselect_hyperslab(space, H5S_SELECT_SET, start, NULL, counts, NULL);
+    success = (H5Dwrite(dataset, type, memorySpace, space, H5P_DEFAULT,
+        memory) >= 0);
+    H5Sclose(memorySpace);
+  }
+
+  if (dataset >= 0)
+    H5Dclose(dataset);
+  H5Sclose(space);
+  H5Tclose(type);
+  H5Pclose(properties);
+  if (H5Fclose(file) < 0)
+    success = false;
+
+  if (!success)
+    return matrix_file::Failure("Save to '" + filename + "' failed.", fatal);
+
+  return true;
+}
+
+inline Dataset::Dataset() :
+    fatal(false),
+    transpose(true),
+    open(false),
+    dimensionality(0),
+    numPoints(0),
+    file(-1),
+    dataset(-1)
+{
+  // Nothing to do.
+}
+
+inline Dataset::Dataset(const std::string& filename,
+                        const bool fatal,
+                        const bool transpose) :
+    open(false),
+    dimensionality(0),
+    numPoints(0),
+    file(-1),
+    dataset(-1)
+{
+  Open(filename, fatal, transpose);
+}
+
+inline Dataset::~Dataset()
+{
+  Close();
+}
+
+inline bool Dataset::Open(const std::string& filename,
+                          const bool fatal,
+                          const bool transpose)
+{
+  Close();
+  this->filename = filename;
+  this->fatal = fatal;
+  this->transpose = transpose;
+
+  file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file < 0)
+    return matrix_file::Failure("Cannot open file '" + filename + "'; load "
+        "failed.", fatal);
+
+  // Armadillo names the dataset "dataset"; Octave names it "value".
+  if (H5Lexists(file, "dataset", H5P_DEFAULT) > 0)
+    dataset = H5Dopen2(file, "dataset", H5P_DEFAULT);
+  else if (H5Lexists(file, "value", H5P_DEFAULT) > 0)
+    dataset = H5Dopen2(file, "value", H5P_DEFAULT);
+
+  if (dataset < 0)
+  {
+    Close();
+    return matrix_file::Failure("Cannot read '" + filename + "': it has no "
+        "dataset named 'dataset' or 'value'.", fatal);
+  }
+
+  const hid_t space = H5Dget_space(dataset);
+  const int rank = H5Sget_simple_extent_ndims(space);
+  hsize_t dims[2] = { 1, 1 };
+  if (rank == 1 || rank == 2)
+    H5Sget_simple_extent_dims(space, dims, NULL);
+  H5Sclose(space);
+
+  if (rank != 1 && rank != 2)
+  {
+    Close();
+    return matrix_file::Failure("Cannot read '" + filename + "': the dataset "
+        "is not one- or two-dimensional.", fatal);
+  }
+
+  // A one-dimensional dataset is a single row.
+  if (rank == 1)
+  {
+    dims[1] = dims[0];
+    dims[0] = 1;
+  }
+
+  dimensionality = (size_t) dims[transpose ? 0 : 1];
+  numPoints = (size_t) dims[transpose ? 1 : 0];
+  open = true;
+  return true;
+}
+
+inline void Dataset::Close()
+{
+  if (dataset >= 0)
+    H5Dclose(dataset);
+  if (file >= 0)
+    H5Fclose(file);
+
+  dataset = -1;
+  file = -1;
+  open = false;
+  dimensionality = 0;
+  numPoints = 0;
+}
+
+template<typename eT>
+bool Dataset::Read(const size_t begin,
+                   const size_t count,
+                   arma::Mat<eT>& points)
+{
+  if (!open)
+    return false;
+
+  if (begin + count > numPoints)
+  {
+    std::ostringstream oss;
+    oss << "Cannot read points " << begin << " to " << (begin + count) << " of "
+        << "'" << filename << "', which has " << numPoints << " points.";
+    return matrix_file::Failure(oss.str(), fatal);
+  }
+
+  if (count == 0 || dimensionality == 0)
+  {
+    points.set_size(dimensionality, count);
+    return true;
+  }
+
+  // Transposed, the hyperslab comes back in HDF5's row-major order with one
+  // dimension per row, which is the transpose of what we want.
+  if (transpose)
+    points.set_size(count, dimensionality);
+  else
+    points.set_size(dimensionality, count);
+
+  const hid_t space = H5Dget_space(dataset);
+  const int rank = H5Sget_simple_extent_ndims(space);
+
+  // The start and size of the hyperslab, for either rank.
+  hsize_t start[2], counts[2];
+  if (rank == 1)
+  {
+    // Not transposed, the only point is the whole row.
+    start[0] = transpose ? begin : 0;
+    counts[0] = transpose ? count : dimensionality;
+  }
+  else
+  {
+    const size_t pointDim = transpose ? 1 : 0;
+    start[1 - pointDim] = 0;
+    start[pointDim] = begin;
+    counts[1 - pointDim] = dimensionality;
+    counts[pointDim] = count;
+  }
+
+  const hid_t type = arma::hdf5_misc::get_hdf5_type<eT>();
+  const hid_t memorySpace = H5Screate_simple(rank, counts, NULL);
+  H5Sselect_hyperslab(space, H5S_SELECT_SET, start, NULL, counts, NULL);
+  const bool success = (H5Dread(dataset, type, memorySpace, space,
+      H5P_DEFAULT, points.memptr()) >= 0);
+  H5Sclose(memorySpace);
+  H5Sclose(space);
+  H5Tclose(type);
+
+  if (!success)
+  {
+    points.reset();
+    std::ostringstream oss;
+    oss << "Cannot read point " << begin << " of '" << filename << "'.";
+    return matrix_file::Failure(oss.str(), fatal);
+  }
+
+  if (transpose)
+    arma::inplace_trans(points);
+
+  return true;
+}
+
+#else
+
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::Mat<eT>& /* matrix */,
+          const bool /* transpose */,
+          const bool fatal)
+{
+  return matrix_file::Failure("Attempted to save HDF5 data to '" + filename +
+      "', but Armadillo was compiled without HDF5 support.  Save failed.",
+      fatal);
+}
+
+inline Dataset::Dataset() :
+    fatal(false),
+    transpose(true),
+    open(false),
+    dimensionality(0),
+    numPoints(0)
+{
+  // Nothing to do.
+}
+
+inline Dataset::Dataset(const std::string& filename,
+                        const bool fatal,
+                        const bool transpose) :
+    open(false),
+    dimensionality(0),
+    numPoints(0)
+{
+  Open(filename, fatal, transpose);
+}
+
+inline Dataset::~Dataset()
+{
+  // Nothing to do.
+}
+
+inline bool Dataset::Open(const std::string& filename,
+                          const bool fatal,
+                          const bool transpose)
+{
+  this->filename = filename;
+  this->fatal = fatal;
+  this->transpose = transpose;
+
+  return matrix_file::Failure("Attempted to load '" + filename + "' as HDF5 "
+      "data, but Armadillo was compiled without HDF5 support.  Load failed.",
+      fatal);
+}
+
+inline void Dataset::Close()
+{
+  // Nothing to do.
+}
+
+template<typename eT>
+bool Dataset::Read(const size_t /* begin */,
+                   const size_t /* count */,
+                   arma::Mat<eT>& /* points */)
+{
+  return false;
+}
+
+#endif
+
+}; // namespace hdf5_file
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file label_mapping.hpp
+ *
+ * A mapping between labels of an arbitrary type and the normalized labels
+ * {0, 1, 2, ...}, which can be saved with a model, so that the labels of test
+ * data can be normalized the same way as the training labels.
+ */
+#ifndef __MLPACK_CORE_DATA_LABEL_MAPPING_HPP
+#define __MLPACK_CORE_DATA_LABEL_MAPPING_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/save_restore_utility.hpp>
+
+#include "normalize_labels.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Holds the labels that the normalized labels [0, n) stand for (as computed by
+ * NormalizeLabels()), and a sorted copy of them, so that other labels can be
+ * normalized with the same mapping in O(log n) time each, without another scan
+ * of the training labels.
+ *
+ * @code
+ * arma::Col<size_t> trainLabels, testLabels;
+ * data::LabelMapping<double> mapping(rawTrainLabels, trainLabels);
+ * // ... train the model; save the mapping with it ...
+ * mapping.Map(rawTestLabels, testLabels);
+ * @endcode
+ *
+ * @tparam eT Type of the original labels.
+ */
+template<typename eT>
+class LabelMapping
+{
+ public:
+  //! Create an empty mapping.
+  LabelMapping() { }
+
+  /**
+   * Create the mapping of the given labels, and normalize them.
+   *
+   * @param labelsIn Input labels of arbitrary datatype.
+   * @param labels Vector that unsigned labels will be stored in.
+   */
+  LabelMapping(const arma::Col<eT>& labelsIn, arma::Col<size_t>& labels);
+
+  /**
+   * Create the mapping from a reverse mapping, as returned by
+   * NormalizeLabels().
+   *
+   * @param mapping Original label of each normalized label.
+   */
+  LabelMapping(const arma::Col<eT>& mapping);
+
+  /**
+   * Replace the mapping with the mapping of the given labels, and normalize
+   * them.
+   *
+   * @param labelsIn Input labels of arbitrary datatype.
+   * @param labels Vector that unsigned labels will be stored in.
+   */
+  void Normalize(const arma::Col<eT>& labelsIn, arma::Col<size_t>& labels);
+
+  /**
+   * Normalize the given labels with the current mapping.  Every label must be
+   * in the mapping.
+   *
+   * @param labelsIn Input labels of arbitrary datatype.
+   * @param labels Vector that unsigned labels will be stored in.
+   */
+  void Map(const arma::Col<eT>& labelsIn, arma::Col<size_t>& labels) const;
+
+  /**
+   * Map the given normalized labels back to the original labels.
+   *
+   * @param labels Set of normalized labels to convert.
+   * @param labelsOut Vector to store the original labels in.
+   */
+  void Revert(const arma::Col<size_t>& labels, arma::Col<eT>& labelsOut) const;
+
+  //! Get the number of different labels.
+  size_t NumClasses() const { return mapping.n_elem; }
+  //! Get the original label of each normalized label.
+  const arma::Col<eT>& Mapping() const { return mapping; }
+
+  /**
+   * Save the mapping to a SaveRestoreUtility (the labels are stored as
+   * doubles).
+   */
+  void Save(util::SaveRestoreUtility& sr) const;
+
+  /**
+   * Load the mapping from a SaveRestoreUtility.
+   */
+  void Load(const util::SaveRestoreUtility& sr);
+
+ private:
+  //! The original label of each normalized label.
+  arma::Col<eT> mapping;
+  //! The original labels, sorted.
+  arma::Col<eT> sortedLabels;
+  //! The normalized label of each of the sorted labels.
+  arma::Col<size_t> sortedIndices;
+
+  //! Fill sortedLabels and sortedIndices from the mapping.
+  void Index();
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "label_mapping_impl.hpp"
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * @file label_mapping_impl.hpp
+ *
+ * Implementation of the LabelMapping class.
+ */
+#ifndef __MLPACK_CORE_DATA_LABEL_MAPPING_IMPL_HPP
+#define __MLPACK_CORE_DATA_LABEL_MAPPING_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "label_mapping.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace data {
+
+template<typename eT>
+LabelMapping<eT>::LabelMapping(const arma::Col<eT>& labelsIn,
+                               arma::Col<size_t>& labels)
+{
+  Normalize(labelsIn, labels);
+}
+
+template<typename eT>
+LabelMapping<eT>::LabelMapping(const arma::Col<eT>& mapping) :
+    mapping(mapping)
+{
+  Index();
+}
+
+template<typename eT>
+void LabelMapping<eT>::Normalize(const arma::Col<eT>& labelsIn,
+                                 arma::Col<size_t>& labels)
+{
+  NormalizeLabels(labelsIn, labels, mapping);
+  Index();
+}
+
+template<typename eT>
+void LabelMapping<eT>::Map(const arma::Col<eT>& labelsIn,
+                           arma::Col<size_t>& labels) const
+{
+  labels.set_size(labelsIn.n_elem);
+
+  const eT* begin = sortedLabels.memptr();
+  const eT* end = begin + sortedLabels.n_elem;
+  for (size_t i = 0; i < labelsIn.n_elem; ++i)
+  {
+    const eT* position = std::lower_bound(begin, end, labelsIn[i]);
+    if (position == end || *position != labelsIn[i])
+      Log::Fatal << "LabelMapping::Map(): label " << labelsIn[i] << " (index "
+          << i << ") is not in the mapping." << std::endl;
+
+    labels[i] = sortedIndices[position - begin];
+  }
+}
+
+template<typename eT>
+void LabelMapping<eT>::Revert(const arma::Col<size_t>& labels,
+                              arma::Col<eT>& labelsOut) const
+{
+  RevertLabels(labels, mapping, labelsOut);
+}
+
+template<typename eT>
+void LabelMapping<eT>::Save(util::SaveRestoreUtility& sr) const
+{
+  sr.SaveParameter(arma::conv_to<arma::vec>::from(mapping), "mapping");
+}
+
+template<typename eT>
+void LabelMapping<eT>::Load(const util::SaveRestoreUtility& sr)
+{
+  arma::vec savedMapping;
+  sr.LoadParameter(savedMapping, "mapping");
+  mapping = arma::conv_to<arma::Col<eT> >::from(savedMapping);
+  Index();
+}
+
+template<typename eT>
+void LabelMapping<eT>::Index()
+{
+  if (mapping.n_elem == 0)
+  {
+    sortedLabels.reset();
+    sortedIndices.reset();
+    return;
+  }
+
+  // The labels in the mapping are all different, so no two compare equal.
+  const arma::uvec order = arma::sort_index(mapping);
+  sortedLabels.set_size(mapping.n_elem);
+  sortedIndices.set_size(mapping.n_elem);
+  for (size_t i = 0; i < order.n_elem; ++i)
+  {
+    sortedLabels[i] = mapping[order[i]];
+    sortedIndices[i] = order[i];
+  }
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
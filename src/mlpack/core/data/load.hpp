@@ -13,6 +13,9 @@
 #include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
 #include <string>
 
+#include "dataset_info.hpp"
+#include "hdf5_file.hpp"
+
 namespace mlpack {
 namespace data /** Functions to load and save matrices. */ {
 
@@ -31,6 +34,13 @@ namespace data /** Functions to load and save matrices. */ {
  *  - Raw binary (raw_binary), denoted by .bin
  *  - Armadillo binary (arma_binary), denoted by .bin
  *  - HDF5, denoted by .hdf, .hdf5, .h5, or .he5
+ *  - mlpack matrix files (see matrix_file.hpp), denoted by .mlb, or .bin
+ *    (detected by the header)
+ *
+ * mlpack matrix files are column-major, so they are read with a single read,
+ * without parsing or transposing ('transpose' is ignored for them).  To use a
+ * matrix file (of doubles) without loading it at all, memory-map it with
+ * MappedMatrix.
  *
  * If the file extension is not one of those types, an error will be given.
  * This is preferable to Armadillo's default behavior of loading an unknown
@@ -54,6 +64,75 @@ bool Load(const std::string& filename,
           bool fatal = false,
           bool transpose = true);
 
+/**
+ * Loads a matrix and the labels of its columns from an mlpack matrix file (see
+ * matrix_file.hpp).  If the file has no labels, the labels are empty.  Other
+ * kinds of files cannot hold labels, so they cannot be loaded with this
+ * overload.
+ *
+ * @param filename Name of matrix file to load.
+ * @param matrix Matrix to load contents of file into.
+ * @param labels Row to load the labels into.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          arma::Row<size_t>& labels,
+          bool fatal = false);
+
+/**
+ * Loads a text file (CSV, TSV, or whitespace-separated) whose dimensions may
+ * hold strings, such as categorical data.  Each string is replaced by its index
+ * in its dimension, and the type of each dimension and the mapping of its
+ * strings are stored in info (see DatasetInfo).  The file is parsed in
+ * parallel; see ParseText() for the format.  Like the other overloads, the
+ * matrix is transposed (so it has one point per column) unless 'transpose' is
+ * false.
+ *
+ * @param filename Name of file to load.
+ * @param matrix Matrix to load contents of file into.
+ * @param info Information about the dimensions of the dataset.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @param transpose If true, transpose the matrix after loading.
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          DatasetInfo& info,
+          bool fatal = false,
+          bool transpose = true);
+
+/**
+ * Loads the given range of points (columns, after transposition) of an HDF5
+ * file, reading only that range from the file with a hyperslab (see
+ * hdf5_file.hpp).  This lets several programs (or threads, with a thread-safe
+ * HDF5 library) each load a slab of a dataset too large to load whole.  Other
+ * kinds of files are not supported by this overload; use ChunkReader to read
+ * them a range of points at a time.
+ *
+ * @code
+ * arma::mat points;
+ * data::Load("features.h5", points, arma::span(1000, 1999)); // 1000 points.
+ * @endcode
+ *
+ * @param filename Name of HDF5 file to load.
+ * @param matrix Matrix to load the points into.
+ * @param points The range of points to load (arma::span::all for every point).
+ * @param fatal If an error should be reported as fatal (default false).
+ * @param transpose If true, the points are the columns of the transposed
+ *     matrix, as they are for data::Load().
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          const arma::span& points,
+          bool fatal = false,
+          bool transpose = true);
+
 }; // namespace data
 }; // namespace mlpack
 
@@ -9,8 +9,12 @@
 
 // In case it hasn't already been included.
 #include "load.hpp"
+#include "matrix_file.hpp"
+#include "parse_text.hpp"
 
 #include <algorithm>
+#include <limits>
+#include <mlpack/core/util/memory_placement.hpp>
 #include <mlpack/core/util/timers.hpp>
 
 namespace mlpack {
@@ -60,6 +64,27 @@ bool Load(const std::string& filename,
     return false;
   }
 
+  // mlpack matrix files are read directly, without Armadillo.  A .bin file
+  // may also be a matrix file.
+  bool matrixFile = (extension == "mlb");
+  if (extension == "bin")
+  {
+    char rawHeader[sizeof(matrix_file::magic)];
+    stream.read(rawHeader, sizeof(rawHeader));
+    matrixFile = (stream.gcount() == sizeof(rawHeader)) &&
+        matrix_file::IsMatrixFile(rawHeader);
+    stream.clear();
+    stream.seekg(0);
+  }
+
+  if (matrixFile)
+  {
+    stream.close();
+    const bool success = matrix_file::Load(filename, matrix, NULL, fatal);
+    Timer::Stop("loading_data");
+    return success;
+  }
+
   bool unknownType = false;
   arma::file_type loadType;
   std::string stringType;
@@ -201,6 +226,20 @@ bool Load(const std::string& filename,
     Log::Info << "Loading '" << filename << "' as " << stringType << ".  "
         << std::flush;
 
+  // Numeric text files are parsed in parallel, straight into the transposed
+  // matrix.  If that doesn't work (a header line, say), Armadillo gets to try.
+  if (transpose && !std::numeric_limits<eT>::is_integer &&
+      (loadType == arma::csv_ascii || loadType == arma::raw_ascii))
+  {
+    if (ParseText(filename, matrix))
+    {
+      Log::Info << "Size is " << matrix.n_cols << " x " << matrix.n_rows
+          << ".\n";
+      Timer::Stop("loading_data");
+      return true;
+    }
+  }
+
   const bool success = matrix.load(stream, loadType);
 
   if (!success)
@@ -222,12 +261,105 @@ bool Load(const std::string& filename,
   if (transpose)
     matrix = trans(matrix);
 
+  // The loaded matrix is written by this thread only, so move it to the NUMA
+  // nodes of the threads that will process it, if asked.
+  util::PlaceMatrix(matrix);
+
   Timer::Stop("loading_data");
 
   // Finally, return the success indicator.
   return success;
 }
 
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          arma::Row<size_t>& labels,
+          bool fatal)
+{
+  Timer::Start("loading_data");
+  const bool success = matrix_file::Load(filename, matrix, &labels, fatal);
+  Timer::Stop("loading_data");
+
+  return success;
+}
+
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          DatasetInfo& info,
+          bool fatal,
+          bool transpose)
+{
+  Timer::Start("loading_data");
+
+  Log::Info << "Loading '" << filename << "' as categorical text data.  "
+      << std::flush;
+  if (!ParseText(filename, matrix, info))
+  {
+    Log::Info << std::endl;
+    Timer::Stop("loading_data");
+    if (fatal)
+      Log::Fatal << "Loading from '" << filename << "' failed." << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed." << std::endl;
+
+    return false;
+  }
+
+  size_t categoricalDimensions = 0;
+  for (size_t d = 0; d < info.Dimensionality(); ++d)
+    if (info.Type(d) == CATEGORICAL)
+      ++categoricalDimensions;
+  Log::Info << "Size is " << matrix.n_cols << " x " << matrix.n_rows << ", "
+      << "with " << categoricalDimensions << " categorical dimensions.\n";
+
+  // The matrix is parsed with one point per column already.
+  if (!transpose)
+    matrix = trans(matrix);
+
+  Timer::Stop("loading_data");
+  return true;
+}
+
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          const arma::span& points,
+          bool fatal,
+          bool transpose)
+{
+  const size_t ext = filename.rfind('.');
+  const std::string extension = (ext == std::string::npos) ? "" :
+      filename.substr(ext + 1);
+  if (extension != "h5" && extension != "hdf5" && extension != "hdf" &&
+      extension != "he5")
+  {
+    return matrix_file::Failure("Cannot load a range of the points of '" +
+        filename + "'; only HDF5 files are supported.", fatal);
+  }
+
+  Timer::Start("loading_data");
+
+  hdf5_file::Dataset dataset(filename, fatal, transpose);
+  if (!dataset.IsOpen())
+  {
+    Timer::Stop("loading_data");
+    return false;
+  }
+
+  const size_t begin = points.whole ? 0 : points.a;
+  const size_t count = points.whole ? dataset.NumPoints() : (points.b < points.a
+      ? 0 : points.b - points.a + 1);
+
+  Log::Info << "Loading " << count << " points of '" << filename << "' as HDF5 "
+      << "data, starting at point " << begin << "." << std::endl;
+
+  const bool success = dataset.Read(begin, count, matrix);
+  Timer::Stop("loading_data");
+  return success;
+}
+
 }; // namespace data
 }; // namespace mlpack
 
@@ -0,0 +1,125 @@
+/**
+ * @file mapped_matrix.hpp
+ *
+ * A matrix stored in a binary file that is memory-mapped instead of loaded, so
+ * that programs can work with datasets that do not fit in memory.
+ */
+#ifndef __MLPACK_CORE_DATA_MAPPED_MATRIX_HPP
+#define __MLPACK_CORE_DATA_MAPPED_MATRIX_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <string>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A matrix of doubles held in a binary matrix file.  Where possible (that is,
+ * on POSIX systems), the file is memory-mapped, so the matrix can be much
+ * larger than the available memory: the operating system reads the columns
+ * when they are used and drops them when memory is needed, so a pass over the
+ * matrix reads the file chunk by chunk.  Otherwise, the file is read into
+ * memory.
+ *
+ * A MappedMatrix either opens an existing matrix file, in which case changes to
+ * the matrix are not written to the file, or creates a new one, in which case
+ * the matrix is the contents of the file and changes are written to it (this
+ * is useful for scratch space that is too large for memory).  The matrix may
+ * not be resized, and the MappedMatrix object must not be destroyed while the
+ * matrix is still in use.
+ *
+ * The file is an mlpack matrix file (see matrix_file.hpp) holding doubles;
+ * labels in the file are ignored.  Save(), Convert() and data::Save() (with a
+ * .mlb extension) write matrix files.
+ */
+class MappedMatrix
+{
+ public:
+  /**
+   * Open the given matrix file.  Log::Fatal is used if the file cannot be
+   * opened or is not a valid matrix file.
+   *
+   * @param filename Name of matrix file to open.
+   */
+  MappedMatrix(const std::string& filename);
+
+  /**
+   * Create a matrix file with the given size, replacing the file if it exists.
+   * The elements of the matrix are initially zero.  Log::Fatal is used if the
+   * file cannot be created.
+   *
+   * @param filename Name of matrix file to create.
+   * @param rows Number of rows of the matrix.
+   * @param cols Number of columns of the matrix.
+   */
+  MappedMatrix(const std::string& filename,
+               const size_t rows,
+               const size_t cols);
+
+  /**
+   * Release the matrix, writing it to the file if the file was created by
+   * this object.
+   */
+  ~MappedMatrix();
+
+  //! Get the matrix.
+  const arma::mat& Matrix() const { return *matrix; }
+  //! Modify the matrix (it may not be resized).
+  arma::mat& Matrix() { return *matrix; }
+
+  /**
+   * Save the given matrix to a matrix file.
+   *
+   * @param filename Name of matrix file to write.
+   * @param matrix Matrix to save.
+   * @return false if the file could not be written.
+   */
+  static bool Save(const std::string& filename, const arma::mat& matrix);
+
+  /**
+   * Convert a CSV (.csv) or ASCII (.txt) dataset with one point per line to a
+   * matrix file with one point per column (as data::Load() would give), a
+   * chunk of points at a time, so the dataset is never held in memory.
+   *
+   * @param textFile Name of the dataset to convert.
+   * @param filename Name of the matrix file to write.
+   * @param chunkSize Number of points to convert at a time.
+   * @return false if the dataset could not be read or the file could not be
+   *     written.
+   */
+  static bool Convert(const std::string& textFile,
+                      const std::string& filename,
+                      const size_t chunkSize = 100000);
+
+ private:
+  //! Name of the file.
+  std::string filename;
+  //! The contents of the file (either mapped or allocated).
+  char* memory;
+  //! The size of the file.
+  size_t memorySize;
+  //! If true, the memory is a mapping of the file.
+  bool mapped;
+  //! If true, changes to the matrix are written to the file.
+  bool writable;
+
+  //! The matrix (which uses the memory of the file).
+  arma::mat* matrix;
+
+  //! Release the contents of the file.
+  void Release();
+
+  //! Not copyable, because the mapping can only be released once.
+  MappedMatrix(const MappedMatrix& other);
+  //! Not copyable, because the mapping can only be released once.
+  MappedMatrix& operator=(const MappedMatrix& other);
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "mapped_matrix_impl.hpp"
+
+#endif
@@ -0,0 +1,281 @@
+/**
+ * @file mapped_matrix_impl.hpp
+ *
+ * Implementation of the MappedMatrix class.
+ */
+#ifndef __MLPACK_CORE_DATA_MAPPED_MATRIX_IMPL_HPP
+#define __MLPACK_CORE_DATA_MAPPED_MATRIX_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "mapped_matrix.hpp"
+#include "chunked_io.hpp"
+#include "matrix_file.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <boost/cstdint.hpp>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+namespace mlpack {
+namespace data {
+inline MappedMatrix::MappedMatrix(const std::string& filename) :
+    filename(filename),
+    memory(NULL),
+    memorySize(0),
+    mapped(false),
+    writable(false),
+    matrix(NULL)
+{
+#ifndef _WIN32
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    Log::Fatal << "Cannot open matrix file '" << filename << "'." << std::endl;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+  {
+    close(fd);
+    Log::Fatal << "Cannot determine the size of matrix file '" << filename
+        << "'." << std::endl;
+  }
+  memorySize = (size_t) fileStat.st_size;
+
+  // The mapping is private, so the file can't be changed through the matrix.
+  void* address = mmap(NULL, memorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+      fd, 0);
+  close(fd);
+
+  if (address == MAP_FAILED)
+    Log::Fatal << "Cannot map matrix file '" << filename << "'." << std::endl;
+
+  memory = (char*) address;
+  mapped = true;
+#else
+  // No mmap(); read the whole file instead.
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open matrix file '" << filename << "'." << std::endl;
+
+  stream.seekg(0, std::ios::end);
+  memorySize = (size_t) stream.tellg();
+  stream.seekg(0, std::ios::beg);
+
+  memory = new char[memorySize];
+  stream.read(memory, memorySize);
+  if (!stream.good())
+  {
+    Release();
+    Log::Fatal << "Cannot read matrix file '" << filename << "'." << std::endl;
+  }
+#endif
+
+  // Check the header.
+  matrix_file::Header header;
+  std::string error;
+  if (!matrix_file::ReadHeader(memory, memorySize, header, error))
+  {
+    Release();
+    Log::Fatal << "Cannot open matrix file '" << filename << "': " << error
+        << "." << std::endl;
+  }
+
+  if (header.elementType != matrix_file::ElementType<double>())
+  {
+    Release();
+    Log::Fatal << "Matrix file '" << filename << "' does not hold doubles; "
+        << "use data::Load() to load it." << std::endl;
+  }
+
+  const size_t expectedSize = matrix_file::FileSize(header);
+  if (memorySize != expectedSize)
+  {
+    Release();
+    Log::Fatal << "Matrix file '" << filename << "' has size " << memorySize
+        << " but should have size " << expectedSize << "." << std::endl;
+  }
+
+  // Any labels after the matrix are ignored.
+  matrix = new arma::mat((double*) (memory + matrix_file::HeaderSize(header)),
+      (size_t) header.rows, (size_t) header.cols, false, true);
+}
+
+inline MappedMatrix::MappedMatrix(const std::string& filename,
+                                  const size_t rows,
+                                  const size_t cols) :
+    filename(filename),
+    memory(NULL),
+    memorySize(matrix_file::headerSize + rows * cols * sizeof(double)),
+    mapped(false),
+    writable(true),
+    matrix(NULL)
+{
+#ifndef _WIN32
+  const int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1)
+    Log::Fatal << "Cannot create matrix file '" << filename << "'."
+        << std::endl;
+
+  // Extending the file fills it with zeros.
+  if (ftruncate(fd, (off_t) memorySize) != 0)
+  {
+    close(fd);
+    Log::Fatal << "Cannot extend matrix file '" << filename << "' to "
+        << memorySize << " bytes." << std::endl;
+  }
+
+  // The mapping is shared, so changes to the matrix are written to the file.
+  void* address = mmap(NULL, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED,
+      fd, 0);
+  close(fd);
+
+  if (address == MAP_FAILED)
+    Log::Fatal << "Cannot map matrix file '" << filename << "'." << std::endl;
+
+  memory = (char*) address;
+  mapped = true;
+#else
+  // No mmap(); the file is written when the object is destroyed.
+  memory = new char[memorySize];
+  memset(memory, 0, memorySize);
+#endif
+
+  matrix_file::Header header;
+  header.rows = rows;
+  header.cols = cols;
+  header.elementType = matrix_file::ElementType<double>();
+  header.labels = 0;
+  matrix_file::WriteHeader(header, memory);
+
+  matrix = new arma::mat((double*) (memory + matrix_file::headerSize), rows,
+      cols, false, true);
+}
+
+inline MappedMatrix::~MappedMatrix()
+{
+  // The matrix must be deleted before the memory it uses.
+  if (matrix)
+    delete matrix;
+
+  if (writable && !mapped && memory)
+  {
+    std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary |
+        std::ios::trunc);
+    stream.write(memory, memorySize);
+    if (!stream.good())
+      Log::Warn << "Error while writing matrix file '" << filename << "'."
+          << std::endl;
+  }
+
+  Release();
+}
+
+inline bool MappedMatrix::Save(const std::string& filename,
+                               const arma::mat& matrix)
+{
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary |
+      std::ios::trunc);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << filename << "' to save matrix to."
+        << std::endl;
+    return false;
+  }
+
+  matrix_file::Header header;
+  header.rows = matrix.n_rows;
+  header.cols = matrix.n_cols;
+  header.elementType = matrix_file::ElementType<double>();
+  header.labels = 0;
+  char buffer[matrix_file::headerSize];
+  matrix_file::WriteHeader(header, buffer);
+  stream.write(buffer, matrix_file::headerSize);
+  stream.write((const char*) matrix.memptr(), matrix.n_elem * sizeof(double));
+
+  if (!stream.good())
+  {
+    Log::Warn << "Error while writing matrix to '" << filename << "'."
+        << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+inline bool MappedMatrix::Convert(const std::string& textFile,
+                                  const std::string& filename,
+                                  const size_t chunkSize)
+{
+  ChunkReader reader(textFile);
+  if (!reader.IsOpen())
+    return false;
+
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary |
+      std::ios::trunc);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << filename << "' to save matrix to."
+        << std::endl;
+    return false;
+  }
+
+  // The size isn't known until the whole dataset has been read, so the header
+  // is written again at the end.
+  matrix_file::Header header;
+  header.rows = 0;
+  header.cols = 0;
+  header.elementType = matrix_file::ElementType<double>();
+  header.labels = 0;
+  char buffer[matrix_file::headerSize];
+  matrix_file::WriteHeader(header, buffer);
+  stream.write(buffer, matrix_file::headerSize);
+
+  arma::mat chunk;
+  while (reader.Read(chunk, chunkSize))
+    stream.write((const char*) chunk.memptr(), chunk.n_elem * sizeof(double));
+
+  if (reader.Failed())
+    return false;
+
+  header.rows = reader.Dimensionality();
+  header.cols = reader.PointsRead();
+  matrix_file::WriteHeader(header, buffer);
+  stream.seekp(0);
+  stream.write(buffer, matrix_file::headerSize);
+
+  if (!stream.good())
+  {
+    Log::Warn << "Error while writing matrix to '" << filename << "'."
+        << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+inline void MappedMatrix::Release()
+{
+  if (memory == NULL)
+    return;
+
+#ifndef _WIN32
+  if (mapped)
+    munmap(memory, memorySize);
+  else
+    delete[] memory;
+#else
+  delete[] memory;
+#endif
+
+  memory = NULL;
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,382 @@
+/**
+ * @file matrix_file.hpp
+ *
+ * Definitions of the mlpack binary matrix file format, which holds a
+ * column-major matrix (and optionally a label for each column) so that it can
+ * be loaded without parsing or transposing, or memory-mapped.
+ */
+#ifndef __MLPACK_CORE_DATA_MATRIX_FILE_HPP
+#define __MLPACK_CORE_DATA_MATRIX_FILE_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * The mlpack binary matrix file format.  A matrix file holds, in the native
+ * byte order:
+ *
+ *  - the 8 characters "MLPACKMM";
+ *  - the version, the number of rows, the number of columns, the element type
+ *    and the number of labels per column (0 or 1), as 64-bit unsigned
+ *    integers;
+ *  - the matrix, in column-major order (as it is held in memory);
+ *  - if there are labels, one 64-bit unsigned integer label for each column.
+ *
+ * The header is 48 bytes long, so the matrix is aligned when the file is
+ * memory-mapped.  Version 1 files (from earlier versions of mlpack) have a
+ * 32-byte header with only the version, rows and columns, and always hold
+ * doubles without labels.
+ *
+ * The element type is (k << 8) | s, where s is the size of an element in bytes
+ * and k is 1 for floating-point types, 2 for signed integers and 3 for unsigned
+ * integers.
+ */
+namespace matrix_file {
+
+//! The first 8 bytes of every matrix file.
+static const char magic[8] = { 'M', 'L', 'P', 'A', 'C', 'K', 'M', 'M' };
+//! The current version of the format.
+static const boost::uint64_t version = 2;
+//! The size of the header of the current version.
+static const size_t headerSize = 48;
+
+/**
+ * The header of a matrix file.
+ */
+struct Header
+{
+  //! The version of the file.
+  boost::uint64_t version;
+  //! The number of rows of the matrix.
+  boost::uint64_t rows;
+  //! The number of columns of the matrix.
+  boost::uint64_t cols;
+  //! The element type (see ElementType()).
+  boost::uint64_t elementType;
+  //! The number of labels per column (0 or 1).
+  boost::uint64_t labels;
+};
+
+//! Return the element type code of the given type.
+template<typename eT>
+inline boost::uint64_t ElementType()
+{
+  const boost::uint64_t kind = !std::numeric_limits<eT>::is_integer ? 1 :
+      (std::numeric_limits<eT>::is_signed ? 2 : 3);
+  return (kind << 8) | sizeof(eT);
+}
+
+//! Return the size in bytes of an element of the given type code.
+inline size_t ElementSize(const boost::uint64_t elementType)
+{
+  return (size_t) (elementType & 0xff);
+}
+
+//! Return the size of the header of a file with the given header.
+inline size_t HeaderSize(const Header& header)
+{
+  return (header.version == 1) ? 32 : headerSize;
+}
+
+//! Return the size of the whole file with the given header.
+inline size_t FileSize(const Header& header)
+{
+  return HeaderSize(header) + header.rows * header.cols *
+      ElementSize(header.elementType) + header.labels * header.cols *
+      sizeof(boost::uint64_t);
+}
+
+//! Return whether or not the given bytes (of which there are at least 8) are
+//! the start of a matrix file.
+inline bool IsMatrixFile(const char* buffer)
+{
+  return (memcmp(buffer, magic, sizeof(magic)) == 0);
+}
+
+/**
+ * Read the header from the start of a matrix file.
+ *
+ * @param buffer The start of the file.
+ * @param size The number of bytes in the buffer (this needs to be at least
+ *     headerSize, unless the file is shorter).
+ * @param header Header to fill.
+ * @param error Set to the reason, if the header is invalid.
+ * @return false if the header is invalid.
+ */
+inline bool ReadHeader(const char* buffer,
+                       const size_t size,
+                       Header& header,
+                       std::string& error)
+{
+  if (size < 32 || !IsMatrixFile(buffer))
+  {
+    error = "not an mlpack matrix file";
+    return false;
+  }
+
+  boost::uint64_t fields[5];
+  memcpy(fields, buffer + sizeof(magic), 3 * sizeof(boost::uint64_t));
+  header.version = fields[0];
+  header.rows = fields[1];
+  header.cols = fields[2];
+
+  if (header.version == 1)
+  {
+    header.elementType = ElementType<double>();
+    header.labels = 0;
+    return true;
+  }
+  else if (header.version != version)
+  {
+    error = "unknown matrix file version";
+    return false;
+  }
+
+  if (size < headerSize)
+  {
+    error = "truncated matrix file header";
+    return false;
+  }
+
+  memcpy(fields, buffer + sizeof(magic), sizeof(fields));
+  header.elementType = fields[3];
+  header.labels = fields[4];
+
+  const size_t elementSize = ElementSize(header.elementType);
+  const boost::uint64_t kind = header.elementType >> 8;
+  if (kind < 1 || kind > 3 || (elementSize & (elementSize - 1)) != 0 ||
+      elementSize == 0 || elementSize > 8 || header.labels > 1)
+  {
+    error = "invalid matrix file header";
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Write the header of a matrix file (of the current version) into the given
+ * buffer, which must hold headerSize bytes.
+ */
+inline void WriteHeader(const Header& header, char* buffer)
+{
+  const boost::uint64_t fields[5] = { version, header.rows, header.cols,
+      header.elementType, header.labels };
+  memcpy(buffer, magic, sizeof(magic));
+  memcpy(buffer + sizeof(magic), fields, sizeof(fields));
+}
+
+//! Report an error, fatally or not.
+inline bool Failure(const std::string& message, const bool fatal)
+{
+  if (fatal)
+    Log::Fatal << message << std::endl;
+  else
+    Log::Warn << message << std::endl;
+
+  return false;
+}
+
+/**
+ * Read n elements of type FileT from the stream into the given memory,
+ * converting them to type eT, a block at a time so that memory use stays low.
+ */
+template<typename FileT, typename eT>
+bool ReadConverted(std::istream& stream, eT* memory, const size_t n)
+{
+  std::vector<FileT> buffer(std::min(n, (size_t) 65536));
+  for (size_t i = 0; i < n; i += buffer.size())
+  {
+    const size_t count = std::min(buffer.size(), n - i);
+    stream.read((char*) &buffer[0], count * sizeof(FileT));
+    if (!stream.good())
+      return false;
+
+    for (size_t j = 0; j < count; ++j)
+      memory[i + j] = (eT) buffer[j];
+  }
+
+  return true;
+}
+
+/**
+ * Read n elements with the given element type code from the stream into the
+ * given memory.  If the types are the same, the elements are read directly
+ * into the memory; otherwise, they are converted.
+ */
+template<typename eT>
+bool ReadElements(std::istream& stream,
+                  const boost::uint64_t elementType,
+                  eT* memory,
+                  const size_t n)
+{
+  if (elementType == ElementType<eT>())
+  {
+    stream.read((char*) memory, n * sizeof(eT));
+    return stream.good() || (n == 0);
+  }
+
+  switch (elementType)
+  {
+    case (1 << 8) | 4:
+      return ReadConverted<float>(stream, memory, n);
+    case (1 << 8) | 8:
+      return ReadConverted<double>(stream, memory, n);
+    case (2 << 8) | 1:
+      return ReadConverted<boost::int8_t>(stream, memory, n);
+    case (2 << 8) | 2:
+      return ReadConverted<boost::int16_t>(stream, memory, n);
+    case (2 << 8) | 4:
+      return ReadConverted<boost::int32_t>(stream, memory, n);
+    case (2 << 8) | 8:
+      return ReadConverted<boost::int64_t>(stream, memory, n);
+    case (3 << 8) | 1:
+      return ReadConverted<boost::uint8_t>(stream, memory, n);
+    case (3 << 8) | 2:
+      return ReadConverted<boost::uint16_t>(stream, memory, n);
+    case (3 << 8) | 4:
+      return ReadConverted<boost::uint32_t>(stream, memory, n);
+    case (3 << 8) | 8:
+      return ReadConverted<boost::uint64_t>(stream, memory, n);
+    default:
+      return false;
+  }
+}
+
+/**
+ * Load a matrix file.  The matrix is read with a single read (no parsing, and
+ * no transposing, since the file is already column-major), unless its element
+ * type differs from eT, in which case the elements are converted.  For a
+ * matrix that does not need to be in memory at all, use MappedMatrix instead.
+ *
+ * @param filename Name of the matrix file.
+ * @param matrix Matrix to load into.
+ * @param labels If not NULL, the labels are loaded into this (it is emptied if
+ *     the file has no labels).
+ * @param fatal If true, errors are fatal.
+ * @return false if the file could not be loaded.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          arma::Row<size_t>* labels,
+          const bool fatal)
+{
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    return Failure("Cannot open file '" + filename + "'; load failed.", fatal);
+
+  stream.seekg(0, std::ios::end);
+  const size_t fileSize = (size_t) stream.tellg();
+  stream.seekg(0, std::ios::beg);
+
+  char buffer[headerSize];
+  stream.read(buffer, std::min(fileSize, headerSize));
+  stream.clear();
+
+  Header header;
+  std::string error;
+  if (!ReadHeader(buffer, std::min(fileSize, headerSize), header, error))
+    return Failure("Cannot load '" + filename + "': " + error + ".", fatal);
+
+  if (fileSize != FileSize(header))
+    return Failure("Cannot load '" + filename + "': the file has the wrong "
+        "size for its header.", fatal);
+
+  Log::Info << "Loading '" << filename << "' as mlpack matrix file.  Size is "
+      << header.rows << " x " << header.cols << "." << std::endl;
+
+  stream.seekg(HeaderSize(header));
+  matrix.set_size((size_t) header.rows, (size_t) header.cols);
+  if (!ReadElements(stream, header.elementType, matrix.memptr(),
+      matrix.n_elem))
+    return Failure("Loading from '" + filename + "' failed.", fatal);
+
+  if (labels != NULL)
+  {
+    if (header.labels == 0)
+    {
+      labels->reset();
+    }
+    else
+    {
+      labels->set_size((size_t) header.cols);
+      if (!ReadElements(stream, ElementType<boost::uint64_t>(),
+          labels->memptr(), labels->n_elem))
+        return Failure("Loading labels from '" + filename + "' failed.",
+            fatal);
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Save a matrix (and optionally its labels) to a matrix file.
+ *
+ * @param filename Name of the matrix file.
+ * @param matrix Matrix to save.
+ * @param labels If not NULL, the labels to save (one for each column).
+ * @param fatal If true, errors are fatal.
+ * @return false if the file could not be saved.
+ */
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::Mat<eT>& matrix,
+          const arma::Row<size_t>* labels,
+          const bool fatal)
+{
+  if (labels != NULL && labels->n_elem != matrix.n_cols)
+    return Failure("Cannot save to '" + filename + "': the number of labels "
+        "is not the number of columns.", fatal);
+
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary |
+      std::ios::trunc);
+  if (!stream.is_open())
+    return Failure("Cannot open file '" + filename + "' for writing; save "
+        "failed.", fatal);
+
+  Log::Info << "Saving mlpack matrix file to '" << filename << "'."
+      << std::endl;
+
+  Header header;
+  header.rows = matrix.n_rows;
+  header.cols = matrix.n_cols;
+  header.elementType = ElementType<eT>();
+  header.labels = (labels == NULL) ? 0 : 1;
+
+  char buffer[headerSize];
+  WriteHeader(header, buffer);
+  stream.write(buffer, headerSize);
+  stream.write((const char*) matrix.memptr(), matrix.n_elem * sizeof(eT));
+
+  if (labels != NULL)
+  {
+    // The labels are always written as 64-bit integers.
+    const std::vector<boost::uint64_t> converted(labels->begin(),
+        labels->end());
+    if (!converted.empty())
+      stream.write((const char*) &converted[0], converted.size() *
+          sizeof(boost::uint64_t));
+  }
+
+  if (!stream.good())
+    return Failure("Save to '" + filename + "' failed.", fatal);
+
+  return true;
+}
+
+}; // namespace matrix_file
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -11,9 +11,30 @@
 // In case it hasn't been included yet.
 #include "normalize_labels.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace mlpack {
 namespace data {
 
+/**
+ * Orders the indices of labels by label, and indices of equal labels by index.
+ */
+template<typename eT>
+class LabelIndexLess
+{
+ public:
+  LabelIndexLess(const arma::Col<eT>& labels) : labels(labels) { }
+
+  bool operator()(const size_t a, const size_t b) const
+  {
+    return (labels[a] < labels[b]) || (labels[a] == labels[b] && a < b);
+  }
+
+ private:
+  const arma::Col<eT>& labels;
+};
+
 /**
  * Given a set of labels of a particular datatype, convert them to unsigned
  * labels in the range [0, n) where n is the number of different labels.  Also,
@@ -29,37 +50,47 @@ void NormalizeLabels(const arma::Col<eT>& labelsIn,
                      arma::Col<size_t>& labels,
                      arma::Col<eT>& mapping)
 {
-  // Loop over the input labels, and develop the mapping.  We'll first naively
-  // resize the mapping to the maximum possible size, and then when we fill it,
-  // we'll resize it back down to its actual size.
-  mapping.set_size(labelsIn.n_elem);
   labels.set_size(labelsIn.n_elem);
-  size_t curLabel = 0;
+
+  // Sort the indices of the labels, keeping equal labels in the order they
+  // appear, so that the first index of each run of equal labels is the first
+  // appearance of that label.  This is O(N log N), instead of checking each
+  // label against every label seen so far.
+  std::vector<size_t> order(labelsIn.n_elem);
   for (size_t i = 0; i < labelsIn.n_elem; ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), LabelIndexLess<eT>(labelsIn));
+
+  // Give each point the index of its run for now, and mark the first
+  // appearance of each label.
+  std::vector<bool> first(labelsIn.n_elem, false);
+  size_t runs = 0;
+  for (size_t i = 0; i < order.size(); ++i)
   {
-    bool found = false;
-    for (size_t j = 0; j < curLabel; ++j)
+    if (i == 0 || labelsIn[order[i]] != labelsIn[order[i - 1]])
     {
-      // Is the label already in the list of labels we have seen?
-      if (labelsIn[i] == mapping[j])
-      {
-        labels[i] = j;
-        found = true;
-        break;
-      }
+      first[order[i]] = true;
+      ++runs;
     }
+    labels[order[i]] = runs - 1;
+  }
 
-    // Do we need to add this new label?
-    if (!found)
+  // Number the labels in the order they first appear.  The first appearance of
+  // a label comes before its other appearances, so the number of each run is
+  // known by the time the other points of the run are reached.
+  arma::Col<size_t> runLabels(runs);
+  mapping.set_size(runs);
+  size_t curLabel = 0;
+  for (size_t i = 0; i < labelsIn.n_elem; ++i)
+  {
+    if (first[i])
     {
+      runLabels[labels[i]] = curLabel;
       mapping[curLabel] = labelsIn[i];
-      labels[i] = curLabel;
       ++curLabel;
     }
+    labels[i] = runLabels[labels[i]];
   }
-
-  // Resize mapping back down to necessary size.
-  mapping.resize(curLabel);
 }
 
 /**
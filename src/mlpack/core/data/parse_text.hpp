@@ -0,0 +1,76 @@
+/**
+ * @file parse_text.hpp
+ *
+ * A parallel parser for numeric CSV and whitespace-separated text files, which
+ * data::Load() uses in place of Armadillo's parser.
+ */
+#ifndef __MLPACK_CORE_DATA_PARSE_TEXT_HPP
+#define __MLPACK_CORE_DATA_PARSE_TEXT_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <string>
+
+#include "dataset_info.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Parse a text file with one point per line, whose values are separated by
+ * commas and/or whitespace (that is, CSV, TSV, or raw ASCII), into a matrix
+ * with one point per column, as data::Load() would give after transposing.
+ *
+ * The file is memory-mapped (where possible) and split into one byte range for
+ * each thread, on line boundaries.  Each thread counts the points in its range,
+ * the matrix is allocated once, and then each thread parses its points
+ * straight into their columns, so no transpose is needed.  Numbers are parsed
+ * with a fast exact path for decimals of up to 15 or so significant digits;
+ * anything else (long mantissas, large exponents, "nan", "inf") goes through
+ * strtod().  Blank lines are skipped.
+ *
+ * Nothing is reported if the file can't be parsed (for instance, if a line has
+ * a different number of values, a value is empty, or there is a header line),
+ * so that the caller can fall back to another parser.
+ *
+ * @param filename Name of file to parse.
+ * @param matrix Matrix to store the points in.
+ * @return false if the file could not be opened or parsed.
+ */
+template<typename eT>
+bool ParseText(const std::string& filename, arma::Mat<eT>& matrix);
+
+/**
+ * Parse a text file with one point per line, like the other overload, but allow
+ * dimensions whose values are strings.  If the first point has a comma, values
+ * are separated by commas (so strings may hold spaces); otherwise they are
+ * separated by whitespace.  Surrounding double quotes are removed.  A dimension
+ * with any value that is not a number is categorical: each of its values
+ * (numbers included) is stored as the index of its string, in the order the
+ * strings first appear in the file, and the mappings are stored in info.
+ *
+ * The work is split between threads as for the other overload.  Each thread
+ * maps the strings of its part of the file with its own hash maps, and the maps
+ * are merged at the end, so that the indices are the same as if the file were
+ * parsed by one thread.  There must be no header line (it would be taken as a
+ * point).
+ *
+ * @param filename Name of file to parse.
+ * @param matrix Matrix to store the points in.
+ * @param info Information to store the type of each dimension and the mappings
+ *     of the strings in.
+ * @return false if the file could not be opened, or if a line has a different
+ *     number of values.
+ */
+template<typename eT>
+bool ParseText(const std::string& filename,
+               arma::Mat<eT>& matrix,
+               DatasetInfo& info);
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "parse_text_impl.hpp"
+
+#endif
@@ -0,0 +1,655 @@
+/**
+ * @file parse_text_impl.hpp
+ *
+ * Implementation of the parallel text parser.
+ */
+#ifndef __MLPACK_CORE_DATA_PARSE_TEXT_IMPL_HPP
+#define __MLPACK_CORE_DATA_PARSE_TEXT_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "parse_text.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace data {
+namespace parse_text {
+
+/**
+ * The contents of a file: memory-mapped where possible, or read otherwise.
+ */
+class FileContents
+{
+ public:
+  //! Map or read the given file.
+  FileContents(const std::string& filename) :
+      data(NULL),
+      size(0),
+      mapped(false),
+      open(false)
+  {
+#ifndef _WIN32
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+      return;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0)
+    {
+      close(fd);
+      return;
+    }
+    size = (size_t) fileStat.st_size;
+
+    if (size > 0)
+    {
+      void* address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address == MAP_FAILED)
+      {
+        close(fd);
+        return;
+      }
+
+      data = (char*) address;
+      mapped = true;
+    }
+    close(fd);
+#else
+    std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+      return;
+
+    stream.seekg(0, std::ios::end);
+    size = (size_t) stream.tellg();
+    stream.seekg(0, std::ios::beg);
+
+    data = new char[size];
+    stream.read(data, size);
+    if (!stream.good() && size > 0)
+      return;
+#endif
+
+    open = true;
+  }
+
+  //! Unmap or free the contents.
+  ~FileContents()
+  {
+#ifndef _WIN32
+    if (mapped)
+      munmap(data, size);
+#else
+    delete[] data;
+#endif
+  }
+
+  //! Return whether or not the file could be mapped or read.
+  bool IsOpen() const { return open; }
+  //! Return the contents of the file.
+  const char* Data() const { return data; }
+  //! Return the size of the file.
+  size_t Size() const { return size; }
+
+ private:
+  //! The contents of the file.
+  char* data;
+  //! The size of the file.
+  size_t size;
+  //! Whether or not the contents are mapped.
+  bool mapped;
+  //! Whether or not the file could be mapped or read.
+  bool open;
+
+  //! Not copyable, because the contents can only be released once.
+  FileContents(const FileContents& other);
+  //! Not copyable, because the contents can only be released once.
+  FileContents& operator=(const FileContents& other);
+};
+
+//! Return whether or not the character is whitespace within a line.
+inline bool IsSpace(const char c)
+{
+  return (c == ' ' || c == '\t' || c == '\r');
+}
+
+//! Return whether or not the character ends a value.
+inline bool EndsValue(const char c)
+{
+  return (c == ',' || c == '\n' || IsSpace(c));
+}
+
+//! Return whether or not the range holds only whitespace.
+inline bool IsBlank(const char* p, const char* end)
+{
+  for (; p != end; ++p)
+    if (!IsSpace(*p))
+      return false;
+
+  return true;
+}
+
+/**
+ * Parse the number starting at p, moving p past it.  Decimals whose mantissa
+ * fits in 53 bits and whose exponent is at most 22 in magnitude are exactly
+ * representable after one multiplication or division (Clinger's fast path),
+ * so they are converted directly; anything else goes through strtod().
+ *
+ * @return false if there is no valid number at p.
+ */
+inline bool ParseValue(const char*& p, const char* end, double& value)
+{
+  static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+      1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+      1e20, 1e21, 1e22 };
+
+  const char* start = p;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+'))
+  {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  // Collect up to 19 significant digits; any more make the mantissa too large
+  // for the fast path anyway.
+  boost::uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool anyDigits = false;
+  for (; p != end && *p >= '0' && *p <= '9'; ++p)
+  {
+    anyDigits = true;
+    if (digits < 19)
+    {
+      mantissa = 10 * mantissa + (*p - '0');
+      if (mantissa != 0)
+        ++digits;
+    }
+  }
+
+  if (p != end && *p == '.')
+  {
+    for (++p; p != end && *p >= '0' && *p <= '9'; ++p)
+    {
+      anyDigits = true;
+      if (digits < 19)
+      {
+        mantissa = 10 * mantissa + (*p - '0');
+        if (mantissa != 0)
+          ++digits;
+        --exponent;
+      }
+    }
+  }
+
+  bool fast = anyDigits && (digits < 19);
+  if (fast && p != end && (*p == 'e' || *p == 'E'))
+  {
+    ++p;
+    bool negativeExponent = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+      negativeExponent = (*p == '-');
+      ++p;
+    }
+
+    int e = 0;
+    bool anyExponentDigits = false;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+    {
+      anyExponentDigits = true;
+      if (e < 10000)
+        e = 10 * e + (*p - '0');
+    }
+
+    fast = anyExponentDigits;
+    exponent += negativeExponent ? -e : e;
+  }
+
+  if (fast && (p == end || EndsValue(*p)) &&
+      mantissa <= (((boost::uint64_t) 1) << 53) &&
+      exponent >= -22 && exponent <= 22)
+  {
+    value = (double) mantissa;
+    if (exponent < 0)
+      value /= powers[-exponent];
+    else
+      value *= powers[exponent];
+    if (negative)
+      value = -value;
+
+    return true;
+  }
+
+  // The slow path: give the whole value to strtod().  The contents of the file
+  // aren't terminated, so copy the value first.
+  const char* valueEnd = start;
+  while (valueEnd != end && !EndsValue(*valueEnd))
+    ++valueEnd;
+
+  char buffer[64];
+  const size_t length = (size_t) (valueEnd - start);
+  if (length == 0 || length >= sizeof(buffer))
+    return false;
+
+  memcpy(buffer, start, length);
+  buffer[length] = '\0';
+
+  char* stop;
+  value = strtod(buffer, &stop);
+  if (stop != buffer + length)
+    return false;
+
+  p = valueEnd;
+  return true;
+}
+
+/**
+ * Parse the values on the line from p to lineEnd, which are separated by
+ * whitespace and/or single commas, into out.
+ *
+ * @param out Memory to store the values in.
+ * @param maxValues Room in out.
+ * @param count Set to the number of values on the line.
+ * @return false if the line can't be parsed or has more than maxValues values.
+ */
+template<typename eT>
+bool ParseLine(const char* p,
+               const char* lineEnd,
+               eT* out,
+               const size_t maxValues,
+               size_t& count)
+{
+  count = 0;
+  while (true)
+  {
+    while (p != lineEnd && IsSpace(*p))
+      ++p;
+    if (p == lineEnd)
+      return true;
+
+    if (count == maxValues)
+      return false;
+
+    double value;
+    if (!ParseValue(p, lineEnd, value))
+      return false;
+    out[count++] = (eT) value;
+
+    while (p != lineEnd && IsSpace(*p))
+      ++p;
+
+    // A comma must be followed by another value.
+    if (p != lineEnd && *p == ',')
+    {
+      ++p;
+      while (p != lineEnd && IsSpace(*p))
+        ++p;
+      if (p == lineEnd || *p == ',')
+        return false;
+    }
+  }
+}
+
+//! Return the end of the line starting at p (the newline, or end).
+inline const char* LineEnd(const char* p, const char* end)
+{
+  const char* newline = (const char*) memchr(p, '\n', end - p);
+  return (newline == NULL) ? end : newline;
+}
+
+/**
+ * Split the file into byte ranges that start on line boundaries, one for each
+ * thread (unless the file is small).  Range r is [starts[r], starts[r + 1]).
+ */
+inline void SplitRanges(const FileContents& file,
+                        std::vector<const char*>& starts)
+{
+  const char* data = file.Data();
+  const char* end = data + file.Size();
+
+  size_t numRanges = 1;
+#ifdef HAS_OPENMP
+  numRanges = (size_t) omp_get_max_threads();
+#endif
+  numRanges = std::max((size_t) 1, std::min(numRanges,
+      file.Size() / 65536));
+
+  starts.resize(numRanges + 1);
+  starts[0] = data;
+  starts[numRanges] = end;
+  for (size_t r = 1; r < numRanges; ++r)
+  {
+    const char* p = std::max(data + r * (file.Size() / numRanges),
+        starts[r - 1]);
+    const char* lineEnd = LineEnd(p, end);
+    starts[r] = (lineEnd == end) ? end : lineEnd + 1;
+  }
+}
+
+/**
+ * Find the next field of the line from p to lineEnd, moving p past it (and its
+ * separator).  If commas is true, fields are separated by commas, so they may
+ * hold spaces; otherwise they are separated by whitespace.  Surrounding
+ * whitespace and double quotes are not part of the field.
+ *
+ * @return false if there are no more fields on the line.
+ */
+inline bool NextField(const char*& p,
+                      const char* lineEnd,
+                      const bool commas,
+                      const char*& fieldBegin,
+                      const char*& fieldEnd)
+{
+  while (p != lineEnd && IsSpace(*p))
+    ++p;
+  if (p == lineEnd)
+    return false;
+
+  fieldBegin = p;
+  if (commas)
+  {
+    const char* comma = (const char*) memchr(p, ',', lineEnd - p);
+    fieldEnd = (comma == NULL) ? lineEnd : comma;
+    p = (comma == NULL) ? lineEnd : comma + 1;
+  }
+  else
+  {
+    while (p != lineEnd && !IsSpace(*p))
+      ++p;
+    fieldEnd = p;
+  }
+
+  while (fieldEnd != fieldBegin && IsSpace(*(fieldEnd - 1)))
+    --fieldEnd;
+  if (fieldEnd - fieldBegin >= 2 && *fieldBegin == '"' &&
+      *(fieldEnd - 1) == '"')
+  {
+    ++fieldBegin;
+    --fieldEnd;
+  }
+
+  return true;
+}
+
+//! Return whether or not the whole field is one number, which is stored in
+//! value.
+inline bool ParseField(const char* fieldBegin,
+                       const char* fieldEnd,
+                       double& value)
+{
+  const char* p = fieldBegin;
+  return (fieldBegin != fieldEnd) && ParseValue(p, fieldEnd, value) &&
+      (p == fieldEnd);
+}
+
+}; // namespace parse_text
+
+template<typename eT>
+bool ParseText(const std::string& filename, arma::Mat<eT>& matrix)
+{
+  using namespace parse_text;
+
+  FileContents file(filename);
+  if (!file.IsOpen() || file.Size() == 0)
+    return false;
+
+  const char* data = file.Data();
+  const char* end = data + file.Size();
+
+  // The first point gives the dimensionality.
+  size_t dimensionality = 0;
+  for (const char* p = data; p != end; )
+  {
+    const char* lineEnd = LineEnd(p, end);
+    if (!IsBlank(p, lineEnd))
+    {
+      std::vector<double> values((lineEnd - p) / 2 + 1);
+      if (!ParseLine(p, lineEnd, &values[0], values.size(), dimensionality))
+        return false;
+      break;
+    }
+
+    p = (lineEnd == end) ? end : lineEnd + 1;
+  }
+
+  if (dimensionality == 0)
+    return false;
+
+  std::vector<const char*> starts;
+  SplitRanges(file, starts);
+  const size_t numRanges = starts.size() - 1;
+
+  // Count the points in each range.
+  std::vector<size_t> counts(numRanges, 0);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t r = 0; r < numRanges; ++r)
+  {
+    for (const char* p = starts[r]; p != starts[r + 1]; )
+    {
+      const char* lineEnd = LineEnd(p, starts[r + 1]);
+      if (!IsBlank(p, lineEnd))
+        ++counts[r];
+      p = (lineEnd == starts[r + 1]) ? lineEnd : lineEnd + 1;
+    }
+  }
+
+  std::vector<size_t> firstColumns(numRanges + 1, 0);
+  for (size_t r = 0; r < numRanges; ++r)
+    firstColumns[r + 1] = firstColumns[r] + counts[r];
+
+  // Now parse each point straight into its column.
+  matrix.set_size(dimensionality, firstColumns[numRanges]);
+  size_t failures = 0;
+  #pragma omp parallel for schedule(dynamic, 1) reduction(+:failures)
+  for (size_t r = 0; r < numRanges; ++r)
+  {
+    size_t column = firstColumns[r];
+    for (const char* p = starts[r]; p != starts[r + 1] && failures == 0; )
+    {
+      const char* lineEnd = LineEnd(p, starts[r + 1]);
+      if (!IsBlank(p, lineEnd))
+      {
+        size_t count;
+        if (!ParseLine(p, lineEnd, matrix.colptr(column), dimensionality,
+            count) || count != dimensionality)
+          ++failures;
+        ++column;
+      }
+      p = (lineEnd == starts[r + 1]) ? lineEnd : lineEnd + 1;
+    }
+  }
+
+  if (failures > 0)
+  {
+    matrix.reset();
+    return false;
+  }
+
+  return true;
+}
+
+template<typename eT>
+bool ParseText(const std::string& filename,
+               arma::Mat<eT>& matrix,
+               DatasetInfo& info)
+{
+  using namespace parse_text;
+
+  FileContents file(filename);
+  if (!file.IsOpen() || file.Size() == 0)
+    return false;
+
+  const char* data = file.Data();
+  const char* end = data + file.Size();
+
+  // The first point gives the dimensionality, and whether the fields are
+  // separated by commas.
+  size_t dimensionality = 0;
+  bool commas = false;
+  for (const char* p = data; p != end; )
+  {
+    const char* lineEnd = LineEnd(p, end);
+    if (!IsBlank(p, lineEnd))
+    {
+      commas = (memchr(p, ',', lineEnd - p) != NULL);
+      const char* fieldBegin;
+      const char* fieldEnd;
+      while (NextField(p, lineEnd, commas, fieldBegin, fieldEnd))
+        ++dimensionality;
+      break;
+    }
+
+    p = (lineEnd == end) ? end : lineEnd + 1;
+  }
+
+  if (dimensionality == 0)
+    return false;
+
+  std::vector<const char*> starts;
+  SplitRanges(file, starts);
+  const size_t numRanges = starts.size() - 1;
+
+  // Count the points in each range, check their number of fields, and find
+  // the dimensions that have a value that is not a number; those dimensions
+  // are categorical.
+  std::vector<size_t> counts(numRanges, 0);
+  std::vector<std::vector<char> > rangeCategorical(numRanges,
+      std::vector<char>(dimensionality, 0));
+  size_t failures = 0;
+  #pragma omp parallel for schedule(dynamic, 1) reduction(+:failures)
+  for (size_t r = 0; r < numRanges; ++r)
+  {
+    for (const char* p = starts[r]; p != starts[r + 1] && failures == 0; )
+    {
+      const char* lineEnd = LineEnd(p, starts[r + 1]);
+      if (!IsBlank(p, lineEnd))
+      {
+        const char* q = p;
+        const char* fieldBegin;
+        const char* fieldEnd;
+        size_t d = 0;
+        while (NextField(q, lineEnd, commas, fieldBegin, fieldEnd))
+        {
+          double value;
+          if (d < dimensionality && !rangeCategorical[r][d] &&
+              !ParseField(fieldBegin, fieldEnd, value))
+            rangeCategorical[r][d] = 1;
+          ++d;
+        }
+
+        if (d != dimensionality)
+          ++failures;
+        ++counts[r];
+      }
+      p = (lineEnd == starts[r + 1]) ? lineEnd : lineEnd + 1;
+    }
+  }
+
+  if (failures > 0)
+    return false;
+
+  std::vector<bool> categorical(dimensionality, false);
+  for (size_t r = 0; r < numRanges; ++r)
+    for (size_t d = 0; d < dimensionality; ++d)
+      if (rangeCategorical[r][d])
+        categorical[d] = true;
+
+  std::vector<size_t> firstColumns(numRanges + 1, 0);
+  for (size_t r = 0; r < numRanges; ++r)
+    firstColumns[r + 1] = firstColumns[r] + counts[r];
+
+  // Now parse each point straight into its column.  Each thread gives the
+  // strings of its range their own indices (in the order they first appear in
+  // the range), with its own hash map for each categorical dimension.
+  typedef boost::unordered_map<std::string, size_t> StringMap;
+  std::vector<std::vector<std::vector<std::string> > > rangeStrings(numRanges,
+      std::vector<std::vector<std::string> >(dimensionality));
+  matrix.set_size(dimensionality, firstColumns[numRanges]);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t r = 0; r < numRanges; ++r)
+  {
+    std::vector<StringMap> maps(dimensionality);
+    size_t column = firstColumns[r];
+    for (const char* p = starts[r]; p != starts[r + 1]; )
+    {
+      const char* lineEnd = LineEnd(p, starts[r + 1]);
+      if (!IsBlank(p, lineEnd))
+      {
+        eT* point = matrix.colptr(column);
+        const char* q = p;
+        const char* fieldBegin;
+        const char* fieldEnd;
+        for (size_t d = 0; NextField(q, lineEnd, commas, fieldBegin, fieldEnd);
+            ++d)
+        {
+          if (categorical[d])
+          {
+            std::vector<std::string>& strings = rangeStrings[r][d];
+            const std::pair<StringMap::iterator, bool> result =
+                maps[d].insert(std::make_pair(std::string(fieldBegin,
+                fieldEnd), strings.size()));
+            if (result.second)
+              strings.push_back(result.first->first);
+            point[d] = (eT) result.first->second;
+          }
+          else
+          {
+            double value;
+            ParseField(fieldBegin, fieldEnd, value);
+            point[d] = (eT) value;
+          }
+        }
+        ++column;
+      }
+      p = (lineEnd == starts[r + 1]) ? lineEnd : lineEnd + 1;
+    }
+  }
+
+  // Merge the strings of the ranges in order, so that the indices are in the
+  // order the strings first appear in the file, and find the index of each
+  // string of each range.
+  info = DatasetInfo(dimensionality);
+  std::vector<std::vector<std::vector<size_t> > > indices(numRanges,
+      std::vector<std::vector<size_t> >(dimensionality));
+  for (size_t r = 0; r < numRanges; ++r)
+  {
+    for (size_t d = 0; d < dimensionality; ++d)
+    {
+      indices[r][d].resize(rangeStrings[r][d].size());
+      for (size_t i = 0; i < rangeStrings[r][d].size(); ++i)
+        indices[r][d][i] = info.MapString(rangeStrings[r][d][i], d);
+    }
+  }
+
+  // Replace the indices of each range with the merged indices.
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t r = 0; r < numRanges; ++r)
+    for (size_t i = firstColumns[r]; i < firstColumns[r + 1]; ++i)
+      for (size_t d = 0; d < dimensionality; ++d)
+        if (categorical[d])
+          matrix(d, i) = (eT) indices[r][d][(size_t) matrix(d, i)];
+
+  return true;
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file quantized_matrix.hpp
+ *
+ * A matrix whose elements are quantized to one byte each, with a scale and an
+ * offset for each dimension, and the distances from full-precision query
+ * points to its columns.
+ */
+#ifndef __MLPACK_CORE_DATA_QUANTIZED_MATRIX_HPP
+#define __MLPACK_CORE_DATA_QUANTIZED_MATRIX_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A matrix of points in which each element is stored as one byte: in each
+ * dimension, the range of the points is split into 255 equal steps, and each
+ * element is replaced by the number of the closest step.  Element (d, i) is
+ * then approximately
+ *
+ *   Offsets()[d] + Scales()[d] * Codes()(d, i),
+ *
+ * within half a step.  The matrix takes an eighth of the memory of an
+ * arma::mat (a quarter of an arma::fmat), which is usually accurate enough to
+ * find candidate neighbors, whose exact distances can then be computed from the
+ * full-precision points (see neighbor::QuantizedSearch).
+ *
+ * Distances from a full-precision query point to the columns are computed with
+ * a QuantizedDistance, without dequantizing the columns.
+ *
+ * @code
+ * extern arma::mat dataset;
+ * data::QuantizedMatrix quantized(dataset);
+ *
+ * data::QuantizedDistance distance(quantized, query);
+ * const double squared = distance.Evaluate(quantized.Column(10));
+ * @endcode
+ */
+class QuantizedMatrix
+{
+ public:
+  //! Create an empty matrix.
+  QuantizedMatrix() { }
+
+  /**
+   * Quantize the given points.
+   *
+   * @tparam MatType Type of the matrix of points (arma::mat or arma::fmat).
+   * @param points Points to quantize, one per column.
+   */
+  template<typename MatType>
+  QuantizedMatrix(const MatType& points) { Quantize(points); }
+
+  /**
+   * Quantize the given points, replacing the contents of the matrix.  The
+   * steps of each dimension are set from the smallest and largest element of
+   * that dimension; a dimension in which every point is the same has a scale
+   * of 0 (and codes of 0).
+   *
+   * @tparam MatType Type of the matrix of points (arma::mat or arma::fmat).
+   * @param points Points to quantize, one per column.
+   */
+  template<typename MatType>
+  void Quantize(const MatType& points);
+
+  /**
+   * Compute the approximate value of the given column.
+   *
+   * @param i Index of the column.
+   * @param point Vector to store the column in.
+   */
+  void Dequantize(const size_t i, arma::vec& point) const;
+
+  /**
+   * Compute the approximate values of every column.
+   *
+   * @param points Matrix to store the columns in.
+   */
+  void Dequantize(arma::mat& points) const;
+
+  //! Get the number of dimensions of the points.
+  size_t Dimensionality() const { return codes.n_rows; }
+  //! Get the number of points.
+  size_t NumPoints() const { return codes.n_cols; }
+
+  //! Get the codes of the given column (Dimensionality() bytes).
+  const unsigned char* Column(const size_t i) const
+  { return codes.colptr(i); }
+
+  //! Get the codes of the points, one column per point.
+  const arma::Mat<unsigned char>& Codes() const { return codes; }
+  //! Get the offset (smallest element) of each dimension.
+  const arma::vec& Offsets() const { return offsets; }
+  //! Get the size of one step of each dimension.
+  const arma::vec& Scales() const { return scales; }
+
+ private:
+  //! The codes of the points.
+  arma::Mat<unsigned char> codes;
+  //! The offset of each dimension.
+  arma::vec offsets;
+  //! The step size of each dimension.
+  arma::vec scales;
+};
+
+/**
+ * The squared Euclidean distances from one full-precision query point to the
+ * columns of a QuantizedMatrix (as if they were dequantized), and to boxes of
+ * codes.  The query is scaled into the steps of each dimension once, when the
+ * object is created, so that
+ *
+ *   ||q - x_i||^2 = sum_d Scales()[d]^2 (Codes()(d, i) - t_d)^2
+ *
+ * with t_d = (q_d - Offsets()[d]) / Scales()[d]; dimensions with a scale of 0
+ * add a constant.  Evaluate() is one multiply-add per dimension on
+ * single-precision values, with eight independent sums so that the compiler
+ * can vectorize the loop without reassociating it.
+ *
+ * MinDistance() is computed in the same way (with each code clamped to the
+ * box), so the distance of a box is never more than the distance of any code
+ * in it, even after rounding; a search that prunes boxes with it finds the
+ * same neighbors as a scan of every column.
+ */
+class QuantizedDistance
+{
+ public:
+  /**
+   * Prepare the distances from the given query point to the columns of the
+   * given matrix.
+   *
+   * @param matrix Quantized matrix.
+   * @param query Query point, with as many dimensions as the matrix.
+   */
+  template<typename VecType>
+  QuantizedDistance(const QuantizedMatrix& matrix, const VecType& query);
+
+  /**
+   * Return the approximate squared distance from the query point to the
+   * point with the given codes.
+   *
+   * @param code Codes of the point (see QuantizedMatrix::Column()).
+   */
+  float Evaluate(const unsigned char* code) const;
+
+  /**
+   * Return the smallest approximate squared distance from the query point to
+   * any point whose codes are between the given ones in each dimension.
+   *
+   * @param lo Smallest code of each dimension.
+   * @param hi Largest code of each dimension.
+   */
+  float MinDistance(const unsigned char* lo, const unsigned char* hi) const;
+
+ private:
+  //! The number of dimensions.
+  size_t dimensionality;
+  //! The query point, in steps from the offset of each dimension.
+  std::vector<float> targets;
+  //! The squared step size of each dimension.
+  std::vector<float> weights;
+  //! The distance contributed by dimensions with a step size of 0.
+  float constant;
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "quantized_matrix_impl.hpp"
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file quantized_matrix_impl.hpp
+ *
+ * Implementation of the QuantizedMatrix and QuantizedDistance classes.
+ */
+#ifndef __MLPACK_CORE_DATA_QUANTIZED_MATRIX_IMPL_HPP
+#define __MLPACK_CORE_DATA_QUANTIZED_MATRIX_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "quantized_matrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mlpack {
+namespace data {
+
+template<typename MatType>
+void QuantizedMatrix::Quantize(const MatType& points)
+{
+  codes.set_size(points.n_rows, points.n_cols);
+  offsets.zeros(points.n_rows);
+  scales.zeros(points.n_rows);
+  if (points.n_cols == 0)
+    return;
+
+  for (size_t d = 0; d < points.n_rows; ++d)
+  {
+    double lo = points(d, 0);
+    double hi = points(d, 0);
+    for (size_t i = 1; i < points.n_cols; ++i)
+    {
+      lo = std::min(lo, (double) points(d, i));
+      hi = std::max(hi, (double) points(d, i));
+    }
+
+    offsets[d] = lo;
+    scales[d] = (hi - lo) / 255.0;
+  }
+
+  // Each point is encoded independently.
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    unsigned char* code = codes.colptr(i);
+    for (size_t d = 0; d < points.n_rows; ++d)
+    {
+      if (scales[d] <= 0.0)
+      {
+        code[d] = 0;
+        continue;
+      }
+
+      const double step = ((double) points(d, i) - offsets[d]) / scales[d];
+      code[d] = (unsigned char) std::min(std::max(std::floor(step + 0.5), 0.0),
+          255.0);
+    }
+  }
+}
+
+inline void QuantizedMatrix::Dequantize(const size_t i, arma::vec& point) const
+{
+  point.set_size(codes.n_rows);
+  const unsigned char* code = codes.colptr(i);
+  for (size_t d = 0; d < codes.n_rows; ++d)
+    point[d] = offsets[d] + scales[d] * code[d];
+}
+
+inline void QuantizedMatrix::Dequantize(arma::mat& points) const
+{
+  points.set_size(codes.n_rows, codes.n_cols);
+  for (size_t i = 0; i < codes.n_cols; ++i)
+  {
+    const unsigned char* code = codes.colptr(i);
+    double* point = points.colptr(i);
+    for (size_t d = 0; d < codes.n_rows; ++d)
+      point[d] = offsets[d] + scales[d] * code[d];
+  }
+}
+
+template<typename VecType>
+QuantizedDistance::QuantizedDistance(const QuantizedMatrix& matrix,
+                                     const VecType& query) :
+    dimensionality(matrix.Dimensionality()),
+    targets(matrix.Dimensionality(), 0.0f),
+    weights(matrix.Dimensionality(), 0.0f),
+    constant(0.0f)
+{
+  if (query.n_elem != dimensionality)
+  {
+    Log::Fatal << "QuantizedDistance::QuantizedDistance(): the query has "
+        << query.n_elem << " dimensions, but the matrix has " << dimensionality
+        << "!" << std::endl;
+  }
+
+  for (size_t d = 0; d < dimensionality; ++d)
+  {
+    const double offset = matrix.Offsets()[d];
+    const double scale = matrix.Scales()[d];
+    if (scale > 0.0)
+    {
+      targets[d] = (float) ((query[d] - offset) / scale);
+      weights[d] = (float) (scale * scale);
+    }
+    else
+    {
+      constant += (float) ((query[d] - offset) * (query[d] - offset));
+    }
+  }
+}
+
+inline float QuantizedDistance::Evaluate(const unsigned char* code) const
+{
+  const float* t = dimensionality ? &targets[0] : NULL;
+  const float* w = dimensionality ? &weights[0] : NULL;
+
+  float sums[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+  size_t d = 0;
+  for (; d + 8 <= dimensionality; d += 8)
+  {
+    for (size_t j = 0; j < 8; ++j)
+    {
+      const float diff = (float) code[d + j] - t[d + j];
+      sums[j] += w[d + j] * diff * diff;
+    }
+  }
+
+  for (size_t j = 0; d < dimensionality; ++d, ++j)
+  {
+    const float diff = (float) code[d] - t[d];
+    sums[j] += w[d] * diff * diff;
+  }
+
+  return constant + (((sums[0] + sums[1]) + (sums[2] + sums[3])) +
+      ((sums[4] + sums[5]) + (sums[6] + sums[7])));
+}
+
+inline float QuantizedDistance::MinDistance(const unsigned char* lo,
+                                            const unsigned char* hi) const
+{
+  const float* t = dimensionality ? &targets[0] : NULL;
+  const float* w = dimensionality ? &weights[0] : NULL;
+
+  // The same sums as Evaluate(), with each code the closest one to the query
+  // in the box.
+  float sums[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+  size_t d = 0;
+  for (; d + 8 <= dimensionality; d += 8)
+  {
+    for (size_t j = 0; j < 8; ++j)
+    {
+      const float closest = std::min(std::max(t[d + j], (float) lo[d + j]),
+          (float) hi[d + j]);
+      const float diff = closest - t[d + j];
+      sums[j] += w[d + j] * diff * diff;
+    }
+  }
+
+  for (size_t j = 0; d < dimensionality; ++d, ++j)
+  {
+    const float closest = std::min(std::max(t[d], (float) lo[d]),
+        (float) hi[d]);
+    const float diff = closest - t[d];
+    sums[j] += w[d] * diff * diff;
+  }
+
+  return constant + (((sums[0] + sums[1]) + (sums[2] + sums[3])) +
+      ((sums[4] + sums[5]) + (sums[6] + sums[7])));
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -31,6 +31,18 @@ namespace data /** Functions to load and save matrices. */ {
  *  - Raw binary (raw_binary), denoted by .bin
  *  - Armadillo binary (arma_binary), denoted by .bin
  *  - HDF5 (hdf5_binary), denoted by .hdf5, .hdf, .h5, or .he5
+ *  - mlpack matrix files (see matrix_file.hpp), denoted by .mlb
+ *
+ * CSV and ASCII files are formatted in parallel by FormatText() rather than by
+ * Armadillo; values are written with as many digits as they need to be read
+ * back exactly.
+ *
+ * HDF5 files are saved as chunked datasets compressed with deflate (see
+ * hdf5_file.hpp), which Armadillo can still load, and whose points can be read
+ * a range at a time with data::Load() or ChunkReader.
+ *
+ * mlpack matrix files are column-major, so they are never transposed; they can
+ * be loaded without parsing, or memory-mapped with MappedMatrix.
  *
  * If the file extension is not one of those types, an error will be given.  If
  * the 'fatal' parameter is set to true, an error will cause the program to
@@ -51,6 +63,23 @@ bool Save(const std::string& filename,
           bool fatal = false,
           bool transpose = true);
 
+/**
+ * Saves a matrix and the labels of its columns to an mlpack matrix file (see
+ * matrix_file.hpp), whatever the extension of the filename.  The matrix is not
+ * transposed.
+ *
+ * @param filename Name of file to save to.
+ * @param matrix Matrix to save into file.
+ * @param labels Labels of the columns of the matrix.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of save.
+ */
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::Mat<eT>& matrix,
+          const arma::Row<size_t>& labels,
+          bool fatal = false);
+
 }; // namespace data
 }; // namespace mlpack
 
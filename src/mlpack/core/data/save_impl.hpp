@@ -9,6 +9,9 @@
 
 // In case it hasn't already been included.
 #include "save.hpp"
+#include "format_text.hpp"
+#include "hdf5_file.hpp"
+#include "matrix_file.hpp"
 
 namespace mlpack {
 namespace data {
@@ -39,6 +42,25 @@ bool Save(const std::string& filename,
   // Get the actual extension.
   std::string extension = filename.substr(ext + 1);
 
+  // mlpack matrix files are written directly, without Armadillo, and never
+  // transposed.
+  if (extension == "mlb")
+  {
+    const bool success = matrix_file::Save(filename, matrix, NULL, fatal);
+    Timer::Stop("saving_data");
+    return success;
+  }
+
+  // HDF5 files are written as chunked, compressed datasets, so that ranges of
+  // points can be read back without reading the whole file.
+  if (extension == "h5" || extension == "hdf5" || extension == "hdf" ||
+      extension == "he5")
+  {
+    const bool success = hdf5_file::Save(filename, matrix, transpose, fatal);
+    Timer::Stop("saving_data");
+    return success;
+  }
+
   // Catch errors opening the file.
   std::fstream stream;
   stream.open(filename.c_str(), std::fstream::out);
@@ -56,21 +78,33 @@ bool Save(const std::string& filename,
     return false;
   }
 
+  // Text is formatted in parallel by FormatText(), not by Armadillo.
+  if (extension == "csv" || extension == "txt")
+  {
+    Log::Info << "Saving " << ((extension == "csv") ? "CSV data" :
+        "raw ASCII formatted data") << " to '" << filename << "'." << std::endl;
+
+    if (!FormatText(stream, matrix, (extension == "csv") ? ',' : ' ',
+        transpose))
+    {
+      Timer::Stop("saving_data");
+      if (fatal)
+        Log::Fatal << "Save to '" << filename << "' failed." << std::endl;
+      else
+        Log::Warn << "Save to '" << filename << "' failed." << std::endl;
+
+      return false;
+    }
+
+    Timer::Stop("saving_data");
+    return true;
+  }
+
   bool unknownType = false;
   arma::file_type saveType;
   std::string stringType;
 
-  if (extension == "csv")
-  {
-    saveType = arma::csv_ascii;
-    stringType = "CSV data";
-  }
-  else if (extension == "txt")
-  {
-    saveType = arma::raw_ascii;
-    stringType = "raw ASCII formatted data";
-  }
-  else if (extension == "bin")
+  if (extension == "bin")
   {
     saveType = arma::arma_binary;
     stringType = "Armadillo binary formatted data";
@@ -80,26 +114,6 @@ bool Save(const std::string& filename,
     saveType = arma::pgm_binary;
     stringType = "PGM data";
   }
-  else if (extension == "h5" || extension == "hdf5" || extension == "hdf" ||
-           extension == "he5")
-  {
-#ifdef ARMA_USE_HDF5
-    saveType = arma::hdf5_binary;
-    stringType = "HDF5 data";
-#else
-    Timer::Stop("saving_data");
-    if (fatal)
-      Log::Fatal << "Attempted to save HDF5 data to '" << filename << "', but "
-          << "Armadillo was compiled without HDF5 support.  Save failed."
-          << std::endl;
-    else
-      Log::Warn << "Attempted to save HDF5 data to '" << filename << "', but "
-          << "Armadillo was compiled without HDF5 support.  Save failed."
-          << std::endl;
-
-    return false;
-#endif
-  }
   else
   {
     unknownType = true;
@@ -161,6 +175,19 @@ bool Save(const std::string& filename,
   return true;
 }
 
+template<typename eT>
+bool Save(const std::string& filename,
+          const arma::Mat<eT>& matrix,
+          const arma::Row<size_t>& labels,
+          bool fatal)
+{
+  Timer::Start("saving_data");
+  const bool success = matrix_file::Save(filename, matrix, &labels, fatal);
+  Timer::Stop("saving_data");
+
+  return success;
+}
+
 }; // namespace data
 }; // namespace mlpack
 
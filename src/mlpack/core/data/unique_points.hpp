@@ -0,0 +1,148 @@
+/**
+ * @file unique_points.hpp
+ *
+ * Collapse the duplicate points of a dataset into unique points, each weighted
+ * by the number of its copies, so that trees and clustering can be run on the
+ * unique points and their results expanded back to the original points.
+ */
+#ifndef __MLPACK_CORE_DATA_UNIQUE_POINTS_HPP
+#define __MLPACK_CORE_DATA_UNIQUE_POINTS_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * The UniquePoints class finds the duplicate points (columns) of a dataset.
+ * The points are hashed, so that only points with the same hash have to be
+ * compared, and the points that are exactly equal (with 0 and -0 taken as
+ * equal) are collapsed into one unique point.  The unique points are numbered
+ * in the order of their first copies in the dataset, and each keeps the
+ * original indices of all its copies, in increasing order, and its count (its
+ * multiplicity), which can be used as its weight.
+ *
+ * Datasets with many duplicates build deep and degenerate trees, since the
+ * copies of a point cannot be split apart, and every copy is visited by every
+ * search.  Searching the unique points instead, and expanding the results
+ * back, does the same work once per unique point.  See
+ * neighbor::ExpandNeighbors(), range::ExpandRanges(), the weighted
+ * KMeans::Cluster(), and EMFit::Estimate() (with the weights as the
+ * probabilities of the points).
+ *
+ * @code
+ * extern arma::mat dataset;
+ *
+ * data::UniquePoints unique(dataset);
+ * arma::mat uniqueDataset;
+ * unique.Extract(dataset, uniqueDataset);
+ *
+ * // Cluster the unique points, each weighted by its count.
+ * arma::Col<size_t> uniqueAssignments, assignments;
+ * arma::mat centroids;
+ * KMeans<> k;
+ * k.Cluster(uniqueDataset, unique.Weights(), 5, uniqueAssignments,
+ *     centroids);
+ *
+ * // The cluster of every original point.
+ * unique.Expand(uniqueAssignments, assignments);
+ * @endcode
+ */
+class UniquePoints
+{
+ public:
+  //! Create an empty object, with no points.
+  UniquePoints() { }
+
+  /**
+   * Find the unique points of the given dataset.
+   *
+   * @param points Dataset to find the duplicates of.
+   */
+  template<typename eT>
+  UniquePoints(const arma::Mat<eT>& points) { Find(points); }
+
+  /**
+   * Find the unique points of the given dataset, replacing any previous
+   * results.
+   *
+   * @param points Dataset to find the duplicates of.
+   */
+  template<typename eT>
+  void Find(const arma::Mat<eT>& points);
+
+  /**
+   * Copy the unique points of the given dataset, which must be the dataset
+   * that the duplicates were found in, into a new matrix: column u is the
+   * first copy of unique point u.
+   *
+   * @param points Dataset the duplicates were found in.
+   * @param uniquePoints Matrix to store the unique points in.
+   */
+  template<typename eT>
+  void Extract(const arma::Mat<eT>& points, arma::Mat<eT>& uniquePoints) const;
+
+  /**
+   * Expand a value for each unique point (such as its cluster) into a value
+   * for each original point.
+   *
+   * @param uniqueValues Value of each unique point.
+   * @param values Vector to store the value of each original point in.
+   */
+  template<typename eT>
+  void Expand(const arma::Col<eT>& uniqueValues, arma::Col<eT>& values) const;
+
+  /**
+   * Expand a column for each unique point (such as its neighbors, if every
+   * copy is to have the same ones) into a column for each original point.
+   *
+   * @param uniqueColumns Column of each unique point.
+   * @param columns Matrix to store the column of each original point in.
+   */
+  template<typename eT>
+  void ExpandColumns(const arma::Mat<eT>& uniqueColumns,
+                     arma::Mat<eT>& columns) const;
+
+  //! Get the number of original points.
+  size_t NumPoints() const { return uniqueIndices.n_elem; }
+  //! Get the number of unique points.
+  size_t NumUnique() const { return counts.n_elem; }
+
+  //! Get the unique point of each original point.
+  const arma::Col<size_t>& UniqueIndices() const { return uniqueIndices; }
+  //! Get the number of copies of each unique point.
+  const arma::Col<size_t>& Counts() const { return counts; }
+  //! Get the number of copies of each unique point, as weights.
+  arma::vec Weights() const { return arma::conv_to<arma::vec>::from(counts); }
+
+  //! Get the number of copies of the given unique point.
+  size_t Count(const size_t unique) const { return counts[unique]; }
+  //! Get the original index of the given copy of the given unique point (copy
+  //! 0 is the first copy).
+  size_t Copy(const size_t unique, const size_t copy) const
+  { return copies[offsets[unique] + copy]; }
+
+  //! Get the offset in Copies() of the copies of each unique point (with one
+  //! more element at the end, the number of points).
+  const arma::Col<size_t>& Offsets() const { return offsets; }
+  //! Get the original indices of the copies of all the unique points, in order.
+  const arma::Col<size_t>& Copies() const { return copies; }
+
+ private:
+  //! The unique point of each original point.
+  arma::Col<size_t> uniqueIndices;
+  //! The number of copies of each unique point.
+  arma::Col<size_t> counts;
+  //! The offset in copies of the copies of each unique point.
+  arma::Col<size_t> offsets;
+  //! The original indices of the copies of each unique point.
+  arma::Col<size_t> copies;
+};
+
+}; // namespace data
+}; // namespace mlpack
+
+// Include implementation.
+#include "unique_points_impl.hpp"
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file unique_points_impl.hpp
+ *
+ * Implementation of the UniquePoints class.
+ */
+#ifndef __MLPACK_CORE_DATA_UNIQUE_POINTS_IMPL_HPP
+#define __MLPACK_CORE_DATA_UNIQUE_POINTS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "unique_points.hpp"
+
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+
+namespace mlpack {
+namespace data {
+
+template<typename eT>
+void UniquePoints::Find(const arma::Mat<eT>& points)
+{
+  const size_t n = points.n_cols;
+
+  // Hash every point; 0 and -0 are equal, so they must hash the same.
+  std::vector<std::pair<size_t, size_t> > hashes(n);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t hash = 0;
+    const eT* point = points.colptr(i);
+    for (size_t d = 0; d < points.n_rows; ++d)
+      boost::hash_combine(hash, (point[d] == eT(0)) ? eT(0) : point[d]);
+
+    hashes[i] = std::make_pair(hash, i);
+  }
+
+  // Within each run of points with the same hash (in increasing order of
+  // index), compare the points to find the groups of copies; nearly all runs
+  // hold a single group, unless the hashes collide.
+  std::sort(hashes.begin(), hashes.end());
+
+  const size_t unassigned = n;
+  arma::Col<size_t> groups(n);
+  groups.fill(unassigned);
+  size_t numGroups = 0;
+  for (size_t begin = 0; begin < n; )
+  {
+    size_t end = begin + 1;
+    while (end < n && hashes[end].first == hashes[begin].first)
+      ++end;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+      const size_t first = hashes[i].second;
+      if (groups[first] != unassigned)
+        continue;
+
+      groups[first] = numGroups;
+      for (size_t j = i + 1; j < end; ++j)
+      {
+        const size_t other = hashes[j].second;
+        if (groups[other] != unassigned)
+          continue;
+
+        bool equal = true;
+        for (size_t d = 0; d < points.n_rows && equal; ++d)
+          equal = (points(d, first) == points(d, other));
+
+        if (equal)
+          groups[other] = numGroups;
+      }
+
+      ++numGroups;
+    }
+
+    begin = end;
+  }
+
+  // Number the unique points in the order of their first copies, and count
+  // them.
+  arma::Col<size_t> uniqueOfGroup(numGroups);
+  uniqueOfGroup.fill(unassigned);
+  uniqueIndices.set_size(n);
+  counts.zeros(numGroups);
+  size_t numUnique = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t& unique = uniqueOfGroup[groups[i]];
+    if (unique == unassigned)
+      unique = numUnique++;
+
+    uniqueIndices[i] = unique;
+    ++counts[unique];
+  }
+
+  // Now list the copies of each unique point.
+  offsets.set_size(numUnique + 1);
+  offsets[0] = 0;
+  for (size_t u = 0; u < numUnique; ++u)
+    offsets[u + 1] = offsets[u] + counts[u];
+
+  arma::Col<size_t> next(offsets.memptr(), numUnique);
+  copies.set_size(n);
+  for (size_t i = 0; i < n; ++i)
+    copies[next[uniqueIndices[i]]++] = i;
+}
+
+template<typename eT>
+void UniquePoints::Extract(const arma::Mat<eT>& points,
+                           arma::Mat<eT>& uniquePoints) const
+{
+  if (points.n_cols != NumPoints())
+  {
+    Log::Fatal << "UniquePoints::Extract(): the dataset has " << points.n_cols
+        << " points, but the duplicates were found in " << NumPoints()
+        << " points!" << std::endl;
+  }
+
+  uniquePoints.set_size(points.n_rows, NumUnique());
+  for (size_t u = 0; u < NumUnique(); ++u)
+    uniquePoints.col(u) = points.col(copies[offsets[u]]);
+}
+
+template<typename eT>
+void UniquePoints::Expand(const arma::Col<eT>& uniqueValues,
+                          arma::Col<eT>& values) const
+{
+  if (uniqueValues.n_elem != NumUnique())
+  {
+    Log::Fatal << "UniquePoints::Expand(): " << uniqueValues.n_elem
+        << " values given for " << NumUnique() << " unique points!"
+        << std::endl;
+  }
+
+  values.set_size(NumPoints());
+  for (size_t i = 0; i < NumPoints(); ++i)
+    values[i] = uniqueValues[uniqueIndices[i]];
+}
+
+template<typename eT>
+void UniquePoints::ExpandColumns(const arma::Mat<eT>& uniqueColumns,
+                                 arma::Mat<eT>& columns) const
+{
+  if (uniqueColumns.n_cols != NumUnique())
+  {
+    Log::Fatal << "UniquePoints::ExpandColumns(): " << uniqueColumns.n_cols
+        << " columns given for " << NumUnique() << " unique points!"
+        << std::endl;
+  }
+
+  columns.set_size(uniqueColumns.n_rows, NumPoints());
+  for (size_t i = 0; i < NumPoints(); ++i)
+    columns.col(i) = uniqueColumns.col(uniqueIndices[i]);
+}
+
+}; // namespace data
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,167 @@
+/**
+ * @file diagonal_gaussian_distribution.cpp
+ *
+ * Implementation of the Gaussian distribution with diagonal covariance.
+ */
+#include "diagonal_gaussian_distribution.hpp"
+
+using namespace mlpack;
+using namespace mlpack::distribution;
+
+void DiagonalGaussianDistribution::Covariance(const arma::vec& covariance)
+{
+  this->covariance = covariance;
+  FactorCovariance();
+}
+
+void DiagonalGaussianDistribution::FactorCovariance()
+{
+  // The covariance is positive definite when every variance is positive.
+  for (size_t i = 0; i < covariance.n_elem; ++i)
+  {
+    if (covariance[i] > 1e-50)
+      continue;
+
+    Log::Debug << "DiagonalGaussianDistribution::Covariance(): variance " << i
+        << " is not positive. Adding perturbation." << std::endl;
+
+    double perturbation = 1e-30;
+    while (covariance[i] <= 1e-50)
+    {
+      covariance[i] += perturbation;
+      perturbation *= 10; // Slow, but we don't want to add too much.
+    }
+  }
+
+  invCov = 1.0 / covariance;
+  logDetCov = accu(log(covariance));
+}
+
+double DiagonalGaussianDistribution::LogProbability(
+    const arma::vec& observation) const
+{
+  const arma::vec diff = observation - mean;
+
+  return -0.5 * (observation.n_elem * log(2 * M_PI) + logDetCov) -
+      0.5 * accu(diff % diff % invCov);
+}
+
+void DiagonalGaussianDistribution::LogProbability(
+    const arma::mat& x,
+    arma::vec& logProbabilities) const
+{
+  // Column i of 'diffs' is the difference between x.col(i) and the mean.
+  const arma::mat diffs = x - (mean * arma::ones<arma::rowvec>(x.n_cols));
+
+  // The Mahalanobis distance of each observation is the sum of its squared
+  // differences, each weighted by the inverse variance of its dimension.
+  logProbabilities = -0.5 * (x.n_rows * log(2 * M_PI) + logDetCov) -
+      0.5 * trans(trans(invCov) * arma::square(diffs));
+}
+
+arma::vec DiagonalGaussianDistribution::Random() const
+{
+  return sqrt(covariance) % arma::randn<arma::vec>(mean.n_elem) + mean;
+}
+
+/**
+ * Estimate the Gaussian distribution directly from the given observations.
+ *
+ * @param observations List of observations.
+ */
+void DiagonalGaussianDistribution::Estimate(const arma::mat& observations)
+{
+  if (observations.n_cols == 0)
+  {
+    // This will end up just being empty.
+    mean.zeros(0);
+    covariance.zeros(0);
+    FactorCovariance();
+    return;
+  }
+
+  mean = arma::mean(observations, 1);
+
+  // Finish estimating the variances by normalizing, with the (1 / (n - 1)) so
+  // that they are unbiased estimators.
+  const arma::mat diffs = observations - (mean *
+      arma::ones<arma::rowvec>(observations.n_cols));
+  covariance = arma::sum(arma::square(diffs), 1) / (observations.n_cols - 1);
+
+  FactorCovariance();
+}
+
+/**
+ * Estimate the Gaussian distribution from the given observations, taking into
+ * account the probability of each observation actually being from this
+ * distribution.
+ */
+void DiagonalGaussianDistribution::Estimate(const arma::mat& observations,
+                                            const arma::vec& probabilities)
+{
+  if (observations.n_cols == 0)
+  {
+    // This will end up just being empty.
+    mean.zeros(0);
+    covariance.zeros(0);
+    FactorCovariance();
+    return;
+  }
+
+  const double sumProb = accu(probabilities);
+  if (sumProb == 0)
+  {
+    // Nothing in this Gaussian!  At least set the variances so that they're
+    // invertible.
+    mean.zeros(observations.n_rows);
+    covariance.zeros(observations.n_rows);
+    FactorCovariance();
+    return;
+  }
+
+  mean = (observations * probabilities) / sumProb;
+
+  // This is probably biased, but I don't know how to unbias it.
+  const arma::mat diffs = observations - (mean *
+      arma::ones<arma::rowvec>(observations.n_cols));
+  covariance = (arma::square(diffs) * probabilities) / sumProb;
+
+  FactorCovariance();
+}
+
+/**
+ * Returns a string representation of this object.
+ */
+std::string DiagonalGaussianDistribution::ToString() const
+{
+  std::ostringstream convert;
+  convert << "DiagonalGaussianDistribution [" << this << "]" << std::endl;
+
+  // Secondary ostringstream so things can be indented right.
+  std::ostringstream data;
+  data << "Mean: " << std::endl << mean;
+  data << "Covariance (diagonal): " << std::endl << covariance;
+
+  convert << util::Indent(data.str());
+  return convert.str();
+}
+
+/**
+ * Save to SaveRestoreUtility.
+ */
+void DiagonalGaussianDistribution::Save(util::SaveRestoreUtility& sr) const
+{
+  sr.SaveParameter(Type(), "type");
+  sr.SaveParameter(mean, "mean");
+  sr.SaveParameter(covariance, "covariance");
+}
+
+/**
+ * Load from SaveRestoreUtility.
+ */
+void DiagonalGaussianDistribution::Load(const util::SaveRestoreUtility& sr)
+{
+  sr.LoadParameter(mean, "mean");
+  sr.LoadParameter(covariance, "covariance");
+  FactorCovariance();
+}
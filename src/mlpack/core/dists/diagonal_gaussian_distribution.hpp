@@ -0,0 +1,173 @@
+/**
+ * @file diagonal_gaussian_distribution.hpp
+ *
+ * Implementation of the Gaussian distribution with diagonal covariance.
+ */
+#ifndef __MLPACK_CORE_DISTS_DIAGONAL_GAUSSIAN_DISTRIBUTION_HPP
+#define __MLPACK_CORE_DISTS_DIAGONAL_GAUSSIAN_DISTRIBUTION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace distribution {
+
+/**
+ * A multivariate Gaussian distribution with diagonal covariance.  Only the
+ * variance of each dimension is stored, so storage and the evaluation of the
+ * density take O(d) time instead of the O(d^2) (and O(d^3) to factor the
+ * covariance) of GaussianDistribution.  It provides the same interface as
+ * GaussianDistribution, except that the covariance is a vector of variances,
+ * so it can be used as the emission distribution of an HMM, or as the component
+ * of a GMM (see gmm::DiagonalGMM).
+ */
+class DiagonalGaussianDistribution
+{
+ private:
+  //! Mean of the distribution.
+  arma::vec mean;
+  //! Variance of each dimension (the diagonal of the covariance).
+  arma::vec covariance;
+  //! Inverse of each variance.
+  arma::vec invCov;
+  //! Log-determinant of the covariance.
+  double logDetCov;
+
+ public:
+  /**
+   * Default constructor, which creates a Gaussian with zero dimension.
+   */
+  DiagonalGaussianDistribution() : logDetCov(0.0) { /* Nothing to do. */ }
+
+  /**
+   * Create a Gaussian distribution with zero mean and identity covariance with
+   * the given dimensionality.
+   */
+  DiagonalGaussianDistribution(const size_t dimension) :
+      mean(arma::zeros<arma::vec>(dimension)),
+      covariance(arma::ones<arma::vec>(dimension)),
+      invCov(arma::ones<arma::vec>(dimension)),
+      logDetCov(0.0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Create a Gaussian distribution with the given mean and variances.
+   */
+  DiagonalGaussianDistribution(const arma::vec& mean,
+                               const arma::vec& covariance) :
+      mean(mean)
+  {
+    Covariance(covariance);
+  }
+
+  //! Return the dimensionality of this distribution.
+  size_t Dimensionality() const { return mean.n_elem; }
+
+  /**
+   * Return the probability of the given observation.
+   */
+  double Probability(const arma::vec& observation) const
+  {
+    return exp(LogProbability(observation));
+  }
+
+  /**
+   * Return the log probability of the given observation.
+   */
+  double LogProbability(const arma::vec& observation) const;
+
+  /**
+   * Calculates the Gaussian probability density function for each data point
+   * (column) in the given matrix.
+   *
+   * @param x List of observations.
+   * @param probabilities Output probabilities for each input observation.
+   */
+  void Probability(const arma::mat& x, arma::vec& probabilities) const
+  {
+    LogProbability(x, probabilities);
+    probabilities = exp(probabilities);
+  }
+
+  /**
+   * Calculates the log of the Gaussian probability density function for each
+   * data point (column) in the given matrix.
+   *
+   * @param x List of observations.
+   * @param logProbabilities Output log probabilities for each input
+   *     observation.
+   */
+  void LogProbability(const arma::mat& x, arma::vec& logProbabilities) const;
+
+  /**
+   * Return a randomly generated observation according to the probability
+   * distribution defined by this object.
+   *
+   * @return Random observation from this Gaussian distribution.
+   */
+  arma::vec Random() const;
+
+  /**
+   * Estimate the Gaussian distribution directly from the given observations.
+   *
+   * @param observations List of observations.
+   */
+  void Estimate(const arma::mat& observations);
+
+  /**
+   * Estimate the Gaussian distribution from the given observations, taking into
+   * account the probability of each observation actually being from this
+   * distribution.
+   */
+  void Estimate(const arma::mat& observations,
+                const arma::vec& probabilities);
+
+  /**
+   * Return the mean.
+   */
+  const arma::vec& Mean() const { return mean; }
+
+  /**
+   * Return a modifiable copy of the mean.
+   */
+  arma::vec& Mean() { return mean; }
+
+  /**
+   * Return the variance of each dimension (the diagonal of the covariance).
+   */
+  const arma::vec& Covariance() const { return covariance; }
+
+  /**
+   * Set the variance of each dimension, and compute their inverses and the
+   * log-determinant of the covariance.
+   */
+  void Covariance(const arma::vec& covariance);
+
+  /**
+   * Return the log-determinant of the covariance.
+   */
+  double LogDetCovariance() const { return logDetCov; }
+
+  /**
+   * Returns a string representation of this object.
+   */
+  std::string ToString() const;
+
+  /*
+   * Save to or Load from SaveRestoreUtility
+   */
+  void Save(util::SaveRestoreUtility& n) const;
+  void Load(const util::SaveRestoreUtility& n);
+  static std::string const Type() { return "DiagonalGaussianDistribution"; }
+
+ private:
+  /**
+   * Compute the inverse variances and the log-determinant of the covariance.
+   * Any variance that is not positive is perturbed until it is.
+   */
+  void FactorCovariance();
+};
+
+}; // namespace distribution
+}; // namespace mlpack
+
+#endif
@@ -10,34 +10,71 @@
 using namespace mlpack;
 using namespace mlpack::distribution;
 
-/**
- * Calculates the multivariate Gaussian probability density function for each
- * data point (column) in the given matrix, with respect to the given mean and
- * variance.
- *
- * @param x List of observations.
- * @param mean Mean of multivariate Gaussian.
- * @param cov Covariance of multivariate Gaussian.
- * @param probabilities Output probabilities for each input observation.
- */
+void GaussianDistribution::Covariance(const arma::mat& covariance)
+{
+  this->covariance = covariance;
+  FactorCovariance();
+}
 
-double GaussianDistribution::Probability(const arma::vec& observation) const
+void GaussianDistribution::FactorCovariance()
 {
-  arma::vec diff = mean - observation;
+  if (covariance.n_elem == 0)
+  {
+    covLower.reset();
+    logDetCov = 0.0;
+    return;
+  }
+
+  // Armadillo gives the upper triangular factor.
+  arma::mat covUpper;
+  if (!arma::chol(covUpper, covariance))
+  {
+    Log::Debug << "GaussianDistribution::Covariance(): Covariance matrix is "
+        << "not positive definite. Adding perturbation." << std::endl;
 
-  arma::vec exponent = -0.5 * (trans(diff) * inv(covariance) * diff);
+    double perturbation = 1e-30;
+    do
+    {
+      if (perturbation > 1e300)
+        Log::Fatal << "GaussianDistribution::Covariance(): covariance matrix "
+            << "cannot be made positive definite!" << std::endl;
 
-  // TODO: What if det(cov) < 0?
-  return pow(2 * M_PI, (double) observation.n_elem / -2.0) *
-      pow(det(covariance), -0.5) * exp(exponent[0]);
+      covariance.diag() += perturbation;
+      perturbation *= 10; // Slow, but we don't want to add too much.
+    } while (!arma::chol(covUpper, covariance));
+  }
+
+  covLower = trans(covUpper);
+  logDetCov = 2.0 * accu(log(covLower.diag()));
+}
+
+double GaussianDistribution::LogProbability(const arma::vec& observation) const
+{
+  // The Mahalanobis distance of the observation is the squared norm of the
+  // solution of (covLower * z = observation - mean).
+  const arma::vec z = arma::solve(arma::trimatl(covLower), observation - mean);
+
+  return -0.5 * (observation.n_elem * log(2 * M_PI) + logDetCov) -
+      0.5 * arma::dot(z, z);
 }
 
+void GaussianDistribution::LogProbability(const arma::mat& x,
+                                          arma::vec& logProbabilities) const
+{
+  // Column i of 'diffs' is the difference between x.col(i) and the mean.
+  const arma::mat diffs = x - (mean * arma::ones<arma::rowvec>(x.n_cols));
+
+  // One triangular solve gives the Mahalanobis distance of every observation:
+  // it is the squared norm of the observation's column of z.
+  const arma::mat z = arma::solve(arma::trimatl(covLower), diffs);
 
+  logProbabilities = -0.5 * (x.n_rows * log(2 * M_PI) + logDetCov) -
+      0.5 * trans(arma::sum(arma::square(z), 0));
+}
 
 arma::vec GaussianDistribution::Random() const
 {
-  // Should we store chol(covariance) for easier calculation later?
-  return trans(chol(covariance)) * arma::randn<arma::vec>(mean.n_elem) + mean;
+  return covLower * arma::randn<arma::vec>(mean.n_elem) + mean;
 }
 
 /**
@@ -56,6 +93,7 @@ void GaussianDistribution::Estimate(const arma::mat& observations)
   {
     mean.zeros(0);
     covariance.zeros(0);
+    FactorCovariance();
     return;
   }
 
@@ -90,6 +128,8 @@ void GaussianDistribution::Estimate(const arma::mat& observations)
       perturbation *= 10; // Slow, but we don't want to add too much.
     }
   }
+
+  FactorCovariance();
 }
 
 /**
@@ -109,6 +149,7 @@ void GaussianDistribution::Estimate(const arma::mat& observations,
   {
     mean.zeros(0);
     covariance.zeros(0);
+    FactorCovariance();
     return;
   }
 
@@ -127,6 +168,7 @@ void GaussianDistribution::Estimate(const arma::mat& observations,
     // Nothing in this Gaussian!  At least set the covariance so that it's
     // invertible.
     covariance.diag() += 1e-50;
+    FactorCovariance();
     return;
   }
 
@@ -156,6 +198,8 @@ void GaussianDistribution::Estimate(const arma::mat& observations,
       perturbation *= 10; // Slow, but we don't want to add too much.
     }
   }
+
+  FactorCovariance();
 }
 
 /**
@@ -193,4 +237,5 @@ void GaussianDistribution::Load(const util::SaveRestoreUtility& sr)
 {
   sr.LoadParameter(mean, "mean");
   sr.LoadParameter(covariance, "covariance");
+  FactorCovariance();
 }
@@ -15,6 +15,13 @@ namespace distribution {
 
 /**
  * A single multivariate Gaussian distribution.
+ *
+ * The Cholesky factor and the log-determinant of the covariance are computed
+ * whenever the covariance is set, so evaluating the density never inverts the
+ * covariance.  For that reason the covariance can only be changed with
+ * Covariance(const arma::mat&), not through a reference.  The densities are
+ * computed in the log domain (see LogProbability()), so they don't underflow
+ * for points far from the mean when only the log-density is needed.
  */
 class GaussianDistribution
 {
@@ -23,12 +30,16 @@ class GaussianDistribution
   arma::vec mean;
   //! Covariance of the distribution.
   arma::mat covariance;
+  //! Lower triangular Cholesky factor of the covariance.
+  arma::mat covLower;
+  //! Log-determinant of the covariance.
+  double logDetCov;
 
  public:
   /**
    * Default constructor, which creates a Gaussian with zero dimension.
    */
-  GaussianDistribution() { /* nothing to do */ }
+  GaussianDistribution() : logDetCov(0.0) { /* nothing to do */ }
 
   /**
    * Create a Gaussian distribution with zero mean and identity covariance with
@@ -36,14 +47,19 @@ class GaussianDistribution
    */
   GaussianDistribution(const size_t dimension) :
       mean(arma::zeros<arma::vec>(dimension)),
-      covariance(arma::eye<arma::mat>(dimension, dimension))
+      covariance(arma::eye<arma::mat>(dimension, dimension)),
+      covLower(arma::eye<arma::mat>(dimension, dimension)),
+      logDetCov(0.0)
   { /* Nothing to do. */ }
 
   /**
    * Create a Gaussian distribution with the given mean and covariance.
    */
   GaussianDistribution(const arma::vec& mean, const arma::mat& covariance) :
-      mean(mean), covariance(covariance) { /* Nothing to do. */ }
+      mean(mean)
+  {
+    Covariance(covariance);
+  }
 
   //! Return the dimensionality of this distribution.
   size_t Dimensionality() const { return mean.n_elem; }
@@ -51,8 +67,16 @@ class GaussianDistribution
   /**
    * Return the probability of the given observation.
    */
-  double Probability(const arma::vec& observation) const;
-  
+  double Probability(const arma::vec& observation) const
+  {
+    return exp(LogProbability(observation));
+  }
+
+  /**
+   * Return the log probability of the given observation.
+   */
+  double LogProbability(const arma::vec& observation) const;
+
   /**
    * Calculates the multivariate Gaussian probability density function for each
    * data point (column) in the given matrix
@@ -60,8 +84,23 @@ class GaussianDistribution
    * @param x List of observations.
    * @param probabilities Output probabilities for each input observation.
    */
-  void Probability(const arma::mat& x, arma::vec& probabilities) const;
-  
+  void Probability(const arma::mat& x, arma::vec& probabilities) const
+  {
+    LogProbability(x, probabilities);
+    probabilities = exp(probabilities);
+  }
+
+  /**
+   * Calculates the log of the multivariate Gaussian probability density
+   * function for each data point (column) in the given matrix, with a single
+   * triangular solve for the whole matrix.
+   *
+   * @param x List of observations.
+   * @param logProbabilities Output log probabilities for each input
+   *     observation.
+   */
+  void LogProbability(const arma::mat& x, arma::vec& logProbabilities) const;
+
   /**
    * Return a randomly generated observation according to the probability
    * distribution defined by this object.
@@ -101,52 +140,41 @@ class GaussianDistribution
   const arma::mat& Covariance() const { return covariance; }
 
   /**
-   * Return a modifiable copy of the covariance.
+   * Set the covariance matrix, and compute its Cholesky factor and
+   * log-determinant.
    */
-  arma::mat& Covariance() { return covariance; }
+  void Covariance(const arma::mat& covariance);
+
+  /**
+   * Return the lower triangular Cholesky factor of the covariance.
+   */
+  const arma::mat& CovarianceLower() const { return covLower; }
+
+  /**
+   * Return the log-determinant of the covariance.
+   */
+  double LogDetCovariance() const { return logDetCov; }
 
   /**
    * Returns a string representation of this object.
    */
   std::string ToString() const;
-    
+
   /*
    * Save to or Load from SaveRestoreUtility
    */
   void Save(util::SaveRestoreUtility& n) const;
   void Load(const util::SaveRestoreUtility& n);
   static std::string const Type() { return "GaussianDistribution"; }
-  
-  
-    
-};
 
-/**
-* Calculates the multivariate Gaussian probability density function for each
-* data point (column) in the given matrix
-*
-* @param x List of observations.
-* @param probabilities Output probabilities for each input observation.
-*/
-inline void GaussianDistribution::Probability(const arma::mat& x,
-                                              arma::vec& probabilities) const
-{
-  // Column i of 'diffs' is the difference between x.col(i) and the mean.
-  arma::mat diffs = x - (mean * arma::ones<arma::rowvec>(x.n_cols));
-  
-  // Now, we only want to calculate the diagonal elements of (diffs' * cov^-1 *
-  // diffs).  We just don't need any of the other elements.  We can calculate
-  // the right hand part of the equation (instead of the left side) so that
-  // later we are referencing columns, not rows -- that is faster.
-  arma::mat rhs = -0.5 * inv(covariance) * diffs;
-  arma::vec exponents(diffs.n_cols); // We will now fill this.
-  for (size_t i = 0; i < diffs.n_cols; i++)
-    exponents(i) = exp(accu(diffs.unsafe_col(i) % rhs.unsafe_col(i)));
-  
-  probabilities = pow(2 * M_PI, (double) mean.n_elem / -2.0) *
-  pow(arma::det(covariance), -0.5) * exponents;
-}
-  
+ private:
+  /**
+   * Compute the Cholesky factor and log-determinant of the covariance.  If the
+   * covariance is not positive definite, its diagonal is perturbed (increasing
+   * the perturbation until it is).
+   */
+  void FactorCovariance();
+};
 
 }; // namespace distribution
 }; // namespace mlpack
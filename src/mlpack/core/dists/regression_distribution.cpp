@@ -35,28 +35,29 @@ std::string RegressionDistribution::ToString() const
  */
 void RegressionDistribution::Estimate(const arma::mat& observations)
 {
-  regression::LinearRegression lr(observations.rows(1, observations.n_rows - 1),
-      (observations.row(0)).t(), 0, true);
-  rf = lr;
-  arma::vec fitted;
-  lr.Predict(observations.rows(1, observations.n_rows - 1), fitted);
-  err.Estimate(observations.row(0) - fitted.t());
+  Estimate(observations, arma::vec());
 }
 
 /**
- * Estimate parameters using provided observation weights.
+ * Estimate parameters using provided observation weights.  The weighted normal
+ * equations are accumulated from the observations in place, so the predictors
+ * are never copied out of the observations.
  *
  * @param weights probability that given observation is from distribution
  */
 void RegressionDistribution::Estimate(const arma::mat& observations,
                              const arma::vec& weights)
 {
-  regression::LinearRegression lr(observations.rows(1, observations.n_rows - 1),
-      (observations.row(0)).t(), 0, true, weights);
-  rf = lr;
-  arma::vec fitted;
-  lr.Predict(observations.rows(1, observations.n_rows - 1), fitted);
-  err.Estimate(observations.row(0) - fitted.t(), weights);
+  regression::NormalEquations equations(true);
+  equations.AddStacked(observations, weights);
+  rf = regression::LinearRegression(equations);
+
+  arma::rowvec residuals;
+  Residuals(observations, residuals);
+  if (weights.n_elem > 0)
+    err.Estimate(residuals, weights);
+  else
+    err.Estimate(residuals);
 }
 
 /**
@@ -71,6 +72,36 @@ double RegressionDistribution::Probability(const arma::vec& observation) const
   return err.Probability(observation(0)-fitted);
 }
 
+/**
+ * Evaluate the log probability density function of each of the given
+ * observations.
+ */
+void RegressionDistribution::LogProbability(const arma::mat& observations,
+                                            arma::vec& logProbabilities) const
+{
+  arma::rowvec residuals;
+  Residuals(observations, residuals);
+  err.LogProbability(residuals, logProbabilities);
+}
+
+void RegressionDistribution::Residuals(const arma::mat& observations,
+                                       arma::rowvec& residuals) const
+{
+  // Each residual is y - b_0 - b^T x, which is the product of the whole
+  // observation with [1; -b], less the intercept b_0.
+  const arma::vec& parameters = rf.Parameters();
+  const size_t offset = rf.Intercept() ? 1 : 0;
+  arma::vec coefficients(observations.n_rows);
+  coefficients[0] = 1.0;
+  if (observations.n_rows > 1)
+    coefficients.subvec(1, observations.n_rows - 1) =
+        -parameters.subvec(offset, parameters.n_elem - 1);
+
+  residuals = arma::trans(coefficients) * observations;
+  if (rf.Intercept())
+    residuals -= parameters[0];
+}
+
 void RegressionDistribution::Predict(const arma::mat& points,
                                      arma::vec& predictions) const
 {
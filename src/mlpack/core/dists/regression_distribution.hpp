@@ -10,6 +10,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/dists/gaussian_distribution.hpp>
 #include <mlpack/methods/linear_regression/linear_regression.hpp>
+#include <mlpack/methods/linear_regression/normal_equations.hpp>
 
 namespace mlpack {
 namespace distribution {
@@ -48,7 +49,8 @@ class RegressionDistribution
       rf(regression::LinearRegression(predictors, responses))
   {
     err = GaussianDistribution(1);
-    err.Covariance() = rf.ComputeError(predictors, responses);
+    err.Covariance(rf.ComputeError(predictors, responses) *
+        arma::ones<arma::mat>(1, 1));
   }
 
   /**
@@ -80,6 +82,16 @@ class RegressionDistribution
   */
   double Probability(const arma::vec& observation) const;
 
+  /**
+   * Evaluate the log probability density function of each of the given
+   * observations (columns), without copying the predictors.
+   *
+   * @param observations Observations to evaluate the log probability at.
+   * @param logProbabilities Vector to store the log probabilities in.
+   */
+  void LogProbability(const arma::mat& observations,
+                      arma::vec& logProbabilities) const;
+
   /**
    * Calculate y_i for each data point in points.
    *
@@ -93,6 +105,10 @@ class RegressionDistribution
 
   //! Return the dimensionality 
     size_t Dimensionality() const { return rf.Parameters().n_elem; }
+
+ private:
+  //! Compute the residual y - f(x) of each of the given observations.
+  void Residuals(const arma::mat& observations, arma::rowvec& residuals) const;
 };
 
 
@@ -0,0 +1,50 @@
+/**
+ * @file knn.cpp
+ *
+ * Implementation of the host side of brute-force k-nearest-neighbor search on
+ * a CUDA device.
+ */
+#include "knn.hpp"
+#include "knn_device.hpp"
+
+using namespace mlpack;
+
+void gpu::KNearestNeighbors(const arma::mat& querySet,
+                            const arma::mat& referenceSet,
+                            const size_t k,
+                            arma::Mat<size_t>& neighbors,
+                            arma::mat& distances,
+                            const bool monochromatic,
+                            const size_t deviceMemory)
+{
+  if (querySet.n_rows != referenceSet.n_rows)
+    Log::Fatal << "gpu::KNearestNeighbors(): the query points have "
+        << querySet.n_rows << " dimensions, but the reference points have "
+        << referenceSet.n_rows << "!" << std::endl;
+
+  const size_t maxK = referenceSet.n_cols - (monochromatic ? 1 : 0);
+  if (k == 0 || k > maxK)
+    Log::Fatal << "gpu::KNearestNeighbors(): invalid k: " << k << "; must be "
+        << "greater than 0 and less than or equal to " << maxK << "."
+        << std::endl;
+
+  neighbors.set_size(k, querySet.n_cols);
+  distances.set_size(k, querySet.n_cols);
+  if (querySet.n_cols == 0)
+    return;
+
+  const char* error = KNearestNeighborsDevice(querySet.memptr(),
+      querySet.n_cols, referenceSet.memptr(), referenceSet.n_cols,
+      referenceSet.n_rows, k, monochromatic, deviceMemory, neighbors.memptr(),
+      distances.memptr());
+  if (error)
+    Log::Fatal << "gpu::KNearestNeighbors(): " << error << std::endl;
+
+  // The device computes squared distances.
+  distances = arma::sqrt(distances);
+}
+
+bool gpu::DeviceAvailable()
+{
+  return (NumDevices() > 0);
+}
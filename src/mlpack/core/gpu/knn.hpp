@@ -0,0 +1,53 @@
+/**
+ * @file knn.hpp
+ *
+ * Brute-force k-nearest-neighbor search on a CUDA device.  This is only
+ * available if mlpack was compiled with CUDA (HAS_CUDA is defined).
+ */
+#ifndef __MLPACK_CORE_GPU_KNN_HPP
+#define __MLPACK_CORE_GPU_KNN_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace gpu {
+
+/**
+ * Find the k nearest neighbors (in Euclidean distance) of each query point
+ * among the reference points, by computing every distance on the CUDA device.
+ * This gives the same results as the naive mode of neighbor::AllkNN (up to
+ * ties and rounding), but the distances are computed in tiles with dense
+ * matrix products, and only the best k candidates of each query are copied
+ * back.  Datasets larger than the device memory are copied to the device one
+ * tile at a time.
+ *
+ * As with neighbor::NeighborSearch, column i of the results holds the
+ * neighbors of query point i, best first.
+ *
+ * @param querySet Set of query points.
+ * @param referenceSet Set of reference points.
+ * @param k Number of neighbors to find.
+ * @param neighbors Matrix to store the indices of the neighbors in.
+ * @param distances Matrix to store the distances of the neighbors in.
+ * @param monochromatic If true, querySet must be referenceSet, and no point is
+ *     returned as its own neighbor.
+ * @param deviceMemory Number of bytes of device memory to use (0 means most of
+ *     the free memory).
+ */
+void KNearestNeighbors(const arma::mat& querySet,
+                       const arma::mat& referenceSet,
+                       const size_t k,
+                       arma::Mat<size_t>& neighbors,
+                       arma::mat& distances,
+                       const bool monochromatic = false,
+                       const size_t deviceMemory = 0);
+
+/**
+ * Return true if a CUDA device is available.
+ */
+bool DeviceAvailable();
+
+}; // namespace gpu
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,307 @@
+/**
+ * @file knn_device.cu
+ *
+ * The CUDA implementation of brute-force k-nearest-neighbor search.  The
+ * squared distance between query q and reference r is |q|^2 + |r|^2 - 2 q'r;
+ * for each pair of tiles of the query and reference sets, the inner products
+ * are computed with one cuBLAS GEMM, and then each thread merges the distances
+ * of one query into its list of the best k candidates, which stays on the
+ * device until every reference tile has been seen.
+ */
+#include "knn_device.hpp"
+
+#include <cuda_runtime.h>
+#include <cublas_v2.h>
+
+#include <algorithm>
+#include <cfloat>
+
+namespace mlpack {
+namespace gpu {
+
+//! The number of threads in each block of the kernels.
+static const unsigned int threadsPerBlock = 256;
+
+//! Compute the squared norm of each column of the given matrix.
+__global__ void SquaredNormsKernel(const double* points,
+                                   const size_t numPoints,
+                                   const size_t dimensionality,
+                                   double* norms)
+{
+  const size_t i = blockIdx.x * (size_t) blockDim.x + threadIdx.x;
+  if (i >= numPoints)
+    return;
+
+  const double* point = points + i * dimensionality;
+  double norm = 0.0;
+  for (size_t d = 0; d < dimensionality; ++d)
+    norm += point[d] * point[d];
+
+  norms[i] = norm;
+}
+
+//! Empty the candidate lists of the given number of queries.
+__global__ void ResetCandidatesKernel(const size_t numCandidates,
+                                      const size_t invalidIndex,
+                                      double* distances,
+                                      size_t* neighbors)
+{
+  const size_t i = blockIdx.x * (size_t) blockDim.x + threadIdx.x;
+  if (i >= numCandidates)
+    return;
+
+  distances[i] = DBL_MAX;
+  neighbors[i] = invalidIndex;
+}
+
+/**
+ * Merge the distances from each query of the tile to each reference of the tile
+ * into the candidate list of the query.  The products are held in a
+ * column-major numQueries x numReferences matrix, so the threads of a warp read
+ * consecutive elements.  Each candidate list is sorted, best first.
+ */
+__global__ void SelectKernel(const double* products,
+                             const double* queryNorms,
+                             const double* referenceNorms,
+                             const size_t numQueries,
+                             const size_t numReferences,
+                             const size_t queryOffset,
+                             const size_t referenceOffset,
+                             const size_t k,
+                             const bool monochromatic,
+                             double* distances,
+                             size_t* neighbors)
+{
+  const size_t q = blockIdx.x * (size_t) blockDim.x + threadIdx.x;
+  if (q >= numQueries)
+    return;
+
+  double* queryDistances = distances + q * k;
+  size_t* queryNeighbors = neighbors + q * k;
+  double worstDistance = queryDistances[k - 1];
+
+  for (size_t r = 0; r < numReferences; ++r)
+  {
+    double distance = queryNorms[q] + referenceNorms[r] +
+        products[q + r * numQueries];
+    // Rounding can make the distance of (nearly) identical points negative.
+    if (distance < 0.0)
+      distance = 0.0;
+
+    if (distance >= worstDistance)
+      continue;
+
+    const size_t index = referenceOffset + r;
+    if (monochromatic && index == queryOffset + q)
+      continue;
+
+    // Insert the candidate, shifting the worse ones down.
+    size_t position = k - 1;
+    while (position > 0 && queryDistances[position - 1] > distance)
+    {
+      queryDistances[position] = queryDistances[position - 1];
+      queryNeighbors[position] = queryNeighbors[position - 1];
+      --position;
+    }
+
+    queryDistances[position] = distance;
+    queryNeighbors[position] = index;
+    worstDistance = queryDistances[k - 1];
+  }
+}
+
+/**
+ * The device memory used by a search, which is released when the search
+ * returns (on success or on error).
+ */
+class DeviceBuffers
+{
+ public:
+  DeviceBuffers() :
+      queries(NULL), queryNorms(NULL), references(NULL), referenceNorms(NULL),
+      products(NULL), distances(NULL), neighbors(NULL), handle(NULL) { }
+
+  ~DeviceBuffers()
+  {
+    cudaFree(queries);
+    cudaFree(queryNorms);
+    cudaFree(references);
+    cudaFree(referenceNorms);
+    cudaFree(products);
+    cudaFree(distances);
+    cudaFree(neighbors);
+    if (handle)
+      cublasDestroy(handle);
+  }
+
+  double* queries;
+  double* queryNorms;
+  double* references;
+  double* referenceNorms;
+  double* products;
+  double* distances;
+  size_t* neighbors;
+  cublasHandle_t handle;
+};
+
+//! Return the description of the error, if the CUDA call failed.
+#define MLPACK_CUDA_CHECK(call) \
+  { \
+    const cudaError_t status = (call); \
+    if (status != cudaSuccess) \
+      return cudaGetErrorString(status); \
+  }
+
+//! Return the number of blocks needed to give a thread to each element.
+static unsigned int NumBlocks(const size_t n)
+{
+  return (unsigned int) ((n + threadsPerBlock - 1) / threadsPerBlock);
+}
+
+const char* KNearestNeighborsDevice(const double* querySet,
+                                    const size_t numQueries,
+                                    const double* referenceSet,
+                                    const size_t numReferences,
+                                    const size_t dimensionality,
+                                    const size_t k,
+                                    const bool monochromatic,
+                                    const size_t deviceMemory,
+                                    size_t* neighbors,
+                                    double* distances)
+{
+  size_t memory = deviceMemory;
+  if (memory == 0)
+  {
+    size_t freeMemory, totalMemory;
+    MLPACK_CUDA_CHECK(cudaMemGetInfo(&freeMemory, &totalMemory));
+    // Leave some room for cuBLAS and the driver.
+    memory = (size_t) (0.8 * freeMemory);
+  }
+
+  // Choose the tile sizes, in elements of 8 bytes (doubles and indices).  A
+  // query tile of t points takes t * (d + 1 + 2k) elements, and a reference
+  // tile of u points takes u * (d + 1 + t) elements, including the products.
+  // The query tiles are made smaller until a reference tile of a reasonable
+  // size (or the whole reference set) fits as well.
+  const size_t elements = memory / sizeof(double);
+  size_t queryTileSize = std::min(numQueries, (size_t) 16384);
+  size_t referenceTileSize = 0;
+  while (queryTileSize > 0)
+  {
+    const size_t queryCost = queryTileSize * (dimensionality + 1 + 2 * k);
+    if (queryCost < elements)
+    {
+      referenceTileSize = std::min(numReferences, (elements - queryCost) /
+          (dimensionality + 1 + queryTileSize));
+      if (referenceTileSize == numReferences ||
+          referenceTileSize >= std::min(queryTileSize, (size_t) 1024))
+        break;
+    }
+
+    queryTileSize /= 2;
+  }
+
+  if (queryTileSize == 0 || referenceTileSize == 0)
+    return "not enough device memory for the search";
+
+  DeviceBuffers buffers;
+  MLPACK_CUDA_CHECK(cudaMalloc((void**) &buffers.queries, queryTileSize *
+      dimensionality * sizeof(double)));
+  MLPACK_CUDA_CHECK(cudaMalloc((void**) &buffers.queryNorms, queryTileSize *
+      sizeof(double)));
+  MLPACK_CUDA_CHECK(cudaMalloc((void**) &buffers.references,
+      referenceTileSize * dimensionality * sizeof(double)));
+  MLPACK_CUDA_CHECK(cudaMalloc((void**) &buffers.referenceNorms,
+      referenceTileSize * sizeof(double)));
+  MLPACK_CUDA_CHECK(cudaMalloc((void**) &buffers.products, queryTileSize *
+      referenceTileSize * sizeof(double)));
+  MLPACK_CUDA_CHECK(cudaMalloc((void**) &buffers.distances, queryTileSize * k *
+      sizeof(double)));
+  MLPACK_CUDA_CHECK(cudaMalloc((void**) &buffers.neighbors, queryTileSize * k *
+      sizeof(size_t)));
+
+  if (cublasCreate(&buffers.handle) != CUBLAS_STATUS_SUCCESS)
+    return "could not initialize cuBLAS";
+
+  // If the whole reference set fits, it is only copied once.
+  const bool referencesResident = (referenceTileSize == numReferences);
+  if (referencesResident)
+  {
+    MLPACK_CUDA_CHECK(cudaMemcpy(buffers.references, referenceSet,
+        numReferences * dimensionality * sizeof(double),
+        cudaMemcpyHostToDevice));
+    SquaredNormsKernel<<<NumBlocks(numReferences), threadsPerBlock>>>(
+        buffers.references, numReferences, dimensionality,
+        buffers.referenceNorms);
+    MLPACK_CUDA_CHECK(cudaGetLastError());
+  }
+
+  const double minusTwo = -2.0;
+  const double zero = 0.0;
+  for (size_t queryBegin = 0; queryBegin < numQueries;
+       queryBegin += queryTileSize)
+  {
+    const size_t queries = std::min(queryTileSize, numQueries - queryBegin);
+
+    MLPACK_CUDA_CHECK(cudaMemcpy(buffers.queries, querySet + queryBegin *
+        dimensionality, queries * dimensionality * sizeof(double),
+        cudaMemcpyHostToDevice));
+    SquaredNormsKernel<<<NumBlocks(queries), threadsPerBlock>>>(
+        buffers.queries, queries, dimensionality, buffers.queryNorms);
+    ResetCandidatesKernel<<<NumBlocks(queries * k), threadsPerBlock>>>(
+        queries * k, numReferences, buffers.distances, buffers.neighbors);
+    MLPACK_CUDA_CHECK(cudaGetLastError());
+
+    for (size_t referenceBegin = 0; referenceBegin < numReferences;
+         referenceBegin += referenceTileSize)
+    {
+      const size_t references = std::min(referenceTileSize, numReferences -
+          referenceBegin);
+
+      if (!referencesResident)
+      {
+        MLPACK_CUDA_CHECK(cudaMemcpy(buffers.references, referenceSet +
+            referenceBegin * dimensionality, references * dimensionality *
+            sizeof(double), cudaMemcpyHostToDevice));
+        SquaredNormsKernel<<<NumBlocks(references), threadsPerBlock>>>(
+            buffers.references, references, dimensionality,
+            buffers.referenceNorms);
+        MLPACK_CUDA_CHECK(cudaGetLastError());
+      }
+
+      // products = -2 * queries' * references.
+      if (cublasDgemm(buffers.handle, CUBLAS_OP_T, CUBLAS_OP_N, (int) queries,
+          (int) references, (int) dimensionality, &minusTwo, buffers.queries,
+          (int) dimensionality, buffers.references, (int) dimensionality,
+          &zero, buffers.products, (int) queries) != CUBLAS_STATUS_SUCCESS)
+        return "cuBLAS matrix multiplication failed";
+
+      SelectKernel<<<NumBlocks(queries), threadsPerBlock>>>(buffers.products,
+          buffers.queryNorms, buffers.referenceNorms, queries, references,
+          queryBegin, referenceBegin, k, monochromatic, buffers.distances,
+          buffers.neighbors);
+      MLPACK_CUDA_CHECK(cudaGetLastError());
+    }
+
+    // The candidate lists have the layout of the output, so they are copied
+    // straight into it.
+    MLPACK_CUDA_CHECK(cudaMemcpy(distances + queryBegin * k, buffers.distances,
+        queries * k * sizeof(double), cudaMemcpyDeviceToHost));
+    MLPACK_CUDA_CHECK(cudaMemcpy(neighbors + queryBegin * k, buffers.neighbors,
+        queries * k * sizeof(size_t), cudaMemcpyDeviceToHost));
+  }
+
+  return NULL;
+}
+
+size_t NumDevices()
+{
+  int devices = 0;
+  if (cudaGetDeviceCount(&devices) != cudaSuccess)
+    return 0;
+
+  return (size_t) devices;
+}
+
+}; // namespace gpu
+}; // namespace mlpack
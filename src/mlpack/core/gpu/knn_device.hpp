@@ -0,0 +1,60 @@
+/**
+ * @file knn_device.hpp
+ *
+ * The interface of the CUDA implementation of brute-force k-nearest-neighbor
+ * search.  This header uses only raw arrays, so that it can be included both by
+ * the device code (compiled by nvcc) and by the host code that uses Armadillo;
+ * use gpu::KNearestNeighbors() (in knn.hpp) instead of this.
+ */
+#ifndef __MLPACK_CORE_GPU_KNN_DEVICE_HPP
+#define __MLPACK_CORE_GPU_KNN_DEVICE_HPP
+
+#include <cstddef>
+
+namespace mlpack {
+namespace gpu {
+
+/**
+ * Find the k nearest references (in squared Euclidean distance) of each query
+ * on the CUDA device.  All matrices are column-major, with one point or one
+ * list of neighbors per column.  The query and reference sets are copied to the
+ * device in tiles that fit in the given amount of memory; for each pair of
+ * tiles, the inner products are computed with one cuBLAS GEMM, and the best k
+ * candidates of each query are kept on the device.
+ *
+ * @param querySet Query points (dimensionality x numQueries).
+ * @param numQueries Number of query points.
+ * @param referenceSet Reference points (dimensionality x numReferences).
+ * @param numReferences Number of reference points.
+ * @param dimensionality Dimensionality of the points.
+ * @param k Number of neighbors to find.
+ * @param monochromatic If true, the query set is the reference set, and no
+ *     point is returned as its own neighbor.
+ * @param deviceMemory Number of bytes of device memory to use (0 means most of
+ *     the free memory).
+ * @param neighbors Array to store the indices of the neighbors in (k x
+ *     numQueries).
+ * @param distances Array to store the squared distances in (k x numQueries).
+ * @return NULL on success, or a description of the error.
+ */
+const char* KNearestNeighborsDevice(const double* querySet,
+                                    const size_t numQueries,
+                                    const double* referenceSet,
+                                    const size_t numReferences,
+                                    const size_t dimensionality,
+                                    const size_t k,
+                                    const bool monochromatic,
+                                    const size_t deviceMemory,
+                                    size_t* neighbors,
+                                    double* distances);
+
+/**
+ * Return the number of CUDA devices (0 if there are none, or if the driver
+ * cannot be used).
+ */
+size_t NumDevices();
+
+}; // namespace gpu
+}; // namespace mlpack
+
+#endif
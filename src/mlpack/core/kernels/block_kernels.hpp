@@ -0,0 +1,148 @@
+/**
+ * @file block_kernels.hpp
+ *
+ * Compute all of the kernel evaluations between two blocks of points at once,
+ * for kernels where this can be done with a matrix multiplication.  This is the
+ * kernel counterpart of metric::BlockDistances().
+ */
+#ifndef __MLPACK_CORE_KERNELS_BLOCK_KERNELS_HPP
+#define __MLPACK_CORE_KERNELS_BLOCK_KERNELS_HPP
+
+#include <mlpack/core.hpp>
+#include "linear_kernel.hpp"
+#include "polynomial_kernel.hpp"
+#include "cosine_distance.hpp"
+#include "pspectrum_string_kernel.hpp"
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * Compute the kernel between every point in a and every point in b.  Most
+ * kernels have no faster way to do this than one evaluation per pair, so this
+ * overload does nothing and returns false; the caller must then evaluate the
+ * kernels one by one.
+ *
+ * @param kernel Kernel to use.
+ * @param a First block of points.
+ * @param b Second block of points.
+ * @param kernels Matrix to store the kernel evaluations in (unused).
+ * @return false, because the kernels were not calculated.
+ */
+template<typename KernelType, typename MatType1, typename MatType2>
+bool BlockKernels(const KernelType& /* kernel */,
+                  const MatType1& /* a */,
+                  const MatType2& /* b */,
+                  arma::mat& /* kernels */)
+{
+  return false;
+}
+
+/**
+ * Compute the linear kernel between every point in a and every point in b with
+ * one matrix multiplication.  The kernel between a(i) and b(j) is stored in
+ * kernels(i, j).
+ *
+ * @param kernel Kernel to use.
+ * @param a First block of points.
+ * @param b Second block of points.
+ * @param kernels Matrix to store the kernel evaluations in.
+ * @return true, because the kernels were calculated.
+ */
+template<typename MatType1, typename MatType2>
+bool BlockKernels(const LinearKernel& /* kernel */,
+                  const MatType1& a,
+                  const MatType2& b,
+                  arma::mat& kernels)
+{
+  kernels = arma::trans(a) * b;
+  return true;
+}
+
+/**
+ * Compute the polynomial kernel (a^T b + offset)^degree between every point in
+ * a and every point in b, using one matrix multiplication for the inner
+ * products.  The kernel between a(i) and b(j) is stored in kernels(i, j).
+ *
+ * @param kernel Kernel to use.
+ * @param a First block of points.
+ * @param b Second block of points.
+ * @param kernels Matrix to store the kernel evaluations in.
+ * @return true, because the kernels were calculated.
+ */
+template<typename MatType1, typename MatType2>
+bool BlockKernels(const PolynomialKernel& kernel,
+                  const MatType1& a,
+                  const MatType2& b,
+                  arma::mat& kernels)
+{
+  kernels = arma::pow(arma::trans(a) * b + kernel.Offset(), kernel.Degree());
+  return true;
+}
+
+/**
+ * Compute the cosine similarity between every point in a and every point in b,
+ * using one matrix multiplication for the inner products.  As with
+ * CosineDistance::Evaluate(), the similarity is 0 if either point has zero
+ * norm.  The kernel between a(i) and b(j) is stored in kernels(i, j).
+ *
+ * @param kernel Kernel to use.
+ * @param a First block of points.
+ * @param b Second block of points.
+ * @param kernels Matrix to store the kernel evaluations in.
+ * @return true, because the kernels were calculated.
+ */
+template<typename MatType1, typename MatType2>
+bool BlockKernels(const CosineDistance& /* kernel */,
+                  const MatType1& a,
+                  const MatType2& b,
+                  arma::mat& kernels)
+{
+  const arma::rowvec aNorms = arma::sqrt(arma::sum(arma::square(a), 0));
+  const arma::rowvec bNorms = arma::sqrt(arma::sum(arma::square(b), 0));
+
+  kernels = arma::trans(a) * b;
+  for (size_t j = 0; j < kernels.n_cols; ++j)
+  {
+    for (size_t i = 0; i < kernels.n_rows; ++i)
+    {
+      const double denominator = aNorms[i] * bNorms[j];
+      kernels(i, j) = (denominator == 0.0) ? 0.0 : kernels(i, j) / denominator;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Compute the p-spectrum string kernel between every string in a and every
+ * string in b, one row at a time with PSpectrumStringKernel::Evaluate().  The
+ * kernel between a(i) and b(j) is stored in kernels(i, j).
+ *
+ * @param kernel Kernel to use.
+ * @param a First block of string indices.
+ * @param b Second block of string indices.
+ * @param kernels Matrix to store the kernel evaluations in.
+ * @return true, because the kernels were calculated.
+ */
+template<typename MatType1, typename MatType2>
+bool BlockKernels(const PSpectrumStringKernel& kernel,
+                  const MatType1& a,
+                  const MatType2& b,
+                  arma::mat& kernels)
+{
+  kernels.set_size(a.n_cols, b.n_cols);
+  arma::vec row;
+  for (size_t i = 0; i < a.n_cols; ++i)
+  {
+    kernel.Evaluate(a.col(i), b, row);
+    kernels.row(i) = arma::trans(row);
+  }
+
+  return true;
+}
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
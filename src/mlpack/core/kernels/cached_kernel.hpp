@@ -0,0 +1,204 @@
+/**
+ * @file cached_kernel.hpp
+ *
+ * A wrapper for any kernel that caches its evaluations between the points of
+ * given datasets.
+ */
+#ifndef __MLPACK_CORE_KERNELS_CACHED_KERNEL_HPP
+#define __MLPACK_CORE_KERNELS_CACHED_KERNEL_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/kernel_traits.hpp>
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * The CachedKernel wraps another kernel, and remembers the evaluations of that
+ * kernel between the points (columns) of the datasets given to Cache(), so that
+ * algorithms that evaluate the kernel between the same points many times (such
+ * as FastMKS) only pay for each evaluation once.  It is used like any other
+ * kernel:
+ *
+ * @code
+ * CachedKernel<GaussianKernel> kernel(GaussianKernel(0.5));
+ * kernel.Cache(querySet, referenceSet);
+ * FastMKS<CachedKernel<GaussianKernel> > fastmks(referenceSet, querySet,
+ *     kernel);
+ * @endcode
+ *
+ * Points are recognized by their address: a vector is a point of a cached
+ * dataset if it is (an alias of) one of the dataset's columns, as given by
+ * unsafe_col() or col().  K(x, y) is cached when x is a point of the first
+ * dataset ('rows') and y a point of the second ('columns'), or the other way
+ * around, since kernels are symmetric.  Evaluations between any other vectors
+ * (such as centroids) are passed straight to the wrapped kernel.  Because of
+ * this, the cached datasets must not be modified or destroyed until the cache
+ * is cleared with Clear() or replaced with Cache().
+ *
+ * Two stores are kept:
+ *
+ *  - The self-kernels K(x, x) of every point of both datasets, which are
+ *    computed when Cache() is called.
+ *
+ *  - The most recently used rows of the kernel matrix, each holding K(x, y)
+ *    for one point x of the first dataset and every point y of the second,
+ *    computed as they are needed.  Each row is contiguous in memory, and the
+ *    number of rows is bounded so that all of them take at most the given
+ *    number of bytes; when a new row is needed and the store is full, the least
+ *    recently used row is dropped.
+ *
+ * Evaluate() may be called concurrently from OpenMP threads (as when computing
+ * blocks of the Nystroem method): each thread has its own store of rows (with
+ * its share of the bytes), so no locks are needed.  Nested parallel regions
+ * are not supported.
+ *
+ * @tparam KernelType Type of kernel to cache.
+ */
+template<typename KernelType>
+class CachedKernel
+{
+ public:
+  /**
+   * Wrap the given kernel.  Nothing is cached until Cache() is called.
+   *
+   * @param kernel Kernel to wrap (it is copied).
+   * @param cacheBytes Maximum number of bytes that the rows of the kernel
+   *     matrix may take, for all threads together.
+   */
+  CachedKernel(const KernelType& kernel = KernelType(),
+               const size_t cacheBytes = 64 * 1024 * 1024);
+
+  /**
+   * Cache the evaluations between the points of the given dataset.
+   *
+   * @param dataset Dataset to cache evaluations for.
+   */
+  void Cache(const arma::mat& dataset) { Cache(dataset, dataset); }
+
+  /**
+   * Cache the evaluations between the points of the first dataset and the
+   * points of the second (such as the query and reference sets).
+   *
+   * @param rowSet Dataset whose points give the rows of the kernel matrix.
+   * @param columnSet Dataset whose points give the columns.
+   */
+  void Cache(const arma::mat& rowSet, const arma::mat& columnSet);
+
+  //! Forget the cached datasets and every cached evaluation.
+  void Clear();
+
+  /**
+   * Evaluate the kernel between the two given vectors, with the cache if they
+   * are points of the cached datasets.
+   *
+   * @param a First vector.
+   * @param b Second vector.
+   * @return K(a, b).
+   */
+  template<typename VecType>
+  double Evaluate(const VecType& a, const VecType& b) const;
+
+  //! Get the wrapped kernel.
+  const KernelType& Kernel() const { return kernel; }
+  //! Modify the wrapped kernel.  Call Clear() or Cache() after changing its
+  //! parameters, since the cached evaluations are not updated.
+  KernelType& Kernel() { return kernel; }
+
+  //! Get the maximum number of bytes the rows of the kernel matrix may take.
+  size_t CacheBytes() const { return cacheBytes; }
+
+  //! Return the number of evaluations answered from the cache.
+  size_t Hits() const;
+  //! Return the number of evaluations of cached pairs that had to be computed.
+  size_t Misses() const;
+
+  //! Convert object to string.
+  std::string ToString() const;
+
+ private:
+  //! The most recently used rows of the kernel matrix, for one thread.
+  struct RowStore
+  {
+    RowStore() : clock(0), hits(0), misses(0) { }
+
+    //! The rows; each column of this matrix is one row of the kernel matrix,
+    //! and uncomputed values are NaN.
+    arma::mat rows;
+    //! The point of the row set held by each slot (or rowSet->n_cols if none).
+    std::vector<size_t> slotRow;
+    //! The time each slot was last used.
+    std::vector<size_t> lastUse;
+    //! The slot holding each point of the row set (or slotRow.size() if none).
+    std::vector<size_t> slotOf;
+    //! The time, in uses.
+    size_t clock;
+    //! Number of evaluations answered from this store.
+    size_t hits;
+    //! Number of evaluations computed for this store.
+    size_t misses;
+  };
+
+  //! The wrapped kernel.
+  KernelType kernel;
+  //! Maximum number of bytes the rows may take, for all threads together.
+  size_t cacheBytes;
+
+  //! The dataset giving the rows of the kernel matrix (NULL if none).
+  const arma::mat* rowSet;
+  //! The dataset giving the columns of the kernel matrix (NULL if none).
+  const arma::mat* columnSet;
+  //! Self-kernels of the points of the row set.
+  arma::vec rowSelfKernels;
+  //! Self-kernels of the points of the column set.
+  arma::vec columnSelfKernels;
+  //! Number of rows each thread's store holds.
+  size_t slots;
+  //! The stores of rows, one for each thread.
+  mutable std::vector<RowStore> stores;
+
+  //! If the given memory is the start of a column of the given dataset (of the
+  //! given length), store the index of the column and return true.
+  static bool Index(const arma::mat* dataset,
+                    const double* memory,
+                    const size_t length,
+                    size_t& index);
+
+  //! Return the slot of the given row of the store, giving it the least
+  //! recently used slot if it has none.
+  size_t Slot(RowStore& store, const size_t row) const;
+};
+
+//! The address of the elements of a vector, or NULL if the vector is not a
+//! column of an arma::mat.
+template<typename VecType>
+inline const double* CachedKernelAddress(const VecType& /* v */)
+{
+  return NULL;
+}
+
+inline const double* CachedKernelAddress(const arma::Col<double>& v)
+{
+  return v.memptr();
+}
+
+inline const double* CachedKernelAddress(const arma::subview_col<double>& v)
+{
+  return v.colptr(0);
+}
+
+//! A cached kernel is normalized if the kernel it wraps is.
+template<typename KernelType>
+class KernelTraits<CachedKernel<KernelType> >
+{
+ public:
+  static const bool IsNormalized = KernelTraits<KernelType>::IsNormalized;
+};
+
+}; // namespace kernel
+}; // namespace mlpack
+
+// Include implementation.
+#include "cached_kernel_impl.hpp"
+
+#endif
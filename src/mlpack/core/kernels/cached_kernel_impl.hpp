@@ -0,0 +1,228 @@
+/**
+ * @file cached_kernel_impl.hpp
+ *
+ * Implementation of the CachedKernel.
+ */
+#ifndef __MLPACK_CORE_KERNELS_CACHED_KERNEL_IMPL_HPP
+#define __MLPACK_CORE_KERNELS_CACHED_KERNEL_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "cached_kernel.hpp"
+
+#include <limits>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kernel {
+
+template<typename KernelType>
+CachedKernel<KernelType>::CachedKernel(const KernelType& kernel,
+                                       const size_t cacheBytes) :
+    kernel(kernel),
+    cacheBytes(cacheBytes),
+    rowSet(NULL),
+    columnSet(NULL),
+    slots(0)
+{
+  // Nothing to do.
+}
+
+template<typename KernelType>
+void CachedKernel<KernelType>::Cache(const arma::mat& rowSet,
+                                     const arma::mat& columnSet)
+{
+  Clear();
+  this->rowSet = &rowSet;
+  this->columnSet = &columnSet;
+
+  rowSelfKernels.set_size(rowSet.n_cols);
+  for (size_t i = 0; i < rowSet.n_cols; ++i)
+    rowSelfKernels[i] = kernel.Evaluate(rowSet.unsafe_col(i),
+        rowSet.unsafe_col(i));
+
+  if (&columnSet == &rowSet)
+  {
+    columnSelfKernels = rowSelfKernels;
+  }
+  else
+  {
+    columnSelfKernels.set_size(columnSet.n_cols);
+    for (size_t i = 0; i < columnSet.n_cols; ++i)
+      columnSelfKernels[i] = kernel.Evaluate(columnSet.unsafe_col(i),
+          columnSet.unsafe_col(i));
+  }
+
+  // Each thread gets an equal share of the bytes for its rows, which are
+  // allocated when the thread first needs them.
+  size_t threads = 1;
+#ifdef HAS_OPENMP
+  threads = (size_t) omp_get_max_threads();
+#endif
+  const size_t rowBytes = std::max((size_t) columnSet.n_cols, (size_t) 1) *
+      sizeof(double);
+  slots = std::min((size_t) rowSet.n_cols,
+      std::max(cacheBytes / (threads * rowBytes), (size_t) 1));
+  stores.resize(threads);
+}
+
+template<typename KernelType>
+void CachedKernel<KernelType>::Clear()
+{
+  rowSet = NULL;
+  columnSet = NULL;
+  rowSelfKernels.reset();
+  columnSelfKernels.reset();
+  slots = 0;
+  stores.clear();
+}
+
+template<typename KernelType>
+template<typename VecType>
+double CachedKernel<KernelType>::Evaluate(const VecType& a,
+                                          const VecType& b) const
+{
+  const double* aMemory = CachedKernelAddress(a);
+  const double* bMemory = CachedKernelAddress(b);
+  if (rowSet == NULL || aMemory == NULL || bMemory == NULL)
+    return kernel.Evaluate(a, b);
+
+  size_t row, column;
+  if (aMemory == bMemory)
+  {
+    if (Index(rowSet, aMemory, a.n_elem, row))
+      return rowSelfKernels[row];
+    if (Index(columnSet, aMemory, a.n_elem, column))
+      return columnSelfKernels[column];
+    return kernel.Evaluate(a, b);
+  }
+
+  if (!(Index(rowSet, aMemory, a.n_elem, row) &&
+        Index(columnSet, bMemory, b.n_elem, column)) &&
+      !(Index(rowSet, bMemory, b.n_elem, row) &&
+        Index(columnSet, aMemory, a.n_elem, column)))
+    return kernel.Evaluate(a, b);
+
+  size_t thread = 0;
+#ifdef HAS_OPENMP
+  thread = (size_t) omp_get_thread_num();
+#endif
+  if (thread >= stores.size())
+    return kernel.Evaluate(a, b);
+  RowStore& store = stores[thread];
+
+  // With one dataset, K(x, y) may already be in the row of y.
+  if (rowSet == columnSet && store.slotOf.size() > 0 &&
+      store.slotOf[column] < slots)
+  {
+    const double value = store.rows(row, store.slotOf[column]);
+    if (value == value)
+    {
+      ++store.hits;
+      return value;
+    }
+  }
+
+  double& value = store.rows(column, Slot(store, row));
+  if (value == value)
+  {
+    ++store.hits;
+  }
+  else
+  {
+    value = kernel.Evaluate(a, b);
+    ++store.misses;
+  }
+
+  return value;
+}
+
+template<typename KernelType>
+size_t CachedKernel<KernelType>::Hits() const
+{
+  size_t hits = 0;
+  for (size_t i = 0; i < stores.size(); ++i)
+    hits += stores[i].hits;
+  return hits;
+}
+
+template<typename KernelType>
+size_t CachedKernel<KernelType>::Misses() const
+{
+  size_t misses = 0;
+  for (size_t i = 0; i < stores.size(); ++i)
+    misses += stores[i].misses;
+  return misses;
+}
+
+template<typename KernelType>
+std::string CachedKernel<KernelType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "CachedKernel [" << this << "]" << std::endl;
+  convert << "  Cache bytes: " << cacheBytes << std::endl;
+  convert << "  Rows per thread: " << slots << std::endl;
+  convert << "  Kernel: " << std::endl;
+  convert << mlpack::util::Indent(kernel.ToString(), 2);
+  return convert.str();
+}
+
+template<typename KernelType>
+bool CachedKernel<KernelType>::Index(const arma::mat* dataset,
+                                     const double* memory,
+                                     const size_t length,
+                                     size_t& index)
+{
+  if (length != dataset->n_rows || length == 0)
+    return false;
+
+  const double* begin = dataset->memptr();
+  if (memory < begin || memory >= begin + dataset->n_elem)
+    return false;
+
+  const size_t offset = (size_t) (memory - begin);
+  if (offset % length != 0)
+    return false;
+
+  index = offset / length;
+  return true;
+}
+
+template<typename KernelType>
+size_t CachedKernel<KernelType>::Slot(RowStore& store, const size_t row) const
+{
+  // The store is set up the first time its thread uses it.
+  if (store.slotOf.size() == 0)
+  {
+    store.rows.set_size(columnSet->n_cols, slots);
+    store.slotRow.assign(slots, rowSet->n_cols);
+    store.lastUse.assign(slots, 0);
+    store.slotOf.assign(rowSet->n_cols, slots);
+  }
+
+  size_t slot = store.slotOf[row];
+  if (slot == slots)
+  {
+    // Take the least recently used slot (those never used come first).
+    slot = 0;
+    for (size_t i = 1; i < slots; ++i)
+      if (store.lastUse[i] < store.lastUse[slot])
+        slot = i;
+
+    if (store.slotRow[slot] != rowSet->n_cols)
+      store.slotOf[store.slotRow[slot]] = slots;
+    store.slotRow[slot] = row;
+    store.slotOf[row] = slot;
+    store.rows.col(slot).fill(std::numeric_limits<double>::quiet_NaN());
+  }
+
+  store.lastUse[slot] = ++store.clock;
+  return slot;
+}
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
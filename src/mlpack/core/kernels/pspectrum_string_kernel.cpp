@@ -10,10 +10,63 @@
  */
 #include "pspectrum_string_kernel.hpp"
 
+#include <algorithm>
+#include <cctype>
+
 using namespace std;
 using namespace mlpack;
 using namespace mlpack::kernel;
 
+/**
+ * Initialize the PSpectrumStringKernel with the given string datasets.  For
+ * more information on this, see the general class documentation.
+ *
+ * @param datasets Sets of string data.  @param p The length of substrings to
+ * search.
+ */
+//! Collapse the sorted keys into the distinct keys and their counts.
+template<typename KeyType>
+static void CountSorted(const std::vector<KeyType>& sorted,
+                        std::vector<KeyType>& keys,
+                        std::vector<size_t>& keyCounts)
+{
+  for (size_t j = 0; j < sorted.size(); ++j)
+  {
+    if (j > 0 && sorted[j] == sorted[j - 1])
+    {
+      ++keyCounts.back();
+    }
+    else
+    {
+      keys.push_back(sorted[j]);
+      keyCounts.push_back(1);
+    }
+  }
+}
+
+//! Lay out the keys and counts of each string one after the other.
+template<typename KeyType>
+static void Flatten(const std::vector<std::vector<KeyType> >& setKeys,
+                    const std::vector<std::vector<size_t> >& setCounts,
+                    std::vector<size_t>& offsets,
+                    std::vector<KeyType>& keys,
+                    std::vector<size_t>& counts)
+{
+  offsets.resize(setKeys.size() + 1);
+  offsets[0] = 0;
+  for (size_t index = 0; index < setKeys.size(); ++index)
+    offsets[index + 1] = offsets[index] + setKeys[index].size();
+
+  keys.reserve(offsets[setKeys.size()]);
+  counts.reserve(offsets[setKeys.size()]);
+  for (size_t index = 0; index < setKeys.size(); ++index)
+  {
+    keys.insert(keys.end(), setKeys[index].begin(), setKeys[index].end());
+    counts.insert(counts.end(), setCounts[index].begin(),
+        setCounts[index].end());
+  }
+}
+
 /**
  * Initialize the PSpectrumStringKernel with the given string datasets.  For
  * more information on this, see the general class documentation.
@@ -25,59 +78,210 @@ mlpack::kernel::PSpectrumStringKernel::PSpectrumStringKernel(
     const std::vector<std::vector<std::string> >& datasets,
     const size_t p) :
     datasets(datasets),
-    p(p)
+    p(p),
+    exactCodes(p <= MaxCodeLength)
 {
   // We have to assemble the counts of substrings.  This is not a particularly
   // fast operation, unfortunately, but it only needs to be done once.
   Log::Info << "Assembling counts of substrings of length " << p << "."
       << std::endl;
 
-  // Resize for number of datasets.
+  // 36^(p - 1), to remove the first character from a code.
+  boost::uint64_t top = 1;
+  for (size_t j = 1; j < p && exactCodes; ++j)
+    top *= 36;
+
+  offsets.resize(datasets.size());
+  kmers.resize(datasets.size());
+  substrings.resize(datasets.size());
   counts.resize(datasets.size());
 
   for (size_t dataset = 0; dataset < datasets.size(); ++dataset)
   {
     const std::vector<std::string>& set = datasets[dataset];
 
-    // Resize for number of strings in dataset.
-    counts[dataset].resize(set.size());
+    // Extract the substrings of each string in parallel, then lay them out
+    // one after the other.
+    std::vector<std::vector<boost::uint64_t> > setKmers(set.size());
+    std::vector<std::vector<std::string> > setSubstrings(set.size());
+    std::vector<std::vector<size_t> > setCounts(set.size());
 
-    // Inspect each string in the dataset.
+    #pragma omp parallel for schedule(dynamic, 64)
     for (size_t index = 0; index < set.size(); ++index)
     {
-      // Convenience references.
       const std::string& str = set[index];
-      std::map<std::string, int>& mapping = counts[dataset][index];
 
-      size_t start = 0;
-      while ((start + p) <= str.length())
+      // The code of the current window (if the codes are exact), and how many
+      // alphanumeric characters (at most p) end at the current position.
+      std::vector<boost::uint64_t> codes;
+      std::vector<std::string> subs;
+      boost::uint64_t code = 0;
+      size_t valid = 0;
+      for (size_t start = 0; start + p <= str.length(); ++start)
       {
-        string sub = str.substr(start, p);
+        if (p == 0)
+        {
+          codes.push_back(0); // Every empty substring is the same.
+          continue;
+        }
 
-        // Convert all characters to lowercase.
-        bool invalid = false;
-        for (size_t j = 0; j < p; ++j)
+        // Bring in characters until the window is full; when a character is
+        // not alphanumeric, every window containing it is skipped.
+        while (valid < p)
         {
-          if (!isalnum(sub[j]))
-          {
-            invalid = true;
-            break; // Only consider substrings with alphanumerics.
-          }
+          const int digit = Digit(str[start + valid]);
+          if (digit < 0)
+            break;
+          if (exactCodes)
+            code = code * 36 + digit;
+          ++valid;
+        }
 
-          sub[j] = tolower(sub[j]);
+        if (valid < p)
+        {
+          // Restart after the character that is not alphanumeric.
+          start += valid;
+          code = 0;
+          valid = 0;
+          continue;
         }
 
-        // Increment position in string.
-        ++start;
+        if (exactCodes)
+        {
+          codes.push_back(code);
 
-        if (!invalid)
+          // Slide the window forward by one character.
+          code -= Digit(str[start]) * top;
+        }
+        else
         {
-          // Add to the map.
-          ++mapping[sub];
+          std::string sub = str.substr(start, p);
+          for (size_t j = 0; j < p; ++j)
+            sub[j] = tolower(sub[j]);
+          subs.push_back(sub);
         }
+        --valid;
+      }
+
+      if (exactCodes)
+      {
+        std::sort(codes.begin(), codes.end());
+        CountSorted(codes, setKmers[index], setCounts[index]);
+      }
+      else
+      {
+        std::sort(subs.begin(), subs.end());
+        CountSorted(subs, setSubstrings[index], setCounts[index]);
       }
     }
+
+    if (exactCodes)
+    {
+      Flatten(setKmers, setCounts, offsets[dataset], kmers[dataset],
+          counts[dataset]);
+    }
+    else
+    {
+      Flatten(setSubstrings, setCounts, offsets[dataset], substrings[dataset],
+          counts[dataset]);
+    }
   }
 
   Log::Info << "Substring extraction complete." << std::endl;
 }
+
+std::vector<std::vector<std::map<std::string, int> > >
+PSpectrumStringKernel::Counts() const
+{
+  std::vector<std::vector<std::map<std::string, int> > > maps(offsets.size());
+  for (size_t dataset = 0; dataset < offsets.size(); ++dataset)
+  {
+    maps[dataset].resize(Strings(dataset));
+    for (size_t index = 0; index < Strings(dataset); ++index)
+    {
+      for (size_t k = offsets[dataset][index];
+          k < offsets[dataset][index + 1]; ++k)
+      {
+        std::string sub;
+        if (exactCodes)
+        {
+          // Decode the base 36 digits, from the last character to the first.
+          sub.resize(p);
+          boost::uint64_t code = kmers[dataset][k];
+          for (size_t j = p; j > 0; --j)
+          {
+            const int digit = (int) (code % 36);
+            sub[j - 1] = (digit < 10) ? ('0' + digit) : ('a' + digit - 10);
+            code /= 36;
+          }
+        }
+        else
+        {
+          sub = substrings[dataset][k];
+        }
+
+        maps[dataset][index][sub] = (int) counts[dataset][k];
+      }
+    }
+  }
+
+  return maps;
+}
+
+size_t PSpectrumStringKernel::Count(const size_t dataset,
+                                    const size_t index,
+                                    const std::string& substring) const
+{
+  if (substring.length() != p)
+    return 0;
+
+  boost::uint64_t code = 0;
+  std::string sub(substring);
+  for (size_t j = 0; j < p; ++j)
+  {
+    const int digit = Digit(substring[j]);
+    if (digit < 0)
+      return 0;
+    if (exactCodes)
+      code = code * 36 + digit;
+    sub[j] = tolower(sub[j]);
+  }
+
+  const size_t first = offsets[dataset][index];
+  const size_t last = offsets[dataset][index + 1];
+  if (exactCodes)
+  {
+    const std::vector<boost::uint64_t>::const_iterator begin =
+        kmers[dataset].begin() + first;
+    const std::vector<boost::uint64_t>::const_iterator end =
+        kmers[dataset].begin() + last;
+    const std::vector<boost::uint64_t>::const_iterator it =
+        std::lower_bound(begin, end, code);
+
+    if (it == end || *it != code)
+      return 0;
+    return counts[dataset][it - kmers[dataset].begin()];
+  }
+
+  const std::vector<std::string>::const_iterator begin =
+      substrings[dataset].begin() + first;
+  const std::vector<std::string>::const_iterator end =
+      substrings[dataset].begin() + last;
+  const std::vector<std::string>::const_iterator it =
+      std::lower_bound(begin, end, sub);
+
+  if (it == end || *it != sub)
+    return 0;
+  return counts[dataset][it - substrings[dataset].begin()];
+}
+
+int PSpectrumStringKernel::Digit(const char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A' + 10;
+  return -1;
+}
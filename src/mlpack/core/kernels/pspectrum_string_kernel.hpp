@@ -16,6 +16,7 @@
 #include <vector>
 
 #include <mlpack/core.hpp>
+#include <boost/cstdint.hpp>
 
 namespace mlpack {
 namespace kernel {
@@ -55,6 +56,14 @@ namespace kernel {
  * the data according to the fake data matrix -- resulting in a meaningless
  * tree.  This kernel was originally written for the FastMKS method; so, at the
  * very least, it will work with that.
+ *
+ * At construction, for p up to MaxCodeLength (12), every substring of length
+ * p is encoded as an integer (its characters, lowercased, are read as digits in
+ * base 36), with a rolling update as the window slides along the string; the
+ * codes are exact, since 36^12 < 2^64.  Longer substrings would not fit, so
+ * they are kept as (lowercased) strings instead.  The substrings of each
+ * string are kept sorted, with their counts, in flat arrays shared by all the
+ * strings of a dataset, so Evaluate() is a linear merge of two sorted arrays.
  */
 class PSpectrumStringKernel
 {
@@ -83,12 +92,47 @@ class PSpectrumStringKernel
   template<typename VecType>
   double Evaluate(const VecType& a, const VecType& b) const;
 
-  //! Access the lists of substrings.
-  const std::vector<std::vector<std::map<std::string, int> > >& Counts() const
-  { return counts; }
-  //! Modify the lists of substrings.
-  std::vector<std::vector<std::map<std::string, int> > >& Counts()
-  { return counts; }
+  /**
+   * Evaluate the kernel between the string given by a and each of the strings
+   * given by the columns of b, storing K(a, b_j) in kernels[j].  This is
+   * faster than calling Evaluate() for each column.
+   *
+   * @param a Index of dataset and string for the first string.
+   * @param b Indices of dataset and string, one column for each string.
+   * @param kernels Vector to store the kernel evaluations in.
+   */
+  template<typename VecType, typename MatType>
+  void Evaluate(const VecType& a, const MatType& b, arma::vec& kernels) const;
+
+  //! Get the number of datasets.
+  size_t Datasets() const { return offsets.size(); }
+  //! Get the number of strings in the given dataset.
+  size_t Strings(const size_t dataset) const
+  { return offsets[dataset].size() - 1; }
+  //! Get the number of distinct substrings of length p of the given string.
+  size_t Substrings(const size_t dataset, const size_t index) const
+  { return offsets[dataset][index + 1] - offsets[dataset][index]; }
+
+  /**
+   * Return the counts of the substrings of each string of each dataset, as a
+   * map from each (lowercased) substring to the number of times it appears:
+   * Counts()[d][i] holds the substrings of string i of dataset d.  The maps
+   * are built on each call, so Count() is much faster for single lookups.
+   */
+  std::vector<std::vector<std::map<std::string, int> > > Counts() const;
+
+  /**
+   * Return the number of times the given substring (of length p) appears in
+   * the given string, ignoring case.  Substrings of the wrong length, or with
+   * characters that are not alphanumeric, appear zero times.
+   *
+   * @param dataset Index of the dataset.
+   * @param index Index of the string in the dataset.
+   * @param substring Substring to count.
+   */
+  size_t Count(const size_t dataset,
+               const size_t index,
+               const std::string& substring) const;
 
   //! Access the value of p.
   size_t P() const { return p; }
@@ -113,12 +157,44 @@ class PSpectrumStringKernel
   //! The datasets.
   const std::vector<std::vector<std::string> >& datasets;
 
-  //! Mappings of the datasets to counts of substrings.  Such a huge structure
-  //! is not wonderful...
-  std::vector<std::vector<std::map<std::string, int> > > counts;
+  //! For each dataset, where the substrings of each string begin in kmers and
+  //! counts (the substrings of string i are at offsets[i] to offsets[i + 1]).
+  std::vector<std::vector<size_t> > offsets;
+  //! For each dataset, the codes of the substrings of each string, sorted.
+  std::vector<std::vector<boost::uint64_t> > kmers;
+  //! For each dataset, the number of times each substring appears.
+  std::vector<std::vector<size_t> > counts;
+
+  //! For each dataset, the substrings of each string, sorted, if they are too
+  //! long to be encoded as integers.
+  std::vector<std::vector<std::string> > substrings;
 
   //! The value of p to use in calculation.
   size_t p;
+  //! Whether the substrings are encoded as integers (p <= MaxCodeLength).
+  bool exactCodes;
+
+  //! The longest substrings whose base 36 codes fit in 64 bits.
+  static const size_t MaxCodeLength = 12;
+
+  //! Return the kernel between string i of dataset d and string j of dataset
+  //! e, by merging their sorted substrings.
+  double Merge(const size_t d, const size_t i, const size_t e, const size_t j)
+      const;
+
+  //! Return the kernel between two sorted lists of substrings (of either
+  //! representation) with the given counts.
+  template<typename KeyType>
+  static double MergeSorted(const KeyType* aKeys,
+                            const KeyType* aEnd,
+                            const size_t* aCounts,
+                            const KeyType* bKeys,
+                            const KeyType* bEnd,
+                            const size_t* bCounts);
+
+  //! Return the base 36 digit of the given character (ignoring case), or -1 if
+  //! it is not alphanumeric.
+  static int Digit(const char c);
 };
 
 }; // namespace kernel
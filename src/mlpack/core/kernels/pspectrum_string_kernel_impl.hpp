@@ -31,44 +31,91 @@ template<typename VecType>
 double PSpectrumStringKernel::Evaluate(const VecType& a,
                                        const VecType& b) const
 {
-  // Get the map of substrings for the two strings we are interested in.
-  const std::map<std::string, int>& aMap = counts[a[0]][a[1]];
-  const std::map<std::string, int>& bMap = counts[b[0]][b[1]];
+  return Merge((size_t) a[0], (size_t) a[1], (size_t) b[0], (size_t) b[1]);
+}
 
-  double eval = 0;
+/**
+ * Evaluate the kernel between the string given by a and each of the strings
+ * given by the columns of b, storing K(a, b_j) in kernels[j].
+ *
+ * @param a Index of dataset and string for the first string.
+ * @param b Indices of dataset and string, one column for each string.
+ * @param kernels Vector to store the kernel evaluations in.
+ */
+template<typename VecType, typename MatType>
+void PSpectrumStringKernel::Evaluate(const VecType& a,
+                                     const MatType& b,
+                                     arma::vec& kernels) const
+{
+  const size_t d = (size_t) a[0];
+  const size_t i = (size_t) a[1];
+
+  kernels.set_size(b.n_cols);
+  for (size_t j = 0; j < b.n_cols; ++j)
+    kernels[j] = Merge(d, i, (size_t) b(0, j), (size_t) b(1, j));
+}
 
-  // Loop through the two maps (which, when iterated through, are sorted
-  // alphabetically).
-  std::map<std::string, int>::const_iterator aIt = aMap.begin();
-  std::map<std::string, int>::const_iterator bIt = bMap.begin();
+inline double PSpectrumStringKernel::Merge(const size_t d,
+                                           const size_t i,
+                                           const size_t e,
+                                           const size_t j) const
+{
+  const size_t aBegin = offsets[d][i];
+  const size_t aLast = offsets[d][i + 1];
+  const size_t bBegin = offsets[e][j];
+  const size_t bLast = offsets[e][j + 1];
+  if ((aBegin == aLast) || (bBegin == bLast))
+    return 0.0; // One of the strings has no substrings.
 
-  while ((aIt != aMap.end()) && (bIt != bMap.end()))
+  if (exactCodes)
   {
-    // Compare alphabetically (this is how std::map is ordered).
-    int result = (*aIt).first.compare((*bIt).first);
+    return MergeSorted(&kmers[d][0] + aBegin, &kmers[d][0] + aLast,
+        &counts[d][aBegin], &kmers[e][0] + bBegin, &kmers[e][0] + bLast,
+        &counts[e][bBegin]);
+  }
 
-    if (result == 0) // The same substring.
-    {
-      eval += ((*aIt).second * (*bIt).second);
+  return MergeSorted(&substrings[d][0] + aBegin, &substrings[d][0] + aLast,
+      &counts[d][aBegin], &substrings[e][0] + bBegin,
+      &substrings[e][0] + bLast, &counts[e][bBegin]);
+}
 
-      // Now increment both.
-      ++aIt;
-      ++bIt;
+template<typename KeyType>
+double PSpectrumStringKernel::MergeSorted(const KeyType* aKeys,
+                                          const KeyType* aEnd,
+                                          const size_t* aCounts,
+                                          const KeyType* bKeys,
+                                          const KeyType* bEnd,
+                                          const size_t* bCounts)
+{
+  // Both lists of substrings are sorted, so walk through them together.
+  double eval = 0;
+  while ((aKeys != aEnd) && (bKeys != bEnd))
+  {
+    if (*aKeys == *bKeys) // The same substring.
+    {
+      eval += (double) (*aCounts) * (double) (*bCounts);
+      ++aKeys;
+      ++aCounts;
+      ++bKeys;
+      ++bCounts;
     }
-    else if (result > 0)
+    else if (*bKeys < *aKeys)
     {
-      // aIt is "ahead" of bIt (alphabetically); so increment bIt to "catch up".
-      ++bIt;
+      // aKeys is "ahead" of bKeys; so increment bKeys to "catch up".
+      ++bKeys;
+      ++bCounts;
     }
     else
     {
-      // bIt is "ahead" of aIt (alphabetically); so increment aIt to "catch up".
-      ++aIt;
+      // bKeys is "ahead" of aKeys; so increment aKeys to "catch up".
+      ++aKeys;
+      ++aCounts;
     }
   }
 
   return eval;
 }
+
 }; // namespace kernel
 }; // namespace mlpack
 
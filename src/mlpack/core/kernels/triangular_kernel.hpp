@@ -7,6 +7,7 @@
 #ifndef __MLPACK_CORE_KERNELS_TRIANGULAR_KERNEL_HPP
 #define __MLPACK_CORE_KERNELS_TRIANGULAR_KERNEL_HPP
 
+#include <boost/math/special_functions/gamma.hpp>
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 
@@ -53,7 +54,21 @@ class TriangularKernel
    */
   double Evaluate(const double distance) const
   {
-    return std::max(0.0, (1 - distance) / bandwidth);
+    return std::max(0.0, 1 - distance / bandwidth);
+  }
+
+  /**
+   * Compute the normalizer of the triangular kernel for the given dimension;
+   * that is, the integral of the kernel over the whole space, which is the
+   * volume of the ball of radius equal to the bandwidth divided by
+   * (dimension + 1).
+   *
+   * @param dimension Dimension to calculate the normalizer for.
+   */
+  double Normalizer(const size_t dimension) const
+  {
+    return pow(bandwidth, (double) dimension) * pow(M_PI, dimension / 2.0) /
+        (boost::math::tgamma(dimension / 2.0 + 1.0) * (dimension + 1.0));
   }
 
   //! Get the bandwidth of the kernel.
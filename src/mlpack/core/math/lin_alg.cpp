@@ -35,11 +35,98 @@ void mlpack::math::VectorPower(arma::vec& vec, const double power)
  * @param xCentered Matrix to write centered output into
  */
 void mlpack::math::Center(const arma::mat& x, arma::mat& xCentered)
+{
+  // Only one copy is made, and none at all if the matrices are the same.
+  if (&x != &xCentered)
+    xCentered = x;
+
+  Center(xCentered);
+}
+
+/**
+ * Centers a matrix in-place, by subtracting the mean of the columns from each
+ * column.
+ *
+ * @param x Matrix to center.
+ */
+void mlpack::math::Center(arma::mat& x)
 {
   // Get the mean of the elements in each row.
-  arma::vec rowMean = arma::sum(x, 1) / x.n_cols;
+  const arma::vec rowMean = arma::sum(x, 1) / x.n_cols;
 
-  xCentered = x - arma::repmat(rowMean, 1, x.n_cols);
+  #pragma omp parallel for
+  for (size_t i = 0; i < x.n_cols; ++i)
+    x.col(i) -= rowMean;
+}
+
+/**
+ * Computes the covariance matrix and the mean of the columns of a matrix,
+ * accumulating the outer products of blocks of columns in parallel.
+ */
+void mlpack::math::Covariance(const arma::mat& x,
+                              arma::mat& covariance,
+                              arma::vec& mean,
+                              const bool twoPass)
+{
+  const size_t blockSize = 1024;
+  const size_t blocks = (x.n_cols + blockSize - 1) / blockSize;
+
+  mean.zeros(x.n_rows);
+  if (twoPass && x.n_cols > 0)
+    mean = arma::sum(x, 1) / x.n_cols;
+
+  // The sums and outer products of the (centered, with twoPass) points.
+  arma::mat products(x.n_rows, x.n_rows);
+  products.zeros();
+  arma::vec sums(x.n_rows);
+  sums.zeros();
+
+  #pragma omp parallel
+  {
+    arma::mat threadProducts(x.n_rows, x.n_rows);
+    threadProducts.zeros();
+    arma::vec threadSums(x.n_rows);
+    threadSums.zeros();
+
+    #pragma omp for schedule(static)
+    for (size_t b = 0; b < blocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t) x.n_cols);
+
+      if (twoPass)
+      {
+        arma::mat block = x.cols(begin, end - 1);
+        block.each_col() -= mean;
+        threadProducts += block * arma::trans(block);
+        threadSums += arma::sum(block, 1);
+      }
+      else
+      {
+        threadProducts += x.cols(begin, end - 1) *
+            arma::trans(x.cols(begin, end - 1));
+        threadSums += arma::sum(x.cols(begin, end - 1), 1);
+      }
+    }
+
+    #pragma omp critical
+    {
+      products += threadProducts;
+      sums += threadSums;
+    }
+  }
+
+  if (x.n_cols == 0)
+  {
+    covariance.zeros(x.n_rows, x.n_rows);
+    return;
+  }
+
+  // With twoPass the sums are (nearly) zero, and this corrects for the
+  // rounding error in the mean.
+  const double norm = (x.n_cols > 1) ? (x.n_cols - 1) : 1;
+  covariance = (products - sums * arma::trans(sums) / x.n_cols) / norm;
+  mean += sums / x.n_cols;
 }
 
 /**
@@ -52,9 +139,9 @@ void mlpack::math::WhitenUsingSVD(const arma::mat& x,
                                   arma::mat& whiteningMatrix)
 {
   arma::mat covX, u, v, invSMatrix, temp1;
-  arma::vec sVector;
+  arma::vec sVector, mean;
 
-  covX = ccov(x);
+  Covariance(x, covX, mean);
 
   svd(u, sVector, v, covX);
 
@@ -75,11 +162,12 @@ void mlpack::math::WhitenUsingEig(const arma::mat& x,
                                   arma::mat& xWhitened,
                                   arma::mat& whiteningMatrix)
 {
-  arma::mat diag, eigenvectors;
-  arma::vec eigenvalues;
+  arma::mat diag, eigenvectors, covX;
+  arma::vec eigenvalues, mean;
 
   // Get eigenvectors of covariance of input matrix.
-  eig_sym(eigenvalues, eigenvectors, ccov(x));
+  Covariance(x, covX, mean);
+  eig_sym(eigenvalues, eigenvectors, covX);
 
   // Generate diagonal matrix using 1 / sqrt(eigenvalues) for each value.
   VectorPower(eigenvalues, -0.5);
@@ -127,9 +215,10 @@ void mlpack::math::Orthogonalize(const arma::mat& x, arma::mat& W)
 {
   // For a matrix A, A^N = V * D^N * V', where VDV' is the
   // eigendecomposition of the matrix A.
-  arma::mat eigenvalues, eigenvectors;
-  arma::vec egval;
-  eig_sym(egval, eigenvectors, ccov(x));
+  arma::mat eigenvalues, eigenvectors, covX;
+  arma::vec egval, mean;
+  Covariance(x, covX, mean);
+  eig_sym(egval, eigenvectors, covX);
   VectorPower(egval, -0.5);
 
   eigenvalues.zeros(egval.n_elem, egval.n_elem);
@@ -208,3 +297,27 @@ void mlpack::math::RemoveRows(const arma::mat& input,
     }
   }
 }
+
+void mlpack::math::SparseFromColumns(
+    const std::vector<std::vector<std::pair<size_t, double> > >& columns,
+    const size_t rows,
+    arma::sp_mat& output)
+{
+  arma::uvec colPointers(columns.size() + 1);
+  colPointers[0] = 0;
+  for (size_t i = 0; i < columns.size(); ++i)
+    colPointers[i + 1] = colPointers[i] + columns[i].size();
+
+  arma::uvec rowIndices(colPointers[columns.size()]);
+  arma::vec values(colPointers[columns.size()]);
+  for (size_t i = 0; i < columns.size(); ++i)
+  {
+    for (size_t j = 0; j < columns[i].size(); ++j)
+    {
+      rowIndices[colPointers[i] + j] = columns[i][j].first;
+      values[colPointers[i] + j] = columns[i][j].second;
+    }
+  }
+
+  output = arma::sp_mat(rowIndices, colPointers, values, rows, columns.size());
+}
@@ -31,6 +31,36 @@ void VectorPower(arma::vec& vec, const double power);
  */
 void Center(const arma::mat& x, arma::mat& xCentered);
 
+/**
+ * Centers a matrix in-place, by subtracting the mean of the columns from each
+ * column, without making a copy of the matrix.
+ *
+ * @param x Matrix to center.
+ */
+void Center(arma::mat& x);
+
+/**
+ * Computes the covariance matrix (normalized by N - 1, as ccov() does) and the
+ * mean of the columns of a matrix, without making a centered copy of it.  The
+ * columns are taken in blocks, in parallel, and each block's outer product is
+ * accumulated into the result.
+ *
+ * In one pass, the sums and outer products of the raw points are accumulated,
+ * so the data is read only once; this can lose precision when the mean is
+ * large compared to the spread of the data.  With twoPass, the mean is
+ * computed first and the outer products of the centered points of each block
+ * are accumulated, which is numerically stable.
+ *
+ * @param x Input matrix (one point per column).
+ * @param covariance Matrix to store the covariance in.
+ * @param mean Vector to store the mean of the columns in.
+ * @param twoPass Whether or not to center the points before accumulating.
+ */
+void Covariance(const arma::mat& x,
+                arma::mat& covariance,
+                arma::vec& mean,
+                const bool twoPass = false);
+
 /**
  * Whitens a matrix using the singular value decomposition of the covariance
  * matrix. Whitening means the covariance matrix of the result is the identity
@@ -76,6 +106,21 @@ void RemoveRows(const arma::mat& input,
                 const std::vector<size_t>& rowsToRemove,
                 arma::mat& output);
 
+/**
+ * Build a sparse matrix from the nonzero elements of each of its columns, given
+ * as (row, value) pairs in increasing order of row, as when the columns are
+ * computed separately (and in parallel).  The matrix is assembled directly in
+ * compressed sparse column form.
+ *
+ * @param columns Nonzero elements of each column.
+ * @param rows Number of rows of the matrix.
+ * @param output Matrix to store the result in.
+ */
+void SparseFromColumns(
+    const std::vector<std::vector<std::pair<size_t, double> > >& columns,
+    const size_t rows,
+    arma::sp_mat& output);
+
 }; // namespace math
 }; // namespace mlpack
 
@@ -0,0 +1,70 @@
+/**
+ * @file power.hpp
+ *
+ * Compile-time integer powers and roots, used in the inner loops of the
+ * distance calculations, where a call to pow() for every dimension would
+ * dominate the cost and keep the compiler from vectorizing the loop.
+ */
+#ifndef __MLPACK_CORE_MATH_POWER_HPP
+#define __MLPACK_CORE_MATH_POWER_HPP
+
+#include <math.h>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * Computes x^Power and x^(1 / Power) for a positive integer Power known at
+ * compile time.  The power is computed by repeated squaring, so it is only a
+ * few multiplications; the root is sqrt() when Power is 2.
+ *
+ * @tparam Power Power to use; this must be positive.
+ */
+template<int Power>
+struct IntPower
+{
+  //! Return x^Power.
+  static double Pow(const double x)
+  {
+    const double half = IntPower<Power / 2>::Pow(x);
+    return (Power % 2 == 0) ? half * half : half * half * x;
+  }
+
+  //! Return x^(1 / Power).
+  static double Root(const double x) { return pow(x, 1.0 / (double) Power); }
+};
+
+//! The recursion ends here.
+template<>
+struct IntPower<1>
+{
+  static double Pow(const double x) { return x; }
+  static double Root(const double x) { return x; }
+};
+
+//! The square root is much faster than pow().
+template<>
+struct IntPower<2>
+{
+  static double Pow(const double x) { return x * x; }
+  static double Root(const double x) { return sqrt(x); }
+};
+
+//! Return x^Power, for a positive integer Power known at compile time.
+template<int Power>
+inline double IntPow(const double x)
+{
+  return IntPower<Power>::Pow(x);
+}
+
+//! Return x^(1 / Power), for a positive integer Power known at compile time.
+template<int Power>
+inline double IntRoot(const double x)
+{
+  return IntPower<Power>::Root(x);
+}
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
@@ -1,10 +1,12 @@
 /**
  * @file random.cpp
  *
- * Declarations of global Boost random number generators.
+ * Declarations of global Boost random number generators, and the random number
+ * streams of the threads.
  */
-#include <boost/random.hpp>
-#include <boost/version.hpp>
+#include "random.hpp"
+
+#include <map>
 
 namespace mlpack {
 namespace math {
@@ -32,5 +34,74 @@ namespace math {
   boost::normal_distribution<> randNormalDist;
 #endif
 
+namespace {
+
+//! Get the number of streams to create: one for each possible thread.
+size_t DefaultStreams()
+{
+#ifdef HAS_OPENMP
+  return (size_t) std::max(1, std::max(omp_get_max_threads(),
+      omp_get_num_procs()));
+#else
+  return 1;
+#endif
+}
+
+//! Create one stream for each possible thread, split from the seed 0.
+std::vector<RandomStream> DefaultThreadStreams()
+{
+  std::vector<RandomStream> streams(DefaultStreams());
+  for (size_t i = 0; i < streams.size(); ++i)
+    streams[i].Seed(RandomStream::StreamSeed(0, i));
+
+  return streams;
+}
+
+//! The master seed of the streams of the threads.
+size_t streamSeed = 0;
+
+//! The random number streams of the threads, by thread number.
+std::vector<RandomStream> threadStreams(DefaultThreadStreams());
+
+//! The streams of any threads numbered beyond the end of threadStreams.
+std::map<size_t, RandomStream> extraStreams;
+
+} // anonymous namespace
+
+RandomStream& ThreadStream()
+{
+  size_t thread = 0;
+#ifdef HAS_OPENMP
+  thread = (size_t) omp_get_thread_num();
+#endif
+
+  if (thread < threadStreams.size())
+    return threadStreams[thread];
+
+  // There are more threads than there were when the streams were seeded (if
+  // omp_set_num_threads() was called afterwards); each extra thread gets its
+  // own stream, which no other thread touches once it has been created.
+  RandomStream* stream;
+  #pragma omp critical(mlpack_math_extra_streams)
+  {
+    std::map<size_t, RandomStream>::iterator it = extraStreams.find(thread);
+    if (it == extraStreams.end())
+      it = extraStreams.insert(std::make_pair(thread, RandomStream(
+          RandomStream::StreamSeed(streamSeed, thread)))).first;
+    stream = &it->second;
+  }
+
+  return *stream;
+}
+
+void SeedThreadStreams(const size_t seed)
+{
+  streamSeed = seed;
+  threadStreams.resize(std::max(threadStreams.size(), DefaultStreams()));
+  for (size_t i = 0; i < threadStreams.size(); ++i)
+    threadStreams[i].Seed(RandomStream::StreamSeed(seed, i));
+  extraStreams.clear();
+}
+
 }; // namespace math
 }; // namespace mlpack
@@ -9,6 +9,12 @@
 #include <mlpack/prereqs.hpp>
 #include <boost/random.hpp>
 
+#include "random_stream.hpp"
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace math /** Miscellaneous math routines. */ {
 
@@ -38,16 +44,39 @@ namespace math /** Miscellaneous math routines. */ {
   extern boost::normal_distribution<> randNormalDist;
 #endif
 
+/**
+ * Get the random number stream of the calling OpenMP thread.  Inside a parallel
+ * region, Random(), RandInt() and RandNormal() draw from this stream instead of
+ * the global generator, so they can be called from any number of threads at
+ * once; outside a parallel region (including a region which is inactive
+ * because of an if() clause) they draw from the global generator, exactly as in
+ * serial code.  The streams are split from the seed given to RandomSeed(), with
+ * RandomStream::StreamSeed(), so with the same seed, the same number of threads
+ * and a static schedule, a parallel region draws the same numbers in each run.
+ * Nested parallel regions are not supported.
+ */
+RandomStream& ThreadStream();
+
+/**
+ * Reseed the random number streams of the threads, splitting them from the
+ * given seed.  This is called by RandomSeed().
+ *
+ * @param seed Master seed for the streams.
+ */
+void SeedThreadStreams(const size_t seed);
+
 /**
  * Set the random seed used by the random functions (Random() and RandInt()).
  * The seed is casted to a 32-bit integer before being given to the random
  * number generator, but a size_t is taken as a parameter for API consistency.
+ * The random number streams of the threads are reseeded too.
  *
  * @param seed Seed for the random number generator.
  */
 inline void RandomSeed(const size_t seed)
 {
   randGen.seed((uint32_t) seed);
+  SeedThreadStreams(seed);
   srand((unsigned int) seed);
 #if ARMA_VERSION_MAJOR > 3 || \
     (ARMA_VERSION_MAJOR == 3 && ARMA_VERSION_MINOR >= 930)
@@ -62,6 +91,11 @@ inline void RandomSeed(const size_t seed)
  */
 inline double Random()
 {
+#ifdef HAS_OPENMP
+  if (omp_in_parallel())
+    return ThreadStream().Random();
+#endif
+
 #if BOOST_VERSION >= 103900
   return randUniformDist(randGen);
 #else
@@ -76,6 +110,11 @@ inline double Random()
  */
 inline double Random(const double lo, const double hi)
 {
+#ifdef HAS_OPENMP
+  if (omp_in_parallel())
+    return ThreadStream().Random(lo, hi);
+#endif
+
 #if BOOST_VERSION >= 103900
   return lo + (hi - lo) * randUniformDist(randGen);
 #else
@@ -90,6 +129,11 @@ inline double Random(const double lo, const double hi)
  */
 inline int RandInt(const int hiExclusive)
 {
+#ifdef HAS_OPENMP
+  if (omp_in_parallel())
+    return ThreadStream().RandInt(hiExclusive);
+#endif
+
 #if BOOST_VERSION >= 103900
   return (int) std::floor((double) hiExclusive * randUniformDist(randGen));
 #else
@@ -104,6 +148,11 @@ inline int RandInt(const int hiExclusive)
  */
 inline int RandInt(const int lo, const int hiExclusive)
 {
+#ifdef HAS_OPENMP
+  if (omp_in_parallel())
+    return ThreadStream().RandInt(lo, hiExclusive);
+#endif
+
 #if BOOST_VERSION >= 103900
   return lo + (int) std::floor((double) (hiExclusive - lo)
                                * randUniformDist(randGen));
@@ -121,6 +170,11 @@ inline int RandInt(const int lo, const int hiExclusive)
  */
 inline double RandNormal()
 {
+#ifdef HAS_OPENMP
+  if (omp_in_parallel())
+    return ThreadStream().RandNormal();
+#endif
+
   return randNormalDist(randGen);
 }
 
@@ -133,9 +187,56 @@ inline double RandNormal()
  */
 inline double RandNormal(const double mean, const double variance)
 {
+#ifdef HAS_OPENMP
+  if (omp_in_parallel())
+    return ThreadStream().RandNormal(mean, variance);
+#endif
+
   return variance * randNormalDist(randGen) + mean;
 }
 
+/**
+ * Fill the given matrix (or vector) with uniform random numbers between 0 and
+ * 1, drawn from the same generator as Random().
+ *
+ * @param values Matrix to fill (its size is not changed).
+ */
+inline void Random(arma::mat& values)
+{
+#ifdef HAS_OPENMP
+  if (omp_in_parallel())
+  {
+    ThreadStream().Random(values);
+    return;
+  }
+#endif
+
+  double* memory = values.memptr();
+  for (size_t i = 0; i < values.n_elem; ++i)
+    memory[i] = Random();
+}
+
+/**
+ * Fill the given matrix (or vector) with normally distributed random numbers
+ * with mean 0 and variance 1, drawn from the same generator as RandNormal().
+ *
+ * @param values Matrix to fill (its size is not changed).
+ */
+inline void RandNormal(arma::mat& values)
+{
+#ifdef HAS_OPENMP
+  if (omp_in_parallel())
+  {
+    ThreadStream().RandNormal(values);
+    return;
+  }
+#endif
+
+  double* memory = values.memptr();
+  for (size_t i = 0; i < values.n_elem; ++i)
+    memory[i] = randNormalDist(randGen);
+}
+
 }; // namespace math
 }; // namespace mlpack
 
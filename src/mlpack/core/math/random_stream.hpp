@@ -0,0 +1,145 @@
+/**
+ * @file random_stream.hpp
+ *
+ * An independent stream of random numbers, for code which draws random numbers
+ * from more than one thread.
+ */
+#ifndef __MLPACK_CORE_MATH_RANDOM_STREAM_HPP
+#define __MLPACK_CORE_MATH_RANDOM_STREAM_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <boost/random.hpp>
+#include <boost/version.hpp>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * A RandomStream owns its own Mersenne twister, so each thread can draw from
+ * its own stream without locking and without racing with the other threads.
+ * The streams of a set of threads are split deterministically from one master
+ * seed with StreamSeed(), so the numbers drawn by each stream depend only on
+ * the master seed and the index of the stream.
+ *
+ * Inside an OpenMP parallel region, math::Random(), math::RandInt() and
+ * math::RandNormal() already draw from the stream of the calling thread (see
+ * math::ThreadStream()); a RandomStream can also be used directly, when the
+ * numbers should not depend on which thread does the work:
+ *
+ * @code
+ * #pragma omp parallel for
+ * for (size_t i = 0; i < tasks; ++i)
+ * {
+ *   RandomStream stream(RandomStream::StreamSeed(seed, i));
+ *   arma::vec noise(100);
+ *   stream.RandNormal(noise);
+ *   ...
+ * }
+ * @endcode
+ */
+class RandomStream
+{
+ public:
+  /**
+   * Create the stream with the given seed.  The seed is cast to a 32-bit
+   * integer, as in math::RandomSeed().
+   *
+   * @param seed Seed for the random number generator.
+   */
+  RandomStream(const size_t seed = 0) : generator((uint32_t) seed) { }
+
+  //! Reset the stream with the given seed.
+  void Seed(const size_t seed)
+  {
+    generator.seed((uint32_t) seed);
+    normalDist.reset();
+  }
+
+  /**
+   * Get the seed of the given stream split from the given master seed.  The
+   * master seed and the stream index are mixed with the SplitMix64 finalizer,
+   * so nearby seeds and stream indices give unrelated streams.
+   *
+   * @param seed Master seed.
+   * @param stream Index of the stream.
+   */
+  static size_t StreamSeed(const size_t seed, const size_t stream)
+  {
+    boost::uint64_t z = (boost::uint64_t) seed +
+        ((boost::uint64_t) stream + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (size_t) ((z ^ (z >> 31)) & 0xFFFFFFFFULL);
+  }
+
+  //! Generate a uniform random number between 0 and 1.
+  double Random() { return generator() / 4294967296.0; }
+
+  //! Generate a uniform random number in the specified range.
+  double Random(const double lo, const double hi)
+  {
+    return lo + (hi - lo) * Random();
+  }
+
+  //! Generate a uniform random integer in [0, hiExclusive).
+  int RandInt(const int hiExclusive)
+  {
+    return (int) std::floor((double) hiExclusive * Random());
+  }
+
+  //! Generate a uniform random integer in [lo, hiExclusive).
+  int RandInt(const int lo, const int hiExclusive)
+  {
+    return lo + (int) std::floor((double) (hiExclusive - lo) * Random());
+  }
+
+  //! Generate a normally distributed random number with mean 0 and variance 1.
+  double RandNormal() { return normalDist(generator); }
+
+  /**
+   * Generate a normally distributed random number with the specified mean and
+   * variance (which, as in math::RandNormal(), scales the standard normal).
+   */
+  double RandNormal(const double mean, const double variance)
+  {
+    return variance * normalDist(generator) + mean;
+  }
+
+  /**
+   * Fill the given matrix (or vector) with uniform random numbers between 0
+   * and 1.  This is the same as calling Random() for each element, without the
+   * copy of arma::randu().
+   */
+  void Random(arma::mat& values)
+  {
+    double* memory = values.memptr();
+    for (size_t i = 0; i < values.n_elem; ++i)
+      memory[i] = generator() / 4294967296.0;
+  }
+
+  //! Fill the given matrix (or vector) with standard normal random numbers.
+  void RandNormal(arma::mat& values)
+  {
+    double* memory = values.memptr();
+    for (size_t i = 0; i < values.n_elem; ++i)
+      memory[i] = normalDist(generator);
+  }
+
+ private:
+#if BOOST_VERSION >= 104700
+  //! The random number generator of the stream.
+  boost::random::mt19937 generator;
+  //! The normal distribution, which keeps the second number of each pair.
+  boost::random::normal_distribution<> normalDist;
+#else
+  //! The random number generator of the stream.
+  boost::mt19937 generator;
+  //! The normal distribution, which keeps the second number of each pair.
+  boost::normal_distribution<> normalDist;
+#endif
+};
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
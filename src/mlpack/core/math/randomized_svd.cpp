@@ -0,0 +1,48 @@
+/**
+ * @file randomized_svd.cpp
+ *
+ * Implementation of the randomized singular value decomposition.
+ */
+#include "randomized_svd.hpp"
+#include <mlpack/core/util/log.hpp>
+
+using namespace mlpack;
+
+void mlpack::math::RandomizedSVD(const arma::mat& data,
+                                 const size_t rank,
+                                 arma::mat& u,
+                                 arma::vec& s,
+                                 arma::mat& v,
+                                 const size_t powerIterations,
+                                 const size_t oversampling)
+{
+  const size_t minDimension = std::min(data.n_rows, data.n_cols);
+  if (rank == 0 || rank > minDimension)
+    Log::Fatal << "RandomizedSVD(): rank (" << rank << ") must be between 1 "
+        << "and the smaller dimension of the matrix (" << minDimension << ")!"
+        << std::endl;
+
+  const size_t samples = std::min(rank + oversampling, minDimension);
+
+  // Sample the range of the matrix, and orthonormalize the samples.
+  arma::mat q, r, z;
+  arma::qr_econ(q, r, data * arma::randn<arma::mat>(data.n_cols, samples));
+
+  // Each power iteration multiplies by A A^T; the basis is orthonormalized
+  // after each product, so the small singular values aren't lost to rounding.
+  for (size_t i = 0; i < powerIterations; ++i)
+  {
+    arma::qr_econ(z, r, arma::trans(data) * q);
+    arma::qr_econ(q, r, data * z);
+  }
+
+  // The SVD of the projection Q^T A (which is small) gives the singular values
+  // and the right singular vectors; the left singular vectors are mapped back
+  // by Q.
+  arma::mat ub;
+  arma::svd_econ(ub, s, v, arma::trans(q) * data);
+
+  u = q * ub.cols(0, rank - 1);
+  s = s.subvec(0, rank - 1);
+  v = v.cols(0, rank - 1);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file randomized_svd.hpp
+ *
+ * A randomized singular value decomposition, which computes the leading
+ * singular vectors of a matrix much faster than a full SVD.
+ */
+#ifndef __MLPACK_CORE_MATH_RANDOMIZED_SVD_HPP
+#define __MLPACK_CORE_MATH_RANDOMIZED_SVD_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * Compute the rank leading singular values and vectors of the given matrix A,
+ * with the randomized range finder of 'Finding Structure with Randomness:
+ * Probabilistic Algorithms for Constructing Approximate Matrix Decompositions'
+ * by N. Halko, P. G. Martinsson and J. A. Tropp.  The range of A is sampled
+ * with a Gaussian test matrix of (rank + oversampling) columns, and refined
+ * with the given number of power iterations (which make the approximation
+ * much more accurate when the singular values decay slowly); the SVD of A
+ * projected onto an orthonormal basis Q of the sampled range then gives the
+ * approximate factorization A ~= U diag(s) V^T.
+ *
+ * For an m x n matrix, each power iteration costs two products of A with an
+ * (m or n) x (rank + oversampling) matrix, so the cost is O(m n rank), instead
+ * of the O(m n min(m, n)) of a full SVD.  The results are random; the seed is
+ * set with math::RandomSeed().
+ *
+ * @param data Matrix to decompose.
+ * @param rank Number of singular values and vectors to compute.
+ * @param u Matrix to store the rank left singular vectors in.
+ * @param s Vector to store the rank largest singular values in (in decreasing
+ *     order).
+ * @param v Matrix to store the rank right singular vectors in.
+ * @param powerIterations Number of power iterations.
+ * @param oversampling Number of extra columns of the test matrix.
+ */
+void RandomizedSVD(const arma::mat& data,
+                   const size_t rank,
+                   arma::mat& u,
+                   arma::vec& s,
+                   arma::mat& v,
+                   const size_t powerIterations = 2,
+                   const size_t oversampling = 10);
+
+/**
+ * Return whether or not RandomizedSVD() should be used instead of a full SVD
+ * to find the rank leading singular vectors of a rows x cols matrix; this is
+ * the case when the sampled range is at most a quarter of the smaller
+ * dimension.
+ *
+ * @param rank Number of singular vectors needed.
+ * @param rows Number of rows of the matrix.
+ * @param cols Number of columns of the matrix.
+ * @param oversampling Number of extra columns of the test matrix.
+ */
+inline bool PreferRandomizedSVD(const size_t rank,
+                                const size_t rows,
+                                const size_t cols,
+                                const size_t oversampling = 10)
+{
+  return (4 * (rank + oversampling) <= std::min(rows, cols));
+}
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * @file block_distances.hpp
+ *
+ * Compute all of the distances between two blocks of points at once, for
+ * metrics where this can be done with a matrix multiplication.  This is used by
+ * the rules of the dual-tree algorithms when two leaves are compared.
+ */
+#ifndef __MLPACK_CORE_METRICS_BLOCK_DISTANCES_HPP
+#define __MLPACK_CORE_METRICS_BLOCK_DISTANCES_HPP
+
+#include <mlpack/core.hpp>
+#include "lmetric.hpp"
+
+namespace mlpack {
+namespace metric {
+
+/**
+ * Compute the distances between every point in a and every point in b.  Most
+ * metrics have no faster way to do this than one evaluation per pair, so this
+ * overload does nothing and returns false; the caller must then evaluate the
+ * distances one by one.
+ *
+ * @param metric Metric to use.
+ * @param a First block of points.
+ * @param b Second block of points.
+ * @param distances Matrix to store the distances in (unused).
+ * @return false, because the distances were not calculated.
+ */
+template<typename MetricType, typename MatType1, typename MatType2>
+bool BlockDistances(const MetricType& /* metric */,
+                    const MatType1& /* a */,
+                    const MatType2& /* b */,
+                    arma::mat& /* distances */)
+{
+  return false;
+}
+
+/**
+ * Compute the (squared, if TakeRoot is false) Euclidean distances between every
+ * point in a and every point in b, using ||a||^2 + ||b||^2 - 2 a^T b, so that
+ * most of the work is one matrix multiplication.  The distance between a(i)
+ * and b(j) is stored in distances(i, j).
+ *
+ * The expansion loses precision when two points are very close together
+ * relative to their norms, so those distances are recomputed directly.  For
+ * low-dimensional data the matrix multiplication is not worth it, so nothing is
+ * done and false is returned.  Single-precision points are converted to double
+ * precision first, so the results do not lose any more accuracy.
+ *
+ * @param metric Metric to use.
+ * @param a First block of points.
+ * @param b Second block of points.
+ * @param distances Matrix to store the distances in.
+ * @return true if the distances were calculated.
+ */
+template<bool TakeRoot, typename eT>
+bool BlockDistances(const LMetric<2, TakeRoot>& /* metric */,
+                    const arma::subview<eT>& a,
+                    const arma::subview<eT>& b,
+                    arma::mat& distances)
+{
+  if (a.n_rows < 8)
+    return false;
+
+  const arma::mat aMat(arma::conv_to<arma::mat>::from(a));
+  const arma::mat bMat(arma::conv_to<arma::mat>::from(b));
+  const arma::rowvec aNorms = arma::sum(arma::square(aMat), 0);
+  const arma::rowvec bNorms = arma::sum(arma::square(bMat), 0);
+
+  distances = -2.0 * arma::trans(aMat) * bMat;
+  for (size_t j = 0; j < bMat.n_cols; ++j)
+  {
+    for (size_t i = 0; i < aMat.n_cols; ++i)
+    {
+      const double normSum = aNorms[i] + bNorms[j];
+      double distance = distances(i, j) + normSum;
+      if (distance < 1e-5 * normSum)
+        distance = arma::accu(arma::square(aMat.unsafe_col(i) -
+            bMat.unsafe_col(j)));
+
+      distances(i, j) = (TakeRoot) ? sqrt(distance) : distance;
+    }
+  }
+
+  return true;
+}
+
+}; // namespace metric
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * @file fixed_lmetric.hpp
+ *
+ * An L-metric for points whose dimensionality is known at compile time, so
+ * that the loop over the dimensions can be unrolled, for low-dimensional data.
+ */
+#ifndef __MLPACK_CORE_METRICS_FIXED_LMETRIC_HPP
+#define __MLPACK_CORE_METRICS_FIXED_LMETRIC_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace metric {
+
+/**
+ * The L_p metric between two dense points with a dimensionality that is known
+ * at compile time, which gives the same results as LMetric<Power, TakeRoot>.
+ * LMetric loops over however many elements the points have; here the number of
+ * iterations is a constant, so for the common case of two- or
+ * three-dimensional data the compiler unrolls the loop and no Armadillo
+ * expressions are built.  The points may be any dense vector type (including
+ * columns of an arma::mat), as long as they have Dimensionality elements; this
+ * is not checked.
+ *
+ * Use this with FixedHRectBound<Dimensionality, Power, TakeRoot>, just as
+ * LMetric is used with HRectBound.
+ *
+ * @tparam Dimensionality Dimensionality of the points.
+ * @tparam Power Power of metric; i.e. Power = 1 gives the L1-norm (Manhattan
+ *    distance).
+ * @tparam TakeRoot If true, the Power'th root of the result is taken before it
+ *    is returned.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot = true>
+class FixedLMetric
+{
+ public:
+  /***
+   * Default constructor does nothing, but is required to satisfy the Kernel
+   * policy.
+   */
+  FixedLMetric() { }
+
+  /**
+   * Computes the distance between two points.
+   */
+  template<typename VecType1, typename VecType2>
+  static double Evaluate(const VecType1& a, const VecType2& b)
+  {
+    double sum = 0;
+    for (size_t i = 0; i < Dimensionality; ++i)
+    {
+      const double difference = fabs((double) a[i] - (double) b[i]);
+      if (Power == INT_MAX)
+        sum = std::max(sum, difference);
+      else
+        sum += math::IntPow<(Power == INT_MAX) ? 1 : Power>(difference);
+    }
+
+    // The compiler should optimize this correctly at compile-time.  The
+    // L-infinity distance has no root to take.
+    if (!TakeRoot || Power == INT_MAX)
+      return sum;
+
+    return math::IntRoot<(Power == INT_MAX) ? 1 : Power>(sum);
+  }
+
+  std::string ToString() const
+  {
+    std::ostringstream convert;
+    convert << "FixedLMetric [" << this << "]" << std::endl;
+    convert << "  Dimensionality: " << Dimensionality << std::endl;
+    convert << "  Power: " << Power << std::endl;
+    convert << "  TakeRoot: " << (TakeRoot ? "true" : "false") << std::endl;
+    return convert.str();
+  }
+};
+
+}; // namespace metric
+}; // namespace mlpack
+
+#endif
@@ -65,10 +65,35 @@ class LMetric
   LMetric() { }
 
   /**
-   * Computes the distance between two points.
+   * Computes the distance between two points.  If both points are sparse (for
+   * instance, columns of an arma::sp_mat), only their nonzero elements are
+   * visited.
    */
   template<typename VecType1, typename VecType2>
   static double Evaluate(const VecType1& a, const VecType2& b);
+
+  /**
+   * Computes the distance between two points, but gives up as soon as it is
+   * known to be greater than the given bound.  The sum is accumulated in
+   * blocks of dimensions (with independent partial sums, so the compiler can
+   * vectorize each block), and it is compared with the bound after each
+   * block.  This is useful when only distances up to a bound are of interest,
+   * such as the distance to the k'th nearest candidate in nearest neighbor
+   * search.
+   *
+   * If the distance is at most the bound, it is returned; otherwise, a value
+   * greater than the bound and no greater than the distance is returned.
+   * Sparse points are not abandoned early.
+   *
+   * @param a First point.
+   * @param b Second point.
+   * @param bound Bound on the distances of interest.
+   */
+  template<typename VecType1, typename VecType2>
+  static double EvaluateBounded(const VecType1& a,
+                                const VecType2& b,
+                                const double bound);
+
   std::string ToString() const;
 };
 
@@ -13,88 +13,234 @@
 namespace mlpack {
 namespace metric {
 
-// Unspecialized implementation.  This should almost never be used...
-template<int Power, bool TakeRoot>
-template<typename VecType1, typename VecType2>
-double LMetric<Power, TakeRoot>::Evaluate(const VecType1& a,
-                                             const VecType2& b)
+/**
+ * Computes the sum of |a_i - b_i|^Power over all dimensions (or the largest
+ * |a_i - b_i|, when Power is INT_MAX).  This is specialized below for the most
+ * common powers and for sparse points.
+ *
+ * @tparam Power Power of the metric.
+ * @tparam Sparse Whether or not both points are sparse.
+ */
+template<int Power, bool Sparse>
+struct LMetricSum
 {
-  double sum = 0;
-  for (size_t i = 0; i < a.n_elem; i++)
-    sum += pow(fabs(a[i] - b[i]), Power);
+  template<typename VecType1, typename VecType2>
+  static double Evaluate(const VecType1& a, const VecType2& b)
+  {
+    double sum = 0;
+    for (size_t i = 0; i < a.n_elem; i++)
+      sum += math::IntPow<Power>(fabs(a[i] - b[i]));
 
-  if (!TakeRoot) // The compiler should optimize this correctly at compile-time.
     return sum;
+  }
+};
 
-  return pow(sum, (1.0 / Power));
-}
-
-// String conversion.
-template<int Power, bool TakeRoot>
-std::string LMetric<Power, TakeRoot>::ToString() const
-{
-  std::ostringstream convert;
-  convert << "LMetric [" << this << "]" << std::endl;
-  convert << "  Power: " << Power << std::endl;
-  convert << "  TakeRoot: " << (TakeRoot ? "true" : "false") << std::endl;
-  return convert.str();
-}
-
-// L1-metric specializations; the root doesn't matter.
+// L1-metric specialization.
 template<>
-template<typename VecType1, typename VecType2>
-double LMetric<1, true>::Evaluate(const VecType1& a, const VecType2& b)
+struct LMetricSum<1, false>
 {
-  return accu(abs(a - b));
-}
-
+  template<typename VecType1, typename VecType2>
+  static double Evaluate(const VecType1& a, const VecType2& b)
+  {
+    return accu(abs(a - b));
+  }
+};
+
+// L2-metric specialization.
 template<>
-template<typename VecType1, typename VecType2>
-double LMetric<1, false>::Evaluate(const VecType1& a, const VecType2& b)
+struct LMetricSum<2, false>
 {
-  return accu(abs(a - b));
-}
-
-// L2-metric specializations.
+  template<typename VecType1, typename VecType2>
+  static double Evaluate(const VecType1& a, const VecType2& b)
+  {
+    return accu(square(a - b));
+  }
+};
+
+// L-infinity (Chebyshev distance) specialization.
 template<>
-template<typename VecType1, typename VecType2>
-double LMetric<2, true>::Evaluate(const VecType1& a, const VecType2& b)
+struct LMetricSum<INT_MAX, false>
 {
-  return sqrt(accu(square(a - b)));
-}
+  template<typename VecType1, typename VecType2>
+  static double Evaluate(const VecType1& a, const VecType2& b)
+  {
+    return arma::as_scalar(max(abs(a - b)));
+  }
+};
 
-template<>
-template<typename VecType1, typename VecType2>
-double LMetric<2, false>::Evaluate(const VecType1& a, const VecType2& b)
+/**
+ * For two sparse points, the nonzero elements of both are walked in order of
+ * dimension, so the cost depends only on the number of nonzero elements and
+ * no temporaries are allocated.  Dimensions where both points are zero add
+ * nothing to the sum.
+ */
+template<int Power>
+struct LMetricSum<Power, true>
 {
-  return accu(square(a - b));
-}
+  template<typename VecType1, typename VecType2>
+  static double Evaluate(const VecType1& a, const VecType2& b)
+  {
+    typename VecType1::const_iterator aIt = a.begin();
+    typename VecType2::const_iterator bIt = b.begin();
+    const typename VecType1::const_iterator aEnd = a.end();
+    const typename VecType2::const_iterator bEnd = b.end();
+
+    double sum = 0;
+    while (aIt != aEnd || bIt != bEnd)
+    {
+      double difference;
+      if (bIt == bEnd || (aIt != aEnd && aIt.row() < bIt.row()))
+      {
+        difference = fabs((double) *aIt);
+        ++aIt;
+      }
+      else if (aIt == aEnd || bIt.row() < aIt.row())
+      {
+        difference = fabs((double) *bIt);
+        ++bIt;
+      }
+      else
+      {
+        difference = fabs((double) *aIt - (double) *bIt);
+        ++aIt;
+        ++bIt;
+      }
+
+      if (Power == INT_MAX)
+        sum = std::max(sum, difference);
+      else
+        sum += math::IntPow<Power>(difference);
+    }
 
-// L3-metric specialization (not very likely to be used, but just in case).
-template<>
+    return sum;
+  }
+};
+
+template<int Power, bool TakeRoot>
 template<typename VecType1, typename VecType2>
-double LMetric<3, true>::Evaluate(const VecType1& a, const VecType2& b)
+double LMetric<Power, TakeRoot>::Evaluate(const VecType1& a,
+                                          const VecType2& b)
 {
-  double sum = 0;
-  for (size_t i = 0; i < a.n_elem; i++)
-    sum += pow(fabs(a[i] - b[i]), 3.0);
+  const double sum = LMetricSum<Power, IsSparse<VecType1>::value &&
+      IsSparse<VecType2>::value>::Evaluate(a, b);
 
-  return pow(accu(pow(abs(a - b), 3.0)), 1.0 / 3.0);
+  // The compiler should optimize this correctly at compile-time.  The
+  // L-infinity distance has no root to take.
+  if (!TakeRoot || Power == INT_MAX)
+    return sum;
+
+  return math::IntRoot<Power>(sum);
 }
 
-template<>
+/**
+ * Computes the L_p distance between two dense points, stopping after any block
+ * of dimensions once the distance is known to be greater than the bound.  The
+ * sums of the blocks are kept in four independent accumulators, which (unlike
+ * a single running sum) can be vectorized.
+ *
+ * @tparam Power Power of the metric.
+ * @tparam TakeRoot Whether or not the root of the sum is the distance.
+ * @tparam Sparse Whether or not both points are sparse.
+ */
+template<int Power, bool TakeRoot, bool Sparse>
+struct LMetricBounded
+{
+  //! Add the term for the given difference to the partial sum.
+  static double Add(const double sum, const double difference)
+  {
+    if (Power == INT_MAX)
+      return std::max(sum, fabs(difference));
+    else
+      return sum + math::IntPow<Power>(fabs(difference));
+  }
+
+  //! Combine two partial sums.
+  static double Combine(const double a, const double b)
+  {
+    return (Power == INT_MAX) ? std::max(a, b) : (a + b);
+  }
+
+  //! Turn the sum into a distance.
+  static double Distance(const double sum)
+  {
+    if (!TakeRoot || Power == INT_MAX)
+      return sum;
+    return math::IntRoot<Power>(sum);
+  }
+
+  template<typename VecType1, typename VecType2>
+  static double Evaluate(const VecType1& a,
+                         const VecType2& b,
+                         const double bound)
+  {
+    // Comparing the sum with the bound saves a root for every block.
+    const double sumBound = (!TakeRoot || Power == INT_MAX) ? bound :
+        math::IntPow<Power>(bound);
+
+    const size_t blockSize = 16;
+    double sum = 0.0;
+    size_t i = 0;
+    while (i < a.n_elem)
+    {
+      const size_t end = std::min(i + blockSize, (size_t) a.n_elem);
+
+      double partial[4] = { 0.0, 0.0, 0.0, 0.0 };
+      for (; i + 4 <= end; i += 4)
+        for (size_t j = 0; j < 4; ++j)
+          partial[j] = Add(partial[j], (double) a[i + j] - (double) b[i + j]);
+      for (; i < end; ++i)
+        partial[0] = Add(partial[0], (double) a[i] - (double) b[i]);
+
+      sum = Combine(sum, Combine(Combine(partial[0], partial[1]),
+          Combine(partial[2], partial[3])));
+
+      // The root of the sum is checked too, because the power of the bound may
+      // have been rounded down.  The partial distance is no greater than the
+      // distance.
+      if (sum > sumBound && i < a.n_elem)
+      {
+        const double distance = Distance(sum);
+        if (distance > bound)
+          return distance;
+      }
+    }
+
+    return Distance(sum);
+  }
+};
+
+// Sparse points have no blocks of dimensions, so the whole distance is taken.
+template<int Power, bool TakeRoot>
+struct LMetricBounded<Power, TakeRoot, true>
+{
+  template<typename VecType1, typename VecType2>
+  static double Evaluate(const VecType1& a,
+                         const VecType2& b,
+                         const double /* bound */)
+  {
+    return LMetric<Power, TakeRoot>::Evaluate(a, b);
+  }
+};
+
+template<int Power, bool TakeRoot>
 template<typename VecType1, typename VecType2>
-double LMetric<3, false>::Evaluate(const VecType1& a, const VecType2& b)
+double LMetric<Power, TakeRoot>::EvaluateBounded(const VecType1& a,
+                                                 const VecType2& b,
+                                                 const double bound)
 {
-  return accu(pow(abs(a - b), 3.0));
+  return LMetricBounded<Power, TakeRoot, IsSparse<VecType1>::value &&
+      IsSparse<VecType2>::value>::Evaluate(a, b, bound);
 }
 
-// L-infinity (Chebyshev distance) specialization
-template<>
-template<typename VecType1, typename VecType2>
-double LMetric<INT_MAX, false>::Evaluate(const VecType1& a, const VecType2& b)
+// String conversion.
+template<int Power, bool TakeRoot>
+std::string LMetric<Power, TakeRoot>::ToString() const
 {
-  return arma::as_scalar(max(abs(a - b)));
+  std::ostringstream convert;
+  convert << "LMetric [" << this << "]" << std::endl;
+  convert << "  Power: " << Power << std::endl;
+  convert << "  TakeRoot: " << (TakeRoot ? "true" : "false") << std::endl;
+  return convert.str();
 }
 
 }; // namespace metric
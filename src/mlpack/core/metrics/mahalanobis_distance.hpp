@@ -50,7 +50,8 @@ class MahalanobisDistance
  public:
   /**
    * Initialize the Mahalanobis distance with the empty matrix as covariance.
-   * Don't call Evaluate() until you set the covariance with Covariance()!
+   * Don't call Evaluate() until you set the covariance with Covariance(), or
+   * the identity matrix of the dimensionality of the points will be used!
    */
   MahalanobisDistance() { }
 
@@ -61,7 +62,8 @@ class MahalanobisDistance
    * @param dimensionality Dimesnsionality of the covariance matrix.
    */
   MahalanobisDistance(const size_t dimensionality) :
-      covariance(arma::eye<arma::mat>(dimensionality, dimensionality)) { }
+      covariance(arma::eye<arma::mat>(dimensionality, dimensionality)),
+      whitening(arma::eye<arma::mat>(dimensionality, dimensionality)) { }
 
   /**
    * Initialize the Mahalanobis distance with the given covariance matrix.  The
@@ -69,7 +71,7 @@ class MahalanobisDistance
    *
    * @param covariance The covariance matrix to use for this distance.
    */
-  MahalanobisDistance(const arma::mat& covariance) : covariance(covariance) { }
+  MahalanobisDistance(const arma::mat& covariance) { Covariance(covariance); }
 
   /**
    * Evaluate the distance between the two given points using this Mahalanobis
@@ -86,6 +88,46 @@ class MahalanobisDistance
   template<typename VecType1, typename VecType2>
   double Evaluate(const VecType1& a, const VecType2& b);
 
+  /**
+   * Compute a transformation W such that (x - y)^T Q (x - y) = ||W x - W y||^2
+   * for all x and y, where Q is the covariance matrix.  Transforming the
+   * points with W once (a whitening) turns the Mahalanobis distance into the
+   * Euclidean distance, so the evaluations cost O(d) instead of O(d^2), and
+   * trees with Euclidean bounds can be built on the transformed points; see
+   * neighbor::MahalanobisSearch.
+   *
+   * Only the symmetric part of Q changes the distance, so that is what is
+   * factored.  W is the upper-triangular Cholesky factor if the symmetric part
+   * is positive definite; otherwise W is found with an eigendecomposition, and
+   * negative eigenvalues (for which this is not a metric) are treated as 0.
+   *
+   * @param transformation Matrix to store W in.
+   */
+  void Whitening(arma::mat& transformation) const;
+
+  /**
+   * Evaluate the distance between the two given points, but give up as soon
+   * as it is known to be greater than the given bound.  This uses the whitened
+   * form ||W x - W y||^2 (see Whitening(); W is computed whenever the
+   * covariance matrix is set, so this method does not modify the object and
+   * may be called from several threads at once), which is a sum over the rows
+   * of W, accumulated in blocks of rows and compared with the bound after each
+   * block.  When the symmetric part of the covariance matrix is positive
+   * semidefinite, this is the same distance as Evaluate(), up to roundoff.  If
+   * the covariance matrix has not been set, the identity matrix is used.
+   *
+   * If the distance is at most the bound, it is returned; otherwise, a value
+   * greater than the bound and no greater than the distance is returned.
+   *
+   * @param a First vector.
+   * @param b Second vector.
+   * @param bound Bound on the distances of interest.
+   */
+  template<typename VecType1, typename VecType2>
+  double EvaluateBounded(const VecType1& a,
+                         const VecType2& b,
+                         const double bound) const;
+
   /**
    * Access the covariance matrix.
    *
@@ -94,14 +136,19 @@ class MahalanobisDistance
   const arma::mat& Covariance() const { return covariance; }
 
   /**
-   * Modify the covariance matrix.
+   * Set the covariance matrix, and compute the whitening transformation used
+   * by EvaluateBounded().
    *
-   * @return Reference to the covariance matrix.
+   * @param covariance The covariance matrix to use for this distance.
    */
-  arma::mat& Covariance() { return covariance; }
+  void Covariance(const arma::mat& covariance);
+
  private:
   //! The covariance matrix associated with this distance.
   arma::mat covariance;
+  //! The whitening transformation used by EvaluateBounded() (empty if the
+  //! covariance matrix is empty).
+  arma::mat whitening;
 };
 
 }; // namespace distance
@@ -42,6 +42,80 @@ double MahalanobisDistance<true>::Evaluate(const VecType1& a,
   return sqrt(out[0]);
 }
 
+template<bool TakeRoot>
+void MahalanobisDistance<TakeRoot>::Whitening(arma::mat& transformation) const
+{
+  if (covariance.n_rows == 0)
+    Log::Fatal << "MahalanobisDistance::Whitening(): the covariance matrix has "
+        << "not been set!" << std::endl;
+
+  const arma::mat symmetric = 0.5 * (covariance + trans(covariance));
+
+  // chol() gives R with trans(R) * R = symmetric, which is what we want.
+  if (arma::chol(transformation, symmetric))
+    return;
+
+  arma::vec eigenvalues;
+  arma::mat eigenvectors;
+  arma::eig_sym(eigenvalues, eigenvectors, symmetric);
+
+  // Eigenvalues that are only negative because of roundoff are not worth a
+  // warning.
+  if (eigenvalues.min() < -1e-10 * arma::abs(eigenvalues).max())
+    Log::Warn << "MahalanobisDistance::Whitening(): the covariance matrix is "
+        << "not positive semidefinite; its negative eigenvalues are ignored."
+        << std::endl;
+
+  transformation = diagmat(sqrt(arma::clamp(eigenvalues, 0.0, DBL_MAX))) *
+      trans(eigenvectors);
+}
+
+template<bool TakeRoot>
+void MahalanobisDistance<TakeRoot>::Covariance(const arma::mat& covariance)
+{
+  this->covariance = covariance;
+  if (covariance.n_elem == 0)
+    whitening.reset();
+  else
+    Whitening(whitening);
+}
+
+template<bool TakeRoot>
+template<typename VecType1, typename VecType2>
+double MahalanobisDistance<TakeRoot>::EvaluateBounded(const VecType1& a,
+                                                      const VecType2& b,
+                                                      const double bound) const
+{
+  const arma::vec m = (a - b);
+
+  // If the covariance matrix has not been set, the whitening is the identity.
+  if (whitening.n_rows == 0)
+  {
+    const double sum = dot(m, m);
+    return TakeRoot ? sqrt(sum) : sum;
+  }
+  const double sumBound = TakeRoot ? (bound * bound) : bound;
+
+  const size_t blockSize = 16;
+  double sum = 0.0;
+  for (size_t i = 0; i < whitening.n_rows; i += blockSize)
+  {
+    const size_t end = std::min(i + blockSize, (size_t) whitening.n_rows);
+    sum += accu(square(whitening.rows(i, end - 1) * m));
+
+    // The root of the sum is checked too, because the square of the bound may
+    // have been rounded down.
+    if (sum > sumBound && end < whitening.n_rows)
+    {
+      const double distance = TakeRoot ? sqrt(sum) : sum;
+      if (distance > bound)
+        return distance;
+    }
+  }
+
+  return TakeRoot ? sqrt(sum) : sum;
+}
+
 // Convert object into string.
 template<bool TakeRoot>
 std::string MahalanobisDistance<TakeRoot>::ToString() const
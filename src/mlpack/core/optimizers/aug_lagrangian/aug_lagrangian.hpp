@@ -38,6 +38,33 @@ namespace optimization {
  * the given coordinates.  Evaluate() should provide the objective function
  * value for the given coordinates.
  *
+ * The state of the optimization (the iterate, the Lagrange multipliers, the
+ * penalty parameter, and the curvature pairs of the L-BFGS optimizer) can be
+ * saved with Save() and restored with Load(); Resume() then continues the
+ * optimization from the restored state.  If CheckpointInterval() is set, the
+ * state is also written to CheckpointFile() every CheckpointInterval() outer
+ * iterations, so that a long optimization can be stopped and picked up again:
+ *
+ * @code
+ * AugLagrangian<MyFunction> aug(f);
+ * aug.CheckpointInterval() = 5;
+ * aug.CheckpointFile() = "aug_lagrangian.bin";
+ * aug.Optimize(coordinates);
+ *
+ * // Later, possibly in another process...
+ * AugLagrangian<MyFunction> resumed(f);
+ * util::SaveRestoreUtility sr;
+ * sr.ReadFile("aug_lagrangian.bin");
+ * resumed.Load(sr);
+ * resumed.Resume(coordinates);
+ * @endcode
+ *
+ * Each outer iteration only changes the Lagrange multipliers or the penalty
+ * parameter, so the function L-BFGS minimizes changes little from one outer
+ * iteration to the next.  If LBFGS().KeepHistory() is set, L-BFGS starts each
+ * outer iteration with the curvature pairs of the last one instead of
+ * building its Hessian approximation from scratch.
+ *
  * @tparam LagrangianFunction Function which can be optimized by this class.
  */
 template<typename LagrangianFunction>
@@ -98,6 +125,34 @@ class AugLagrangian
                 const double initSigma,
                 const size_t maxIterations = 1000);
 
+  /**
+   * Continue an optimization from the state restored by Load() (or the state
+   * at the end of the last call to Optimize()).  The outer iterations done
+   * before the state was saved count towards maxIterations.
+   *
+   * @param coordinates Output matrix to store the optimized coordinates in.
+   * @param maxIterations Maximum number of iterations of the Augmented
+   *     Lagrangian algorithm.  0 indicates no maximum.
+   */
+  bool Resume(arma::mat& coordinates, const size_t maxIterations = 1000);
+
+  /**
+   * Save the state of the optimization: the current iterate, the Lagrange
+   * multipliers, the penalty parameter and threshold, the number of outer
+   * iterations done, and the curvature pairs of the L-BFGS optimizer.
+   *
+   * @param sr SaveRestoreUtility to save the state into.
+   */
+  void Save(util::SaveRestoreUtility& sr) const;
+
+  /**
+   * Load the state of an optimization saved by Save(); call Resume() to
+   * continue it.
+   *
+   * @param sr SaveRestoreUtility to load the state from.
+   */
+  void Load(const util::SaveRestoreUtility& sr);
+
   //! Get the LagrangianFunction.
   const LagrangianFunction& Function() const { return function; }
   //! Modify the LagrangianFunction.
@@ -118,6 +173,20 @@ class AugLagrangian
   //! Modify the penalty parameter.
   double& Sigma() { return augfunc.Sigma(); }
 
+  //! Get the number of outer iterations done.
+  size_t Iteration() const { return iteration; }
+
+  //! Get the number of outer iterations between checkpoints (0 means none).
+  size_t CheckpointInterval() const { return checkpointInterval; }
+  //! Modify the number of outer iterations between checkpoints (0 means none).
+  size_t& CheckpointInterval() { return checkpointInterval; }
+
+  //! Get the file checkpoints are written to.
+  const std::string& CheckpointFile() const { return checkpointFile; }
+  //! Modify the file checkpoints are written to (a filename ending in ".bin"
+  //! gives a binary file; otherwise, XML is written).
+  std::string& CheckpointFile() { return checkpointFile; }
+
   // convert the obkect into a string
   std::string ToString() const;
 
@@ -135,6 +204,25 @@ class AugLagrangian
 
   //! The L-BFGS optimizer that we will use.
   L_BFGSType& lbfgs;
+
+  //! The iterate at the last saved state.
+  arma::mat iterate;
+  //! The penalty below which lambda is updated (instead of sigma).
+  double penaltyThreshold;
+  //! The number of outer iterations done.
+  size_t iteration;
+
+  //! Number of outer iterations between checkpoints (0 means none).
+  size_t checkpointInterval;
+  //! File checkpoints are written to.
+  std::string checkpointFile;
+
+  //! Run outer iterations from the current state until convergence or until
+  //! maxIterations outer iterations are done in total.
+  bool OuterIterations(arma::mat& coordinates, const size_t maxIterations);
+
+  //! Save the state with the given iterate to the checkpoint file.
+  void Checkpoint(const arma::mat& coordinates);
 };
 
 }; // namespace optimization
@@ -8,6 +8,7 @@
 #define __MLPACK_CORE_OPTIMIZERS_AUG_LAGRANGIAN_AUG_LAGRANGIAN_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/evaluate_with_gradient.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -17,8 +18,8 @@ namespace optimization {
  * LagrangianFunction into a function usable by a simple optimizer like L-BFGS.
  * Given a LagrangianFunction which follows the format outlined in the
  * documentation for AugLagrangian, this class provides Evaluate(), Gradient(),
- * and GetInitialPoint() functions which allow this class to be used with a
- * simple optimizer like L-BFGS.
+ * EvaluateWithGradient(), and GetInitialPoint() functions which allow this
+ * class to be used with a simple optimizer like L-BFGS.
  *
  * This class can be specialized for your particular implementation -- commonly,
  * a faster method for computing the overall objective and gradient of the
@@ -71,6 +72,19 @@ class AugLagrangianFunction
    */
   void Gradient(const arma::mat& coordinates, arma::mat& gradient) const;
 
+  /**
+   * Evaluate the objective function and the gradient of the Augmented
+   * Lagrangian function at once.  Each constraint is only evaluated once, and
+   * if the LagrangianFunction has an EvaluateWithGradient() method, it is used
+   * for the objective and its gradient.
+   *
+   * @param coordinates Coordinates to evaluate function and gradient at.
+   * @param gradient Matrix to store gradient into.
+   * @return Objective function.
+   */
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient) const;
+
   /**
    * Get the initial point of the optimization (supplied by the
    * LagrangianFunction).
@@ -20,7 +20,10 @@ AugLagrangian<LagrangianFunction>::AugLagrangian(LagrangianFunction& function) :
     function(function),
     augfunc(function),
     lbfgsInternal(augfunc),
-    lbfgs(lbfgsInternal)
+    lbfgs(lbfgsInternal),
+    penaltyThreshold(DBL_MAX),
+    iteration(0),
+    checkpointInterval(0)
 {
   lbfgs.MaxIterations() = 1000;
 }
@@ -31,7 +34,10 @@ AugLagrangian<LagrangianFunction>::AugLagrangian(
     L_BFGSType& lbfgs) :
     function(augfunc.Function()),
     augfunc(augfunc),
-    lbfgs(lbfgs)
+    lbfgs(lbfgs),
+    penaltyThreshold(DBL_MAX),
+    iteration(0),
+    checkpointInterval(0)
 {
   // Nothing to do.  lbfgsInternal isn't used in this case.
 }
@@ -59,6 +65,8 @@ std::string AugLagrangian<LagrangianFunction>::ToString() const
   convert << mlpack::util::Indent(function.ToString(), 2);
   convert << "  L-BFGS optimizer:" << std::endl;
   convert << mlpack::util::Indent(lbfgs.ToString(), 2);
+  convert << "  Checkpoint interval: " << checkpointInterval << std::endl;
+  convert << "  Checkpoint file: " << checkpointFile << std::endl;
   return convert.str();
 }
 
@@ -67,8 +75,96 @@ bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
                                                  const size_t maxIterations)
 {
   // Ensure that we update lambda immediately.
-  double penaltyThreshold = DBL_MAX;
+  penaltyThreshold = DBL_MAX;
+  iteration = 0;
 
+  // The curvature pairs of an earlier optimization don't apply here.
+  lbfgs.ResetHistory();
+
+  return OuterIterations(coordinates, maxIterations);
+}
+
+template<typename LagrangianFunction>
+bool AugLagrangian<LagrangianFunction>::Resume(arma::mat& coordinates,
+                                               const size_t maxIterations)
+{
+  if (iterate.n_elem == 0)
+  {
+    Log::Fatal << "AugLagrangian::Resume(): no state to resume from; call "
+        << "Load() or Optimize() first." << std::endl;
+  }
+
+  coordinates = iterate;
+  return OuterIterations(coordinates, maxIterations);
+}
+
+template<typename LagrangianFunction>
+void AugLagrangian<LagrangianFunction>::Save(util::SaveRestoreUtility& sr)
+    const
+{
+  sr.SaveParameter(iterate, "iterate");
+  sr.SaveParameter(augfunc.Lambda(), "lambda");
+  sr.SaveParameter(augfunc.Sigma(), "sigma");
+  sr.SaveParameter(iteration, "iteration");
+
+  // DBL_MAX means that lambda has not been updated yet; it does not survive
+  // being written as text, so it is saved as a flag instead.
+  const bool thresholdSet = (penaltyThreshold != DBL_MAX);
+  sr.SaveParameter(thresholdSet, "penalty_threshold_set");
+  if (thresholdSet)
+    sr.SaveParameter(penaltyThreshold, "penalty_threshold");
+
+  util::SaveRestoreUtility lbfgsState;
+  lbfgs.Save(lbfgsState);
+  sr.AddChild(lbfgsState, "lbfgs");
+}
+
+template<typename LagrangianFunction>
+void AugLagrangian<LagrangianFunction>::Load(
+    const util::SaveRestoreUtility& sr)
+{
+  sr.LoadParameter(iterate, "iterate");
+  sr.LoadParameter(augfunc.Lambda(), "lambda");
+  sr.LoadParameter(augfunc.Sigma(), "sigma");
+  sr.LoadParameter(iteration, "iteration");
+
+  bool thresholdSet;
+  sr.LoadParameter(thresholdSet, "penalty_threshold_set");
+  if (thresholdSet)
+    sr.LoadParameter(penaltyThreshold, "penalty_threshold");
+  else
+    penaltyThreshold = DBL_MAX;
+
+  const std::map<std::string, util::SaveRestoreUtility> children =
+      sr.Children();
+  std::map<std::string, util::SaveRestoreUtility>::const_iterator it =
+      children.find("lbfgs");
+  if (it == children.end())
+    Log::Fatal << "AugLagrangian::Load(): no L-BFGS state found!" << std::endl;
+  lbfgs.Load(it->second);
+}
+
+template<typename LagrangianFunction>
+void AugLagrangian<LagrangianFunction>::Checkpoint(
+    const arma::mat& coordinates)
+{
+  iterate = coordinates;
+
+  util::SaveRestoreUtility sr;
+  Save(sr);
+  if (!sr.WriteFile(checkpointFile))
+    Log::Warn << "AugLagrangian: could not write checkpoint to '"
+        << checkpointFile << "'." << std::endl;
+  else
+    Log::Info << "AugLagrangian: saved checkpoint to '" << checkpointFile
+        << "' after iteration " << iteration << "." << std::endl;
+}
+
+template<typename LagrangianFunction>
+bool AugLagrangian<LagrangianFunction>::OuterIterations(
+    arma::mat& coordinates,
+    const size_t maxIterations)
+{
   // Track the last objective to compare for convergence.
   double lastObjective = function.Evaluate(coordinates);
 
@@ -80,18 +176,14 @@ bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
   Log::Debug << "Penalty is " << penalty << " (threshold " << penaltyThreshold
       << ")." << std::endl;
 
-  // The odd comparison allows user to pass maxIterations = 0 (i.e. no limit on
-  // number of iterations).
-  size_t it;
-  for (it = 0; it != (maxIterations - 1); it++)
+  // maxIterations = 0 means that there is no limit on the number of
+  // iterations.  The iterations done before a resumed state was saved count
+  // too.
+  while ((maxIterations == 0) || (iteration < maxIterations - 1))
   {
-    Log::Warn << "AugLagrangian on iteration " << it
+    Log::Warn << "AugLagrangian on iteration " << iteration
         << ", starting with objective "  << lastObjective << "." << std::endl;
 
- //   Log::Warn << coordinates << std::endl;
-
-//    Log::Warn << trans(coordinates) * coordinates << std::endl;
-
     if (!lbfgs.Optimize(coordinates))
       Log::Warn << "L-BFGS reported an error during optimization."
           << std::endl;
@@ -100,7 +192,10 @@ bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
     // comparing with is arbitrary).
     if (std::abs(lastObjective - function.Evaluate(coordinates)) < 1e-10 &&
         augfunc.Sigma() > 500000)
+    {
+      iterate = coordinates;
       return true;
+    }
 
     lastObjective = function.Evaluate(coordinates);
 
@@ -111,23 +206,11 @@ bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
     // First, calculate the current penalty.
     double penalty = 0;
     for (size_t i = 0; i < function.NumConstraints(); i++)
-    {
       penalty += std::pow(function.EvaluateConstraint(i, coordinates), 2);
-//      Log::Debug << "Constraint " << i << " is " <<
-//          function.EvaluateConstraint(i, coordinates) << std::endl;
-    }
 
     Log::Warn << "Penalty is " << penalty << " (threshold "
         << penaltyThreshold << ")." << std::endl;
 
-    for (size_t i = 0; i < function.NumConstraints(); ++i)
-    {
-//      arma::mat tmpgrad;
-//      function.GradientConstraint(i, coordinates, tmpgrad);
-//      Log::Debug << "Gradient of constraint " << i << " is " << std::endl;
-//      Log::Debug << tmpgrad << std::endl;
-    }
-
     if (penalty < penaltyThreshold) // We update lambda.
     {
       // We use the update: lambda_{k + 1} = lambda_k - sigma * c(coordinates),
@@ -150,8 +233,15 @@ bool AugLagrangian<LagrangianFunction>::Optimize(arma::mat& coordinates,
       augfunc.Sigma() *= 10;
       Log::Warn << "Updated sigma to " << augfunc.Sigma() << "." << std::endl;
     }
+
+    ++iteration;
+
+    // The saved state is the one at the start of the next outer iteration.
+    if ((checkpointInterval > 0) && (iteration % checkpointInterval == 0))
+      Checkpoint(coordinates);
   }
 
+  iterate = coordinates;
   return false;
 }
 
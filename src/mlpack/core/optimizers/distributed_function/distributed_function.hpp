@@ -0,0 +1,163 @@
+/**
+ * @file distributed_function.hpp
+ *
+ * A wrapper for objective functions which are sums over data split across the
+ * nodes of a distributed computation, so that they can be optimized with L_BFGS
+ * on every node at once.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_DISTRIBUTED_FUNCTION_DISTRIBUTED_FUNCTION_HPP
+#define __MLPACK_CORE_OPTIMIZERS_DISTRIBUTED_FUNCTION_DISTRIBUTED_FUNCTION_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/local_reducer.hpp>
+#include <mlpack/core/optimizers/evaluate_with_gradient.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * The DistributedFunction wraps an objective function which is the sum of a
+ * function over a shard of the data, held by this node, and makes it the sum
+ * over the shards of all the nodes: the objective and the gradient are
+ * computed on the local shard, and then summed over the nodes with the
+ * reducer (an all-reduce; see util::LocalReducer).  Every node then holds the
+ * same objective and gradient, so an optimizer such as L_BFGS run on every
+ * node takes the same steps and reaches the same coordinates on each.
+ *
+ * The wrapped function can be any function that can be optimized by L_BFGS
+ * (such as regression::LogisticRegressionFunction,
+ * regression::SoftmaxRegressionFunction, or nn::SparseAutoencoderFunction);
+ * if it implements EvaluateWithGradient(), the objective and the gradient are
+ * summed with a single reduction.  The initial point of the rank 0 node is
+ * used by every node, since the initial points of functions such as
+ * SparseAutoencoderFunction are random.
+ *
+ * Every term of the function is summed over the nodes, including any
+ * regularization term, which each node adds once; so to get the regularization
+ * of the whole dataset, each node should use its share of it (for instance,
+ * lambda / NumNodes()).
+ *
+ * All the nodes must construct the wrapper and run the optimizer together,
+ * with the same parameters, since every evaluation is a collective operation.
+ *
+ * @code
+ * // Each MPI process has loaded its own shard of the data.
+ * extern arma::mat shard;
+ * extern arma::vec shardResponses;
+ *
+ * typedef regression::LogisticRegressionFunction<> LocalFunction;
+ * typedef DistributedFunction<LocalFunction, util::MPIReducer> FunctionType;
+ *
+ * util::MPIReducer reducer;
+ * LocalFunction f(shard, shardResponses, lambda / reducer.NumNodes());
+ * FunctionType df(f, reducer);
+ *
+ * L_BFGS<FunctionType> lbfgs(df);
+ * arma::mat parameters = df.GetInitialPoint();
+ * lbfgs.Optimize(parameters); // The same on every process.
+ * @endcode
+ *
+ * @tparam FunctionType Objective function over the local shard.
+ * @tparam ReducerType Reducer used to sum over the nodes (util::LocalReducer
+ *     for a single node, util::MPIReducer for MPI).
+ */
+template<typename FunctionType, typename ReducerType = util::LocalReducer>
+class DistributedFunction
+{
+ public:
+  /**
+   * Wrap the given function.  This is collective: the initial point of the
+   * rank 0 node is shared with every node.
+   *
+   * @param function Objective function over the local shard.
+   * @param reducer Reducer used to sum over the nodes.
+   */
+  DistributedFunction(FunctionType& function,
+                      ReducerType reducer = ReducerType()) :
+      function(function),
+      reducer(reducer),
+      initialPoint(function.GetInitialPoint())
+  {
+    if (this->reducer.Rank() != 0)
+      initialPoint.zeros();
+    this->reducer.Sum(initialPoint.memptr(), initialPoint.n_elem);
+  }
+
+  /**
+   * Evaluate the objective, summed over the nodes, at the given coordinates.
+   *
+   * @param coordinates Coordinates to evaluate the function at.
+   */
+  double Evaluate(const arma::mat& coordinates)
+  {
+    double objective = function.Evaluate(coordinates);
+    reducer.Sum(&objective, 1);
+    return objective;
+  }
+
+  /**
+   * Evaluate the gradient, summed over the nodes, at the given coordinates.
+   *
+   * @param coordinates Coordinates to evaluate the gradient at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  {
+    function.Gradient(coordinates, gradient);
+    reducer.Sum(gradient.memptr(), gradient.n_elem);
+  }
+
+  /**
+   * Evaluate the objective and the gradient, summed over the nodes, at the
+   * given coordinates, with one reduction.
+   *
+   * @param coordinates Coordinates to evaluate the function at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient)
+  {
+    const double objective = ObjectiveWithGradient(function, coordinates,
+        gradient);
+
+    // The objective is reduced along with the gradient.
+    buffer.set_size(gradient.n_elem + 1);
+    std::copy(gradient.memptr(), gradient.memptr() + gradient.n_elem,
+        buffer.memptr());
+    buffer[gradient.n_elem] = objective;
+
+    reducer.Sum(buffer.memptr(), buffer.n_elem);
+
+    std::copy(buffer.memptr(), buffer.memptr() + gradient.n_elem,
+        gradient.memptr());
+    return buffer[gradient.n_elem];
+  }
+
+  //! Get the initial point, which is the same on every node.
+  const arma::mat& GetInitialPoint() const { return initialPoint; }
+
+  //! Get the wrapped function.
+  const FunctionType& Function() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& Function() { return function; }
+
+  //! Get the reducer.
+  const ReducerType& Reducer() const { return reducer; }
+  //! Modify the reducer.
+  ReducerType& Reducer() { return reducer; }
+
+ private:
+  //! The objective function over the local shard.
+  FunctionType& function;
+  //! The reducer used to sum over the nodes.
+  ReducerType reducer;
+  //! The initial point of the rank 0 node.
+  arma::mat initialPoint;
+  //! Space for the objective and the gradient, for EvaluateWithGradient().
+  arma::vec buffer;
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * @file evaluate_with_gradient.hpp
+ *
+ * Utilities for optimizers to evaluate the objective function and its gradient
+ * at once, when the function to be optimized can do so.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_EVALUATE_WITH_GRADIENT_HPP
+#define __MLPACK_CORE_OPTIMIZERS_EVALUATE_WITH_GRADIENT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+//! Detect whether a function can compute its objective and gradient at once.
+HAS_MEM_FUNC(EvaluateWithGradient, HasEvaluateWithGradient);
+
+/**
+ * Whether FunctionType has a (const or non-const) method
+ *
+ *   double EvaluateWithGradient(const arma::mat& coordinates,
+ *                               arma::mat& gradient);
+ *
+ * which returns the objective function at the given coordinates and stores the
+ * gradient there.  Many functions compute the same intermediate results (such
+ * as a forward pass through the data) in Evaluate() and in Gradient(), so
+ * optimizers which need both at the same point should use
+ * ObjectiveWithGradient(), which calls EvaluateWithGradient() if it exists.
+ */
+template<typename FunctionType>
+struct HasEvaluateWithGradientMethod
+{
+  static const bool value = HasEvaluateWithGradient<FunctionType,
+      double (FunctionType::*)(const arma::mat&, arma::mat&) const>::value ||
+      HasEvaluateWithGradient<FunctionType,
+      double (FunctionType::*)(const arma::mat&, arma::mat&)>::value;
+};
+
+/**
+ * Evaluate the objective function at the given coordinates, and store its
+ * gradient there, with one call to EvaluateWithGradient().
+ *
+ * @param function Function to evaluate.
+ * @param coordinates Coordinates to evaluate the function at.
+ * @param gradient Matrix to store the gradient in.
+ * @return Objective function value.
+ */
+template<typename FunctionType>
+double ObjectiveWithGradient(
+    FunctionType& function,
+    const arma::mat& coordinates,
+    arma::mat& gradient,
+    const typename boost::enable_if_c<
+        HasEvaluateWithGradientMethod<FunctionType>::value,
+        FunctionType*>::type = 0)
+{
+  return function.EvaluateWithGradient(coordinates, gradient);
+}
+
+/**
+ * Evaluate the objective function at the given coordinates, and store its
+ * gradient there, with separate calls to Evaluate() and Gradient(), for
+ * functions without EvaluateWithGradient().
+ *
+ * @param function Function to evaluate.
+ * @param coordinates Coordinates to evaluate the function at.
+ * @param gradient Matrix to store the gradient in.
+ * @return Objective function value.
+ */
+template<typename FunctionType>
+double ObjectiveWithGradient(
+    FunctionType& function,
+    const arma::mat& coordinates,
+    arma::mat& gradient,
+    const typename boost::disable_if_c<
+        HasEvaluateWithGradientMethod<FunctionType>::value,
+        FunctionType*>::type = 0)
+{
+  const double objective = function.Evaluate(coordinates);
+  function.Gradient(coordinates, gradient);
+  return objective;
+}
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -9,6 +9,7 @@
 #define __MLPACK_CORE_OPTIMIZERS_LBFGS_LBFGS_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/evaluate_with_gradient.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -24,6 +25,15 @@ namespace optimization {
  *  - double Evaluate(const arma::mat& coordinates);
  *  - void Gradient(const arma::mat& coordinates, arma::mat& gradient);
  *  - arma::mat& GetInitialPoint();
+ *
+ * If the function also implements
+ *
+ *  - double EvaluateWithGradient(const arma::mat& coordinates,
+ *                                arma::mat& gradient);
+ *
+ * which returns the objective and stores the gradient, it is used whenever
+ * both are needed at the same point (which is at every step of the line
+ * search), so that the function can compute them in one pass.
  */
 template<typename FunctionType>
 class L_BFGS
@@ -139,6 +149,37 @@ class L_BFGS
   //! Modify the maximum line search step size.
   double& MaxStep() { return maxStep; }
 
+  /**
+   * Get whether the curvature pairs (the s and y matrices) are kept from one
+   * call to Optimize() to the next.  If true, each call continues with the
+   * approximation of the Hessian built by the last one, as long as the size of
+   * the iterate and the memory size have not changed; this is useful when a
+   * sequence of similar functions is optimized, as in AugLagrangian.
+   */
+  bool KeepHistory() const { return keepHistory; }
+  //! Modify whether the curvature pairs are kept between calls to Optimize().
+  bool& KeepHistory() { return keepHistory; }
+
+  //! Forget the stored curvature pairs, so that the next call to Optimize()
+  //! starts from a scaled identity Hessian approximation.
+  void ResetHistory() { numUpdates = 0; }
+
+  /**
+   * Save the stored curvature pairs, so that an interrupted optimization can
+   * be continued later (see KeepHistory()).
+   *
+   * @param sr SaveRestoreUtility to save the history into.
+   */
+  void Save(util::SaveRestoreUtility& sr) const;
+
+  /**
+   * Load curvature pairs saved by Save().  The memory size is set to the one
+   * of the saved optimizer.
+   *
+   * @param sr SaveRestoreUtility to load the history from.
+   */
+  void Load(const util::SaveRestoreUtility& sr);
+
   // convert the obkect into a string
   std::string ToString() const;
 
@@ -153,6 +194,21 @@ class L_BFGS
   //! Stores all the y matrices in memory.
   arma::cube y;
 
+  // The workspace of Optimize(), allocated once so that the iterations don't
+  // allocate any memory.
+  //! The iterate at the last iteration.
+  arma::mat oldIterateTmp;
+  //! The gradient at the current iterate.
+  arma::mat gradientTmp;
+  //! The gradient at the last iterate.
+  arma::mat oldGradientTmp;
+  //! The search direction.
+  arma::mat searchDirectionTmp;
+  //! The rho coefficients of SearchDirection().
+  arma::vec rhoTmp;
+  //! The alpha coefficients of SearchDirection().
+  arma::vec alphaTmp;
+
   //! Size of memory for this L-BFGS optimizer.
   size_t numBasis;
   //! Maximum number of iterations.
@@ -169,6 +225,10 @@ class L_BFGS
   double minStep;
   //! Maximum step of the line search.
   double maxStep;
+  //! Whether the curvature pairs are kept between calls to Optimize().
+  bool keepHistory;
+  //! Number of curvature pairs computed since the history was last reset.
+  size_t numUpdates;
 
   //! Best point found so far.
   std::pair<arma::mat, double> minPointIterate;
@@ -181,6 +241,16 @@ class L_BFGS
    */
   double Evaluate(const arma::mat& iterate);
 
+  /**
+   * Evaluate the function and its gradient at the given iterate point, and
+   * store the result if it is a new minimum.
+   *
+   * @param iterate Point to evaluate the function at.
+   * @param gradient Matrix to store the gradient in.
+   * @return The value of the function.
+   */
+  double EvaluateWithGradient(const arma::mat& iterate, arma::mat& gradient);
+
   /**
    * Calculate the scaling factor, gamma, which is used to scale the Hessian
    * approximation matrix.  See method M3 in Section 4 of Liu and Nocedal
@@ -45,7 +45,9 @@ L_BFGS<FunctionType>::L_BFGS(FunctionType& function,
     minGradientNorm(minGradientNorm),
     maxLineSearchTrials(maxLineSearchTrials),
     minStep(minStep),
-    maxStep(maxStep)
+    maxStep(maxStep),
+    keepHistory(false),
+    numUpdates(0)
 {
   // Get the dimensions of the coordinates of the function; GetInitialPoint()
   // might return an arma::vec, but that's okay because then n_cols will simply
@@ -57,6 +59,13 @@ L_BFGS<FunctionType>::L_BFGS(FunctionType& function,
   s.set_size(rows, cols, numBasis);
   y.set_size(rows, cols, numBasis);
 
+  oldIterateTmp.set_size(rows, cols);
+  gradientTmp.set_size(rows, cols);
+  oldGradientTmp.set_size(rows, cols);
+  searchDirectionTmp.set_size(rows, cols);
+  rhoTmp.set_size(numBasis);
+  alphaTmp.set_size(numBasis);
+
   // Allocate the pair holding the min iterate information.
   minPointIterate.first.zeros(rows, cols);
   minPointIterate.second = std::numeric_limits<double>::max();
@@ -84,6 +93,28 @@ double L_BFGS<FunctionType>::Evaluate(const arma::mat& iterate)
   return functionValue;
 }
 
+/**
+ * Evaluate the function and its gradient at the given iterate point and store
+ * the result if it is a new minimum.
+ *
+ * @return The value of the function
+ */
+template<typename FunctionType>
+double L_BFGS<FunctionType>::EvaluateWithGradient(const arma::mat& iterate,
+                                                  arma::mat& gradient)
+{
+  const double functionValue = ObjectiveWithGradient(function, iterate,
+      gradient);
+
+  if (functionValue < minPointIterate.second)
+  {
+    minPointIterate.first = iterate;
+    minPointIterate.second = functionValue;
+  }
+
+  return functionValue;
+}
+
 /**
  * Calculate the scaling factor gamma which is used to scale the Hessian
  * approximation matrix.  See method M3 in Section 4 of Liu and Nocedal (1989).
@@ -178,10 +209,8 @@ bool L_BFGS<FunctionType>::LineSearch(double& functionValue,
   {
     // Perform a step and evaluate the gradient and the function values at that
     // point.
-    newIterateTmp = iterate;
-    newIterateTmp += stepSize * searchDirection;
-    functionValue = Evaluate(newIterateTmp);
-    function.Gradient(newIterateTmp, gradient);
+    newIterateTmp = iterate + stepSize * searchDirection;
+    functionValue = EvaluateWithGradient(newIterateTmp, gradient);
     numIterations++;
 
     if (functionValue > initialFunctionValue + stepSize *
@@ -250,9 +279,9 @@ void L_BFGS<FunctionType>::SearchDirection(const arma::mat& gradient,
   // See "A Recursive Formula to Compute H * g" in "Updating quasi-Newton
   // matrices with limited storage" (Nocedal, 1980).
 
-  // Temporary variables.
-  arma::vec rho(numBasis);
-  arma::vec alpha(numBasis);
+  // Temporary variables; these are preallocated by Optimize().
+  arma::vec& rho = rhoTmp;
+  arma::vec& alpha = alphaTmp;
 
   size_t limit = (numBasis > iterationNum) ? 0 : (iterationNum - numBasis);
   for (size_t i = iterationNum; i != limit; i--)
@@ -342,39 +371,48 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
   const size_t rows = function.GetInitialPoint().n_rows;
   const size_t cols = function.GetInitialPoint().n_cols;
 
+  // The curvature pairs of the last call can only be used if they still fit.
+  if (!keepHistory || (s.n_rows != rows) || (s.n_cols != cols) ||
+      (s.n_slices != numBasis))
+    numUpdates = 0;
+
   s.set_size(rows, cols, numBasis);
   y.set_size(rows, cols, numBasis);
   minPointIterate.second = std::numeric_limits<double>::max();
 
+  // Make sure the workspace is the right size too; if it already is, no memory
+  // is allocated, and none is allocated in the optimization loop.
+  newIterateTmp.set_size(iterate.n_rows, iterate.n_cols);
+  minPointIterate.first.set_size(iterate.n_rows, iterate.n_cols);
+  rhoTmp.set_size(numBasis);
+  alphaTmp.set_size(numBasis);
+
   // The old iterate to be saved.
-  arma::mat oldIterate;
+  arma::mat& oldIterate = oldIterateTmp;
   oldIterate.zeros(iterate.n_rows, iterate.n_cols);
 
   // Whether to optimize until convergence.
   bool optimizeUntilConvergence = (maxIterations == 0);
 
-  // The initial function value.
-  double functionValue = Evaluate(iterate);
-
-  // The gradient: the current and the old.
-  arma::mat gradient;
-  arma::mat oldGradient;
+  // The initial function value and gradient.
+  arma::mat& gradient = gradientTmp;
+  arma::mat& oldGradient = oldGradientTmp;
   gradient.zeros(iterate.n_rows, iterate.n_cols);
   oldGradient.zeros(iterate.n_rows, iterate.n_cols);
+  double functionValue = EvaluateWithGradient(iterate, gradient);
 
   // The search direction.
-  arma::mat searchDirection;
+  arma::mat& searchDirection = searchDirectionTmp;
   searchDirection.zeros(iterate.n_rows, iterate.n_cols);
 
-  // The initial gradient value.
-  function.Gradient(iterate, gradient);
-
   // The main optimization loop.
   for (size_t itNum = 0; optimizeUntilConvergence || (itNum != maxIterations);
        ++itNum)
   {
+    // The line search leaves the objective of the new iterate in
+    // functionValue, so there is no need to evaluate it again.
     Log::Debug << "L-BFGS iteration " << itNum << "; objective " <<
-        function.Evaluate(iterate) << "." << std::endl;
+        functionValue << "." << std::endl;
 
     // Break when the norm of the gradient becomes too small.
     if (GradientNormTooSmall(gradient))
@@ -385,11 +423,11 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
     }
 
     // Choose the scaling factor.
-    double scalingFactor = ChooseScalingFactor(itNum, gradient);
+    double scalingFactor = ChooseScalingFactor(numUpdates, gradient);
 
     // Build an approximation to the Hessian and choose the search
     // direction for the current iteration.
-    SearchDirection(gradient, itNum, scalingFactor, searchDirection);
+    SearchDirection(gradient, numUpdates, scalingFactor, searchDirection);
 
     // Save the old iterate and the gradient before stepping.
     oldIterate = iterate;
@@ -404,7 +442,7 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
 
     // It is possible that the difference between the two coordinates is zero.
     // In this case we terminate successfully.
-    if (accu(iterate != oldIterate) == 0)
+    if (std::equal(iterate.begin(), iterate.end(), oldIterate.begin()))
     {
       Log::Debug << "L-BFGS step size of 0 (terminating successfully)."
           << std::endl;
@@ -412,13 +450,65 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
     }
 
     // Overwrite an old basis set.
-    UpdateBasisSet(itNum, iterate, oldIterate, gradient, oldGradient);
+    UpdateBasisSet(numUpdates, iterate, oldIterate, gradient, oldGradient);
+    ++numUpdates;
 
   } // End of the optimization loop.
 
   return function.Evaluate(iterate);
 }
 
+template<typename FunctionType>
+void L_BFGS<FunctionType>::Save(util::SaveRestoreUtility& sr) const
+{
+  sr.SaveParameter(numBasis, "num_basis");
+  sr.SaveParameter(numUpdates, "num_updates");
+  sr.SaveParameter(s.n_rows, "rows");
+  sr.SaveParameter(s.n_cols, "cols");
+
+  // Only the slices which hold curvature pairs are initialized; the others
+  // aren't saved.  Each cube is saved as a matrix with its slices side by side.
+  const size_t stored = std::min(numUpdates, numBasis);
+  if (stored > 0)
+  {
+    sr.SaveParameter(arma::mat(s.memptr(), s.n_rows, s.n_cols * stored), "s");
+    sr.SaveParameter(arma::mat(y.memptr(), y.n_rows, y.n_cols * stored), "y");
+  }
+}
+
+template<typename FunctionType>
+void L_BFGS<FunctionType>::Load(const util::SaveRestoreUtility& sr)
+{
+  size_t rows, cols;
+  sr.LoadParameter(numBasis, "num_basis");
+  sr.LoadParameter(numUpdates, "num_updates");
+  sr.LoadParameter(rows, "rows");
+  sr.LoadParameter(cols, "cols");
+
+  s.set_size(rows, cols, numBasis);
+  y.set_size(rows, cols, numBasis);
+
+  const size_t stored = std::min(numUpdates, numBasis);
+  if (stored > 0)
+  {
+    arma::mat sMat, yMat;
+    sr.LoadParameter(sMat, "s");
+    sr.LoadParameter(yMat, "y");
+    if ((sMat.n_rows != rows) || (sMat.n_cols != cols * stored) ||
+        (yMat.n_rows != rows) || (yMat.n_cols != cols * stored))
+    {
+      Log::Fatal << "L_BFGS::Load(): saved curvature pairs have the wrong size!"
+          << std::endl;
+    }
+
+    for (size_t i = 0; i < stored; ++i)
+    {
+      s.slice(i) = sMat.cols(i * cols, (i + 1) * cols - 1);
+      y.slice(i) = yMat.cols(i * cols, (i + 1) * cols - 1);
+    }
+  }
+}
+
 // Convert the object to a string.
 template<typename FunctionType>
 std::string L_BFGS<FunctionType>::ToString() const
@@ -62,6 +62,11 @@ class LRSDP
   //! Modify the objective function matrix (C).
   arma::mat& C() { return function.C(); }
 
+  //! Return the mode of the C matrix (see LRSDPFunction).
+  size_t CMode() const { return function.CMode(); }
+  //! Modify the mode of the C matrix (see LRSDPFunction).
+  size_t& CMode() { return function.CMode(); }
+
   //! Return the vector of A matrices (which correspond to the constraints).
   const std::vector<arma::mat>& A() const { return function.A(); }
   //! Modify the veector of A matrices (which correspond to the constraints).
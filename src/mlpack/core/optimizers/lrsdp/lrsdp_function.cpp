@@ -7,52 +7,179 @@
  * for faster execution with the AugLagrangian optimizer.
  */
 #include "lrsdp_function.hpp"
+#include <mlpack/core/optimizers/parallel_sum/parallel_sum.hpp>
 
 using namespace mlpack;
 using namespace mlpack::optimization;
 
 LRSDPFunction::LRSDPFunction(const size_t numConstraints,
                              const arma::mat& initialPoint):
+    cMode(0),
     a(numConstraints),
     b(numConstraints),
     initialPoint(initialPoint),
     aModes(numConstraints)
-{ }
-
-double LRSDPFunction::Evaluate(const arma::mat& coordinates) const
 {
-  return -accu(coordinates * trans(coordinates));
+  aModes.zeros();
 }
 
-void LRSDPFunction::Gradient(const arma::mat& /* coordinates */,
-                     arma::mat& /* gradient */) const
+namespace {
+
+/**
+ * Return Tr(M * (R R^T)) for the matrix M with the given representation (see
+ * LRSDPFunction::AModes()), without computing R R^T.
+ */
+double TraceProduct(const arma::mat& m,
+                    const size_t mode,
+                    const arma::mat& coordinates)
 {
-  Log::Fatal << "LRSDP::Gradient() not implemented for arbitrary optimizers!"
-      << std::endl;
+  if (mode == 0)
+  {
+    // Tr(M R R^T) = sum((M R) % R).
+    return accu((m * coordinates) % coordinates);
+  }
+  else if (mode == 1)
+  {
+    // Each entry (i, j) contributes M_ij (R R^T)_ji = M_ij <r_i, r_j>.
+    double value = 0.0;
+    for (size_t k = 0; k < m.n_cols; ++k)
+      value += m(2, k) * dot(coordinates.row((size_t) m(0, k)),
+                             coordinates.row((size_t) m(1, k)));
+
+    return value;
+  }
+  else
+  {
+    // M = V V^T, so Tr(M R R^T) = ||V^T R||_F^2.
+    const arma::mat vr = trans(m) * coordinates;
+    return accu(vr % vr);
+  }
 }
 
-double LRSDPFunction::EvaluateConstraint(const size_t index,
-                                 const arma::mat& coordinates) const
+/**
+ * Add scale times the gradient of Tr(M * (R R^T)) with respect to R to the
+ * given gradient, for the matrix M with the given representation.  For dense
+ * matrices, M is assumed to be symmetric, so the gradient is 2 M R.
+ */
+void AddTraceProductGradient(const arma::mat& m,
+                             const size_t mode,
+                             const arma::mat& coordinates,
+                             const double scale,
+                             arma::mat& gradient)
 {
-  arma::mat rrt = coordinates * trans(coordinates);
-  if (aModes[index] == 0)
-    return trace(a[index] * rrt) - b[index];
+  if (mode == 0)
+  {
+    gradient += (2 * scale) * m * coordinates;
+  }
+  else if (mode == 1)
+  {
+    // (M + M^T) R, one entry at a time.
+    for (size_t k = 0; k < m.n_cols; ++k)
+    {
+      const size_t i = (size_t) m(0, k);
+      const size_t j = (size_t) m(1, k);
+      gradient.row(i) += (scale * m(2, k)) * coordinates.row(j);
+      gradient.row(j) += (scale * m(2, k)) * coordinates.row(i);
+    }
+  }
   else
   {
-    double value = -b[index];
-    for (size_t i = 0; i < a[index].n_cols; ++i)
-      value += a[index](2, i) * rrt(a[index](0, i), a[index](1, i));
+    // M = V V^T, so the gradient is 2 V (V^T R).
+    gradient += (2 * scale) * m * (trans(m) * coordinates);
+  }
+}
 
-    return value;
+/**
+ * The sum of scaled constraint gradients, sum_i scale_i * d/dR Tr(A_i R R^T),
+ * over blocks of constraints, for ParallelSum().
+ */
+class ConstraintGradientSum
+{
+ public:
+  ConstraintGradientSum(const LRSDPFunction& function,
+                        const arma::vec& scales) :
+      function(function),
+      scales(scales)
+  { }
+
+  double Block(const arma::mat& coordinates,
+               const size_t begin,
+               const size_t end,
+               arma::mat& gradient) const
+  {
+    for (size_t i = begin; i < end; ++i)
+      AddTraceProductGradient(function.A()[i], function.AModes()[i],
+          coordinates, scales[i], gradient);
+
+    return 0.0;
   }
+
+ private:
+  const LRSDPFunction& function;
+  const arma::vec& scales;
+};
+
+//! Evaluate all the constraints c_i(R) = Tr(A_i R R^T) - b_i in parallel.
+void EvaluateConstraints(const LRSDPFunction& function,
+                         const arma::mat& coordinates,
+                         arma::vec& constraints)
+{
+  constraints.set_size(function.NumConstraints());
+
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (size_t i = 0; i < constraints.n_elem; ++i)
+    constraints[i] = function.EvaluateConstraint(i, coordinates);
 }
 
-void LRSDPFunction::GradientConstraint(const size_t /* index */,
-                               const arma::mat& /* coordinates */,
-                               arma::mat& /* gradient */) const
+/**
+ * Compute the gradient of the augmented Lagrangian, 2 C R - sum_i y_i * 2 A_i R
+ * with y_i = lambda_i - sigma * c_i(R), given the constraint values.  The
+ * constraint terms are summed in parallel.
+ */
+void AugLagrangianGradient(const LRSDPFunction& function,
+                           const arma::vec& lambda,
+                           const double sigma,
+                           const arma::vec& constraints,
+                           const arma::mat& coordinates,
+                           arma::mat& gradient)
 {
-  Log::Fatal << "LRSDP::GradientConstraint() not implemented for arbitrary "
-      << "optimizers!" << std::endl;
+  const arma::vec scales = sigma * constraints - lambda;
+  const ConstraintGradientSum sum(function, scales);
+
+  gradient.set_size(coordinates.n_rows, coordinates.n_cols);
+  ParallelSum(sum, &ConstraintGradientSum::Block, coordinates,
+      function.NumConstraints(), gradient, 64);
+
+  AddTraceProductGradient(function.C(), function.CMode(), coordinates, 1.0,
+      gradient);
+}
+
+} // anonymous namespace
+
+double LRSDPFunction::Evaluate(const arma::mat& coordinates) const
+{
+  return TraceProduct(c, cMode, coordinates);
+}
+
+void LRSDPFunction::Gradient(const arma::mat& coordinates,
+                             arma::mat& gradient) const
+{
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+  AddTraceProductGradient(c, cMode, coordinates, 1.0, gradient);
+}
+
+double LRSDPFunction::EvaluateConstraint(const size_t index,
+                                         const arma::mat& coordinates) const
+{
+  return TraceProduct(a[index], aModes[index], coordinates) - b[index];
+}
+
+void LRSDPFunction::GradientConstraint(const size_t index,
+                                       const arma::mat& coordinates,
+                                       arma::mat& gradient) const
+{
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+  AddTraceProductGradient(a[index], aModes[index], coordinates, 1.0, gradient);
 }
 
 // Return a string representation of the object.
@@ -66,7 +193,7 @@ std::string LRSDPFunction::ToString() const
   convert << "  A_i modes: " << aModes.t();
   convert << "  Constraint b_i values: " << b.t();
   convert << "  Objective matrix (C) size: " << c.n_rows << "x" << c.n_cols
-      << std::endl;
+      << " (mode " << cMode << ")" << std::endl;
   return convert.str();
 }
 
@@ -82,39 +209,14 @@ double AugLagrangianFunction<LRSDPFunction>::Evaluate(
   // L(R, y, s) = Tr(C * (R R^T)) -
   //     sum_{i = 1}^{m} (y_i (Tr(A_i * (R R^T)) - b_i)) +
   //     (sigma / 2) * sum_{i = 1}^{m} (Tr(A_i * (R R^T)) - b_i)^2
+  // The constraints are evaluated in parallel, and R R^T is never formed.
+  arma::vec constraints;
+  EvaluateConstraints(function, coordinates, constraints);
 
-  // Let's start with the objective: Tr(C * (R R^T)).
-  // Simple, possibly slow solution.
-  arma::mat rrt = coordinates * trans(coordinates);
-  double objective = trace(function.C() * rrt);
-
-  // Now each constraint.
-  for (size_t i = 0; i < function.B().n_elem; ++i)
-  {
-    // Take the trace subtracted by the b_i.
-    double constraint = -function.B()[i];
-
-    if (function.AModes()[i] == 0)
-    {
-      constraint += trace(function.A()[i] * rrt);
-    }
-    else
-    {
-      for (size_t j = 0; j < function.A()[i].n_cols; ++j)
-      {
-        constraint += function.A()[i](2, j) *
-            rrt(function.A()[i](0, j), function.A()[i](1, j));
-      }
-    }
-
-    objective -= (lambda[i] * constraint);
-    objective += (sigma / 2) * std::pow(constraint, 2.0);
-  }
-
-  return objective;
+  return function.Evaluate(coordinates) - dot(lambda, constraints) +
+      (sigma / 2) * dot(constraints, constraints);
 }
 
-
 template<>
 void AugLagrangianFunction<LRSDPFunction>::Gradient(
     const arma::mat& coordinates,
@@ -125,45 +227,30 @@ void AugLagrangianFunction<LRSDPFunction>::Gradient(
   //   with
   // S' = C - sum_{i = 1}^{m} y'_i A_i
   // y'_i = y_i - sigma * (Trace(A_i * (R R^T)) - b_i)
-  arma::mat rrt = coordinates * trans(coordinates);
-  arma::mat s = function.C();
-
-  for (size_t i = 0; i < function.B().n_elem; ++i)
-  {
-    double constraint = -function.B()[i];
+  // S' is not formed either; each A_i R is added to the gradient directly.
+  arma::vec constraints;
+  EvaluateConstraints(function, coordinates, constraints);
 
-    if (function.AModes()[i] == 0)
-    {
-      constraint += trace(function.A()[i] * rrt);
-    }
-    else
-    {
-      for (size_t j = 0; j < function.A()[i].n_cols; ++j)
-      {
-        constraint += function.A()[i](2, j) *
-            rrt(function.A()[i](0, j), function.A()[i](1, j));
-      }
-    }
+  AugLagrangianGradient(function, lambda, sigma, constraints, coordinates,
+      gradient);
+}
 
-    double y = lambda[i] - sigma * constraint;
+template<>
+double AugLagrangianFunction<LRSDPFunction>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  // This is Evaluate() and Gradient() together; the constraints are only
+  // evaluated once.
+  arma::vec constraints;
+  EvaluateConstraints(function, coordinates, constraints);
 
-    if (function.AModes()[i] == 0)
-    {
-      s -= (y * function.A()[i]);
-    }
-    else
-    {
-      // We only need to subtract the entries which could be modified.
-      for (size_t j = 0; j < function.A()[i].n_cols; ++j)
-      {
-        s(function.A()[i](0, j), function.A()[i](1, j)) -= y;
-      }
-    }
-  }
+  AugLagrangianGradient(function, lambda, sigma, constraints, coordinates,
+      gradient);
 
-  gradient = 2 * s * coordinates;
+  return function.Evaluate(coordinates) - dot(lambda, constraints) +
+      (sigma / 2) * dot(constraints, constraints);
 }
 
 }; // namespace optimization
 }; // namespace mlpack
-
@@ -16,6 +16,17 @@ namespace optimization {
 
 /**
  * The objective function that LRSDP is trying to optimize.
+ *
+ * The objective matrix C and each constraint matrix A_i can be given in one of
+ * three representations, chosen by CMode() and AModes():
+ *
+ *  - 0: a dense (symmetric) n x n matrix;
+ *  - 1: a sparse matrix, given as a 3 x k matrix of its k non-zero entries,
+ *       where each column holds the row, the column, and the value of an entry;
+ *  - 2: a low-rank matrix V V^T, given as the n x k matrix V.
+ *
+ * R R^T is never formed, so with sparse and low-rank matrices the cost of each
+ * evaluation is linear in n.  The constraints are evaluated in parallel.
  */
 class LRSDPFunction
 {
@@ -29,8 +40,8 @@ class LRSDPFunction
                 const arma::mat& initialPoint);
 
   /**
-   * Evaluate the objective function of the LRSDP (no constraints) at the given
-   * coordinates.
+   * Evaluate the objective function of the LRSDP (no constraints),
+   * Tr(C * (R R^T)), at the given coordinates.
    */
   double Evaluate(const arma::mat& coordinates) const;
 
@@ -64,6 +75,11 @@ class LRSDPFunction
   //! Modify the objective function matrix (C).
   arma::mat& C() { return c; }
 
+  //! Return the mode of the C matrix.
+  size_t CMode() const { return cMode; }
+  //! Modify the mode of the C matrix.
+  size_t& CMode() { return cMode; }
+
   //! Return the vector of A matrices (which correspond to the constraints).
   const std::vector<arma::mat>& A() const { return a; }
   //! Modify the veector of A matrices (which correspond to the constraints).
@@ -85,6 +101,8 @@ class LRSDPFunction
  private:
   //! Objective function matrix c.
   arma::mat c;
+  //! 0 for a dense c, 1 for entries in matrix, 2 for low-rank.
+  size_t cMode;
   //! A_i for each constraint.
   std::vector<arma::mat> a;
   //! b_i for each constraint.
@@ -92,7 +110,7 @@ class LRSDPFunction
 
   //! Initial point.
   arma::mat initialPoint;
-  //! 1 if entries in matrix, 0 for normal.
+  //! 0 for dense, 1 for entries in matrix, 2 for low-rank.
   arma::uvec aModes;
 };
 
@@ -106,6 +124,11 @@ void AugLagrangianFunction<LRSDPFunction>::Gradient(
     const arma::mat& coordinates,
     arma::mat& gradient) const;
 
+template<>
+double AugLagrangianFunction<LRSDPFunction>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const;
+
 };
 };
 
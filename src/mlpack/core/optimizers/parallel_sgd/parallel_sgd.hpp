@@ -0,0 +1,145 @@
+/**
+ * @file parallel_sgd.hpp
+ *
+ * Lock-free parallel stochastic gradient descent, in the style of Hogwild!.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_HPP
+#define __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * An implementation of parallel stochastic gradient descent which takes the
+ * same DecomposableFunctionType as the SGD class.  Each sequence of updates
+ * through the \f$ n \f$ functions is split into disjoint contiguous parts of
+ * the (shuffled) visitation order, one for each thread, and every thread
+ * applies its updates to the shared iterate without any locking.  This is the
+ * Hogwild! scheme:
+ *
+ * @code
+ * @inproceedings{recht2011hogwild,
+ *   title={Hogwild!: A lock-free approach to parallelizing stochastic gradient
+ *       descent},
+ *   author={Recht, B. and Re, C. and Wright, S. and Niu, F.},
+ *   booktitle={Advances in Neural Information Processing Systems},
+ *   pages={693--701},
+ *   year={2011}
+ * }
+ * @endcode
+ *
+ * Updates from different threads may overwrite each other, so this only works
+ * well when the gradient of each function touches a small part of the
+ * coordinates, and collisions are rare; that is the case for matrix
+ * factorizations such as RegularizedSVDFunction, where each rating only
+ * affects one user and one item.  Only the non-zero entries of each gradient
+ * are written to the iterate.  If the DecomposableFunctionType also
+ * implements
+ *
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::sp_mat& gradient) const;
+ *
+ * it is used instead of the dense gradient, so that gradients with few
+ * non-zero entries are cheap to compute and apply.
+ *
+ * Since the order in which the threads' updates land is not fixed, the result
+ * depends on the number of threads and may vary between runs; with one thread
+ * (or without OpenMP), this is the same as SGD with a batch size of 1.  The
+ * termination criteria are the same as for SGD, but the objective is only
+ * checked after each full sequence through the functions.
+ *
+ * @tparam DecomposableFunctionType Decomposable objective function type to be
+ *     minimized.
+ */
+template<typename DecomposableFunctionType>
+class ParallelSGD
+{
+ public:
+  /**
+   * Construct the parallel SGD optimizer with the given function and
+   * parameters.
+   *
+   * @param function Function to be optimized (minimized).
+   * @param stepSize Step size for each iteration.
+   * @param maxIterations Maximum number of per-function updates, over all
+   *     threads (0 means no limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the function order is shuffled before each
+   *     sequence; otherwise, each thread visits its functions in linear order.
+   */
+  ParallelSGD(DecomposableFunctionType& function,
+              const double stepSize = 0.01,
+              const size_t maxIterations = 100000,
+              const double tolerance = 1e-5,
+              const bool shuffle = true);
+
+  /**
+   * Optimize the given function using lock-free parallel stochastic gradient
+   * descent.  The given starting point will be modified to store the finishing
+   * point of the algorithm, and the final objective value is returned.
+   *
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  double Optimize(arma::mat& iterate);
+
+  //! Get the instantiated function to be optimized.
+  const DecomposableFunctionType& Function() const { return function; }
+  //! Modify the instantiated function.
+  DecomposableFunctionType& Function() { return function; }
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Return a string representation of the object.
+  std::string ToString() const;
+
+ private:
+  //! The instantiated function.
+  DecomposableFunctionType& function;
+
+  //! The step size for each example.
+  double stepSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+
+  //! Evaluate the objective over all the functions.  The per-function values
+  //! are computed in parallel, but summed in order.
+  double Objective(const arma::mat& iterate) const;
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+// Include implementation.
+#include "parallel_sgd_impl.hpp"
+
+#endif
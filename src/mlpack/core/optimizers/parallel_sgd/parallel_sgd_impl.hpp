@@ -0,0 +1,185 @@
+/**
+ * @file parallel_sgd_impl.hpp
+ *
+ * Implementation of lock-free parallel stochastic gradient descent.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_IMPL_HPP
+#define __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_sgd.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+//! Detect whether a function can compute a sparse per-function gradient.
+HAS_MEM_FUNC(Gradient, HasSparseGradient);
+
+/**
+ * Run one sequence of updates with the sparse gradients of the functions
+ * visitationOrder[0] through visitationOrder[numUpdates - 1].  Each thread
+ * takes a contiguous part of the visitation order, and the updates are not
+ * synchronized.
+ */
+template<typename FunctionType>
+void HogwildSequence(
+    FunctionType& function,
+    arma::mat& iterate,
+    const arma::vec& visitationOrder,
+    const size_t numUpdates,
+    const double stepSize,
+    const typename boost::enable_if_c<HasSparseGradient<FunctionType,
+        void (FunctionType::*)(const arma::mat&, const size_t, arma::sp_mat&)
+        const>::value, FunctionType*>::type = 0)
+{
+  #pragma omp parallel
+  {
+    arma::sp_mat gradient;
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < numUpdates; ++i)
+    {
+      function.Gradient(iterate, (size_t) visitationOrder[i], gradient);
+
+      for (arma::sp_mat::const_iterator it = gradient.begin();
+           it != gradient.end(); ++it)
+        iterate(it.row(), it.col()) -= stepSize * (*it);
+    }
+  }
+}
+
+/**
+ * Run one sequence of updates with the dense gradients of the functions
+ * visitationOrder[0] through visitationOrder[numUpdates - 1].  Only the
+ * non-zero entries of each gradient are written, so that threads working on
+ * different coordinates don't overwrite each other's updates.
+ */
+template<typename FunctionType>
+void HogwildSequence(
+    FunctionType& function,
+    arma::mat& iterate,
+    const arma::vec& visitationOrder,
+    const size_t numUpdates,
+    const double stepSize,
+    const typename boost::disable_if_c<HasSparseGradient<FunctionType,
+        void (FunctionType::*)(const arma::mat&, const size_t, arma::sp_mat&)
+        const>::value, FunctionType*>::type = 0)
+{
+  #pragma omp parallel
+  {
+    arma::mat gradient(iterate.n_rows, iterate.n_cols);
+    double* coordinates = iterate.memptr();
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < numUpdates; ++i)
+    {
+      function.Gradient(iterate, (size_t) visitationOrder[i], gradient);
+
+      for (size_t j = 0; j < gradient.n_elem; ++j)
+        if (gradient[j] != 0.0)
+          coordinates[j] -= stepSize * gradient[j];
+    }
+  }
+}
+
+template<typename DecomposableFunctionType>
+ParallelSGD<DecomposableFunctionType>::ParallelSGD(
+    DecomposableFunctionType& function,
+    const double stepSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle) :
+    function(function),
+    stepSize(stepSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename DecomposableFunctionType>
+double ParallelSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
+{
+  // Find the number of functions to use.
+  const size_t numFunctions = function.NumFunctions();
+
+  // The threads split this into contiguous parts.
+  arma::vec visitationOrder = arma::linspace(0, (numFunctions - 1),
+      numFunctions);
+
+  // To keep track of where we are and how things are going.
+  size_t iterations = 0;
+  double overallObjective = Objective(iterate);
+  double lastObjective = DBL_MAX;
+
+  while ((maxIterations == 0) || (iterations < maxIterations))
+  {
+    // Output current objective function.
+    Log::Info << "Parallel SGD: iteration " << iterations << ", objective "
+        << overallObjective << "." << std::endl;
+
+    if (overallObjective != overallObjective)
+    {
+      Log::Warn << "Parallel SGD: converged to " << overallObjective << "; "
+          << "terminating with failure.  Try a smaller step size?"
+          << std::endl;
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Log::Info << "Parallel SGD: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    if (shuffle) // Determine order of visitation.
+      visitationOrder = arma::shuffle(visitationOrder);
+
+    // The last sequence may be cut short by the maximum number of iterations.
+    const size_t numUpdates = (maxIterations == 0) ? numFunctions :
+        std::min(numFunctions, maxIterations - iterations);
+    HogwildSequence(function, iterate, visitationOrder, numUpdates, stepSize);
+    iterations += numUpdates;
+
+    lastObjective = overallObjective;
+    overallObjective = Objective(iterate);
+  }
+
+  Log::Info << "Parallel SGD: maximum iterations (" << maxIterations << ") "
+      << "reached; terminating optimization." << std::endl;
+  return overallObjective;
+}
+
+template<typename DecomposableFunctionType>
+double ParallelSGD<DecomposableFunctionType>::Objective(
+    const arma::mat& iterate) const
+{
+  arma::vec objectives(function.NumFunctions());
+
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < objectives.n_elem; ++i)
+    objectives[i] = function.Evaluate(iterate, i);
+
+  return arma::accu(objectives);
+}
+
+// Convert the object to a string.
+template<typename DecomposableFunctionType>
+std::string ParallelSGD<DecomposableFunctionType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "ParallelSGD [" << this << "]" << std::endl;
+  convert << "  Function:" << std::endl;
+  convert << util::Indent(function.ToString(), 2);
+  convert << "  Step size: " << stepSize << std::endl;
+  convert << "  Maximum iterations: " << maxIterations << std::endl;
+  convert << "  Tolerance: " << tolerance << std::endl;
+  convert << "  Shuffle points: " << (shuffle ? "true" : "false") << std::endl;
+  return convert.str();
+}
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file parallel_sum.hpp
+ *
+ * Evaluate objective functions (and their gradients) which are sums over data
+ * points in parallel, over blocks of points.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_PARALLEL_SUM_PARALLEL_SUM_HPP
+#define __MLPACK_CORE_OPTIMIZERS_PARALLEL_SUM_PARALLEL_SUM_HPP
+
+#include <mlpack/core.hpp>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * Sum the terms of an objective function over blocks of points, in parallel.
+ * Most objectives used with L_BFGS (such as
+ * regression::LogisticRegressionFunction) are sums of terms for each data
+ * point, so these functions let them split Evaluate() and Gradient() over all
+ * cores: the points are split into blocks of blockSize consecutive points, and
+ * the blocks are given to the threads in turn (so that blocks of uneven cost,
+ * as in triangular pairwise loops, are spread evenly).  Each thread sums its
+ * blocks into its own accumulator, and the accumulators are added in thread
+ * order at the end; so the result is the same in each run with the same
+ * number of threads.
+ *
+ * The terms of each block are computed by a const member function of the
+ * objective, which must return the sum of the objective terms of points begin
+ * through (end - 1), and, in the version with a sum, add the sum of their
+ * gradient terms (or whatever else is to be summed) to the given matrix:
+ *
+ * @code
+ * double EvaluateWithGradientBlock(const arma::mat& coordinates,
+ *                                  const size_t begin,
+ *                                  const size_t end,
+ *                                  arma::mat& gradient) const;
+ *
+ * arma::mat gradient(coordinates.n_rows, coordinates.n_cols);
+ * const double objective = ParallelSum(*this,
+ *     &MyFunction::EvaluateWithGradientBlock, coordinates, numPoints,
+ *     gradient);
+ * @endcode
+ *
+ * The block function is called concurrently from several threads, so it must
+ * not modify the object.
+ *
+ * @param function Objective function.
+ * @param block Member function computing the terms of a block of points.
+ * @param coordinates Coordinates to evaluate the objective at.
+ * @param numPoints Number of points to sum over.
+ * @param sum Matrix to store the sum in; its size must be set before the call.
+ * @param blockSize Number of points in each block.
+ * @return Sum of the objective terms of all the points.
+ */
+template<typename FunctionType>
+double ParallelSum(const FunctionType& function,
+                   double (FunctionType::*block)(const arma::mat&,
+                                                 const size_t,
+                                                 const size_t,
+                                                 arma::mat&) const,
+                   const arma::mat& coordinates,
+                   const size_t numPoints,
+                   arma::mat& sum,
+                   const size_t blockSize = 256)
+{
+  const size_t numBlocks = (numPoints + blockSize - 1) / blockSize;
+
+  size_t numThreads = 1;
+#ifdef HAS_OPENMP
+  numThreads = std::max((size_t) 1, std::min(numBlocks,
+      (size_t) omp_get_max_threads()));
+#endif
+
+  // Each thread has its own accumulator.
+  std::vector<arma::mat> threadSums(numThreads);
+  arma::vec threadObjectives = arma::zeros<arma::vec>(numThreads);
+  for (size_t t = 0; t < numThreads; ++t)
+    threadSums[t].zeros(sum.n_rows, sum.n_cols);
+
+  #pragma omp parallel num_threads(numThreads) if (numThreads > 1)
+  {
+    size_t thread = 0;
+#ifdef HAS_OPENMP
+    thread = (size_t) omp_get_thread_num();
+#endif
+
+    double objective = 0.0;
+    #pragma omp for schedule(static, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(numPoints, begin + blockSize);
+      objective += (function.*block)(coordinates, begin, end,
+          threadSums[thread]);
+    }
+
+    threadObjectives[thread] = objective;
+  }
+
+  sum = threadSums[0];
+  for (size_t t = 1; t < numThreads; ++t)
+    sum += threadSums[t];
+
+  return arma::accu(threadObjectives);
+}
+
+/**
+ * Sum the objective terms of an objective function over blocks of points, in
+ * parallel, as the other overload of ParallelSum() does, but without a
+ * gradient.  The block function must return the sum of the objective terms of
+ * points begin through (end - 1):
+ *
+ * @code
+ * double EvaluateBlock(const arma::mat& coordinates,
+ *                      const size_t begin,
+ *                      const size_t end) const;
+ * @endcode
+ *
+ * @param function Objective function.
+ * @param block Member function computing the terms of a block of points.
+ * @param coordinates Coordinates to evaluate the objective at.
+ * @param numPoints Number of points to sum over.
+ * @param blockSize Number of points in each block.
+ * @return Sum of the objective terms of all the points.
+ */
+template<typename FunctionType>
+double ParallelSum(const FunctionType& function,
+                   double (FunctionType::*block)(const arma::mat&,
+                                                 const size_t,
+                                                 const size_t) const,
+                   const arma::mat& coordinates,
+                   const size_t numPoints,
+                   const size_t blockSize = 256)
+{
+  const size_t numBlocks = (numPoints + blockSize - 1) / blockSize;
+
+  // The terms of each block are stored, and summed in order.
+  arma::vec objectives(numBlocks);
+
+  #pragma omp parallel for schedule(static, 1) if (numBlocks > 1)
+  for (size_t b = 0; b < numBlocks; ++b)
+  {
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(numPoints, begin + blockSize);
+    objectives[b] = (function.*block)(coordinates, begin, end);
+  }
+
+  return arma::accu(objectives);
+}
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -8,6 +8,7 @@
 #define __MLPACK_CORE_OPTIMIZERS_SA_SA_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <boost/random.hpp>
 
 #include "exponential_schedule.hpp"
 
@@ -50,6 +51,22 @@ namespace optimization {
  * which returns the next temperature given current temperature and the value
  * of the function being optimized.
  *
+ * If the FunctionType also implements
+ *
+ *   double EvaluateDelta(const arma::mat& coordinates,
+ *                        const size_t i,
+ *                        const double change);
+ *
+ * which returns the change of the objective when coordinates[i] is increased
+ * by change (without modifying the coordinates), it is used instead of
+ * Evaluate() for each move.  Since each move only changes one parameter, this
+ * is often much cheaper than evaluating the whole function.
+ *
+ * Several independent annealing chains can be run in parallel with
+ * Optimize(iterate, chains); then the function's Evaluate() (or
+ * EvaluateDelta()) must be safe to call from several threads at once, and the
+ * cooling schedule must be copyable, since each chain gets its own copy.
+ *
  * @tparam FunctionType objective function type to be minimized.
  * @tparam CoolingScheduleType type for cooling schedule
  */
@@ -98,6 +115,20 @@ class SA
    */
   double Optimize(arma::mat& iterate);
 
+  /**
+   * Optimize the given function by running several independent simulated
+   * annealing chains from the given starting point in parallel, and keep the
+   * best final point.  Each chain starts with the temperature and move sizes
+   * of this optimizer and has its own random number generator and copy of the
+   * cooling schedule; afterwards, this optimizer takes the temperature and
+   * move sizes of the best chain.
+   *
+   * @param iterate Starting point (will be modified).
+   * @param chains Number of annealing chains to run.
+   * @return Objective value of the final point.
+   */
+  double Optimize(arma::mat& iterate, const size_t chains);
+
   //! Get the instantiated function to be optimized.
   const FunctionType& Function() const { return function; }
   //! Modify the instantiated function.
@@ -175,6 +206,21 @@ class SA
   //! Move size of each parameter.
   arma::mat moveSize;
 
+  //! Random number generator for the moves; each chain has its own.
+  boost::mt19937 randGen;
+
+  /**
+   * Run the annealing from the given point with the current temperature and
+   * move sizes, and the random number generator of this object.
+   *
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  double Anneal(arma::mat& iterate);
+
+  //! Return a uniform random number in [0, 1) from randGen.
+  double Random() { return randGen() / 4294967296.0; }
+
   /**
    * GenerateMove proposes a move on element iterate(idx), and determines if
    * that move is acceptable or not according to the Metropolis criterion.
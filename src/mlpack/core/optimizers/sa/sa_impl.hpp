@@ -12,6 +12,58 @@
 namespace mlpack {
 namespace optimization {
 
+//! Detect whether a function can compute the change of the objective for a
+//! move of one coordinate.
+HAS_MEM_FUNC(EvaluateDelta, HasEvaluateDelta);
+
+//! Whether FunctionType has a (const or non-const) EvaluateDelta().
+template<typename FunctionType>
+struct HasEvaluateDeltaMethod
+{
+  static const bool value = HasEvaluateDelta<FunctionType,
+      double (FunctionType::*)(const arma::mat&, const size_t, const double)
+      const>::value ||
+      HasEvaluateDelta<FunctionType,
+      double (FunctionType::*)(const arma::mat&, const size_t, const double)>::
+      value;
+};
+
+//! Move coordinates[i] by the given change, and return the new energy, with
+//! EvaluateDelta().
+template<typename FunctionType>
+double MoveEnergy(
+    FunctionType& function,
+    arma::mat& coordinates,
+    const size_t i,
+    const double change,
+    const double energy,
+    const typename boost::enable_if_c<
+        HasEvaluateDeltaMethod<FunctionType>::value,
+        FunctionType*>::type = 0)
+{
+  const double newEnergy = energy + function.EvaluateDelta(coordinates, i,
+      change);
+  coordinates(i) += change;
+  return newEnergy;
+}
+
+//! Move coordinates[i] by the given change, and return the new energy, with
+//! Evaluate().
+template<typename FunctionType>
+double MoveEnergy(
+    FunctionType& function,
+    arma::mat& coordinates,
+    const size_t i,
+    const double change,
+    const double /* energy */,
+    const typename boost::disable_if_c<
+        HasEvaluateDeltaMethod<FunctionType>::value,
+        FunctionType*>::type = 0)
+{
+  coordinates(i) += change;
+  return function.Evaluate(coordinates);
+}
+
 template<
     typename FunctionType,
     typename CoolingScheduleType
@@ -53,6 +105,70 @@ template<
     typename CoolingScheduleType
 >
 double SA<FunctionType, CoolingScheduleType>::Optimize(arma::mat &iterate)
+{
+  math::RandomSeed(std::time(NULL));
+  randGen.seed((uint32_t) math::RandInt(0,
+      std::numeric_limits<int>::max()));
+
+  return Anneal(iterate);
+}
+
+//! Optimize the function (minimize) with several parallel chains.
+template<
+    typename FunctionType,
+    typename CoolingScheduleType
+>
+double SA<FunctionType, CoolingScheduleType>::Optimize(arma::mat& iterate,
+                                                       const size_t chains)
+{
+  if (chains == 0)
+    Log::Fatal << "SA::Optimize(): number of chains must be positive!"
+        << std::endl;
+
+  math::RandomSeed(std::time(NULL));
+
+  // The chains are set up serially, so that their seeds only depend on the
+  // global random seed.
+  std::vector<CoolingScheduleType> schedules(chains, coolingSchedule);
+  std::vector<SA*> chainOptimizers(chains);
+  std::vector<arma::mat> iterates(chains, iterate);
+  arma::vec energies(chains);
+  for (size_t c = 0; c < chains; ++c)
+  {
+    chainOptimizers[c] = new SA(function, schedules[c], maxIterations,
+        temperature, initMoves, moveCtrlSweep, tolerance, maxToleranceSweep,
+        0.0, 0.0, gain);
+    chainOptimizers[c]->MaxMove() = maxMove;
+    chainOptimizers[c]->MoveSize() = moveSize;
+    chainOptimizers[c]->randGen.seed((uint32_t) math::RandInt(0,
+        std::numeric_limits<int>::max()));
+  }
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t c = 0; c < chains; ++c)
+    energies[c] = chainOptimizers[c]->Anneal(iterates[c]);
+
+  arma::uword best;
+  energies.min(best);
+  iterate = iterates[best];
+  temperature = chainOptimizers[best]->Temperature();
+  moveSize = chainOptimizers[best]->MoveSize();
+
+  Log::Debug << "SA: best of " << chains << " chains has objective "
+      << energies[best] << "." << std::endl;
+
+  for (size_t c = 0; c < chains; ++c)
+    delete chainOptimizers[c];
+
+  return energies[best];
+}
+
+//! Run one annealing chain.
+template<
+    typename FunctionType,
+    typename CoolingScheduleType
+>
+double SA<FunctionType, CoolingScheduleType>::Anneal(arma::mat& iterate)
 {
   const size_t rows = function.GetInitialPoint().n_rows;
   const size_t cols = function.GetInitialPoint().n_cols;
@@ -60,7 +176,6 @@ double SA<FunctionType, CoolingScheduleType>::Optimize(arma::mat &iterate)
   size_t frozenCount = 0;
   double energy = function.Evaluate(iterate);
   double oldEnergy = energy;
-  math::RandomSeed(std::time(NULL));
 
   size_t idx = 0;
   size_t sweepCounter = 0;
@@ -92,13 +207,15 @@ double SA<FunctionType, CoolingScheduleType>::Optimize(arma::mat &iterate)
       Log::Debug << "SA: minimized within tolerance " << tolerance << " for "
           << maxToleranceSweep << " sweeps after " << i << " iterations; "
           << "terminating optimization." << std::endl;
-      return energy;
+
+      // Sums of EvaluateDelta() may have drifted from the true objective.
+      return function.Evaluate(iterate);
     }
   }
 
   Log::Debug << "SA: maximum iterations (" << maxIterations << ") reached; "
       << "terminating optimization." << std::endl;
-  return energy;
+  return function.Evaluate(iterate);
 }
 
 /**
@@ -128,15 +245,14 @@ void SA<FunctionType, CoolingScheduleType>::GenerateMove(
   // MoveControl() is derived for the Laplace distribution.
 
   // Sample from a Laplace distribution with scale parameter moveSize(idx).
-  const double unif = 2.0 * math::Random() - 1.0;
+  const double unif = 2.0 * Random() - 1.0;
   const double move = (unif < 0) ? (moveSize(idx) * std::log(1 + unif)) :
       (-moveSize(idx) * std::log(1 - unif));
 
-  iterate(idx) += move;
-  energy = function.Evaluate(iterate);
+  energy = MoveEnergy(function, iterate, idx, move, energy);
   // According to the Metropolis criterion, accept the move with probability
   // min{1, exp(-(E_new - E_old) / T)}.
-  const double xi = math::Random();
+  const double xi = Random();
   const double delta = energy - prevEnergy;
   const double criterion = std::exp(-delta / temperature);
   if (delta <= 0. || criterion > xi)
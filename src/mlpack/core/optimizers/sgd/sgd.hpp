@@ -9,6 +9,12 @@
 
 #include <mlpack/core.hpp>
 
+#include "update_policies/vanilla_update.hpp"
+#include "update_policies/momentum_update.hpp"
+#include "update_policies/adagrad_update.hpp"
+#include "update_policies/rmsprop_update.hpp"
+#include "update_policies/adam_update.hpp"
+
 namespace mlpack {
 namespace optimization {
 
@@ -64,6 +70,29 @@ namespace optimization {
  * objective function on the first point in the dataset (presumably, the dataset
  * is held internally in the DecomposableFunctionType).
  *
+ * SGD can also update the iterate with the average gradient of a mini-batch of
+ * consecutive functions, instead of a single function (see the batchSize
+ * parameter); the batches are then visited in linear or in shuffled order.  If
+ * the DecomposableFunctionType also implements
+ *
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t begin,
+ *                 const size_t batchSize,
+ *                 arma::mat& gradient) const;
+ *
+ * which stores the sum of the gradients of functions begin through
+ * (begin + batchSize - 1) in gradient, it is used for each mini-batch, so that
+ * the whole batch can be handled with matrix-matrix operations.  Otherwise,
+ * the per-function gradients are summed.
+ *
+ * How the iterate is moved along each gradient is decided by an update policy
+ * (see VanillaUpdate for the interface), given to Optimize().  Besides the
+ * plain step of the equation above (VanillaUpdate, the default), there are
+ * MomentumUpdate, AdaGradUpdate, RMSPropUpdate and AdamUpdate.  Methods which
+ * take the optimizer as a template template parameter can use MomentumSGD,
+ * AdaGradSGD, RMSPropSGD or AdamSGD (see update_policy_sgd.hpp), which fix the
+ * update policy.
+ *
  * @tparam DecomposableFunctionType Decomposable objective function type to be
  *     minimized.
  */
@@ -81,12 +110,15 @@ class SGD
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param shuffle If true, the function order is shuffled; otherwise, each
    *     function is visited in linear order.
+   * @param batchSize Number of consecutive functions whose average gradient is
+   *     used for each update; each update counts as one iteration.
    */
   SGD(DecomposableFunctionType& function,
       const double stepSize = 0.01,
       const size_t maxIterations = 100000,
       const double tolerance = 1e-5,
-      const bool shuffle = true);
+      const bool shuffle = true,
+      const size_t batchSize = 1);
 
   /**
    * Optimize the given function using stochastic gradient descent.  The given
@@ -98,6 +130,18 @@ class SGD
    */
   double Optimize(arma::mat& iterate);
 
+  /**
+   * Optimize the given function using stochastic gradient descent, moving the
+   * iterate with the given update policy.  The policy is initialized with the
+   * size of the iterate before the first update.
+   *
+   * @param iterate Starting point (will be modified).
+   * @param updatePolicy Policy used to update the iterate with each gradient.
+   * @return Objective value of the final point.
+   */
+  template<typename UpdatePolicyType>
+  double Optimize(arma::mat& iterate, UpdatePolicyType& updatePolicy);
+
   //! Get the instantiated function to be optimized.
   const DecomposableFunctionType& Function() const { return function; }
   //! Modify the instantiated function.
@@ -123,6 +167,11 @@ class SGD
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get the number of functions in each mini-batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of functions in each mini-batch.
+  size_t& BatchSize() { return batchSize; }
+
   // convert the obkect into a string
   std::string ToString() const;
 
@@ -142,6 +191,9 @@ class SGD
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! The number of functions in each mini-batch.
+  size_t batchSize;
 };
 
 }; // namespace optimization
@@ -150,4 +202,7 @@ class SGD
 // Include implementation.
 #include "sgd_impl.hpp"
 
+// Include the optimizers with a fixed update policy.
+#include "update_policy_sgd.hpp"
+
 #endif
@@ -14,34 +14,92 @@
 namespace mlpack {
 namespace optimization {
 
+//! Detect whether a function can compute the gradient of a mini-batch at once.
+HAS_MEM_FUNC(Gradient, HasBatchGradient);
+
+//! Let the function compute the summed gradient of the mini-batch at once.
+template<typename FunctionType>
+void BatchGradient(
+    const FunctionType& function,
+    const arma::mat& iterate,
+    const size_t begin,
+    const size_t batchSize,
+    arma::mat& gradient,
+    const typename boost::enable_if_c<HasBatchGradient<FunctionType,
+        void (FunctionType::*)(const arma::mat&, const size_t, const size_t,
+        arma::mat&) const>::value, FunctionType*>::type = 0)
+{
+  function.Gradient(iterate, begin, batchSize, gradient);
+}
+
+//! The function has no mini-batch gradient, so sum the gradients of each
+//! function in the mini-batch.
+template<typename FunctionType>
+void BatchGradient(
+    FunctionType& function,
+    const arma::mat& iterate,
+    const size_t begin,
+    const size_t batchSize,
+    arma::mat& gradient,
+    const typename boost::disable_if_c<HasBatchGradient<FunctionType,
+        void (FunctionType::*)(const arma::mat&, const size_t, const size_t,
+        arma::mat&) const>::value, FunctionType*>::type = 0)
+{
+  function.Gradient(iterate, begin, gradient);
+
+  arma::mat pointGradient(gradient.n_rows, gradient.n_cols);
+  for (size_t i = begin + 1; i < begin + batchSize; ++i)
+  {
+    function.Gradient(iterate, i, pointGradient);
+    gradient += pointGradient;
+  }
+}
+
 template<typename DecomposableFunctionType>
 SGD<DecomposableFunctionType>::SGD(DecomposableFunctionType& function,
                                    const double stepSize,
                                    const size_t maxIterations,
                                    const double tolerance,
-                                   const bool shuffle) :
+                                   const bool shuffle,
+                                   const size_t batchSize) :
     function(function),
     stepSize(stepSize),
     maxIterations(maxIterations),
     tolerance(tolerance),
-    shuffle(shuffle)
-{ /* Nothing to do. */ }
+    shuffle(shuffle),
+    batchSize(batchSize)
+{
+  if (batchSize == 0)
+    Log::Fatal << "SGD::SGD(): batch size must be positive!" << std::endl;
+}
 
 //! Optimize the function (minimize).
 template<typename DecomposableFunctionType>
 double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
 {
-  // Find the number of functions to use.
+  VanillaUpdate updatePolicy;
+  return Optimize(iterate, updatePolicy);
+}
+
+//! Optimize the function (minimize) with the given update policy.
+template<typename DecomposableFunctionType>
+template<typename UpdatePolicyType>
+double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate,
+                                               UpdatePolicyType& updatePolicy)
+{
+  // Find the number of functions to use.  Each mini-batch holds batchSize
+  // consecutive functions, except perhaps the last one.
   const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
 
   // This is used only if shuffle is true.
   arma::vec visitationOrder;
   if (shuffle)
-    visitationOrder = arma::shuffle(arma::linspace(0, (numFunctions - 1),
-        numFunctions));
+    visitationOrder = arma::shuffle(arma::linspace(0, (numBatches - 1),
+        numBatches));
 
   // To keep track of where we are and how things are going.
-  size_t currentFunction = 0;
+  size_t currentBatch = 0;
   double overallObjective = 0;
   double lastObjective = DBL_MAX;
 
@@ -50,11 +108,12 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
     overallObjective += function.Evaluate(iterate, i);
 
   // Now iterate!
+  updatePolicy.Initialize(iterate.n_rows, iterate.n_cols);
   arma::mat gradient(iterate.n_rows, iterate.n_cols);
-  for (size_t i = 1; i != maxIterations; ++i, ++currentFunction)
+  for (size_t i = 1; i != maxIterations; ++i, ++currentBatch)
   {
     // Is this iteration the start of a sequence?
-    if ((currentFunction % numFunctions) == 0)
+    if ((currentBatch % numBatches) == 0)
     {
       // Output current objective function.
       Log::Info << "SGD: iteration " << i << ", objective " << overallObjective
@@ -77,27 +136,35 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
       // Reset the counter variables.
       lastObjective = overallObjective;
       overallObjective = 0;
-      currentFunction = 0;
+      currentBatch = 0;
 
       if (shuffle) // Determine order of visitation.
         visitationOrder = arma::shuffle(visitationOrder);
     }
 
-    // Evaluate the gradient for this iteration.
-    if (shuffle)
-      function.Gradient(iterate, visitationOrder[currentFunction], gradient);
-    else
-      function.Gradient(iterate, currentFunction, gradient);
+    // Find the functions in this iteration's batch.
+    const size_t batch = shuffle ? (size_t) visitationOrder[currentBatch] :
+        currentBatch;
+    const size_t begin = batch * batchSize;
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - begin);
 
-    // And update the iterate.
-    iterate -= stepSize * gradient;
+    // Evaluate the (average) gradient for this iteration, and update the
+    // iterate.
+    if (effectiveBatchSize == 1)
+    {
+      function.Gradient(iterate, begin, gradient);
+    }
+    else
+    {
+      BatchGradient(function, iterate, begin, effectiveBatchSize, gradient);
+      gradient /= effectiveBatchSize;
+    }
+    updatePolicy.Update(iterate, stepSize, gradient);
 
     // Now add that to the overall objective function.
-    if (shuffle)
-      overallObjective += function.Evaluate(iterate,
-          visitationOrder[currentFunction]);
-    else
-      overallObjective += function.Evaluate(iterate, currentFunction);
+    for (size_t j = begin; j < begin + effectiveBatchSize; ++j)
+      overallObjective += function.Evaluate(iterate, j);
   }
 
   Log::Info << "SGD: maximum iterations (" << maxIterations << ") reached; "
@@ -121,6 +188,7 @@ std::string SGD<DecomposableFunctionType>::ToString() const
   convert << "  Maximum iterations: " << maxIterations << std::endl;
   convert << "  Tolerance: " << tolerance << std::endl;
   convert << "  Shuffle points: " << (shuffle ? "true" : "false") << std::endl;
+  convert << "  Batch size: " << batchSize << std::endl;
   return convert.str();
 }
 
@@ -0,0 +1,82 @@
+/**
+ * @file adagrad_update.hpp
+ *
+ * AdaGrad update for SGD.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_ADAGRAD_UPDATE_HPP
+#define __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_ADAGRAD_UPDATE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * AdaGrad scales the step of each coordinate by the inverse square root of the
+ * sum of its squared past gradients, so that rarely updated coordinates take
+ * larger steps:
+ *
+ * \f[
+ * G_{j + 1} = G_j + \nabla f_i(A_j)^2, \qquad
+ * A_{j + 1} = A_j - \alpha \frac{\nabla f_i(A_j)}{\sqrt{G_{j + 1}} + \epsilon}.
+ * \f]
+ *
+ * @code
+ * @article{duchi2011adaptive,
+ *   title={Adaptive subgradient methods for online learning and stochastic
+ *       optimization},
+ *   author={Duchi, J. and Hazan, E. and Singer, Y.},
+ *   journal={Journal of Machine Learning Research},
+ *   volume={12},
+ *   pages={2121--2159},
+ *   year={2011}
+ * }
+ * @endcode
+ */
+class AdaGradUpdate
+{
+ public:
+  /**
+   * Construct the AdaGrad update policy.
+   *
+   * @param epsilon Value added to the denominator, to avoid division by zero.
+   */
+  AdaGradUpdate(const double epsilon = 1e-8) : epsilon(epsilon) { }
+
+  //! Allocate the sums of squared gradients and set them to zero.
+  void Initialize(const size_t rows, const size_t cols)
+  {
+    squaredGradient.zeros(rows, cols);
+  }
+
+  /**
+   * Update the iterate with the given gradient.
+   *
+   * @param iterate Iterate to update.
+   * @param stepSize Step size of the optimizer.
+   * @param gradient Gradient of the objective at the iterate.
+   */
+  void Update(arma::mat& iterate,
+              const double stepSize,
+              const arma::mat& gradient)
+  {
+    squaredGradient += arma::square(gradient);
+    iterate -= stepSize * gradient / (arma::sqrt(squaredGradient) + epsilon);
+  }
+
+  //! Get the value added to the denominator.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value added to the denominator.
+  double& Epsilon() { return epsilon; }
+
+ private:
+  //! The value added to the denominator.
+  double epsilon;
+  //! The sum of the squared gradients of each coordinate.
+  arma::mat squaredGradient;
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file adam_update.hpp
+ *
+ * Adam update for SGD.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_ADAM_UPDATE_HPP
+#define __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_ADAM_UPDATE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * Adam keeps running averages of both the gradients and the squared gradients,
+ * corrects them for their initialization at zero, and steps along the average
+ * gradient scaled by the inverse square root of the average squared gradient:
+ *
+ * \f[
+ * m_{j + 1} = \beta_1 m_j + (1 - \beta_1) \nabla f_i(A_j), \qquad
+ * v_{j + 1} = \beta_2 v_j + (1 - \beta_2) \nabla f_i(A_j)^2,
+ * \f]
+ * \f[
+ * A_{j + 1} = A_j - \alpha
+ *     \frac{\sqrt{1 - \beta_2^{j + 1}}}{1 - \beta_1^{j + 1}}
+ *     \frac{m_{j + 1}}{\sqrt{v_{j + 1}} + \epsilon}.
+ * \f]
+ *
+ * @code
+ * @inproceedings{kingma2015adam,
+ *   title={Adam: A method for stochastic optimization},
+ *   author={Kingma, D. and Ba, J.},
+ *   booktitle={International Conference on Learning Representations},
+ *   year={2015}
+ * }
+ * @endcode
+ */
+class AdamUpdate
+{
+ public:
+  /**
+   * Construct the Adam update policy.
+   *
+   * @param beta1 Decay of the running average of the gradients.
+   * @param beta2 Decay of the running average of the squared gradients.
+   * @param epsilon Value added to the denominator, to avoid division by zero.
+   */
+  AdamUpdate(const double beta1 = 0.9,
+             const double beta2 = 0.999,
+             const double epsilon = 1e-8) :
+      beta1(beta1),
+      beta2(beta2),
+      epsilon(epsilon),
+      iteration(0)
+  {
+    if (beta1 < 0.0 || beta1 >= 1.0 || beta2 < 0.0 || beta2 >= 1.0)
+    {
+      Log::Fatal << "AdamUpdate::AdamUpdate(): beta1 (" << beta1 << ") and "
+          << "beta2 (" << beta2 << ") must be in [0, 1)!" << std::endl;
+    }
+  }
+
+  //! Allocate the running averages and set them to zero.
+  void Initialize(const size_t rows, const size_t cols)
+  {
+    meanGradient.zeros(rows, cols);
+    meanSquaredGradient.zeros(rows, cols);
+    iteration = 0;
+  }
+
+  /**
+   * Update the iterate with the given gradient.
+   *
+   * @param iterate Iterate to update.
+   * @param stepSize Step size of the optimizer.
+   * @param gradient Gradient of the objective at the iterate.
+   */
+  void Update(arma::mat& iterate,
+              const double stepSize,
+              const arma::mat& gradient)
+  {
+    ++iteration;
+
+    meanGradient *= beta1;
+    meanGradient += (1 - beta1) * gradient;
+    meanSquaredGradient *= beta2;
+    meanSquaredGradient += (1 - beta2) * arma::square(gradient);
+
+    // The bias corrections of both averages are folded into the step size.
+    const double correctedStepSize = stepSize *
+        std::sqrt(1 - std::pow(beta2, (double) iteration)) /
+        (1 - std::pow(beta1, (double) iteration));
+    iterate -= correctedStepSize * meanGradient /
+        (arma::sqrt(meanSquaredGradient) + epsilon);
+  }
+
+  //! Get the decay of the running average of the gradients.
+  double Beta1() const { return beta1; }
+  //! Modify the decay of the running average of the gradients.
+  double& Beta1() { return beta1; }
+
+  //! Get the decay of the running average of the squared gradients.
+  double Beta2() const { return beta2; }
+  //! Modify the decay of the running average of the squared gradients.
+  double& Beta2() { return beta2; }
+
+  //! Get the value added to the denominator.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value added to the denominator.
+  double& Epsilon() { return epsilon; }
+
+ private:
+  //! The decay of the running average of the gradients.
+  double beta1;
+  //! The decay of the running average of the squared gradients.
+  double beta2;
+  //! The value added to the denominator.
+  double epsilon;
+  //! The number of updates since Initialize().
+  size_t iteration;
+  //! The running average of the gradients.
+  arma::mat meanGradient;
+  //! The running average of the squared gradients.
+  arma::mat meanSquaredGradient;
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file momentum_update.hpp
+ *
+ * SGD update with momentum.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_MOMENTUM_UPDATE_HPP
+#define __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_MOMENTUM_UPDATE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * The momentum update accumulates a velocity from the past gradients, and
+ * moves the iterate along it:
+ *
+ * \f[
+ * v_{j + 1} = \mu v_j - \alpha \nabla f_i(A_j), \qquad
+ * A_{j + 1} = A_j + v_{j + 1}
+ * \f]
+ *
+ * where \f$ \mu \f$ is the momentum.  This damps the oscillations of plain SGD
+ * across narrow valleys, and speeds it up along them.
+ */
+class MomentumUpdate
+{
+ public:
+  /**
+   * Construct the momentum update policy.
+   *
+   * @param momentum Fraction of the velocity kept at each update (between 0
+   *     and 1).
+   */
+  MomentumUpdate(const double momentum = 0.5) : momentum(momentum)
+  {
+    if (momentum < 0.0 || momentum >= 1.0)
+    {
+      Log::Fatal << "MomentumUpdate::MomentumUpdate(): momentum (" << momentum
+          << ") must be in [0, 1)!" << std::endl;
+    }
+  }
+
+  //! Allocate the velocity and set it to zero.
+  void Initialize(const size_t rows, const size_t cols)
+  {
+    velocity.zeros(rows, cols);
+  }
+
+  /**
+   * Update the iterate with the given gradient.
+   *
+   * @param iterate Iterate to update.
+   * @param stepSize Step size of the optimizer.
+   * @param gradient Gradient of the objective at the iterate.
+   */
+  void Update(arma::mat& iterate,
+              const double stepSize,
+              const arma::mat& gradient)
+  {
+    velocity *= momentum;
+    velocity -= stepSize * gradient;
+    iterate += velocity;
+  }
+
+  //! Get the momentum.
+  double Momentum() const { return momentum; }
+  //! Modify the momentum.
+  double& Momentum() { return momentum; }
+
+ private:
+  //! The fraction of the velocity kept at each update.
+  double momentum;
+  //! The current velocity.
+  arma::mat velocity;
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
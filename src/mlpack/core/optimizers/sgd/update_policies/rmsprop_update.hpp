@@ -0,0 +1,92 @@
+/**
+ * @file rmsprop_update.hpp
+ *
+ * RMSProp update for SGD.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_RMSPROP_UPDATE_HPP
+#define __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_RMSPROP_UPDATE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * RMSProp is like AdaGrad, but it scales the step of each coordinate by a
+ * running average of the squared gradients instead of their sum, so that the
+ * steps don't shrink towards zero:
+ *
+ * \f[
+ * E_{j + 1} = \beta E_j + (1 - \beta) \nabla f_i(A_j)^2, \qquad
+ * A_{j + 1} = A_j - \alpha \frac{\nabla f_i(A_j)}{\sqrt{E_{j + 1}} + \epsilon}.
+ * \f]
+ *
+ * RMSProp was proposed by G. Hinton in his lecture "Neural Networks for
+ * Machine Learning" (Coursera, 2012).
+ */
+class RMSPropUpdate
+{
+ public:
+  /**
+   * Construct the RMSProp update policy.
+   *
+   * @param decay Decay of the running average of the squared gradients.
+   * @param epsilon Value added to the denominator, to avoid division by zero.
+   */
+  RMSPropUpdate(const double decay = 0.99, const double epsilon = 1e-8) :
+      decay(decay),
+      epsilon(epsilon)
+  {
+    if (decay < 0.0 || decay >= 1.0)
+    {
+      Log::Fatal << "RMSPropUpdate::RMSPropUpdate(): decay (" << decay << ") "
+          << "must be in [0, 1)!" << std::endl;
+    }
+  }
+
+  //! Allocate the averages of squared gradients and set them to zero.
+  void Initialize(const size_t rows, const size_t cols)
+  {
+    meanSquaredGradient.zeros(rows, cols);
+  }
+
+  /**
+   * Update the iterate with the given gradient.
+   *
+   * @param iterate Iterate to update.
+   * @param stepSize Step size of the optimizer.
+   * @param gradient Gradient of the objective at the iterate.
+   */
+  void Update(arma::mat& iterate,
+              const double stepSize,
+              const arma::mat& gradient)
+  {
+    meanSquaredGradient *= decay;
+    meanSquaredGradient += (1 - decay) * arma::square(gradient);
+    iterate -= stepSize * gradient / (arma::sqrt(meanSquaredGradient) +
+        epsilon);
+  }
+
+  //! Get the decay of the running average.
+  double Decay() const { return decay; }
+  //! Modify the decay of the running average.
+  double& Decay() { return decay; }
+
+  //! Get the value added to the denominator.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value added to the denominator.
+  double& Epsilon() { return epsilon; }
+
+ private:
+  //! The decay of the running average.
+  double decay;
+  //! The value added to the denominator.
+  double epsilon;
+  //! The running average of the squared gradients of each coordinate.
+  arma::mat meanSquaredGradient;
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @file vanilla_update.hpp
+ *
+ * The plain SGD update, which steps against the gradient.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_VANILLA_UPDATE_HPP
+#define __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICIES_VANILLA_UPDATE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * The update policy used by SGD by default: the iterate takes a step of the
+ * given step size against the gradient,
+ *
+ * \f[
+ * A_{j + 1} = A_j - \alpha \nabla f_i(A_j).
+ * \f]
+ *
+ * An update policy for SGD must implement the following two functions:
+ *
+ *   void Initialize(const size_t rows, const size_t cols);
+ *   void Update(arma::mat& iterate,
+ *               const double stepSize,
+ *               const arma::mat& gradient);
+ *
+ * Initialize() is called once by SGD::Optimize(), with the size of the
+ * iterate, so that any state the policy needs can be allocated before the
+ * first update.
+ */
+class VanillaUpdate
+{
+ public:
+  //! The plain update keeps no state.
+  void Initialize(const size_t /* rows */, const size_t /* cols */) { }
+
+  /**
+   * Update the iterate with the given gradient.
+   *
+   * @param iterate Iterate to update.
+   * @param stepSize Step size of the optimizer.
+   * @param gradient Gradient of the objective at the iterate.
+   */
+  void Update(arma::mat& iterate,
+              const double stepSize,
+              const arma::mat& gradient)
+  {
+    iterate -= stepSize * gradient;
+  }
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file update_policy_sgd.hpp
+ *
+ * SGD optimizers with a fixed update policy, for use as template template
+ * parameters (as in LogisticRegression<AdamSGD>).
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICY_SGD_HPP
+#define __MLPACK_CORE_OPTIMIZERS_SGD_UPDATE_POLICY_SGD_HPP
+
+#include "sgd.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * SGD which always moves the iterate with the given update policy.  The policy
+ * object (and its parameters) is held by the optimizer, and its state is
+ * reset at the start of each call to Optimize().
+ *
+ * Methods such as LogisticRegression take their optimizer as a template with
+ * one parameter, so UpdatePolicySGD can't be given to them directly; use
+ * MomentumSGD, AdaGradSGD, RMSPropSGD or AdamSGD instead.
+ *
+ * @tparam DecomposableFunctionType Decomposable objective function type to be
+ *     minimized.
+ * @tparam UpdatePolicyType Policy used to update the iterate.
+ */
+template<typename DecomposableFunctionType, typename UpdatePolicyType>
+class UpdatePolicySGD : public SGD<DecomposableFunctionType>
+{
+ public:
+  /**
+   * Construct the optimizer with the given function, SGD parameters, and
+   * update policy (see the SGD constructor for the other parameters).
+   *
+   * @param updatePolicy Update policy, with its parameters.
+   */
+  UpdatePolicySGD(DecomposableFunctionType& function,
+                  const double stepSize,
+                  const size_t maxIterations,
+                  const double tolerance,
+                  const bool shuffle,
+                  const size_t batchSize,
+                  const UpdatePolicyType& updatePolicy) :
+      SGD<DecomposableFunctionType>(function, stepSize, maxIterations,
+          tolerance, shuffle, batchSize),
+      updatePolicy(updatePolicy)
+  { /* Nothing to do. */ }
+
+  /**
+   * Optimize the given function with the update policy of this optimizer.
+   *
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  double Optimize(arma::mat& iterate)
+  {
+    return SGD<DecomposableFunctionType>::Optimize(iterate, updatePolicy);
+  }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+ private:
+  //! The update policy.
+  UpdatePolicyType updatePolicy;
+};
+
+/**
+ * SGD with momentum (see MomentumUpdate).
+ */
+template<typename DecomposableFunctionType>
+class MomentumSGD :
+    public UpdatePolicySGD<DecomposableFunctionType, MomentumUpdate>
+{
+ public:
+  //! Construct the optimizer; see SGD and MomentumUpdate for the parameters.
+  MomentumSGD(DecomposableFunctionType& function,
+              const double stepSize = 0.01,
+              const size_t maxIterations = 100000,
+              const double tolerance = 1e-5,
+              const bool shuffle = true,
+              const size_t batchSize = 1,
+              const MomentumUpdate& updatePolicy = MomentumUpdate()) :
+      UpdatePolicySGD<DecomposableFunctionType, MomentumUpdate>(function,
+          stepSize, maxIterations, tolerance, shuffle, batchSize, updatePolicy)
+  { /* Nothing to do. */ }
+};
+
+/**
+ * SGD with AdaGrad step sizes (see AdaGradUpdate).
+ */
+template<typename DecomposableFunctionType>
+class AdaGradSGD :
+    public UpdatePolicySGD<DecomposableFunctionType, AdaGradUpdate>
+{
+ public:
+  //! Construct the optimizer; see SGD and AdaGradUpdate for the parameters.
+  AdaGradSGD(DecomposableFunctionType& function,
+             const double stepSize = 0.01,
+             const size_t maxIterations = 100000,
+             const double tolerance = 1e-5,
+             const bool shuffle = true,
+             const size_t batchSize = 1,
+             const AdaGradUpdate& updatePolicy = AdaGradUpdate()) :
+      UpdatePolicySGD<DecomposableFunctionType, AdaGradUpdate>(function,
+          stepSize, maxIterations, tolerance, shuffle, batchSize, updatePolicy)
+  { /* Nothing to do. */ }
+};
+
+/**
+ * SGD with RMSProp step sizes (see RMSPropUpdate).
+ */
+template<typename DecomposableFunctionType>
+class RMSPropSGD :
+    public UpdatePolicySGD<DecomposableFunctionType, RMSPropUpdate>
+{
+ public:
+  //! Construct the optimizer; see SGD and RMSPropUpdate for the parameters.
+  RMSPropSGD(DecomposableFunctionType& function,
+             const double stepSize = 0.01,
+             const size_t maxIterations = 100000,
+             const double tolerance = 1e-5,
+             const bool shuffle = true,
+             const size_t batchSize = 1,
+             const RMSPropUpdate& updatePolicy = RMSPropUpdate()) :
+      UpdatePolicySGD<DecomposableFunctionType, RMSPropUpdate>(function,
+          stepSize, maxIterations, tolerance, shuffle, batchSize, updatePolicy)
+  { /* Nothing to do. */ }
+};
+
+/**
+ * SGD with Adam updates (see AdamUpdate).
+ */
+template<typename DecomposableFunctionType>
+class AdamSGD : public UpdatePolicySGD<DecomposableFunctionType, AdamUpdate>
+{
+ public:
+  //! Construct the optimizer; see SGD and AdamUpdate for the parameters.
+  AdamSGD(DecomposableFunctionType& function,
+          const double stepSize = 0.001,
+          const size_t maxIterations = 100000,
+          const double tolerance = 1e-5,
+          const bool shuffle = true,
+          const size_t batchSize = 1,
+          const AdamUpdate& updatePolicy = AdamUpdate()) :
+      UpdatePolicySGD<DecomposableFunctionType, AdamUpdate>(function,
+          stepSize, maxIterations, tolerance, shuffle, batchSize, updatePolicy)
+  { /* Nothing to do. */ }
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
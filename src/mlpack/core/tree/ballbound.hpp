@@ -92,6 +92,10 @@ class BallBound
   //! Get the dimensionality of the ball.
   double Dim() const { return center.n_elem; }
 
+  //! Reset the bound so that it contains nothing; the next points added with
+  //! operator|=() will set the center.
+  void Clear() { radius = -DBL_MAX; }
+
   /**
    * Get the minimum width of the bound (this is same as the diameter).
    * For ball bounds, width along all dimensions remain same.
@@ -104,7 +108,8 @@ class BallBound
   /**
    * Determines if a point is within this bound.
    */
-  bool Contains(const VecType& point) const;
+  template<typename OtherVecType>
+  bool Contains(const OtherVecType& point) const;
 
   /**
    * Place the centroid of BallBound into the given vector.
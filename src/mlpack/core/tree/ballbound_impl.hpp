@@ -95,7 +95,8 @@ math::Range BallBound<VecType, TMetricType>::operator[](const size_t i) const
  * Determines if a point is within the bound.
  */
 template<typename VecType, typename TMetricType>
-bool BallBound<VecType, TMetricType>::Contains(const VecType& point) const
+template<typename OtherVecType>
+bool BallBound<VecType, TMetricType>::Contains(const OtherVecType& point) const
 {
   if (radius < 0)
     return false;
@@ -235,14 +236,15 @@ BallBound<VecType, TMetricType>::operator|=(const MatType& data)
   // Now iteratively add points.
   for (size_t i = 0; i < data.n_cols; ++i)
   {
-    const double dist = metric->Evaluate(center, (VecType) data.col(i));
+    // The point is not converted to VecType, so sparse points stay sparse.
+    const double dist = metric->Evaluate(center, data.col(i));
 
     // See if the new point lies outside the bound.
     if (dist > radius)
     {
       // Move towards the new point and increase the radius just enough to
       // accomodate the new point.
-      arma::vec diff = data.col(i) - center;
+      arma::Col<typename VecType::elem_type> diff = data.col(i) - center;
       center += ((dist - radius) / (2 * dist)) * diff;
       radius = 0.5 * (dist + radius);
     }
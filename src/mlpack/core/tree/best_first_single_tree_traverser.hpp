@@ -0,0 +1,164 @@
+/**
+ * @file best_first_single_tree_traverser.hpp
+ *
+ * A single-tree traverser for any tree type, which visits the nodes in order of
+ * their scores with a priority queue, and can stop each traversal after a given
+ * number of leaves or base cases, for approximate search with a bounded cost
+ * for each query point.
+ */
+#ifndef __MLPACK_CORE_TREE_BEST_FIRST_SINGLE_TREE_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_BEST_FIRST_SINGLE_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+
+#include "tree_traits.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The BestFirstSingleTreeTraverser traverses a tree with the given point and
+ * set of rules, always visiting next the node with the best (lowest) score of
+ * all the nodes found so far which have not been pruned, instead of descending
+ * depth-first.  Because the most promising nodes are visited first, the
+ * traversal can be stopped early and still give good results; a budget on the
+ * number of leaves visited and on the number of base cases evaluated for each
+ * query point can be given.  With no budget (the default), the traversal gives
+ * the same results as the depth-first traversers.
+ *
+ * This only uses the generic tree interface (IsLeaf(), NumChildren(), Child(),
+ * NumPoints(), Point() and Parent()), so it works with any tree type.  For tree
+ * types where the first point of a node is its centroid (see TreeTraits), the
+ * base case with the point of each node is evaluated when the node is scored,
+ * as the depth-first cover tree traverser does, so that rules can reuse the
+ * result of Score().
+ *
+ * @code
+ * BestFirstSingleTreeTraverser<TreeType, RuleType> traverser(rules, 5);
+ * for (size_t i = 0; i < querySet.n_cols; ++i)
+ *   traverser.Traverse(i, *referenceTree); // Visit at most 5 leaves.
+ * @endcode
+ *
+ * @tparam TreeType Type of tree to traverse.
+ * @tparam RuleType Type of rules to traverse the tree with.
+ */
+template<typename TreeType, typename RuleType>
+class BestFirstSingleTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the traverser with the given rule set and budget.  A budget of
+   * 0 means that there is no limit.
+   *
+   * @param rule Rules to traverse the tree with.
+   * @param maxLeaves Maximum number of leaves to visit for each query point.
+   * @param maxBaseCases Maximum number of base cases to evaluate for each query
+   *     point.
+   */
+  BestFirstSingleTreeTraverser(RuleType& rule,
+                               const size_t maxLeaves = 0,
+                               const size_t maxBaseCases = 0);
+
+  /**
+   * Traverse the tree with the given point, until every node is visited or
+   * pruned, or the budget is used up.
+   *
+   * @param queryIndex The index of the point in the query set which is being
+   *     used as the query point.
+   * @param referenceNode The tree node to be traversed.
+   */
+  void Traverse(const size_t queryIndex, TreeType& referenceNode);
+
+  //! Get the maximum number of leaves to visit for each query point.
+  size_t MaxLeaves() const { return maxLeaves; }
+  //! Modify the maximum number of leaves to visit for each query point.
+  size_t& MaxLeaves() { return maxLeaves; }
+
+  //! Get the maximum number of base cases for each query point.
+  size_t MaxBaseCases() const { return maxBaseCases; }
+  //! Modify the maximum number of base cases for each query point.
+  size_t& MaxBaseCases() { return maxBaseCases; }
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! Get the number of leaves visited.
+  size_t NumLeaves() const { return numLeaves; }
+  //! Modify the number of leaves visited.
+  size_t& NumLeaves() { return numLeaves; }
+
+  //! Get the number of base cases evaluated.
+  size_t NumBaseCases() const { return numBaseCases; }
+  //! Modify the number of base cases evaluated.
+  size_t& NumBaseCases() { return numBaseCases; }
+
+  //! Get the number of traversals which were stopped by the budget.
+  size_t NumStopped() const { return numStopped; }
+  //! Modify the number of traversals which were stopped by the budget.
+  size_t& NumStopped() { return numStopped; }
+
+ private:
+  //! A node waiting to be visited, with its score.
+  struct QueueEntry
+  {
+    //! The node.
+    TreeType* node;
+    //! The score of the node.
+    double score;
+
+    //! Order entries so that the priority queue gives the lowest score first.
+    bool operator<(const QueueEntry& other) const
+    {
+      return (score > other.score);
+    }
+  };
+
+  /**
+   * Score the given node and, unless it is pruned, add it to the queue.  For
+   * trees whose first point is the centroid, the base case with the point of
+   * the node is also evaluated here.
+   */
+  void Enqueue(const size_t queryIndex, TreeType& node);
+
+  //! Evaluate a base case, counting it against the budget.
+  void BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  //! Return whether or not the budget of the current query point is used up.
+  bool OverBudget() const;
+
+  //! Reference to the rules with which the tree will be traversed.
+  RuleType& rule;
+
+  //! The maximum number of leaves to visit for each query point.
+  size_t maxLeaves;
+  //! The maximum number of base cases for each query point.
+  size_t maxBaseCases;
+
+  //! The number of nodes which have been pruned during traversal.
+  size_t numPrunes;
+  //! The number of leaves which have been visited.
+  size_t numLeaves;
+  //! The number of base cases which have been evaluated.
+  size_t numBaseCases;
+  //! The number of traversals which were stopped by the budget.
+  size_t numStopped;
+
+  //! The number of leaves visited for the current query point.
+  size_t queryLeaves;
+  //! The number of base cases evaluated for the current query point.
+  size_t queryBaseCases;
+
+  //! The queue of nodes to visit, held in the class so that it isn't
+  //! continually being reallocated.
+  std::vector<QueueEntry> queue;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "best_first_single_tree_traverser_impl.hpp"
+
+#endif
@@ -0,0 +1,156 @@
+/**
+ * @file best_first_single_tree_traverser_impl.hpp
+ *
+ * Implementation of the BestFirstSingleTreeTraverser, which visits the nodes of
+ * a tree in order of their scores until the budget is used up.
+ */
+#ifndef __MLPACK_CORE_TREE_BEST_FIRST_SINGLE_TREE_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_BEST_FIRST_SINGLE_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "best_first_single_tree_traverser.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename TreeType, typename RuleType>
+BestFirstSingleTreeTraverser<TreeType, RuleType>::BestFirstSingleTreeTraverser(
+    RuleType& rule,
+    const size_t maxLeaves,
+    const size_t maxBaseCases) :
+    rule(rule),
+    maxLeaves(maxLeaves),
+    maxBaseCases(maxBaseCases),
+    numPrunes(0),
+    numLeaves(0),
+    numBaseCases(0),
+    numStopped(0),
+    queryLeaves(0),
+    queryBaseCases(0)
+{ /* Nothing to do. */ }
+
+template<typename TreeType, typename RuleType>
+void BestFirstSingleTreeTraverser<TreeType, RuleType>::Traverse(
+    const size_t queryIndex,
+    TreeType& referenceNode)
+{
+  queryLeaves = 0;
+  queryBaseCases = 0;
+  queue.clear();
+
+  Enqueue(queryIndex, referenceNode);
+
+  while (!queue.empty())
+  {
+    if (OverBudget())
+    {
+      ++numStopped;
+      queue.clear();
+      return;
+    }
+
+    // Take the node with the best score.
+    std::pop_heap(queue.begin(), queue.end());
+    TreeType& node = *queue.back().node;
+    const double score = queue.back().score;
+    queue.pop_back();
+
+    // The results found since the node was scored may allow it to be pruned.
+    if (rule.Rescore(queryIndex, node, score) == DBL_MAX)
+    {
+      ++numPrunes;
+      continue;
+    }
+
+    if (node.IsLeaf())
+    {
+      ++numLeaves;
+      ++queryLeaves;
+
+      // If the first point is the centroid, its base case was evaluated when
+      // the node was scored.
+      if (!TreeTraits<TreeType>::FirstPointIsCentroid)
+      {
+        for (size_t i = 0; i < node.NumPoints(); ++i)
+        {
+          // The budget may run out in the middle of a leaf.
+          if (maxBaseCases != 0 && queryBaseCases >= maxBaseCases)
+            break;
+
+          BaseCase(queryIndex, node.Point(i));
+        }
+      }
+
+      continue;
+    }
+
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+    {
+      TreeType& child = node.Child(i);
+
+      // The point of a self-leaf has already been evaluated with its parent,
+      // so there is nothing left to do there.
+      if (TreeTraits<TreeType>::HasSelfChildren && child.IsLeaf() &&
+          child.Point(0) == node.Point(0))
+      {
+        ++numPrunes;
+        continue;
+      }
+
+      Enqueue(queryIndex, child);
+    }
+  }
+}
+
+template<typename TreeType, typename RuleType>
+void BestFirstSingleTreeTraverser<TreeType, RuleType>::Enqueue(
+    const size_t queryIndex,
+    TreeType& node)
+{
+  const double score = rule.Score(queryIndex, node);
+  if (score == DBL_MAX)
+  {
+    ++numPrunes;
+    return;
+  }
+
+  // Evaluating the base case right after Score() lets the rules return the
+  // result they just calculated.  A self-child shares the base case of its
+  // parent.
+  if (TreeTraits<TreeType>::FirstPointIsCentroid)
+  {
+    if (node.Parent() == NULL || !TreeTraits<TreeType>::HasSelfChildren ||
+        node.Point(0) != node.Parent()->Point(0))
+      BaseCase(queryIndex, node.Point(0));
+  }
+
+  QueueEntry entry;
+  entry.node = &node;
+  entry.score = score;
+  queue.push_back(entry);
+  std::push_heap(queue.begin(), queue.end());
+}
+
+template<typename TreeType, typename RuleType>
+inline void BestFirstSingleTreeTraverser<TreeType, RuleType>::BaseCase(
+    const size_t queryIndex,
+    const size_t referenceIndex)
+{
+  rule.BaseCase(queryIndex, referenceIndex);
+  ++numBaseCases;
+  ++queryBaseCases;
+}
+
+template<typename TreeType, typename RuleType>
+inline bool BestFirstSingleTreeTraverser<TreeType, RuleType>::OverBudget() const
+{
+  return (maxLeaves != 0 && queryLeaves >= maxLeaves) ||
+      (maxBaseCases != 0 && queryBaseCases >= maxBaseCases);
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -9,6 +9,9 @@
 
 #include "bounds.hpp"
 #include "binary_space_tree/binary_space_tree.hpp"
+#include "binary_space_tree/rp_tree_split.hpp"
+#include "binary_space_tree/pca_split.hpp"
+#include "binary_space_tree/vp_tree_split.hpp"
 #include "binary_space_tree/single_tree_traverser.hpp"
 #include "binary_space_tree/single_tree_traverser_impl.hpp"
 #include "binary_space_tree/dual_tree_traverser.hpp"
@@ -16,5 +19,7 @@
 #include "binary_space_tree/breadth_first_dual_tree_traverser.hpp"
 #include "binary_space_tree/breadth_first_dual_tree_traverser_impl.hpp"
 #include "binary_space_tree/traits.hpp"
+#include "binary_space_tree/fixed_dimension_kd_tree.hpp"
+#include "binary_space_tree/mapped_tree.hpp"
 
 #endif
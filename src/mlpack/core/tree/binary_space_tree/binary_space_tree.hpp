@@ -8,6 +8,9 @@
 
 #include <mlpack/core.hpp>
 #include "mean_split.hpp"
+#include "../hollow_ballbound.hpp"
+
+#include <map>
 
 #include "../statistic.hpp"
 
@@ -27,12 +30,17 @@ namespace tree /** Trees and tree-building procedures. */ {
  * This tree does take one runtime parameter in the constructor, which is the
  * max leaf size to be used.
  *
+ * If mlpack was compiled with OpenMP, the subtrees of large nodes are built in
+ * parallel.  The resulting tree (and the ordering of the points) is the same as
+ * the one built by a single thread.
+ *
  * @tparam BoundType The bound used for each node.  The valid types of bounds
  *     and the necessary skeleton interface for this class can be found in
  *     bounds/.
  * @tparam StatisticType Extra data contained in the node.  See statistic.hpp
  *     for the necessary skeleton interface.
- * @tparam MatType The dataset class.
+ * @tparam MatType The dataset class; arma::mat, arma::fmat, and arma::sp_mat
+ *     can all be used.
  * @tparam SplitType The class that partitions the dataset/points at a
  *     particular node into two parts. Its definition decides the way this split
  *     is done.
@@ -73,6 +81,12 @@ class BinarySpaceTree
   double minimumBoundDistance;
   //! The dataset.
   MatType& dataset;
+  //! The contiguous block holding the descendants of this node, if Flatten()
+  //! was called on it (NULL otherwise).
+  BinarySpaceTree* nodes;
+  //! The number of points in this node when it was last split; used to decide
+  //! when the node has changed enough to be rebuilt.
+  size_t countAtBuild;
 
  public:
   //! So other classes can use TreeType::Mat.
@@ -210,6 +224,21 @@ class BinarySpaceTree
    */
   BinarySpaceTree(const BinarySpaceTree& other);
 
+  /**
+   * Construct this node, and recursively its children, from the binary node
+   * records written by Save().  No splitting is done: the given dataset must be
+   * the (already rearranged) dataset the saved tree was built on.  The record
+   * pointer is advanced past the records that were read.  This is used by
+   * MappedTree to load a tree without rebuilding it.
+   *
+   * @param data Dataset the tree was built on.
+   * @param records Pointer to the node records; this will be modified.
+   * @param parent Parent of this node (NULL if this is the root).
+   */
+  BinarySpaceTree(MatType& data,
+                  const char*& records,
+                  BinarySpaceTree* parent = NULL);
+
   /**
    * Deletes this node, deallocating the memory for the children and calling
    * their destructors in turn.  This will invalidate any pointers or references
@@ -244,6 +273,82 @@ class BinarySpaceTree
    */
   BinarySpaceTree* FindByBeginCount(size_t begin, size_t count);
 
+  /**
+   * Write the nodes of this tree (but not the dataset or the statistics) to
+   * the given binary stream in preorder, in the format read by the record
+   * constructor.  This is only available when BoundType is an HRectBound.
+   *
+   * @param stream Stream to write the node records to.
+   */
+  void Save(std::ostream& stream) const;
+
+  /**
+   * Move all of the nodes of this tree (except the root, which is this node)
+   * into one contiguous block of memory, in breadth-first order, so that the
+   * two children of a node are next to each other in memory and the top levels
+   * of the tree, which are visited by every traversal, are packed densely.  The
+   * structure of the tree and the ordering of the points are not changed, but
+   * any pointers to nodes other than the root are invalidated, so this should
+   * be called right after the tree is built.  The tree must not be modified
+   * (for instance with ExtendTree()) afterwards.
+   *
+   * This can only be called on the root of a tree.
+   */
+  void Flatten();
+
+  /**
+   * Insert the given points into the tree.  The points are appended to the
+   * dataset, and then moved next to the other points of the leaves they are
+   * inserted into, which are the leaves whose bounds are closest to them; the
+   * bounds are widened on the way down.  Leaves that grow past the maximum leaf
+   * size are split, and any node whose size has changed by more than half
+   * since it was last split is rebuilt, so the tree does not drift too far
+   * from the tree that would be built from scratch.  Only the leaves that
+   * receive points and their ancestors are touched, although the columns of
+   * the dataset after the first of those leaves must be shifted.
+   *
+   * The mapping is updated to match: the new points get the original indices
+   * n, n + 1, ... (where n is the number of points in the tree before
+   * inserting), as if they had been appended to the original dataset.
+   *
+   * This can only be called on the root of a tree that has not been
+   * flattened.
+   *
+   * @param points Points to insert.
+   * @param oldFromNew Mapping from the current dataset to the original one, as
+   *      returned by the tree constructor; this will be updated.
+   */
+  void InsertPoints(const MatType& points, std::vector<size_t>& oldFromNew);
+
+  /**
+   * Remove the points with the given original indices from the tree and the
+   * dataset.  The bounds of leaves that lose points are shrunk to fit, empty
+   * nodes are removed, and nodes that have changed too much are rebuilt, as
+   * with InsertPoints().  The original indices are renumbered as if the points
+   * had been removed from the original dataset (so every index above a removed
+   * point goes down by one for each removed point below it).
+   *
+   * This can only be called on the root of a tree that has not been
+   * flattened.
+   *
+   * @param indices Original indices of the points to remove.
+   * @param oldFromNew Mapping from the current dataset to the original one, as
+   *      returned by the tree constructor; this will be updated.
+   */
+  void RemovePoints(const std::vector<size_t>& indices,
+                    std::vector<size_t>& oldFromNew);
+
+  /**
+   * Recompute the bounds, furthest descendant distances, parent distances and
+   * statistics of this subtree after the points in the dataset have been
+   * modified in place, keeping the structure of the tree (so each point stays
+   * in the same leaf).  This takes O(n) time, and is much cheaper than building
+   * a new tree when the points have only moved a little; but the tree gets
+   * looser as the points move further from where they were when the tree was
+   * built.
+   */
+  void RefitBounds();
+
   //! Return the bound object for this node.
   const BoundType& Bound() const { return bound; }
   //! Return the bound object for this node.
@@ -456,13 +561,38 @@ class BinarySpaceTree
       count(count),
       bound(bound),
       stat(stat),
-      maxLeafSize(maxLeafSize) { }
+      maxLeafSize(maxLeafSize),
+      nodes(NULL),
+      countAtBuild(count) { }
 
   BinarySpaceTree* CopyMe()
   {
     return new BinarySpaceTree(begin, count, bound, stat, maxLeafSize);
   }
 
+  //! Nodes with more points than this have their subtrees built in parallel
+  //! (only if mlpack was compiled with OpenMP).
+  static const size_t parallelBuildThreshold = 10000;
+
+  /**
+   * Expand the bound of this node to contain its points.
+   *
+   * @param boundToUpdate The bound of this node.
+   */
+  template<typename BoundType2>
+  void UpdateBound(BoundType2& boundToUpdate);
+
+  /**
+   * Expand the hollow ball bound of this node to contain its points.  A
+   * right child is given a hole around the center of the bound of its parent
+   * (which is the vantage point, for VPTreeSplit), and a left child keeps the
+   * hole of its parent; either way, the hole then shrinks to fit the points.
+   *
+   * @param boundToUpdate The bound of this node.
+   */
+  template<typename VecType, typename MetricType>
+  void UpdateBound(bound::HollowBallBound<VecType, MetricType>& boundToUpdate);
+
   /**
    * Splits the current node, assigning its left and right children recursively.
    *
@@ -479,6 +609,70 @@ class BinarySpaceTree
    */
   void SplitNode(MatType& data, std::vector<size_t>& oldFromNew);
 
+  /**
+   * Move the columns of this subtree to make room for the inserted points, put
+   * the inserted points after the other points of their leaves, and update the
+   * nodes whose points changed.  Subtrees are visited from right to left, and
+   * the visit stops once every inserted point has its place.
+   *
+   * @param points Points being inserted.
+   * @param additions The indices of the points inserted into each leaf.
+   * @param remaining The number of inserted points that belong in this subtree
+   *      or anywhere before it; this is decremented as points are placed.
+   * @param oldSize Number of points in the dataset before inserting.
+   * @param oldFromNew Mapping to update.
+   * @param stale Nodes that should be rebuilt are added to this.
+   */
+  void InsertShift(
+      const MatType& points,
+      const std::map<BinarySpaceTree*, std::vector<size_t> >& additions,
+      size_t& remaining,
+      const size_t oldSize,
+      std::vector<size_t>& oldFromNew,
+      std::vector<BinarySpaceTree*>& stale);
+
+  /**
+   * Drop the removed columns from this subtree and move the rest over to fill
+   * the gaps, updating the nodes whose points changed and removing empty
+   * children.  Subtrees without removed points that do not need to move are
+   * skipped.
+   *
+   * @param columns Sorted columns of the points being removed.
+   * @param removed The number of removed columns before this subtree; this is
+   *      incremented as removed columns are found.
+   * @param oldFromNew Mapping to update.
+   * @param stale Nodes that should be rebuilt are added to this.
+   */
+  void RemoveShift(const std::vector<size_t>& columns,
+                   size_t& removed,
+                   std::vector<size_t>& oldFromNew,
+                   std::vector<BinarySpaceTree*>& stale);
+
+  //! Return whether the number of points in this node has changed by more than
+  //! half since it was last split.
+  bool IsStale() const
+  {
+    const size_t change = (count > countAtBuild) ? (count - countAtBuild) :
+        (countAtBuild - count);
+    return (2 * change > countAtBuild);
+  }
+
+  /**
+   * Recompute the furthest descendant distance, the parent distances of the
+   * children and the statistic after the points of this node have changed.
+   */
+  void UpdateNode();
+
+  /**
+   * Rebuild each of the given nodes from scratch, except for those that are
+   * below another one of them.
+   *
+   * @param stale Nodes to rebuild.
+   * @param oldFromNew Mapping to update.
+   */
+  void RebuildStale(const std::vector<BinarySpaceTree*>& stale,
+                    std::vector<size_t>& oldFromNew);
+
  public:
   /**
    * Returns a string representation of this object.
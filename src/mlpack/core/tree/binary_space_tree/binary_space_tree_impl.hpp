@@ -13,6 +13,9 @@
 #include <mlpack/core/util/log.hpp>
 #include <mlpack/core/util/string_util.hpp>
 
+#include <boost/cstdint.hpp>
+#include <algorithm>
+
 namespace mlpack {
 namespace tree {
 
@@ -33,10 +36,21 @@ BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     maxLeafSize(maxLeafSize),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(data)
+    dataset(data),
+    nodes(NULL),
+    countAtBuild(count)
 {
-  // Do the actual splitting of this node.
-  SplitNode(data);
+  // Do the actual splitting of this node.  If OpenMP is available and the
+  // dataset is large enough, the subtrees are built in parallel.
+  #pragma omp parallel if (data.n_cols > parallelBuildThreshold)
+  {
+    #pragma omp single
+    SplitNode(data);
+  }
+
+  // The points are now in their final order; move them to the NUMA nodes of
+  // the threads that will process them, if asked (see util::PlaceMatrix()).
+  util::PlaceMatrix(data);
 
   // Create the statistic depending on if we are a leaf or not.
   stat = StatisticType(*this);
@@ -58,15 +72,25 @@ BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     maxLeafSize(maxLeafSize),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(data)
+    dataset(data),
+    nodes(NULL),
+    countAtBuild(count)
 {
   // Initialize oldFromNew correctly.
   oldFromNew.resize(data.n_cols);
   for (size_t i = 0; i < data.n_cols; i++)
     oldFromNew[i] = i; // Fill with unharmed indices.
 
-  // Now do the actual splitting.
-  SplitNode(data, oldFromNew);
+  // Now do the actual splitting.  If OpenMP is available and the dataset is
+  // large enough, the subtrees are built in parallel.
+  #pragma omp parallel if (data.n_cols > parallelBuildThreshold)
+  {
+    #pragma omp single
+    SplitNode(data, oldFromNew);
+  }
+
+  // Place the reordered points, as in the first constructor.
+  util::PlaceMatrix(data);
 
   // Create the statistic depending on if we are a leaf or not.
   stat = StatisticType(*this);
@@ -89,15 +113,25 @@ BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     maxLeafSize(maxLeafSize),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(data)
+    dataset(data),
+    nodes(NULL),
+    countAtBuild(count)
 {
   // Initialize the oldFromNew vector correctly.
   oldFromNew.resize(data.n_cols);
   for (size_t i = 0; i < data.n_cols; i++)
     oldFromNew[i] = i; // Fill with unharmed indices.
 
-  // Now do the actual splitting.
-  SplitNode(data, oldFromNew);
+  // Now do the actual splitting.  If OpenMP is available and the dataset is
+  // large enough, the subtrees are built in parallel.
+  #pragma omp parallel if (data.n_cols > parallelBuildThreshold)
+  {
+    #pragma omp single
+    SplitNode(data, oldFromNew);
+  }
+
+  // Place the reordered points, as in the first constructor.
+  util::PlaceMatrix(data);
 
   // Create the statistic depending on if we are a leaf or not.
   stat = StatisticType(*this);
@@ -125,7 +159,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     count(count),
     maxLeafSize(maxLeafSize),
     bound(data.n_rows),
-    dataset(data)
+    dataset(data),
+    nodes(NULL),
+    countAtBuild(count)
 {
   // Perform the actual splitting.
   SplitNode(data);
@@ -152,7 +188,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     count(count),
     maxLeafSize(maxLeafSize),
     bound(data.n_rows),
-    dataset(data)
+    dataset(data),
+    nodes(NULL),
+    countAtBuild(count)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -184,7 +222,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     count(count),
     maxLeafSize(maxLeafSize),
     bound(data.n_rows),
-    dataset(data)
+    dataset(data),
+    nodes(NULL),
+    countAtBuild(count)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -238,7 +278,9 @@ BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
     splitDimension(other.splitDimension),
     parentDistance(other.parentDistance),
     furthestDescendantDistance(other.furthestDescendantDistance),
-    dataset(other.dataset)
+    dataset(other.dataset),
+    nodes(NULL),
+    countAtBuild(other.countAtBuild)
 {
   // Create left and right children (if any).
   if (other.Left())
@@ -254,6 +296,69 @@ BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
   }
 }
 
+/**
+ * Construct a node and its children from the records written by Save().  Each
+ * record holds the begin, count, maximum leaf size, split dimension and whether
+ * or not the node has children as 64-bit unsigned integers, followed by the
+ * parent distance, furthest descendant distance and minimum bound width, and
+ * then the lower and upper bound in each dimension, all as doubles.
+ */
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::BinarySpaceTree(
+    MatType& data,
+    const char*& records,
+    BinarySpaceTree* parent) :
+    left(NULL),
+    right(NULL),
+    parent(parent),
+    bound(data.n_rows),
+    dataset(data),
+    nodes(NULL),
+    countAtBuild(0)
+{
+  // The records may not be aligned, so copy each field out.
+  boost::uint64_t header[5];
+  memcpy(header, records, sizeof(header));
+  records += sizeof(header);
+
+  begin = (size_t) header[0];
+  count = (size_t) header[1];
+  countAtBuild = count;
+  maxLeafSize = (size_t) header[2];
+  splitDimension = (size_t) header[3];
+  const bool hasChildren = (header[4] != 0);
+
+  double distances[3];
+  memcpy(distances, records, sizeof(distances));
+  records += sizeof(distances);
+
+  parentDistance = distances[0];
+  furthestDescendantDistance = distances[1];
+  bound.MinWidth() = distances[2];
+
+  for (size_t d = 0; d < bound.Dim(); ++d)
+  {
+    double range[2];
+    memcpy(range, records, sizeof(range));
+    records += sizeof(range);
+
+    bound[d] = math::Range(range[0], range[1]);
+  }
+
+  // The children follow this record, in preorder.
+  if (hasChildren)
+  {
+    left = new BinarySpaceTree(data, records, this);
+    right = new BinarySpaceTree(data, records, this);
+  }
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
 /**
  * Deletes this node, deallocating the memory for the children and calling their
  * destructors in turn.  This will invalidate any pointers or references to any
@@ -266,6 +371,22 @@ template<typename BoundType,
 BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
   ~BinarySpaceTree()
 {
+  if (nodes)
+  {
+    // The descendants were moved into one block by Flatten(), so they must not
+    // delete each other.
+    const size_t numNodes = TreeSize() - 1;
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+      nodes[i].left = NULL;
+      nodes[i].right = NULL;
+      nodes[i].~BinarySpaceTree();
+    }
+
+    ::operator delete(nodes);
+    return;
+  }
+
   if (left)
     delete left;
   if (right)
@@ -558,6 +679,45 @@ inline size_t BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
   return begin + count;
 }
 
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename BoundType2>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::UpdateBound(
+    BoundType2& boundToUpdate)
+{
+  boundToUpdate |= dataset.cols(begin, begin + count - 1);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename VecType, typename MetricType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::UpdateBound(
+    bound::HollowBallBound<VecType, MetricType>& boundToUpdate)
+{
+  // Only the bound of the parent is used here, because the sibling may be
+  // under construction in another task.  A hole radius of DBL_MAX is shrunk by
+  // operator|=() to the distance to the closest point.
+  if (parent != NULL)
+  {
+    if (begin != parent->Begin())
+    {
+      boundToUpdate.HollowCenter() = parent->Bound().Center();
+      boundToUpdate.InnerRadius() = DBL_MAX;
+    }
+    else if (parent->Bound().InnerRadius() > 0)
+    {
+      boundToUpdate.HollowCenter() = parent->Bound().HollowCenter();
+      boundToUpdate.InnerRadius() = DBL_MAX;
+    }
+  }
+
+  boundToUpdate |= dataset.cols(begin, begin + count - 1);
+}
+
 template<typename BoundType,
          typename StatisticType,
          typename MatType,
@@ -565,8 +725,10 @@ template<typename BoundType,
 void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::SplitNode(
     MatType& data)
 {
+  countAtBuild = count;
+
   // We need to expand the bounds of this node properly.
-  bound |= data.cols(begin, begin + count - 1);
+  UpdateBound(bound);
 
   // Calculate the furthest descendant distance.
   furthestDescendantDistance = 0.5 * bound.Diameter();
@@ -591,17 +753,23 @@ void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::SplitNode(
     return;
 
   // Now that we know the split column, we will recursively split the children
-  // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree<BoundType, StatisticType, MatType>(data, begin,
-      splitCol - begin, this, maxLeafSize);
-  right = new BinarySpaceTree<BoundType, StatisticType, MatType>(data, splitCol,
-      begin + count - splitCol, this, maxLeafSize);
+  // by calling their constructors (which perform this splitting process).  The
+  // children hold disjoint sets of points, so when this is called inside a
+  // parallel region and the node is large enough, the left child is built as a
+  // separate task.  This does not change the resulting tree.
+  #pragma omp task if (count > parallelBuildThreshold) shared(data)
+  left = new BinarySpaceTree(data, begin, splitCol - begin, this, maxLeafSize);
+  right = new BinarySpaceTree(data, splitCol, begin + count - splitCol, this,
+      maxLeafSize);
+  #pragma omp taskwait
 
   // Calculate parent distances for those two nodes.
-  arma::vec centroid, leftCentroid, rightCentroid;
-  Centroid(centroid);
-  left->Centroid(leftCentroid);
-  right->Centroid(rightCentroid);
+  // The centroids have the same element type as the data, so that the metric
+  // can be evaluated between them.
+  arma::Col<typename MatType::elem_type> centroid, leftCentroid, rightCentroid;
+  bound.Centroid(centroid);
+  left->Bound().Centroid(leftCentroid);
+  right->Bound().Centroid(rightCentroid);
 
   const double leftParentDistance = bound.Metric().Evaluate(centroid,
       leftCentroid);
@@ -620,9 +788,10 @@ void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::SplitNode(
     MatType& data,
     std::vector<size_t>& oldFromNew)
 {
-  // This should be a single function for Bound.
+  countAtBuild = count;
+
   // We need to expand the bounds of this node properly.
-  bound |= data.cols(begin, begin + count - 1);
+  UpdateBound(bound);
 
   // Calculate the furthest descendant distance.
   furthestDescendantDistance = 0.5 * bound.Diameter();
@@ -648,17 +817,25 @@ void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::SplitNode(
     return;
 
   // Now that we know the split column, we will recursively split the children
-  // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree<BoundType, StatisticType, MatType>(data, begin,
-      splitCol - begin, oldFromNew, this, maxLeafSize);
-  right = new BinarySpaceTree<BoundType, StatisticType, MatType>(data, splitCol,
-      begin + count - splitCol, oldFromNew, this, maxLeafSize);
+  // by calling their constructors (which perform this splitting process).  The
+  // children hold disjoint sets of points (and disjoint parts of oldFromNew),
+  // so when this is called inside a parallel region and the node is large
+  // enough, the left child is built as a separate task.  This does not change
+  // the resulting tree or the mapping.
+  #pragma omp task if (count > parallelBuildThreshold) shared(data, oldFromNew)
+  left = new BinarySpaceTree(data, begin, splitCol - begin, oldFromNew, this,
+      maxLeafSize);
+  right = new BinarySpaceTree(data, splitCol, begin + count - splitCol,
+      oldFromNew, this, maxLeafSize);
+  #pragma omp taskwait
 
   // Calculate parent distances for those two nodes.
-  arma::vec centroid, leftCentroid, rightCentroid;
-  Centroid(centroid);
-  left->Centroid(leftCentroid);
-  right->Centroid(rightCentroid);
+  // The centroids have the same element type as the data, so that the metric
+  // can be evaluated between them.
+  arma::Col<typename MatType::elem_type> centroid, leftCentroid, rightCentroid;
+  bound.Centroid(centroid);
+  left->Bound().Centroid(leftCentroid);
+  right->Bound().Centroid(rightCentroid);
 
   const double leftParentDistance = bound.Metric().Evaluate(centroid,
       leftCentroid);
@@ -669,6 +846,493 @@ void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::SplitNode(
   right->ParentDistance() = rightParentDistance;
 }
 
+/**
+ * Write the records of this node and its descendants (in preorder) to the given
+ * stream.  See the record constructor for the layout.
+ */
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::Save(
+    std::ostream& stream) const
+{
+  const bool hasChildren = (left != NULL);
+  const boost::uint64_t header[5] = { begin, count, maxLeafSize,
+      hasChildren ? splitDimension : 0, (boost::uint64_t) hasChildren };
+  stream.write((const char*) header, sizeof(header));
+
+  const double distances[3] = { parentDistance, furthestDescendantDistance,
+      bound.MinWidth() };
+  stream.write((const char*) distances, sizeof(distances));
+
+  for (size_t d = 0; d < bound.Dim(); ++d)
+  {
+    const double range[2] = { bound[d].Lo(), bound[d].Hi() };
+    stream.write((const char*) range, sizeof(range));
+  }
+
+  if (left != NULL)
+  {
+    left->Save(stream);
+    right->Save(stream);
+  }
+}
+
+/**
+ * Move all of the descendants of this node into one contiguous block, in
+ * breadth-first order.
+ */
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::Flatten()
+{
+  if (parent != NULL)
+  {
+    Log::Fatal << "BinarySpaceTree::Flatten() can only be called on the root of"
+        << " a tree." << std::endl;
+  }
+
+  // Nothing to do if there is only one node, or if the tree is already flat.
+  if (!left || nodes)
+    return;
+
+  // Collect the descendants in breadth-first order.  The two children of any
+  // node will then be next to each other.
+  std::vector<BinarySpaceTree*> order;
+  order.push_back(left);
+  order.push_back(right);
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    if (order[i]->left)
+    {
+      order.push_back(order[i]->left);
+      order.push_back(order[i]->right);
+    }
+  }
+
+  const size_t numNodes = order.size();
+  nodes = static_cast<BinarySpaceTree*>(::operator new(numNodes *
+      sizeof(BinarySpaceTree)));
+  // The top of the tree is read by every thread, so the nodes can only be
+  // interleaved, not placed by first touch.
+  util::AdviseMemory(nodes, numNodes * sizeof(BinarySpaceTree));
+
+  // Copy each node into its place in the block and delete the original.  The
+  // children of the node at position i are placed at positions next and
+  // next + 1.
+  size_t next = 2;
+  for (size_t i = 0; i < numNodes; ++i)
+  {
+    BinarySpaceTree* node = order[i];
+    const bool hasChildren = (node->left != NULL);
+
+    // Detach the children so neither the copy nor the deletion recurses.
+    node->left = NULL;
+    node->right = NULL;
+    new (nodes + i) BinarySpaceTree(*node);
+    delete node;
+
+    if (hasChildren)
+    {
+      nodes[i].left = nodes + next;
+      nodes[i].right = nodes + next + 1;
+      next += 2;
+    }
+  }
+
+  // Now fix the parent pointers.
+  left = nodes;
+  right = nodes + 1;
+  left->parent = this;
+  right->parent = this;
+  for (size_t i = 0; i < numNodes; ++i)
+  {
+    if (nodes[i].left)
+    {
+      nodes[i].left->parent = nodes + i;
+      nodes[i].right->parent = nodes + i;
+    }
+  }
+}
+
+/**
+ * Insert the points: find a leaf for each of them, make room in the dataset,
+ * then fix up the nodes that changed.
+ */
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    InsertPoints(const MatType& points, std::vector<size_t>& oldFromNew)
+{
+  if (parent != NULL || nodes != NULL)
+  {
+    Log::Fatal << "BinarySpaceTree::InsertPoints() can only be called on the "
+        << "root of a tree that has not been flattened." << std::endl;
+  }
+
+  if (points.n_cols == 0)
+    return;
+
+  // Send each point down to the leaf whose bound is closest, widening the
+  // bounds along the way.  Ties go to the left.
+  std::map<BinarySpaceTree*, std::vector<size_t> > additions;
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    const arma::Col<typename MatType::elem_type> point =
+        points.unsafe_col(i);
+
+    BinarySpaceTree* node = this;
+    node->bound |= point;
+    while (node->left != NULL)
+    {
+      if (node->left->bound.MinDistance(point) <=
+          node->right->bound.MinDistance(point))
+        node = node->left;
+      else
+        node = node->right;
+
+      node->bound |= point;
+    }
+
+    additions[node].push_back(i);
+  }
+
+  // Make room at the end of the dataset, then shift everything into place.
+  const size_t oldSize = dataset.n_cols;
+  dataset.resize(dataset.n_rows, oldSize + points.n_cols);
+  oldFromNew.resize(oldSize + points.n_cols);
+
+  size_t remaining = points.n_cols;
+  std::vector<BinarySpaceTree*> stale;
+  InsertShift(points, additions, remaining, oldSize, oldFromNew, stale);
+
+  RebuildStale(stale, oldFromNew);
+}
+
+/**
+ * Remove the points: find their columns, close the gaps in the dataset, then
+ * renumber the original indices.
+ */
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    RemovePoints(const std::vector<size_t>& indices,
+                 std::vector<size_t>& oldFromNew)
+{
+  if (parent != NULL || nodes != NULL)
+  {
+    Log::Fatal << "BinarySpaceTree::RemovePoints() can only be called on the "
+        << "root of a tree that has not been flattened." << std::endl;
+  }
+
+  std::vector<size_t> sortedIndices(indices);
+  std::sort(sortedIndices.begin(), sortedIndices.end());
+  sortedIndices.erase(std::unique(sortedIndices.begin(), sortedIndices.end()),
+      sortedIndices.end());
+
+  if (sortedIndices.empty())
+    return;
+
+  if (sortedIndices.back() >= dataset.n_cols)
+  {
+    Log::Fatal << "BinarySpaceTree::RemovePoints(): point "
+        << sortedIndices.back() << " is not in the tree (the tree has "
+        << dataset.n_cols << " points)." << std::endl;
+  }
+
+  // Find the current column of each point to be removed.
+  std::vector<size_t> columns;
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    if (std::binary_search(sortedIndices.begin(), sortedIndices.end(),
+        oldFromNew[i]))
+      columns.push_back(i);
+
+  size_t removed = 0;
+  std::vector<BinarySpaceTree*> stale;
+  RemoveShift(columns, removed, oldFromNew, stale);
+
+  dataset.resize(dataset.n_rows, dataset.n_cols - columns.size());
+  oldFromNew.resize(dataset.n_cols);
+
+  // Each remaining original index goes down by the number of removed indices
+  // below it.
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    oldFromNew[i] -= (std::lower_bound(sortedIndices.begin(),
+        sortedIndices.end(), oldFromNew[i]) - sortedIndices.begin());
+
+  RebuildStale(stale, oldFromNew);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    InsertShift(
+        const MatType& points,
+        const std::map<BinarySpaceTree*, std::vector<size_t> >& additions,
+        size_t& remaining,
+        const size_t oldSize,
+        std::vector<size_t>& oldFromNew,
+        std::vector<BinarySpaceTree*>& stale)
+{
+  // Nothing before this point moves.
+  if (remaining == 0)
+    return;
+
+  const size_t oldCount = count;
+  if (left != NULL)
+  {
+    right->InsertShift(points, additions, remaining, oldSize, oldFromNew,
+        stale);
+    left->InsertShift(points, additions, remaining, oldSize, oldFromNew,
+        stale);
+
+    begin = left->begin;
+    count = left->count + right->count;
+  }
+  else
+  {
+    typename std::map<BinarySpaceTree*, std::vector<size_t> >::const_iterator
+        it = additions.find(this);
+    const size_t numAdded = (it == additions.end()) ? 0 : it->second.size();
+
+    // The points of this leaf move right by the number of inserted points that
+    // go before them, and the inserted points go right after them.  Moving from
+    // right to left means nothing is overwritten before it is moved.
+    const size_t shift = remaining - numAdded;
+    if (shift > 0)
+    {
+      for (size_t i = begin + count; i > begin; --i)
+      {
+        dataset.col(i - 1 + shift) = dataset.col(i - 1);
+        oldFromNew[i - 1 + shift] = oldFromNew[i - 1];
+      }
+    }
+
+    for (size_t i = 0; i < numAdded; ++i)
+    {
+      const size_t column = begin + count + shift + i;
+      dataset.col(column) = points.col(it->second[i]);
+      oldFromNew[column] = oldSize + it->second[i];
+    }
+
+    begin += shift;
+    count += numAdded;
+    remaining = shift;
+
+    // The bound was already widened on the way down.
+    if (count > maxLeafSize)
+      SplitNode(dataset, oldFromNew);
+  }
+
+  if (count != oldCount)
+  {
+    UpdateNode();
+    if (left != NULL && IsStale())
+      stale.push_back(this);
+  }
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    RefitBounds()
+{
+  bound.Clear();
+  if (left != NULL)
+  {
+    left->RefitBounds();
+    right->RefitBounds();
+
+    bound |= left->Bound();
+    bound |= right->Bound();
+  }
+  else if (count > 0)
+  {
+    bound |= dataset.cols(begin, begin + count - 1);
+  }
+
+  // The children are done, so their distances and statistics are up to date.
+  UpdateNode();
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    RemoveShift(const std::vector<size_t>& columns,
+                size_t& removed,
+                std::vector<size_t>& oldFromNew,
+                std::vector<BinarySpaceTree*>& stale)
+{
+  // If no points have been removed yet and none are in this subtree, nothing
+  // here moves.
+  if (removed == 0 && columns[0] >= begin + count)
+    return;
+
+  const size_t oldCount = count;
+  if (left != NULL)
+  {
+    left->RemoveShift(columns, removed, oldFromNew, stale);
+    right->RemoveShift(columns, removed, oldFromNew, stale);
+
+    // If one child is now empty, the other one takes the place of this node.
+    if (left->count == 0 || right->count == 0)
+    {
+      BinarySpaceTree* empty = (left->count == 0) ? left : right;
+      BinarySpaceTree* child = (left->count == 0) ? right : left;
+      delete empty;
+
+      left = child->left;
+      right = child->right;
+      if (left != NULL)
+      {
+        left->parent = this;
+        right->parent = this;
+      }
+
+      begin = child->begin;
+      count = child->count;
+      bound.Clear();
+      if (count > 0)
+        bound |= dataset.cols(begin, begin + count - 1);
+      splitDimension = child->splitDimension;
+      countAtBuild = child->countAtBuild;
+
+      // If the child was going to be rebuilt, this node must be rebuilt
+      // instead.
+      std::replace(stale.begin(), stale.end(), child, this);
+
+      child->left = NULL;
+      child->right = NULL;
+      delete child;
+    }
+    else
+    {
+      begin = left->begin;
+      count = left->count + right->count;
+    }
+  }
+  else
+  {
+    // Keep the points that are not removed, packed to the left.
+    const size_t newBegin = begin - removed;
+    size_t next = newBegin;
+    for (size_t i = begin; i < begin + count; ++i)
+    {
+      if (removed < columns.size() && columns[removed] == i)
+      {
+        ++removed;
+        continue;
+      }
+
+      if (next != i)
+      {
+        dataset.col(next) = dataset.col(i);
+        oldFromNew[next] = oldFromNew[i];
+      }
+      ++next;
+    }
+
+    begin = newBegin;
+    count = next - newBegin;
+
+    // Shrink the bound to fit the remaining points.
+    if (count != oldCount)
+    {
+      bound.Clear();
+      if (count > 0)
+        bound |= dataset.cols(begin, begin + count - 1);
+    }
+  }
+
+  // The bounds of the ancestors are not shrunk; they are still valid, just
+  // looser than they need to be, until the node is rebuilt.
+  if (count != oldCount)
+  {
+    UpdateNode();
+    if (left != NULL && IsStale())
+      stale.push_back(this);
+  }
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    UpdateNode()
+{
+  furthestDescendantDistance = 0.5 * bound.Diameter();
+
+  if (left != NULL)
+  {
+    arma::Col<typename MatType::elem_type> centroid, leftCentroid,
+        rightCentroid;
+    bound.Centroid(centroid);
+    left->Bound().Centroid(leftCentroid);
+    right->Bound().Centroid(rightCentroid);
+
+    left->ParentDistance() = bound.Metric().Evaluate(centroid, leftCentroid);
+    right->ParentDistance() = bound.Metric().Evaluate(centroid,
+        rightCentroid);
+  }
+
+  stat = StatisticType(*this);
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+    RebuildStale(const std::vector<BinarySpaceTree*>& stale,
+                 std::vector<size_t>& oldFromNew)
+{
+  // Only rebuild the nodes that are not inside another node being rebuilt;
+  // find them all before deleting anything.
+  std::vector<BinarySpaceTree*> rebuild;
+  for (size_t i = 0; i < stale.size(); ++i)
+  {
+    bool covered = false;
+    for (BinarySpaceTree* node = stale[i]->parent; node != NULL;
+        node = node->parent)
+      if (std::find(stale.begin(), stale.end(), node) != stale.end())
+        covered = true;
+
+    if (!covered)
+      rebuild.push_back(stale[i]);
+  }
+
+  for (size_t i = 0; i < rebuild.size(); ++i)
+  {
+    BinarySpaceTree* node = rebuild[i];
+    delete node->left;
+    delete node->right;
+    node->left = NULL;
+    node->right = NULL;
+
+    node->bound.Clear();
+    node->SplitNode(dataset, oldFromNew);
+    node->UpdateNode();
+
+    // The bound may have shrunk, which moves its centroid.
+    if (node->parent != NULL)
+      node->parent->UpdateNode();
+  }
+}
+
 /**
  * Returns a string representation of this object.
  */
@@ -41,6 +41,31 @@ class BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
   void Traverse(BinarySpaceTree& queryNode,
                 BinarySpaceTree& referenceNode);
 
+  /**
+   * Traverse the two trees level by level, in parallel (with
+   * util::NumThreads() threads).  The combinations to visit at each level are
+   * grouped by query node, and the groups are handed out to the threads, which
+   * score them concurrently; each thread collects the combinations it finds
+   * for the next level in its own buffer, and the buffers are joined once the
+   * level is finished.  Because all the combinations of a query node are
+   * visited by one thread, and the combinations of one level have query nodes
+   * in disjoint subtrees, no two threads touch the same query node or query
+   * point at once.  This suits wide, shallow trees, where the task-parallel
+   * DualTreeTraverser::TraverseParallel() has too few subtrees to share out.
+   *
+   * As with TraverseParallel(), each thread gets its own copy of the rules, so
+   * the rules must be copy-constructible, must not share state between query
+   * nodes (other than the results for each query point), and must provide a
+   * modifiable Statistics() accessor (see TraversalStatistics); the statistics
+   * of each copy are added back into the rules at the end.  This must not be
+   * called from inside a parallel region, or it will run on one thread.
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   */
+  void TraverseLevels(BinarySpaceTree& queryNode,
+                      BinarySpaceTree& referenceNode);
+
   //! Get the number of prunes.
   size_t NumPrunes() const { return numPrunes; }
   //! Modify the number of prunes.
@@ -80,6 +105,56 @@ class BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
   //! Traversal information, held in the class so that it isn't continually
   //! being reallocated.
   typename RuleType::TraversalInfoType traversalInfo;
+
+  //! A combination to visit in TraverseLevels(), with the traversal
+  //! information to restore before visiting it.
+  struct Combination
+  {
+    BinarySpaceTree* queryNode;
+    BinarySpaceTree* referenceNode;
+    typename RuleType::TraversalInfoType traversalInfo;
+  };
+
+  //! The work of one thread in TraverseLevels(): its copy of the rules, its
+  //! counts, and the combinations it found for the next level, which start a
+  //! new group (of one query node) at each index in groupStarts.
+  struct LevelBuffer
+  {
+    LevelBuffer() :
+        rule(NULL), numPrunes(0), numScores(0), numBaseCases(0) { }
+
+    RuleType* rule;
+    size_t numPrunes;
+    size_t numScores;
+    size_t numBaseCases;
+    std::vector<Combination> combinations;
+    std::vector<size_t> groupStarts;
+  };
+
+  /**
+   * Visit the given combinations, which all have the same query node, with
+   * the rules of the given buffer, and add the combinations they lead to
+   * (grouped by query node) to the buffer.
+   */
+  void TraverseGroup(const Combination* begin,
+                     const Combination* end,
+                     LevelBuffer& buffer);
+
+  /**
+   * Score the query node against both children of the reference node, and add
+   * the combinations that are not pruned to the buffer, better one first.
+   */
+  void ScoreReferenceChildren(
+      BinarySpaceTree& queryNode,
+      BinarySpaceTree& referenceNode,
+      const typename RuleType::TraversalInfoType& parentInfo,
+      LevelBuffer& buffer);
+
+  //! Add a combination to visit to the buffer.
+  static void Push(LevelBuffer& buffer,
+                   BinarySpaceTree& queryNode,
+                   BinarySpaceTree& referenceNode,
+                   const typename RuleType::TraversalInfoType& info);
 };
 
 }; // namespace tree
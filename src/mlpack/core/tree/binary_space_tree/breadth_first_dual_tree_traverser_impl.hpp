@@ -13,6 +13,7 @@
 #include "breadth_first_dual_tree_traverser.hpp"
 
 #include <queue>
+#include <vector>
 
 namespace mlpack {
 namespace tree {
@@ -436,6 +437,250 @@ BreadthFirstDualTreeTraverser<RuleType>::Traverse(
   }
 }
 
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename RuleType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+BreadthFirstDualTreeTraverser<RuleType>::TraverseLevels(
+    BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>& queryRoot,
+    BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>&
+        referenceRoot)
+{
+  // Increment the visit counter.
+  ++numVisited;
+
+  // Each thread scores with its own copy of the rules, starting from the
+  // current traversal information.
+  const size_t numThreads = util::NumThreads();
+  std::vector<LevelBuffer> buffers(numThreads);
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    buffers[t].rule = new RuleType(rule);
+    buffers[t].rule->Statistics().Reset();
+  }
+
+  // The first level is the combination of the roots, in a group of its own.
+  // Each level is held in one flat array, with the index where each group
+  // starts (and, last, the size of the level).
+  std::vector<Combination> level(1);
+  level[0].queryNode = &queryRoot;
+  level[0].referenceNode = &referenceRoot;
+  level[0].traversalInfo = rule.TraversalInfo();
+  std::vector<size_t> groupStarts(2);
+  groupStarts[0] = 0;
+  groupStarts[1] = 1;
+
+  std::vector<Combination> nextLevel;
+  std::vector<size_t> nextGroupStarts;
+
+  #pragma omp parallel num_threads(numThreads) if (numThreads > 1)
+  {
+    size_t thread = 0;
+#ifdef HAS_OPENMP
+    thread = (size_t) omp_get_thread_num();
+#endif
+    LevelBuffer& buffer = buffers[thread];
+
+    while (groupStarts.size() > 1)
+    {
+      const size_t numGroups = groupStarts.size() - 1;
+      #pragma omp for schedule(dynamic, 1)
+      for (size_t g = 0; g < numGroups; ++g)
+      {
+        TraverseGroup(&level[0] + groupStarts[g], &level[0] +
+            groupStarts[g + 1], buffer);
+      }
+
+      // Once every thread has finished the level, join their buffers into the
+      // next level.
+      #pragma omp single
+      {
+        nextLevel.clear();
+        nextGroupStarts.clear();
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+          const size_t offset = nextLevel.size();
+          for (size_t i = 0; i < buffers[t].groupStarts.size(); ++i)
+            nextGroupStarts.push_back(offset + buffers[t].groupStarts[i]);
+          nextLevel.insert(nextLevel.end(), buffers[t].combinations.begin(),
+              buffers[t].combinations.end());
+
+          buffers[t].combinations.clear();
+          buffers[t].groupStarts.clear();
+        }
+        nextGroupStarts.push_back(nextLevel.size());
+
+        level.swap(nextLevel);
+        groupStarts.swap(nextGroupStarts);
+      }
+    }
+  }
+
+  // Now merge the results of each thread back into our rules and statistics.
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    rule.Statistics() += buffers[t].rule->Statistics();
+    numPrunes += buffers[t].numPrunes;
+    numScores += buffers[t].numScores;
+    numBaseCases += buffers[t].numBaseCases;
+    delete buffers[t].rule;
+  }
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename RuleType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+BreadthFirstDualTreeTraverser<RuleType>::TraverseGroup(
+    const Combination* begin,
+    const Combination* end,
+    LevelBuffer& buffer)
+{
+  RuleType& threadRule = *buffer.rule;
+  BinarySpaceTree& queryNode = *begin->queryNode;
+
+  if (queryNode.IsLeaf())
+  {
+    // Every combination this leads to has the same query node, so they are
+    // one group.
+    const size_t groupStart = buffer.combinations.size();
+    for (const Combination* c = begin; c != end; ++c)
+    {
+      BinarySpaceTree& referenceNode = *c->referenceNode;
+      if (referenceNode.IsLeaf())
+      {
+        threadRule.TraversalInfo() = c->traversalInfo;
+        for (size_t query = queryNode.Begin(); query < queryNode.End(); ++query)
+          for (size_t ref = referenceNode.Begin(); ref < referenceNode.End();
+               ++ref)
+            threadRule.BaseCase(query, ref);
+
+        buffer.numBaseCases += queryNode.Count() * referenceNode.Count();
+      }
+      else
+      {
+        ScoreReferenceChildren(queryNode, referenceNode, c->traversalInfo,
+            buffer);
+      }
+    }
+
+    if (buffer.combinations.size() > groupStart)
+      buffer.groupStarts.push_back(groupStart);
+    return;
+  }
+
+  // Recurse down the query node.  The combinations of each query child make
+  // up one group of the next level.
+  BinarySpaceTree* queryChildren[2] = { queryNode.Left(), queryNode.Right() };
+  for (size_t i = 0; i < 2; ++i)
+  {
+    BinarySpaceTree& queryChild = *queryChildren[i];
+    const size_t groupStart = buffer.combinations.size();
+    for (const Combination* c = begin; c != end; ++c)
+    {
+      BinarySpaceTree& referenceNode = *c->referenceNode;
+      if (referenceNode.IsLeaf())
+      {
+        // Only the query node is split, so the recursion order does not
+        // matter.
+        threadRule.TraversalInfo() = c->traversalInfo;
+        ++buffer.numScores;
+        if (threadRule.Score(queryChild, referenceNode) != DBL_MAX)
+          Push(buffer, queryChild, referenceNode, threadRule.TraversalInfo());
+        else
+          ++buffer.numPrunes;
+      }
+      else
+      {
+        ScoreReferenceChildren(queryChild, referenceNode, c->traversalInfo,
+            buffer);
+      }
+    }
+
+    if (buffer.combinations.size() > groupStart)
+      buffer.groupStarts.push_back(groupStart);
+  }
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename RuleType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+BreadthFirstDualTreeTraverser<RuleType>::ScoreReferenceChildren(
+    BinarySpaceTree& queryNode,
+    BinarySpaceTree& referenceNode,
+    const typename RuleType::TraversalInfoType& parentInfo,
+    LevelBuffer& buffer)
+{
+  RuleType& threadRule = *buffer.rule;
+
+  // Score both reference children, restoring the traversal information of the
+  // parent combination before each.
+  threadRule.TraversalInfo() = parentInfo;
+  double leftScore = threadRule.Score(queryNode, *referenceNode.Left());
+  const typename RuleType::TraversalInfoType leftInfo =
+      threadRule.TraversalInfo();
+  threadRule.TraversalInfo() = parentInfo;
+  double rightScore = threadRule.Score(queryNode, *referenceNode.Right());
+  buffer.numScores += 2;
+
+  if (leftScore == DBL_MAX && rightScore == DBL_MAX)
+  {
+    buffer.numPrunes += 2;
+  }
+  else if (leftScore <= rightScore)
+  {
+    // The left child goes first (as in Traverse(), on ties too); is it still
+    // valid to recurse to the right?
+    Push(buffer, queryNode, *referenceNode.Left(), leftInfo);
+    rightScore = threadRule.Rescore(queryNode, *referenceNode.Right(),
+        rightScore);
+
+    if (rightScore != DBL_MAX)
+      Push(buffer, queryNode, *referenceNode.Right(),
+          threadRule.TraversalInfo());
+    else
+      ++buffer.numPrunes;
+  }
+  else
+  {
+    // The right child goes first; is it still valid to recurse to the left?
+    Push(buffer, queryNode, *referenceNode.Right(), threadRule.TraversalInfo());
+    leftScore = threadRule.Rescore(queryNode, *referenceNode.Left(),
+        leftScore);
+
+    if (leftScore != DBL_MAX)
+      Push(buffer, queryNode, *referenceNode.Left(), leftInfo);
+    else
+      ++buffer.numPrunes;
+  }
+}
+
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename RuleType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+BreadthFirstDualTreeTraverser<RuleType>::Push(
+    LevelBuffer& buffer,
+    BinarySpaceTree& queryNode,
+    BinarySpaceTree& referenceNode,
+    const typename RuleType::TraversalInfoType& info)
+{
+  Combination combination;
+  combination.queryNode = &queryNode;
+  combination.referenceNode = &referenceNode;
+  combination.traversalInfo = info;
+  buffer.combinations.push_back(combination);
+}
+
 }; // namespace tree
 }; // namespace mlpack
 
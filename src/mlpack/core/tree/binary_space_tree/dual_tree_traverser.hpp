@@ -41,6 +41,30 @@ class BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
   void Traverse(BinarySpaceTree& queryNode,
                 BinarySpaceTree& referenceNode);
 
+  /**
+   * Traverse the two trees, splitting the work into OpenMP tasks.  Above the
+   * given split depth, the recursion into each query child is run as a
+   * separate task; at and below the split depth, each task runs the regular
+   * serial traversal.  Every task gets its own copy of the rules and its own
+   * traverser, and when the tasks are finished, the traversal statistics of
+   * each copy of the rules (and the statistics of each traverser) are added
+   * back into this object's rules and statistics.
+   *
+   * This must be called from inside an OpenMP parallel region (usually from an
+   * 'omp single' block) to actually run in parallel; otherwise the tasks run
+   * one after another.  The rules must be copy-constructible, must not share
+   * state between query nodes (other than the results for each query point),
+   * and must provide a modifiable Statistics() accessor (see
+   * TraversalStatistics).
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   * @param splitDepth Number of query tree levels to split into tasks.
+   */
+  void TraverseParallel(BinarySpaceTree& queryNode,
+                        BinarySpaceTree& referenceNode,
+                        const size_t splitDepth);
+
   //! Get the number of prunes.
   size_t NumPrunes() const { return numPrunes; }
   //! Modify the number of prunes.
@@ -80,6 +104,10 @@ class BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
   //! Traversal information, held in the class so that it isn't continually
   //! being reallocated.
   typename RuleType::TraversalInfoType traversalInfo;
+
+  //! Offsets of the query points of a leaf that were not pruned, held in the
+  //! class so that it isn't continually being reallocated.
+  std::vector<size_t> queryPoints;
 };
 
 }; // namespace tree
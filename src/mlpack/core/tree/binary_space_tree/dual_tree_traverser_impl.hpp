@@ -15,6 +15,44 @@
 namespace mlpack {
 namespace tree {
 
+//! Detect whether a set of rules can evaluate all of the base cases between two
+//! leaves at once.
+HAS_MEM_FUNC(BaseCases, HasBaseCases);
+
+//! Let the rules evaluate the base cases between the listed points of the query
+//! leaf (given by their offsets in the leaf) and every point of the reference
+//! leaf at once; this returns false if they could not.
+template<typename RuleType, typename TreeType>
+bool LeafBaseCases(
+    RuleType& rule,
+    TreeType& queryNode,
+    const std::vector<size_t>& queryPoints,
+    TreeType& referenceNode,
+    const typename boost::enable_if_c<
+        HasBaseCases<RuleType, bool (RuleType::*)(TreeType&,
+        const std::vector<size_t>&, TreeType&)>::value,
+        RuleType*
+    >::type = 0)
+{
+  return rule.BaseCases(queryNode, queryPoints, referenceNode);
+}
+
+//! The rules have no batched base cases, so they must be done one by one.
+template<typename RuleType, typename TreeType>
+bool LeafBaseCases(
+    RuleType& /* rule */,
+    TreeType& /* queryNode */,
+    const std::vector<size_t>& /* queryPoints */,
+    TreeType& /* referenceNode */,
+    const typename boost::disable_if_c<
+        HasBaseCases<RuleType, bool (RuleType::*)(TreeType&,
+        const std::vector<size_t>&, TreeType&)>::value,
+        RuleType*
+    >::type = 0)
+{
+  return false;
+}
+
 template<typename BoundType,
          typename StatisticType,
          typename MatType,
@@ -49,23 +87,38 @@ DualTreeTraverser<RuleType>::Traverse(
   // If both are leaves, we must evaluate the base case.
   if (queryNode.IsLeaf() && referenceNode.IsLeaf())
   {
-    // Loop through each of the points in each node.
+    // Find the points of the query node that we need to investigate (this
+    // function should be implemented for the single-tree recursion too).
+    // Restore the traversal information before each score.
+    queryPoints.clear();
     for (size_t query = queryNode.Begin(); query < queryNode.End(); ++query)
     {
-      // See if we need to investigate this point (this function should be
-      // implemented for the single-tree recursion too).  Restore the traversal
-      // information first.
       rule.TraversalInfo() = traversalInfo;
       const double childScore = rule.Score(query, referenceNode);
 
-      if (childScore == DBL_MAX)
-        continue; // We can't improve this particular point.
+      if (childScore != DBL_MAX)
+        queryPoints.push_back(query - queryNode.Begin());
+    }
 
-      for (size_t ref = referenceNode.Begin(); ref < referenceNode.End(); ++ref)
-        rule.BaseCase(query, ref);
+    // We can't improve any of the points.
+    if (queryPoints.empty())
+      return;
 
-      numBaseCases += referenceNode.Count();
+    // If the rules can do all of the remaining base cases at once (usually with
+    // a matrix multiplication), let them; otherwise loop through each of the
+    // remaining points.
+    if (!LeafBaseCases(rule, queryNode, queryPoints, referenceNode))
+    {
+      for (size_t i = 0; i < queryPoints.size(); ++i)
+      {
+        const size_t query = queryNode.Begin() + queryPoints[i];
+        for (size_t ref = referenceNode.Begin(); ref < referenceNode.End();
+            ++ref)
+          rule.BaseCase(query, ref);
+      }
     }
+
+    numBaseCases += queryPoints.size() * referenceNode.Count();
   }
   else if ((!queryNode.IsLeaf()) && referenceNode.IsLeaf())
   {
@@ -326,6 +379,78 @@ DualTreeTraverser<RuleType>::Traverse(
   }
 }
 
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+template<typename RuleType>
+void BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>::
+DualTreeTraverser<RuleType>::TraverseParallel(
+    BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>& queryNode,
+    BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>&
+        referenceNode,
+    const size_t splitDepth)
+{
+  // Once we are deep enough (or can't split the query node any further), this
+  // task just runs the serial traversal.
+  if (splitDepth == 0 || queryNode.IsLeaf())
+  {
+    Traverse(queryNode, referenceNode);
+    return;
+  }
+
+  // Increment the visit counter.
+  ++numVisited;
+
+  // The recursions into the two query children are independent: they only
+  // touch the results of their own query points and the statistics of their
+  // own query nodes.  So each one gets its own copy of the rules (and thus its
+  // own traversal information and base case cache), starting from the current
+  // traversal information, and its own traverser.
+  RuleType leftRule(rule);
+  RuleType rightRule(rule);
+  leftRule.Statistics().Reset();
+  rightRule.Statistics().Reset();
+
+  DualTreeTraverser leftTraverser(leftRule);
+  DualTreeTraverser rightTraverser(rightRule);
+
+  BinarySpaceTree* queryLeft = queryNode.Left();
+  BinarySpaceTree* queryRight = queryNode.Right();
+  BinarySpaceTree* reference = &referenceNode;
+
+  #pragma omp task shared(leftRule, leftTraverser) \
+      firstprivate(queryLeft, reference)
+  {
+    ++leftTraverser.numScores;
+    if (leftRule.Score(*queryLeft, *reference) != DBL_MAX)
+      leftTraverser.TraverseParallel(*queryLeft, *reference, splitDepth - 1);
+    else
+      ++leftTraverser.numPrunes;
+  }
+
+  #pragma omp task shared(rightRule, rightTraverser) \
+      firstprivate(queryRight, reference)
+  {
+    ++rightTraverser.numScores;
+    if (rightRule.Score(*queryRight, *reference) != DBL_MAX)
+      rightTraverser.TraverseParallel(*queryRight, *reference, splitDepth - 1);
+    else
+      ++rightTraverser.numPrunes;
+  }
+
+  #pragma omp taskwait
+
+  // Now merge the results of each task back into our rules and statistics.
+  rule.Statistics() += leftRule.Statistics();
+  rule.Statistics() += rightRule.Statistics();
+
+  numPrunes += leftTraverser.NumPrunes() + rightTraverser.NumPrunes();
+  numVisited += leftTraverser.NumVisited() + rightTraverser.NumVisited();
+  numScores += leftTraverser.NumScores() + rightTraverser.NumScores();
+  numBaseCases += leftTraverser.NumBaseCases() + rightTraverser.NumBaseCases();
+}
+
 }; // namespace tree
 }; // namespace mlpack
 
@@ -0,0 +1,51 @@
+/**
+ * @file fixed_dimension_kd_tree.hpp
+ *
+ * A convenience class giving the type of a kd-tree built for data with a
+ * dimensionality that is known at compile time.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_FIXED_DIMENSION_KD_TREE_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_FIXED_DIMENSION_KD_TREE_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/fixed_lmetric.hpp>
+#include "../fixed_hrectbound.hpp"
+#include "../statistic.hpp"
+#include "binary_space_tree.hpp"
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * The kd-tree type for data of the given dimensionality (a BinarySpaceTree
+ * with a FixedHRectBound), and the matching metric, which should be used for
+ * the base cases.  For instance, for three-dimensional data,
+ *
+ * @code
+ * typedef FixedDimensionKDTree<3, RangeSearchStat> KDTree3D;
+ * RangeSearch<KDTree3D::MetricType, KDTree3D::Type> rs(dataset);
+ * @endcode
+ *
+ * @tparam Dimensionality The dimensionality of the data.
+ * @tparam StatisticType Extra data contained in the nodes of the tree.
+ * @tparam Power The power of the L-metric; use 2 for Euclidean (L2).
+ * @tparam TakeRoot Whether or not the root of the metric should be taken.
+ */
+template<size_t Dimensionality,
+         typename StatisticType = EmptyStatistic,
+         int Power = 2,
+         bool TakeRoot = true>
+struct FixedDimensionKDTree
+{
+  //! The bound of each node.
+  typedef bound::FixedHRectBound<Dimensionality, Power, TakeRoot> BoundType;
+  //! The metric matching the bound.
+  typedef metric::FixedLMetric<Dimensionality, Power, TakeRoot> MetricType;
+  //! The type of the tree.
+  typedef BinarySpaceTree<BoundType, StatisticType> Type;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * @file mapped_tree.hpp
+ *
+ * Definition of the MappedTree class, which loads a BinarySpaceTree and the
+ * dataset it was built on from a binary tree file, without rebuilding the tree.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_TREE_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_TREE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A BinarySpaceTree loaded from a tree file written by MappedTree::Save(),
+ * along with the (rearranged) dataset the tree was built on and the mapping
+ * from the indices of the points in that dataset to their original indices.
+ *
+ * Where possible (that is, on POSIX systems), the file is memory-mapped, so the
+ * dataset is not actually read until it is used, and the operating system can
+ * share the pages between processes.  Otherwise, the file is read into memory.
+ * The nodes of the tree are recreated from the file, but no splitting or bound
+ * calculation needs to be done, so loading is much faster than building.
+ *
+ * The tree can be given to any method that takes a pre-built tree, such as the
+ * NeighborSearch(TreeType*, ...) constructors.  The MappedTree object must not
+ * be destroyed while the tree or dataset is still in use.  The statistics are
+ * not stored in the file, so a tree saved with one StatisticType may be loaded
+ * with another.
+ *
+ * The file is written in the native byte order.
+ *
+ * @tparam TreeType Type of tree; this must be a BinarySpaceTree using an
+ *     HRectBound and arma::mat.
+ */
+template<typename TreeType>
+class MappedTree
+{
+ public:
+  /**
+   * Load the tree file with the given name.  Log::Fatal is used if the file
+   * cannot be opened or is not a valid tree file.
+   *
+   * @param filename Name of tree file to load.
+   */
+  MappedTree(const std::string& filename);
+
+  /**
+   * Release the tree, the dataset, and the mapped file.
+   */
+  ~MappedTree();
+
+  /**
+   * Save the given tree, the dataset it was built on (as it is ordered by the
+   * tree), and the given mapping to a tree file.
+   *
+   * @param filename Name of tree file to write.
+   * @param tree Tree to save.
+   * @param oldFromNew Mapping from indices in the tree's dataset to original
+   *     indices, as given by the BinarySpaceTree constructor.
+   * @return false if the file could not be written.
+   */
+  static bool Save(const std::string& filename,
+                   const TreeType& tree,
+                   const std::vector<size_t>& oldFromNew);
+
+  //! Get the tree.
+  const TreeType& Tree() const { return *tree; }
+  //! Modify the tree.
+  TreeType& Tree() { return *tree; }
+
+  //! Get the dataset (in the order used by the tree).
+  const arma::mat& Dataset() const { return *dataset; }
+  //! Modify the dataset (in the order used by the tree).
+  arma::mat& Dataset() { return *dataset; }
+
+  //! Get the mapping from indices in the dataset to the original indices.
+  const std::vector<size_t>& OldFromNew() const { return oldFromNew; }
+
+ private:
+  //! The contents of the file (either mapped or allocated).
+  char* memory;
+  //! The size of the file.
+  size_t memorySize;
+  //! If true, the memory is a mapping of the file.
+  bool mapped;
+
+  //! The dataset (which uses the memory of the file).
+  arma::mat* dataset;
+  //! The mapping from new indices to original indices.
+  std::vector<size_t> oldFromNew;
+  //! The tree built on the dataset.
+  TreeType* tree;
+
+  //! Release the contents of the file.
+  void Release();
+
+  //! Not copyable, because the mapping can only be released once.
+  MappedTree(const MappedTree& other);
+  //! Not copyable, because the mapping can only be released once.
+  MappedTree& operator=(const MappedTree& other);
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "mapped_tree_impl.hpp"
+
+#endif
@@ -0,0 +1,258 @@
+/**
+ * @file mapped_tree_impl.hpp
+ *
+ * Implementation of the MappedTree class.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_TREE_IMPL_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_MAPPED_TREE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mapped_tree.hpp"
+#include "binary_space_tree.hpp"
+#include "../hrectbound.hpp"
+
+#include <fstream>
+#include <boost/cstdint.hpp>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The layout of a tree file is:
+ *
+ *  - the 8 characters "MLPACKBT";
+ *  - the version (1), an identifier of the type of bound, the number of rows
+ *    and columns of the dataset, and the number of nodes in the tree, as 64-bit
+ *    unsigned integers;
+ *  - the dataset, in column-major order, as doubles;
+ *  - the oldFromNew mapping, as 64-bit unsigned integers;
+ *  - the node records written by BinarySpaceTree::Save().
+ *
+ * Because the header is 48 bytes long, the dataset is aligned when the file is
+ * mapped.
+ */
+namespace mapped_tree {
+
+static const char magic[8] = { 'M', 'L', 'P', 'A', 'C', 'K', 'B', 'T' };
+static const boost::uint64_t version = 1;
+
+/**
+ * Return an identifier of the bound type of the given type of tree.  The
+ * distances stored in the nodes depend on the metric of the bound, so a tree
+ * can only be loaded with the same type of bound it was saved with.
+ */
+template<int Power,
+         bool TakeRoot,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+boost::uint64_t BoundId(const BinarySpaceTree<bound::HRectBound<Power,
+    TakeRoot>, StatisticType, MatType, SplitType>* /* tree */)
+{
+  return 2 * Power + (TakeRoot ? 1 : 0);
+}
+
+}; // namespace mapped_tree
+
+template<typename TreeType>
+MappedTree<TreeType>::MappedTree(const std::string& filename) :
+    memory(NULL),
+    memorySize(0),
+    mapped(false),
+    dataset(NULL),
+    tree(NULL)
+{
+#ifndef _WIN32
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    Log::Fatal << "Cannot open tree file '" << filename << "'." << std::endl;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+  {
+    close(fd);
+    Log::Fatal << "Cannot determine the size of tree file '" << filename
+        << "'." << std::endl;
+  }
+  memorySize = (size_t) fileStat.st_size;
+
+  // The mapping is private, so the file can't be changed through the dataset.
+  void* address = mmap(NULL, memorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+      fd, 0);
+  close(fd);
+
+  if (address == MAP_FAILED)
+    Log::Fatal << "Cannot map tree file '" << filename << "'." << std::endl;
+
+  memory = (char*) address;
+  mapped = true;
+#else
+  // No mmap(); read the whole file instead.
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open tree file '" << filename << "'." << std::endl;
+
+  stream.seekg(0, std::ios::end);
+  memorySize = (size_t) stream.tellg();
+  stream.seekg(0, std::ios::beg);
+
+  memory = new char[memorySize];
+  stream.read(memory, memorySize);
+  if (!stream.good())
+  {
+    Release();
+    Log::Fatal << "Cannot read tree file '" << filename << "'." << std::endl;
+  }
+#endif
+
+  // Check the header.
+  boost::uint64_t header[5];
+  if ((memorySize < sizeof(mapped_tree::magic) + sizeof(header)) ||
+      (memcmp(memory, mapped_tree::magic, sizeof(mapped_tree::magic)) != 0))
+  {
+    Release();
+    Log::Fatal << "'" << filename << "' is not a tree file." << std::endl;
+  }
+
+  const char* position = memory + sizeof(mapped_tree::magic);
+  memcpy(header, position, sizeof(header));
+  position += sizeof(header);
+
+  if (header[0] != mapped_tree::version)
+  {
+    Release();
+    Log::Fatal << "Tree file '" << filename << "' has unknown version "
+        << header[0] << "." << std::endl;
+  }
+
+  if (header[1] != mapped_tree::BoundId((const TreeType*) NULL))
+  {
+    Release();
+    Log::Fatal << "Tree file '" << filename << "' holds a tree with a different "
+        << "type of bound." << std::endl;
+  }
+
+  const size_t rows = (size_t) header[2];
+  const size_t cols = (size_t) header[3];
+  const size_t nodes = (size_t) header[4];
+
+  // Make sure the file is as long as the header says, so we don't read past
+  // the end of it.
+  const size_t recordSize = 5 * sizeof(boost::uint64_t) +
+      (3 + 2 * rows) * sizeof(double);
+  const size_t expectedSize = (position - memory) +
+      rows * cols * sizeof(double) + cols * sizeof(boost::uint64_t) +
+      nodes * recordSize;
+  if (nodes == 0 || memorySize != expectedSize)
+  {
+    Release();
+    Log::Fatal << "Tree file '" << filename << "' has size " << memorySize
+        << " but should have size " << expectedSize << "." << std::endl;
+  }
+
+  // Use the memory of the file directly for the dataset; the matrix may not be
+  // resized.
+  dataset = new arma::mat((double*) position, rows, cols, false, true);
+  position += rows * cols * sizeof(double);
+
+  oldFromNew.resize(cols);
+  for (size_t i = 0; i < cols; ++i)
+  {
+    boost::uint64_t index;
+    memcpy(&index, position, sizeof(index));
+    position += sizeof(index);
+    oldFromNew[i] = (size_t) index;
+  }
+
+  tree = new TreeType(*dataset, position);
+}
+
+template<typename TreeType>
+MappedTree<TreeType>::~MappedTree()
+{
+  // The tree and dataset must be deleted before the memory they use.
+  if (tree)
+    delete tree;
+  if (dataset)
+    delete dataset;
+
+  Release();
+}
+
+template<typename TreeType>
+bool MappedTree<TreeType>::Save(const std::string& filename,
+                                const TreeType& tree,
+                                const std::vector<size_t>& oldFromNew)
+{
+  const arma::mat& data = tree.Dataset();
+  if (oldFromNew.size() != data.n_cols)
+  {
+    Log::Warn << "Cannot save tree to '" << filename << "': the mapping has "
+        << oldFromNew.size() << " elements but the dataset has " << data.n_cols
+        << " points." << std::endl;
+    return false;
+  }
+
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary |
+      std::ios::trunc);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << filename << "' to save tree to."
+        << std::endl;
+    return false;
+  }
+
+  stream.write(mapped_tree::magic, sizeof(mapped_tree::magic));
+  const boost::uint64_t header[5] = { mapped_tree::version,
+      mapped_tree::BoundId(&tree), data.n_rows, data.n_cols, tree.TreeSize() };
+  stream.write((const char*) header, sizeof(header));
+
+  stream.write((const char*) data.memptr(), data.n_elem * sizeof(double));
+
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+  {
+    const boost::uint64_t index = oldFromNew[i];
+    stream.write((const char*) &index, sizeof(index));
+  }
+
+  tree.Save(stream);
+
+  if (!stream.good())
+  {
+    Log::Warn << "Error while writing tree to '" << filename << "'."
+        << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+template<typename TreeType>
+void MappedTree<TreeType>::Release()
+{
+  if (memory == NULL)
+    return;
+
+#ifndef _WIN32
+  if (mapped)
+    munmap(memory, memorySize);
+  else
+    delete[] memory;
+#else
+  delete[] memory;
+#endif
+
+  memory = NULL;
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -91,13 +91,19 @@ bool MeanSplit<BoundType, MatType>::SplitNode(const BoundType& bound,
   return true;
 }
 
-template<typename BoundType, typename MatType>
-size_t MeanSplit<BoundType, MatType>::
-    PerformSplit(MatType& data,
-                 const size_t begin,
-                 const size_t count,
-                 const size_t splitDimension,
-                 const double splitVal)
+/**
+ * Reorder the columns of a dense matrix so that the points with value less
+ * than splitVal in dimension splitDimension come first, and return the index
+ * of the first point that does not.  If oldFromNew is not NULL, it is updated
+ * to match.
+ */
+template<typename MatType>
+size_t PartitionColumns(MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        const size_t splitDimension,
+                        const double splitVal,
+                        std::vector<size_t>* oldFromNew)
 {
   // This method modifies the input dataset.  We loop both from the left and
   // right sides of the points contained in this node.  The points less than
@@ -118,6 +124,14 @@ size_t MeanSplit<BoundType, MatType>::
     // Swap columns.
     data.swap_cols(left, right);
 
+    // Update the indices for what we changed.
+    if (oldFromNew)
+    {
+      size_t t = (*oldFromNew)[left];
+      (*oldFromNew)[left] = (*oldFromNew)[right];
+      (*oldFromNew)[right] = t;
+    }
+
     // See how many points on the left are correct.  When they are correct,
     // increase the left counter accordingly.  When we encounter one that isn't
     // correct, stop.  We will switch it later.
@@ -137,6 +151,88 @@ size_t MeanSplit<BoundType, MatType>::
   return left;
 }
 
+/**
+ * Reorder the columns of a sparse matrix in the same way.  Swapping two columns
+ * of a sparse matrix means moving all of the nonzero elements stored between
+ * them, so instead the new order is found first and then the nonzero elements
+ * of the node's columns are moved into place in one pass.  The points keep
+ * their relative order on each side of the split.
+ */
+template<typename eT>
+size_t PartitionColumns(arma::SpMat<eT>& data,
+                        const size_t begin,
+                        const size_t count,
+                        const size_t splitDimension,
+                        const double splitVal,
+                        std::vector<size_t>* oldFromNew)
+{
+  // Element access through a const reference does not create any elements.
+  const arma::SpMat<eT>& constData = data;
+
+  std::vector<size_t> order;
+  order.reserve(count);
+  for (size_t i = begin; i < begin + count; ++i)
+    if (constData(splitDimension, i) < splitVal)
+      order.push_back(i);
+
+  const size_t splitCol = begin + order.size();
+  for (size_t i = begin; i < begin + count; ++i)
+    if (!(constData(splitDimension, i) < splitVal))
+      order.push_back(i);
+
+  // Gather the nonzero elements of the columns in their new order.
+  const size_t firstNonzero = data.col_ptrs[begin];
+  const size_t numNonzeros = data.col_ptrs[begin + count] - firstNonzero;
+  std::vector<eT> values(numNonzeros);
+  std::vector<arma::uword> rowIndices(numNonzeros);
+  std::vector<arma::uword> colPtrs(count);
+
+  size_t position = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    colPtrs[i] = firstNonzero + position;
+    for (size_t j = data.col_ptrs[order[i]]; j < data.col_ptrs[order[i] + 1];
+        ++j, ++position)
+    {
+      values[position] = data.values[j];
+      rowIndices[position] = data.row_indices[j];
+    }
+  }
+
+  // Now write them back.  The total number of nonzero elements in the node does
+  // not change, so nothing outside of the node moves.
+  for (size_t i = 0; i < numNonzeros; ++i)
+  {
+    arma::access::rw(data.values[firstNonzero + i]) = values[i];
+    arma::access::rw(data.row_indices[firstNonzero + i]) = rowIndices[i];
+  }
+  for (size_t i = 0; i < count; ++i)
+    arma::access::rw(data.col_ptrs[begin + i]) = colPtrs[i];
+
+  if (oldFromNew)
+  {
+    std::vector<size_t> oldIndices(count);
+    for (size_t i = 0; i < count; ++i)
+      oldIndices[i] = (*oldFromNew)[order[i]];
+    for (size_t i = 0; i < count; ++i)
+      (*oldFromNew)[begin + i] = oldIndices[i];
+  }
+
+  return splitCol;
+}
+
+template<typename BoundType, typename MatType>
+size_t MeanSplit<BoundType, MatType>::
+    PerformSplit(MatType& data,
+                 const size_t begin,
+                 const size_t count,
+                 const size_t splitDimension,
+                 const double splitVal)
+{
+  return PartitionColumns(data, begin, count, splitDimension, splitVal,
+      (std::vector<size_t>*) NULL);
+}
+
 template<typename BoundType, typename MatType>
 size_t MeanSplit<BoundType, MatType>::
     PerformSplit(MatType& data,
@@ -146,47 +242,8 @@ size_t MeanSplit<BoundType, MatType>::
                  const double splitVal,
                  std::vector<size_t>& oldFromNew)
 {
-  // This method modifies the input dataset.  We loop both from the left and
-  // right sides of the points contained in this node.  The points less than
-  // splitVal should be on the left side of the matrix, and the points greater
-  // than splitVal should be on the right side of the matrix.
-  size_t left = begin;
-  size_t right = begin + count - 1;
-
-  // First half-iteration of the loop is out here because the termination
-  // condition is in the middle.
-  while ((data(splitDimension, left) < splitVal) && (left <= right))
-    left++;
-  while ((data(splitDimension, right) >= splitVal) && (left <= right))
-    right--;
-
-  while (left <= right)
-  {
-    // Swap columns.
-    data.swap_cols(left, right);
-
-    // Update the indices for what we changed.
-    size_t t = oldFromNew[left];
-    oldFromNew[left] = oldFromNew[right];
-    oldFromNew[right] = t;  
-
-    // See how many points on the left are correct.  When they are correct,
-    // increase the left counter accordingly.  When we encounter one that isn't
-    // correct, stop.  We will switch it later.
-    while ((data(splitDimension, left) < splitVal) && (left <= right))
-      left++;
-
-    // Now see how many points on the right are correct.  When they are correct,
-    // decrease the right counter accordingly.  When we encounter one that isn't
-    // correct, stop.  We will switch it with the wrong point we found in the
-    // previous loop.
-    while ((data(splitDimension, right) >= splitVal) && (left <= right))
-      right--;
-  }
-
-  Log::Assert(left == right + 1);
-
-  return left;
+  return PartitionColumns(data, begin, count, splitDimension, splitVal,
+      &oldFromNew);
 }
 
 }; // namespace tree
@@ -0,0 +1,121 @@
+/**
+ * @file pca_split.hpp
+ *
+ * Definition of PCASplit, a class that splits a binary space partitioning tree
+ * node with a hyperplane perpendicular to the principal direction of its
+ * points, at the median (a PCA tree).
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_PCA_SPLIT_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_PCA_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * A binary space partitioning tree node is split into its left and right child
+ * by a hyperplane perpendicular to the principal direction of the points of the
+ * node (the direction of largest variance), at the median of the projections
+ * of the points onto it.  Like RPTreeSplit, this adapts to the intrinsic
+ * dimension of the data, and it usually gives smaller cells for the same
+ * number of points, at a higher cost to build.
+ *
+ * The principal direction is found with a few iterations of the power method on
+ * the covariance of the points of the node, without forming the covariance
+ * matrix, so each split costs O(Iterations * d * n) for n points in d
+ * dimensions.  The iterations start from the direction of the point furthest
+ * from the mean, which is usually close to the principal direction.
+ *
+ * As with RPTreeSplit, the children are not boxes, so the split is best used
+ * with a bound that does not depend on the orientation of the axes, such as
+ * BallBound:
+ *
+ * @code
+ * typedef BinarySpaceTree<BallBound<>, EmptyStatistic, arma::mat,
+ *     PCASplit<BallBound<>, arma::mat> > PCATree;
+ * @endcode
+ *
+ * Only dense matrices are supported.
+ */
+template<typename BoundType, typename MatType = arma::mat>
+class PCASplit
+{
+ public:
+  //! The maximum number of power iterations for each split.
+  static const size_t Iterations = 20;
+
+  /**
+   * Split the node along its principal direction.  Because the split is not
+   * along one dimension, splitDimension is set to the number of dimensions of
+   * the data.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitDimension This will be set to the number of dimensions.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitDimension,
+                        size_t& splitCol);
+
+  /**
+   * Split the node along its principal direction and return a list of changed
+   * indices.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitDimension This will be set to the number of dimensions.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew Vector which will be filled with the old positions for
+   *    each new point.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitDimension,
+                        size_t& splitCol,
+                        std::vector<size_t>& oldFromNew);
+
+  /**
+   * Find the principal direction of the given points (the unit eigenvector of
+   * their covariance with the largest eigenvalue), approximately, with the
+   * power method.
+   *
+   * @param points Points to find the principal direction of.
+   * @param direction This will be filled with the principal direction.
+   */
+  template<typename PointsType>
+  static void PrincipalDirection(
+      const PointsType& points,
+      arma::Col<typename MatType::elem_type>& direction);
+
+ private:
+  //! Split the node, updating oldFromNew if it is not NULL.
+  static bool Split(MatType& data,
+                    const size_t begin,
+                    const size_t count,
+                    size_t& splitDimension,
+                    size_t& splitCol,
+                    std::vector<size_t>* oldFromNew);
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "pca_split_impl.hpp"
+
+#endif
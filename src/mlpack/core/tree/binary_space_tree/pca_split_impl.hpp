@@ -0,0 +1,128 @@
+/**
+ * @file pca_split_impl.hpp
+ *
+ * Implementation of class (PCASplit) to split a binary space partition tree
+ * along the principal direction of each node.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_PCA_SPLIT_IMPL_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_PCA_SPLIT_IMPL_HPP
+
+#include "pca_split.hpp"
+#include "projection_partition.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename MatType>
+bool PCASplit<BoundType, MatType>::SplitNode(const BoundType& /* bound */,
+                                             MatType& data,
+                                             const size_t begin,
+                                             const size_t count,
+                                             size_t& splitDimension,
+                                             size_t& splitCol)
+{
+  return Split(data, begin, count, splitDimension, splitCol,
+      (std::vector<size_t>*) NULL);
+}
+
+template<typename BoundType, typename MatType>
+bool PCASplit<BoundType, MatType>::SplitNode(const BoundType& /* bound */,
+                                             MatType& data,
+                                             const size_t begin,
+                                             const size_t count,
+                                             size_t& splitDimension,
+                                             size_t& splitCol,
+                                             std::vector<size_t>& oldFromNew)
+{
+  return Split(data, begin, count, splitDimension, splitCol, &oldFromNew);
+}
+
+template<typename BoundType, typename MatType>
+template<typename PointsType>
+void PCASplit<BoundType, MatType>::PrincipalDirection(
+    const PointsType& points,
+    arma::Col<typename MatType::elem_type>& direction)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const arma::Col<ElemType> mean = arma::mean(points, 1);
+
+  // Start from the direction of the point furthest from the mean.
+  ElemType furthestDistance = -1;
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    const ElemType distance = arma::accu(arma::square(points.col(i) - mean));
+    if (distance > furthestDistance)
+    {
+      furthestDistance = distance;
+      direction = points.col(i) - mean;
+    }
+  }
+
+  ElemType norm = arma::norm(direction, 2);
+  if (norm == 0)
+  {
+    // All the points are the same; any direction will do.
+    direction.zeros(points.n_rows);
+    direction[0] = 1;
+    return;
+  }
+  direction /= norm;
+
+  // Each iteration multiplies the direction by the covariance (up to scale),
+  // as X_c (X_c^T v), where X_c is the centered points; the points are not
+  // actually centered, to avoid copying them.
+  for (size_t iteration = 0; iteration < Iterations; ++iteration)
+  {
+    arma::Row<ElemType> projections = direction.t() * points;
+    projections -= arma::dot(mean, direction);
+
+    arma::Col<ElemType> next = points * projections.t() -
+        mean * arma::accu(projections);
+    norm = arma::norm(next, 2);
+    if (norm == 0)
+      return;
+    next /= norm;
+
+    const ElemType change = 1 - std::abs(arma::dot(next, direction));
+    direction = next;
+    if (change < 1e-6)
+      break;
+  }
+}
+
+template<typename BoundType, typename MatType>
+bool PCASplit<BoundType, MatType>::Split(MatType& data,
+                                         const size_t begin,
+                                         const size_t count,
+                                         size_t& splitDimension,
+                                         size_t& splitCol,
+                                         std::vector<size_t>* oldFromNew)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The split is not along any one dimension.
+  splitDimension = data.n_rows;
+
+  arma::Col<ElemType> direction;
+  PrincipalDirection(data.cols(begin, begin + count - 1), direction);
+
+  arma::Row<ElemType> projections = direction.t() *
+      data.cols(begin, begin + count - 1);
+
+  // Split at the median.
+  arma::Row<ElemType> sorted(projections);
+  std::nth_element(sorted.begin(), sorted.begin() + count / 2, sorted.end());
+  const double splitVal = (double) sorted[count / 2];
+
+  return SplitByProjection(data, begin, count, projections, splitVal, splitCol,
+      oldFromNew);
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file projection_partition.hpp
+ *
+ * Helper functions for the split policies of BinarySpaceTree which split nodes
+ * with a hyperplane (RPTreeSplit and PCASplit): the points of a node are
+ * projected onto a direction, and reordered according to their projections.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_PROJECTION_PARTITION_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_PROJECTION_PARTITION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Reorder the columns of the given node of a dense matrix so that the points
+ * whose projection is less than splitVal come first, and return the index of
+ * the first point whose projection is not.  The projections are reordered
+ * along with the points.  If oldFromNew is not NULL, it is updated to match.
+ * At least one projection must be less than splitVal, and at least one must
+ * not be (see SplitByProjection()).
+ *
+ * @param data The dataset used by the binary space tree.
+ * @param begin Index of the first point of the node.
+ * @param count Number of points in the node.
+ * @param projections Projection of each point of the node (projections[i] is
+ *     the projection of point (begin + i)).
+ * @param splitVal Value to split the projections at.
+ * @param oldFromNew Old position of each point (may be NULL).
+ */
+template<typename MatType, typename VecType>
+size_t PartitionByProjection(MatType& data,
+                             const size_t begin,
+                             const size_t count,
+                             VecType& projections,
+                             const double splitVal,
+                             std::vector<size_t>* oldFromNew)
+{
+  // This is the same two-sided loop as PartitionColumns(), on the projections
+  // instead of one dimension of the data.  Because at least one projection is
+  // less than splitVal and at least one is not, neither index can run past the
+  // ends of the node.
+  size_t left = 0;
+  size_t right = count - 1;
+
+  while ((projections[left] < splitVal) && (left <= right))
+    left++;
+  while ((projections[right] >= splitVal) && (left <= right))
+    right--;
+
+  while (left <= right)
+  {
+    data.swap_cols(begin + left, begin + right);
+    std::swap(projections[left], projections[right]);
+
+    if (oldFromNew)
+      std::swap((*oldFromNew)[begin + left], (*oldFromNew)[begin + right]);
+
+    while ((projections[left] < splitVal) && (left <= right))
+      left++;
+    while ((projections[right] >= splitVal) && (left <= right))
+      right--;
+  }
+
+  Log::Assert(left == right + 1);
+
+  return begin + left;
+}
+
+/**
+ * Split the given node along the given projections at splitVal, and return
+ * whether or not both sides are non-empty.  If splitVal puts all the points on
+ * one side (which can happen when many points have the same projection), the
+ * node is split halfway between the smallest and largest projections instead;
+ * if all the projections are the same, the node cannot be split.
+ *
+ * @param data The dataset used by the binary space tree.
+ * @param begin Index of the first point of the node.
+ * @param count Number of points in the node.
+ * @param projections Projection of each point of the node.
+ * @param splitVal Value to split the projections at.
+ * @param splitCol This will be filled with the index of the first point of the
+ *     right side.
+ * @param oldFromNew Old position of each point (may be NULL).
+ */
+template<typename MatType, typename VecType>
+bool SplitByProjection(MatType& data,
+                       const size_t begin,
+                       const size_t count,
+                       VecType& projections,
+                       const double splitVal,
+                       size_t& splitCol,
+                       std::vector<size_t>* oldFromNew)
+{
+  const double minProjection = projections.min();
+  const double maxProjection = projections.max();
+  if (minProjection == maxProjection)
+    return false;
+
+  double value = splitVal;
+  if (!(value > minProjection && value <= maxProjection))
+    value = 0.5 * (minProjection + maxProjection);
+
+  // The midpoint can round to the smallest projection if the two are adjacent
+  // floating-point numbers.
+  if (!(value > minProjection))
+    value = maxProjection;
+
+  splitCol = PartitionByProjection(data, begin, count, projections, value,
+      oldFromNew);
+
+  return true;
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file rp_tree_split.hpp
+ *
+ * Definition of RPTreeSplit, a class that splits a binary space partitioning
+ * tree node with a hyperplane perpendicular to a random direction, at a
+ * jittered median (a random projection tree).
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_SPLIT_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * A binary space partitioning tree node is split into its left and right child
+ * by a hyperplane.  The normal of the hyperplane is a random direction (drawn
+ * uniformly from the unit sphere), and the points are divided at a random
+ * quantile of their projections onto it, between the first and third quartiles
+ * (a jittered median), so each child gets at least a quarter of the points.
+ * This is the random projection tree of Dasgupta and Freund ("Random
+ * projection trees and low dimensional manifolds", 2008), whose cells shrink
+ * at a rate that depends on the intrinsic dimension of the data instead of the
+ * dimension of the space it lies in.  Axis-aligned splits, such as MeanSplit,
+ * adapt poorly to data lying near a low-dimensional subspace that is not
+ * aligned with the axes.
+ *
+ * The children are not boxes, so the split is best used with a bound that does
+ * not depend on the orientation of the axes, such as BallBound:
+ *
+ * @code
+ * typedef BinarySpaceTree<BallBound<>, EmptyStatistic, arma::mat,
+ *     RPTreeSplit<BallBound<>, arma::mat> > RPTree;
+ * @endcode
+ *
+ * HRectBound can also be used; the boxes are then the bounding boxes of the
+ * points of each node.  The directions are drawn with math::RandNormal().  Only
+ * dense matrices are supported.
+ */
+template<typename BoundType, typename MatType = arma::mat>
+class RPTreeSplit
+{
+ public:
+  /**
+   * Split the node along a random direction.  Because the split is not along
+   * one dimension, splitDimension is set to the number of dimensions of the
+   * data.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitDimension This will be set to the number of dimensions.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitDimension,
+                        size_t& splitCol);
+
+  /**
+   * Split the node along a random direction and return a list of changed
+   * indices.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitDimension This will be set to the number of dimensions.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew Vector which will be filled with the old positions for
+   *    each new point.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitDimension,
+                        size_t& splitCol,
+                        std::vector<size_t>& oldFromNew);
+
+ private:
+  //! Split the node, updating oldFromNew if it is not NULL.
+  static bool Split(MatType& data,
+                    const size_t begin,
+                    const size_t count,
+                    size_t& splitDimension,
+                    size_t& splitCol,
+                    std::vector<size_t>* oldFromNew);
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "rp_tree_split_impl.hpp"
+
+#endif
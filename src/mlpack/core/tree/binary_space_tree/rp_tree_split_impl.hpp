@@ -0,0 +1,81 @@
+/**
+ * @file rp_tree_split_impl.hpp
+ *
+ * Implementation of class (RPTreeSplit) to split a binary space partition tree
+ * along a random direction.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_SPLIT_IMPL_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_RP_TREE_SPLIT_IMPL_HPP
+
+#include "rp_tree_split.hpp"
+#include "projection_partition.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename MatType>
+bool RPTreeSplit<BoundType, MatType>::SplitNode(const BoundType& /* bound */,
+                                                MatType& data,
+                                                const size_t begin,
+                                                const size_t count,
+                                                size_t& splitDimension,
+                                                size_t& splitCol)
+{
+  return Split(data, begin, count, splitDimension, splitCol,
+      (std::vector<size_t>*) NULL);
+}
+
+template<typename BoundType, typename MatType>
+bool RPTreeSplit<BoundType, MatType>::SplitNode(const BoundType& /* bound */,
+                                                MatType& data,
+                                                const size_t begin,
+                                                const size_t count,
+                                                size_t& splitDimension,
+                                                size_t& splitCol,
+                                                std::vector<size_t>& oldFromNew)
+{
+  return Split(data, begin, count, splitDimension, splitCol, &oldFromNew);
+}
+
+template<typename BoundType, typename MatType>
+bool RPTreeSplit<BoundType, MatType>::Split(MatType& data,
+                                            const size_t begin,
+                                            const size_t count,
+                                            size_t& splitDimension,
+                                            size_t& splitCol,
+                                            std::vector<size_t>* oldFromNew)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The split is not along any one dimension.
+  splitDimension = data.n_rows;
+
+  // A direction drawn from a spherical Gaussian is uniform on the sphere; it
+  // does not need to be normalized, because only the order of the projections
+  // matters.
+  arma::Col<ElemType> direction(data.n_rows);
+  for (size_t d = 0; d < data.n_rows; ++d)
+    direction[d] = (ElemType) math::RandNormal();
+
+  arma::Row<ElemType> projections = direction.t() *
+      data.cols(begin, begin + count - 1);
+
+  // Find a random quantile between the first and third quartiles.
+  const size_t lo = count / 4;
+  const size_t hi = std::max(lo + 1, count - count / 4);
+  const size_t rank = (size_t) math::RandInt((int) lo, (int) hi);
+
+  arma::Row<ElemType> sorted(projections);
+  std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+  const double splitVal = (double) sorted[rank];
+
+  return SplitByProjection(data, begin, count, projections, splitVal, splitCol,
+      oldFromNew);
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -20,8 +20,9 @@ namespace tree {
  */
 template<typename BoundType,
          typename StatisticType,
-         typename MatType>
-class TreeTraits<BinarySpaceTree<BoundType, StatisticType, MatType> >
+         typename MatType,
+         typename SplitType>
+class TreeTraits<BinarySpaceTree<BoundType, StatisticType, MatType, SplitType> >
 {
  public:
   /**
@@ -45,6 +46,11 @@ class TreeTraits<BinarySpaceTree<BoundType, StatisticType, MatType> >
    * Points are rearranged during building of the tree.
    */
   static const bool RearrangesDataset = true;
+
+  /**
+   * Each point is held by exactly one leaf.
+   */
+  static const bool HasDuplicatedPoints = false;
 };
 
 }; // namespace tree
@@ -0,0 +1,120 @@
+/**
+ * @file vp_tree_split.hpp
+ *
+ * Definition of VPTreeSplit, a class that splits a binary space partitioning
+ * tree node by the distance of its points from a vantage point, at the median
+ * (a vantage point tree).
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * A binary space partitioning tree node is split into its left and right child
+ * by the distance of its points from a vantage point: the points closer than
+ * the median distance go to the left child, and the others go to the right
+ * child (Yianilos, "Data structures and algorithms for nearest neighbor search
+ * in general metric spaces", 1993).  Only the metric is ever evaluated, so this
+ * works for metrics that the axis-aligned bounds of kd-trees cannot handle,
+ * and it is much cheaper to build than a cover tree.
+ *
+ * The vantage point of a node is the center of its bound, which for
+ * HollowBallBound is the first point of the node.  After a node is split, the
+ * first point of each child is set to an approximate 1-center of a sample of
+ * the points of the child (the sample point closest to all the others), so
+ * that the balls of the children are small.  The bound of the right child gets
+ * a hole around the vantage point of the node (see BinarySpaceTree), so the
+ * split is meant to be used with HollowBallBound:
+ *
+ * @code
+ * typedef BinarySpaceTree<HollowBallBound<>, EmptyStatistic, arma::mat,
+ *     VPTreeSplit<HollowBallBound<>, arma::mat> > VPTree;
+ * @endcode
+ *
+ * Because this is a BinarySpaceTree, the usual single-tree and dual-tree
+ * traversers work with it, so any dual-tree algorithm can use it.  The samples
+ * are drawn with math::RandInt().  Only dense matrices are supported.
+ */
+template<typename BoundType, typename MatType = arma::mat>
+class VPTreeSplit
+{
+ public:
+  //! The number of points sampled to choose the vantage point of each child.
+  static const size_t SampleSize = 20;
+
+  /**
+   * Split the node by the distance from its vantage point.  Because the split
+   * is not along one dimension, splitDimension is set to the number of
+   * dimensions of the data.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitDimension This will be set to the number of dimensions.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitDimension,
+                        size_t& splitCol);
+
+  /**
+   * Split the node by the distance from its vantage point and return a list of
+   * changed indices.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitDimension This will be set to the number of dimensions.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew Vector which will be filled with the old positions for
+   *    each new point.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitDimension,
+                        size_t& splitCol,
+                        std::vector<size_t>& oldFromNew);
+
+ private:
+  //! Split the node, updating oldFromNew if it is not NULL.
+  static bool Split(const BoundType& bound,
+                    MatType& data,
+                    const size_t begin,
+                    const size_t count,
+                    size_t& splitDimension,
+                    size_t& splitCol,
+                    std::vector<size_t>* oldFromNew);
+
+  /**
+   * Move the point that will be the vantage point of the given child to its
+   * first column, updating oldFromNew if it is not NULL.
+   */
+  static void MoveVantagePoint(typename BoundType::MetricType& metric,
+                               MatType& data,
+                               const size_t begin,
+                               const size_t count,
+                               std::vector<size_t>* oldFromNew);
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "vp_tree_split_impl.hpp"
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ * @file vp_tree_split_impl.hpp
+ *
+ * Implementation of class (VPTreeSplit) to split a binary space partition tree
+ * by the distance from a vantage point.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_IMPL_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_IMPL_HPP
+
+#include "vp_tree_split.hpp"
+#include "projection_partition.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename MatType>
+bool VPTreeSplit<BoundType, MatType>::SplitNode(const BoundType& bound,
+                                                MatType& data,
+                                                const size_t begin,
+                                                const size_t count,
+                                                size_t& splitDimension,
+                                                size_t& splitCol)
+{
+  return Split(bound, data, begin, count, splitDimension, splitCol,
+      (std::vector<size_t>*) NULL);
+}
+
+template<typename BoundType, typename MatType>
+bool VPTreeSplit<BoundType, MatType>::SplitNode(const BoundType& bound,
+                                                MatType& data,
+                                                const size_t begin,
+                                                const size_t count,
+                                                size_t& splitDimension,
+                                                size_t& splitCol,
+                                                std::vector<size_t>& oldFromNew)
+{
+  return Split(bound, data, begin, count, splitDimension, splitCol,
+      &oldFromNew);
+}
+
+template<typename BoundType, typename MatType>
+bool VPTreeSplit<BoundType, MatType>::Split(const BoundType& bound,
+                                            MatType& data,
+                                            const size_t begin,
+                                            const size_t count,
+                                            size_t& splitDimension,
+                                            size_t& splitCol,
+                                            std::vector<size_t>* oldFromNew)
+{
+  // The split is not along any one dimension.
+  splitDimension = data.n_rows;
+
+  typename BoundType::MetricType metric = bound.Metric();
+
+  // The distances play the part of the projections of RPTreeSplit; the vantage
+  // point itself is at distance 0, so it goes to the left child.
+  arma::vec distances(count);
+  for (size_t i = 0; i < count; ++i)
+    distances[i] = metric.Evaluate(bound.Center(), data.col(begin + i));
+
+  arma::vec sorted(distances);
+  std::nth_element(sorted.begin(), sorted.begin() + count / 2, sorted.end());
+  const double splitVal = sorted[count / 2];
+
+  if (!SplitByProjection(data, begin, count, distances, splitVal, splitCol,
+      oldFromNew))
+    return false;
+
+  MoveVantagePoint(metric, data, begin, splitCol - begin, oldFromNew);
+  MoveVantagePoint(metric, data, splitCol, begin + count - splitCol,
+      oldFromNew);
+
+  return true;
+}
+
+template<typename BoundType, typename MatType>
+void VPTreeSplit<BoundType, MatType>::MoveVantagePoint(
+    typename BoundType::MetricType& metric,
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    std::vector<size_t>* oldFromNew)
+{
+  // Small children use all of their points as the sample.
+  std::vector<size_t> sample;
+  if (count <= SampleSize)
+  {
+    for (size_t i = 0; i < count; ++i)
+      sample.push_back(begin + i);
+  }
+  else
+  {
+    for (size_t i = 0; i < SampleSize; ++i)
+      sample.push_back((size_t) math::RandInt((int) begin,
+          (int) (begin + count)));
+  }
+
+  // Take the sample point whose furthest sample point is closest.
+  size_t best = sample[0];
+  double bestRadius = DBL_MAX;
+  for (size_t i = 0; i < sample.size(); ++i)
+  {
+    double radius = 0;
+    for (size_t j = 0; j < sample.size() && radius < bestRadius; ++j)
+      radius = std::max(radius, metric.Evaluate(data.col(sample[i]),
+          data.col(sample[j])));
+
+    if (radius < bestRadius)
+    {
+      bestRadius = radius;
+      best = sample[i];
+    }
+  }
+
+  if (best != begin)
+  {
+    data.swap_cols(begin, best);
+    if (oldFromNew)
+      std::swap((*oldFromNew)[begin], (*oldFromNew)[best]);
+  }
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -16,55 +16,49 @@ CosineTree::CosineTree(const arma::mat& dataset) :
     parent(NULL),
     left(NULL),
     right(NULL),
+    indices(new std::vector<size_t>(dataset.n_cols)),
+    l2NormsSquared(new arma::vec(dataset.n_cols)),
+    begin(0),
     numColumns(dataset.n_cols)
 {
-  // Initialize sizes of column indices and l2 norms.
-  indices.resize(numColumns);
-  l2NormsSquared.zeros(numColumns);
-
   // Set indices and calculate squared norms of the columns.
   for(size_t i = 0; i < numColumns; i++)
   {
-    indices[i] = i;
+    (*indices)[i] = i;
     double l2Norm = arma::norm(dataset.col(i), 2);
-    l2NormsSquared(i) = l2Norm * l2Norm;
+    (*l2NormsSquared)(i) = l2Norm * l2Norm;
   }
 
   // Frobenius norm of columns in the node.
-  frobNormSquared = arma::accu(l2NormsSquared);
+  frobNormSquared = arma::accu(*l2NormsSquared);
 
   // Calculate centroid of columns in the node.
   CalculateCentroid();
 
-  splitPointIndex = ColumnSampleLS();
+  splitPointIndex = Index(ColumnSampleLS());
 }
 
 CosineTree::CosineTree(CosineTree& parentNode,
-                       const std::vector<size_t>& subIndices) :
+                       const size_t begin,
+                       const size_t count) :
     dataset(parentNode.GetDataset()),
     parent(&parentNode),
     left(NULL),
     right(NULL),
-    numColumns(subIndices.size())
+    indices(parentNode.indices),
+    l2NormsSquared(parentNode.l2NormsSquared),
+    begin(begin),
+    numColumns(count)
 {
-  // Initialize sizes of column indices and l2 norms.
-  indices.resize(numColumns);
-  l2NormsSquared.zeros(numColumns);
-
-  // Set indices and squared norms of the columns.
-  for(size_t i = 0; i < numColumns; i++)
-  {
-    indices[i] = parentNode.indices[subIndices[i]];
-    l2NormsSquared(i) = parentNode.l2NormsSquared(subIndices[i]);
-  }
-
   // Frobenius norm of columns in the node.
-  frobNormSquared = arma::accu(l2NormsSquared);
+  frobNormSquared = 0;
+  for(size_t i = 0; i < numColumns; i++)
+    frobNormSquared += L2NormSquared(i);
 
   // Calculate centroid of columns in the node.
   CalculateCentroid();
 
-  splitPointIndex = ColumnSampleLS();
+  splitPointIndex = (numColumns > 0) ? Index(ColumnSampleLS()) : 0;
 }
 
 CosineTree::CosineTree(const arma::mat& dataset,
@@ -73,8 +67,11 @@ CosineTree::CosineTree(const arma::mat& dataset,
     dataset(dataset),
     epsilon(epsilon),
     delta(delta),
+    parent(NULL),
     left(NULL),
-    right(NULL)
+    right(NULL),
+    indices(NULL),
+    l2NormsSquared(NULL)
 {
   // Declare the cosine tree priority queue.
   CosineNodeQueue treeQueue;
@@ -137,6 +134,13 @@ CosineTree::~CosineTree()
     delete left;
   if (right)
     delete right;
+
+  // The root node owns the index array.
+  if (!parent)
+  {
+    delete indices;
+    delete l2NormsSquared;
+  }
 }
 
 void CosineTree::ModifiedGramSchmidt(CosineNodeQueue& treeQueue,
@@ -186,12 +190,8 @@ double CosineTree::MonteCarloError(CosineTree* node,
   size_t numSamples = log(node->NumColumns()) + 1;
   node->ColumnSamplesLS(sampledIndices, probabilities, numSamples);
 
-  // Get pointer to the original dataset.
-  arma::mat dataset = node->GetDataset();
-
-  // Initialize weighted projection magnitudes as zeros.
-  arma::vec weightedMagnitudes;
-  weightedMagnitudes.zeros(numSamples);
+  // Get the original dataset.
+  const arma::mat& dataset = node->GetDataset();
 
   // Set size of projection vector, depending on whether additional basis
   // vectors are passed.
@@ -201,41 +201,33 @@ double CosineTree::MonteCarloError(CosineTree* node,
   else
     projectionSize = treeQueue.size();
 
-  // For each sample, calculate the weighted projection onto the current basis.
-  for(size_t i = 0; i < numSamples; i++)
-  {
-    // Initialize projection as a vector of zeros.
-    arma::vec projection;
-    projection.zeros(projectionSize);
-
-    CosineTree *currentNode;
-    CosineNodeQueue::const_iterator j = treeQueue.begin();
+  // Collect the current basis and the samples, so that the projections of all
+  // the samples onto the existing subspace are one matrix product.
+  arma::mat currentBasis(dataset.n_rows, projectionSize);
+  CosineNodeQueue::const_iterator j = treeQueue.begin();
+  size_t k = 0;
+  for(; j != treeQueue.end(); j++, k++)
+    currentBasis.col(k) = (*j)->BasisVector();
 
-    size_t k = 0;
-    // Compute the projection of the sampled vector onto the existing subspace.
-    for(; j != treeQueue.end(); j++, k++)
-    {
-      currentNode = *j;
+  // If two additional vectors are passed, take their projections.
+  if(addBasisVector1 && addBasisVector2)
+  {
+    currentBasis.col(k++) = *addBasisVector1;
+    currentBasis.col(k) = *addBasisVector2;
+  }
 
-      projection(k) = arma::dot(dataset.col(sampledIndices[i]),
-                                currentNode->BasisVector());
-    }
-    // If two additional vectors are passed, take their projections.
-    if(addBasisVector1 && addBasisVector2)
-    {
-      projection(k++) = arma::dot(dataset.col(sampledIndices[i]),
-                                  *addBasisVector1);
-      projection(k) = arma::dot(dataset.col(sampledIndices[i]),
-                                *addBasisVector2);
-    }
+  arma::mat samples(dataset.n_rows, numSamples);
+  for(size_t i = 0; i < numSamples; i++)
+    samples.col(i) = dataset.col(sampledIndices[i]);
 
-    // Calculate the Frobenius norm squared of the projected vector.
-    double frobProjection = arma::norm(projection, "frob");
-    double frobProjectionSquared = frobProjection * frobProjection;
+  const arma::mat projections = arma::trans(currentBasis) * samples;
 
-    // Calculate the weighted projection magnitude.
-    weightedMagnitudes(i) = frobProjectionSquared / probabilities(i);
-  }
+  // Calculate the weighted projection magnitude of each sample, from the
+  // Frobenius norm squared of its projection.
+  arma::vec weightedMagnitudes(numSamples);
+  for(size_t i = 0; i < numSamples; i++)
+    weightedMagnitudes(i) = arma::dot(projections.col(i), projections.col(i)) /
+        probabilities(i);
 
   // Compute mean and standard deviation of the weighted samples.
   double mu = arma::mean(weightedMagnitudes);
@@ -291,6 +283,7 @@ void CosineTree::CosineNodeSplit()
   cosineMin = arma::min(cosines);
 
   std::vector<size_t> leftIndices, rightIndices;
+  std::vector<double> leftNorms, rightNorms;
 
   // Split columns into left and right children. The splitting condition for the
   // column to be in the left child is as follows:
@@ -299,17 +292,33 @@ void CosineTree::CosineNodeSplit()
   {
     if(cosineMax - cosines(i) <= cosines(i) - cosineMin)
     {
-      leftIndices.push_back(i);
+      leftIndices.push_back(Index(i));
+      leftNorms.push_back(L2NormSquared(i));
     }
     else
     {
-      rightIndices.push_back(i);
+      rightIndices.push_back(Index(i));
+      rightNorms.push_back(L2NormSquared(i));
     }
   }
 
+  // Reorder the columns of the node so that those of the left child come
+  // first; the order within each child is kept.
+  for(size_t i = 0; i < leftIndices.size(); i++)
+  {
+    (*indices)[begin + i] = leftIndices[i];
+    (*l2NormsSquared)[begin + i] = leftNorms[i];
+  }
+  for(size_t i = 0; i < rightIndices.size(); i++)
+  {
+    (*indices)[begin + leftIndices.size() + i] = rightIndices[i];
+    (*l2NormsSquared)[begin + leftIndices.size() + i] = rightNorms[i];
+  }
+
   // Split the node into left and right children.
-  left = new CosineTree(*this, leftIndices);
-  right = new CosineTree(*this, rightIndices);
+  left = new CosineTree(*this, begin, leftIndices.size());
+  right = new CosineTree(*this, begin + leftIndices.size(),
+      rightIndices.size());
 }
 
 void CosineTree::ColumnSamplesLS(std::vector<size_t>& sampledIndices,
@@ -323,7 +332,7 @@ void CosineTree::ColumnSamplesLS(std::vector<size_t>& sampledIndices,
   // Calculate cumulative length-squared distribution for the node.
   for(size_t i = 0; i < numColumns; i++)
   {
-    cDistribution(i+1) = cDistribution(i) + l2NormsSquared(i) / frobNormSquared;
+    cDistribution(i+1) = cDistribution(i) + L2NormSquared(i) / frobNormSquared;
   }
 
   // Intialize sizes of the 'sampledIndices' and 'probabilities' vectors.
@@ -338,8 +347,8 @@ void CosineTree::ColumnSamplesLS(std::vector<size_t>& sampledIndices,
 
     // Sample from the distribution and store corresponding probability.
     searchIndex = BinarySearch(cDistribution, randValue, start, end);
-    sampledIndices[i] = indices[searchIndex];
-    probabilities(i) = l2NormsSquared(searchIndex) / frobNormSquared;
+    sampledIndices[i] = Index(searchIndex);
+    probabilities(i) = L2NormSquared(searchIndex) / frobNormSquared;
   }
 }
 
@@ -358,7 +367,7 @@ size_t CosineTree::ColumnSampleLS()
   // Calculate cumulative length-squared distribution for the node.
   for(size_t i = 0; i < numColumns; i++)
   {
-    cDistribution(i+1) = cDistribution(i) + l2NormsSquared(i) / frobNormSquared;
+    cDistribution(i+1) = cDistribution(i) + L2NormSquared(i) / frobNormSquared;
   }
 
   // Generate a random value for sampling.
@@ -402,18 +411,19 @@ void CosineTree::CalculateCosines(arma::vec& cosines)
   // Initialize cosine vector as a vector of zeros.
   cosines.zeros(numColumns);
 
+  #pragma omp parallel for schedule(static)
   for(size_t i = 0; i < numColumns; i++)
   {
     // If norm is zero, store cosine value as zero. Else, calculate cosine value
     // between two vectors.
-    if(l2NormsSquared(i) == 0)
+    if(L2NormSquared(i) == 0)
     {
       cosines(i) = 0;
     }
     else
     {
-      cosines(i) = arma::norm_dot(dataset.col(indices[splitPointIndex]),
-                                  dataset.col(indices[i]));
+      cosines(i) = arma::norm_dot(dataset.col(splitPointIndex),
+                                  dataset.col(Index(i)));
     }
   }
 }
@@ -426,7 +436,7 @@ void CosineTree::CalculateCentroid()
   // Calculate centroid of columns in the node.
   for(size_t i = 0; i < numColumns; i++)
   {
-    centroid += dataset.col(indices[i]);
+    centroid += dataset.col(Index(i));
   }
   centroid /= numColumns;
 }
@@ -36,14 +36,17 @@ class CosineTree
 
   /**
    * CosineTree constructor for nodes other than the root node of the tree. It
-   * takes in a pointer to the parent node and a list of column indices which
-   * mentions the columns to be included in the node. The function calculate the
-   * relevant variables just like the constructor above.
+   * takes in a pointer to the parent node and the range of the columns of the
+   * parent node to be included in the node; the columns of all the nodes are
+   * stored in one permuted index array, which is owned by the root node, and
+   * each node is a contiguous range of it. The function calculate the relevant
+   * variables just like the constructor above.
    *
    * @param parentNode Pointer to the parent cosine node.
-   * @param subIndices Pointer to vector of column indices to be included.
+   * @param begin Position of the first column of the node in the index array.
+   * @param count Number of columns in the node.
    */
-  CosineTree(CosineTree& parentNode, const std::vector<size_t>& subIndices);
+  CosineTree(CosineTree& parentNode, const size_t begin, const size_t count);
 
   /**
    * Construct the CosineTree and the basis for the given matrix, and passed
@@ -64,7 +67,8 @@ class CosineTree
              const double delta);
 
   /**
-   * Clean up the CosineTree: release allocated memory (including children).
+   * Clean up the CosineTree: release allocated memory (including children, and
+   * the index array, if this is the root node).
    */
   ~CosineTree();
 
@@ -88,6 +92,7 @@ class CosineTree
    * weighted norms of projections of samples drawn from the input node's matrix
    * columns. The error is calculated as the difference between the Frobenius
    * norm of the input node's matrix and lower bound of the normal distribution.
+   * The projections of all the samples are computed with one matrix product.
    *
    * @param node Node for which Monte Carlo estimate is calculated.
    * @param treeQueue Priority queue of cosine nodes.
@@ -109,7 +114,9 @@ class CosineTree
   /**
    * This function splits the cosine node into two children based on the cosines
    * of the columns contained in the node, with respect to the sampled splitting
-   * point. The function also calls the CosineTree constructor for the children.
+   * point. The columns of the node are reordered in the index array so that
+   * those of the left child come first. The function also calls the CosineTree
+   * constructor for the children.
    */
   void CosineNodeSplit();
 
@@ -148,7 +155,8 @@ class CosineTree
   /**
    * Calculate cosines of the columns present in the node, with respect to the
    * sampled splitting point. The calculated cosine values are useful for
-   * splitting the node into its children.
+   * splitting the node into its children. The cosines are computed in
+   * parallel.
    *
    * @param cosines Vector to store the cosine values in.
    */
@@ -167,7 +175,11 @@ class CosineTree
   const arma::mat& GetDataset() const { return dataset; }
 
   //! Get the indices of columns in the node.
-  std::vector<size_t>& VectorIndices() { return indices; }
+  std::vector<size_t> VectorIndices() const
+  {
+    return std::vector<size_t>(indices->begin() + begin,
+        indices->begin() + begin + numColumns);
+  }
 
   //! Set the Monte Carlo error.
   void L2Error(const double error) { this->l2Error = error; }
@@ -197,7 +209,7 @@ class CosineTree
   double FrobNormSquared() const { return frobNormSquared; }
 
   //! Get the column index of split point of the node.
-  size_t SplitPointIndex() const { return indices[splitPointIndex]; }
+  size_t SplitPointIndex() const { return splitPointIndex; }
 
  private:
   //! Matrix for which cosine tree is constructed.
@@ -214,15 +226,17 @@ class CosineTree
   CosineTree* left;
   //! Right child of the node.
   CosineTree* right;
-  //! Indices of columns of input matrix in the node.
-  std::vector<size_t> indices;
-  //! L2-norm squared of columns in the node.
-  arma::vec l2NormsSquared;
+  //! Permuted indices of columns of input matrix, shared by all the nodes.
+  std::vector<size_t>* indices;
+  //! L2-norm squared of columns, in the order of the indices.
+  arma::vec* l2NormsSquared;
+  //! Position of the first column of the node in the indices.
+  size_t begin;
   //! Centroid of columns of input matrix in the node.
   arma::vec centroid;
   //! Orthonormalized basis vector of the node.
   arma::vec basisVector;
-  //! Index of split point of cosine node.
+  //! Column index of split point of cosine node.
   size_t splitPointIndex;
   //! Number of columns of input matrix in the node.
   size_t numColumns;
@@ -230,6 +244,15 @@ class CosineTree
   double l2Error;
   //! Frobenius norm squared of columns in the node.
   double frobNormSquared;
+
+  //! Get the column index of the i'th column of the node.
+  size_t Index(const size_t i) const { return (*indices)[begin + i]; }
+
+  //! Get the L2-norm squared of the i'th column of the node.
+  double L2NormSquared(const size_t i) const
+  {
+    return (*l2NormsSquared)[begin + i];
+  }
 };
 
 class CompareCosineNode
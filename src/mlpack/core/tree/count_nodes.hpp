@@ -0,0 +1,34 @@
+/**
+ * @file count_nodes.hpp
+ *
+ * A function to count the nodes of any tree type.
+ */
+#ifndef __MLPACK_CORE_TREE_COUNT_NODES_HPP
+#define __MLPACK_CORE_TREE_COUNT_NODES_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Return the number of nodes in the subtree rooted at the given node
+ * (including the node itself), for any tree type.  (For trees with
+ * self-children, such as the cover tree, each self-child counts as a node.)
+ *
+ * @param node Root of the subtree to count.
+ */
+template<typename TreeType>
+size_t CountNodes(TreeType& node)
+{
+  size_t count = 1;
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    count += CountNodes(node.Child(i));
+
+  return count;
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
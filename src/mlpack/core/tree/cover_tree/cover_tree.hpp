@@ -10,6 +10,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include "first_point_is_root.hpp"
+#include "node_pool.hpp"
 #include "../statistic.hpp"
 
 namespace mlpack {
@@ -147,6 +148,10 @@ class CoverTree
    * @param farSetSize Size of the far set; may be modified (if this node uses
    *     any points in the far set).
    * @param usedSetSize The number of points used will be added to this number.
+   *
+   * If the parent was built by one of the constructors above, the nodes below
+   * this one are allocated from the node pool of that tree, so this node must
+   * be too.
    */
   CoverTree(const arma::mat& dataset,
             const double base,
@@ -330,6 +335,42 @@ class CoverTree
   //! Get the instantiated metric.
   MetricType& Metric() const { return *metric; }
 
+  /**
+   * Insert a point into the tree, without rebuilding it.  The point must
+   * already be a column of the dataset the tree was built on: append it to
+   * that matrix (for instance with insert_cols()), and then call this with its
+   * index.  This must be called on the root of the tree.
+   *
+   * The point is passed down the tree to the closest child that covers it at
+   * each level, as in the usual cover tree insertion, and it becomes a leaf of
+   * the lowest node that covers it; if it is close to a leaf child of that
+   * node, the leaf becomes a node at the lowest scale that covers both points.
+   * The scale of the root is raised if the point is outside of its cover.
+   * Furthest descendant distances, parent distances, and numbers of
+   * descendants are kept exact, so searches give the same results as with a
+   * tree built from scratch, and only the children of the nodes on the path to
+   * the point are visited.  The separation between the nodes of a level is not
+   * always kept, though, so after very many insertions, searches may be
+   * faster with a new tree.
+   *
+   * The statistics of the nodes on the path to the point are not recomputed.
+   *
+   * @param pointIndex Index of the point in the dataset.
+   */
+  void Insert(const size_t pointIndex);
+
+  /**
+   * Insert a block of points into the tree, as with Insert(pointIndex); the
+   * points must be the given number of columns of the dataset starting at
+   * begin.  The points are inserted in order of decreasing distance to the
+   * root, so that, as during construction, the points furthest away are placed
+   * first, at the highest levels.
+   *
+   * @param begin Index of the first point in the dataset.
+   * @param count Number of points to insert.
+   */
+  void Insert(const size_t begin, const size_t count);
+
  private:
   //! Reference to the matrix which this tree is built on.
   const arma::mat& dataset;
@@ -367,6 +408,34 @@ class CoverTree
   //! The metric used for this tree.
   MetricType* metric;
 
+  //! The pool that the nodes of this tree are allocated from (may be NULL).
+  NodePool<CoverTree>* nodePool;
+
+  //! Whether or not we need to destroy the node pool in the destructor.
+  bool localNodePool;
+
+  //! The number of points above which distances are computed in parallel.
+  static const size_t parallelBuildThreshold = 10000;
+
+  /**
+   * Allocate a new node, from the node pool if there is one.  The arguments are
+   * passed on to the node-building constructor.
+   */
+  CoverTree* NewChild(const size_t pointIndex,
+                      const int scale,
+                      const double parentDistance,
+                      arma::Col<size_t>& indices,
+                      arma::vec& distances,
+                      size_t nearSetSize,
+                      size_t& farSetSize,
+                      size_t& usedSetSize);
+
+  /**
+   * Destroy the given node of a tree and free its memory, unless the memory
+   * belongs to the node pool of the tree.
+   */
+  static void DeleteNode(CoverTree* node);
+
   /**
    * Create the children for this node.
    */
@@ -455,6 +524,26 @@ class CoverTree
    */
   void RemoveNewImplicitNodes();
 
+  /**
+   * Insert the given point, which is at the given distance from the point of
+   * the root and is covered by it, starting at the root.
+   */
+  void InsertFromRoot(const size_t pointIndex, const double distance);
+
+  /**
+   * Insert the given point below this node, which covers it; the distance
+   * between the point and the point of this node must be given.  Returns the
+   * number of distance evaluations.
+   */
+  size_t InsertPoint(const size_t pointIndex, const double distance);
+
+  //! Create a leaf holding the given point, as a child of this node.
+  CoverTree* NewLeaf(const size_t pointIndex, const double parentDistance);
+
+  //! Return the lowest scale s whose cover, pow(base, s), holds the given
+  //! distance.
+  int CoveringScale(const double distance) const;
+
  public:
   /**
    * Returns a string representation of this object.
@@ -11,6 +11,7 @@
 #include "cover_tree.hpp"
 
 #include <mlpack/core/util/string_util.hpp>
+#include <functional>
 #include <string>
 
 namespace mlpack {
@@ -32,6 +33,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(0),
     localMetric(metric == NULL),
     metric(metric),
+    nodePool(new NodePool<CoverTree>()),
+    localNodePool(true),
     distanceComps(0)
 {
   // If we need to create a metric, do that.  We'll just do it on the heap.
@@ -84,7 +87,7 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     scale = old->Scale();
 
     // Now delete it.
-    delete old;
+    DeleteNode(old);
   }
 
   // Use the furthest descendant distance to determine the scale of the root
@@ -113,6 +116,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(0),
     localMetric(false),
     metric(&metric),
+    nodePool(new NodePool<CoverTree>()),
+    localNodePool(true),
     distanceComps(0)
 {
   // If there is only one point in the dataset, uh, we're done.
@@ -161,7 +166,7 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     scale = old->Scale();
 
     // Now delete it.
-    delete old;
+    DeleteNode(old);
   }
 
   // Use the furthest descendant distance to determine the scale of the root
@@ -199,6 +204,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(0),
     localMetric(false),
     metric(&metric),
+    nodePool((parent == NULL) ? NULL : parent->nodePool),
+    localNodePool(false),
     distanceComps(0)
 {
   // If the size of the near set is 0, this is a leaf.
@@ -238,6 +245,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(furthestDescendantDistance),
     localMetric(metric == NULL),
     metric(metric),
+    nodePool(NULL),
+    localNodePool(false),
     distanceComps(0)
 {
   // If necessary, create a local metric.
@@ -262,6 +271,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CoverTree(
     furthestDescendantDistance(other.furthestDescendantDistance),
     localMetric(false),
     metric(other.metric),
+    nodePool(NULL),
+    localNodePool(false),
     distanceComps(0)
 {
   // Copy each child by hand.
@@ -277,11 +288,47 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::~CoverTree()
 {
   // Delete each child.
   for (size_t i = 0; i < children.size(); ++i)
-    delete children[i];
+    DeleteNode(children[i]);
 
   // Delete the local metric, if necessary.
   if (localMetric)
     delete metric;
+
+  // Now that every node is destroyed, the memory they used can be released.
+  if (localNodePool)
+    delete nodePool;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::DeleteNode(
+    CoverTree* node)
+{
+  // The root of the tree owns the pool, but is not allocated from it.
+  if (node->nodePool != NULL && !node->localNodePool)
+    node->~CoverTree();
+  else
+    delete node;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+CoverTree<MetricType, RootPointPolicy, StatisticType>*
+CoverTree<MetricType, RootPointPolicy, StatisticType>::NewChild(
+    const size_t pointIndex,
+    const int scale,
+    const double parentDistance,
+    arma::Col<size_t>& indices,
+    arma::vec& distances,
+    size_t nearSetSize,
+    size_t& farSetSize,
+    size_t& usedSetSize)
+{
+  if (nodePool == NULL)
+    return new CoverTree(dataset, base, pointIndex, scale, this, parentDistance,
+        indices, distances, nearSetSize, farSetSize, usedSetSize, *metric);
+
+  return new (nodePool->Allocate()) CoverTree(dataset, base, pointIndex, scale,
+      this, parentDistance, indices, distances, nearSetSize, farSetSize,
+      usedSetSize, *metric);
 }
 
 //! Return the number of descendant points.
@@ -470,17 +517,16 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
     // Make the self child at the lowest possible level.
     // This should not modify farSetSize or usedSetSize.
     size_t tempSize = 0;
-    children.push_back(new CoverTree(dataset, base, point, INT_MIN, this, 0,
-        indices, distances, 0, tempSize, usedSetSize, *metric));
+    children.push_back(NewChild(point, INT_MIN, 0, indices, distances, 0,
+        tempSize, usedSetSize));
     distanceComps += children.back()->DistanceComps();
 
     // Every point in the near set should be a leaf.
     for (size_t i = 0; i < nearSetSize; ++i)
     {
       // farSetSize and usedSetSize will not be modified.
-      children.push_back(new CoverTree(dataset, base, indices[i],
-          INT_MIN, this, distances[i], indices, distances, 0, tempSize,
-          usedSetSize, *metric));
+      children.push_back(NewChild(indices[i], INT_MIN, distances[i], indices,
+          distances, 0, tempSize, usedSetSize));
       distanceComps += children.back()->DistanceComps();
       usedSetSize++;
     }
@@ -510,9 +556,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
   // Build the self child (recursively).
   size_t childFarSetSize = nearSetSize - childNearSetSize;
   size_t childUsedSetSize = 0;
-  children.push_back(new CoverTree(dataset, base, point, nextScale, this, 0,
-      indices, distances, childNearSetSize, childFarSetSize, childUsedSetSize,
-      *metric));
+  children.push_back(NewChild(point, nextScale, 0, indices, distances,
+      childNearSetSize, childFarSetSize, childUsedSetSize));
   // Don't double-count the self-child (so, subtract one).
   numDescendants += children[0]->NumDescendants();
 
@@ -568,9 +613,8 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
     if ((nearSetSize == 1) && (farSetSize == 0))
     {
       size_t childNearSetSize = 0;
-      children.push_back(new CoverTree(dataset, base, indices[0], nextScale,
-          this, distances[0], indices, distances, childNearSetSize, farSetSize,
-          usedSetSize, *metric));
+      children.push_back(NewChild(indices[0], nextScale, distances[0],
+          indices, distances, childNearSetSize, farSetSize, usedSetSize));
       distanceComps += children.back()->DistanceComps();
       numDescendants += children.back()->NumDescendants();
 
@@ -610,9 +654,9 @@ CoverTree<MetricType, RootPointPolicy, StatisticType>::CreateChildren(
 
     // Build this child (recursively).
     childUsedSetSize = 1; // Mark self point as used.
-    children.push_back(new CoverTree(dataset, base, indices[0], nextScale,
-        this, distances[0], childIndices, childDistances, childNearSetSize,
-        childFarSetSize, childUsedSetSize, *metric));
+    children.push_back(NewChild(indices[0], nextScale, distances[0],
+        childIndices, childDistances, childNearSetSize, childFarSetSize,
+        childUsedSetSize));
     numDescendants += children.back()->NumDescendants();
 
     // Remove any implicit nodes.
@@ -697,8 +741,10 @@ void CoverTree<MetricType, RootPointPolicy, StatisticType>::ComputeDistances(
     const size_t pointSetSize)
 {
   // For each point, rebuild the distances.  The indices do not need to be
-  // modified.
+  // modified.  Near the top of the tree there are many points, so it is worth
+  // splitting the work between threads.
   distanceComps += pointSetSize;
+  #pragma omp parallel for if (pointSetSize > parallelBuildThreshold)
   for (size_t i = 0; i < pointSetSize; ++i)
   {
     distances[i] = metric->Evaluate(dataset.unsafe_col(pointIndex),
@@ -971,8 +1017,183 @@ inline void CoverTree<MetricType, RootPointPolicy, StatisticType>::
     old->Children().erase(old->Children().begin() + old->Children().size() - 1);
 
     // Now delete it.
-    delete old;
+    DeleteNode(old);
+  }
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::Insert(
+    const size_t pointIndex)
+{
+  if (parent != NULL)
+    Log::Fatal << "CoverTree::Insert(): points can only be inserted at the "
+        << "root of the tree!" << std::endl;
+  if (pointIndex >= dataset.n_cols)
+    Log::Fatal << "CoverTree::Insert(): point " << pointIndex << " is not in "
+        << "the dataset, which has " << dataset.n_cols << " points!"
+        << std::endl;
+
+  ++distanceComps;
+  InsertFromRoot(pointIndex, metric->Evaluate(dataset.unsafe_col(point),
+      dataset.unsafe_col(pointIndex)));
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::Insert(
+    const size_t begin,
+    const size_t count)
+{
+  if (parent != NULL)
+    Log::Fatal << "CoverTree::Insert(): points can only be inserted at the "
+        << "root of the tree!" << std::endl;
+  if (begin + count > dataset.n_cols)
+    Log::Fatal << "CoverTree::Insert(): points " << begin << " to "
+        << (begin + count - 1) << " are not in the dataset, which has "
+        << dataset.n_cols << " points!" << std::endl;
+
+  std::vector<std::pair<double, size_t> > order(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    order[i] = std::make_pair(metric->Evaluate(dataset.unsafe_col(point),
+        dataset.unsafe_col(begin + i)), begin + i);
+  }
+  distanceComps += count;
+
+  // The furthest points go first.
+  std::sort(order.begin(), order.end(),
+      std::greater<std::pair<double, size_t> >());
+  for (size_t i = 0; i < count; ++i)
+    InsertFromRoot(order[i].second, order[i].first);
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::InsertFromRoot(
+    const size_t pointIndex,
+    const double distance)
+{
+  // A tree of one point becomes a node with a self-child and the new point,
+  // as it would be if it were built with both points.
+  if (children.empty())
+  {
+    children.push_back(NewLeaf(point, 0.0));
+    children.push_back(NewLeaf(pointIndex, distance));
+    numDescendants = 2;
+    furthestDescendantDistance = distance;
+    scale = CoveringScale(distance);
+    stat = StatisticType(*this);
+    return;
   }
+
+  // The cover of the root must hold the new point.  The scales of the nodes
+  // below the root are still lower than its new scale.
+  if (distance > pow(base, scale))
+    scale = CoveringScale(distance);
+
+  distanceComps += InsertPoint(pointIndex, distance);
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+size_t CoverTree<MetricType, RootPointPolicy, StatisticType>::InsertPoint(
+    const size_t pointIndex,
+    const double distance)
+{
+  ++numDescendants;
+  if (distance > furthestDescendantDistance)
+    furthestDescendantDistance = distance;
+
+  // Find the closest child that covers the point, and the closest leaf child.
+  // The self-child is at the same distance as this node.
+  size_t comps = 0;
+  size_t coveringChild = children.size();
+  double coveringDistance = DBL_MAX;
+  size_t leafChild = children.size();
+  double leafDistance = DBL_MAX;
+  for (size_t i = 0; i < children.size(); ++i)
+  {
+    double childDistance = distance;
+    if (i > 0)
+    {
+      childDistance = metric->Evaluate(dataset.unsafe_col(children[i]->Point()),
+          dataset.unsafe_col(pointIndex));
+      ++comps;
+    }
+
+    if (children[i]->IsLeaf())
+    {
+      if (childDistance < leafDistance)
+      {
+        leafChild = i;
+        leafDistance = childDistance;
+      }
+    }
+    else if (childDistance <= pow(base, children[i]->Scale()) &&
+             childDistance < coveringDistance)
+    {
+      coveringChild = i;
+      coveringDistance = childDistance;
+    }
+  }
+
+  if (coveringChild < children.size())
+    return comps + children[coveringChild]->InsertPoint(pointIndex,
+        coveringDistance);
+
+  // If the point is too close to a leaf child to be separated from it at the
+  // level of the children, the leaf becomes a node that holds both.
+  if (leafChild < children.size())
+  {
+    const int leafScale = CoveringScale(leafDistance);
+    if (leafScale < scale)
+    {
+      CoverTree* leaf = children[leafChild];
+      CoverTree* node = new CoverTree(dataset, base, leaf->Point(), leafScale,
+          this, leaf->ParentDistance(), leafDistance, metric);
+
+      leaf->Parent() = node;
+      leaf->ParentDistance() = 0.0;
+      node->children.push_back(leaf);
+      node->children.push_back(node->NewLeaf(pointIndex, leafDistance));
+      node->numDescendants = 2;
+      node->stat = StatisticType(*node);
+
+      children[leafChild] = node;
+      return comps;
+    }
+  }
+
+  children.push_back(NewLeaf(pointIndex, distance));
+  return comps;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+CoverTree<MetricType, RootPointPolicy, StatisticType>*
+CoverTree<MetricType, RootPointPolicy, StatisticType>::NewLeaf(
+    const size_t pointIndex,
+    const double parentDistance)
+{
+  // Nodes made after construction are not allocated from the node pool, so
+  // DeleteNode() deletes them.
+  CoverTree* leaf = new CoverTree(dataset, base, pointIndex, INT_MIN, this,
+      parentDistance, 0.0, metric);
+  leaf->numDescendants = 1;
+  leaf->stat = StatisticType(*leaf);
+  return leaf;
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+int CoverTree<MetricType, RootPointPolicy, StatisticType>::CoveringScale(
+    const double distance) const
+{
+  // Duplicate points are held by nodes at the lowest scale above the leaves.
+  if (distance == 0.0)
+    return INT_MIN + 1;
+
+  int coveringScale = (int) ceil(log(distance) / log(base));
+  // Roundoff in the logarithms may leave the scale one too low.
+  while (pow(base, coveringScale) < distance)
+    ++coveringScale;
+
+  return coveringScale;
 }
 
 /**
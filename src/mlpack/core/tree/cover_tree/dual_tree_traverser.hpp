@@ -8,6 +8,7 @@
 #define __MLPACK_CORE_TREE_COVER_TREE_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <deque>
 #include <queue>
 
 namespace mlpack {
@@ -72,22 +73,137 @@ class CoverTree<MetricType, RootPointPolicy, StatisticType>::DualTreeTraverser
   };
 
   /**
-   * Helper function for traversal of the two trees.
+   * The reference nodes to be recursed into for one query node, grouped by
+   * scale.  This replaces a std::map<int, std::vector<DualCoverTreeMapEntry> >:
+   * the scales are kept in a small sorted array (there are only ever a few of
+   * them), and the vectors of entries of scales which are removed (or of the
+   * whole map, when it is cleared) are kept, with their memory, to be reused
+   * for the next scales.  The traverser keeps one ScaleMap for each level of
+   * the query recursion, so after the first few query nodes the traversal
+   * allocates no memory.
+   */
+  class ScaleMap
+  {
+   public:
+    ScaleMap() : size(0) { }
+
+    //! Return whether or not there are any scales in the map.
+    bool Empty() const { return size == 0; }
+    //! Return the number of scales in the map.
+    size_t Size() const { return size; }
+
+    //! Get the i'th smallest scale.
+    int Scale(const size_t i) const { return scales[i]; }
+    //! Get the entries of the i'th smallest scale.
+    std::vector<DualCoverTreeMapEntry>& Entries(const size_t i)
+    { return entries[i]; }
+
+    //! Get the largest scale.
+    int MaxScale() const { return scales[size - 1]; }
+    //! Get the smallest scale.
+    int MinScale() const { return scales[0]; }
+
+    //! Get the index of the given scale, or Size() if it is not in the map.
+    size_t Find(const int scale) const
+    {
+      const size_t i = std::lower_bound(scales.begin(), scales.begin() + size,
+          scale) - scales.begin();
+      return (i < size && scales[i] == scale) ? i : size;
+    }
+
+    /**
+     * Get the entries of the given scale, adding the scale (with no entries)
+     * if it is not in the map.  Adding a scale moves the vectors of entries of
+     * the larger scales, so references to them are invalidated.
+     */
+    std::vector<DualCoverTreeMapEntry>& operator[](const int scale)
+    {
+      const size_t i = std::lower_bound(scales.begin(), scales.begin() + size,
+          scale) - scales.begin();
+      if (i < size && scales[i] == scale)
+        return entries[i];
+
+      // Make room for the new scale at the end, then move it into place.
+      if (entries.size() == size)
+      {
+        scales.push_back(scale);
+        entries.push_back(std::vector<DualCoverTreeMapEntry>());
+      }
+
+      for (size_t j = size; j > i; --j)
+      {
+        scales[j] = scales[j - 1];
+        entries[j].swap(entries[j - 1]);
+      }
+
+      scales[i] = scale;
+      ++size;
+      return entries[i];
+    }
+
+    //! Remove the i'th smallest scale (its memory is kept for reuse).
+    void Erase(const size_t i)
+    {
+      entries[i].clear();
+      for (size_t j = i; j + 1 < size; ++j)
+      {
+        scales[j] = scales[j + 1];
+        entries[j].swap(entries[j + 1]);
+      }
+
+      --size;
+    }
+
+    //! Remove all the scales (their memory is kept for reuse).
+    void Clear()
+    {
+      for (size_t i = 0; i < size; ++i)
+        entries[i].clear();
+      size = 0;
+    }
+
+   private:
+    //! The scales in the map, in increasing order (only the first size are
+    //! used).
+    std::vector<int> scales;
+    //! The entries of each scale.
+    std::vector<std::vector<DualCoverTreeMapEntry> > entries;
+    //! The number of scales in the map.
+    size_t size;
+  };
+
+  //! The maps of each level of the query recursion.  A deque is used so that
+  //! adding a level does not move the maps of the other levels.
+  std::deque<ScaleMap> scaleMaps;
+
+  //! The entries of the scale being recursed into by ReferenceRecursion().
+  std::vector<DualCoverTreeMapEntry> recursionEntries;
+
+  //! Get the (empty) map for the given level of the query recursion.
+  ScaleMap& LevelMap(const size_t level);
+
+  /**
+   * Helper function for traversal of the two trees, where referenceMap is the
+   * map for the given level of the query recursion.
    */
   void Traverse(CoverTree& queryNode,
-                std::map<int, std::vector<DualCoverTreeMapEntry> >&
-                    referenceMap);
+                ScaleMap& referenceMap,
+                const size_t level);
 
   //! Prepare map for recursion.
   void PruneMap(CoverTree& queryNode,
-                std::map<int, std::vector<DualCoverTreeMapEntry> >&
-                    referenceMap,
-                std::map<int, std::vector<DualCoverTreeMapEntry> >&
-                    childMap);
+                ScaleMap& referenceMap,
+                ScaleMap& childMap);
+
+  //! Score the entries of the given scale for a query child, adding those which
+  //! are not pruned to the child map.
+  void PruneScale(CoverTree& queryNode,
+                  std::vector<DualCoverTreeMapEntry>& scaleVector,
+                  const int scale,
+                  ScaleMap& childMap);
 
   void ReferenceRecursion(CoverTree& queryNode,
-                          std::map<int, std::vector<DualCoverTreeMapEntry> >&
-                              referenceMap);
+                          ScaleMap& referenceMap);
 };
 
 }; // namespace tree
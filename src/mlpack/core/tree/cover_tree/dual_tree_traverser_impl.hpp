@@ -29,7 +29,7 @@ DualTreeTraverser<RuleType>::Traverse(
     CoverTree<MetricType, RootPointPolicy, StatisticType>& referenceNode)
 {
   // Start by creating a map and adding the reference root node to it.
-  std::map<int, std::vector<DualCoverTreeMapEntry> > refMap;
+  ScaleMap& refMap = LevelMap(0);
 
   DualCoverTreeMapEntry rootRefEntry;
 
@@ -43,7 +43,22 @@ DualTreeTraverser<RuleType>::Traverse(
 
   refMap[referenceNode.Scale()].push_back(rootRefEntry);
 
-  Traverse(queryNode, refMap);
+  Traverse(queryNode, refMap, 0);
+}
+
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+template<typename RuleType>
+typename CoverTree<MetricType, RootPointPolicy, StatisticType>::
+    template DualTreeTraverser<RuleType>::ScaleMap&
+CoverTree<MetricType, RootPointPolicy, StatisticType>::
+DualTreeTraverser<RuleType>::LevelMap(const size_t level)
+{
+  // The maps are kept from one traversal to the next, with their memory.
+  while (scaleMaps.size() <= level)
+    scaleMaps.push_back(ScaleMap());
+
+  scaleMaps[level].Clear();
+  return scaleMaps[level];
 }
 
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
@@ -51,38 +66,39 @@ template<typename RuleType>
 void CoverTree<MetricType, RootPointPolicy, StatisticType>::
 DualTreeTraverser<RuleType>::Traverse(
     CoverTree<MetricType, RootPointPolicy, StatisticType>& queryNode,
-    std::map<int, std::vector<DualCoverTreeMapEntry> >& referenceMap)
+    ScaleMap& referenceMap,
+    const size_t level)
 {
-  if (referenceMap.size() == 0)
+  if (referenceMap.Empty())
     return; // Nothing to do!
 
   // First recurse down the reference nodes as necessary.
   ReferenceRecursion(queryNode, referenceMap);
 
   // Did the map get emptied?
-  if (referenceMap.size() == 0)
+  if (referenceMap.Empty())
     return; // Nothing to do!
 
   // Now, reduce the scale of the query node by recursing.  But we can't recurse
   // if the query node is a leaf node.
   if ((queryNode.Scale() != INT_MIN) &&
-      (queryNode.Scale() >= (*referenceMap.rbegin()).first))
+      (queryNode.Scale() >= referenceMap.MaxScale()))
   {
     // Recurse into the non-self-children first.  The recursion order cannot
     // affect the runtime of the algorithm, because each query child recursion's
     // results are separate and independent.  I don't think this is true in
     // every case, and we may have to modify this section to consider scores in
-    // the future.
+    // the future.  Each child's recursion is done before the next child's
+    // starts, so they all use the same map for the next level.
     for (size_t i = 1; i < queryNode.NumChildren(); ++i)
     {
-      // We need a copy of the map for this child.
-      std::map<int, std::vector<DualCoverTreeMapEntry> > childMap;
+      ScaleMap& childMap = LevelMap(level + 1);
       PruneMap(queryNode.Child(i), referenceMap, childMap);
-      Traverse(queryNode.Child(i), childMap);
+      Traverse(queryNode.Child(i), childMap, level + 1);
     }
-    std::map<int, std::vector<DualCoverTreeMapEntry> > selfChildMap;
+    ScaleMap& selfChildMap = LevelMap(level + 1);
     PruneMap(queryNode.Child(0), referenceMap, selfChildMap);
-    Traverse(queryNode.Child(0), selfChildMap);
+    Traverse(queryNode.Child(0), selfChildMap, level + 1);
   }
 
   if (queryNode.Scale() != INT_MIN)
@@ -90,10 +106,9 @@ DualTreeTraverser<RuleType>::Traverse(
 
   // If we have made it this far, all we have is a bunch of base case
   // evaluations to do.
-  Log::Assert((*referenceMap.begin()).first == INT_MIN);
+  Log::Assert(referenceMap.MinScale() == INT_MIN);
   Log::Assert(queryNode.Scale() == INT_MIN);
-  std::vector<DualCoverTreeMapEntry>& pointVector =
-      (*referenceMap.begin()).second;
+  std::vector<DualCoverTreeMapEntry>& pointVector = referenceMap.Entries(0);
 
   for (size_t i = 0; i < pointVector.size(); ++i)
   {
@@ -133,117 +148,76 @@ template<typename RuleType>
 void CoverTree<MetricType, RootPointPolicy, StatisticType>::
 DualTreeTraverser<RuleType>::PruneMap(
     CoverTree& queryNode,
-    std::map<int, std::vector<DualCoverTreeMapEntry> >& referenceMap,
-    std::map<int, std::vector<DualCoverTreeMapEntry> >& childMap)
+    ScaleMap& referenceMap,
+    ScaleMap& childMap)
 {
-  if (referenceMap.empty())
+  if (referenceMap.Empty())
     return; // Nothing to do.
 
   // Copy the zero set first.
-  if ((*referenceMap.begin()).first == INT_MIN)
-  {
-    // Get a reference to the vector representing the entries at this scale.
-    std::vector<DualCoverTreeMapEntry>& scaleVector =
-        (*referenceMap.begin()).second;
-
-    // Before traversing all the points in this scale, sort by score.
-    std::sort(scaleVector.begin(), scaleVector.end());
-
-    const int thisScale = (*referenceMap.begin()).first;
-    childMap[thisScale].reserve(scaleVector.size());
-    std::vector<DualCoverTreeMapEntry>& newScaleVector = childMap[thisScale];
-
-    // Loop over each entry in the vector.
-    for (size_t j = 0; j < scaleVector.size(); ++j)
-    {
-      const DualCoverTreeMapEntry& frame = scaleVector[j];
-
-      // First evaluate if we can prune without performing the base case.
-      CoverTree<MetricType, RootPointPolicy, StatisticType>* refNode =
-          frame.referenceNode;
-
-      // Perform the actual scoring, after restoring the traversal info.
-      rule.TraversalInfo() = frame.traversalInfo;
-      double score = rule.Score(queryNode, *refNode);
-
-      if (score == DBL_MAX)
-      {
-        // Pruned.  Move on.
-        ++numPrunes;
-        continue;
-      }
-
-      // If it isn't pruned, we must evaluate the base case.
-      const double baseCase = rule.BaseCase(queryNode.Point(),
-          refNode->Point());
-
-      // Add to child map.
-      newScaleVector.push_back(frame);
-      newScaleVector.back().score = score;
-      newScaleVector.back().baseCase = baseCase;
-      newScaleVector.back().traversalInfo = rule.TraversalInfo();
-    }
-
-    // If we didn't add anything, then strike this vector from the map.
-    if (newScaleVector.size() == 0)
-      childMap.erase((*referenceMap.begin()).first);
-  }
-
-  typename std::map<int, std::vector<DualCoverTreeMapEntry> >::reverse_iterator
-      it = referenceMap.rbegin();
+  if (referenceMap.MinScale() == INT_MIN)
+    PruneScale(queryNode, referenceMap.Entries(0), INT_MIN, childMap);
 
-  while ((it != referenceMap.rend()))
+  // Then the other scales, from the largest down.
+  for (size_t i = referenceMap.Size(); i > 0; --i)
   {
-    const int thisScale = (*it).first;
+    const int thisScale = referenceMap.Scale(i - 1);
     if (thisScale == INT_MIN) // We already did it.
       break;
 
-    // Get a reference to the vector representing the entries at this scale.
-    std::vector<DualCoverTreeMapEntry>& scaleVector = (*it).second;
-
-    // Before traversing all the points in this scale, sort by score.
-    std::sort(scaleVector.begin(), scaleVector.end());
-
-    childMap[thisScale].reserve(scaleVector.size());
-    std::vector<DualCoverTreeMapEntry>& newScaleVector = childMap[thisScale];
+    PruneScale(queryNode, referenceMap.Entries(i - 1), thisScale, childMap);
+  }
+}
 
-    // Loop over each entry in the vector.
-    for (size_t j = 0; j < scaleVector.size(); ++j)
-    {
-      const DualCoverTreeMapEntry& frame = scaleVector[j];
+template<typename MetricType, typename RootPointPolicy, typename StatisticType>
+template<typename RuleType>
+void CoverTree<MetricType, RootPointPolicy, StatisticType>::
+DualTreeTraverser<RuleType>::PruneScale(
+    CoverTree& queryNode,
+    std::vector<DualCoverTreeMapEntry>& scaleVector,
+    const int scale,
+    ScaleMap& childMap)
+{
+  // Before traversing all the points in this scale, sort by score.
+  std::sort(scaleVector.begin(), scaleVector.end());
 
-      // First evaluate if we can prune without performing the base case.
-      CoverTree<MetricType, RootPointPolicy, StatisticType>* refNode =
-          frame.referenceNode;
+  std::vector<DualCoverTreeMapEntry>& newScaleVector = childMap[scale];
+  newScaleVector.reserve(scaleVector.size());
 
-      // Perform the actual scoring, after restoring the traversal info.
-      rule.TraversalInfo() = frame.traversalInfo;
-      double score = rule.Score(queryNode, *refNode);
+  // Loop over each entry in the vector.
+  for (size_t j = 0; j < scaleVector.size(); ++j)
+  {
+    const DualCoverTreeMapEntry& frame = scaleVector[j];
 
-      if (score == DBL_MAX)
-      {
-        // Pruned.  Move on.
-        ++numPrunes;
-        continue;
-      }
+    // First evaluate if we can prune without performing the base case.
+    CoverTree<MetricType, RootPointPolicy, StatisticType>* refNode =
+        frame.referenceNode;
 
-      // If it isn't pruned, we must evaluate the base case.
-      const double baseCase = rule.BaseCase(queryNode.Point(),
-          refNode->Point());
+    // Perform the actual scoring, after restoring the traversal info.
+    rule.TraversalInfo() = frame.traversalInfo;
+    double score = rule.Score(queryNode, *refNode);
 
-      // Add to child map.
-      newScaleVector.push_back(frame);
-      newScaleVector.back().score = score;
-      newScaleVector.back().baseCase = baseCase;
-      newScaleVector.back().traversalInfo = rule.TraversalInfo();
+    if (score == DBL_MAX)
+    {
+      // Pruned.  Move on.
+      ++numPrunes;
+      continue;
     }
 
-    // If we didn't add anything, then strike this vector from the map.
-    if (newScaleVector.size() == 0)
-      childMap.erase((*it).first);
+    // If it isn't pruned, we must evaluate the base case.
+    const double baseCase = rule.BaseCase(queryNode.Point(),
+        refNode->Point());
 
-    ++it; // Advance to next scale.
+    // Add to child map.
+    newScaleVector.push_back(frame);
+    newScaleVector.back().score = score;
+    newScaleVector.back().baseCase = baseCase;
+    newScaleVector.back().traversalInfo = rule.TraversalInfo();
   }
+
+  // If we didn't add anything, then strike this scale from the map.
+  if (newScaleVector.empty())
+    childMap.Erase(childMap.Find(scale));
 }
 
 template<typename MetricType, typename RootPointPolicy, typename StatisticType>
@@ -251,36 +225,40 @@ template<typename RuleType>
 void CoverTree<MetricType, RootPointPolicy, StatisticType>::
 DualTreeTraverser<RuleType>::ReferenceRecursion(
     CoverTree& queryNode,
-    std::map<int, std::vector<DualCoverTreeMapEntry> >& referenceMap)
+    ScaleMap& referenceMap)
 {
   // First, reduce the maximum scale in the reference map down to the scale of
   // the query node.
-  while (!referenceMap.empty())
+  while (!referenceMap.Empty())
   {
     // Hacky bullshit to imitate jl cover tree.
-    if (queryNode.Parent() == NULL && (*referenceMap.rbegin()).first <
+    if (queryNode.Parent() == NULL && referenceMap.MaxScale() <
         queryNode.Scale())
       break;
-    if (queryNode.Parent() != NULL && (*referenceMap.rbegin()).first <=
+    if (queryNode.Parent() != NULL && referenceMap.MaxScale() <=
         queryNode.Scale())
       break;
     // If the query node's scale is INT_MIN and the reference map's maximum
     // scale is INT_MIN, don't try to recurse...
     if ((queryNode.Scale() == INT_MIN) &&
-       ((*referenceMap.rbegin()).first == INT_MIN))
+       (referenceMap.MaxScale() == INT_MIN))
       break;
 
-    // Get a reference to the current largest scale.
-    std::vector<DualCoverTreeMapEntry>& scaleVector = (*referenceMap.rbegin()).second;
+    // Take the entries of the current largest scale out of the map; it isn't
+    // needed anymore, and the children added below all have smaller scales.
+    const size_t maxIndex = referenceMap.Size() - 1;
+    recursionEntries.clear();
+    recursionEntries.swap(referenceMap.Entries(maxIndex));
+    referenceMap.Erase(maxIndex);
 
     // Before traversing all the points in this scale, sort by score.
-    std::sort(scaleVector.begin(), scaleVector.end());
+    std::sort(recursionEntries.begin(), recursionEntries.end());
 
     // Now loop over each element.
-    for (size_t i = 0; i < scaleVector.size(); ++i)
+    for (size_t i = 0; i < recursionEntries.size(); ++i)
     {
       // Get a reference to the current element.
-      const DualCoverTreeMapEntry& frame = scaleVector.at(i);
+      const DualCoverTreeMapEntry& frame = recursionEntries[i];
 
       CoverTree<MetricType, RootPointPolicy, StatisticType>* refNode =
           frame.referenceNode;
@@ -322,9 +300,6 @@ DualTreeTraverser<RuleType>::ReferenceRecursion(
         referenceMap[newFrame.referenceNode->Scale()].push_back(newFrame);
       }
     }
-
-    // Now clear the memory for this scale; it isn't needed anymore.
-    referenceMap.erase((*referenceMap.rbegin()).first);
   }
 }
 
@@ -0,0 +1,82 @@
+/**
+ * @file node_pool.hpp
+ *
+ * A simple arena for allocating the nodes of a tree in large blocks, so that
+ * building a tree does not make one heap allocation per node and freeing the
+ * tree releases a handful of blocks instead of every node separately.
+ */
+#ifndef __MLPACK_CORE_TREE_COVER_TREE_NODE_POOL_HPP
+#define __MLPACK_CORE_TREE_COVER_TREE_NODE_POOL_HPP
+
+#include <mlpack/core.hpp>
+#include <new>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Hands out uninitialized memory for objects of type NodeType, carved out of
+ * blocks that each hold blockSize objects.  Memory is never returned to the
+ * pool one object at a time; it is all released when the pool is destroyed.
+ * The pool does not call any destructors, so objects built in its memory with
+ * placement new must be destroyed by hand before the pool goes away.
+ *
+ * The pool is not thread-safe.
+ *
+ * @tparam NodeType Type of object to allocate.
+ */
+template<typename NodeType>
+class NodePool
+{
+ public:
+  /**
+   * Create an empty pool; no memory is allocated until the first call to
+   * Allocate().
+   *
+   * @param blockSize Number of objects to allocate room for at a time.
+   */
+  NodePool(const size_t blockSize = 1024) :
+      blockSize(blockSize),
+      used(blockSize)
+  { }
+
+  //! Release all of the memory held by the pool.
+  ~NodePool()
+  {
+    for (size_t i = 0; i < blocks.size(); ++i)
+      ::operator delete(blocks[i]);
+  }
+
+  //! Return memory for one object of type NodeType.
+  void* Allocate()
+  {
+    if (used == blockSize)
+    {
+      blocks.push_back(::operator new(sizeof(NodeType) * blockSize));
+      used = 0;
+    }
+
+    return static_cast<char*>(blocks.back()) + sizeof(NodeType) * used++;
+  }
+
+  //! Return the number of blocks that have been allocated.
+  size_t NumBlocks() const { return blocks.size(); }
+
+ private:
+  //! The pool cannot be copied.
+  NodePool(const NodePool& other);
+  //! The pool cannot be copied.
+  NodePool& operator=(const NodePool& other);
+
+  //! The number of objects that fit in each block.
+  size_t blockSize;
+  //! The number of objects handed out from the last block.
+  size_t used;
+  //! The allocated blocks.
+  std::vector<void*> blocks;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
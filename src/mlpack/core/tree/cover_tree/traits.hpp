@@ -46,6 +46,11 @@ class TreeTraits<CoverTree<MetricType, RootPointPolicy, StatisticType> >
    * Points are not rearranged when the tree is built.
    */
   static const bool RearrangesDataset = false;
+
+  /**
+   * A point is held by several nodes (as self-children), but by only one leaf.
+   */
+  static const bool HasDuplicatedPoints = false;
 };
 
 }; // namespace tree
@@ -0,0 +1,196 @@
+/**
+ * @file fixed_hrectbound.hpp
+ *
+ * Bounds that are useful for binary space partitioning trees.
+ *
+ * This file describes the interface for the FixedHRectBound class, which
+ * implements a hyperrectangle bound whose dimensionality is known at compile
+ * time.
+ */
+#ifndef __MLPACK_CORE_TREE_FIXED_HRECTBOUND_HPP
+#define __MLPACK_CORE_TREE_FIXED_HRECTBOUND_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/math/range.hpp>
+#include <mlpack/core/metrics/fixed_lmetric.hpp>
+
+namespace mlpack {
+namespace bound {
+
+/**
+ * Hyper-rectangle bound for an L-metric, for data with a dimensionality that is
+ * known at compile time.  This is the same as HRectBound, except that the
+ * ranges are stored in the bound itself instead of on the heap, and every loop
+ * over the dimensions has a constant number of iterations, so for
+ * low-dimensional data (for instance two- or three-dimensional geographic data)
+ * the loops are unrolled and each distance calculation touches a single block
+ * of memory.
+ *
+ * This should be used in conjunction with the FixedLMetric class, with the
+ * same template parameters.  A kd-tree for three-dimensional data is then
+ *
+ * @code
+ * typedef BinarySpaceTree<FixedHRectBound<3>, EmptyStatistic> KDTree3D;
+ * @endcode
+ *
+ * (see also FixedDimensionKDTree).  Building a tree with a FixedHRectBound on
+ * data of any other dimensionality is an error.  Only dense data is supported.
+ *
+ * @tparam Dimensionality The dimensionality of the data.
+ * @tparam Power The metric to use; use 2 for Euclidean (L2).
+ * @tparam TakeRoot Whether or not the root should be taken (see LMetric
+ *     documentation).
+ */
+template<size_t Dimensionality, int Power = 2, bool TakeRoot = true>
+class FixedHRectBound
+{
+ public:
+  //! This is the metric type that this bound is using.
+  typedef metric::FixedLMetric<Dimensionality, Power, TakeRoot> MetricType;
+
+  /**
+   * Empty constructor; each dimension is the empty set.
+   */
+  FixedHRectBound();
+
+  /**
+   * Initializes with each dimension the empty set.  The given dimensionality
+   * must be Dimensionality.
+   */
+  FixedHRectBound(const size_t dimension);
+
+  /**
+   * Resets all dimensions to the empty set (so that this bound contains
+   * nothing).
+   */
+  void Clear();
+
+  //! Gets the dimensionality.
+  size_t Dim() const { return Dimensionality; }
+
+  //! Get the range for a particular dimension.  No bounds checking.  Be
+  //! careful: this may make MinWidth() invalid.
+  math::Range& operator[](const size_t i) { return bounds[i]; }
+  //! Modify the range for a particular dimension.  No bounds checking.
+  const math::Range& operator[](const size_t i) const { return bounds[i]; }
+
+  //! Get the minimum width of the bound.
+  double MinWidth() const { return minWidth; }
+  //! Modify the minimum width of the bound.
+  double& MinWidth() { return minWidth; }
+
+  /**
+   * Calculates the centroid of the range, placing it into the given vector.
+   *
+   * @param centroid Vector which the centroid will be written to.
+   */
+  template<typename VecType>
+  void Centroid(VecType& centroid) const;
+
+  /**
+   * Calculate the volume of the hyperrectangle.
+   *
+   * @return Volume of the hyperrectangle.
+   */
+  double Volume() const;
+
+  /**
+   * Calculates minimum bound-to-point distance.
+   *
+   * @param point Point to which the minimum distance is requested.
+   */
+  template<typename VecType>
+  double MinDistance(const VecType& point,
+                     typename boost::enable_if<IsVector<VecType> >* = 0) const;
+
+  /**
+   * Calculates minimum bound-to-bound distance.
+   *
+   * @param other Bound to which the minimum distance is requested.
+   */
+  double MinDistance(const FixedHRectBound& other) const;
+
+  /**
+   * Calculates maximum bound-to-point distance.
+   *
+   * @param point Point to which the maximum distance is requested.
+   */
+  template<typename VecType>
+  double MaxDistance(const VecType& point,
+                     typename boost::enable_if<IsVector<VecType> >* = 0) const;
+
+  /**
+   * Computes maximum distance.
+   *
+   * @param other Bound to which the maximum distance is requested.
+   */
+  double MaxDistance(const FixedHRectBound& other) const;
+
+  /**
+   * Calculates minimum and maximum bound-to-bound distance.
+   *
+   * @param other Bound to which the minimum and maximum distances are
+   *     requested.
+   */
+  math::Range RangeDistance(const FixedHRectBound& other) const;
+
+  /**
+   * Calculates minimum and maximum bound-to-point distance.
+   *
+   * @param point Point to which the minimum and maximum distances are
+   *     requested.
+   */
+  template<typename VecType>
+  math::Range RangeDistance(const VecType& point,
+                            typename boost::enable_if<IsVector<VecType> >* = 0)
+      const;
+
+  /**
+   * Expands this region to include new points.
+   *
+   * @tparam MatType Type of matrix; could be Mat, a subview, or just a vector.
+   * @param data Data points to expand this region to include.
+   */
+  template<typename MatType>
+  FixedHRectBound& operator|=(const MatType& data);
+
+  /**
+   * Expands this region to encompass another bound.
+   */
+  FixedHRectBound& operator|=(const FixedHRectBound& other);
+
+  /**
+   * Determines if a point is within this bound.
+   */
+  template<typename VecType>
+  bool Contains(const VecType& point) const;
+
+  /**
+   * Returns the diameter of the hyperrectangle (that is, the longest diagonal).
+   */
+  double Diameter() const;
+
+  /**
+   * Returns a string representation of this object.
+   */
+  std::string ToString() const;
+
+  /**
+   * Return the metric associated with this bound.  Because it is a
+   * FixedLMetric, it cannot store state, so we can make it on the fly.
+   */
+  static MetricType Metric() { return MetricType(); }
+
+ private:
+  //! The bounds for each dimension.
+  math::Range bounds[Dimensionality];
+  //! Cached minimum width of bound.
+  double minWidth;
+};
+
+}; // namespace bound
+}; // namespace mlpack
+
+#include "fixed_hrectbound_impl.hpp"
+
+#endif // __MLPACK_CORE_TREE_FIXED_HRECTBOUND_HPP
@@ -0,0 +1,351 @@
+/**
+ * @file fixed_hrectbound_impl.hpp
+ *
+ * Implementation of the fixed-dimensionality hyper-rectangle bound policy
+ * class.  Each function is the same as in hrectbound_impl.hpp, but loops over a
+ * constant number of dimensions.
+ */
+#ifndef __MLPACK_CORE_TREE_FIXED_HRECTBOUND_IMPL_HPP
+#define __MLPACK_CORE_TREE_FIXED_HRECTBOUND_IMPL_HPP
+
+#include <math.h>
+
+// In case it has not been included yet.
+#include "fixed_hrectbound.hpp"
+
+namespace mlpack {
+namespace bound {
+
+/**
+ * Empty constructor.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+inline FixedHRectBound<Dimensionality, Power, TakeRoot>::FixedHRectBound() :
+    minWidth(0)
+{ /* Nothing to do. */ }
+
+/**
+ * Initializes with each dimension the empty set.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+inline FixedHRectBound<Dimensionality, Power, TakeRoot>::FixedHRectBound(
+    const size_t dimension) :
+    minWidth(0)
+{
+  if (dimension != Dimensionality)
+    Log::Fatal << "FixedHRectBound::FixedHRectBound(): the bound has "
+        << Dimensionality << " dimensions, but " << dimension << " were "
+        << "requested!" << std::endl;
+}
+
+/**
+ * Resets all dimensions to the empty set.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+inline void FixedHRectBound<Dimensionality, Power, TakeRoot>::Clear()
+{
+  for (size_t i = 0; i < Dimensionality; i++)
+    bounds[i] = math::Range();
+  minWidth = 0;
+}
+
+/***
+ * Calculates the centroid of the range, placing it into the given vector.
+ *
+ * @param centroid Vector which the centroid will be written to.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+template<typename VecType>
+inline void FixedHRectBound<Dimensionality, Power, TakeRoot>::Centroid(
+    VecType& centroid) const
+{
+  // Set size correctly if necessary.
+  if (!(centroid.n_elem == Dimensionality))
+    centroid.set_size(Dimensionality);
+
+  for (size_t i = 0; i < Dimensionality; i++)
+    centroid(i) = bounds[i].Mid();
+}
+
+/**
+ * Calculate the volume of the hyperrectangle.
+ *
+ * @return Volume of the hyperrectangle.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+inline double FixedHRectBound<Dimensionality, Power, TakeRoot>::Volume() const
+{
+  double volume = 1.0;
+  for (size_t i = 0; i < Dimensionality; ++i)
+    volume *= (bounds[i].Hi() - bounds[i].Lo());
+
+  return volume;
+}
+
+/**
+ * Calculates minimum bound-to-point distance.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+template<typename VecType>
+inline double FixedHRectBound<Dimensionality, Power, TakeRoot>::MinDistance(
+    const VecType& point,
+    typename boost::enable_if<IsVector<VecType> >* /* junk */) const
+{
+  Log::Assert(point.n_elem == Dimensionality);
+
+  double sum = 0;
+  for (size_t d = 0; d < Dimensionality; d++)
+  {
+    const double lower = bounds[d].Lo() - point[d];
+    const double higher = point[d] - bounds[d].Hi();
+
+    // See HRectBound::MinDistance(): this is twice the distance in this
+    // dimension.
+    sum += math::IntPow<Power>((lower + fabs(lower)) + (higher + fabs(higher)));
+  }
+
+  if (TakeRoot)
+    return math::IntRoot<Power>(sum) / 2.0;
+  else
+    return sum / math::IntPow<Power>(2.0);
+}
+
+/**
+ * Calculates minimum bound-to-bound distance.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+inline double FixedHRectBound<Dimensionality, Power, TakeRoot>::MinDistance(
+    const FixedHRectBound& other) const
+{
+  double sum = 0;
+  for (size_t d = 0; d < Dimensionality; d++)
+  {
+    const double lower = other.bounds[d].Lo() - bounds[d].Hi();
+    const double higher = bounds[d].Lo() - other.bounds[d].Hi();
+    sum += math::IntPow<Power>((lower + fabs(lower)) + (higher + fabs(higher)));
+  }
+
+  if (TakeRoot)
+    return math::IntRoot<Power>(sum) / 2.0;
+  else
+    return sum / math::IntPow<Power>(2.0);
+}
+
+/**
+ * Calculates maximum bound-to-point distance.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+template<typename VecType>
+inline double FixedHRectBound<Dimensionality, Power, TakeRoot>::MaxDistance(
+    const VecType& point,
+    typename boost::enable_if<IsVector<VecType> >* /* junk */) const
+{
+  Log::Assert(point.n_elem == Dimensionality);
+
+  double sum = 0;
+  for (size_t d = 0; d < Dimensionality; d++)
+  {
+    const double v = std::max(fabs(point[d] - bounds[d].Lo()),
+        fabs(bounds[d].Hi() - point[d]));
+    sum += math::IntPow<Power>(v);
+  }
+
+  if (TakeRoot)
+    return math::IntRoot<Power>(sum);
+  else
+    return sum;
+}
+
+/**
+ * Computes maximum distance.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+inline double FixedHRectBound<Dimensionality, Power, TakeRoot>::MaxDistance(
+    const FixedHRectBound& other) const
+{
+  double sum = 0;
+  for (size_t d = 0; d < Dimensionality; d++)
+  {
+    const double v = std::max(fabs(other.bounds[d].Hi() - bounds[d].Lo()),
+        fabs(bounds[d].Hi() - other.bounds[d].Lo()));
+    sum += math::IntPow<Power>(v); // v is non-negative.
+  }
+
+  if (TakeRoot)
+    return math::IntRoot<Power>(sum);
+  else
+    return sum;
+}
+
+/**
+ * Calculates minimum and maximum bound-to-bound distance.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+inline math::Range
+FixedHRectBound<Dimensionality, Power, TakeRoot>::RangeDistance(
+    const FixedHRectBound& other) const
+{
+  double loSum = 0;
+  double hiSum = 0;
+  for (size_t d = 0; d < Dimensionality; d++)
+  {
+    const double v1 = other.bounds[d].Lo() - bounds[d].Hi();
+    const double v2 = bounds[d].Lo() - other.bounds[d].Hi();
+    const double vLo = std::max(std::max(v1, v2), 0.0);
+    const double vHi = -std::min(v1, v2);
+
+    loSum += math::IntPow<Power>(vLo);
+    hiSum += math::IntPow<Power>(vHi);
+  }
+
+  if (TakeRoot)
+    return math::Range(math::IntRoot<Power>(loSum),
+                       math::IntRoot<Power>(hiSum));
+  else
+    return math::Range(loSum, hiSum);
+}
+
+/**
+ * Calculates minimum and maximum bound-to-point distance.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+template<typename VecType>
+inline math::Range
+FixedHRectBound<Dimensionality, Power, TakeRoot>::RangeDistance(
+    const VecType& point,
+    typename boost::enable_if<IsVector<VecType> >* /* junk */) const
+{
+  Log::Assert(point.n_elem == Dimensionality);
+
+  double loSum = 0;
+  double hiSum = 0;
+  for (size_t d = 0; d < Dimensionality; d++)
+  {
+    const double v1 = bounds[d].Lo() - point[d];
+    const double v2 = point[d] - bounds[d].Hi();
+    const double vLo = std::max(std::max(v1, v2), 0.0);
+    const double vHi = -std::min(v1, v2);
+
+    loSum += math::IntPow<Power>(vLo);
+    hiSum += math::IntPow<Power>(vHi);
+  }
+
+  if (TakeRoot)
+    return math::Range(math::IntRoot<Power>(loSum),
+                       math::IntRoot<Power>(hiSum));
+  else
+    return math::Range(loSum, hiSum);
+}
+
+/**
+ * Expands this region to include new points.  The points are visited one at a
+ * time, so no temporary vectors of minima and maxima are needed.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+template<typename MatType>
+inline FixedHRectBound<Dimensionality, Power, TakeRoot>&
+FixedHRectBound<Dimensionality, Power, TakeRoot>::operator|=(
+    const MatType& data)
+{
+  Log::Assert(data.n_rows == Dimensionality);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t d = 0; d < Dimensionality; ++d)
+    {
+      const double value = (double) data(d, i);
+      if (value < bounds[d].Lo())
+        bounds[d].Lo() = value;
+      if (value > bounds[d].Hi())
+        bounds[d].Hi() = value;
+    }
+  }
+
+  minWidth = DBL_MAX;
+  for (size_t d = 0; d < Dimensionality; d++)
+  {
+    const double width = bounds[d].Width();
+    if (width < minWidth)
+      minWidth = width;
+  }
+
+  return *this;
+}
+
+/**
+ * Expands this region to encompass another bound.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+inline FixedHRectBound<Dimensionality, Power, TakeRoot>&
+FixedHRectBound<Dimensionality, Power, TakeRoot>::operator|=(
+    const FixedHRectBound& other)
+{
+  minWidth = DBL_MAX;
+  for (size_t i = 0; i < Dimensionality; i++)
+  {
+    bounds[i] |= other.bounds[i];
+    const double width = bounds[i].Width();
+    if (width < minWidth)
+      minWidth = width;
+  }
+
+  return *this;
+}
+
+/**
+ * Determines if a point is within this bound.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+template<typename VecType>
+inline bool FixedHRectBound<Dimensionality, Power, TakeRoot>::Contains(
+    const VecType& point) const
+{
+  for (size_t i = 0; i < Dimensionality; i++)
+  {
+    if (!bounds[i].Contains(point(i)))
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * Returns the diameter of the hyperrectangle (that is, the longest diagonal).
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+inline double FixedHRectBound<Dimensionality, Power, TakeRoot>::Diameter()
+    const
+{
+  double d = 0;
+  for (size_t i = 0; i < Dimensionality; ++i)
+    d += math::IntPow<Power>(bounds[i].Hi() - bounds[i].Lo());
+
+  if (TakeRoot)
+    return math::IntRoot<Power>(d);
+  else
+    return d;
+}
+
+/**
+ * Returns a string representation of this object.
+ */
+template<size_t Dimensionality, int Power, bool TakeRoot>
+std::string FixedHRectBound<Dimensionality, Power, TakeRoot>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "FixedHRectBound [" << this << "]" << std::endl;
+  convert << "  Power: " << Power << std::endl;
+  convert << "  TakeRoot: " << (TakeRoot ? "true" : "false") << std::endl;
+  convert << "  Dimensionality: " << Dimensionality << std::endl;
+  convert << "  Bounds: " << std::endl;
+  for (size_t i = 0; i < Dimensionality; ++i)
+    convert << util::Indent(bounds[i].ToString()) << std::endl;
+  convert << "  Minimum width: " << minWidth << std::endl;
+
+  return convert.str();
+}
+
+}; // namespace bound
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_TREE_FIXED_HRECTBOUND_IMPL_HPP
@@ -0,0 +1,76 @@
+/**
+ * @file hilbert_curve.hpp
+ *
+ * Keys of points on the Hilbert curve, and the order of a set of points along
+ * it.  These are used to split the nodes of the Hilbert R tree, and to visit
+ * the queries of single-tree searches in an order where consecutive queries
+ * are close to each other.
+ */
+#ifndef __MLPACK_CORE_TREE_HILBERT_CURVE_HPP
+#define __MLPACK_CORE_TREE_HILBERT_CURVE_HPP
+
+#include <mlpack/core.hpp>
+
+#include "hrectbound.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Compute the key of the given point on the Hilbert curve through the given
+ * bound, with the given number of bits for each dimension (Skilling's
+ * algorithm).  Each coordinate is scaled to an integer in [0, 2^order) within
+ * the bound, and the bits of the Hilbert index are packed, most significant
+ * first, into 64 bit words, so keys compare lexicographically (as std::vectors
+ * do) in the order of the curve.
+ *
+ * @param point Point to compute the key of.
+ * @param bound Bound the curve runs through.
+ * @param order Number of bits for each dimension (between 1 and 63).
+ * @param key Vector to store the key in.
+ */
+template<typename VecType>
+void HilbertKey(const VecType& point,
+                const bound::HRectBound<>& bound,
+                const size_t order,
+                std::vector<uint64_t>& key);
+
+/**
+ * Orders entries by their precomputed Hilbert keys.
+ */
+class HilbertKeyComparator
+{
+ public:
+  HilbertKeyComparator(const std::vector<std::vector<uint64_t> >& keys) :
+      keys(keys) { }
+
+  bool operator()(const size_t a, const size_t b) const
+  {
+    return keys[a] < keys[b];
+  }
+
+ private:
+  const std::vector<std::vector<uint64_t> >& keys;
+};
+
+/**
+ * Compute the order of the columns of the given matrix along the Hilbert curve
+ * through their bounding box, with 16 bits for each dimension.  Points that
+ * are close in the order are close in space, so visiting them in this order
+ * (for instance, the queries of a single-tree search) touches the same parts
+ * of a tree one after another.
+ *
+ * @param points Points to order.
+ * @param order Vector to store the order in: order[i] is the index of the ith
+ *     point along the curve.
+ */
+template<typename MatType>
+void HilbertOrder(const MatType& points, std::vector<size_t>& order);
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "hilbert_curve_impl.hpp"
+
+#endif
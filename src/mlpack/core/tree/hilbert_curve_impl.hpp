@@ -0,0 +1,114 @@
+/**
+ * @file hilbert_curve_impl.hpp
+ *
+ * Implementation of the Hilbert curve keys and orders.
+ */
+#ifndef __MLPACK_CORE_TREE_HILBERT_CURVE_IMPL_HPP
+#define __MLPACK_CORE_TREE_HILBERT_CURVE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "hilbert_curve.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename VecType>
+void HilbertKey(const VecType& point,
+                const bound::HRectBound<>& bound,
+                const size_t order,
+                std::vector<uint64_t>& key)
+{
+  const size_t dim = bound.Dim();
+  key.assign((dim * order + 63) / 64, 0);
+  if (dim == 0)
+    return;
+
+  // Scale each coordinate to an integer within the bound.
+  const uint64_t maxCoordinate = (((uint64_t) 1) << order) - 1;
+  std::vector<uint64_t> x(dim, 0);
+  for (size_t i = 0; i < dim; i++)
+  {
+    const double width = bound[i].Width();
+    if (width <= 0)
+      continue;
+
+    const double scaled = (point[i] - bound[i].Lo()) / width * maxCoordinate;
+    if (scaled >= (double) maxCoordinate)
+      x[i] = maxCoordinate;
+    else if (scaled > 0)
+      x[i] = (uint64_t) scaled;
+  }
+
+  // Transform the coordinates in place into the transposed Hilbert index (see
+  // Skilling, "Programming the Hilbert curve", 2004).  First, undo the excess
+  // work of the inverse transform.
+  const uint64_t highBit = ((uint64_t) 1) << (order - 1);
+  for (uint64_t q = highBit; q > 1; q >>= 1)
+  {
+    const uint64_t p = q - 1;
+    for (size_t i = 0; i < dim; i++)
+    {
+      if (x[i] & q)
+      {
+        x[0] ^= p; // Invert the low bits of the first coordinate.
+      }
+      else
+      {
+        // Exchange the low bits of the first and ith coordinates.
+        const uint64_t t = (x[0] ^ x[i]) & p;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+
+  // Then, Gray encode.
+  for (size_t i = 1; i < dim; i++)
+    x[i] ^= x[i - 1];
+
+  uint64_t t = 0;
+  for (uint64_t q = highBit; q > 1; q >>= 1)
+    if (x[dim - 1] & q)
+      t ^= q - 1;
+
+  for (size_t i = 0; i < dim; i++)
+    x[i] ^= t;
+
+  // The Hilbert index interleaves the bits of the transposed index, from the
+  // most significant bit of each coordinate down.
+  size_t bit = 0;
+  for (size_t b = order; b > 0; b--)
+  {
+    for (size_t i = 0; i < dim; i++, bit++)
+    {
+      if ((x[i] >> (b - 1)) & 1)
+        key[bit / 64] |= ((uint64_t) 1) << (63 - (bit % 64));
+    }
+  }
+}
+
+template<typename MatType>
+void HilbertOrder(const MatType& points, std::vector<size_t>& order)
+{
+  bound::HRectBound<> bound(points.n_rows);
+  bound |= points;
+
+  // The keys are independent, so they can be computed in parallel.
+  std::vector<std::vector<uint64_t> > keys(points.n_cols);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < points.n_cols; i++)
+    HilbertKey(points.col(i), bound, 16, keys[i]);
+
+  order.resize(points.n_cols);
+  for (size_t i = 0; i < points.n_cols; i++)
+    order[i] = i;
+
+  std::sort(order.begin(), order.end(), HilbertKeyComparator(keys));
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
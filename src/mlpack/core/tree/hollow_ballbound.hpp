@@ -0,0 +1,209 @@
+/**
+ * @file hollow_ballbound.hpp
+ *
+ * Bounds that are useful for binary space partitioning trees.
+ * Interface to a hollow ball bound (a ball with a ball-shaped hole) that works
+ * in arbitrary metric spaces.
+ */
+#ifndef __MLPACK_CORE_TREE_HOLLOW_BALLBOUND_HPP
+#define __MLPACK_CORE_TREE_HOLLOW_BALLBOUND_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace bound {
+
+/**
+ * A hollow ball bound encloses a set of points that are at most a specific
+ * distance (radius) from a specific point (center), and at least another
+ * distance (inner radius) from another point (hollow center).  This is the
+ * shape of the nodes of a vantage point tree: the points of a node that are
+ * further than the median distance from the vantage point go to a child whose
+ * hole is the ball around the vantage point.  If the inner radius is 0, there
+ * is no hole, and the bound is a ball, as with BallBound.
+ *
+ * Unlike BallBound, the center is never moved: it is the first point added to
+ * the bound, and the bound only ever evaluates the metric between points.  So
+ * the bound works with any metric, without needing the points to form a vector
+ * space (the mean of two points does not have to mean anything).  The metric is
+ * default-constructed, as with BallBound.
+ *
+ * @tparam VecType Type of vector (arma::vec or arma::sp_vec).
+ * @tparam TMetricType metric type used in the distance measure.
+ */
+template<typename VecType = arma::vec,
+         typename TMetricType = metric::LMetric<2, true> >
+class HollowBallBound
+{
+ public:
+  typedef VecType Vec;
+  //! Need this for Binary Space Partion Tree
+  typedef TMetricType MetricType;
+
+ private:
+  //! The radius of the ball bound.
+  double radius;
+
+  //! The center of the ball bound.
+  VecType center;
+
+  //! The radius of the hole; 0 if there is no hole.
+  double innerRadius;
+
+  //! The center of the hole.
+  VecType hollowCenter;
+
+  //! The metric used in this bound.  Some metrics (such as
+  //! MahalanobisDistance) have a non-const Evaluate().
+  mutable TMetricType metric;
+
+ public:
+  //! Empty Constructor.
+  HollowBallBound();
+
+  /**
+   * Create the hollow ball bound with the specified dimensionality.  The bound
+   * contains nothing and has no hole.
+   *
+   * @param dimension Dimensionality of hollow ball bound.
+   */
+  HollowBallBound(const size_t dimension);
+
+  /**
+   * Create the hollow ball bound with the specified radii and centers.
+   *
+   * @param innerRadius Radius of the hole.
+   * @param outerRadius Radius of the ball.
+   * @param center Center of the ball.
+   * @param hollowCenter Center of the hole.
+   */
+  HollowBallBound(const double innerRadius,
+                  const double outerRadius,
+                  const VecType& center,
+                  const VecType& hollowCenter);
+
+  //! Get the radius of the ball.
+  double OuterRadius() const { return radius; }
+  //! Modify the radius of the ball.
+  double& OuterRadius() { return radius; }
+
+  //! Get the radius of the hole.
+  double InnerRadius() const { return innerRadius; }
+  //! Modify the radius of the hole.
+  double& InnerRadius() { return innerRadius; }
+
+  //! Get the center point of the ball.
+  const VecType& Center() const { return center; }
+  //! Modify the center point of the ball.
+  VecType& Center() { return center; }
+
+  //! Get the center point of the hole.
+  const VecType& HollowCenter() const { return hollowCenter; }
+  //! Modify the center point of the hole.
+  VecType& HollowCenter() { return hollowCenter; }
+
+  //! Get the dimensionality of the ball.
+  double Dim() const { return center.n_elem; }
+
+  //! Reset the bound so that it contains nothing and has no hole; the next
+  //! points added with operator|=() will set the center.
+  void Clear() { radius = -DBL_MAX; innerRadius = 0; }
+
+  /**
+   * Get the minimum width of the bound (this is same as the diameter).
+   * For ball bounds, width along all dimensions remain same.
+   */
+  double MinWidth() const { return radius * 2.0; }
+
+  //! Get the range in a certain dimension.
+  math::Range operator[](const size_t i) const;
+
+  /**
+   * Determines if a point is within this bound.
+   */
+  template<typename OtherVecType>
+  bool Contains(const OtherVecType& point) const;
+
+  /**
+   * Place the centroid of HollowBallBound into the given vector.  This is the
+   * center of the ball, which is one of the points of the bound.
+   *
+   * @param centroid Vector which the centroid will be written to.
+   */
+  void Centroid(VecType& centroid) const { centroid = center; }
+
+  /**
+   * Calculates minimum bound-to-point distance.
+   */
+  template<typename OtherVecType>
+  double MinDistance(const OtherVecType& point,
+                     typename boost::enable_if<IsVector<OtherVecType> >* = 0)
+      const;
+
+  /**
+   * Calculates minimum bound-to-bound distance.
+   */
+  double MinDistance(const HollowBallBound& other) const;
+
+  /**
+   * Computes maximum distance.
+   */
+  template<typename OtherVecType>
+  double MaxDistance(const OtherVecType& point,
+                     typename boost::enable_if<IsVector<OtherVecType> >* = 0)
+      const;
+
+  /**
+   * Computes maximum distance.
+   */
+  double MaxDistance(const HollowBallBound& other) const;
+
+  /**
+   * Calculates minimum and maximum bound-to-point distance.
+   */
+  template<typename OtherVecType>
+  math::Range RangeDistance(
+      const OtherVecType& other,
+      typename boost::enable_if<IsVector<OtherVecType> >* = 0) const;
+
+  /**
+   * Calculates minimum and maximum bound-to-bound distance.
+   */
+  math::Range RangeDistance(const HollowBallBound& other) const;
+
+  /**
+   * Expand the bound to include the given points.  If the bound contains
+   * nothing, the first point becomes the center.  The radius grows to reach
+   * every point, and if there is a hole, its radius shrinks so that no point is
+   * inside it.
+   *
+   * @tparam MatType Type of matrix; could be arma::mat, arma::spmat, or a
+   *     vector.
+   * @tparam data Data points to add.
+   */
+  template<typename MatType>
+  const HollowBallBound& operator|=(const MatType& data);
+
+  /**
+   * Returns the diameter of the ball.
+   */
+  double Diameter() const { return 2 * radius; }
+
+  /**
+   * Returns the distance metric used in this bound.
+   */
+  TMetricType Metric() const { return metric; }
+
+  /**
+   * Returns a string representation of this object.
+   */
+  std::string ToString() const;
+};
+
+}; // namespace bound
+}; // namespace mlpack
+
+#include "hollow_ballbound_impl.hpp"
+
+#endif // __MLPACK_CORE_TREE_HOLLOW_BALLBOUND_HPP
@@ -0,0 +1,266 @@
+/**
+ * @file hollow_ballbound_impl.hpp
+ *
+ * Bounds that are useful for binary space partitioning trees.
+ * Implementation of HollowBallBound ball bound metric policy class.
+ */
+#ifndef __MLPACK_CORE_TREE_HOLLOW_BALLBOUND_IMPL_HPP
+#define __MLPACK_CORE_TREE_HOLLOW_BALLBOUND_IMPL_HPP
+
+// In case it hasn't been included already.
+#include "hollow_ballbound.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace mlpack {
+namespace bound {
+
+//! Empty Constructor.
+template<typename VecType, typename TMetricType>
+HollowBallBound<VecType, TMetricType>::HollowBallBound() :
+    radius(-DBL_MAX),
+    innerRadius(0)
+{ /* Nothing to do. */ }
+
+/**
+ * Create the hollow ball bound with the specified dimensionality.
+ *
+ * @param dimension Dimensionality of hollow ball bound.
+ */
+template<typename VecType, typename TMetricType>
+HollowBallBound<VecType, TMetricType>::HollowBallBound(const size_t dimension) :
+    radius(-DBL_MAX),
+    center(dimension),
+    innerRadius(0),
+    hollowCenter(dimension)
+{ /* Nothing to do. */ }
+
+/**
+ * Create the hollow ball bound with the specified radii and centers.
+ */
+template<typename VecType, typename TMetricType>
+HollowBallBound<VecType, TMetricType>::HollowBallBound(
+    const double innerRadius,
+    const double outerRadius,
+    const VecType& center,
+    const VecType& hollowCenter) :
+    radius(outerRadius),
+    center(center),
+    innerRadius(innerRadius),
+    hollowCenter(hollowCenter)
+{ /* Nothing to do. */ }
+
+//! Get the range in a certain dimension.
+template<typename VecType, typename TMetricType>
+math::Range HollowBallBound<VecType, TMetricType>::operator[](
+    const size_t i) const
+{
+  if (radius < 0)
+    return math::Range();
+  else
+    return math::Range(center[i] - radius, center[i] + radius);
+}
+
+/**
+ * Determines if a point is within the bound.
+ */
+template<typename VecType, typename TMetricType>
+template<typename OtherVecType>
+bool HollowBallBound<VecType, TMetricType>::Contains(
+    const OtherVecType& point) const
+{
+  if (radius < 0)
+    return false;
+  else if (metric.Evaluate(center, point) > radius)
+    return false;
+  else if (innerRadius > 0)
+    return metric.Evaluate(hollowCenter, point) >= innerRadius;
+  else
+    return true;
+}
+
+/**
+ * Calculates minimum bound-to-point distance.  A point of the bound is at
+ * least (innerRadius - d(point, hollowCenter)) from the point, by the triangle
+ * inequality, so the hole can give a better bound than the ball.
+ */
+template<typename VecType, typename TMetricType>
+template<typename OtherVecType>
+double HollowBallBound<VecType, TMetricType>::MinDistance(
+    const OtherVecType& point,
+    typename boost::enable_if<IsVector<OtherVecType> >* /* junk */) const
+{
+  if (radius < 0)
+    return DBL_MAX;
+
+  double distance = metric.Evaluate(point, center) - radius;
+  if (innerRadius > 0)
+  {
+    const double holeDistance = innerRadius -
+        metric.Evaluate(point, hollowCenter);
+    distance = std::max(distance, holeDistance);
+  }
+
+  return math::ClampNonNegative(distance);
+}
+
+/**
+ * Calculates minimum bound-to-bound distance.  Each point of the other bound is
+ * within other.radius of other.center, so it is at most
+ * d(other.center, hollowCenter) + other.radius from the center of this hole,
+ * and at least (innerRadius - that) from every point of this bound; the same
+ * holds with the bounds swapped.
+ */
+template<typename VecType, typename TMetricType>
+double HollowBallBound<VecType, TMetricType>::MinDistance(
+    const HollowBallBound& other) const
+{
+  if (radius < 0 || other.radius < 0)
+    return DBL_MAX;
+
+  double distance = metric.Evaluate(center, other.center) - radius -
+      other.radius;
+  if (innerRadius > 0)
+  {
+    const double holeDistance = innerRadius -
+        metric.Evaluate(hollowCenter, other.center) - other.radius;
+    distance = std::max(distance, holeDistance);
+  }
+  if (other.innerRadius > 0)
+  {
+    const double holeDistance = other.innerRadius -
+        metric.Evaluate(other.hollowCenter, center) - radius;
+    distance = std::max(distance, holeDistance);
+  }
+
+  return math::ClampNonNegative(distance);
+}
+
+/**
+ * Computes maximum distance.
+ */
+template<typename VecType, typename TMetricType>
+template<typename OtherVecType>
+double HollowBallBound<VecType, TMetricType>::MaxDistance(
+    const OtherVecType& point,
+    typename boost::enable_if<IsVector<OtherVecType> >* /* junk */) const
+{
+  if (radius < 0)
+    return DBL_MAX;
+  else
+    return metric.Evaluate(point, center) + radius;
+}
+
+/**
+ * Computes maximum distance.
+ */
+template<typename VecType, typename TMetricType>
+double HollowBallBound<VecType, TMetricType>::MaxDistance(
+    const HollowBallBound& other) const
+{
+  if (radius < 0 || other.radius < 0)
+    return DBL_MAX;
+  else
+    return metric.Evaluate(other.center, center) + radius + other.radius;
+}
+
+/**
+ * Calculates minimum and maximum bound-to-point distance.
+ */
+template<typename VecType, typename TMetricType>
+template<typename OtherVecType>
+math::Range HollowBallBound<VecType, TMetricType>::RangeDistance(
+    const OtherVecType& point,
+    typename boost::enable_if<IsVector<OtherVecType> >* /* junk */) const
+{
+  if (radius < 0)
+    return math::Range(DBL_MAX, DBL_MAX);
+
+  const double dist = metric.Evaluate(center, point);
+  double lo = dist - radius;
+  if (innerRadius > 0)
+    lo = std::max(lo, innerRadius - metric.Evaluate(hollowCenter, point));
+
+  return math::Range(math::ClampNonNegative(lo), dist + radius);
+}
+
+/**
+ * Calculates minimum and maximum bound-to-bound distance.
+ */
+template<typename VecType, typename TMetricType>
+math::Range HollowBallBound<VecType, TMetricType>::RangeDistance(
+    const HollowBallBound& other) const
+{
+  if (radius < 0 || other.radius < 0)
+    return math::Range(DBL_MAX, DBL_MAX);
+
+  const double dist = metric.Evaluate(center, other.center);
+  const double sumradius = radius + other.radius;
+
+  // The lower bound is the same as in MinDistance().
+  double lo = dist - sumradius;
+  if (innerRadius > 0)
+    lo = std::max(lo, innerRadius -
+        metric.Evaluate(hollowCenter, other.center) - other.radius);
+  if (other.innerRadius > 0)
+    lo = std::max(lo, other.innerRadius -
+        metric.Evaluate(other.hollowCenter, center) - radius);
+
+  return math::Range(math::ClampNonNegative(lo), dist + sumradius);
+}
+
+/**
+ * Expand the bound to include the given points.  The center does not move, so
+ * the radius is just the largest distance from the center.
+ */
+template<typename VecType, typename TMetricType>
+template<typename MatType>
+const HollowBallBound<VecType, TMetricType>&
+HollowBallBound<VecType, TMetricType>::operator|=(const MatType& data)
+{
+  if (radius < 0)
+  {
+    center = data.col(0);
+    radius = 0;
+  }
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    // The point is not converted to VecType, so sparse points stay sparse.
+    const double dist = metric.Evaluate(center, data.col(i));
+    if (dist > radius)
+      radius = dist;
+
+    // Shrink the hole so that the point is not inside it.
+    if (innerRadius > 0)
+    {
+      const double holeDist = metric.Evaluate(hollowCenter, data.col(i));
+      if (holeDist < innerRadius)
+        innerRadius = holeDist;
+    }
+  }
+
+  return *this;
+}
+
+/**
+ * Returns a string representation of this object.
+ */
+template<typename VecType, typename TMetricType>
+std::string HollowBallBound<VecType, TMetricType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "HollowBallBound [" << this << "]" << std::endl;
+  convert << "  Outer radius:  " << radius << std::endl;
+  convert << "  Center:" << std::endl << center;
+  convert << "  Inner radius:  " << innerRadius << std::endl;
+  convert << "  Hollow center:" << std::endl << hollowCenter;
+  convert << "  Metric:" << std::endl << metric.ToString();
+  return convert.str();
+}
+
+}; // namespace bound
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_TREE_HOLLOW_BALLBOUND_IMPL_HPP
@@ -76,7 +76,8 @@ class HRectBound
    *
    * @param centroid Vector which the centroid will be written to.
    */
-  void Centroid(arma::vec& centroid) const;
+  template<typename VecType>
+  void Centroid(VecType& centroid) const;
 
   /**
    * Calculate the volume of the hyperrectangle.
@@ -146,6 +147,20 @@ class HRectBound
   template<typename MatType>
   HRectBound& operator|=(const MatType& data);
 
+  /**
+   * Expands this region to include new sparse points.  Only the nonzero
+   * elements are visited; a dimension in which some point is zero is expanded
+   * to include zero.
+   *
+   * @param data Sparse data points to expand this region to include.
+   */
+  template<typename eT>
+  HRectBound& operator|=(const arma::SpMat<eT>& data);
+
+  //! Expands this region to include new sparse points (see above).
+  template<typename eT>
+  HRectBound& operator|=(const arma::SpSubview<eT>& data);
+
   /**
    * Expands this region to encompass another bound.
    */
@@ -181,6 +196,10 @@ class HRectBound
   math::Range* bounds;
   //! Cached minimum width of bound.
   double minWidth;
+
+  //! Expand the bound to include the given sparse points.
+  template<typename MatType>
+  HRectBound& SparseExpand(const MatType& data);
 };
 
 }; // namespace bound
@@ -105,7 +105,8 @@ inline void HRectBound<Power, TakeRoot>::Clear()
  * @param centroid Vector which the centroid will be written to.
  */
 template<int Power, bool TakeRoot>
-inline void HRectBound<Power, TakeRoot>::Centroid(arma::vec& centroid) const
+template<typename VecType>
+inline void HRectBound<Power, TakeRoot>::Centroid(VecType& centroid) const
 {
   // Set size correctly if necessary.
   if (!(centroid.n_elem == dim))
@@ -152,7 +153,7 @@ inline double HRectBound<Power, TakeRoot>::MinDistance(
     // Since only one of 'lower' or 'higher' is negative, if we add each's
     // absolute value to itself and then sum those two, our result is the
     // nonnegative half of the equation times two; then we raise to power Power.
-    sum += pow((lower + fabs(lower)) + (higher + fabs(higher)), (double) Power);
+    sum += math::IntPow<Power>((lower + fabs(lower)) + (higher + fabs(higher)));
   }
 
   // Now take the Power'th root (but make sure our result is squared if it needs
@@ -160,9 +161,9 @@ inline double HRectBound<Power, TakeRoot>::MinDistance(
   // that was introduced earlier.  The compiler should optimize out the if
   // statement entirely.
   if (TakeRoot)
-    return pow(sum, 1.0 / (double) Power) / 2.0;
+    return math::IntRoot<Power>(sum) / 2.0;
   else
-    return sum / pow(2.0, Power);
+    return sum / math::IntPow<Power>(2.0);
 }
 
 /**
@@ -185,7 +186,7 @@ double HRectBound<Power, TakeRoot>::MinDistance(const HRectBound& other) const
     // We invoke the following:
     //   x + fabs(x) = max(x * 2, 0)
     //   (x * 2)^2 / 4 = x^2
-    sum += pow((lower + fabs(lower)) + (higher + fabs(higher)), (double) Power);
+    sum += math::IntPow<Power>((lower + fabs(lower)) + (higher + fabs(higher)));
 
     // Move bound pointers.
     mbound++;
@@ -194,9 +195,9 @@ double HRectBound<Power, TakeRoot>::MinDistance(const HRectBound& other) const
 
   // The compiler should optimize out this if statement entirely.
   if (TakeRoot)
-    return pow(sum, 1.0 / (double) Power) / 2.0;
+    return math::IntRoot<Power>(sum) / 2.0;
   else
-    return sum / pow(2.0, Power);
+    return sum / math::IntPow<Power>(2.0);
 }
 
 /**
@@ -216,12 +217,12 @@ inline double HRectBound<Power, TakeRoot>::MaxDistance(
   {
     double v = std::max(fabs(point[d] - bounds[d].Lo()),
         fabs(bounds[d].Hi() - point[d]));
-    sum += pow(v, (double) Power);
+    sum += math::IntPow<Power>(v);
   }
 
   // The compiler should optimize out this if statement entirely.
   if (TakeRoot)
-    return pow(sum, 1.0 / (double) Power);
+    return math::IntRoot<Power>(sum);
   else
     return sum;
 }
@@ -242,12 +243,12 @@ inline double HRectBound<Power, TakeRoot>::MaxDistance(const HRectBound& other)
   {
     v = std::max(fabs(other.bounds[d].Hi() - bounds[d].Lo()),
         fabs(bounds[d].Hi() - other.bounds[d].Lo()));
-    sum += pow(v, (double) Power); // v is non-negative.
+    sum += math::IntPow<Power>(v); // v is non-negative.
   }
 
   // The compiler should optimize out this if statement entirely.
   if (TakeRoot)
-    return pow(sum, 1.0 / (double) Power);
+    return math::IntRoot<Power>(sum);
   else
     return sum;
 }
@@ -264,30 +265,23 @@ inline math::Range HRectBound<Power, TakeRoot>::RangeDistance(
 
   Log::Assert(dim == other.dim);
 
-  double v1, v2, vLo, vHi;
   for (size_t d = 0; d < dim; d++)
   {
-    v1 = other.bounds[d].Lo() - bounds[d].Hi();
-    v2 = bounds[d].Lo() - other.bounds[d].Hi();
-    // One of v1 or v2 is negative.
-    if (v1 >= v2)
-    {
-      vHi = -v2; // Make it nonnegative.
-      vLo = (v1 > 0) ? v1 : 0; // Force to be 0 if negative.
-    }
-    else
-    {
-      vHi = -v1; // Make it nonnegative.
-      vLo = (v2 > 0) ? v2 : 0; // Force to be 0 if negative.
-    }
-
-    loSum += pow(vLo, (double) Power);
-    hiSum += pow(vHi, (double) Power);
+    const double v1 = other.bounds[d].Lo() - bounds[d].Hi();
+    const double v2 = bounds[d].Lo() - other.bounds[d].Hi();
+    // One of v1 or v2 is negative.  The larger one (forced to be nonnegative)
+    // is the minimum distance, and the negated smaller one is the maximum.
+    // There are no branches, so the compiler can vectorize this loop.
+    const double vLo = std::max(std::max(v1, v2), 0.0);
+    const double vHi = -std::min(v1, v2);
+
+    loSum += math::IntPow<Power>(vLo);
+    hiSum += math::IntPow<Power>(vHi);
   }
 
   if (TakeRoot)
-    return math::Range(pow(loSum, 1.0 / (double) Power),
-                       pow(hiSum, 1.0 / (double) Power));
+    return math::Range(math::IntRoot<Power>(loSum),
+                       math::IntRoot<Power>(hiSum));
   else
     return math::Range(loSum, hiSum);
 }
@@ -306,38 +300,23 @@ inline math::Range HRectBound<Power, TakeRoot>::RangeDistance(
 
   Log::Assert(point.n_elem == dim);
 
-  double v1, v2, vLo, vHi;
   for (size_t d = 0; d < dim; d++)
   {
-    v1 = bounds[d].Lo() - point[d]; // Negative if point[d] > lo.
-    v2 = point[d] - bounds[d].Hi(); // Negative if point[d] < hi.
-    // One of v1 or v2 (or both) is negative.
-    if (v1 >= 0) // point[d] <= bounds_[d].Lo().
-    {
-      vHi = -v2; // v2 will be larger but must be negated.
-      vLo = v1;
-    }
-    else // point[d] is between lo and hi, or greater than hi.
-    {
-      if (v2 >= 0)
-      {
-        vHi = -v1; // v1 will be larger, but must be negated.
-        vLo = v2;
-      }
-      else
-      {
-        vHi = -std::min(v1, v2); // Both are negative, but we need the larger.
-        vLo = 0;
-      }
-    }
-
-    loSum += pow(vLo, (double) Power);
-    hiSum += pow(vHi, (double) Power);
+    const double v1 = bounds[d].Lo() - point[d]; // Negative if point[d] > lo.
+    const double v2 = point[d] - bounds[d].Hi(); // Negative if point[d] < hi.
+    // One of v1 or v2 (or both) is negative.  The larger one (or 0, if the
+    // point is inside the bound) is the minimum distance, and the negated
+    // smaller one is the maximum distance.
+    const double vLo = std::max(std::max(v1, v2), 0.0);
+    const double vHi = -std::min(v1, v2);
+
+    loSum += math::IntPow<Power>(vLo);
+    hiSum += math::IntPow<Power>(vHi);
   }
 
   if (TakeRoot)
-    return math::Range(pow(loSum, 1.0 / (double) Power),
-                       pow(hiSum, 1.0 / (double) Power));
+    return math::Range(math::IntRoot<Power>(loSum),
+                       math::IntRoot<Power>(hiSum));
   else
     return math::Range(loSum, hiSum);
 }
@@ -352,8 +331,10 @@ inline HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator|=(
 {
   Log::Assert(data.n_rows == dim);
 
-  arma::vec mins(min(data, 1));
-  arma::vec maxs(max(data, 1));
+  // The data may be single-precision; the bound itself is always stored in
+  // double precision.
+  arma::Col<typename MatType::elem_type> mins(min(data, 1));
+  arma::Col<typename MatType::elem_type> maxs(max(data, 1));
 
   minWidth = DBL_MAX;
   for (size_t i = 0; i < dim; i++)
@@ -367,6 +348,72 @@ inline HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator|=(
   return *this;
 }
 
+/**
+ * Expands this region to include new sparse points.
+ */
+template<int Power, bool TakeRoot>
+template<typename eT>
+inline HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator|=(
+    const arma::SpMat<eT>& data)
+{
+  return SparseExpand(data);
+}
+
+template<int Power, bool TakeRoot>
+template<typename eT>
+inline HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::operator|=(
+    const arma::SpSubview<eT>& data)
+{
+  return SparseExpand(data);
+}
+
+template<int Power, bool TakeRoot>
+template<typename MatType>
+inline HRectBound<Power, TakeRoot>& HRectBound<Power, TakeRoot>::SparseExpand(
+    const MatType& data)
+{
+  Log::Assert(data.n_rows == dim);
+
+  if (data.n_cols == 0)
+    return *this;
+
+  // Find the range of the nonzero elements in each dimension, and count them;
+  // if a dimension has fewer nonzero elements than there are points, zero is
+  // in its range too.
+  arma::vec mins(dim);
+  arma::vec maxs(dim);
+  mins.fill(DBL_MAX);
+  maxs.fill(-DBL_MAX);
+  arma::Col<size_t> nonzeros(dim);
+  nonzeros.zeros();
+
+  for (typename MatType::const_iterator it = data.begin(); it != data.end();
+      ++it)
+  {
+    const size_t d = it.row();
+    const double value = (double) *it;
+    mins[d] = std::min(mins[d], value);
+    maxs[d] = std::max(maxs[d], value);
+    ++nonzeros[d];
+  }
+
+  minWidth = DBL_MAX;
+  for (size_t i = 0; i < dim; i++)
+  {
+    if (nonzeros[i] < data.n_cols)
+      bounds[i] |= math::Range(std::min(mins[i], 0.0),
+          std::max(maxs[i], 0.0));
+    else
+      bounds[i] |= math::Range(mins[i], maxs[i]);
+
+    const double width = bounds[i].Width();
+    if (width < minWidth)
+      minWidth = width;
+  }
+
+  return *this;
+}
+
 /**
  * Expands this region to encompass another bound.
  */
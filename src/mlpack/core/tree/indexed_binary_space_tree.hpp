@@ -0,0 +1,17 @@
+/**
+ * @file indexed_binary_space_tree.hpp
+ *
+ * Include all the necessary files to use the IndexedBinarySpaceTree class.
+ */
+#ifndef __MLPACK_CORE_TREE_INDEXED_BINARY_SPACE_TREE_HPP
+#define __MLPACK_CORE_TREE_INDEXED_BINARY_SPACE_TREE_HPP
+
+#include "bounds.hpp"
+#include "indexed_tree/indexed_binary_space_tree.hpp"
+#include "indexed_tree/single_tree_traverser.hpp"
+#include "indexed_tree/single_tree_traverser_impl.hpp"
+#include "indexed_tree/dual_tree_traverser.hpp"
+#include "indexed_tree/dual_tree_traverser_impl.hpp"
+#include "indexed_tree/traits.hpp"
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file dual_tree_traverser.hpp
+ *
+ * Defines the DualTreeTraverser for the IndexedBinarySpaceTree tree type.  This
+ * is a nested class of IndexedBinarySpaceTree which traverses two trees in a
+ * depth-first manner with a given set of rules which indicate the branches
+ * which can be pruned and the order in which to recurse.
+ */
+#ifndef __MLPACK_CORE_TREE_INDEXED_TREE_DUAL_TREE_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_INDEXED_TREE_DUAL_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+
+#include "indexed_binary_space_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+class IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+    DualTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the dual-tree traverser with the given rule set.
+   */
+  DualTreeTraverser(RuleType& rule);
+
+  /**
+   * Traverse the two trees.  This does not reset the number of prunes.
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   * @param score The score of the current node combination.
+   */
+  void Traverse(IndexedBinarySpaceTree& queryNode,
+                IndexedBinarySpaceTree& referenceNode);
+
+  /**
+   * Traverse the two trees, splitting the work into OpenMP tasks.  Above the
+   * given split depth, the recursion into each query child is run as a
+   * separate task; at and below the split depth, each task runs the regular
+   * serial traversal.  Every task gets its own copy of the rules and its own
+   * traverser, and when the tasks are finished, the traversal statistics of
+   * each copy of the rules (and the statistics of each traverser) are added
+   * back into this object's rules and statistics.
+   *
+   * This must be called from inside an OpenMP parallel region (usually from an
+   * 'omp single' block) to actually run in parallel; otherwise the tasks run
+   * one after another.  The rules must be copy-constructible, must not share
+   * state between query nodes (other than the results for each query point),
+   * and must provide a modifiable Statistics() accessor (see
+   * TraversalStatistics).
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   * @param splitDepth Number of query tree levels to split into tasks.
+   */
+  void TraverseParallel(IndexedBinarySpaceTree& queryNode,
+                        IndexedBinarySpaceTree& referenceNode,
+                        const size_t splitDepth);
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! Get the number of visited combinations.
+  size_t NumVisited() const { return numVisited; }
+  //! Modify the number of visited combinations.
+  size_t& NumVisited() { return numVisited; }
+
+  //! Get the number of times a node combination was scored.
+  size_t NumScores() const { return numScores; }
+  //! Modify the number of times a node combination was scored.
+  size_t& NumScores() { return numScores; }
+
+  //! Get the number of times a base case was calculated.
+  size_t NumBaseCases() const { return numBaseCases; }
+  //! Modify the number of times a base case was calculated.
+  size_t& NumBaseCases() { return numBaseCases; }
+
+ private:
+  //! Reference to the rules with which the trees will be traversed.
+  RuleType& rule;
+
+  //! The number of prunes.
+  size_t numPrunes;
+
+  //! The number of node combinations that have been visited during traversal.
+  size_t numVisited;
+
+  //! The number of times a node combination was scored.
+  size_t numScores;
+
+  //! The number of times a base case was calculated.
+  size_t numBaseCases;
+
+  //! Traversal information, held in the class so that it isn't continually
+  //! being reallocated.
+  typename RuleType::TraversalInfoType traversalInfo;
+
+  //! Offsets of the query points of a leaf that were not pruned, held in the
+  //! class so that it isn't continually being reallocated.
+  std::vector<size_t> queryPoints;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "dual_tree_traverser_impl.hpp"
+
+#endif // __MLPACK_CORE_TREE_INDEXED_TREE_DUAL_TREE_TRAVERSER_HPP
+
@@ -0,0 +1,412 @@
+/**
+ * @file dual_tree_traverser_impl.hpp
+ *
+ * Implementation of the DualTreeTraverser for IndexedBinarySpaceTree.  This is
+ * the same traversal as the one of BinarySpaceTree, except that the points of a
+ * leaf are found through Point() instead of being a range of the dataset.  The
+ * trees must be the same type.
+ */
+#ifndef __MLPACK_CORE_TREE_INDEXED_TREE_DUAL_TREE_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_INDEXED_TREE_DUAL_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dual_tree_traverser.hpp"
+
+// For LeafBaseCases().
+#include "../binary_space_tree/dual_tree_traverser.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+DualTreeTraverser<RuleType>::DualTreeTraverser(RuleType& rule) :
+    rule(rule),
+    numPrunes(0),
+    numVisited(0),
+    numScores(0),
+    numBaseCases(0)
+{ /* Nothing to do. */ }
+
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+void IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+DualTreeTraverser<RuleType>::Traverse(
+    IndexedBinarySpaceTree<BoundType, StatisticType, MatType>& queryNode,
+    IndexedBinarySpaceTree<BoundType, StatisticType, MatType>&
+        referenceNode)
+{
+  // Increment the visit counter.
+  ++numVisited;
+
+  // Store the current traversal info.
+  traversalInfo = rule.TraversalInfo();
+
+  // If both are leaves, we must evaluate the base case.
+  if (queryNode.IsLeaf() && referenceNode.IsLeaf())
+  {
+    // Find the points of the query node that we need to investigate (this
+    // function should be implemented for the single-tree recursion too).
+    // Restore the traversal information before each score.
+    queryPoints.clear();
+    for (size_t i = 0; i < queryNode.NumPoints(); ++i)
+    {
+      rule.TraversalInfo() = traversalInfo;
+      const double childScore = rule.Score(queryNode.Point(i), referenceNode);
+
+      if (childScore != DBL_MAX)
+        queryPoints.push_back(i);
+    }
+
+    // We can't improve any of the points.
+    if (queryPoints.empty())
+      return;
+
+    // If the rules can do all of the remaining base cases at once (usually with
+    // a matrix multiplication), let them; otherwise loop through each of the
+    // remaining points.
+    if (!LeafBaseCases(rule, queryNode, queryPoints, referenceNode))
+    {
+      for (size_t i = 0; i < queryPoints.size(); ++i)
+      {
+        const size_t query = queryNode.Point(queryPoints[i]);
+        for (size_t j = 0; j < referenceNode.NumPoints(); ++j)
+          rule.BaseCase(query, referenceNode.Point(j));
+      }
+    }
+
+    numBaseCases += queryPoints.size() * referenceNode.NumPoints();
+  }
+  else if ((!queryNode.IsLeaf()) && referenceNode.IsLeaf())
+  {
+    // We have to recurse down the query node.  In this case the recursion order
+    // does not matter.
+    const double leftScore = rule.Score(*queryNode.Left(), referenceNode);
+    ++numScores;
+
+    if (leftScore != DBL_MAX)
+      Traverse(*queryNode.Left(), referenceNode);
+    else
+      ++numPrunes;
+
+    // Before recursing, we have to set the traversal information correctly.
+    rule.TraversalInfo() = traversalInfo;
+    const double rightScore = rule.Score(*queryNode.Right(), referenceNode);
+    ++numScores;
+
+    if (rightScore != DBL_MAX)
+      Traverse(*queryNode.Right(), referenceNode);
+    else
+      ++numPrunes;
+  }
+  else if (queryNode.IsLeaf() && (!referenceNode.IsLeaf()))
+  {
+    // We have to recurse down the reference node.  In this case the recursion
+    // order does matter.  Before recursing, though, we have to set the
+    // traversal information correctly.
+    double leftScore = rule.Score(queryNode, *referenceNode.Left());
+    typename RuleType::TraversalInfoType leftInfo = rule.TraversalInfo();
+    rule.TraversalInfo() = traversalInfo;
+    double rightScore = rule.Score(queryNode, *referenceNode.Right());
+    numScores += 2;
+
+    if (leftScore < rightScore)
+    {
+      // Recurse to the left.  Restore the left traversal info.  Store the right
+      // traversal info.
+      traversalInfo = rule.TraversalInfo();
+      rule.TraversalInfo() = leftInfo;
+      Traverse(queryNode, *referenceNode.Left());
+
+      // Is it still valid to recurse to the right?
+      rightScore = rule.Rescore(queryNode, *referenceNode.Right(), rightScore);
+
+      if (rightScore != DBL_MAX)
+      {
+        // Restore the right traversal info.
+        rule.TraversalInfo() = traversalInfo;
+        Traverse(queryNode, *referenceNode.Right());
+      }
+      else
+        ++numPrunes;
+    }
+    else if (rightScore < leftScore)
+    {
+      // Recurse to the right.
+      Traverse(queryNode, *referenceNode.Right());
+
+      // Is it still valid to recurse to the left?
+      leftScore = rule.Rescore(queryNode, *referenceNode.Left(), leftScore);
+
+      if (leftScore != DBL_MAX)
+      {
+        // Restore the left traversal info.
+        rule.TraversalInfo() = leftInfo;
+        Traverse(queryNode, *referenceNode.Left());
+      }
+      else
+        ++numPrunes;
+    }
+    else // leftScore is equal to rightScore.
+    {
+      if (leftScore == DBL_MAX)
+      {
+        numPrunes += 2;
+      }
+      else
+      {
+        // Choose the left first.  Restore the left traversal info.  Store the
+        // right traversal info.
+        traversalInfo = rule.TraversalInfo();
+        rule.TraversalInfo() = leftInfo;
+        Traverse(queryNode, *referenceNode.Left());
+
+        rightScore = rule.Rescore(queryNode, *referenceNode.Right(),
+            rightScore);
+
+        if (rightScore != DBL_MAX)
+        {
+          // Restore the right traversal info.
+          rule.TraversalInfo() = traversalInfo;
+          Traverse(queryNode, *referenceNode.Right());
+        }
+        else
+          ++numPrunes;
+      }
+    }
+  }
+  else
+  {
+    // We have to recurse down both query and reference nodes.  Because the
+    // query descent order does not matter, we will go to the left query child
+    // first.  Before recursing, we have to set the traversal information
+    // correctly.
+    double leftScore = rule.Score(*queryNode.Left(), *referenceNode.Left());
+    typename RuleType::TraversalInfoType leftInfo = rule.TraversalInfo();
+    rule.TraversalInfo() = traversalInfo;
+    double rightScore = rule.Score(*queryNode.Left(), *referenceNode.Right());
+    typename RuleType::TraversalInfoType rightInfo;
+    numScores += 2;
+
+    if (leftScore < rightScore)
+    {
+      // Recurse to the left.  Restore the left traversal info.  Store the right
+      // traversal info.
+      rightInfo = rule.TraversalInfo();
+      rule.TraversalInfo() = leftInfo;
+      Traverse(*queryNode.Left(), *referenceNode.Left());
+
+      // Is it still valid to recurse to the right?
+      rightScore = rule.Rescore(*queryNode.Left(), *referenceNode.Right(),
+          rightScore);
+
+      if (rightScore != DBL_MAX)
+      {
+        // Restore the right traversal info.
+        rule.TraversalInfo() = rightInfo;
+        Traverse(*queryNode.Left(), *referenceNode.Right());
+      }
+      else
+        ++numPrunes;
+    }
+    else if (rightScore < leftScore)
+    {
+      // Recurse to the right.
+      Traverse(*queryNode.Left(), *referenceNode.Right());
+
+      // Is it still valid to recurse to the left?
+      leftScore = rule.Rescore(*queryNode.Left(), *referenceNode.Left(),
+          leftScore);
+
+      if (leftScore != DBL_MAX)
+      {
+        // Restore the left traversal info.
+        rule.TraversalInfo() = leftInfo;
+        Traverse(*queryNode.Left(), *referenceNode.Left());
+      }
+      else
+        ++numPrunes;
+    }
+    else
+    {
+      if (leftScore == DBL_MAX)
+      {
+        numPrunes += 2;
+      }
+      else
+      {
+        // Choose the left first.  Restore the left traversal info and store the
+        // right traversal info.
+        rightInfo = rule.TraversalInfo();
+        rule.TraversalInfo() = leftInfo;
+        Traverse(*queryNode.Left(), *referenceNode.Left());
+
+        // Is it still valid to recurse to the right?
+        rightScore = rule.Rescore(*queryNode.Left(), *referenceNode.Right(),
+            rightScore);
+
+        if (rightScore != DBL_MAX)
+        {
+          // Restore the right traversal information.
+          rule.TraversalInfo() = rightInfo;
+          Traverse(*queryNode.Left(), *referenceNode.Right());
+        }
+        else
+          ++numPrunes;
+      }
+    }
+
+    // Restore the main traversal information.
+    rule.TraversalInfo() = traversalInfo;
+
+    // Now recurse down the right query node.
+    leftScore = rule.Score(*queryNode.Right(), *referenceNode.Left());
+    leftInfo = rule.TraversalInfo();
+    rule.TraversalInfo() = traversalInfo;
+    rightScore = rule.Score(*queryNode.Right(), *referenceNode.Right());
+    numScores += 2;
+
+    if (leftScore < rightScore)
+    {
+      // Recurse to the left.  Restore the left traversal info.  Store the right
+      // traversal info.
+      rightInfo = rule.TraversalInfo();
+      rule.TraversalInfo() = leftInfo;
+      Traverse(*queryNode.Right(), *referenceNode.Left());
+
+      // Is it still valid to recurse to the right?
+      rightScore = rule.Rescore(*queryNode.Right(), *referenceNode.Right(),
+          rightScore);
+
+      if (rightScore != DBL_MAX)
+      {
+        // Restore the right traversal info.
+        rule.TraversalInfo() = rightInfo;
+        Traverse(*queryNode.Right(), *referenceNode.Right());
+      }
+      else
+        ++numPrunes;
+    }
+    else if (rightScore < leftScore)
+    {
+      // Recurse to the right.
+      Traverse(*queryNode.Right(), *referenceNode.Right());
+
+      // Is it still valid to recurse to the left?
+      leftScore = rule.Rescore(*queryNode.Right(), *referenceNode.Left(),
+          leftScore);
+
+      if (leftScore != DBL_MAX)
+      {
+        // Restore the left traversal info.
+        rule.TraversalInfo() = leftInfo;
+        Traverse(*queryNode.Right(), *referenceNode.Left());
+      }
+      else
+        ++numPrunes;
+    }
+    else
+    {
+      if (leftScore == DBL_MAX)
+      {
+        numPrunes += 2;
+      }
+      else
+      {
+        // Choose the left first.  Restore the left traversal info.  Store the
+        // right traversal info.
+        rightInfo = rule.TraversalInfo();
+        rule.TraversalInfo() = leftInfo;
+        Traverse(*queryNode.Right(), *referenceNode.Left());
+
+        // Is it still valid to recurse to the right?
+        rightScore = rule.Rescore(*queryNode.Right(), *referenceNode.Right(),
+            rightScore);
+
+        if (rightScore != DBL_MAX)
+        {
+          // Restore the right traversal info.
+          rule.TraversalInfo() = rightInfo;
+          Traverse(*queryNode.Right(), *referenceNode.Right());
+        }
+        else
+          ++numPrunes;
+      }
+    }
+  }
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+void IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+DualTreeTraverser<RuleType>::TraverseParallel(
+    IndexedBinarySpaceTree<BoundType, StatisticType, MatType>& queryNode,
+    IndexedBinarySpaceTree<BoundType, StatisticType, MatType>&
+        referenceNode,
+    const size_t splitDepth)
+{
+  // Once we are deep enough (or can't split the query node any further), this
+  // task just runs the serial traversal.
+  if (splitDepth == 0 || queryNode.IsLeaf())
+  {
+    Traverse(queryNode, referenceNode);
+    return;
+  }
+
+  // Increment the visit counter.
+  ++numVisited;
+
+  // The recursions into the two query children are independent: they only
+  // touch the results of their own query points and the statistics of their
+  // own query nodes.  So each one gets its own copy of the rules (and thus its
+  // own traversal information and base case cache), starting from the current
+  // traversal information, and its own traverser.
+  RuleType leftRule(rule);
+  RuleType rightRule(rule);
+  leftRule.Statistics().Reset();
+  rightRule.Statistics().Reset();
+
+  DualTreeTraverser leftTraverser(leftRule);
+  DualTreeTraverser rightTraverser(rightRule);
+
+  IndexedBinarySpaceTree* queryLeft = queryNode.Left();
+  IndexedBinarySpaceTree* queryRight = queryNode.Right();
+  IndexedBinarySpaceTree* reference = &referenceNode;
+
+  #pragma omp task shared(leftRule, leftTraverser) \
+      firstprivate(queryLeft, reference)
+  {
+    ++leftTraverser.numScores;
+    if (leftRule.Score(*queryLeft, *reference) != DBL_MAX)
+      leftTraverser.TraverseParallel(*queryLeft, *reference, splitDepth - 1);
+    else
+      ++leftTraverser.numPrunes;
+  }
+
+  #pragma omp task shared(rightRule, rightTraverser) \
+      firstprivate(queryRight, reference)
+  {
+    ++rightTraverser.numScores;
+    if (rightRule.Score(*queryRight, *reference) != DBL_MAX)
+      rightTraverser.TraverseParallel(*queryRight, *reference, splitDepth - 1);
+    else
+      ++rightTraverser.numPrunes;
+  }
+
+  #pragma omp taskwait
+
+  // Now merge the results of each task back into our rules and statistics.
+  rule.Statistics() += leftRule.Statistics();
+  rule.Statistics() += rightRule.Statistics();
+
+  numPrunes += leftTraverser.NumPrunes() + rightTraverser.NumPrunes();
+  numVisited += leftTraverser.NumVisited() + rightTraverser.NumVisited();
+  numScores += leftTraverser.NumScores() + rightTraverser.NumScores();
+  numBaseCases += leftTraverser.NumBaseCases() + rightTraverser.NumBaseCases();
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif // __MLPACK_CORE_TREE_INDEXED_TREE_DUAL_TREE_TRAVERSER_IMPL_HPP
@@ -0,0 +1,363 @@
+/**
+ * @file indexed_binary_space_tree.hpp
+ *
+ * Definition of the IndexedBinarySpaceTree class, a binary space tree that
+ * permutes an array of point indices instead of the columns of the dataset.
+ */
+#ifndef __MLPACK_CORE_TREE_INDEXED_TREE_INDEXED_BINARY_SPACE_TREE_HPP
+#define __MLPACK_CORE_TREE_INDEXED_TREE_INDEXED_BINARY_SPACE_TREE_HPP
+
+#include <mlpack/core.hpp>
+
+#include "../statistic.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A binary space partitioning tree that does not rearrange its dataset.  The
+ * nodes are split in the same way as a BinarySpaceTree with a MeanSplit (in the
+ * middle of the widest dimension of the bound), but instead of swapping the
+ * columns of the dataset, the tree permutes one array of point indices shared
+ * by all of its nodes, so that the points of each node are a contiguous range
+ * of that array.  The tree is thus the same as the BinarySpaceTree built on a
+ * copy of the dataset, and Point(i) of a node is the original index of the
+ * point that the BinarySpaceTree would hold at Point(i) of the same node (that
+ * is, the index array is the oldFromNew mapping of the BinarySpaceTree).
+ *
+ * Because the dataset is only read, it does not have to be copied before the
+ * tree is built, the results of a search do not have to be mapped back to the
+ * original indices, and several trees (with different leaf sizes or bounds, or
+ * in different processes, if the matrix is memory-mapped) can share one
+ * read-only matrix.  The dataset must not be changed while the tree exists.
+ *
+ * The price is that the points of a leaf are no longer next to each other in
+ * memory.  To get that locality back, each leaf can optionally keep its own
+ * copy of the coordinates of its points (see LocalDataset()), so that the base
+ * cases between two leaves can be computed on contiguous blocks of points (see
+ * LeafBlockDistances()).  This uses as much memory again as the dataset.
+ *
+ * If mlpack was compiled with OpenMP, the subtrees of large nodes are built in
+ * parallel; the resulting tree is the same as the one built by a single thread.
+ *
+ * @code
+ * extern arma::mat dataset;
+ * typedef IndexedBinarySpaceTree<bound::HRectBound<2>,
+ *     neighbor::NeighborSearchStat<neighbor::NearestNeighborSort> > TreeType;
+ *
+ * // Build the tree, with leaf-local copies of the points.  The dataset is
+ * // neither modified nor copied.
+ * TreeType tree(dataset, 20, true);
+ *
+ * // The neighbors are indices into the dataset; nothing needs to be unmapped.
+ * neighbor::NeighborSearch<neighbor::NearestNeighborSort,
+ *     metric::EuclideanDistance, TreeType> knn(&tree, dataset);
+ * knn.Search(5, neighbors, distances);
+ * @endcode
+ *
+ * @tparam BoundType The bound used for each node; an HRectBound or a BallBound.
+ * @tparam StatisticType Extra data contained in the node.  See statistic.hpp
+ *     for the necessary skeleton interface.
+ * @tparam MatType The dataset class; a dense matrix type (arma::mat or
+ *     arma::fmat).
+ */
+template<typename BoundType,
+         typename StatisticType = EmptyStatistic,
+         typename MatType = arma::mat>
+class IndexedBinarySpaceTree
+{
+ private:
+  //! The left child node.
+  IndexedBinarySpaceTree* left;
+  //! The right child node.
+  IndexedBinarySpaceTree* right;
+  //! The parent node (NULL if this is the root of the tree).
+  IndexedBinarySpaceTree* parent;
+  //! The position of the first index of this node in the index array.
+  size_t begin;
+  //! The number of points held by this node (and its children).
+  size_t count;
+  //! The max leaf size.
+  size_t maxLeafSize;
+  //! The bound object for this node.
+  BoundType bound;
+  //! Any extra data contained in the node.
+  StatisticType stat;
+  //! The dimension this node split on if it is a parent.
+  size_t splitDimension;
+  //! The distance from the centroid of this node to the centroid of the parent.
+  double parentDistance;
+  //! The worst possible distance to the furthest descendant, cached to speed
+  //! things up.
+  double furthestDescendantDistance;
+  //! The dataset.
+  const MatType& dataset;
+  //! The indices of the points, ordered so that the points of each node are
+  //! contiguous.  This is shared by all the nodes and owned by the root.
+  std::vector<size_t>* indices;
+  //! The copy of the points of this node, if it is a leaf and leaf-local
+  //! copies were asked for (NULL otherwise).
+  MatType* localDataset;
+
+ public:
+  //! So other classes can use TreeType::Mat.
+  typedef MatType Mat;
+
+  //! A single-tree traverser for indexed binary space trees; see
+  //! single_tree_traverser.hpp.
+  template<typename RuleType>
+  class SingleTreeTraverser;
+
+  //! A dual-tree traverser for indexed binary space trees; see
+  //! dual_tree_traverser.hpp.
+  template<typename RuleType>
+  class DualTreeTraverser;
+
+  /**
+   * Construct this as the root node of an indexed binary space tree on the
+   * given dataset.  The dataset is not modified, and is not copied (unless
+   * leaf-local copies are asked for).
+   *
+   * @param data Dataset to build the tree on.
+   * @param maxLeafSize Size of each leaf in the tree.
+   * @param copyLeafPoints If true, each leaf keeps a copy of the coordinates of
+   *     its points.
+   */
+  IndexedBinarySpaceTree(const MatType& data,
+                         const size_t maxLeafSize = 20,
+                         const bool copyLeafPoints = false);
+
+  /**
+   * Create a copy of the given tree, with its own copies of every node, of the
+   * index array and of the leaf-local points (the dataset is not copied).  The
+   * copy is the root of a new tree.
+   *
+   * @param other Tree to copy.
+   */
+  IndexedBinarySpaceTree(const IndexedBinarySpaceTree& other);
+
+  /**
+   * Delete this node and all of its children (and the index array, if this is
+   * the root).
+   */
+  ~IndexedBinarySpaceTree();
+
+  //! Return the bound object for this node.
+  const BoundType& Bound() const { return bound; }
+  //! Return the bound object for this node.
+  BoundType& Bound() { return bound; }
+
+  //! Return the statistic object for this node.
+  const StatisticType& Stat() const { return stat; }
+  //! Return the statistic object for this node.
+  StatisticType& Stat() { return stat; }
+
+  //! Return whether or not this node is a leaf (has no children).
+  bool IsLeaf() const { return (left == NULL); }
+
+  //! Return the max leaf size.
+  size_t MaxLeafSize() const { return maxLeafSize; }
+
+  //! Gets the left child of this node.
+  IndexedBinarySpaceTree* Left() const { return left; }
+  //! Gets the right child of this node.
+  IndexedBinarySpaceTree* Right() const { return right; }
+  //! Gets the parent of this node.
+  IndexedBinarySpaceTree* Parent() const { return parent; }
+
+  //! Get the split dimension for this node.
+  size_t SplitDimension() const { return splitDimension; }
+
+  //! Get the dataset which the tree is built on.
+  const MatType& Dataset() const { return dataset; }
+
+  /**
+   * Get the indices of all the points of the tree, in the order of the tree:
+   * the points of each node are a contiguous range of this array.
+   */
+  const std::vector<size_t>& Indices() const { return *indices; }
+
+  /**
+   * Get the copy of the points of this node, in the same order as Point(), if
+   * this is a leaf of a tree built with leaf-local copies; otherwise, NULL.
+   */
+  const MatType* LocalDataset() const { return localDataset; }
+
+  //! Get the metric which the tree uses.
+  typename BoundType::MetricType Metric() const { return bound.Metric(); }
+
+  //! Get the centroid of the node and store it in the given vector.
+  void Centroid(arma::vec& centroid) { bound.Centroid(centroid); }
+
+  //! Return the number of children in this node.
+  size_t NumChildren() const { return IsLeaf() ? 0 : 2; }
+
+  /**
+   * Return the furthest distance to a point held in this node.  If this is not
+   * a leaf node, then the distance is 0 because the node holds no points.
+   */
+  double FurthestPointDistance() const;
+
+  /**
+   * Return the furthest possible descendant distance: the distance from the
+   * centroid to the furthest edge of the bound.  The actual furthest
+   * descendant distance may be less.
+   */
+  double FurthestDescendantDistance() const
+  { return furthestDescendantDistance; }
+
+  //! Return the minimum distance from the center of the node to any bound edge.
+  double MinimumBoundDistance() const { return bound.MinWidth() / 2.0; }
+
+  //! Return the distance from the center of this node to the center of the
+  //! parent node.
+  double ParentDistance() const { return parentDistance; }
+  //! Modify the distance from the center of this node to the center of the
+  //! parent node.
+  double& ParentDistance() { return parentDistance; }
+
+  /**
+   * Return the specified child (0 will be left, 1 will be right).  If the index
+   * is greater than 1, this will return the right child.
+   *
+   * @param child Index of child to return.
+   */
+  IndexedBinarySpaceTree& Child(const size_t child) const
+  { return (child == 0) ? *left : *right; }
+
+  //! Return the number of points in this node (0 if not a leaf).
+  size_t NumPoints() const { return IsLeaf() ? count : 0; }
+
+  //! Return the number of descendants of this node.
+  size_t NumDescendants() const { return count; }
+
+  /**
+   * Return the index (with reference to the dataset) of a particular descendant
+   * of this node.  The index should be less than the number of descendants.
+   *
+   * @param index Index of the descendant.
+   */
+  size_t Descendant(const size_t index) const
+  { return (*indices)[begin + index]; }
+
+  /**
+   * Return the index (with reference to the dataset) of a particular point in
+   * this node.  This will happily return invalid indices if the given index is
+   * greater than the number of points in this node -- be careful.
+   *
+   * @param index Index of point for which a dataset index is wanted.
+   */
+  size_t Point(const size_t index) const { return (*indices)[begin + index]; }
+
+  //! Return the minimum distance to another node.
+  double MinDistance(const IndexedBinarySpaceTree* other) const
+  {
+    return bound.MinDistance(other->Bound());
+  }
+
+  //! Return the maximum distance to another node.
+  double MaxDistance(const IndexedBinarySpaceTree* other) const
+  {
+    return bound.MaxDistance(other->Bound());
+  }
+
+  //! Return the minimum and maximum distance to another node.
+  math::Range RangeDistance(const IndexedBinarySpaceTree* other) const
+  {
+    return bound.RangeDistance(other->Bound());
+  }
+
+  //! Return the minimum distance to another point.
+  template<typename VecType>
+  double MinDistance(const VecType& point,
+                     typename boost::enable_if<IsVector<VecType> >::type* = 0)
+      const
+  {
+    return bound.MinDistance(point);
+  }
+
+  //! Return the maximum distance to another point.
+  template<typename VecType>
+  double MaxDistance(const VecType& point,
+                     typename boost::enable_if<IsVector<VecType> >::type* = 0)
+      const
+  {
+    return bound.MaxDistance(point);
+  }
+
+  //! Return the minimum and maximum distance to another point.
+  template<typename VecType>
+  math::Range
+  RangeDistance(const VecType& point,
+                typename boost::enable_if<IsVector<VecType> >::type* = 0) const
+  {
+    return bound.RangeDistance(point);
+  }
+
+  //! Obtains the number of nodes in the tree, starting with this.
+  size_t TreeSize() const;
+
+  //! Obtains the number of levels below this node in the tree, starting with
+  //! this.
+  size_t TreeDepth() const;
+
+  //! Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  /**
+   * Construct a child of the given node, holding the points at the given range
+   * of positions in the index array.
+   *
+   * @param parent Parent of the new node.
+   * @param begin Position of the first index of the new node.
+   * @param count Number of points of the new node.
+   * @param copyLeafPoints If true, leaves keep a copy of their points.
+   */
+  IndexedBinarySpaceTree(IndexedBinarySpaceTree* parent,
+                         const size_t begin,
+                         const size_t count,
+                         const bool copyLeafPoints);
+
+  /**
+   * Copy the given node and its children into a child of the given parent,
+   * sharing the index array of the parent.
+   *
+   * @param other Node to copy.
+   * @param parent Parent of the copy.
+   */
+  IndexedBinarySpaceTree(const IndexedBinarySpaceTree& other,
+                         IndexedBinarySpaceTree* parent);
+
+  //! Nodes with more points than this have their subtrees built in parallel
+  //! (only if mlpack was compiled with OpenMP).
+  static const size_t parallelBuildThreshold = 10000;
+
+  //! The number of points gathered at once when the bound of a node is set.
+  static const size_t boundBlockSize = 256;
+
+  /**
+   * Set the bound of this node from its points, and split it (recursively) if
+   * it holds more than the max leaf size, by reordering its part of the index
+   * array.
+   *
+   * @param copyLeafPoints If true, leaves keep a copy of their points.
+   */
+  void SplitNode(const bool copyLeafPoints);
+
+  /**
+   * Reorder the indices of this node so that those of the points with value
+   * less than splitVal in dimension splitDim come first, in the same way as
+   * MeanSplit reorders the columns of a dataset, and return the position of the
+   * first index that does not.
+   */
+  size_t PerformSplit(const size_t splitDim, const double splitVal);
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "indexed_binary_space_tree_impl.hpp"
+
+#endif
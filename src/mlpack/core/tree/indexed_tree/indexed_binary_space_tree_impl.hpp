@@ -0,0 +1,311 @@
+/**
+ * @file indexed_binary_space_tree_impl.hpp
+ *
+ * Implementation of the IndexedBinarySpaceTree class.
+ */
+#ifndef __MLPACK_CORE_TREE_INDEXED_TREE_INDEXED_BINARY_SPACE_TREE_IMPL_HPP
+#define __MLPACK_CORE_TREE_INDEXED_TREE_INDEXED_BINARY_SPACE_TREE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "indexed_binary_space_tree.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename StatisticType, typename MatType>
+IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+IndexedBinarySpaceTree(const MatType& data,
+                       const size_t maxLeafSize,
+                       const bool copyLeafPoints) :
+    left(NULL),
+    right(NULL),
+    parent(NULL),
+    begin(0), /* This root node starts at index 0, */
+    count(data.n_cols), /* and spans all of the dataset. */
+    maxLeafSize(maxLeafSize),
+    bound(data.n_rows),
+    splitDimension(0),
+    parentDistance(0), // Parent distance for the root is 0: it has no parent.
+    furthestDescendantDistance(0),
+    dataset(data),
+    indices(new std::vector<size_t>(data.n_cols)),
+    localDataset(NULL)
+{
+  for (size_t i = 0; i < data.n_cols; ++i)
+    (*indices)[i] = i;
+
+  // Do the actual splitting of this node.  If OpenMP is available and the
+  // dataset is large enough, the subtrees are built in parallel.
+  #pragma omp parallel if (data.n_cols > parallelBuildThreshold)
+  {
+    #pragma omp single
+    SplitNode(copyLeafPoints);
+  }
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+IndexedBinarySpaceTree(IndexedBinarySpaceTree* parent,
+                       const size_t begin,
+                       const size_t count,
+                       const bool copyLeafPoints) :
+    left(NULL),
+    right(NULL),
+    parent(parent),
+    begin(begin),
+    count(count),
+    maxLeafSize(parent->maxLeafSize),
+    bound(parent->dataset.n_rows),
+    splitDimension(0),
+    parentDistance(0),
+    furthestDescendantDistance(0),
+    dataset(parent->dataset),
+    indices(parent->indices),
+    localDataset(NULL)
+{
+  // Perform the actual splitting.
+  SplitNode(copyLeafPoints);
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+IndexedBinarySpaceTree(const IndexedBinarySpaceTree& other) :
+    left(NULL),
+    right(NULL),
+    parent(NULL),
+    begin(other.begin),
+    count(other.count),
+    maxLeafSize(other.maxLeafSize),
+    bound(other.bound),
+    stat(other.stat),
+    splitDimension(other.splitDimension),
+    parentDistance(other.parentDistance),
+    furthestDescendantDistance(other.furthestDescendantDistance),
+    dataset(other.dataset),
+    indices(new std::vector<size_t>(*other.indices)),
+    localDataset(other.localDataset ? new MatType(*other.localDataset) : NULL)
+{
+  // Copy the children, which share our copy of the index array.
+  if (other.Left())
+  {
+    left = new IndexedBinarySpaceTree(*other.Left(), this);
+    right = new IndexedBinarySpaceTree(*other.Right(), this);
+  }
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+IndexedBinarySpaceTree(const IndexedBinarySpaceTree& other,
+                       IndexedBinarySpaceTree* parent) :
+    left(NULL),
+    right(NULL),
+    parent(parent),
+    begin(other.begin),
+    count(other.count),
+    maxLeafSize(other.maxLeafSize),
+    bound(other.bound),
+    stat(other.stat),
+    splitDimension(other.splitDimension),
+    parentDistance(other.parentDistance),
+    furthestDescendantDistance(other.furthestDescendantDistance),
+    dataset(other.dataset),
+    indices(parent->indices),
+    localDataset(other.localDataset ? new MatType(*other.localDataset) : NULL)
+{
+  if (other.Left())
+  {
+    left = new IndexedBinarySpaceTree(*other.Left(), this);
+    right = new IndexedBinarySpaceTree(*other.Right(), this);
+  }
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+~IndexedBinarySpaceTree()
+{
+  if (left)
+    delete left;
+  if (right)
+    delete right;
+  if (localDataset)
+    delete localDataset;
+
+  // The index array belongs to the root.
+  if (!parent)
+    delete indices;
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+double IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+    FurthestPointDistance() const
+{
+  if (!IsLeaf())
+    return 0.0;
+
+  // Otherwise return the distance from the centroid to a corner of the bound.
+  return 0.5 * bound.Diameter();
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+size_t IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::TreeSize()
+    const
+{
+  if (IsLeaf())
+    return 1;
+
+  return 1 + left->TreeSize() + right->TreeSize();
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+size_t IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::TreeDepth()
+    const
+{
+  if (IsLeaf())
+    return 1;
+
+  return 1 + std::max(left->TreeDepth(), right->TreeDepth());
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+void IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::SplitNode(
+    const bool copyLeafPoints)
+{
+  // Expand the bound to contain the points of this node.  They are gathered a
+  // block at a time, so that the dataset is never copied as a whole.
+  arma::uvec blockIndices;
+  for (size_t i = 0; i < count; i += boundBlockSize)
+  {
+    blockIndices.set_size(std::min((size_t) boundBlockSize, count - i));
+    for (size_t j = 0; j < blockIndices.n_elem; ++j)
+      blockIndices[j] = (*indices)[begin + i + j];
+
+    const MatType block = dataset.cols(blockIndices);
+    bound |= block;
+  }
+
+  // Calculate the furthest descendant distance.
+  furthestDescendantDistance = 0.5 * bound.Diameter();
+
+  // Find the split dimension, as MeanSplit does: the widest one.  If every
+  // dimension has width zero, all the points are the same and can't be split.
+  double maxWidth = -1;
+  if (count > maxLeafSize)
+  {
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+    {
+      const double width = bound[d].Width();
+      if (width > maxWidth)
+      {
+        maxWidth = width;
+        splitDimension = d;
+      }
+    }
+  }
+
+  // Split in the middle of that dimension.  The points with value less than the
+  // middle go to the left child, and the others go to the right child.  If the
+  // bound is so thin that the middle rounds to one of its ends, the points
+  // can't be split either.
+  const size_t splitCol = (maxWidth > 0) ? PerformSplit(splitDimension,
+      bound[splitDimension].Mid()) : begin;
+
+  if (splitCol == begin || splitCol == begin + count)
+  {
+    // This is a leaf.
+    if (copyLeafPoints)
+    {
+      arma::uvec leafIndices(count);
+      for (size_t i = 0; i < count; ++i)
+        leafIndices[i] = (*indices)[begin + i];
+      localDataset = new MatType(dataset.cols(leafIndices));
+    }
+    return;
+  }
+
+  // The children hold disjoint ranges of the index array, so when this is
+  // called inside a parallel region and the node is large enough, the left
+  // child is built as a separate task.  This does not change the resulting
+  // tree.
+  #pragma omp task if (count > parallelBuildThreshold)
+  left = new IndexedBinarySpaceTree(this, begin, splitCol - begin,
+      copyLeafPoints);
+  right = new IndexedBinarySpaceTree(this, splitCol, begin + count - splitCol,
+      copyLeafPoints);
+  #pragma omp taskwait
+
+  // Calculate parent distances for those two nodes.
+  // The centroids have the same element type as the data, so that the metric
+  // can be evaluated between them.
+  arma::Col<typename MatType::elem_type> centroid, leftCentroid, rightCentroid;
+  bound.Centroid(centroid);
+  left->Bound().Centroid(leftCentroid);
+  right->Bound().Centroid(rightCentroid);
+
+  left->ParentDistance() = bound.Metric().Evaluate(centroid, leftCentroid);
+  right->ParentDistance() = bound.Metric().Evaluate(centroid, rightCentroid);
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+size_t IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::PerformSplit(
+    const size_t splitDim,
+    const double splitVal)
+{
+  // This is the loop of MeanSplit, with the indices swapped instead of the
+  // columns, so that the points end up in the same order.  The indices in
+  // [left, right) have not been looked at yet.
+  std::vector<size_t>& order = *indices;
+  size_t left = begin;
+  size_t right = begin + count;
+
+  while (true)
+  {
+    while ((left < right) && (dataset(splitDim, order[left]) < splitVal))
+      ++left;
+    while ((left < right) && (dataset(splitDim, order[right - 1]) >= splitVal))
+      --right;
+
+    if (left == right)
+      break;
+
+    std::swap(order[left], order[right - 1]);
+  }
+
+  return left;
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+std::string IndexedBinarySpaceTree<BoundType, StatisticType, MatType>::
+    ToString() const
+{
+  std::ostringstream convert;
+  convert << "IndexedBinarySpaceTree [" << this << "]" << std::endl;
+  convert << "  Number of descendants: " << count << std::endl;
+  convert << "  Bound: " << std::endl;
+  convert << mlpack::util::Indent(bound.ToString(), 2);
+  convert << "  Statistic: " << std::endl;
+  convert << mlpack::util::Indent(stat.ToString(), 2);
+  convert << "  Max leaf size: " << maxLeafSize << std::endl;
+  convert << "  Leaf-local points: " << (localDataset != NULL) << std::endl;
+  if (!IsLeaf())
+  {
+    convert << "  Split dimension: " << splitDimension << std::endl;
+    convert << "  Left child:" << std::endl;
+    convert << mlpack::util::Indent(left->ToString(), 2);
+    convert << "  Right child:" << std::endl;
+    convert << mlpack::util::Indent(right->ToString(), 2);
+  }
+  return convert.str();
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
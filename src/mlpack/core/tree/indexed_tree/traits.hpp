@@ -0,0 +1,55 @@
+/**
+ * @file traits.hpp
+ *
+ * Specialization of the TreeTraits class for the IndexedBinarySpaceTree type of
+ * tree.
+ */
+#ifndef __MLPACK_CORE_TREE_INDEXED_TREE_TRAITS_HPP
+#define __MLPACK_CORE_TREE_INDEXED_TREE_TRAITS_HPP
+
+#include <mlpack/core/tree/tree_traits.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * This is a specialization of the TreeTraits class to the
+ * IndexedBinarySpaceTree tree type.  It has the same structure as the binary
+ * space tree, but it does not rearrange the dataset.  See
+ * mlpack/core/tree/tree_traits.hpp for more information.
+ */
+template<typename BoundType, typename StatisticType, typename MatType>
+class TreeTraits<IndexedBinarySpaceTree<BoundType, StatisticType, MatType> >
+{
+ public:
+  /**
+   * The children of a node represent non-overlapping subsets of the space which
+   * the node represents.
+   */
+  static const bool HasOverlappingChildren = false;
+
+  /**
+   * There is no guarantee that the first point in a node is its centroid.
+   */
+  static const bool FirstPointIsCentroid = false;
+
+  /**
+   * Points are not contained at multiple levels of the tree.
+   */
+  static const bool HasSelfChildren = false;
+
+  /**
+   * The index array is permuted instead of the dataset.
+   */
+  static const bool RearrangesDataset = false;
+
+  /**
+   * Each point is held by exactly one leaf.
+   */
+  static const bool HasDuplicatedPoints = false;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
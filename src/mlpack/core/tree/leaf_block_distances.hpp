@@ -0,0 +1,147 @@
+/**
+ * @file leaf_block_distances.hpp
+ *
+ * Compute all of the distances between the points of two leaves at once, with
+ * metric::BlockDistances(), for the batched base cases of dual-tree rules.
+ * Only the query points whose base cases were not pruned are used.
+ * This hides whether the points of a leaf are a contiguous range of its dataset
+ * (as in a BinarySpaceTree) or a leaf-local copy (as in an
+ * IndexedBinarySpaceTree).
+ */
+#ifndef __MLPACK_CORE_TREE_LEAF_BLOCK_DISTANCES_HPP
+#define __MLPACK_CORE_TREE_LEAF_BLOCK_DISTANCES_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/block_distances.hpp>
+
+namespace mlpack {
+namespace tree {
+
+//! Detect whether the leaves of a tree can hold copies of their points.
+HAS_MEM_FUNC(LocalDataset, HasLocalDataset);
+
+/**
+ * Compute the distances between the points in the given range of columns of
+ * the reference matrix and the listed points in the given range of columns of
+ * the query matrix, so that distances(i, k) is the distance between reference
+ * column referenceBegin + i and query column queryBegin + queryPoints[k].  If
+ * every point of the query range is listed, the range is used as it is;
+ * otherwise the listed points are copied together first.
+ *
+ * @param metric Metric to use.
+ * @param referencePoints Matrix holding the reference points.
+ * @param referenceBegin First column of the reference points.
+ * @param referenceCount Number of reference points.
+ * @param queryPoints Matrix holding the query points.
+ * @param queryBegin First column of the query points.
+ * @param queryCount Number of query points in the range.
+ * @param listedQueries Offsets (in the range) of the query points to use.
+ * @param distances Matrix to store the distances in.
+ * @return true if the distances were calculated (see metric::BlockDistances()).
+ */
+template<typename MetricType, typename MatType>
+bool ListedBlockDistances(const MetricType& metric,
+                          const MatType& referencePoints,
+                          const size_t referenceBegin,
+                          const size_t referenceCount,
+                          const MatType& queryPoints,
+                          const size_t queryBegin,
+                          const size_t queryCount,
+                          const std::vector<size_t>& listedQueries,
+                          arma::mat& distances)
+{
+  if (listedQueries.size() == queryCount)
+  {
+    return metric::BlockDistances(metric, referencePoints.cols(referenceBegin,
+        referenceBegin + referenceCount - 1), queryPoints.cols(queryBegin,
+        queryBegin + queryCount - 1), distances);
+  }
+
+  MatType queries(queryPoints.n_rows, listedQueries.size());
+  for (size_t k = 0; k < listedQueries.size(); ++k)
+    queries.col(k) = queryPoints.col(queryBegin + listedQueries[k]);
+
+  return metric::BlockDistances(metric, referencePoints.cols(referenceBegin,
+      referenceBegin + referenceCount - 1), queries.cols(0, queries.n_cols - 1),
+      distances);
+}
+
+/**
+ * Compute the distances between every point of the reference leaf and the
+ * listed points of the query leaf (those whose base cases were not pruned), so
+ * that distances(i, k) is the distance between points referenceNode.Point(i)
+ * and queryNode.Point(queryPoints[k]).  This overload is for trees whose leaves
+ * hold a contiguous range of the columns of their dataset, such as
+ * BinarySpaceTree.  Neither leaf and no list may be empty.
+ *
+ * @param metric Metric to use.
+ * @param referenceSet Dataset of the reference tree.
+ * @param referenceNode Reference leaf.
+ * @param querySet Dataset of the query tree.
+ * @param queryNode Query leaf.
+ * @param queryPoints Offsets (in the query leaf) of the query points to use.
+ * @param distances Matrix to store the distances in.
+ * @return true if the distances were calculated (see metric::BlockDistances()).
+ */
+template<typename MetricType, typename MatType, typename TreeType>
+bool LeafBlockDistances(
+    const MetricType& metric,
+    const MatType& referenceSet,
+    const TreeType& referenceNode,
+    const MatType& querySet,
+    const TreeType& queryNode,
+    const std::vector<size_t>& queryPoints,
+    arma::mat& distances,
+    const typename boost::disable_if_c<HasLocalDataset<TreeType,
+        const typename TreeType::Mat* (TreeType::*)() const>::value,
+        TreeType*>::type = 0)
+{
+  return ListedBlockDistances(metric, referenceSet, referenceNode.Point(0),
+      referenceNode.NumPoints(), querySet, queryNode.Point(0),
+      queryNode.NumPoints(), queryPoints, distances);
+}
+
+/**
+ * Compute the distances between every point of the reference leaf and the
+ * listed points of the query leaf, for trees whose leaves may hold copies of
+ * their points (see IndexedBinarySpaceTree::LocalDataset()).  If either leaf
+ * has no copy, its points are scattered through the dataset, so nothing is done
+ * and false is returned; the base cases must then be evaluated one by one.
+ *
+ * @param metric Metric to use.
+ * @param referenceSet Dataset of the reference tree (unused).
+ * @param referenceNode Reference leaf.
+ * @param querySet Dataset of the query tree (unused).
+ * @param queryNode Query leaf.
+ * @param queryPoints Offsets (in the query leaf) of the query points to use.
+ * @param distances Matrix to store the distances in.
+ * @return true if the distances were calculated.
+ */
+template<typename MetricType, typename MatType, typename TreeType>
+bool LeafBlockDistances(
+    const MetricType& metric,
+    const MatType& /* referenceSet */,
+    const TreeType& referenceNode,
+    const MatType& /* querySet */,
+    const TreeType& queryNode,
+    const std::vector<size_t>& queryPoints,
+    arma::mat& distances,
+    const typename boost::enable_if_c<HasLocalDataset<TreeType,
+        const typename TreeType::Mat* (TreeType::*)() const>::value,
+        TreeType*>::type = 0)
+{
+  const typename TreeType::Mat* referencePoints = referenceNode.LocalDataset();
+  const typename TreeType::Mat* localQueries = queryNode.LocalDataset();
+  if (!referencePoints || !localQueries)
+    return false;
+
+  // The block distances are computed on views of the matrices.
+  return ListedBlockDistances(metric, *referencePoints, 0,
+      referencePoints->n_cols, *localQueries, 0, localQueries->n_cols,
+      queryPoints, distances);
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
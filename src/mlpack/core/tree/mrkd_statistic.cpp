@@ -10,14 +10,32 @@ using namespace mlpack;
 using namespace mlpack::tree;
 
 MRKDStatistic::MRKDStatistic() :
-    dataset(NULL),
     begin(0),
     count(0),
-    leftStat(NULL),
-    rightStat(NULL),
-    parentStat(NULL)
+    sumOfSquaredNorms(0.0),
+    dominatingCentroid(0)
 { }
 
+/**
+ * Add a set of points to the statistics, with the pairwise update of the mean
+ * and scatter.
+ */
+void MRKDStatistic::Merge(const size_t otherCount,
+                          const arma::vec& otherCenterOfMass,
+                          const arma::mat& otherScatter)
+{
+  if (otherCount == 0)
+    return;
+
+  const size_t newCount = count + otherCount;
+  const arma::vec delta = otherCenterOfMass - centerOfMass;
+
+  centerOfMass += delta * ((double) otherCount / newCount);
+  scatter += otherScatter + (delta * trans(delta)) *
+      ((double) count * otherCount / newCount);
+  count = newCount;
+}
+
 /**
  * Returns a string representation of this object.
  */
@@ -25,19 +43,10 @@ std::string MRKDStatistic::ToString() const
 {
   std::ostringstream convert;
 
-  convert << "MRKDStatistic [" << this << std::endl;
+  convert << "MRKDStatistic [" << this << "]" << std::endl;
   convert << "begin: " << begin << std::endl;
   convert << "count: " << count << std::endl;
+  convert << "centerOfMass: " << trans(centerOfMass);
   convert << "sumOfSquaredNorms: " << sumOfSquaredNorms << std::endl;
-  if (leftStat != NULL)
-  {
-    convert << "leftStat:" << std::endl;
-    convert << mlpack::util::Indent(leftStat->ToString());
-  }
-  if (rightStat != NULL)
-  {
-    convert << "rightStat:" << std::endl;
-    convert << mlpack::util::Indent(rightStat->ToString());
-  }
   return convert.str();
 }
@@ -13,7 +13,13 @@ namespace mlpack {
 namespace tree {
 
 /**
- * Statistic for multi-resolution kd-trees.
+ * Statistic for multi-resolution kd-trees.  For each node it holds the number
+ * of points, their center of mass, the sum of the outer products of their
+ * differences from the center of mass (their scatter), and the sum of their
+ * squared norms, so that algorithms such as tree-based EM (gmm::TreeEMFit)
+ * can summarize every point in a node at once.  The statistics of a node are
+ * computed from those of its children, so the tree must be built depth-first
+ * (as BinarySpaceTree is).
  */
 class MRKDStatistic
 {
@@ -22,12 +28,13 @@ class MRKDStatistic
   MRKDStatistic();
 
   /**
-   * This constructor is called when a node is finished initializing.
+   * This constructor is called when a node is finished initializing, and
+   * computes the statistics of the points in the node.
    *
    * @param node The node that has been finished.
    */
   template<typename TreeType>
-  MRKDStatistic(const TreeType& /* node */);
+  MRKDStatistic(const TreeType& node);
 
   /**
    * Returns a string representation of this object.
@@ -49,6 +56,16 @@ class MRKDStatistic
   //! Modify the center of mass.
   arma::colvec& CenterOfMass() { return centerOfMass; }
 
+  //! Get the scatter of the points around the center of mass.
+  const arma::mat& Scatter() const { return scatter; }
+  //! Modify the scatter of the points around the center of mass.
+  arma::mat& Scatter() { return scatter; }
+
+  //! Get the sum of the squared Euclidean norms of the points.
+  double SumOfSquaredNorms() const { return sumOfSquaredNorms; }
+  //! Modify the sum of the squared Euclidean norms of the points.
+  double& SumOfSquaredNorms() { return sumOfSquaredNorms; }
+
   //! Get the index of the dominating centroid.
   size_t DominatingCentroid() const { return dominatingCentroid; }
   //! Modify the index of the dominating centroid.
@@ -60,22 +77,24 @@ class MRKDStatistic
   std::vector<size_t>& Whitelist() { return whitelist; }
 
  private:
-  //! The data points this object contains.
-  const arma::mat* dataset;
+  /**
+   * Add a set of points, summarized by their number, center of mass, and
+   * scatter, to the statistics.
+   */
+  void Merge(const size_t otherCount,
+             const arma::vec& otherCenterOfMass,
+             const arma::mat& otherScatter);
+
   //! The initial item in the dataset, so we don't have to make a copy.
   size_t begin;
   //! The number of items in the dataset.
   size_t count;
-  //! The left child.
-  const MRKDStatistic* leftStat;
-  //! The right child.
-  const MRKDStatistic* rightStat;
-  //! A link to the parent node; NULL if this is the root.
-  const MRKDStatistic* parentStat;
 
   // Computed statistics.
   //! The center of mass for this dataset.
   arma::colvec centerOfMass;
+  //! The sum of (x - centerOfMass) * (x - centerOfMass)^T over the points.
+  arma::mat scatter;
   //! The sum of the squared Euclidean norms for this dataset.
   double sumOfSquaredNorms;
 
@@ -85,8 +104,6 @@ class MRKDStatistic
 
   //! The list of centroids that cannot own this hyperrectangle.
   std::vector<size_t> whitelist;
-  //! Whether or not the whitelist is valid.
-  bool isWhitelistValid;
 };
 
 }; // namespace tree
@@ -14,78 +14,33 @@ namespace mlpack {
 namespace tree {
 
 template<typename TreeType>
-MRKDStatistic::MRKDStatistic(const TreeType& /* node */) :
-    dataset(NULL),
-    begin(0),
-    count(0),
-    leftStat(NULL),
-    rightStat(NULL),
-    parentStat(NULL)
-{ }
-
-/**
- * This constructor is called when a leaf is created.
- *
- * @param dataset Matrix that the tree is being built on.
- * @param begin Starting index corresponding to this leaf.
- * @param count Number of points held in this leaf.
- *
-template<typename MatType>
 MRKDStatistic::MRKDStatistic(const TreeType& node) :
-    dataset(&dataset),
-    begin(begin),
-    count(count),
-    leftStat(NULL),
-    rightStat(NULL),
-    parentStat(NULL)
-{
-  centerOfMass = dataset.col(begin);
-  for (size_t i = begin + 1; i < begin + count; ++i)
-    centerOfMass += dataset.col(i);
-
-  sumOfSquaredNorms = 0.0;
-  for (size_t i = begin; i < begin + count; ++i)
-    sumOfSquaredNorms += arma::norm(dataset.col(i), 2);
-}
-
- **
- * This constructor is called when a non-leaf node is created.
- * This lets you build fast bottom-up statistics when building trees.
- *
- * @param dataset Matrix that the tree is being built on.
- * @param begin Starting index corresponding to this leaf.
- * @param count Number of points held in this leaf.
- * @param leftStat MRKDStatistic object of the left child node.
- * @param rightStat MRKDStatistic object of the right child node.
- *
-template<typename MatType>
-MRKDStatistic::MRKDStatistic(const MatType& dataset,
-                             const size_t begin,
-                             const size_t count,
-                             MRKDStatistic& leftStat,
-                             MRKDStatistic& rightStat) :
-    dataset(&dataset),
-    begin(begin),
-    count(count),
-    leftStat(&leftStat),
-    rightStat(&rightStat),
-    parentStat(NULL)
+    begin((node.NumDescendants() > 0) ? node.Descendant(0) : 0),
+    count(0),
+    centerOfMass(arma::zeros<arma::vec>(node.Dataset().n_rows)),
+    scatter(arma::zeros<arma::mat>(node.Dataset().n_rows,
+        node.Dataset().n_rows)),
+    sumOfSquaredNorms(0.0),
+    dominatingCentroid(0)
 {
-  sumOfSquaredNorms = leftStat.sumOfSquaredNorms + rightStat.sumOfSquaredNorms;
-
-  *
-  centerOfMass = ((leftStat.centerOfMass * leftStat.count) +
-                  (rightStat.centerOfMass * rightStat.count)) /
-                  (leftStat.count + rightStat.count);
-  *
-  centerOfMass = leftStat.centerOfMass + rightStat.centerOfMass;
-
-  isWhitelistValid = false;
-
-  leftStat.parentStat = this;
-  rightStat.parentStat = this;
+  // The children have already been built, so their statistics can be combined
+  // instead of visiting every descendant point again.
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    const MRKDStatistic& childStat = node.Child(i).Stat();
+    Merge(childStat.count, childStat.centerOfMass, childStat.scatter);
+    sumOfSquaredNorms += childStat.sumOfSquaredNorms;
+  }
+
+  const arma::mat noScatter = arma::zeros<arma::mat>(scatter.n_rows,
+      scatter.n_cols);
+  for (size_t i = 0; i < node.NumPoints(); ++i)
+  {
+    const arma::vec point = node.Dataset().col(node.Point(i));
+    Merge(1, point, noScatter);
+    sumOfSquaredNorms += arma::dot(point, point);
+  }
 }
-*/
 
 }; // namespace tree
 }; // namespace mlpack
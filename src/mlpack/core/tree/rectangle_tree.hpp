@@ -23,5 +23,6 @@
 #include "rectangle_tree/r_star_tree_descent_heuristic.hpp"
 #include "rectangle_tree/traits.hpp"
 #include "rectangle_tree/x_tree_split.hpp"
+#include "rectangle_tree/hilbert_r_tree_split.hpp"
 
 #endif
@@ -1 +1,95 @@
- 
+/**
+ * @file hilbert_r_tree_split.hpp
+ *
+ * Definition of the HilbertRTreeSplit class, a class that splits the nodes of
+ * an R tree along the Hilbert curve, starting at a leaf node and moving upwards
+ * if necessary.
+ */
+#ifndef __MLPACK_CORE_TREE_RECTANGLE_TREE_HILBERT_R_TREE_SPLIT_HPP
+#define __MLPACK_CORE_TREE_RECTANGLE_TREE_HILBERT_R_TREE_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/hilbert_curve.hpp>
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * A Rectangle Tree has new points inserted at the bottom.  When these nodes
+ * overflow, this class splits them, moving up the tree and splitting nodes as
+ * necessary.  The entries of an overflowing node (the points of a leaf, or the
+ * centroids of the children of a non-leaf node) are ordered along the Hilbert
+ * curve through the bound of the root, and the first half of them goes to one
+ * new node and the rest to the other, so each node holds a contiguous stretch
+ * of the curve.
+ *
+ * The position of each entry on the curve is given by an integer key, which is
+ * computed once for each entry of the node being split (with HilbertKey()), so
+ * the sort only compares integers.
+ */
+template<typename DescentType,
+         typename StatisticType,
+         typename MatType>
+class HilbertRTreeSplit
+{
+ public:
+  // Convenience typedef to keep lines from being 1000 characters long.
+  typedef RectangleTree<HilbertRTreeSplit, DescentType, StatisticType, MatType>
+      TreeType;
+
+  //! The number of bits of each dimension of the keys.
+  static const size_t Order = 16;
+
+  /**
+   * Split a leaf node along the Hilbert curve.  If necessary, this split will
+   * propagate upwards through the tree.
+   */
+  static void SplitLeafNode(TreeType* tree,
+                            std::vector<bool>& relevels);
+
+  /**
+   * Split a non-leaf node along the Hilbert curve.  If this is a root node,
+   * the tree increases in depth.
+   */
+  static bool SplitNonLeafNode(TreeType* tree,
+                               std::vector<bool>& relevels);
+
+  /**
+   * Compute the key of the given point on the Hilbert curve through the given
+   * bound, with Order bits for each dimension (see tree::HilbertKey()).
+   *
+   * @param point Point to compute the key of.
+   * @param bound Bound the curve runs through.
+   * @param key Vector to store the key in.
+   */
+  template<typename VecType>
+  static void HilbertKey(const VecType& point,
+                         const HRectBound<>& bound,
+                         std::vector<uint64_t>& key)
+  {
+    tree::HilbertKey(point, bound, Order, key);
+  }
+
+ private:
+  /**
+   * Get the bound of the root of the tree, which the curve runs through.
+   */
+  static const HRectBound<>& RootBound(const TreeType* tree);
+
+  /**
+   * Replace the given node in its parent with the two new nodes, and split the
+   * parent if it overflows.
+   */
+  static void ReplaceNode(TreeType* tree,
+                          TreeType* treeOne,
+                          TreeType* treeTwo,
+                          std::vector<bool>& relevels);
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation
+#include "hilbert_r_tree_split_impl.hpp"
+
+#endif
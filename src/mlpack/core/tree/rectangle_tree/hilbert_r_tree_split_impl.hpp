@@ -1 +1,176 @@
- 
+/**
+ * @file hilbert_r_tree_split_impl.hpp
+ *
+ * Implementation of class (HilbertRTreeSplit) to split a RectangleTree along
+ * the Hilbert curve.
+ */
+#ifndef __MLPACK_CORE_TREE_RECTANGLE_TREE_HILBERT_R_TREE_SPLIT_IMPL_HPP
+#define __MLPACK_CORE_TREE_RECTANGLE_TREE_HILBERT_R_TREE_SPLIT_IMPL_HPP
+
+#include "hilbert_r_tree_split.hpp"
+#include "rectangle_tree.hpp"
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * We compute the key of each point of the leaf, sort the points by key, and
+ * give the first half of them to one new node and the rest to the other.  Then
+ * we replace the old node with the new nodes, spliting the parent if necessary.
+ */
+template<typename DescentType,
+         typename StatisticType,
+         typename MatType>
+void HilbertRTreeSplit<DescentType, StatisticType, MatType>::SplitLeafNode(
+    TreeType* tree,
+    std::vector<bool>& relevels)
+{
+  // If we are splitting the root node, we need will do things differently so
+  // that the constructor and other methods don't confuse the end user by giving
+  // an address of another node.
+  if (tree->Parent() == NULL)
+  {
+    // We actually want to copy this way.  Pointers and everything.
+    TreeType* copy = new TreeType(*tree, false);
+    copy->Parent() = tree;
+    tree->Count() = 0;
+    // Because this was a leaf node, numChildren must be 0.
+    tree->Children()[(tree->NumChildren())++] = copy;
+    SplitLeafNode(copy, relevels);
+    return;
+  }
+
+  // Each key is computed once; the sort only compares the keys.
+  const HRectBound<>& bound = RootBound(tree);
+  std::vector<std::vector<uint64_t> > keys(tree->Count());
+  std::vector<size_t> order(tree->Count());
+  for (size_t i = 0; i < tree->Count(); i++)
+  {
+    HilbertKey(tree->Dataset().col(tree->Points()[i]), bound, keys[i]);
+    order[i] = i;
+  }
+
+  std::sort(order.begin(), order.end(), HilbertKeyComparator(keys));
+
+  TreeType* treeOne = new TreeType(tree->Parent());
+  TreeType* treeTwo = new TreeType(tree->Parent());
+
+  const size_t cutOff = tree->Count() / 2;
+  for (size_t i = 0; i < tree->Count(); i++)
+  {
+    if (i < cutOff)
+      treeOne->InsertPoint(tree->Points()[order[i]]);
+    else
+      treeTwo->InsertPoint(tree->Points()[order[i]]);
+  }
+
+  ReplaceNode(tree, treeOne, treeTwo, relevels);
+
+  // We need to delete this carefully since references to points are used.
+  tree->SoftDelete();
+}
+
+/**
+ * We compute the key of the centroid of each child, sort the children by key,
+ * and give the first half of them to one new node and the rest to the other.
+ * Then we replace the old node with the new nodes, and recurse up the tree if
+ * necessary.
+ */
+template<typename DescentType,
+         typename StatisticType,
+         typename MatType>
+bool HilbertRTreeSplit<DescentType, StatisticType, MatType>::SplitNonLeafNode(
+    TreeType* tree,
+    std::vector<bool>& relevels)
+{
+  // If we are splitting the root node, we need will do things differently so
+  // that the constructor and other methods don't confuse the end user by giving
+  // an address of another node.
+  if (tree->Parent() == NULL)
+  {
+    // We actually want to copy this way.  Pointers and everything.
+    TreeType* copy = new TreeType(*tree, false);
+    copy->Parent() = tree;
+    tree->NumChildren() = 0;
+    tree->Children()[(tree->NumChildren())++] = copy;
+    SplitNonLeafNode(copy, relevels);
+    return true;
+  }
+
+  const HRectBound<>& bound = RootBound(tree);
+  std::vector<std::vector<uint64_t> > keys(tree->NumChildren());
+  std::vector<size_t> order(tree->NumChildren());
+  arma::vec centroid;
+  for (size_t i = 0; i < tree->NumChildren(); i++)
+  {
+    tree->Children()[i]->Bound().Centroid(centroid);
+    HilbertKey(centroid, bound, keys[i]);
+    order[i] = i;
+  }
+
+  std::sort(order.begin(), order.end(), HilbertKeyComparator(keys));
+
+  TreeType* treeOne = new TreeType(tree->Parent());
+  TreeType* treeTwo = new TreeType(tree->Parent());
+
+  const size_t cutOff = tree->NumChildren() / 2;
+  for (size_t i = 0; i < tree->NumChildren(); i++)
+  {
+    TreeType* child = tree->Children()[order[i]];
+    TreeType* destTree = (i < cutOff) ? treeOne : treeTwo;
+
+    destTree->Bound() |= child->Bound();
+    destTree->Children()[destTree->NumChildren()++] = child;
+    child->Parent() = destTree;
+  }
+
+  ReplaceNode(tree, treeOne, treeTwo, relevels);
+
+  // Because we now have pointers to the information stored under this tree,
+  // we need to delete this node carefully.
+  tree->SoftDelete();
+
+  return false;
+}
+
+template<typename DescentType,
+         typename StatisticType,
+         typename MatType>
+const HRectBound<>&
+HilbertRTreeSplit<DescentType, StatisticType, MatType>::RootBound(
+    const TreeType* tree)
+{
+  while (tree->Parent() != NULL)
+    tree = tree->Parent();
+
+  return tree->Bound();
+}
+
+template<typename DescentType,
+         typename StatisticType,
+         typename MatType>
+void HilbertRTreeSplit<DescentType, StatisticType, MatType>::ReplaceNode(
+    TreeType* tree,
+    TreeType* treeOne,
+    TreeType* treeTwo,
+    std::vector<bool>& relevels)
+{
+  TreeType* par = tree->Parent();
+  size_t index = 0;
+  while (par->Children()[index] != tree) { ++index; }
+
+  par->Children()[index] = treeOne;
+  par->Children()[par->NumChildren()++] = treeTwo;
+
+  // We only add one at a time, so we should only need to test for equality
+  // just in case, we use an assert.
+  assert(par->NumChildren() <= par->MaxNumChildren() + 1);
+  if (par->NumChildren() == par->MaxNumChildren() + 1)
+    SplitNonLeafNode(par, relevels);
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
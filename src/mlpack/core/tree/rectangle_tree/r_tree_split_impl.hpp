@@ -36,7 +36,6 @@ void RTreeSplit<DescentType, StatisticType, MatType>::SplitLeafNode(
     TreeType* copy = new TreeType(*tree, false);
     copy->Parent() = tree;
     tree->Count() = 0;
-    tree->NullifyData();
     // Because this was a leaf node, numChildren must be 0.
     tree->Children()[(tree->NumChildren())++] = copy;
     SplitLeafNode(copy, relevels);
@@ -104,7 +103,6 @@ bool RTreeSplit<DescentType, StatisticType, MatType>::SplitNonLeafNode(
     TreeType* copy = new TreeType(*tree, false);
     copy->Parent() = tree;
     tree->NumChildren() = 0;
-    tree->NullifyData();
     tree->Children()[(tree->NumChildren())++] = copy;
     SplitNonLeafNode(copy, relevels);
     return true;
@@ -180,8 +178,9 @@ void RTreeSplit<DescentType, StatisticType, MatType>::GetPointSeeds(
   {
     for (size_t j = i + 1; j < tree.Count(); j++)
     {
-      const double score = arma::prod(arma::abs(tree.LocalDataset().col(i) -
-          tree.LocalDataset().col(j)));
+      const double score = arma::prod(arma::abs(
+          tree.Dataset().col(tree.Points()[i]) -
+          tree.Dataset().col(tree.Points()[j])));
 
       if (score > worstPairScore)
       {
@@ -257,16 +256,12 @@ void RTreeSplit<DescentType, StatisticType, MatType>::AssignPointDestNode(
   if (intI > intJ)
   {
     oldTree->Points()[intI] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(intI) = oldTree->LocalDataset().col(end);
     oldTree->Points()[intJ] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(intJ) = oldTree->LocalDataset().col(end);
   }
   else
   {
     oldTree->Points()[intJ] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(intJ) = oldTree->LocalDataset().col(end);
     oldTree->Points()[intI] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(intI) = oldTree->LocalDataset().col(end);
   }
 
   size_t numAssignedOne = 1;
@@ -308,7 +303,7 @@ void RTreeSplit<DescentType, StatisticType, MatType>::AssignPointDestNode(
       double newVolTwo = 1.0;
       for (size_t i = 0; i < oldTree->Bound().Dim(); i++)
       {
-        double c = oldTree->LocalDataset().col(index)[i];
+        double c = oldTree->Dataset().col(oldTree->Points()[index])[i];
         newVolOne *= treeOne->Bound()[i].Contains(c) ?
             treeOne->Bound()[i].Width() : (c < treeOne->Bound()[i].Lo() ?
             (treeOne->Bound()[i].Hi() - c) : (c - treeOne->Bound()[i].Lo()));
@@ -352,7 +347,6 @@ void RTreeSplit<DescentType, StatisticType, MatType>::AssignPointDestNode(
     }
 
     oldTree->Points()[bestIndex] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(bestIndex) = oldTree->LocalDataset().col(end);
   }
 
   // See if we need to satisfy the minimum fill.
@@ -93,10 +93,9 @@ class RectangleTree
   double furthestDescendantDistance;
   //! The dataset.
   MatType& dataset;
-  //! The mapping to the dataset
+  //! The indices of the points held by this node (if it is a leaf); the points
+  //! themselves are only stored in the dataset.
   std::vector<size_t> points;
-  //! The local dataset
-  MatType* localDataset;
 
  public:
   //! So other classes can use TreeType::Mat.
@@ -123,13 +122,18 @@ class RectangleTree
    *      have.
    * @param firstDataIndex The index of the first data point.  UNUSED UNLESS WE
    *      ADD SUPPORT FOR HAVING A "CENTERAL" DATA MATRIX.
+   * @param bulkLoad If true, build the tree bottom-up with Sort-Tile-Recursive
+   *      packing instead of inserting the points one at a time.  This is much
+   *      faster for large datasets and gives nearly full, well-separated nodes,
+   *      but the split policy is not used until points are inserted later.
    */
   RectangleTree(MatType& data,
                 const size_t maxLeafSize = 20,
                 const size_t minLeafSize = 8,
                 const size_t maxNumChildren = 5,
                 const size_t minNumChildren = 2,
-                const size_t firstDataIndex = 0);
+                const size_t firstDataIndex = 0,
+                const bool bulkLoad = false);
 
   /**
    * Construct this as an empty node with the specified parent.  Copying the
@@ -166,31 +170,36 @@ class RectangleTree
   void SoftDelete();
 
   /**
-   * Set dataset to null. Used for memory management.  Be cafeful.
-   */
-  void NullifyData();
-
-  /**
-   * Inserts a point into the tree. The point will be copied to the data matrix
-   * of the leaf node where it is finally inserted, but we pass by reference
-   * since it may be passed many times before it actually reaches a leaf.
+   * Inserts a point into the tree.  The index of the point is stored in the
+   * leaf node where it is finally inserted; the point itself is not copied.
    *
-   * @param point The point (arma::vec&) to be inserted.
+   * @param point Index of the point in the dataset.
    */
   void InsertPoint(const size_t point);
 
   /**
    * Inserts a point into the tree, tracking which levels have been inserted
-   * into.  The point will be copied to the data matrix of the leaf node where
-   * it is finally inserted, but we pass by reference since it may be passed
-   * many times before it actually reaches a leaf.
+   * into.  The index of the point is stored in the leaf node where it is
+   * finally inserted; the point itself is not copied.
    *
-   * @param point The point (arma::vec&) to be inserted.
+   * @param point Index of the point in the dataset.
    * @param relevels The levels that have been reinserted to on this top level
    *      insertion.
    */
   void InsertPoint(const size_t point, std::vector<bool>& relevels);
 
+  /**
+   * Insert many points (given as indices into the dataset) into the tree.  The
+   * points are first sorted with Sort-Tile-Recursive so that consecutive
+   * insertions descend to nearby leaves.  If the batch is at least as large as
+   * the tree, the whole tree is rebuilt with bulk loading instead, which is
+   * far faster than inserting the points one by one.  This must be called on
+   * the root of the tree.
+   *
+   * @param newPoints Indices of the points to insert.
+   */
+  void InsertPoints(const std::vector<size_t>& newPoints);
+
   /**
    * Inserts a node into the tree, tracking which levels have been inserted
    * into.  The node will be inserted so that the tree remains valid.
@@ -227,6 +236,17 @@ class RectangleTree
    */
   bool DeletePoint(const size_t point, std::vector<bool>& relevels);
 
+  /**
+   * Delete many points (given as indices into the dataset) from the tree.  If
+   * at least half of the points in the tree are deleted, the tree is rebuilt
+   * from the remaining points with bulk loading instead of condensing it once
+   * for every point.  This must be called on the root of the tree.
+   *
+   * @param oldPoints Indices of the points to delete.
+   * @return The number of points that were found and deleted.
+   */
+  size_t DeletePoints(const std::vector<size_t>& oldPoints);
+
   /**
    * Removes a node from the tree.  You are responsible for deleting it if you
    * wish to do so.
@@ -312,11 +332,6 @@ class RectangleTree
   //! Modify the points vector for this node.  Be careful!
   std::vector<size_t>& Points() { return points; }
 
-  //! Get the local dataset of this node.
-  const arma::mat& LocalDataset() const { return *localDataset; }
-  //! Modify the local dataset of this node.
-  arma::mat& LocalDataset() { return *localDataset; }
-
   //! Get the metric which the tree uses.
   typename HRectBound<>::MetricType Metric() const { return bound.Metric(); }
 
@@ -509,6 +524,65 @@ class RectangleTree
    */
   void SplitNode(std::vector<bool>& relevels);
 
+  /**
+   * Build the tree below this (empty) node from the given points with
+   * Sort-Tile-Recursive packing: the points are sorted into tiles and packed
+   * into leaves, and the leaves are packed into parents in the same way, level
+   * by level, until they fit under this node.  The order of the indices is
+   * changed.
+   *
+   * @param indices Indices of the points to put in the tree.
+   */
+  void BulkLoad(std::vector<size_t>& indices);
+
+  /**
+   * Throw away every node below this one and bulk load it again from the given
+   * points.
+   *
+   * @param indices Indices of the points to put in the tree.
+   */
+  void Rebuild(std::vector<size_t>& indices);
+
+  //! Append the index of every point held beneath this node to the vector.
+  void CollectPoints(std::vector<size_t>& indices) const;
+
+  //! Compare two columns of a matrix by their value in one dimension.
+  template<typename DataType>
+  struct DimensionComparator
+  {
+    DimensionComparator(const DataType& data, const size_t dim) :
+        data(data), dim(dim) { }
+
+    bool operator()(const size_t a, const size_t b) const
+    {
+      return data(dim, a) < data(dim, b);
+    }
+
+    const DataType& data;
+    const size_t dim;
+  };
+
+  /**
+   * Sort the indices in [begin, end) in Sort-Tile-Recursive order: sort them
+   * by the first dimension, cut them into slabs that each hold a whole number
+   * of groups, and sort each slab the same way by the next dimension.  After
+   * this, every consecutive run of groupSize indices lies in a compact tile.
+   *
+   * @param data Matrix whose columns the indices refer to.
+   * @param indices Indices to sort.
+   * @param begin First index to sort.
+   * @param end One past the last index to sort.
+   * @param dim Dimension to sort by.
+   * @param groupSize Number of indices that will be packed into one node.
+   */
+  template<typename DataType>
+  static void SortTileRecursive(const DataType& data,
+                                std::vector<size_t>& indices,
+                                const size_t begin,
+                                const size_t end,
+                                const size_t dim,
+                                const size_t groupSize);
+
  public:
   /**
    * Condense the bounding rectangles for this node based on the removal of the
@@ -27,7 +27,8 @@ RectangleTree<SplitType, DescentType, StatisticType, MatType>::RectangleTree(
     const size_t minLeafSize,
     const size_t maxNumChildren,
     const size_t minNumChildren,
-    const size_t firstDataIndex) :
+    const size_t firstDataIndex,
+    const bool bulkLoad) :
     maxNumChildren(maxNumChildren),
     minNumChildren(minNumChildren),
     numChildren(0),
@@ -41,11 +42,20 @@ RectangleTree<SplitType, DescentType, StatisticType, MatType>::RectangleTree(
     splitHistory(bound.Dim()),
     parentDistance(0),
     dataset(data),
-    points(maxLeafSize + 1), // Add one to make splitting the node simpler.
-    localDataset(new MatType(data.n_rows, static_cast<int> (maxLeafSize) + 1))
+    points(maxLeafSize + 1) // Add one to make splitting the node simpler.
 {
   stat = StatisticType(*this);
 
+  if (bulkLoad)
+  {
+    std::vector<size_t> indices;
+    for (size_t i = firstDataIndex; i < data.n_cols; i++)
+      indices.push_back(i);
+
+    BulkLoad(indices);
+    return;
+  }
+
   // For now, just insert the points in order.
   RectangleTree* root = this;
 
@@ -72,9 +82,7 @@ RectangleTree<SplitType, DescentType, StatisticType, MatType>::RectangleTree(
     splitHistory(bound.Dim()),
     parentDistance(0),
     dataset(parentNode->Dataset()),
-    points(maxLeafSize + 1), // Add one to make splitting the node simpler.
-    localDataset(new MatType(static_cast<int> (parentNode->Bound().Dim()),
-                             static_cast<int> (maxLeafSize) + 1))
+    points(maxLeafSize + 1) // Add one to make splitting the node simpler.
 {
   stat = StatisticType(*this);
 }
@@ -103,28 +111,16 @@ RectangleTree<SplitType, DescentType, StatisticType, MatType>::RectangleTree(
     splitHistory(other.SplitHistory()),
     parentDistance(other.ParentDistance()),
     dataset(other.dataset),
-    points(other.Points()),
-    localDataset(NULL)
+    points(other.Points())
 {
   if (deepCopy)
   {
-    if (numChildren > 0)
-    {
-      for (size_t i = 0; i < numChildren; i++)
-      {
-        children[i] = new RectangleTree(*(other.Children()[i]));
-      }
-    }
-    else
-    {
-      localDataset = new MatType(other.LocalDataset());
-    }
+    for (size_t i = 0; i < numChildren; i++)
+      children[i] = new RectangleTree(*(other.Children()[i]));
   }
   else
   {
     children = other.Children();
-    arma::mat& otherData = const_cast<arma::mat&>(other.LocalDataset());
-    localDataset = &otherData;
   }
 }
 
@@ -141,8 +137,6 @@ RectangleTree<SplitType, DescentType, StatisticType, MatType>::~RectangleTree()
 {
   for (size_t i = 0; i < numChildren; i++)
     delete children[i];
-
-  delete localDataset;
 }
 
 /**
@@ -164,19 +158,6 @@ void RectangleTree<SplitType, DescentType, StatisticType, MatType>::SoftDelete()
   delete this;
 }
 
-/**
- * Set the local dataset to null.
- */
-template<typename SplitType,
-         typename DescentType,
-         typename StatisticType,
-         typename MatType>
-void RectangleTree<SplitType, DescentType, StatisticType, MatType>::
-    NullifyData()
-{
-  localDataset = NULL;
-}
-
 /**
  * Recurse through the tree and insert the point at the leaf node chosen
  * by the heuristic.
@@ -198,7 +179,6 @@ void RectangleTree<SplitType, DescentType, StatisticType, MatType>::InsertPoint(
   // If this is a leaf node, we stop here and add the point.
   if (numChildren == 0)
   {
-    localDataset->col(count) = dataset.col(point);
     points[count++] = point;
     SplitNode(lvls);
     return;
@@ -213,9 +193,8 @@ void RectangleTree<SplitType, DescentType, StatisticType, MatType>::InsertPoint(
 
 /**
  * Inserts a point into the tree, tracking which levels have been inserted into.
- * The point will be copied to the data matrix of the leaf node where it is
- * finally inserted, but we pass by reference since it may be passed many times
- * before it actually reaches a leaf.
+ * The index of the point is stored in the leaf node where it is finally
+ * inserted.
  */
 template<typename SplitType,
          typename DescentType,
@@ -231,7 +210,6 @@ void RectangleTree<SplitType, DescentType, StatisticType, MatType>::InsertPoint(
   // If this is a leaf node, we stop here and add the point.
   if (numChildren == 0)
   {
-    localDataset->col(count) = dataset.col(point);
     points[count++] = point;
     SplitNode(relevels);
     return;
@@ -244,6 +222,39 @@ void RectangleTree<SplitType, DescentType, StatisticType, MatType>::InsertPoint(
   children[descentNode]->InsertPoint(point, relevels);
 }
 
+/**
+ * Insert a batch of points.  Large batches rebuild the tree; smaller ones are
+ * inserted in Sort-Tile-Recursive order, so that points inserted one after the
+ * other usually go to the same leaf.
+ */
+template<typename SplitType,
+         typename DescentType,
+         typename StatisticType,
+         typename MatType>
+void RectangleTree<SplitType, DescentType, StatisticType, MatType>::
+    InsertPoints(const std::vector<size_t>& newPoints)
+{
+  if (parent != NULL)
+    Log::Fatal << "RectangleTree::InsertPoints() must be called on the root of "
+        << "the tree!" << std::endl;
+
+  if (newPoints.size() >= NumDescendants())
+  {
+    std::vector<size_t> indices;
+    CollectPoints(indices);
+    indices.insert(indices.end(), newPoints.begin(), newPoints.end());
+    Rebuild(indices);
+    return;
+  }
+
+  std::vector<size_t> sortedPoints(newPoints);
+  SortTileRecursive(dataset, sortedPoints, 0, sortedPoints.size(), 0,
+      maxLeafSize);
+
+  for (size_t i = 0; i < sortedPoints.size(); i++)
+    InsertPoint(sortedPoints[i]);
+}
+
 /**
  * Inserts a node into the tree, tracking which levels have been inserted into.
  *
@@ -303,8 +314,7 @@ bool RectangleTree<SplitType, DescentType, StatisticType, MatType>::DeletePoint(
     {
       if (points[i] == point)
       {
-        localDataset->col(i) = localDataset->col(--count); // Decrement count.
-        points[i] = points[count];
+        points[i] = points[--count]; // Decrement count.
         // This function wil ensure that minFill is satisfied.
         CondenseTree(dataset.col(point), lvls, true);
         return true;
@@ -338,8 +348,7 @@ bool RectangleTree<SplitType, DescentType, StatisticType, MatType>::DeletePoint(
     {
       if (points[i] == point)
       {
-        localDataset->col(i) = localDataset->col(--count);
-        points[i] = points[count];
+        points[i] = points[--count]; // Decrement count.
         // This function will ensure that minFill is satisfied.
         CondenseTree(dataset.col(point), relevels, true);
         return true;
@@ -355,6 +364,48 @@ bool RectangleTree<SplitType, DescentType, StatisticType, MatType>::DeletePoint(
   return false;
 }
 
+/**
+ * Delete a batch of points.  If most of the tree is going away, it is cheaper
+ * to rebuild it from what is left than to condense it after every point.
+ */
+template<typename SplitType,
+         typename DescentType,
+         typename StatisticType,
+         typename MatType>
+size_t RectangleTree<SplitType, DescentType, StatisticType, MatType>::
+    DeletePoints(const std::vector<size_t>& oldPoints)
+{
+  if (parent != NULL)
+    Log::Fatal << "RectangleTree::DeletePoints() must be called on the root of "
+        << "the tree!" << std::endl;
+
+  if (2 * oldPoints.size() >= NumDescendants())
+  {
+    std::vector<size_t> indices;
+    CollectPoints(indices);
+
+    std::vector<size_t> sortedPoints(oldPoints);
+    std::sort(sortedPoints.begin(), sortedPoints.end());
+
+    std::vector<size_t> remaining;
+    for (size_t i = 0; i < indices.size(); i++)
+      if (!std::binary_search(sortedPoints.begin(), sortedPoints.end(),
+          indices[i]))
+        remaining.push_back(indices[i]);
+
+    const size_t numDeleted = indices.size() - remaining.size();
+    Rebuild(remaining);
+    return numDeleted;
+  }
+
+  size_t numDeleted = 0;
+  for (size_t i = 0; i < oldPoints.size(); i++)
+    if (DeletePoint(oldPoints[i]))
+      ++numDeleted;
+
+  return numDeleted;
+}
+
 /**
  * Recurse through the tree to remove the node.  Once we find the node, we
  * shrink the rectangles if necessary.
@@ -568,6 +619,188 @@ void RectangleTree<SplitType, DescentType, StatisticType, MatType>::SplitNode(
   }
 }
 
+/**
+ * Pack the points into leaves and the leaves into parents, bottom-up, so that
+ * every leaf ends up at the same depth.  The items at each level are split as
+ * evenly as possible between the fewest nodes that can hold them, so each node
+ * is at least half full; this satisfies the minimum fill as long as it is no
+ * more than half of the maximum, which the split policies also assume.
+ */
+template<typename SplitType,
+         typename DescentType,
+         typename StatisticType,
+         typename MatType>
+void RectangleTree<SplitType, DescentType, StatisticType, MatType>::BulkLoad(
+    std::vector<size_t>& indices)
+{
+  // If everything fits in one leaf, this node is that leaf.
+  if (indices.size() <= maxLeafSize)
+  {
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+      points[count++] = indices[i];
+      bound |= dataset.col(indices[i]);
+    }
+
+    stat = StatisticType(*this);
+    return;
+  }
+
+  // Pack the points into leaves.
+  const size_t numLeaves = (indices.size() + maxLeafSize - 1) / maxLeafSize;
+  SortTileRecursive(dataset, indices, 0, indices.size(), 0,
+      (indices.size() + numLeaves - 1) / numLeaves);
+
+  std::vector<RectangleTree*> nodes(numLeaves);
+  size_t start = 0;
+  for (size_t i = 0; i < numLeaves; i++)
+  {
+    const size_t end = start + indices.size() / numLeaves +
+        ((i < indices.size() % numLeaves) ? 1 : 0);
+
+    RectangleTree* leaf = new RectangleTree(this);
+    for (size_t j = start; j < end; j++)
+    {
+      leaf->points[leaf->count++] = indices[j];
+      leaf->bound |= dataset.col(indices[j]);
+    }
+
+    leaf->stat = StatisticType(*leaf);
+    nodes[i] = leaf;
+    start = end;
+  }
+
+  // Pack each level into parents, using the centroids of the nodes to sort
+  // them, until there are few enough nodes to be the children of this one.
+  while (nodes.size() > maxNumChildren)
+  {
+    arma::mat centroids(dataset.n_rows, nodes.size());
+    std::vector<size_t> order(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+      arma::vec centroid;
+      nodes[i]->Bound().Centroid(centroid);
+      centroids.col(i) = centroid;
+      order[i] = i;
+    }
+
+    const size_t numParents = (nodes.size() + maxNumChildren - 1) /
+        maxNumChildren;
+    SortTileRecursive(centroids, order, 0, order.size(), 0,
+        (nodes.size() + numParents - 1) / numParents);
+
+    std::vector<RectangleTree*> parents(numParents);
+    start = 0;
+    for (size_t i = 0; i < numParents; i++)
+    {
+      const size_t end = start + nodes.size() / numParents +
+          ((i < nodes.size() % numParents) ? 1 : 0);
+
+      RectangleTree* node = new RectangleTree(this);
+      for (size_t j = start; j < end; j++)
+      {
+        RectangleTree* child = nodes[order[j]];
+        node->children[node->numChildren++] = child;
+        child->parent = node;
+        node->bound |= child->bound;
+      }
+
+      node->stat = StatisticType(*node);
+      parents[i] = node;
+      start = end;
+    }
+
+    nodes.swap(parents);
+  }
+
+  for (size_t i = 0; i < nodes.size(); i++)
+  {
+    children[numChildren++] = nodes[i];
+    nodes[i]->parent = this;
+    bound |= nodes[i]->bound;
+  }
+
+  stat = StatisticType(*this);
+}
+
+/**
+ * Empty this node and bulk load it again.
+ */
+template<typename SplitType,
+         typename DescentType,
+         typename StatisticType,
+         typename MatType>
+void RectangleTree<SplitType, DescentType, StatisticType, MatType>::Rebuild(
+    std::vector<size_t>& indices)
+{
+  for (size_t i = 0; i < numChildren; i++)
+    delete children[i];
+
+  numChildren = 0;
+  count = 0;
+  bound = HRectBound<>(dataset.n_rows);
+
+  BulkLoad(indices);
+}
+
+/**
+ * Gather the indices of all of the points held in the leaves below this node.
+ */
+template<typename SplitType,
+         typename DescentType,
+         typename StatisticType,
+         typename MatType>
+void RectangleTree<SplitType, DescentType, StatisticType, MatType>::
+    CollectPoints(std::vector<size_t>& indices) const
+{
+  if (numChildren == 0)
+  {
+    indices.insert(indices.end(), points.begin(), points.begin() + count);
+    return;
+  }
+
+  for (size_t i = 0; i < numChildren; i++)
+    children[i]->CollectPoints(indices);
+}
+
+/**
+ * Sort the indices into tiles.  The number of slabs in each dimension is the
+ * (d - dim)'th root of the number of groups left to make, so the tiles come out
+ * roughly square.
+ */
+template<typename SplitType,
+         typename DescentType,
+         typename StatisticType,
+         typename MatType>
+template<typename DataType>
+void RectangleTree<SplitType, DescentType, StatisticType, MatType>::
+    SortTileRecursive(const DataType& data,
+                      std::vector<size_t>& indices,
+                      const size_t begin,
+                      const size_t end,
+                      const size_t dim,
+                      const size_t groupSize)
+{
+  const size_t n = end - begin;
+  if (n <= groupSize || dim >= data.n_rows)
+    return;
+
+  std::sort(indices.begin() + begin, indices.begin() + end,
+      DimensionComparator<DataType>(data, dim));
+
+  if (dim + 1 == data.n_rows)
+    return;
+
+  const size_t numGroups = (n + groupSize - 1) / groupSize;
+  const size_t numSlabs = (size_t) std::ceil(std::pow((double) numGroups,
+      1.0 / (double) (data.n_rows - dim)));
+  const size_t slabSize = groupSize * ((numGroups + numSlabs - 1) / numSlabs);
+
+  for (size_t slab = begin; slab < end; slab += slabSize)
+    SortTileRecursive(data, indices, slab, std::min(slab + slabSize, end),
+        dim + 1, groupSize);
+}
+
 /**
  * Condense the tree.  This shrinks the bounds and moves up the tree if
  * applicable.  If a node goes below minimum fill, this code will deal with it.
@@ -672,12 +905,9 @@ void RectangleTree<SplitType, DescentType, StatisticType, MatType>::
 
       numChildren = child->NumChildren();
 
+      // In case the tree has a height of two.
       for (size_t i = 0; i < child->Count(); i++)
-      {
-        // In case the tree has a height of two.
         points[i] = child->Points()[i];
-        localDataset->col(i) = child->LocalDataset().col(i);
-      }
 
       count = child->Count();
       maxNumChildren = child->MaxNumChildren(); // Required for the X tree.
@@ -713,8 +943,8 @@ bool RectangleTree<SplitType, DescentType, StatisticType, MatType>::
         double min = DBL_MAX;
         for (size_t j = 0; j < count; j++)
         {
-          if (localDataset->col(j)[i] < min)
-            min = localDataset->col(j)[i];
+          if (dataset(i, points[j]) < min)
+            min = dataset(i, points[j]);
         }
 
         if (bound[i].Lo() < min)
@@ -732,8 +962,8 @@ bool RectangleTree<SplitType, DescentType, StatisticType, MatType>::
         double max = -1 * DBL_MAX;
         for (size_t j = 0; j < count; j++)
         {
-          if (localDataset->col(j)[i] > max)
-            max = localDataset->col(j)[i];
+          if (dataset(i, points[j]) > max)
+            max = dataset(i, points[j]);
         }
 
         if (bound[i].Hi() > max)
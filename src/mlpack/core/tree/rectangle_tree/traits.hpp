@@ -44,6 +44,11 @@ class TreeTraits<RectangleTree<StatisticType, MatType> >
    * AND REARRANGE THE MATRIX
    */
   static const bool RearrangesDataset = true;
+
+  /**
+   * Each point is held by exactly one leaf.
+   */
+  static const bool HasDuplicatedPoints = false;
 };
 
 }; // namespace tree
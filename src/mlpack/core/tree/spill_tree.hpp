@@ -0,0 +1,17 @@
+/**
+ * @file spill_tree.hpp
+ *
+ * Include all the necessary files to use the SpillTree class.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_HPP
+
+#include "bounds.hpp"
+#include "spill_tree/spill_tree.hpp"
+#include "spill_tree/defeatist_single_tree_traverser.hpp"
+#include "spill_tree/defeatist_single_tree_traverser_impl.hpp"
+#include "spill_tree/defeatist_dual_tree_traverser.hpp"
+#include "spill_tree/defeatist_dual_tree_traverser_impl.hpp"
+#include "spill_tree/traits.hpp"
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file defeatist_dual_tree_traverser.hpp
+ *
+ * A nested class of SpillTree which searches the tree defeatistly for each
+ * point of a query tree.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_DEFEATIST_DUAL_TREE_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_DEFEATIST_DUAL_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+
+#include "spill_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The defeatist dual-tree traverser runs the defeatist single-tree traversal
+ * (see SpillTree::SingleTreeTraverser) for each point of the query node, once
+ * for each point even if the query tree holds it in several leaves.  There is
+ * no pruning to share between the query points, so the query tree only serves
+ * to enumerate them.
+ */
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+class SpillTree<BoundType, StatisticType, MatType>::DualTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the dual-tree traverser with the given rule set.
+   */
+  DualTreeTraverser(RuleType& rule);
+
+  /**
+   * Traverse the reference tree with each point of the query node.
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   */
+  void Traverse(SpillTree& queryNode, SpillTree& referenceNode);
+
+  //! Get the number of prunes (always 0; nothing is scored).
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+ private:
+  //! Reference to the rules with which the trees will be traversed.
+  RuleType& rule;
+
+  //! The number of nodes which have been pruned during traversal.
+  size_t numPrunes;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "defeatist_dual_tree_traverser_impl.hpp"
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * @file defeatist_dual_tree_traverser_impl.hpp
+ *
+ * Implementation of the defeatist dual-tree traverser of the SpillTree.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_DEFEATIST_DUAL_TREE_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_DEFEATIST_DUAL_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "defeatist_dual_tree_traverser.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+SpillTree<BoundType, StatisticType, MatType>::
+DualTreeTraverser<RuleType>::DualTreeTraverser(RuleType& rule) :
+    rule(rule),
+    numPrunes(0)
+{ /* Nothing to do. */ }
+
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+void SpillTree<BoundType, StatisticType, MatType>::
+DualTreeTraverser<RuleType>::Traverse(
+    SpillTree<BoundType, StatisticType, MatType>& queryNode,
+    SpillTree<BoundType, StatisticType, MatType>& referenceNode)
+{
+  // Collect the query points; a point may be held by several leaves of the
+  // query tree, but it should only be searched for once.
+  std::vector<size_t> queryPoints(queryNode.NumDescendants());
+  for (size_t i = 0; i < queryPoints.size(); ++i)
+    queryPoints[i] = queryNode.Descendant(i);
+  std::sort(queryPoints.begin(), queryPoints.end());
+  queryPoints.erase(std::unique(queryPoints.begin(), queryPoints.end()),
+      queryPoints.end());
+
+  SingleTreeTraverser<RuleType> traverser(rule);
+  for (size_t i = 0; i < queryPoints.size(); ++i)
+    traverser.Traverse(queryPoints[i], referenceNode);
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file defeatist_single_tree_traverser.hpp
+ *
+ * A nested class of SpillTree which searches the tree defeatistly: each query
+ * point visits the one leaf on its side of every splitting hyperplane, without
+ * backtracking.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_DEFEATIST_SINGLE_TREE_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_DEFEATIST_SINGLE_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+
+#include "spill_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The defeatist single-tree traverser takes each query point from the root of
+ * the spill tree down to the leaf on its side of each splitting hyperplane and
+ * evaluates the base cases of that leaf only.  The rules are never asked to
+ * score a node, so nothing is pruned and the results are approximate.  The
+ * rules must provide QuerySet(), the dataset of the query points.
+ */
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+class SpillTree<BoundType, StatisticType, MatType>::SingleTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the single tree traverser with the given rule set.
+   */
+  SingleTreeTraverser(RuleType& rule);
+
+  /**
+   * Traverse the tree with the given point.
+   *
+   * @param queryIndex The index of the point in the query set which is being
+   *     used as the query point.
+   * @param referenceNode The tree node to be traversed.
+   */
+  void Traverse(const size_t queryIndex, SpillTree& referenceNode);
+
+  //! Get the number of prunes (always 0; nothing is scored).
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+ private:
+  //! Reference to the rules with which the tree will be traversed.
+  RuleType& rule;
+
+  //! The number of nodes which have been pruned during traversal.
+  size_t numPrunes;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "defeatist_single_tree_traverser_impl.hpp"
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * @file defeatist_single_tree_traverser_impl.hpp
+ *
+ * Implementation of the defeatist single-tree traverser of the SpillTree.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_DEFEATIST_SINGLE_TREE_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_DEFEATIST_SINGLE_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "defeatist_single_tree_traverser.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+SpillTree<BoundType, StatisticType, MatType>::
+SingleTreeTraverser<RuleType>::SingleTreeTraverser(RuleType& rule) :
+    rule(rule),
+    numPrunes(0)
+{ /* Nothing to do. */ }
+
+template<typename BoundType, typename StatisticType, typename MatType>
+template<typename RuleType>
+void SpillTree<BoundType, StatisticType, MatType>::
+SingleTreeTraverser<RuleType>::Traverse(
+    const size_t queryIndex,
+    SpillTree<BoundType, StatisticType, MatType>& referenceNode)
+{
+  // Follow the side of each hyperplane the query point is on.
+  SpillTree* node = &referenceNode;
+  while (!node->IsLeaf())
+    node = node->ChildOf(rule.QuerySet().unsafe_col(queryIndex));
+
+  // The points of the leaf are the only candidates.
+  for (size_t i = 0; i < node->NumPoints(); ++i)
+    rule.BaseCase(queryIndex, node->Point(i));
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,346 @@
+/**
+ * @file spill_tree.hpp
+ *
+ * Definition of the SpillTree class, a binary space tree whose children may
+ * share the points near their splitting hyperplane, for fast approximate
+ * nearest neighbor search.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_SPILL_TREE_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_SPILL_TREE_HPP
+
+#include <mlpack/core.hpp>
+
+#include "../statistic.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A spill tree is a kd-tree whose children may overlap: each node is split by
+ * an axis-aligned hyperplane through the median of the widest dimension of the
+ * node, and the points within the overlap buffer around the hyperplane (those
+ * nearer to it than tau times the width of the node in that dimension) go to
+ * both children.  A point can thus be held by several leaves.  For more
+ * information, see
+ *
+ * @code
+ * @inproceedings{liu2004investigation,
+ *   title={An Investigation of Practical Approximate Nearest Neighbor
+ *       Algorithms},
+ *   author={Liu, Ting and Moore, Andrew W. and Gray, Alexander G. and Yang,
+ *       Ke},
+ *   booktitle={Advances in Neural Information Processing Systems 17},
+ *   pages={825--832},
+ *   year={2004}
+ * }
+ * @endcode
+ *
+ * The spill tree is searched with defeatist traversals (its SingleTreeTraverser
+ * and DualTreeTraverser): each query point follows the side of the splitting
+ * hyperplane it lies on from the root down to one leaf, whose points are the
+ * only candidates, so there is no backtracking and a search takes time
+ * proportional to the depth of the tree and the leaf size.  The neighbors found
+ * are approximate; the overlap buffer makes it likely that the true neighbors
+ * of a query point near a hyperplane are in the leaf it reaches.  A larger tau
+ * gives better neighbors but a bigger (and deeper) tree.  If an overlapping
+ * split would leave more than rho of the points of a node in one child, the
+ * node is split without overlap instead; this bounds the depth of the tree.
+ * The leaf size should be at least the number of neighbors that are searched
+ * for, since the candidates come from one leaf.
+ *
+ * The dataset is not rearranged (or copied) and must not be changed while the
+ * tree exists.  The bounds of the nodes contain all of their points, so the
+ * MinDistance() and MaxDistance() functions are valid bounds.
+ *
+ * @tparam BoundType The bound used for each node; this must be an HRectBound
+ *     (or have its interface), since the split uses the range of each
+ *     dimension.
+ * @tparam StatisticType Extra data contained in the node.  See statistic.hpp
+ *     for the necessary skeleton interface.
+ * @tparam MatType The dataset class; a dense matrix type.
+ */
+template<typename BoundType,
+         typename StatisticType = EmptyStatistic,
+         typename MatType = arma::mat>
+class SpillTree
+{
+ private:
+  //! The left child node.
+  SpillTree* left;
+  //! The right child node.
+  SpillTree* right;
+  //! The parent node (NULL if this is the root of the tree).
+  SpillTree* parent;
+  //! The indices of the points held by this node, if it is a leaf.
+  std::vector<size_t> points;
+  //! The number of points held by the leaves below this node (a point held by
+  //! several leaves is counted once for each).
+  size_t numDescendants;
+  //! The max leaf size.
+  size_t maxLeafSize;
+  //! The width of the overlap buffer, as a fraction of the width of a node.
+  double tau;
+  //! The largest fraction of the points of a node that an overlapping child
+  //! may hold.
+  double rho;
+  //! The bound object for this node.
+  BoundType bound;
+  //! Any extra data contained in the node.
+  StatisticType stat;
+  //! The dimension this node split on if it is a parent.
+  size_t splitDimension;
+  //! The value of the splitting hyperplane along the split dimension.
+  double splitValue;
+  //! Whether the children of this node share the points near the hyperplane.
+  bool overlapping;
+  //! The distance from the centroid of this node to the centroid of the parent.
+  double parentDistance;
+  //! The worst possible distance to the furthest descendant, cached to speed
+  //! things up.
+  double furthestDescendantDistance;
+  //! The dataset.
+  const MatType& dataset;
+
+ public:
+  //! So other classes can use TreeType::Mat.
+  typedef MatType Mat;
+
+  //! A defeatist single-tree traverser for spill trees; see
+  //! defeatist_single_tree_traverser.hpp.
+  template<typename RuleType>
+  class SingleTreeTraverser;
+
+  //! A defeatist traverser of a query tree against a spill tree; see
+  //! defeatist_dual_tree_traverser.hpp.
+  template<typename RuleType>
+  class DualTreeTraverser;
+
+  /**
+   * Construct this as the root node of a spill tree on the given dataset.  The
+   * dataset is not modified, and is not copied.
+   *
+   * @param data Dataset to build the tree on.
+   * @param tau Width of the overlap buffer on each side of a splitting
+   *     hyperplane, as a fraction of the width of the node along the split
+   *     dimension (0 gives a tree without overlap).
+   * @param maxLeafSize Size of each leaf in the tree.
+   * @param rho Largest fraction of the points of a node that a child of an
+   *     overlapping split may hold.
+   */
+  SpillTree(const MatType& data,
+            const double tau = 0.05,
+            const size_t maxLeafSize = 20,
+            const double rho = 0.7);
+
+  /**
+   * Create a copy of the given tree, with its own copies of every node (the
+   * dataset is not copied).
+   *
+   * @param other Tree to copy.
+   */
+  SpillTree(const SpillTree& other);
+
+  /**
+   * Delete this node and all of its children.
+   */
+  ~SpillTree();
+
+  //! Return the bound object for this node.
+  const BoundType& Bound() const { return bound; }
+  //! Return the bound object for this node.
+  BoundType& Bound() { return bound; }
+
+  //! Return the statistic object for this node.
+  const StatisticType& Stat() const { return stat; }
+  //! Return the statistic object for this node.
+  StatisticType& Stat() { return stat; }
+
+  //! Return whether or not this node is a leaf (has no children).
+  bool IsLeaf() const { return (left == NULL); }
+
+  //! Return the max leaf size.
+  size_t MaxLeafSize() const { return maxLeafSize; }
+  //! Return the width of the overlap buffer, relative to the node width.
+  double Tau() const { return tau; }
+  //! Return the largest fraction of points an overlapping child may hold.
+  double Rho() const { return rho; }
+
+  //! Gets the left child of this node.
+  SpillTree* Left() const { return left; }
+  //! Gets the right child of this node.
+  SpillTree* Right() const { return right; }
+  //! Gets the parent of this node.
+  SpillTree* Parent() const { return parent; }
+
+  //! Get the split dimension for this node.
+  size_t SplitDimension() const { return splitDimension; }
+  //! Get the value of the splitting hyperplane along the split dimension.
+  double SplitValue() const { return splitValue; }
+  //! Return whether the children of this node share the points near the
+  //! splitting hyperplane.
+  bool Overlapping() const { return overlapping; }
+
+  //! Get the dataset which the tree is built on.
+  const MatType& Dataset() const { return dataset; }
+
+  //! Get the metric which the tree uses.
+  typename BoundType::MetricType Metric() const { return bound.Metric(); }
+
+  //! Get the centroid of the node and store it in the given vector.
+  void Centroid(arma::vec& centroid) { bound.Centroid(centroid); }
+
+  //! Return the number of children in this node.
+  size_t NumChildren() const { return IsLeaf() ? 0 : 2; }
+
+  /**
+   * Return the furthest distance to a point held in this node.  If this is not
+   * a leaf node, then the distance is 0 because the node holds no points.
+   */
+  double FurthestPointDistance() const;
+
+  /**
+   * Return the furthest possible descendant distance: the distance from the
+   * centroid to a corner of the bound.  The actual furthest descendant
+   * distance may be less.
+   */
+  double FurthestDescendantDistance() const
+  { return furthestDescendantDistance; }
+
+  //! Return the minimum distance from the center of the node to any bound edge.
+  double MinimumBoundDistance() const { return bound.MinWidth() / 2.0; }
+
+  //! Return the distance from the center of this node to the center of the
+  //! parent node.
+  double ParentDistance() const { return parentDistance; }
+  //! Modify the distance from the center of this node to the center of the
+  //! parent node.
+  double& ParentDistance() { return parentDistance; }
+
+  /**
+   * Return the specified child (0 will be left, 1 will be right).  If the index
+   * is greater than 1, this will return the right child.
+   *
+   * @param child Index of child to return.
+   */
+  SpillTree& Child(const size_t child) const
+  { return (child == 0) ? *left : *right; }
+
+  //! Return the number of points in this node (0 if not a leaf).
+  size_t NumPoints() const { return points.size(); }
+
+  /**
+   * Return the number of points held by the leaves below this node.  A point
+   * held by several of those leaves is counted for each of them.
+   */
+  size_t NumDescendants() const { return numDescendants; }
+
+  /**
+   * Return the index (with reference to the dataset) of a particular descendant
+   * of this node: the descendants of the left child come first, then those of
+   * the right child.  This takes time proportional to the depth of the tree.
+   *
+   * @param index Index of the descendant.
+   */
+  size_t Descendant(const size_t index) const;
+
+  /**
+   * Return the index (with reference to the dataset) of a particular point in
+   * this node.
+   *
+   * @param index Index of point for which a dataset index is wanted.
+   */
+  size_t Point(const size_t index) const { return points[index]; }
+
+  //! Return the minimum distance to another node.
+  double MinDistance(const SpillTree* other) const
+  {
+    return bound.MinDistance(other->Bound());
+  }
+
+  //! Return the maximum distance to another node.
+  double MaxDistance(const SpillTree* other) const
+  {
+    return bound.MaxDistance(other->Bound());
+  }
+
+  //! Return the minimum and maximum distance to another node.
+  math::Range RangeDistance(const SpillTree* other) const
+  {
+    return bound.RangeDistance(other->Bound());
+  }
+
+  //! Return the minimum distance to another point.
+  template<typename VecType>
+  double MinDistance(const VecType& point,
+                     typename boost::enable_if<IsVector<VecType> >::type* = 0)
+      const
+  {
+    return bound.MinDistance(point);
+  }
+
+  //! Return the maximum distance to another point.
+  template<typename VecType>
+  double MaxDistance(const VecType& point,
+                     typename boost::enable_if<IsVector<VecType> >::type* = 0)
+      const
+  {
+    return bound.MaxDistance(point);
+  }
+
+  //! Return the minimum and maximum distance to another point.
+  template<typename VecType>
+  math::Range
+  RangeDistance(const VecType& point,
+                typename boost::enable_if<IsVector<VecType> >::type* = 0) const
+  {
+    return bound.RangeDistance(point);
+  }
+
+  /**
+   * Return the child whose part of the space the given point lies in: the left
+   * child if the point is before the splitting hyperplane, and the right child
+   * otherwise.  This must not be called on a leaf.
+   *
+   * @param point Point to find the child of.
+   */
+  template<typename VecType>
+  SpillTree* ChildOf(const VecType& point) const
+  {
+    return (point[splitDimension] < splitValue) ? left : right;
+  }
+
+  //! Obtains the number of nodes in the tree, starting with this.
+  size_t TreeSize() const;
+
+  //! Obtains the number of levels below this node in the tree, starting with
+  //! this.
+  size_t TreeDepth() const;
+
+  //! Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  /**
+   * Construct a child of the given node, holding the given points.
+   *
+   * @param parent Parent of the new node.
+   * @param points Indices of the points of the new node (these are consumed).
+   */
+  SpillTree(SpillTree* parent, std::vector<size_t>& points);
+
+  /**
+   * Set the bound of this node from its points, and split it (recursively) if
+   * it holds more than the max leaf size.
+   *
+   * @param points Indices of the points of this node (these are consumed).
+   */
+  void SplitNode(std::vector<size_t>& points);
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "spill_tree_impl.hpp"
+
+#endif
@@ -0,0 +1,310 @@
+/**
+ * @file spill_tree_impl.hpp
+ *
+ * Implementation of the SpillTree class.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_SPILL_TREE_IMPL_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_SPILL_TREE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "spill_tree.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename StatisticType, typename MatType>
+SpillTree<BoundType, StatisticType, MatType>::SpillTree(
+    const MatType& data,
+    const double tau,
+    const size_t maxLeafSize,
+    const double rho) :
+    left(NULL),
+    right(NULL),
+    parent(NULL),
+    numDescendants(0),
+    maxLeafSize(maxLeafSize),
+    tau(tau),
+    rho(rho),
+    bound(data.n_rows),
+    splitDimension(0),
+    splitValue(0.0),
+    overlapping(false),
+    parentDistance(0), // Parent distance for the root is 0: it has no parent.
+    furthestDescendantDistance(0),
+    dataset(data)
+{
+  if (tau < 0.0)
+  {
+    Log::Fatal << "SpillTree::SpillTree(): tau must be non-negative (" << tau
+        << " given)." << std::endl;
+  }
+
+  if (rho <= 0.5 || rho > 1.0)
+  {
+    Log::Fatal << "SpillTree::SpillTree(): rho must be in (0.5, 1] (" << rho
+        << " given)." << std::endl;
+  }
+
+  std::vector<size_t> allPoints(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    allPoints[i] = i;
+
+  // Do the actual splitting of this node.
+  SplitNode(allPoints);
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+SpillTree<BoundType, StatisticType, MatType>::SpillTree(
+    SpillTree* parent,
+    std::vector<size_t>& points) :
+    left(NULL),
+    right(NULL),
+    parent(parent),
+    numDescendants(0),
+    maxLeafSize(parent->maxLeafSize),
+    tau(parent->tau),
+    rho(parent->rho),
+    bound(parent->dataset.n_rows),
+    splitDimension(0),
+    splitValue(0.0),
+    overlapping(false),
+    parentDistance(0),
+    furthestDescendantDistance(0),
+    dataset(parent->dataset)
+{
+  SplitNode(points);
+
+  stat = StatisticType(*this);
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+SpillTree<BoundType, StatisticType, MatType>::SpillTree(
+    const SpillTree& other) :
+    left(NULL),
+    right(NULL),
+    parent(other.parent),
+    points(other.points),
+    numDescendants(other.numDescendants),
+    maxLeafSize(other.maxLeafSize),
+    tau(other.tau),
+    rho(other.rho),
+    bound(other.bound),
+    stat(other.stat),
+    splitDimension(other.splitDimension),
+    splitValue(other.splitValue),
+    overlapping(other.overlapping),
+    parentDistance(other.parentDistance),
+    furthestDescendantDistance(other.furthestDescendantDistance),
+    dataset(other.dataset)
+{
+  // Create left and right children (if any).
+  if (other.Left())
+  {
+    left = new SpillTree(*other.Left());
+    left->parent = this; // Set parent to this, not other tree.
+  }
+
+  if (other.Right())
+  {
+    right = new SpillTree(*other.Right());
+    right->parent = this; // Set parent to this, not other tree.
+  }
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+SpillTree<BoundType, StatisticType, MatType>::~SpillTree()
+{
+  if (left)
+    delete left;
+  if (right)
+    delete right;
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+double SpillTree<BoundType, StatisticType, MatType>::FurthestPointDistance()
+    const
+{
+  if (!IsLeaf())
+    return 0.0;
+
+  // Otherwise return the distance from the centroid to a corner of the bound.
+  return 0.5 * bound.Diameter();
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+size_t SpillTree<BoundType, StatisticType, MatType>::Descendant(
+    const size_t index) const
+{
+  const SpillTree* node = this;
+  size_t i = index;
+  while (!node->IsLeaf())
+  {
+    if (i < node->left->NumDescendants())
+    {
+      node = node->left;
+    }
+    else
+    {
+      i -= node->left->NumDescendants();
+      node = node->right;
+    }
+  }
+
+  return node->points[i];
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+size_t SpillTree<BoundType, StatisticType, MatType>::TreeSize() const
+{
+  if (IsLeaf())
+    return 1;
+
+  return 1 + left->TreeSize() + right->TreeSize();
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+size_t SpillTree<BoundType, StatisticType, MatType>::TreeDepth() const
+{
+  if (IsLeaf())
+    return 1;
+
+  return 1 + std::max(left->TreeDepth(), right->TreeDepth());
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+void SpillTree<BoundType, StatisticType, MatType>::SplitNode(
+    std::vector<size_t>& nodePoints)
+{
+  numDescendants = nodePoints.size();
+
+  // The bound holds every point of the node, including the points it shares
+  // with its sibling.
+  if (nodePoints.size() > 0)
+  {
+    const MatType nodeData = dataset.cols(arma::conv_to<arma::uvec>::from(
+        nodePoints));
+    bound |= nodeData;
+  }
+
+  // Calculate the furthest descendant distance.
+  furthestDescendantDistance = 0.5 * bound.Diameter();
+
+  // Now, check if we need to split at all.
+  if (nodePoints.size() <= maxLeafSize)
+  {
+    points.swap(nodePoints);
+    return;
+  }
+
+  // Split along the widest dimension; if every dimension has width zero, all
+  // the points are the same and can't be split.
+  double maxWidth = 0.0;
+  for (size_t d = 0; d < bound.Dim(); ++d)
+  {
+    if (bound[d].Width() > maxWidth)
+    {
+      maxWidth = bound[d].Width();
+      splitDimension = d;
+    }
+  }
+
+  if (maxWidth == 0.0)
+  {
+    points.swap(nodePoints);
+    return;
+  }
+
+  // The hyperplane goes through the median, so that the tree is balanced; if
+  // so many points are at the median that one side would be empty, it goes
+  // through the middle of the bound instead.
+  const size_t n = nodePoints.size();
+  std::vector<double> values(n);
+  for (size_t i = 0; i < n; ++i)
+    values[i] = dataset(splitDimension, nodePoints[i]);
+  std::nth_element(values.begin(), values.begin() + n / 2, values.end());
+  splitValue = values[n / 2];
+
+  size_t leftCount = 0;
+  for (size_t i = 0; i < n; ++i)
+    if (dataset(splitDimension, nodePoints[i]) < splitValue)
+      ++leftCount;
+  if (leftCount == 0 || leftCount == n)
+    splitValue = bound[splitDimension].Mid();
+
+  // Points within the overlap buffer go to both children, unless that leaves
+  // too many points (or all of them) in one of them.
+  double overlap = tau * maxWidth;
+  std::vector<size_t> leftPoints, rightPoints;
+  for (size_t attempt = 0; attempt < 2; ++attempt)
+  {
+    leftPoints.clear();
+    rightPoints.clear();
+    for (size_t i = 0; i < n; ++i)
+    {
+      const double value = dataset(splitDimension, nodePoints[i]);
+      if (value < splitValue + overlap)
+        leftPoints.push_back(nodePoints[i]);
+      if (value >= splitValue - overlap)
+        rightPoints.push_back(nodePoints[i]);
+    }
+
+    overlapping = (overlap > 0.0);
+    if (!overlapping || (leftPoints.size() <= rho * n &&
+        rightPoints.size() <= rho * n && leftPoints.size() < n &&
+        rightPoints.size() < n))
+      break;
+
+    overlap = 0.0;
+  }
+
+  // The points of this node are held by its children now.
+  std::vector<size_t>().swap(nodePoints);
+
+  left = new SpillTree(this, leftPoints);
+  right = new SpillTree(this, rightPoints);
+
+  // Calculate parent distances for those two nodes.
+  arma::vec centroid, leftCentroid, rightCentroid;
+  bound.Centroid(centroid);
+  left->Bound().Centroid(leftCentroid);
+  right->Bound().Centroid(rightCentroid);
+
+  left->ParentDistance() = bound.Metric().Evaluate(centroid, leftCentroid);
+  right->ParentDistance() = bound.Metric().Evaluate(centroid, rightCentroid);
+}
+
+template<typename BoundType, typename StatisticType, typename MatType>
+std::string SpillTree<BoundType, StatisticType, MatType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "SpillTree [" << this << "]" << std::endl;
+  convert << "  Descendants: " << numDescendants << std::endl;
+  convert << "  Bound: " << std::endl;
+  convert << mlpack::util::Indent(bound.ToString(), 2);
+  convert << "  Statistic: " << std::endl;
+  convert << mlpack::util::Indent(stat.ToString(), 2);
+  convert << "  Max leaf size: " << maxLeafSize << std::endl;
+  convert << "  Tau: " << tau << std::endl;
+  convert << "  Rho: " << rho << std::endl;
+  if (!IsLeaf())
+  {
+    convert << "  Split dimension: " << splitDimension << std::endl;
+    convert << "  Split value: " << splitValue << std::endl;
+    convert << "  Overlapping: " << overlapping << std::endl;
+    convert << "  Left child:" << std::endl;
+    convert << mlpack::util::Indent(left->ToString(), 2);
+    convert << "  Right child:" << std::endl;
+    convert << mlpack::util::Indent(right->ToString(), 2);
+  }
+  return convert.str();
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file traits.hpp
+ *
+ * Specialization of the TreeTraits class for the SpillTree type of tree.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_TRAITS_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_TRAITS_HPP
+
+#include <mlpack/core/tree/tree_traits.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * This is a specialization of the TreeType class to the SpillTree tree type.
+ * It defines characteristics of the spill tree, and is used to help write
+ * tree-independent (but still optimized) tree-based algorithms.  See
+ * mlpack/core/tree/tree_traits.hpp for more information.
+ */
+template<typename BoundType, typename StatisticType, typename MatType>
+class TreeTraits<SpillTree<BoundType, StatisticType, MatType> >
+{
+ public:
+  /**
+   * The children of a spill tree node share the points in the overlap buffer
+   * around the splitting hyperplane, so they may overlap.
+   */
+  static const bool HasOverlappingChildren = true;
+
+  /**
+   * There is no guarantee that the first point in a node is its centroid.
+   */
+  static const bool FirstPointIsCentroid = false;
+
+  /**
+   * Points are not contained at multiple levels of the spill tree.
+   */
+  static const bool HasSelfChildren = false;
+
+  /**
+   * The dataset is not rearranged during building of the tree.
+   */
+  static const bool RearrangesDataset = false;
+
+  /**
+   * The points in an overlap buffer are held by the leaves of both children.
+   */
+  static const bool HasDuplicatedPoints = true;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file symmetric_dual_tree_traverser.hpp
+ *
+ * A dual-tree traverser for monochromatic problems, which traverses a tree
+ * against itself visiting each unordered pair of nodes (and each unordered pair
+ * of points) only once.
+ */
+#ifndef __MLPACK_CORE_TREE_SYMMETRIC_DUAL_TREE_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_SYMMETRIC_DUAL_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+
+#include "tree_traits.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The SymmetricDualTreeTraverser traverses a tree against itself, for problems
+ * where the query set is the reference set and the results are symmetric (the
+ * distance from i to j is the distance from j to i).  The usual dual-tree
+ * traversers visit both (A, B) and (B, A) for every pair of nodes, and so
+ * evaluate every distance twice.  This traverser only visits one of them, and
+ * the rules must update the results of both sides from each call:
+ *
+ * @code
+ * // Evaluate the distance between points i and j (i != j), and update the
+ * // results of both i and j.
+ * double SymmetricBaseCase(const size_t i, const size_t j);
+ *
+ * // Score the unordered pair of (distinct) nodes; DBL_MAX means that neither
+ * // node can improve the results of the other.
+ * double SymmetricScore(TreeType& nodeA, TreeType& nodeB);
+ * double SymmetricRescore(TreeType& nodeA, TreeType& nodeB,
+ *                         const double oldScore);
+ * @endcode
+ *
+ * A node is never scored against itself; the pairs of its children are visited
+ * instead, and the pairs of points in a leaf are visited once each.  Child
+ * pairs are visited in order of their scores.
+ *
+ * The traversal only uses the generic tree interface (IsLeaf(), NumChildren(),
+ * Child(), NumPoints() and Point()), and needs each point to be held by exactly
+ * one leaf and by no other node, so it cannot be used with trees that have
+ * self-children (see TreeTraits), such as the cover tree.
+ *
+ * @tparam TreeType Type of tree to traverse.
+ * @tparam RuleType Type of rules to traverse the tree with.
+ */
+template<typename TreeType, typename RuleType>
+class SymmetricDualTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the traverser with the given rule set.
+   */
+  SymmetricDualTreeTraverser(RuleType& rule);
+
+  /**
+   * Traverse the given tree against itself.
+   *
+   * @param root Root of the tree.
+   */
+  void Traverse(TreeType& root);
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+ private:
+  //! A pair of nodes waiting to be visited, with its score.
+  struct NodePair
+  {
+    //! The first node.
+    TreeType* first;
+    //! The second node.
+    TreeType* second;
+    //! The score of the pair.
+    double score;
+
+    //! Order pairs so that the lowest score comes first.
+    bool operator<(const NodePair& other) const
+    {
+      return (score < other.score);
+    }
+  };
+
+  //! Visit the pairs of points and of children of the given node.
+  void TraverseSelf(TreeType& node);
+
+  //! Visit the given pair of distinct nodes.
+  void Traverse(TreeType& nodeA, TreeType& nodeB);
+
+  //! Score the pair and add it to the list of pairs, unless it is pruned.
+  void AddPair(TreeType& nodeA,
+               TreeType& nodeB,
+               std::vector<NodePair>& pairs);
+
+  //! Visit the given pairs in order of their scores.
+  void VisitPairs(std::vector<NodePair>& pairs);
+
+  //! Reference to the rules with which the tree will be traversed.
+  RuleType& rule;
+
+  //! The number of node pairs which have been pruned during traversal.
+  size_t numPrunes;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+// Include implementation.
+#include "symmetric_dual_tree_traverser_impl.hpp"
+
+#endif
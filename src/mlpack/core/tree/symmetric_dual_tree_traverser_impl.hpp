@@ -0,0 +1,137 @@
+/**
+ * @file symmetric_dual_tree_traverser_impl.hpp
+ *
+ * Implementation of the SymmetricDualTreeTraverser, which visits each unordered
+ * pair of nodes of a tree once.
+ */
+#ifndef __MLPACK_CORE_TREE_SYMMETRIC_DUAL_TREE_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_SYMMETRIC_DUAL_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "symmetric_dual_tree_traverser.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename TreeType, typename RuleType>
+SymmetricDualTreeTraverser<TreeType, RuleType>::SymmetricDualTreeTraverser(
+    RuleType& rule) :
+    rule(rule),
+    numPrunes(0)
+{ /* Nothing to do. */ }
+
+template<typename TreeType, typename RuleType>
+void SymmetricDualTreeTraverser<TreeType, RuleType>::Traverse(TreeType& root)
+{
+  TraverseSelf(root);
+}
+
+template<typename TreeType, typename RuleType>
+void SymmetricDualTreeTraverser<TreeType, RuleType>::TraverseSelf(
+    TreeType& node)
+{
+  if (node.IsLeaf())
+  {
+    for (size_t i = 0; i < node.NumPoints(); ++i)
+      for (size_t j = i + 1; j < node.NumPoints(); ++j)
+        rule.SymmetricBaseCase(node.Point(i), node.Point(j));
+
+    return;
+  }
+
+  // Each child against itself first; these pairs cannot be pruned, and they
+  // give the results that the other pairs are pruned with.
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    TraverseSelf(node.Child(i));
+
+  std::vector<NodePair> pairs;
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    for (size_t j = i + 1; j < node.NumChildren(); ++j)
+      AddPair(node.Child(i), node.Child(j), pairs);
+
+  VisitPairs(pairs);
+}
+
+template<typename TreeType, typename RuleType>
+void SymmetricDualTreeTraverser<TreeType, RuleType>::Traverse(
+    TreeType& nodeA,
+    TreeType& nodeB)
+{
+  if (nodeA.IsLeaf() && nodeB.IsLeaf())
+  {
+    for (size_t i = 0; i < nodeA.NumPoints(); ++i)
+      for (size_t j = 0; j < nodeB.NumPoints(); ++j)
+        rule.SymmetricBaseCase(nodeA.Point(i), nodeB.Point(j));
+
+    return;
+  }
+
+  // Split every node that is not a leaf.
+  std::vector<NodePair> pairs;
+  if (nodeA.IsLeaf())
+  {
+    for (size_t j = 0; j < nodeB.NumChildren(); ++j)
+      AddPair(nodeA, nodeB.Child(j), pairs);
+  }
+  else if (nodeB.IsLeaf())
+  {
+    for (size_t i = 0; i < nodeA.NumChildren(); ++i)
+      AddPair(nodeA.Child(i), nodeB, pairs);
+  }
+  else
+  {
+    for (size_t i = 0; i < nodeA.NumChildren(); ++i)
+      for (size_t j = 0; j < nodeB.NumChildren(); ++j)
+        AddPair(nodeA.Child(i), nodeB.Child(j), pairs);
+  }
+
+  VisitPairs(pairs);
+}
+
+template<typename TreeType, typename RuleType>
+void SymmetricDualTreeTraverser<TreeType, RuleType>::AddPair(
+    TreeType& nodeA,
+    TreeType& nodeB,
+    std::vector<NodePair>& pairs)
+{
+  const double score = rule.SymmetricScore(nodeA, nodeB);
+  if (score == DBL_MAX)
+  {
+    ++numPrunes;
+    return;
+  }
+
+  NodePair pair;
+  pair.first = &nodeA;
+  pair.second = &nodeB;
+  pair.score = score;
+  pairs.push_back(pair);
+}
+
+template<typename TreeType, typename RuleType>
+void SymmetricDualTreeTraverser<TreeType, RuleType>::VisitPairs(
+    std::vector<NodePair>& pairs)
+{
+  std::sort(pairs.begin(), pairs.end());
+
+  for (size_t p = 0; p < pairs.size(); ++p)
+  {
+    // The results found since the pair was scored may allow it to be pruned.
+    const double score = rule.SymmetricRescore(*pairs[p].first,
+        *pairs[p].second, pairs[p].score);
+    if (score == DBL_MAX)
+    {
+      ++numPrunes;
+      continue;
+    }
+
+    Traverse(*pairs[p].first, *pairs[p].second);
+  }
+}
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
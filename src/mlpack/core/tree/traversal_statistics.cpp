@@ -0,0 +1,111 @@
+/**
+ * @file traversal_statistics.cpp
+ *
+ * Implementation of TraversalStatistics.
+ */
+#include "traversal_statistics.hpp"
+
+using namespace mlpack;
+using namespace mlpack::tree;
+
+TraversalStatistics::TraversalStatistics() :
+    baseCases(0),
+    scores(0),
+    nodeVisits(0),
+    leafPairs(0),
+    approximatePrunes(0),
+    maxRelativeError(0.0)
+{ }
+
+void TraversalStatistics::StartPhase(const std::string& name)
+{
+  phaseStarts[name] = Profiler::MonotonicNanoseconds();
+}
+
+void TraversalStatistics::StopPhase(const std::string& name)
+{
+  std::map<std::string, boost::uint64_t>::iterator it = phaseStarts.find(name);
+  if (it == phaseStarts.end())
+  {
+    Log::Warn << "TraversalStatistics::StopPhase(): phase '" << name << "' was "
+        << "never started." << std::endl;
+    return;
+  }
+
+  phaseTimes[name] += (Profiler::MonotonicNanoseconds() - it->second) / 1e9;
+  phaseStarts.erase(it);
+}
+
+double TraversalStatistics::PhaseTime(const std::string& name) const
+{
+  std::map<std::string, double>::const_iterator it = phaseTimes.find(name);
+  return (it == phaseTimes.end()) ? 0.0 : it->second;
+}
+
+size_t TraversalStatistics::Prunes() const
+{
+  size_t prunes = 0;
+  for (size_t i = 0; i < prunesByDepth.size(); ++i)
+    prunes += prunesByDepth[i];
+  return prunes;
+}
+
+TraversalStatistics& TraversalStatistics::operator+=(
+    const TraversalStatistics& other)
+{
+  baseCases += other.baseCases;
+  scores += other.scores;
+  nodeVisits += other.nodeVisits;
+  leafPairs += other.leafPairs;
+
+  if (other.prunesByDepth.size() > prunesByDepth.size())
+    prunesByDepth.resize(other.prunesByDepth.size(), 0);
+  for (size_t i = 0; i < other.prunesByDepth.size(); ++i)
+    prunesByDepth[i] += other.prunesByDepth[i];
+
+  approximatePrunes += other.approximatePrunes;
+  maxRelativeError = std::max(maxRelativeError, other.maxRelativeError);
+
+  for (std::map<std::string, double>::const_iterator it =
+      other.phaseTimes.begin(); it != other.phaseTimes.end(); ++it)
+    phaseTimes[it->first] += it->second;
+
+  return *this;
+}
+
+void TraversalStatistics::Reset()
+{
+  baseCases = 0;
+  scores = 0;
+  nodeVisits = 0;
+  leafPairs = 0;
+  prunesByDepth.clear();
+  approximatePrunes = 0;
+  maxRelativeError = 0.0;
+  phaseTimes.clear();
+  phaseStarts.clear();
+}
+
+void TraversalStatistics::Print() const
+{
+  Log::Info << "Traversal statistics:" << std::endl;
+  Log::Info << "  base cases: " << baseCases << std::endl;
+  Log::Info << "  scores: " << scores << std::endl;
+  Log::Info << "  node visits: " << nodeVisits << std::endl;
+  Log::Info << "  leaf pairs: " << leafPairs << std::endl;
+  Log::Info << "  prunes: " << Prunes() << std::endl;
+  for (size_t i = 0; i < prunesByDepth.size(); ++i)
+    if (prunesByDepth[i] > 0)
+      Log::Info << "    at depth " << i << ": " << prunesByDepth[i]
+          << std::endl;
+
+  if (approximatePrunes > 0)
+  {
+    Log::Info << "  approximate prunes: " << approximatePrunes << std::endl;
+    Log::Info << "  maximum relative error: " << maxRelativeError << std::endl;
+  }
+
+  for (std::map<std::string, double>::const_iterator it = phaseTimes.begin();
+      it != phaseTimes.end(); ++it)
+    Log::Info << "  " << it->first << ": " << it->second << "s" << std::endl;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file traversal_statistics.hpp
+ *
+ * Counts of the work done by a tree traversal, which every RuleType class
+ * fills in, so that the different tree-based algorithms can be compared on
+ * the same terms.
+ */
+#ifndef __MLPACK_CORE_TREE_TRAVERSAL_STATISTICS_HPP
+#define __MLPACK_CORE_TREE_TRAVERSAL_STATISTICS_HPP
+
+#include <mlpack/core.hpp>
+
+#include <map>
+#include <vector>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The TraversalStatistics class holds counts of the work done by one or more
+ * tree traversals: the number of base cases, the number of Score() calls, the
+ * number of node combinations that were pruned (by the depth of the deeper
+ * node), the number of node combinations that were recursed into (visits), and
+ * the number of those in which every node was a leaf (leaf pairs).  It also
+ * holds the time spent in each named phase of the algorithm (such as
+ * "tree_building" and "traversal").
+ *
+ * This class should be held as a member of the RuleType class, and the
+ * interface to it should be through a Statistics() method.  BaseCase() should
+ * increment BaseCases(), and Score() should pass each score it returns through
+ * Score(), which counts it:
+ *
+ * @code
+ * return statistics.Score(distance, queryNode, referenceNode);
+ * @endcode
+ *
+ * Prunes made later by Rescore() are not counted, since Rescore() is const;
+ * the traversers count those with NumPrunes().  Rules that allow a relative
+ * error in their results also pass each prune that is only made because of it
+ * to ApproximatePrune(), so that MaxRelativeError() bounds the error.
+ * Statistics from several rules objects (for instance, one for each thread)
+ * can be combined with +=.
+ */
+class TraversalStatistics
+{
+ public:
+  //! Initialize all of the counts to zero.
+  TraversalStatistics();
+
+  /**
+   * Count one Score() call for a single-tree traversal, which gave the given
+   * score for the given reference node, and return the score.
+   */
+  template<typename TreeType>
+  double Score(const double score, const TreeType& referenceNode)
+  {
+    ++scores;
+    if (score == DBL_MAX)
+    {
+      Prune(Depth(referenceNode));
+    }
+    else
+    {
+      ++nodeVisits;
+      if (referenceNode.NumChildren() == 0)
+        ++leafPairs;
+    }
+
+    return score;
+  }
+
+  /**
+   * Count one Score() call for a dual-tree traversal, which gave the given
+   * score for the given node combination, and return the score.
+   */
+  template<typename TreeType>
+  double Score(const double score,
+               const TreeType& queryNode,
+               const TreeType& referenceNode)
+  {
+    ++scores;
+    if (score == DBL_MAX)
+    {
+      Prune(std::max(Depth(queryNode), Depth(referenceNode)));
+    }
+    else
+    {
+      ++nodeVisits;
+      if (queryNode.NumChildren() == 0 && referenceNode.NumChildren() == 0)
+        ++leafPairs;
+    }
+
+    return score;
+  }
+
+  //! Count one prune of a node combination whose deeper node has the given
+  //! depth (the root has depth 0).
+  void Prune(const size_t depth)
+  {
+    if (depth >= prunesByDepth.size())
+      prunesByDepth.resize(depth + 1, 0);
+    ++prunesByDepth[depth];
+  }
+
+  //! Return the depth of the given node (the root has depth 0).
+  template<typename TreeType>
+  static size_t Depth(const TreeType& node)
+  {
+    size_t depth = 0;
+    for (const TreeType* n = node.Parent(); n != NULL; n = n->Parent())
+      ++depth;
+    return depth;
+  }
+
+  //! Start timing the given phase.  Phases are additive, like Timer.
+  void StartPhase(const std::string& name);
+  //! Stop timing the given phase.
+  void StopPhase(const std::string& name);
+  //! Get the time spent in the given phase, in seconds.
+  double PhaseTime(const std::string& name) const;
+  //! Get the time spent in each phase, in seconds.
+  const std::map<std::string, double>& PhaseTimes() const { return phaseTimes; }
+
+  //! Get the number of base cases.
+  size_t BaseCases() const { return baseCases; }
+  //! Modify the number of base cases.
+  size_t& BaseCases() { return baseCases; }
+
+  //! Get the number of Score() calls.
+  size_t Scores() const { return scores; }
+  //! Modify the number of Score() calls.
+  size_t& Scores() { return scores; }
+
+  //! Get the number of node combinations recursed into.
+  size_t NodeVisits() const { return nodeVisits; }
+  //! Modify the number of node combinations recursed into.
+  size_t& NodeVisits() { return nodeVisits; }
+
+  //! Get the number of node combinations recursed into that held only leaves.
+  size_t LeafPairs() const { return leafPairs; }
+  //! Modify the number of node combinations recursed into that held only
+  //! leaves.
+  size_t& LeafPairs() { return leafPairs; }
+
+  //! Get the total number of prunes.
+  size_t Prunes() const;
+  //! Get the number of prunes at each depth.
+  const std::vector<size_t>& PrunesByDepth() const { return prunesByDepth; }
+
+  //! Count one prune that was only made because the rules allow some relative
+  //! error, after which any result may be worse than the exact one by at most
+  //! the given fraction.
+  void ApproximatePrune(const double relativeError)
+  {
+    ++approximatePrunes;
+    if (relativeError > maxRelativeError)
+      maxRelativeError = relativeError;
+  }
+
+  //! Get the number of prunes that were only made because the rules allow
+  //! some relative error.  These are also counted by Score().
+  size_t ApproximatePrunes() const { return approximatePrunes; }
+  //! Get the largest fraction by which any result may be worse than the exact
+  //! one, over all approximate prunes (0 if the results are exact).
+  double MaxRelativeError() const { return maxRelativeError; }
+
+  //! Add the counts and phase times of another set of statistics to these.
+  TraversalStatistics& operator+=(const TraversalStatistics& other);
+
+  //! Set all of the counts and phase times to zero.
+  void Reset();
+
+  //! Print the statistics to Log::Info (so they are shown with --verbose).
+  void Print() const;
+
+ private:
+  //! The number of base cases.
+  size_t baseCases;
+  //! The number of Score() calls.
+  size_t scores;
+  //! The number of node combinations recursed into.
+  size_t nodeVisits;
+  //! The number of node combinations recursed into that held only leaves.
+  size_t leafPairs;
+  //! The number of prunes at each depth.
+  std::vector<size_t> prunesByDepth;
+  //! The number of prunes made only because of the allowed relative error.
+  size_t approximatePrunes;
+  //! The largest relative error any approximate prune may have caused.
+  double maxRelativeError;
+
+  //! The time spent in each phase, in seconds.
+  std::map<std::string, double> phaseTimes;
+  //! When each running phase was started, in nanoseconds.
+  std::map<std::string, boost::uint64_t> phaseStarts;
+};
+
+}; // namespace tree
+}; // namespace mlpack
+
+#endif
@@ -94,6 +94,12 @@ class TreeTraits
    * This is true if the tree rearranges points in the dataset when it is built.
    */
   static const bool RearrangesDataset = false;
+
+  /**
+   * This is true if a point can be held by more than one leaf of the tree (so
+   * a traversal may visit it more than once).
+   */
+  static const bool HasDuplicatedPoints = false;
 };
 
 }; // namespace tree
@@ -86,4 +86,43 @@ struct IsVector<arma::SpSubview<eT> >
   const static bool value = true;
 };
 
+/**
+ * If value == true, then MatType is some sort of Armadillo sparse matrix,
+ * vector, or subview.  This is used to pick algorithms that only visit the
+ * nonzero elements of sparse data.
+ */
+template<typename MatType>
+struct IsSparse
+{
+  const static bool value = false;
+};
+
+//template<>
+template<typename eT>
+struct IsSparse<arma::SpMat<eT> >
+{
+  const static bool value = true;
+};
+
+//template<>
+template<typename eT>
+struct IsSparse<arma::SpCol<eT> >
+{
+  const static bool value = true;
+};
+
+//template<>
+template<typename eT>
+struct IsSparse<arma::SpRow<eT> >
+{
+  const static bool value = true;
+};
+
+//template<>
+template<typename eT>
+struct IsSparse<arma::SpSubview<eT> >
+{
+  const static bool value = true;
+};
+
 #endif
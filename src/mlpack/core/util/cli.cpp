@@ -13,8 +13,13 @@
 
 #include "cli.hpp"
 #include "log.hpp"
+#include "log_backend.hpp"
 
 #include "option.hpp"
+#include "memory_placement.hpp"
+#include "memory_tracker.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
 
 using namespace mlpack;
 using namespace mlpack::util;
@@ -73,14 +78,33 @@ CLI::~CLI()
       Log::Info << "  " << i << ": ";
       timer.PrintTimer((*it).first);
     }
+
+    MemoryTracker::PrintSummary();
+
+#ifdef MLPACK_PROFILE_SCOPES
+    Profiler::PrintSummary();
+#endif
   }
 
+  // Write the memory statistics, if the user asked for them.
+  if (HasParam("memory_json") && !HasParam("help") && !HasParam("info"))
+    MemoryTracker::WriteJSON(GetParam<std::string>("memory_json"));
+
+#ifdef MLPACK_PROFILE_SCOPES
+  // Write the trace of the profiled scopes, if the user asked for it.
+  if (HasParam("profile_trace") && !HasParam("help") && !HasParam("info"))
+    Profiler::WriteTrace(GetParam<std::string>("profile_trace"));
+#endif
+
   // Notify the user if we are debugging, but only if we actually parsed the
   // options.  This way this output doesn't show up inexplicably for someone who
   // may not have wanted it there (i.e. in Boost unit tests).
   if (didParse)
     Log::Debug << "Compiled with debugging symbols." << std::endl;
 
+  // Write whatever is left of the log, if it was asynchronous.
+  util::LogBackend::Stop();
+
   return;
 }
 
@@ -224,6 +248,37 @@ void CLI::DefaultMessages()
     Log::Info.ignoreInput = false;
   }
 
+  // Set the number of threads used by parallel regions, if it was given.
+  if (HasParam("threads"))
+  {
+    const int threads = GetParam<int>("threads");
+    if (threads < 0)
+      Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+          << "0 (for all of them) or greater." << std::endl;
+
+    util::SetNumThreads((size_t) threads);
+  }
+
+  // Set where large matrices are put, and pin the threads, if asked.
+  const std::string numa = GetParam<std::string>("numa");
+  if (numa == "first_touch")
+    util::SetMemoryPlacement(util::FIRST_TOUCH_PLACEMENT);
+  else if (numa == "interleave")
+    util::SetMemoryPlacement(util::INTERLEAVED_PLACEMENT);
+  else if (numa != "")
+    Log::Fatal << "Invalid --numa placement: '" << numa << "'.  Must be "
+        << "'first_touch' or 'interleave'." << std::endl;
+
+  util::SetHugePages(HasParam("huge_pages"));
+
+  if (HasParam("pin_threads") && !util::PinThreads())
+    Log::Warn << "Could not pin the threads to CPUs." << std::endl;
+
+  // Write the log from a background thread, if asked.
+  if (HasParam("async_log") && !util::LogBackend::Start())
+    Log::Warn << "Could not start the asynchronous log; it will be written "
+        << "synchronously." << std::endl;
+
   // Notify the user if we are debugging.  This is not done in the constructor
   // because the output streams may not be set up yet.  We also don't want this
   // message twice if the user just asked for help or information.
@@ -742,3 +797,20 @@ PARAM_STRING("info", "Get help on a specific module or option.", "", "");
 PARAM_FLAG("verbose", "Display informational messages and the full list of "
     "parameters and timers at the end of execution.", "v");
 PARAM_FLAG("version", "Display the version of mlpack.", "V");
+PARAM_INT("threads", "Number of threads to use (0 uses all of them; only has "
+    "an effect if mlpack was built with OpenMP).", "", 0);
+PARAM_STRING("numa", "Placement of large matrices on the NUMA nodes: "
+    "'first_touch' (the points processed by each thread are put on its node) "
+    "or 'interleave' (the pages are spread over all the nodes; requires "
+    "libnuma).", "", "");
+PARAM_FLAG("huge_pages", "Back large matrices with transparent huge pages "
+    "(Linux only).", "");
+PARAM_FLAG("pin_threads", "Pin each thread to its own CPU (Linux only).", "");
+PARAM_FLAG("async_log", "Write the log from a background thread, so that "
+    "verbose output does not slow the program down.", "");
+PARAM_STRING("memory_json", "File to write the memory used during each timer "
+    "phase, and the counters (such as tree_nodes), to, as JSON.", "", "");
+#ifdef MLPACK_PROFILE_SCOPES
+PARAM_STRING("profile_trace", "File to write a trace of the profiled scopes "
+    "to, in the Chrome trace (JSON) format.", "", "");
+#endif
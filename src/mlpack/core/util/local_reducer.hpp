@@ -0,0 +1,52 @@
+/**
+ * @file local_reducer.hpp
+ *
+ * The LocalReducer, which sums values over the nodes of a distributed
+ * computation when there is only one node.
+ */
+#ifndef __MLPACK_CORE_UTIL_LOCAL_REDUCER_HPP
+#define __MLPACK_CORE_UTIL_LOCAL_REDUCER_HPP
+
+#include <cstddef>
+
+namespace mlpack {
+namespace util {
+
+/**
+ * Distributed algorithms (such as the distributed overloads of
+ * kmeans::KMeans::Cluster() and gmm::EMFit::Estimate()) run on the part of the
+ * data held by each node, and combine the sums computed on each node with a
+ * reducer, an all-reduce: after Sum() returns, every node holds the sum of the
+ * values given by all the nodes.  Every node must call Sum() the same number of
+ * times, with the same number of values.  A reducer provides
+ *
+ * @code
+ * // Replace the n values with their sums over all the nodes.
+ * void Sum(double* values, const size_t n);
+ *
+ * // Get the index of this node, and the number of nodes.
+ * size_t Rank() const;
+ * size_t NumNodes() const;
+ * @endcode
+ *
+ * The LocalReducer is the reducer for a single node, which does nothing; the
+ * util::MPIReducer (in mpi_reducer.hpp) sums over the processes of an MPI
+ * communicator, and other transports can be plugged in by writing a class with
+ * the same methods.
+ */
+class LocalReducer
+{
+ public:
+  //! Sum the values over all the nodes; there is only one, so they are kept.
+  void Sum(double* /* values */, const size_t /* n */) { }
+
+  //! Get the index of this node.
+  size_t Rank() const { return 0; }
+  //! Get the number of nodes.
+  size_t NumNodes() const { return 1; }
+};
+
+}; // namespace util
+}; // namespace mlpack
+
+#endif
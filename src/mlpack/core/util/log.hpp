@@ -45,6 +45,21 @@ namespace mlpack {
  * mode.  Messages to Log::Info will only be shown when the --verbose flag is
  * given to the program (or rather, the CLI class).
  *
+ * The values given to Log::Debug and Log::Info are computed (and formatted,
+ * for Log::Info) even if they are not shown.  In hot code, use the
+ * MLPACK_LOG_DEBUG and MLPACK_LOG_INFO macros instead, which do nothing at all
+ * for a level that is not shown: MLPACK_LOG_DEBUG is removed by the compiler in
+ * non-debug mode, and MLPACK_LOG_INFO is one branch unless --verbose is given
+ * (and is removed too if MLPACK_NO_INFO_LOG is defined).
+ *
+ * @code
+ * MLPACK_LOG_DEBUG << "Residual " << arma::norm(x - y) << "." << std::endl;
+ * @endcode
+ *
+ * The streams may be written to from several threads; see LogBackend for
+ * writing them asynchronously, and ProgressReporter for reporting the progress
+ * of long loops.
+ *
  * @see PrefixedOutStream, NullOutStream, CLI
  */
 class Log
@@ -85,4 +100,20 @@ class Log
 
 }; //namespace mlpack
 
+// The statement after the `else' is never run when the level is not shown, so
+// nothing in it is computed; when the condition is `true', the compiler removes
+// the statement entirely.
+#ifdef DEBUG
+  #define MLPACK_LOG_DEBUG mlpack::Log::Debug
+#else
+  #define MLPACK_LOG_DEBUG if (true) { } else mlpack::Log::Debug
+#endif
+
+#ifdef MLPACK_NO_INFO_LOG
+  #define MLPACK_LOG_INFO if (true) { } else mlpack::Log::Info
+#else
+  #define MLPACK_LOG_INFO if (mlpack::Log::Info.ignoreInput) { } else \
+      mlpack::Log::Info
+#endif
+
 #endif
@@ -0,0 +1,246 @@
+/**
+ * @file log_backend.cpp
+ *
+ * Implementation of the asynchronous backend of the Log streams.
+ */
+#include "log_backend.hpp"
+
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+  #include <pthread.h>
+#endif
+
+// Each thread keeps a pointer to its own line buffers.
+#if defined(_MSC_VER)
+  #define MLPACK_LOG_THREAD_LOCAL __declspec(thread)
+#else
+  #define MLPACK_LOG_THREAD_LOCAL __thread
+#endif
+
+using namespace mlpack::util;
+
+bool LogBackend::asynchronous = false;
+
+namespace {
+
+//! The lines one thread is building, one for each stream it writes to.
+struct LineBuffers
+{
+  std::vector<std::pair<const void*, std::ostringstream*> > streams;
+};
+
+//! The calling thread's line buffers.  They are never freed, since the
+//! threads of OpenMP's pool live until the program ends.
+MLPACK_LOG_THREAD_LOCAL LineBuffers* lineBuffers = NULL;
+
+#ifndef _WIN32
+//! Text waiting to be written.
+struct Entry
+{
+  std::ostream* destination;
+  std::string text;
+};
+
+//! Write the given entries, flushing each destination when the next entry
+//! goes elsewhere (so that the order of the lines is kept across streams).
+void Write(const std::vector<Entry>& entries)
+{
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    *entries[i].destination << entries[i].text;
+    if (i + 1 == entries.size() ||
+        entries[i + 1].destination != entries[i].destination)
+      entries[i].destination->flush();
+  }
+}
+
+//! Protects everything below.
+pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+//! Signalled when there is something to write, or the thread must stop.
+pthread_cond_t queueReady = PTHREAD_COND_INITIALIZER;
+//! Signalled when a batch has been written.
+pthread_cond_t batchWritten = PTHREAD_COND_INITIALIZER;
+
+pthread_t flusher;
+//! Whether the background thread takes submissions.
+bool running = false;
+//! Whether the background thread should stop once the queue is empty.
+bool stopping = false;
+//! Number of entries submitted, and written, since the thread started.
+size_t submitted = 0;
+size_t written = 0;
+
+std::vector<Entry>& Queue()
+{
+  static std::vector<Entry> queue;
+  return queue;
+}
+
+/**
+ * The background thread: take the whole queue at once, and write it without
+ * holding the lock, so that submitting a line only waits for a swap.
+ */
+void* RunFlusher(void* /* argument */)
+{
+  std::vector<Entry> batch;
+
+  pthread_mutex_lock(&queueLock);
+  while (true)
+  {
+    while (Queue().empty() && !stopping)
+      pthread_cond_wait(&queueReady, &queueLock);
+
+    if (Queue().empty())
+    {
+      // Stopping, and nothing is left; later submissions are written by the
+      // threads that submit them.
+      running = false;
+      break;
+    }
+
+    batch.swap(Queue());
+    pthread_mutex_unlock(&queueLock);
+
+    Write(batch);
+    const size_t count = batch.size();
+    batch.clear();
+
+    pthread_mutex_lock(&queueLock);
+    written += count;
+    pthread_cond_broadcast(&batchWritten);
+  }
+  pthread_cond_broadcast(&batchWritten);
+  pthread_mutex_unlock(&queueLock);
+
+  return NULL;
+}
+
+//! Called at exit, so that nothing that was logged is lost.
+void StopAtExit()
+{
+  LogBackend::Stop();
+}
+#endif
+
+} // anonymous namespace
+
+bool LogBackend::Start()
+{
+#ifndef _WIN32
+  pthread_mutex_lock(&queueLock);
+  if (running)
+  {
+    pthread_mutex_unlock(&queueLock);
+    return true;
+  }
+
+  stopping = false;
+  submitted = 0;
+  written = 0;
+  // Make the queue before the exit handler is registered, so that it is
+  // destroyed after the handler has run.
+  Queue().clear();
+  if (pthread_create(&flusher, NULL, RunFlusher, NULL) != 0)
+  {
+    pthread_mutex_unlock(&queueLock);
+    return false;
+  }
+  running = true;
+  pthread_mutex_unlock(&queueLock);
+
+  static bool registered = false;
+  if (!registered)
+  {
+    atexit(StopAtExit);
+    registered = true;
+  }
+
+  asynchronous = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void LogBackend::Stop()
+{
+  asynchronous = false;
+
+#ifndef _WIN32
+  pthread_mutex_lock(&queueLock);
+  if (!running || stopping)
+  {
+    pthread_mutex_unlock(&queueLock);
+    return;
+  }
+
+  stopping = true;
+  pthread_cond_signal(&queueReady);
+  pthread_mutex_unlock(&queueLock);
+
+  pthread_join(flusher, NULL);
+
+  pthread_mutex_lock(&queueLock);
+  stopping = false;
+  pthread_mutex_unlock(&queueLock);
+#endif
+}
+
+void LogBackend::Submit(std::ostream& destination, const std::string& text)
+{
+#ifndef _WIN32
+  pthread_mutex_lock(&queueLock);
+  if (running)
+  {
+    Entry entry;
+    entry.destination = &destination;
+    entry.text = text;
+
+    // The thread only sleeps while the queue is empty.
+    if (Queue().empty())
+      pthread_cond_signal(&queueReady);
+    Queue().push_back(entry);
+    ++submitted;
+
+    pthread_mutex_unlock(&queueLock);
+    return;
+  }
+  pthread_mutex_unlock(&queueLock);
+#endif
+
+  // There is no background thread, so write it now.
+  #pragma omp critical(mlpackPrefixedOutStream)
+  {
+    destination << text;
+    destination.flush();
+  }
+}
+
+void LogBackend::Flush()
+{
+#ifndef _WIN32
+  pthread_mutex_lock(&queueLock);
+  const size_t target = submitted;
+  while (running && written < target)
+    pthread_cond_wait(&batchWritten, &queueLock);
+  pthread_mutex_unlock(&queueLock);
+#endif
+}
+
+std::ostringstream& LogBackend::LineBuffer(const void* stream)
+{
+  if (lineBuffers == NULL)
+    lineBuffers = new LineBuffers();
+
+  std::vector<std::pair<const void*, std::ostringstream*> >& streams =
+      lineBuffers->streams;
+  for (size_t i = 0; i < streams.size(); ++i)
+    if (streams[i].first == stream)
+      return *streams[i].second;
+
+  streams.push_back(std::make_pair(stream, new std::ostringstream()));
+  return *streams.back().second;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file log_backend.hpp
+ *
+ * The asynchronous backend of the Log streams: each thread builds its lines in
+ * its own buffer, and finished lines are written by a background thread.
+ */
+#ifndef __MLPACK_CORE_UTIL_LOG_BACKEND_HPP
+#define __MLPACK_CORE_UTIL_LOG_BACKEND_HPP
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace mlpack {
+namespace util {
+
+/**
+ * By default, each value given to a PrefixedOutStream (such as Log::Info) is
+ * written to its destination right away, under a lock.  Once Start() has been
+ * called, the streams are asynchronous instead: each thread builds the line it
+ * is writing in a buffer of its own, without taking any lock, and only hands
+ * finished lines to the backend.  A background thread writes them, in the
+ * order they were finished, while the other threads carry on.  So lines
+ * written by several threads are never mixed, and a thread that logs in a
+ * loop does not wait for the terminal.
+ *
+ * A line is written once it ends with a newline; a Fatal line is written (with
+ * everything before it) before the program terminates.  Stop() writes
+ * everything that is left and makes the streams synchronous again; it is
+ * called at exit, and by CLI when the program ends.  Programs using CLI start
+ * the backend with --async_log.
+ *
+ * @code
+ * util::LogBackend::Start();
+ * #pragma omp parallel for
+ * for (int i = 0; i < 100; ++i)
+ *   Log::Info << "Point " << i << " done." << std::endl; // Never mixed.
+ * util::LogBackend::Stop();
+ * @endcode
+ *
+ * The background thread needs POSIX threads; on Windows, Start() does nothing
+ * and the streams stay synchronous.
+ */
+class LogBackend
+{
+ public:
+  /**
+   * Start the background thread, and make the streams asynchronous.  This
+   * should be called before other threads write to the streams.
+   *
+   * @return false if the background thread could not be started (and the
+   *     streams are still synchronous).
+   */
+  static bool Start();
+
+  /**
+   * Write every line that is left, stop the background thread, and make the
+   * streams synchronous again.  Lines that have not been finished with a
+   * newline are dropped, so this should be called between lines.
+   */
+  static void Stop();
+
+  //! Return whether the streams are asynchronous.
+  static bool Asynchronous() { return asynchronous; }
+
+  /**
+   * Hand text (one or more finished lines) to the backend, to be written to
+   * the given destination.  If the background thread is not running, the text
+   * is written now.
+   *
+   * @param destination Stream to write the text to.
+   * @param text Text to write.
+   */
+  static void Submit(std::ostream& destination, const std::string& text);
+
+  //! Wait until everything submitted so far has been written.
+  static void Flush();
+
+  /**
+   * Return the calling thread's buffer for the line being written to the
+   * given stream.
+   *
+   * @param stream The stream the line is written to.
+   */
+  static std::ostringstream& LineBuffer(const void* stream);
+
+ private:
+  //! Whether the streams are asynchronous.
+  static bool asynchronous;
+};
+
+}; // namespace util
+}; // namespace mlpack
+
+#endif
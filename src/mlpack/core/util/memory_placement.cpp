@@ -0,0 +1,122 @@
+/**
+ * @file memory_placement.cpp
+ *
+ * Implementation of the placement of large matrices on NUMA nodes, huge pages,
+ * and thread pinning.
+ */
+#include "memory_placement.hpp"
+#include "log.hpp"
+
+#include <vector>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+#ifdef HAS_NUMA
+  #include <numa.h>
+#endif
+
+#ifdef __linux__
+  #include <pthread.h>
+  #include <sched.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+using namespace mlpack;
+
+// The settings, which are set once by CLI::ParseCommandLine().
+static util::MemoryPlacement memoryPlacement = util::DEFAULT_PLACEMENT;
+static bool hugePages = false;
+
+void util::SetMemoryPlacement(const MemoryPlacement placement)
+{
+#ifndef HAS_NUMA
+  if (placement == INTERLEAVED_PLACEMENT)
+    Log::Warn << "Interleaved memory placement requires libnuma, but mlpack "
+        << "was compiled without it; using first-touch placement." << std::endl;
+#endif
+
+  memoryPlacement = placement;
+}
+
+util::MemoryPlacement util::GetMemoryPlacement()
+{
+  return memoryPlacement;
+}
+
+void util::SetHugePages(const bool useHugePages)
+{
+#if !defined(__linux__) || !defined(MADV_HUGEPAGE)
+  if (useHugePages)
+    Log::Warn << "Huge pages are not supported on this system." << std::endl;
+#endif
+
+  hugePages = useHugePages;
+}
+
+bool util::HugePages()
+{
+  return hugePages;
+}
+
+void util::AdviseMemory(void* memory, const size_t bytes)
+{
+#ifdef __linux__
+  // Only whole pages can be advised.
+  const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+  const size_t start = (((size_t) memory + pageSize - 1) / pageSize) *
+      pageSize;
+  const size_t end = (((size_t) memory + bytes) / pageSize) * pageSize;
+  if (end <= start)
+    return;
+
+  #ifdef MADV_HUGEPAGE
+  if (hugePages)
+    madvise((void*) start, end - start, MADV_HUGEPAGE);
+  #endif
+
+  #ifdef HAS_NUMA
+  if (memoryPlacement == INTERLEAVED_PLACEMENT && numa_available() >= 0)
+    numa_interleave_memory((void*) start, end - start, numa_all_nodes_ptr);
+  #endif
+#else
+  (void) memory;
+  (void) bytes;
+#endif
+}
+
+bool util::PinThreads()
+{
+#if defined(__linux__) && defined(HAS_OPENMP)
+  // Find the CPUs that this process may run on.
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    return false;
+
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET(cpu, &allowed))
+      cpus.push_back(cpu);
+
+  if (cpus.empty())
+    return false;
+
+  bool success = true;
+  #pragma omp parallel reduction(&&:success)
+  {
+    const size_t thread = (size_t) omp_get_thread_num();
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpus[thread % cpus.size()], &cpuSet);
+    success = (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet),
+        &cpuSet) == 0);
+  }
+
+  return success;
+#else
+  return false;
+#endif
+}
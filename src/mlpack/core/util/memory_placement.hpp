@@ -0,0 +1,115 @@
+/**
+ * @file memory_placement.hpp
+ *
+ * Placement of large matrices on the NUMA nodes of a machine, huge pages for
+ * them, and pinning of threads to CPUs.  By default none of this is done; the
+ * programs using CLI turn it on with the --numa, --huge_pages and --pin_threads
+ * options.
+ */
+#ifndef __MLPACK_CORE_UTIL_MEMORY_PLACEMENT_HPP
+#define __MLPACK_CORE_UTIL_MEMORY_PLACEMENT_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include <algorithm>
+
+namespace mlpack {
+namespace util {
+
+/**
+ * Where the pages of large matrices are put on a machine with several NUMA
+ * nodes.  Pages are normally put on the node of the thread that first writes to
+ * them ("first touch"), which for a matrix loaded or copied by the main thread
+ * is the node of the main thread, so that the threads of parallel loops on the
+ * other nodes all read remote memory.
+ */
+enum MemoryPlacement
+{
+  //! Leave the matrices where they are allocated.
+  DEFAULT_PLACEMENT,
+  //! Copy each matrix in parallel, so that the columns processed by each thread
+  //! (in a statically scheduled loop over the columns) are on its node.
+  FIRST_TOUCH_PLACEMENT,
+  //! Spread the pages of each matrix over all the nodes in turn (this needs
+  //! libnuma; otherwise first touch is used).
+  INTERLEAVED_PLACEMENT
+};
+
+//! Set where the pages of large matrices are put.
+void SetMemoryPlacement(const MemoryPlacement placement);
+//! Get where the pages of large matrices are put.
+MemoryPlacement GetMemoryPlacement();
+
+//! Set whether large matrices are backed by huge pages (where the operating
+//! system supports transparent huge pages).
+void SetHugePages(const bool hugePages);
+//! Get whether large matrices are backed by huge pages.
+bool HugePages();
+
+/**
+ * Apply the current interleaving and huge page settings to the given memory,
+ * which must not have been written to yet (pages are only placed when they are
+ * first touched).  Only the whole pages in the range are affected.
+ *
+ * @param memory Start of the memory.
+ * @param bytes Size of the memory.
+ */
+void AdviseMemory(void* memory, const size_t bytes);
+
+/**
+ * Pin each of the threads used by parallel regions (see NumThreads()) to its
+ * own CPU, among the CPUs this process may run on, so that the threads do not
+ * move away from the memory they placed.  This relies on the OpenMP runtime
+ * reusing the same threads for later parallel regions, as the common ones do.
+ * This is only supported on Linux.
+ *
+ * @return false if the threads could not be pinned.
+ */
+bool PinThreads();
+
+//! The smallest matrix (in bytes) that PlaceMatrix() moves.
+const size_t placementThreshold = 1 << 20;
+
+/**
+ * Move the elements of the given matrix to new memory placed according to the
+ * current settings (GetMemoryPlacement() and HugePages()).  The new memory is
+ * first written by a statically scheduled parallel loop over the columns, so
+ * with first-touch placement the columns are on the nodes of the threads that
+ * process them in such loops.  Nothing is done for small matrices, for
+ * matrices that do not own their memory (such as memory-mapped matrices), or
+ * with the default settings.  The size and the elements of the matrix do not
+ * change, but its memory does.
+ *
+ * @param matrix Matrix to place.
+ */
+template<typename eT>
+void PlaceMatrix(arma::Mat<eT>& matrix)
+{
+  if (GetMemoryPlacement() == DEFAULT_PLACEMENT && !HugePages())
+    return;
+  if (matrix.n_elem * sizeof(eT) < placementThreshold || matrix.mem_state != 0)
+    return;
+
+  // Armadillo does not initialize the memory, so no page is touched yet.
+  arma::Mat<eT> placed(matrix.n_rows, matrix.n_cols);
+  AdviseMemory(placed.memptr(), placed.n_elem * sizeof(eT));
+
+  const size_t numColumns = matrix.n_cols;
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < numColumns; ++i)
+    std::copy(matrix.colptr(i), matrix.colptr(i) + matrix.n_rows,
+        placed.colptr(i));
+
+  matrix.steal_mem(placed);
+}
+
+/**
+ * Other matrix types (such as sparse matrices) are not placed.
+ */
+template<typename MatType>
+void PlaceMatrix(MatType& /* matrix */) { }
+
+}; // namespace util
+}; // namespace mlpack
+
+#endif
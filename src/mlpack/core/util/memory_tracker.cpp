@@ -0,0 +1,358 @@
+/**
+ * @file memory_tracker.cpp
+ *
+ * Implementation of the MemoryTracker.
+ */
+#include "memory_tracker.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#if defined(__GLIBC__)
+  #include <malloc.h> // mallinfo()
+#endif
+
+#if defined(__unix__) || defined(__unix) || \
+    (defined(__MACH__) && defined(__APPLE__))
+  #include <sys/resource.h> // getrusage()
+  #define MLPACK_MEMORY_TRACKER_HAS_RUSAGE
+#endif
+
+using namespace mlpack;
+
+namespace {
+
+//! The state of one phase.
+struct Phase
+{
+  Phase() :
+      runs(0), heapGrowth(0), liveBytes(0), peakResidentBytes(0),
+      active(false), startLiveBytes(0) { }
+
+  size_t runs;
+  boost::int64_t heapGrowth;
+  size_t liveBytes;
+  size_t peakResidentBytes;
+  //! Whether the phase is running now.
+  bool active;
+  //! The heap memory in use when the current run started.
+  size_t startLiveBytes;
+};
+
+std::map<std::string, Phase>& PhaseMap()
+{
+  static std::map<std::string, Phase> phases;
+  return phases;
+}
+
+std::map<std::string, size_t>& CounterMap()
+{
+  static std::map<std::string, size_t> counters;
+  return counters;
+}
+
+#if defined(__linux__)
+/**
+ * Read the given field (such as "VmRSS:") of /proc/self/status, in bytes, or
+ * return 0 if it isn't there.
+ */
+size_t ReadStatusField(const std::string& field)
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.compare(0, field.size(), field) == 0)
+    {
+      std::istringstream value(line.substr(field.size()));
+      size_t kilobytes = 0;
+      value >> kilobytes;
+      return kilobytes * 1024;
+    }
+  }
+
+  return 0;
+}
+#endif
+
+/**
+ * Reset the peak resident set size of the process to its current resident set
+ * size, where possible (Linux 4.0 and later); return whether it was reset.
+ */
+bool ResetPeakResidentBytes()
+{
+#if defined(__linux__)
+  static bool canReset = true;
+  if (!canReset)
+    return false;
+
+  std::FILE* clearRefs = std::fopen("/proc/self/clear_refs", "w");
+  canReset = (clearRefs != NULL) && (std::fputs("5", clearRefs) >= 0);
+  if (clearRefs != NULL)
+    canReset = (std::fclose(clearRefs) == 0) && canReset;
+
+  return canReset;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Fold the peak resident set size since the last phase boundary into the peak
+ * of each running phase, and start measuring the next peak.  This must be
+ * called with the tracker locked.
+ */
+void UpdatePeaks()
+{
+  const size_t peak = MemoryTracker::PeakResidentBytes();
+
+  std::map<std::string, Phase>& phases = PhaseMap();
+  for (std::map<std::string, Phase>::iterator it = phases.begin();
+       it != phases.end(); ++it)
+  {
+    if (it->second.active)
+      it->second.peakResidentBytes = std::max(it->second.peakResidentBytes,
+          peak);
+  }
+
+  ResetPeakResidentBytes();
+}
+
+//! Format a number of bytes for people to read.
+std::string FormatBytes(const double bytes)
+{
+  const char* units[] = { "B", "kB", "MB", "GB", "TB" };
+  double value = bytes;
+  size_t unit = 0;
+  while ((value >= 1024.0 || value <= -1024.0) && unit < 4)
+  {
+    value /= 1024.0;
+    ++unit;
+  }
+
+  std::ostringstream convert;
+  convert.precision((unit == 0) ? 0 : 1);
+  convert << std::fixed << value << " " << units[unit];
+  return convert.str();
+}
+
+//! Escape the given string for JSON.
+std::string EscapeJSON(const std::string& s)
+{
+  std::string escaped;
+  for (size_t c = 0; c < s.size(); ++c)
+  {
+    if (s[c] == '"' || s[c] == '\\')
+      escaped += '\\';
+    escaped += s[c];
+  }
+
+  return escaped;
+}
+
+} // anonymous namespace
+
+void MemoryTracker::StartPhase(const std::string& name)
+{
+  #pragma omp critical(mlpackMemoryTracker)
+  {
+    UpdatePeaks();
+
+    Phase& phase = PhaseMap()[name];
+    phase.active = true;
+    phase.startLiveBytes = LiveBytes();
+    phase.peakResidentBytes = std::max(phase.peakResidentBytes,
+        ResidentBytes());
+  }
+}
+
+void MemoryTracker::StopPhase(const std::string& name)
+{
+  #pragma omp critical(mlpackMemoryTracker)
+  {
+    std::map<std::string, Phase>::iterator it = PhaseMap().find(name);
+    if (it != PhaseMap().end() && it->second.active)
+    {
+      UpdatePeaks();
+
+      Phase& phase = it->second;
+      const size_t live = LiveBytes();
+      phase.heapGrowth += (boost::int64_t) live -
+          (boost::int64_t) phase.startLiveBytes;
+      phase.liveBytes = live;
+      phase.active = false;
+      ++phase.runs;
+    }
+  }
+}
+
+void MemoryTracker::AddCounter(const std::string& name, const size_t value)
+{
+  #pragma omp critical(mlpackMemoryTracker)
+  CounterMap()[name] += value;
+}
+
+size_t MemoryTracker::Counter(const std::string& name)
+{
+  size_t value = 0;
+  #pragma omp critical(mlpackMemoryTracker)
+  {
+    std::map<std::string, size_t>::const_iterator it = CounterMap().find(name);
+    if (it != CounterMap().end())
+      value = it->second;
+  }
+
+  return value;
+}
+
+std::vector<MemoryTracker::PhaseStatistics> MemoryTracker::Phases()
+{
+  std::vector<PhaseStatistics> statistics;
+  #pragma omp critical(mlpackMemoryTracker)
+  {
+    const std::map<std::string, Phase>& phases = PhaseMap();
+    for (std::map<std::string, Phase>::const_iterator it = phases.begin();
+         it != phases.end(); ++it)
+    {
+      if (it->second.runs == 0)
+        continue;
+
+      PhaseStatistics s;
+      s.name = it->first;
+      s.runs = it->second.runs;
+      s.heapGrowth = it->second.heapGrowth;
+      s.liveBytes = it->second.liveBytes;
+      s.peakResidentBytes = it->second.peakResidentBytes;
+      statistics.push_back(s);
+    }
+  }
+
+  return statistics;
+}
+
+std::map<std::string, size_t> MemoryTracker::Counters()
+{
+  std::map<std::string, size_t> counters;
+  #pragma omp critical(mlpackMemoryTracker)
+  counters = CounterMap();
+
+  return counters;
+}
+
+void MemoryTracker::PrintSummary()
+{
+  const std::vector<PhaseStatistics> phases = Phases();
+  if (!phases.empty())
+  {
+    Log::Info << "Program memory:" << std::endl;
+    for (size_t i = 0; i < phases.size(); ++i)
+    {
+      const PhaseStatistics& s = phases[i];
+      Log::Info << "  " << s.name << ": heap growth "
+          << FormatBytes((double) s.heapGrowth) << ", live "
+          << FormatBytes((double) s.liveBytes) << ", peak RSS "
+          << FormatBytes((double) s.peakResidentBytes) << std::endl;
+    }
+  }
+
+  const std::map<std::string, size_t> counters = Counters();
+  if (!counters.empty())
+  {
+    Log::Info << "Program counters:" << std::endl;
+    for (std::map<std::string, size_t>::const_iterator it = counters.begin();
+         it != counters.end(); ++it)
+      Log::Info << "  " << it->first << ": " << it->second << std::endl;
+  }
+}
+
+bool MemoryTracker::WriteJSON(const std::string& filename)
+{
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::trunc);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << filename << "' to write the memory "
+        << "statistics to." << std::endl;
+    return false;
+  }
+
+  const std::vector<PhaseStatistics> phases = Phases();
+  stream << "{\"phases\":[";
+  for (size_t i = 0; i < phases.size(); ++i)
+  {
+    const PhaseStatistics& s = phases[i];
+    stream << ((i == 0) ? "\n" : ",\n") << "{\"name\":\""
+        << EscapeJSON(s.name) << "\",\"runs\":" << s.runs
+        << ",\"heap_growth\":" << s.heapGrowth << ",\"live_bytes\":"
+        << s.liveBytes << ",\"peak_resident_bytes\":" << s.peakResidentBytes
+        << "}";
+  }
+
+  const std::map<std::string, size_t> counters = Counters();
+  stream << "\n],\"counters\":{";
+  for (std::map<std::string, size_t>::const_iterator it = counters.begin();
+       it != counters.end(); ++it)
+  {
+    stream << ((it == counters.begin()) ? "\n" : ",\n") << "\""
+        << EscapeJSON(it->first) << "\":" << it->second;
+  }
+  stream << "\n}}" << std::endl;
+
+  return stream.good();
+}
+
+void MemoryTracker::Reset()
+{
+  #pragma omp critical(mlpackMemoryTracker)
+  {
+    PhaseMap().clear();
+    CounterMap().clear();
+  }
+}
+
+size_t MemoryTracker::LiveBytes()
+{
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+  #if __GLIBC_PREREQ(2, 33)
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+  #else
+    // The fields of mallinfo() are ints, which wrap around above 2GB.
+    const struct mallinfo info = mallinfo();
+    return (size_t) (unsigned int) info.uordblks +
+        (size_t) (unsigned int) info.hblkhd;
+  #endif
+#else
+  return 0;
+#endif
+}
+
+size_t MemoryTracker::ResidentBytes()
+{
+#if defined(__linux__)
+  return ReadStatusField("VmRSS:");
+#else
+  return 0;
+#endif
+}
+
+size_t MemoryTracker::PeakResidentBytes()
+{
+#if defined(__linux__)
+  return ReadStatusField("VmHWM:");
+#elif defined(MLPACK_MEMORY_TRACKER_HAS_RUSAGE)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+  #if defined(__MACH__) && defined(__APPLE__)
+    return (size_t) usage.ru_maxrss; // In bytes.
+  #else
+    return (size_t) usage.ru_maxrss * 1024; // In kilobytes.
+  #endif
+#else
+  return 0;
+#endif
+}
@@ -0,0 +1,122 @@
+/**
+ * @file memory_tracker.hpp
+ *
+ * Tracking of the memory used during each timer phase (such as tree_building
+ * or computing_neighbors), and named counters (such as the number of tree
+ * nodes built), so that the memory a program needs can be measured instead of
+ * guessed.
+ */
+#ifndef __MLPACK_CORE_UTIL_MEMORY_TRACKER_HPP
+#define __MLPACK_CORE_UTIL_MEMORY_TRACKER_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace mlpack {
+
+/**
+ * The MemoryTracker records, for each phase timed with Timer::Start() and
+ * Timer::Stop(), how much the heap grew during the phase, how much heap memory
+ * was in use when it ended, and the peak resident set size of the process
+ * while it ran.  Every call to Timer::Start() and Timer::Stop() is also a call
+ * to StartPhase() and StopPhase(), so nothing needs to be added to code that
+ * is already timed.  Phases may be nested (total_time holds every other
+ * phase); the peak of a phase includes the peaks of the phases inside it.
+ *
+ * The heap figures come from the C library's allocator statistics (mallinfo())
+ * and count every allocation, including the memory of Armadillo matrices; they
+ * are zero where the C library does not provide them (anything but glibc).
+ * The peak resident set size is exact for each phase on Linux 4.0 and later,
+ * where the high-water mark of the process is reset at each phase boundary;
+ * elsewhere it is the peak of the process up to the end of the phase.
+ *
+ * Counters accumulate other quantities worth reporting, such as the number of
+ * tree nodes built ("tree_nodes") and the size of the copies made of datasets
+ * ("dataset_copy_bytes").
+ *
+ * Programs using CLI print the phases and counters with --verbose, and write
+ * them as JSON to the file given with --memory_json.
+ */
+class MemoryTracker
+{
+ public:
+  //! Memory statistics for one phase.
+  struct PhaseStatistics
+  {
+    //! Name of the phase (the name of its timer).
+    std::string name;
+    //! Number of times the phase was run.
+    size_t runs;
+    //! Growth of the heap (in bytes) during the phase, summed over its runs;
+    //! this is negative if the phase freed more than it allocated.
+    boost::int64_t heapGrowth;
+    //! Heap memory in use (in bytes) at the end of the last run of the phase.
+    size_t liveBytes;
+    //! Peak resident set size (in bytes) of the process during the phase.
+    size_t peakResidentBytes;
+  };
+
+  /**
+   * Start tracking the given phase.  This is called by Timer::Start().
+   *
+   * @param name Name of the phase.
+   */
+  static void StartPhase(const std::string& name);
+
+  /**
+   * Stop tracking the given phase.  This is called by Timer::Stop().  Nothing
+   * is done if the phase was not started.
+   *
+   * @param name Name of the phase.
+   */
+  static void StopPhase(const std::string& name);
+
+  /**
+   * Add the given value to the named counter (which starts at 0).
+   *
+   * @param name Name of the counter.
+   * @param value Value to add.
+   */
+  static void AddCounter(const std::string& name, const size_t value);
+
+  //! Return the value of the named counter (0 if nothing was added to it).
+  static size_t Counter(const std::string& name);
+
+  //! Return the statistics of every phase that has finished at least one run,
+  //! in order of their names.
+  static std::vector<PhaseStatistics> Phases();
+
+  //! Return every counter.
+  static std::map<std::string, size_t> Counters();
+
+  //! Print the statistics of every phase, and every counter, to Log::Info.
+  static void PrintSummary();
+
+  /**
+   * Write the statistics of every phase, and every counter, as JSON.
+   *
+   * @param filename File to write the statistics to.
+   * @return false if the file could not be written.
+   */
+  static bool WriteJSON(const std::string& filename);
+
+  //! Forget every phase and counter.
+  static void Reset();
+
+  //! Return the heap memory currently in use, in bytes (0 if unknown).
+  static size_t LiveBytes();
+
+  //! Return the current resident set size of the process, in bytes (0 if
+  //! unknown).
+  static size_t ResidentBytes();
+
+  //! Return the peak resident set size of the process since the last phase
+  //! boundary (on Linux) or since it started, in bytes (0 if unknown).
+  static size_t PeakResidentBytes();
+};
+
+}; // namespace mlpack
+
+#endif
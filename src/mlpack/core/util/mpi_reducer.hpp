@@ -0,0 +1,88 @@
+/**
+ * @file mpi_reducer.hpp
+ *
+ * The MPIReducer, which sums values over the processes of an MPI communicator.
+ * This is not included by core.hpp, since it needs MPI.
+ */
+#ifndef __MLPACK_CORE_UTIL_MPI_REDUCER_HPP
+#define __MLPACK_CORE_UTIL_MPI_REDUCER_HPP
+
+#include <mpi.h>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+namespace mlpack {
+namespace util {
+
+/**
+ * A reducer (see LocalReducer) which sums values over all the processes of an
+ * MPI communicator with MPI_Allreduce().  MPI must already be initialized.
+ */
+class MPIReducer
+{
+ public:
+  /**
+   * Create the reducer for the given communicator.
+   *
+   * @param communicator Communicator of the processes to sum over.
+   */
+  MPIReducer(const MPI_Comm communicator = MPI_COMM_WORLD) :
+      communicator(communicator)
+  {
+    int rank, size;
+    MPI_Comm_rank(communicator, &rank);
+    MPI_Comm_size(communicator, &size);
+    this->rank = (size_t) rank;
+    numNodes = (size_t) size;
+  }
+
+  //! Replace the n values with their sums over all the processes.
+  void Sum(double* values, const size_t n)
+  {
+    if (n > 0)
+      MPI_Allreduce(MPI_IN_PLACE, values, (int) n, MPI_DOUBLE, MPI_SUM,
+          communicator);
+  }
+
+  //! Get the rank of this process.
+  size_t Rank() const { return rank; }
+  //! Get the number of processes.
+  size_t NumNodes() const { return numNodes; }
+
+ private:
+  //! The communicator to sum over.
+  MPI_Comm communicator;
+  //! The rank of this process.
+  size_t rank;
+  //! The number of processes.
+  size_t numNodes;
+};
+
+/**
+ * Replace every occurrence of '%r' in the given file name with the given rank,
+ * so that the programs run with MPI can load and save a file for each process.
+ *
+ * @param filename File name, possibly containing '%r'.
+ * @param rank Rank of the process.
+ */
+inline std::string RankFileName(const std::string& filename, const size_t rank)
+{
+  std::ostringstream rankString;
+  rankString << rank;
+
+  std::string result = filename;
+  size_t position = result.find("%r");
+  while (position != std::string::npos)
+  {
+    result.replace(position, 2, rankString.str());
+    position = result.find("%r", position + rankString.str().size());
+  }
+
+  return result;
+}
+
+}; // namespace util
+}; // namespace mlpack
+
+#endif
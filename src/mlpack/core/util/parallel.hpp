@@ -0,0 +1,238 @@
+/**
+ * @file parallel.hpp
+ *
+ * Parallel loops, reductions and task groups, built on OpenMP, so that parallel
+ * code does not have to repeat the same OpenMP boilerplate.  Without OpenMP,
+ * everything here runs serially.
+ */
+#ifndef __MLPACK_CORE_UTIL_PARALLEL_HPP
+#define __MLPACK_CORE_UTIL_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+// OpenMP tasks need OpenMP 3.0.
+#if defined(HAS_OPENMP) && defined(_OPENMP) && (_OPENMP >= 200805)
+  #define MLPACK_HAS_OPENMP_TASKS
+#endif
+
+namespace mlpack {
+namespace util {
+
+/**
+ * Get the number of threads that parallel regions will use (this is set by the
+ * --threads option of programs using CLI, or by SetNumThreads()).
+ */
+inline size_t NumThreads()
+{
+#ifdef HAS_OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+/**
+ * Set the number of threads that parallel regions will use.  If threads is 0,
+ * nothing is changed.
+ *
+ * @param threads Number of threads to use.
+ */
+inline void SetNumThreads(const size_t threads)
+{
+#ifdef HAS_OPENMP
+  if (threads > 0)
+    omp_set_num_threads((int) threads);
+#else
+  (void) threads;
+#endif
+}
+
+/**
+ * Call the given function on each block of grain consecutive indices in
+ * [begin, end) (the last block may be smaller), in parallel.  The blocks are
+ * handed out to the threads one at a time, so blocks of uneven cost are spread
+ * evenly.  The function is called from several threads at once, as
+ *
+ * @code
+ * void operator()(const size_t begin, const size_t end) const;
+ * @endcode
+ *
+ * for the indices begin through (end - 1), so it must be safe to call
+ * concurrently on distinct blocks.
+ *
+ * @param begin First index.
+ * @param end One past the last index.
+ * @param grain Number of indices in each block.
+ * @param function Function to call on each block.
+ */
+template<typename FunctionType>
+void ParallelFor(const size_t begin,
+                 const size_t end,
+                 const size_t grain,
+                 const FunctionType& function)
+{
+  if (end <= begin)
+    return;
+
+  const size_t grainSize = std::max((size_t) 1, grain);
+  const size_t numBlocks = (end - begin + grainSize - 1) / grainSize;
+
+  #pragma omp parallel for schedule(dynamic, 1) if (numBlocks > 1)
+  for (size_t b = 0; b < numBlocks; ++b)
+  {
+    const size_t blockBegin = begin + b * grainSize;
+    function(blockBegin, std::min(end, blockBegin + grainSize));
+  }
+}
+
+/**
+ * Reduce [begin, end) in parallel, in blocks of grain consecutive indices.  As
+ * with optimization::ParallelSum(), each thread accumulates its blocks into its
+ * own copy of the identity, and the copies are added (with operator+=) in
+ * thread order at the end, so the result is the same in each run with the same
+ * number of threads.  The function is called concurrently as
+ *
+ * @code
+ * void operator()(const size_t begin, const size_t end, T& sum) const;
+ * @endcode
+ *
+ * and must add the terms of indices begin through (end - 1) to sum.
+ *
+ * @param begin First index.
+ * @param end One past the last index.
+ * @param grain Number of indices in each block.
+ * @param identity Value to start each sum from (such as zero).
+ * @param function Function accumulating the terms of each block.
+ * @return Sum of the terms of all the indices.
+ */
+template<typename T, typename FunctionType>
+T ParallelReduce(const size_t begin,
+                 const size_t end,
+                 const size_t grain,
+                 const T& identity,
+                 const FunctionType& function)
+{
+  if (end <= begin)
+    return identity;
+
+  const size_t grainSize = std::max((size_t) 1, grain);
+  const size_t numBlocks = (end - begin + grainSize - 1) / grainSize;
+  const size_t numThreads = std::max((size_t) 1, std::min(numBlocks,
+      NumThreads()));
+
+  std::vector<T> threadSums(numThreads, identity);
+
+  #pragma omp parallel num_threads(numThreads) if (numThreads > 1)
+  {
+    size_t thread = 0;
+#ifdef HAS_OPENMP
+    thread = (size_t) omp_get_thread_num();
+#endif
+
+    #pragma omp for schedule(static, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t blockBegin = begin + b * grainSize;
+      function(blockBegin, std::min(end, blockBegin + grainSize),
+          threadSums[thread]);
+    }
+  }
+
+  T sum = threadSums[0];
+  for (size_t t = 1; t < numThreads; ++t)
+    sum += threadSums[t];
+
+  return sum;
+}
+
+/**
+ * A TaskGroup runs tasks (such as the recursions into the children of a tree
+ * node) asynchronously, as OpenMP tasks, and waits for them.  Tasks only run in
+ * parallel inside a parallel region, so the root of the recursion should be
+ * started with RunTasks(); elsewhere (or without OpenMP 3.0) each task is run
+ * immediately.  Each task is copied, and called with no arguments:
+ *
+ * @code
+ * struct Recursion
+ * {
+ *   void operator()() const
+ *   {
+ *     TaskGroup group;
+ *     if (node->Left())
+ *       group.Run(Recursion(node->Left()));
+ *     if (node->Right())
+ *       group.Run(Recursion(node->Right()));
+ *     group.Wait();
+ *     ...
+ *   }
+ * };
+ *
+ * RunTasks(Recursion(root));
+ * @endcode
+ */
+class TaskGroup
+{
+ public:
+  /**
+   * Run the given task (asynchronously, if inside a parallel region).  The task
+   * is copied, so any output must be through pointers or references it holds.
+   *
+   * @param task Task to run.
+   */
+  template<typename TaskType>
+  void Run(const TaskType& task)
+  {
+#ifdef MLPACK_HAS_OPENMP_TASKS
+    TaskType taskCopy(task);
+    #pragma omp task firstprivate(taskCopy)
+    taskCopy();
+#else
+    task();
+#endif
+  }
+
+  //! Wait for all of the tasks run by this thread's current task to finish.
+  void Wait()
+  {
+#ifdef MLPACK_HAS_OPENMP_TASKS
+    #pragma omp taskwait
+#endif
+  }
+};
+
+/**
+ * Start a parallel region (unless already inside one) in which the given task
+ * is run by one thread, and the tasks it starts with a TaskGroup are run by all
+ * the threads.  This returns when all the tasks have finished.
+ *
+ * @param task Root task to run.
+ */
+template<typename TaskType>
+void RunTasks(const TaskType& task)
+{
+#ifdef MLPACK_HAS_OPENMP_TASKS
+  if (!omp_in_parallel())
+  {
+    #pragma omp parallel
+    {
+      #pragma omp single
+      task();
+    }
+
+    return;
+  }
+#endif
+
+  task();
+}
+
+}; // namespace util
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ * @file parameter_sweep.hpp
+ *
+ * A harness for k-fold cross-validation over a set of parameter
+ * configurations, which runs the (configuration, fold) evaluations in parallel
+ * and shares the data prepared for each fold between the configurations.
+ */
+#ifndef __MLPACK_CORE_UTIL_PARAMETER_SWEEP_HPP
+#define __MLPACK_CORE_UTIL_PARAMETER_SWEEP_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace util {
+
+/**
+ * The ParameterSweep class evaluates a number of configurations of a method
+ * (such as different leaf sizes, numbers of Gaussians, or values of lambda)
+ * with k-fold cross-validation, in one process: the dataset is loaded once,
+ * the points are split into folds once, and anything that does not depend on
+ * the configuration (such as a tree built on the training points of a fold) is
+ * prepared once for each fold and then shared, read-only, by the evaluations
+ * of every configuration on that fold.  The folds are prepared in parallel,
+ * and then all the (configuration, fold) pairs are evaluated in parallel (see
+ * ParallelFor()), each timed separately.
+ *
+ * What is evaluated is given by the TaskType, which must implement
+ *
+ * @code
+ * // Data shared by the evaluations of one fold.
+ * typedef ... FoldDataType;
+ *
+ * // Prepare the data of a fold (or return NULL, if nothing is shared).
+ * FoldDataType* Prepare(const arma::uvec& training,
+ *                       const arma::uvec& test) const;
+ *
+ * // Train the given configuration on the training points of a fold and
+ * // return its score on the test points.
+ * double Evaluate(const size_t configuration,
+ *                 const FoldDataType* foldData,
+ *                 const arma::uvec& training,
+ *                 const arma::uvec& test) const;
+ * @endcode
+ *
+ * where training and test hold the (sorted) indices of the points of the fold.
+ * Both functions are called from several threads at once, so they must not
+ * modify the task or the fold data.  The fold data is deleted at the end of
+ * Run().  Scores can be anything (accuracy, log-likelihood, squared error); see
+ * BestConfiguration().
+ *
+ * An example, which picks lambda for ridge regression:
+ *
+ * @code
+ * class RidgeTask
+ * {
+ *  public:
+ *   typedef int FoldDataType; // Nothing is shared.
+ *
+ *   RidgeTask(const arma::mat& x, const arma::vec& y, const arma::vec& lambdas)
+ *       : x(x), y(y), lambdas(lambdas) { }
+ *
+ *   FoldDataType* Prepare(const arma::uvec&, const arma::uvec&) const
+ *   { return NULL; }
+ *
+ *   double Evaluate(const size_t c, const FoldDataType*,
+ *                   const arma::uvec& training, const arma::uvec& test) const
+ *   {
+ *     regression::LinearRegression lr(x.cols(training), y.elem(training),
+ *         lambdas[c]);
+ *     return -lr.ComputeError(x.cols(test), y.elem(test));
+ *   }
+ *
+ *  private:
+ *   const arma::mat& x;
+ *   const arma::vec& y;
+ *   const arma::vec& lambdas;
+ * };
+ *
+ * ParameterSweep<RidgeTask> sweep(x.n_cols, 10);
+ * sweep.Run(RidgeTask(x, y, lambdas), lambdas.n_elem);
+ * sweep.Report();
+ * const double lambda = lambdas[sweep.BestConfiguration()];
+ * @endcode
+ *
+ * @tparam TaskType Task that prepares folds and evaluates configurations.
+ */
+template<typename TaskType>
+class ParameterSweep
+{
+ public:
+  /**
+   * Split the given number of points into folds of (almost) equal size.  If
+   * shuffle is true, the points are assigned to folds at random (with
+   * math::RandInt()); otherwise each fold is a contiguous block of points.
+   *
+   * @param numPoints Number of points in the dataset.
+   * @param folds Number of folds (at least 2, and at most numPoints).
+   * @param shuffle Whether to assign the points to folds at random.
+   */
+  ParameterSweep(const size_t numPoints,
+                 const size_t folds,
+                 const bool shuffle = true);
+
+  /**
+   * Evaluate each of the given number of configurations (0 through
+   * configurations - 1) on each fold.  The scores and times of an earlier run
+   * are overwritten.
+   *
+   * @param task Task to run.
+   * @param configurations Number of configurations to evaluate.
+   */
+  void Run(const TaskType& task, const size_t configurations);
+
+  /**
+   * Return the configuration with the best mean score over the folds.
+   *
+   * @param higherIsBetter Whether higher scores are better (as for accuracy);
+   *     if false, lower scores are better (as for errors).
+   */
+  size_t BestConfiguration(const bool higherIsBetter = true) const;
+
+  /**
+   * Print the mean score, the standard deviation of the score over the folds,
+   * and the total evaluation time of each configuration to Log::Info (so this
+   * is shown with --verbose).
+   *
+   * @param names Names of the configurations (such as "leaf_size = 20"); if
+   *     empty, the configurations are numbered.
+   */
+  void Report(const std::vector<std::string>& names =
+      std::vector<std::string>()) const;
+
+  //! Get the number of folds.
+  size_t Folds() const { return trainingIndices.size(); }
+  //! Get the (sorted) indices of the training points of the given fold.
+  const arma::uvec& TrainingIndices(const size_t fold) const
+  { return trainingIndices[fold]; }
+  //! Get the (sorted) indices of the test points of the given fold.
+  const arma::uvec& TestIndices(const size_t fold) const
+  { return testIndices[fold]; }
+
+  //! Get the score of each configuration (row) on each fold (column).
+  const arma::mat& Scores() const { return scores; }
+  //! Get the time (in seconds) taken by each configuration (row) on each fold
+  //! (column).
+  const arma::mat& Times() const { return times; }
+  //! Get the time (in seconds) taken to prepare each fold.
+  const arma::vec& PrepareTimes() const { return prepareTimes; }
+  //! Get the wall-clock time (in seconds) taken by the last call to Run().
+  double TotalTime() const { return totalTime; }
+
+  //! Get the mean score of each configuration over the folds.
+  arma::vec MeanScores() const { return arma::mean(scores, 1); }
+  //! Get the standard deviation of the score of each configuration over the
+  //! folds.
+  arma::vec ScoreDeviations() const { return arma::stddev(scores, 0, 1); }
+
+ private:
+  //! The training points of each fold.
+  std::vector<arma::uvec> trainingIndices;
+  //! The test points of each fold.
+  std::vector<arma::uvec> testIndices;
+
+  //! The score of each configuration on each fold.
+  arma::mat scores;
+  //! The time taken by each configuration on each fold.
+  arma::mat times;
+  //! The time taken to prepare each fold.
+  arma::vec prepareTimes;
+  //! The time taken by the last run.
+  double totalTime;
+
+  //! Prepares the data of the folds of a block (for ParallelFor()).
+  class PrepareFunction;
+  //! Evaluates the (configuration, fold) pairs of a block (for ParallelFor()).
+  class EvaluateFunction;
+};
+
+}; // namespace util
+}; // namespace mlpack
+
+// Include implementation.
+#include "parameter_sweep_impl.hpp"
+
+#endif
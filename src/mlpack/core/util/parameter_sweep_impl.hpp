@@ -0,0 +1,227 @@
+/**
+ * @file parameter_sweep_impl.hpp
+ *
+ * Implementation of the ParameterSweep class.
+ */
+#ifndef __MLPACK_CORE_UTIL_PARAMETER_SWEEP_IMPL_HPP
+#define __MLPACK_CORE_UTIL_PARAMETER_SWEEP_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parameter_sweep.hpp"
+
+#include <iomanip>
+
+namespace mlpack {
+namespace util {
+
+template<typename TaskType>
+class ParameterSweep<TaskType>::PrepareFunction
+{
+ public:
+  PrepareFunction(const TaskType& task,
+                  const ParameterSweep& sweep,
+                  std::vector<typename TaskType::FoldDataType*>& foldData,
+                  arma::vec& prepareTimes) :
+      task(task),
+      sweep(sweep),
+      foldData(foldData),
+      prepareTimes(prepareTimes)
+  { }
+
+  void operator()(const size_t begin, const size_t end) const
+  {
+    for (size_t f = begin; f < end; ++f)
+    {
+      arma::wall_clock timer;
+      timer.tic();
+      foldData[f] = task.Prepare(sweep.TrainingIndices(f),
+          sweep.TestIndices(f));
+      prepareTimes[f] = timer.toc();
+    }
+  }
+
+ private:
+  const TaskType& task;
+  const ParameterSweep& sweep;
+  std::vector<typename TaskType::FoldDataType*>& foldData;
+  arma::vec& prepareTimes;
+};
+
+template<typename TaskType>
+class ParameterSweep<TaskType>::EvaluateFunction
+{
+ public:
+  EvaluateFunction(
+      const TaskType& task,
+      const ParameterSweep& sweep,
+      const std::vector<typename TaskType::FoldDataType*>& foldData,
+      arma::mat& scores,
+      arma::mat& times) :
+      task(task),
+      sweep(sweep),
+      foldData(foldData),
+      scores(scores),
+      times(times)
+  { }
+
+  void operator()(const size_t begin, const size_t end) const
+  {
+    // Pairs are numbered fold by fold, so that the threads working at the
+    // same time mostly share the data of one fold.
+    for (size_t i = begin; i < end; ++i)
+    {
+      const size_t f = i / scores.n_rows;
+      const size_t c = i % scores.n_rows;
+
+      arma::wall_clock timer;
+      timer.tic();
+      scores(c, f) = task.Evaluate(c, foldData[f], sweep.TrainingIndices(f),
+          sweep.TestIndices(f));
+      times(c, f) = timer.toc();
+    }
+  }
+
+ private:
+  const TaskType& task;
+  const ParameterSweep& sweep;
+  const std::vector<typename TaskType::FoldDataType*>& foldData;
+  arma::mat& scores;
+  arma::mat& times;
+};
+
+template<typename TaskType>
+ParameterSweep<TaskType>::ParameterSweep(const size_t numPoints,
+                                         const size_t folds,
+                                         const bool shuffle) :
+    totalTime(0.0)
+{
+  if (folds < 2 || folds > numPoints)
+  {
+    Log::Fatal << "ParameterSweep::ParameterSweep(): the number of folds ("
+        << folds << ") must be at least 2 and at most the number of points ("
+        << numPoints << ")." << std::endl;
+  }
+
+  std::vector<size_t> order(numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+    order[i] = i;
+
+  if (shuffle)
+  {
+    for (size_t i = numPoints - 1; i > 0; --i)
+      std::swap(order[i], order[(size_t) math::RandInt(0, (int) i + 1)]);
+  }
+
+  // The first (numPoints % folds) folds get one point more than the others.
+  std::vector<size_t> fold(numPoints);
+  size_t start = 0;
+  for (size_t f = 0; f < folds; ++f)
+  {
+    const size_t size = numPoints / folds + ((f < numPoints % folds) ? 1 : 0);
+    for (size_t i = start; i < start + size; ++i)
+      fold[order[i]] = f;
+    start += size;
+  }
+
+  // Collect the (sorted) indices of each fold.
+  std::vector<std::vector<size_t> > test(folds), training(folds);
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    for (size_t f = 0; f < folds; ++f)
+    {
+      if (fold[i] == f)
+        test[f].push_back(i);
+      else
+        training[f].push_back(i);
+    }
+  }
+
+  trainingIndices.resize(folds);
+  testIndices.resize(folds);
+  for (size_t f = 0; f < folds; ++f)
+  {
+    trainingIndices[f] = arma::conv_to<arma::uvec>::from(training[f]);
+    testIndices[f] = arma::conv_to<arma::uvec>::from(test[f]);
+  }
+}
+
+template<typename TaskType>
+void ParameterSweep<TaskType>::Run(const TaskType& task,
+                                   const size_t configurations)
+{
+  arma::wall_clock timer;
+  timer.tic();
+
+  const size_t folds = Folds();
+  scores.zeros(configurations, folds);
+  times.zeros(configurations, folds);
+  prepareTimes.zeros(folds);
+
+  // Prepare the data of each fold, and then evaluate every configuration on
+  // every fold.
+  std::vector<typename TaskType::FoldDataType*> foldData(folds,
+      (typename TaskType::FoldDataType*) NULL);
+  ParallelFor(0, folds, 1, PrepareFunction(task, *this, foldData,
+      prepareTimes));
+  ParallelFor(0, configurations * folds, 1, EvaluateFunction(task, *this,
+      foldData, scores, times));
+
+  for (size_t f = 0; f < folds; ++f)
+    delete foldData[f];
+
+  totalTime = timer.toc();
+  Log::Info << "Evaluated " << configurations << " configurations on " << folds
+      << " folds in " << totalTime << " seconds." << std::endl;
+}
+
+template<typename TaskType>
+size_t ParameterSweep<TaskType>::BestConfiguration(const bool higherIsBetter)
+    const
+{
+  if (scores.n_rows == 0)
+  {
+    Log::Fatal << "ParameterSweep::BestConfiguration(): no configurations have "
+        << "been evaluated." << std::endl;
+  }
+
+  const arma::vec means = MeanScores();
+  arma::uword best;
+  if (higherIsBetter)
+    means.max(best);
+  else
+    means.min(best);
+
+  return (size_t) best;
+}
+
+template<typename TaskType>
+void ParameterSweep<TaskType>::Report(const std::vector<std::string>& names)
+    const
+{
+  const arma::vec means = MeanScores();
+  const arma::vec deviations = ScoreDeviations();
+  const arma::vec configurationTimes = arma::sum(times, 1);
+
+  Log::Info << "Cross-validation results (" << Folds() << " folds; "
+      << arma::accu(prepareTimes) << " seconds preparing folds):" << std::endl;
+  for (size_t c = 0; c < scores.n_rows; ++c)
+  {
+    std::ostringstream name;
+    if (c < names.size())
+      name << names[c];
+    else
+      name << "configuration " << c;
+
+    // Format the whole line here, since Log::Info formats each value alone.
+    std::ostringstream line;
+    line << "  " << std::left << std::setw(24) << name.str() << " score "
+        << means[c] << " (+/- " << deviations[c] << "), "
+        << configurationTimes[c] << " seconds";
+    Log::Info << line.str() << std::endl;
+  }
+}
+
+}; // namespace util
+}; // namespace mlpack
+
+#endif
@@ -17,6 +17,7 @@
 #include <boost/utility/enable_if.hpp>
 #include <boost/type_traits.hpp>
 
+#include <mlpack/core/util/log_backend.hpp>
 #include <mlpack/core/util/sfinae_utility.hpp>
 #include <mlpack/core/util/string_util.hpp>
 
@@ -47,6 +48,10 @@ namespace util {
  *
  * These objects are used for the mlpack::Log levels (DEBUG, INFO, WARN, and
  * FATAL).
+ *
+ * Once LogBackend::Start() has been called, the stream is asynchronous: each
+ * thread builds its lines in its own buffer, and a line is written (by a
+ * background thread) once it ends with a newline.
  */
 class PrefixedOutStream
 {
@@ -157,6 +162,30 @@ class PrefixedOutStream
   template<typename T>
   void BaseLogic(const T& val);
 
+  /**
+   * The base logic of BaseLogic(), which takes a lock (if mlpack was compiled
+   * with OpenMP) so that the streams can be written to from several threads.
+   * Each value is written atomically, but the values written by different
+   * threads may still be interleaved within a line.
+   *
+   * @tparam T The type of the data to output.
+   * @param val The data to be output.
+   */
+  template<typename T>
+  void UnlockedBaseLogic(const T& val);
+
+  /**
+   * The base logic of BaseLogic() when the streams are asynchronous (see
+   * LogBackend): the value is added to the calling thread's buffer for this
+   * stream, without a lock, and each line it finishes is handed to the
+   * backend.
+   *
+   * @tparam T The type of the data to output.
+   * @param val The data to be output.
+   */
+  template<typename T>
+  void BufferedBaseLogic(const T& val);
+
   /**
    * Output the prefix, but only if we need to and if we are allowed to.
    */
@@ -61,6 +61,23 @@ void PrefixedOutStream::CallBaseLogic(const T& s,
 
 template<typename T>
 void PrefixedOutStream::BaseLogic(const T& val)
+{
+  // Asynchronous streams need no lock, since each thread has its own buffer.
+  if (LogBackend::Asynchronous())
+  {
+    if (!ignoreInput)
+      BufferedBaseLogic<T>(val);
+    return;
+  }
+
+  // The streams may be written to from several threads, so only one thread at
+  // a time writes to any of them.
+  #pragma omp critical(mlpackPrefixedOutStream)
+  UnlockedBaseLogic<T>(val);
+}
+
+template<typename T>
+void PrefixedOutStream::UnlockedBaseLogic(const T& val)
 {
   // We will use this to track whether or not we need to terminate at the end of
   // this call (only for streams which terminate after a newline).
@@ -133,6 +150,47 @@ void PrefixedOutStream::BaseLogic(const T& val)
     exit(1);
 }
 
+template<typename T>
+void PrefixedOutStream::BufferedBaseLogic(const T& val)
+{
+  std::ostringstream& buffer = LogBackend::LineBuffer(this);
+
+  // Stream manipulators go to the buffer too, and apply to the next value.
+  buffer << val;
+  if (buffer.fail())
+  {
+    buffer.clear();
+    buffer << "Failed lexical_cast<std::string>(T) for output; output not "
+        << "shown.\n";
+  }
+
+  const std::string text = buffer.str();
+  if (text.find('\n') == std::string::npos)
+    return;
+
+  // Hand every finished line to the backend at once, and keep the rest.
+  std::string lines;
+  size_t nl;
+  size_t pos = 0;
+  while ((nl = text.find('\n', pos)) != std::string::npos)
+  {
+    lines += prefix;
+    lines.append(text, pos, nl + 1 - pos);
+    pos = nl + 1;
+  }
+
+  buffer.str("");
+  buffer << text.substr(pos);
+  LogBackend::Submit(destination, lines);
+
+  // Everything before a fatal line must be written before terminating.
+  if (fatal)
+  {
+    LogBackend::Flush();
+    exit(1);
+  }
+}
+
 // This is an inline function (that is why it is here and not in .cc).
 void PrefixedOutStream::PrefixIfNeeded()
 {
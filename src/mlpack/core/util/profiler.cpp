@@ -0,0 +1,366 @@
+/**
+ * @file profiler.cpp
+ *
+ * Implementation of the Profiler.
+ */
+#include "profiler.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#if defined(_WIN32)
+  #include <windows.h> // QueryPerformanceCounter()
+#else
+  #include <time.h> // clock_gettime()
+  #include <sys/time.h> // gettimeofday()
+#endif
+
+// Each thread keeps a pointer to its own buffer.
+#if defined(_MSC_VER)
+  #define MLPACK_PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+  #define MLPACK_PROFILER_THREAD_LOCAL __thread
+#endif
+
+using namespace mlpack;
+
+namespace {
+
+/**
+ * Durations are counted in a histogram of 252 buckets.  Durations under 4
+ * ticks have their own buckets; above that, each power of two is split into
+ * four buckets, so each percentile is estimated to within about 12%.
+ */
+const size_t numBuckets = 252;
+
+//! Return the histogram bucket for the given duration.
+inline size_t Bucket(const boost::uint64_t ticks)
+{
+  if (ticks < 4)
+    return (size_t) ticks;
+
+#if defined(__GNUC__) || defined(__clang__)
+  const size_t exponent = 63 - __builtin_clzll(ticks);
+#else
+  size_t exponent = 0;
+  for (boost::uint64_t t = ticks; t > 1; t >>= 1)
+    ++exponent;
+#endif
+
+  return 4 + 4 * (exponent - 2) + (size_t) ((ticks >> (exponent - 2)) & 3);
+}
+
+//! Return the duration in the middle of the given histogram bucket.
+inline double BucketValue(const size_t bucket)
+{
+  if (bucket < 4)
+    return (double) bucket;
+
+  const size_t exponent = (bucket - 4) / 4 + 2;
+  const double width = (double) (((boost::uint64_t) 1) << (exponent - 2));
+  return width * (4 + (bucket - 4) % 4) + width / 2;
+}
+
+//! Statistics of one scope on one thread.
+struct ScopeRecord
+{
+  ScopeRecord() : calls(0), ticks(0), histogram(numBuckets, 0) { }
+
+  //! Number of runs.
+  boost::uint64_t calls;
+  //! Total duration of the runs.
+  boost::uint64_t ticks;
+  //! Histogram of the durations of the runs.
+  std::vector<boost::uint64_t> histogram;
+};
+
+//! One run of a scope, for the trace.
+struct Event
+{
+  //! The ID of the scope.
+  size_t id;
+  //! When the run started.
+  boost::uint64_t start;
+  //! When the run ended.
+  boost::uint64_t end;
+};
+
+//! Everything one thread has recorded.
+struct ThreadBuffer
+{
+  ThreadBuffer() : droppedEvents(0) { }
+
+  //! Statistics of each scope, indexed by ID.
+  std::vector<ScopeRecord> scopes;
+  //! Runs recorded for the trace.
+  std::vector<Event> events;
+  //! Runs not recorded for the trace because there were too many.
+  size_t droppedEvents;
+};
+
+//! The names of the scopes, indexed by ID.
+std::vector<std::string>& Names()
+{
+  static std::vector<std::string> names;
+  return names;
+}
+
+//! The buffers of every thread that has recorded anything.  They are never
+//! freed, since threads may still point to them.
+std::vector<ThreadBuffer*>& Buffers()
+{
+  static std::vector<ThreadBuffer*> buffers;
+  return buffers;
+}
+
+//! The calling thread's buffer.
+MLPACK_PROFILER_THREAD_LOCAL ThreadBuffer* threadBuffer = NULL;
+
+//! The time (in clock ticks and in nanoseconds) when profiling started, to
+//! calibrate the clock against.
+boost::uint64_t originTicks = 0;
+boost::uint64_t originNanoseconds = 0;
+
+} // anonymous namespace
+
+size_t Profiler::Register(const std::string& name)
+{
+  size_t id;
+  #pragma omp critical(mlpackProfiler)
+  {
+    if (Names().empty())
+    {
+      originTicks = Now();
+      originNanoseconds = MonotonicNanoseconds();
+    }
+
+    std::vector<std::string>& names = Names();
+    id = std::find(names.begin(), names.end(), name) - names.begin();
+    if (id == names.size())
+      names.push_back(name);
+  }
+
+  return id;
+}
+
+void Profiler::Record(const size_t id,
+                      const boost::uint64_t start,
+                      const boost::uint64_t end)
+{
+  if (threadBuffer == NULL)
+  {
+    #pragma omp critical(mlpackProfiler)
+    {
+      threadBuffer = new ThreadBuffer();
+      Buffers().push_back(threadBuffer);
+    }
+  }
+
+  if (id >= threadBuffer->scopes.size())
+    threadBuffer->scopes.resize(id + 1);
+
+  const boost::uint64_t ticks = (end > start) ? (end - start) : 0;
+  ScopeRecord& scope = threadBuffer->scopes[id];
+  ++scope.calls;
+  scope.ticks += ticks;
+  ++scope.histogram[Bucket(ticks)];
+
+  if (threadBuffer->events.size() < MaxTraceEvents())
+  {
+    Event event;
+    event.id = id;
+    event.start = start;
+    event.end = end;
+    threadBuffer->events.push_back(event);
+  }
+  else
+  {
+    ++threadBuffer->droppedEvents;
+  }
+}
+
+boost::uint64_t Profiler::MonotonicNanoseconds()
+{
+#if defined(_WIN32)
+  static LARGE_INTEGER frequency;
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return (boost::uint64_t) (1e9 * (double) counter.QuadPart /
+      (double) frequency.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (boost::uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return (boost::uint64_t) tv.tv_sec * 1000000000 + tv.tv_usec * 1000;
+#endif
+}
+
+double Profiler::TicksPerSecond()
+{
+#ifdef MLPACK_PROFILER_HAS_TSC
+  // Calibrate the time-stamp counter against the monotonic clock, over the
+  // time since the first scope was registered.
+  const double ticks = (double) (Now() - originTicks);
+  const double nanoseconds = (double) (MonotonicNanoseconds() -
+      originNanoseconds);
+  return (nanoseconds > 0) ? (1e9 * ticks / nanoseconds) : 1e9;
+#else
+  return 1e9;
+#endif
+}
+
+std::vector<Profiler::Statistics> Profiler::Summary()
+{
+  std::vector<Statistics> summary;
+  const double ticksPerSecond = TicksPerSecond();
+
+  #pragma omp critical(mlpackProfiler)
+  {
+    const std::vector<std::string>& names = Names();
+    const std::vector<ThreadBuffer*>& buffers = Buffers();
+    for (size_t id = 0; id < names.size(); ++id)
+    {
+      // Combine the records of every thread.
+      ScopeRecord combined;
+      for (size_t t = 0; t < buffers.size(); ++t)
+      {
+        if (id >= buffers[t]->scopes.size())
+          continue;
+
+        const ScopeRecord& record = buffers[t]->scopes[id];
+        combined.calls += record.calls;
+        combined.ticks += record.ticks;
+        for (size_t b = 0; b < numBuckets; ++b)
+          combined.histogram[b] += record.histogram[b];
+      }
+
+      if (combined.calls == 0)
+        continue;
+
+      Statistics statistics;
+      statistics.name = names[id];
+      statistics.calls = (size_t) combined.calls;
+      statistics.total = combined.ticks / ticksPerSecond;
+      statistics.mean = statistics.total / combined.calls;
+
+      // Find the buckets that hold each percentile.
+      const double percentiles[] = { 0.5, 0.9, 0.99 };
+      double* values[] = { &statistics.p50, &statistics.p90, &statistics.p99 };
+      boost::uint64_t cumulative = 0;
+      size_t p = 0;
+      for (size_t b = 0; b < numBuckets && p < 3; ++b)
+      {
+        cumulative += combined.histogram[b];
+        while (p < 3 && cumulative >= percentiles[p] * combined.calls)
+          *values[p++] = BucketValue(b) / ticksPerSecond;
+      }
+
+      summary.push_back(statistics);
+    }
+  }
+
+  return summary;
+}
+
+void Profiler::PrintSummary()
+{
+  const std::vector<Statistics> summary = Summary();
+  if (summary.empty())
+    return;
+
+  Log::Info << "Profiled scopes:" << std::endl;
+  for (size_t i = 0; i < summary.size(); ++i)
+  {
+    const Statistics& s = summary[i];
+    Log::Info << "  " << s.name << ": " << s.calls << " calls, " << s.total
+        << "s total, " << (s.mean * 1e6) << "us mean (50%: " << (s.p50 * 1e6)
+        << "us, 90%: " << (s.p90 * 1e6) << "us, 99%: " << (s.p99 * 1e6)
+        << "us)" << std::endl;
+  }
+}
+
+bool Profiler::WriteTrace(const std::string& filename)
+{
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::trunc);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << filename << "' to write the profile "
+        << "trace to." << std::endl;
+    return false;
+  }
+
+  const double ticksPerMicrosecond = TicksPerSecond() / 1e6;
+  size_t droppedEvents = 0;
+
+  stream << std::fixed << std::setprecision(3);
+  stream << "{\"traceEvents\":[";
+  bool first = true;
+  #pragma omp critical(mlpackProfiler)
+  {
+    const std::vector<std::string>& names = Names();
+    const std::vector<ThreadBuffer*>& buffers = Buffers();
+    for (size_t t = 0; t < buffers.size(); ++t)
+    {
+      const std::vector<Event>& events = buffers[t]->events;
+      for (size_t i = 0; i < events.size(); ++i)
+      {
+        // Escape the name for JSON.
+        std::string name;
+        for (size_t c = 0; c < names[events[i].id].size(); ++c)
+        {
+          const char character = names[events[i].id][c];
+          if (character == '"' || character == '\\')
+            name += '\\';
+          name += character;
+        }
+
+        const double start = (events[i].start - originTicks) /
+            ticksPerMicrosecond;
+        const double duration = (events[i].end - events[i].start) /
+            ticksPerMicrosecond;
+        stream << (first ? "\n" : ",\n") << "{\"name\":\"" << name
+            << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << t << ",\"ts\":"
+            << start << ",\"dur\":" << duration << "}";
+        first = false;
+      }
+
+      droppedEvents += buffers[t]->droppedEvents;
+    }
+  }
+  stream << "\n],\"displayTimeUnit\":\"ns\"}" << std::endl;
+
+  if (droppedEvents > 0)
+    Log::Warn << droppedEvents << " profiled runs were not written to the "
+        << "trace; increase Profiler::MaxTraceEvents() to keep them."
+        << std::endl;
+
+  return stream.good();
+}
+
+void Profiler::Reset()
+{
+  #pragma omp critical(mlpackProfiler)
+  {
+    std::vector<ThreadBuffer*>& buffers = Buffers();
+    for (size_t t = 0; t < buffers.size(); ++t)
+    {
+      buffers[t]->scopes.clear();
+      buffers[t]->events.clear();
+      buffers[t]->droppedEvents = 0;
+    }
+  }
+}
+
+size_t& Profiler::MaxTraceEvents()
+{
+  static size_t maxTraceEvents = 1000000;
+  return maxTraceEvents;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file profiler.hpp
+ *
+ * A low-overhead profiler for scopes inside hot loops (such as BaseCase() and
+ * Score()), where Timer::Start() and Timer::Stop() are far too expensive.
+ */
+#ifndef __MLPACK_CORE_UTIL_PROFILER_HPP
+#define __MLPACK_CORE_UTIL_PROFILER_HPP
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+  #include <x86intrin.h> // __rdtsc()
+  #define MLPACK_PROFILER_HAS_TSC
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h> // __rdtsc()
+  #define MLPACK_PROFILER_HAS_TSC
+#endif
+
+namespace mlpack {
+
+/**
+ * The Profiler records how long named scopes take, with much less overhead
+ * than Timer: each scope is given an integer ID once (when its name is
+ * registered), times are taken from the processor's time-stamp counter where
+ * there is one, and each thread records into its own buffer, so no locks are
+ * taken and no names are looked up while profiling.
+ *
+ * For each scope, the number of calls, the total time, and a histogram of the
+ * durations (from which percentiles are estimated) are kept.  The first
+ * MaxTraceEvents() calls on each thread are also recorded individually, and
+ * can be written as a Chrome trace (load it in chrome://tracing), where nested
+ * scopes show up nested.
+ *
+ * Scopes are usually profiled with the MLPACK_PROFILE_SCOPE() macro, which
+ * does nothing unless mlpack is compiled with the PROFILE_SCOPES CMake option
+ * (which defines MLPACK_PROFILE_SCOPES):
+ *
+ * @code
+ * double BaseCase(const size_t queryIndex, const size_t referenceIndex)
+ * {
+ *   MLPACK_PROFILE_SCOPE("BaseCase");
+ *   ...
+ * }
+ * @endcode
+ *
+ * Programs using CLI print a summary of the profiled scopes with --verbose, and
+ * write the trace to the file given with --profile_trace.
+ */
+class Profiler
+{
+ public:
+  //! Statistics for one profiled scope.
+  struct Statistics
+  {
+    //! Name of the scope.
+    std::string name;
+    //! Number of times the scope was run.
+    size_t calls;
+    //! Total time spent in the scope, in seconds.
+    double total;
+    //! Mean time spent in the scope, in seconds.
+    double mean;
+    //! Estimated median time spent in the scope, in seconds.
+    double p50;
+    //! Estimated 90th percentile of the time spent in the scope, in seconds.
+    double p90;
+    //! Estimated 99th percentile of the time spent in the scope, in seconds.
+    double p99;
+  };
+
+  /**
+   * Return the ID of the scope with the given name, registering it if it has
+   * not been seen before.  This takes a lock, so call it once for each scope,
+   * not each time the scope is run.
+   *
+   * @param name Name of the scope.
+   */
+  static size_t Register(const std::string& name);
+
+  //! Return the current time, in clock ticks.
+  static boost::uint64_t Now()
+  {
+#ifdef MLPACK_PROFILER_HAS_TSC
+    return (boost::uint64_t) __rdtsc();
+#else
+    return MonotonicNanoseconds();
+#endif
+  }
+
+  /**
+   * Record one run of the scope with the given ID, from start to end (in clock
+   * ticks, as given by Now()), in the calling thread's buffer.
+   */
+  static void Record(const size_t id,
+                     const boost::uint64_t start,
+                     const boost::uint64_t end);
+
+  //! Return the statistics of every scope that has been run, combined over all
+  //! threads.
+  static std::vector<Statistics> Summary();
+
+  //! Print the statistics of every scope that has been run to Log::Info.
+  static void PrintSummary();
+
+  /**
+   * Write the recorded runs of every scope as a Chrome trace (JSON).
+   *
+   * @param filename File to write the trace to.
+   * @return false if the file could not be written.
+   */
+  static bool WriteTrace(const std::string& filename);
+
+  //! Forget everything that has been recorded (the scope IDs are kept).
+  static void Reset();
+
+  //! Modify the maximum number of runs recorded individually for the trace, on
+  //! each thread (1000000 by default).  Runs beyond this are only counted.
+  static size_t& MaxTraceEvents();
+
+  //! Return the time from a monotonic clock, in nanoseconds.  This is slower
+  //! than Now(), but the times are comparable between processors.
+  static boost::uint64_t MonotonicNanoseconds();
+
+ private:
+  //! Return the number of clock ticks per second.
+  static double TicksPerSecond();
+};
+
+/**
+ * Records the time from its construction to its destruction as one run of the
+ * given scope.
+ */
+class ProfileScope
+{
+ public:
+  //! Start timing the scope with the given ID.
+  ProfileScope(const size_t id) : id(id), start(Profiler::Now()) { }
+
+  //! Stop timing, and record the run.
+  ~ProfileScope() { Profiler::Record(id, start, Profiler::Now()); }
+
+ private:
+  //! The ID of the scope.
+  size_t id;
+  //! When the scope was entered.
+  boost::uint64_t start;
+};
+
+}; // namespace mlpack
+
+#define MLPACK_PROFILE_JOIN_INTERNAL(A, B) A ## B
+#define MLPACK_PROFILE_JOIN(A, B) MLPACK_PROFILE_JOIN_INTERNAL(A, B)
+
+/**
+ * Profile the rest of the enclosing scope under the given name (which must be
+ * the same every time this line is run), if mlpack was compiled with
+ * MLPACK_PROFILE_SCOPES defined; otherwise, this does nothing.
+ */
+#ifdef MLPACK_PROFILE_SCOPES
+  #define MLPACK_PROFILE_SCOPE(NAME) \
+      static const size_t MLPACK_PROFILE_JOIN(mlpackProfileId, __LINE__) = \
+          mlpack::Profiler::Register(NAME); \
+      mlpack::ProfileScope MLPACK_PROFILE_JOIN(mlpackProfileScope, __LINE__)( \
+          MLPACK_PROFILE_JOIN(mlpackProfileId, __LINE__))
+#else
+  #define MLPACK_PROFILE_SCOPE(NAME)
+#endif
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @file progress_reporter.cpp
+ *
+ * Implementation of the ProgressReporter.
+ */
+#include "progress_reporter.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace mlpack;
+using namespace mlpack::util;
+
+ProgressReporter::ProgressReporter(const std::string& task,
+                                   const size_t total,
+                                   const double interval) :
+    task(task),
+    total(total),
+    interval((boost::uint64_t) (1e9 * std::max(interval, 0.0))),
+    start(Profiler::MonotonicNanoseconds()),
+    next(start + this->interval),
+    reports(0)
+{
+  // Nothing to do.
+}
+
+bool ProgressReporter::Claim()
+{
+  bool claimed = false;
+  #pragma omp critical(mlpackProgressReporter)
+  {
+    const boost::uint64_t now = Profiler::MonotonicNanoseconds();
+    if (now >= next)
+    {
+      next = now + interval;
+      ++reports;
+      claimed = true;
+    }
+  }
+
+  return claimed;
+}
+
+void ProgressReporter::Report(const size_t done)
+{
+  const double seconds = 1e-9 * (double) (Profiler::MonotonicNanoseconds() -
+      start);
+  const double rate = (seconds > 0.0) ? done / seconds : 0.0;
+
+  // Format the whole line here, since Log::Info formats each value alone.
+  std::ostringstream line;
+  line << task << ": ";
+  if (total > 0)
+  {
+    line.precision(1);
+    line << done << "/" << total << " (" << std::fixed
+        << (100.0 * done / total) << "%), ";
+  }
+  else
+  {
+    line << done << " done, ";
+  }
+
+  line.unsetf(std::ios::floatfield);
+  line.precision(4);
+  line << rate << " per second";
+  if (total > 0 && rate > 0.0 && done < total)
+    line << ", about " << (total - done) / rate << " seconds left";
+  line << ".";
+
+  Log::Info << line.str() << std::endl;
+}
+
+void ProgressReporter::Finish(const size_t done)
+{
+  if (Log::Info.ignoreInput)
+    return;
+
+  const double seconds = 1e-9 * (double) (Profiler::MonotonicNanoseconds() -
+      start);
+
+  #pragma omp critical(mlpackProgressReporter)
+  ++reports;
+
+  std::ostringstream line;
+  line << task << ": " << done << " done in " << seconds << " seconds.";
+  Log::Info << line.str() << std::endl;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file progress_reporter.hpp
+ *
+ * Rate-limited reports of the progress of long loops to Log::Info.
+ */
+#ifndef __MLPACK_CORE_UTIL_PROGRESS_REPORTER_HPP
+#define __MLPACK_CORE_UTIL_PROGRESS_REPORTER_HPP
+
+#include <string>
+#include <boost/cstdint.hpp>
+
+#include "log.hpp"
+#include "profiler.hpp"
+
+namespace mlpack {
+namespace util {
+
+/**
+ * Reports the progress of a long loop to Log::Info, at most once every few
+ * seconds, so that a loop can report every step without slowing down (or
+ * flooding the terminal).  When Log::Info is not shown, Update() is a single
+ * branch; otherwise it reads the clock, and only formats a report when one is
+ * due.
+ *
+ * @code
+ * util::ProgressReporter progress("Computing kernel rows", n);
+ * for (size_t i = 0; i < n; ++i)
+ * {
+ *   ComputeRow(i);
+ *   progress.Update(i + 1); // "Computing kernel rows: 513/2000 (25.6%), ..."
+ * }
+ * progress.Finish(n);
+ * @endcode
+ *
+ * Custom reports are written with Due():
+ *
+ * @code
+ * if (progress.Due())
+ *   Log::Info << "Iteration " << i << ": objective " << objective << std::endl;
+ * @endcode
+ *
+ * Update() and Due() may be called from several threads; only one of them
+ * gives each report.
+ */
+class ProgressReporter
+{
+ public:
+  /**
+   * Set up the reporter.  The first report is due after the given interval.
+   *
+   * @param task Name of the task, which starts each report.
+   * @param total Number of steps in the task, or 0 if it is unknown.
+   * @param interval Minimum time between two reports, in seconds.
+   */
+  ProgressReporter(const std::string& task,
+                   const size_t total = 0,
+                   const double interval = 1.0);
+
+  /**
+   * Return whether a report is due: Log::Info is shown, and the interval has
+   * passed since the last report (or since the reporter was set up).  If so,
+   * the next report is due one interval later.
+   */
+  bool Due()
+  {
+    if (Log::Info.ignoreInput)
+      return false;
+
+    return (Profiler::MonotonicNanoseconds() >= next) && Claim();
+  }
+
+  /**
+   * Report the number of steps done, with the rate and (if the total is known)
+   * the time left, if a report is due.
+   *
+   * @param done Number of steps done.
+   */
+  void Update(const size_t done)
+  {
+    if (Due())
+      Report(done);
+  }
+
+  /**
+   * Report that the task is done, and how long it took, whether or not a
+   * report is due.
+   *
+   * @param done Number of steps done.
+   */
+  void Finish(const size_t done);
+
+  //! Get the number of reports given (by Update(), Due(), and Finish()).
+  size_t Reports() const { return reports; }
+
+ private:
+  //! Take the report that is due, unless another thread just took it.
+  bool Claim();
+
+  //! Give a report of the steps done.
+  void Report(const size_t done);
+
+  //! Name of the task.
+  std::string task;
+  //! Number of steps in the task (0 if unknown).
+  size_t total;
+  //! Minimum time between two reports, in nanoseconds.
+  boost::uint64_t interval;
+  //! When the reporter was set up.
+  boost::uint64_t start;
+  //! When the next report is due.
+  boost::uint64_t next;
+  //! Number of reports given.
+  size_t reports;
+};
+
+}; // namespace util
+}; // namespace mlpack
+
+#endif
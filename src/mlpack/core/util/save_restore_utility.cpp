@@ -4,15 +4,112 @@
  * @author Michael Fox
  *
  * The SaveRestoreUtility provides helper functions in saving and
- *   restoring models.  The current output file type is XML.
+ *   restoring models.  Models are saved as XML, or in a binary format if the
+ *   filename ends in ".bin".
  */
 #include <mlpack/core.hpp>
 
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <boost/cstdint.hpp>
+
 using namespace mlpack;
 using namespace mlpack::util;
 
+namespace {
+
+//! The first 8 bytes of every binary model file.
+const char binaryMagic[8] = { 'M', 'L', 'P', 'A', 'C', 'K', 'S', 'R' };
+
+//! Write a 64-bit unsigned integer.
+void WriteSize(std::ostream& stream, const boost::uint64_t size)
+{
+  stream.write((const char*) &size, sizeof(size));
+}
+
+//! Write a length-prefixed string.
+void WriteString(std::ostream& stream, const std::string& str)
+{
+  WriteSize(stream, str.size());
+  stream.write(str.data(), str.size());
+}
+
+//! Read a 64-bit unsigned integer, moving position past it.
+bool ReadSize(const char*& position, const char* end, boost::uint64_t& size)
+{
+  if ((size_t) (end - position) < sizeof(size))
+    return false;
+
+  memcpy(&size, position, sizeof(size));
+  position += sizeof(size);
+  return true;
+}
+
+//! Read a length-prefixed string, moving position past it.
+bool ReadString(const char*& position, const char* end, std::string& str)
+{
+  boost::uint64_t size;
+  if (!ReadSize(position, end, size) || (boost::uint64_t) (end - position) <
+      size)
+    return false;
+
+  str.assign(position, (size_t) size);
+  position += size;
+  return true;
+}
+
+//! Format a matrix for XML, one row per line.
+std::string MatrixToString(const arma::mat& mat)
+{
+  std::ostringstream output;
+  size_t columns = mat.n_cols;
+  size_t rows = mat.n_rows;
+  for (size_t r = 0; r < rows; ++r)
+  {
+    for (size_t c = 0; c < columns - 1; ++c)
+    {
+      output << std::setprecision(15) << mat(r, c) << ",";
+    }
+    output << std::setprecision(15) << mat(r, columns - 1) << std::endl;
+  }
+  return output.str();
+}
+
+} // anonymous namespace
+
+bool SaveRestoreUtility::IsBinaryFile(const std::string& filename)
+{
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  char buffer[sizeof(binaryMagic)];
+  stream.read(buffer, sizeof(buffer));
+
+  return stream.good() && (memcmp(buffer, binaryMagic, sizeof(buffer)) == 0);
+}
+
 bool SaveRestoreUtility::ReadFile(const std::string& filename)
 {
+  if (IsBinaryFile(filename))
+  {
+    // Read the whole file at once, then take the nodes out of it.
+    std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+    stream.seekg(0, std::ios::end);
+    const size_t size = (size_t) stream.tellg();
+    stream.seekg(0, std::ios::beg);
+
+    std::vector<char> buffer(size);
+    stream.read(&buffer[0], size);
+
+    const char* position = &buffer[0] + sizeof(binaryMagic);
+    if (!stream.good() || !ReadBinary(position, &buffer[0] + size))
+    {
+      Log::Fatal << "Could not load binary model file '" << filename << "'!"
+          << std::endl;
+    }
+
+    return true;
+  }
+
   xmlDocPtr xmlDocTree = NULL;
   if (NULL == (xmlDocTree = xmlReadFile(filename.c_str(), NULL, 0)))
   {
@@ -28,6 +125,7 @@ bool SaveRestoreUtility::ReadFile(const std::string& filename)
 void SaveRestoreUtility::ReadFile(xmlNode* n)
 {
   parameters.clear();
+  matrices.clear();
   xmlNodePtr current = NULL;
   for (current = n; current; current = current->next)
   {
@@ -49,6 +147,15 @@ void SaveRestoreUtility::ReadFile(xmlNode* n)
 
 bool SaveRestoreUtility::WriteFile(const std::string& filename)
 {
+  if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".bin")
+  {
+    std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary |
+        std::ios::trunc);
+    stream.write(binaryMagic, sizeof(binaryMagic));
+    WriteBinary(stream);
+    return stream.good();
+  }
+
   bool success = false;
   xmlDocPtr xmlDocTree = xmlNewDoc(BAD_CAST "1.0");
   xmlNodePtr root = xmlNewNode(NULL, BAD_CAST "root");
@@ -64,8 +171,14 @@ bool SaveRestoreUtility::WriteFile(const std::string& filename)
 
 void SaveRestoreUtility::WriteFile(xmlNode* n)
 {
+  // Matrices are only formatted now that they are needed as strings.
+  std::map<std::string, std::string> strings(parameters);
+  for (std::map<std::string, arma::mat>::const_iterator it = matrices.begin();
+       it != matrices.end(); ++it)
+    strings[(*it).first] = MatrixToString((*it).second);
+
   for (std::map<std::string, std::string>::reverse_iterator it =
-	    parameters.rbegin(); it != parameters.rend(); ++it)
+	    strings.rbegin(); it != strings.rend(); ++it)
   {
     xmlNewChild(n, NULL, BAD_CAST(*it).first.c_str(),
         BAD_CAST(*it).second.c_str());
@@ -79,9 +192,95 @@ void SaveRestoreUtility::WriteFile(xmlNode* n)
   }
 }
 
+void SaveRestoreUtility::WriteBinary(std::ostream& stream) const
+{
+  WriteSize(stream, parameters.size());
+  for (std::map<std::string, std::string>::const_iterator it =
+       parameters.begin(); it != parameters.end(); ++it)
+  {
+    WriteString(stream, (*it).first);
+    WriteString(stream, (*it).second);
+  }
+
+  WriteSize(stream, matrices.size());
+  for (std::map<std::string, arma::mat>::const_iterator it = matrices.begin();
+       it != matrices.end(); ++it)
+  {
+    const arma::mat& matrix = (*it).second;
+    WriteString(stream, (*it).first);
+    WriteSize(stream, matrix.n_rows);
+    WriteSize(stream, matrix.n_cols);
+    stream.write((const char*) matrix.memptr(), matrix.n_elem *
+        sizeof(double));
+  }
+
+  WriteSize(stream, children.size());
+  for (std::map<std::string, SaveRestoreUtility>::const_iterator it =
+       children.begin(); it != children.end(); ++it)
+  {
+    WriteString(stream, (*it).first);
+    (*it).second.WriteBinary(stream);
+  }
+}
+
+bool SaveRestoreUtility::ReadBinary(const char*& position, const char* end)
+{
+  parameters.clear();
+  matrices.clear();
+  children.clear();
+
+  boost::uint64_t count;
+  std::string name;
+  if (!ReadSize(position, end, count))
+    return false;
+  for (boost::uint64_t i = 0; i < count; ++i)
+  {
+    if (!ReadString(position, end, name) ||
+        !ReadString(position, end, parameters[name]))
+      return false;
+  }
+
+  if (!ReadSize(position, end, count))
+    return false;
+  for (boost::uint64_t i = 0; i < count; ++i)
+  {
+    boost::uint64_t rows, cols;
+    if (!ReadString(position, end, name) || !ReadSize(position, end, rows) ||
+        !ReadSize(position, end, cols))
+      return false;
+
+    // Check the size without overflowing.
+    const boost::uint64_t available = (end - position) / sizeof(double);
+    if (rows != 0 && (cols > available / rows))
+      return false;
+
+    arma::mat& matrix = matrices[name];
+    matrix.set_size((size_t) rows, (size_t) cols);
+    memcpy(matrix.memptr(), position, matrix.n_elem * sizeof(double));
+    position += matrix.n_elem * sizeof(double);
+  }
+
+  if (!ReadSize(position, end, count))
+    return false;
+  for (boost::uint64_t i = 0; i < count; ++i)
+  {
+    if (!ReadString(position, end, name) ||
+        !children[name].ReadBinary(position, end))
+      return false;
+  }
+
+  return true;
+}
+
 arma::mat& SaveRestoreUtility::LoadParameter(arma::mat& matrix,
                                              const std::string& name) const
 {
+  // Matrices that have not been written to XML don't need to be parsed.
+  std::map<std::string, arma::mat>::const_iterator matrixIt =
+      matrices.find(name);
+  if (matrixIt != matrices.end())
+    return matrix = (*matrixIt).second;
+
   std::map<std::string, std::string>::const_iterator it = parameters.find(name);
   if (it != parameters.end())
   {
@@ -182,18 +381,9 @@ void SaveRestoreUtility::SaveParameter(const char c, const std::string& name)
 void SaveRestoreUtility::SaveParameter(const arma::mat& mat,
                                        const std::string& name)
 {
-  std::ostringstream output;
-  size_t columns = mat.n_cols;
-  size_t rows = mat.n_rows;
-  for (size_t r = 0; r < rows; ++r)
-  {
-    for (size_t c = 0; c < columns - 1; ++c)
-    {
-      output << std::setprecision(15) << mat(r, c) << ",";
-    }
-    output << std::setprecision(15) << mat(r, columns - 1) << std::endl;
-  }
-  parameters[name] = output.str();
+  // The matrix is kept as it is; it is only formatted if it is written to XML.
+  parameters.erase(name);
+  matrices[name] = mat;
 }
 
 // Special template specializations for vectors.
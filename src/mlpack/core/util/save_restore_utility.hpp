@@ -3,7 +3,8 @@
  * @author Neil Slagle
  *
  * The SaveRestoreUtility provides helper functions in saving and
- *   restoring models.  The current output file type is XML.
+ *   restoring models.  Models are saved as XML, or in a binary format if the
+ *   filename ends in ".bin".
  *
  * @experimental
  */
@@ -32,6 +33,12 @@ class SaveRestoreUtility
    */
   std::map<std::string, std::string> parameters;
 
+  /**
+   * matrices contains a list of names and matrix parameters, which are only
+   * converted to strings if they are written to XML.
+   */
+  std::map<std::string, arma::mat> matrices;
+
   /**
    * children contains a list of names in string format and child
    * models in the model hierarchy in SaveRestoreUtility format
@@ -49,15 +56,28 @@ class SaveRestoreUtility
   ~SaveRestoreUtility() { parameters.clear(); }
 
   /**
-   * ReadFile reads an XML tree from a file.
+   * ReadFile reads a model from a file, which may be XML or binary (binary
+   * files are recognized by their contents, not their extension).
    */
   bool ReadFile(const std::string& filename);
 
   /**
-   * WriteFile writes the XML tree to a file.
+   * WriteFile writes the model to a file.  If the filename ends in ".bin", the
+   * binary format is used; otherwise, the model is written as XML.
+   *
+   * In the binary format, each node holds its string parameters, then its
+   * matrices, then its children, each as a count followed by length-prefixed
+   * names and values.  Matrices are stored as their number of rows and columns
+   * followed by their elements, so they are saved and loaded exactly and
+   * without being formatted or parsed.
    */
   bool WriteFile(const std::string& filename);
 
+  /**
+   * Return whether or not the given file is a model in the binary format.
+   */
+  static bool IsBinaryFile(const std::string& filename);
+
   /**
    * LoadParameter loads a parameter from the parameters map.
    */
@@ -135,6 +155,17 @@ class SaveRestoreUtility
    */
   void ReadFile(xmlNode* n);
 
+  /**
+   * WriteBinary writes this node in the binary format, recursively.
+   */
+  void WriteBinary(std::ostream& stream) const;
+
+  /**
+   * ReadBinary reads this node from the binary format, recursively, moving
+   * position past it.  False is returned if the node is invalid.
+   */
+  bool ReadBinary(const char*& position, const char* end);
+
 };
 
 //! Specialization for arma::vec.
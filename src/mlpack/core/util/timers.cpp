@@ -8,6 +8,7 @@
 #include "timers.hpp"
 #include "cli.hpp"
 #include "log.hpp"
+#include "memory_tracker.hpp"
 
 #include <map>
 #include <string>
@@ -29,11 +30,16 @@ inline void timersub(const timeval* tvp, const timeval* uvp, timeval* vvp)
 #endif
 
 /**
- * Start the given timer.
+ * Start the given timer.  The timers are shared between threads, so only one
+ * thread at a time may use them.
  */
 void Timer::Start(const std::string& name)
 {
+  #pragma omp critical(mlpackTimers)
   CLI::GetSingleton().timer.StartTimer(name);
+
+  // Each timer is also a phase whose memory use is tracked.
+  MemoryTracker::StartPhase(name);
 }
 
 /**
@@ -41,6 +47,9 @@ void Timer::Start(const std::string& name)
  */
 void Timer::Stop(const std::string& name)
 {
+  MemoryTracker::StopPhase(name);
+
+  #pragma omp critical(mlpackTimers)
   CLI::GetSingleton().timer.StopTimer(name);
 }
 
@@ -49,7 +58,11 @@ void Timer::Stop(const std::string& name)
  */
 timeval Timer::Get(const std::string& name)
 {
-  return CLI::GetSingleton().timer.GetTimer(name);
+  timeval value;
+  #pragma omp critical(mlpackTimers)
+  value = CLI::GetSingleton().timer.GetTimer(name);
+
+  return value;
 }
 
 std::map<std::string, timeval>& Timers::GetAllTimers()
@@ -66,6 +66,12 @@ class Timer
    *
    * @note Undefined behavior will occur if a timer is started twice.
    *
+   * Timers may be started and stopped from several threads at once, but since
+   * they are shared by all the threads, each timer should only be used by one
+   * thread at a time.
+   *
+   * The memory used while a timer runs is recorded too; see MemoryTracker.
+   *
    * @param name Name of timer to be started.
    */
   static void Start(const std::string& name);
@@ -78,6 +78,9 @@ AdaBoost<MatType, WeakLearner>::AdaBoost(
   // This is the final hypothesis.
   arma::Row<size_t> finalH(predictedLabels.n_cols);
 
+  // The contribution of each point to rt and zt.
+  arma::vec pointTerms(data.n_cols);
+
   // now start the boosting rounds
   for (int i = 0; i < iterations; i++)
   {
@@ -99,24 +102,28 @@ AdaBoost<MatType, WeakLearner>::AdaBoost(
     // Now from predictedLabels, build ht, the weak hypothesis
     // buildClassificationMatrix(ht, predictedLabels);
 
-    // Now, start calculation of alpha(t) using ht
+    // Now, start calculation of alpha(t) using ht.  The contribution of each
+    // point is computed in parallel, but they are summed in order, so that rt
+    // does not depend on the number of threads.
 
+    #pragma omp parallel for schedule(static)
     for (size_t j = 0;j < D.n_rows; j++) // instead of D, ht
     {
       if (predictedLabels(j) == labels(j))
       {
         // for (int k = 0;k < numClasses; k++)
         //   rt += D(j,k);
-        rt += arma::accu(D.row(j));
+        pointTerms[j] = arma::accu(D.row(j));
       }
 
       else
       {
         // for (int k = 0;k < numClasses; k++)
         //   rt -= D(j,k);
-        rt -= arma::accu(D.row(j));
+        pointTerms[j] = -arma::accu(D.row(j));
       }
     }
+    rt = arma::accu(pointTerms);
     // end calculation of rt
 
     if (i > 0)
@@ -134,16 +141,20 @@ AdaBoost<MatType, WeakLearner>::AdaBoost(
     alpha.push_back(alphat);
     wl.push_back(w);
 
-    // now start modifying weights
+    // now start modifying weights; each point is independent, and zt is
+    // summed in order afterwards
+    const double expo = exp(alphat);
+    #pragma omp parallel for schedule(static)
     for (size_t j = 0;j < D.n_rows; j++)
     {
-      double expo = exp(alphat);
+      pointTerms[j] = 0.0;
       if (predictedLabels(j) == labels(j))
       {
           for (size_t k = 0;k < D.n_cols; k++)
           {
             // we calculate zt, the normalization constant
-            zt += D(j,k) / expo; // * exp(-1 * alphat * yt(j,k) * ht(j,k));
+            // * exp(-1 * alphat * yt(j,k) * ht(j,k));
+            pointTerms[j] += D(j,k) / expo;
             D(j,k) = D(j,k) / expo;
 
             // adding to the matrix of FinalHypothesis
@@ -159,7 +170,7 @@ AdaBoost<MatType, WeakLearner>::AdaBoost(
         for (size_t k = 0;k < D.n_cols; k++)
           {
             // we calculate zt, the normalization constant
-            zt += D(j,k) * expo;
+            pointTerms[j] += D(j,k) * expo;
             D(j,k) = D(j,k) * expo;
 
             // adding to the matrix of FinalHypothesis
@@ -171,6 +182,8 @@ AdaBoost<MatType, WeakLearner>::AdaBoost(
       }
     }
 
+    zt = arma::accu(pointTerms);
+
     // normalization of D
     D = D / zt;
 
@@ -215,6 +228,7 @@ void AdaBoost<MatType, WeakLearner>::Classify(
   {
     wl[i].Classify(test, tempPredictedLabels);
 
+    #pragma omp parallel for schedule(static)
     for (size_t j = 0; j < tempPredictedLabels.n_cols; j++)
       cMatrix(tempPredictedLabels(j), j) += (alpha[i] * tempPredictedLabels(j));
   }
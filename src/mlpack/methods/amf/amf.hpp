@@ -20,11 +20,14 @@
 #include <mlpack/methods/amf/update_rules/svd_batch_learning.hpp>
 #include <mlpack/methods/amf/update_rules/svd_incomplete_incremental_learning.hpp>
 #include <mlpack/methods/amf/update_rules/svd_complete_incremental_learning.hpp>
+#include <mlpack/methods/amf/update_rules/svd_parallel_incremental_learning.hpp>
+#include <mlpack/methods/amf/update_rules/weighted_als.hpp>
 
 #include <mlpack/methods/amf/init_rules/random_init.hpp>
 
 #include <mlpack/methods/amf/termination_policies/simple_residue_termination.hpp>
 #include <mlpack/methods/amf/termination_policies/simple_tolerance_termination.hpp>
+#include <mlpack/methods/amf/termination_policies/gram_residue_termination.hpp>
 
 namespace mlpack {
 namespace amf /** Alternating Matrix Factorization **/ {
@@ -136,6 +139,17 @@ typedef amf::AMF<amf::SimpleResidueTermination,
                  amf::RandomInitialization, 
                  amf::NMFALSUpdate> NMFALSFactorizer;
 
+/**
+ * SparseWeightedALSFactorizer factorizes the given sparse matrix V into two
+ * matrices W and H with alternating least squares over the observed (non-zero)
+ * entries of V only.
+ *
+ * @see WeightedALSUpdate
+ */
+typedef amf::AMF<amf::SimpleToleranceTermination<arma::sp_mat>,
+                 amf::RandomInitialization,
+                 amf::WeightedALSUpdate> SparseWeightedALSFactorizer;
+
 //! Add simple typedefs 
 #ifdef MLPACK_USE_CXX11
 
@@ -0,0 +1,155 @@
+/**
+ * @file nndsvd_init.hpp
+ *
+ * Initialization rule for Alternating Matrix Factorization, with the
+ * non-negative double singular value decomposition (NNDSVD) of V.
+ */
+#ifndef __MLPACK_METHODS_AMF_NNDSVD_INIT_HPP
+#define __MLPACK_METHODS_AMF_NNDSVD_INIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace amf {
+
+/**
+ * This initialization rule sets W and H from the r leading singular triplets
+ * (sigma_j, u_j, v_j) of V, with the NNDSVD of 'SVD based initialization: A
+ * head start for nonnegative matrix factorization' by C. Boutsidis and E.
+ * Gallopoulos (Pattern Recognition, 2008).  Each pair of singular vectors is
+ * split into its positive and its negative parts; the pair of parts whose
+ * norms have the larger product p_j gives column j of W and row j of H, both
+ * normalized and scaled by sqrt(sigma_j p_j).  This is a non-negative
+ * approximation of the truncated SVD of V, which is usually much closer to a
+ * good factorization than a random start, so far fewer iterations are needed.
+ *
+ * The singular triplets are computed with math::RandomizedSVD() when r is small
+ * compared to V (see math::PreferRandomizedSVD()), and with a full SVD
+ * otherwise.  A sparse V is converted to a dense matrix first.
+ *
+ * About half of the entries of W and H found in this way are zero, and a
+ * multiplicative update rule can never change an entry that is zero.  So by
+ * default, the zero entries are set to the average of the entries of V (the
+ * NNDSVDa variant of the paper); this can be turned off for update rules that
+ * have no such problem, such as alternating least squares.
+ */
+class NNDSVDInitialization
+{
+ public:
+  /**
+   * Create the initialization rule.
+   *
+   * @param fillZeros If true, set the zero entries of W and H to the average
+   *     of the entries of V.
+   */
+  NNDSVDInitialization(const bool fillZeros = true) : fillZeros(fillZeros) { }
+
+  /**
+   * Initialize W and H from the NNDSVD of the given (sparse) matrix, which is
+   * converted to a dense matrix.
+   *
+   * @param V Input matrix.
+   * @param r Rank of the factorization.
+   * @param W W matrix, to be initialized.
+   * @param H H matrix, to be initialized.
+   */
+  template<typename MatType>
+  inline void Initialize(const MatType& V,
+                         const size_t r,
+                         arma::mat& W,
+                         arma::mat& H) const
+  {
+    const arma::mat denseV(V);
+    Initialize(denseV, r, W, H);
+  }
+
+  /**
+   * Initialize W and H from the NNDSVD of the given matrix.
+   *
+   * @param V Input matrix.
+   * @param r Rank of the factorization.
+   * @param W W matrix, to be initialized.
+   * @param H H matrix, to be initialized.
+   */
+  inline void Initialize(const arma::mat& V,
+                         const size_t r,
+                         arma::mat& W,
+                         arma::mat& H) const
+  {
+    W.zeros(V.n_rows, r);
+    H.zeros(r, V.n_cols);
+
+    // There are no more singular triplets than the smaller dimension of V;
+    // the other columns of W and rows of H are left at zero.
+    const size_t rank = std::min(r, (size_t) std::min(V.n_rows, V.n_cols));
+    if (rank < r)
+    {
+      Log::Warn << "NNDSVDInitialization::Initialize(): rank " << r << " is "
+          << "larger than the smaller dimension of V; only " << rank
+          << " columns of W are set." << std::endl;
+    }
+
+    arma::mat u, v;
+    arma::vec sigma;
+    if (math::PreferRandomizedSVD(rank, V.n_rows, V.n_cols))
+    {
+      math::RandomizedSVD(V, rank, u, sigma, v);
+    }
+    else
+    {
+      arma::svd_econ(u, sigma, v, V);
+    }
+
+    for (size_t j = 0; j < rank; ++j)
+    {
+      // The positive and negative parts of the singular vectors.
+      const arma::vec x = u.unsafe_col(j);
+      const arma::vec y = v.unsafe_col(j);
+      const arma::vec xPos = 0.5 * (x + arma::abs(x));
+      const arma::vec yPos = 0.5 * (y + arma::abs(y));
+      const arma::vec xNeg = xPos - x;
+      const arma::vec yNeg = yPos - y;
+
+      const double xPosNorm = arma::norm(xPos, 2);
+      const double yPosNorm = arma::norm(yPos, 2);
+      const double xNegNorm = arma::norm(xNeg, 2);
+      const double yNegNorm = arma::norm(yNeg, 2);
+
+      const double pos = xPosNorm * yPosNorm;
+      const double neg = xNegNorm * yNegNorm;
+      if (pos >= neg && pos > 0.0)
+      {
+        const double scale = std::sqrt(sigma[j] * pos);
+        W.col(j) = (scale / xPosNorm) * xPos;
+        H.row(j) = (scale / yPosNorm) * yPos.t();
+      }
+      else if (neg > pos)
+      {
+        const double scale = std::sqrt(sigma[j] * neg);
+        W.col(j) = (scale / xNegNorm) * xNeg;
+        H.row(j) = (scale / yNegNorm) * yNeg.t();
+      }
+    }
+
+    if (fillZeros)
+    {
+      const double average = arma::accu(V) / V.n_elem;
+      W.elem(arma::find(W == 0.0)).fill(average);
+      H.elem(arma::find(H == 0.0)).fill(average);
+    }
+  }
+
+  //! Get whether the zero entries of W and H are set to the average of V.
+  bool FillZeros() const { return fillZeros; }
+  //! Modify whether the zero entries of W and H are set to the average of V.
+  bool& FillZeros() { return fillZeros; }
+
+ private:
+  //! If true, the zero entries of W and H are set to the average of V.
+  bool fillZeros;
+};
+
+}; // namespace amf
+}; // namespace mlpack
+
+#endif
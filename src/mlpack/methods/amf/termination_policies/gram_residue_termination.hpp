@@ -0,0 +1,156 @@
+/**
+ * @file gram_residue_termination.hpp
+ *
+ * Termination policy used in AMF (Alternating Matrix Factorization), which
+ * measures the reconstruction error without forming WH.
+ */
+#ifndef __MLPACK_METHODS_AMF_TERMINATION_POLICIES_GRAM_RESIDUE_TERMINATION_HPP
+#define __MLPACK_METHODS_AMF_TERMINATION_POLICIES_GRAM_RESIDUE_TERMINATION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace amf {
+
+/**
+ * This class implements a termination policy based on the relative
+ * reconstruction error \f$ \|V - WH\|_F / \|V\|_F \f$.  The error is computed
+ * from the r x r Gram matrices, with
+ *
+ * \f[
+ * \|V - WH\|_F^2 = \|V\|_F^2 - 2 tr(H^T W^T V) + tr(W^T W H H^T),
+ * \f]
+ *
+ * so WH is never formed.  \f$ \|V\|_F \f$ is computed once, in Initialize();
+ * the Gram term costs O(r^2 (n + m)) and the cross term needs W^T V, which
+ * costs one pass over V (only over the non-zero entries, if V is sparse).
+ *
+ * The factorization has converged when the relative change of the error
+ * between two iterations drops below the tolerance, or when the number of
+ * iterations goes above the limit.  Because the terms of the sum cancel, the
+ * error is only accurate to about sqrt(eps) times \f$ \|V\|_F \f$, so for very
+ * accurate factorizations a policy that forms the residuals, such as
+ * SimpleToleranceTermination, should be used.
+ *
+ * @see AMF, SimpleResidueTermination
+ */
+template<typename MatType = arma::mat>
+class GramResidueTermination
+{
+ public:
+  /**
+   * Construct the GramResidueTermination object with the given tolerance and
+   * maximum number of iterations.  0 indicates no iteration limit.
+   *
+   * @param tolerance Minimum relative change of the reconstruction error.
+   * @param maxIterations Maximum number of iterations.
+   */
+  GramResidueTermination(const double tolerance = 1e-5,
+                         const size_t maxIterations = 10000) :
+      tolerance(tolerance),
+      maxIterations(maxIterations),
+      V(NULL),
+      squaredNorm(0),
+      residue(DBL_MAX),
+      residueOld(DBL_MAX),
+      iteration(1)
+  { }
+
+  /**
+   * Initialize the termination policy before starting the factorization.
+   *
+   * @param V Input matrix being factorized.
+   */
+  void Initialize(const MatType& V)
+  {
+    this->V = &V;
+    squaredNorm = SquaredNorm(V);
+
+    residue = DBL_MAX;
+    residueOld = DBL_MAX;
+    iteration = 1;
+  }
+
+  /**
+   * Check if the termination criterion is met.
+   *
+   * @param W Basis matrix of output.
+   * @param H Encoding matrix of output.
+   */
+  bool IsConverged(arma::mat& W, arma::mat& H)
+  {
+    wtv = W.t() * (*V);
+    const double cross = arma::accu(H % wtv);
+
+    // Both Gram matrices are symmetric, so the trace of their product is the
+    // sum of their element-wise product.
+    const double gram = arma::accu((W.t() * W) % (H * H.t()));
+
+    // If V is zero, the absolute error is used.
+    const double scale = (squaredNorm > 0) ? squaredNorm : 1.0;
+    residueOld = residue;
+    residue = std::sqrt(std::max(0.0, squaredNorm - 2 * cross + gram) / scale);
+
+    iteration++;
+
+    return ((residueOld != DBL_MAX &&
+        std::fabs(residueOld - residue) <= tolerance * residueOld) ||
+        (maxIterations != 0 && iteration > maxIterations));
+  }
+
+  //! Get the current relative reconstruction error.
+  const double& Index() const { return residue; }
+
+  //! Get the current iteration count.
+  const size_t& Iteration() const { return iteration; }
+
+  //! Access the maximum iteration count.
+  const size_t& MaxIterations() const { return maxIterations; }
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Access the tolerance.
+  const double& Tolerance() const { return tolerance; }
+  double& Tolerance() { return tolerance; }
+
+ private:
+  //! Tolerance on the relative change of the error.
+  double tolerance;
+  //! Iteration threshold.
+  size_t maxIterations;
+
+  //! Pointer to the matrix being factorized.
+  const MatType* V;
+  //! The squared Frobenius norm of V.
+  double squaredNorm;
+  //! Buffer for W^T V.
+  arma::mat wtv;
+
+  //! The current relative reconstruction error.
+  double residue;
+  //! The relative reconstruction error of the previous iteration.
+  double residueOld;
+  //! The current iteration count.
+  size_t iteration;
+
+  //! Compute the squared Frobenius norm of a dense matrix.
+  template<typename DenseMatType>
+  static double SquaredNorm(const DenseMatType& V)
+  {
+    return arma::accu(arma::square(V));
+  }
+
+  //! Compute the squared Frobenius norm of a sparse matrix.
+  static double SquaredNorm(const arma::sp_mat& V)
+  {
+    double sum = 0;
+    for (size_t i = 0; i < V.n_nonzero; ++i)
+      sum += V.values[i] * V.values[i];
+
+    return sum;
+  }
+}; // class GramResidueTermination
+
+}; // namespace amf
+}; // namespace mlpack
+
+#endif
@@ -21,6 +21,10 @@ namespace amf {
  * IsConverged() will return true.  This class is meant for use with the AMF
  * (alternating matrix factorization) class.
  *
+ * The norm of WH is computed from the r x r Gram matrices, as
+ * \f$ \|WH\|_F^2 = tr(W^T W H H^T) \f$, so each check costs
+ * O(r^2 (n + m)) and WH itself is never formed.
+ *
  * @see AMF
  */
 class SimpleResidueTermination
@@ -62,8 +66,11 @@ class SimpleResidueTermination
    */
   bool IsConverged(arma::mat& W, arma::mat& H)
   {
-    // Calculate the norm and compute the residue
-    const double norm = arma::norm(W * H, "fro");
+    // Calculate the norm and compute the residue.  Both Gram matrices are
+    // symmetric, so the trace of their product is the sum of their element-wise
+    // product.
+    const double norm = std::sqrt(std::max(0.0,
+        arma::accu((W.t() * W) % (H * H.t()))));
     residue = fabs(normOld - norm) / normOld;
 
     // Store the norm.
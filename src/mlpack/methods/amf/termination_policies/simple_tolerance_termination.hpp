@@ -20,6 +20,11 @@ namespace amf {
  * Secondary termination criterion terminates algorithm when iteration count
  * goes above the threshold.
  *
+ * The residue is the root mean square error over the non-zero entries of V.
+ * WH is never formed: for a sparse V, only the non-zero entries are visited;
+ * for a dense V, one column of WH at a time is computed.  The columns are
+ * visited in parallel.
+ *
  * @see AMF
  */
 template <class MatType>
@@ -63,30 +68,11 @@ class SimpleToleranceTermination
    */
   bool IsConverged(arma::mat& W, arma::mat& H)
   {
-    arma::mat WH;
-
-    WH = W * H;
-
     // compute residue
     residueOld = residue;
-    size_t n = V->n_rows;
-    size_t m = V->n_cols;
     double sum = 0;
     size_t count = 0;
-    for(size_t i = 0;i < n;i++)
-    {
-        for(size_t j = 0;j < m;j++)
-        {
-            double temp = 0;
-            if((temp = (*V)(i,j)) != 0)
-            {
-                temp = (temp - WH(i, j));
-                temp = temp * temp;
-                sum += temp;
-                count++;
-            }
-        }
-    }
+    SquaredErrors(*V, W, H, sum, count);
     residue = sum / count;
     residue = sqrt(residue);
 
@@ -153,6 +139,74 @@ class SimpleToleranceTermination
   double& Tolerance() { return tolerance; }
 
  private:
+  //! Sum the squared errors of the non-zero entries of a dense matrix, and
+  //! count the entries.
+  template<typename DenseMatType>
+  void SquaredErrors(const DenseMatType& V,
+                     const arma::mat& W,
+                     const arma::mat& H,
+                     double& sum,
+                     size_t& count) const
+  {
+    // References can't be reduced, so local sums are used.
+    double localSum = 0;
+    size_t localCount = 0;
+
+    #pragma omp parallel
+    {
+      arma::vec wh;
+
+      #pragma omp for schedule(static) reduction(+:localSum, localCount)
+      for (size_t j = 0; j < V.n_cols; ++j)
+      {
+        wh = W * H.col(j);
+        for (size_t i = 0; i < V.n_rows; ++i)
+        {
+          const double value = V(i, j);
+          if (value != 0)
+          {
+            localSum += (value - wh[i]) * (value - wh[i]);
+            localCount++;
+          }
+        }
+      }
+    }
+
+    sum = localSum;
+    count = localCount;
+  }
+
+  //! Sum the squared errors of the non-zero entries of a sparse matrix, and
+  //! count the entries.
+  void SquaredErrors(const arma::sp_mat& V,
+                     const arma::mat& W,
+                     const arma::mat& H,
+                     double& sum,
+                     size_t& count)
+  {
+    // The rows of W are used as columns, so that they are contiguous.
+    wt = W.t();
+
+    double localSum = 0;
+    size_t localCount = 0;
+
+    #pragma omp parallel for schedule(dynamic, 256) \
+        reduction(+:localSum, localCount)
+    for (size_t j = 0; j < V.n_cols; ++j)
+    {
+      for (arma::sp_mat::const_iterator it = V.begin_col(j);
+           it != V.end_col(j); ++it)
+      {
+        const double error = (*it) - arma::dot(wt.col(it.row()), H.col(j));
+        localSum += error * error;
+        localCount++;
+      }
+    }
+
+    sum = localSum;
+    count = localCount;
+  }
+
   //! tolerance
   double tolerance;
   //! iteration threshold
@@ -181,6 +235,8 @@ class SimpleToleranceTermination
   //! variables to store information of minimum residue poi
   arma::mat W;
   arma::mat H;
+  //! transpose of W, for sparse matrices
+  arma::mat wt;
   double c_indexOld;
   double c_index;
 }; // class SimpleToleranceTermination
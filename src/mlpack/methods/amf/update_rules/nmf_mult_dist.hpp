@@ -19,6 +19,11 @@ namespace amf {
  * that the Frobenius norm \f$ \sqrt{\sum_i \sum_j(V-WH)^2} \f$ is
  * non-increasing between subsequent iterations. Both of the update rules
  * for W and H are defined in this file.
+ *
+ * The r x r Gram matrix (H H^T or W^T W) is computed before it is multiplied
+ * with the other factor, so no temporaries of the size of V are built, and the
+ * products are kept in buffers that are reused in each iteration.  The
+ * element-wise update is done in parallel with OpenMP.
  */
 class NMFMultiplicativeDistanceUpdate
 {
@@ -46,11 +51,15 @@ class NMFMultiplicativeDistanceUpdate
    * @param H Encoding matrix.
    */
   template<typename MatType>
-  inline static void WUpdate(const MatType& V,
-                             arma::mat& W,
-                             const arma::mat& H)
+  inline void WUpdate(const MatType& V,
+                      arma::mat& W,
+                      const arma::mat& H)
   {
-    W = (W % (V * H.t())) / (W * H * H.t());
+    gram = H * H.t();
+    numerator = V * H.t();
+    denominator = W * gram;
+
+    Scale(W);
   }
 
   /**
@@ -66,11 +75,38 @@ class NMFMultiplicativeDistanceUpdate
    * @param H Encoding matrix to be updated.
    */
   template<typename MatType>
-  inline static void HUpdate(const MatType& V,
-                             const arma::mat& W,
-                             arma::mat& H)
+  inline void HUpdate(const MatType& V,
+                      const arma::mat& W,
+                      arma::mat& H)
+  {
+    gram = W.t() * W;
+    numerator = W.t() * V;
+    denominator = gram * H;
+
+    Scale(H);
+  }
+
+ private:
+  //! The r x r Gram matrix of the fixed factor.
+  arma::mat gram;
+  //! The numerator of the update (V H^T or W^T V).
+  arma::mat numerator;
+  //! The denominator of the update (W H H^T or W^T W H).
+  arma::mat denominator;
+
+  //! Multiply each element of the given factor by the ratio of the numerator
+  //! and the denominator.
+  inline void Scale(arma::mat& factor) const
   {
-    H = (H % (W.t() * V)) / (W.t() * W * H);
+    #pragma omp parallel for schedule(static)
+    for (size_t j = 0; j < factor.n_cols; ++j)
+    {
+      double* f = factor.colptr(j);
+      const double* n = numerator.colptr(j);
+      const double* d = denominator.colptr(j);
+      for (size_t i = 0; i < factor.n_rows; ++i)
+        f[i] *= n[i] / d[i];
+    }
   }
 };
 
@@ -20,15 +20,27 @@ namespace amf {
  * is non-increasing between subsequent iterations. Both of the update rules
  * for W and H are defined in this file.
  *
- * This set of update rules is not meant to work with sparse matrices.  Using
- * sparse matrices often causes NaNs in the output, so other choices of update
- * rules are better in that situation.
+ * The ratios V / (WH) are never formed for all of V at once.  For a dense V,
+ * the rows of W (or the columns of H) are updated in blocks of BlockSize(),
+ * and only the block of WH that is needed is computed; the blocks are updated
+ * in parallel with OpenMP.  For a sparse V, the ratio is zero wherever V is
+ * zero, so only the non-zero entries of V are visited, and each row of W (or
+ * column of H) is updated in parallel.  The W update of a sparse V visits the
+ * rows of V, so a transposed copy of V is kept, which is made by Initialize().
  */
 class NMFMultiplicativeDivergenceUpdate
 {
  public:
-  // Empty constructor required for the WUpdateRule template.
-  NMFMultiplicativeDivergenceUpdate() { }
+  /**
+   * Create the update rule.  The default constructor is required for the
+   * UpdateRule template.
+   *
+   * @param blockSize Number of rows of W (or columns of H) in each block, for
+   *     dense matrices.
+   */
+  NMFMultiplicativeDivergenceUpdate(const size_t blockSize = 256) :
+      blockSize(blockSize)
+  { }
 
   template<typename MatType>
   void Initialize(const MatType& dataset, const size_t rank)
@@ -37,6 +49,18 @@ class NMFMultiplicativeDivergenceUpdate
     (void)rank;
   }
 
+  /**
+   * Initialize the update rule for a sparse matrix, by storing its transpose.
+   *
+   * @param dataset Input matrix to be factorized.
+   * @param rank Rank of the factorization.
+   */
+  void Initialize(const arma::sp_mat& dataset, const size_t rank)
+  {
+    (void)rank;
+    vt = dataset.t();
+  }
+
   /**
    * The update rule for the basis matrix W. The formula used is
    * \f[
@@ -51,30 +75,70 @@ class NMFMultiplicativeDivergenceUpdate
    * @param H Encoding matrix.
    */
   template<typename MatType>
-  inline static void WUpdate(const MatType& V,
-                            arma::mat& W,
-                            const arma::mat& H)
+  inline void WUpdate(const MatType& V,
+                      arma::mat& W,
+                      const arma::mat& H)
+  {
+    sums = arma::sum(H, 1);
+    const size_t numBlocks = (W.n_rows + blockSize - 1) / blockSize;
+
+    #pragma omp parallel
+    {
+      // Each thread has its own buffers, allocated once.
+      arma::mat ratios, numerator;
+
+      #pragma omp for schedule(static)
+      for (size_t b = 0; b < numBlocks; ++b)
+      {
+        const size_t begin = b * blockSize;
+        const size_t end = std::min((size_t) W.n_rows, begin + blockSize);
+
+        ratios = V.rows(begin, end - 1) / (W.rows(begin, end - 1) * H);
+        numerator = ratios * H.t();
+
+        for (size_t j = 0; j < W.n_cols; ++j)
+          for (size_t i = begin; i < end; ++i)
+            W(i, j) *= numerator(i - begin, j) / sums[j];
+      }
+    }
+  }
+
+  /**
+   * The update rule for the basis matrix W, for a sparse input matrix; only
+   * the non-zero entries of V are visited.
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix to be updated.
+   * @param H Encoding matrix.
+   */
+  inline void WUpdate(const arma::sp_mat& V,
+                      arma::mat& W,
+                      const arma::mat& H)
   {
-    // Simple implementation left in the header file.
-    arma::mat t1;
-    arma::rowvec t2;
+    // Make the transposed copy if Initialize() was not called with V.
+    if (vt.n_rows != V.n_cols || vt.n_cols != V.n_rows ||
+        vt.n_nonzero != V.n_nonzero)
+      vt = V.t();
+
+    sums = arma::sum(H, 1);
 
-    t1 = W * H;
-    for (size_t i = 0; i < W.n_rows; ++i)
+    #pragma omp parallel
     {
-      for (size_t j = 0; j < W.n_cols; ++j)
+      arma::vec w, numerator;
+
+      #pragma omp for schedule(dynamic, 256)
+      for (size_t i = 0; i < W.n_rows; ++i)
       {
-        // Writing this as a single expression does not work as of Armadillo
-        // 3.920.  This should be fixed in a future release, and then the code
-        // below can be fixed.
-        //t2 = H.row(j) % V.row(i) / t1.row(i);
-        t2.set_size(H.n_cols);
-        for (size_t k = 0; k < t2.n_elem; ++k)
-        {
-          t2(k) = H(j, k) * V(i, k) / t1(i, k);
-        }
-
-        W(i, j) = W(i, j) * sum(t2) / sum(H.row(j));
+        w = arma::trans(W.row(i));
+        numerator.zeros(W.n_cols);
+
+        // Column i of the transpose holds row i of V.
+        for (arma::sp_mat::const_iterator it = vt.begin_col(i);
+             it != vt.end_col(i); ++it)
+          numerator += ((*it) / arma::dot(w, H.col(it.row()))) *
+              H.col(it.row());
+
+        W.row(i) = arma::trans(w % numerator / sums);
       }
     }
   }
@@ -93,33 +157,81 @@ class NMFMultiplicativeDivergenceUpdate
    * @param H Encoding matrix to updated.
    */
   template<typename MatType>
-  inline static void HUpdate(const MatType& V,
-                            const arma::mat& W,
-                            arma::mat& H)
+  inline void HUpdate(const MatType& V,
+                      const arma::mat& W,
+                      arma::mat& H)
+  {
+    sums = arma::trans(arma::sum(W, 0));
+    const size_t numBlocks = (H.n_cols + blockSize - 1) / blockSize;
+
+    #pragma omp parallel
+    {
+      arma::mat ratios, numerator;
+
+      #pragma omp for schedule(static)
+      for (size_t b = 0; b < numBlocks; ++b)
+      {
+        const size_t begin = b * blockSize;
+        const size_t end = std::min((size_t) H.n_cols, begin + blockSize);
+
+        ratios = V.cols(begin, end - 1) / (W * H.cols(begin, end - 1));
+        numerator = W.t() * ratios;
+
+        for (size_t j = begin; j < end; ++j)
+          for (size_t i = 0; i < H.n_rows; ++i)
+            H(i, j) *= numerator(i, j - begin) / sums[i];
+      }
+    }
+  }
+
+  /**
+   * The update rule for the encoding matrix H, for a sparse input matrix;
+   * only the non-zero entries of V are visited.
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix.
+   * @param H Encoding matrix to updated.
+   */
+  inline void HUpdate(const arma::sp_mat& V,
+                      const arma::mat& W,
+                      arma::mat& H)
   {
-    // Simple implementation left in the header file.
-    arma::mat t1;
-    arma::colvec t2;
+    // The rows of W are used as columns, so that they are contiguous.
+    wt = W.t();
+    sums = arma::trans(arma::sum(W, 0));
 
-    t1 = W * H;
-    for (size_t i = 0; i < H.n_rows; i++)
+    #pragma omp parallel
     {
-      for (size_t j = 0; j < H.n_cols; j++)
+      arma::vec numerator;
+
+      #pragma omp for schedule(dynamic, 256)
+      for (size_t j = 0; j < H.n_cols; ++j)
       {
-        // Writing this as a single expression does not work as of Armadillo
-        // 3.920.  This should be fixed in a future release, and then the code
-        // below can be fixed.
-        //t2 = W.col(i) % V.col(j) / t1.col(j);
-        t2.set_size(W.n_rows);
-        for (size_t k = 0; k < t2.n_elem; ++k)
-        {
-          t2(k) = W(k, i) * V(k, j) / t1(k, j);
-        }
-
-        H(i,j) = H(i,j) * sum(t2) / sum(W.col(i));
+        numerator.zeros(H.n_rows);
+        for (arma::sp_mat::const_iterator it = V.begin_col(j);
+             it != V.end_col(j); ++it)
+          numerator += ((*it) / arma::dot(wt.col(it.row()), H.col(j))) *
+              wt.col(it.row());
+
+        H.col(j) %= numerator / sums;
       }
     }
   }
+
+  //! Get the number of rows of W (or columns of H) in each block.
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of rows of W (or columns of H) in each block.
+  size_t& BlockSize() { return blockSize; }
+
+ private:
+  //! Number of rows of W (or columns of H) in each block.
+  size_t blockSize;
+  //! The sums of the rows of H (or the columns of W).
+  arma::vec sums;
+  //! The transpose of W, for sparse matrices.
+  arma::mat wt;
+  //! The transpose of V, for sparse matrices.
+  arma::sp_mat vt;
 };
 
 }; // namespace amf
@@ -0,0 +1,252 @@
+/**
+ * @file svd_parallel_incremental_learning.hpp
+ *
+ * SVD factorizer used in AMF (Alternating Matrix Factorization), which runs
+ * complete incremental learning in parallel over strata of the input matrix.
+ */
+#ifndef __MLPACK_METHODS_AMF_UPDATE_RULES_SVD_PARALLEL_INCREMENTAL_LEARNING_HPP
+#define __MLPACK_METHODS_AMF_UPDATE_RULES_SVD_PARALLEL_INCREMENTAL_LEARNING_HPP
+
+#include <mlpack/core.hpp>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace amf {
+
+/**
+ * This class computes SVD by complete incremental learning (as
+ * SVDCompleteIncrementalLearning does, updating the feature vectors after each
+ * single score), with the scores processed in parallel by the stratified
+ * schedule of distributed stochastic gradient descent (DSGD), described in the
+ * paper 'Large-Scale Matrix Factorization with Distributed Stochastic Gradient
+ * Descent' by R. Gemulla, E. Nijkamp, P. J. Haas and Y. Sismanis.
+ *
+ * The rows and the columns of V are split into p blocks each, so V is split
+ * into p x p blocks of scores.  The scores of block (b, (b + s) mod p) only
+ * touch the rows of W in row block b and the columns of H in column block
+ * (b + s) mod p, so for each s the p blocks of such a stratum are disjoint and
+ * are processed concurrently, each by one thread, in column-major order.  One
+ * WUpdate() / HUpdate() pair makes one pass over all the scores, with the p
+ * strata s = 0, ..., p - 1 processed in turn.  The result is the same as that
+ * of sequential complete incremental learning over the blocks in the order
+ * (0, s), (1, 1 + s), ..., for s = 0, ..., p - 1, whatever the number of
+ * threads is.
+ *
+ * Because each pair of updates is a full pass over the data, this rule is used
+ * with the simple termination policies (such as SimpleToleranceTermination),
+ * not with CompleteIncrementalTermination.  Only the non-zero entries of V are
+ * scores; they are bucketed by block in Initialize().
+ *
+ * @see SVDCompleteIncrementalLearning
+ */
+class SVDParallelIncrementalLearning
+{
+ public:
+  /**
+   * Create the update rule.
+   *
+   * @param u Step size of each update.
+   * @param kw Regularization constant for the W matrix.
+   * @param kh Regularization constant for the H matrix.
+   * @param blocks Number of row and column blocks p; if 0, the maximum number
+   *     of OpenMP threads is used.
+   */
+  SVDParallelIncrementalLearning(const double u = 0.01,
+                                 const double kw = 0,
+                                 const double kh = 0,
+                                 const size_t blocks = 0) :
+      u(u), kw(kw), kh(kh), blocks(blocks), p(1)
+  { }
+
+  /**
+   * Bucket the non-zero entries of the given matrix by block.  This function
+   * must be called before a new factorization.
+   *
+   * @param dataset Input matrix to be factorized.
+   * @param rank Rank of the factorization.
+   */
+  template<typename MatType>
+  void Initialize(const MatType& dataset, const size_t rank)
+  {
+    (void) rank;
+    SetBlocks(dataset.n_rows, dataset.n_cols);
+
+    // Count the entries of each block first, so they can be placed directly.
+    std::vector<size_t> counts(p * p, 0);
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+      for (size_t i = 0; i < dataset.n_rows; ++i)
+        if (dataset(i, j) != 0)
+          ++counts[Block(i, j)];
+
+    Place(counts);
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+      for (size_t i = 0; i < dataset.n_rows; ++i)
+        if (dataset(i, j) != 0)
+          Store(i, j, dataset(i, j), counts);
+  }
+
+  /**
+   * Bucket the non-zero entries of the given sparse matrix by block.  This
+   * function must be called before a new factorization.
+   *
+   * @param dataset Input matrix to be factorized.
+   * @param rank Rank of the factorization.
+   */
+  void Initialize(const arma::sp_mat& dataset, const size_t rank)
+  {
+    (void) rank;
+    SetBlocks(dataset.n_rows, dataset.n_cols);
+
+    std::vector<size_t> counts(p * p, 0);
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+      for (arma::sp_mat::const_iterator it = dataset.begin_col(j);
+           it != dataset.end_col(j); ++it)
+        ++counts[Block(it.row(), j)];
+
+    Place(counts);
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+      for (arma::sp_mat::const_iterator it = dataset.begin_col(j);
+           it != dataset.end_col(j); ++it)
+        Store(it.row(), j, *it, counts);
+  }
+
+  /**
+   * Make one pass over all the scores, updating W and a copy of H; HUpdate()
+   * stores the copy of H.
+   *
+   * @param V Input matrix (the entries stored by Initialize() are used).
+   * @param W Basis matrix to be updated.
+   * @param H Encoding matrix.
+   */
+  template<typename MatType>
+  inline void WUpdate(const MatType& /* V */,
+                      arma::mat& W,
+                      const arma::mat& H)
+  {
+    h = H;
+
+    for (size_t s = 0; s < p; ++s)
+    {
+      // The blocks of a stratum share no rows of W and no columns of H.
+      #pragma omp parallel for schedule(dynamic, 1)
+      for (size_t b = 0; b < p; ++b)
+      {
+        const size_t block = b * p + (b + s) % p;
+        for (size_t e = blockBegin[block]; e < blockBegin[block + 1]; ++e)
+        {
+          const size_t i = locations(0, e);
+          const size_t j = locations(1, e);
+
+          double error = values[e] - arma::dot(W.row(i), h.col(j));
+          W.row(i) += u * (error * arma::trans(h.col(j)) - kw * W.row(i));
+
+          // The encoding is updated with the new basis vector.
+          error = values[e] - arma::dot(W.row(i), h.col(j));
+          h.col(j) += u * (error * arma::trans(W.row(i)) - kh * h.col(j));
+        }
+      }
+    }
+  }
+
+  /**
+   * Store the encoding matrix computed by the last call to WUpdate().
+   *
+   * @param V Input matrix.
+   * @param W Basis matrix.
+   * @param H Encoding matrix to be updated.
+   */
+  template<typename MatType>
+  inline void HUpdate(const MatType& /* V */,
+                      const arma::mat& /* W */,
+                      arma::mat& H)
+  {
+    H = h;
+  }
+
+  //! Get the number of row and column blocks used in the last factorization.
+  size_t Blocks() const { return p; }
+
+ private:
+  //! Step size of each update.
+  double u;
+  //! Regularization constant for the W matrix.
+  double kw;
+  //! Regularization constant for the H matrix.
+  double kh;
+  //! Requested number of blocks (0 for the number of threads).
+  size_t blocks;
+
+  //! Number of row and column blocks.
+  size_t p;
+  //! Number of rows of the input matrix.
+  size_t n;
+  //! Number of columns of the input matrix.
+  size_t m;
+
+  //! Row and column of each score, sorted by block.
+  arma::Mat<size_t> locations;
+  //! Value of each score, sorted by block.
+  arma::vec values;
+  //! The first score of each block (block (r, c) has index r * p + c).
+  std::vector<size_t> blockBegin;
+
+  //! The copy of H that WUpdate() updates.
+  arma::mat h;
+
+  //! Set the number of blocks for an n x m matrix.
+  void SetBlocks(const size_t rows, const size_t cols)
+  {
+    n = rows;
+    m = cols;
+
+    p = blocks;
+    if (p == 0)
+    {
+      p = 1;
+#ifdef HAS_OPENMP
+      p = (size_t) omp_get_max_threads();
+#endif
+    }
+    p = std::max((size_t) 1, std::min(p, std::min(n, m)));
+  }
+
+  //! Get the block of entry (i, j).
+  size_t Block(const size_t i, const size_t j) const
+  {
+    return (i * p / n) * p + (j * p / m);
+  }
+
+  //! Allocate the scores and set the beginning of each block; counts is then
+  //! reused as the position of the next score of each block.
+  void Place(std::vector<size_t>& counts)
+  {
+    blockBegin.assign(p * p + 1, 0);
+    for (size_t b = 0; b < p * p; ++b)
+      blockBegin[b + 1] = blockBegin[b] + counts[b];
+
+    locations.set_size(2, blockBegin[p * p]);
+    values.set_size(blockBegin[p * p]);
+    for (size_t b = 0; b < p * p; ++b)
+      counts[b] = blockBegin[b];
+  }
+
+  //! Store the score (i, j).
+  void Store(const size_t i,
+             const size_t j,
+             const double value,
+             std::vector<size_t>& next)
+  {
+    const size_t e = next[Block(i, j)]++;
+    locations(0, e) = i;
+    locations(1, e) = j;
+    values[e] = value;
+  }
+};
+
+}; // namespace amf
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * @file weighted_als.hpp
+ *
+ * Weighted alternating least squares update rule for AMF, which only uses the
+ * observed entries of the matrix.
+ */
+#ifndef __MLPACK_METHODS_AMF_UPDATE_RULES_WEIGHTED_ALS_HPP
+#define __MLPACK_METHODS_AMF_UPDATE_RULES_WEIGHTED_ALS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace amf {
+
+/**
+ * This class implements weighted alternating least squares for matrices with
+ * missing entries, such as rating matrices, where the non-zero entries of V
+ * are the observed entries.  With explicit feedback, each row of W (and each
+ * column of H) is the regularized least-squares fit to the observed entries of
+ * its row (or column) of V only,
+ *
+ * \f[
+ * \min_{w_i} \sum_{j \in O_i} (V_{ij} - w_i h_j)^2 + \lambda ||w_i||^2,
+ * \f]
+ *
+ * which is a k x k linear system for rank k.  With implicit feedback (as in
+ * 'Collaborative Filtering for Implicit Feedback Datasets' by Y. Hu, Y. Koren
+ * and C. Volinsky), every entry of V is used, with preference 1 if the entry is
+ * non-zero and 0 otherwise, and confidence 1 + alpha V_{ij}; the k x k systems
+ * are formed from H H^T, computed once per update, plus a correction for the
+ * observed entries.  Either way, each update costs O(nnz(V) k^2 + (n + m) k^3)
+ * for an n x m matrix V, and the rows (or columns) are solved in parallel with
+ * OpenMP.
+ *
+ * V may be an arma::sp_mat or an arma::mat; a dense V is converted to a sparse
+ * matrix once, when the rule is initialized.
+ */
+class WeightedALSUpdate
+{
+ public:
+  /**
+   * Create the update rule.
+   *
+   * @param lambda Regularization parameter.
+   * @param implicit Whether V holds implicit feedback (counts or strengths of
+   *     preference) instead of explicit ratings.
+   * @param alpha Confidence scaling for implicit feedback.
+   */
+  WeightedALSUpdate(const double lambda = 0.01,
+                    const bool implicit = false,
+                    const double alpha = 1.0) :
+      lambda(lambda),
+      implicit(implicit),
+      alpha(alpha)
+  { }
+
+  /**
+   * Initialize the update rule before a new factorization; the observed
+   * entries of the dataset (and their transpose, to go over the rows of V) are
+   * stored.
+   *
+   * @param dataset Input matrix to be factorized.
+   * @param rank Rank of the factorization.
+   */
+  template<typename MatType>
+  void Initialize(const MatType& dataset, const size_t rank)
+  {
+    (void) rank;
+    InitializeData(dataset);
+  }
+
+  /**
+   * The update rule for the basis matrix W: each row of W is solved for with H
+   * fixed.
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix to be updated.
+   * @param H Encoding matrix.
+   */
+  template<typename MatType>
+  inline void WUpdate(const MatType& /* V */,
+                      arma::mat& W,
+                      const arma::mat& H) const
+  {
+    arma::mat wt;
+    Solve(vt, H, wt);
+    W = trans(wt);
+  }
+
+  /**
+   * The update rule for the encoding matrix H: each column of H is solved for
+   * with W fixed.
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix.
+   * @param H Encoding matrix to be updated.
+   */
+  template<typename MatType>
+  inline void HUpdate(const MatType& V,
+                      const arma::mat& W,
+                      arma::mat& H) const
+  {
+    Solve(Observed(V), trans(W), H);
+  }
+
+  //! Get the regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Modify the regularization parameter.
+  double& Lambda() { return lambda; }
+
+  //! Get whether V holds implicit feedback.
+  bool Implicit() const { return implicit; }
+  //! Modify whether V holds implicit feedback.
+  bool& Implicit() { return implicit; }
+
+  //! Get the confidence scaling for implicit feedback.
+  double Alpha() const { return alpha; }
+  //! Modify the confidence scaling for implicit feedback.
+  double& Alpha() { return alpha; }
+
+ private:
+  //! Regularization parameter.
+  double lambda;
+  //! Whether V holds implicit feedback.
+  bool implicit;
+  //! Confidence scaling for implicit feedback.
+  double alpha;
+
+  //! Sparse copy of V, if V is dense.
+  arma::sp_mat v;
+  //! Transpose of V, so that the rows of V are its columns.
+  arma::sp_mat vt;
+
+  //! Store the transpose of a sparse dataset.
+  void InitializeData(const arma::sp_mat& dataset)
+  {
+    v.reset();
+    vt = trans(dataset);
+  }
+
+  //! Store a sparse copy of a dense dataset, and its transpose.
+  void InitializeData(const arma::mat& dataset)
+  {
+    v = arma::sp_mat(dataset);
+    vt = trans(v);
+  }
+
+  //! Get the observed entries of a sparse dataset.
+  const arma::sp_mat& Observed(const arma::sp_mat& V) const { return V; }
+  //! Get the observed entries of a dense dataset.
+  const arma::sp_mat& Observed(const arma::mat& /* V */) const { return v; }
+
+  /**
+   * Solve for each column of the factors, given the observed entries of the
+   * corresponding column of the data and the fixed factors (whose columns
+   * correspond to the rows of the data).
+   */
+  void Solve(const arma::sp_mat& data,
+             const arma::mat& fixed,
+             arma::mat& factors) const
+  {
+    const size_t rank = fixed.n_rows;
+    factors.set_size(rank, data.n_cols);
+
+    // With implicit feedback, every entry contributes to the systems.
+    arma::mat base;
+    if (implicit)
+      base = fixed * trans(fixed);
+    else
+      base.zeros(rank, rank);
+
+    #pragma omp parallel
+    {
+      arma::mat a(rank, rank);
+      arma::vec b(rank);
+
+      #pragma omp for schedule(dynamic, 64)
+      for (size_t j = 0; j < data.n_cols; ++j)
+      {
+        a = base;
+        a.diag() += lambda;
+        b.zeros();
+
+        for (arma::sp_mat::const_iterator it = data.begin_col(j);
+             it != data.end_col(j); ++it)
+        {
+          const double* f = fixed.colptr(it.row());
+
+          // The confidence-weighted outer product of the fixed factors, and
+          // the weighted target; with implicit feedback, the confidence is
+          // 1 + alpha V_ij (of which 1 is already in the base) and the target
+          // is 1.
+          const double weight = implicit ? alpha * (*it) : 1.0;
+          const double target = implicit ? 1.0 + alpha * (*it) : (*it);
+          for (size_t k = 0; k < rank; ++k)
+          {
+            b[k] += target * f[k];
+            for (size_t l = 0; l < rank; ++l)
+              a(l, k) += weight * f[l] * f[k];
+          }
+        }
+
+        // Without observed entries or regularization, there is nothing to fit.
+        if (!implicit && (lambda == 0.0) &&
+            (data.col_ptrs[j] == data.col_ptrs[j + 1]))
+          factors.col(j).zeros();
+        else
+          factors.col(j) = arma::solve(a, b);
+      }
+    }
+  }
+}; // class WeightedALSUpdate
+
+}; // namespace amf
+}; // namespace mlpack
+
+#endif
@@ -13,11 +13,14 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/fastmks/fastmks.hpp>
+#include <mlpack/core/kernels/linear_kernel.hpp>
 #include <mlpack/methods/amf/amf.hpp>
 #include <mlpack/methods/amf/update_rules/nmf_als.hpp>
 #include <mlpack/methods/amf/termination_policies/simple_residue_termination.hpp>
 #include <set>
 #include <map>
+#include <queue>
 #include <iostream>
 
 namespace mlpack {
@@ -141,8 +144,9 @@ class CF
   const arma::mat& W() const { return w; }
   //! Get the Item Matrix.
   const arma::mat& H() const { return h; }
-  //! Get the Rating Matrix.
-  const arma::mat& Rating() const { return rating; }
+  //! Get the Rating Matrix.  This is computed as W * H on each call, and is
+  //! not needed by GetRecommendations().
+  arma::mat Rating() const { return w * h; }
   //! Get the cleaned data matrix.
   const arma::sp_mat& CleanedData() const { return cleanedData; }
 
@@ -158,6 +162,13 @@ class CF
   /**
    * Generates the given number of recommendations for the specified users.
    *
+   * The rating matrix W * H is never formed.  The neighborhood of each user is
+   * found with a kNN search on the columns of H, transformed so that their
+   * distances are the distances between the columns of W * H; the average
+   * rating of the neighbors is then W times the average of their columns of H.
+   * The users are processed in parallel, in blocks, and the best numRecs
+   * un-rated items of each user are kept in a heap.
+   *
    * @param numRecs Number of Recommendations
    * @param recommendations Matrix to save recommendations
    * @param users Users for which recommendations are to be generated
@@ -166,6 +177,94 @@ class CF
                           arma::Mat<size_t>& recommendations,
                           arma::Col<size_t>& users);
 
+  /**
+   * Generates the given number of recommendations for all users directly from
+   * the factorization, as the items with the highest predicted ratings.
+   *
+   * @param numRecs Number of Recommendations
+   * @param recommendations Matrix to save recommendations into.
+   */
+  void GetFactorRecommendations(const size_t numRecs,
+                                arma::Mat<size_t>& recommendations);
+
+  /**
+   * Generates the given number of recommendations for the specified users
+   * directly from the factorization.  Instead of averaging the ratings of a
+   * neighborhood of users, the items recommended to user u are the un-rated
+   * items i with the highest predicted ratings W_i H_u.  This is a
+   * max-inner-product search of H_u against the rows of W, which is done with
+   * FastMKS and the linear kernel: one cover tree is built on the rows of W,
+   * and the users are searched against it with dual-tree search, in parallel
+   * batches.  To exclude the items a user has rated, each batch asks for
+   * numRecs more results than the largest number of items rated by a user in
+   * the batch.
+   *
+   * @param numRecs Number of Recommendations
+   * @param recommendations Matrix to save recommendations
+   * @param users Users for which recommendations are to be generated
+   */
+  void GetFactorRecommendations(const size_t numRecs,
+                                arma::Mat<size_t>& recommendations,
+                                arma::Col<size_t>& users);
+
+  /**
+   * Project the ratings of a new user into the factor space, with W fixed, by
+   * solving the regularized least-squares problem
+   *
+   * \f[
+   * \min_h \sum_{i \in S} (r_i - W_i h)^2 + \lambda ||h||^2
+   * \f]
+   *
+   * over the set S of items the user rated.  This takes O(|S| r^2 + r^3)
+   * time for rank r, whatever the size of the dataset, and does not change the
+   * model.  (For non-negative factorizations, the new factors are not
+   * constrained to be non-negative.)
+   *
+   * @param ratings (item, rating) table of the new user, one column for each
+   *     rating.
+   * @param factors Vector to store the factors of the user (its column of H)
+   *     in.
+   * @param lambda Regularization parameter.
+   */
+  void FoldInUser(const arma::mat& ratings,
+                  arma::vec& factors,
+                  const double lambda = 0.01) const;
+
+  /**
+   * Project the ratings of a new item into the factor space, with H fixed, as
+   * FoldInUser() does for users.
+   *
+   * @param ratings (user, rating) table of the new item, one column for each
+   *     rating.
+   * @param factors Vector to store the factors of the item (its row of W) in.
+   * @param lambda Regularization parameter.
+   */
+  void FoldInItem(const arma::mat& ratings,
+                  arma::rowvec& factors,
+                  const double lambda = 0.01) const;
+
+  /**
+   * Add a new user to the model: its factors are found with FoldInUser() and
+   * appended to H, and its ratings are added to the cleaned data, so that
+   * recommendations can be generated for it.  Adding the ratings copies the
+   * cleaned data, so to add many users at once, retraining may be faster.
+   *
+   * @param ratings (item, rating) table of the new user.
+   * @param lambda Regularization parameter.
+   * @return Index of the new user.
+   */
+  size_t AddUser(const arma::mat& ratings, const double lambda = 0.01);
+
+  /**
+   * Add a new item to the model: its factors are found with FoldInItem() and
+   * appended to W, and its ratings are added to the cleaned data.
+   *
+   * @param ratings (user, rating) table of the new item.
+   * @param lambda Regularization parameter.
+   * @return Index of the new item.
+   */
+  size_t AddItem(const arma::mat& ratings, const double lambda = 0.01);
+
   /**
    * Returns a string representation of this object.
    */
@@ -182,28 +281,24 @@ class CF
   arma::mat w;
   //! Item matrix.
   arma::mat h;
-  //! Rating matrix.
-  arma::mat rating;
   //! Cleaned data matrix.
   arma::sp_mat cleanedData;
   //! Converts the User, Item, Value Matrix to User-Item Table
   void CleanData(const arma::mat& data);
 
   /**
-   * Helper function to insert a point into the recommendation matrices.
+   * Add the given ratings to the cleaned data, which is resized to the given
+   * number of items and users.
    *
-   * @param queryIndex Index of point whose recommendations we are inserting
-   *     into.
-   * @param pos Position in list to insert into.
-   * @param neighbor Index of item being inserted as a recommendation.
-   * @param value Value of recommendation.
+   * @param locations (item, user) location of each new rating.
+   * @param values Value of each new rating.
+   * @param numItems New number of items.
+   * @param numUsers New number of users.
    */
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double value,
-                      arma::Mat<size_t>& recommendations,
-                      arma::mat& values) const;
+  void InsertRatings(const arma::umat& locations,
+                     const arma::vec& values,
+                     const size_t numItems,
+                     const size_t numUsers);
 
 }; // class CF
 
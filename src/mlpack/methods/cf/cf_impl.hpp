@@ -53,6 +53,22 @@ void ApplyFactorizer(arma::mat& data,
   factorizer.Apply(data, rank, w, h);
 }
 
+/**
+ * Orders candidate recommendations, as (value, item) pairs, so that the worst
+ * candidate (the lowest value, and the highest item among equal values) is at
+ * the top of a std::priority_queue.
+ */
+struct CandidateCompare
+{
+  bool operator()(const std::pair<double, size_t>& a,
+                  const std::pair<double, size_t>& b) const
+  {
+    if (a.first != b.first)
+      return a.first > b.first;
+    return a.second < b.second;
+  }
+};
+
 /**
  * Construct the CF object using an instantiated factorizer.
  */
@@ -116,81 +132,211 @@ void CF<FactorizerType>::GetRecommendations(const size_t numRecs,
                                             arma::Mat<size_t>& recommendations,
                                             arma::Col<size_t>& users)
 {
-  // Generate new table by multiplying approximate values.
-  rating = w * h;
-
-  // Now, we will use the decomposed w and h matrices to estimate what the user
-  // would have rated items as, and then pick the best items.
+  // The distance between the ratings of two users is
+  // || W h_i - W h_j || = || R (h_i - h_j) ||, for any R with R^T R = W^T W,
+  // so the neighborhoods can be found in the rank-dimensional factor space
+  // without forming the rating matrix.  R is taken from the eigendecomposition
+  // of W^T W, which (unlike the Cholesky decomposition) works even if W does
+  // not have full rank.
+  arma::vec eigenvalues;
+  arma::mat eigenvectors;
+  arma::eig_sym(eigenvalues, eigenvectors, arma::trans(w) * w);
+  for (size_t i = 0; i < eigenvalues.n_elem; ++i)
+    eigenvalues[i] = std::sqrt(std::max(eigenvalues[i], 0.0));
+  const arma::mat reference = arma::diagmat(eigenvalues) *
+      arma::trans(eigenvectors) * h;
 
   // Temporarily store feature vector of queried users.
-  arma::mat query(rating.n_rows, users.n_elem);
+  arma::mat query(reference.n_rows, users.n_elem);
 
   // Select feature vectors of queried users.
   for (size_t i = 0; i < users.n_elem; i++)
-    query.col(i) = rating.col(users(i));
+    query.col(i) = reference.col(users(i));
 
   // Temporary storage for neighborhood of the queried users.
   arma::Mat<size_t> neighborhood;
 
   // Calculate the neighborhood of the queried users.
   // This should be a templatized option.
-  neighbor::AllkNN a(rating, query);
+  neighbor::AllkNN a(reference, query);
   arma::mat resultingDistances; // Temporary storage.
   a.Search(numUsersForSimilarity, neighborhood, resultingDistances);
 
-  // Temporary storage for storing the average rating for each user in their
-  // neighborhood.
-  arma::mat averages = arma::zeros<arma::mat>(rating.n_rows, query.n_cols);
+  // Generate recommendations for each query user by finding the maximum numRecs
+  // average ratings of its neighbors.
+  recommendations.set_size(numRecs, users.n_elem);
+  recommendations.fill(cleanedData.n_rows); // Invalid item number.
+
+  // Users whose recommendations fill a block of this size are processed
+  // together, so that their average ratings are one matrix product.
+  const size_t blockSize = 256;
+  const size_t numBlocks = (users.n_elem + blockSize - 1) / blockSize;
 
-  // Iterate over each query user.
-  for (size_t i = 0; i < neighborhood.n_cols; ++i)
+  #pragma omp parallel
   {
-    // Iterate over each neighbor of the query user.
-    for (size_t j = 0; j < neighborhood.n_rows; ++j)
-      averages.col(i) += rating.col(neighborhood(j, i));
-    // Normalize average.
-    averages.col(i) /= neighborhood.n_rows;
+    // Each thread has its own buffers, allocated once.
+    arma::mat averages, ratings;
+    std::vector<bool> rated(cleanedData.n_rows, false);
+
+    // The worst of the current candidates of a user is at the top of the
+    // heap.
+    typedef std::pair<double, size_t> Candidate;
+    std::priority_queue<Candidate, std::vector<Candidate>, CandidateCompare>
+        candidates;
+
+    #pragma omp for schedule(static)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min((size_t) users.n_elem, begin + blockSize);
+
+      // The average rating of the neighbors is W times the average of their
+      // columns of H.
+      averages.zeros(h.n_rows, end - begin);
+      for (size_t i = begin; i < end; ++i)
+      {
+        for (size_t j = 0; j < neighborhood.n_rows; ++j)
+          averages.col(i - begin) += h.col(neighborhood(j, i));
+        averages.col(i - begin) /= neighborhood.n_rows;
+      }
+      ratings = w * averages;
+
+      for (size_t i = begin; i < end; ++i)
+      {
+        // Mark the items that the user has already rated.
+        const size_t user = users(i);
+        for (arma::sp_mat::const_iterator it = cleanedData.begin_col(user);
+             it != cleanedData.end_col(user); ++it)
+          rated[it.row()] = true;
+
+        const double* userRatings = ratings.colptr(i - begin);
+        for (size_t j = 0; j < ratings.n_rows; ++j)
+        {
+          if (rated[j])
+            continue; // The user already rated the item.
+
+          if (candidates.size() < numRecs)
+            candidates.push(Candidate(userRatings[j], j));
+          else if (numRecs > 0 && userRatings[j] > candidates.top().first)
+          {
+            candidates.pop();
+            candidates.push(Candidate(userRatings[j], j));
+          }
+        }
+
+        // If we were not able to come up with enough recommendations, issue a
+        // warning.
+        if (candidates.size() < numRecs)
+        {
+          #pragma omp critical
+          Log::Warn << "Could not provide " << numRecs << " recommendations "
+              << "for user " << user << " (not enough un-rated items)!"
+              << std::endl;
+        }
+
+        // The heap gives the candidates from worst to best.
+        while (!candidates.empty())
+        {
+          recommendations(candidates.size() - 1, i) = candidates.top().second;
+          candidates.pop();
+        }
+
+        for (arma::sp_mat::const_iterator it = cleanedData.begin_col(user);
+             it != cleanedData.end_col(user); ++it)
+          rated[it.row()] = false;
+      }
+    }
   }
+}
 
-  // Generate recommendations for each query user by finding the maximum numRecs
-  // elements in the averages matrix.
+template<typename FactorizerType>
+void CF<FactorizerType>::GetFactorRecommendations(
+    const size_t numRecs,
+    arma::Mat<size_t>& recommendations)
+{
+  arma::Col<size_t> users = arma::linspace<arma::Col<size_t> >(0,
+      cleanedData.n_cols - 1, cleanedData.n_cols);
+
+  GetFactorRecommendations(numRecs, recommendations, users);
+}
+
+template<typename FactorizerType>
+void CF<FactorizerType>::GetFactorRecommendations(
+    const size_t numRecs,
+    arma::Mat<size_t>& recommendations,
+    arma::Col<size_t>& users)
+{
   recommendations.set_size(numRecs, users.n_elem);
   recommendations.fill(cleanedData.n_rows); // Invalid item number.
-  arma::mat values(numRecs, users.n_elem);
-  values.fill(-DBL_MAX); // The smallest possible value.
-  for (size_t i = 0; i < users.n_elem; i++)
+  if (numRecs == 0)
+    return;
+
+  // The predicted rating of item i for user u is the inner product of row i
+  // of W and column u of H, so one cover tree is built on the rows of W.
+  const arma::mat items = arma::trans(w);
+  fastmks::FastMKS<kernel::LinearKernel> fastMKS(items);
+
+  // A FastMKS object can search several batches at once.
+  const size_t batchSize = 1024;
+  const size_t numBatches = (users.n_elem + batchSize - 1) / batchSize;
+
+  #pragma omp parallel
   {
-    // Look through the averages column corresponding to the current user.
-    for (size_t j = 0; j < averages.n_rows; ++j)
+    arma::mat queries, products;
+    arma::Mat<size_t> indices;
+    std::vector<bool> rated(cleanedData.n_rows, false);
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBatches; ++b)
     {
-      // Ensure that the user hasn't already rated the item.
-      if (cleanedData(j, users(i)) != 0.0)
-        continue; // The user already rated the item.
+      const size_t begin = b * batchSize;
+      const size_t end = std::min((size_t) users.n_elem, begin + batchSize);
 
-      // Is the estimated value better than the worst candidate?
-      const double value = averages(j, i);
-      if (value > values(values.n_rows - 1, i))
+      queries.set_size(h.n_rows, end - begin);
+      size_t maxRated = 0;
+      for (size_t i = begin; i < end; ++i)
       {
-        // It should be inserted.  Which position?
-        size_t insertPosition = values.n_rows - 1;
-        while (insertPosition > 0)
+        const size_t user = users(i);
+        queries.col(i - begin) = h.col(user);
+        maxRated = std::max(maxRated, (size_t) (cleanedData.col_ptrs[user + 1]
+            - cleanedData.col_ptrs[user]));
+      }
+
+      const size_t k = std::min(numRecs + maxRated, (size_t) items.n_cols);
+      fastMKS.Search(queries, k, indices, products);
+
+      for (size_t i = begin; i < end; ++i)
+      {
+        // Mark the items that the user has already rated.
+        const size_t user = users(i);
+        for (arma::sp_mat::const_iterator it = cleanedData.begin_col(user);
+             it != cleanedData.end_col(user); ++it)
+          rated[it.row()] = true;
+
+        // The results are sorted, so take the first un-rated items.
+        size_t found = 0;
+        for (size_t j = 0; (j < k) && (found < numRecs); ++j)
+        {
+          const size_t item = indices(j, i - begin);
+          if (item == size_t() - 1)
+            break; // No more results.
+          if (!rated[item])
+            recommendations(found++, i) = item;
+        }
+
+        if (found < numRecs)
         {
-          if (value <= values(insertPosition - 1, i))
-            break; // The current value is the right one.
-          insertPosition--;
+          #pragma omp critical
+          Log::Warn << "Could not provide " << numRecs << " recommendations "
+              << "for user " << user << " (not enough un-rated items)!"
+              << std::endl;
         }
 
-        // Now insert it into the list.
-        InsertNeighbor(i, insertPosition, j, value, recommendations,
-            values);
+        for (arma::sp_mat::const_iterator it = cleanedData.begin_col(user);
+             it != cleanedData.end_col(user); ++it)
+          rated[it.row()] = false;
       }
     }
-
-    // If we were not able to come up with enough recommendations, issue a
-    // warning.
-    if (recommendations(values.n_rows - 1, i) == cleanedData.n_rows + 1)
-      Log::Warn << "Could not provide " << values.n_rows << " recommendations "
-          << "for user " << users(i) << " (not enough un-rated items)!" << std::endl;
   }
 }
 
@@ -217,37 +363,124 @@ void CF<FactorizerType>::CleanData(const arma::mat& data)
   cleanedData = arma::sp_mat(locations, values, maxItemID, maxUserID);
 }
 
-/**
- * Helper function to insert a point into the recommendation matrices.
- *
- * @param queryIndex Index of point whose recommendations we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of item being inserted as a recommendation.
- * @param value Value of recommendation.
- */
 template<typename FactorizerType>
-void CF<FactorizerType>::InsertNeighbor(const size_t queryIndex,
-                                        const size_t pos,
-                                        const size_t neighbor,
-                                        const double value,
-                                        arma::Mat<size_t>& recommendations,
-                                        arma::mat& values) const
+void CF<FactorizerType>::FoldInUser(const arma::mat& ratings,
+                                    arma::vec& factors,
+                                    const double lambda) const
 {
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (recommendations.n_rows - 1))
+  // Gather the rows of W of the rated items; then solve
+  // (W_S^T W_S + lambda I) h = W_S^T r_S.
+  arma::mat rows(ratings.n_cols, w.n_cols);
+  arma::vec values(ratings.n_cols);
+  for (size_t i = 0; i < ratings.n_cols; ++i)
+  {
+    const size_t item = (size_t) ratings(0, i);
+    if (item >= w.n_rows)
+      Log::Fatal << "CF::FoldInUser(): item " << item << " is not in the model "
+          << "(there are " << w.n_rows << " items)!" << std::endl;
+
+    rows.row(i) = w.row(item);
+    values[i] = ratings(1, i);
+  }
+
+  arma::mat a = arma::trans(rows) * rows;
+  a.diag() += lambda;
+  factors = arma::solve(a, arma::trans(rows) * values);
+}
+
+template<typename FactorizerType>
+void CF<FactorizerType>::FoldInItem(const arma::mat& ratings,
+                                    arma::rowvec& factors,
+                                    const double lambda) const
+{
+  // Gather the columns of H of the users who rated the item; then solve
+  // (H_S H_S^T + lambda I) w^T = H_S r_S.
+  arma::mat cols(h.n_rows, ratings.n_cols);
+  arma::vec values(ratings.n_cols);
+  for (size_t i = 0; i < ratings.n_cols; ++i)
+  {
+    const size_t user = (size_t) ratings(0, i);
+    if (user >= h.n_cols)
+      Log::Fatal << "CF::FoldInItem(): user " << user << " is not in the model "
+          << "(there are " << h.n_cols << " users)!" << std::endl;
+
+    cols.col(i) = h.col(user);
+    values[i] = ratings(1, i);
+  }
+
+  arma::mat a = cols * arma::trans(cols);
+  a.diag() += lambda;
+  factors = arma::trans(arma::solve(a, cols * values));
+}
+
+template<typename FactorizerType>
+size_t CF<FactorizerType>::AddUser(const arma::mat& ratings,
+                                   const double lambda)
+{
+  arma::vec factors;
+  FoldInUser(ratings, factors, lambda);
+  h.insert_cols(h.n_cols, factors);
+
+  const size_t user = cleanedData.n_cols;
+  arma::umat locations(2, ratings.n_cols);
+  for (size_t i = 0; i < ratings.n_cols; ++i)
+  {
+    locations(0, i) = (arma::uword) ratings(0, i);
+    locations(1, i) = user;
+  }
+  InsertRatings(locations, arma::trans(ratings.row(1)), cleanedData.n_rows,
+      user + 1);
+
+  return user;
+}
+
+template<typename FactorizerType>
+size_t CF<FactorizerType>::AddItem(const arma::mat& ratings,
+                                   const double lambda)
+{
+  arma::rowvec factors;
+  FoldInItem(ratings, factors, lambda);
+  w.insert_rows(w.n_rows, factors);
+
+  const size_t item = cleanedData.n_rows;
+  arma::umat locations(2, ratings.n_cols);
+  for (size_t i = 0; i < ratings.n_cols; ++i)
+  {
+    locations(0, i) = item;
+    locations(1, i) = (arma::uword) ratings(0, i);
+  }
+  InsertRatings(locations, arma::trans(ratings.row(1)), item + 1,
+      cleanedData.n_cols);
+
+  return item;
+}
+
+template<typename FactorizerType>
+void CF<FactorizerType>::InsertRatings(const arma::umat& locations,
+                                       const arma::vec& values,
+                                       const size_t numItems,
+                                       const size_t numUsers)
+{
+  // Rebuild the sparse matrix with the batch insert constructor, from the old
+  // ratings and the new ones.
+  arma::umat allLocations(2, cleanedData.n_nonzero + locations.n_cols);
+  arma::vec allValues(cleanedData.n_nonzero + locations.n_cols);
+  size_t i = 0;
+  for (arma::sp_mat::const_iterator it = cleanedData.begin();
+       it != cleanedData.end(); ++it, ++i)
+  {
+    allLocations(0, i) = it.row();
+    allLocations(1, i) = it.col();
+    allValues[i] = *it;
+  }
+
+  if (locations.n_cols > 0)
   {
-    const int len = (values.n_rows - 1) - pos;
-    memmove(values.colptr(queryIndex) + (pos + 1),
-        values.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(recommendations.colptr(queryIndex) + (pos + 1),
-        recommendations.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
+    allLocations.cols(i, allLocations.n_cols - 1) = locations;
+    allValues.subvec(i, allValues.n_elem - 1) = values;
   }
 
-  // Now put the new information in the right index.
-  values(pos, queryIndex) = value;
-  recommendations(pos, queryIndex) = neighbor;
+  cleanedData = arma::sp_mat(allLocations, allValues, numItems, numUsers);
 }
 
 // Return string of object.
@@ -39,7 +39,12 @@ PROGRAM_INFO("Collaborating Filtering", "This program performs collaborative "
     "The following optimization algorithms can be used with --algorithm (-a) "
     "parameter: "
     "\n"
-    "RegSVD -- Regularized SVD using a SGD optimizer ");
+    "RegSVD -- Regularized SVD using a SGD optimizer "
+    "\n"
+    "ParallelRegSVD -- Regularized SVD using a lock-free parallel SGD "
+    "optimizer "
+    "\n"
+    "WeightedALS -- Alternating least squares over the observed ratings only");
 
 // Parameters for program.
 PARAM_STRING_REQ("input_file", "Input dataset to perform CF on.", "i");
@@ -60,6 +65,10 @@ PARAM_INT("neighborhood", "Size of the neighborhood of similar users to "
 
 PARAM_INT("rank", "Rank of decomposed matrices.", "R", 2);
 
+PARAM_FLAG("fastmks", "If set, recommend the items with the highest predicted "
+    "ratings, found with FastMKS, instead of averaging the ratings of the "
+    "neighborhood.", "F");
+
 template<typename Factorizer>
 void ComputeRecommendations(Factorizer factorizer,
                             arma::mat& dataset,
@@ -82,12 +91,18 @@ void ComputeRecommendations(Factorizer factorizer,
 
     Log::Info << "Generating recommendations for " << users.n_elem << " users "
         << "in '" << queryFile << "'." << endl;
-    c.GetRecommendations(numRecs, recommendations, users);
+    if (CLI::HasParam("fastmks"))
+      c.GetFactorRecommendations(numRecs, recommendations, users);
+    else
+      c.GetRecommendations(numRecs, recommendations, users);
   }
   else
   {
     Log::Info << "Generating recommendations for all users." << endl;
-    c.GetRecommendations(numRecs, recommendations);
+    if (CLI::HasParam("fastmks"))
+      c.GetFactorRecommendations(numRecs, recommendations);
+    else
+      c.GetRecommendations(numRecs, recommendations);
   }
 }
                             
@@ -126,6 +141,10 @@ int main(int argc, char** argv)
     CR(SparseSVDCompleteIncrementalFactorizer());
   else if(algo == "RegSVD")
     CR(RegularizedSVD<>());
+  else if(algo == "ParallelRegSVD")
+    CR(RegularizedSVD<optimization::ParallelSGD>());
+  else if(algo == "WeightedALS")
+    CR(SparseWeightedALSFactorizer());
 
   const string outputFile = CLI::GetParam<string>("output_file");
   data::Save(outputFile, recommendations);
@@ -101,16 +101,24 @@ double mlpack::cf::SVDWrapper<DummyClass>::Apply(const arma::mat& V,
     Log::Info << "Setting decomposition rank to " << r << std::endl;
   }
 
-  // get svd factorization
+  // get svd factorization; for a small rank, only the leading singular vectors
+  // are computed, with the randomized SVD
   arma::vec sigma;
-  arma::svd(W, sigma, H, V);
+  if (math::PreferRandomizedSVD(r, V.n_rows, V.n_cols))
+  {
+    math::RandomizedSVD(V, r, W, sigma, H);
+  }
+  else
+  {
+    arma::svd(W, sigma, H, V);
 
-  // remove the part of W and H depending upon the value of rank
-  W = W.submat(0, 0, W.n_rows - 1, r - 1);
-  H = H.submat(0, 0, H.n_cols - 1, r - 1);
+    // remove the part of W and H depending upon the value of rank
+    W = W.submat(0, 0, W.n_rows - 1, r - 1);
+    H = H.submat(0, 0, H.n_cols - 1, r - 1);
 
-  // take only required eigenvalues
-  sigma = sigma.subvec(0, r - 1);
+    // take only required eigenvalues
+    sigma = sigma.subvec(0, r - 1);
+  }
   
   // eigenvalue matrix is multiplied to W
   // it can either be multiplied to H matrix
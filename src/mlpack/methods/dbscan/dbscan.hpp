@@ -0,0 +1,155 @@
+/**
+ * @file dbscan.hpp
+ *
+ * An implementation of DBSCAN (density-based spatial clustering of applications
+ * with noise) that works directly on the dual-tree range traversal, so that the
+ * neighbor lists of the points are never stored.
+ *
+ * @code
+ * @inproceedings{ester1996density,
+ *   title={A density-based algorithm for discovering clusters in large spatial
+ *       databases with noise.},
+ *   author={Ester, M. and Kriegel, H.-P. and Sander, J. and Xu, X.},
+ *   booktitle={Proceedings of the Second International Conference on Knowledge
+ *       Discovery and Data Mining (KDD '96)},
+ *   pages={226--231},
+ *   year={1996}
+ * }
+ * @endcode
+ */
+#ifndef __MLPACK_METHODS_DBSCAN_DBSCAN_HPP
+#define __MLPACK_METHODS_DBSCAN_DBSCAN_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <mlpack/methods/range_search/range_search.hpp>
+
+namespace mlpack {
+namespace dbscan /** Density-based clustering. */ {
+
+/**
+ * DBSCAN clusters the points of a dataset by density.  A point is a core point
+ * if at least minPoints points (including itself) are within a distance of
+ * epsilon of it.  Core points within epsilon of each other are in the same
+ * cluster; a point that is not a core point, but is within epsilon of a core
+ * point, is a border point and joins the cluster of one such core point; every
+ * other point is noise.
+ *
+ * The clustering is done in two passes over a single tree.  First the core
+ * points are found with RangeSearch::Count(), which counts whole nodes inside
+ * the range without computing their distances.  Then a dual-tree traversal
+ * (see DBSCANRules) merges each pair of core points within epsilon of each
+ * other in a UnionFind structure as soon as it is found, so no neighbor list is
+ * ever stored, and node pairs entirely within epsilon are merged in time linear
+ * in their size.
+ *
+ * @code
+ * extern arma::mat data;
+ * DBSCAN<> dbscan(0.5, 5); // Epsilon of 0.5, at least 5 points per core.
+ *
+ * arma::Col<size_t> assignments;
+ * const size_t clusters = dbscan.Cluster(data, assignments);
+ * @endcode
+ *
+ * @tparam MetricType The metric to use.
+ * @tparam TreeType Type of tree to use; the tree must rearrange the dataset
+ *     into contiguous nodes, as BinarySpaceTree does.
+ */
+template<typename MetricType = metric::EuclideanDistance,
+         typename TreeType = tree::BinarySpaceTree<bound::HRectBound<2>,
+                                                   range::RangeSearchStat> >
+class DBSCAN
+{
+ public:
+  /**
+   * Create the DBSCAN object with the given parameters.
+   *
+   * @param epsilon Largest distance at which two points are neighbors.
+   * @param minPoints Smallest number of neighbors (including the point itself)
+   *     of a core point.
+   * @param naive If true, all pairs of points are compared, instead of using a
+   *     tree.
+   * @param leafSize Leaf size of the tree.
+   * @param metric Instantiated distance metric.
+   */
+  DBSCAN(const double epsilon,
+         const size_t minPoints,
+         const bool naive = false,
+         const size_t leafSize = 20,
+         const MetricType metric = MetricType());
+
+  /**
+   * Cluster the given dataset.  Clusters are numbered in order of their lowest
+   * point index, and noise points are given the label equal to the number of
+   * clusters returned.
+   *
+   * @param data Dataset to cluster.
+   * @param assignments Vector to store the cluster of each point in.
+   * @return Number of clusters found.
+   */
+  size_t Cluster(const typename TreeType::Mat& data,
+                 arma::Col<size_t>& assignments);
+
+  /**
+   * Cluster the given dataset, also returning which points are core points.
+   *
+   * @param data Dataset to cluster.
+   * @param assignments Vector to store the cluster of each point in.
+   * @param corePoints Vector to store in whether each point is a core point.
+   * @return Number of clusters found.
+   */
+  size_t Cluster(const typename TreeType::Mat& data,
+                 arma::Col<size_t>& assignments,
+                 std::vector<bool>& corePoints);
+
+  //! Get the largest distance at which two points are neighbors.
+  double Epsilon() const { return epsilon; }
+  //! Modify the largest distance at which two points are neighbors.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smallest number of neighbors of a core point.
+  size_t MinPoints() const { return minPoints; }
+  //! Modify the smallest number of neighbors of a core point.
+  size_t& MinPoints() { return minPoints; }
+
+  //! Get whether naive search is used.
+  bool Naive() const { return naive; }
+  //! Modify whether naive search is used.
+  bool& Naive() { return naive; }
+
+  //! Get the leaf size of the tree.
+  size_t LeafSize() const { return leafSize; }
+  //! Modify the leaf size of the tree.
+  size_t& LeafSize() { return leafSize; }
+
+  //! Get the traversal statistics of the last clustering.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+
+  // Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! The largest distance at which two points are neighbors.
+  double epsilon;
+  //! The smallest number of neighbors of a core point.
+  size_t minPoints;
+  //! If true, all pairs of points are compared.
+  bool naive;
+  //! The leaf size of the tree.
+  size_t leafSize;
+  //! Instantiated distance metric.
+  MetricType metric;
+
+  //! The traversal statistics of the last clustering.
+  tree::TraversalStatistics statistics;
+};
+
+}; // namespace dbscan
+}; // namespace mlpack
+
+// Include implementation.
+#include "dbscan_impl.hpp"
+
+#endif
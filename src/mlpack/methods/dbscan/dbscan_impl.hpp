@@ -0,0 +1,187 @@
+/**
+ * @file dbscan_impl.hpp
+ *
+ * Implementation of the DBSCAN class.
+ */
+#ifndef __MLPACK_METHODS_DBSCAN_DBSCAN_IMPL_HPP
+#define __MLPACK_METHODS_DBSCAN_DBSCAN_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dbscan.hpp"
+
+// The rules for the merging traversal.
+#include "dbscan_rules.hpp"
+
+namespace mlpack {
+namespace dbscan {
+
+template<typename MetricType, typename TreeType>
+DBSCAN<MetricType, TreeType>::DBSCAN(const double epsilon,
+                                     const size_t minPoints,
+                                     const bool naive,
+                                     const size_t leafSize,
+                                     const MetricType metric) :
+    epsilon(epsilon),
+    minPoints(minPoints),
+    naive(naive),
+    leafSize(leafSize),
+    metric(metric)
+{
+  if (epsilon < 0.0)
+  {
+    Log::Fatal << "DBSCAN::DBSCAN(): epsilon (" << epsilon << ") must not be "
+        << "negative!" << std::endl;
+  }
+}
+
+template<typename MetricType, typename TreeType>
+size_t DBSCAN<MetricType, TreeType>::Cluster(
+    const typename TreeType::Mat& data,
+    arma::Col<size_t>& assignments)
+{
+  std::vector<bool> corePoints;
+  return Cluster(data, assignments, corePoints);
+}
+
+template<typename MetricType, typename TreeType>
+size_t DBSCAN<MetricType, TreeType>::Cluster(
+    const typename TreeType::Mat& data,
+    arma::Col<size_t>& assignments,
+    std::vector<bool>& corePoints)
+{
+  statistics.Reset();
+  const size_t numPoints = data.n_cols;
+
+  // The tree is built on a copy of the data, because it rearranges the points;
+  // both passes work in the order of the tree.  In naive mode the copy is not
+  // rearranged.
+  typename TreeType::Mat dataset(data);
+  std::vector<size_t> oldFromNew;
+  TreeType* tree = NULL;
+  if (!naive)
+  {
+    statistics.StartPhase("tree_building");
+    tree = new TreeType(dataset, oldFromNew, leafSize);
+    statistics.StopPhase("tree_building");
+  }
+
+  // First pass: count the neighbors of each point to find the core points.
+  // Nodes entirely within epsilon are counted without computing distances.
+  statistics.StartPhase("core_points");
+  arma::Col<size_t> counts;
+  {
+    typedef range::RangeSearch<MetricType, TreeType> RangeSearchType;
+    RangeSearchType* rangeSearch = naive ?
+        new RangeSearchType(dataset, true, false, metric) :
+        new RangeSearchType(tree, dataset, false, metric);
+    rangeSearch->Count(math::Range(0.0, epsilon), counts);
+    statistics += rangeSearch->Statistics();
+    delete rangeSearch;
+  }
+
+  // The point itself counts towards minPoints.
+  std::vector<bool> treeCorePoints(numPoints);
+  size_t numCorePoints = 0;
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    treeCorePoints[i] = (counts[i] + 1 >= minPoints);
+    if (treeCorePoints[i])
+      ++numCorePoints;
+  }
+  statistics.StopPhase("core_points");
+
+  Log::Info << numCorePoints << " of " << numPoints << " points are core "
+      << "points." << std::endl;
+
+  // Second pass: unite neighboring core points and attach the border points,
+  // as each pair of neighbors is found.
+  statistics.StartPhase("merging");
+  emst::UnionFind connections(numPoints);
+  arma::Col<size_t> borderCores(numPoints);
+  borderCores.fill(numPoints);
+
+  typedef DBSCANRules<MetricType, TreeType> RuleType;
+  RuleType rules(dataset, epsilon, treeCorePoints, connections, borderCores,
+      metric);
+
+  if (naive)
+  {
+    // Each pair only needs to be considered once.
+    for (size_t i = 0; i < numPoints; ++i)
+      for (size_t j = i + 1; j < numPoints; ++j)
+        rules.BaseCase(i, j);
+  }
+  else
+  {
+    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
+    traverser.Traverse(*tree, *tree);
+    delete tree;
+  }
+
+  statistics += rules.Statistics();
+  statistics.StopPhase("merging");
+
+  // Map the points back to their original order.
+  std::vector<size_t> newFromOld(numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+    newFromOld[naive ? i : oldFromNew[i]] = i;
+
+  // Number the clusters in order of their lowest point; noise is labeled
+  // numPoints until the number of clusters is known.
+  arma::Col<size_t> componentCluster(numPoints);
+  componentCluster.fill(numPoints);
+  assignments.set_size(numPoints);
+  corePoints.resize(numPoints);
+  size_t numClusters = 0;
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    const size_t point = newFromOld[i];
+    corePoints[i] = treeCorePoints[point];
+
+    size_t root;
+    if (treeCorePoints[point])
+    {
+      root = connections.Find(point);
+    }
+    else if (borderCores[point] != numPoints)
+    {
+      root = connections.Find(borderCores[point]);
+    }
+    else
+    {
+      assignments[i] = numPoints;
+      continue;
+    }
+
+    if (componentCluster[root] == numPoints)
+      componentCluster[root] = numClusters++;
+    assignments[i] = componentCluster[root];
+  }
+
+  for (size_t i = 0; i < numPoints; ++i)
+    if (assignments[i] == numPoints)
+      assignments[i] = numClusters;
+
+  return numClusters;
+}
+
+template<typename MetricType, typename TreeType>
+std::string DBSCAN<MetricType, TreeType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "DBSCAN [" << this << "]" << std::endl;
+  convert << "  Epsilon: " << epsilon << std::endl;
+  convert << "  Minimum points: " << minPoints << std::endl;
+  if (naive)
+    convert << "  Naive: TRUE" << std::endl;
+  else
+    convert << "  Leaf size: " << leafSize << std::endl;
+  convert << "  Metric: " << std::endl <<
+      mlpack::util::Indent(metric.ToString(), 2);
+  return convert.str();
+}
+
+}; // namespace dbscan
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file dbscan_main.cpp
+ *
+ * Executable for running DBSCAN on a dataset.
+ */
+#include <mlpack/core.hpp>
+
+#include "dbscan.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::dbscan;
+
+PROGRAM_INFO("DBSCAN clustering",
+    "This program clusters the points of a dataset with DBSCAN "
+    "(density-based spatial clustering of applications with noise).  A point "
+    "is a core point if at least --min_points (-p) points, including itself, "
+    "are within --epsilon (-e) of it.  Core points within epsilon of each "
+    "other are in the same cluster, non-core points within epsilon of a core "
+    "point join one of its clusters, and all other points are noise."
+    "\n\n"
+    "The neighbors of each point are never stored: the core points are found "
+    "by counting with a dual-tree range search, and the clusters are merged "
+    "during a dual-tree traversal of a kd-tree."
+    "\n\n"
+    "The cluster of each point is saved to --output_file (-o), one label per "
+    "line.  Clusters are numbered from 0 in order of their lowest point, and "
+    "noise points are given the label one past the last cluster.  Whether "
+    "each point is a core point can be saved with --core_file (-C).");
+
+PARAM_STRING_REQ("input_file", "Input dataset to cluster.", "i");
+PARAM_STRING("output_file", "File to save the cluster of each point to.", "o",
+    "assignments.csv");
+PARAM_STRING("core_file", "If specified, save whether each point is a core "
+    "point (1) or not (0) to this file.", "C", "");
+
+PARAM_DOUBLE_REQ("epsilon", "Largest distance at which two points are "
+    "neighbors.", "e");
+PARAM_INT("min_points", "Smallest number of neighbors (including the point "
+    "itself) of a core point.", "p", 5);
+
+PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
+PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string inputFile = CLI::GetParam<string>("input_file");
+  const string outputFile = CLI::GetParam<string>("output_file");
+  const string coreFile = CLI::GetParam<string>("core_file");
+  const double epsilon = CLI::GetParam<double>("epsilon");
+
+  // Sanity checks on the parameters.
+  if (epsilon < 0.0)
+  {
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be greater than "
+        << "or equal to 0." << endl;
+  }
+
+  if (CLI::GetParam<int>("min_points") < 1)
+  {
+    Log::Fatal << "Invalid minimum number of points: "
+        << CLI::GetParam<int>("min_points") << ".  Must be greater than 0."
+        << endl;
+  }
+  const size_t minPoints = (size_t) CLI::GetParam<int>("min_points");
+
+  if (CLI::GetParam<int>("leaf_size") <= 0)
+  {
+    Log::Fatal << "Invalid leaf size: " << CLI::GetParam<int>("leaf_size")
+        << ".  Must be greater than 0." << endl;
+  }
+  const size_t leafSize = (size_t) CLI::GetParam<int>("leaf_size");
+
+  arma::mat dataset;
+  data::Load(inputFile, dataset, true);
+
+  DBSCAN<> dbscan(epsilon, minPoints, CLI::HasParam("naive"), leafSize);
+
+  arma::Col<size_t> assignments;
+  vector<bool> corePoints;
+  Timer::Start("clustering");
+  const size_t clusters = dbscan.Cluster(dataset, assignments, corePoints);
+  Timer::Stop("clustering");
+  dbscan.Statistics().Print();
+
+  size_t noise = 0;
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+    if (assignments[i] == clusters)
+      ++noise;
+
+  Log::Info << "Found " << clusters << " clusters; " << noise << " points are "
+      << "noise." << endl;
+
+  // Save the labels as one column.
+  arma::Mat<size_t> output = trans(assignments);
+  data::Save(outputFile, output);
+
+  if (coreFile != "")
+  {
+    arma::Mat<size_t> core(1, corePoints.size());
+    for (size_t i = 0; i < corePoints.size(); ++i)
+      core[i] = corePoints[i] ? 1 : 0;
+    data::Save(coreFile, core);
+  }
+}
@@ -0,0 +1,166 @@
+/**
+ * @file dbscan_rules.hpp
+ *
+ * Rules for the DBSCAN merging traversal, which unites core points within
+ * epsilon of each other as the pairs are found.
+ */
+#ifndef __MLPACK_METHODS_DBSCAN_DBSCAN_RULES_HPP
+#define __MLPACK_METHODS_DBSCAN_DBSCAN_RULES_HPP
+
+#include <mlpack/core/tree/leaf_block_distances.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <mlpack/methods/emst/union_find.hpp>
+
+#include "../neighbor_search/ns_traversal_info.hpp"
+
+namespace mlpack {
+namespace dbscan {
+
+/**
+ * The rules for the second pass of DBSCAN, once the core points are known.  A
+ * dual-tree traversal of the tree with itself finds every pair of points within
+ * epsilon of each other; each pair of core points is united in the UnionFind
+ * structure, and each non-core point found near a core point is recorded as a
+ * border point of that core point.  Nothing is stored per pair, and node pairs
+ * entirely within epsilon are handled in time linear in their size.
+ */
+template<typename MetricType, typename TreeType>
+class DBSCANRules
+{
+ public:
+  /**
+   * Construct the DBSCANRules object.  This is usually done from within the
+   * DBSCAN class at clustering time.
+   *
+   * @param dataset Set of points being clustered (in tree order).
+   * @param epsilon Largest distance at which two points are neighbors.
+   * @param corePoints Whether each point is a core point.
+   * @param connections UnionFind structure to unite core points in.
+   * @param borderCores Core point each border point is attached to; points
+   *     that are not attached hold the number of points.
+   * @param metric Instantiated metric.
+   */
+  DBSCANRules(const typename TreeType::Mat& dataset,
+              const double epsilon,
+              const std::vector<bool>& corePoints,
+              emst::UnionFind& connections,
+              arma::Col<size_t>& borderCores,
+              MetricType& metric);
+
+  /**
+   * Compute the base case between the given query point and reference point,
+   * connecting them if they are within epsilon of each other.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceIndex Index of reference point.
+   */
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  /**
+   * Compute the base cases between the given points of the query leaf (those
+   * that Score() did not prune) and every point in the reference leaf at once,
+   * if the metric allows it (see metric::BlockDistances()).  If it does not,
+   * nothing is done and false is returned.
+   *
+   * @param queryNode Query leaf.
+   * @param queryPoints Offsets in the query leaf of the points to compute.
+   * @param referenceNode Reference leaf.
+   * @return true if the base cases were computed.
+   */
+  bool BaseCases(TreeType& queryNode,
+                 const std::vector<size_t>& queryPoints,
+                 TreeType& referenceNode);
+
+  /**
+   * Get the score for recursion order.  The node is pruned (DBL_MAX is
+   * returned) if it is further than epsilon from the query point, or if it is
+   * entirely within epsilon, in which case all of its points are connected to
+   * the query point right away.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   */
+  double Score(const size_t queryIndex, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+  /**
+   * Get the score for recursion order.  The node combination is pruned
+   * (DBL_MAX is returned) if the nodes are further than epsilon apart, or if
+   * they are entirely within epsilon, in which case all of their points are
+   * connected right away.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   */
+  double Score(TreeType& queryNode, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+  typedef neighbor::NeighborSearchTraversalInfo<TreeType> TraversalInfoType;
+
+  const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
+  TraversalInfoType& TraversalInfo() { return traversalInfo; }
+
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+ private:
+  //! The set of points being clustered.
+  const typename TreeType::Mat& dataset;
+
+  //! The largest distance at which two points are neighbors.
+  double epsilon;
+
+  //! Whether each point is a core point.
+  const std::vector<bool>& corePoints;
+
+  //! The components of the core points.
+  emst::UnionFind& connections;
+
+  //! The core point each border point is attached to.
+  arma::Col<size_t>& borderCores;
+
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! Connect two points that are within epsilon of each other.
+  void Connect(const size_t a, const size_t b);
+
+  //! Connect every point of the two nodes, which are entirely within epsilon
+  //! of each other.
+  void ConnectAll(TreeType& queryNode, TreeType& referenceNode);
+
+  TraversalInfoType traversalInfo;
+
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
+};
+
+}; // namespace dbscan
+}; // namespace mlpack
+
+// Include implementation.
+#include "dbscan_rules_impl.hpp"
+
+#endif
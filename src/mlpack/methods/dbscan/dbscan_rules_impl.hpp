@@ -0,0 +1,215 @@
+/**
+ * @file dbscan_rules_impl.hpp
+ *
+ * Implementation of the DBSCAN merging rules.
+ */
+#ifndef __MLPACK_METHODS_DBSCAN_DBSCAN_RULES_IMPL_HPP
+#define __MLPACK_METHODS_DBSCAN_DBSCAN_RULES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dbscan_rules.hpp"
+
+namespace mlpack {
+namespace dbscan {
+
+template<typename MetricType, typename TreeType>
+DBSCANRules<MetricType, TreeType>::DBSCANRules(
+    const typename TreeType::Mat& dataset,
+    const double epsilon,
+    const std::vector<bool>& corePoints,
+    emst::UnionFind& connections,
+    arma::Col<size_t>& borderCores,
+    MetricType& metric) :
+    dataset(dataset),
+    epsilon(epsilon),
+    corePoints(corePoints),
+    connections(connections),
+    borderCores(borderCores),
+    metric(metric)
+{
+  // Nothing to do.
+}
+
+//! The base case.  Evaluate the distance between the two points and connect
+//! them if they are neighbors.
+template<typename MetricType, typename TreeType>
+inline force_inline
+double DBSCANRules<MetricType, TreeType>::BaseCase(
+    const size_t queryIndex,
+    const size_t referenceIndex)
+{
+  // A point is not its own neighbor.
+  if (queryIndex == referenceIndex)
+    return 0.0;
+
+  const double distance = metric.Evaluate(dataset.unsafe_col(queryIndex),
+      dataset.unsafe_col(referenceIndex));
+  ++statistics.BaseCases();
+
+  if (distance <= epsilon)
+    Connect(queryIndex, referenceIndex);
+
+  return distance;
+}
+
+//! Batched base cases between two leaves.
+template<typename MetricType, typename TreeType>
+bool DBSCANRules<MetricType, TreeType>::BaseCases(
+    TreeType& queryNode,
+    const std::vector<size_t>& queryPoints,
+    TreeType& referenceNode)
+{
+  if (queryPoints.empty() || referenceNode.NumPoints() == 0)
+    return false;
+
+  // blockDistances(i, k) is the distance between the i'th reference point and
+  // the query point queryPoints[k].
+  arma::mat blockDistances;
+  if (!tree::LeafBlockDistances(metric, dataset, referenceNode, dataset,
+      queryNode, queryPoints, blockDistances))
+    return false;
+
+  for (size_t k = 0; k < queryPoints.size(); ++k)
+  {
+    const size_t queryIndex = queryNode.Point(queryPoints[k]);
+    for (size_t i = 0; i < referenceNode.NumPoints(); ++i)
+    {
+      // A point is not its own neighbor.
+      const size_t referenceIndex = referenceNode.Point(i);
+      if (queryIndex == referenceIndex)
+        continue;
+
+      ++statistics.BaseCases();
+      if (blockDistances(i, k) <= epsilon)
+        Connect(queryIndex, referenceIndex);
+    }
+  }
+
+  return true;
+}
+
+//! Single-tree scoring function.
+template<typename MetricType, typename TreeType>
+double DBSCANRules<MetricType, TreeType>::Score(const size_t queryIndex,
+                                                TreeType& referenceNode)
+{
+  const math::Range distances =
+      referenceNode.RangeDistance(dataset.unsafe_col(queryIndex));
+
+  // If the node is too far away, prune it.
+  if (distances.Lo() > epsilon)
+    return statistics.Score(DBL_MAX, referenceNode);
+
+  // If every point in the node is a neighbor, connect them all now.  A core
+  // point is connected to each of them; any other point only needs one core
+  // point to be attached to.
+  if (distances.Hi() <= epsilon)
+  {
+    for (size_t i = 0; i < referenceNode.NumDescendants(); ++i)
+    {
+      const size_t referenceIndex = referenceNode.Descendant(i);
+      if (referenceIndex == queryIndex)
+        continue;
+
+      Connect(queryIndex, referenceIndex);
+      if (!corePoints[queryIndex] && corePoints[referenceIndex])
+        break;
+    }
+
+    return statistics.Score(DBL_MAX, referenceNode);
+  }
+
+  // Otherwise the score doesn't matter.  Recursion order is irrelevant here.
+  return statistics.Score(0.0, referenceNode);
+}
+
+//! Single-tree rescoring function.
+template<typename MetricType, typename TreeType>
+double DBSCANRules<MetricType, TreeType>::Rescore(
+    const size_t /* queryIndex */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  // If it wasn't pruned before, it isn't pruned now.
+  return oldScore;
+}
+
+//! Dual-tree scoring function.
+template<typename MetricType, typename TreeType>
+double DBSCANRules<MetricType, TreeType>::Score(TreeType& queryNode,
+                                                TreeType& referenceNode)
+{
+  const math::Range distances = referenceNode.RangeDistance(&queryNode);
+
+  // If the nodes are too far apart, prune the combination.
+  if (distances.Lo() > epsilon)
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
+
+  // If every pair of points is a pair of neighbors, connect them all now.
+  if (distances.Hi() <= epsilon)
+  {
+    ConnectAll(queryNode, referenceNode);
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
+  }
+
+  // Otherwise the score doesn't matter.  Recursion order is irrelevant here.
+  return statistics.Score(0.0, queryNode, referenceNode);
+}
+
+//! Dual-tree rescoring function.
+template<typename MetricType, typename TreeType>
+double DBSCANRules<MetricType, TreeType>::Rescore(
+    TreeType& /* queryNode */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  // If it wasn't pruned before, it isn't pruned now.
+  return oldScore;
+}
+
+//! Connect two neighboring points.
+template<typename MetricType, typename TreeType>
+inline force_inline
+void DBSCANRules<MetricType, TreeType>::Connect(const size_t a, const size_t b)
+{
+  if (corePoints[a] && corePoints[b])
+    connections.Union(a, b);
+  else if (corePoints[a] && (borderCores[b] == dataset.n_cols))
+    borderCores[b] = a;
+  else if (corePoints[b] && (borderCores[a] == dataset.n_cols))
+    borderCores[a] = b;
+}
+
+//! Connect every point of two nodes that are entirely within epsilon of each
+//! other.
+template<typename MetricType, typename TreeType>
+void DBSCANRules<MetricType, TreeType>::ConnectAll(TreeType& queryNode,
+                                                   TreeType& referenceNode)
+{
+  // All of the points are neighbors of each other, so connecting every point to
+  // one core point is enough.  If there are no core points, nothing happens.
+  size_t core = dataset.n_cols;
+  for (size_t i = 0; (i < queryNode.NumDescendants()) &&
+      (core == dataset.n_cols); ++i)
+    if (corePoints[queryNode.Descendant(i)])
+      core = queryNode.Descendant(i);
+  for (size_t i = 0; (i < referenceNode.NumDescendants()) &&
+      (core == dataset.n_cols); ++i)
+    if (corePoints[referenceNode.Descendant(i)])
+      core = referenceNode.Descendant(i);
+
+  if (core == dataset.n_cols)
+    return;
+
+  for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
+    if (queryNode.Descendant(i) != core)
+      Connect(core, queryNode.Descendant(i));
+  for (size_t i = 0; i < referenceNode.NumDescendants(); ++i)
+    if (referenceNode.Descendant(i) != core)
+      Connect(core, referenceNode.Descendant(i));
+}
+
+}; // namespace dbscan
+}; // namespace mlpack
+
+#endif
@@ -8,6 +8,7 @@
 #define __MLPACK_METHODS_DECISION_STUMP_DECISION_STUMP_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/binned_matrix.hpp>
 
 namespace mlpack {
 namespace decision_stump {
@@ -23,6 +24,13 @@ namespace decision_stump {
  * last bin has range up to \infty (split[i + 1] does not exist in that case).
  * Points that are below the first bin will take the label of the first bin.
  *
+ * Optionally, the stump can be trained in a quantized mode: each dimension of
+ * the data is binned once into at most 256 bins (see data::BinnedMatrix), and
+ * the splitting ranges of each attribute are built from per-bin histograms of
+ * the labels, with no sorting.  The ranges then start on bin boundaries.  A
+ * stump trained in this way passes its bins on to the stumps built from it,
+ * so AdaBoost bins the data once for all of its rounds.
+ *
  * @tparam MatType Type of matrix that is being used (sparse or dense).
  */
 template <typename MatType = arma::mat>
@@ -37,11 +45,14 @@ class DecisionStump
    * @param labels Labels of training data.
    * @param classes Number of distinct classes in labels.
    * @param inpBucketSize Minimum size of bucket when splitting.
+   * @param maxBins If nonzero, train in quantized mode, with at most this many
+   *     bins (at most 256) in each dimension.
    */
   DecisionStump(const MatType& data,
                 const arma::Row<size_t>& labels,
                 const size_t classes,
-                size_t inpBucketSize);
+                size_t inpBucketSize,
+                const size_t maxBins = 0);
 
   /**
    * Classification function. After training, classify test, and put the
@@ -56,7 +67,9 @@ class DecisionStump
   /**
    * Alternate constructor which copies parameters bucketSize and numClass from
    * an already initiated decision stump, other. It appropriately sets the
-   * weight vector.
+   * weight vector.  If other was trained in quantized mode, so is this stump;
+   * if other was trained on data of the same size (as in every round of
+   * AdaBoost), its bins are used instead of binning the data again.
    *
    * @param other The other initiated Decision Stump object from
    *      which we copy the values.
@@ -85,6 +98,12 @@ class DecisionStump
   //! Modify the labels for each split bin (be careful!).
   arma::Col<size_t>& BinLabels() { return binLabels; }
 
+  //! Get the maximum number of bins of each dimension in quantized mode (0 if
+  //! the stump is not quantized).
+  size_t MaxBins() const { return maxBins; }
+  //! Get the bins of the training data (empty unless this stump binned it).
+  const data::BinnedMatrix& Binned() const { return binned; }
+
  private:
   //! Stores the number of classes.
   size_t numClass;
@@ -101,6 +120,12 @@ class DecisionStump
   //! Stores the labels for each splitting bin.
   arma::Col<size_t> binLabels;
 
+  //! The maximum number of bins of each dimension in quantized mode.
+  size_t maxBins;
+
+  //! The bins of the training data, if this stump binned it.
+  data::BinnedMatrix binned;
+
   /**
    * Sets up attribute as if it were splitting on it and finds entropy when
    * splitting on attribute.
@@ -124,6 +149,67 @@ class DecisionStump
   template <typename rType> void TrainOnAtt(const arma::rowvec& attribute,
                                             const arma::Row<size_t>& labels);
 
+  /**
+   * Build the histograms of the labels of one attribute of the binned data,
+   * with the weight (or number) of the points of each class in each bin.
+   *
+   * @param bins Bins of the training data.
+   * @param attribute The attribute.
+   * @param labels Labels of the training data.
+   * @param weightD Weights of the training points (if isWeight is true).
+   * @param classWeights Matrix to store the histograms in (one column per bin).
+   * @param counts Vector to store the number of points in each bin in.
+   */
+  template <bool isWeight>
+  void BinHistograms(const data::BinnedMatrix& bins,
+                     const size_t attribute,
+                     const arma::Row<size_t>& labels,
+                     const arma::rowvec& weightD,
+                     arma::mat& classWeights,
+                     arma::Col<size_t>& counts) const;
+
+  /**
+   * Split the bins of an attribute into buckets of at least bucketSize points,
+   * each ending where the heaviest class of the bins changes, and return the
+   * first bin of each bucket.
+   *
+   * @param classWeights Histograms of the labels of the attribute.
+   * @param counts Number of points in each bin.
+   * @param firstBins Vector to store the first bin of each bucket in.
+   */
+  void BinBuckets(const arma::mat& classWeights,
+                  const arma::Col<size_t>& counts,
+                  std::vector<size_t>& firstBins) const;
+
+  /**
+   * The binned counterpart of SetupSplitAttribute(): find the entropy when
+   * splitting on the given attribute, from the histograms of its bins.
+   */
+  template <bool isWeight>
+  double SetupBinnedSplitAttribute(const data::BinnedMatrix& bins,
+                                   const size_t attribute,
+                                   const arma::Row<size_t>& labels,
+                                   const arma::rowvec& weightD);
+
+  /**
+   * The binned counterpart of TrainOnAtt(): set the splitting ranges of the
+   * given attribute from the histograms of its bins.
+   */
+  template <bool isWeight>
+  void TrainOnBinnedAtt(const data::BinnedMatrix& bins,
+                        const size_t attribute,
+                        const arma::rowvec& values,
+                        const arma::Row<size_t>& labels,
+                        const arma::rowvec& weightD);
+
+  //! Calculate the entropy of a histogram of labels, as CalculateEntropy()
+  //! does.
+  static double HistogramEntropy(const arma::vec& classWeights);
+
+  //! Return the heaviest class of a histogram of labels (the largest, if
+  //! several are as heavy, as CountMostFreq() does).
+  static size_t HeaviestClass(const arma::vec& classWeights);
+
   /**
    * After the "split" matrix has been set up, merge ranges with identical class
    * labels.
@@ -163,10 +249,12 @@ class DecisionStump
    * @param data Dataset to train on.
    * @param labels Labels for dataset.
    * @param isWeight Whether we need to run a weighted Decision Stump.
+   * @param bins Bins of the data, in quantized mode (NULL otherwise).
    */
   template <bool isWeight>
   void Train(const MatType& data, const arma::Row<size_t>& labels,
-             const arma::rowvec& weightD);
+             const arma::rowvec& weightD,
+             const data::BinnedMatrix* bins = NULL);
 
 };
 
@@ -26,14 +26,25 @@ template<typename MatType>
 DecisionStump<MatType>::DecisionStump(const MatType& data,
                                       const arma::Row<size_t>& labels,
                                       const size_t classes,
-                                      size_t inpBucketSize)
+                                      size_t inpBucketSize,
+                                      const size_t maxBins) :
+    maxBins(maxBins)
 {
   numClass = classes;
   bucketSize = inpBucketSize;
 
   arma::rowvec weightD;
 
-  Train<false>(data, labels, weightD);
+  if (maxBins > 0)
+  {
+    // Bin the data once; the stumps built from this one will use these bins.
+    binned.Bin(data, maxBins);
+    Train<false>(data, labels, weightD, &binned);
+  }
+  else
+  {
+    Train<false>(data, labels, weightD);
+  }
 }
 
 /**
@@ -46,42 +57,86 @@ DecisionStump<MatType>::DecisionStump(const MatType& data,
 template<typename MatType>
 template <bool isWeight>
 void DecisionStump<MatType>::Train(const MatType& data, const arma::Row<size_t>& labels,
-                                    const arma::rowvec& weightD)
+                                    const arma::rowvec& weightD,
+                                    const data::BinnedMatrix* bins)
 {
   // If classLabels are not all identical, proceed with training.
   int bestAtt = 0;
   double entropy;
-  const double rootEntropy = CalculateEntropy<size_t, isWeight>(
-      labels.subvec(0, labels.n_elem - 1), 0, weightD);
+  double rootEntropy;
+  if (bins == NULL)
+  {
+    rootEntropy = CalculateEntropy<size_t, isWeight>(
+        labels.subvec(0, labels.n_elem - 1), 0, weightD);
+  }
+  else
+  {
+    // In quantized mode, every entropy comes from a histogram.
+    arma::vec classWeights(numClass);
+    classWeights.zeros();
+    for (size_t i = 0; i < labels.n_elem; i++)
+      classWeights[labels[i]] += isWeight ? weightD[i] : 1.0;
+
+    rootEntropy = HistogramEntropy(classWeights);
+  }
 
-  double gain, bestGain = 0.0;
+  // The split search of each attribute is independent of the others, so if
+  // OpenMP is available, the attributes are searched in parallel.  Attributes
+  // with identical values are never chosen, which a gain of 0 ensures.
+  arma::vec gains(data.n_rows);
+  #pragma omp parallel for schedule(dynamic, 1) private(entropy)
   for (size_t i = 0; i < data.n_rows; i++)
   {
+    gains[i] = 0.0;
+
+    if (bins != NULL)
+    {
+      // An attribute with a single bin has identical values.
+      if (bins->NumBins(i) > 1)
+      {
+        entropy = SetupBinnedSplitAttribute<isWeight>(*bins, i, labels,
+            weightD);
+        gains[i] = rootEntropy - entropy;
+      }
+    }
     // Go through each attribute of the data.
-    if (IsDistinct<double>(data.row(i)))
+    else if (IsDistinct<double>(data.row(i)))
     {
       // For each attribute with non-identical values, treat it as a potential
       // splitting attribute and calculate entropy if split on it.
       entropy = SetupSplitAttribute<isWeight>(data.row(i), labels, weightD);
 
-      gain = rootEntropy - entropy;
-      // Find the attribute with the best entropy so that the gain is
-      // maximized.
+      gains[i] = rootEntropy - entropy;
+    }
+  }
 
-      // if (entropy < bestEntropy)
-      // Instead of the above rule, we are maximizing gain, which was
-      // what is returned from SetupSplitAttribute.
-      if (gain < bestGain)
-      {
-        bestAtt = i;
-        bestGain = gain;
-      }
+  // Find the attribute with the best entropy so that the gain is maximized,
+  // in order, so that ties are broken the same way no matter how many threads
+  // are used.
+  double bestGain = 0.0;
+  for (size_t i = 0; i < data.n_rows; i++)
+  {
+    // if (entropy < bestEntropy)
+    // Instead of the above rule, we are maximizing gain, which was
+    // what is returned from SetupSplitAttribute.
+    if (gains[i] < bestGain)
+    {
+      bestAtt = i;
+      bestGain = gains[i];
     }
   }
   splitAttribute = bestAtt;
 
   // Once the splitting column/attribute has been decided, train on it.
-  TrainOnAtt<double>(data.row(splitAttribute), labels);
+  if (bins != NULL)
+  {
+    TrainOnBinnedAtt<isWeight>(*bins, splitAttribute, data.row(splitAttribute),
+        labels, weightD);
+  }
+  else
+  {
+    TrainOnAtt<double>(data.row(splitAttribute), labels);
+  }
 }
 
 /**
@@ -96,6 +151,8 @@ template<typename MatType>
 void DecisionStump<MatType>::Classify(const MatType& test,
                                       arma::Row<size_t>& predictedLabels)
 {
+  // Each point is classified independently.
+  #pragma omp parallel for schedule(static)
   for (size_t i = 0; i < test.n_cols; i++)
   {
     // Determine which bin the test point falls into.
@@ -138,11 +195,26 @@ DecisionStump<MatType>::DecisionStump(
 {
   numClass = other.numClass;
   bucketSize = other.bucketSize;
+  maxBins = other.MaxBins();
 
   // weightD = weights;
   // tempD = weightD;
 
-  Train<true>(data, labels, weights);
+  if (maxBins == 0)
+  {
+    Train<true>(data, labels, weights);
+  }
+  else if (other.Binned().NumPoints() == data.n_cols &&
+           other.Binned().Dimensionality() == data.n_rows)
+  {
+    // The other stump was trained on this data, so its bins can be used.
+    Train<true>(data, labels, weights, &other.Binned());
+  }
+  else
+  {
+    binned.Bin(data, maxBins);
+    Train<true>(data, labels, weights, &binned);
+  }
 }
 
 /**
@@ -163,11 +235,9 @@ double DecisionStump<MatType>::SetupSplitAttribute(
   size_t i, count, begin, end;
   double entropy = 0.0;
 
-  // Sort the attribute in order to calculate splitting ranges.
-  arma::rowvec sortedAtt = arma::sort(attribute);
-
   // Store the indices of the sorted attribute to build a vector of sorted
-  // labels.  This sort is stable.
+  // labels, in order to calculate splitting ranges.  This sort is stable, and
+  // it is the only sort needed.
   arma::uvec sortedIndexAtt = arma::stable_sort_index(attribute.t());
 
   arma::Row<size_t> sortedLabels(attribute.n_elem);
@@ -254,15 +324,20 @@ void DecisionStump<MatType>::TrainOnAtt(const arma::rowvec& attribute,
 {
   size_t i, count, begin, end;
 
-  arma::rowvec sortedSplitAtt = arma::sort(attribute);
+  // Sort the attribute once; the sorted values and labels both come from the
+  // sorted indices.
   arma::uvec sortedSplitIndexAtt = arma::stable_sort_index(attribute.t());
+  arma::rowvec sortedSplitAtt(attribute.n_elem);
   arma::Row<size_t> sortedLabels(attribute.n_elem);
   sortedLabels.fill(0);
   arma::vec tempSplit;
   arma::Row<size_t> tempLabel;
 
   for (i = 0; i < attribute.n_elem; i++)
+  {
+    sortedSplitAtt(i) = attribute(sortedSplitIndexAtt(i));
     sortedLabels(i) = labels(sortedSplitIndexAtt(i));
+  }
 
   arma::rowvec subCols;
   rType mostFreq;
@@ -332,6 +407,159 @@ void DecisionStump<MatType>::TrainOnAtt(const arma::rowvec& attribute,
   MergeRanges();
 }
 
+template <typename MatType>
+template <bool isWeight>
+void DecisionStump<MatType>::BinHistograms(const data::BinnedMatrix& bins,
+                                           const size_t attribute,
+                                           const arma::Row<size_t>& labels,
+                                           const arma::rowvec& weightD,
+                                           arma::mat& classWeights,
+                                           arma::Col<size_t>& counts) const
+{
+  const size_t numBins = bins.NumBins(attribute);
+  classWeights.zeros(numClass, numBins);
+  counts.zeros(numBins);
+
+  const unsigned char* attBins = bins.Dimension(attribute);
+  for (size_t i = 0; i < labels.n_elem; i++)
+  {
+    classWeights(labels[i], attBins[i]) += isWeight ? weightD[i] : 1.0;
+    ++counts[attBins[i]];
+  }
+}
+
+template <typename MatType>
+void DecisionStump<MatType>::BinBuckets(const arma::mat& classWeights,
+                                        const arma::Col<size_t>& counts,
+                                        std::vector<size_t>& firstBins) const
+{
+  // This is the same splitting as SetupSplitAttribute(), but whole bins are
+  // added to a bucket at a time, and the label of a bin is its heaviest class.
+  firstBins.clear();
+  size_t bucketPoints = 0;
+  bool bucketOpen = false;
+  for (size_t b = 0; b < counts.n_elem; b++)
+  {
+    if (counts[b] == 0)
+      continue;
+
+    if (!bucketOpen)
+    {
+      firstBins.push_back(b);
+      bucketOpen = true;
+    }
+    bucketPoints += counts[b];
+
+    size_t next = b + 1;
+    while (next < counts.n_elem && counts[next] == 0)
+      ++next;
+    if (next == counts.n_elem)
+      break;
+
+    if (bucketPoints >= bucketSize && HeaviestClass(classWeights.col(b)) !=
+        HeaviestClass(classWeights.col(next)))
+    {
+      bucketOpen = false;
+      bucketPoints = 0;
+    }
+  }
+}
+
+template <typename MatType>
+template <bool isWeight>
+double DecisionStump<MatType>::SetupBinnedSplitAttribute(
+    const data::BinnedMatrix& bins,
+    const size_t attribute,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& weightD)
+{
+  arma::mat classWeights;
+  arma::Col<size_t> counts;
+  BinHistograms<isWeight>(bins, attribute, labels, weightD, classWeights,
+      counts);
+
+  std::vector<size_t> firstBins;
+  BinBuckets(classWeights, counts, firstBins);
+
+  // As in SetupSplitAttribute(), the entropy of each bucket is weighted by the
+  // ratio of points in it.
+  double entropy = 0.0;
+  for (size_t j = 0; j < firstBins.size(); j++)
+  {
+    const size_t last = (j + 1 < firstBins.size()) ? firstBins[j + 1] - 1 :
+        counts.n_elem - 1;
+    const double ratioEl = (double) arma::accu(counts.subvec(firstBins[j],
+        last)) / labels.n_elem;
+
+    entropy += ratioEl * HistogramEntropy(arma::sum(classWeights.cols(
+        firstBins[j], last), 1));
+  }
+
+  return entropy;
+}
+
+template <typename MatType>
+template <bool isWeight>
+void DecisionStump<MatType>::TrainOnBinnedAtt(const data::BinnedMatrix& bins,
+                                              const size_t attribute,
+                                              const arma::rowvec& values,
+                                              const arma::Row<size_t>& labels,
+                                              const arma::rowvec& weightD)
+{
+  arma::mat classWeights;
+  arma::Col<size_t> counts;
+  BinHistograms<isWeight>(bins, attribute, labels, weightD, classWeights,
+      counts);
+
+  std::vector<size_t> firstBins;
+  BinBuckets(classWeights, counts, firstBins);
+
+  // Each range after the first starts at the cut point below its first bin;
+  // the first starts at the smallest value, as in TrainOnAtt().
+  split.set_size(firstBins.size());
+  binLabels.set_size(firstBins.size());
+  for (size_t j = 0; j < firstBins.size(); j++)
+  {
+    const size_t last = (j + 1 < firstBins.size()) ? firstBins[j + 1] - 1 :
+        counts.n_elem - 1;
+
+    split[j] = (j == 0) ? arma::min(values) :
+        bins.Cuts(attribute)[firstBins[j] - 1];
+    binLabels[j] = HeaviestClass(arma::sum(classWeights.cols(firstBins[j],
+        last), 1));
+  }
+
+  MergeRanges();
+}
+
+template <typename MatType>
+double DecisionStump<MatType>::HistogramEntropy(const arma::vec& classWeights)
+{
+  const double accWeight = arma::accu(classWeights);
+  if (accWeight <= 0.0)
+    return 0.0;
+
+  double entropy = 0.0;
+  for (size_t j = 0; j < classWeights.n_elem; j++)
+  {
+    const double p1 = classWeights[j] / accWeight;
+    entropy += (p1 == 0) ? 0 : p1 * std::log(p1);
+  }
+
+  return entropy / std::log(2.0);
+}
+
+template <typename MatType>
+size_t DecisionStump<MatType>::HeaviestClass(const arma::vec& classWeights)
+{
+  size_t heaviest = 0;
+  for (size_t j = 1; j < classWeights.n_elem; j++)
+    if (classWeights[j] >= classWeights[heaviest])
+      heaviest = j;
+
+  return heaviest;
+}
+
 /**
  * After the "split" matrix has been set up, merge ranges with identical class
  * labels.
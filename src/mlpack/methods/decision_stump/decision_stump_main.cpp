@@ -46,6 +46,9 @@ PARAM_STRING("output_file", "The file in which the predicted labels for the "
 
 PARAM_INT("bin_size", "The minimum number of training points in each "
     "decision stump bin.", "b", 6);
+PARAM_INT("max_bins", "If nonzero, bin each dimension of the training set "
+    "into at most this many bins (at most 256) and find the splitting ranges "
+    "from histograms of the bins, instead of sorting.", "m", 0);
 
 int main(int argc, char *argv[])
 {
@@ -84,6 +87,13 @@ int main(int argc, char *argv[])
   const size_t inpBucketSize = CLI::GetParam<int>("bucket_size");
   const size_t numClasses = labels.max() + 1;
 
+  const int maxBins = CLI::GetParam<int>("max_bins");
+  if (maxBins != 0 && (maxBins < 2 || maxBins > 256))
+  {
+    Log::Fatal << "Invalid number of bins (" << maxBins << "); must be 0 or "
+        << "between 2 and 256." << endl;
+  }
+
   // Load the test file.
   const string testingDataFilename = CLI::GetParam<std::string>("test_file");
   mat testingData;
@@ -96,7 +106,7 @@ int main(int argc, char *argv[])
 
   Timer::Start("training");
   DecisionStump<> ds(trainingData, labels.t(), numClasses,
-                     inpBucketSize);
+                     inpBucketSize, (size_t) maxBins);
   Timer::Stop("training");
 
   Row<size_t> predictedLabels(testingData.n_cols);
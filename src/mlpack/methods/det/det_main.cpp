@@ -7,6 +7,7 @@
 
 #include <mlpack/core.hpp>
 #include "dt_utils.hpp"
+#include "flat_dtree.hpp"
 
 using namespace mlpack;
 using namespace mlpack::det;
@@ -23,7 +24,9 @@ PROGRAM_INFO("Density Estimation With Density Estimation Trees",
     "in the DET can be calculated."
     "\n\n"
     "The created DET can be saved to a file, along with the density estimates "
-    "for the test set and the variable importances.");
+    "for the test set and the variable importances.  The DET can also be saved "
+    "in a compact binary form (with --flat_tree_file), which can be loaded to "
+    "compute density estimates quickly.");
 
 // Input data files.
 PARAM_STRING_REQ("train_file", "The data set on which to build a density "
@@ -49,6 +52,8 @@ PARAM_STRING("tree_file", "The file in which to print the final optimally "
     "pruned tree.", "r", "");
 PARAM_STRING("vi_file", "The file to output the variable importance values "
     "for each feature.", "i", "");
+PARAM_STRING("flat_tree_file", "The file in which to save the final optimally "
+    "pruned tree in binary form (see FlatDTree).", "F", "");
 
 // Parameters for the algorithm.
 PARAM_INT("folds", "The number of folds of cross-validation to perform for the "
@@ -57,6 +62,13 @@ PARAM_INT("min_leaf_size", "The minimum size of a leaf in the unpruned, fully "
     "grown DET.", "N", 5);
 PARAM_INT("max_leaf_size", "The maximum size of a leaf in the unpruned, fully "
     "grown DET.", "M", 10);
+PARAM_FLAG("presort", "Sort each dimension of the data once before growing "
+    "each tree, instead of at every node.  This is faster, but uses more "
+    "memory.", "P");
+PARAM_INT("max_bins", "If nonzero, bin each dimension of the data into at most "
+    "this many bins (at most 256) once before growing each tree, and find "
+    "splits from histograms of the bins instead of sorting.  Splits are then "
+    "only made between bins.", "B", 0);
 /*
 PARAM_FLAG("volume_regularization", "This flag gives the used the option to use"
     "a form of regularization similar to the usual alpha-pruning in decision "
@@ -99,12 +111,28 @@ int main(int argc, char *argv[])
   const int maxLeafSize = CLI::GetParam<int>("max_leaf_size");
   const int minLeafSize = CLI::GetParam<int>("min_leaf_size");
 
+  const int maxBins = CLI::GetParam<int>("max_bins");
+  if (maxBins != 0 && (maxBins < 2 || maxBins > 256))
+  {
+    Log::Fatal << "Invalid number of bins (" << maxBins << "); must be 0 or "
+        << "between 2 and 256." << endl;
+  }
+  if (maxBins != 0 && CLI::HasParam("presort"))
+    Log::Warn << "--presort is ignored when --max_bins is given." << endl;
+
   // Obtain the optimal tree.
   Timer::Start("det_training");
   DTree *dtreeOpt = Trainer(trainingData, folds, regularization, maxLeafSize,
-      minLeafSize, unprunedTreeEstimateFile);
+      minLeafSize, unprunedTreeEstimateFile, CLI::HasParam("presort"),
+      (size_t) maxBins);
   Timer::Stop("det_training");
 
+  // The density estimates are computed with the flattened tree, which gives the
+  // same results but evaluates all of the points at once.
+  FlatDTree flatTree(*dtreeOpt);
+  if (CLI::GetParam<string>("flat_tree_file") != "")
+    flatTree.Save(CLI::GetParam<string>("flat_tree_file"));
+
   // Compute densities for the training points in the optimal tree.
   FILE *fp = NULL;
 
@@ -115,10 +143,13 @@ int main(int argc, char *argv[])
 
     // Compute density estimates for each point in the training set.
     Timer::Start("det_estimation_time");
-    for (size_t i = 0; i < trainingData.n_cols; i++)
-      fprintf(fp, "%lg\n", dtreeOpt->ComputeValue(trainingData.unsafe_col(i)));
+    arma::vec estimates;
+    flatTree.ComputeValues(trainingData, estimates);
     Timer::Stop("det_estimation_time");
 
+    for (size_t i = 0; i < estimates.n_elem; i++)
+      fprintf(fp, "%lg\n", estimates[i]);
+
     fclose(fp);
   }
 
@@ -137,10 +168,13 @@ int main(int argc, char *argv[])
       fp = fopen(CLI::GetParam<string>("test_set_estimates_file").c_str(), "w");
 
       Timer::Start("det_test_set_estimation");
-      for (size_t i = 0; i < testData.n_cols; i++)
-        fprintf(fp, "%lg\n", dtreeOpt->ComputeValue(testData.unsafe_col(i)));
+      arma::vec estimates;
+      flatTree.ComputeValues(testData, estimates);
       Timer::Stop("det_test_set_estimation");
 
+      for (size_t i = 0; i < estimates.n_elem; i++)
+        fprintf(fp, "%lg\n", estimates[i]);
+
       fclose(fp);
     }
   }
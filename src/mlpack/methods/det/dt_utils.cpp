@@ -101,7 +101,9 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
                             const bool useVolumeReg,
                             const size_t maxLeafSize,
                             const size_t minLeafSize,
-                            const std::string unprunedTreeOutput)
+                            const std::string unprunedTreeOutput,
+                            const bool presort,
+                            const size_t maxBins)
 {
   // Initialize the tree.
   DTree* dtree = new DTree(dataset);
@@ -117,7 +119,7 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
   // Growing the tree
   double oldAlpha = 0.0;
   double alpha = dtree->Grow(newDataset, oldFromNew, useVolumeReg, maxLeafSize,
-      minLeafSize);
+      minLeafSize, presort, maxBins);
 
   Log::Info << dtree->SubtreeLeaves() << " leaf nodes in the tree using full "
       << "dataset; minimum alpha: " << alpha << "." << std::endl;
@@ -170,13 +172,18 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
 
   delete dtree;
 
-  arma::mat cvData(dataset);
+  const arma::mat& cvData = dataset;
   size_t testSize = dataset.n_cols / folds;
 
-  std::vector<double> regularizationConstants;
-  regularizationConstants.resize(prunedSequence.size(), 0);
+  // The contribution of each fold to each regularization constant.  The folds
+  // are independent, so if OpenMP is available they are run in parallel; each
+  // fold keeps its own column so that the sum below does not depend on the
+  // order the folds finish in.
+  arma::mat foldConstants(prunedSequence.size(), folds);
+  foldConstants.zeros();
 
   // Go through each fold.
+  #pragma omp parallel for schedule(dynamic, 1)
   for (size_t fold = 0; fold < folds; fold++)
   {
     // Break up data into train and test sets.
@@ -209,9 +216,8 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
       cvOldFromNew[i] = i;
 
     // Grow the tree.
-    oldAlpha = 0.0;
-    alpha = cvDTree->Grow(train, cvOldFromNew, useVolumeReg, maxLeafSize,
-        minLeafSize);
+    cvDTree->Grow(train, cvOldFromNew, useVolumeReg, maxLeafSize, minLeafSize,
+        presort, maxBins);
 
     // Sequentially prune with all the values of available alphas and adding
     // values for test values.  Don't enter this loop if there are less than two
@@ -228,12 +234,12 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
       }
 
       // Update the cv regularization constant.
-      regularizationConstants[i] += 2.0 * cvVal / (double) dataset.n_cols;
+      foldConstants(i, fold) = 2.0 * cvVal / (double) dataset.n_cols;
 
       // Determine the new alpha value and prune accordingly.
-      oldAlpha = 0.5 * (prunedSequence[i + 1].first +
+      const double foldAlpha = 0.5 * (prunedSequence[i + 1].first +
           prunedSequence[i + 2].first);
-      alpha = cvDTree->PruneAndUpdate(oldAlpha, train.n_cols, useVolumeReg);
+      cvDTree->PruneAndUpdate(foldAlpha, train.n_cols, useVolumeReg);
     }
 
     // Compute test values for this state of the tree.
@@ -245,13 +251,19 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
     }
 
     if (prunedSequence.size() > 2)
-      regularizationConstants[prunedSequence.size() - 2] += 2.0 * cvVal /
+      foldConstants(prunedSequence.size() - 2, fold) = 2.0 * cvVal /
           (double) dataset.n_cols;
 
     test.reset();
     delete cvDTree;
   }
 
+  std::vector<double> regularizationConstants;
+  regularizationConstants.resize(prunedSequence.size(), 0);
+  for (size_t fold = 0; fold < folds; ++fold)
+    for (size_t i = 0; i < prunedSequence.size(); ++i)
+      regularizationConstants[i] += foldConstants(i, fold);
+
   double optimalAlpha = -1.0;
   long double cvBestError = -std::numeric_limits<long double>::max();
 
@@ -284,7 +296,7 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
   // Grow the tree.
   oldAlpha = -DBL_MAX;
   alpha = dtreeOpt->Grow(newDataset, oldFromNew, useVolumeReg, maxLeafSize,
-      minLeafSize);
+      minLeafSize, presort, maxBins);
 
   // Prune with optimal alpha.
   while ((oldAlpha < optimalAlpha) && (dtreeOpt->SubtreeLeaves() > 1))
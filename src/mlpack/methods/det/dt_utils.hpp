@@ -53,13 +53,19 @@ void PrintVariableImportance(const DTree* dtree,
  * @param maxLeafSize Maximum number of points allowed in a leaf.
  * @param minLeafSize Minimum number of points allowed in a leaf.
  * @param unprunedTreeOutput Filename to print unpruned tree to (optional).
+ * @param presort If true, sort each dimension once before growing each tree
+ *     (see DTree::Grow()).
+ * @param maxBins If nonzero, bin each dimension into at most this many bins
+ *     before growing each tree (see DTree::Grow()).
  */
 DTree* Trainer(arma::mat& dataset,
                const size_t folds,
                const bool useVolumeReg = false,
                const size_t maxLeafSize = 10,
                const size_t minLeafSize = 5,
-               const std::string unprunedTreeOutput = "");
+               const std::string unprunedTreeOutput = "",
+               const bool presort = false,
+               const size_t maxBins = 0);
 
 }; // namespace det
 }; // namespace mlpack
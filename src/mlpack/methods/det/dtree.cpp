@@ -130,7 +130,8 @@ bool DTree::FindSplit(const arma::mat& data,
                       double& splitValue,
                       double& leftError,
                       double& rightError,
-                      const size_t minLeafSize) const
+                      const size_t minLeafSize,
+                      const SortedDimensions* sorted) const
 {
   // Ensure the dimensionality of the data is the same as the dimensionality of
   // the bounding rectangle.
@@ -165,15 +166,20 @@ bool DTree::FindSplit(const arma::mat& data,
     // Find the log volume of all the other dimensions.
     double volumeWithoutDim = logVolume - std::log(max - min);
 
-    // Get the values for the dimension.
-    arma::rowvec dimVec = data.row(dim).subvec(start, end - 1);
-
-    // Sort the values in ascending order.
-    dimVec = arma::sort(dimVec);
+    // Get the values for the dimension in ascending order.  If they were
+    // presorted, they don't need to be sorted again.
+    arma::rowvec sortedDim;
+    if (sorted == NULL)
+    {
+      sortedDim = data.row(dim).subvec(start, end - 1);
+      sortedDim = arma::sort(sortedDim);
+    }
+    const double* dimVec = (sorted == NULL) ? sortedDim.memptr() :
+        sorted->values.colptr(dim) + (start - sorted->offset);
 
     // Find the best split for this dimension.  We need to figure out why
     // there are spikes if this minLeafSize is enforced here...
-    for (size_t i = minLeafSize - 1; i < dimVec.n_elem - minLeafSize; ++i)
+    for (size_t i = minLeafSize - 1; i < points - minLeafSize; ++i)
     {
       // This makes sense for real continuous data.  This kinda corrupts the
       // data and estimation if the data is ordinal.
@@ -232,6 +238,104 @@ bool DTree::FindSplit(const arma::mat& data,
   return splitFound;
 }
 
+// This function finds the best split in the same way as FindSplit(), but the
+// possible splits are the cut points between the bins of each dimension, and
+// the number of points on each side of a cut comes from the number of points of
+// the node in each bin, so nothing is sorted.
+bool DTree::FindBinnedSplit(const arma::mat& data,
+                            const arma::Col<size_t>& oldFromNew,
+                            const BinnedDimensions& binned,
+                            size_t& splitDim,
+                            double& splitValue,
+                            double& leftError,
+                            double& rightError,
+                            const size_t minLeafSize) const
+{
+  assert(data.n_rows == maxVals.n_elem);
+  assert(data.n_rows == minVals.n_elem);
+
+  const size_t points = end - start;
+
+  double minError = logNegError;
+  bool splitFound = false;
+
+  std::vector<size_t> counts;
+  for (size_t dim = 0; dim < maxVals.n_elem; dim++)
+  {
+    const double min = minVals[dim];
+    const double max = maxVals[dim];
+
+    // If there is nothing to split in this dimension, move on.
+    if (max - min == 0.0)
+      continue;
+
+    // Count the points of this node in each bin of this dimension.
+    const unsigned char* dimBins = binned.bins.Dimension(dim);
+    counts.assign(binned.bins.NumBins(dim), 0);
+    for (size_t i = start; i < end; ++i)
+      ++counts[dimBins[binned.rows[oldFromNew[i]]]];
+
+    bool dimSplitFound = false;
+    double minDimError = std::pow(points, 2.0) / (max - min);
+    double dimLeftError = 0.0; // For -Wuninitialized.  These variables will
+    double dimRightError = 0.0; // always be set to something else before use.
+    double dimSplitValue = 0.0;
+
+    // Find the log volume of all the other dimensions.
+    double volumeWithoutDim = logVolume - std::log(max - min);
+
+    // The points left of cut b are the points in bins 0 through b.
+    const arma::vec& cuts = binned.bins.Cuts(dim);
+    size_t leftPoints = 0;
+    for (size_t b = 0; b < cuts.n_elem; ++b)
+    {
+      leftPoints += counts[b];
+      if (leftPoints < minLeafSize)
+        continue;
+      if (points - leftPoints < minLeafSize)
+        break;
+
+      const double split = cuts[b];
+      if ((split - min > 0.0) && (max - split > 0.0))
+      {
+        // This is the same error reduction condition as in FindSplit().
+        double negLeftError = std::pow(leftPoints, 2.0) / (split - min);
+        double negRightError = std::pow(points - leftPoints, 2.0) /
+            (max - split);
+
+        // If this is better, take it.
+        if ((negLeftError + negRightError) >= minDimError)
+        {
+          minDimError = negLeftError + negRightError;
+          dimLeftError = negLeftError;
+          dimRightError = negRightError;
+          dimSplitValue = split;
+          dimSplitFound = true;
+        }
+      }
+    }
+
+    double actualMinDimError = std::log(minDimError)
+        - 2 * std::log((double) data.n_cols) - volumeWithoutDim;
+
+    if ((actualMinDimError > minError) && dimSplitFound)
+    {
+      // Calculate actual error (in logspace) by adding terms back to our
+      // estimate.
+      minError = actualMinDimError;
+      splitDim = dim;
+      splitValue = dimSplitValue;
+      leftError = std::log(dimLeftError) - 2 * std::log((double) data.n_cols)
+          - volumeWithoutDim;
+      rightError = std::log(dimRightError) - 2 * std::log((double) data.n_cols)
+          - volumeWithoutDim;
+      splitFound = true;
+    } // end if better split found in this dimension.
+  }
+
+  return splitFound;
+}
+
 size_t DTree::SplitData(arma::mat& data,
                         const size_t splitDim,
                         const double splitValue,
@@ -265,12 +369,128 @@ size_t DTree::SplitData(arma::mat& data,
   return left;
 }
 
+void DTree::SplitSorted(SortedDimensions& sorted,
+                        const size_t splitIndex) const
+{
+  const size_t points = end - start;
+  const size_t leftPoints = splitIndex - start;
+  const size_t first = start - sorted.offset;
+
+  // The points in the left child are exactly the first leftPoints points in
+  // the sorted order of the split dimension, which is already partitioned.
+  const size_t* splitIds = sorted.ids.colptr(splitDim) + first;
+  for (size_t i = 0; i < points; ++i)
+    sorted.goesLeft[splitIds[i]] = (i < leftPoints);
+
+  // Partition every other dimension while keeping the order on both sides.
+  std::vector<double> rightValues;
+  std::vector<size_t> rightIds;
+  rightValues.reserve(points - leftPoints);
+  rightIds.reserve(points - leftPoints);
+  for (size_t dim = 0; dim < sorted.values.n_cols; ++dim)
+  {
+    if (dim == splitDim)
+      continue;
+
+    double* values = sorted.values.colptr(dim) + first;
+    size_t* ids = sorted.ids.colptr(dim) + first;
+
+    rightValues.clear();
+    rightIds.clear();
+    size_t leftIndex = 0;
+    for (size_t i = 0; i < points; ++i)
+    {
+      if (sorted.goesLeft[ids[i]])
+      {
+        values[leftIndex] = values[i];
+        ids[leftIndex] = ids[i];
+        ++leftIndex;
+      }
+      else
+      {
+        rightValues.push_back(values[i]);
+        rightIds.push_back(ids[i]);
+      }
+    }
+
+    std::copy(rightValues.begin(), rightValues.end(), values + leftPoints);
+    std::copy(rightIds.begin(), rightIds.end(), ids + leftPoints);
+  }
+}
+
 // Greedily expand the tree
 double DTree::Grow(arma::mat& data,
                    arma::Col<size_t>& oldFromNew,
                    const bool useVolReg,
                    const size_t maxLeafSize,
-                   const size_t minLeafSize)
+                   const size_t minLeafSize,
+                   const bool presort,
+                   const size_t maxBins)
+{
+  // Bin each dimension once, if we were asked to.  The points are identified
+  // by their entries in oldFromNew.
+  BinnedDimensions* binned = NULL;
+  if (maxBins > 0)
+  {
+    binned = new BinnedDimensions();
+    binned->bins.Bin(data.cols(start, end - 1), maxBins);
+    binned->rows.resize(arma::max(oldFromNew.subvec(start, end - 1)) + 1);
+    for (size_t i = start; i < end; ++i)
+      binned->rows[oldFromNew[i]] = i - start;
+  }
+
+  // Sort the values of each dimension once, if we were asked to.  The points
+  // are identified by their position at this time.
+  SortedDimensions* sorted = NULL;
+  if (presort && binned == NULL)
+  {
+    sorted = new SortedDimensions();
+    sorted->offset = start;
+    sorted->values.set_size(end - start, data.n_rows);
+    sorted->ids.set_size(end - start, data.n_rows);
+    sorted->goesLeft.resize(end - start);
+    for (size_t dim = 0; dim < data.n_rows; ++dim)
+    {
+      const arma::rowvec dimValues = data.row(dim).subvec(start, end - 1);
+      const arma::uvec order = arma::sort_index(dimValues);
+      for (size_t i = 0; i < order.n_elem; ++i)
+      {
+        sorted->values(i, dim) = data(dim, start + order[i]);
+        sorted->ids(i, dim) = order[i];
+      }
+    }
+  }
+
+  double alpha = 0.0;
+  if (!root)
+  {
+    alpha = GrowNode(data, oldFromNew, useVolReg, maxLeafSize, minLeafSize,
+        sorted, binned);
+  }
+  else
+  {
+    // If OpenMP is available and the dataset is large enough, the subtrees
+    // are grown in parallel.
+    #pragma omp parallel if ((end - start) > parallelGrowThreshold)
+    {
+      #pragma omp single
+      alpha = GrowNode(data, oldFromNew, useVolReg, maxLeafSize, minLeafSize,
+          sorted, binned);
+    }
+  }
+
+  delete sorted;
+  delete binned;
+  return alpha;
+}
+
+double DTree::GrowNode(arma::mat& data,
+                       arma::Col<size_t>& oldFromNew,
+                       const bool useVolReg,
+                       const size_t maxLeafSize,
+                       const size_t minLeafSize,
+                       SortedDimensions* sorted,
+                       const BinnedDimensions* binned)
 {
   Log::Assert(data.n_rows == maxVals.n_elem);
   Log::Assert(data.n_rows == minVals.n_elem);
@@ -293,7 +513,12 @@ double DTree::Grow(arma::mat& data,
     size_t dim;
     double splitValueTmp;
     double leftError, rightError;
-    if (FindSplit(data, dim, splitValueTmp, leftError, rightError, minLeafSize))
+    const bool splitFound = (binned != NULL) ?
+        FindBinnedSplit(data, oldFromNew, *binned, dim, splitValueTmp,
+            leftError, rightError, minLeafSize) :
+        FindSplit(data, dim, splitValueTmp, leftError, rightError, minLeafSize,
+            sorted);
+    if (splitFound)
     {
       // Move the data around for the children to have points in a node lie
       // contiguously (to increase efficiency during the training).
@@ -312,14 +537,24 @@ double DTree::Grow(arma::mat& data,
       splitValue = splitValueTmp;
       splitDim = dim;
 
+      // Give each child its part of the sorted values.
+      if (sorted != NULL)
+        SplitSorted(*sorted, splitIndex);
+
       // Recursively grow the children.
       left = new DTree(maxValsL, minValsL, start, splitIndex, leftError);
       right = new DTree(maxValsR, minValsR, splitIndex, end, rightError);
 
-      leftG = left->Grow(data, oldFromNew, useVolReg, maxLeafSize,
-          minLeafSize);
-      rightG = right->Grow(data, oldFromNew, useVolReg, maxLeafSize,
-          minLeafSize);
+      // The children hold disjoint ranges of the points, so when this is
+      // called inside a parallel region and the left child is large enough, it
+      // is grown as a separate task.  This does not change the resulting tree.
+      #pragma omp task if ((splitIndex - start) > parallelGrowThreshold) \
+          shared(data, oldFromNew, leftG, sorted, binned)
+      leftG = left->GrowNode(data, oldFromNew, useVolReg, maxLeafSize,
+          minLeafSize, sorted, binned);
+      rightG = right->GrowNode(data, oldFromNew, useVolReg, maxLeafSize,
+          minLeafSize, sorted, binned);
+      #pragma omp taskwait
 
       // Store values of R(T~) and |T~|.
       subtreeLeaves = left->SubtreeLeaves() + right->SubtreeLeaves();
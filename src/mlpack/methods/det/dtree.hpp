@@ -9,6 +9,7 @@
 #define __MLPACK_METHODS_DET_DTREE_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/binned_matrix.hpp>
 
 namespace mlpack {
 namespace det /** Density Estimation Trees */ {
@@ -106,19 +107,37 @@ class DTree
 
   /**
    * Greedily expand the tree.  The points in the dataset will be reordered
-   * during tree growth.
+   * during tree growth.  If OpenMP is available and this is the root, large
+   * subtrees are grown in parallel; the resulting tree is the same.
+   *
+   * If presort is true, each dimension is sorted once before growth, and the
+   * sorted values are partitioned down the tree along with the points.  This
+   * takes O(n d) time per level of the tree instead of O(n log n d), at the
+   * cost of O(n d) extra memory; the resulting tree is the same.
+   *
+   * If maxBins is nonzero, each dimension is instead binned once before growth
+   * into at most maxBins bins (see data::BinnedMatrix), and the splits of each
+   * node are searched on histograms of the bins of its points, with no
+   * sorting.  This takes O(n d) time per level of the tree and only n bytes of
+   * extra memory per dimension, but splits are only made on the cut points
+   * between bins, so the tree may differ.  presort is then ignored.
    *
    * @param data Dataset to build tree on.
    * @param oldFromNew Mappings from old points to new points.
    * @param useVolReg If true, volume regularization is used.
    * @param maxLeafSize Maximum size of a leaf.
    * @param minLeafSize Minimum size of a leaf.
+   * @param presort If true, sort each dimension once before growing the tree.
+   * @param maxBins If nonzero, bin each dimension into at most this many bins
+   *     (at most 256) before growing the tree.
    */
   double Grow(arma::mat& data,
               arma::Col<size_t>& oldFromNew,
               const bool useVolReg = false,
               const size_t maxLeafSize = 10,
-              const size_t minLeafSize = 5);
+              const size_t minLeafSize = 5,
+              const bool presort = false,
+              const size_t maxBins = 0);
 
   /**
    * Perform alpha pruning on a tree.  Returns the new value of alpha.
@@ -285,17 +304,66 @@ class DTree
 
  private:
 
+  /**
+   * The values of each dimension of the points, sorted once before growth.
+   * For a node holding points [start, end), rows (start - offset) through
+   * (end - offset - 1) of each column hold the values of that dimension for the
+   * points of the node, in ascending order, and the identifiers of the points
+   * they belong to.
+   */
+  struct SortedDimensions
+  {
+    //! The sorted values; one column per dimension.
+    arma::mat values;
+    //! The identifier of the point each value belongs to.
+    arma::Mat<size_t> ids;
+    //! Scratch space: whether each point goes to the left child of a split.
+    std::vector<char> goesLeft;
+    //! The index of the first point of the node the values were sorted at.
+    size_t offset;
+  };
+
+  /**
+   * The bins of each dimension of the points, computed once before growth.
+   * The points are identified by their entries in oldFromNew, which move with
+   * them as the data is reordered: the bins of the point at index i of the
+   * data are in row rows[oldFromNew[i]] of the binned matrix.
+   */
+  struct BinnedDimensions
+  {
+    //! The bins of the points.
+    data::BinnedMatrix bins;
+    //! The row of the bins of each point, by its entry in oldFromNew.
+    std::vector<size_t> rows;
+  };
+
   // Utility methods.
 
   /**
-   * Find the dimension to split on.
+   * Find the dimension to split on.  If sorted is given, it holds the sorted
+   * values of each dimension, so they are not sorted again.
    */
   bool FindSplit(const arma::mat& data,
                  size_t& splitDim,
                  double& splitValue,
                  double& leftError,
                  double& rightError,
-                 const size_t minLeafSize = 5) const;
+                 const size_t minLeafSize = 5,
+                 const SortedDimensions* sorted = NULL) const;
+
+  /**
+   * Find the dimension to split on, using the cut points between the bins of
+   * each dimension as the possible splits and counting the points of this
+   * node in each bin.
+   */
+  bool FindBinnedSplit(const arma::mat& data,
+                       const arma::Col<size_t>& oldFromNew,
+                       const BinnedDimensions& binned,
+                       size_t& splitDim,
+                       double& splitValue,
+                       double& leftError,
+                       double& rightError,
+                       const size_t minLeafSize = 5) const;
 
   /**
    * Split the data, returning the number of points left of the split.
@@ -305,6 +373,30 @@ class DTree
                    const double splitValue,
                    arma::Col<size_t>& oldFromNew) const;
 
+  /**
+   * Stably partition the sorted values of each dimension of this node between
+   * its children, once the node has been split at splitIndex.
+   */
+  void SplitSorted(SortedDimensions& sorted, const size_t splitIndex) const;
+
+  /**
+   * Grow the subtree rooted at this node; this does the work of Grow().  When
+   * called inside a parallel region, the left child of a large node is grown
+   * as a separate task.  If sorted is not NULL, it holds the presorted values
+   * of the points of this node; if binned is not NULL, it holds the bins of
+   * the points.
+   */
+  double GrowNode(arma::mat& data,
+                  arma::Col<size_t>& oldFromNew,
+                  const bool useVolReg,
+                  const size_t maxLeafSize,
+                  const size_t minLeafSize,
+                  SortedDimensions* sorted,
+                  const BinnedDimensions* binned);
+
+  //! Minimum number of points in a node for its children to be grown in
+  //! parallel.
+  static const size_t parallelGrowThreshold = 10000;
 };
 
 }; // namespace det
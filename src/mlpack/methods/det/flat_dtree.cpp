@@ -0,0 +1,306 @@
+/**
+ * @file flat_dtree.cpp
+ *
+ * Implementation of the flattened density estimation tree.
+ */
+#include "flat_dtree.hpp"
+
+#include <boost/cstdint.hpp>
+#include <cstring>
+#include <stack>
+
+using namespace mlpack;
+using namespace det;
+
+FlatDTree::FlatDTree(const DTree& tree) :
+    maxVals(tree.MaxVals()),
+    minVals(tree.MinVals()),
+    numLeaves(0)
+{
+  // Lay the nodes out in breadth-first order, so that the children of each node
+  // are added next to each other.
+  std::vector<const DTree*> nodes(1, &tree);
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    const DTree* node = nodes[i];
+    if (node->SubtreeLeaves() > 1)
+    {
+      nodes.push_back(node->Left());
+      nodes.push_back(node->Right());
+    }
+  }
+
+  splitDims.zeros(nodes.size());
+  splitValues.zeros(nodes.size());
+  children.zeros(nodes.size());
+  densities.zeros(nodes.size());
+  tags.zeros(nodes.size());
+
+  size_t nextChild = 1;
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    if (nodes[i]->SubtreeLeaves() > 1)
+    {
+      splitDims[i] = nodes[i]->SplitDim();
+      splitValues[i] = nodes[i]->SplitValue();
+      children[i] = nextChild;
+      nextChild += 2;
+    }
+    else
+    {
+      densities[i] = std::exp(std::log(nodes[i]->Ratio()) -
+          nodes[i]->LogVolume());
+    }
+  }
+
+  // Tag the leaves from left to right, like DTree::TagTree().
+  std::stack<size_t> stack;
+  stack.push(0);
+  while (!stack.empty())
+  {
+    const size_t node = stack.top();
+    stack.pop();
+
+    if (children[node] == 0)
+    {
+      tags[node] = numLeaves++;
+    }
+    else
+    {
+      stack.push(children[node] + 1);
+      stack.push(children[node]);
+    }
+  }
+}
+
+/**
+ * The layout of a flattened tree file is:
+ *
+ *  - the 8 characters "MLPACKDT";
+ *  - the version (1), the dimensionality, the number of nodes, and the number
+ *    of leaves, as 64-bit unsigned integers;
+ *  - the maximum and minimum values of the bounding box, the split values, and
+ *    the density estimates, as doubles;
+ *  - the split dimensions, the children, and the leaf tags, as 64-bit unsigned
+ *    integers.
+ *
+ * Every section is stored as it is held in memory (in the native byte order).
+ */
+namespace flat_dtree {
+
+static const char magic[8] = { 'M', 'L', 'P', 'A', 'C', 'K', 'D', 'T' };
+static const boost::uint64_t version = 1;
+
+}; // namespace flat_dtree
+
+bool FlatDTree::Save(const std::string& treeFile) const
+{
+  std::ofstream stream(treeFile.c_str(), std::ios::out | std::ios::binary |
+      std::ios::trunc);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << treeFile << "' to save density "
+        << "estimation tree to." << std::endl;
+    return false;
+  }
+
+  stream.write(flat_dtree::magic, sizeof(flat_dtree::magic));
+  const boost::uint64_t header[4] = { flat_dtree::version, maxVals.n_elem,
+      NumNodes(), numLeaves };
+  stream.write((const char*) header, sizeof(header));
+
+  stream.write((const char*) maxVals.memptr(), maxVals.n_elem * sizeof(double));
+  stream.write((const char*) minVals.memptr(), minVals.n_elem * sizeof(double));
+  stream.write((const char*) splitValues.memptr(),
+      splitValues.n_elem * sizeof(double));
+  stream.write((const char*) densities.memptr(),
+      densities.n_elem * sizeof(double));
+
+  // size_t may not be 64 bits wide.
+  std::vector<boost::uint64_t> buffer(NumNodes());
+  const arma::Col<size_t>* arrays[3] = { &splitDims, &children, &tags };
+  for (size_t a = 0; a < 3; ++a)
+  {
+    std::copy(arrays[a]->begin(), arrays[a]->end(), buffer.begin());
+    stream.write((const char*) &buffer[0],
+        buffer.size() * sizeof(boost::uint64_t));
+  }
+
+  if (!stream.good())
+  {
+    Log::Warn << "Error while writing density estimation tree to '"
+        << treeFile << "'." << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+FlatDTree::FlatDTree(const std::string& treeFile)
+{
+  std::ifstream stream(treeFile.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open density estimation tree file '" << treeFile
+        << "'." << std::endl;
+
+  stream.seekg(0, std::ios::end);
+  const size_t fileSize = (size_t) stream.tellg();
+  stream.seekg(0, std::ios::beg);
+
+  // Check the header.
+  char fileMagic[sizeof(flat_dtree::magic)];
+  boost::uint64_t header[4];
+  stream.read(fileMagic, sizeof(fileMagic));
+  stream.read((char*) header, sizeof(header));
+  if (!stream.good() ||
+      (memcmp(fileMagic, flat_dtree::magic, sizeof(flat_dtree::magic)) != 0))
+  {
+    Log::Fatal << "'" << treeFile << "' is not a density estimation tree file."
+        << std::endl;
+  }
+
+  if (header[0] != flat_dtree::version)
+  {
+    Log::Fatal << "Density estimation tree file '" << treeFile << "' has "
+        << "unknown version " << header[0] << "." << std::endl;
+  }
+
+  const size_t dimensionality = (size_t) header[1];
+  const size_t numNodes = (size_t) header[2];
+  numLeaves = (size_t) header[3];
+
+  // Make sure the file is as long as the header says before allocating
+  // anything, so a corrupt header can't make us allocate huge amounts.
+  const size_t expectedSize = sizeof(flat_dtree::magic) + sizeof(header) +
+      (2 * dimensionality + 2 * numNodes) * sizeof(double) +
+      3 * numNodes * sizeof(boost::uint64_t);
+  if (numNodes == 0 || fileSize != expectedSize)
+  {
+    Log::Fatal << "Density estimation tree file '" << treeFile << "' has size "
+        << fileSize << " but should have size " << expectedSize << "."
+        << std::endl;
+  }
+
+  maxVals.set_size(dimensionality);
+  minVals.set_size(dimensionality);
+  splitValues.set_size(numNodes);
+  densities.set_size(numNodes);
+  stream.read((char*) maxVals.memptr(), maxVals.n_elem * sizeof(double));
+  stream.read((char*) minVals.memptr(), minVals.n_elem * sizeof(double));
+  stream.read((char*) splitValues.memptr(),
+      splitValues.n_elem * sizeof(double));
+  stream.read((char*) densities.memptr(), densities.n_elem * sizeof(double));
+
+  std::vector<boost::uint64_t> buffer(numNodes);
+  arma::Col<size_t>* arrays[3] = { &splitDims, &children, &tags };
+  for (size_t a = 0; a < 3; ++a)
+  {
+    stream.read((char*) &buffer[0], buffer.size() * sizeof(boost::uint64_t));
+    arrays[a]->set_size(numNodes);
+    for (size_t i = 0; i < numNodes; ++i)
+      (*arrays[a])[i] = (size_t) buffer[i];
+  }
+
+  if (!stream.good())
+  {
+    Log::Fatal << "Cannot read density estimation tree file '" << treeFile
+        << "'." << std::endl;
+  }
+
+  // Evaluation trusts the tree, so make sure every query ends up in a leaf:
+  // children must come after their parent, and split dimensions and tags must
+  // be in range.
+  bool valid = true;
+  for (size_t i = 0; i < numNodes && valid; ++i)
+  {
+    if (children[i] == 0)
+      valid = (tags[i] < numLeaves);
+    else
+      valid = (children[i] > i) && (children[i] + 1 < numNodes) &&
+          (splitDims[i] < dimensionality);
+  }
+
+  if (!valid)
+    Log::Fatal << "Density estimation tree file '" << treeFile << "' is "
+        << "corrupt." << std::endl;
+
+  Log::Info << "Loaded density estimation tree with " << numNodes << " nodes "
+      << "and " << numLeaves << " leaves from '" << treeFile << "'."
+      << std::endl;
+}
+
+inline size_t FlatDTree::FindLeaf(const double* query) const
+{
+  const size_t* nodeChildren = children.memptr();
+  const size_t* nodeSplitDims = splitDims.memptr();
+  const double* nodeSplitValues = splitValues.memptr();
+
+  // Go to the right child if the query is greater than the split value.
+  size_t node = 0;
+  while (nodeChildren[node] != 0)
+    node = nodeChildren[node] +
+        (query[nodeSplitDims[node]] > nodeSplitValues[node]);
+
+  return node;
+}
+
+inline bool FlatDTree::WithinRange(const double* query) const
+{
+  for (size_t i = 0; i < maxVals.n_elem; ++i)
+    if ((query[i] < minVals[i]) || (query[i] > maxVals[i]))
+      return false;
+
+  return true;
+}
+
+double FlatDTree::ComputeValue(const arma::vec& query) const
+{
+  Log::Assert(query.n_elem == maxVals.n_elem);
+
+  if (!WithinRange(query.memptr()))
+    return 0.0;
+
+  return densities[FindLeaf(query.memptr())];
+}
+
+void FlatDTree::ComputeValues(const arma::mat& queries, arma::vec& values) const
+{
+  Log::Assert(queries.n_rows == maxVals.n_elem);
+
+  values.set_size(queries.n_cols);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    const double* query = queries.colptr(i);
+    values[i] = WithinRange(query) ? densities[FindLeaf(query)] : 0.0;
+  }
+}
+
+size_t FlatDTree::FindBucket(const arma::vec& query) const
+{
+  Log::Assert(query.n_elem == maxVals.n_elem);
+
+  return tags[FindLeaf(query.memptr())];
+}
+
+void FlatDTree::FindBuckets(const arma::mat& queries,
+                            arma::Col<size_t>& buckets) const
+{
+  Log::Assert(queries.n_rows == maxVals.n_elem);
+
+  buckets.set_size(queries.n_cols);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < queries.n_cols; ++i)
+    buckets[i] = tags[FindLeaf(queries.colptr(i))];
+}
+
+// Return string of object.
+std::string FlatDTree::ToString() const
+{
+  std::ostringstream convert;
+  convert << "Flat Density Estimation Tree [" << this << "]" << std::endl;
+  convert << "  Dimensionality: " << maxVals.n_elem << std::endl;
+  convert << "  Nodes: " << NumNodes() << std::endl;
+  convert << "  Leaves: " << numLeaves << std::endl;
+  return convert.str();
+}
@@ -0,0 +1,141 @@
+/**
+ * @file flat_dtree.hpp
+ *
+ * A flattened, read-only form of a density estimation tree, for fast density
+ * estimates of many query points.
+ */
+#ifndef __MLPACK_METHODS_DET_FLAT_DTREE_HPP
+#define __MLPACK_METHODS_DET_FLAT_DTREE_HPP
+
+#include <mlpack/core.hpp>
+
+#include "dtree.hpp"
+
+namespace mlpack {
+namespace det {
+
+/**
+ * A density estimation tree stored as flat arrays of nodes, instead of as
+ * linked DTree objects.  This can't be grown or pruned, but it gives the same
+ * density estimates and leaf tags as the DTree it was built from, it can
+ * evaluate a whole matrix of query points at once (in parallel, if OpenMP is
+ * available), and it can be saved to and loaded from a binary file.
+ *
+ * The nodes are stored in breadth-first order, so the two children of each
+ * node are next to each other: a query moves from node i to node
+ * children[i] + (query[splitDims[i]] > splitValues[i]), without branching on
+ * the direction.  Leaves have no children, which is marked with 0 (the root
+ * is never a child).
+ *
+ * @code
+ * DTree* dtree = Trainer(data, 10);
+ * FlatDTree flatTree(*dtree);
+ *
+ * arma::vec densities;
+ * flatTree.ComputeValues(queries, densities);
+ * flatTree.Save("det.bin");
+ * @endcode
+ */
+class FlatDTree
+{
+ public:
+  /**
+   * Flatten the given density estimation tree.  The tree may be deleted
+   * afterwards.  The leaves are tagged from left to right, as DTree::TagTree()
+   * does.
+   *
+   * @param tree Tree to flatten.
+   */
+  FlatDTree(const DTree& tree);
+
+  /**
+   * Load a flattened tree from the given file (see Save()).  Log::Fatal is
+   * used if the file cannot be read or is not a valid tree file.
+   *
+   * @param treeFile Name of the file to load.
+   */
+  FlatDTree(const std::string& treeFile);
+
+  /**
+   * Save the flattened tree to a binary file, so that it can be loaded later.
+   *
+   * @param treeFile Name of the file to write.
+   * @return false if the file could not be written.
+   */
+  bool Save(const std::string& treeFile) const;
+
+  /**
+   * Compute the density estimate of a given query point.  This is the same as
+   * DTree::ComputeValue().
+   *
+   * @param query Point to estimate density of.
+   */
+  double ComputeValue(const arma::vec& query) const;
+
+  /**
+   * Compute the density estimate of each of the given query points.
+   *
+   * @param queries Points to estimate the density of, one per column.
+   * @param values Vector to store the density estimates in.
+   */
+  void ComputeValues(const arma::mat& queries, arma::vec& values) const;
+
+  /**
+   * Return the tag of the leaf containing the query.  This is the same as
+   * DTree::FindBucket() after DTree::TagTree() has been called.
+   *
+   * @param query Query to search for.
+   */
+  size_t FindBucket(const arma::vec& query) const;
+
+  /**
+   * Find the tag of the leaf containing each of the given query points.
+   *
+   * @param queries Queries to search for, one per column.
+   * @param buckets Vector to store the leaf tags in.
+   */
+  void FindBuckets(const arma::mat& queries, arma::Col<size_t>& buckets) const;
+
+  //! Return the dimensionality of the tree.
+  size_t Dimensionality() const { return maxVals.n_elem; }
+  //! Return the number of nodes in the tree.
+  size_t NumNodes() const { return splitDims.n_elem; }
+  //! Return the number of leaves in the tree.
+  size_t NumLeaves() const { return numLeaves; }
+
+  /**
+   * Returns a string representation of this object.
+   */
+  std::string ToString() const;
+
+ private:
+  //! Upper half of the bounding box of the root.
+  arma::vec maxVals;
+  //! Lower half of the bounding box of the root.
+  arma::vec minVals;
+
+  //! The splitting dimension of each node.
+  arma::Col<size_t> splitDims;
+  //! The split value of each node.
+  arma::vec splitValues;
+  //! The index of the left child of each node (the right child follows it), or
+  //! 0 for leaves.
+  arma::Col<size_t> children;
+  //! The density estimate of each leaf.
+  arma::vec densities;
+  //! The tag of each leaf.
+  arma::Col<size_t> tags;
+  //! The number of leaves.
+  size_t numLeaves;
+
+  //! Return the index of the leaf containing the query.
+  size_t FindLeaf(const double* query) const;
+
+  //! Return whether the query is within the bounding box of the root.
+  bool WithinRange(const double* query) const;
+};
+
+}; // namespace det
+}; // namespace mlpack
+
+#endif // __MLPACK_METHODS_DET_FLAT_DTREE_HPP
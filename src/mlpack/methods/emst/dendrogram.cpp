@@ -0,0 +1,138 @@
+/**
+ * @file dendrogram.cpp
+ *
+ * Implementation of the single-linkage dendrogram.
+ */
+#include "dendrogram.hpp"
+
+using namespace mlpack;
+using namespace mlpack::emst;
+
+Dendrogram::Dendrogram(const arma::mat& mst, const size_t numPoints) :
+    numPoints(numPoints)
+{
+  if (numPoints == 0 || mst.n_rows != 3 || mst.n_cols != numPoints - 1)
+  {
+    Log::Fatal << "Dendrogram::Dendrogram(): expected a 3x" << numPoints - 1
+        << " edge matrix, but got " << mst.n_rows << "x" << mst.n_cols << "!"
+        << std::endl;
+  }
+
+  // Merges happen in order of increasing edge length; the sort is stable so
+  // that equal-length edges keep their order.
+  const arma::uvec order = arma::stable_sort_index(mst.row(2).t());
+
+  merges.set_size(4, numPoints - 1);
+  mergeEdges.set_size(2, numPoints - 1);
+
+  // The cluster each component root currently belongs to, and its size.
+  UnionFind connections(numPoints);
+  arma::Col<size_t> cluster(numPoints);
+  arma::Col<size_t> clusterSize(numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    cluster[i] = i;
+    clusterSize[i] = 1;
+  }
+
+  for (size_t i = 0; i < order.n_elem; ++i)
+  {
+    const size_t lesser = (size_t) mst(0, order[i]);
+    const size_t greater = (size_t) mst(1, order[i]);
+
+    const size_t lesserRoot = connections.Find(lesser);
+    const size_t greaterRoot = connections.Find(greater);
+    if (lesserRoot == greaterRoot)
+    {
+      Log::Fatal << "Dendrogram::Dendrogram(): edge (" << lesser << ", "
+          << greater << ") makes a cycle; the edges are not a spanning tree!"
+          << std::endl;
+    }
+
+    merges(0, i) = std::min(cluster[lesserRoot], cluster[greaterRoot]);
+    merges(1, i) = std::max(cluster[lesserRoot], cluster[greaterRoot]);
+    merges(2, i) = mst(2, order[i]);
+    merges(3, i) = clusterSize[lesserRoot] + clusterSize[greaterRoot];
+    mergeEdges(0, i) = lesser;
+    mergeEdges(1, i) = greater;
+
+    connections.Union(lesserRoot, greaterRoot);
+    const size_t root = connections.Find(lesserRoot);
+    cluster[root] = numPoints + i;
+    clusterSize[root] = (size_t) merges(3, i);
+  }
+}
+
+size_t Dendrogram::Cut(const double height,
+                       arma::Col<size_t>& labels,
+                       const size_t minClusterSize) const
+{
+  // The merges are sorted by height, so everything up to the first merge above
+  // the cut is used.
+  size_t numMerges = 0;
+  while (numMerges < merges.n_cols && merges(2, numMerges) <= height)
+    ++numMerges;
+
+  return Label(numMerges, labels, minClusterSize);
+}
+
+size_t Dendrogram::CutClusters(const size_t numClusters,
+                               arma::Col<size_t>& labels,
+                               const size_t minClusterSize) const
+{
+  if (numClusters == 0 || numClusters > numPoints)
+  {
+    Log::Fatal << "Dendrogram::CutClusters(): number of clusters ("
+        << numClusters << ") must be between 1 and the number of points ("
+        << numPoints << ")!" << std::endl;
+  }
+
+  return Label(numPoints - numClusters, labels, minClusterSize);
+}
+
+size_t Dendrogram::Label(const size_t numMerges,
+                         arma::Col<size_t>& labels,
+                         const size_t minClusterSize) const
+{
+  UnionFind connections(numPoints);
+  for (size_t i = 0; i < numMerges; ++i)
+    connections.Union(mergeEdges(0, i), mergeEdges(1, i));
+
+  // Count the points in each component.
+  arma::Col<size_t> componentSize(numPoints);
+  componentSize.zeros();
+  for (size_t i = 0; i < numPoints; ++i)
+    ++componentSize[connections.Find(i)];
+
+  // Number the large enough components in order of their lowest point.
+  arma::Col<size_t> componentLabel(numPoints);
+  componentLabel.fill(numPoints);
+  size_t numClusters = 0;
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    const size_t root = connections.Find(i);
+    if (componentSize[root] >= minClusterSize &&
+        componentLabel[root] == numPoints)
+      componentLabel[root] = numClusters++;
+  }
+
+  // Everything else is noise.
+  labels.set_size(numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    const size_t root = connections.Find(i);
+    labels[i] = (componentLabel[root] == numPoints) ? numClusters :
+        componentLabel[root];
+  }
+
+  return numClusters;
+}
+
+std::string Dendrogram::ToString() const
+{
+  std::ostringstream convert;
+  convert << "Dendrogram [" << this << "]" << std::endl;
+  convert << "  Points: " << numPoints << std::endl;
+  convert << "  Merges: " << merges.n_cols << std::endl;
+  return convert.str();
+}
@@ -0,0 +1,116 @@
+/**
+ * @file dendrogram.hpp
+ *
+ * Single-linkage dendrogram built from a Euclidean minimum spanning tree.
+ */
+#ifndef __MLPACK_METHODS_EMST_DENDROGRAM_HPP
+#define __MLPACK_METHODS_EMST_DENDROGRAM_HPP
+
+#include <mlpack/core.hpp>
+
+#include "union_find.hpp"
+
+namespace mlpack {
+namespace emst {
+
+/**
+ * The single-linkage hierarchical clustering of a dataset, built from its
+ * minimum spanning tree.  Adding the MST edges in order of increasing length
+ * to a UnionFind structure merges clusters in exactly the order single linkage
+ * does, so the dendrogram takes only O(N log N) time once the MST is known.
+ *
+ * The merges are stored in a 4 x (N - 1) matrix, in the same layout that most
+ * hierarchical clustering tools use.  Clusters 0 to N - 1 are the individual
+ * points, and merge i creates cluster N + i.  Column i holds the two clusters
+ * that are merged (lesser index first), the height (distance) of the merge,
+ * and the number of points in the new cluster.
+ *
+ * @code
+ * extern arma::mat data;
+ * DualTreeBoruvka<> dtb(data);
+ *
+ * arma::mat mst;
+ * dtb.ComputeMST(mst);
+ *
+ * Dendrogram dendrogram(mst, data.n_cols);
+ * arma::Col<size_t> labels;
+ * const size_t clusters = dendrogram.Cut(0.5, labels);
+ * @endcode
+ */
+class Dendrogram
+{
+ public:
+  /**
+   * Build the dendrogram from the edges of a minimum spanning tree, in the
+   * format returned by DualTreeBoruvka::ComputeMST() (a 3 x (N - 1) matrix of
+   * lesser index, greater index, and distance).  The edges do not need to be
+   * sorted.
+   *
+   * @param mst Edges of the minimum spanning tree.
+   * @param numPoints Number of points in the dataset.
+   */
+  Dendrogram(const arma::mat& mst, const size_t numPoints);
+
+  /**
+   * Label the points by cutting the dendrogram at the given height: two points
+   * are in the same cluster if they are joined by merges no higher than the
+   * height.  Clusters are numbered in order of their lowest point index.
+   * Points in clusters with fewer than minClusterSize points are considered
+   * noise, and are given the label equal to the number of clusters returned.
+   *
+   * This takes O(N) time, so many cuts can be extracted cheaply.
+   *
+   * @param height Height at which to cut the dendrogram.
+   * @param labels Vector to store the cluster label of each point in.
+   * @param minClusterSize Minimum number of points in a cluster.
+   * @return Number of clusters with at least minClusterSize points.
+   */
+  size_t Cut(const double height,
+             arma::Col<size_t>& labels,
+             const size_t minClusterSize = 1) const;
+
+  /**
+   * Label the points by cutting the dendrogram so that it has the given number
+   * of clusters, before small clusters are removed.  Points in clusters with
+   * fewer than minClusterSize points are labeled as noise, as in Cut().
+   *
+   * @param numClusters Number of clusters to cut the dendrogram into.
+   * @param labels Vector to store the cluster label of each point in.
+   * @param minClusterSize Minimum number of points in a cluster.
+   * @return Number of clusters with at least minClusterSize points.
+   */
+  size_t CutClusters(const size_t numClusters,
+                     arma::Col<size_t>& labels,
+                     const size_t minClusterSize = 1) const;
+
+  //! Get the merges (a 4 x (N - 1) matrix).
+  const arma::mat& Merges() const { return merges; }
+
+  //! Get the number of points in the dataset.
+  size_t NumPoints() const { return numPoints; }
+
+  /**
+   * Returns a string representation of this object.
+   */
+  std::string ToString() const;
+
+ private:
+  //! Label the points using the first numMerges merges.
+  size_t Label(const size_t numMerges,
+               arma::Col<size_t>& labels,
+               const size_t minClusterSize) const;
+
+  //! The number of points in the dataset.
+  size_t numPoints;
+
+  //! The merges, as described in the class documentation.
+  arma::mat merges;
+
+  //! The MST edge that caused each merge, as (lesser, greater) point indices.
+  arma::Mat<size_t> mergeEdges;
+};
+
+}; // namespace emst
+}; // namespace mlpack
+
+#endif
@@ -22,11 +22,13 @@
 
 #include "dtb_stat.hpp"
 #include "edge_pair.hpp"
+#include "dendrogram.hpp"
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 namespace mlpack {
 namespace emst /** Euclidean Minimum Spanning Trees. */ {
@@ -89,6 +91,9 @@ class DualTreeBoruvka
   //! Indicates whether or not O(n^2) naive mode will be used.
   bool naive;
 
+  //! The relative error allowed in the edges found by the traversals.
+  double epsilon;
+
   //! Edges.
   std::vector<EdgePair> edges; // We must use vector with non-numerical types.
 
@@ -110,6 +115,9 @@ class DualTreeBoruvka
   //! The instantiated metric.
   MetricType metric;
 
+  //! The traversal statistics of tree building and all computations.
+  tree::TraversalStatistics statistics;
+
   //! For sorting the edge list after the computation.
   struct SortEdgesHelper
   {
@@ -165,16 +173,54 @@ class DualTreeBoruvka
    * index of the edge; the second row will contain the greater index of the
    * edge; and the third row will contain the distance between the two edges.
    *
+   * If OpenMP is available, the traversal in each round is split across
+   * threads by query subtree.
+   *
    * @param results Matrix which results will be stored in.
    */
   void ComputeMST(arma::mat& results);
 
+  /**
+   * Compute the MST, as above, and also the single-linkage dendrogram of the
+   * dataset, in the format described in the Dendrogram class (a 4 x (N - 1)
+   * matrix of merged clusters, merge heights, and cluster sizes).  Points are
+   * indexed in the same way as in the results.  To extract flat clusterings,
+   * construct a Dendrogram from the results instead.
+   *
+   * @param results Matrix which results will be stored in.
+   * @param dendrogram Matrix which the merges will be stored in.
+   */
+  void ComputeMST(arma::mat& results, arma::mat& dendrogram);
+
+  //! Get the relative error allowed in the edges found by the traversals.
+  double Epsilon() const { return epsilon; }
+  //! Modify the relative error allowed in the edges found by the traversals.
+  //! With epsilon > 0, nodes are pruned unless they could shorten the
+  //! candidate edge of a component by more than a factor of (1 + epsilon), so
+  //! each edge added is within a factor of (1 + epsilon) of the shortest edge
+  //! out of its component, and the total length of the tree is within a
+  //! factor of (1 + epsilon) of that of the MST.  The largest error the
+  //! prunes may have caused is given by Statistics().MaxRelativeError().  This
+  //! is 0 (exact MST) by default, and must not be negative.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the traversal statistics of tree building and all computations.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of tree building and all computations.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
   /**
    * Returns a string representation of this object.
    */
   std::string ToString() const;
 
  private:
+  /**
+   * Collect disjoint subtrees of the query tree (the whole tree, with one
+   * thread) to be traversed in parallel.
+   */
+  void SplitQueryTree(std::vector<TreeType*>& queryNodes);
+
   /**
    * Adds a single edge to the edge list
    */
@@ -9,6 +9,10 @@
 
 #include "dtb_rules.hpp"
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace emst {
 
@@ -48,11 +52,13 @@ DualTreeBoruvka<MetricType, TreeType>::DualTreeBoruvka(
     data((tree::TreeTraits<TreeType>::RearrangesDataset && !naive) ? dataCopy : dataset),
     ownTree(!naive),
     naive(naive),
+    epsilon(0.0),
     connections(dataset.n_cols),
     totalDist(0.0),
     metric(metric)
 {
   Timer::Start("emst/tree_building");
+  statistics.StartPhase("tree_building");
 
   if (!naive)
   {
@@ -64,6 +70,7 @@ DualTreeBoruvka<MetricType, TreeType>::DualTreeBoruvka(
         oldFromNew);
   }
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("emst/tree_building");
 
   edges.reserve(data.n_cols - 1); // Set size.
@@ -83,6 +90,7 @@ DualTreeBoruvka<MetricType, TreeType>::DualTreeBoruvka(
     tree(tree),
     ownTree(false),
     naive(false),
+    epsilon(0.0),
     connections(data.n_cols),
     totalDist(0.0),
     metric(metric)
@@ -109,26 +117,81 @@ DualTreeBoruvka<MetricType, TreeType>::~DualTreeBoruvka()
 template<typename MetricType, typename TreeType>
 void DualTreeBoruvka<MetricType, TreeType>::ComputeMST(arma::mat& results)
 {
+  if (epsilon < 0)
+  {
+    Log::Fatal << "DualTreeBoruvka::ComputeMST(): epsilon must be "
+        << "non-negative (" << epsilon << " given)." << std::endl;
+  }
+
   Timer::Start("emst/mst_computation");
+  statistics.StartPhase("traversal");
 
   totalDist = 0; // Reset distance.
 
+  // Split the query tree into subtrees that the threads traverse separately.
+  std::vector<TreeType*> queryNodes;
+  if (!naive)
+    SplitQueryTree(queryNodes);
+
+  // Components cannot change during a traversal, so Find() is read-only as
+  // long as the union-find structure is flat.
+  connections.Flatten();
+
   typedef DTBRules<MetricType, TreeType> RuleType;
-  RuleType rules(data, connections, neighborsDistances, neighborsInComponent,
-                 neighborsOutComponent, metric);
+  tree::TraversalStatistics traversalStatistics;
   while (edges.size() < (data.n_cols - 1))
   {
-    if (naive)
-    {
-      // Full O(N^2) traversal.
-      for (size_t i = 0; i < data.n_cols; ++i)
-        for (size_t j = 0; j < data.n_cols; ++j)
-          rules.BaseCase(i, j);
-    }
-    else
+    #pragma omp parallel
     {
-      typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
-      traverser.Traverse(*tree, *tree);
+      // Each thread collects candidate edges into its own arrays, which are
+      // reduced into the member arrays at the end of the round.
+      arma::vec threadDistances(data.n_cols);
+      threadDistances.fill(DBL_MAX);
+      arma::Col<size_t> threadInComponent(data.n_cols);
+      arma::Col<size_t> threadOutComponent(data.n_cols);
+
+      RuleType rules(data, connections, threadDistances, threadInComponent,
+                     threadOutComponent, metric, epsilon);
+
+      if (naive)
+      {
+        // Full O(N^2) traversal.
+        #pragma omp for schedule(dynamic, 16)
+        for (size_t i = 0; i < data.n_cols; ++i)
+          for (size_t j = 0; j < data.n_cols; ++j)
+            rules.BaseCase(i, j);
+      }
+      else
+      {
+        typename TreeType::template DualTreeTraverser<RuleType>
+            traverser(rules);
+
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t i = 0; i < queryNodes.size(); ++i)
+          traverser.Traverse(*queryNodes[i], *tree);
+      }
+
+      #pragma omp critical
+      {
+        // Ties are broken by point index, so that the result does not depend
+        // on the order in which the threads are merged.
+        for (size_t i = 0; i < data.n_cols; ++i)
+        {
+          if ((threadDistances[i] < neighborsDistances[i]) ||
+              ((threadDistances[i] == neighborsDistances[i]) &&
+               (threadDistances[i] != DBL_MAX) &&
+               ((threadInComponent[i] < neighborsInComponent[i]) ||
+                ((threadInComponent[i] == neighborsInComponent[i]) &&
+                 (threadOutComponent[i] < neighborsOutComponent[i])))))
+          {
+            neighborsDistances[i] = threadDistances[i];
+            neighborsInComponent[i] = threadInComponent[i];
+            neighborsOutComponent[i] = threadOutComponent[i];
+          }
+        }
+
+        traversalStatistics += rules.Statistics();
+      }
     }
 
     AddAllEdges();
@@ -138,12 +201,22 @@ void DualTreeBoruvka<MetricType, TreeType>::ComputeMST(arma::mat& results)
     Log::Info << edges.size() << " edges found so far." << std::endl;
     if (!naive)
     {
-      Log::Info << rules.BaseCases() << " cumulative base cases." << std::endl;
-      Log::Info << rules.Scores() << " cumulative node combinations scored."
+      Log::Info << traversalStatistics.BaseCases() << " cumulative base cases."
           << std::endl;
+      Log::Info << traversalStatistics.Scores() << " cumulative node "
+          << "combinations scored." << std::endl;
     }
   }
 
+  if (!naive && epsilon > 0)
+  {
+    Log::Info << traversalStatistics.ApproximatePrunes() << " approximate "
+        << "prunes; edges are within a relative error of "
+        << traversalStatistics.MaxRelativeError() << "." << std::endl;
+  }
+  statistics += traversalStatistics;
+
+  statistics.StopPhase("traversal");
   Timer::Stop("emst/mst_computation");
 
   EmitResults(results);
@@ -151,6 +224,64 @@ void DualTreeBoruvka<MetricType, TreeType>::ComputeMST(arma::mat& results)
   Log::Info << "Total spanning tree length: " << totalDist << std::endl;
 }
 
+/**
+ * Compute the MST, then the single-linkage dendrogram from its edges.
+ */
+template<typename MetricType, typename TreeType>
+void DualTreeBoruvka<MetricType, TreeType>::ComputeMST(arma::mat& results,
+                                                       arma::mat& dendrogram)
+{
+  ComputeMST(results);
+
+  dendrogram = Dendrogram(results, data.n_cols).Merges();
+}
+
+/**
+ * Collect disjoint subtrees of the query tree that together hold every point,
+ * so that each can be traversed by a different thread.
+ */
+template<typename MetricType, typename TreeType>
+void DualTreeBoruvka<MetricType, TreeType>::SplitQueryTree(
+    std::vector<TreeType*>& queryNodes)
+{
+  size_t numThreads = 1;
+#ifdef HAS_OPENMP
+  numThreads = (size_t) omp_get_max_threads();
+#endif
+
+  // A few subtrees per thread keep the load balanced.  With one thread the
+  // whole tree is traversed at once, as before.
+  const size_t minNodes = (numThreads == 1) ? 1 : 8 * numThreads;
+
+  queryNodes.clear();
+  queryNodes.push_back(tree);
+
+  // Split one level at a time.  Only nodes that hold no points of their own
+  // are split, so that no query point is lost or visited twice.
+  bool split = true;
+  while (split && queryNodes.size() < minNodes)
+  {
+    split = false;
+    std::vector<TreeType*> nextNodes;
+    for (size_t i = 0; i < queryNodes.size(); ++i)
+    {
+      TreeType* node = queryNodes[i];
+      if (node->NumChildren() > 0 && node->NumPoints() == 0)
+      {
+        for (size_t j = 0; j < node->NumChildren(); ++j)
+          nextNodes.push_back(&node->Child(j));
+        split = true;
+      }
+      else
+      {
+        nextNodes.push_back(node);
+      }
+    }
+
+    queryNodes.swap(nextNodes);
+  }
+}
+
 /**
  * Adds a single edge to the edge list
  */
@@ -286,6 +417,9 @@ void DualTreeBoruvka<MetricType, TreeType>::Cleanup()
 
   if (!naive)
     CleanupHelper(tree);
+
+  // Make Find() read-only for the next round.
+  connections.Flatten();
 }
 
 // convert the object to a string
@@ -297,6 +431,7 @@ std::string DualTreeBoruvka<MetricType, TreeType>::ToString() const
   convert << "  Data: " << data.n_rows << "x" << data.n_cols <<std::endl;
   convert << "  Total Distance: " << totalDist <<std::endl;
   convert << "  Naive: " << naive << std::endl;
+  convert << "  Epsilon: " << epsilon << std::endl;
   convert << "  Metric: " << std::endl;
   convert << util::Indent(metric.ToString(), 2);
   convert << std::endl;
@@ -8,6 +8,8 @@
 #define __MLPACK_METHODS_EMST_DTB_RULES_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/leaf_block_distances.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 #include "../neighbor_search/ns_traversal_info.hpp"
 
@@ -18,15 +20,38 @@ template<typename MetricType, typename TreeType>
 class DTBRules
 {
  public:
+  /**
+   * Construct the rules.  With epsilon > 0, Score() also prunes nodes that
+   * cannot shorten the candidate edge of a component by more than a factor of
+   * (1 + epsilon), and counts those prunes in the statistics (see
+   * tree::TraversalStatistics::MaxRelativeError()).  Rescore() only prunes
+   * exactly, so that every approximate prune is counted.
+   */
   DTBRules(const arma::mat& dataSet,
            UnionFind& connections,
            arma::vec& neighborsDistances,
            arma::Col<size_t>& neighborsInComponent,
            arma::Col<size_t>& neighborsOutComponent,
-           MetricType& metric);
+           MetricType& metric,
+           const double epsilon = 0.0);
 
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Compute the base cases between the given points of the query leaf (those
+   * that Score() did not prune) and every point in the reference leaf at once,
+   * if the metric allows it (see metric::BlockDistances()).  If it does not,
+   * nothing is done and false is returned.
+   *
+   * @param queryNode Query leaf.
+   * @param queryPoints Offsets in the query leaf of the points to compute.
+   * @param referenceNode Reference leaf.
+   * @return true if the base cases were computed.
+   */
+  bool BaseCases(TreeType& queryNode,
+                 const std::vector<size_t>& queryPoints,
+                 TreeType& referenceNode);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -111,14 +136,22 @@ class DTBRules
   TraversalInfoType& TraversalInfo() { return traversalInfo; }
 
   //! Get the number of base cases performed.
-  size_t BaseCases() const { return baseCases; }
+  size_t BaseCases() const { return statistics.BaseCases(); }
   //! Modify the number of base cases performed.
-  size_t& BaseCases() { return baseCases; }
+  size_t& BaseCases() { return statistics.BaseCases(); }
 
   //! Get the number of node combinations that have been scored.
-  size_t Scores() const { return scores; }
+  size_t Scores() const { return statistics.Scores(); }
   //! Modify the number of node combinations that have been scored.
-  size_t& Scores() { return scores; }
+  size_t& Scores() { return statistics.Scores(); }
+
+  //! Get the relative error allowed when pruning.
+  double Epsilon() const { return epsilon; }
+
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
 
  private:
   //! The data points.
@@ -141,17 +174,26 @@ class DTBRules
   //! The instantiated metric.
   MetricType& metric;
 
+  //! The relative error allowed when pruning.
+  double epsilon;
+
   /**
    * Update the bound for the given query node.
    */
   inline double CalculateBound(TreeType& queryNode) const;
 
+  /**
+   * Return the score for a node whose points are at least the given distance
+   * away, given the bound on the length of the candidate edges it would need
+   * to beat: DBL_MAX if it is pruned (exactly, or because of epsilon), and the
+   * distance otherwise.
+   */
+  inline double PruneScore(const double distance, const double bound);
+
   TraversalInfoType traversalInfo;
 
-  //! The number of base cases calculated.
-  size_t baseCases;
-  //! The number of node combinations that have been scored.
-  size_t scores;
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
 
 }; // class DTBRules
 
@@ -17,7 +17,8 @@ DTBRules(const arma::mat& dataSet,
          arma::vec& neighborsDistances,
          arma::Col<size_t>& neighborsInComponent,
          arma::Col<size_t>& neighborsOutComponent,
-         MetricType& metric)
+         MetricType& metric,
+         const double epsilon)
 :
   dataSet(dataSet),
   connections(connections),
@@ -25,8 +26,7 @@ DTBRules(const arma::mat& dataSet,
   neighborsInComponent(neighborsInComponent),
   neighborsOutComponent(neighborsOutComponent),
   metric(metric),
-  baseCases(0),
-  scores(0)
+  epsilon(epsilon)
 {
   // Nothing else to do.
 }
@@ -48,7 +48,7 @@ double DTBRules<MetricType, TreeType>::BaseCase(const size_t queryIndex,
 
   if (queryComponentIndex != referenceComponentIndex)
   {
-    ++baseCases;
+    ++statistics.BaseCases();
     double distance = metric.Evaluate(dataSet.col(queryIndex),
                                       dataSet.col(referenceIndex));
 
@@ -70,6 +70,51 @@ double DTBRules<MetricType, TreeType>::BaseCase(const size_t queryIndex,
   return newUpperBound;
 }
 
+template<typename MetricType, typename TreeType>
+bool DTBRules<MetricType, TreeType>::BaseCases(
+    TreeType& queryNode,
+    const std::vector<size_t>& queryPoints,
+    TreeType& referenceNode)
+{
+  if (queryPoints.empty() || referenceNode.NumPoints() == 0)
+    return false;
+
+  // blockDistances(i, k) is the distance between the i'th reference point and
+  // the query point queryPoints[k].
+  arma::mat blockDistances;
+  if (!tree::LeafBlockDistances(metric, dataSet, referenceNode, dataSet,
+      queryNode, queryPoints, blockDistances))
+    return false;
+
+  // Find the components of the reference points only once.
+  std::vector<size_t> referenceComponents(referenceNode.NumPoints());
+  for (size_t i = 0; i < referenceNode.NumPoints(); ++i)
+    referenceComponents[i] = connections.Find(referenceNode.Point(i));
+
+  for (size_t k = 0; k < queryPoints.size(); ++k)
+  {
+    const size_t queryIndex = queryNode.Point(queryPoints[k]);
+    const size_t queryComponentIndex = connections.Find(queryIndex);
+
+    for (size_t i = 0; i < referenceNode.NumPoints(); ++i)
+    {
+      // Only points in other components can be a new edge.
+      if (referenceComponents[i] == queryComponentIndex)
+        continue;
+
+      ++statistics.BaseCases();
+      if (blockDistances(i, k) < neighborsDistances[queryComponentIndex])
+      {
+        neighborsDistances[queryComponentIndex] = blockDistances(i, k);
+        neighborsInComponent[queryComponentIndex] = queryIndex;
+        neighborsOutComponent[queryComponentIndex] = referenceNode.Point(i);
+      }
+    }
+  }
+
+  return true;
+}
+
 template<typename MetricType, typename TreeType>
 double DTBRules<MetricType, TreeType>::Score(const size_t queryIndex,
                                              TreeType& referenceNode)
@@ -81,15 +126,15 @@ double DTBRules<MetricType, TreeType>::Score(const size_t queryIndex,
   // signed values.
   if (queryComponentIndex ==
       (size_t) referenceNode.Stat().ComponentMembership())
-    return DBL_MAX;
+    return statistics.Score(DBL_MAX, referenceNode);
 
   const arma::vec queryPoint = dataSet.unsafe_col(queryIndex);
   const double distance = referenceNode.MinDistance(queryPoint);
 
   // If all the points in the reference node are farther than the candidate
   // nearest neighbor for the query's component, we prune.
-  return neighborsDistances[queryComponentIndex] < distance
-      ? DBL_MAX : distance;
+  return statistics.Score(PruneScore(distance,
+      neighborsDistances[queryComponentIndex]), referenceNode);
 }
 
 template<typename MetricType, typename TreeType>
@@ -105,7 +150,7 @@ double DTBRules<MetricType, TreeType>::Score(const size_t queryIndex,
   // If the query belongs to the same component as all of the references,
   // then prune.
   if (queryComponentIndex == referenceNode.Stat().ComponentMembership())
-    return DBL_MAX;
+    return statistics.Score(DBL_MAX, referenceNode);
 
   const arma::vec queryPoint = dataSet.unsafe_col(queryIndex);
   const double distance = referenceNode.MinDistance(queryPoint,
@@ -113,8 +158,8 @@ double DTBRules<MetricType, TreeType>::Score(const size_t queryIndex,
 
   // If all the points in the reference node are farther than the candidate
   // nearest neighbor for the query's component, we prune.
-  return (neighborsDistances[queryComponentIndex] < distance) ? DBL_MAX :
-      distance;
+  return statistics.Score(PruneScore(distance,
+      neighborsDistances[queryComponentIndex]), referenceNode);
 }
 
 template<typename MetricType, typename TreeType>
@@ -137,15 +182,15 @@ double DTBRules<MetricType, TreeType>::Score(TreeType& queryNode,
   if ((queryNode.Stat().ComponentMembership() >= 0) &&
       (queryNode.Stat().ComponentMembership() ==
            referenceNode.Stat().ComponentMembership()))
-    return DBL_MAX;
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
 
-  ++scores;
   const double distance = queryNode.MinDistance(&referenceNode);
   const double bound = CalculateBound(queryNode);
 
   // If all the points in the reference node are farther than the candidate
   // nearest neighbor for all queries in the node, we prune.
-  return (bound < distance) ? DBL_MAX : distance;
+  return statistics.Score(PruneScore(distance, bound), queryNode,
+      referenceNode);
 }
 
 template<typename MetricType, typename TreeType>
@@ -158,15 +203,15 @@ double DTBRules<MetricType, TreeType>::Score(TreeType& queryNode,
   if ((queryNode.Stat().ComponentMembership() >= 0) &&
       (queryNode.Stat().ComponentMembership() ==
            referenceNode.Stat().ComponentMembership()))
-    return DBL_MAX;
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
 
-  ++scores;
   const double distance = queryNode.MinDistance(referenceNode, baseCaseResult);
   const double bound = CalculateBound(queryNode);
 
   // If all the points in the reference node are farther than the candidate
   // nearest neighbor for all queries in the node, we prune.
-  return (bound < distance) ? DBL_MAX : distance;
+  return statistics.Score(PruneScore(distance, bound), queryNode,
+      referenceNode);
 }
 
 template<typename MetricType, typename TreeType>
@@ -229,6 +274,25 @@ inline double DTBRules<MetricType, TreeType>::CalculateBound(
   return queryNode.Stat().Bound();
 }
 
+template<typename MetricType, typename TreeType>
+inline double DTBRules<MetricType, TreeType>::PruneScore(const double distance,
+                                                         const double bound)
+{
+  if (bound < distance)
+    return DBL_MAX;
+
+  // There is nothing to relax until a candidate edge has been found.
+  if ((epsilon == 0.0) || (bound == DBL_MAX) ||
+      (bound > (1 + epsilon) * distance))
+    return distance;
+
+  // No edge into the node is shorter than the distance, so the candidate edge
+  // is at most this much (relative to it) longer than any of them.
+  statistics.ApproximatePrune((bound > distance) ?
+      (bound - distance) / distance : 0.0);
+  return DBL_MAX;
+}
+
 }; // namespace emst
 }; // namespace mlpack
 
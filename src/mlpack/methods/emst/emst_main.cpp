@@ -23,6 +23,7 @@
 #include "dtb.hpp"
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
 
 PROGRAM_INFO("Fast Euclidean Minimum Spanning Tree", "This program can compute "
     "the Euclidean minimum spanning tree of a set of input points using the "
@@ -31,21 +32,102 @@ PROGRAM_INFO("Fast Euclidean Minimum Spanning Tree", "This program can compute "
     "The output is saved in a three-column matrix, where each row indicates an "
     "edge.  The first column corresponds to the lesser index of the edge; the "
     "second column corresponds to the greater index of the edge; and the third "
-    "column corresponds to the distance between the two points.");
+    "column corresponds to the distance between the two points."
+    "\n\n"
+    "The tree can be a kd-tree (the default), a ball tree, or a cover tree, "
+    "chosen with --tree_type (-t); in high dimensions, where kd-tree bounds "
+    "are loose, ball trees and cover trees may prune much more.  With "
+    "--epsilon (-e), an approximate tree is found faster: each of its edges is "
+    "within a factor of (1 + epsilon) of the shortest edge out of its "
+    "component, so its total length is within a factor of (1 + epsilon) of "
+    "that of the minimum spanning tree."
+    "\n\n"
+    "The single-linkage dendrogram of the points can be saved with the "
+    "--dendrogram_file (-d) option.  Each row is one merge, in order of "
+    "increasing height: the two clusters that are merged (the points are "
+    "clusters 0 to N - 1, and merge i creates cluster N + i), the height of "
+    "the merge, and the number of points in the new cluster."
+    "\n\n"
+    "Flat cluster labels can be saved with the --labels_file (-L) option, by "
+    "cutting the dendrogram at the height given by --cut_distance (-c).  "
+    "Points in clusters with fewer than --min_cluster_size (-m) points are "
+    "labeled as noise, with the label one past the last cluster.");
 
 PARAM_STRING_REQ("input_file", "Data input file.", "i");
 PARAM_STRING("output_file", "Data output file.  Stored as an edge list.", "o",
     "emst_output.csv");
 PARAM_FLAG("naive", "Compute the MST using O(n^2) naive algorithm.", "n");
-PARAM_INT("leaf_size", "Leaf size in the kd-tree.  One-element leaves give the "
-    "empirically best performance, but at the cost of greater memory "
-    "requirements.", "l", 1);
+PARAM_STRING("dendrogram_file", "File to save the single-linkage dendrogram "
+    "to.", "d", "");
+PARAM_STRING("labels_file", "File to save cluster labels to, obtained by "
+    "cutting the dendrogram at --cut_distance.", "L", "");
+PARAM_DOUBLE("cut_distance", "Height at which to cut the dendrogram for "
+    "--labels_file.", "c", 0.0);
+PARAM_INT("min_cluster_size", "Clusters with fewer points than this are "
+    "labeled as noise in --labels_file.", "m", 1);
+PARAM_INT("leaf_size", "Leaf size in the kd-tree or ball tree.  One-element "
+    "leaves give the empirically best performance, but at the cost of greater "
+    "memory requirements.", "l", 1);
+PARAM_STRING("tree_type", "Type of tree to use: 'kd', 'ball', or 'cover'.", "t",
+    "kd");
+PARAM_DOUBLE("epsilon", "Relative error allowed in each edge of the tree; 0 "
+    "gives the exact minimum spanning tree.", "e", 0.0);
 
 using namespace mlpack;
 using namespace mlpack::emst;
 using namespace mlpack::tree;
 using namespace std;
 
+/**
+ * Compute the MST with a binary space tree (kd-tree or ball tree) built with
+ * the given leaf size, and store its edges, with indices of the original
+ * dataset, in results.
+ */
+template<typename TreeType>
+void RunDTB(arma::mat& dataPoints,
+            const size_t leafSize,
+            const double epsilon,
+            arma::mat& results)
+{
+  // Compute the tree by hand, so that the leaf size can be given.
+  Timer::Start("tree_building");
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataPoints, oldFromNew, leafSize);
+  metric::LMetric<2, true> metric;
+  Timer::Stop("tree_building");
+
+  DualTreeBoruvka<metric::EuclideanDistance, TreeType> dtb(&tree, dataPoints,
+      metric);
+  dtb.Epsilon() = epsilon;
+
+  // Run the DTB algorithm.
+  Log::Info << "Calculating minimum spanning tree." << endl;
+  arma::mat mappedResults;
+  dtb.ComputeMST(mappedResults);
+  dtb.Statistics().Print();
+
+  // Unmap the results.
+  results.set_size(mappedResults.n_rows, mappedResults.n_cols);
+  for (size_t i = 0; i < mappedResults.n_cols; ++i)
+  {
+    const size_t indexA = oldFromNew[size_t(mappedResults(0, i))];
+    const size_t indexB = oldFromNew[size_t(mappedResults(1, i))];
+
+    if (indexA < indexB)
+    {
+      results(0, i) = indexA;
+      results(1, i) = indexB;
+    }
+    else
+    {
+      results(0, i) = indexB;
+      results(1, i) = indexA;
+    }
+
+    results(2, i) = mappedResults(2, i);
+  }
+}
+
 int main(int argc, char* argv[])
 {
   CLI::ParseCommandLine(argc, argv);
@@ -55,6 +137,45 @@ int main(int argc, char* argv[])
   arma::mat dataPoints;
   data::Load(dataFilename, dataPoints, true);
 
+  // Check the clustering options before doing any work.
+  if (CLI::GetParam<int>("min_cluster_size") <= 0)
+  {
+    Log::Fatal << "Invalid minimum cluster size ("
+        << CLI::GetParam<int>("min_cluster_size") << ")!  Must be greater "
+        << "than or equal to 1." << std::endl;
+  }
+  if (CLI::GetParam<string>("labels_file") == "" &&
+      (CLI::HasParam("cut_distance") || CLI::HasParam("min_cluster_size")))
+  {
+    Log::Warn << "--cut_distance and --min_cluster_size are ignored unless "
+        << "--labels_file is specified." << std::endl;
+  }
+
+  const string treeType = CLI::GetParam<string>("tree_type");
+  if (treeType != "kd" && treeType != "ball" && treeType != "cover")
+  {
+    Log::Fatal << "Invalid tree type '" << treeType << "'; must be 'kd', "
+        << "'ball', or 'cover'." << std::endl;
+  }
+  if (treeType == "cover" && CLI::HasParam("leaf_size"))
+    Log::Warn << "--leaf_size is ignored for cover trees." << std::endl;
+
+  const double epsilon = CLI::GetParam<double>("epsilon");
+  if (epsilon < 0)
+  {
+    Log::Fatal << "Invalid epsilon (" << epsilon << ")!  Must be greater than "
+        << "or equal to 0." << std::endl;
+  }
+  if (CLI::GetParam<bool>("naive") && (CLI::HasParam("tree_type") ||
+      CLI::HasParam("epsilon")))
+  {
+    Log::Warn << "--tree_type and --epsilon are ignored because --naive is "
+        << "specified." << std::endl;
+  }
+
+  // The MST edges, with indices of the original dataset.
+  arma::mat results;
+
   // Do naive computation if necessary.
   if (CLI::GetParam<bool>("naive"))
   {
@@ -62,12 +183,8 @@ int main(int argc, char* argv[])
 
     DualTreeBoruvka<> naive(dataPoints, true);
 
-    arma::mat naiveResults;
-    naive.ComputeMST(naiveResults);
-
-    const string outputFilename = CLI::GetParam<string>("output_file");
-
-    data::Save(outputFilename, naiveResults, true);
+    naive.ComputeMST(results);
+    naive.Statistics().Print();
   }
   else
   {
@@ -80,48 +197,60 @@ int main(int argc, char* argv[])
           << ")!  Must be greater than or equal to 1." << std::endl;
     }
 
-    // Initialize the tree and get ready to compute the MST.  Compute the tree
-    // by hand.
     const size_t leafSize = (size_t) CLI::GetParam<int>("leaf_size");
+    if (treeType == "kd")
+    {
+      RunDTB<BinarySpaceTree<bound::HRectBound<2>, DTBStat> >(dataPoints,
+          leafSize, epsilon, results);
+    }
+    else if (treeType == "ball")
+    {
+      RunDTB<BinarySpaceTree<bound::BallBound<>, DTBStat> >(dataPoints,
+          leafSize, epsilon, results);
+    }
+    else
+    {
+      // The cover tree does not rearrange the dataset, so no unmapping is
+      // needed.
+      DualTreeBoruvka<metric::EuclideanDistance,
+          CoverTree<metric::EuclideanDistance, FirstPointIsRoot, DTBStat> >
+          dtb(dataPoints);
+      dtb.Epsilon() = epsilon;
+
+      Log::Info << "Calculating minimum spanning tree." << endl;
+      dtb.ComputeMST(results);
+      dtb.Statistics().Print();
+    }
+  }
 
-    Timer::Start("tree_building");
-    std::vector<size_t> oldFromNew;
-    tree::BinarySpaceTree<bound::HRectBound<2>, DTBStat> tree(dataPoints,
-        oldFromNew, leafSize);
-    metric::LMetric<2, true> metric;
-    Timer::Stop("tree_building");
+  // Output the results.
+  const string outputFilename = CLI::GetParam<string>("output_file");
 
-    DualTreeBoruvka<> dtb(&tree, dataPoints, metric);
+  data::Save(outputFilename, results, true);
 
-    // Run the DTB algorithm.
-    Log::Info << "Calculating minimum spanning tree." << endl;
-    arma::mat results;
-    dtb.ComputeMST(results);
+  // Build the dendrogram from the edges, if it is needed.
+  const string dendrogramFilename = CLI::GetParam<string>("dendrogram_file");
+  const string labelsFilename = CLI::GetParam<string>("labels_file");
+  if (dendrogramFilename != "" || labelsFilename != "")
+  {
+    Timer::Start("dendrogram");
+    Dendrogram dendrogram(results, dataPoints.n_cols);
+    Timer::Stop("dendrogram");
 
-    // Unmap the results.
-    arma::mat unmappedResults(results.n_rows, results.n_cols);
-    for (size_t i = 0; i < results.n_cols; ++i)
-    {
-      const size_t indexA = oldFromNew[size_t(results(0, i))];
-      const size_t indexB = oldFromNew[size_t(results(1, i))];
-
-      if (indexA < indexB)
-      {
-        unmappedResults(0, i) = indexA;
-        unmappedResults(1, i) = indexB;
-      }
-      else
-      {
-        unmappedResults(0, i) = indexB;
-        unmappedResults(1, i) = indexA;
-      }
-
-      unmappedResults(2, i) = results(2, i);
-    }
+    if (dendrogramFilename != "")
+      data::Save(dendrogramFilename, dendrogram.Merges(), true);
 
-    // Output the results.
-    const string outputFilename = CLI::GetParam<string>("output_file");
+    if (labelsFilename != "")
+    {
+      arma::Col<size_t> labels;
+      const size_t clusters = dendrogram.Cut(
+          CLI::GetParam<double>("cut_distance"), labels,
+          (size_t) CLI::GetParam<int>("min_cluster_size"));
+      Log::Info << clusters << " clusters found." << endl;
 
-    data::Save(outputFilename, unmappedResults, true);
+      // One label per line.
+      arma::Mat<size_t> output = trans(labels);
+      data::Save(labelsFilename, output, true);
+    }
   }
 }
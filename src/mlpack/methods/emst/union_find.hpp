@@ -6,6 +6,8 @@
  * of a graph.  Each point in the graph is initially in its own component.
  * Calling unionfind.Union(x, y) unites the components indexed by x and y.
  * unionfind.Find(x) returns the index of the component containing point x.
+ * After unionfind.Flatten(), Find() may be called concurrently until the next
+ * Union().
  */
 #ifndef __MLPACK_METHODS_EMST_UNION_FIND_HPP
 #define __MLPACK_METHODS_EMST_UNION_FIND_HPP
@@ -56,12 +58,27 @@ class UnionFind
     }
     else
     {
-      // This ensures that the tree has a small depth
-      parent[x] = Find(parent[x]);
-      return parent[x];
+      // This ensures that the tree has a small depth.  The parent is only
+      // written if it changes, so that Find() does not modify the structure
+      // after Flatten() has been called.
+      const size_t root = Find(parent[x]);
+      if (parent[x] != root)
+        parent[x] = root;
+      return root;
     }
   }
 
+  /**
+   * Point every element directly at the root of its component.  Until the next
+   * call to Union(), Find() then only reads the structure, so it is safe to
+   * call Find() from several threads at once.
+   */
+  void Flatten()
+  {
+    for (size_t i = 0; i < parent.n_elem; ++i)
+      Find(i);
+  }
+
   /**
    * Union the components containing x and y.
    *
@@ -12,6 +12,7 @@
 #include <mlpack/core/metrics/ip_metric.hpp>
 #include "fastmks_stat.hpp"
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 namespace mlpack {
 namespace fastmks /** Fast max-kernel search. */ {
@@ -166,6 +167,9 @@ class FastMKS
    * product to point 4 in the query set will be stored in row 0 and column 4 of
    * the indices matrix.
    *
+   * For the linear and polynomial kernels and cosine similarity, naive search
+   * evaluates blocks of kernels with one matrix multiplication each.
+   *
    * @param k The number of maximum kernels to find.
    * @param indices Matrix to store resulting indices of max-kernel search in.
    * @param products Matrix to store resulting max-kernel values in.
@@ -174,11 +178,58 @@ class FastMKS
               arma::Mat<size_t>& indices,
               arma::mat& products);
 
+  /**
+   * Search for the maximum kernels of each point in the given batch of
+   * queries, using the reference tree held by this object; the search mode
+   * (naive, single-tree, or dual-tree, which builds a tree on the batch) is the
+   * one given at construction.  The results are stored as in the other
+   * overload of Search().
+   *
+   * This does not modify the object (the traversal statistics are not
+   * updated), so a FastMKS object can serve batches from several threads at
+   * once.  Single-tree and naive search are also parallelized over the queries
+   * of each batch when OpenMP is available.
+   *
+   * @param querySet Batch of query points.
+   * @param k The number of maximum kernels to find.
+   * @param indices Matrix to store resulting indices of max-kernel search in.
+   * @param products Matrix to store resulting max-kernel values in.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& indices,
+              arma::mat& products);
+
   //! Get the inner-product metric induced by the given kernel.
   const metric::IPMetric<KernelType>& Metric() const { return metric; }
   //! Modify the inner-product metric induced by the given kernel.
   metric::IPMetric<KernelType>& Metric() { return metric; }
 
+  //! Get whether single-tree searches visit the queries along the Hilbert
+  //! curve.
+  bool ReorderQueries() const { return reorderQueries; }
+  //! Modify whether single-tree searches visit the queries along the Hilbert
+  //! curve (see tree::HilbertOrder()) instead of in the order they were given,
+  //! so that consecutive queries reach the same parts of the reference tree.
+  //! The results are the same.  This is false by default.
+  bool& ReorderQueries() { return reorderQueries; }
+
+  //! Get the relative error allowed in the results of tree-based searches.
+  double Epsilon() const { return epsilon; }
+  //! Modify the relative error allowed in the results of tree-based searches.
+  //! With epsilon > 0, nodes are pruned unless they can improve on the current
+  //! kth kernel k* by more than epsilon * |k*|, so for positive kernels each
+  //! kth kernel found is within a factor of (1 + epsilon) of the exact one.
+  //! The largest error the prunes may have caused is given by
+  //! Statistics().MaxRelativeError().  This is 0 (exact search) by default,
+  //! and must not be negative.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the traversal statistics of tree building and all searches.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of tree building and all searches.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
   /**
    * Returns a string representation of this object.
    */
@@ -203,17 +254,37 @@ class FastMKS
   bool single;
   //! If true, naive (brute-force) search is used.
   bool naive;
+  //! If true, single-tree searches visit the queries along the Hilbert curve.
+  bool reorderQueries;
+  //! The relative error allowed in the results of tree-based searches.
+  double epsilon;
 
   //! The instantiated inner-product metric induced by the given kernel.
   metric::IPMetric<KernelType> metric;
 
-  //! Utility function.  Copied too many times from too many places.
-  void InsertNeighbor(arma::Mat<size_t>& indices,
-                      arma::mat& products,
-                      const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance);
+  //! The self-kernels sqrt(K(r, r)) of the reference points, computed when
+  //! the object is constructed (unless search is naive).
+  arma::vec referenceKernels;
+  //! The self-kernels sqrt(K(q, q)) of the query points, computed by the first
+  //! search (unused if there is no separate query set).
+  arma::vec queryKernels;
+
+  //! Compute sqrt(K(x, x)) for each point in the given dataset.
+  void SelfKernels(const arma::mat& dataset, arma::vec& kernels);
+
+  //! Search for the maximum kernels of the given queries (which may be the
+  //! reference set), with the given query tree and query self-kernels.
+  void SearchHelper(const arma::mat& queries,
+                    TreeType* queryRoot,
+                    const arma::vec& querySelfKernels,
+                    const size_t k,
+                    arma::Mat<size_t>& indices,
+                    arma::mat& products,
+                    tree::TraversalStatistics& searchStatistics,
+                    size_t& numPrunes);
+
+  //! The traversal statistics of tree building and all searches.
+  tree::TraversalStatistics statistics;
 };
 
 }; // namespace fastmks
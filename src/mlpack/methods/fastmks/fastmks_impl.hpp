@@ -12,6 +12,8 @@
 
 #include "fastmks_rules.hpp"
 
+#include <mlpack/core/kernels/block_kernels.hpp>
+#include <mlpack/core/tree/hilbert_curve.hpp>
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
 #include <queue>
 
@@ -29,9 +31,12 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     queryTree(NULL),
     treeOwner(true),
     single(single),
-    naive(naive)
+    naive(naive),
+    reorderQueries(false),
+    epsilon(0.0)
 {
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   if (!naive)
     referenceTree = new TreeType(referenceSet);
@@ -39,7 +44,12 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
   if (!naive && !single)
     queryTree = new TreeType(referenceSet);
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
+
+  // Every tree search needs the self-kernels of the reference points.
+  if (!naive)
+    SelfKernels(referenceSet, referenceKernels);
 }
 
 // Two datasets, no instantiated kernel.
@@ -54,9 +64,12 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     queryTree(NULL),
     treeOwner(true),
     single(single),
-    naive(naive)
+    naive(naive),
+    reorderQueries(false),
+    epsilon(0.0)
 {
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   // If necessary, the trees should be built.
   if (!naive)
@@ -65,7 +78,12 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
   if (!naive && !single)
     queryTree = new TreeType(querySet);
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
+
+  // Every tree search needs the self-kernels of the reference points.
+  if (!naive)
+    SelfKernels(referenceSet, referenceKernels);
 }
 
 // One dataset, instantiated kernel.
@@ -81,9 +99,12 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     treeOwner(true),
     single(single),
     naive(naive),
+    reorderQueries(false),
+    epsilon(0.0),
     metric(kernel)
 {
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   // If necessary, the reference tree should be built.  There is no query tree.
   if (!naive)
@@ -92,7 +113,12 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
   if (!naive && !single)
     queryTree = new TreeType(referenceSet, metric);
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
+
+  // Every tree search needs the self-kernels of the reference points.
+  if (!naive)
+    SelfKernels(referenceSet, referenceKernels);
 }
 
 // Two datasets, instantiated kernel.
@@ -109,9 +135,12 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     treeOwner(true),
     single(single),
     naive(naive),
+    reorderQueries(false),
+    epsilon(0.0),
     metric(kernel)
 {
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   // If necessary, the trees should be built.
   if (!naive)
@@ -120,7 +149,12 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
   if (!naive && !single)
     queryTree = new TreeType(querySet, metric);
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
+
+  // Every tree search needs the self-kernels of the reference points.
+  if (!naive)
+    SelfKernels(referenceSet, referenceKernels);
 }
 
 // One dataset, pre-built tree.
@@ -136,11 +170,17 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     treeOwner(false),
     single(single),
     naive(naive),
+    reorderQueries(false),
+    epsilon(0.0),
     metric(referenceTree->Metric())
 {
   // The query tree cannot be the same as the reference tree.
   if (referenceTree)
     queryTree = new TreeType(*referenceTree);
+
+  // Every tree search needs the self-kernels of the reference points.
+  if (!naive)
+    SelfKernels(referenceSet, referenceKernels);
 }
 
 // Two datasets, pre-built trees.
@@ -158,9 +198,13 @@ FastMKS<KernelType, TreeType>::FastMKS(const arma::mat& referenceSet,
     treeOwner(false),
     single(single),
     naive(naive),
+    reorderQueries(false),
+    epsilon(0.0),
     metric(referenceTree->Metric())
 {
-  // Nothing to do.
+  // Every tree search needs the self-kernels of the reference points.
+  if (!naive)
+    SelfKernels(referenceSet, referenceKernels);
 }
 
 template<typename KernelType, typename TreeType>
@@ -187,117 +231,209 @@ void FastMKS<KernelType, TreeType>::Search(const size_t k,
                                            arma::Mat<size_t>& indices,
                                            arma::mat& products)
 {
-  // No remapping will be necessary because we are using the cover tree.
-  indices.set_size(k, querySet.n_cols);
-  products.set_size(k, querySet.n_cols);
-  products.fill(-DBL_MAX);
+  // The query self-kernels only need to be computed once.
+  if (!naive && (&querySet != &referenceSet) &&
+      (queryKernels.n_elem != querySet.n_cols))
+    SelfKernels(querySet, queryKernels);
 
   Timer::Start("computing_products");
+  statistics.StartPhase("traversal");
+
+  tree::TraversalStatistics searchStatistics;
+  size_t numPrunes = 0;
+  SearchHelper(querySet, queryTree, (&querySet == &referenceSet) ?
+      referenceKernels : queryKernels, k, indices, products, searchStatistics,
+      numPrunes);
+
+  if (!naive)
+  {
+    Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
+    Log::Info << searchStatistics.BaseCases() << " base cases." << std::endl;
+    Log::Info << searchStatistics.Scores() << " scores." << std::endl;
+    if (epsilon > 0)
+    {
+      Log::Info << searchStatistics.ApproximatePrunes() << " approximate "
+          << "prunes; results are within a relative error of "
+          << searchStatistics.MaxRelativeError() << "." << std::endl;
+    }
+  }
+  statistics += searchStatistics;
+
+  statistics.StopPhase("traversal");
+  Timer::Stop("computing_products");
+}
+
+template<typename KernelType, typename TreeType>
+void FastMKS<KernelType, TreeType>::Search(const arma::mat& batchQuerySet,
+                                           const size_t k,
+                                           arma::Mat<size_t>& indices,
+                                           arma::mat& products)
+{
+  // Everything specific to this batch is local, so that several batches can be
+  // searched at once.
+  arma::vec batchQueryKernels;
+  if (!naive)
+    SelfKernels(batchQuerySet, batchQueryKernels);
+
+  // Dual-tree search needs a tree on the batch.
+  metric::IPMetric<KernelType> batchMetric(metric.Kernel());
+  TreeType* batchQueryTree = NULL;
+  if (!naive && !single)
+    batchQueryTree = new TreeType(batchQuerySet, batchMetric);
+
+  tree::TraversalStatistics searchStatistics;
+  size_t numPrunes = 0;
+  SearchHelper(batchQuerySet, batchQueryTree, batchQueryKernels, k, indices,
+      products, searchStatistics, numPrunes);
+
+  delete batchQueryTree;
+}
+
+template<typename KernelType, typename TreeType>
+void FastMKS<KernelType, TreeType>::SearchHelper(
+    const arma::mat& queries,
+    TreeType* queryRoot,
+    const arma::vec& querySelfKernels,
+    const size_t k,
+    arma::Mat<size_t>& indices,
+    arma::mat& products,
+    tree::TraversalStatistics& searchStatistics,
+    size_t& numPrunes)
+{
+  // No remapping will be necessary because we are using the cover tree.  While
+  // the search runs, each column holds a heap of candidates (see
+  // CandidateHeap); these are sorted once the search is done.
+  if (epsilon < 0)
+  {
+    Log::Fatal << "FastMKS::Search(): epsilon must be non-negative (" << epsilon
+        << " given)." << std::endl;
+  }
+
+  typedef typename FastMKSRules<KernelType, TreeType>::CandidateHeapType
+      CandidateHeapType;
+  indices.set_size(k, queries.n_cols);
+  indices.fill(size_t() - 1);
+  products.set_size(k, queries.n_cols);
+  products.fill(-DBL_MAX);
 
   // Naive implementation.
   if (naive)
   {
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < querySet.n_cols; ++q)
+    // Loop over blocks of queries and references.  If the kernel allows it,
+    // all the kernels in a block are computed with one matrix multiplication;
+    // otherwise, this is a simple double loop.  Stupid, slow, but a good
+    // benchmark.  Each thread takes whole blocks of queries.
+    const size_t queryBlockSize = 256;
+    const size_t referenceBlockSize = 1024;
+    const size_t numQueryBlocks = (queries.n_cols + queryBlockSize - 1) /
+        queryBlockSize;
+    size_t baseCases = 0;
+
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:baseCases)
+    for (size_t block = 0; block < numQueryBlocks; ++block)
     {
-      for (size_t r = 0; r < referenceSet.n_cols; ++r)
+      const size_t qBegin = block * queryBlockSize;
+      const size_t qEnd = std::min(qBegin + queryBlockSize, queries.n_cols);
+
+      arma::mat blockKernels;
+      for (size_t rBegin = 0; rBegin < referenceSet.n_cols;
+           rBegin += referenceBlockSize)
       {
-        if ((&querySet == &referenceSet) && (q == r))
-          continue;
+        const size_t rEnd = std::min(rBegin + referenceBlockSize,
+            referenceSet.n_cols);
+        const bool blockDone = kernel::BlockKernels(metric.Kernel(),
+            queries.cols(qBegin, qEnd - 1),
+            referenceSet.cols(rBegin, rEnd - 1), blockKernels);
 
-        const double eval = metric.Kernel().Evaluate(querySet.unsafe_col(q),
-            referenceSet.unsafe_col(r));
+        for (size_t q = qBegin; q < qEnd; ++q)
+        {
+          for (size_t r = rBegin; r < rEnd; ++r)
+          {
+            if ((&queries == &referenceSet) && (q == r))
+              continue;
 
-        size_t insertPosition;
-        for (insertPosition = 0; insertPosition < indices.n_rows;
-            ++insertPosition)
-          if (eval > products(insertPosition, q))
-            break;
+            const double eval = blockDone ?
+                blockKernels(q - qBegin, r - rBegin) :
+                metric.Kernel().Evaluate(queries.unsafe_col(q),
+                                         referenceSet.unsafe_col(r));
 
-        if (insertPosition < indices.n_rows)
-          InsertNeighbor(indices, products, q, insertPosition, r, eval);
+            ++baseCases;
+
+            CandidateHeapType::Insert(indices, products, q, r, eval);
+          }
+        }
       }
     }
 
-    Timer::Stop("computing_products");
+    searchStatistics.BaseCases() += baseCases;
 
+    CandidateHeapType::Sort(indices, products);
     return;
   }
 
+  typedef FastMKSRules<KernelType, TreeType> RuleType;
+
   // Single-tree implementation.
   if (single)
   {
-    // Create rules object (this will store the results).  This constructor
-    // precalculates each self-kernel value.
-    typedef FastMKSRules<KernelType, TreeType> RuleType;
-    RuleType rules(referenceSet, querySet, indices, products, metric.Kernel());
-
-    typename TreeType::template SingleTreeTraverser<RuleType> traverser(rules);
+    // Visit the queries along the Hilbert curve, if requested, so that
+    // consecutive queries reach the same parts of the reference tree.  Each
+    // query still writes to its own column of the results.
+    std::vector<size_t> order;
+    if (reorderQueries)
+      tree::HilbertOrder(queries, order);
+
+    // The queries are independent, so each thread searches its own queries
+    // with its own rules object.  Each query's results are a separate column
+    // of indices and products.  The rules only read the reference tree if its
+    // first points are centroids; otherwise they store kernel evaluations in
+    // the tree, and the search must be serial.
+    #pragma omp parallel if(tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+    {
+      RuleType rules(referenceSet, queries, indices, products,
+          metric.Kernel(), referenceKernels, querySelfKernels, epsilon);
 
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+      typename TreeType::template SingleTreeTraverser<RuleType>
+          traverser(rules);
 
-    // Save the number of pruned nodes.
-    const size_t numPrunes = traverser.NumPrunes();
+      #pragma omp for schedule(dynamic, 16)
+      for (size_t i = 0; i < queries.n_cols; ++i)
+        traverser.Traverse(order.empty() ? i : order[i], *referenceTree);
 
-    Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
-
-    Log::Info << rules.BaseCases() << " base cases." << std::endl;
-    Log::Info << rules.Scores() << " scores." << std::endl;
+      #pragma omp critical
+      {
+        numPrunes += traverser.NumPrunes();
+        searchStatistics += rules.Statistics();
+      }
+    }
 
-    Timer::Stop("computing_products");
+    CandidateHeapType::Sort(indices, products);
     return;
   }
 
-  // Dual-tree implementation.
-  typedef FastMKSRules<KernelType, TreeType> RuleType;
-  RuleType rules(referenceSet, querySet, indices, products, metric.Kernel());
+  // Dual-tree implementation.  The traversal keeps parent-child pruning state
+  // across the whole query tree, so it is done by one thread.
+  RuleType rules(referenceSet, queries, indices, products, metric.Kernel(),
+      referenceKernels, querySelfKernels, epsilon);
 
   typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
 
-  traverser.Traverse(*queryTree, *referenceTree);
-
-  const size_t numPrunes = traverser.NumPrunes();
+  traverser.Traverse(*queryRoot, *referenceTree);
 
-  Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
-  Log::Info << rules.BaseCases() << " base cases." << std::endl;
-  Log::Info << rules.Scores() << " scores." << std::endl;
+  numPrunes += traverser.NumPrunes();
+  searchStatistics += rules.Statistics();
 
-  Timer::Stop("computing_products");
-  return;
+  CandidateHeapType::Sort(indices, products);
 }
 
-/**
- * Helper function to insert a point into the neighbors and distances matrices.
- *
- * @param queryIndex Index of point whose neighbors we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of reference point which is being inserted.
- * @param distance Distance from query point to reference point.
- */
 template<typename KernelType, typename TreeType>
-void FastMKS<KernelType, TreeType>::InsertNeighbor(arma::Mat<size_t>& indices,
-                                                   arma::mat& products,
-                                                   const size_t queryIndex,
-                                                   const size_t pos,
-                                                   const size_t neighbor,
-                                                   const double distance)
+void FastMKS<KernelType, TreeType>::SelfKernels(const arma::mat& dataset,
+                                                arma::vec& kernels)
 {
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (products.n_rows - 1))
-  {
-    int len = (products.n_rows - 1) - pos;
-    memmove(products.colptr(queryIndex) + (pos + 1),
-        products.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(indices.colptr(queryIndex) + (pos + 1),
-        indices.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
-  }
-
-  // Now put the new information in the right index.
-  products(pos, queryIndex) = distance;
-  indices(pos, queryIndex) = neighbor;
+  kernels.set_size(dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    kernels[i] = sqrt(metric.Kernel().Evaluate(dataset.unsafe_col(i),
+                                               dataset.unsafe_col(i)));
 }
 
 // Return string of object.
@@ -308,6 +444,7 @@ std::string FastMKS<KernelType, TreeType>::ToString() const
   convert << "FastMKS [" << this << "]" << std::endl;
   convert << "  Naive: " << naive << std::endl;
   convert << "  Single: " << single << std::endl;
+  convert << "  Epsilon: " << epsilon << std::endl;
   convert << "  Metric: " << std::endl;
   convert << mlpack::util::Indent(metric.ToString(),2);
   convert << std::endl;
@@ -365,6 +502,13 @@ void FastMKS<kernel::GaussianKernel>::Search(const size_t k,
   // Single-tree implementation.
   if (single)
   {
+    // Visit the queries along the Hilbert curve, if requested, so that
+    // consecutive queries reach the same parts of the reference tree.  Each
+    // query still writes to its own column of the results.
+    std::vector<size_t> order;
+    if (reorderQueries)
+      tree::HilbertOrder(queries, order);
+
     // Calculate number of pruned nodes.
     size_t numPrunes = 0;
 
@@ -57,6 +57,11 @@ PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single", "If true, single-tree search is used (as opposed to "
     "dual-tree search.", "S");
 
+PARAM_DOUBLE("epsilon", "Relative error allowed in tree-based searches; if "
+    "greater than 0, nodes are pruned unless they can improve on the kth "
+    "kernel found by more than epsilon times its magnitude.  The largest "
+    "error the search may have made is printed with --verbose.", "e", 0.0);
+
 // Cover tree parameter.
 PARAM_DOUBLE("base", "Base to use during cover tree construction.", "b", 2.0);
 
@@ -74,6 +79,7 @@ void RunFastMKS(const arma::mat& referenceData,
                 const bool single,
                 const bool naive,
                 const double base,
+                const double epsilon,
                 const size_t k,
                 arma::Mat<size_t>& indices,
                 arma::mat& products,
@@ -87,9 +93,11 @@ void RunFastMKS(const arma::mat& referenceData,
 
   // Create FastMKS object.
   FastMKS<KernelType> fastmks(referenceData, &tree, (single && !naive), naive);
+  fastmks.Epsilon() = epsilon;
 
   // Now search with it.
   fastmks.Search(k, indices, products);
+  fastmks.Statistics().Print();
 }
 
 //! Run FastMKS for a given query and reference set using the given kernel type.
@@ -99,6 +107,7 @@ void RunFastMKS(const arma::mat& referenceData,
                 const bool single,
                 const bool naive,
                 const double base,
+                const double epsilon,
                 const size_t k,
                 arma::Mat<size_t>& indices,
                 arma::mat& products,
@@ -114,9 +123,11 @@ void RunFastMKS(const arma::mat& referenceData,
   // Create FastMKS object.
   FastMKS<KernelType> fastmks(referenceData, &referenceTree, queryData,
       &queryTree, (single && !naive), naive);
+  fastmks.Epsilon() = epsilon;
 
   // Now search with it.
   fastmks.Search(k, indices, products);
+  fastmks.Statistics().Print();
 }
 
 int main(int argc, char** argv)
@@ -136,6 +147,16 @@ int main(int argc, char** argv)
   // For cover tree construction.
   const double base = CLI::GetParam<double>("base");
 
+  // Sanity check on epsilon.
+  const double epsilon = CLI::GetParam<double>("epsilon");
+  if (epsilon < 0)
+  {
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be 0 or greater."
+        << endl;
+  }
+  if (epsilon > 0 && naive)
+    Log::Warn << "--epsilon ignored because --naive is present." << endl;
+
   // Kernel parameters.
   const string kernelType = CLI::GetParam<string>("kernel");
   const double degree = CLI::GetParam<double>("degree");
@@ -202,45 +223,45 @@ int main(int argc, char** argv)
     if (kernelType == "linear")
     {
       LinearKernel lk;
-      RunFastMKS<LinearKernel>(referenceData, single, naive, base, k, indices,
-          products, lk);
+      RunFastMKS<LinearKernel>(referenceData, single, naive, base,
+          epsilon, k, indices, products, lk);
     }
     else if (kernelType == "polynomial")
     {
 
       PolynomialKernel pk(degree, offset);
-      RunFastMKS<PolynomialKernel>(referenceData, single, naive, base, k,
-          indices, products, pk);
+      RunFastMKS<PolynomialKernel>(referenceData, single, naive, base,
+          epsilon, k, indices, products, pk);
     }
     else if (kernelType == "cosine")
     {
       CosineDistance cd;
-      RunFastMKS<CosineDistance>(referenceData, single, naive, base, k, indices,
-          products, cd);
+      RunFastMKS<CosineDistance>(referenceData, single, naive, base,
+          epsilon, k, indices, products, cd);
     }
     else if (kernelType == "gaussian")
     {
       GaussianKernel gk(bandwidth);
-      RunFastMKS<GaussianKernel>(referenceData, single, naive, base, k, indices,
-          products, gk);
+      RunFastMKS<GaussianKernel>(referenceData, single, naive, base,
+          epsilon, k, indices, products, gk);
     }
     else if (kernelType == "epanechnikov")
     {
       EpanechnikovKernel ek(bandwidth);
-      RunFastMKS<EpanechnikovKernel>(referenceData, single, naive, base, k,
-          indices, products, ek);
+      RunFastMKS<EpanechnikovKernel>(referenceData, single, naive, base,
+          epsilon, k, indices, products, ek);
     }
     else if (kernelType == "triangular")
     {
       TriangularKernel tk(bandwidth);
-      RunFastMKS<TriangularKernel>(referenceData, single, naive, base, k,
-          indices, products, tk);
+      RunFastMKS<TriangularKernel>(referenceData, single, naive, base,
+          epsilon, k, indices, products, tk);
     }
     else if (kernelType == "hyptan")
     {
       HyperbolicTangentKernel htk(scale, offset);
-      RunFastMKS<HyperbolicTangentKernel>(referenceData, single, naive, base, k,
-          indices, products, htk);
+      RunFastMKS<HyperbolicTangentKernel>(referenceData, single, naive, base,
+          epsilon, k, indices, products, htk);
     }
   }
   else
@@ -248,44 +269,44 @@ int main(int argc, char** argv)
     if (kernelType == "linear")
     {
       LinearKernel lk;
-      RunFastMKS<LinearKernel>(referenceData, queryData, single, naive, base, k,
-          indices, products, lk);
+      RunFastMKS<LinearKernel>(referenceData, queryData, single, naive, base,
+          epsilon, k, indices, products, lk);
     }
     else if (kernelType == "polynomial")
     {
       PolynomialKernel pk(degree, offset);
-      RunFastMKS<PolynomialKernel>(referenceData, queryData, single, naive,
-          base, k, indices, products, pk);
+      RunFastMKS<PolynomialKernel>(referenceData, queryData,
+          single, naive, base, epsilon, k, indices, products, pk);
     }
     else if (kernelType == "cosine")
     {
       CosineDistance cd;
       RunFastMKS<CosineDistance>(referenceData, queryData, single, naive, base,
-          k, indices, products, cd);
+          epsilon, k, indices, products, cd);
     }
     else if (kernelType == "gaussian")
     {
       GaussianKernel gk(bandwidth);
       RunFastMKS<GaussianKernel>(referenceData, queryData, single, naive, base,
-          k, indices, products, gk);
+          epsilon, k, indices, products, gk);
     }
     else if (kernelType == "epanechnikov")
     {
       EpanechnikovKernel ek(bandwidth);
-      RunFastMKS<EpanechnikovKernel>(referenceData, queryData, single, naive,
-          base, k, indices, products, ek);
+      RunFastMKS<EpanechnikovKernel>(referenceData, queryData,
+          single, naive, base, epsilon, k, indices, products, ek);
     }
     else if (kernelType == "triangular")
     {
       TriangularKernel tk(bandwidth);
-      RunFastMKS<TriangularKernel>(referenceData, queryData, single, naive,
-          base, k, indices, products, tk);
+      RunFastMKS<TriangularKernel>(referenceData, queryData,
+          single, naive, base, epsilon, k, indices, products, tk);
     }
     else if (kernelType == "hyptan")
     {
       HyperbolicTangentKernel htk(scale, offset);
-      RunFastMKS<HyperbolicTangentKernel>(referenceData, queryData, single,
-          naive, base, k, indices, products, htk);
+      RunFastMKS<HyperbolicTangentKernel>(referenceData, queryData,
+          single, naive, base, epsilon, k, indices, products, htk);
     }
   }
 
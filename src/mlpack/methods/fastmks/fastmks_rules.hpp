@@ -9,8 +9,11 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 #include "../neighbor_search/ns_traversal_info.hpp"
+#include "../neighbor_search/candidate_heap.hpp"
+#include "../neighbor_search/sort_policies/furthest_neighbor_sort.hpp"
 
 namespace mlpack {
 namespace fastmks {
@@ -22,11 +25,30 @@ template<typename KernelType, typename TreeType>
 class FastMKSRules
 {
  public:
+  /**
+   * The candidates for each query point are held in a heap where larger kernel
+   * values are better; this is the ordering that FurthestNeighborSort gives.
+   */
+  typedef neighbor::CandidateHeap<neighbor::FurthestNeighborSort>
+      CandidateHeapType;
+
+  /**
+   * Construct the rules.  The self-kernels sqrt(K(x, x)) of each point are
+   * computed once by FastMKS, and only referenced here.
+   *
+   * With epsilon > 0, Score() also prunes nodes that cannot improve on the
+   * kth best kernel k* by more than epsilon * |k*|, and counts those prunes in
+   * the statistics (see tree::TraversalStatistics::MaxRelativeError()).
+   * Rescore() only prunes exactly, so that every approximate prune is counted.
+   */
   FastMKSRules(const arma::mat& referenceSet,
                const arma::mat& querySet,
                arma::Mat<size_t>& indices,
                arma::mat& products,
-               KernelType& kernel);
+               KernelType& kernel,
+               const arma::vec& referenceKernels,
+               const arma::vec& queryKernels,
+               const double epsilon = 0.0);
 
   //! Compute the base case (kernel value) between two points.
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
@@ -82,14 +104,22 @@ class FastMKSRules
                  const double oldScore) const;
 
   //! Get the number of times BaseCase() was called.
-  size_t BaseCases() const { return baseCases; }
+  size_t BaseCases() const { return statistics.BaseCases(); }
   //! Modify the number of times BaseCase() was called.
-  size_t& BaseCases() { return baseCases; }
+  size_t& BaseCases() { return statistics.BaseCases(); }
 
   //! Get the number of times Score() was called.
-  size_t Scores() const { return scores; }
+  size_t Scores() const { return statistics.Scores(); }
   //! Modify the number of times Score() was called.
-  size_t& Scores() { return scores; }
+  size_t& Scores() { return statistics.Scores(); }
+
+  //! Get the relative error allowed when pruning.
+  double Epsilon() const { return epsilon; }
+
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
 
   typedef neighbor::NeighborSearchTraversalInfo<TreeType> TraversalInfoType;
 
@@ -102,15 +132,15 @@ class FastMKSRules
   //! The query dataset.
   const arma::mat& querySet;
 
-  //! The indices of the maximum kernel results.
+  //! The indices of the maximum kernel results (each column is a heap).
   arma::Mat<size_t>& indices;
-  //! The maximum kernels.
+  //! The maximum kernels (each column is a heap).
   arma::mat& products;
 
   //! Cached query set self-kernels (|| q || for each q).
-  arma::vec queryKernels;
+  const arma::vec& queryKernels;
   //! Cached reference set self-kernels (|| r || for each r).
-  arma::vec referenceKernels;
+  const arma::vec& referenceKernels;
 
   //! The instantiated kernel.
   KernelType& kernel;
@@ -122,19 +152,28 @@ class FastMKSRules
   //! The last kernel evaluation resulting from BaseCase().
   double lastKernel;
 
+  //! The last kernel evaluation with each reference point (only used if the
+  //! first point of each node is its centroid).
+  arma::vec pointKernels;
+  //! The query index each entry of pointKernels was evaluated with.
+  arma::Col<size_t> pointKernelQueries;
+
+  //! The relative error allowed when pruning.
+  double epsilon;
+
   //! Calculate the bound for a given query node.
   double CalculateBound(TreeType& queryNode) const;
 
-  //! Utility function to insert neighbor into list of results.
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance);
+  /**
+   * Return whether a node whose kernels are at most maxKernel can be pruned
+   * only because of epsilon, given the kth best kernel it would need to beat
+   * (this is only called once the node could not be pruned exactly).  Such
+   * prunes are counted in the statistics.
+   */
+  bool ApproximatePrune(const double maxKernel, const double bestKernel);
 
-  //! For benchmarking.
-  size_t baseCases;
-  //! For benchmarking.
-  size_t scores;
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
 
   TraversalInfoType traversalInfo;
 };
@@ -14,32 +14,34 @@ namespace mlpack {
 namespace fastmks {
 
 template<typename KernelType, typename TreeType>
-FastMKSRules<KernelType, TreeType>::FastMKSRules(const arma::mat& referenceSet,
-                                                 const arma::mat& querySet,
-                                                 arma::Mat<size_t>& indices,
-                                                 arma::mat& products,
-                                                 KernelType& kernel) :
+FastMKSRules<KernelType, TreeType>::FastMKSRules(
+    const arma::mat& referenceSet,
+    const arma::mat& querySet,
+    arma::Mat<size_t>& indices,
+    arma::mat& products,
+    KernelType& kernel,
+    const arma::vec& referenceKernels,
+    const arma::vec& queryKernels,
+    const double epsilon) :
     referenceSet(referenceSet),
     querySet(querySet),
     indices(indices),
     products(products),
+    queryKernels(queryKernels),
+    referenceKernels(referenceKernels),
     kernel(kernel),
     lastQueryIndex(-1),
     lastReferenceIndex(-1),
     lastKernel(0.0),
-    baseCases(0),
-    scores(0)
+    epsilon(epsilon)
 {
-  // Precompute each self-kernel.
-  queryKernels.set_size(querySet.n_cols);
-  for (size_t i = 0; i < querySet.n_cols; ++i)
-    queryKernels[i] = sqrt(kernel.Evaluate(querySet.unsafe_col(i),
-                                           querySet.unsafe_col(i)));
-
-  referenceKernels.set_size(referenceSet.n_cols);
-  for (size_t i = 0; i < referenceSet.n_cols; ++i)
-    referenceKernels[i] = sqrt(kernel.Evaluate(referenceSet.unsafe_col(i),
-                                               referenceSet.unsafe_col(i)));
+  // No kernel evaluations have been cached yet.
+  if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+  {
+    pointKernels.set_size(referenceSet.n_cols);
+    pointKernelQueries.set_size(referenceSet.n_cols);
+    pointKernelQueries.fill(size_t() - 1);
+  }
 
   // Set to invalid memory, so that the first node combination does not try to
   // dereference null pointers.
@@ -63,18 +65,27 @@ double FastMKSRules<KernelType, TreeType>::BaseCase(
         (referenceIndex == lastReferenceIndex))
       return lastKernel;
 
+    // The evaluation may also have been done for an ancestor whose point is
+    // the same.
+    if (pointKernelQueries[referenceIndex] == queryIndex)
+      return pointKernels[referenceIndex];
+
     // Store new values.
     lastQueryIndex = queryIndex;
     lastReferenceIndex = referenceIndex;
   }
 
-  ++baseCases;
+  ++statistics.BaseCases();
   double kernelEval = kernel.Evaluate(querySet.unsafe_col(queryIndex),
                                       referenceSet.unsafe_col(referenceIndex));
 
   // Update the last kernel value, if we need to.
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+  {
     lastKernel = kernelEval;
+    pointKernels[referenceIndex] = kernelEval;
+    pointKernelQueries[referenceIndex] = queryIndex;
+  }
 
   // If the reference and query sets are identical, we still need to compute the
   // base case (so that things can be bounded properly), but we won't add it to
@@ -83,15 +94,8 @@ double FastMKSRules<KernelType, TreeType>::BaseCase(
     return kernelEval;
 
   // If this is a better candidate, insert it into the list.
-  if (kernelEval < products(products.n_rows - 1, queryIndex))
-    return kernelEval;
-
-  size_t insertPosition = 0;
-  for ( ; insertPosition < products.n_rows; ++insertPosition)
-    if (kernelEval >= products(insertPosition, queryIndex))
-      break;
-
-  InsertNeighbor(queryIndex, insertPosition, referenceIndex, kernelEval);
+  CandidateHeapType::Insert(indices, products, queryIndex, referenceIndex,
+      kernelEval);
 
   return kernelEval;
 }
@@ -101,16 +105,36 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
                                                  TreeType& referenceNode)
 {
   // Compare with the current best.
-  const double bestKernel = products(products.n_rows - 1, queryIndex);
+  const double bestKernel = CandidateHeapType::WorstDistance(products,
+      queryIndex);
 
   // See if we can perform a parent-child prune.
   const double furthestDist = referenceNode.FurthestDescendantDistance();
-  if (referenceNode.Parent() != NULL)
+  // The parent's kernel is only known if it was evaluated for this query; when
+  // the first point is the centroid, it is looked up by point, so that several
+  // rules objects can search the same tree at once.
+  bool parentKernelKnown = (referenceNode.Parent() != NULL);
+  double parentKernel = 0.0;
+  if (parentKernelKnown)
+  {
+    if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+    {
+      const size_t parentPoint = referenceNode.Parent()->Point(0);
+      parentKernelKnown = (pointKernelQueries[parentPoint] == queryIndex);
+      parentKernel = pointKernels[parentPoint];
+    }
+    else
+    {
+      parentKernel = referenceNode.Parent()->Stat().LastKernel();
+    }
+  }
+
+  if (parentKernelKnown)
   {
     double maxKernelBound;
     const double parentDist = referenceNode.ParentDistance();
     const double combinedDistBound = parentDist + furthestDist;
-    const double lastKernel = referenceNode.Parent()->Stat().LastKernel();
+    const double lastKernel = parentKernel;
     if (kernel::KernelTraits<KernelType>::IsNormalized)
     {
       const double squaredDist = std::pow(combinedDistBound, 2.0);
@@ -132,27 +156,20 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
           combinedDistBound * queryKernels[queryIndex];
     }
 
-    if (maxKernelBound < bestKernel)
-      return DBL_MAX;
+    if ((maxKernelBound < bestKernel) ||
+        ApproximatePrune(maxKernelBound, bestKernel))
+      return statistics.Score(DBL_MAX, referenceNode);
   }
 
   // Calculate the maximum possible kernel value, either by calculating the
   // centroid or, if the centroid is a point, use that.
-  ++scores;
   double kernelEval;
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
   {
-    // Could it be that this kernel evaluation has already been calculated?
-    if (tree::TreeTraits<TreeType>::HasSelfChildren &&
-        referenceNode.Parent() != NULL &&
-        referenceNode.Point(0) == referenceNode.Parent()->Point(0))
-    {
-      kernelEval = referenceNode.Parent()->Stat().LastKernel();
-    }
-    else
-    {
-      kernelEval = BaseCase(queryIndex, referenceNode.Point(0));
-    }
+    // If this kernel evaluation has already been calculated (for instance, by
+    // the parent of a self-child), BaseCase() returns it without evaluating
+    // the kernel again.
+    kernelEval = BaseCase(queryIndex, referenceNode.Point(0));
   }
   else
   {
@@ -161,9 +178,9 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     referenceNode.Centroid(refCentroid);
 
     kernelEval = kernel.Evaluate(queryPoint, refCentroid);
-  }
 
-  referenceNode.Stat().LastKernel() = kernelEval;
+    referenceNode.Stat().LastKernel() = kernelEval;
+  }
 
   double maxKernel;
   if (kernel::KernelTraits<KernelType>::IsNormalized)
@@ -186,9 +203,12 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     maxKernel = kernelEval + furthestDist * queryKernels[queryIndex];
   }
 
+  if ((maxKernel <= bestKernel) || ApproximatePrune(maxKernel, bestKernel))
+    return statistics.Score(DBL_MAX, referenceNode);
+
   // We return the inverse of the maximum kernel so that larger kernels are
   // recursed into first.
-  return (maxKernel > bestKernel) ? (1.0 / maxKernel) : DBL_MAX;
+  return statistics.Score(1.0 / maxKernel, referenceNode);
 }
 
 template<typename KernelType, typename TreeType>
@@ -284,12 +304,13 @@ double FastMKSRules<KernelType, TreeType>::Score(TreeType& queryNode,
   // Now add the dual term.
   adjustedScore += (dualQueryTerm * dualRefTerm);
 
-  if (adjustedScore < bestKernel)
+  if ((adjustedScore < bestKernel) ||
+      ApproximatePrune(adjustedScore, bestKernel))
   {
     // It is not possible that this node combination can contain a point
     // combination with kernel value better than the minimum kernel value to
     // improve any of the results, so we can prune it.
-    return DBL_MAX;
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
   }
 
   // We were unable to perform a parent-child or parent-parent prune, so now we
@@ -334,7 +355,6 @@ double FastMKSRules<KernelType, TreeType>::Score(TreeType& queryNode,
 
     traversalInfo.LastBaseCase() = kernelEval;
   }
-  ++scores;
 
   double maxKernel;
   if (kernel::KernelTraits<KernelType>::IsNormalized)
@@ -375,9 +395,12 @@ double FastMKSRules<KernelType, TreeType>::Score(TreeType& queryNode,
   traversalInfo.LastQueryNode() = &queryNode;
   traversalInfo.LastReferenceNode() = &referenceNode;
 
+  if ((maxKernel <= bestKernel) || ApproximatePrune(maxKernel, bestKernel))
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
+
   // We return the inverse of the maximum kernel so that larger kernels are
   // recursed into first.
-  return (maxKernel > bestKernel) ? (1.0 / maxKernel) : DBL_MAX;
+  return statistics.Score(1.0 / maxKernel, queryNode, referenceNode);
 }
 
 template<typename KernelType, typename TreeType>
@@ -385,7 +408,8 @@ double FastMKSRules<KernelType, TreeType>::Rescore(const size_t queryIndex,
                                                    TreeType& /*referenceNode*/,
                                                    const double oldScore) const
 {
-  const double bestKernel = products(products.n_rows - 1, queryIndex);
+  const double bestKernel = CandidateHeapType::WorstDistance(products,
+      queryIndex);
 
   return ((1.0 / oldScore) > bestKernel) ? oldScore : DBL_MAX;
 }
@@ -430,17 +454,18 @@ double FastMKSRules<KernelType, TreeType>::CalculateBound(TreeType& queryNode)
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
     const size_t point = queryNode.Point(i);
-    if (products(products.n_rows - 1, point) < worstPointKernel)
-      worstPointKernel = products(products.n_rows - 1, point);
+    const double pointKernel = CandidateHeapType::WorstDistance(products,
+        point);
+    if (pointKernel < worstPointKernel)
+      worstPointKernel = pointKernel;
 
-    if (products(products.n_rows - 1, point) == -DBL_MAX)
+    if (pointKernel == -DBL_MAX)
       continue; // Avoid underflow.
 
     // This should be (queryDescendantDistance + centroidDistance) for any tree
     // but it works for cover trees since centroidDistance = 0 for cover trees.
-    const double candidateKernel = products(products.n_rows - 1, point) -
-        queryDescendantDistance *
-        referenceKernels[indices(indices.n_rows - 1, point)];
+    const double candidateKernel = pointKernel - queryDescendantDistance *
+        referenceKernels[CandidateHeapType::WorstNeighbor(indices, point)];
 
     if (candidateKernel > bestAdjustedPointKernel)
       bestAdjustedPointKernel = candidateKernel;
@@ -472,35 +497,23 @@ double FastMKSRules<KernelType, TreeType>::CalculateBound(TreeType& queryNode)
   return (interA > interB) ? interA : interB;
 }
 
-/**
- * Helper function to insert a point into the neighbors and distances matrices.
- *
- * @param queryIndex Index of point whose neighbors we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of reference point which is being inserted.
- * @param distance Distance from query point to reference point.
- */
 template<typename KernelType, typename TreeType>
-void FastMKSRules<KernelType, TreeType>::InsertNeighbor(const size_t queryIndex,
-                                                        const size_t pos,
-                                                        const size_t neighbor,
-                                                        const double distance)
+inline bool FastMKSRules<KernelType, TreeType>::ApproximatePrune(
+    const double maxKernel,
+    const double bestKernel)
 {
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (products.n_rows - 1))
-  {
-    int len = (products.n_rows - 1) - pos;
-    memmove(products.colptr(queryIndex) + (pos + 1),
-        products.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(indices.colptr(queryIndex) + (pos + 1),
-        indices.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
-  }
-
-  // Now put the new information in the right index.
-  products(pos, queryIndex) = distance;
-  indices(pos, queryIndex) = neighbor;
+  // There is nothing to relax until k candidates have been found.
+  if ((epsilon == 0.0) || (bestKernel == -DBL_MAX))
+    return false;
+
+  if (maxKernel > bestKernel + epsilon * std::fabs(bestKernel))
+    return false;
+
+  // Any point in the node is at most this much (relative to the kth best
+  // kernel, which only grows) better than the kth best kernel.
+  statistics.ApproximatePrune((maxKernel > bestKernel) ?
+      (maxKernel - bestKernel) / std::fabs(bestKernel) : 0.0);
+  return true;
 }
 
 }; // namespace fastmks
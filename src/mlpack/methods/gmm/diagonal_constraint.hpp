@@ -25,6 +25,9 @@ class DiagonalConstraint
     arma::vec diagonal = covariance.diag();
     covariance = arma::diagmat(diagonal);
   }
+
+  //! A diagonal covariance is already diagonal, so do nothing.
+  static void ApplyConstraint(const arma::vec& /* diagonalCovariance */) { }
 };
 
 }; // namespace gmm
@@ -69,6 +69,20 @@ class EigenvalueRatioConstraint
     covariance = eigenvectors * arma::diagmat(eigenvalues) * eigenvectors.t();
   }
 
+  /**
+   * Apply the eigenvalue ratio constraint to the given diagonal covariance.
+   * Its eigenvalues are the variances themselves, so they are changed in the
+   * same order that eig_sym() would give them, and no eigendecomposition is
+   * needed.
+   */
+  void ApplyConstraint(arma::vec& diagonalCovariance) const
+  {
+    const arma::uvec order = arma::sort_index(diagonalCovariance);
+    const double first = diagonalCovariance[order[0]];
+    for (size_t i = 0; i < order.n_elem; ++i)
+      diagonalCovariance[order[i]] = first * ratios[i];
+  }
+
  private:
   //! Ratios for eigenvalues.
   const arma::vec& ratios;
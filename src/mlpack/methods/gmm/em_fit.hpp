@@ -10,6 +10,7 @@
 #define __MLPACK_METHODS_GMM_EM_FIT_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/util/local_reducer.hpp>
 
 // Default clustering mechanism.
 #include <mlpack/methods/kmeans/kmeans.hpp>
@@ -31,9 +32,23 @@ namespace gmm {
  *
  * This method should create 'clusters' clusters, and return the assignment of
  * each point to a cluster.
+ *
+ * Both steps of each EM iteration are split across OpenMP threads (if mlpack
+ * was compiled with OpenMP): the E-step over blocks of observations, and the
+ * M-step over blocks of observations (with the sums for each component added
+ * together at the end) and then over components.  The number of threads can be
+ * set with the OMP_NUM_THREADS environment variable.
+ *
+ * The components are distribution::GaussianDistribution objects by default.
+ * If DistributionType is distribution::DiagonalGaussianDistribution, each
+ * component has a diagonal covariance, and the M-step only computes the
+ * variance of each dimension, which takes O(d) time and memory for each
+ * observation instead of O(d^2).  (The CovarianceConstraintPolicy is then
+ * applied to the vector of variances.)
  */
 template<typename InitialClusteringType = kmeans::KMeans<>,
-         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint>
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint,
+         typename DistributionType = distribution::GaussianDistribution>
 class EMFit
 {
  public:
@@ -75,7 +90,7 @@ class EMFit
    *      clustering.
    */
   void Estimate(const arma::mat& observations,
-                std::vector<distribution::GaussianDistribution>& dists,
+                std::vector<DistributionType>& dists,
                 arma::vec& weights,
                 const bool useInitialModel = false);
 
@@ -88,6 +103,13 @@ class EMFit
    * parameters is used as the initial model, instead of using the
    * InitialClusteringType::Cluster() option.
    *
+   * Each observation is weighted by its probability, in the responsibilities
+   * and in the log-likelihood, so the probabilities can also be any
+   * nonnegative weights: for instance, the counts of the unique points of a
+   * dataset with duplicates (see data::UniquePoints), which give the same
+   * model as the whole dataset would from the same initial model.  (The
+   * initial clustering does not use the probabilities.)
+   *
    * @param observations List of observations to train on.
    * @param probabilities Probability of each point being from this model.
    * @param means Vector to store trained means in.
@@ -98,8 +120,36 @@ class EMFit
    */
   void Estimate(const arma::mat& observations,
                 const arma::vec& probabilities,
-                std::vector<distribution::GaussianDistribution>& dists,
+                std::vector<DistributionType>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Fit observations which are split across several nodes to a Gaussian
+   * mixture model using the EM algorithm.  Each node calls this with its own
+   * observations.  The E-step is run on the local observations, and the
+   * sufficient statistics of the M-step (the total responsibility, the
+   * weighted sum of the observations and the weighted scatter of each
+   * component) and the log-likelihood are summed over all the nodes with the
+   * given reducer (see util::LocalReducer), so every node gets the same model
+   * as EM on all of the observations.  Unless useInitialModel is set, the
+   * initial model is found by running the clusterer on the observations of the
+   * first node only (node 0), and is then sent to the other nodes.
+   *
+   * @param observations Observations held by this node.
+   * @param dists Vector of components (with the number of components and the
+   *     dimensionality already set).
+   * @param weights Vector to store a priori weights in.
+   * @param reducer Reducer to sum over the nodes (for instance,
+   *     util::MPIReducer).
+   * @param useInitialModel If true, the given model (the same on every node) is
+   *     used for the initial clustering.
+   */
+  template<typename ReducerType>
+  void Estimate(const arma::mat& observations,
+                std::vector<DistributionType>& dists,
                 arma::vec& weights,
+                ReducerType& reducer,
                 const bool useInitialModel = false);
 
   //! Get the clusterer.
@@ -134,23 +184,127 @@ class EMFit
    * @param weights Vector to store a priori weights in.
    */
   void InitialClustering(const arma::mat& observations,
-                         std::vector<distribution::GaussianDistribution>& dists,
+                         std::vector<DistributionType>& dists,
                          arma::vec& weights);
 
   /**
-   * Calculate the log-likelihood of a model.  Yes, this is reimplemented in the
-   * GMM code.  Intuition suggests that the log-likelihood is not the best way
-   * to determine if the EM algorithm has converged.
+   * Send the model of node 0 to every node, using the reducer: node 0 gives the
+   * parameters and every other node gives zeros, so the sums are the
+   * parameters of node 0.
+   *
+   * @param dists Components (set on node 0).
+   * @param weights A priori weights (set on node 0).
+   * @param reducer Reducer to sum over the nodes.
+   */
+  template<typename ReducerType>
+  void ShareModel(std::vector<DistributionType>& dists,
+                  arma::vec& weights,
+                  ReducerType& reducer) const;
+
+  /**
+   * Set the covariance of the given component from the given values, which
+   * have the layout of the current covariance (a full matrix, or a vector of
+   * variances).
+   */
+  template<typename CovarianceType>
+  static void SetCovariance(DistributionType& dist,
+                            const CovarianceType& currentCovariance,
+                            const double* values);
+
+  /**
+   * Compute the covariance of each component from the initial clustering, once
+   * the means have been computed, and apply the constraint to it.
    *
-   * @param data Data matrix.
-   * @param means Vector of means.
-   * @param covariances Vector of covariance matrices.
-   * @param weights Vector of a priori weights.
+   * @param observations List of observations.
+   * @param assignments Cluster each observation was assigned to.
+   * @param counts Number of observations in each cluster.
+   * @param dists Components to set the covariances of.
+   */
+  void InitialCovariances(
+      const arma::mat& observations,
+      const arma::Col<size_t>& assignments,
+      const arma::vec& counts,
+      std::vector<distribution::GaussianDistribution>& dists) const;
+
+  //! Compute the initial variances of diagonal Gaussian components.
+  void InitialCovariances(
+      const arma::mat& observations,
+      const arma::Col<size_t>& assignments,
+      const arma::vec& counts,
+      std::vector<distribution::DiagonalGaussianDistribution>& dists) const;
+
+  /**
+   * Calculate the responsibility of each component for each observation (the
+   * E-step), and return the log-likelihood of the model.  The observations are
+   * split into blocks, which are divided between OpenMP threads; each thread
+   * sums the log-likelihood of its own observations.  The probabilities are
+   * normalized in the log domain, so observations far from every component
+   * don't underflow.
+   *
+   * @param observations List of observations.
+   * @param probabilities Probability of each observation being from this
+   *     model, which scales its responsibilities and its log-likelihood (or
+   *     empty, for all 1).
+   * @param dists Current components.
+   * @param weights Current a priori weights.
+   * @param condProb Matrix to store the responsibilities in (one row for each
+   *     observation and one column for each component).
+   */
+  double Expectation(const arma::mat& observations,
+                     const arma::vec& probabilities,
+                     const std::vector<DistributionType>& dists,
+                     const arma::vec& weights,
+                     arma::mat& condProb) const;
+
+  /**
+   * Update the means and covariances of the components from the
+   * responsibilities (the M-step).  Each thread sums the weighted observations
+   * and then the weighted scatter of its own blocks of observations, the sums
+   * are added together, and then the components are updated in parallel.  A
+   * component with no responsibility for any observation is not changed
+   * (except that the constraint is still applied).
+   *
+   * @param observations List of observations.
+   * @param condProb Responsibilities, as given by Expectation().
+   * @param dists Components to update.
+   * @param probRowSums Vector to store the total responsibility of each
+   *     component in.
+   * @param reducer Reducer to sum the statistics of the M-step over the nodes
+   *     with (util::LocalReducer if the observations are all here).
    */
-  double LogLikelihood(const arma::mat& data,
-                       const std::vector<distribution::GaussianDistribution>&
-                           dists,
-                       const arma::vec& weights) const;
+  template<typename ReducerType>
+  void Maximization(const arma::mat& observations,
+                    const arma::mat& condProb,
+                    std::vector<DistributionType>& dists,
+                    arma::vec& probRowSums,
+                    ReducerType& reducer) const;
+
+  /**
+   * Update the covariances of the components in the M-step, once the means have
+   * been updated, and apply the constraint to them.
+   *
+   * @param observations List of observations.
+   * @param condProb Responsibilities, as given by Expectation().
+   * @param probRowSums Total responsibility of each component.
+   * @param dists Components to update.
+   * @param reducer Reducer to sum the scatter over the nodes with.
+   */
+  template<typename ReducerType>
+  void UpdateCovariances(
+      const arma::mat& observations,
+      const arma::mat& condProb,
+      const arma::vec& probRowSums,
+      std::vector<distribution::GaussianDistribution>& dists,
+      ReducerType& reducer) const;
+
+  //! Update the variances of diagonal Gaussian components in the M-step.
+  template<typename ReducerType>
+  void UpdateCovariances(
+      const arma::mat& observations,
+      const arma::mat& condProb,
+      const arma::vec& probRowSums,
+      std::vector<distribution::DiagonalGaussianDistribution>& dists,
+      ReducerType& reducer) const;
 
   //! Maximum iterations of EM algorithm.
   size_t maxIterations;
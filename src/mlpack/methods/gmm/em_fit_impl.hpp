@@ -15,8 +15,11 @@ namespace mlpack {
 namespace gmm {
 
 //! Constructor.
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-EMFit<InitialClusteringType, CovarianceConstraintPolicy>::EMFit(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::EMFit(
     const size_t maxIterations,
     const double tolerance,
     InitialClusteringType clusterer,
@@ -27,10 +30,13 @@ EMFit<InitialClusteringType, CovarianceConstraintPolicy>::EMFit(
     constraint(constraint)
 { /* Nothing to do. */ }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Estimate(
     const arma::mat& observations,
-    std::vector<distribution::GaussianDistribution>& dists,
+    std::vector<DistributionType>& dists,
     arma::vec& weights,
     const bool useInitialModel)
 {
@@ -38,13 +44,18 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
   if (!useInitialModel)
     InitialClustering(observations, dists, weights);
 
-  double l = LogLikelihood(observations, dists, weights);
+  // The E-step gives the log-likelihood of the current model along with the
+  // conditional probabilities of each Gaussian given each observation, so each
+  // iteration's E-step also checks the convergence of the last iteration.
+  const arma::vec probabilities; // Every observation has probability 1.
+  arma::mat condProb(observations.n_cols, dists.size());
+  double l = Expectation(observations, probabilities, dists, weights,
+      condProb);
 
   Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, dists.size());
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
@@ -53,52 +64,11 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
     Log::Info << "EMFit::Estimate(): iteration " << iteration << ", "
         << "log-likelihood " << l << "." << std::endl;
 
-    // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      dists[i].Probability(observations, condProbAlias);
-      condProbAlias *= weights[i];
-    }
-
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
-    // Store the sum of the probability of each state over all the observations.
-    arma::vec probRowSums = trans(arma::sum(condProb, 0 /* columnwise */));
-
-    // Calculate the new value of the means using the updated conditional
+    // Calculate the new means and covariances using the conditional
     // probabilities.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Don't update if there's no probability of the Gaussian having points.
-      if (probRowSums[i] != 0)
-        dists[i].Mean() = (observations * condProb.col(i)) / probRowSums[i];
-
-      // Calculate the new value of the covariances using the updated
-      // conditional probabilities and the updated means.
-      arma::mat tmp = observations - (dists[i].Mean() *
-          arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i)));
-
-      // Don't update if there's no probability of the Gaussian having points.
-      if (probRowSums[i] != 0.0)
-        dists[i].Covariance() = (tmp * trans(tmpB)) / probRowSums[i];
-
-      // Apply covariance constraint.
-      constraint.ApplyConstraint(dists[i].Covariance());
-    }
+    arma::vec probRowSums;
+    util::LocalReducer reducer;
+    Maximization(observations, condProb, dists, probRowSums, reducer);
 
     // Calculate the new values for omega using the updated conditional
     // probabilities.
@@ -106,85 +76,46 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
 
     // Update values of l; calculate new log-likelihood.
     lOld = l;
-    l = LogLikelihood(observations, dists, weights);
+    l = Expectation(observations, probabilities, dists, weights, condProb);
 
     iteration++;
   }
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Estimate(
     const arma::mat& observations,
     const arma::vec& probabilities,
-    std::vector<distribution::GaussianDistribution>& dists,
+    std::vector<DistributionType>& dists,
     arma::vec& weights,
     const bool useInitialModel)
 {
   if (!useInitialModel)
     InitialClustering(observations, dists, weights);
 
-  double l = LogLikelihood(observations, dists, weights);
+  // The conditional probabilities are scaled by the probability of each point
+  // being from this mixture model.
+  arma::mat condProb(observations.n_cols, dists.size());
+  double l = Expectation(observations, probabilities, dists, weights,
+      condProb);
 
   Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, dists.size());
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
   while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
   {
-    // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      dists[i].Probability(observations, condProbAlias);
-      condProbAlias *= weights[i];
-    }
-
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
-    // This will store the sum of probabilities of each state over all the
-    // observations.
-    arma::vec probRowSums(dists.size());
-
-    // Calculate the new value of the means using the updated conditional
+    // Calculate the new means and covariances using the conditional
     // probabilities.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Calculate the sum of probabilities of points, which is the
-      // conditional probability of each point being from Gaussian i
-      // multiplied by the probability of the point being from this mixture
-      // model.
-      probRowSums[i] = accu(condProb.col(i) % probabilities);
-
-      dists[i].Mean() = (observations * (condProb.col(i) % probabilities)) /
-        probRowSums[i];
-
-      // Calculate the new value of the covariances using the updated
-      // conditional probabilities and the updated means.
-      arma::mat tmp = observations - (dists[i].Mean() *
-          arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i) % probabilities));
-
-      dists[i].Covariance() = (tmp * trans(tmpB)) / probRowSums[i];
-
-      // Apply covariance constraint.
-      constraint.ApplyConstraint(dists[i].Covariance());
-    }
+    arma::vec probRowSums;
+    util::LocalReducer reducer;
+    Maximization(observations, condProb, dists, probRowSums, reducer);
 
     // Calculate the new values for omega using the updated conditional
     // probabilities.
@@ -192,17 +123,80 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
 
     // Update values of l; calculate new log-likelihood.
     lOld = l;
-    l = LogLikelihood(observations, dists, weights);
+    l = Expectation(observations, probabilities, dists, weights, condProb);
 
     iteration++;
   }
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
-InitialClustering(const arma::mat& observations,
-                  std::vector<distribution::GaussianDistribution>& dists,
-                  arma::vec& weights)
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+template<typename ReducerType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Estimate(
+    const arma::mat& observations,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights,
+    ReducerType& reducer,
+    const bool useInitialModel)
+{
+  // The initial model of node 0 is used everywhere, so that every node starts
+  // from the same model.
+  if (!useInitialModel)
+  {
+    if (reducer.Rank() == 0)
+      InitialClustering(observations, dists, weights);
+    ShareModel(dists, weights, reducer);
+  }
+
+  double numObservations = observations.n_cols;
+  reducer.Sum(&numObservations, 1);
+
+  // The log-likelihood of the model is the sum of the log-likelihoods of the
+  // observations of each node, so every node sees the same value and stops at
+  // the same iteration.
+  const arma::vec probabilities; // Every observation has probability 1.
+  arma::mat condProb(observations.n_cols, dists.size());
+  double l = Expectation(observations, probabilities, dists, weights,
+      condProb);
+  reducer.Sum(&l, 1);
+
+  Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
+      << l << std::endl;
+
+  double lOld = -DBL_MAX;
+
+  // Iterate to update the model until no more improvement is found.
+  size_t iteration = 1;
+  while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
+  {
+    Log::Info << "EMFit::Estimate(): iteration " << iteration << ", "
+        << "log-likelihood " << l << "." << std::endl;
+
+    // The sufficient statistics are summed over all nodes in the M-step.
+    arma::vec probRowSums;
+    Maximization(observations, condProb, dists, probRowSums, reducer);
+
+    weights = probRowSums / numObservations;
+
+    // Update values of l; calculate new log-likelihood.
+    lOld = l;
+    l = Expectation(observations, probabilities, dists, weights, condProb);
+    reducer.Sum(&l, 1);
+
+    iteration++;
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::InitialClustering(
+    const arma::mat& observations,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights)
 {
   // Assignments from clustering.
   arma::Col<size_t> assignments;
@@ -210,15 +204,12 @@ InitialClustering(const arma::mat& observations,
   // Run clustering algorithm.
   clusterer.Cluster(observations, dists.size(), assignments);
 
-  // Now calculate the means, covariances, and weights.
+  // Now calculate the means and weights.
   weights.zeros();
   for (size_t i = 0; i < dists.size(); ++i)
-  {
     dists[i].Mean().zeros();
-    dists[i].Covariance().zeros();
-  }
 
-  // From the assignments, generate our means, covariances, and weights.
+  // From the assignments, generate our means and weights.
   for (size_t i = 0; i < observations.n_cols; ++i)
   {
     const size_t cluster = assignments[i];
@@ -226,67 +217,432 @@ InitialClustering(const arma::mat& observations,
     // Add this to the relevant mean.
     dists[cluster].Mean() += observations.col(i);
 
-    // Add this to the relevant covariance.
-    dists[cluster].Covariance() += observations.col(i) *
-        trans(observations.col(i));
-
     // Now add one to the weights (we will normalize).
     weights[cluster]++;
   }
 
-  // Now normalize the mean and covariance.
+  // Now normalize the mean.
   for (size_t i = 0; i < dists.size(); ++i)
   {
     dists[i].Mean() /= (weights[i] > 1) ? weights[i] : 1;
   }
 
+  // The covariances depend on the type of the distribution.
+  InitialCovariances(observations, assignments, weights, dists);
+
+  // Finally, normalize weights.
+  weights /= accu(weights);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+template<typename ReducerType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::ShareModel(
+    std::vector<DistributionType>& dists,
+    arma::vec& weights,
+    ReducerType& reducer) const
+{
+  // Each component is packed as its mean, its covariance and its weight.
+  const size_t dimensionality = dists[0].Mean().n_elem;
+  const size_t covarianceSize = dists[0].Covariance().n_elem;
+  const size_t componentSize = dimensionality + covarianceSize + 1;
+
+  arma::vec model(componentSize * dists.size());
+  model.zeros();
+  if (reducer.Rank() == 0)
+  {
+    for (size_t i = 0; i < dists.size(); ++i)
+    {
+      double* component = model.memptr() + i * componentSize;
+      std::copy(dists[i].Mean().memptr(), dists[i].Mean().memptr() +
+          dimensionality, component);
+      std::copy(dists[i].Covariance().memptr(), dists[i].Covariance().memptr()
+          + covarianceSize, component + dimensionality);
+      component[componentSize - 1] = weights[i];
+    }
+  }
+
+  reducer.Sum(model.memptr(), model.n_elem);
+
+  weights.set_size(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    const double* component = model.memptr() + i * componentSize;
+    std::copy(component, component + dimensionality,
+        dists[i].Mean().memptr());
+    SetCovariance(dists[i], dists[i].Covariance(), component + dimensionality);
+    weights[i] = component[componentSize - 1];
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+template<typename CovarianceType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::SetCovariance(
+    DistributionType& dist,
+    const CovarianceType& currentCovariance,
+    const double* values)
+{
+  CovarianceType covariance(currentCovariance);
+  std::copy(values, values + covariance.n_elem, covariance.memptr());
+  dist.Covariance(covariance);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::InitialCovariances(
+    const arma::mat& observations,
+    const arma::Col<size_t>& assignments,
+    const arma::vec& counts,
+    std::vector<distribution::GaussianDistribution>& dists) const
+{
+  // The covariances are accumulated separately, and given to the distributions
+  // when they are done.
+  std::vector<arma::mat> covariances(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+    covariances[i].zeros(observations.n_rows, observations.n_rows);
+
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    // Add this to the relevant covariance.
+    covariances[assignments[i]] += observations.col(i) *
+        trans(observations.col(i));
+  }
+
   for (size_t i = 0; i < observations.n_cols; ++i)
   {
     const size_t cluster = assignments[i];
     const arma::vec normObs = observations.col(i) - dists[cluster].Mean();
-    dists[cluster].Covariance() += normObs * normObs.t();
+    covariances[cluster] += normObs * normObs.t();
   }
 
   for (size_t i = 0; i < dists.size(); ++i)
   {
-    dists[i].Covariance() /= (weights[i] > 1) ? weights[i] : 1;
+    covariances[i] /= (counts[i] > 1) ? counts[i] : 1;
 
     // Apply constraints to covariance matrix.
-    constraint.ApplyConstraint(dists[i].Covariance());
+    constraint.ApplyConstraint(covariances[i]);
+    dists[i].Covariance(covariances[i]);
   }
-
-  // Finally, normalize weights.
-  weights /= accu(weights);
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-double EMFit<InitialClusteringType, CovarianceConstraintPolicy>::LogLikelihood(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::InitialCovariances(
     const arma::mat& observations,
-    const std::vector<distribution::GaussianDistribution>& dists,
-    const arma::vec& weights) const
+    const arma::Col<size_t>& assignments,
+    const arma::vec& counts,
+    std::vector<distribution::DiagonalGaussianDistribution>& dists) const
 {
-  double logLikelihood = 0;
+  // Only the variance of each dimension is accumulated.
+  arma::mat covariances(observations.n_rows, dists.size());
+  covariances.zeros();
+
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    // Add this to the relevant covariance.
+    covariances.col(assignments[i]) += arma::square(observations.col(i));
+  }
+
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    const size_t cluster = assignments[i];
+    covariances.col(cluster) += arma::square(observations.col(i) -
+        dists[cluster].Mean());
+  }
 
-  arma::vec phis;
-  arma::mat likelihoods(dists.size(), observations.n_cols);
-  
   for (size_t i = 0; i < dists.size(); ++i)
   {
-    dists[i].Probability(observations, phis);
-    likelihoods.row(i) = weights(i) * trans(phis);
+    arma::vec covariance = covariances.col(i) /
+        ((counts[i] > 1) ? counts[i] : 1);
+
+    // Apply constraints to the diagonal covariance.
+    constraint.ApplyConstraint(covariance);
+    dists[i].Covariance(covariance);
   }
-  // Now sum over every point.
-  for (size_t j = 0; j < observations.n_cols; ++j)
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+double EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Expectation(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    const std::vector<DistributionType>& dists,
+    const arma::vec& weights,
+    arma::mat& condProb) const
+{
+  // The log of each Gaussian's a priori weight.
+  const arma::vec logWeights = log(weights);
+
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  condProb.set_size(observations.n_cols, dists.size());
+  double logLikelihood = 0.0;
+  size_t outliers = 0;
+  #pragma omp parallel reduction(+:logLikelihood, outliers)
   {
-    if (accu(likelihoods.col(j)) == 0)
-      Log::Info << "Likelihood of point " << j << " is 0!  It is probably an "
-          << "outlier." << std::endl;
-    logLikelihood += log(accu(likelihoods.col(j)));
+    arma::vec logProbs;
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t)
+          observations.n_cols) - 1;
+
+      // Calculate the log-probability of each observation in the block under
+      // each Gaussian, weighted by the a priori weight of the Gaussian.
+      for (size_t i = 0; i < dists.size(); ++i)
+      {
+        dists[i].LogProbability(observations.cols(begin, end), logProbs);
+        condProb.submat(begin, i, end, i) = logProbs + logWeights[i];
+      }
+
+      // Normalize row-wise, with the log-sum-exp trick so that points far from
+      // every Gaussian are still assigned to the nearest ones.
+      for (size_t j = begin; j <= end; ++j)
+      {
+        // The log-likelihood of each observation is weighted by its
+        // probability too, so that it is the objective the M-step maximizes.
+        const double probability = (probabilities.n_elem > 0) ?
+            probabilities[j] : 1.0;
+        const double maxLogProb = condProb.row(j).max();
+
+        // Avoid dividing by zero; if the probability for everything is 0, we
+        // don't want to make it NaN.
+        if (maxLogProb == -std::numeric_limits<double>::infinity())
+        {
+          if (probability != 0.0)
+            logLikelihood += maxLogProb;
+          condProb.row(j).zeros();
+          ++outliers;
+          continue;
+        }
+
+        condProb.row(j) = exp(condProb.row(j) - maxLogProb);
+        const double probSum = accu(condProb.row(j));
+        logLikelihood += probability * (maxLogProb + log(probSum));
+        condProb.row(j) *= (probability / probSum);
+      }
+    }
   }
-  
+
+  if (outliers > 0)
+    Log::Info << "Likelihood of " << outliers << " points is 0!  They are "
+        << "probably outliers." << std::endl;
+
   return logLikelihood;
 }
 
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+template<typename ReducerType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Maximization(
+    const arma::mat& observations,
+    const arma::mat& condProb,
+    std::vector<DistributionType>& dists,
+    arma::vec& probRowSums,
+    ReducerType& reducer) const
+{
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  // Sum the conditional probabilities and the weighted observations for each
+  // Gaussian.  Each thread sums its own blocks, and the sums are added together
+  // at the end.
+  probRowSums.zeros(dists.size());
+  arma::mat means(observations.n_rows, dists.size());
+  means.zeros();
+  #pragma omp parallel
+  {
+    arma::vec threadProbRowSums;
+    threadProbRowSums.zeros(dists.size());
+    arma::mat threadMeans;
+    threadMeans.zeros(observations.n_rows, dists.size());
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t)
+          observations.n_cols) - 1;
+
+      threadProbRowSums += trans(arma::sum(condProb.rows(begin, end), 0));
+      threadMeans += observations.cols(begin, end) *
+          condProb.rows(begin, end);
+    }
+
+    #pragma omp critical
+    {
+      probRowSums += threadProbRowSums;
+      means += threadMeans;
+    }
+  }
+
+  // Add the sums of the other nodes, if the observations are split.
+  reducer.Sum(probRowSums.memptr(), probRowSums.n_elem);
+  reducer.Sum(means.memptr(), means.n_elem);
+
+  // Don't update if there's no probability of the Gaussian having points.
+  for (size_t i = 0; i < dists.size(); ++i)
+    if (probRowSums[i] != 0)
+      dists[i].Mean() = means.col(i) / probRowSums[i];
+
+  // The covariances depend on the type of the distribution.
+  UpdateCovariances(observations, condProb, probRowSums, dists, reducer);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+template<typename ReducerType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::UpdateCovariances(
+    const arma::mat& observations,
+    const arma::mat& condProb,
+    const arma::vec& probRowSums,
+    std::vector<distribution::GaussianDistribution>& dists,
+    ReducerType& reducer) const
+{
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  // Sum the weighted scatter of the observations around the updated means in
+  // the same way as the means.
+  arma::cube covariances(observations.n_rows, observations.n_rows,
+      dists.size());
+  covariances.zeros();
+  #pragma omp parallel
+  {
+    arma::cube threadCovariances;
+    threadCovariances.zeros(observations.n_rows, observations.n_rows,
+        dists.size());
+    arma::mat diffs;
+    arma::mat weightedDiffs;
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t)
+          observations.n_cols) - 1;
+
+      for (size_t i = 0; i < dists.size(); ++i)
+      {
+        if (probRowSums[i] == 0)
+          continue;
+
+        diffs = observations.cols(begin, end) - (dists[i].Mean() *
+            arma::ones<arma::rowvec>(end - begin + 1));
+        weightedDiffs = diffs % (arma::ones<arma::vec>(observations.n_rows) *
+            trans(condProb.submat(begin, i, end, i)));
+        threadCovariances.slice(i) += diffs * trans(weightedDiffs);
+      }
+    }
+
+    #pragma omp critical
+    {
+      covariances += threadCovariances;
+    }
+  }
+
+  reducer.Sum(covariances.memptr(), covariances.n_elem);
+
+  // Finally, update the covariances, and apply the constraint.
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    // Don't update if there's no probability of the Gaussian having points.
+    arma::mat covariance = (probRowSums[i] != 0.0) ?
+        arma::mat(covariances.slice(i) / probRowSums[i]) :
+        dists[i].Covariance();
+
+    // Apply covariance constraint.
+    constraint.ApplyConstraint(covariance);
+    dists[i].Covariance(covariance);
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+template<typename ReducerType>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::UpdateCovariances(
+    const arma::mat& observations,
+    const arma::mat& condProb,
+    const arma::vec& probRowSums,
+    std::vector<distribution::DiagonalGaussianDistribution>& dists,
+    ReducerType& reducer) const
+{
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  // Sum the weighted squared differences of the observations from the updated
+  // means, which is O(d) for each observation instead of O(d^2).  Column i
+  // holds the variances of component i.
+  arma::mat covariances(observations.n_rows, dists.size());
+  covariances.zeros();
+  #pragma omp parallel
+  {
+    arma::mat threadCovariances;
+    threadCovariances.zeros(observations.n_rows, dists.size());
+    arma::mat diffs;
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t)
+          observations.n_cols) - 1;
+
+      for (size_t i = 0; i < dists.size(); ++i)
+      {
+        if (probRowSums[i] == 0)
+          continue;
+
+        diffs = observations.cols(begin, end) - (dists[i].Mean() *
+            arma::ones<arma::rowvec>(end - begin + 1));
+        threadCovariances.col(i) += arma::square(diffs) *
+            condProb.submat(begin, i, end, i);
+      }
+    }
+
+    #pragma omp critical
+    {
+      covariances += threadCovariances;
+    }
+  }
+
+  reducer.Sum(covariances.memptr(), covariances.n_elem);
+
+  // Finally, update the covariances, and apply the constraint.
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    // Don't update if there's no probability of the Gaussian having points.
+    arma::vec covariance = (probRowSums[i] != 0.0) ?
+        arma::vec(covariances.col(i) / probRowSums[i]) :
+        dists[i].Covariance();
+
+    // Apply covariance constraint.
+    constraint.ApplyConstraint(covariance);
+    dists[i].Covariance(covariance);
+  }
+}
+
 }; // namespace gmm
 }; // namespace mlpack
 
@@ -29,12 +29,12 @@ namespace gmm /** Gaussian Mixture Models. */ {
  *
  * @code
  * void Estimate(const arma::mat& observations,
- *               std::vector<distribution::GaussianDistribution>& dists,
+ *               std::vector<DistributionType>& dists,
  *               arma::vec& weights);
  *
  * void Estimate(const arma::mat& observations,
  *               const arma::vec& probabilities,
- *               std::vector<distribution::GaussianDistribution>& dists,
+ *               std::vector<DistributionType>& dists,
  *               arma::vec& weights);
  * @endcode
  *
@@ -47,6 +47,12 @@ namespace gmm /** Gaussian Mixture Models. */ {
  * For a sample implementation, see the EMFit class; this class uses the EM
  * algorithm to train a GMM, and is the default fitting type.
  *
+ * The components of the GMM are of type DistributionType, which is
+ * distribution::GaussianDistribution by default.  For high-dimensional data,
+ * distribution::DiagonalGaussianDistribution components (with an EMFit that
+ * uses them) take O(d) storage and time instead of O(d^2); see the DiagonalGMM
+ * typedef.
+ *
  * The GMM, once trained, can be used to generate random points from the
  * distribution and estimate the probability of points being from the
  * distribution.  The parameters of the GMM can be obtained through the
@@ -69,7 +75,8 @@ namespace gmm /** Gaussian Mixture Models. */ {
  * arma::vec observation = g.Random();
  * @endcode
  */
-template<typename FittingType = EMFit<> >
+template<typename FittingType = EMFit<>,
+         typename DistributionType = distribution::GaussianDistribution>
 class GMM
 {
  private:
@@ -79,7 +86,7 @@ class GMM
   size_t dimensionality;
 
   //! Vector of Gaussians
-  std::vector<distribution::GaussianDistribution> dists;
+  std::vector<DistributionType> dists;
 
   //! Legacy member data, not used.
   std::vector<arma::vec> means;
@@ -134,7 +141,7 @@ class GMM
    * @param dists Distributions of the model.
    * @param weights Weights of the model.
    */
-  GMM(const std::vector<distribution::GaussianDistribution> & dists,
+  GMM(const std::vector<DistributionType> & dists,
       const arma::vec& weights) :
       gaussians(dists.size()),
       dimensionality((!dists.empty()) ? dists[0].Mean().n_elem : 0),
@@ -152,7 +159,7 @@ class GMM
    * @param covariances Covariances of the model.
    * @param weights Weights of the model.
    */
-  GMM(const std::vector<distribution::GaussianDistribution> & dists,
+  GMM(const std::vector<DistributionType> & dists,
       const arma::vec& weights,
       FittingType& fitter) :
       gaussians(dists.size()),
@@ -165,7 +172,7 @@ class GMM
    * Copy constructor for GMMs which use different fitting types.
    */
   template<typename OtherFittingType>
-  GMM(const GMM<OtherFittingType>& other);
+  GMM(const GMM<OtherFittingType, DistributionType>& other);
 
   /**
    * Copy constructor for GMMs using the same fitting type.  This also copies
@@ -177,7 +184,7 @@ class GMM
    * Copy operator for GMMs which use different fitting types.
    */
   template<typename OtherFittingType>
-  GMM& operator=(const GMM<OtherFittingType>& other);
+  GMM& operator=(const GMM<OtherFittingType, DistributionType>& other);
 
   /**
    * Copy operator for GMMs which use the same fitting type.  This also copies
@@ -232,14 +239,14 @@ class GMM
    *
    * @param i index of component.
    */
-  const distribution::GaussianDistribution& Component(size_t i) const {
+  const DistributionType& Component(size_t i) const {
       return dists[i]; }
   /**
    * Return a reference to a component distribution.
    *
    * @param i index of component.
    */
-  distribution::GaussianDistribution& Component(size_t i) { return dists[i]; }
+  DistributionType& Component(size_t i) { return dists[i]; }
 
   //! Functions from earlier releases give errors
   const std::vector<arma::vec>& Means() const
@@ -296,6 +303,50 @@ class GMM
   double Probability(const arma::vec& observation,
                      const size_t component) const;
 
+  /**
+   * Compute the log-probability of each of the given observations (columns),
+   * with one batch evaluation for each component.  The log-probabilities are
+   * summed in the log domain, so distant observations don't underflow.
+   *
+   * @param observations List of observations.
+   * @param logProbabilities Vector to store the log-probability of each
+   *     observation in.
+   */
+  void LogProbability(const arma::mat& observations,
+                      arma::vec& logProbabilities) const;
+
+  /**
+   * Compute the log-responsibility of each component for each of the given
+   * observations (log P(component | observation)), along with the
+   * log-probability of each observation.  The observations are split into
+   * blocks which are divided between OpenMP threads, and each block is
+   * evaluated with one batch evaluation for each component.  The outputs are
+   * only reallocated if they are not already the right size, so buffers can be
+   * reused across calls.  An observation with probability 0 under every
+   * component has log-responsibilities of -inf.
+   *
+   * @param observations List of observations.
+   * @param logResponsibilities Matrix to store the log-responsibilities in (one
+   *     row for each observation and one column for each component).
+   * @param logProbabilities Vector to store the log-probability of each
+   *     observation in.
+   */
+  void LogResponsibilities(const arma::mat& observations,
+                           arma::mat& logResponsibilities,
+                           arma::vec& logProbabilities) const;
+
+  /**
+   * Compute the log-likelihood of the given observations under this model,
+   * splitting the observations into blocks like LogResponsibilities().
+   *
+   * @param observations List of observations.
+   * @return The sum of the log-probabilities of the observations.
+   */
+  double LogLikelihood(const arma::mat& observations) const
+  {
+    return LogLikelihood(observations, dists, weights);
+  }
+
   /**
    * Return a randomly generated observation according to the probability
    * distribution defined by this object.
@@ -359,6 +410,17 @@ class GMM
                   const size_t trials = 1,
                   const bool useExistingModel = false);
 
+  /**
+   * Update the model with a mini-batch of observations, for a FittingType that
+   * can be trained online (such as OnlineEMFit).  The model can be used
+   * between updates.  The fitter keeps statistics of the model it updates, so
+   * if the model is changed in any other way (including by an Estimate() with
+   * more than one trial), reset the fitter with Fitter().Reset() first.
+   *
+   * @param observations Mini-batch of observations.
+   */
+  void Update(const arma::mat& observations);
+
   /**
    * Classify the given observations as being from an individual component in
    * this GMM.  The resultant classifications are stored in the 'labels' object,
@@ -399,9 +461,28 @@ class GMM
    * @param weights Weights of the given mixture model.
    */
   double LogLikelihood(const arma::mat& dataPoints,
-                       const std::vector<distribution::GaussianDistribution>& distsL,
+                       const std::vector<DistributionType>& distsL,
                        const arma::vec& weights) const;
 
+  //! Number of observations in each block of the batch evaluations.
+  static const size_t blockSize = 1024;
+
+  /**
+   * Compute the weighted log-probability of observations begin to end
+   * (inclusive) under each component of the given model, with one row for each
+   * observation and one column for each component.
+   */
+  static void LogComponents(const arma::mat& observations,
+                            const size_t begin,
+                            const size_t end,
+                            const std::vector<DistributionType>& distsL,
+                            const arma::vec& weightsL,
+                            arma::mat& logComponents);
+
+  //! Sum each row of the given log-probabilities in the log domain (with the
+  //! log-sum-exp trick).
+  static void LogSums(const arma::mat& logComponents, arma::vec& logSums);
+
   //! Locally-stored fitting object; in case the user did not pass one.
   FittingType localFitter;
 
@@ -409,6 +490,14 @@ class GMM
   FittingType& fitter;
 };
 
+/**
+ * A GMM whose components have diagonal covariances, trained with the EM
+ * algorithm.
+ */
+typedef GMM<EMFit<kmeans::KMeans<>, PositiveDefiniteConstraint,
+    distribution::DiagonalGaussianDistribution>,
+    distribution::DiagonalGaussianDistribution> DiagonalGMM;
+
 }; // namespace gmm
 }; // namespace mlpack
 
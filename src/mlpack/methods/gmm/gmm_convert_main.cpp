@@ -52,7 +52,9 @@ int main(int argc, char* argv[])
     string covName = "covariance" + o.str();
 
     load.LoadParameter(gmm.Component(i).Mean(), meanName);
-    load.LoadParameter(gmm.Component(i).Covariance(), covName);
+    arma::mat covariance;
+    load.LoadParameter(covariance, covName);
+    gmm.Component(i).Covariance(covariance);
   }
 
   gmm.Save(CLI::GetParam<string>("output_file"));
@@ -24,11 +24,12 @@ namespace gmm {
  * @param gaussians Number of Gaussians in this GMM.
  * @param dimensionality Dimensionality of each Gaussian.
  */
-template<typename FittingType>
-GMM<FittingType>::GMM(const size_t gaussians, const size_t dimensionality) :
+template<typename FittingType, typename DistributionType>
+GMM<FittingType, DistributionType>::GMM(const size_t gaussians,
+                                        const size_t dimensionality) :
     gaussians(gaussians),
     dimensionality(dimensionality),
-    dists(gaussians, distribution::GaussianDistribution(dimensionality)),
+    dists(gaussians, DistributionType(dimensionality)),
     weights(gaussians),
     localFitter(FittingType()),
     fitter(localFitter)
@@ -47,13 +48,13 @@ GMM<FittingType>::GMM(const size_t gaussians, const size_t dimensionality) :
  * @param dimensionality Dimensionality of each Gaussian.
  * @param fitter Initialized fitting mechanism.
  */
-template<typename FittingType>
-GMM<FittingType>::GMM(const size_t gaussians,
-                      const size_t dimensionality,
-                      FittingType& fitter) :
+template<typename FittingType, typename DistributionType>
+GMM<FittingType, DistributionType>::GMM(const size_t gaussians,
+                                        const size_t dimensionality,
+                                        FittingType& fitter) :
     gaussians(gaussians),
     dimensionality(dimensionality),
-    dists(gaussians, distribution::GaussianDistribution(dimensionality)),
+    dists(gaussians, DistributionType(dimensionality)),
     weights(gaussians),
     fitter(fitter)
 {
@@ -63,9 +64,10 @@ GMM<FittingType>::GMM(const size_t gaussians,
 
 
 // Copy constructor.
-template<typename FittingType>
+template<typename FittingType, typename DistributionType>
 template<typename OtherFittingType>
-GMM<FittingType>::GMM(const GMM<OtherFittingType>& other) :
+GMM<FittingType, DistributionType>::GMM(
+    const GMM<OtherFittingType, DistributionType>& other) :
     gaussians(other.gaussians),
     dimensionality(other.dimensionality),
     dists(other.dists),
@@ -74,8 +76,9 @@ GMM<FittingType>::GMM(const GMM<OtherFittingType>& other) :
     fitter(localFitter) { /* Nothing to do. */ }
 
 // Copy constructor for when the other GMM uses the same fitting type.
-template<typename FittingType>
-GMM<FittingType>::GMM(const GMM<FittingType>& other) :
+template<typename FittingType, typename DistributionType>
+GMM<FittingType, DistributionType>::GMM(
+    const GMM<FittingType, DistributionType>& other) :
     gaussians(other.Gaussians()),
     dimensionality(other.dimensionality),
     dists(other.dists),
@@ -83,10 +86,11 @@ GMM<FittingType>::GMM(const GMM<FittingType>& other) :
     localFitter(other.fitter),
     fitter(localFitter) { /* Nothing to do. */ }
 
-template<typename FittingType>
+template<typename FittingType, typename DistributionType>
 template<typename OtherFittingType>
-GMM<FittingType>& GMM<FittingType>::operator=(
-    const GMM<OtherFittingType>& other)
+GMM<FittingType, DistributionType>&
+GMM<FittingType, DistributionType>::operator=(
+    const GMM<OtherFittingType, DistributionType>& other)
 {
   gaussians = other.gaussians;
   dimensionality = other.dimensionality;
@@ -96,8 +100,10 @@ GMM<FittingType>& GMM<FittingType>::operator=(
   return *this;
 }
 
-template<typename FittingType>
-GMM<FittingType>& GMM<FittingType>::operator=(const GMM<FittingType>& other)
+template<typename FittingType, typename DistributionType>
+GMM<FittingType, DistributionType>&
+GMM<FittingType, DistributionType>::operator=(
+    const GMM<FittingType, DistributionType>& other)
 {
   gaussians = other.gaussians;
   dimensionality = other.dimensionality;
@@ -109,8 +115,8 @@ GMM<FittingType>& GMM<FittingType>::operator=(const GMM<FittingType>& other)
 }
 
 // Load a GMM from file.
-template<typename FittingType>
-void GMM<FittingType>::Load(const std::string& filename)
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::Load(const std::string& filename)
 {
   util::SaveRestoreUtility load;
 
@@ -120,8 +126,8 @@ void GMM<FittingType>::Load(const std::string& filename)
 }
 
 // Save a GMM to a file.
-template<typename FittingType>
-void GMM<FittingType>::Save(const std::string& filename) const
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::Save(const std::string& filename) const
 {
   util::SaveRestoreUtility save;
   Save(save);
@@ -132,8 +138,9 @@ void GMM<FittingType>::Save(const std::string& filename) const
 
 
 // Save a GMM to a SaveRestoreUtility.
-template<typename FittingType>
-void GMM<FittingType>::Save(util::SaveRestoreUtility& sr) const
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::Save(
+    util::SaveRestoreUtility& sr) const
 {
   sr.SaveParameter(Type(), "type");
   sr.SaveParameter(gaussians, "gaussians");
@@ -155,8 +162,9 @@ void GMM<FittingType>::Save(util::SaveRestoreUtility& sr) const
 }
 
 // Load a GMM from SaveRestoreUtility.
-template<typename FittingType>
-void GMM<FittingType>::Load(const util::SaveRestoreUtility& sr)
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::Load(
+    const util::SaveRestoreUtility& sr)
 {
     sr.LoadParameter(gaussians, "gaussians");
     sr.LoadParameter(dimensionality, "dimensionality");
@@ -183,8 +191,9 @@ void GMM<FittingType>::Load(const util::SaveRestoreUtility& sr)
 /**
  * Return the probability of the given observation being from this GMM.
  */
-template<typename FittingType>
-double GMM<FittingType>::Probability(const arma::vec& observation) const
+template<typename FittingType, typename DistributionType>
+double GMM<FittingType, DistributionType>::Probability(
+    const arma::vec& observation) const
 {
   // Sum the probability for each Gaussian in our mixture (and we have to
   // multiply by the prior for each Gaussian too).
@@ -199,21 +208,144 @@ double GMM<FittingType>::Probability(const arma::vec& observation) const
  * Return the probability of the given observation being from the given
  * component in the mixture.
  */
-template<typename FittingType>
-double GMM<FittingType>::Probability(const arma::vec& observation,
-                                     const size_t component) const
+template<typename FittingType, typename DistributionType>
+double GMM<FittingType, DistributionType>::Probability(
+    const arma::vec& observation,
+    const size_t component) const
 {
   // We are only considering one Gaussian component -- so we only need to call
   // Probability() once.  We do consider the prior probability!
   return weights[component] * dists[component].Probability(observation);
 }
 
+/**
+ * Compute the log-probability of each of the given observations, with one
+ * batch evaluation for each component on each block of observations.
+ */
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::LogProbability(
+    const arma::mat& observations,
+    arma::vec& logProbabilities) const
+{
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  logProbabilities.set_size(observations.n_cols);
+  #pragma omp parallel
+  {
+    arma::mat logComponents;
+    arma::vec logSums;
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t)
+          observations.n_cols) - 1;
+
+      LogComponents(observations, begin, end, dists, weights, logComponents);
+      LogSums(logComponents, logSums);
+      logProbabilities.subvec(begin, end) = logSums;
+    }
+  }
+}
+
+/**
+ * Compute the log-responsibility of each component for each observation, block
+ * by block.
+ */
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::LogResponsibilities(
+    const arma::mat& observations,
+    arma::mat& logResponsibilities,
+    arma::vec& logProbabilities) const
+{
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
+
+  logResponsibilities.set_size(observations.n_cols, gaussians);
+  logProbabilities.set_size(observations.n_cols);
+  #pragma omp parallel
+  {
+    arma::mat logComponents;
+    arma::vec logSums;
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t)
+          observations.n_cols) - 1;
+
+      LogComponents(observations, begin, end, dists, weights, logComponents);
+      LogSums(logComponents, logSums);
+      logProbabilities.subvec(begin, end) = logSums;
+
+      for (size_t i = 0; i < gaussians; ++i)
+      {
+        for (size_t j = 0; j < logSums.n_elem; ++j)
+        {
+          logResponsibilities(begin + j, i) = (logSums[j] ==
+              -std::numeric_limits<double>::infinity()) ? logSums[j] :
+              logComponents(j, i) - logSums[j];
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Compute the weighted log-probability of a block of observations under each
+ * component.
+ */
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::LogComponents(
+    const arma::mat& observations,
+    const size_t begin,
+    const size_t end,
+    const std::vector<DistributionType>& distsL,
+    const arma::vec& weightsL,
+    arma::mat& logComponents)
+{
+  logComponents.set_size(end - begin + 1, distsL.size());
+  arma::vec logPhis;
+  for (size_t i = 0; i < distsL.size(); ++i)
+  {
+    distsL[i].LogProbability(observations.cols(begin, end), logPhis);
+    logComponents.col(i) = log(weightsL[i]) + logPhis;
+  }
+}
+
+/**
+ * Sum each row of the given log-probabilities with the log-sum-exp trick.
+ */
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::LogSums(
+    const arma::mat& logComponents,
+    arma::vec& logSums)
+{
+  // Go through the columns, so the memory is accessed in order.  Rows whose
+  // maximum is -inf get NaN sums, which are replaced below.
+  const arma::vec maxLogs = arma::max(logComponents, 1);
+  arma::vec sums(logComponents.n_rows);
+  sums.zeros();
+  for (size_t i = 0; i < logComponents.n_cols; ++i)
+    sums += exp(logComponents.col(i) - maxLogs);
+
+  logSums.set_size(logComponents.n_rows);
+  for (size_t j = 0; j < logComponents.n_rows; ++j)
+  {
+    if (maxLogs[j] == -std::numeric_limits<double>::infinity())
+      logSums[j] = maxLogs[j];
+    else
+      logSums[j] = maxLogs[j] + log(sums[j]);
+  }
+}
+
 /**
  * Return a randomly generated observation according to the probability
  * distribution defined by this object.
  */
-template<typename FittingType>
-arma::vec GMM<FittingType>::Random() const
+template<typename FittingType, typename DistributionType>
+arma::vec GMM<FittingType, DistributionType>::Random() const
 {
   // Determine which Gaussian it will be coming from.
   double gaussRand = math::Random();
@@ -230,17 +362,17 @@ arma::vec GMM<FittingType>::Random() const
     }
   }
 
-  return trans(chol(dists[gaussian].Covariance())) *
-      arma::randn<arma::vec>(dimensionality) + dists[gaussian].Mean();
+  return dists[gaussian].Random();
 }
 
 /**
  * Fit the GMM to the given observations.
  */
-template<typename FittingType>
-double GMM<FittingType>::Estimate(const arma::mat& observations,
-                                  const size_t trials,
-                                  const bool useExistingModel)
+template<typename FittingType, typename DistributionType>
+double GMM<FittingType, DistributionType>::Estimate(
+    const arma::mat& observations,
+    const size_t trials,
+    const bool useExistingModel)
 {
   double bestLikelihood; // This will be reported later.
 
@@ -259,7 +391,7 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
       return -DBL_MAX; // It's what they asked for...
 
     // If each trial must start from the same initial location, we must save it.
-    std::vector<distribution::GaussianDistribution> distsOrig;
+    std::vector<DistributionType> distsOrig;
     arma::vec weightsOrig;
     if (useExistingModel)
     {
@@ -278,8 +410,8 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         << bestLikelihood << "." << std::endl;
 
     // Now the temporary model.
-    std::vector<distribution::GaussianDistribution> distsTrial(gaussians,
-        distribution::GaussianDistribution(dimensionality));
+    std::vector<DistributionType> distsTrial(gaussians,
+        DistributionType(dimensionality));
     arma::vec weightsTrial(gaussians);
 
     for (size_t trial = 1; trial < trials; ++trial)
@@ -320,11 +452,12 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
  * Fit the GMM to the given observations, each of which has a certain
  * probability of being from this distribution.
  */
-template<typename FittingType>
-double GMM<FittingType>::Estimate(const arma::mat& observations,
-                                  const arma::vec& probabilities,
-                                  const size_t trials,
-                                  const bool useExistingModel)
+template<typename FittingType, typename DistributionType>
+double GMM<FittingType, DistributionType>::Estimate(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    const size_t trials,
+    const bool useExistingModel)
 {
   double bestLikelihood; // This will be reported later.
 
@@ -343,7 +476,7 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
       return -DBL_MAX; // It's what they asked for...
 
     // If each trial must start from the same initial location, we must save it.
-    std::vector<distribution::GaussianDistribution> distsOrig;
+    std::vector<DistributionType> distsOrig;
     arma::vec weightsOrig;
     if (useExistingModel)
     {
@@ -362,8 +495,8 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         << bestLikelihood << "." << std::endl;
 
     // Now the temporary model.
-    std::vector<distribution::GaussianDistribution> distsTrial(gaussians,
-        distribution::GaussianDistribution(dimensionality));
+    std::vector<DistributionType> distsTrial(gaussians,
+        DistributionType(dimensionality));
     arma::vec weightsTrial(gaussians);
 
     for (size_t trial = 1; trial < trials; ++trial)
@@ -401,30 +534,58 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
   return bestLikelihood;
 }
 
+/**
+ * Update the GMM with a mini-batch of observations.
+ */
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::Update(const arma::mat& observations)
+{
+  fitter.Update(observations, dists, weights);
+}
+
 /**
  * Classify the given observations as being from an individual component in this
  * GMM.
  */
-template<typename FittingType>
-void GMM<FittingType>::Classify(const arma::mat& observations,
-                                arma::Col<size_t>& labels) const
+template<typename FittingType, typename DistributionType>
+void GMM<FittingType, DistributionType>::Classify(
+    const arma::mat& observations,
+    arma::Col<size_t>& labels) const
 {
-  // This is not the best way to do this!
+  const size_t numBlocks = (observations.n_cols + blockSize - 1) / blockSize;
 
-  // We should not have to fill this with values, because each one should be
-  // overwritten.
   labels.set_size(observations.n_cols);
-  for (size_t i = 0; i < observations.n_cols; ++i)
+  #pragma omp parallel
   {
-    // Find maximum probability component.
-    double probability = 0;
-    for (size_t j = 0; j < gaussians; ++j)
+    arma::mat logComponents;
+    arma::vec best;
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
     {
-      double newProb = Probability(observations.unsafe_col(i), j);
-      if (newProb >= probability)
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t)
+          observations.n_cols) - 1;
+
+      // The weighted log-probabilities, in the log domain so that distant
+      // points don't underflow.
+      LogComponents(observations, begin, end, dists, weights, logComponents);
+
+      // Find the maximum probability component of every observation.  Ties go
+      // to the last component.
+      best.set_size(end - begin + 1);
+      best.fill(-std::numeric_limits<double>::infinity());
+      labels.subvec(begin, end).zeros();
+      for (size_t j = 0; j < gaussians; ++j)
       {
-        probability = newProb;
-        labels[i] = j;
+        for (size_t i = 0; i < best.n_elem; ++i)
+        {
+          if (logComponents(i, j) >= best[i])
+          {
+            best[i] = logComponents(i, j);
+            labels[begin + i] = j;
+          }
+        }
       }
     }
   }
@@ -433,33 +594,40 @@ void GMM<FittingType>::Classify(const arma::mat& observations,
 /**
  * Get the log-likelihood of this data's fit to the model.
  */
-template<typename FittingType>
-double GMM<FittingType>::LogLikelihood(
+template<typename FittingType, typename DistributionType>
+double GMM<FittingType, DistributionType>::LogLikelihood(
     const arma::mat& data,
-    const std::vector<distribution::GaussianDistribution>& distsL,
+    const std::vector<DistributionType>& distsL,
     const arma::vec& weightsL) const
 {
-  double loglikelihood = 0;
-  arma::vec phis;
-  arma::mat likelihoods(gaussians, data.n_cols);
+  const size_t numBlocks = (data.n_cols + blockSize - 1) / blockSize;
 
-  for (size_t i = 0; i < gaussians; i++)
+  double loglikelihood = 0;
+  #pragma omp parallel reduction(+:loglikelihood)
   {
-    distsL[i].Probability(data, phis);
-    likelihoods.row(i) = weightsL(i) * trans(phis);
+    arma::mat logComponents;
+    arma::vec logSums;
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t) data.n_cols) - 1;
+
+      LogComponents(data, begin, end, distsL, weightsL, logComponents);
+      LogSums(logComponents, logSums);
+      loglikelihood += accu(logSums);
+    }
   }
 
-  // Now sum over every point.
-  for (size_t j = 0; j < data.n_cols; j++)
-    loglikelihood += log(accu(likelihoods.col(j)));
   return loglikelihood;
 }
 
 /**
 * Returns a string representation of this object.
 */
-template<typename FittingType>
-std::string GMM<FittingType>::ToString() const
+template<typename FittingType, typename DistributionType>
+std::string GMM<FittingType, DistributionType>::ToString() const
 {
   std::ostringstream convert;
   std::ostringstream data;
@@ -11,6 +11,10 @@
 
 #include <mlpack/methods/kmeans/refined_start.hpp>
 
+#ifdef HAS_MPI
+  #include <mlpack/core/util/mpi_reducer.hpp>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::gmm;
 using namespace mlpack::util;
@@ -34,7 +38,16 @@ PROGRAM_INFO("Gaussian Mixture Model (GMM) Training",
     "iteration of the EM algorithm which ensure that the covariance matrices "
     "are positive definite.  Specifying the flag can cause faster runtime, "
     "but may also cause non-positive definite covariance matrices, which will "
-    "cause the program to crash.");
+    "cause the program to crash."
+    "\n\n"
+    "If the 'distributed' flag is set, the program must be run with MPI (for "
+    "instance, with mpirun), and the dataset is split across the processes: "
+    "'%r' in --input_file is replaced with the rank of each process, so that "
+    "each process loads its own part of the dataset.  Each iteration of EM is "
+    "then run on each part, and the sums of the M-step are added over all the "
+    "processes, so the model is the same as if it were fit on the whole "
+    "dataset.  The initial model is found from the part of the first process, "
+    "only one trial is performed, and the first process saves the model.");
 
 PARAM_STRING_REQ("input_file", "File containing the data on which the model "
     "will be fit.", "i");
@@ -44,6 +57,9 @@ PARAM_STRING("output_file", "The file to write the trained GMM parameters into "
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 PARAM_INT("trials", "Number of trials to perform in training GMM.", "t", 10);
 
+PARAM_FLAG("distributed", "Fit the model with MPI, on a dataset split across "
+    "the processes ('%r' in --input_file is replaced with the rank).", "D");
+
 // Parameters for EM algorithm.
 PARAM_DOUBLE("tolerance", "Tolerance for convergence of EM.", "T", 1e-10);
 PARAM_FLAG("no_force_positive", "Do not force the covariance matrices to be "
@@ -64,19 +80,74 @@ PARAM_DOUBLE("percentage", "If using --refined_start, specify the percentage of"
     " the dataset used for each sampling (should be between 0.0 and 1.0).",
     "p", 0.02);
 
+// Fit the GMM with its fitter, either on the local dataset (with the given
+// number of trials) or on the dataset split across the MPI processes.
+template<typename GMMType, typename FittingType>
+double Estimate(GMMType& gmm,
+                FittingType& fitter,
+                const arma::mat& dataPoints,
+                const size_t trials)
+{
+  if (!CLI::HasParam("distributed"))
+    return gmm.Estimate(dataPoints, trials);
+
+#ifdef HAS_MPI
+  MPIReducer reducer;
+
+  std::vector<distribution::GaussianDistribution> dists(gmm.Gaussians(),
+      distribution::GaussianDistribution(gmm.Dimensionality()));
+  arma::vec weights(gmm.Gaussians());
+  fitter.Estimate(dataPoints, dists, weights, reducer);
+
+  for (size_t i = 0; i < dists.size(); ++i)
+    gmm.Component(i) = dists[i];
+  gmm.Weights() = weights;
+
+  // The log-likelihood of the whole dataset is the sum over the processes.
+  double likelihood = 0.0;
+  for (size_t i = 0; i < dataPoints.n_cols; ++i)
+    likelihood += log(gmm.Probability(dataPoints.col(i)));
+  reducer.Sum(&likelihood, 1);
+
+  return likelihood;
+#else
+  // This cannot happen; main() has already checked.
+  (void) fitter;
+  return -DBL_MAX;
+#endif
+}
+
 int main(int argc, char* argv[])
 {
   CLI::ParseCommandLine(argc, argv);
 
+  const bool distributed = CLI::HasParam("distributed");
+  size_t rank = 0;
+  if (distributed)
+  {
+#ifdef HAS_MPI
+    MPI_Init(&argc, &argv);
+    rank = MPIReducer().Rank();
+#else
+    Log::Fatal << "--distributed requires MPI, but mlpack was compiled "
+        << "without MPI support." << std::endl;
+#endif
+  }
+
   // Check parameters and load data.
   if (CLI::GetParam<int>("seed") != 0)
     math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
   else
     math::RandomSeed((size_t) std::time(NULL));
 
+  string inputFile = CLI::GetParam<string>("input_file");
+#ifdef HAS_MPI
+  if (distributed)
+    inputFile = RankFileName(inputFile, rank);
+#endif
+
   arma::mat dataPoints;
-  data::Load(CLI::GetParam<string>("input_file"), dataPoints,
-      true);
+  data::Load(inputFile, dataPoints, true);
 
   const int gaussians = CLI::GetParam<int>("gaussians");
   if (gaussians <= 0)
@@ -100,6 +171,14 @@ int main(int argc, char* argv[])
   const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
   const double tolerance = CLI::GetParam<double>("tolerance");
   const bool forcePositive = !CLI::HasParam("no_force_positive");
+  const size_t trials = (size_t) CLI::GetParam<int>("trials");
+  if (distributed && trials > 1)
+    Log::Warn << "Only one trial is performed with --distributed." << endl;
+
+  // With --distributed, every process has the same model, and only the first
+  // one saves it.
+  const string outputFile = (rank == 0) ? CLI::GetParam<string>("output_file") :
+      "";
 
   // This gets a bit weird because we need different types depending on whether
   // --refined_start is specified.
@@ -133,11 +212,12 @@ int main(int argc, char* argv[])
 
       // Compute the parameters of the model using the EM algorithm.
       Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
+      likelihood = Estimate(gmm, em, dataPoints, trials);
       Timer::Stop("em");
 
       // Save results.
-      gmm.Save(CLI::GetParam<string>("output_file"));
+      if (outputFile != "")
+        gmm.Save(outputFile);
     }
     else
     {
@@ -148,11 +228,12 @@ int main(int argc, char* argv[])
 
       // Compute the parameters of the model using the EM algorithm.
       Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
+      likelihood = Estimate(gmm, em, dataPoints, trials);
       Timer::Stop("em");
 
       // Save results.
-      gmm.Save(CLI::GetParam<string>("output_file"));
+      if (outputFile != "")
+        gmm.Save(outputFile);
     }
   }
   else
@@ -167,11 +248,12 @@ int main(int argc, char* argv[])
 
       // Compute the parameters of the model using the EM algorithm.
       Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
+      likelihood = Estimate(gmm, em, dataPoints, trials);
       Timer::Stop("em");
 
       // Save results.
-      gmm.Save(CLI::GetParam<string>("output_file"));
+      if (outputFile != "")
+        gmm.Save(outputFile);
     }
     else
     {
@@ -184,13 +266,19 @@ int main(int argc, char* argv[])
 
       // Compute the parameters of the model using the EM algorithm.
       Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
+      likelihood = Estimate(gmm, em, dataPoints, trials);
       Timer::Stop("em");
 
       // Save results.
-      gmm.Save(CLI::GetParam<string>("output_file"));
+      if (outputFile != "")
+        gmm.Save(outputFile);
     }
   }
 
   Log::Info << "Log-likelihood of estimate: " << likelihood << ".\n";
+
+#ifdef HAS_MPI
+  if (distributed)
+    MPI_Finalize();
+#endif
 }
@@ -22,6 +22,9 @@ class NoConstraint
  public:
   //! Do nothing, and do not modify the covariance matrix.
   static void ApplyConstraint(const arma::mat& /* covariance */) { }
+
+  //! Do nothing, and do not modify the diagonal covariance.
+  static void ApplyConstraint(const arma::vec& /* diagonalCovariance */) { }
 };
 
 }; // namespace gmm
@@ -0,0 +1,315 @@
+/**
+ * @file online_em_fit.hpp
+ *
+ * Utility class to fit a GMM with the online (stepwise) EM algorithm, which
+ * updates the model from mini-batches of observations.  Can be used as the
+ * FittingType of a GMM.
+ */
+#ifndef __MLPACK_METHODS_GMM_ONLINE_EM_FIT_HPP
+#define __MLPACK_METHODS_GMM_ONLINE_EM_FIT_HPP
+
+#include <mlpack/core.hpp>
+
+// Default clustering mechanism.
+#include <mlpack/methods/kmeans/kmeans.hpp>
+// Default covariance matrix constraint.
+#include "positive_definite_constraint.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * This class fits a GMM with the online EM algorithm (stepwise EM), so that a
+ * model can be trained from a stream of mini-batches of observations, instead
+ * of from a whole dataset that fits in memory.  Running averages of the
+ * sufficient statistics of each component (its total responsibility, the
+ * responsibility-weighted sum of the observations, and the weighted sum of
+ * their outer products) are kept; each mini-batch gives new estimates of the
+ * statistics with one E-step, and the running averages are moved toward them
+ * with the step size
+ *
+ *   eta_t = (t + t0)^(-kappa)
+ *
+ * for the t'th update, after which the weights, means, and covariances are
+ * recomputed from the averages (and the constraint is applied to the
+ * covariances).  The iteration converges when kappa is in (0.5, 1]; smaller
+ * values of kappa forget old mini-batches faster.  For more information, see
+ *
+ * @code
+ * @article{cappe2009online,
+ *     title={On-line Expectation-Maximization Algorithm for Latent Data
+ *       Models},
+ *     author={Capp{\'e}, Olivier and Moulines, Eric},
+ *     journal={Journal of the Royal Statistical Society: Series B},
+ *     volume={71},
+ *     number={3},
+ *     pages={593--613},
+ *     year={2009}
+ * }
+ * @endcode
+ *
+ * The model is complete after every update, so it can be used (for instance
+ * with GMM::Probability() or GMM::Classify()) between mini-batches:
+ *
+ * @code
+ * GMM<OnlineEMFit<> > gmm(3, data.n_rows);
+ * gmm.Estimate(firstBatch);
+ * while (NextBatch(batch))
+ * {
+ *   gmm.Update(batch);
+ *   gmm.Classify(batch, labels);
+ * }
+ * @endcode
+ *
+ * When the fitter is asked to update a model it holds no statistics for (or
+ * after Reset()), the statistics are first set from the model itself, so a
+ * model trained in any other way can also be refined online.  Estimate()
+ * clusters the observations with the InitialClusteringType (unless the given
+ * model is used), and then makes the given number of passes over the
+ * observations, in mini-batches taken in random order.
+ *
+ * @tparam InitialClusteringType Type of clustering used by Estimate().
+ * @tparam CovarianceConstraintPolicy Constraint applied to the covariances
+ *     after each update.
+ * @tparam DistributionType Type of the components; either
+ *     distribution::GaussianDistribution or
+ *     distribution::DiagonalGaussianDistribution.
+ */
+template<typename InitialClusteringType = kmeans::KMeans<>,
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint,
+         typename DistributionType = distribution::GaussianDistribution>
+class OnlineEMFit
+{
+ public:
+  /**
+   * Construct the OnlineEMFit object, optionally passing an
+   * InitialClusteringType object (just in case it needs to store state).
+   *
+   * @param batchSize Number of observations in each mini-batch of Estimate().
+   * @param passes Number of passes Estimate() makes over the observations.
+   * @param stepDecay Exponent kappa of the step sizes.
+   * @param stepOffset Offset t0 of the step sizes.
+   * @param clusterer Object which will perform the initial clustering.
+   * @param constraint Object which applies constraints to the covariances.
+   */
+  OnlineEMFit(const size_t batchSize = 1000,
+              const size_t passes = 10,
+              const double stepDecay = 0.6,
+              const double stepOffset = 1.0,
+              InitialClusteringType clusterer = InitialClusteringType(),
+              CovarianceConstraintPolicy constraint =
+                  CovarianceConstraintPolicy());
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM) with mini-batches
+   * of the online EM algorithm.  The size of the vectors (indicating the number
+   * of components) must already be set.  Optionally, if useInitialModel is set
+   * to true, then the model given in the dists and weights parameters is used
+   * as the initial model, instead of using the InitialClusteringType::Cluster()
+   * option.  Any statistics held from earlier updates are discarded.
+   *
+   * @param observations List of observations to train on.
+   * @param dists Vector of components to train.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, the given model is used for the initial
+   *      clustering.
+   */
+  void Estimate(const arma::mat& observations,
+                std::vector<DistributionType>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM), taking into account
+   * the probabilities of each point being from this mixture, which scale the
+   * responsibilities of each point in each mini-batch.
+   *
+   * @param observations List of observations to train on.
+   * @param probabilities Probability of each point being from this model.
+   * @param dists Vector of components to train.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, the given model is used for the initial
+   *      clustering.
+   */
+  void Estimate(const arma::mat& observations,
+                const arma::vec& probabilities,
+                std::vector<DistributionType>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Update the model with one mini-batch of observations: one E-step on the
+   * mini-batch, a step of the running statistics toward the statistics of the
+   * mini-batch, and an M-step from the running statistics.
+   *
+   * @param observations Mini-batch of observations.
+   * @param dists Components to update.
+   * @param weights A priori weights to update.
+   */
+  void Update(const arma::mat& observations,
+              std::vector<DistributionType>& dists,
+              arma::vec& weights);
+
+  /**
+   * Update the model with one mini-batch of observations, each with the given
+   * probability of being from this model.
+   *
+   * @param observations Mini-batch of observations.
+   * @param probabilities Probability of each observation being from this model
+   *     (or empty, for all 1).
+   * @param dists Components to update.
+   * @param weights A priori weights to update.
+   */
+  void Update(const arma::mat& observations,
+              const arma::vec& probabilities,
+              std::vector<DistributionType>& dists,
+              arma::vec& weights);
+
+  //! Forget the running statistics (and the number of updates), so that the
+  //! next update starts from the model it is given.
+  void Reset();
+
+  //! Get the number of updates since the statistics were set.
+  size_t Updates() const { return updates; }
+
+  //! Get the clusterer.
+  const InitialClusteringType& Clusterer() const { return clusterer; }
+  //! Modify the clusterer.
+  InitialClusteringType& Clusterer() { return clusterer; }
+
+  //! Get the covariance constraint policy class.
+  const CovarianceConstraintPolicy& Constraint() const { return constraint; }
+  //! Modify the covariance constraint policy class.
+  CovarianceConstraintPolicy& Constraint() { return constraint; }
+
+  //! Get the number of observations in each mini-batch of Estimate().
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of observations in each mini-batch of Estimate().
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of passes Estimate() makes over the observations.
+  size_t Passes() const { return passes; }
+  //! Modify the number of passes Estimate() makes over the observations.
+  size_t& Passes() { return passes; }
+
+  //! Get the exponent kappa of the step sizes.
+  double StepDecay() const { return stepDecay; }
+  //! Modify the exponent kappa of the step sizes.
+  double& StepDecay() { return stepDecay; }
+
+  //! Get the offset t0 of the step sizes.
+  double StepOffset() const { return stepOffset; }
+  //! Modify the offset t0 of the step sizes.
+  double& StepOffset() { return stepOffset; }
+
+ private:
+  /**
+   * Set the running statistics from the given model, as if it had been
+   * estimated from observations with exactly its parameters.
+   */
+  void SetStatistics(const std::vector<DistributionType>& dists,
+                     const arma::vec& weights);
+
+  /**
+   * Compute the statistics of the given observations, averaged over the
+   * observations, for the given responsibilities.
+   *
+   * @param observations List of observations.
+   * @param condProb Responsibilities (one row for each observation and one
+   *     column for each component).
+   * @param batchMass Vector to store the total responsibility of each component
+   *     in.
+   * @param batchSums Matrix to store the weighted sums of the observations in
+   *     (one column for each component).
+   * @param batchMoments Matrix to store the weighted second moments in (one
+   *     column for each component).
+   */
+  void Statistics(const arma::mat& observations,
+                  const arma::mat& condProb,
+                  arma::vec& batchMass,
+                  arma::mat& batchSums,
+                  arma::mat& batchMoments) const;
+
+  /**
+   * Calculate the responsibility of each component for each observation, in
+   * the log domain so that observations far from every component don't
+   * underflow, and scale them by the probabilities (if any are given).
+   */
+  void Expectation(const arma::mat& observations,
+                   const arma::vec& probabilities,
+                   const std::vector<DistributionType>& dists,
+                   const arma::vec& weights,
+                   arma::mat& condProb) const;
+
+  //! Set the weights, means, and covariances from the running statistics.  A
+  //! component with no responsibility is not changed.
+  void Maximization(std::vector<DistributionType>& dists,
+                    arma::vec& weights) const;
+
+  //! The number of values in the second moment of one component: d^2 for full
+  //! covariances.
+  static size_t MomentSize(const distribution::GaussianDistribution& dist);
+  //! The number of values in the second moment of one component: d for
+  //! diagonal covariances.
+  static size_t MomentSize(
+      const distribution::DiagonalGaussianDistribution& dist);
+
+  //! Compute the weighted sum of the outer products of the observations.
+  static void Moment(const arma::mat& observations,
+                     const arma::vec& weights,
+                     const distribution::GaussianDistribution& dist,
+                     arma::vec& moment);
+  //! Compute the weighted sum of the squares of the observations.
+  static void Moment(const arma::mat& observations,
+                     const arma::vec& weights,
+                     const distribution::DiagonalGaussianDistribution& dist,
+                     arma::vec& moment);
+
+  //! Compute the second moment of the given component, E[x x^T] flattened.
+  static void Moment(const distribution::GaussianDistribution& dist,
+                     arma::vec& moment);
+  //! Compute the second moment of the given component, E[x .* x].
+  static void Moment(const distribution::DiagonalGaussianDistribution& dist,
+                     arma::vec& moment);
+
+  //! Set the covariance of the component (whose mean is already set) from its
+  //! second moment, and apply the constraint to it.
+  void SetCovariance(const arma::vec& moment,
+                     distribution::GaussianDistribution& dist) const;
+  //! Set the variances of the component (whose mean is already set) from its
+  //! second moment, and apply the constraint to them.
+  void SetCovariance(const arma::vec& moment,
+                     distribution::DiagonalGaussianDistribution& dist) const;
+
+  //! Number of observations in each mini-batch of Estimate().
+  size_t batchSize;
+  //! Number of passes Estimate() makes over the observations.
+  size_t passes;
+  //! Exponent kappa of the step sizes.
+  double stepDecay;
+  //! Offset t0 of the step sizes.
+  double stepOffset;
+  //! Object which will perform the clustering.
+  InitialClusteringType clusterer;
+  //! Object which applies constraints to the covariance matrix.
+  CovarianceConstraintPolicy constraint;
+
+  //! Number of updates since the statistics were set.
+  size_t updates;
+  //! Running average of the responsibility of each component.
+  arma::vec mass;
+  //! Running average of the weighted observations (one column for each
+  //! component).
+  arma::mat sums;
+  //! Running average of the weighted second moments (one column for each
+  //! component).
+  arma::mat moments;
+};
+
+}; // namespace gmm
+}; // namespace mlpack
+
+// Include implementation.
+#include "online_em_fit_impl.hpp"
+
+#endif
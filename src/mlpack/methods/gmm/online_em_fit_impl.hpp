@@ -0,0 +1,393 @@
+/**
+ * @file online_em_fit_impl.hpp
+ *
+ * Implementation of the online EM algorithm for fitting GMMs.
+ */
+#ifndef __MLPACK_METHODS_GMM_ONLINE_EM_FIT_IMPL_HPP
+#define __MLPACK_METHODS_GMM_ONLINE_EM_FIT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "online_em_fit.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::OnlineEMFit(
+    const size_t batchSize,
+    const size_t passes,
+    const double stepDecay,
+    const double stepOffset,
+    InitialClusteringType clusterer,
+    CovarianceConstraintPolicy constraint) :
+    batchSize(batchSize),
+    passes(passes),
+    stepDecay(stepDecay),
+    stepOffset(stepOffset),
+    clusterer(clusterer),
+    constraint(constraint),
+    updates(0)
+{
+  if (stepDecay <= 0.5 || stepDecay > 1.0)
+    Log::Warn << "OnlineEMFit::OnlineEMFit(): step decay " << stepDecay
+        << " is not in (0.5, 1]; the online EM iteration may not converge."
+        << std::endl;
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Estimate(
+    const arma::mat& observations,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  // Every observation has probability 1.
+  Estimate(observations, arma::vec(), dists, weights, useInitialModel);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Estimate(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  if (useInitialModel)
+  {
+    SetStatistics(dists, weights);
+  }
+  else
+  {
+    // The statistics of the clusters, as if each observation had all of its
+    // responsibility in its own cluster.
+    arma::Col<size_t> assignments;
+    clusterer.Cluster(observations, dists.size(), assignments);
+
+    arma::mat condProb(observations.n_cols, dists.size());
+    condProb.zeros();
+    for (size_t i = 0; i < observations.n_cols; ++i)
+      condProb(i, assignments[i]) = (probabilities.n_elem > 0) ?
+          probabilities[i] : 1.0;
+
+    Statistics(observations, condProb, mass, sums, moments);
+    updates = 0;
+    Maximization(dists, weights);
+  }
+
+  // Now make each pass over the observations, in mini-batches.
+  const size_t size = std::max(batchSize, (size_t) 1);
+  for (size_t pass = 0; pass < passes; ++pass)
+  {
+    const arma::uvec order = arma::shuffle(arma::linspace<arma::uvec>(0,
+        observations.n_cols - 1, observations.n_cols));
+
+    for (size_t begin = 0; begin < observations.n_cols; begin += size)
+    {
+      const size_t end = std::min(begin + size, (size_t)
+          observations.n_cols) - 1;
+      const arma::uvec batch = order.subvec(begin, end);
+
+      if (probabilities.n_elem > 0)
+        Update(observations.cols(batch), probabilities.elem(batch), dists,
+            weights);
+      else
+        Update(observations.cols(batch), dists, weights);
+    }
+
+    Log::Debug << "OnlineEMFit::Estimate(): pass " << pass + 1 << " done, "
+        << updates << " updates." << std::endl;
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Update(
+    const arma::mat& observations,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights)
+{
+  Update(observations, arma::vec(), dists, weights);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Update(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    std::vector<DistributionType>& dists,
+    arma::vec& weights)
+{
+  if (observations.n_cols == 0)
+    return;
+
+  // If the statistics don't belong to a model of this shape, start from the
+  // model itself.
+  if (mass.n_elem != dists.size() || sums.n_rows != observations.n_rows)
+    SetStatistics(dists, weights);
+
+  arma::mat condProb;
+  Expectation(observations, probabilities, dists, weights, condProb);
+
+  arma::vec batchMass;
+  arma::mat batchSums, batchMoments;
+  Statistics(observations, condProb, batchMass, batchSums, batchMoments);
+
+  // Take a step of the running averages toward the mini-batch.
+  ++updates;
+  const double step = std::pow(updates + stepOffset, -stepDecay);
+  mass = (1.0 - step) * mass + step * batchMass;
+  sums = (1.0 - step) * sums + step * batchSums;
+  moments = (1.0 - step) * moments + step * batchMoments;
+
+  Maximization(dists, weights);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Reset()
+{
+  updates = 0;
+  mass.reset();
+  sums.reset();
+  moments.reset();
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::SetStatistics(
+    const std::vector<DistributionType>& dists,
+    const arma::vec& weights)
+{
+  updates = 0;
+  mass = weights;
+  sums.set_size(dists[0].Mean().n_elem, dists.size());
+  moments.set_size(MomentSize(dists[0]), dists.size());
+
+  arma::vec moment;
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    sums.col(i) = weights[i] * dists[i].Mean();
+    Moment(dists[i], moment);
+    moments.col(i) = weights[i] * moment;
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Statistics(
+    const arma::mat& observations,
+    const arma::mat& condProb,
+    arma::vec& batchMass,
+    arma::mat& batchSums,
+    arma::mat& batchMoments) const
+{
+  const double n = observations.n_cols;
+
+  batchMass = trans(arma::sum(condProb)) / n;
+  batchSums = observations * condProb / n;
+
+  const DistributionType dist(observations.n_rows);
+  batchMoments.set_size(MomentSize(dist), condProb.n_cols);
+  arma::vec moment;
+  for (size_t i = 0; i < condProb.n_cols; ++i)
+  {
+    Moment(observations, condProb.col(i), dist, moment);
+    batchMoments.col(i) = moment / n;
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Expectation(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    const std::vector<DistributionType>& dists,
+    const arma::vec& weights,
+    arma::mat& condProb) const
+{
+  // The log-probability of each observation under each component, weighted by
+  // the a priori weight of the component.
+  const arma::vec logWeights = log(weights);
+  condProb.set_size(observations.n_cols, dists.size());
+  arma::vec logProbs;
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    dists[i].LogProbability(observations, logProbs);
+    condProb.col(i) = logProbs + logWeights[i];
+  }
+
+  // Normalize row-wise, with the log-sum-exp trick.
+  for (size_t j = 0; j < observations.n_cols; ++j)
+  {
+    const double maxLogProb = condProb.row(j).max();
+
+    // An observation with probability 0 under every component gives no
+    // responsibility to any of them.
+    if (maxLogProb == -std::numeric_limits<double>::infinity())
+    {
+      condProb.row(j).zeros();
+      continue;
+    }
+
+    condProb.row(j) = exp(condProb.row(j) - maxLogProb);
+    condProb.row(j) /= accu(condProb.row(j));
+
+    if (probabilities.n_elem > 0)
+      condProb.row(j) *= probabilities[j];
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Maximization(
+    std::vector<DistributionType>& dists,
+    arma::vec& weights) const
+{
+  const double totalMass = accu(mass);
+  if (totalMass > 0.0)
+    weights = mass / totalMass;
+
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    // Don't update if there's no probability of the Gaussian having points.
+    if (mass[i] <= 0.0)
+      continue;
+
+    dists[i].Mean() = sums.col(i) / mass[i];
+    SetCovariance(moments.col(i) / mass[i], dists[i]);
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+size_t OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::MomentSize(
+    const distribution::GaussianDistribution& dist)
+{
+  return dist.Mean().n_elem * dist.Mean().n_elem;
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+size_t OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::MomentSize(
+    const distribution::DiagonalGaussianDistribution& dist)
+{
+  return dist.Mean().n_elem;
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Moment(
+    const arma::mat& observations,
+    const arma::vec& weights,
+    const distribution::GaussianDistribution& /* dist */,
+    arma::vec& moment)
+{
+  const arma::mat weighted = observations %
+      (arma::ones<arma::vec>(observations.n_rows) * trans(weights));
+  moment = vectorise(weighted * trans(observations));
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Moment(
+    const arma::mat& observations,
+    const arma::vec& weights,
+    const distribution::DiagonalGaussianDistribution& /* dist */,
+    arma::vec& moment)
+{
+  moment = arma::square(observations) * weights;
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Moment(
+    const distribution::GaussianDistribution& dist,
+    arma::vec& moment)
+{
+  moment = vectorise(dist.Covariance() + dist.Mean() * trans(dist.Mean()));
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::Moment(
+    const distribution::DiagonalGaussianDistribution& dist,
+    arma::vec& moment)
+{
+  moment = dist.Covariance() + arma::square(dist.Mean());
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::SetCovariance(
+    const arma::vec& moment,
+    distribution::GaussianDistribution& dist) const
+{
+  const size_t d = dist.Mean().n_elem;
+  arma::mat covariance = arma::reshape(moment, d, d) -
+      dist.Mean() * trans(dist.Mean());
+
+  // The subtraction can leave the matrix slightly asymmetric.
+  covariance = 0.5 * (covariance + trans(covariance));
+
+  // Apply covariance constraint.
+  constraint.ApplyConstraint(covariance);
+  dist.Covariance(covariance);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename DistributionType>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    DistributionType>::SetCovariance(
+    const arma::vec& moment,
+    distribution::DiagonalGaussianDistribution& dist) const
+{
+  arma::vec covariance = moment - arma::square(dist.Mean());
+
+  // Apply covariance constraint.
+  constraint.ApplyConstraint(covariance);
+  dist.Covariance(covariance);
+}
+
+}; // namespace gmm
+}; // namespace mlpack
+
+#endif
@@ -39,6 +39,28 @@ class PositiveDefiniteConstraint
       }
     }
   }
+
+  /**
+   * Apply the positive definiteness constraint to the given diagonal
+   * covariance, which is positive definite when every variance is positive.
+   *
+   * @param diagonalCovariance Variance of each dimension.
+   */
+  static void ApplyConstraint(arma::vec& diagonalCovariance)
+  {
+    if (diagonalCovariance.min() <= 1e-50)
+    {
+      Log::Debug << "Covariance matrix is not positive definite.  Adding "
+          << "perturbation." << std::endl;
+
+      double perturbation = 1e-30;
+      while (diagonalCovariance.min() <= 1e-50)
+      {
+        diagonalCovariance += perturbation;
+        perturbation *= 10;
+      }
+    }
+  }
 };
 
 }; // namespace gmm
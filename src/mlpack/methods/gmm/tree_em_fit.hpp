@@ -0,0 +1,238 @@
+/**
+ * @file tree_em_fit.hpp
+ *
+ * Utility class to fit a GMM using the EM algorithm, accelerated with a
+ * multi-resolution kd-tree.  Can be used as the FittingType of a GMM.
+ */
+#ifndef __MLPACK_METHODS_GMM_TREE_EM_FIT_HPP
+#define __MLPACK_METHODS_GMM_TREE_EM_FIT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/mrkd_statistic.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+// Default clustering mechanism.
+#include <mlpack/methods/kmeans/kmeans.hpp>
+// Default covariance matrix constraint.
+#include "positive_definite_constraint.hpp"
+// Exact EM is used when each observation has a probability.
+#include "em_fit.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * This class fits a GMM to observations with the EM algorithm, like EMFit, but
+ * performs the E-step with a traversal of a kd-tree built on the observations
+ * (an mrkd-tree; each node holds a tree::MRKDStatistic).  When the
+ * responsibility of every component is nearly constant over a node (it can't
+ * vary by more than tau), the node's points are summarized by their count,
+ * center of mass, and scatter, and the whole node is assigned the
+ * responsibilities at its center of mass, so it is not traversed any further.
+ * When the components are well separated, most of the tree can be pruned in
+ * this way, so each iteration can take much less time than O(n) density
+ * evaluations.  The result is an approximation to the EM iteration, which
+ * approaches the exact iteration as tau goes to 0.  For more information, see
+ *
+ * @code
+ * @inproceedings{moore1999very,
+ *     title={Very Fast EM-based Mixture Model Clustering Using Multiresolution
+ *       kd-trees},
+ *     author={Moore, Andrew W.},
+ *     booktitle={Advances in Neural Information Processing Systems 11},
+ *     pages={543--549},
+ *     year={1999}
+ * }
+ * @endcode
+ *
+ * The pruning bounds only depend on the extreme eigenvalues of each covariance,
+ * so they are tightest when the components are not very elongated, and the
+ * tree pays off most for low-dimensional data.  The components must be
+ * distribution::GaussianDistribution objects.
+ *
+ * The clustering mechanism is used in the same way as in EMFit.  This class can
+ * be used as the FittingType of a GMM:
+ *
+ * @code
+ * GMM<TreeEMFit<> > gmm(3, data.n_rows);
+ * gmm.Estimate(data);
+ * @endcode
+ */
+template<typename InitialClusteringType = kmeans::KMeans<>,
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint>
+class TreeEMFit
+{
+ public:
+  //! The type of tree used to accelerate the E-step.
+  typedef tree::BinarySpaceTree<bound::HRectBound<2, true>,
+      tree::MRKDStatistic, arma::mat> TreeType;
+
+  /**
+   * Construct the TreeEMFit object, optionally passing an InitialClusteringType
+   * object (just in case it needs to store state).  Setting the maximum number
+   * of iterations to 0 means that the EM algorithm will iterate until
+   * convergence (with the given tolerance).
+   *
+   * @param maxIterations Maximum number of iterations for EM.
+   * @param tolerance Log-likelihood tolerance required for convergence.
+   * @param tau Largest range of the responsibility of any component within a
+   *     node for the node to be pruned.
+   * @param leafSize Maximum number of points in each leaf of the tree.
+   * @param clusterer Object which will perform the initial clustering.
+   * @param constraint Object which applies constraints to the covariances.
+   */
+  TreeEMFit(const size_t maxIterations = 300,
+            const double tolerance = 1e-10,
+            const double tau = 0.01,
+            const size_t leafSize = 20,
+            InitialClusteringType clusterer = InitialClusteringType(),
+            CovarianceConstraintPolicy constraint =
+                CovarianceConstraintPolicy());
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM) using the
+   * tree-based EM algorithm.  The size of the vectors (indicating the number of
+   * components) must already be set.  Optionally, if useInitialModel is set to
+   * true, then the model given in the dists and weights parameters is used as
+   * the initial model, instead of using the InitialClusteringType::Cluster()
+   * option.
+   *
+   * @param observations List of observations to train on.
+   * @param dists Vector of components to train.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, the given model is used for the initial
+   *      clustering.
+   */
+  void Estimate(const arma::mat& observations,
+                std::vector<distribution::GaussianDistribution>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM), taking into account
+   * the probabilities of each point being from this mixture.  The probability
+   * of each point differs, so the points of a node can't be summarized, and
+   * this uses the exact EM algorithm (EMFit) instead.
+   *
+   * @param observations List of observations to train on.
+   * @param probabilities Probability of each point being from this model.
+   * @param dists Vector of components to train.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, the given model is used for the initial
+   *      clustering.
+   */
+  void Estimate(const arma::mat& observations,
+                const arma::vec& probabilities,
+                std::vector<distribution::GaussianDistribution>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  //! Get the clusterer.
+  const InitialClusteringType& Clusterer() const { return clusterer; }
+  //! Modify the clusterer.
+  InitialClusteringType& Clusterer() { return clusterer; }
+
+  //! Get the covariance constraint policy class.
+  const CovarianceConstraintPolicy& Constraint() const { return constraint; }
+  //! Modify the covariance constraint policy class.
+  CovarianceConstraintPolicy& Constraint() { return constraint; }
+
+  //! Get the maximum number of iterations of the EM algorithm.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations of the EM algorithm.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for the convergence of the EM algorithm.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for the convergence of the EM algorithm.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the largest range of responsibilities for a node to be pruned.
+  double Tau() const { return tau; }
+  //! Modify the largest range of responsibilities for a node to be pruned.
+  double& Tau() { return tau; }
+
+  //! Get the maximum number of points in each leaf of the tree.
+  size_t LeafSize() const { return leafSize; }
+  //! Modify the maximum number of points in each leaf of the tree.
+  size_t& LeafSize() { return leafSize; }
+
+  //! Get the traversal statistics of the last call to Estimate().
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+
+ private:
+  /**
+   * Run the clusterer, and then turn the cluster assignments into Gaussians.
+   * The vectors must be already set to the number of clusters.
+   *
+   * @param observations List of observations.
+   * @param dists Vector to store the components in.
+   * @param weights Vector to store a priori weights in.
+   */
+  void InitialClustering(const arma::mat& observations,
+                         std::vector<distribution::GaussianDistribution>& dists,
+                         arma::vec& weights);
+
+  /**
+   * Perform the E-step with a traversal of the tree, computing the sufficient
+   * statistics of each component, and return the (approximate) log-likelihood
+   * of the model.
+   *
+   * @param tree Tree built on the observations.
+   * @param dists Current components.
+   * @param weights Current a priori weights.
+   * @param probRowSums Vector to store the total responsibility of each
+   *     component in.
+   * @param sums Matrix to store the responsibility-weighted sum of the
+   *     observations for each component in.
+   * @param scatters Vector to store the responsibility-weighted scatter of the
+   *     observations around the mean of each component in.
+   */
+  double Expectation(TreeType& tree,
+                     const std::vector<distribution::GaussianDistribution>&
+                         dists,
+                     const arma::vec& weights,
+                     arma::vec& probRowSums,
+                     arma::mat& sums,
+                     std::vector<arma::mat>& scatters);
+
+  /**
+   * Update the components from the sufficient statistics (the M-step).  A
+   * component with no responsibility for any observation is not changed.
+   *
+   * @param probRowSums Total responsibility of each component.
+   * @param sums Responsibility-weighted sum of the observations.
+   * @param scatters Responsibility-weighted scatter of the observations.
+   * @param dists Components to update.
+   */
+  void Maximization(const arma::vec& probRowSums,
+                    const arma::mat& sums,
+                    const std::vector<arma::mat>& scatters,
+                    std::vector<distribution::GaussianDistribution>& dists)
+      const;
+
+  //! Maximum iterations of EM algorithm.
+  size_t maxIterations;
+  //! Tolerance for convergence of EM.
+  double tolerance;
+  //! Largest range of responsibilities for a node to be pruned.
+  double tau;
+  //! Maximum number of points in each leaf of the tree.
+  size_t leafSize;
+  //! Object which will perform the clustering.
+  InitialClusteringType clusterer;
+  //! Object which applies constraints to the covariance matrix.
+  CovarianceConstraintPolicy constraint;
+
+  //! The traversal statistics of the last call to Estimate().
+  tree::TraversalStatistics statistics;
+};
+
+}; // namespace gmm
+}; // namespace mlpack
+
+// Include implementation.
+#include "tree_em_fit_impl.hpp"
+
+#endif
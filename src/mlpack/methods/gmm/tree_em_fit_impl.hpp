@@ -0,0 +1,230 @@
+/**
+ * @file tree_em_fit_impl.hpp
+ *
+ * Implementation of the tree-based EM algorithm for fitting GMMs.
+ */
+#ifndef __MLPACK_METHODS_GMM_TREE_EM_FIT_IMPL_HPP
+#define __MLPACK_METHODS_GMM_TREE_EM_FIT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "tree_em_fit.hpp"
+#include "tree_em_fit_rules.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+//! Constructor.
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+TreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::TreeEMFit(
+    const size_t maxIterations,
+    const double tolerance,
+    const double tau,
+    const size_t leafSize,
+    InitialClusteringType clusterer,
+    CovarianceConstraintPolicy constraint) :
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    tau(tau),
+    leafSize(leafSize),
+    clusterer(clusterer),
+    constraint(constraint)
+{ /* Nothing to do. */ }
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void TreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+    const arma::mat& observations,
+    std::vector<distribution::GaussianDistribution>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  statistics = tree::TraversalStatistics();
+
+  // Only perform initial clustering if the user wanted it.
+  if (!useInitialModel)
+    InitialClustering(observations, dists, weights);
+
+  // The tree rearranges the dataset, so build it on a copy.  We don't need any
+  // mappings, since the sufficient statistics don't depend on the order of the
+  // points.
+  Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
+  arma::mat dataset(observations);
+  TreeType tree(dataset, leafSize);
+  statistics.StopPhase("tree_building");
+  Timer::Stop("tree_building");
+
+  // As in EMFit, each iteration's E-step also checks the convergence of the
+  // last iteration.
+  arma::vec probRowSums;
+  arma::mat sums;
+  std::vector<arma::mat> scatters;
+  double l = Expectation(tree, dists, weights, probRowSums, sums, scatters);
+
+  Log::Debug << "TreeEMFit::Estimate(): initial clustering log-likelihood: "
+      << l << std::endl;
+
+  double lOld = -DBL_MAX;
+
+  // Iterate to update the model until no more improvement is found.
+  size_t iteration = 1;
+  while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
+  {
+    Log::Info << "TreeEMFit::Estimate(): iteration " << iteration << ", "
+        << "log-likelihood " << l << "." << std::endl;
+
+    // Calculate the new means and covariances from the sufficient statistics.
+    Maximization(probRowSums, sums, scatters, dists);
+
+    // Calculate the new values for omega.
+    weights = probRowSums / observations.n_cols;
+
+    // Update values of l; calculate new log-likelihood.
+    lOld = l;
+    l = Expectation(tree, dists, weights, probRowSums, sums, scatters);
+
+    iteration++;
+  }
+
+  Log::Info << "TreeEMFit::Estimate(): " << statistics.BaseCases() << " base "
+      << "cases and " << statistics.Prunes() << " prunes in " << iteration
+      << " iterations." << std::endl;
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void TreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    std::vector<distribution::GaussianDistribution>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  // The points in a node have different probabilities, so we can't use the
+  // tree.
+  EMFit<InitialClusteringType, CovarianceConstraintPolicy> fitter(
+      maxIterations, tolerance, clusterer, constraint);
+  fitter.Estimate(observations, probabilities, dists, weights,
+      useInitialModel);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void TreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+    InitialClustering(const arma::mat& observations,
+                      std::vector<distribution::GaussianDistribution>& dists,
+                      arma::vec& weights)
+{
+  // Assignments from clustering.
+  arma::Col<size_t> assignments;
+
+  // Run clustering algorithm.
+  clusterer.Cluster(observations, dists.size(), assignments);
+
+  // Now calculate the means and weights.
+  weights.zeros(dists.size());
+  arma::mat means(observations.n_rows, dists.size());
+  means.zeros();
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    means.col(assignments[i]) += observations.col(i);
+    weights[assignments[i]]++;
+  }
+
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    dists[i].Mean() = means.col(i) / ((weights[i] > 1) ? weights[i] : 1);
+  }
+
+  // Now the covariances, around the means.
+  std::vector<arma::mat> covariances(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+    covariances[i].zeros(observations.n_rows, observations.n_rows);
+
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    const size_t cluster = assignments[i];
+    const arma::vec normObs = observations.col(i) - dists[cluster].Mean();
+    covariances[cluster] += normObs * normObs.t();
+  }
+
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    covariances[i] /= (weights[i] > 1) ? weights[i] : 1;
+
+    // Apply constraints to covariance matrix.
+    constraint.ApplyConstraint(covariances[i]);
+    dists[i].Covariance(covariances[i]);
+  }
+
+  // Finally, normalize weights.
+  weights /= accu(weights);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+double TreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+    Expectation(TreeType& tree,
+                const std::vector<distribution::GaussianDistribution>& dists,
+                const arma::vec& weights,
+                arma::vec& probRowSums,
+                arma::mat& sums,
+                std::vector<arma::mat>& scatters)
+{
+  const size_t dimensionality = tree.Dataset().n_rows;
+
+  probRowSums.zeros(dists.size());
+  sums.zeros(dimensionality, dists.size());
+  scatters.resize(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+    scatters[i].zeros(dimensionality, dimensionality);
+  double logLikelihood = 0.0;
+
+  // Create rules object.
+  typedef TreeEMFitRules<TreeType> RulesType;
+  RulesType rules(tree.Dataset(), dists, weights, tau, probRowSums, sums,
+      scatters, logLikelihood);
+
+  // Use single-tree traverser, with a fake query index (since the query index
+  // is irrelevant; we are checking each node with all components).
+  typename TreeType::template SingleTreeTraverser<RulesType> traverser(rules);
+
+  statistics.StartPhase("traversal");
+  traverser.Traverse(0, tree);
+  statistics.StopPhase("traversal");
+
+  statistics += rules.Statistics();
+
+  if (rules.Outliers() > 0)
+    Log::Info << "Likelihood of " << rules.Outliers() << " points is 0!  They "
+        << "are probably outliers." << std::endl;
+
+  return logLikelihood;
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void TreeEMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+    Maximization(const arma::vec& probRowSums,
+                 const arma::mat& sums,
+                 const std::vector<arma::mat>& scatters,
+                 std::vector<distribution::GaussianDistribution>& dists) const
+{
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    // Don't update if there's no probability of the Gaussian having points.
+    if (probRowSums[i] == 0)
+      continue;
+
+    // The scatters are around the old means, so move them to the new means.
+    const arma::vec mean = sums.col(i) / probRowSums[i];
+    const arma::vec shift = mean - dists[i].Mean();
+    arma::mat covariance = scatters[i] / probRowSums[i] - shift * trans(shift);
+
+    // Apply constraints to covariance matrix.
+    constraint.ApplyConstraint(covariance);
+
+    dists[i].Mean() = mean;
+    dists[i].Covariance(covariance);
+  }
+}
+
+}; // namespace gmm
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @file tree_em_fit_rules.hpp
+ *
+ * Defines the pruning rules and base cases necessary to perform the E-step of
+ * the EM algorithm for GMMs with a multi-resolution kd-tree (mrkd-tree), as
+ * described by Moore in "Very Fast EM-based Mixture Model Clustering Using
+ * Multiresolution kd-trees" (NIPS 1998).
+ */
+#ifndef __MLPACK_METHODS_GMM_TREE_EM_FIT_RULES_HPP
+#define __MLPACK_METHODS_GMM_TREE_EM_FIT_RULES_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * The rules class for the single-tree traversal that performs the E-step of
+ * tree-based EM.  Like PellegMooreKMeansRules, it considers every component at
+ * once, so the query index is ignored.  The tree must have hyperrectangle
+ * bounds and tree::MRKDStatistic statistics.
+ *
+ * For each node, the minimum and maximum distances from the node's bound to
+ * each component's mean give (with the extreme eigenvalues of the component's
+ * covariance) bounds on the density of each component anywhere in the node, and
+ * from them, bounds on the responsibility of each component for any point in
+ * the node.  If no responsibility can vary by more than tau within the node,
+ * every point in the node is given the responsibilities at the node's center of
+ * mass, and the node's count, center of mass, and scatter are added to the
+ * sufficient statistics of each component, so the node is pruned.  Otherwise,
+ * the traversal continues, and the points of leaves are handled exactly in
+ * BaseCase().
+ *
+ * The sufficient statistics are the total responsibility of each component, the
+ * responsibility-weighted sum of the points, and the responsibility-weighted
+ * scatter of the points around the current mean of each component.
+ */
+template<typename TreeType>
+class TreeEMFitRules
+{
+ public:
+  /**
+   * Create the TreeEMFitRules object.  The sufficient statistics and the
+   * log-likelihood are added to, so they should be zero before the traversal.
+   *
+   * @param dataset The dataset that the tree is built on.
+   * @param dists Current components.
+   * @param weights Current a priori weights.
+   * @param tau Largest range of responsibilities within a node for the node to
+   *     be pruned.
+   * @param probRowSums Total responsibility of each component (output).
+   * @param sums Responsibility-weighted sum of the points, for each component
+   *     (output, one column for each component).
+   * @param scatters Responsibility-weighted scatter of the points around the
+   *     current mean of each component (output).
+   * @param logLikelihood Log-likelihood of the dataset (output).
+   */
+  TreeEMFitRules(const typename TreeType::Mat& dataset,
+                 const std::vector<distribution::GaussianDistribution>& dists,
+                 const arma::vec& weights,
+                 const double tau,
+                 arma::vec& probRowSums,
+                 arma::mat& sums,
+                 std::vector<arma::mat>& scatters,
+                 double& logLikelihood);
+
+  /**
+   * Add the responsibilities of each component for the given point to the
+   * sufficient statistics.
+   *
+   * @param queryIndex Index of query point (fake, will be ignored).
+   * @param referenceIndex Index of reference point.
+   */
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  /**
+   * Determine if the responsibilities of every component are nearly constant
+   * in the node, and if so, add the whole node to the sufficient statistics and
+   * prune it.
+   *
+   * @param queryIndex Index of query point (fake, will be ignored).
+   * @param referenceNode Node containing points in the dataset.
+   */
+  double Score(const size_t queryIndex, TreeType& referenceNode);
+
+  /**
+   * Rescore to determine if a node can be pruned.  In this case, a node can
+   * never be pruned during rescoring, so this just returns oldScore.
+   *
+   * @param queryIndex Index of query point (fake, will be ignored).
+   * @param referenceNode Node containing points in the dataset.
+   * @param oldScore Resulting score from Score().
+   */
+  double Rescore(const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore);
+
+  //! Get the number of points whose likelihood is 0.
+  size_t Outliers() const { return outliers; }
+
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+ private:
+  /**
+   * Add the given number of points, with the given center of mass and scatter,
+   * to the sufficient statistics, with the responsibilities given by the
+   * (weighted) log-densities of each component at the center of mass.
+   */
+  void Accumulate(const double count,
+                  const arma::vec& centerOfMass,
+                  const arma::mat* scatter);
+
+  //! The dataset.
+  const typename TreeType::Mat& dataset;
+  //! The components.
+  const std::vector<distribution::GaussianDistribution>& dists;
+  //! The log of the a priori weight of each component.
+  arma::vec logWeights;
+  //! The log of the largest value of the weighted density of each component.
+  arma::vec logNormalizers;
+  //! The inverse of the largest eigenvalue of each covariance.
+  arma::vec invMaxEigenvalues;
+  //! The inverse of the smallest eigenvalue of each covariance.
+  arma::vec invMinEigenvalues;
+  //! Largest range of responsibilities for a node to be pruned.
+  double tau;
+
+  //! Total responsibility of each component.
+  arma::vec& probRowSums;
+  //! Responsibility-weighted sum of the points for each component.
+  arma::mat& sums;
+  //! Responsibility-weighted scatter around the mean of each component.
+  std::vector<arma::mat>& scatters;
+  //! Log-likelihood of the points seen so far.
+  double& logLikelihood;
+
+  //! The number of points whose likelihood is 0.
+  size_t outliers;
+
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
+};
+
+}; // namespace gmm
+}; // namespace mlpack
+
+// Include implementation.
+#include "tree_em_fit_rules_impl.hpp"
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * @file tree_em_fit_rules_impl.hpp
+ *
+ * Implementation of the pruning rules and base cases necessary to perform the
+ * E-step of the EM algorithm for GMMs with a multi-resolution kd-tree.
+ */
+#ifndef __MLPACK_METHODS_GMM_TREE_EM_FIT_RULES_IMPL_HPP
+#define __MLPACK_METHODS_GMM_TREE_EM_FIT_RULES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "tree_em_fit_rules.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+template<typename TreeType>
+TreeEMFitRules<TreeType>::TreeEMFitRules(
+    const typename TreeType::Mat& dataset,
+    const std::vector<distribution::GaussianDistribution>& dists,
+    const arma::vec& weights,
+    const double tau,
+    arma::vec& probRowSums,
+    arma::mat& sums,
+    std::vector<arma::mat>& scatters,
+    double& logLikelihood) :
+    dataset(dataset),
+    dists(dists),
+    logWeights(log(weights)),
+    logNormalizers(dists.size()),
+    invMaxEigenvalues(dists.size()),
+    invMinEigenvalues(dists.size()),
+    tau(tau),
+    probRowSums(probRowSums),
+    sums(sums),
+    scatters(scatters),
+    logLikelihood(logLikelihood),
+    outliers(0)
+{
+  // The Mahalanobis distance from a mean to any point at Euclidean distance r
+  // from it is between r^2 / lambda_max and r^2 / lambda_min, where lambda_max
+  // and lambda_min are the extreme eigenvalues of the covariance.
+  arma::vec eigenvalues;
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    logNormalizers[i] = logWeights[i] - 0.5 * (dataset.n_rows *
+        log(2 * M_PI) + dists[i].LogDetCovariance());
+
+    arma::eig_sym(eigenvalues, dists[i].Covariance());
+    invMaxEigenvalues[i] = (eigenvalues.max() > 0) ? 1.0 / eigenvalues.max() :
+        0.0;
+    invMinEigenvalues[i] = (eigenvalues.min() > 0) ? 1.0 / eigenvalues.min() :
+        DBL_MAX;
+  }
+}
+
+template<typename TreeType>
+inline force_inline
+double TreeEMFitRules<TreeType>::BaseCase(
+    const size_t /* queryIndex */,
+    const size_t referenceIndex)
+{
+  ++statistics.BaseCases();
+  Accumulate(1.0, dataset.col(referenceIndex), NULL);
+  return 0.0;
+}
+
+template<typename TreeType>
+double TreeEMFitRules<TreeType>::Score(
+    const size_t /* queryIndex */,
+    TreeType& referenceNode)
+{
+  // Bound the log of the weighted density of each component anywhere in the
+  // node.
+  arma::vec upper(dists.size());
+  arma::vec lower(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    const double minDistance = referenceNode.MinDistance(dists[i].Mean());
+    const double maxDistance = referenceNode.MaxDistance(dists[i].Mean());
+
+    upper[i] = logNormalizers[i] - 0.5 * minDistance * minDistance *
+        invMaxEigenvalues[i];
+    lower[i] = logNormalizers[i] - 0.5 * maxDistance * maxDistance *
+        invMinEigenvalues[i];
+  }
+
+  // If every component has zero density, we can't say anything about the node.
+  const double maxUpper = upper.max();
+  if (maxUpper == -std::numeric_limits<double>::infinity())
+    return statistics.Score(0.0, referenceNode);
+
+  // Bound the responsibility of each component for any point in the node.  The
+  // densities are scaled by the largest upper bound, so they don't all
+  // underflow.
+  const arma::vec upperDensities = exp(upper - maxUpper);
+  const arma::vec lowerDensities = exp(lower - maxUpper);
+  const double upperSum = accu(upperDensities);
+  const double lowerSum = accu(lowerDensities);
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    // The responsibility is largest if this component's density is as large as
+    // possible and every other is as small as possible, and vice versa.
+    const double maxDenominator = upperDensities[i] + (lowerSum -
+        lowerDensities[i]);
+    const double minDenominator = lowerDensities[i] + (upperSum -
+        upperDensities[i]);
+
+    const double maxResponsibility = (maxDenominator > 0) ?
+        std::min(upperDensities[i] / maxDenominator, 1.0) : 1.0;
+    const double minResponsibility = (minDenominator > 0) ?
+        lowerDensities[i] / minDenominator : 0.0;
+
+    if (maxResponsibility - minResponsibility >= tau)
+      return statistics.Score(0.0, referenceNode);
+  }
+
+  // Every responsibility is nearly constant in the node, so the
+  // responsibilities at the center of mass are used for every point in it.
+  Accumulate((double) referenceNode.Stat().Count(),
+      referenceNode.Stat().CenterOfMass(), &referenceNode.Stat().Scatter());
+
+  return statistics.Score(DBL_MAX, referenceNode);
+}
+
+template<typename TreeType>
+inline double TreeEMFitRules<TreeType>::Rescore(
+    const size_t /* queryIndex */,
+    TreeType& /* referenceNode */,
+    const double oldScore)
+{
+  // There's no possible way that calling Rescore() can produce a prune now.
+  return oldScore;
+}
+
+template<typename TreeType>
+void TreeEMFitRules<TreeType>::Accumulate(const double count,
+                                          const arma::vec& centerOfMass,
+                                          const arma::mat* scatter)
+{
+  arma::vec logProbs(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+    logProbs[i] = logWeights[i] + dists[i].LogProbability(centerOfMass);
+
+  // Normalize with the log-sum-exp trick, as in EMFit::Expectation(); if the
+  // likelihood is 0, these points are probably outliers.
+  const double maxLogProb = logProbs.max();
+  if (maxLogProb == -std::numeric_limits<double>::infinity())
+  {
+    logLikelihood += maxLogProb;
+    outliers += (size_t) count;
+    return;
+  }
+
+  arma::vec responsibilities = exp(logProbs - maxLogProb);
+  const double probSum = accu(responsibilities);
+  logLikelihood += count * (maxLogProb + log(probSum));
+  responsibilities /= probSum;
+
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    if (responsibilities[i] == 0)
+      continue;
+
+    // The scatter of the points around the mean of the component is their
+    // scatter around their center of mass, plus the scatter of the center of
+    // mass around the mean.
+    const arma::vec diff = centerOfMass - dists[i].Mean();
+    probRowSums[i] += count * responsibilities[i];
+    sums.col(i) += (count * responsibilities[i]) * centerOfMass;
+    scatters[i] += (count * responsibilities[i]) * (diff * trans(diff));
+    if (scatter != NULL)
+      scatters[i] += responsibilities[i] * (*scatter);
+  }
+}
+
+}; // namespace gmm
+}; // namespace mlpack
+
+#endif
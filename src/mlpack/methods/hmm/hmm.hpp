@@ -73,9 +73,36 @@ namespace hmm /** Hidden Markov Models. */ {
  * (with Predict()), generate a sequence (with Generate()), or estimate the
  * probabilities of each state for a sequence of observations (with Estimate()).
  *
+ * The transition matrix is dense (arma::mat) by default.  For HMMs with many
+ * states, most of which can only transition to a few others (such as
+ * left-to-right HMMs), it can be an arma::sp_mat instead; then the forward
+ * algorithm, the backward algorithm, and the Viterbi algorithm take time
+ * linear in the number of nonzero transitions for each observation, instead of
+ * quadratic in the number of states.  Baum-Welch training (Train() with
+ * unlabeled data) never makes a zero transition probability nonzero, so the
+ * sparsity pattern of the transition matrix should be set before training.
+ *
+ * @code
+ * // A left-to-right HMM, where each state can only stay the same or move to
+ * // the next state.
+ * arma::sp_mat transition(states, states);
+ * for (size_t i = 0; i < states - 1; ++i)
+ * {
+ *   transition(i, i) = 0.5;
+ *   transition(i + 1, i) = 0.5;
+ * }
+ * transition(states - 1, states - 1) = 1.0;
+ *
+ * HMM<GaussianDistribution, arma::sp_mat> hmm(initial, transition, emissions);
+ * hmm.Train(observations);
+ * @endcode
+ *
  * @tparam Distribution Type of emission distribution for this HMM.
+ * @tparam TransitionMatType Type of the transition matrix (arma::mat or
+ *     arma::sp_mat).
  */
-template<typename Distribution = distribution::DiscreteDistribution>
+template<typename Distribution = distribution::DiscreteDistribution,
+         typename TransitionMatType = arma::mat>
 class HMM
 {
  public:
@@ -128,7 +155,7 @@ class HMM
    *      (Baum-Welch).
    */
   HMM(const arma::vec& initial,
-      const arma::mat& transition,
+      const TransitionMatType& transition,
       const std::vector<Distribution>& emission,
       const double tolerance = 1e-5);
 
@@ -158,6 +185,12 @@ class HMM
    * for training.
    * @endnote
    *
+   * If mlpack was compiled with OpenMP, the forward-backward pass over the
+   * sequences in each iteration is split across threads (the number of threads
+   * can be set with the OMP_NUM_THREADS environment variable).  The sequences
+   * are divided into fixed chunks whose sums are added together in order, so
+   * the trained model does not depend on the number of threads.
+   *
    * @param dataSeq Vector of observation sequences.
    */
   void Train(const std::vector<arma::mat>& dataSeq);
@@ -240,6 +273,25 @@ class HMM
                 arma::Col<size_t>& stateSequence,
                 const size_t startState = 0) const;
 
+  /**
+   * Generate one random data sequence for each of the given lengths, all
+   * starting in the same hidden state.  The hidden states are sampled in
+   * parallel (if mlpack was compiled with OpenMP), each sequence with its own
+   * random number generator, seeded from the mlpack generator, so the results
+   * depend only on the mlpack seed and not on the number of threads.  The
+   * emission distributions draw from the mlpack generator, so the observations
+   * are then sampled one sequence at a time.
+   *
+   * @param lengths Lengths of the random sequences to generate.
+   * @param dataSequences Vector to store the data sequences in.
+   * @param stateSequences Vector to store the state sequences in.
+   * @param startState Hidden state to start each sequence in (default 0).
+   */
+  void Generate(const std::vector<size_t>& lengths,
+                std::vector<arma::mat>& dataSequences,
+                std::vector<arma::Col<size_t> >& stateSequences,
+                const size_t startState = 0) const;
+
   /**
    * Compute the most probable hidden state sequence for the given data
    * sequence, using the Viterbi algorithm, returning the log-likelihood of the
@@ -253,6 +305,23 @@ class HMM
   double Predict(const arma::mat& dataSeq,
                  arma::Col<size_t>& stateSeq) const;
 
+  /**
+   * Compute the most probable hidden state sequence for each of the given data
+   * sequences, using the Viterbi algorithm.  The sequences are divided between
+   * OpenMP threads (if mlpack was compiled with OpenMP), and each thread reuses
+   * its own workspace for all of its sequences, so this is much faster than
+   * calling Predict() for each sequence when there are many short sequences.
+   *
+   * @param dataSeqs Sequences of observations.
+   * @param stateSeqs Vector in which the most probable state sequence of each
+   *    data sequence will be stored.
+   * @param logLikelihoods Vector in which the log-likelihood of the most
+   *    probable state sequence of each data sequence will be stored.
+   */
+  void Predict(const std::vector<arma::mat>& dataSeqs,
+               std::vector<arma::Col<size_t> >& stateSeqs,
+               arma::vec& logLikelihoods) const;
+
   /**
    * Compute the log-likelihood of the given data sequence.
    *
@@ -261,6 +330,48 @@ class HMM
    */
   double LogLikelihood(const arma::mat& dataSeq) const;
 
+  /**
+   * Compute the log-likelihood of each of the given data sequences.  As with
+   * the batch Predict(), the sequences are divided between OpenMP threads, and
+   * each thread reuses its own workspace.
+   *
+   * @param dataSeqs Data sequences to evaluate the likelihood of.
+   * @param logLikelihoods Vector in which the log-likelihood of each sequence
+   *    will be stored.
+   */
+  void LogLikelihood(const std::vector<arma::mat>& dataSeqs,
+                     arma::vec& logLikelihoods) const;
+
+  /**
+   * Online HMM filtering.  Given the probabilities of each hidden state
+   * conditioned on the observations so far, P(X[t - 1] | Y[0], ..., Y[t - 1]),
+   * update them with the next observation to P(X[t] | Y[0], ..., Y[t]).  If
+   * stateProb is empty, the observation is taken to be the first of the
+   * sequence, so the initial state probabilities are used.  Each step takes
+   * O(N^2) time for N hidden states, and once stateProb and workspace have been
+   * sized by the first step, nothing is reallocated.  The state probabilities
+   * after each step are the same as the columns of the forward probabilities
+   * computed for the whole sequence by Estimate().
+   *
+   * @code
+   * arma::vec stateProb, workspace;
+   * double logLikelihood = 0.0;
+   * for (size_t t = 0; t < dataSeq.n_cols; ++t)
+   *   logLikelihood += hmm.FilterStep(dataSeq.unsafe_col(t), stateProb,
+   *       workspace);
+   * @endcode
+   *
+   * @param observation Next observation.
+   * @param stateProb Probability of each hidden state given the previous
+   *    observations (or empty), which will be updated with the observation.
+   * @param workspace Vector used for the predicted state probabilities; it
+   *    should be kept between steps so that it is not reallocated.
+   * @return Log-likelihood of the observation given the previous ones.
+   */
+  double FilterStep(const arma::vec& observation,
+                    arma::vec& stateProb,
+                    arma::vec& workspace) const;
+
   /**
    * HMM filtering. Computes the k-step-ahead expected emission at each time
    * conditioned only on prior observations. That is
@@ -297,9 +408,9 @@ class HMM
   arma::vec& Initial() { return initial; }
 
   //! Return the transition matrix.
-  const arma::mat& Transition() const { return transition; }
+  const TransitionMatType& Transition() const { return transition; }
   //! Return a modifiable transition matrix reference.
-  arma::mat& Transition() { return transition; }
+  TransitionMatType& Transition() { return transition; }
 
   //! Return the emission distributions.
   const std::vector<Distribution>& Emission() const { return emission; }
@@ -362,11 +473,152 @@ class HMM
                 const arma::vec& scales,
                 arma::mat& backwardProb) const;
 
+  /**
+   * Compute the log-probability of each observation in the given data sequence
+   * under the emission distribution of each state.  The returned matrix has
+   * rows equal to the number of hidden states and columns equal to the number
+   * of observations.  Distributions with a batch LogProbability() (such as
+   * GaussianDistribution and GMM) are called once per state; the covariance
+   * work is then shared by the whole sequence.
+   *
+   * @param dataSeq Data sequence to compute log-probabilities for.
+   * @param logEmissions Matrix in which the log-probabilities will be saved.
+   */
+  void EmissionLogProbabilities(const arma::mat& dataSeq,
+                                arma::mat& logEmissions) const;
+
+  /**
+   * The Forward algorithm, using the emission probabilities (not their logs)
+   * of each state for each observation, as given by exp() of
+   * EmissionLogProbabilities().
+   *
+   * @param emissionProb Emission probabilities of each state for each
+   *    observation.
+   * @param scales Vector in which scaling factors will be saved.
+   * @param forwardProb Matrix in which forward probabilities will be saved.
+   */
+  void ForwardEmissions(const arma::mat& emissionProb,
+                        arma::vec& scales,
+                        arma::mat& forwardProb) const;
+
+  /**
+   * The Backward algorithm, using the emission probabilities of each state for
+   * each observation and the scaling factors found by ForwardEmissions().
+   *
+   * @param emissionProb Emission probabilities of each state for each
+   *    observation.
+   * @param scales Vector of scaling factors.
+   * @param backwardProb Matrix in which backward probabilities will be saved.
+   */
+  void BackwardEmissions(const arma::mat& emissionProb,
+                         const arma::vec& scales,
+                         arma::mat& backwardProb) const;
+
+  /**
+   * The Viterbi algorithm, using the given workspaces, which are only
+   * reallocated if they are too small.  This is used by both overloads of
+   * Predict().
+   *
+   * @param dataSeq Sequence of observations.
+   * @param colPtrs Start of the nonzero transitions from each state (as given
+   *    by GetTransitions()).
+   * @param rowIndices State that each nonzero transition is to.
+   * @param logProbabilities Log-probability of each nonzero transition.
+   * @param stateSeq Vector in which the most probable state sequence will be
+   *    stored.
+   * @param logStateProb Workspace for the log-probability of the most probable
+   *    path to each state at each time step.
+   * @param stateSeqBack Workspace for the previous state of the most probable
+   *    path to each state at each time step.
+   * @return Log-likelihood of most probable state sequence.
+   */
+  double Viterbi(const arma::mat& dataSeq,
+                 const arma::uvec& colPtrs,
+                 const arma::uvec& rowIndices,
+                 const arma::vec& logProbabilities,
+                 arma::Col<size_t>& stateSeq,
+                 arma::mat& logStateProb,
+                 arma::Mat<size_t>& stateSeqBack) const;
+
+  /**
+   * Get the nonzero transition probabilities, in compressed sparse column
+   * order: the transitions from state i are entries colPtrs[i] to
+   * colPtrs[i + 1] - 1 of rowIndices (which holds the states they are to) and
+   * probabilities.
+   *
+   * @param transition Transition matrix.
+   * @param colPtrs Vector to store the start of the transitions from each state
+   *    in (with one extra element, the number of nonzero transitions).
+   * @param rowIndices Vector to store the state each transition is to in.
+   * @param probabilities Vector to store the probability of each transition in.
+   */
+  static void GetTransitions(const arma::mat& transition,
+                             arma::uvec& colPtrs,
+                             arma::uvec& rowIndices,
+                             arma::vec& probabilities);
+
+  //! Get the nonzero transition probabilities of a sparse transition matrix.
+  static void GetTransitions(const arma::sp_mat& transition,
+                             arma::uvec& colPtrs,
+                             arma::uvec& rowIndices,
+                             arma::vec& probabilities);
+
+  /**
+   * Build the alias tables (Walker's alias method, with Vose's construction) of
+   * the transitions from each state, so that each transition can be sampled in
+   * constant time.  For the transitions from state i, entry k (between
+   * colPtrs[i] and colPtrs[i + 1] - 1) is kept with probability aliasProbs[k],
+   * and otherwise is replaced by entry aliases[k].  Each state must have at
+   * least one nonzero transition.
+   *
+   * @param colPtrs Start of the nonzero transitions from each state (as given
+   *    by GetTransitions()).
+   * @param probabilities Probability of each nonzero transition.
+   * @param aliasProbs Vector to store the probability of keeping each entry in.
+   * @param aliases Vector to store the alias of each entry in.
+   */
+  static void BuildAliasTables(const arma::uvec& colPtrs,
+                               const arma::vec& probabilities,
+                               arma::vec& aliasProbs,
+                               arma::uvec& aliases);
+
+  /**
+   * Sample the state after the given state from the alias tables, given two
+   * uniform random numbers in [0, 1).
+   */
+  static size_t SampleTransition(const arma::uvec& colPtrs,
+                                 const arma::uvec& rowIndices,
+                                 const arma::vec& aliasProbs,
+                                 const arma::uvec& aliases,
+                                 const size_t state,
+                                 const double entryValue,
+                                 const double aliasValue);
+
+  /**
+   * Set the transition matrix (which must already have the right size) from
+   * the nonzero transition probabilities, as given by GetTransitions().
+   *
+   * @param colPtrs Start of the transitions from each state.
+   * @param rowIndices State that each transition is to.
+   * @param probabilities Probability of each transition.
+   * @param transition Transition matrix to set.
+   */
+  static void SetTransitions(const arma::uvec& colPtrs,
+                             const arma::uvec& rowIndices,
+                             const arma::vec& probabilities,
+                             arma::mat& transition);
+
+  //! Set the nonzero transition probabilities of a sparse transition matrix.
+  static void SetTransitions(const arma::uvec& colPtrs,
+                             const arma::uvec& rowIndices,
+                             const arma::vec& probabilities,
+                             arma::sp_mat& transition);
+
   //! Set of emission probability distributions; one for each state.
   std::vector<Distribution> emission;
 
   //! Transition probability matrix.
-  arma::mat transition;
+  TransitionMatType transition;
   
  private:
   //! Initial state probability vector.
@@ -12,17 +12,86 @@
 // Just in case...
 #include "hmm.hpp"
 
+#include <boost/utility/enable_if.hpp>
+
 namespace mlpack {
 namespace hmm {
 
+HAS_MEM_FUNC(LogProbability, HasBatchLogProbability);
+
+/**
+ * Compute the log-probability of each observation under a distribution that
+ * has a batch LogProbability(), with one call.
+ */
+template<typename Distribution>
+void DistributionLogProbabilities(
+    const Distribution& distribution,
+    const arma::mat& observations,
+    arma::vec& logProbabilities,
+    const typename boost::enable_if<HasBatchLogProbability<Distribution,
+        void(Distribution::*)(const arma::mat&, arma::vec&) const> >::type* = 0)
+{
+  distribution.LogProbability(observations, logProbabilities);
+}
+
+/**
+ * Compute the log-probability of each observation under a distribution that
+ * only evaluates one observation at a time.
+ */
+template<typename Distribution>
+void DistributionLogProbabilities(
+    const Distribution& distribution,
+    const arma::mat& observations,
+    arma::vec& logProbabilities,
+    const typename boost::disable_if<HasBatchLogProbability<Distribution,
+        void(Distribution::*)(const arma::mat&, arma::vec&) const> >::type* = 0)
+{
+  logProbabilities.set_size(observations.n_cols);
+  for (size_t i = 0; i < observations.n_cols; ++i)
+    logProbabilities[i] = log(distribution.Probability(
+        observations.unsafe_col(i)));
+}
+
+/**
+ * Whether the emission distributions of different states can be estimated at
+ * the same time, from different threads.  This is false unless specialized,
+ * because the estimation of some distributions is not safe to run
+ * concurrently (a GMM, for instance, starts its fitting from points drawn with
+ * the global random number generator).
+ */
+template<typename Distribution>
+struct ParallelEstimate
+{
+  static const bool value = false;
+};
+
+template<>
+struct ParallelEstimate<distribution::DiscreteDistribution>
+{
+  static const bool value = true;
+};
+
+template<>
+struct ParallelEstimate<distribution::GaussianDistribution>
+{
+  static const bool value = true;
+};
+
+template<>
+struct ParallelEstimate<distribution::DiagonalGaussianDistribution>
+{
+  static const bool value = true;
+};
+
 /**
  * Create the Hidden Markov Model with the given number of hidden states and the
  * given number of emission states.
  */
-template<typename Distribution>
-HMM<Distribution>::HMM(const size_t states,
-                       const Distribution emissions,
-                       const double tolerance) :
+template<typename Distribution, typename TransitionMatType>
+HMM<Distribution, TransitionMatType>::HMM(
+    const size_t states,
+    const Distribution emissions,
+    const double tolerance) :
     emission(states, /* default distribution */ emissions),
     transition(arma::ones<arma::mat>(states, states) / (double) states),
     initial(arma::ones<arma::vec>(states) / (double) states),
@@ -34,11 +103,12 @@ HMM<Distribution>::HMM(const size_t states,
  * Create the Hidden Markov Model with the given transition matrix and the given
  * emission probability matrix.
  */
-template<typename Distribution>
-HMM<Distribution>::HMM(const arma::vec& initial,
-                       const arma::mat& transition,
-                       const std::vector<Distribution>& emission,
-                       const double tolerance) :
+template<typename Distribution, typename TransitionMatType>
+HMM<Distribution, TransitionMatType>::HMM(
+    const arma::vec& initial,
+    const TransitionMatType& transition,
+    const std::vector<Distribution>& emission,
+    const double tolerance) :
     emission(emission),
     transition(transition),
     initial(initial),
@@ -71,8 +141,9 @@ HMM<Distribution>::HMM(const arma::vec& initial,
  *
  * @param dataSeq Set of data sequences to train on.
  */
-template<typename Distribution>
-void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Train(
+    const std::vector<arma::mat>& dataSeq)
 {
   // We should allow a guess at the transition and emission matrices.
   double loglik = 0;
@@ -81,10 +152,14 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
   // Maximum iterations?
   size_t iterations = 1000;
 
-  // Find length of all sequences and ensure they are the correct size.
+  // Find length of all sequences and ensure they are the correct size.  Each
+  // sequence's observations start at its offset in the list of emission
+  // observations.
   size_t totalLength = 0;
+  std::vector<size_t> offsets(dataSeq.size());
   for (size_t seq = 0; seq < dataSeq.size(); seq++)
   {
+    offsets[seq] = totalLength;
     totalLength += dataSeq[seq].n_cols;
 
     if (dataSeq[seq].n_rows != dimensionality)
@@ -99,6 +174,27 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
       arma::vec(totalLength));
   arma::mat emissionList(dimensionality, totalLength);
 
+  // The emission observations don't change between iterations.
+  for (size_t seq = 0; seq < dataSeq.size(); seq++)
+    if (dataSeq[seq].n_cols > 0)
+      emissionList.cols(offsets[seq], offsets[seq] + dataSeq[seq].n_cols - 1) =
+          dataSeq[seq];
+
+  // The sequences are split into chunks, which are divided between OpenMP
+  // threads.  Each chunk has its own transition sums and log-likelihood, which
+  // are added together in order, so the result doesn't depend on the number of
+  // threads or on which thread handled which chunk.
+  const size_t chunkSize = 16;
+  const size_t numChunks = (dataSeq.size() + chunkSize - 1) / chunkSize;
+  std::vector<arma::vec> chunkTransitions(numChunks);
+  arma::vec chunkLoglik(numChunks);
+
+  // Only the nonzero transition probabilities are re-estimated (the others stay
+  // zero), so each time step takes time linear in the number of them.
+  arma::uvec colPtrs;
+  arma::uvec rowIndices;
+  arma::vec probabilities;
+
   // This should be the Baum-Welch algorithm (EM for HMM estimation). This
   // follows the procedure outlined in Elliot, Aggoun, and Moore's book "Hidden
   // Markov Models: Estimation and Control", pp. 36-40.
@@ -107,57 +203,88 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
     // Clear new transition matrix and emission probabilities.
     arma::vec newInitial(transition.n_rows);
     newInitial.zeros();
-    arma::mat newTransition(transition.n_rows, transition.n_cols);
+    GetTransitions(transition, colPtrs, rowIndices, probabilities);
+    arma::vec newTransition(probabilities.n_elem);
     newTransition.zeros();
 
     // Reset log likelihood.
     loglik = 0;
 
-    // Sum over time.
-    size_t sumTime = 0;
-
-    // Loop over each sequence.
-    for (size_t seq = 0; seq < dataSeq.size(); seq++)
+    // Loop over each sequence.  This is the E-step.
+    #pragma omp parallel
     {
       arma::mat stateProb;
       arma::mat forward;
       arma::mat backward;
       arma::vec scales;
+      arma::mat emissionProbs;
 
-      // Add the log-likelihood of this sequence.  This is the E-step.
-      loglik += Estimate(dataSeq[seq], stateProb, forward, backward, scales);
-
-      // Now re-estimate the parameters.  This is the M-step.
-      //   pi_i = sum_d ((1 / P(seq[d])) sum_t (f(i, 0) b(i, 0))
-      //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(i, t) T_ij E_i(seq[d][t]) b(i,
-      //           t + 1)))
-      //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t) b(i, t)
-      // We store the new estimates in a different matrix.
-      for (size_t t = 0; t < dataSeq[seq].n_cols; t++)
+      #pragma omp for schedule(dynamic, 1)
+      for (size_t c = 0; c < numChunks; c++)
       {
-        for (size_t j = 0; j < transition.n_cols; j++)
-        {
-          // Add to estimate of initial probability for state j.
-          newInitial[j] = stateProb(j, 0);
+        chunkTransitions[c].zeros(probabilities.n_elem);
+        chunkLoglik[c] = 0;
 
-          if (t < dataSeq[seq].n_cols - 1)
+        const size_t end = std::min((c + 1) * chunkSize, dataSeq.size());
+        for (size_t seq = c * chunkSize; seq < end; seq++)
+        {
+          // Run the forward-backward algorithm, evaluating the emissions of
+          // the whole sequence once, and add the log-likelihood of this
+          // sequence.
+          EmissionLogProbabilities(dataSeq[seq], emissionProbs);
+          emissionProbs = exp(emissionProbs);
+          ForwardEmissions(emissionProbs, scales, forward);
+          BackwardEmissions(emissionProbs, scales, backward);
+          stateProb = forward % backward;
+          chunkLoglik[c] += accu(log(scales));
+
+          // Now accumulate the statistics needed to re-estimate the parameters.
+          //   pi_i = sum_d ((1 / P(seq[d])) sum_t (f(i, 0) b(i, 0))
+          //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(i, t) T_ij E_i(seq[d][t])
+          //           b(i, t + 1)))
+          //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t)
+          //           b(i, t)
+          // We store the new estimates in a different matrix.
+          for (size_t t = 0; t < dataSeq[seq].n_cols; t++)
           {
-            // Estimate of T_ij (probability of transition from state j to state
-            // i).  We postpone multiplication of the old T_ij until later.
-            for (size_t i = 0; i < transition.n_rows; i++)
-              newTransition(i, j) += forward(j, t) * backward(i, t + 1) *
-                  emission[i].Probability(dataSeq[seq].unsafe_col(t + 1)) /
-                  scales[t + 1];
+            for (size_t j = 0; j < transition.n_cols; j++)
+            {
+              if (t < dataSeq[seq].n_cols - 1)
+              {
+                // Estimate of T_ij (probability of transition from state j to
+                // state i), for each state i that state j can transition to.
+                // We postpone multiplication of the old T_ij until later.
+                for (size_t k = colPtrs[j]; k < colPtrs[j + 1]; k++)
+                {
+                  const size_t i = rowIndices[k];
+                  chunkTransitions[c][k] += forward(j, t) *
+                      backward(i, t + 1) * emissionProbs(i, t + 1) /
+                      scales[t + 1];
+                }
+              }
+
+              // Add to the emission probabilities, for
+              // Distribution::Estimate().  Each sequence has its own part of
+              // the list, so no two threads write to the same element.
+              emissionProb[j][offsets[seq] + t] = stateProb(j, t);
+            }
           }
 
-          // Add to list of emission observations, for Distribution::Estimate().
-          emissionList.col(sumTime) = dataSeq[seq].col(t);
-          emissionProb[j][sumTime] = stateProb(j, t);
+          // Add to estimate of initial probability for each state.  (Only the
+          // last sequence's probabilities are kept.)
+          if (seq == dataSeq.size() - 1 && dataSeq[seq].n_cols > 0)
+            newInitial = stateProb.col(0);
         }
-        sumTime++;
       }
     }
 
+    // Add the sums of the chunks together, in order.
+    for (size_t c = 0; c < numChunks; c++)
+    {
+      loglik += chunkLoglik[c];
+      newTransition += chunkTransitions[c];
+    }
+
     // Normalize the new initial probabilities.
     if (dataSeq.size() == 0)
       initial = newInitial / dataSeq.size();
@@ -166,13 +293,28 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
     // multiplication) because every element of the new transition matrix must
     // still be multiplied by the old elements (this is the multiplication we
     // earlier postponed).
-    transition %= newTransition;
+    probabilities %= newTransition;
 
-    // Now we normalize the transition matrix.
+    // Now we normalize the transition matrix.  A state that is never on a path
+    // with nonzero probability keeps zero transition probabilities, instead of
+    // dividing by 0.
     for (size_t i = 0; i < transition.n_cols; i++)
-      transition.col(i) /= accu(transition.col(i));
+    {
+      if (colPtrs[i + 1] == colPtrs[i])
+        continue;
 
-    // Now estimate emission probabilities.
+      const double sum = accu(probabilities.subvec(colPtrs[i],
+          colPtrs[i + 1] - 1));
+      if (sum > 0)
+        probabilities.subvec(colPtrs[i], colPtrs[i + 1] - 1) /= sum;
+    }
+
+    SetTransitions(colPtrs, rowIndices, probabilities, transition);
+
+    // Now estimate emission probabilities, in parallel if the distributions
+    // allow it.
+    #pragma omp parallel for schedule(dynamic, 1) \
+        if (ParallelEstimate<Distribution>::value)
     for (size_t state = 0; state < transition.n_cols; state++)
       emission[state].Estimate(emissionList, emissionProb[state]);
 
@@ -193,9 +335,10 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
  * Train the model using the given labeled observations; the transition and
  * emission matrices are directly estimated.
  */
-template<typename Distribution>
-void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq,
-                              const std::vector<arma::Col<size_t> >& stateSeq)
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Train(
+    const std::vector<arma::mat>& dataSeq,
+    const std::vector<arma::Col<size_t> >& stateSeq)
 {
   // Simple error checking.
   if (dataSeq.size() != stateSeq.size())
@@ -236,7 +379,7 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq,
     initial[stateSeq[seq][0]]++;
     for (size_t t = 0; t < dataSeq[seq].n_cols - 1; t++)
     {
-      transition(stateSeq[seq][t + 1], stateSeq[seq][t])++;
+      transition(stateSeq[seq][t + 1], stateSeq[seq][t]) += 1.0;
       emissionList[stateSeq[seq][t]].push_back(std::make_pair(seq, t));
     }
 
@@ -249,17 +392,28 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq,
   initial /= accu(initial);
 
   // Normalize transition matrix.
+  arma::uvec colPtrs;
+  arma::uvec rowIndices;
+  arma::vec probabilities;
+  GetTransitions(transition, colPtrs, rowIndices, probabilities);
   for (size_t col = 0; col < transition.n_cols; col++)
   {
     // If the transition probability sum is greater than 0 in this column, the
     // emission probability sum will also be greater than 0.  We want to avoid
     // division by 0.
-    double sum = accu(transition.col(col));
+    if (colPtrs[col + 1] == colPtrs[col])
+      continue;
+
+    const double sum = accu(probabilities.subvec(colPtrs[col],
+        colPtrs[col + 1] - 1));
     if (sum > 0)
-      transition.col(col) /= sum;
+      probabilities.subvec(colPtrs[col], colPtrs[col + 1] - 1) /= sum;
   }
+  SetTransitions(colPtrs, rowIndices, probabilities, transition);
 
-  // Estimate emission matrix.
+  // Estimate emission matrix, in parallel if the distributions allow it.
+  #pragma omp parallel for schedule(dynamic, 1) \
+      if (ParallelEstimate<Distribution>::value)
   for (size_t state = 0; state < transition.n_cols; state++)
   {
     // Generate full sequence of observations for this state from the list of
@@ -279,16 +433,21 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq,
  * Estimate the probabilities of each hidden state at each time step for each
  * given data observation.
  */
-template<typename Distribution>
-double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
-                                   arma::mat& stateProb,
-                                   arma::mat& forwardProb,
-                                   arma::mat& backwardProb,
-                                   arma::vec& scales) const
+template<typename Distribution, typename TransitionMatType>
+double HMM<Distribution, TransitionMatType>::Estimate(
+    const arma::mat& dataSeq,
+    arma::mat& stateProb,
+    arma::mat& forwardProb,
+    arma::mat& backwardProb,
+    arma::vec& scales) const
 {
-  // First run the forward-backward algorithm.
-  Forward(dataSeq, scales, forwardProb);
-  Backward(dataSeq, scales, backwardProb);
+  // First run the forward-backward algorithm.  The emissions are evaluated
+  // once for both passes.
+  arma::mat emissionProb;
+  EmissionLogProbabilities(dataSeq, emissionProb);
+  emissionProb = exp(emissionProb);
+  ForwardEmissions(emissionProb, scales, forwardProb);
+  BackwardEmissions(emissionProb, scales, backwardProb);
 
   // Now assemble the state probability matrix based on the forward and backward
   // probabilities.
@@ -302,9 +461,10 @@ double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
  * Estimate the probabilities of each hidden state at each time step for each
  * given data observation.
  */
-template<typename Distribution>
-double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
-                                   arma::mat& stateProb) const
+template<typename Distribution, typename TransitionMatType>
+double HMM<Distribution, TransitionMatType>::Estimate(
+    const arma::mat& dataSeq,
+    arma::mat& stateProb) const
 {
   // We don't need to save these.
   arma::mat forwardProb, backwardProb;
@@ -318,47 +478,105 @@ double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
  * stored in the dataSequence parameter, and the state sequence is stored in
  * the stateSequence parameter.
  */
-template<typename Distribution>
-void HMM<Distribution>::Generate(const size_t length,
-                                 arma::mat& dataSequence,
-                                 arma::Col<size_t>& stateSequence,
-                                 const size_t startState) const
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Generate(
+    const size_t length,
+    arma::mat& dataSequence,
+    arma::Col<size_t>& stateSequence,
+    const size_t startState) const
 {
+  arma::uvec colPtrs;
+  arma::uvec rowIndices;
+  arma::vec probabilities;
+  GetTransitions(transition, colPtrs, rowIndices, probabilities);
+
+  arma::vec aliasProbs;
+  arma::uvec aliases;
+  BuildAliasTables(colPtrs, probabilities, aliasProbs, aliases);
+
   // Set vectors to the right size.
   stateSequence.set_size(length);
   dataSequence.set_size(dimensionality, length);
+  if (length == 0)
+    return;
 
-  // Set start state (default is 0).
+  // Set start state (default is 0), and choose the first emission.
   stateSequence[0] = startState;
-
-  // Choose first emission state.
-  double randValue = math::Random();
-
-  // We just have to find where our random value sits in the probability
-  // distribution of emissions for our starting state.
   dataSequence.col(0) = emission[startState].Random();
 
   // Now choose the states and emissions for the rest of the sequence.
   for (size_t t = 1; t < length; t++)
   {
-    // First choose the hidden state.
-    randValue = math::Random();
+    // First choose the hidden state; the alias tables take constant time,
+    // instead of a search through the transitions from the last state.
+    const double entryValue = math::Random();
+    const double aliasValue = math::Random();
+    stateSequence[t] = SampleTransition(colPtrs, rowIndices, aliasProbs,
+        aliases, stateSequence[t - 1], entryValue, aliasValue);
 
-    // Now find where our random value sits in the probability distribution of
-    // state changes.
-    double probSum = 0;
-    for (size_t st = 0; st < transition.n_rows; st++)
+    // Now choose the emission.
+    dataSequence.col(t) = emission[stateSequence[t]].Random();
+  }
+}
+
+/**
+ * Generate many random sequences, sampling the hidden states in parallel.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Generate(
+    const std::vector<size_t>& lengths,
+    std::vector<arma::mat>& dataSequences,
+    std::vector<arma::Col<size_t> >& stateSequences,
+    const size_t startState) const
+{
+  arma::uvec colPtrs;
+  arma::uvec rowIndices;
+  arma::vec probabilities;
+  GetTransitions(transition, colPtrs, rowIndices, probabilities);
+
+  arma::vec aliasProbs;
+  arma::uvec aliases;
+  BuildAliasTables(colPtrs, probabilities, aliasProbs, aliases);
+
+  // The seeds are drawn in order, so each sequence gets the same stream of
+  // random numbers no matter which thread generates it.
+  std::vector<boost::uint32_t> seeds(lengths.size());
+  for (size_t seq = 0; seq < lengths.size(); ++seq)
+    seeds[seq] = (boost::uint32_t) math::RandInt(
+        std::numeric_limits<int>::max());
+
+  dataSequences.resize(lengths.size());
+  stateSequences.resize(lengths.size());
+  #pragma omp parallel for schedule(dynamic, 16)
+  for (size_t seq = 0; seq < lengths.size(); ++seq)
+  {
+    boost::mt19937 generator(seeds[seq]);
+    boost::uniform_real<> unit(0.0, 1.0);
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<> >
+        uniform(generator, unit);
+
+    arma::Col<size_t>& stateSequence = stateSequences[seq];
+    stateSequence.set_size(lengths[seq]);
+    if (lengths[seq] == 0)
+      continue;
+
+    stateSequence[0] = startState;
+    for (size_t t = 1; t < lengths[seq]; t++)
     {
-      probSum += transition(st, stateSequence[t - 1]);
-      if (randValue <= probSum)
-      {
-        stateSequence[t] = st;
-        break;
-      }
+      const double entryValue = uniform();
+      const double aliasValue = uniform();
+      stateSequence[t] = SampleTransition(colPtrs, rowIndices, aliasProbs,
+          aliases, stateSequence[t - 1], entryValue, aliasValue);
     }
+  }
 
-    // Now choose the emission.
-    dataSequence.col(t) = emission[stateSequence[t]].Random();
+  // The emission distributions use the mlpack random number generator, which
+  // is shared between threads, so the observations are sampled serially.
+  for (size_t seq = 0; seq < lengths.size(); ++seq)
+  {
+    dataSequences[seq].set_size(dimensionality, lengths[seq]);
+    for (size_t t = 0; t < lengths[seq]; t++)
+      dataSequences[seq].col(t) = emission[stateSequences[seq][t]].Random();
   }
 }
 
@@ -367,64 +585,65 @@ void HMM<Distribution>::Generate(const size_t length,
  * using the Viterbi algorithm. Returns the log-likelihood of the most likely
  * sequence.
  */
-template<typename Distribution>
-double HMM<Distribution>::Predict(const arma::mat& dataSeq,
-                                  arma::Col<size_t>& stateSeq) const
+template<typename Distribution, typename TransitionMatType>
+double HMM<Distribution, TransitionMatType>::Predict(
+    const arma::mat& dataSeq,
+    arma::Col<size_t>& stateSeq) const
 {
-  // This is an implementation of the Viterbi algorithm for finding the most
-  // probable sequence of states to produce the observed data sequence.  We
-  // don't use log-likelihoods to save that little bit of time, but we'll
-  // calculate the log-likelihood at the end of it all.
-  stateSeq.set_size(dataSeq.n_cols);
-  arma::mat logStateProb(transition.n_rows, dataSeq.n_cols);
-  arma::mat stateSeqBack(transition.n_rows, dataSeq.n_cols);
-
-  // Store the logs of the transposed transition matrix.  This is because we
-  // will be using the rows of the transition matrix.
-  arma::mat logTrans(log(trans(transition)));
+  // Store the logs of the nonzero transition probabilities.
+  arma::uvec colPtrs;
+  arma::uvec rowIndices;
+  arma::vec logProbabilities;
+  GetTransitions(transition, colPtrs, rowIndices, logProbabilities);
+  logProbabilities = log(logProbabilities);
+
+  arma::mat logStateProb;
+  arma::Mat<size_t> stateSeqBack;
+  return Viterbi(dataSeq, colPtrs, rowIndices, logProbabilities, stateSeq,
+      logStateProb, stateSeqBack);
+}
 
-  // The calculation of the first state is slightly different; the probability
-  // of the first state being state j is the maximum probability that the state
-  // came to be j from another state.
-  logStateProb.col(0).zeros();
-  for (size_t state = 0; state < transition.n_rows; state++)
+/**
+ * Compute the most probable hidden state sequence for each of the given
+ * observation sequences, in parallel.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Predict(
+    const std::vector<arma::mat>& dataSeqs,
+    std::vector<arma::Col<size_t> >& stateSeqs,
+    arma::vec& logLikelihoods) const
+{
+  arma::uvec colPtrs;
+  arma::uvec rowIndices;
+  arma::vec logProbabilities;
+  GetTransitions(transition, colPtrs, rowIndices, logProbabilities);
+  logProbabilities = log(logProbabilities);
+
+  // The workspaces are allocated once, large enough for the longest sequence.
+  size_t maxLength = 0;
+  for (size_t seq = 0; seq < dataSeqs.size(); ++seq)
+    maxLength = std::max(maxLength, (size_t) dataSeqs[seq].n_cols);
+
+  stateSeqs.resize(dataSeqs.size());
+  logLikelihoods.set_size(dataSeqs.size());
+  #pragma omp parallel
   {
-    logStateProb(state, 0) = log(initial[state] *
-        emission[state].Probability(dataSeq.unsafe_col(0)));
-    stateSeqBack(state, 0) = state;
-  }
+    arma::mat logStateProb(transition.n_rows, maxLength);
+    arma::Mat<size_t> stateSeqBack(transition.n_rows, maxLength);
 
-  // Store the best first state.
-  arma::uword index;
-  for (size_t t = 1; t < dataSeq.n_cols; t++)
-  {
-    // Assemble the state probability for this element.
-    // Given that we are in state j, we use state with the highest probability
-    // of being the previous state.
-    for (size_t j = 0; j < transition.n_rows; j++)
-    {
-      arma::vec prob = logStateProb.col(t - 1) + logTrans.col(j);
-      logStateProb(j, t) = prob.max(index) +
-          log(emission[j].Probability(dataSeq.unsafe_col(t)));
-        stateSeqBack(j, t) = index;
-    }
+    #pragma omp for schedule(dynamic, 16)
+    for (size_t seq = 0; seq < dataSeqs.size(); ++seq)
+      logLikelihoods[seq] = Viterbi(dataSeqs[seq], colPtrs, rowIndices,
+          logProbabilities, stateSeqs[seq], logStateProb, stateSeqBack);
   }
-
-  // Backtrack to find the most probable state sequence.
-  logStateProb.unsafe_col(dataSeq.n_cols - 1).max(index);
-  stateSeq[dataSeq.n_cols - 1] = index;
-  for (size_t t = 2; t <= dataSeq.n_cols; t++)
-    stateSeq[dataSeq.n_cols - t] =
-        stateSeqBack(stateSeq[dataSeq.n_cols - t + 1], dataSeq.n_cols - t + 1);
-
-  return logStateProb(stateSeq(dataSeq.n_cols - 1), dataSeq.n_cols - 1);
 }
 
 /**
  * Compute the log-likelihood of the given data sequence.
  */
-template<typename Distribution>
-double HMM<Distribution>::LogLikelihood(const arma::mat& dataSeq) const
+template<typename Distribution, typename TransitionMatType>
+double HMM<Distribution, TransitionMatType>::LogLikelihood(
+    const arma::mat& dataSeq) const
 {
   arma::mat forward;
   arma::vec scales;
@@ -435,22 +654,79 @@ double HMM<Distribution>::LogLikelihood(const arma::mat& dataSeq) const
   return accu(log(scales));
 }
 
+/**
+ * Compute the log-likelihood of each of the given data sequences, in parallel.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::LogLikelihood(
+    const std::vector<arma::mat>& dataSeqs,
+    arma::vec& logLikelihoods) const
+{
+  logLikelihoods.set_size(dataSeqs.size());
+  #pragma omp parallel
+  {
+    arma::mat forward;
+    arma::vec scales;
+
+    #pragma omp for schedule(dynamic, 16)
+    for (size_t seq = 0; seq < dataSeqs.size(); ++seq)
+    {
+      Forward(dataSeqs[seq], scales, forward);
+      logLikelihoods[seq] = accu(log(scales));
+    }
+  }
+}
+
+/**
+ * Online HMM filtering: update the state probabilities with one observation.
+ */
+template<typename Distribution, typename TransitionMatType>
+double HMM<Distribution, TransitionMatType>::FilterStep(
+    const arma::vec& observation,
+    arma::vec& stateProb,
+    arma::vec& workspace) const
+{
+  // Predict the state probabilities at this time step from the last ones.
+  if (stateProb.n_elem == 0)
+  {
+    stateProb.set_size(transition.n_rows);
+    workspace = initial;
+  }
+  else
+  {
+    workspace = transition * stateProb;
+  }
+
+  // Now weight each state by the probability of it emitting the observation,
+  // and normalize, as in Forward().
+  for (size_t state = 0; state < transition.n_rows; state++)
+    stateProb[state] = workspace[state] *
+        emission[state].Probability(observation);
+
+  const double scale = accu(stateProb);
+  stateProb /= scale;
+
+  return log(scale);
+}
+
 /**
  * HMM filtering.
  */
-template<typename Distribution>
-void HMM<Distribution>::Filter(const arma::mat& dataSeq,
-                               arma::mat& filterSeq,
-                               size_t ahead) const
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Filter(
+    const arma::mat& dataSeq,
+    arma::mat& filterSeq,
+    size_t ahead) const
 {
   // First run the forward algorithm.
   arma::mat forwardProb;
   arma::vec scales;
   Forward(dataSeq, scales, forwardProb);
 
-  // Propagate state ahead.
-  if (ahead != 0)
-    forwardProb = pow(transition, ahead) * forwardProb;
+  // Propagate state ahead, one step at a time, so that a sparse transition
+  // matrix stays sparse.
+  for (size_t i = 0; i < ahead; i++)
+    forwardProb = transition * forwardProb;
 
   // Compute expected emissions.
   // Will not work for distributions without a Mean() function.
@@ -462,9 +738,10 @@ void HMM<Distribution>::Filter(const arma::mat& dataSeq,
 /**
  * HMM smoothing.
  */
-template<typename Distribution>
-void HMM<Distribution>::Smooth(const arma::mat& dataSeq,
-                               arma::mat& smoothSeq) const
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Smooth(
+    const arma::mat& dataSeq,
+    arma::mat& smoothSeq) const
 {
   // First run the forward algorithm.
   arma::mat stateProb;
@@ -480,41 +757,86 @@ void HMM<Distribution>::Smooth(const arma::mat& dataSeq,
 /**
  * The Forward procedure (part of the Forward-Backward algorithm).
  */
-template<typename Distribution>
-void HMM<Distribution>::Forward(const arma::mat& dataSeq,
-                                arma::vec& scales,
-                                arma::mat& forwardProb) const
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Forward(
+    const arma::mat& dataSeq,
+    arma::vec& scales,
+    arma::mat& forwardProb) const
+{
+  arma::mat emissionProb;
+  EmissionLogProbabilities(dataSeq, emissionProb);
+  emissionProb = exp(emissionProb);
+  ForwardEmissions(emissionProb, scales, forwardProb);
+}
+
+/**
+ * The Backward procedure (part of the Forward-Backward algorithm).
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Backward(
+    const arma::mat& dataSeq,
+    const arma::vec& scales,
+    arma::mat& backwardProb) const
+{
+  arma::mat emissionProb;
+  EmissionLogProbabilities(dataSeq, emissionProb);
+  emissionProb = exp(emissionProb);
+  BackwardEmissions(emissionProb, scales, backwardProb);
+}
+
+/**
+ * Compute the log-probability of each observation under each state's emission
+ * distribution, with one (batch, if possible) evaluation per state.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::EmissionLogProbabilities(
+    const arma::mat& dataSeq,
+    arma::mat& logEmissions) const
+{
+  logEmissions.set_size(transition.n_rows, dataSeq.n_cols);
+  arma::vec logProbabilities;
+  for (size_t state = 0; state < transition.n_rows; state++)
+  {
+    DistributionLogProbabilities(emission[state], dataSeq, logProbabilities);
+    logEmissions.row(state) = trans(logProbabilities);
+  }
+}
+
+/**
+ * The Forward procedure, with the emission probabilities already computed.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::ForwardEmissions(
+    const arma::mat& emissionProb,
+    arma::vec& scales,
+    arma::mat& forwardProb) const
 {
   // Our goal is to calculate the forward probabilities:
   //  P(X_k | o_{1:k}) for all possible states X_k, for each time point k.
-  forwardProb.zeros(transition.n_rows, dataSeq.n_cols);
-  scales.zeros(dataSeq.n_cols);
+  forwardProb.zeros(transition.n_rows, emissionProb.n_cols);
+  scales.zeros(emissionProb.n_cols);
 
   // The first entry in the forward algorithm uses the initial state
   // probabilities.  Note that MATLAB assumes that the starting state (at
   // t = -1) is state 0; this is not our assumption here.  To force that
   // behavior, you could append a single starting state to every single data
   // sequence and that should produce results in line with MATLAB.
-  for (size_t state = 0; state < transition.n_rows; state++)
-    forwardProb(state, 0) = initial(state) *
-        emission[state].Probability(dataSeq.unsafe_col(0));
+  forwardProb.col(0) = initial % emissionProb.col(0);
 
   // Then normalize the column.
   scales[0] = accu(forwardProb.col(0));
   forwardProb.col(0) /= scales[0];
 
   // Now compute the probabilities for each successive observation.
-  for (size_t t = 1; t < dataSeq.n_cols; t++)
+  for (size_t t = 1; t < emissionProb.n_cols; t++)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
-    {
-      // The forward probability of state j at time t is the sum over all states
-      // of the probability of the previous state transitioning to the current
-      // state and emitting the given observation.
-      forwardProb(j, t) = accu(forwardProb.col(t - 1) %
-          trans(transition.row(j))) *
-          emission[j].Probability(dataSeq.unsafe_col(t));
-    }
+    // The forward probability of state j at time t is the sum over all states
+    // of the probability of the previous state transitioning to the current
+    // state and emitting the given observation.  The sum is a product with the
+    // transition matrix, which only takes time linear in the number of nonzero
+    // transitions if it is sparse.
+    forwardProb.col(t) = transition * forwardProb.col(t - 1);
+    forwardProb.col(t) %= emissionProb.col(t);
 
     // Normalize probability.
     scales[t] = accu(forwardProb.col(t));
@@ -522,39 +844,306 @@ void HMM<Distribution>::Forward(const arma::mat& dataSeq,
   }
 }
 
-template<typename Distribution>
-void HMM<Distribution>::Backward(const arma::mat& dataSeq,
-                                 const arma::vec& scales,
-                                 arma::mat& backwardProb) const
+/**
+ * The Backward procedure, with the emission probabilities already computed.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::BackwardEmissions(
+    const arma::mat& emissionProb,
+    const arma::vec& scales,
+    arma::mat& backwardProb) const
 {
   // Our goal is to calculate the backward probabilities:
   //  P(X_k | o_{k + 1:T}) for all possible states X_k, for each time point k.
-  backwardProb.zeros(transition.n_rows, dataSeq.n_cols);
+  backwardProb.zeros(transition.n_rows, emissionProb.n_cols);
 
   // The last element probability is 1.
-  backwardProb.col(dataSeq.n_cols - 1).fill(1);
+  backwardProb.col(emissionProb.n_cols - 1).fill(1);
 
   // Now step backwards through all other observations.
-  for (size_t t = dataSeq.n_cols - 2; t + 1 > 0; t--)
+  arma::vec emitted(transition.n_rows);
+  for (size_t t = emissionProb.n_cols - 2; t + 1 > 0; t--)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
+    // The backward probability of state j at time t is the sum over all state
+    // of the probability of the next state having been a transition from the
+    // current state multiplied by the probability of each of those states
+    // emitting the given observation.
+    emitted = backwardProb.col(t + 1) % emissionProb.col(t + 1);
+
+    // Normalize by the weights from the forward algorithm.
+    backwardProb.col(t) = (trans(transition) * emitted) / scales[t + 1];
+  }
+}
+
+/**
+ * Get the nonzero entries of a dense transition matrix.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::GetTransitions(
+    const arma::mat& transition,
+    arma::uvec& colPtrs,
+    arma::uvec& rowIndices,
+    arma::vec& probabilities)
+{
+  const size_t nonzeros = (size_t) accu(transition != 0);
+  colPtrs.set_size(transition.n_cols + 1);
+  rowIndices.set_size(nonzeros);
+  probabilities.set_size(nonzeros);
+
+  size_t k = 0;
+  for (size_t col = 0; col < transition.n_cols; col++)
+  {
+    colPtrs[col] = k;
+    for (size_t row = 0; row < transition.n_rows; row++)
     {
-      // The backward probability of state j at time t is the sum over all state
-      // of the probability of the next state having been a transition from the
-      // current state multiplied by the probability of each of those states
-      // emitting the given observation.
-      for (size_t state = 0; state < transition.n_rows; state++)
-        backwardProb(j, t) += transition(state, j) * backwardProb(state, t + 1)
-            * emission[state].Probability(dataSeq.unsafe_col(t + 1));
-
-      // Normalize by the weights from the forward algorithm.
-      backwardProb(j, t) /= scales[t + 1];
+      if (transition(row, col) != 0)
+      {
+        rowIndices[k] = row;
+        probabilities[k] = transition(row, col);
+        ++k;
+      }
     }
   }
+  colPtrs[transition.n_cols] = k;
 }
 
-template<typename Distribution>
-std::string HMM<Distribution>::ToString() const
+/**
+ * Get the nonzero entries of a sparse transition matrix.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::GetTransitions(
+    const arma::sp_mat& transition,
+    arma::uvec& colPtrs,
+    arma::uvec& rowIndices,
+    arma::vec& probabilities)
+{
+  colPtrs.zeros(transition.n_cols + 1);
+  rowIndices.set_size(transition.n_nonzero);
+  probabilities.set_size(transition.n_nonzero);
+
+  // The iterator visits the nonzero entries in column-major order.
+  size_t k = 0;
+  for (arma::sp_mat::const_iterator it = transition.begin();
+       it != transition.end(); ++it)
+  {
+    ++colPtrs[it.col() + 1];
+    rowIndices[k] = it.row();
+    probabilities[k] = (*it);
+    ++k;
+  }
+
+  for (size_t col = 0; col < transition.n_cols; col++)
+    colPtrs[col + 1] += colPtrs[col];
+}
+
+/**
+ * Build the alias tables of the transitions from each state.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::BuildAliasTables(
+    const arma::uvec& colPtrs,
+    const arma::vec& probabilities,
+    arma::vec& aliasProbs,
+    arma::uvec& aliases)
+{
+  aliasProbs.set_size(probabilities.n_elem);
+  aliases.set_size(probabilities.n_elem);
+
+  std::vector<size_t> small, large;
+  for (size_t col = 0; col + 1 < colPtrs.n_elem; col++)
+  {
+    const size_t begin = colPtrs[col];
+    const size_t end = colPtrs[col + 1];
+    if (begin == end)
+      Log::Fatal << "HMM::Generate(): there are no transitions from state "
+          << col << "!" << std::endl;
+
+    // Scale the probabilities so that their mean is one, then split them into
+    // the entries below and above the mean.  The column is normalized here in
+    // case it does not sum to exactly one.
+    const double scale = (end - begin) /
+        arma::accu(probabilities.subvec(begin, end - 1));
+    small.clear();
+    large.clear();
+    for (size_t k = begin; k < end; k++)
+    {
+      aliasProbs[k] = scale * probabilities[k];
+      aliases[k] = k;
+      if (aliasProbs[k] < 1.0)
+        small.push_back(k);
+      else
+        large.push_back(k);
+    }
+
+    // Each small entry is topped up by a large entry, which may then become
+    // small itself.
+    while (!small.empty() && !large.empty())
+    {
+      const size_t s = small.back();
+      const size_t l = large.back();
+      small.pop_back();
+      aliases[s] = l;
+      aliasProbs[l] -= (1.0 - aliasProbs[s]);
+      if (aliasProbs[l] < 1.0)
+      {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+
+    // Whatever is left is one, up to roundoff.
+    for (size_t i = 0; i < small.size(); ++i)
+      aliasProbs[small[i]] = 1.0;
+    for (size_t i = 0; i < large.size(); ++i)
+      aliasProbs[large[i]] = 1.0;
+  }
+}
+
+/**
+ * Sample the state after the given state, in constant time.
+ */
+template<typename Distribution, typename TransitionMatType>
+size_t HMM<Distribution, TransitionMatType>::SampleTransition(
+    const arma::uvec& colPtrs,
+    const arma::uvec& rowIndices,
+    const arma::vec& aliasProbs,
+    const arma::uvec& aliases,
+    const size_t state,
+    const double entryValue,
+    const double aliasValue)
+{
+  const size_t begin = colPtrs[state];
+  const size_t count = colPtrs[state + 1] - begin;
+  const size_t k = begin + std::min(count - 1, (size_t) (entryValue * count));
+  return (aliasValue < aliasProbs[k]) ? rowIndices[k] : rowIndices[aliases[k]];
+}
+
+/**
+ * Set the nonzero entries of a dense transition matrix.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::SetTransitions(
+    const arma::uvec& colPtrs,
+    const arma::uvec& rowIndices,
+    const arma::vec& probabilities,
+    arma::mat& transition)
+{
+  transition.zeros();
+  for (size_t col = 0; col < transition.n_cols; col++)
+    for (size_t k = colPtrs[col]; k < colPtrs[col + 1]; k++)
+      transition(rowIndices[k], col) = probabilities[k];
+}
+
+/**
+ * Set the nonzero entries of a sparse transition matrix.
+ */
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::SetTransitions(
+    const arma::uvec& colPtrs,
+    const arma::uvec& rowIndices,
+    const arma::vec& probabilities,
+    arma::sp_mat& transition)
+{
+  arma::umat locations(2, probabilities.n_elem);
+  for (size_t col = 0; col + 1 < colPtrs.n_elem; col++)
+  {
+    for (size_t k = colPtrs[col]; k < colPtrs[col + 1]; k++)
+    {
+      locations(0, k) = rowIndices[k];
+      locations(1, k) = col;
+    }
+  }
+
+  transition = arma::sp_mat(locations, probabilities, transition.n_rows,
+      transition.n_cols);
+}
+
+/**
+ * The Viterbi algorithm, with the given workspaces.
+ */
+template<typename Distribution, typename TransitionMatType>
+double HMM<Distribution, TransitionMatType>::Viterbi(
+    const arma::mat& dataSeq,
+    const arma::uvec& colPtrs,
+    const arma::uvec& rowIndices,
+    const arma::vec& logProbabilities,
+    arma::Col<size_t>& stateSeq,
+    arma::mat& logStateProb,
+    arma::Mat<size_t>& stateSeqBack) const
+{
+  // This is an implementation of the Viterbi algorithm for finding the most
+  // probable sequence of states to produce the observed data sequence.  Only
+  // the first dataSeq.n_cols columns of the workspaces are used, so they only
+  // need to be reallocated if they are too small.
+  const size_t states = transition.n_rows;
+  stateSeq.set_size(dataSeq.n_cols);
+  if (logStateProb.n_rows != states || logStateProb.n_cols < dataSeq.n_cols)
+    logStateProb.set_size(states, dataSeq.n_cols);
+  if (stateSeqBack.n_rows != states || stateSeqBack.n_cols < dataSeq.n_cols)
+    stateSeqBack.set_size(states, dataSeq.n_cols);
+
+  // The emissions of the whole sequence are evaluated at once.
+  arma::mat logEmissions;
+  EmissionLogProbabilities(dataSeq, logEmissions);
+
+  // The calculation of the first state is slightly different; the probability
+  // of the first state being state j is the maximum probability that the state
+  // came to be j from another state.
+  for (size_t state = 0; state < states; state++)
+  {
+    logStateProb(state, 0) = log(initial[state]) + logEmissions(state, 0);
+    stateSeqBack(state, 0) = state;
+  }
+
+  for (size_t t = 1; t < dataSeq.n_cols; t++)
+  {
+    // Assemble the state probability for this element.
+    // Given that we are in state j, we use state with the highest probability
+    // of being the previous state (the first one, if there is a tie).  Only
+    // the nonzero transitions can be on the most probable path, so we visit
+    // each of them once; a state that no state can transition to keeps a
+    // log-probability of -inf.
+    for (size_t j = 0; j < states; j++)
+    {
+      logStateProb(j, t) = -std::numeric_limits<double>::infinity();
+      stateSeqBack(j, t) = 0;
+    }
+
+    for (size_t i = 0; i < states; i++)
+    {
+      for (size_t k = colPtrs[i]; k < colPtrs[i + 1]; k++)
+      {
+        const size_t j = rowIndices[k];
+        const double prob = logStateProb(i, t - 1) + logProbabilities[k];
+        if (prob > logStateProb(j, t))
+        {
+          logStateProb(j, t) = prob;
+          stateSeqBack(j, t) = i;
+        }
+      }
+    }
+
+    for (size_t j = 0; j < states; j++)
+      logStateProb(j, t) += logEmissions(j, t);
+  }
+
+  // Backtrack to find the most probable state sequence.
+  const size_t last = dataSeq.n_cols - 1;
+  size_t index = 0;
+  for (size_t state = 1; state < states; state++)
+    if (logStateProb(state, last) > logStateProb(index, last))
+      index = state;
+
+  stateSeq[last] = index;
+  for (size_t t = 2; t <= dataSeq.n_cols; t++)
+    stateSeq[dataSeq.n_cols - t] =
+        stateSeqBack(stateSeq[dataSeq.n_cols - t + 1], dataSeq.n_cols - t + 1);
+
+  return logStateProb(stateSeq[last], last);
+}
+
+template<typename Distribution, typename TransitionMatType>
+std::string HMM<Distribution, TransitionMatType>::ToString() const
 {
   std::ostringstream convert;
   convert << "HMM [" << this << "]" << std::endl;
@@ -566,15 +1155,16 @@ std::string HMM<Distribution>::ToString() const
 }
 
 //! Save to SaveRestoreUtility
-template<typename Distribution>
-void HMM<Distribution>::Save(util::SaveRestoreUtility& sr) const
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Save(
+    util::SaveRestoreUtility& sr) const
 {
   //  Save parameters.
   sr.SaveParameter(Type(), "type");
   sr.SaveParameter(Emission()[0].Type(), "emission_type");
   sr.SaveParameter(dimensionality, "dimensionality");
   sr.SaveParameter(transition.n_rows, "states");
-  sr.SaveParameter(transition, "transition");
+  sr.SaveParameter(arma::mat(transition), "transition");
 
   // Now the emissions.
   util::SaveRestoreUtility mn;
@@ -589,12 +1179,15 @@ void HMM<Distribution>::Save(util::SaveRestoreUtility& sr) const
 }
 
 //! Load from SaveRestoreUtility
-template<typename Distribution>
-void HMM<Distribution>::Load(const util::SaveRestoreUtility& sr)
+template<typename Distribution, typename TransitionMatType>
+void HMM<Distribution, TransitionMatType>::Load(
+    const util::SaveRestoreUtility& sr)
 {
   // Load parameters.
   sr.LoadParameter(dimensionality, "dimensionality");
-  sr.LoadParameter(transition, "transition");
+  arma::mat transitionMat;
+  sr.LoadParameter(transitionMat, "transition");
+  transition = TransitionMatType(transitionMat);
 
   // Now each emission distribution.
   Emission().resize(transition.n_rows);
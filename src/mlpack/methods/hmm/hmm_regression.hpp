@@ -14,6 +14,13 @@
 namespace mlpack {
 namespace hmm /** Hidden Markov Models. */ {
 
+//! The regressions of different states are refit in parallel.
+template<>
+struct ParallelEstimate<distribution::RegressionDistribution>
+{
+  static const bool value = true;
+};
+
 /**
  * A class that represents a Hidden Markov Model Regression (HMMR). HMMR is an
  * extension of Hidden Markov Models to regression analysis. The method is
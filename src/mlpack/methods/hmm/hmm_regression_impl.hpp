@@ -102,7 +102,8 @@ void HMMRegression::Filter(const arma::mat& predictors,
   
   // Propagate state, predictors ahead
   if(ahead != 0) {
-    forwardProb = pow(transition, ahead)*forwardProb;
+    for (size_t i = 0; i < ahead; i++)
+      forwardProb = transition * forwardProb;
     forwardProb = forwardProb.cols(0, forwardProb.n_cols-ahead-1);
   }  
   
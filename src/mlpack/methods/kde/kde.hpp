@@ -0,0 +1,234 @@
+/**
+ * @file kde.hpp
+ *
+ * Defines the KDE class, which performs kernel density estimation with
+ * dual-tree (or single-tree) algorithms.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_HPP
+#define __MLPACK_METHODS_KDE_KDE_HPP
+
+#include <mlpack/core.hpp>
+
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+#include "kde_stat.hpp"
+#include "kde_rules.hpp"
+
+namespace mlpack {
+namespace kde /** Kernel density estimation. */ {
+
+/**
+ * The KDE class performs kernel density estimation: for each query point q it
+ * computes
+ *
+ * @f[
+ * \hat{f}(q) = \frac{1}{N} \sum_{i = 1}^{N} K(d(q, r_i))
+ * @f]
+ *
+ * over the N reference points r_i.  This is the kernel density estimate of the
+ * reference set at q up to the normalizing constant of the kernel; divide by
+ * KernelType::Normalizer(dimensionality) to get a probability density.
+ *
+ * It is implemented in the style of a generalized tree-independent dual-tree
+ * algorithm: node combinations over which the kernel barely changes are
+ * approximated instead of being evaluated point by point (see the KDERules
+ * class).  Each estimate then satisfies
+ *
+ * @f[
+ * | \hat{f}(q) - f(q) | \le \epsilon_{rel} f(q) + \epsilon_{abs}
+ * @f]
+ *
+ * where f(q) is the exact value.  With relError = absError = 0 the estimates
+ * are exact; node combinations outside the support of a compact kernel (such
+ * as the Epanechnikov kernel) are still pruned.
+ *
+ * The kernel must be a non-increasing function of the distance (see KDERules),
+ * and the default tree type, a kd-tree, uses Euclidean distances in its bounds,
+ * so the metric should be the Euclidean distance unless another tree type is
+ * given.
+ *
+ * @tparam KernelType Kernel to estimate with.
+ * @tparam MetricType Metric to compute distances with.
+ * @tparam TreeType Type of tree to use; its statistic must be KDEStat.
+ */
+template<typename KernelType = kernel::GaussianKernel,
+         typename MetricType = metric::EuclideanDistance,
+         typename TreeType = tree::BinarySpaceTree<bound::HRectBound<2>,
+                                                   KDEStat> >
+class KDE
+{
+ public:
+  /**
+   * Initialize the KDE object with the given reference set.  The reference
+   * tree is built on a copy of the reference set, unless naive is true.
+   *
+   * @param referenceSet Reference dataset.
+   * @param kernel Instantiated kernel (holding the bandwidth).
+   * @param relError Relative error tolerance of each estimate.
+   * @param absError Absolute error tolerance of each estimate.
+   * @param naive Whether the computation should be done in O(n^2) naive mode.
+   * @param singleMode Whether single-tree computation should be used (as
+   *      opposed to dual-tree computation).
+   * @param metric Instantiated distance metric.
+   */
+  KDE(const typename TreeType::Mat& referenceSet,
+      const KernelType kernel = KernelType(),
+      const double relError = 0.05,
+      const double absError = 0.0,
+      const bool naive = false,
+      const bool singleMode = false,
+      const MetricType metric = MetricType());
+
+  /**
+   * Initialize the KDE object with the given reference set, taking the memory
+   * of the matrix instead of copying it: the given matrix is left empty, and
+   * the points are rearranged in place during tree-building.  Because the
+   * estimates do not depend on the order of the reference points, nothing has
+   * to be mapped back.
+   *
+   * @param referenceSet Reference dataset (which is emptied).
+   * @param kernel Instantiated kernel (holding the bandwidth).
+   * @param relError Relative error tolerance of each estimate.
+   * @param absError Absolute error tolerance of each estimate.
+   * @param naive Whether the computation should be done in O(n^2) naive mode.
+   * @param singleMode Whether single-tree computation should be used (as
+   *      opposed to dual-tree computation).
+   * @param metric Instantiated distance metric.
+   */
+  KDE(typename TreeType::Mat* referenceSet,
+      const KernelType kernel = KernelType(),
+      const double relError = 0.05,
+      const double absError = 0.0,
+      const bool naive = false,
+      const bool singleMode = false,
+      const MetricType metric = MetricType());
+
+  /**
+   * Initialize the KDE object with a pre-constructed reference tree.  It is
+   * assumed that the points in referenceSet correspond to the points in
+   * referenceTree.  Nothing is copied, and the tree is not deleted when this
+   * object is destroyed.
+   *
+   * @param referenceTree Pre-built tree for reference points.
+   * @param referenceSet Set of reference points corresponding to referenceTree.
+   * @param kernel Instantiated kernel (holding the bandwidth).
+   * @param relError Relative error tolerance of each estimate.
+   * @param absError Absolute error tolerance of each estimate.
+   * @param singleMode Whether single-tree computation should be used (as
+   *      opposed to dual-tree computation).
+   * @param metric Instantiated distance metric.
+   */
+  KDE(TreeType* referenceTree,
+      const typename TreeType::Mat& referenceSet,
+      const KernelType kernel = KernelType(),
+      const double relError = 0.05,
+      const double absError = 0.0,
+      const bool singleMode = false,
+      const MetricType metric = MetricType());
+
+  /**
+   * Destroy the KDE object.  If the reference tree was created, it will be
+   * deleted.
+   */
+  ~KDE();
+
+  /**
+   * Compute the estimate at each of the given query points.  In dual-tree mode
+   * a query tree is built on a copy of the query set; the estimates are given
+   * in the order of querySet.  In single-tree mode, the query points are split
+   * across NumThreads() threads.
+   *
+   * @param querySet Set of query points.
+   * @param estimates Vector which will hold the estimate at each query point.
+   */
+  void Evaluate(const typename TreeType::Mat& querySet, arma::vec& estimates);
+
+  /**
+   * Compute the estimate at each point of the given pre-built query tree with
+   * a dual-tree traversal, even in single-tree mode (this is not possible in
+   * naive mode, where there is no reference tree).  No copy of the query set is
+   * made, and the estimates are given in the order of queryTree->Dataset().
+   * The reference tree may be given as the query tree, to estimate the density
+   * at each reference point.
+   *
+   * @param queryTree Pre-built tree for the query points.
+   * @param estimates Vector which will hold the estimate at each query point.
+   */
+  void Evaluate(TreeType* queryTree, arma::vec& estimates);
+
+  //! Returns a string representation of this object.
+  std::string ToString() const;
+
+  //! Get the kernel.
+  const KernelType& Kernel() const { return kernel; }
+  //! Get the relative error tolerance.
+  double RelativeError() const { return relError; }
+  //! Get the absolute error tolerance.
+  double AbsoluteError() const { return absError; }
+
+  //! Get the number of threads used for single-tree evaluation.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for single-tree evaluation.  This only
+  //! has an effect if mlpack was compiled with OpenMP.
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the traversal statistics of all evaluations.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of all evaluations.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+ private:
+  //! Check the error tolerances given to the constructor.
+  void CheckErrors() const;
+
+  /**
+   * Add the kernel sums held by the statistics of the given node and its
+   * ancestors (parentEstimate) to the sum of each descendant, resetting the
+   * statistics to zero.
+   */
+  static void AddPrunedEstimates(TreeType& node,
+                                 const double parentEstimate,
+                                 arma::vec& estimates);
+
+  //! Copy of reference matrix; used when a tree is built internally.
+  typename TreeType::Mat referenceCopy;
+  //! Reference set (data should be accessed using this).
+  const typename TreeType::Mat& referenceSet;
+
+  //! Pointer to the root of the reference tree.
+  TreeType* referenceTree;
+
+  //! If true, this object created the reference tree.
+  bool treeOwner;
+
+  //! Indicates if O(n^2) naive evaluation will be used.
+  bool naive;
+  //! Indicates if single-tree evaluation is being used (opposed to dual-tree).
+  bool singleMode;
+
+  //! Instantiated kernel.
+  KernelType kernel;
+  //! Relative error tolerance.
+  double relError;
+  //! Absolute error tolerance.
+  double absError;
+  //! Instantiated distance metric.
+  MetricType metric;
+
+  //! The number of threads used for single-tree evaluation.
+  size_t numThreads;
+
+  //! The traversal statistics of all evaluations.
+  tree::TraversalStatistics statistics;
+};
+
+}; // namespace kde
+}; // namespace mlpack
+
+// Include implementation.
+#include "kde_impl.hpp"
+
+#endif
@@ -0,0 +1,331 @@
+/**
+ * @file kde_impl.hpp
+ *
+ * Implementation of the KDE class.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_IMPL_HPP
+#define __MLPACK_METHODS_KDE_KDE_IMPL_HPP
+
+// Just in case it hasn't been included.
+#include "kde.hpp"
+
+namespace mlpack {
+namespace kde {
+
+//! Call the tree constructor that does mapping.
+template<typename TreeType>
+TreeType* BuildTree(
+    typename TreeType::Mat& dataset,
+    std::vector<size_t>& oldFromNew,
+    typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset, oldFromNew);
+}
+
+//! Call the tree constructor that does not do mapping.
+template<typename TreeType>
+TreeType* BuildTree(
+    const typename TreeType::Mat& dataset,
+    const std::vector<size_t>& /* oldFromNew */,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset);
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+KDE<KernelType, MetricType, TreeType>::KDE(
+    const typename TreeType::Mat& referenceSetIn,
+    const KernelType kernel,
+    const double relError,
+    const double absError,
+    const bool naive,
+    const bool singleMode,
+    const MetricType metric) :
+    referenceSet(tree::TreeTraits<TreeType>::RearrangesDataset ? referenceCopy
+        : referenceSetIn),
+    referenceTree(NULL),
+    treeOwner(!naive), // If in naive mode, we are not building any trees.
+    naive(naive),
+    singleMode(!naive && singleMode), // Naive overrides single mode.
+    kernel(kernel),
+    relError(relError),
+    absError(absError),
+    metric(metric),
+    numThreads(1)
+{
+  CheckErrors();
+
+  // Build the tree.
+  Timer::Start("kde/tree_building");
+  statistics.StartPhase("tree_building");
+
+  // Copy the dataset, if it will be modified during tree building.
+  if (tree::TreeTraits<TreeType>::RearrangesDataset)
+    referenceCopy = referenceSetIn;
+
+  // The const_cast is safe; if RearrangesDataset == false, then it'll be casted
+  // back to const anyway, and if not, referenceSet points to referenceCopy,
+  // which isn't const.  The order of the reference points does not matter, so
+  // no mapping is kept.
+  if (!naive)
+    referenceTree = new TreeType(
+        const_cast<typename TreeType::Mat&>(referenceSet));
+
+  statistics.StopPhase("tree_building");
+  Timer::Stop("kde/tree_building");
+}
+
+// Construct the object, taking the memory of the dataset.
+template<typename KernelType, typename MetricType, typename TreeType>
+KDE<KernelType, MetricType, TreeType>::KDE(
+    typename TreeType::Mat* referenceSetIn,
+    const KernelType kernel,
+    const double relError,
+    const double absError,
+    const bool naive,
+    const bool singleMode,
+    const MetricType metric) :
+    referenceSet(referenceCopy),
+    referenceTree(NULL),
+    treeOwner(!naive), // If in naive mode, we are not building any trees.
+    naive(naive),
+    singleMode(!naive && singleMode), // Naive overrides single mode.
+    kernel(kernel),
+    relError(relError),
+    absError(absError),
+    metric(metric),
+    numThreads(1)
+{
+  CheckErrors();
+
+  Timer::Start("kde/tree_building");
+  statistics.StartPhase("tree_building");
+
+  // The tree is built on the memory of the given dataset; nothing is copied
+  // (unless the memory cannot be taken, as with matrices using auxiliary
+  // memory).
+  referenceCopy.steal_mem(*referenceSetIn);
+
+  if (!naive)
+    referenceTree = new TreeType(referenceCopy);
+
+  statistics.StopPhase("tree_building");
+  Timer::Stop("kde/tree_building");
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+KDE<KernelType, MetricType, TreeType>::KDE(
+    TreeType* referenceTree,
+    const typename TreeType::Mat& referenceSet,
+    const KernelType kernel,
+    const double relError,
+    const double absError,
+    const bool singleMode,
+    const MetricType metric) :
+    referenceSet(referenceSet),
+    referenceTree(referenceTree),
+    treeOwner(false),
+    naive(false),
+    singleMode(singleMode),
+    kernel(kernel),
+    relError(relError),
+    absError(absError),
+    metric(metric),
+    numThreads(1)
+{
+  CheckErrors();
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+KDE<KernelType, MetricType, TreeType>::~KDE()
+{
+  if (treeOwner && referenceTree)
+    delete referenceTree;
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+void KDE<KernelType, MetricType, TreeType>::Evaluate(
+    const typename TreeType::Mat& querySet,
+    arma::vec& estimates)
+{
+  typedef KDERules<MetricType, KernelType, TreeType> RuleType;
+
+  if (!naive && !singleMode)
+  {
+    // Build a query tree on a copy of the query set, if the tree would
+    // rearrange it.
+    Timer::Start("kde/tree_building");
+    statistics.StartPhase("tree_building");
+
+    typename TreeType::Mat queryCopy;
+    if (tree::TreeTraits<TreeType>::RearrangesDataset)
+      queryCopy = querySet;
+
+    std::vector<size_t> oldFromNewQueries;
+    TreeType* queryTree = BuildTree<TreeType>(
+        const_cast<typename TreeType::Mat&>(
+        tree::TreeTraits<TreeType>::RearrangesDataset ? queryCopy : querySet),
+        oldFromNewQueries);
+
+    statistics.StopPhase("tree_building");
+    Timer::Stop("kde/tree_building");
+
+    if (!tree::TreeTraits<TreeType>::RearrangesDataset)
+    {
+      Evaluate(queryTree, estimates);
+    }
+    else
+    {
+      // Map the estimates back to the original order of the query points.
+      arma::vec treeEstimates;
+      Evaluate(queryTree, treeEstimates);
+
+      estimates.set_size(querySet.n_cols);
+      for (size_t i = 0; i < treeEstimates.n_elem; ++i)
+        estimates[oldFromNewQueries[i]] = treeEstimates[i];
+    }
+
+    delete queryTree;
+    return;
+  }
+
+  Timer::Start("kde/computing_estimates");
+  statistics.StartPhase("traversal");
+
+  estimates.zeros(querySet.n_cols);
+  RuleType rules(referenceSet, querySet, estimates, relError, absError, metric,
+      kernel);
+
+  if (naive)
+  {
+    // The naive brute-force solution.
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      for (size_t j = 0; j < referenceSet.n_cols; ++j)
+        rules.BaseCase(i, j);
+  }
+  else
+  {
+    // The query points are independent, so we can split them across threads.
+    // Each thread gets its own copy of the rules and its own traverser, and
+    // each query point only writes to its own estimate, so no locking is
+    // necessary.
+    #pragma omp parallel num_threads(numThreads)
+    {
+      RuleType threadRules(rules);
+
+      typename TreeType::template SingleTreeTraverser<RuleType>
+          traverser(threadRules);
+
+      #pragma omp for schedule(dynamic, 16)
+      for (size_t i = 0; i < querySet.n_cols; ++i)
+        traverser.Traverse(i, *referenceTree);
+
+      #pragma omp critical
+      {
+        rules.Statistics() += threadRules.Statistics();
+      }
+    }
+  }
+
+  estimates /= referenceSet.n_cols;
+
+  statistics += rules.Statistics();
+
+  statistics.StopPhase("traversal");
+  Timer::Stop("kde/computing_estimates");
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+void KDE<KernelType, MetricType, TreeType>::Evaluate(
+    TreeType* queryTree,
+    arma::vec& estimates)
+{
+  typedef KDERules<MetricType, KernelType, TreeType> RuleType;
+
+  // Without a reference tree, there is nothing to traverse.
+  if (naive)
+    Log::Fatal << "KDE::Evaluate(): a query tree can't be used in naive mode!"
+        << std::endl;
+
+  Timer::Start("kde/computing_estimates");
+  statistics.StartPhase("traversal");
+
+  const typename TreeType::Mat& querySet = queryTree->Dataset();
+  estimates.zeros(querySet.n_cols);
+  RuleType rules(referenceSet, querySet, estimates, relError, absError, metric,
+      kernel);
+
+  typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
+  traverser.Traverse(*queryTree, *referenceTree);
+
+  // Now add the approximations of every pruned node combination.
+  AddPrunedEstimates(*queryTree, 0.0, estimates);
+
+  estimates /= referenceSet.n_cols;
+
+  statistics += rules.Statistics();
+
+  statistics.StopPhase("traversal");
+  Timer::Stop("kde/computing_estimates");
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+std::string KDE<KernelType, MetricType, TreeType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "KDE [" << this << "]" << std::endl;
+  convert << "  Relative error: " << relError << std::endl;
+  convert << "  Absolute error: " << absError << std::endl;
+  if (treeOwner)
+    convert << "  Tree Owner: TRUE" << std::endl;
+  if (naive)
+    convert << "  Naive: TRUE" << std::endl;
+  convert << "  Kernel: " << std::endl <<
+      mlpack::util::Indent(kernel.ToString(), 2);
+  convert << "  Metric: " << std::endl <<
+      mlpack::util::Indent(metric.ToString(), 2);
+  return convert.str();
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+void KDE<KernelType, MetricType, TreeType>::CheckErrors() const
+{
+  if (relError < 0.0 || relError >= 1.0)
+    Log::Fatal << "KDE::KDE(): relative error " << relError << " must be in "
+        << "[0, 1)!" << std::endl;
+
+  if (absError < 0.0)
+    Log::Fatal << "KDE::KDE(): absolute error " << absError << " must be "
+        << "non-negative!" << std::endl;
+}
+
+template<typename KernelType, typename MetricType, typename TreeType>
+void KDE<KernelType, MetricType, TreeType>::AddPrunedEstimates(
+    TreeType& node,
+    const double parentEstimate,
+    arma::vec& estimates)
+{
+  const double estimate = parentEstimate + node.Stat().PrunedEstimate();
+  node.Stat().PrunedEstimate() = 0.0;
+
+  // Only leaves hold their points; this also avoids adding the estimate twice
+  // to points that belong to both a node and one of its children (as in trees
+  // with self-children).
+  if (node.NumChildren() == 0)
+  {
+    for (size_t i = 0; i < node.NumPoints(); ++i)
+      estimates[node.Point(i)] += estimate;
+  }
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    AddPrunedEstimates(node.Child(i), estimate, estimates);
+}
+
+}; // namespace kde
+}; // namespace mlpack
+
+#endif
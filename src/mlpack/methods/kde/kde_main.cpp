@@ -0,0 +1,248 @@
+/**
+ * @file kde_main.cpp
+ *
+ * Executable for kernel density estimation with dual-tree (or single-tree)
+ * algorithms.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/epanechnikov_kernel.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/spherical_kernel.hpp>
+#include <mlpack/core/kernels/triangular_kernel.hpp>
+
+#include "kde.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::kde;
+using namespace mlpack::kernel;
+using namespace mlpack::tree;
+
+// Information about the program itself.
+PROGRAM_INFO("Kernel Density Estimation",
+    "This program performs kernel density estimation: given a set of reference "
+    "points and a kernel with a bandwidth, it estimates the density of the "
+    "reference set at each query point.  If no query set is given, the density "
+    "is estimated at each reference point.  The available kernels are "
+    "'gaussian', 'epanechnikov', 'triangular' and 'spherical'."
+    "\n\n"
+    "The estimates are computed with a dual-tree algorithm on kd-trees, which "
+    "approximates the contribution of groups of reference points whose kernel "
+    "values barely change.  The error of each estimate is at most --rel_error "
+    "times the true density plus --abs_error divided by the normalizing "
+    "constant of the kernel; if both are 0, the estimates are exact.  The "
+    "estimates are normalized, so they are true probability densities."
+    "\n\n"
+    "For example, the following will estimate the density of 'input.csv' at "
+    "each point of 'queries.csv' with a Gaussian kernel of bandwidth 0.5, to "
+    "within 1% of each density, and store the estimates in 'density.csv':"
+    "\n\n"
+    "$ kde --reference_file=input.csv --query_file=queries.csv\n"
+    "  --bandwidth=0.5 --rel_error=0.01 --output_file=density.csv"
+    "\n\n"
+    "Line i of the output file holds the estimate at query point i.");
+
+// Define our input parameters that this program will take.
+PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
+    "r");
+PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
+PARAM_STRING_REQ("output_file", "File to output the density estimates into.",
+    "o");
+
+PARAM_STRING("kernel", "Kernel to use: 'gaussian', 'epanechnikov', "
+    "'triangular' or 'spherical'.", "k", "gaussian");
+PARAM_DOUBLE("bandwidth", "Bandwidth of the kernel.", "b", 1.0);
+PARAM_DOUBLE("rel_error", "Relative error tolerance of each estimate.", "e",
+    0.05);
+PARAM_DOUBLE("abs_error", "Absolute error tolerance of each (unnormalized) "
+    "kernel value.", "E", 0.0);
+
+PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
+PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
+PARAM_FLAG("single_mode", "If true, single-tree estimation is used (as opposed "
+    "to dual-tree estimation).", "s");
+
+typedef BinarySpaceTree<bound::HRectBound<2>, KDEStat> KDETreeType;
+
+/**
+ * Estimate the density at each query point (or each reference point, if
+ * queryData is empty) with the given kernel, placing the estimates in the
+ * original order of the points.  The datasets are rearranged in place during
+ * tree building, so they are never copied (except in naive mode).
+ */
+template<typename KernelType>
+void RunKDE(KernelType& kernel,
+            arma::mat& referenceData,
+            arma::mat& queryData,
+            const double relError,
+            const double absError,
+            const size_t leafSize,
+            const bool naive,
+            const bool singleMode,
+            arma::vec& estimates)
+{
+  typedef KDE<KernelType, metric::EuclideanDistance, KDETreeType> KDEType;
+
+  if (naive)
+  {
+    KDEType kde(referenceData, kernel, relError, absError, true);
+    kde.Evaluate(queryData.n_cols > 0 ? queryData : referenceData, estimates);
+  }
+  else
+  {
+    // The reference points are only rearranged, so the mapping is needed when
+    // the density is estimated at each of them.
+    Log::Info << "Building reference tree..." << endl;
+    Timer::Start("tree_building");
+
+    vector<size_t> oldFromNewRefs;
+    KDETreeType referenceTree(referenceData, oldFromNewRefs, leafSize);
+
+    Timer::Stop("tree_building");
+
+    KDEType kde(&referenceTree, referenceData, kernel, relError, absError,
+        singleMode);
+    kde.NumThreads() = CLI::HasParam("threads") ? util::NumThreads() : 1;
+
+    if (singleMode)
+    {
+      // Single-tree estimates are in the order of the query points.
+      if (queryData.n_cols > 0)
+      {
+        kde.Evaluate(queryData, estimates);
+      }
+      else
+      {
+        arma::vec treeEstimates;
+        kde.Evaluate(referenceData, treeEstimates);
+
+        estimates.set_size(treeEstimates.n_elem);
+        for (size_t i = 0; i < treeEstimates.n_elem; ++i)
+          estimates[oldFromNewRefs[i]] = treeEstimates[i];
+      }
+    }
+    else
+    {
+      vector<size_t> oldFromNewQueries;
+      KDETreeType* queryTree = &referenceTree;
+      if (queryData.n_cols > 0)
+      {
+        Log::Info << "Building query tree..." << endl;
+        Timer::Start("tree_building");
+
+        queryTree = new KDETreeType(queryData, oldFromNewQueries, leafSize);
+
+        Timer::Stop("tree_building");
+      }
+      else
+      {
+        oldFromNewQueries = oldFromNewRefs;
+      }
+
+      Log::Info << "Trees built." << endl;
+
+      arma::vec treeEstimates;
+      kde.Evaluate(queryTree, treeEstimates);
+
+      estimates.set_size(treeEstimates.n_elem);
+      for (size_t i = 0; i < treeEstimates.n_elem; ++i)
+        estimates[oldFromNewQueries[i]] = treeEstimates[i];
+
+      if (queryTree != &referenceTree)
+        delete queryTree;
+    }
+
+    kde.Statistics().Print();
+  }
+
+  estimates /= kernel.Normalizer(referenceData.n_rows);
+}
+
+int main(int argc, char *argv[])
+{
+  // Give CLI the command line parameters the user passed in.
+  CLI::ParseCommandLine(argc, argv);
+
+  const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string queryFile = CLI::GetParam<string>("query_file");
+  const string outputFile = CLI::GetParam<string>("output_file");
+  const string kernelType = CLI::GetParam<string>("kernel");
+  const double bandwidth = CLI::GetParam<double>("bandwidth");
+  const double relError = CLI::GetParam<double>("rel_error");
+  const double absError = CLI::GetParam<double>("abs_error");
+  const int lsInt = CLI::GetParam<int>("leaf_size");
+  const bool naive = CLI::HasParam("naive");
+  const bool singleMode = CLI::HasParam("single_mode");
+
+  // Sanity checks on the parameters.
+  if (bandwidth <= 0.0)
+  {
+    Log::Fatal << "Invalid bandwidth: " << bandwidth << ".  Must be greater "
+        << "than 0." << endl;
+  }
+
+  if (lsInt <= 0)
+  {
+    Log::Fatal << "Invalid leaf size: " << lsInt << ".  Must be greater than "
+        << "0." << endl;
+  }
+  const size_t leafSize = (size_t) lsInt;
+
+  if (singleMode && naive)
+  {
+    Log::Warn << "--single_mode ignored because --naive is present." << endl;
+  }
+
+  arma::mat referenceData;
+  data::Load(referenceFile, referenceData, true);
+  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
+
+  arma::mat queryData;
+  if (queryFile != "")
+  {
+    data::Load(queryFile, queryData, true);
+    Log::Info << "Loaded query data from '" << queryFile << "' ("
+        << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
+
+    if (queryData.n_rows != referenceData.n_rows)
+    {
+      Log::Fatal << "Query data has " << queryData.n_rows << " dimensions, "
+          << "but reference data has " << referenceData.n_rows << "!" << endl;
+    }
+  }
+
+  arma::vec estimates;
+  if (kernelType == "gaussian")
+  {
+    GaussianKernel kernel(bandwidth);
+    RunKDE(kernel, referenceData, queryData, relError, absError, leafSize,
+        naive, singleMode, estimates);
+  }
+  else if (kernelType == "epanechnikov")
+  {
+    EpanechnikovKernel kernel(bandwidth);
+    RunKDE(kernel, referenceData, queryData, relError, absError, leafSize,
+        naive, singleMode, estimates);
+  }
+  else if (kernelType == "triangular")
+  {
+    TriangularKernel kernel(bandwidth);
+    RunKDE(kernel, referenceData, queryData, relError, absError, leafSize,
+        naive, singleMode, estimates);
+  }
+  else if (kernelType == "spherical")
+  {
+    SphericalKernel kernel(bandwidth);
+    RunKDE(kernel, referenceData, queryData, relError, absError, leafSize,
+        naive, singleMode, estimates);
+  }
+  else
+  {
+    Log::Fatal << "Unknown kernel type '" << kernelType << "'; must be "
+        << "'gaussian', 'epanechnikov', 'triangular' or 'spherical'." << endl;
+  }
+
+  // One estimate on each line.
+  data::Save(outputFile, estimates, true, false);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file kde_rules.hpp
+ *
+ * Rules for dual-tree and single-tree kernel density estimation, so that it can
+ * be done with arbitrary tree types.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_RULES_HPP
+#define __MLPACK_METHODS_KDE_KDE_RULES_HPP
+
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+#include "../neighbor_search/ns_traversal_info.hpp"
+
+namespace mlpack {
+namespace kde {
+
+/**
+ * The rules for kernel density estimation.  The kernel must be a function of
+ * the distance only (KernelType::Evaluate(double) must exist), and it must be
+ * non-increasing in the distance, as all of GaussianKernel, EpanechnikovKernel,
+ * TriangularKernel and SphericalKernel are.  Then, if the distances between a
+ * query point (or node) and the points of a reference node are in the range
+ * [dMin, dMax], every kernel value is in [K(dMax), K(dMin)], and if
+ *
+ * @f[
+ * K(d_{min}) - K(d_{max}) \le 2 \max(\epsilon_{rel} K(d_{max}), \epsilon_{abs})
+ * @f]
+ *
+ * the node combination is pruned: each kernel value is approximated by
+ * (K(dMin) + K(dMax)) / 2, which is within the larger of relError times the
+ * true value and absError of it.  A reference node that is out of the support
+ * of a compact kernel gives K(dMin) = K(dMax) = 0, so it is always pruned
+ * without adding anything.
+ *
+ * The rules hold the unnormalized kernel sum of each query point; see
+ * KDE::Evaluate() for the estimates themselves.
+ */
+template<typename MetricType, typename KernelType, typename TreeType>
+class KDERules
+{
+ public:
+  /**
+   * Construct the KDERules object.  This is usually done from within the KDE
+   * class at evaluation time.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param estimates Vector to add the kernel sum of each query point to.
+   * @param relError Relative error tolerance of each kernel value.
+   * @param absError Absolute error tolerance of each kernel value.
+   * @param metric Instantiated metric.
+   * @param kernel Instantiated kernel.
+   */
+  KDERules(const typename TreeType::Mat& referenceSet,
+           const typename TreeType::Mat& querySet,
+           arma::vec& estimates,
+           const double relError,
+           const double absError,
+           MetricType& metric,
+           KernelType& kernel);
+
+  /**
+   * Compute the base case between the given query point and reference point,
+   * adding the kernel value to the sum of the query point.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceIndex Index of reference point.
+   */
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  /**
+   * Get the score for recursion order.  If the reference node can be
+   * approximated for the given query point, its approximate kernel sum is
+   * added and DBL_MAX is returned (the node is pruned); otherwise the score is
+   * the minimum distance to the node, so that the closest nodes, which hold
+   * most of the density, are visited first.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   */
+  double Score(const size_t queryIndex, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.  Nothing that is learned during
+   * the traversal makes pruning any easier, so this just returns the old
+   * score.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+  /**
+   * Get the score for recursion order.  If the reference node can be
+   * approximated for every point of the query node, its approximate kernel sum
+   * is added to the statistic of the query node (see KDEStat) and DBL_MAX is
+   * returned (the combination is pruned); otherwise the score is the minimum
+   * distance between the nodes.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   */
+  double Score(TreeType& queryNode, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.  Nothing that is learned during
+   * the traversal makes pruning any easier, so this just returns the old
+   * score.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+  typedef neighbor::NeighborSearchTraversalInfo<TreeType> TraversalInfoType;
+
+  const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
+  TraversalInfoType& TraversalInfo() { return traversalInfo; }
+
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+ private:
+  //! The reference set.
+  const typename TreeType::Mat& referenceSet;
+
+  //! The query set.
+  const typename TreeType::Mat& querySet;
+
+  //! The kernel sum of each query point.
+  arma::vec& estimates;
+
+  //! The relative error tolerance.
+  const double relError;
+
+  //! The absolute error tolerance.
+  const double absError;
+
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! The instantiated kernel.
+  KernelType& kernel;
+
+  //! The last query index.
+  size_t lastQueryIndex;
+  //! The last reference index.
+  size_t lastReferenceIndex;
+
+  /**
+   * If every kernel value between points at the given distances can be
+   * approximated, set the approximate sum of the given number of them and
+   * return true.
+   */
+  bool CanPrune(const math::Range& distances,
+                const size_t numReferences,
+                double& approximation);
+
+  TraversalInfoType traversalInfo;
+
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
+};
+
+}; // namespace kde
+}; // namespace mlpack
+
+// Include implementation.
+#include "kde_rules_impl.hpp"
+
+#endif
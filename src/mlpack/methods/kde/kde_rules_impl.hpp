@@ -0,0 +1,152 @@
+/**
+ * @file kde_rules_impl.hpp
+ *
+ * Implementation of rules for kernel density estimation with generic trees.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_RULES_IMPL_HPP
+#define __MLPACK_METHODS_KDE_KDE_RULES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kde_rules.hpp"
+
+namespace mlpack {
+namespace kde {
+
+template<typename MetricType, typename KernelType, typename TreeType>
+KDERules<MetricType, KernelType, TreeType>::KDERules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    arma::vec& estimates,
+    const double relError,
+    const double absError,
+    MetricType& metric,
+    KernelType& kernel) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    estimates(estimates),
+    relError(relError),
+    absError(absError),
+    metric(metric),
+    kernel(kernel),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols)
+{
+  // Nothing to do.
+}
+
+//! The base case.  Evaluate the kernel between the two points and add it to the
+//! sum of the query point.
+template<typename MetricType, typename KernelType, typename TreeType>
+inline force_inline
+double KDERules<MetricType, KernelType, TreeType>::BaseCase(
+    const size_t queryIndex,
+    const size_t referenceIndex)
+{
+  // If we have just performed this base case, don't do it again.
+  if ((lastQueryIndex == queryIndex) && (lastReferenceIndex == referenceIndex))
+    return 0.0; // No value to return... this shouldn't do anything bad.
+
+  const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
+      referenceSet.unsafe_col(referenceIndex));
+  ++statistics.BaseCases();
+
+  // Update last indices, so we don't accidentally perform a base case twice.
+  lastQueryIndex = queryIndex;
+  lastReferenceIndex = referenceIndex;
+
+  estimates[queryIndex] += kernel.Evaluate(distance);
+
+  return distance;
+}
+
+//! Single-tree scoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Score(
+    const size_t queryIndex,
+    TreeType& referenceNode)
+{
+  const math::Range distances =
+      referenceNode.RangeDistance(querySet.unsafe_col(queryIndex));
+
+  double approximation;
+  if (CanPrune(distances, referenceNode.NumDescendants(), approximation))
+  {
+    estimates[queryIndex] += approximation;
+    return statistics.Score(DBL_MAX, referenceNode);
+  }
+
+  return statistics.Score(distances.Lo(), referenceNode);
+}
+
+//! Single-tree rescoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Rescore(
+    const size_t /* queryIndex */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  // If it wasn't pruned before, it isn't pruned now.
+  return oldScore;
+}
+
+//! Dual-tree scoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Score(
+    TreeType& queryNode,
+    TreeType& referenceNode)
+{
+  const math::Range distances = referenceNode.RangeDistance(&queryNode);
+
+  // The approximation is the same for every query point in the node, so it is
+  // only added to its statistic, not to each of its descendants.
+  double approximation;
+  if (CanPrune(distances, referenceNode.NumDescendants(), approximation))
+  {
+    queryNode.Stat().PrunedEstimate() += approximation;
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
+  }
+
+  traversalInfo.LastQueryNode() = &queryNode;
+  traversalInfo.LastReferenceNode() = &referenceNode;
+  return statistics.Score(distances.Lo(), queryNode, referenceNode);
+}
+
+//! Dual-tree rescoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Rescore(
+    TreeType& /* queryNode */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  // If it wasn't pruned before, it isn't pruned now.
+  return oldScore;
+}
+
+//! Check whether kernel values between points at the given distances can be
+//! approximated.
+template<typename MetricType, typename KernelType, typename TreeType>
+inline force_inline
+bool KDERules<MetricType, KernelType, TreeType>::CanPrune(
+    const math::Range& distances,
+    const size_t numReferences,
+    double& approximation)
+{
+  // The kernel is non-increasing, so the largest kernel value is at the
+  // smallest distance.
+  const double maxKernel = kernel.Evaluate(distances.Lo());
+  const double minKernel = kernel.Evaluate(distances.Hi());
+
+  // minKernel is a lower bound on every true kernel value, so this tolerance
+  // is never more than relError times the true value (or absError).
+  const double tolerance = std::max(relError * minKernel, absError);
+  if (maxKernel - minKernel > 2 * tolerance)
+    return false;
+
+  approximation = numReferences * (maxKernel + minKernel) / 2.0;
+  return true;
+}
+
+}; // namespace kde
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,52 @@
+/**
+ * @file kde_stat.hpp
+ *
+ * Statistic class for KDE, which holds the kernel sums that were added to every
+ * point of a query node at once when a node combination was pruned.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_STAT_HPP
+#define __MLPACK_METHODS_KDE_KDE_STAT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kde {
+
+/**
+ * Statistic class for KDE, to be set to the StatisticType of the tree type that
+ * kernel density estimation is being performed with.  When the dual-tree
+ * traversal prunes a combination of a query node and a reference node, the
+ * approximated kernel sum of the reference node is the same for every query
+ * point in the query node, so instead of adding it to each of the descendants
+ * of the query node it is added once to this statistic.  After the traversal,
+ * the statistics are pushed down to the points (see KDE::Evaluate()).
+ */
+class KDEStat
+{
+ public:
+  /**
+   * Initialize the statistic.
+   */
+  KDEStat() : prunedEstimate(0.0) { }
+
+  /**
+   * Initialize the statistic given a tree node that this statistic belongs to.
+   * In this case, we ignore the node.
+   */
+  template<typename TreeType>
+  KDEStat(TreeType& /* node */) : prunedEstimate(0.0) { }
+
+  //! Get the kernel sum to be added to every descendant of the node.
+  double PrunedEstimate() const { return prunedEstimate; }
+  //! Modify the kernel sum to be added to every descendant of the node.
+  double& PrunedEstimate() { return prunedEstimate; }
+
+ private:
+  //! The kernel sum to be added to every descendant of the node.
+  double prunedEstimate;
+};
+
+}; // namespace kde
+}; // namespace mlpack
+
+#endif
@@ -27,6 +27,21 @@ namespace kpca {
  * There are numerous available kernels in the mlpack::kernel namespace (see
  * files in mlpack/core/kernels/) and it is easy to write your own; see other
  * implementations for examples.
+ *
+ * Apply() fits the model and transforms the data it was fit to at once.  To
+ * project new points too, fit the model with Train(); the points (or any other
+ * points) can then be projected with Transform(), at the cost of one kernel
+ * evaluation with every training point per point, and the model can be saved
+ * and restored with a util::SaveRestoreUtility.
+ *
+ * @code
+ * extern arma::mat data, newData;
+ * KernelPCA<kernel::GaussianKernel> kpca(kernel::GaussianKernel(2.0));
+ * kpca.Train(data, 3);
+ *
+ * arma::mat transformed;
+ * kpca.Transform(newData, transformed);
+ * @endcode
  */
 template <
   typename KernelType,
@@ -101,6 +116,53 @@ class KernelPCA
    */
   void Apply(arma::mat& data, const size_t newDimension);
 
+  /**
+   * Fit the model to the given data set, so that points can be projected with
+   * Transform().  This stores the training points, the leading newDimension
+   * eigenvectors of the centered kernel matrix (scaled by the inverse square
+   * roots of their eigenvalues), and the means of the kernel matrix that the
+   * centering needs; they take O(n (d + newDimension)) memory, and the means
+   * take O(n^2) more kernel evaluations.
+   *
+   * The kernel rule must give the eigenvectors over the training points, as
+   * NaiveKernelRule, MatrixFreeKernelRule and RandomFeaturesKernelRule do (with
+   * the last, projections use the exact kernel, so they are only close to
+   * those of Apply()).  NystroemKernelRule does not.
+   *
+   * @param data Data matrix.
+   * @param newDimension Number of components to keep (0 keeps all of them).
+   */
+  void Train(const arma::mat& data, const size_t newDimension = 0);
+
+  /**
+   * Project the given points with the model fit by Train().  A point x is
+   * mapped to P^T k', where k' is the vector of kernel values between x and the
+   * training points, centered with the means of the kernel matrix, and P holds
+   * the scaled eigenvectors; so the training points are mapped as Apply()
+   * would map them.  The points are projected in parallel if OpenMP is
+   * available.
+   *
+   * @param data Points to project.
+   * @param transformedData Matrix to store the projections in (one column per
+   *     point).
+   */
+  void Transform(const arma::mat& data, arma::mat& transformedData) const;
+
+  //! Get the training points of the fitted model.
+  const arma::mat& TrainingData() const { return trainingData; }
+  //! Get the scaled eigenvectors of the fitted model (one column each).
+  const arma::mat& Projection() const { return projection; }
+
+  /**
+   * Save the fitted model to a SaveRestoreUtility.  The kernel is not saved, so
+   * it must be set again (when this object is constructed) before a loaded
+   * model is used.
+   */
+  void Save(util::SaveRestoreUtility& sr) const;
+
+  //! Load a fitted model from a SaveRestoreUtility.
+  void Load(const util::SaveRestoreUtility& sr);
+
   //! Get the kernel.
   const KernelType& Kernel() const { return kernel; }
   //! Modify the kernel.
@@ -121,6 +183,17 @@ class KernelPCA
   //! run.
   bool centerTransformedData;
 
+  //! The training points of the fitted model.
+  arma::mat trainingData;
+  //! The eigenvectors of the fitted model, scaled by the inverse square roots
+  //! of their eigenvalues.
+  arma::mat projection;
+  //! The sums of the columns of the projection.
+  arma::vec projectionSums;
+  //! What the centering of the kernel values (and of the transformed data, if
+  //! it is centered) subtracts from each projection.
+  arma::vec offsets;
+
 }; // class KernelPCA
 
 }; // namespace kpca
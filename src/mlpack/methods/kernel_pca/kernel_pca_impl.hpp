@@ -72,10 +72,129 @@ void KernelPCA<KernelType, KernelRule>::Apply(arma::mat& data,
 
   Apply(data, data, eigVal, coeffs, newDimension);
 
-  if (newDimension < coeffs.n_rows && newDimension > 0)
+  // Some kernel rules only compute newDimension components.
+  if (newDimension < data.n_rows && newDimension > 0)
     data.shed_rows(newDimension, data.n_rows - 1);
 }
 
+//! Fit the model to the provided data set.
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Train(const arma::mat& data,
+                                              const size_t newDimension)
+{
+  arma::mat transformedData, eigvec;
+  arma::vec eigval;
+  KernelRule::ApplyKernelMatrix(data, transformedData, eigval, eigvec,
+                                newDimension, kernel);
+
+  if (eigvec.n_rows != data.n_cols)
+  {
+    Log::Fatal << "KernelPCA::Train(): the kernel rule does not give the "
+        << "eigenvectors over the training points, so new points cannot be "
+        << "projected!" << std::endl;
+  }
+
+  const size_t components = (newDimension == 0) ? eigvec.n_cols :
+      std::min(newDimension, (size_t) eigvec.n_cols);
+  projection = eigvec.cols(0, components - 1);
+  projection.each_row() /= arma::trans(arma::sqrt(eigval.subvec(0,
+      components - 1)));
+
+  // The means of the rows of the kernel matrix, which is symmetric.
+  arma::vec kernelMeans(data.n_cols);
+  #pragma omp parallel
+  {
+    KernelType threadKernel(kernel);
+
+    #pragma omp for schedule(dynamic, 16)
+    for (size_t i = 0; i < data.n_cols; ++i)
+    {
+      double sum = 0.0;
+      for (size_t j = 0; j < data.n_cols; ++j)
+        sum += threadKernel.Evaluate(data.unsafe_col(i), data.unsafe_col(j));
+      kernelMeans[i] = sum / data.n_cols;
+    }
+  }
+
+  // With k the kernel values of a point, the centered values are
+  //   k - mean(k) 1 - kernelMeans + mean(kernelMeans) 1,
+  // so the projection is P^T k - mean(k) P^T 1 - offsets.
+  projectionSums = arma::trans(arma::sum(projection, 0));
+  offsets = arma::trans(projection) * kernelMeans -
+      arma::mean(kernelMeans) * projectionSums;
+
+  if (centerTransformedData)
+    offsets += arma::mean(transformedData.rows(0, components - 1), 1);
+
+  trainingData = data;
+}
+
+//! Project points with the fitted model.
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Transform(
+    const arma::mat& data,
+    arma::mat& transformedData) const
+{
+  if (projection.n_cols == 0)
+  {
+    Log::Fatal << "KernelPCA::Transform(): the model has not been trained!"
+        << std::endl;
+  }
+
+  if (data.n_rows != trainingData.n_rows)
+  {
+    Log::Fatal << "KernelPCA::Transform(): the points have " << data.n_rows
+        << " dimensions, but the training points have " << trainingData.n_rows
+        << "!" << std::endl;
+  }
+
+  transformedData.set_size(projection.n_cols, data.n_cols);
+
+  // Each point is projected independently.
+  #pragma omp parallel
+  {
+    KernelType threadKernel(kernel);
+    arma::vec kernelValues(trainingData.n_cols);
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < data.n_cols; ++i)
+    {
+      for (size_t j = 0; j < trainingData.n_cols; ++j)
+      {
+        kernelValues[j] = threadKernel.Evaluate(data.unsafe_col(i),
+            trainingData.unsafe_col(j));
+      }
+
+      transformedData.col(i) = arma::trans(projection) * kernelValues -
+          arma::mean(kernelValues) * projectionSums - offsets;
+    }
+  }
+}
+
+//! Save the fitted model.
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Save(
+    util::SaveRestoreUtility& sr) const
+{
+  sr.SaveParameter(centerTransformedData, "centerTransformedData");
+  sr.SaveParameter(trainingData, "trainingData");
+  sr.SaveParameter(projection, "projection");
+  sr.SaveParameter(projectionSums, "projectionSums");
+  sr.SaveParameter(offsets, "offsets");
+}
+
+//! Load a fitted model.
+template <typename KernelType, typename KernelRule>
+void KernelPCA<KernelType, KernelRule>::Load(
+    const util::SaveRestoreUtility& sr)
+{
+  sr.LoadParameter(centerTransformedData, "centerTransformedData");
+  sr.LoadParameter(trainingData, "trainingData");
+  sr.LoadParameter(projection, "projection");
+  sr.LoadParameter(projectionSums, "projectionSums");
+  sr.LoadParameter(offsets, "offsets");
+}
+
 //! Returns a string representation of the object.
 template <typename KernelType, typename KernelRule>
 std::string KernelPCA<KernelType, KernelRule>::ToString() const
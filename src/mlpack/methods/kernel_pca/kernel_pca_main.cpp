@@ -8,8 +8,10 @@
 #include <mlpack/methods/nystroem_method/ordered_selection.hpp>
 #include <mlpack/methods/nystroem_method/random_selection.hpp>
 #include <mlpack/methods/nystroem_method/kmeans_selection.hpp>
+#include <mlpack/methods/nystroem_method/sampled_kmeans_selection.hpp>
 #include <mlpack/methods/nystroem_method/nystroem_method.hpp>
 #include <mlpack/methods/kernel_pca/kernel_rules/nystroem_method.hpp>
+#include <mlpack/methods/kernel_pca/kernel_rules/matrix_free_method.hpp>
 
 #include "kernel_pca.hpp"
 
@@ -70,7 +72,16 @@ PROGRAM_INFO("Kernel Principal Components Analysis",
     " a subset of the data as basis to reconstruct the kernel matrix; to specify"
     " the sampling scheme, the --sampling parameter is used, the sampling scheme"
     " for the nystr\u00F6m method can be chosen from the following list: kmeans,"
-    " random, ordered.");
+    " sampled-kmeans, random, ordered.  The 'sampled-kmeans' scheme clusters "
+    "only a random sample of the data, and is much faster than 'kmeans' on "
+    "large datasets."
+    "\n\n"
+    "Alternately, the leading eigenvectors of the exact kernel matrix can be "
+    "computed without storing the kernel matrix, by specifying the "
+    "--matrix_free (-m) option.  This needs only O(n * d) memory, where d is "
+    "the new dimensionality, but evaluates the kernel matrix once for each "
+    "iteration, so it is meant for a small new dimensionality on datasets "
+    "whose kernel matrix does not fit in memory.");
 
 PARAM_STRING_REQ("input_file", "Input dataset to perform KPCA on.", "i");
 PARAM_STRING_REQ("output_file", "File to save modified dataset to.", "o");
@@ -85,9 +96,11 @@ PARAM_FLAG("center", "If set, the transformed data will be centered about the "
     "origin.", "c");
 
 PARAM_FLAG("nystroem_method", "If set, the nystroem method will be used.", "n");
+PARAM_FLAG("matrix_free", "If set, the kernel matrix will not be stored, and "
+    "the components will be computed iteratively.", "m");
 
 PARAM_STRING("sampling", "Sampling scheme to use for the nystroem method: "
-    "'kmeans', 'random', 'ordered'", "s", "kmeans");
+    "'kmeans', 'sampled-kmeans', 'random', 'ordered'", "s", "kmeans");
 
 PARAM_DOUBLE("kernel_scale", "Scale, for 'hyptan' kernel.", "S", 1.0);
 PARAM_DOUBLE("offset", "Offset, for 'hyptan' and 'polynomial' kernels.", "O",
@@ -102,6 +115,7 @@ template<typename KernelType>
 void RunKPCA(arma::mat& dataset,
              const bool centerTransformedData,
              const bool nystroem,
+             const bool matrixFree,
              const size_t newDim,
              const string& sampling,
              KernelType& kernel)
@@ -115,6 +129,12 @@ void RunKPCA(arma::mat& dataset,
           KMeansSelection<> > >kpca;
       kpca.Apply(dataset, newDim);
     }
+    else if (sampling == "sampled-kmeans")
+    {
+      KernelPCA<KernelType, NystroemKernelRule<KernelType,
+          SampledKMeansSelection<> > > kpca;
+      kpca.Apply(dataset, newDim);
+    }
     else if (sampling == "random")
     {
       KernelPCA<KernelType, NystroemKernelRule<KernelType,
@@ -131,9 +151,16 @@ void RunKPCA(arma::mat& dataset,
     {
       // Invalid sampling scheme.
       Log::Fatal << "Invalid sampling scheme ('" << sampling << "'); valid "
-        << "choices are 'kmeans', 'random' and 'ordered'" << endl;
+        << "choices are 'kmeans', 'sampled-kmeans', 'random' and 'ordered'"
+        << endl;
     }
   }
+  else if (matrixFree)
+  {
+    KernelPCA<KernelType, MatrixFreeKernelRule<KernelType> > kpca(kernel,
+        centerTransformedData);
+    kpca.Apply(dataset, newDim);
+  }
   else
   {
     KernelPCA<KernelType> kpca(kernel, centerTransformedData);
@@ -170,21 +197,25 @@ int main(int argc, char** argv)
 
   const bool centerTransformedData = CLI::HasParam("center");
   const bool nystroem = CLI::HasParam("nystroem_method");
+  const bool matrixFree = CLI::HasParam("matrix_free");
+  if (nystroem && matrixFree)
+    Log::Fatal << "Only one of --nystroem_method and --matrix_free may be "
+        << "specified!" << endl;
   const string sampling = CLI::GetParam<string>("sampling");
 
   if (kernelType == "linear")
   {
     LinearKernel kernel;
-    RunKPCA<LinearKernel>(dataset, centerTransformedData, nystroem, newDim,
-        sampling, kernel);
+    RunKPCA<LinearKernel>(dataset, centerTransformedData, nystroem,
+        matrixFree, newDim, sampling, kernel);
   }
   else if (kernelType == "gaussian")
   {
     const double bandwidth = CLI::GetParam<double>("bandwidth");
 
     GaussianKernel kernel(bandwidth);
-    RunKPCA<GaussianKernel>(dataset, centerTransformedData, nystroem, newDim,
-        sampling, kernel);
+    RunKPCA<GaussianKernel>(dataset, centerTransformedData, nystroem,
+        matrixFree, newDim, sampling, kernel);
   }
   else if (kernelType == "polynomial")
   {
@@ -193,7 +224,7 @@ int main(int argc, char** argv)
 
     PolynomialKernel kernel(degree, offset);
     RunKPCA<PolynomialKernel>(dataset, centerTransformedData, nystroem,
-        newDim, sampling, kernel);
+        matrixFree, newDim, sampling, kernel);
   }
   else if (kernelType == "hyptan")
   {
@@ -202,15 +233,15 @@ int main(int argc, char** argv)
 
     HyperbolicTangentKernel kernel(scale, offset);
     RunKPCA<HyperbolicTangentKernel>(dataset, centerTransformedData, nystroem,
-        newDim, sampling, kernel);
+        matrixFree, newDim, sampling, kernel);
   }
   else if (kernelType == "laplacian")
   {
     const double bandwidth = CLI::GetParam<double>("bandwidth");
 
     LaplacianKernel kernel(bandwidth);
-    RunKPCA<LaplacianKernel>(dataset, centerTransformedData, nystroem, newDim,
-        sampling, kernel);
+    RunKPCA<LaplacianKernel>(dataset, centerTransformedData, nystroem,
+        matrixFree, newDim, sampling, kernel);
   }
   else if (kernelType == "epanechnikov")
   {
@@ -218,13 +249,13 @@ int main(int argc, char** argv)
 
     EpanechnikovKernel kernel(bandwidth);
     RunKPCA<EpanechnikovKernel>(dataset, centerTransformedData, nystroem,
-        newDim, sampling, kernel);
+        matrixFree, newDim, sampling, kernel);
   }
   else if (kernelType == "cosine")
   {
     CosineDistance kernel;
-    RunKPCA<CosineDistance>(dataset, centerTransformedData, nystroem, newDim,
-        sampling, kernel);
+    RunKPCA<CosineDistance>(dataset, centerTransformedData, nystroem,
+        matrixFree, newDim, sampling, kernel);
   }
   else
   {
@@ -0,0 +1,166 @@
+/**
+ * @file matrix_free_method.hpp
+ *
+ * Use block subspace iteration on the centered kernel matrix, evaluating the
+ * kernel matrix a block at a time, so that it is never stored.
+ */
+
+#ifndef __MLPACK_METHODS_KERNEL_PCA_MATRIX_FREE_METHOD_HPP
+#define __MLPACK_METHODS_KERNEL_PCA_MATRIX_FREE_METHOD_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/nystroem_method/kernel_block.hpp>
+
+namespace mlpack {
+namespace kpca {
+
+/**
+ * The MatrixFreeKernelRule computes the leading eigenvectors of the centered
+ * kernel matrix by block subspace iteration with Rayleigh-Ritz extraction.
+ * Each iteration multiplies the centered kernel matrix by an n x (rank + 10)
+ * basis; the product is computed in parallel over blocks of blockSize rows,
+ * from kernel blocks of blockSize x blockSize points which are evaluated as
+ * needed (see kernel::KernelBlock()), and the centering is applied to the
+ * product with the means of the rows of the kernel matrix.  So the memory
+ * used is O(n * rank) instead of the O(n^2) of NaiveKernelRule, and the
+ * results are the same up to the convergence of the iteration, which stops
+ * when the leading rank Ritz values change by less than a relative 1e-6.
+ *
+ * Each iteration evaluates the whole kernel matrix once, so this rule is meant
+ * for a few components of datasets whose kernel matrix does not fit in memory.
+ *
+ * @tparam KernelType Kernel to be used for computation.
+ * @tparam maxIterations Maximum number of subspace iterations.
+ * @tparam blockSize Number of points in each block of the kernel matrix.
+ */
+template<typename KernelType,
+         size_t maxIterations = 20,
+         size_t blockSize = 512>
+class MatrixFreeKernelRule
+{
+  public:
+    /**
+     * Compute the leading eigenvectors of the centered kernel matrix without
+     * storing it.
+     *
+     * @param data Input data points.
+     * @param transformedData Matrix to output results into.
+     * @param eigval KPCA eigenvalues will be written to this vector.
+     * @param eigvec KPCA eigenvectors will be written to this matrix.
+     * @param rank Number of components to compute.
+     * @param kernel Kernel to be used for computation.
+     */
+    static void ApplyKernelMatrix(const arma::mat& data,
+                                  arma::mat& transformedData,
+                                  arma::vec& eigval,
+                                  arma::mat& eigvec,
+                                  const size_t rank,
+                                  KernelType kernel = KernelType())
+  {
+    const size_t n = data.n_cols;
+    const size_t k = (rank == 0) ? n : std::min(rank, n);
+    const size_t l = std::min(n, k + 10);
+
+    // The means of the rows of the kernel matrix are needed for the
+    // "psuedo-centering" (see NaiveKernelRule).
+    arma::mat x(n, 1);
+    x.fill(1.0 / n);
+    arma::mat y;
+    Multiply(data, kernel, x, y);
+    const arma::vec rowMean = y.col(0);
+    const double mean = arma::mean(rowMean);
+
+    arma::mat q, r, ritzVectors;
+    arma::vec ritzValues, lastValues;
+    x.randn(n, l);
+    arma::qr_econ(q, r, x);
+
+    for (size_t i = 0; i < maxIterations; ++i)
+    {
+      CenteredMultiply(data, kernel, rowMean, mean, q, y);
+
+      // The Ritz values are in increasing order.
+      arma::eig_sym(ritzValues, ritzVectors,
+          arma::symmatu(arma::trans(q) * y));
+      eigval = arma::flipud(ritzValues.subvec(l - k, l - 1));
+
+      if (i > 0 && arma::max(arma::abs(eigval - lastValues)) <=
+          1e-6 * std::abs(eigval[0]))
+        break;
+
+      lastValues = eigval;
+      if (i + 1 < maxIterations)
+        arma::qr_econ(q, r, y);
+    }
+
+    // y is the product of the centered kernel matrix and q, so the product of
+    // the centered kernel matrix and the eigenvectors is y times the Ritz
+    // vectors.
+    const arma::mat top = arma::fliplr(ritzVectors.cols(l - k, l - 1));
+    eigvec = q * top;
+    transformedData = arma::trans(y * top);
+    transformedData.each_col() /= arma::sqrt(eigval);
+  }
+
+  private:
+    //! Compute y = K x, where K is the kernel matrix.
+    static void Multiply(const arma::mat& data,
+                         KernelType& kernel,
+                         const arma::mat& x,
+                         arma::mat& y)
+    {
+      const size_t numBlocks = (data.n_cols + blockSize - 1) / blockSize;
+      y.set_size(data.n_cols, x.n_cols);
+
+      #pragma omp parallel
+      {
+        arma::mat block;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t b = 0; b < numBlocks; ++b)
+        {
+          const size_t begin = b * blockSize;
+          const size_t end = std::min((size_t) data.n_cols, begin + blockSize);
+          const arma::mat rows(const_cast<double*>(data.colptr(begin)),
+              data.n_rows, end - begin, false, true);
+
+          y.rows(begin, end - 1).zeros();
+          for (size_t c = 0; c < numBlocks; ++c)
+          {
+            const size_t colBegin = c * blockSize;
+            const size_t colEnd = std::min((size_t) data.n_cols,
+                colBegin + blockSize);
+            const arma::mat cols(const_cast<double*>(data.colptr(colBegin)),
+                data.n_rows, colEnd - colBegin, false, true);
+
+            kernel::KernelBlock(kernel, rows, cols, block);
+            y.rows(begin, end - 1) += block * x.rows(colBegin, colEnd - 1);
+          }
+        }
+      }
+    }
+
+    /**
+     * Compute y = K' x, where K' = K - r 1^T - 1 r^T + mean 1 1^T is the
+     * centered kernel matrix, r holds the means of the rows of K, and mean is
+     * the mean of r.
+     */
+    static void CenteredMultiply(const arma::mat& data,
+                                 KernelType& kernel,
+                                 const arma::vec& rowMean,
+                                 const double mean,
+                                 const arma::mat& x,
+                                 arma::mat& y)
+    {
+      Multiply(data, kernel, x, y);
+
+      const arma::rowvec sums = arma::sum(x, 0);
+      y -= rowMean * sums;
+      y.each_row() -= arma::trans(rowMean) * x - mean * sums;
+    }
+};
+
+}; // namespace kpca
+}; // namespace mlpack
+
+#endif
@@ -24,14 +24,15 @@ class NaiveKernelRule
      * @param transformedData Matrix to output results into.
      * @param eigval KPCA eigenvalues will be written to this vector.
      * @param eigvec KPCA eigenvectors will be written to this matrix.
-     * @param rank Rank to be used for matrix approximation.
+     * @param rank Number of components needed; if it is much smaller than the
+     *     number of points, only that many are computed.
      * @param kernel Kernel to be used for computation.
      */
     static void ApplyKernelMatrix(const arma::mat& data,
                                   arma::mat& transformedData,
                                   arma::vec& eigval,
                                   arma::mat& eigvec,
-                                  const size_t /* unused */,
+                                  const size_t rank,
                                   KernelType kernel = KernelType())
   {
     // Construct the kernel matrix.
@@ -67,16 +68,28 @@ class NaiveKernelRule
     kernelMatrix.each_row() -= rowMean;
     kernelMatrix += arma::sum(rowMean) / kernelMatrix.n_cols;
 
-    // Eigendecompose the centered kernel matrix.
-    arma::eig_sym(eigval, eigvec, kernelMatrix);
+    if (rank > 0 && math::PreferRandomizedSVD(rank, kernelMatrix.n_rows,
+        kernelMatrix.n_cols))
+    {
+      // The centered kernel matrix is symmetric positive semidefinite, so its
+      // singular vectors are its eigenvectors; when only a few are needed,
+      // the randomized SVD finds them (largest first).
+      arma::mat v;
+      math::RandomizedSVD(kernelMatrix, rank, eigvec, eigval, v);
+    }
+    else
+    {
+      // Eigendecompose the centered kernel matrix.
+      arma::eig_sym(eigval, eigvec, kernelMatrix);
 
-    // Swap the eigenvalues since they are ordered backwards (we need largest to
-    // smallest).
-    for (size_t i = 0; i < floor(eigval.n_elem / 2.0); ++i)
-      eigval.swap_rows(i, (eigval.n_elem - 1) - i);
+      // Swap the eigenvalues since they are ordered backwards (we need largest
+      // to smallest).
+      for (size_t i = 0; i < floor(eigval.n_elem / 2.0); ++i)
+        eigval.swap_rows(i, (eigval.n_elem - 1) - i);
 
-    // Flip the coefficients to produce the same effect.
-    eigvec = arma::fliplr(eigvec);
+      // Flip the coefficients to produce the same effect.
+      eigvec = arma::fliplr(eigvec);
+    }
 
     transformedData = eigvec.t() * kernelMatrix;
     transformedData.each_col() /= arma::sqrt(eigval);
@@ -0,0 +1,176 @@
+/**
+ * @file random_features_method.hpp
+ *
+ * Use random Fourier features to approximate shift-invariant kernels, and
+ * perform linear PCA on the features.
+ */
+
+#ifndef __MLPACK_METHODS_KERNEL_PCA_RANDOM_FEATURES_METHOD_HPP
+#define __MLPACK_METHODS_KERNEL_PCA_RANDOM_FEATURES_METHOD_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kpca {
+
+/**
+ * The RandomFourierFeatures class maps points to an explicit feature space in
+ * which the dot product approximates a shift-invariant kernel, as described in
+ * the paper 'Random Features for Large-Scale Kernel Machines' by A. Rahimi and
+ * B. Recht.  Each of the numFeatures features of a point x is
+ *
+ * z_i(x) = \sqrt{2 / D} \cos(w_i^T x + b_i),
+ *
+ * where the frequencies w_i are drawn from the Fourier transform of the kernel
+ * and the phases b_i are uniform in [0, 2 \pi).  The features of a set of
+ * points are computed with one matrix multiplication.  Since the frequencies
+ * are fixed when the object is constructed, chunks of a dataset can be mapped
+ * one at a time (for instance, for StreamingPCA).
+ *
+ * The GaussianKernel and the LaplacianKernel are supported.
+ *
+ * @tparam KernelType Shift-invariant kernel to approximate.
+ */
+template<typename KernelType>
+class RandomFourierFeatures
+{
+ public:
+  /**
+   * Draw the frequencies and the phases of the features.
+   *
+   * @param kernel Kernel to approximate.
+   * @param dimensionality Dimensionality of the points.
+   * @param numFeatures Number of features D.
+   */
+  RandomFourierFeatures(const KernelType& kernel,
+                        const size_t dimensionality,
+                        const size_t numFeatures)
+  {
+    Sample(kernel, dimensionality, numFeatures, frequencies);
+    phases = (2 * M_PI) * arma::randu<arma::vec>(numFeatures);
+  }
+
+  /**
+   * Map the given points to the feature space.
+   *
+   * @param data Points to map (one column for each point).
+   * @param features Matrix to store the features in (one column for each
+   *     point).
+   */
+  void Map(const arma::mat& data, arma::mat& features) const
+  {
+    if (data.n_rows != frequencies.n_cols)
+      Log::Fatal << "RandomFourierFeatures::Map(): the points have "
+          << "dimensionality " << data.n_rows << ", but the features were "
+          << "drawn for dimensionality " << frequencies.n_cols << "!"
+          << std::endl;
+
+    features = frequencies * data;
+
+    const double scale = std::sqrt(2.0 / frequencies.n_rows);
+    #pragma omp parallel for schedule(static)
+    for (size_t j = 0; j < features.n_cols; ++j)
+      for (size_t i = 0; i < features.n_rows; ++i)
+        features(i, j) = scale * std::cos(features(i, j) + phases[i]);
+  }
+
+  //! Get the number of features.
+  size_t NumFeatures() const { return frequencies.n_rows; }
+  //! Get the frequencies (one row for each feature).
+  const arma::mat& Frequencies() const { return frequencies; }
+  //! Get the phases.
+  const arma::vec& Phases() const { return phases; }
+
+ private:
+  //! The frequency of each feature (one row for each feature).
+  arma::mat frequencies;
+  //! The phase of each feature.
+  arma::vec phases;
+
+  //! The Fourier transform of the Gaussian kernel is Gaussian, with variance
+  //! 1 / bandwidth^2.
+  static void Sample(const kernel::GaussianKernel& kernel,
+                     const size_t dimensionality,
+                     const size_t numFeatures,
+                     arma::mat& frequencies)
+  {
+    frequencies.randn(numFeatures, dimensionality);
+    frequencies /= kernel.Bandwidth();
+  }
+
+  //! The Fourier transform of the Laplacian kernel is the multivariate Cauchy
+  //! distribution, which is a multivariate t distribution with one degree of
+  //! freedom: a Gaussian vector divided by the norm of a standard normal.
+  static void Sample(const kernel::LaplacianKernel& kernel,
+                     const size_t dimensionality,
+                     const size_t numFeatures,
+                     arma::mat& frequencies)
+  {
+    frequencies.randn(numFeatures, dimensionality);
+    const arma::vec scales = arma::abs(arma::randn<arma::vec>(numFeatures)) *
+        kernel.Bandwidth();
+    frequencies.each_col() /= scales;
+  }
+};
+
+/**
+ * The RandomFeaturesKernelRule approximates the kernel matrix by the dot
+ * products of numFeatures random Fourier features of the points (see
+ * RandomFourierFeatures), and performs linear PCA on the centered features.
+ * This takes O(n D) time and memory instead of the O(n^2) of NaiveKernelRule;
+ * the accuracy of the approximation of each kernel value is O(1 / \sqrt{D}).
+ *
+ * @tparam KernelType Shift-invariant kernel (GaussianKernel or
+ *     LaplacianKernel).
+ * @tparam numFeatures Number of random features D.
+ */
+template<typename KernelType, size_t numFeatures = 1024>
+class RandomFeaturesKernelRule
+{
+  public:
+    /**
+     * Approximate the kernel matrix with random Fourier features, and compute
+     * the principal components of the features.
+     *
+     * @param data Input data points.
+     * @param transformedData Matrix to output results into.
+     * @param eigval KPCA eigenvalues will be written to this vector.
+     * @param eigvec KPCA eigenvectors will be written to this matrix.
+     * @param rank Number of components needed (at most numFeatures are
+     *     computed).
+     * @param kernel Kernel to be used for computation.
+     */
+    static void ApplyKernelMatrix(const arma::mat& data,
+                                  arma::mat& transformedData,
+                                  arma::vec& eigval,
+                                  arma::mat& eigvec,
+                                  const size_t rank,
+                                  KernelType kernel = KernelType())
+  {
+    RandomFourierFeatures<KernelType> map(kernel, data.n_rows, numFeatures);
+    arma::mat features;
+    map.Map(data, features);
+
+    // Centering the features centers the approximate kernel matrix.
+    features.each_col() -= arma::mean(features, 1);
+
+    // The nonzero eigenvalues of the kernel matrix Z^T Z are those of Z Z^T;
+    // if Z Z^T u = lambda u, the eigenvector of Z^T Z is Z^T u / sqrt(lambda).
+    arma::mat vectors;
+    arma::eig_sym(eigval, vectors, features * arma::trans(features));
+
+    const size_t k = (rank == 0) ? numFeatures : std::min(rank,
+        (size_t) numFeatures);
+    eigval = arma::flipud(eigval.subvec(numFeatures - k, numFeatures - 1));
+    vectors = arma::fliplr(vectors.cols(numFeatures - k, numFeatures - 1));
+
+    transformedData = arma::trans(vectors) * features;
+    eigvec = arma::trans(transformedData);
+    eigvec.each_row() /= arma::trans(arma::sqrt(eigval));
+  }
+};
+
+}; // namespace kpca
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file accumulate_point.hpp
+ *
+ * Add a (possibly weighted) point of a dense or sparse dataset to a column of a
+ * matrix of centroid sums, without creating a temporary vector for the point.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_ACCUMULATE_POINT_HPP
+#define __MLPACK_METHODS_KMEANS_ACCUMULATE_POINT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * Add the given point of a dense dataset to the given column of the centroid
+ * sums.
+ *
+ * @param dataset Dataset holding the point.
+ * @param point Index of the point in the dataset.
+ * @param sums Matrix of centroid sums.
+ * @param cluster Index of the column of the sums to add the point to.
+ * @param weight Weight to multiply the point by (default 1).
+ */
+template<typename eT>
+inline void AccumulatePoint(const arma::Mat<eT>& dataset,
+                            const size_t point,
+                            arma::mat& sums,
+                            const size_t cluster,
+                            const double weight = 1.0)
+{
+  const eT* p = dataset.colptr(point);
+  double* s = sums.colptr(cluster);
+  for (size_t d = 0; d < dataset.n_rows; ++d)
+    s[d] += weight * p[d];
+}
+
+/**
+ * Add the given point of a sparse dataset to the given column of the centroid
+ * sums.  Only the nonzero elements of the point are visited.
+ *
+ * @param dataset Dataset holding the point.
+ * @param point Index of the point in the dataset.
+ * @param sums Matrix of centroid sums.
+ * @param cluster Index of the column of the sums to add the point to.
+ * @param weight Weight to multiply the point by (default 1).
+ */
+template<typename eT>
+inline void AccumulatePoint(const arma::SpMat<eT>& dataset,
+                            const size_t point,
+                            arma::mat& sums,
+                            const size_t cluster,
+                            const double weight = 1.0)
+{
+  typename arma::SpMat<eT>::const_iterator it = dataset.begin_col(point);
+  for ( ; it != dataset.end_col(point); ++it)
+    sums(it.row(), cluster) += weight * (*it);
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -23,6 +23,9 @@ class AllowEmptyClusters
   //! Default constructor required by EmptyClusterPolicy policy.
   AllowEmptyClusters() { }
 
+  //! This function does nothing; there is no state to reset.
+  static inline force_inline void Reset() { }
+
   /**
    * This function does nothing.  It is called by K-Means when K-Means detects
    * an empty cluster.
@@ -32,7 +35,8 @@ class AllowEmptyClusters
    * @param emptyCluster Index of cluster which is empty.
    * @param centroids Centroids of each cluster (one per column).
    * @param clusterCounts Number of points in each cluster.
-   * @param assignments Cluster assignments of each point.
+   * @param metric Instantiated metric.
+   * @param iteration Number of the current iteration.
    *
    * @return Number of points changed (0).
    */
@@ -42,7 +46,8 @@ class AllowEmptyClusters
       const size_t /* emptyCluster */,
       const arma::mat& /* centroids */,
       arma::Col<size_t>& /* clusterCounts */,
-      MetricType& /* metric */)
+      MetricType& /* metric */,
+      const size_t /* iteration */)
   {
     // Empty clusters are okay!  Do nothing.
     return 0;
@@ -0,0 +1,116 @@
+/**
+ * @file centroid_tree.hpp
+ *
+ * A tree built on the centroids for the dual-tree Lloyd iterations, which is
+ * kept between iterations while the centroids move only a little.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_CENTROID_TREE_HPP
+#define __MLPACK_METHODS_KMEANS_CENTROID_TREE_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <boost/utility/enable_if.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * A tree on the current centroids, for the Lloyd steps that traverse a
+ * centroid tree and a tree on the points together (DualTreeKMeans and
+ * DTNNKMeans).  Building the centroid tree and initializing its statistics
+ * every iteration is wasted work once the centroids only move slightly, so
+ * instead, when the tree type supports it (BinarySpaceTree::RefitBounds()),
+ * the tree is kept and its bounds are refitted to the new centroids.  Refitted
+ * bounds are exact, so the results do not change; the tree only gets looser
+ * as the centroids move, which makes pruning less effective.  Therefore the
+ * tree is rebuilt once the centroids have moved (in total, since it was built)
+ * further than a given fraction of the radius of the tree.
+ *
+ * The tree is built on a copy of the centroids, which the tree may rearrange;
+ * Centroids() and OldFromNew() give the centroids in the order of the tree and
+ * the mapping back to the original order.
+ */
+template<typename MetricType, typename TreeType>
+class CentroidTree
+{
+ public:
+  /**
+   * Create the CentroidTree object.  No tree is built until Update() is
+   * called.
+   *
+   * @param rebuildThreshold The tree is rebuilt when the centroids have moved
+   *     further than this fraction of the radius of the tree since it was
+   *     built; 0 rebuilds it every time.
+   */
+  CentroidTree(const double rebuildThreshold = 0.1);
+
+  //! Delete the tree.
+  ~CentroidTree();
+
+  /**
+   * Make the tree hold the given centroids, either by refitting the current
+   * tree or by building a new one.
+   *
+   * @param centroids Current centroids (in their original order).
+   * @param metric Metric used to measure how far the centroids moved.
+   * @param distanceCalculations Incremented by the number of distance
+   *     calculations done.
+   * @return true if a new tree was built (so any pointers into the old tree
+   *     are no longer valid).
+   */
+  bool Update(const arma::mat& centroids,
+              MetricType& metric,
+              size_t& distanceCalculations);
+
+  //! Get the tree (Update() must have been called).
+  TreeType& Tree() { return *tree; }
+
+  //! Get the centroids, in the order of the tree.
+  const arma::mat& Centroids() const { return treeCentroids; }
+
+  //! Get the mapping from the tree's order of the centroids to the original
+  //! order (empty if the tree does not rearrange its dataset).
+  const std::vector<size_t>& OldFromNew() const { return oldFromNew; }
+
+  //! Get the rebuild threshold.
+  double RebuildThreshold() const { return rebuildThreshold; }
+  //! Modify the rebuild threshold.
+  double& RebuildThreshold() { return rebuildThreshold; }
+
+  //! Get the number of times the tree has been built.
+  size_t Builds() const { return builds; }
+
+ private:
+  //! The tree on the centroids.
+  TreeType* tree;
+  //! The centroids the tree is built on, in the order of the tree.
+  arma::mat treeCentroids;
+  //! Mapping from the order of the tree to the original order.
+  std::vector<size_t> oldFromNew;
+
+  //! The fraction of the radius of the tree that the centroids may move
+  //! before the tree is rebuilt.
+  double rebuildThreshold;
+  //! The radius of the tree when it was built.
+  double builtRadius;
+  //! The total distance the centroids have moved since the tree was built.
+  double drift;
+  //! The number of times the tree has been built.
+  size_t builds;
+
+  //! Build a new tree on the given centroids.
+  void Build(const arma::mat& centroids);
+
+  //! Not copyable, because the tree can only be deleted once.
+  CentroidTree(const CentroidTree& other);
+  //! Not copyable, because the tree can only be deleted once.
+  CentroidTree& operator=(const CentroidTree& other);
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "centroid_tree_impl.hpp"
+
+#endif
@@ -0,0 +1,151 @@
+/**
+ * @file centroid_tree_impl.hpp
+ *
+ * Implementation of the CentroidTree class, which keeps a tree on the centroids
+ * between Lloyd iterations.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_CENTROID_TREE_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_CENTROID_TREE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "centroid_tree.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+//! Call the tree constructor that does mapping.
+template<typename TreeType>
+TreeType* BuildTree(
+    typename TreeType::Mat& dataset,
+    std::vector<size_t>& oldFromNew,
+    typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
+    >::type = 0)
+{
+  // This is a hack.  I know this will be BinarySpaceTree, so force a leaf size
+  // of two.
+  return new TreeType(dataset, oldFromNew, 1);
+}
+
+//! Call the tree constructor that does not do mapping.
+template<typename TreeType>
+TreeType* BuildTree(
+    const typename TreeType::Mat& dataset,
+    const std::vector<size_t>& /* oldFromNew */,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset);
+}
+
+//! Whether or not the bounds of a tree can be refitted to its modified
+//! dataset; only BinarySpaceTree supports this.
+template<typename TreeType>
+struct CanRefit
+{
+  static const bool value = false;
+};
+
+//! BinarySpaceTree can be refitted with RefitBounds().
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+struct CanRefit<tree::BinarySpaceTree<BoundType, StatisticType, MatType,
+    SplitType> >
+{
+  static const bool value = true;
+};
+
+//! Refit a BinarySpaceTree to its modified dataset.
+template<typename BoundType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType>
+void RefitTree(
+    tree::BinarySpaceTree<BoundType, StatisticType, MatType, SplitType>& tree)
+{
+  tree.RefitBounds();
+}
+
+//! Other trees can't be refitted (this is never called, because CanRefit is
+//! false for them).
+template<typename TreeType>
+void RefitTree(TreeType& /* tree */) { }
+
+template<typename MetricType, typename TreeType>
+CentroidTree<MetricType, TreeType>::CentroidTree(
+    const double rebuildThreshold) :
+    tree(NULL),
+    rebuildThreshold(rebuildThreshold),
+    builtRadius(0.0),
+    drift(0.0),
+    builds(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType>
+CentroidTree<MetricType, TreeType>::~CentroidTree()
+{
+  if (tree)
+    delete tree;
+}
+
+template<typename MetricType, typename TreeType>
+bool CentroidTree<MetricType, TreeType>::Update(
+    const arma::mat& centroids,
+    MetricType& metric,
+    size_t& distanceCalculations)
+{
+  if (tree != NULL && CanRefit<TreeType>::value &&
+      treeCentroids.n_cols == centroids.n_cols)
+  {
+    // How far did the centroids move since the last update?
+    double maxMovement = 0.0;
+    for (size_t i = 0; i < treeCentroids.n_cols; ++i)
+    {
+      const size_t old = oldFromNew.empty() ? i : oldFromNew[i];
+      const double movement = metric.Evaluate(treeCentroids.col(i),
+          centroids.col(old));
+      if (movement > maxMovement)
+        maxMovement = movement;
+    }
+    distanceCalculations += treeCentroids.n_cols;
+
+    if (drift + maxMovement <= rebuildThreshold * builtRadius)
+    {
+      drift += maxMovement;
+      for (size_t i = 0; i < treeCentroids.n_cols; ++i)
+        treeCentroids.col(i) = centroids.col(oldFromNew.empty() ? i :
+            oldFromNew[i]);
+
+      RefitTree(*tree);
+      return false;
+    }
+  }
+
+  Build(centroids);
+  return true;
+}
+
+template<typename MetricType, typename TreeType>
+void CentroidTree<MetricType, TreeType>::Build(const arma::mat& centroids)
+{
+  if (tree)
+    delete tree;
+
+  treeCentroids = centroids;
+  oldFromNew.clear();
+  tree = BuildTree<TreeType>(treeCentroids, oldFromNew);
+
+  builtRadius = tree->FurthestDescendantDistance();
+  drift = 0.0;
+  ++builds;
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -13,6 +13,8 @@
 #include <mlpack/core/tree/binary_space_tree.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include "centroid_tree.hpp"
 
 namespace mlpack {
 namespace kmeans {
@@ -34,8 +36,18 @@ class DTNNKMeans
  public:
   /**
    * Construct the DTNNKMeans object, which will construct a tree on the points.
+   * The tree on the centroids is kept between iterations, with its bounds
+   * refitted, until the centroids have moved further than rebuildThreshold
+   * times its radius (see CentroidTree).
+   *
+   * @param dataset Dataset to cluster.
+   * @param metric Instantiated metric.
+   * @param rebuildThreshold Fraction of the radius of the centroid tree the
+   *     centroids may move before it is rebuilt; 0 rebuilds it every iteration.
    */
-  DTNNKMeans(const MatType& dataset, MetricType& metric);
+  DTNNKMeans(const MatType& dataset,
+             MetricType& metric,
+             const double rebuildThreshold = 0.1);
 
   /**
    * Delete the tree constructed by the DTNNKMeans object.
@@ -59,6 +71,14 @@ class DTNNKMeans
   //! Modify the number of distance calculations.
   size_t& DistanceCalculations() { return distanceCalculations; }
 
+  //! Get the number of times the centroid tree has been built.
+  size_t CentroidTreeBuilds() const { return centroidTree.Builds(); }
+
+  //! Get the traversal statistics of tree building and all iterations.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of tree building and all iterations.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
  private:
   //! The original dataset reference.
   const MatType& datasetOrig; // Maybe not necessary.
@@ -71,10 +91,15 @@ class DTNNKMeans
 
   //! The tree built on the points.
   TreeType* tree;
+  //! The tree built on the centroids.
+  CentroidTree<MetricType, TreeType> centroidTree;
 
   //! Track distance calculations.
   size_t distanceCalculations;
 
+  //! The traversal statistics of tree building and all iterations.
+  tree::TraversalStatistics statistics;
+
   //! Update the bounds in the tree before the next iteration.
   void UpdateTree(TreeType& node, const double tolerance);
 };
@@ -13,45 +13,27 @@
 // In case it hasn't been included yet.
 #include "dtnn_kmeans.hpp"
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace kmeans {
 
-//! Call the tree constructor that does mapping.
-template<typename TreeType>
-TreeType* BuildTree(
-    typename TreeType::Mat& dataset,
-    std::vector<size_t>& oldFromNew,
-    typename boost::enable_if_c<
-        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
-    >::type = 0)
-{
-  // This is a hack.  I know this will be BinarySpaceTree, so force a leaf size
-  // of two.
-  return new TreeType(dataset, oldFromNew, 1);
-}
-
-//! Call the tree constructor that does not do mapping.
-template<typename TreeType>
-TreeType* BuildTree(
-    const typename TreeType::Mat& dataset,
-    const std::vector<size_t>& /* oldFromNew */,
-    const typename boost::enable_if_c<
-        tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
-    >::type = 0)
-{
-  return new TreeType(dataset);
-}
-
 template<typename MetricType, typename MatType, typename TreeType>
-DTNNKMeans<MetricType, MatType, TreeType>::DTNNKMeans(const MatType& dataset,
-                                                      MetricType& metric) :
+DTNNKMeans<MetricType, MatType, TreeType>::DTNNKMeans(
+    const MatType& dataset,
+    MetricType& metric,
+    const double rebuildThreshold) :
     datasetOrig(dataset),
     dataset(tree::TreeTraits<TreeType>::RearrangesDataset ? datasetCopy :
         datasetOrig),
     metric(metric),
+    centroidTree(rebuildThreshold),
     distanceCalculations(0)
 {
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   // Copy the dataset, if necessary.
   if (tree::TreeTraits<TreeType>::RearrangesDataset)
@@ -60,6 +42,7 @@ DTNNKMeans<MetricType, MatType, TreeType>::DTNNKMeans(const MatType& dataset,
   // Now build the tree.  We don't need any mappings.
   tree = new TreeType(const_cast<typename TreeType::Mat&>(this->dataset));
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
 }
 
@@ -80,33 +63,54 @@ double DTNNKMeans<MetricType, MatType, TreeType>::Iterate(
   newCentroids.zeros(centroids.n_rows, centroids.n_cols);
   counts.zeros(centroids.n_cols);
 
-  // Build a tree on the centroids.
-  std::vector<size_t> oldFromNewCentroids;
-  TreeType* centroidTree = BuildTree<TreeType>(
-      const_cast<typename TreeType::Mat&>(centroids), oldFromNewCentroids);
+  // Refit or rebuild the tree on the centroids.
+  statistics.StartPhase("centroid_tree_building");
+  centroidTree.Update(centroids, metric, distanceCalculations);
+  statistics.StopPhase("centroid_tree_building");
+  const arma::mat& treeCentroids = centroidTree.Centroids();
+  const std::vector<size_t>& oldFromNewCentroids = centroidTree.OldFromNew();
 
   typedef neighbor::NeighborSearch<neighbor::NearestNeighborSort, MetricType,
       TreeType> AllkNNType;
-  AllkNNType allknn(centroidTree, tree, centroids, dataset, false, metric);
+  AllkNNType allknn(&centroidTree.Tree(), tree, treeCentroids, dataset, false,
+      metric);
+
+  // The tree on the points is the query tree, so the dual-tree traversal can
+  // split it between the threads.
+#ifdef HAS_OPENMP
+  allknn.NumThreads() = (size_t) omp_get_max_threads();
+#endif
 
   // This is a lot of overhead.  We don't need the distances.
   arma::mat distances;
   arma::Mat<size_t> assignments;
   allknn.Search(1, assignments, distances);
   distanceCalculations += allknn.BaseCases() + allknn.Scores();
+  statistics += allknn.Statistics();
 
-  // From the assignments, calculate the new centroids and counts.
-  for (size_t i = 0; i < dataset.n_cols; ++i)
+  // From the assignments, calculate the new centroids and counts.  The points
+  // are split across threads; each thread sums its points into its own
+  // centroids and counts, which are added together at the end.
+  #pragma omp parallel
   {
-    if (tree::TreeTraits<TreeType>::RearrangesDataset)
+    arma::mat threadCentroids;
+    threadCentroids.zeros(centroids.n_rows, centroids.n_cols);
+    arma::Col<size_t> threadCounts;
+    threadCounts.zeros(centroids.n_cols);
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < dataset.n_cols; ++i)
     {
-      newCentroids.col(oldFromNewCentroids[assignments[i]]) += dataset.col(i);
-      ++counts(oldFromNewCentroids[assignments[i]]);
+      const size_t cluster = (tree::TreeTraits<TreeType>::RearrangesDataset) ?
+          oldFromNewCentroids[assignments[i]] : assignments[i];
+      threadCentroids.col(cluster) += dataset.col(i);
+      ++threadCounts(cluster);
     }
-    else
+
+    #pragma omp critical
     {
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
+      newCentroids += threadCentroids;
+      counts += threadCounts;
     }
   }
 
@@ -125,7 +129,7 @@ double DTNNKMeans<MetricType, MatType, TreeType>::Iterate(
     else
     {
       newCentroids.col(old) /= counts(old);
-      const double movement = metric.Evaluate(centroids.col(c),
+      const double movement = metric.Evaluate(treeCentroids.col(c),
           newCentroids.col(old));
       residual += std::pow(movement, 2.0);
 
@@ -137,8 +141,6 @@ double DTNNKMeans<MetricType, MatType, TreeType>::Iterate(
 
   UpdateTree(*tree, maxMovement);
 
-  delete centroidTree;
-
   return std::sqrt(residual);
 }
 
@@ -7,7 +7,10 @@
 #ifndef __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_HPP
 #define __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_HPP
 
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
 #include "dual_tree_kmeans_statistic.hpp"
+#include "centroid_tree.hpp"
 
 namespace mlpack {
 namespace kmeans {
@@ -21,7 +24,22 @@ template<
 class DualTreeKMeans
 {
  public:
-  DualTreeKMeans(const MatType& dataset, MetricType& metric);
+  /**
+   * Construct the DualTreeKMeans object, which will construct a tree on the
+   * points.  The tree on the centroids is kept between iterations, with its
+   * bounds refitted, until the centroids have moved further than
+   * rebuildThreshold times its radius (see CentroidTree); while it is kept, the
+   * closest centroid node found for each node of the point tree is carried
+   * over to the next iteration.
+   *
+   * @param dataset Dataset to cluster.
+   * @param metric Instantiated metric.
+   * @param rebuildThreshold Fraction of the radius of the centroid tree the
+   *     centroids may move before it is rebuilt; 0 rebuilds it every iteration.
+   */
+  DualTreeKMeans(const MatType& dataset,
+                 MetricType& metric,
+                 const double rebuildThreshold = 0.1);
 
   ~DualTreeKMeans();
 
@@ -34,6 +52,14 @@ class DualTreeKMeans
   //! Modify the number of distance calculations.
   size_t& DistanceCalculations() { return distanceCalculations; }
 
+  //! Get the number of times the centroid tree has been built.
+  size_t CentroidTreeBuilds() const { return centroidTree.Builds(); }
+
+  //! Get the traversal statistics of tree building and all iterations.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of tree building and all iterations.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
  private:
   //! The original dataset reference.
   const MatType& datasetOrig;
@@ -46,6 +72,8 @@ class DualTreeKMeans
 
   //! The tree built on the points.
   TreeType* tree;
+  //! The tree built on the centroids.
+  CentroidTree<MetricType, TreeType> centroidTree;
 
   arma::vec clusterDistances;
   arma::Col<size_t> assignments;
@@ -57,6 +85,13 @@ class DualTreeKMeans
 
   //! Track distance calculations.
   size_t distanceCalculations;
+
+  //! The traversal statistics of tree building and all iterations.
+  tree::TraversalStatistics statistics;
+
+  //! Forget the closest centroid nodes of the given node and its descendants,
+  //! because the centroid tree they point into has been deleted.
+  void ResetClosestQueryNodes(TreeType& node);
 };
 
 template<typename MetricType, typename MatType>
@@ -10,6 +10,7 @@
 // In case it hasn't been included yet.
 #include "dual_tree_kmeans.hpp"
 #include "dual_tree_kmeans_rules.hpp"
+#include "subtree_split.hpp"
 
 namespace mlpack {
 namespace kmeans {
@@ -17,11 +18,13 @@ namespace kmeans {
 template<typename MetricType, typename MatType, typename TreeType>
 DualTreeKMeans<MetricType, MatType, TreeType>::DualTreeKMeans(
     const MatType& dataset,
-    MetricType& metric) :
+    MetricType& metric,
+    const double rebuildThreshold) :
     datasetOrig(dataset),
     dataset(tree::TreeTraits<TreeType>::RearrangesDataset ? datasetCopy :
         datasetOrig),
     metric(metric),
+    centroidTree(rebuildThreshold),
     iteration(0),
     distanceCalculations(0)
 {
@@ -31,6 +34,7 @@ DualTreeKMeans<MetricType, MatType, TreeType>::DualTreeKMeans(
   distanceIteration.zeros(dataset.n_cols);
 
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   // Copy the dataset, if necessary.
   if (tree::TreeTraits<TreeType>::RearrangesDataset)
@@ -39,6 +43,7 @@ DualTreeKMeans<MetricType, MatType, TreeType>::DualTreeKMeans(
   // Now build the tree.  We don't need any mappings.
   tree = new TreeType(const_cast<typename TreeType::Mat&>(this->dataset));
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
 }
 
@@ -63,40 +68,85 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
     clusterDistances.fill(DBL_MAX / 2.0); // To prevent overflow.
   }
 
-  // Build a tree on the centroids.
-  std::vector<size_t> oldFromNewCentroids;
-  TreeType* centroidTree = BuildTree<TreeType>(
-      const_cast<typename TreeType::Mat&>(centroids), oldFromNewCentroids);
-
-  // Now run the dual-tree algorithm.
+  // Refit or rebuild the tree on the centroids.  If it was rebuilt, the
+  // closest centroid nodes from the last iteration are gone.
+  statistics.StartPhase("centroid_tree_building");
+  if (centroidTree.Update(centroids, metric, distanceCalculations))
+    ResetClosestQueryNodes(*tree);
+  statistics.StopPhase("centroid_tree_building");
+  const arma::mat& treeCentroids = centroidTree.Centroids();
+  const std::vector<size_t>& oldFromNewCentroids = centroidTree.OldFromNew();
+
+  // Split the tree on the points into subtrees for the threads.  The nodes
+  // above the subtrees, and the roots of the subtrees (which are the roots of
+  // their traversals), aren't scored, so their statistics are prepared for
+  // this iteration here, parents first; no clusters are pruned for them.
   typedef DualTreeKMeansRules<MetricType, TreeType> RulesType;
-  RulesType rules(dataset, centroids, newCentroids, counts, oldFromNewCentroids,
-      iteration, clusterDistances, distances, assignments, distanceIteration,
-      metric);
-
-  // Use the dual-tree traverser.
-//typename TreeType::template DualTreeTraverser<RulesType> traverser(rules);
-  typename TreeType::template BreadthFirstDualTreeTraverser<RulesType>
-      traverser(rules);
+  std::vector<TreeType*> subtrees, ancestors;
+  SplitIntoSubtrees(*tree, subtrees, ancestors);
+  {
+    RulesType rules(dataset, treeCentroids, newCentroids, counts,
+        oldFromNewCentroids, iteration, clusterDistances, distances,
+        assignments, distanceIteration, metric);
+    for (size_t i = 0; i < ancestors.size(); ++i)
+      rules.IterationUpdate(*ancestors[i]);
+    for (size_t i = 0; i < subtrees.size(); ++i)
+      rules.IterationUpdate(*subtrees[i]);
+  }
 
-  traverser.Traverse(*centroidTree, *tree);
+  // Now run the dual-tree algorithm.  Each thread traverses its subtrees with
+  // its own rules object, which sums the points into its own centroids and
+  // counts; these are added together at the end.  Each subtree only touches
+  // the statistics of its own nodes and the assignments and distances of its
+  // own points, so nothing else has to be shared.
+  statistics.StartPhase("traversal");
+  #pragma omp parallel
+  {
+    arma::mat threadCentroids;
+    threadCentroids.zeros(centroids.n_rows, centroids.n_cols);
+    arma::Col<size_t> threadCounts;
+    threadCounts.zeros(centroids.n_cols);
+
+    RulesType rules(dataset, treeCentroids, threadCentroids, threadCounts,
+        oldFromNewCentroids, iteration, clusterDistances, distances,
+        assignments, distanceIteration, metric);
+    typename TreeType::template BreadthFirstDualTreeTraverser<RulesType>
+        traverser(rules);
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      // Base cases look at the pruned clusters of the last reference node,
+      // which starts as the root of the subtree.
+      rules.TraversalInfo().LastReferenceNode() = subtrees[i];
+      traverser.Traverse(centroidTree.Tree(), *subtrees[i]);
+    }
 
-  distanceCalculations += rules.DistanceCalculations();
+    #pragma omp critical
+    {
+      newCentroids += threadCentroids;
+      counts += threadCounts;
+      distanceCalculations += rules.DistanceCalculations();
+      statistics += rules.Statistics();
+    }
+  }
+  statistics.StopPhase("traversal");
 
   // Now, calculate how far the clusters moved, after normalizing them.
   double residual = 0.0;
   clusterDistances.zeros();
   for (size_t c = 0; c < centroids.n_cols; ++c)
   {
-    if (counts[c] == 0)
+    const size_t oldCluster = oldFromNewCentroids[c];
+    if (counts[oldCluster] == 0)
     {
-      newCentroids.col(c).fill(DBL_MAX); // Should have happened anyway I think.
+      // Should have happened anyway I think.
+      newCentroids.col(oldCluster).fill(DBL_MAX);
     }
     else
     {
-      const size_t oldCluster = oldFromNewCentroids[c];
       newCentroids.col(oldCluster) /= counts(oldCluster);
-      const double dist = metric.Evaluate(centroids.col(c),
+      const double dist = metric.Evaluate(treeCentroids.col(c),
                                           newCentroids.col(oldCluster));
       if (dist > clusterDistances[centroids.n_cols])
         clusterDistances[centroids.n_cols] = dist;
@@ -106,12 +156,19 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
   }
   Log::Info << clusterDistances.t();
 
-  delete centroidTree;
-
   ++iteration;
   return std::sqrt(residual);
 }
 
+template<typename MetricType, typename MatType, typename TreeType>
+void DualTreeKMeans<MetricType, MatType, TreeType>::ResetClosestQueryNodes(
+    TreeType& node)
+{
+  node.Stat().ClosestQueryNode() = NULL;
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    ResetClosestQueryNodes(node.Child(i));
+}
+
 } // namespace kmeans
 } // namespace mlpack
 
@@ -7,6 +7,8 @@
 #ifndef __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_RULES_HPP
 #define __MLPACK_METHODS_KMEANS_DUAL_TREE_KMEANS_RULES_HPP
 
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
 namespace mlpack {
 namespace kmeans {
 
@@ -43,11 +45,25 @@ class DualTreeKMeansRules
   size_t DistanceCalculations() const { return distanceCalculations; }
   size_t& DistanceCalculations() { return distanceCalculations; }
 
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
   typedef neighbor::NeighborSearchTraversalInfo<TreeType> TraversalInfoType;
 
   const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
   TraversalInfoType& TraversalInfo() { return traversalInfo; }
 
+  /**
+   * Prepare the statistic of the given reference node for this iteration, if it
+   * hasn't been already: no clusters have been pruned yet beyond those pruned
+   * for its parent, and the distances to its closest query node are
+   * recalculated.  The parent must already have been prepared (or the node
+   * must be a root).  This returns 1 if the statistic was updated.
+   *
+   * @param referenceNode Reference node to prepare.
+   */
+  size_t IterationUpdate(TreeType& referenceNode) const;
+
  private:
   const typename TreeType::Mat& dataset;
   const arma::mat& centroids;
@@ -66,7 +82,7 @@ class DualTreeKMeansRules
 
   TraversalInfoType traversalInfo;
 
-  size_t IterationUpdate(TreeType& referenceNode) const;
+  tree::TraversalStatistics statistics;
 
   bool IsDescendantOf(const TreeType& potentialParent, const TreeType&
       potentialChild) const;
@@ -64,6 +64,7 @@ inline force_inline double DualTreeKMeansRules<MetricType, TreeType>::BaseCase(
     return 0.0;
 
   ++distanceCalculations;
+  ++statistics.BaseCases();
 
   const double distance = metric.Evaluate(centroids.col(queryIndex),
                                           dataset.col(referenceIndex));
@@ -104,7 +105,7 @@ double DualTreeKMeansRules<MetricType, TreeType>::Score(
   IterationUpdate(referenceNode);
 
   // No pruning here, for now.
-  return 0.0;
+  return statistics.Score(0.0, referenceNode);
 }
 
 template<typename MetricType, typename TreeType>
@@ -116,6 +117,13 @@ double DualTreeKMeansRules<MetricType, TreeType>::Score(
 
   traversalInfo.LastReferenceNode() = &referenceNode;
 
+  // If the closest query node (perhaps carried over from the last iteration)
+  // is below this query node, it is at least as tight, so keep it; this query
+  // node can't be pruned anyway.
+  TreeType* closest = (TreeType*) referenceNode.Stat().ClosestQueryNode();
+  if (closest != NULL && IsDescendantOf(queryNode, *closest))
+    return statistics.Score(0.0, queryNode, referenceNode);
+
   // Can we update the minimum query node distance for this reference node?
   const double minDistance = referenceNode.MinDistance(&queryNode);
   ++distanceCalculations;
@@ -126,7 +134,8 @@ double DualTreeKMeansRules<MetricType, TreeType>::Score(
     referenceNode.Stat().MaxQueryNodeDistance() =
         referenceNode.MaxDistance(&queryNode);
     ++distanceCalculations;
-    return 0.0; // Pruning is not possible.
+    // Pruning is not possible.
+    return statistics.Score(0.0, queryNode, referenceNode);
   }
   else if (IsDescendantOf(
       *((TreeType*) referenceNode.Stat().ClosestQueryNode()), queryNode))
@@ -137,7 +146,8 @@ double DualTreeKMeansRules<MetricType, TreeType>::Score(
     referenceNode.Stat().MaxQueryNodeDistance() =
         referenceNode.MaxDistance(&queryNode);
     ++distanceCalculations;
-    return 0.0; // Pruning is not possible.
+    // Pruning is not possible.
+    return statistics.Score(0.0, queryNode, referenceNode);
   }
 
   double score = ElkanTypeScore(queryNode, referenceNode);
@@ -174,7 +184,7 @@ double DualTreeKMeansRules<MetricType, TreeType>::Score(
     }
   }
 
-  return score;
+  return statistics.Score(score, queryNode, referenceNode);
 }
 
 template<typename MetricType, typename TreeType>
@@ -210,43 +220,29 @@ inline size_t DualTreeKMeansRules<MetricType, TreeType>::IterationUpdate(
   referenceNode.Stat().Iteration() = iteration;
   referenceNode.Stat().ClustersPruned() = (referenceNode.Parent() == NULL) ?
       0 : referenceNode.Parent()->Stat().ClustersPruned();
-  referenceNode.Stat().ClosestQueryNode() = (referenceNode.Parent() == NULL) ?
-      NULL : referenceNode.Parent()->Stat().ClosestQueryNode();
 
-  if (referenceNode.Stat().ClosestQueryNode() != NULL)
-    referenceNode.Stat().MinQueryNodeDistance() =
-        referenceNode.MinDistance((TreeType*)
-        referenceNode.Stat().ClosestQueryNode());
+  // If the centroid tree was kept from the last iteration, the closest query
+  // node found in that iteration is still in the tree (with refitted bounds),
+  // so it is a good place to start.  Otherwise, start from the parent's.
+  if (referenceNode.Stat().ClosestQueryNode() == NULL)
+    referenceNode.Stat().ClosestQueryNode() = (referenceNode.Parent() == NULL) ?
+        NULL : referenceNode.Parent()->Stat().ClosestQueryNode();
 
-  const size_t itDiff = iteration - referenceNode.Stat().Iteration();
-  if (itDiff > 1)
+  // The bounds of the query nodes are up to date, so the distances to the
+  // closest query node can just be calculated again.
+  if (referenceNode.Stat().ClosestQueryNode() != NULL)
   {
-    // Maybe this can be tighter?
-    referenceNode.Stat().MinQueryNodeDistance() = DBL_MAX;
+    const TreeType* closest = (TreeType*)
+        referenceNode.Stat().ClosestQueryNode();
+    referenceNode.Stat().MinQueryNodeDistance() =
+        referenceNode.MinDistance(closest);
+    referenceNode.Stat().MaxQueryNodeDistance() =
+        referenceNode.MaxDistance(closest);
   }
   else
   {
-    if (referenceNode.Stat().MinQueryNodeDistance() != DBL_MAX)
-    {
-      // Update the distance to the closest query node.  If this node has an
-      // owner, we know how far to increase the bound.  Otherwise, increase it
-      // by the furthest amount that any centroid moved.
-//      if (referenceNode.Stat().Owner() < centroids.n_cols)
-//        referenceNode.Stat().MinQueryNodeDistance() +=
-//            clusterDistances(referenceNode.Stat().Owner());
-//      else
-//        referenceNode.Stat().MinQueryNodeDistance() = DBL_MAX;
-//            clusterDistances(centroids.n_cols);
-      if (referenceNode.Stat().MaxQueryNodeDistance() == DBL_MAX)
-        referenceNode.Stat().MinQueryNodeDistance() = DBL_MAX;
-      else
-      {
-        referenceNode.Stat().MinQueryNodeDistance() +=
-            clusterDistances(centroids.n_cols);
-//referenceNode.Stat().MaxQueryNodeDistance() +
-//clusterDistances(centroids.n_cols);
-      }
-    }
+    referenceNode.Stat().MinQueryNodeDistance() = DBL_MAX;
+    referenceNode.Stat().MaxQueryNodeDistance() = DBL_MAX;
   }
 
   return 1;
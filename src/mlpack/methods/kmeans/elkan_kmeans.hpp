@@ -26,6 +26,10 @@ class ElkanKMeans
    * @param centroids Current cluster centroids.
    * @param newCentroids New cluster centroids.
    * @param counts Current counts, to be overwritten with new counts.
+   *
+   * The points are split across OpenMP threads (if mlpack was compiled with
+   * OpenMP); the number of threads can be set with the OMP_NUM_THREADS
+   * environment variable.
    */
   double Iterate(const arma::mat& centroids,
                  arma::mat& newCentroids,
@@ -9,6 +9,11 @@
 
 // In case it hasn't been included yet.
 #include "elkan_kmeans.hpp"
+#include "accumulate_point.hpp"
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace kmeans {
@@ -41,9 +46,6 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   // being the closest cluster centroid.
   clusterDistances.diag().fill(DBL_MAX);
 
-  // Initially set r(x) to true.
-  std::vector<bool> mustRecalculate(dataset.n_cols, true);
-
   // If this is the first iteration, we must reset all the bounds.
   if (lowerBounds.n_rows != centroids.n_cols)
   {
@@ -57,36 +59,66 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   }
 
   // Step 1: for all centers, compute between-cluster distances.  For all
-  // centers, compute s(c) = 1/2 min d(c, c').
+  // centers, compute s(c) = 1/2 min d(c, c').  Each pair is only computed by
+  // one thread.
+  #pragma omp parallel for schedule(dynamic, 16)
   for (size_t i = 0; i < centroids.n_cols; ++i)
   {
     for (size_t j = i + 1; j < centroids.n_cols; ++j)
     {
       const double distance = metric.Evaluate(centroids.col(i),
                                               centroids.col(j));
-      distanceCalculations++;
       clusterDistances(i, j) = distance;
       clusterDistances(j, i) = distance;
     }
   }
+  distanceCalculations += centroids.n_cols * (centroids.n_cols - 1) / 2;
 
   // Now find the closest cluster to each other cluster.  We multiply by 0.5 so
   // that this is equivalent to s(c) for each cluster c.
   minClusterDistances = 0.5 * arma::min(clusterDistances).t();
 
-  // Now loop over all points, and see which ones need to be updated.
-  for (size_t i = 0; i < dataset.n_cols; ++i)
+  // Now loop over all points, and see which ones need to be updated.  The
+  // bounds and assignment of each point are only used by the thread handling
+  // that point, and each thread sums its points into its own centroids and
+  // counts.  These are added together in thread order at the end, and the
+  // points are split between the threads in a fixed way, so the result only
+  // depends on the number of threads.
+  size_t numThreads = 1;
+#ifdef HAS_OPENMP
+  numThreads = (size_t) omp_get_max_threads();
+#endif
+
+  std::vector<arma::mat> threadCentroids(numThreads);
+  std::vector<arma::Col<size_t> > threadCounts(numThreads);
+  std::vector<size_t> threadDistanceCalculations(numThreads, 0);
+  for (size_t t = 0; t < numThreads; ++t)
   {
-    // Step 2: identify all points such that u(x) <= s(c(x)).
-    if (upperBounds(i) <= minClusterDistances(assignments[i]))
-    {
-      // No change needed.  This point must still belong to that cluster.
-      counts(assignments[i])++;
-      newCentroids.col(assignments[i]) += arma::vec(dataset.col(i));
-      continue;
-    }
-    else
+    threadCentroids[t].zeros(centroids.n_rows, centroids.n_cols);
+    threadCounts[t].zeros(centroids.n_cols);
+  }
+
+  #pragma omp parallel num_threads(numThreads)
+  {
+    size_t thread = 0;
+#ifdef HAS_OPENMP
+    thread = (size_t) omp_get_thread_num();
+#endif
+
+    #pragma omp for schedule(static, 256)
+    for (size_t i = 0; i < dataset.n_cols; ++i)
     {
+      // Step 2: identify all points such that u(x) <= s(c(x)).
+      if (upperBounds(i) <= minClusterDistances(assignments[i]))
+      {
+        // No change needed.  This point must still belong to that cluster.
+        threadCounts[thread](assignments[i])++;
+        AccumulatePoint(dataset, i, threadCentroids[thread], assignments[i]);
+        continue;
+      }
+
+      // r(x) is true at the start of every iteration.
+      bool mustRecalculate = true;
       for (size_t c = 0; c < centroids.n_cols; ++c)
       {
         // Step 3: for all remaining points x and centers c such that c != c(x),
@@ -103,13 +135,13 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
         // Step 3a: if r(x) then compute d(x, c(x)) and assign r(x) = false.
         // Otherwise, d(x, c(x)) = u(x).
         double dist;
-        if (mustRecalculate[i])
+        if (mustRecalculate)
         {
-          mustRecalculate[i] = false;
+          mustRecalculate = false;
           dist = metric.Evaluate(dataset.col(i), centroids.col(assignments[i]));
           lowerBounds(assignments[i], i) = dist;
           upperBounds(i) = dist;
-          distanceCalculations++;
+          threadDistanceCalculations[thread]++;
 
           // Check if we can prune again.
           if (upperBounds(i) <= lowerBounds(c, i))
@@ -131,7 +163,7 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
           const double pointDist = metric.Evaluate(dataset.col(i),
                                                    centroids.col(c));
           lowerBounds(c, i) = pointDist;
-          distanceCalculations++;
+          threadDistanceCalculations[thread]++;
           if (pointDist < dist)
           {
             upperBounds(i) = pointDist;
@@ -139,13 +171,20 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
           }
         }
       }
+
+      // At this point, we know the new cluster assignment.
+      // Step 4: for each center c, let m(c) be the mean of the points assigned
+      // to c.
+      AccumulatePoint(dataset, i, threadCentroids[thread], assignments[i]);
+      threadCounts[thread][assignments[i]]++;
     }
+  }
 
-    // At this point, we know the new cluster assignment.
-    // Step 4: for each center c, let m(c) be the mean of the points assigned to
-    // c.
-    newCentroids.col(assignments[i]) += arma::vec(dataset.col(i));
-    counts[assignments[i]]++;
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    newCentroids += threadCentroids[t];
+    counts += threadCounts[t];
+    distanceCalculations += threadDistanceCalculations[t];
   }
 
   // Now, normalize and calculate the distance each cluster has moved.
@@ -163,6 +202,7 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     distanceCalculations++;
   }
 
+  #pragma omp parallel for schedule(static)
   for (size_t i = 0; i < dataset.n_cols; ++i)
   {
     // Step 5: for each point x and center c, assign
@@ -0,0 +1,75 @@
+/**
+ * @file gpu_naive_kmeans.hpp
+ *
+ * A step of the Lloyd algorithm for k-means clustering which finds the closest
+ * centroid of each point on a CUDA device.  This is only available if mlpack
+ * was compiled with CUDA (HAS_CUDA is defined).
+ */
+#ifndef __MLPACK_METHODS_KMEANS_GPU_NAIVE_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_GPU_NAIVE_KMEANS_HPP
+
+#include <mlpack/core/gpu/knn.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An implementation of the naive Lloyd step (see NaiveKMeans) in which the
+ * distances between every point and every centroid are computed on the GPU,
+ * with gpu::KNearestNeighbors(); the dataset is copied to the device in tiles,
+ * so it may be larger than the device memory.  The new centroids are then
+ * summed on the host.  Each iteration still evaluates O(kN) distances, but with
+ * dense matrix products, so for large datasets it is much faster than
+ * NaiveKMeans.
+ *
+ * The distances are always Euclidean, so this should only be used with
+ * metric::EuclideanDistance (or SquaredEuclideanDistance, which gives the same
+ * assignments); the metric is only used to compute the residual.  Only dense
+ * matrices (arma::mat) are supported.
+ *
+ * @param MetricType Type of metric used with this implementation.
+ * @param MatType Matrix type (arma::mat).
+ */
+template<typename MetricType, typename MatType>
+class GPUNaiveKMeans
+{
+ public:
+  /**
+   * Construct the GPUNaiveKMeans object with the given dataset and metric.
+   *
+   * @param dataset Dataset.
+   * @param metric Instantiated metric.
+   */
+  GPUNaiveKMeans(const MatType& dataset, MetricType& metric);
+
+  /**
+   * Run a single iteration of the Lloyd algorithm, updating the given centroids
+   * into the newCentroids matrix.
+   *
+   * @param centroids Current cluster centroids.
+   * @param newCentroids New cluster centroids.
+   * @param counts Number of points in each cluster.
+   */
+  double Iterate(const arma::mat& centroids,
+                 arma::mat& newCentroids,
+                 arma::Col<size_t>& counts);
+
+  size_t DistanceCalculations() const { return distanceCalculations; }
+
+ private:
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! Number of distance calculations.
+  size_t distanceCalculations;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "gpu_naive_kmeans_impl.hpp"
+
+#endif
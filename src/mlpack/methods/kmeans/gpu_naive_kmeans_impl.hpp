@@ -0,0 +1,68 @@
+/**
+ * @file gpu_naive_kmeans_impl.hpp
+ *
+ * Implementation of the Lloyd step for k-means clustering which finds the
+ * closest centroid of each point on a CUDA device.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_GPU_NAIVE_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_GPU_NAIVE_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "gpu_naive_kmeans.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType, typename MatType>
+GPUNaiveKMeans<MetricType, MatType>::GPUNaiveKMeans(const MatType& dataset,
+                                                    MetricType& metric) :
+    dataset(dataset),
+    metric(metric),
+    distanceCalculations(0)
+{ /* Nothing to do. */ }
+
+// Run a single iteration.
+template<typename MetricType, typename MatType>
+double GPUNaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
+                                                    arma::mat& newCentroids,
+                                                    arma::Col<size_t>& counts)
+{
+  // The closest centroid of each point is its nearest neighbor among the
+  // centroids.
+  arma::Mat<size_t> assignments;
+  arma::mat distances;
+  gpu::KNearestNeighbors(dataset, centroids, 1, assignments, distances);
+
+  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
+  counts.zeros(centroids.n_cols);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    newCentroids.col(assignments[i]) += dataset.col(i);
+    counts(assignments[i])++;
+  }
+
+  // Now normalize the centroid.
+  for (size_t i = 0; i < centroids.n_cols; ++i)
+    if (counts(i) != 0)
+      newCentroids.col(i) /= counts(i);
+    else
+      newCentroids.col(i).fill(DBL_MAX); // Invalid value.
+
+  distanceCalculations += centroids.n_cols * dataset.n_cols;
+
+  // Calculate cluster distortion for this iteration.
+  double cNorm = 0.0;
+  for (size_t i = 0; i < centroids.n_cols; ++i)
+  {
+    cNorm += std::pow(metric.Evaluate(centroids.col(i), newCentroids.col(i)),
+        2.0);
+  }
+  distanceCalculations += centroids.n_cols;
+
+  return std::sqrt(cNorm);
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -7,6 +7,8 @@
 #ifndef __MLPACK_METHODS_KMEANS_HAMERLY_KMEANS_HPP
 #define __MLPACK_METHODS_KMEANS_HAMERLY_KMEANS_HPP
 
+#include <mlpack/core.hpp>
+
 namespace mlpack {
 namespace kmeans {
 
@@ -16,9 +18,23 @@ class HamerlyKMeans
  public:
   /**
    * Construct the HamerlyKMeans object, which must store several sets of
-   * bounds.
+   * bounds.  For datasets too large for memory (such as a data::MappedMatrix),
+   * the bounds can be kept in a matrix file instead, which is memory-mapped
+   * (see data::MappedMatrix) and holds the upper bound, lower bound, and
+   * assignment of each point in a column.  The file is replaced if it exists.
+   *
+   * @param dataset Dataset to cluster.
+   * @param metric Instantiated metric.
+   * @param boundsFile If not empty, the matrix file to keep the bounds in.
    */
-  HamerlyKMeans(const MatType& dataset, MetricType& metric);
+  HamerlyKMeans(const MatType& dataset,
+                MetricType& metric,
+                const std::string& boundsFile = "");
+
+  /**
+   * Release the bounds (writing them to the bounds file, if one was given).
+   */
+  ~HamerlyKMeans();
 
   /**
    * Run a single iteration of Hamerly's algorithm, updating the given centroids
@@ -27,6 +43,10 @@ class HamerlyKMeans
    * @param centroids Current cluster centroids.
    * @param newCentroids New cluster centroids.
    * @param counts Current counts, to be overwritten with new counts.
+   *
+   * The points are split across OpenMP threads (if mlpack was compiled with
+   * OpenMP); the number of threads can be set with the OMP_NUM_THREADS
+   * environment variable.
    */
   double Iterate(const arma::mat& centroids,
                  arma::mat& newCentroids,
@@ -43,15 +63,21 @@ class HamerlyKMeans
   //! Minimum cluster distances from each cluster.
   arma::vec minClusterDistances;
 
-  //! Upper bounds for each point.
-  arma::vec upperBounds;
-  //! Lower bounds for each point.
-  arma::vec lowerBounds;
-  //! Assignments for each point.
-  arma::Col<size_t> assignments;
+  //! The bounds file, if the bounds are not kept in memory.
+  data::MappedMatrix* boundsFile;
+  //! The bounds, if they are kept in memory.
+  arma::mat ownedBounds;
+  //! Upper bound (row 0), lower bound (row 1), and assignment (row 2) for each
+  //! point, either ownedBounds or the matrix of boundsFile.
+  arma::mat* bounds;
 
   //! Track distance calculations.
   size_t distanceCalculations;
+
+  //! Not copyable, because the bounds file can only be released once.
+  HamerlyKMeans(const HamerlyKMeans& other);
+  //! Not copyable, because the bounds file can only be released once.
+  HamerlyKMeans& operator=(const HamerlyKMeans& other);
 };
 
 } // namespace kmeans
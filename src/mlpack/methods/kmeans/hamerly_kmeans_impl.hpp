@@ -9,18 +9,38 @@
 
 // In case it hasn't been included yet.
 #include "hamerly_kmeans.hpp"
+#include "accumulate_point.hpp"
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace kmeans {
 
 template<typename MetricType, typename MatType>
-HamerlyKMeans<MetricType, MatType>::HamerlyKMeans(const MatType& dataset,
-                                                  MetricType& metric) :
+HamerlyKMeans<MetricType, MatType>::HamerlyKMeans(
+    const MatType& dataset,
+    MetricType& metric,
+    const std::string& boundsFile) :
     dataset(dataset),
     metric(metric),
+    boundsFile(NULL),
+    bounds(&ownedBounds),
     distanceCalculations(0)
 {
-  // Nothing to do.
+  if (!boundsFile.empty())
+  {
+    this->boundsFile = new data::MappedMatrix(boundsFile, 3, dataset.n_cols);
+    bounds = &this->boundsFile->Matrix();
+  }
+}
+
+template<typename MetricType, typename MatType>
+HamerlyKMeans<MetricType, MatType>::~HamerlyKMeans()
+{
+  if (boundsFile)
+    delete boundsFile;
 }
 
 template<typename MetricType, typename MatType>
@@ -28,13 +48,19 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
                                                    arma::mat& newCentroids,
                                                    arma::Col<size_t>& counts)
 {
+  // The bounds of each point are in one column, so that each point only
+  // touches one part of the bounds file (if there is one).  Assignments are
+  // stored as doubles.
+  arma::mat& bounds = *this->bounds;
+
   // If this is the first iteration, we need to set all the bounds.
   if (minClusterDistances.n_elem != centroids.n_cols)
   {
-    upperBounds.set_size(dataset.n_cols);
-    upperBounds.fill(DBL_MAX);
-    lowerBounds.zeros(dataset.n_cols);
-    assignments.zeros(dataset.n_cols);
+    if (!boundsFile)
+      bounds.set_size(3, dataset.n_cols);
+    bounds.row(0).fill(DBL_MAX);
+    bounds.row(1).zeros();
+    bounds.row(2).zeros();
     minClusterDistances.set_size(centroids.n_cols);
   }
 
@@ -60,62 +86,101 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     }
   }
 
-  for (size_t i = 0; i < dataset.n_cols; ++i)
-  {
-    const double m = std::max(minClusterDistances(assignments[i]),
-                              lowerBounds(i));
+  // The bounds and assignment of each point are only used by the thread
+  // handling that point, and each thread sums its points into its own
+  // centroids and counts.  These are added together in thread order at the
+  // end, and the points are split between the threads in a fixed way, so the
+  // result only depends on the number of threads.
+  size_t numThreads = 1;
+#ifdef HAS_OPENMP
+  numThreads = (size_t) omp_get_max_threads();
+#endif
 
-    // First bound test.
-    if (upperBounds(i) <= m)
-    {
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
-      continue;
-    }
+  std::vector<arma::mat> threadCentroids(numThreads);
+  std::vector<arma::Col<size_t> > threadCounts(numThreads);
+  std::vector<size_t> threadDistanceCalculations(numThreads, 0);
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    threadCentroids[t].zeros(centroids.n_rows, centroids.n_cols);
+    threadCounts[t].zeros(centroids.n_cols);
+  }
 
-    // Tighten upper bound.
-    upperBounds(i) = metric.Evaluate(dataset.col(i),
-                                     centroids.col(assignments[i]));
-    ++distanceCalculations;
+  #pragma omp parallel num_threads(numThreads)
+  {
+    size_t thread = 0;
+#ifdef HAS_OPENMP
+    thread = (size_t) omp_get_thread_num();
+#endif
 
-    // Second bound test.
-    if (upperBounds(i) <= m)
+    #pragma omp for schedule(static, 256)
+    for (size_t i = 0; i < dataset.n_cols; ++i)
     {
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
-      continue;
-    }
+      double& upperBound = bounds(0, i);
+      double& lowerBound = bounds(1, i);
+      size_t assignment = (size_t) bounds(2, i);
 
-    // The bounds failed.  So test against all other clusters.
-    // This is Hamerly's Point-All-Ctrs() function from the paper.
-    // We have to reset the lower bound first.
-    lowerBounds(i) = DBL_MAX;
-    for (size_t c = 0; c < centroids.n_cols; ++c)
-    {
-      if (c == assignments[i])
+      const double m = std::max(minClusterDistances(assignment), lowerBound);
+
+      // First bound test.
+      if (upperBound <= m)
+      {
+        AccumulatePoint(dataset, i, threadCentroids[thread], assignment);
+        ++threadCounts[thread](assignment);
         continue;
+      }
 
-      const double dist = metric.Evaluate(dataset.col(i), centroids.col(c));
+      // Tighten upper bound.
+      upperBound = metric.Evaluate(dataset.col(i), centroids.col(assignment));
+      ++threadDistanceCalculations[thread];
 
-      // Is this a better cluster?  At this point, upperBounds[i] = d(i, c(i)).
-      if (dist < upperBounds(i))
+      // Second bound test.
+      if (upperBound <= m)
       {
-        // lowerBounds holds the second closest cluster.
-        lowerBounds(i) = upperBounds(i);
-        upperBounds(i) = dist;
-        assignments[i] = c;
+        AccumulatePoint(dataset, i, threadCentroids[thread], assignment);
+        ++threadCounts[thread](assignment);
+        continue;
       }
-      else if (dist < lowerBounds(i))
+
+      // The bounds failed.  So test against all other clusters.
+      // This is Hamerly's Point-All-Ctrs() function from the paper.
+      // We have to reset the lower bound first.
+      const size_t oldAssignment = assignment;
+      lowerBound = DBL_MAX;
+      for (size_t c = 0; c < centroids.n_cols; ++c)
       {
-        // This is a closer second-closest cluster.
-        lowerBounds(i) = dist;
+        if (c == oldAssignment)
+          continue;
+
+        const double dist = metric.Evaluate(dataset.col(i), centroids.col(c));
+
+        // Is this a better cluster?  At this point, upperBound = d(i, c(i)).
+        if (dist < upperBound)
+        {
+          // The lower bound holds the second closest cluster.
+          lowerBound = upperBound;
+          upperBound = dist;
+          assignment = c;
+        }
+        else if (dist < lowerBound)
+        {
+          // This is a closer second-closest cluster.
+          lowerBound = dist;
+        }
       }
+      threadDistanceCalculations[thread] += centroids.n_cols - 1;
+      bounds(2, i) = (double) assignment;
+
+      // Update new centroids.
+      AccumulatePoint(dataset, i, threadCentroids[thread], assignment);
+      ++threadCounts[thread](assignment);
     }
-    distanceCalculations += centroids.n_cols - 1;
+  }
 
-    // Update new centroids.
-    newCentroids.col(assignments[i]) += dataset.col(i);
-    ++counts(assignments[i]);
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    newCentroids += threadCentroids[t];
+    counts += threadCounts[t];
+    distanceCalculations += threadDistanceCalculations[t];
   }
 
   // Normalize centroids and calculate cluster movement (contains parts of
@@ -152,13 +217,15 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   }
 
   // Now update bounds (lines 3-8 of Update-Bounds()).
+  #pragma omp parallel for schedule(static)
   for (size_t i = 0; i < dataset.n_cols; ++i)
   {
-    upperBounds(i) += centroidMovements(assignments[i]);
-    if (assignments[i] == furthestMovingCluster)
-      lowerBounds(i) -= secondFurthestMovement;
+    const size_t assignment = (size_t) bounds(2, i);
+    bounds(0, i) += centroidMovements(assignment);
+    if (assignment == furthestMovingCluster)
+      bounds(1, i) -= secondFurthestMovement;
     else
-      lowerBounds(i) -= furthestMovement;
+      bounds(1, i) -= furthestMovement;
   }
 
   return std::sqrt(centroidMovement);
@@ -50,8 +50,10 @@ namespace kmeans /** K-Means clustering. */ {
  *     default constructor and 'void Cluster(const arma::mat&, const size_t,
  *     arma::Col<size_t>&)'.
  * @tparam EmptyClusterPolicy Policy for what to do on an empty cluster; must
- *     implement a default constructor and 'void EmptyCluster(const arma::mat&,
- *     arma::Col<size_t&)'.
+ *     implement a default constructor and 'size_t EmptyCluster(const MatType&,
+ *     const size_t, arma::mat&, arma::Col<size_t>&, MetricType&, const
+ *     size_t)', which is given the number of the iteration last, and
+ *     'void Reset()', which is called at the start of each call to Cluster().
  * @tparam LloydStepType Implementation of single Lloyd step to use.
  *
  * @see RandomPartition, RefinedStart, AllowEmptyClusters,
@@ -147,6 +149,85 @@ class KMeans
                const bool initialAssignmentGuess = false,
                const bool initialCentroidGuess = false);
 
+  /**
+   * Perform k-means clustering on a dataset that is read a chunk at a time, so
+   * that the dataset never has to be held in memory, returning the centroids
+   * of each cluster.  Each iteration is one pass over the file: the Lloyd step
+   * is run on each chunk, and the centroids of the chunks are combined
+   * (weighted by their counts), so the result is the same as one Lloyd step on
+   * the whole dataset.  Unless initialGuess is set, the initial centroids are
+   * found by running the partitioner on the first chunk only.  The empty
+   * cluster policy needs the whole dataset, so it is not used; an empty
+   * cluster keeps its centroid from the previous iteration.
+   *
+   * @param reader Reader for the file holding the dataset.
+   * @param clusters Number of clusters to compute.
+   * @param centroids Matrix in which the centroids are stored.
+   * @param initialGuess If true, then it is assumed that centroids contains the
+   *      initial centroids of each cluster.
+   * @param chunkSize Number of points to read at a time.
+   */
+  void Cluster(data::ChunkReader& reader,
+               const size_t clusters,
+               arma::mat& centroids,
+               const bool initialGuess = false,
+               const size_t chunkSize = 100000);
+
+  /**
+   * Perform k-means clustering on a dataset which is split across several
+   * nodes, returning the centroids of each cluster.  Each node calls this with
+   * its own part of the dataset.  Each iteration runs the Lloyd step on the
+   * local data, and the sums and counts of each cluster of every node are
+   * combined with the given reducer (see util::LocalReducer), so that every
+   * node gets the centroids of one Lloyd step on the whole dataset.  Unless
+   * initialGuess is set, each node runs the partitioner on its own data, and
+   * the initial centroids are the means of the clusters over all nodes.  As
+   * with a dataset read in chunks, the empty cluster policy is not used; an
+   * empty cluster keeps its centroid from the previous iteration.
+   *
+   * @param data Part of the dataset held by this node.
+   * @param clusters Number of clusters to compute.
+   * @param centroids Matrix in which the centroids are stored.
+   * @param reducer Reducer to sum over the nodes (for instance,
+   *     util::MPIReducer).
+   * @param initialGuess If true, then it is assumed that centroids contains the
+   *      initial centroids of each cluster (the same on every node).
+   */
+  template<typename ReducerType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::mat& centroids,
+               ReducerType& reducer,
+               const bool initialGuess = false);
+
+  /**
+   * Perform weighted k-means clustering on the data, returning the list of
+   * cluster assignments and the centroids of each cluster.  Each point counts
+   * as many times as its weight in the centroid of its cluster, so if the
+   * points are the unique points of a dataset with duplicates (see
+   * data::UniquePoints) and the weights are their counts, an iteration gives
+   * the same centroids as an iteration on the whole dataset.  Every point is
+   * compared with every centroid in each iteration (the Lloyd step type is not
+   * used, as it does not take weights).  The initial partition is computed on
+   * the points without their weights, unless initialGuess is set.  As with a
+   * dataset read in chunks, the empty cluster policy is not used; an empty
+   * cluster keeps its centroid from the previous iteration.
+   *
+   * @param data Dataset to cluster.
+   * @param weights Weight of each point (nonnegative).
+   * @param clusters Number of clusters to compute.
+   * @param assignments Vector to store cluster assignments in.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialGuess If true, then it is assumed that centroids contains the
+   *      initial centroids of each cluster.
+   */
+  void Cluster(const MatType& data,
+               const arma::vec& weights,
+               const size_t clusters,
+               arma::Col<size_t>& assignments,
+               arma::mat& centroids,
+               const bool initialGuess = false);
+
   //! Get the maximum number of iterations.
   size_t MaxIterations() const { return maxIterations; }
   //! Set the maximum number of iterations.
@@ -180,6 +261,12 @@ class KMeans
   InitialPartitionPolicy partitioner;
   //! Instantiated empty cluster policy.
   EmptyClusterPolicy emptyClusterAction;
+
+  //! Assign each point to the nearest of the given centroids, returning the
+  //! number of distance calculations.
+  size_t AssignPoints(const MatType& data,
+                      const arma::mat& centroids,
+                      arma::Col<size_t>& assignments);
 };
 
 }; // namespace kmeans
@@ -8,11 +8,42 @@
 #include "kmeans.hpp"
 
 #include <mlpack/core/tree/mrkd_statistic.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
+#include "accumulate_point.hpp"
 
 namespace mlpack {
 namespace kmeans {
 
+//! Detect whether a Lloyd step type keeps traversal statistics.
+HAS_MEM_FUNC(Statistics, HasTraversalStatistics);
+
+//! Print the traversal statistics of a tree-based Lloyd step type.
+template<typename LloydStepType>
+void PrintTraversalStatistics(
+    const LloydStepType& lloydStep,
+    const typename boost::enable_if_c<
+        HasTraversalStatistics<LloydStepType, const tree::TraversalStatistics&
+            (LloydStepType::*)() const>::value,
+        LloydStepType*
+    >::type = 0)
+{
+  lloydStep.Statistics().Print();
+}
+
+//! The Lloyd step type does not use a tree, so there is nothing to print.
+template<typename LloydStepType>
+void PrintTraversalStatistics(
+    const LloydStepType& /* lloydStep */,
+    const typename boost::enable_if_c<
+        !HasTraversalStatistics<LloydStepType, const tree::TraversalStatistics&
+            (LloydStepType::*)() const>::value,
+        LloydStepType*
+    >::type = 0)
+{
+  // Nothing to do.
+}
+
 /**
  * Construct the K-Means object.
  */
@@ -137,6 +168,10 @@ Cluster(const MatType& data,
 
   size_t iteration = 0;
 
+  // The iteration numbers start again from 0, so any state the empty cluster
+  // policy kept from an earlier call is stale.
+  emptyClusterAction.Reset();
+
   LloydStepType<MetricType, MatType> lloydStep(data, metric);
   arma::mat centroidsOther;
   double cNorm;
@@ -159,9 +194,10 @@ Cluster(const MatType& data,
         Log::Info << "Cluster " << i << " is empty.\n";
         if (iteration % 2 == 0)
           emptyClusterAction.EmptyCluster(data, i, centroidsOther, counts,
-              metric);
+              metric, iteration);
         else
-          emptyClusterAction.EmptyCluster(data, i, centroids, counts, metric);
+          emptyClusterAction.EmptyCluster(data, i, centroids, counts, metric,
+              iteration);
       }
     }
 
@@ -189,6 +225,7 @@ Cluster(const MatType& data,
   }
   Log::Info << lloydStep.DistanceCalculations() << " distance calculations."
       << std::endl;
+  PrintTraversalStatistics(lloydStep);
 }
 
 /**
@@ -263,6 +300,463 @@ Cluster(const MatType& data,
   }
 }
 
+/**
+ * Perform k-means clustering on a dataset that is read a chunk at a time,
+ * returning the centroids of each cluster.
+ */
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    LloydStepType,
+    MatType>::
+Cluster(data::ChunkReader& reader,
+        const size_t clusters,
+        arma::mat& centroids,
+        const bool initialGuess,
+        const size_t chunkSize)
+{
+  if (clusters == 0)
+    Log::Warn << "KMeans::Cluster(): zero clusters requested.  This probably "
+        << "isn't going to work.  Brace for crash." << std::endl;
+
+  arma::mat chunk;
+  if (!reader.Reset() || !reader.Read(chunk, chunkSize))
+    Log::Fatal << "KMeans::Cluster(): could not read the dataset."
+        << std::endl;
+
+  if (initialGuess)
+  {
+    if (centroids.n_cols != clusters)
+      Log::Fatal << "KMeans::Cluster(): wrong number of initial cluster "
+        << "centroids (" << centroids.n_cols << ", should be " << clusters
+        << ")!" << std::endl;
+
+    if (centroids.n_rows != chunk.n_rows)
+      Log::Fatal << "KMeans::Cluster(): initial cluster centroids have wrong "
+        << " dimensionality (" << centroids.n_rows << ", should be "
+        << chunk.n_rows << ")!" << std::endl;
+  }
+  else
+  {
+    // Use the partitioner on the first chunk to find the initial centroids.
+    if (clusters > chunk.n_cols)
+      Log::Warn << "KMeans::Cluster(): more clusters requested than points in "
+          << "the first chunk." << std::endl;
+
+    arma::Col<size_t> assignments;
+    partitioner.Cluster(chunk, clusters, assignments);
+
+    arma::Col<size_t> counts;
+    counts.zeros(clusters);
+    centroids.zeros(chunk.n_rows, clusters);
+    for (size_t i = 0; i < chunk.n_cols; ++i)
+    {
+      centroids.col(assignments[i]) += chunk.col(i);
+      counts[assignments[i]]++;
+    }
+
+    for (size_t i = 0; i < clusters; ++i)
+      if (counts[i] != 0)
+        centroids.col(i) /= counts[i];
+  }
+
+  size_t iteration = 0;
+  size_t distanceCalculations = 0;
+  arma::mat newCentroids, chunkCentroids;
+  arma::Col<size_t> counts, chunkCounts;
+  double cNorm;
+
+  do
+  {
+    newCentroids.zeros(centroids.n_rows, clusters);
+    counts.zeros(clusters);
+
+    // The first chunk of each pass has already been read.
+    size_t points = 0;
+    do
+    {
+      if (chunk.n_rows != centroids.n_rows)
+        Log::Fatal << "KMeans::Cluster(): points in the dataset have "
+            << "dimensionality " << chunk.n_rows << ", but the centroids have "
+            << "dimensionality " << centroids.n_rows << "." << std::endl;
+
+      LloydStepType<MetricType, arma::mat> lloydStep(chunk, metric);
+      lloydStep.Iterate(centroids, chunkCentroids, chunkCounts);
+      distanceCalculations += lloydStep.DistanceCalculations();
+
+      for (size_t i = 0; i < clusters; ++i)
+        if (chunkCounts[i] != 0)
+          newCentroids.col(i) += chunkCounts[i] * chunkCentroids.col(i);
+      counts += chunkCounts;
+      points += chunk.n_cols;
+    } while (reader.Read(chunk, chunkSize));
+
+    if (reader.Failed())
+      Log::Fatal << "KMeans::Cluster(): could not read the dataset."
+          << std::endl;
+
+    cNorm = 0.0;
+    for (size_t i = 0; i < clusters; ++i)
+    {
+      if (counts[i] == 0)
+      {
+        Log::Info << "Cluster " << i << " is empty.\n";
+        newCentroids.col(i) = centroids.col(i);
+      }
+      else
+      {
+        newCentroids.col(i) /= counts[i];
+      }
+
+      cNorm += std::pow(metric.Evaluate(centroids.col(i),
+          newCentroids.col(i)), 2.0);
+    }
+    distanceCalculations += clusters;
+    cNorm = std::sqrt(cNorm);
+    centroids.swap(newCentroids);
+
+    iteration++;
+    Log::Info << "KMeans::Cluster(): iteration " << iteration << ", residual "
+        << cNorm << " (" << points << " points).\n";
+
+    // Start the next pass.
+    if (cNorm > 1e-5 && iteration != maxIterations)
+      if (!reader.Reset() || !reader.Read(chunk, chunkSize))
+        Log::Fatal << "KMeans::Cluster(): could not read the dataset."
+            << std::endl;
+
+  } while (cNorm > 1e-5 && iteration != maxIterations);
+
+  if (iteration != maxIterations)
+  {
+    Log::Info << "KMeans::Cluster(): converged after " << iteration
+        << " iterations." << std::endl;
+  }
+  else
+  {
+    Log::Info << "KMeans::Cluster(): terminated after limit of " << iteration
+        << " iterations." << std::endl;
+  }
+  Log::Info << distanceCalculations << " distance calculations." << std::endl;
+}
+
+/**
+ * Perform k-means clustering on a dataset which is split across several nodes,
+ * returning the centroids of each cluster.
+ */
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+template<typename ReducerType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    LloydStepType,
+    MatType>::
+Cluster(const MatType& data,
+        const size_t clusters,
+        arma::mat& centroids,
+        ReducerType& reducer,
+        const bool initialGuess)
+{
+  if (clusters == 0)
+    Log::Warn << "KMeans::Cluster(): zero clusters requested.  This probably "
+        << "isn't going to work.  Brace for crash." << std::endl;
+
+  if (initialGuess)
+  {
+    if (centroids.n_cols != clusters)
+      Log::Fatal << "KMeans::Cluster(): wrong number of initial cluster "
+        << "centroids (" << centroids.n_cols << ", should be " << clusters
+        << ")!" << std::endl;
+
+    if (centroids.n_rows != data.n_rows)
+      Log::Fatal << "KMeans::Cluster(): initial cluster centroids have wrong "
+        << " dimensionality (" << centroids.n_rows << ", should be "
+        << data.n_rows << ")!" << std::endl;
+  }
+
+  // The sums of the points of each cluster on this node, with the count of the
+  // points in the last row, so that they are combined in one reduction.
+  const size_t dimensionality = data.n_rows;
+  arma::mat sums;
+
+  if (!initialGuess)
+  {
+    sums.zeros(dimensionality + 1, clusters);
+    if (data.n_cols > 0)
+    {
+      arma::Col<size_t> assignments;
+      partitioner.Cluster(data, clusters, assignments);
+
+      for (size_t i = 0; i < data.n_cols; ++i)
+      {
+        sums.submat(0, assignments[i], dimensionality - 1, assignments[i]) +=
+            arma::vec(data.col(i));
+        sums(dimensionality, assignments[i]) += 1.0;
+      }
+    }
+
+    reducer.Sum(sums.memptr(), sums.n_elem);
+
+    centroids.zeros(dimensionality, clusters);
+    for (size_t i = 0; i < clusters; ++i)
+      if (sums(dimensionality, i) != 0.0)
+        centroids.col(i) = sums.submat(0, i, dimensionality - 1, i) /
+            sums(dimensionality, i);
+  }
+
+  size_t iteration = 0;
+  size_t distanceCalculations = 0;
+  arma::mat newCentroids, localCentroids;
+  arma::Col<size_t> localCounts;
+  double cNorm;
+
+  do
+  {
+    sums.zeros(dimensionality + 1, clusters);
+    if (data.n_cols > 0)
+    {
+      // As with a dataset read in chunks, the Lloyd step only sees part of the
+      // data, so any state it keeps between iterations would be wrong; a new
+      // one is used in each iteration.
+      LloydStepType<MetricType, MatType> lloydStep(data, metric);
+      lloydStep.Iterate(centroids, localCentroids, localCounts);
+      distanceCalculations += lloydStep.DistanceCalculations();
+
+      for (size_t i = 0; i < clusters; ++i)
+      {
+        if (localCounts[i] == 0)
+          continue;
+
+        sums.submat(0, i, dimensionality - 1, i) = localCounts[i] *
+            localCentroids.col(i);
+        sums(dimensionality, i) = (double) localCounts[i];
+      }
+    }
+
+    reducer.Sum(sums.memptr(), sums.n_elem);
+
+    newCentroids.set_size(dimensionality, clusters);
+    cNorm = 0.0;
+    for (size_t i = 0; i < clusters; ++i)
+    {
+      if (sums(dimensionality, i) == 0.0)
+      {
+        Log::Info << "Cluster " << i << " is empty.\n";
+        newCentroids.col(i) = centroids.col(i);
+      }
+      else
+      {
+        newCentroids.col(i) = sums.submat(0, i, dimensionality - 1, i) /
+            sums(dimensionality, i);
+      }
+
+      cNorm += std::pow(metric.Evaluate(centroids.col(i),
+          newCentroids.col(i)), 2.0);
+    }
+    distanceCalculations += clusters;
+    cNorm = std::sqrt(cNorm);
+    centroids.swap(newCentroids);
+
+    iteration++;
+    Log::Info << "KMeans::Cluster(): iteration " << iteration << ", residual "
+        << cNorm << ".\n";
+
+  } while (cNorm > 1e-5 && iteration != maxIterations);
+
+  if (iteration != maxIterations)
+  {
+    Log::Info << "KMeans::Cluster(): converged after " << iteration
+        << " iterations." << std::endl;
+  }
+  else
+  {
+    Log::Info << "KMeans::Cluster(): terminated after limit of " << iteration
+        << " iterations." << std::endl;
+  }
+  Log::Info << distanceCalculations << " distance calculations on node "
+      << reducer.Rank() << "." << std::endl;
+}
+
+/**
+ * Perform weighted k-means clustering on the data, returning the list of
+ * cluster assignments and the centroids of each cluster.
+ */
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    LloydStepType,
+    MatType>::
+Cluster(const MatType& data,
+        const arma::vec& weights,
+        const size_t clusters,
+        arma::Col<size_t>& assignments,
+        arma::mat& centroids,
+        const bool initialGuess)
+{
+  if (weights.n_elem != data.n_cols)
+    Log::Fatal << "KMeans::Cluster(): the number of weights ("
+        << weights.n_elem << ") is not the number of points (" << data.n_cols
+        << ")!" << std::endl;
+
+  if (clusters > data.n_cols)
+    Log::Warn << "KMeans::Cluster(): more clusters requested than points given."
+        << std::endl;
+  else if (clusters == 0)
+    Log::Warn << "KMeans::Cluster(): zero clusters requested.  This probably "
+        << "isn't going to work.  Brace for crash." << std::endl;
+
+  if (initialGuess)
+  {
+    if (centroids.n_cols != clusters)
+      Log::Fatal << "KMeans::Cluster(): wrong number of initial cluster "
+        << "centroids (" << centroids.n_cols << ", should be " << clusters
+        << ")!" << std::endl;
+
+    if (centroids.n_rows != data.n_rows)
+      Log::Fatal << "KMeans::Cluster(): initial cluster centroids have wrong "
+        << " dimensionality (" << centroids.n_rows << ", should be "
+        << data.n_rows << ")!" << std::endl;
+  }
+
+  arma::mat sums;
+  arma::vec clusterWeights;
+
+  if (!initialGuess)
+  {
+    partitioner.Cluster(data, clusters, assignments);
+
+    sums.zeros(data.n_rows, clusters);
+    clusterWeights.zeros(clusters);
+    for (size_t i = 0; i < data.n_cols; ++i)
+    {
+      AccumulatePoint(data, i, sums, assignments[i], weights[i]);
+      clusterWeights[assignments[i]] += weights[i];
+    }
+
+    centroids.zeros(data.n_rows, clusters);
+    for (size_t i = 0; i < clusters; ++i)
+      if (clusterWeights[i] != 0.0)
+        centroids.col(i) = sums.col(i) / clusterWeights[i];
+  }
+
+  size_t iteration = 0;
+  size_t distanceCalculations = 0;
+  arma::mat newCentroids;
+  double cNorm;
+
+  do
+  {
+    distanceCalculations += AssignPoints(data, centroids, assignments);
+
+    sums.zeros(data.n_rows, clusters);
+    clusterWeights.zeros(clusters);
+    for (size_t i = 0; i < data.n_cols; ++i)
+    {
+      AccumulatePoint(data, i, sums, assignments[i], weights[i]);
+      clusterWeights[assignments[i]] += weights[i];
+    }
+
+    newCentroids.set_size(data.n_rows, clusters);
+    cNorm = 0.0;
+    for (size_t i = 0; i < clusters; ++i)
+    {
+      if (clusterWeights[i] == 0.0)
+      {
+        Log::Info << "Cluster " << i << " is empty.\n";
+        newCentroids.col(i) = centroids.col(i);
+      }
+      else
+      {
+        newCentroids.col(i) = sums.col(i) / clusterWeights[i];
+      }
+
+      cNorm += std::pow(metric.Evaluate(centroids.col(i),
+          newCentroids.col(i)), 2.0);
+    }
+    distanceCalculations += clusters;
+    cNorm = std::sqrt(cNorm);
+    centroids.swap(newCentroids);
+
+    iteration++;
+    Log::Info << "KMeans::Cluster(): iteration " << iteration << ", residual "
+        << cNorm << ".\n";
+
+  } while (cNorm > 1e-5 && iteration != maxIterations);
+
+  if (iteration != maxIterations)
+  {
+    Log::Info << "KMeans::Cluster(): converged after " << iteration
+        << " iterations." << std::endl;
+  }
+  else
+  {
+    Log::Info << "KMeans::Cluster(): terminated after limit of " << iteration
+        << " iterations." << std::endl;
+  }
+
+  // Calculate final assignments.
+  distanceCalculations += AssignPoints(data, centroids, assignments);
+  Log::Info << distanceCalculations << " distance calculations." << std::endl;
+}
+
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+size_t KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    LloydStepType,
+    MatType>::
+AssignPoints(const MatType& data,
+             const arma::mat& centroids,
+             arma::Col<size_t>& assignments)
+{
+  assignments.set_size(data.n_cols);
+
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    // Find the closest centroid to this point.
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+
+    for (size_t j = 0; j < centroids.n_cols; j++)
+    {
+      const double distance = metric.Evaluate(data.col(i), centroids.col(j));
+
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    assignments[i] = closestCluster;
+  }
+
+  return data.n_cols * centroids.n_cols;
+}
+
 template<typename MetricType,
          typename InitialPartitionPolicy,
          typename EmptyClusterPolicy,
@@ -9,14 +9,24 @@
 #include "kmeans.hpp"
 #include "allow_empty_clusters.hpp"
 #include "refined_start.hpp"
+#include "kmeans_plus_plus.hpp"
+#include "kmeans_parallel.hpp"
 #include "elkan_kmeans.hpp"
 #include "hamerly_kmeans.hpp"
+#include "yinyang_kmeans.hpp"
 #include "pelleg_moore_kmeans.hpp"
 #include "dtnn_kmeans.hpp"
 #include "dual_tree_kmeans.hpp"
+#include "mini_batch_kmeans.hpp"
+#include "gpu_naive_kmeans.hpp"
+
+#ifdef HAS_MPI
+  #include <mlpack/core/util/mpi_reducer.hpp>
+#endif
 
 using namespace mlpack;
 using namespace mlpack::kmeans;
+using namespace mlpack::util;
 using namespace std;
 
 // Define parameters for the executable.
@@ -35,12 +45,43 @@ PROGRAM_INFO("K-Means Clustering", "This program performs K-Means clustering "
     "to be used in each sample, the --percentage parameter is used (it should "
     "be a value between 0.0 and 1.0)."
     "\n\n"
+    "Initial points can also be chosen with k-means++ (--kmeans_plus_plus), "
+    "which picks each point with probability proportional to its squared "
+    "distance to the points already picked, or with its scalable variant "
+    "k-means|| (--kmeans_parallel), which needs only a few passes over the "
+    "data; --oversampling and --rounds control the sampling of k-means||."
+    "\n\n"
     "There are several options available for the algorithm used for each Lloyd "
     "iteration, specified with the --algorithm (-a) option.  The standard O(kN)"
     " approach can be used ('naive').  Other options include the Pelleg-Moore "
     "tree-based algorithm ('pelleg-moore'), Elkan's triangle-inequality based "
-    "algorithm ('elkan'), and Hamerly's modification to Elkan's algorithm "
-    "('hamerly')."
+    "algorithm ('elkan'), Hamerly's modification to Elkan's algorithm "
+    "('hamerly'), and Yinyang k-means ('yinyang'), which prunes about as well "
+    "as 'elkan' for large k with much smaller bounds.  For very large datasets,"
+    " mini-batch k-means ('minibatch') samples only --mini_batch_size (-b) "
+    "points in each iteration, so it gives approximate centroids with much less"
+    " work; --max_iterations should be set with the batch size in mind, and "
+    "--allow_empty_clusters is recommended."
+    "  If mlpack was compiled with CUDA, --gpu (-g) runs the 'naive' algorithm "
+    "on the GPU."
+    "\n\n"
+    "Datasets too large for memory can be given as a binary matrix file (as "
+    "written by data::MappedMatrix::Convert()) with the --mapped (-M) option; "
+    "the file is then memory-mapped instead of loaded, and the 'naive' and "
+    "'hamerly' algorithms read it a part at a time in each iteration.  With "
+    "'hamerly', --hamerly_bounds_file (-B) keeps the bounds of each point in "
+    "the given (memory-mapped) file instead of in memory.  --in_place cannot be"
+    " used with --mapped, and --labels_only must be given with --output_file."
+    "\n\n"
+    "If --distributed (-D) is given, the program must be run with MPI (for "
+    "instance, with mpirun), and the dataset is split across the processes: "
+    "'%r' in --inputFile and --output_file is replaced with the rank of each "
+    "process, so that each process loads its own part of the dataset and saves "
+    "its own labels.  In each iteration, each process runs the Lloyd step on "
+    "its part, and the sums and counts of the clusters are added over all the "
+    "processes, so the centroids are the same as if the whole dataset were "
+    "clustered.  The first process saves the centroids.  --mapped cannot be "
+    "used with --distributed, and empty clusters keep their centroid."
     "\n\n"
     "As of October 2014, the --overclustering option has been removed.  If you "
     "want this support back, let us know -- file a bug at "
@@ -50,6 +91,13 @@ PROGRAM_INFO("K-Means Clustering", "This program performs K-Means clustering "
 PARAM_STRING_REQ("inputFile", "Input dataset to perform clustering on.", "i");
 PARAM_INT_REQ("clusters", "Number of clusters to find.", "c");
 
+// Input options.
+PARAM_FLAG("mapped", "If specified, the input dataset is a binary matrix file, "
+    "which will be memory-mapped instead of loaded.", "M");
+PARAM_FLAG("distributed", "If specified, cluster with MPI a dataset split "
+    "across the processes ('%r' in --inputFile and --output_file is replaced "
+    "with the rank).", "D");
+
 // Output options.
 PARAM_FLAG("in_place", "If specified, a column containing the learned cluster "
     "assignments will be added to the input dataset file.  In this case, "
@@ -76,8 +124,50 @@ PARAM_INT("samplings", "Number of samplings to perform for refined start (use "
 PARAM_DOUBLE("percentage", "Percentage of dataset to use for each refined start"
     " sampling (use when --refined_start is specified).", "p", 0.02);
 
+// Parameters for k-means++ and k-means||.
+PARAM_FLAG("kmeans_plus_plus", "Use k-means++ to choose initial points.", "K");
+PARAM_FLAG("kmeans_parallel", "Use k-means|| to choose initial points.", "");
+PARAM_DOUBLE("oversampling", "Oversampling factor for k-means||: about this "
+    "many times the number of clusters are sampled in each round (use when "
+    "--kmeans_parallel is specified).", "", 2.0);
+PARAM_INT("rounds", "Number of sampling rounds for k-means|| (use when "
+    "--kmeans_parallel is specified).", "", 5);
+
 PARAM_STRING("algorithm", "Algorithm to use for the Lloyd iteration ('naive', "
-    "'pelleg-moore', 'elkan', 'hamerly', or 'dtnn').", "a", "naive");
+    "'pelleg-moore', 'elkan', 'hamerly', 'yinyang', 'dtnn', or 'minibatch').",
+    "a", "naive");
+PARAM_FLAG("gpu", "Find the closest centroid of each point on the GPU (use "
+    "with --algorithm naive; requires CUDA).", "g");
+PARAM_INT("mini_batch_size", "Number of points sampled in each iteration (use "
+    "with --algorithm minibatch).", "b", 1000);
+PARAM_STRING("hamerly_bounds_file", "If specified, the bounds for Hamerly's "
+    "algorithm are kept in this (memory-mapped) file instead of in memory (use "
+    "with --algorithm hamerly).", "B", "");
+
+/**
+ * MiniBatchKMeans, with the batch size given on the command line.  KMeans
+ * constructs its Lloyd step with only the dataset and metric.
+ */
+template<typename MetricType, typename MatType>
+class CLIMiniBatchKMeans : public MiniBatchKMeans<MetricType, MatType>
+{
+ public:
+  CLIMiniBatchKMeans(const MatType& dataset, MetricType& metric) :
+      MiniBatchKMeans<MetricType, MatType>(dataset, metric,
+          (size_t) CLI::GetParam<int>("mini_batch_size")) { }
+};
+
+/**
+ * HamerlyKMeans, with the bounds file given on the command line.
+ */
+template<typename MetricType, typename MatType>
+class CLIHamerlyKMeans : public HamerlyKMeans<MetricType, MatType>
+{
+ public:
+  CLIHamerlyKMeans(const MatType& dataset, MetricType& metric) :
+      HamerlyKMeans<MetricType, MatType>(dataset, metric,
+          CLI::GetParam<string>("hamerly_bounds_file")) { }
+};
 
 // Given the type of initial partition policy, figure out the empty cluster
 // policy and run k-means.
@@ -95,10 +185,33 @@ template<typename InitialPartitionPolicy,
          template<class, class> class LloydStepType>
 void RunKMeans(const InitialPartitionPolicy& ipp);
 
+// Run k-means with MPI on the part of the dataset held by this process, and
+// compute the assignments of its points if they are wanted.
+template<typename KMeansType>
+void DistributedCluster(KMeansType& kmeans,
+                        const arma::mat& dataset,
+                        const size_t clusters,
+                        arma::mat& centroids,
+                        const bool initialGuess,
+                        arma::Col<size_t>* assignments);
+
+// Get the rank of this process (0 if --distributed is not given).
+size_t Rank();
+
 int main(int argc, char** argv)
 {
   CLI::ParseCommandLine(argc, argv);
 
+  if (CLI::HasParam("distributed"))
+  {
+#ifdef HAS_MPI
+    MPI_Init(&argc, &argv);
+#else
+    Log::Fatal << "--distributed requires MPI, but mlpack was compiled "
+        << "without MPI support." << endl;
+#endif
+  }
+
   // Initialize random seed.
   if (CLI::GetParam<int>("seed") != 0)
     math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
@@ -108,6 +221,14 @@ int main(int argc, char** argv)
   // Now, start building the KMeans type that we'll be using.  Start with the
   // initial partition policy.  The call to FindEmptyClusterPolicy<> results in
   // a call to RunKMeans<> and the algorithm is completed.
+  if ((CLI::HasParam("refined_start") ? 1 : 0) +
+      (CLI::HasParam("kmeans_plus_plus") ? 1 : 0) +
+      (CLI::HasParam("kmeans_parallel") ? 1 : 0) > 1)
+  {
+    Log::Fatal << "Only one of --refined_start, --kmeans_plus_plus, and "
+        << "--kmeans_parallel may be specified!" << endl;
+  }
+
   if (CLI::HasParam("refined_start"))
   {
     const int samplings = CLI::GetParam<int>("samplings");
@@ -122,10 +243,84 @@ int main(int argc, char** argv)
 
     FindEmptyClusterPolicy<RefinedStart>(RefinedStart(samplings, percentage));
   }
+  else if (CLI::HasParam("kmeans_plus_plus"))
+  {
+    FindEmptyClusterPolicy<KMeansPlusPlus>(KMeansPlusPlus());
+  }
+  else if (CLI::HasParam("kmeans_parallel"))
+  {
+    const double oversampling = CLI::GetParam<double>("oversampling");
+    const int rounds = CLI::GetParam<int>("rounds");
+
+    if (oversampling <= 0.0)
+      Log::Fatal << "Oversampling factor (" << oversampling << ") must be "
+          << "greater than 0.0!" << endl;
+    if (rounds < 0)
+      Log::Fatal << "Number of rounds (" << rounds << ") must be greater than "
+          << "or equal to 0!" << endl;
+
+    FindEmptyClusterPolicy<KMeansParallel>(KMeansParallel(oversampling,
+        (size_t) rounds));
+  }
   else
   {
     FindEmptyClusterPolicy<RandomPartition>(RandomPartition());
   }
+
+#ifdef HAS_MPI
+  if (CLI::HasParam("distributed"))
+    MPI_Finalize();
+#endif
+}
+
+size_t Rank()
+{
+#ifdef HAS_MPI
+  if (CLI::HasParam("distributed"))
+    return MPIReducer().Rank();
+#endif
+  return 0;
+}
+
+template<typename KMeansType>
+void DistributedCluster(KMeansType& kmeans,
+                        const arma::mat& dataset,
+                        const size_t clusters,
+                        arma::mat& centroids,
+                        const bool initialGuess,
+                        arma::Col<size_t>* assignments)
+{
+#ifdef HAS_MPI
+  MPIReducer reducer;
+  kmeans.Cluster(dataset, clusters, centroids, reducer, initialGuess);
+#else
+  // main() has already checked this.
+  (void) kmeans;
+  (void) initialGuess;
+#endif
+
+  if (!assignments)
+    return;
+
+  // Assign each point to its nearest centroid.
+  assignments->set_size(dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    double minDistance = DBL_MAX;
+    size_t closestCluster = 0;
+    for (size_t j = 0; j < clusters; ++j)
+    {
+      const double distance = kmeans.Metric().Evaluate(dataset.col(i),
+          centroids.col(j));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    (*assignments)[i] = closestCluster;
+  }
 }
 
 // Given the type of initial partition policy, figure out the empty cluster
@@ -145,10 +340,16 @@ template<typename InitialPartitionPolicy, typename EmptyClusterPolicy>
 void FindLloydStepType(const InitialPartitionPolicy& ipp)
 {
   const string algorithm = CLI::GetParam<string>("algorithm");
+  if (CLI::HasParam("gpu") && algorithm != "naive")
+    Log::Fatal << "--gpu can only be used with --algorithm naive." << endl;
+
   if (algorithm == "elkan")
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, ElkanKMeans>(ipp);
   else if (algorithm == "hamerly")
-    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, HamerlyKMeans>(ipp);
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
+        CLIHamerlyKMeans>(ipp);
+  else if (algorithm == "yinyang")
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, YinyangKMeans>(ipp);
   else if (algorithm == "pelleg-moore")
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
         PellegMooreKMeans>(ipp);
@@ -161,11 +362,34 @@ void FindLloydStepType(const InitialPartitionPolicy& ipp)
   else if (algorithm == "dualtree")
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
         DefaultDualTreeKMeans>(ipp);
+  else if (algorithm == "minibatch")
+  {
+    if (CLI::GetParam<int>("mini_batch_size") < 1)
+      Log::Fatal << "Invalid mini-batch size ("
+          << CLI::GetParam<int>("mini_batch_size") << ")! Must be greater "
+          << "than 0." << endl;
+
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
+        CLIMiniBatchKMeans>(ipp);
+  }
+  else if (algorithm == "naive" && CLI::HasParam("gpu"))
+  {
+#ifdef HAS_CUDA
+    if (!gpu::DeviceAvailable())
+      Log::Fatal << "--gpu specified, but no CUDA device was found." << endl;
+
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, GPUNaiveKMeans>(ipp);
+#else
+    Log::Fatal << "--gpu requires CUDA, but mlpack was compiled without CUDA "
+        << "support." << endl;
+#endif
+  }
   else if (algorithm == "naive")
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, NaiveKMeans>(ipp);
   else
     Log::Fatal << "Unknown algorithm: '" << algorithm << "'.  Supported options"
-        << " are 'naive', 'pelleg-moore', 'elkan', and 'hamerly'." << endl;
+        << " are 'naive', 'pelleg-moore', 'elkan', 'hamerly', 'yinyang', "
+        << "'dtnn', 'dtnn-covertree', 'dualtree', and 'minibatch'." << endl;
 }
 
 // Given the template parameters, sanitize/load input and run k-means.
@@ -174,8 +398,24 @@ template<typename InitialPartitionPolicy,
          template<class, class> class LloydStepType>
 void RunKMeans(const InitialPartitionPolicy& ipp)
 {
-  // Now, do validation of input options.
-  const string inputFile = CLI::GetParam<string>("inputFile");
+  // Now, do validation of input options.  With --distributed, each process
+  // loads and saves its own files.
+  const bool distributed = CLI::HasParam("distributed");
+  const size_t rank = Rank();
+  string inputFile = CLI::GetParam<string>("inputFile");
+  string outputFile = CLI::GetParam<string>("output_file");
+#ifdef HAS_MPI
+  if (distributed)
+  {
+    if (CLI::HasParam("output_file") && MPIReducer().NumNodes() > 1 &&
+        outputFile.find("%r") == string::npos)
+      Log::Fatal << "With --distributed, --output_file must contain '%r', so "
+          << "that each process saves its labels to its own file." << endl;
+
+    inputFile = RankFileName(inputFile, rank);
+    outputFile = RankFileName(outputFile, rank);
+  }
+#endif
   const int clusters = CLI::GetParam<int>("clusters");
   if (clusters < 1)
   {
@@ -198,9 +438,38 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
         << "no results will be saved." << std::endl;
   }
 
-  // Load our dataset.
-  arma::mat dataset;
-  data::Load(inputFile, dataset, true); // Fatal upon failure.
+  if (CLI::HasParam("hamerly_bounds_file") &&
+      CLI::GetParam<string>("algorithm") != "hamerly")
+    Log::Warn << "--hamerly_bounds_file ignored because --algorithm is not "
+        << "'hamerly'." << endl;
+
+  // Load our dataset, or map it if it is a matrix file.  The mapped matrix
+  // can't be resized, so the labels can't be added to it.
+  const bool mapped = CLI::HasParam("mapped");
+  if (mapped && distributed)
+    Log::Fatal << "--mapped cannot be used with --distributed!" << endl;
+  if (mapped && CLI::HasParam("in_place"))
+    Log::Fatal << "--in_place cannot be used with --mapped!" << endl;
+  if (mapped && CLI::HasParam("output_file") && !CLI::HasParam("labels_only"))
+    Log::Fatal << "--labels_only must be specified with --mapped and "
+        << "--output_file!" << endl;
+
+  arma::mat loadedDataset;
+  data::MappedMatrix* mappedDataset = NULL;
+  if (mapped)
+  {
+    Timer::Start("loading_data");
+    mappedDataset = new data::MappedMatrix(inputFile); // Fatal upon failure.
+    Timer::Stop("loading_data");
+    Log::Info << "Mapped " << mappedDataset->Matrix().n_rows << "x"
+        << mappedDataset->Matrix().n_cols << " matrix from '" << inputFile
+        << "'." << endl;
+  }
+  else
+  {
+    data::Load(inputFile, loadedDataset, true); // Fatal upon failure.
+  }
+  arma::mat& dataset = mapped ? mappedDataset->Matrix() : loadedDataset;
 
   arma::mat centroids;
 
@@ -211,9 +480,12 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
     string initialCentroidsFile = CLI::GetParam<string>("initial_centroids");
     data::Load(initialCentroidsFile, centroids, true);
 
-    if (CLI::HasParam("refined_start"))
-      Log::Warn << "Initial centroids are specified, but will be ignored "
-          << "because --refined_start is also specified!" << endl;
+    // The initial partition policy is only used when there is no guess.
+    if (CLI::HasParam("refined_start") || CLI::HasParam("kmeans_plus_plus") ||
+        CLI::HasParam("kmeans_parallel"))
+      Log::Warn << "Initial centroids are specified, so --refined_start, "
+          << "--kmeans_plus_plus, and --kmeans_parallel will be ignored!"
+          << endl;
     else
       Log::Info << "Using initial centroid guesses from '" <<
           initialCentroidsFile << "'." << endl;
@@ -229,8 +501,12 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
     // We need to get the assignments.
     arma::Col<size_t> assignments;
     Timer::Start("clustering");
-    kmeans.Cluster(dataset, clusters, assignments, centroids,
-        false, initialCentroidGuess);
+    if (distributed)
+      DistributedCluster(kmeans, dataset, clusters, centroids,
+          initialCentroidGuess, &assignments);
+    else
+      kmeans.Cluster(dataset, clusters, assignments, centroids,
+          false, initialCentroidGuess);
     Timer::Stop("clustering");
 
     // Now figure out what to do with our results.
@@ -252,7 +528,6 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
       if (CLI::HasParam("labels_only"))
       {
         // Save only the labels.
-        string outputFile = CLI::GetParam<string>("output_file");
         arma::Mat<size_t> output = trans(assignments);
         data::Save(outputFile, output);
       }
@@ -266,7 +541,6 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
         dataset.insert_rows(dataset.n_rows, trans(converted));
 
         // Now save, in the different file.
-        string outputFile = CLI::GetParam<string>("output_file");
         data::Save(outputFile, dataset);
       }
     }
@@ -275,11 +549,19 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
   {
     // Just save the centroids.
     Timer::Start("clustering");
-    kmeans.Cluster(dataset, clusters, centroids, initialCentroidGuess);
+    if (distributed)
+      DistributedCluster(kmeans, dataset, clusters, centroids,
+          initialCentroidGuess, (arma::Col<size_t>*) NULL);
+    else
+      kmeans.Cluster(dataset, clusters, centroids, initialCentroidGuess);
     Timer::Stop("clustering");
   }
 
-  // Should we write the centroids to a file?
-  if (CLI::HasParam("centroid_file"))
+  // Should we write the centroids to a file?  Every process has the same
+  // centroids, so only the first one saves them.
+  if (CLI::HasParam("centroid_file") && rank == 0)
     data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
+
+  if (mappedDataset)
+    delete mappedDataset;
 }
@@ -0,0 +1,114 @@
+/**
+ * @file kmeans_parallel.hpp
+ *
+ * An implementation of the scalable k-means|| seeding strategy of Bahmani et
+ * al.  This class is meant to provide initial points as good as those of
+ * k-means++, with far fewer passes over the data.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_HPP
+
+#include <mlpack/core.hpp>
+#include "kmeans_plus_plus.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The k-means|| approach for choosing initial points for k-means clustering.
+ * k-means++ needs k passes over the data, one for each seed.  Instead, k-means||
+ * starts from one random point and, in each of a few rounds, samples every
+ * point independently with probability proportional to its squared distance to
+ * the closest candidate so far (oversampling, so that about l points are added
+ * in each round).  Each candidate is then weighted by the number of points
+ * closest to it, weighted k-means++ reduces the candidates to k seeds, and each
+ * point is assigned to its closest seed.  It is an implementation of the
+ * following paper:
+ *
+ * @article{bahmani2012scalable,
+ *   title={Scalable k-means++},
+ *   author={Bahmani, Bahman and Moseley, Benjamin and Vattani, Andrea and
+ *       Kumar, Ravi and Vassilvitskii, Sergei},
+ *   journal={Proceedings of the VLDB Endowment},
+ *   volume={5},
+ *   number={7},
+ *   pages={622--633},
+ *   year={2012}
+ * }
+ *
+ * Distances are always squared Euclidean distances.  The distance computations
+ * of each round are split across OpenMP threads (if mlpack was compiled with
+ * OpenMP).
+ */
+class KMeansParallel
+{
+ public:
+  /**
+   * Create the KMeansParallel object, optionally specifying the oversampling
+   * factor and the number of rounds.
+   *
+   * @param oversampling The expected number of points sampled in each round is
+   *     this factor times the number of clusters (l = oversampling * k).
+   * @param rounds Number of sampling rounds.
+   */
+  KMeansParallel(const double oversampling = 2.0,
+                 const size_t rounds = 5) :
+      oversampling(oversampling), rounds(rounds) { }
+
+  /**
+   * Partition the given dataset into the given number of clusters by choosing
+   * seeds with k-means|| and assigning each point to its closest seed.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to partition.
+   * @param clusters Number of clusters to split dataset into.
+   * @param assignments Vector to store cluster assignments into.  Values will
+   *     be between 0 and (clusters - 1).
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments) const;
+
+  //! Get the oversampling factor.
+  double Oversampling() const { return oversampling; }
+  //! Modify the oversampling factor.
+  double& Oversampling() { return oversampling; }
+
+  //! Get the number of sampling rounds.
+  size_t Rounds() const { return rounds; }
+  //! Modify the number of sampling rounds.
+  size_t& Rounds() { return rounds; }
+
+ private:
+  //! The oversampling factor.
+  double oversampling;
+  //! The number of sampling rounds.
+  size_t rounds;
+
+  /**
+   * Update the squared distance from each point to its closest center, and the
+   * index of that center, with the centers from index 'first' on, in one pass
+   * over the data.  The points are split across threads.
+   *
+   * @param data Dataset holding the points and the centers.
+   * @param centers Indices of the centers in the dataset.
+   * @param first Index (in centers) of the first new center.
+   * @param minDistances Squared distance from each point to its closest center.
+   * @param closest Index (in centers) of the closest center to each point.
+   */
+  template<typename MatType>
+  static void UpdateDistances(const MatType& data,
+                              const std::vector<size_t>& centers,
+                              const size_t first,
+                              arma::vec& minDistances,
+                              arma::Col<size_t>& closest);
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+// Include implementation.
+#include "kmeans_parallel_impl.hpp"
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file kmeans_parallel_impl.hpp
+ *
+ * Implementation of the k-means|| seeding strategy.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_parallel.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+//! Partition the given dataset with k-means||.
+template<typename MatType>
+void KMeansParallel::Cluster(const MatType& data,
+                             const size_t clusters,
+                             arma::Col<size_t>& assignments) const
+{
+  const double l = oversampling * clusters;
+
+  // Start with one random candidate.
+  std::vector<size_t> candidates;
+  candidates.push_back((size_t) math::RandInt(data.n_cols));
+
+  arma::vec minDistances(data.n_cols);
+  minDistances.fill(DBL_MAX);
+  arma::Col<size_t> closest(data.n_cols);
+  UpdateDistances(data, candidates, 0, minDistances, closest);
+
+  for (size_t r = 0; r < rounds; ++r)
+  {
+    const double cost = arma::accu(minDistances);
+    if (cost == 0.0)
+      break; // Every point coincides with a candidate.
+
+    // Sample each point independently, with probability l * d^2 / cost.  The
+    // candidates have distance 0, so they are never sampled again.
+    const size_t first = candidates.size();
+    for (size_t i = 0; i < data.n_cols; ++i)
+      if (math::Random() * cost < l * minDistances[i])
+        candidates.push_back(i);
+
+    UpdateDistances(data, candidates, first, minDistances, closest);
+  }
+
+  Log::Info << "KMeansParallel::Cluster(): sampled " << candidates.size()
+      << " candidates." << std::endl;
+
+  // Weight each candidate by the number of points closest to it, and then
+  // reduce the candidates to the seeds with weighted k-means++.
+  arma::vec weights;
+  weights.zeros(candidates.size());
+  for (size_t i = 0; i < data.n_cols; ++i)
+    weights[closest[i]] += 1.0;
+
+  MatType candidateData(data.n_rows, candidates.size());
+  for (size_t j = 0; j < candidates.size(); ++j)
+    candidateData.col(j) = data.col(candidates[j]);
+
+  arma::Col<size_t> candidateSeeds;
+  arma::Col<size_t> candidateAssignments;
+  KMeansPlusPlus::ChooseSeeds(candidateData, clusters, weights, candidateSeeds,
+      candidateAssignments);
+
+  // Finally, assign each point to its closest seed.
+  std::vector<size_t> seeds(clusters);
+  for (size_t c = 0; c < clusters; ++c)
+    seeds[c] = candidates[candidateSeeds[c]];
+
+  minDistances.fill(DBL_MAX);
+  assignments.zeros(data.n_cols);
+  UpdateDistances(data, seeds, 0, minDistances, assignments);
+}
+
+template<typename MatType>
+void KMeansParallel::UpdateDistances(const MatType& data,
+                                     const std::vector<size_t>& centers,
+                                     const size_t first,
+                                     arma::vec& minDistances,
+                                     arma::Col<size_t>& closest)
+{
+  // Each point only updates its own distance and index.
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t j = first; j < centers.size(); ++j)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), data.col(centers[j]));
+
+      if (distance < minDistances[i])
+      {
+        minDistances[i] = distance;
+        closest[i] = j;
+      }
+    }
+  }
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file kmeans_plus_plus.hpp
+ *
+ * An implementation of the k-means++ seeding strategy of Arthur and
+ * Vassilvitskii.  This class is meant to provide better initial points for the
+ * k-means algorithm.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The k-means++ approach for choosing initial points for k-means clustering.
+ * The first seed is a random point of the dataset, and each further seed is a
+ * point chosen with probability proportional to its squared distance to the
+ * closest seed chosen so far (D^2 sampling).  Each point is then assigned to
+ * its closest seed.  This takes O(kN) time, and the resulting clustering is
+ * O(log k)-competitive with the optimal one in expectation.  It is an
+ * implementation of the following paper:
+ *
+ * @inproceedings{arthur2007kmeans,
+ *   title={k-means++: The advantages of careful seeding},
+ *   author={Arthur, David and Vassilvitskii, Sergei},
+ *   booktitle={Proceedings of the Eighteenth Annual ACM-SIAM Symposium on
+ *       Discrete Algorithms (SODA 2007)},
+ *   pages={1027--1035},
+ *   year={2007}
+ * }
+ *
+ * Distances are always squared Euclidean distances.  The distance updates for
+ * each new seed are split across OpenMP threads (if mlpack was compiled with
+ * OpenMP).
+ */
+class KMeansPlusPlus
+{
+ public:
+  //! Empty constructor, required by the InitialPartitionPolicy policy.
+  KMeansPlusPlus() { }
+
+  /**
+   * Partition the given dataset into the given number of clusters by choosing
+   * seeds with k-means++ and assigning each point to its closest seed.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to partition.
+   * @param clusters Number of clusters to split dataset into.
+   * @param assignments Vector to store cluster assignments into.  Values will
+   *     be between 0 and (clusters - 1).
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments) const;
+
+  /**
+   * Choose the given number of seeds from the dataset with (weighted) D^2
+   * sampling: each seed is chosen with probability proportional to the weight
+   * of the point times its squared distance to the closest seed so far.  If
+   * the points all coincide with seeds before enough seeds are chosen, the
+   * remaining seeds are chosen uniformly at random.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to choose seeds from.
+   * @param clusters Number of seeds to choose.
+   * @param weights Weight of each point; if empty, every point has weight 1.
+   * @param seeds Vector to store the indices of the seeds into.
+   * @param assignments Vector to store the index (in seeds) of the closest seed
+   *     to each point into.
+   */
+  template<typename MatType>
+  static void ChooseSeeds(const MatType& data,
+                          const size_t clusters,
+                          const arma::vec& weights,
+                          arma::Col<size_t>& seeds,
+                          arma::Col<size_t>& assignments);
+
+ private:
+  /**
+   * Update the squared distance from each point to its closest seed, and the
+   * index of that seed, with a new seed.  The points are split across threads.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset holding the points and the new seed.
+   * @param seed Index of the new seed in the dataset.
+   * @param label Label to give points whose closest seed is the new seed.
+   * @param minDistances Squared distance from each point to its closest seed.
+   * @param closest Label of the closest seed to each point.
+   */
+  template<typename MatType>
+  static void UpdateDistances(const MatType& data,
+                              const size_t seed,
+                              const size_t label,
+                              arma::vec& minDistances,
+                              arma::Col<size_t>& closest);
+};
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+// Include implementation.
+#include "kmeans_plus_plus_impl.hpp"
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file kmeans_plus_plus_impl.hpp
+ *
+ * Implementation of the k-means++ seeding strategy.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_plus_plus.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+//! Partition the given dataset with k-means++.
+template<typename MatType>
+void KMeansPlusPlus::Cluster(const MatType& data,
+                             const size_t clusters,
+                             arma::Col<size_t>& assignments) const
+{
+  arma::Col<size_t> seeds;
+  ChooseSeeds(data, clusters, arma::vec(), seeds, assignments);
+}
+
+template<typename MatType>
+void KMeansPlusPlus::ChooseSeeds(const MatType& data,
+                                 const size_t clusters,
+                                 const arma::vec& weights,
+                                 arma::Col<size_t>& seeds,
+                                 arma::Col<size_t>& assignments)
+{
+  seeds.set_size(clusters);
+  assignments.zeros(data.n_cols);
+  arma::vec minDistances(data.n_cols);
+  minDistances.fill(DBL_MAX);
+
+  for (size_t c = 0; c < clusters; ++c)
+  {
+    // The first seed is chosen only by weight.  After that, the chance of each
+    // point is its weight times its squared distance to the closest seed.
+    double total = 0.0;
+    for (size_t i = 0; i < data.n_cols; ++i)
+      total += ((weights.n_elem == 0) ? 1.0 : weights[i]) *
+          ((c == 0) ? 1.0 : minDistances[i]);
+
+    size_t seed = data.n_cols - 1;
+    if (total > 0.0)
+    {
+      double target = math::Random() * total;
+      for (size_t i = 0; i < data.n_cols; ++i)
+      {
+        target -= ((weights.n_elem == 0) ? 1.0 : weights[i]) *
+            ((c == 0) ? 1.0 : minDistances[i]);
+        if (target < 0.0)
+        {
+          seed = i;
+          break;
+        }
+      }
+    }
+    else
+    {
+      // Every point is already a seed (or has no weight).
+      seed = (size_t) math::RandInt(data.n_cols);
+    }
+
+    seeds[c] = seed;
+    UpdateDistances(data, seed, c, minDistances, assignments);
+  }
+}
+
+template<typename MatType>
+void KMeansPlusPlus::UpdateDistances(const MatType& data,
+                                     const size_t seed,
+                                     const size_t label,
+                                     arma::vec& minDistances,
+                                     arma::Col<size_t>& closest)
+{
+  // Each point only updates its own distance and label.
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    const double distance = metric::SquaredEuclideanDistance::Evaluate(
+        data.col(i), data.col(seed));
+
+    if (distance < minDistances[i])
+    {
+      minDistances[i] = distance;
+      closest[i] = label;
+    }
+  }
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
@@ -17,12 +17,29 @@ namespace kmeans {
 /**
  * When an empty cluster is detected, this class takes the point furthest from
  * the centroid of the cluster with maximum variance as a new cluster.
+ *
+ * The assignments and variances of the clusters are only computed for the
+ * first empty cluster of each iteration (which is O(Nk)); for the other empty
+ * clusters of that iteration they are updated as points are taken, so those
+ * only need a pass over the points of the cluster with maximum variance.
  */
 class MaxVarianceNewCluster
 {
  public:
   //! Default constructor required by EmptyClusterPolicy.
-  MaxVarianceNewCluster() { }
+  MaxVarianceNewCluster() : iteration(size_t(-1)) { }
+
+  /**
+   * Forget the assignments and variances of the last clustering.  This is
+   * called by K-Means at the start of each call to Cluster(), since the
+   * iteration numbers start again from 0 and the dataset may have changed.
+   */
+  void Reset()
+  {
+    iteration = size_t(-1);
+    variances.reset();
+    assignments.reset();
+  }
 
   /**
    * Take the point furthest from the centroid of the cluster with maximum
@@ -33,16 +50,33 @@ class MaxVarianceNewCluster
    * @param emptyCluster Index of cluster which is empty.
    * @param centroids Centroids of each cluster (one per column).
    * @param clusterCounts Number of points in each cluster.
-   * @param assignments Cluster assignments of each point.
+   * @param metric Instantiated metric.
+   * @param iteration Number of the current iteration; the variances are
+   *     recomputed when it changes.
    *
    * @return Number of points changed.
    */
   template<typename MetricType, typename MatType>
-  static size_t EmptyCluster(const MatType& data,
-                             const size_t emptyCluster,
-                             arma::mat& centroids,
-                             arma::Col<size_t>& clusterCounts,
-                             MetricType& metric);
+  size_t EmptyCluster(const MatType& data,
+                      const size_t emptyCluster,
+                      arma::mat& centroids,
+                      arma::Col<size_t>& clusterCounts,
+                      MetricType& metric,
+                      const size_t iteration);
+
+ private:
+  //! The iteration that the assignments and variances were computed for.
+  size_t iteration;
+  //! The sum of the distances from the points of each cluster to its centroid.
+  arma::vec variances;
+  //! The closest cluster of each point.
+  arma::Col<size_t> assignments;
+
+  //! Compute the assignments and variances for the given centroids.
+  template<typename MetricType, typename MatType>
+  void Precalculate(const MatType& data,
+                    const arma::mat& centroids,
+                    MetricType& metric);
 };
 
 }; // namespace kmeans
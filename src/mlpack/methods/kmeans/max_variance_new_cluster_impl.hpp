@@ -21,49 +21,38 @@ size_t MaxVarianceNewCluster::EmptyCluster(const MatType& data,
                                            const size_t emptyCluster,
                                            arma::mat& centroids,
                                            arma::Col<size_t>& clusterCounts,
-                                           MetricType& metric)
+                                           MetricType& metric,
+                                           const size_t iteration)
 {
-  // First, we need to find the cluster with maximum variance (by which I mean
-  // the sum of the covariance matrices).
-  arma::vec variances;
-  variances.zeros(clusterCounts.n_elem); // Start with 0.
-  arma::Col<size_t> assignments(data.n_cols);
+  // The assignments and variances only need to be computed for the first empty
+  // cluster of an iteration.
+  if (iteration != this->iteration || assignments.n_elem != data.n_cols ||
+      variances.n_elem != centroids.n_cols)
+  {
+    Precalculate(data, centroids, metric);
+    this->iteration = iteration;
+  }
 
-  // Add the variance of each point's distance away from the cluster.  I think
-  // this is the sensible thing to do.
-  for (size_t i = 0; i < data.n_cols; ++i)
+  // Now find the cluster with maximum variance.  If the number of points in the
+  // cluster is 1, that cluster is not selected, because the point cannot be
+  // taken from it.
+  size_t maxVarCluster = centroids.n_cols; // Invalid value.
+  double maxVariance = -DBL_MAX;
+  for (size_t i = 0; i < clusterCounts.n_elem; ++i)
   {
-    // Find the closest centroid to this point.
-    double minDistance = std::numeric_limits<double>::infinity();
-    size_t closestCluster = centroids.n_cols; // Invalid value.
+    if (clusterCounts[i] <= 1)
+      continue;
 
-    for (size_t j = 0; j < centroids.n_cols; j++)
+    const double variance = variances[i] / clusterCounts[i];
+    if (variance > maxVariance)
     {
-      const double distance = metric.Evaluate(data.col(i), centroids.col(j));
-
-      if (distance < minDistance)
-      {
-        minDistance = distance;
-        closestCluster = j;
-      }
+      maxVariance = variance;
+      maxVarCluster = i;
     }
-
-    assignments[i] = closestCluster;
-    variances[closestCluster] += metric.Evaluate(data.col(i),
-        centroids.col(closestCluster));
   }
 
-  // Divide by the number of points in the cluster to produce the variance.
-  // Although a -nan will occur here for the empty cluster(s), this doesn't
-  // matter because variances.max() won't pick it up.  If the number of points
-  // in the cluster is 1, we ensure that cluster is not selected by forcing the
-  // variance to 0.
-  for (size_t i = 0; i < clusterCounts.n_elem; ++i)
-    variances[i] /= (clusterCounts[i] == 1) ? DBL_MAX : clusterCounts[i];
-
-  // Now find the cluster with maximum variance.
-  arma::uword maxVarCluster;
-  variances.max(maxVarCluster);
+  if (maxVarCluster == centroids.n_cols)
+    return 0; // No cluster has a point to spare.
 
   // Now, inside this cluster, find the point which is furthest away.
   size_t furthestPoint = data.n_cols;
@@ -83,6 +72,11 @@ size_t MaxVarianceNewCluster::EmptyCluster(const MatType& data,
     }
   }
 
+  // The counts may not match the assignments (they come from the Lloyd step),
+  // so the cluster may have no point left.
+  if (furthestPoint == data.n_cols)
+    return 0;
+
   // Take that point and add it to the empty cluster.
   centroids.col(maxVarCluster) *= (double(clusterCounts[maxVarCluster]) /
       double(clusterCounts[maxVarCluster] - 1));
@@ -93,6 +87,13 @@ size_t MaxVarianceNewCluster::EmptyCluster(const MatType& data,
   centroids.col(emptyCluster) = arma::vec(data.col(furthestPoint));
   assignments[furthestPoint] = emptyCluster;
 
+  // Update the variances for the next empty cluster of this iteration.  The
+  // distances of the other points of the cluster to its moved centroid are not
+  // recomputed.
+  variances[maxVarCluster] = std::max(variances[maxVarCluster] - maxDistance,
+      0.0);
+  variances[emptyCluster] = 0.0;
+
   // Output some debugging information.
   Log::Debug << "Point " << furthestPoint << " assigned to empty cluster " <<
       emptyCluster << ".\n";
@@ -100,6 +101,40 @@ size_t MaxVarianceNewCluster::EmptyCluster(const MatType& data,
   return 1; // We only changed one point.
 }
 
+template<typename MetricType, typename MatType>
+void MaxVarianceNewCluster::Precalculate(const MatType& data,
+                                         const arma::mat& centroids,
+                                         MetricType& metric)
+{
+  // We need to find the variance of each cluster (by which I mean the sum of
+  // the covariance matrices).
+  variances.zeros(centroids.n_cols); // Start with 0.
+  assignments.set_size(data.n_cols);
+
+  // Add the variance of each point's distance away from the cluster.  I think
+  // this is the sensible thing to do.
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    // Find the closest centroid to this point.
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+
+    for (size_t j = 0; j < centroids.n_cols; j++)
+    {
+      const double distance = metric.Evaluate(data.col(i), centroids.col(j));
+
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    assignments[i] = closestCluster;
+    variances[closestCluster] += minDistance;
+  }
+}
+
 }; // namespace kmeans
 }; // namespace mlpack
 
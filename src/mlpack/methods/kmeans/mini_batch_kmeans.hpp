@@ -0,0 +1,91 @@
+/**
+ * @file mini_batch_kmeans.hpp
+ *
+ * An implementation of mini-batch k-means (Sculley, "Web-scale k-means
+ * clustering", 2010), which approximates each Lloyd iteration using a small
+ * random sample of the dataset.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * A Lloyd step that, instead of assigning every point of the dataset, samples
+ * a mini-batch of points (with replacement), assigns each of them to its
+ * closest centroid, and moves that centroid towards the point.  Each centroid
+ * has its own learning rate, the inverse of the number of points it has been
+ * assigned so far, so the centroids move less as they see more points.  Each
+ * iteration costs O(bk) for a batch size of b instead of O(Nk), so for large
+ * datasets the centroids get close to convergence in much less time, although
+ * the final centroids are only an approximation of those found by Lloyd's
+ * algorithm.
+ *
+ * Because each iteration only sees a batch, the counts returned by Iterate()
+ * are the total number of points each centroid has been assigned over all
+ * iterations.  A centroid that has not yet been assigned any points has a count
+ * of 0, so it is best to use AllowEmptyClusters with small batches, to avoid
+ * clusters being reinitialized early on.  The maximum number of iterations of
+ * KMeans should be set with the batch size in mind, since the residual of a
+ * single batch is noisy and rarely falls below the convergence tolerance.
+ *
+ * @param MetricType Type of metric used with this implementation.
+ * @param MatType Matrix type (arma::mat or arma::sp_mat).
+ */
+template<typename MetricType, typename MatType>
+class MiniBatchKMeans
+{
+ public:
+  /**
+   * Construct the MiniBatchKMeans object with the given dataset and metric.
+   *
+   * @param dataset Dataset.
+   * @param metric Instantiated metric.
+   * @param batchSize Number of points to sample in each iteration.
+   */
+  MiniBatchKMeans(const MatType& dataset,
+                  MetricType& metric,
+                  const size_t batchSize = 1000);
+
+  /**
+   * Run a single mini-batch iteration, updating the given centroids into the
+   * newCentroids matrix.
+   *
+   * @param centroids Current cluster centroids.
+   * @param newCentroids New cluster centroids.
+   * @param counts Total number of points assigned to each cluster so far.
+   */
+  double Iterate(const arma::mat& centroids,
+                 arma::mat& newCentroids,
+                 arma::Col<size_t>& counts);
+
+  size_t DistanceCalculations() const { return distanceCalculations; }
+
+  //! Get the number of points sampled in each iteration.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points sampled in each iteration.
+  size_t& BatchSize() { return batchSize; }
+
+ private:
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! The number of points sampled in each iteration.
+  size_t batchSize;
+  //! The total number of points assigned to each cluster so far.
+  arma::Col<size_t> clusterCounts;
+
+  //! Number of distance calculations.
+  size_t distanceCalculations;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "mini_batch_kmeans_impl.hpp"
+
+#endif
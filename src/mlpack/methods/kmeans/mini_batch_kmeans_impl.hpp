@@ -0,0 +1,104 @@
+/**
+ * @file mini_batch_kmeans_impl.hpp
+ *
+ * Implementation of mini-batch k-means.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mini_batch_kmeans.hpp"
+#include "accumulate_point.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType, typename MatType>
+MiniBatchKMeans<MetricType, MatType>::MiniBatchKMeans(const MatType& dataset,
+                                                      MetricType& metric,
+                                                      const size_t batchSize) :
+    dataset(dataset),
+    metric(metric),
+    batchSize(batchSize),
+    distanceCalculations(0)
+{
+  if (batchSize == 0)
+    Log::Fatal << "MiniBatchKMeans: batch size must be greater than 0."
+        << std::endl;
+}
+
+// Run a single iteration.
+template<typename MetricType, typename MatType>
+double MiniBatchKMeans<MetricType, MatType>::Iterate(
+    const arma::mat& centroids,
+    arma::mat& newCentroids,
+    arma::Col<size_t>& counts)
+{
+  // If this is the first iteration, no points have been assigned yet.
+  if (clusterCounts.n_elem != centroids.n_cols)
+    clusterCounts.zeros(centroids.n_cols);
+
+  // Sample the batch.
+  arma::Col<size_t> batch(batchSize);
+  for (size_t i = 0; i < batchSize; ++i)
+    batch[i] = (size_t) math::RandInt(dataset.n_cols);
+
+  // Find the closest centroid to each point of the batch, using the centroids
+  // from the start of the iteration.  The points are independent, so they can
+  // be split across threads.
+  arma::Col<size_t> batchAssignments(batchSize);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+    {
+      const double distance = metric.Evaluate(dataset.col(batch[i]),
+                                              centroids.col(j));
+
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    Log::Assert(closestCluster != centroids.n_cols);
+    batchAssignments[i] = closestCluster;
+  }
+  distanceCalculations += batchSize * centroids.n_cols;
+
+  // Now take a gradient step for each point: move its centroid towards it with
+  // the learning rate 1 / (number of points assigned to the centroid so far).
+  // Centroids that were not assigned any points stay where they are.
+  newCentroids = centroids;
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    const size_t cluster = batchAssignments[i];
+    clusterCounts[cluster]++;
+    const double learningRate = 1.0 / (double) clusterCounts[cluster];
+
+    newCentroids.col(cluster) *= (1.0 - learningRate);
+    AccumulatePoint(dataset, batch[i], newCentroids, cluster, learningRate);
+  }
+
+  counts = clusterCounts;
+
+  // Calculate cluster distortion for this iteration.
+  double cNorm = 0.0;
+  for (size_t i = 0; i < centroids.n_cols; ++i)
+  {
+    cNorm += std::pow(metric.Evaluate(centroids.col(i), newCentroids.col(i)),
+        2.0);
+  }
+  distanceCalculations += centroids.n_cols;
+
+  return std::sqrt(cNorm);
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
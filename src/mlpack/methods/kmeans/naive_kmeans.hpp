@@ -18,6 +18,10 @@ namespace kmeans {
  * looking for the mlpack::kmeans::KMeans class instead of this one.  This class
  * is used by KMeans as the actual implementation of the Lloyd iteration.
  *
+ * The points are split across OpenMP threads (if mlpack was compiled with
+ * OpenMP); the number of threads can be set with the OMP_NUM_THREADS
+ * environment variable.
+ *
  * @param MetricType Type of metric used with this implementation.
  * @param MatType Matrix type (arma::mat or arma::sp_mat).
  */
@@ -11,6 +11,11 @@
 
 // In case it hasn't been included yet.
 #include "naive_kmeans.hpp"
+#include "accumulate_point.hpp"
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace kmeans {
@@ -32,29 +37,62 @@ double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   newCentroids.zeros(centroids.n_rows, centroids.n_cols);
   counts.zeros(centroids.n_cols);
 
-  // Find the closest centroid to each point and update the new centroids.
-  for (size_t i = 0; i < dataset.n_cols; i++)
+  // Find the closest centroid to each point and update the new centroids.  The
+  // points are split across threads; each thread sums its points into its own
+  // centroids and counts, which are added together in thread order at the
+  // end, so the result only depends on the number of threads.
+  size_t numThreads = 1;
+#ifdef HAS_OPENMP
+  numThreads = (size_t) omp_get_max_threads();
+#endif
+
+  std::vector<arma::mat> threadCentroids(numThreads);
+  std::vector<arma::Col<size_t> > threadCounts(numThreads);
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    threadCentroids[t].zeros(centroids.n_rows, centroids.n_cols);
+    threadCounts[t].zeros(centroids.n_cols);
+  }
+
+  #pragma omp parallel num_threads(numThreads)
   {
-    // Find the closest centroid to this point.
-    double minDistance = std::numeric_limits<double>::infinity();
-    size_t closestCluster = centroids.n_cols; // Invalid value.
+    size_t thread = 0;
+#ifdef HAS_OPENMP
+    thread = (size_t) omp_get_thread_num();
+#endif
 
-    for (size_t j = 0; j < centroids.n_cols; j++)
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < dataset.n_cols; i++)
     {
-      const double distance = metric.Evaluate(dataset.col(i), centroids.col(j));
+      // Find the closest centroid to this point.
+      double minDistance = std::numeric_limits<double>::infinity();
+      size_t closestCluster = centroids.n_cols; // Invalid value.
 
-      if (distance < minDistance)
+      for (size_t j = 0; j < centroids.n_cols; j++)
       {
-        minDistance = distance;
-        closestCluster = j;
+        const double distance = metric.Evaluate(dataset.col(i),
+                                                centroids.col(j));
+
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          closestCluster = j;
+        }
       }
-    }
 
-    Log::Assert(closestCluster != centroids.n_cols);
+      Log::Assert(closestCluster != centroids.n_cols);
 
-    // We now have the minimum distance centroid index.  Update that centroid.
-    newCentroids.col(closestCluster) += arma::vec(dataset.col(i));
-    counts(closestCluster)++;
+      // We now have the minimum distance centroid index.  Update that
+      // centroid.
+      AccumulatePoint(dataset, i, threadCentroids[thread], closestCluster);
+      threadCounts[thread](closestCluster)++;
+    }
+  }
+
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    newCentroids += threadCentroids[t];
+    counts += threadCounts[t];
   }
 
   // Now normalize the centroid.
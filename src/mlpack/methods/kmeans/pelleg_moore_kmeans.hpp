@@ -9,6 +9,7 @@
 #define __MLPACK_METHODS_KMEANS_PELLEG_MOORE_KMEANS_HPP
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 #include "pelleg_moore_kmeans_statistic.hpp"
 
 namespace mlpack {
@@ -64,6 +65,11 @@ class PellegMooreKMeans
   //! Modify the number of distance calculations.
   size_t& DistanceCalculations() { return distanceCalculations; }
 
+  //! Get the traversal statistics of tree building and all iterations.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of tree building and all iterations.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
   //! Convenience typedef for the tree.
   typedef tree::BinarySpaceTree<bound::HRectBound<2, true>,
       PellegMooreKMeansStatistic, MatType> TreeType;
@@ -83,6 +89,9 @@ class PellegMooreKMeans
 
   //! Track distance calculations.
   size_t distanceCalculations;
+
+  //! The traversal statistics of tree building and all iterations.
+  tree::TraversalStatistics statistics;
 };
 
 } // namespace kmeans
@@ -10,6 +10,7 @@
 
 #include "pelleg_moore_kmeans.hpp"
 #include "pelleg_moore_kmeans_rules.hpp"
+#include "subtree_split.hpp"
 
 namespace mlpack {
 namespace kmeans {
@@ -25,6 +26,7 @@ PellegMooreKMeans<MetricType, MatType>::PellegMooreKMeans(
     distanceCalculations(0)
 {
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   // Copy the dataset, if necessary.
   if (tree::TreeTraits<TreeType>::RearrangesDataset)
@@ -33,6 +35,7 @@ PellegMooreKMeans<MetricType, MatType>::PellegMooreKMeans(
   // Now build the tree.  We don't need any mappings.
   tree = new TreeType(const_cast<typename TreeType::Mat&>(this->dataset));
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
 }
 
@@ -53,18 +56,49 @@ double PellegMooreKMeans<MetricType, MatType>::Iterate(
   newCentroids.zeros(centroids.n_rows, centroids.n_cols);
   counts.zeros(centroids.n_cols);
 
-  // Create rules object.
+  // Split the tree into subtrees for the threads.  The blacklists of the nodes
+  // above the subtrees aren't computed, so they are emptied; then the roots of
+  // the subtrees start with empty blacklists, like the children of the root.
+  std::vector<TreeType*> subtrees, ancestors;
+  SplitIntoSubtrees(*tree, subtrees, ancestors);
+  for (size_t i = 0; i < ancestors.size(); ++i)
+    ancestors[i]->Stat().Blacklist().reset();
+
   typedef PellegMooreKMeansRules<MetricType, TreeType> RulesType;
-  RulesType rules(dataset, centroids, newCentroids, counts, metric);
 
-  // Use single-tree traverser.
-  typename TreeType::template SingleTreeTraverser<RulesType> traverser(rules);
+  // Each thread traverses its subtrees with its own rules object, which sums
+  // the points into its own centroids and counts; these are added together at
+  // the end.  The query index is fake (since the query index is irrelevant; we
+  // are checking each node with all clusters).
+  statistics.StartPhase("traversal");
+  #pragma omp parallel
+  {
+    arma::mat threadCentroids;
+    threadCentroids.zeros(centroids.n_rows, centroids.n_cols);
+    arma::Col<size_t> threadCounts;
+    threadCounts.zeros(centroids.n_cols);
+
+    RulesType rules(dataset, centroids, threadCentroids, threadCounts, metric);
+    typename TreeType::template SingleTreeTraverser<RulesType>
+        traverser(rules);
 
-  // Now, do a traversal with a fake query index (since the query index is
-  // irrelevant; we are checking each node with all clusters.
-  traverser.Traverse(0, *tree);
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      // The traverser only scores the children of the node it is given.
+      if (rules.Score(0, *subtrees[i]) != DBL_MAX)
+        traverser.Traverse(0, *subtrees[i]);
+    }
 
-  distanceCalculations += rules.DistanceCalculations();
+    #pragma omp critical
+    {
+      newCentroids += threadCentroids;
+      counts += threadCounts;
+      distanceCalculations += rules.DistanceCalculations();
+      statistics += rules.Statistics();
+    }
+  }
+  statistics.StopPhase("traversal");
 
   // Now, calculate how far the clusters moved, after normalizing them.
   double residual = 0.0;
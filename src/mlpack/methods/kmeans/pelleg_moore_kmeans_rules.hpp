@@ -9,6 +9,7 @@
 #ifndef __MLPACK_METHODS_KMEANS_PELLEG_MOORE_KMEANS_RULES_HPP
 #define __MLPACK_METHODS_KMEANS_PELLEG_MOORE_KMEANS_RULES_HPP
 
+#include <mlpack/core/tree/traversal_statistics.hpp>
 #include <mlpack/methods/neighbor_search/ns_traversal_info.hpp>
 
 namespace mlpack {
@@ -82,6 +83,11 @@ class PellegMooreKMeansRules
   //! Modify the number of distance calculations that have been performed.
   size_t& DistanceCalculations() { return distanceCalculations; }
 
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
  private:
   //! The dataset.
   const typename TreeType::Mat& dataset;
@@ -96,6 +102,9 @@ class PellegMooreKMeansRules
 
   //! The number of O(d) distance calculations that have been performed.
   size_t distanceCalculations;
+
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
 };
 
 }; // namespace kmeans
@@ -125,7 +125,7 @@ double PellegMooreKMeansRules<MetricType, TreeType>::Score(
     newCentroids.col(closestCluster) += referenceNode.NumDescendants() *
         referenceNode.Stat().Centroid();
 
-    return DBL_MAX;
+    return statistics.Score(DBL_MAX, referenceNode);
   }
 
   // Perform the base case here.
@@ -139,6 +139,7 @@ double PellegMooreKMeansRules<MetricType, TreeType>::Score(
         continue;
 
       ++distanceCalculations;
+      ++statistics.BaseCases();
 
       // The reference index is the index of the data point.
       const double distance = metric.Evaluate(centroids.col(c),
@@ -158,7 +159,7 @@ double PellegMooreKMeansRules<MetricType, TreeType>::Score(
 
   // Otherwise, we're not sure, so we can't prune.  Recursion order doesn't make
   // a difference, so we'll just return a score of 0.
-  return 0.0;
+  return statistics.Score(0.0, referenceNode);
 }
 
 template<typename MetricType, typename TreeType>
@@ -0,0 +1,78 @@
+/**
+ * @file subtree_split.hpp
+ *
+ * A utility to split a tree into disjoint subtrees, so that the tree-based
+ * k-means algorithms can traverse the subtrees on different OpenMP threads.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_SUBTREE_SPLIT_HPP
+#define __MLPACK_METHODS_KMEANS_SUBTREE_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+#include <deque>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * Split the given tree into disjoint subtrees which together hold every point
+ * of the tree, so that each subtree can be traversed by a different thread.
+ * Nodes are split breadth-first, starting from the root, until there are a few
+ * subtrees for each OpenMP thread (this gives the OpenMP runtime some slack to
+ * balance the load when the subtrees take different amounts of time) or no
+ * subtree can be split (only nodes without points of their own are split).
+ * Without OpenMP, the only subtree is the root.
+ *
+ * The nodes that were split are stored in 'ancestors', with every node after
+ * its parent; each ancestor is an ancestor of some subtree, and isn't visited
+ * by a traversal of the subtrees, so its statistic must be prepared for the
+ * iteration by the caller.
+ *
+ * @param root Root of the tree to split.
+ * @param subtrees Vector to store the roots of the subtrees in.
+ * @param ancestors Vector to store the nodes that were split in.
+ */
+template<typename TreeType>
+void SplitIntoSubtrees(TreeType& root,
+                       std::vector<TreeType*>& subtrees,
+                       std::vector<TreeType*>& ancestors)
+{
+  size_t threads = 1;
+#ifdef HAS_OPENMP
+  threads = (size_t) omp_get_max_threads();
+#endif
+  const size_t minSubtrees = (threads > 1) ? 4 * threads : 1;
+
+  subtrees.clear();
+  ancestors.clear();
+
+  std::deque<TreeType*> queue;
+  queue.push_back(&root);
+  while (!queue.empty() && subtrees.size() + queue.size() < minSubtrees)
+  {
+    TreeType* node = queue.front();
+    queue.pop_front();
+
+    // A node that holds points of its own can't be split without losing them.
+    if (node->NumChildren() == 0 || node->NumPoints() > 0)
+    {
+      subtrees.push_back(node);
+      continue;
+    }
+
+    ancestors.push_back(node);
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      queue.push_back(&node->Child(i));
+  }
+
+  subtrees.insert(subtrees.end(), queue.begin(), queue.end());
+}
+
+}; // namespace kmeans
+}; // namespace mlpack
+
+#endif
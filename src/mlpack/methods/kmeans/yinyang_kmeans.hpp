@@ -0,0 +1,108 @@
+/**
+ * @file yinyang_kmeans.hpp
+ *
+ * An implementation of Yinyang k-means (Ding et al., "Yinyang K-Means: A
+ * Drop-In Replacement of the Classic K-Means with Consistent Speedup", 2015)
+ * for exact Lloyd iterations.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * Yinyang k-means splits the centroids into t groups (by clustering the initial
+ * centroids), and keeps, for each point, an upper bound on the distance to its
+ * closest centroid and one lower bound for each group, on the distance to every
+ * centroid of that group (other than the assigned centroid).  A whole group is
+ * skipped when its lower bound is not less than the upper bound, and inside the
+ * other groups each centroid whose own movement keeps it far enough is skipped.
+ *
+ * This prunes about as well as Elkan's algorithm for large k, but the lower
+ * bounds take N x t floats instead of N x k doubles.  The lower bounds are
+ * rounded down when they are stored as floats, so they stay valid.
+ */
+template<typename MetricType, typename MatType>
+class YinyangKMeans
+{
+ public:
+  /**
+   * Construct the YinyangKMeans object, which must store several sets of
+   * bounds.
+   *
+   * @param dataset Dataset to cluster.
+   * @param metric Instantiated metric.
+   * @param numGroups Number of groups of centroids (0 means one group for
+   *     every 10 centroids, as suggested in the paper).
+   */
+  YinyangKMeans(const MatType& dataset,
+                MetricType& metric,
+                const size_t numGroups = 0);
+
+  /**
+   * Run a single iteration of Yinyang k-means, updating the given centroids
+   * into the newCentroids matrix.  The groups are chosen in the first
+   * iteration.
+   *
+   * @param centroids Current cluster centroids.
+   * @param newCentroids New cluster centroids.
+   * @param counts Current counts, to be overwritten with new counts.
+   *
+   * The points are split across OpenMP threads (if mlpack was compiled with
+   * OpenMP); the number of threads can be set with the OMP_NUM_THREADS
+   * environment variable.
+   */
+  double Iterate(const arma::mat& centroids,
+                 arma::mat& newCentroids,
+                 arma::Col<size_t>& counts);
+
+  size_t DistanceCalculations() const { return distanceCalculations; }
+
+ private:
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+  //! The requested number of groups (0 for the default).
+  size_t requestedGroups;
+
+  //! The group of each centroid.
+  arma::Col<size_t> clusterGroups;
+  //! The centroids of each group, one group after another.
+  arma::Col<size_t> groupMembers;
+  //! The index in groupMembers of the first centroid of each group (and the
+  //! number of centroids at the end).
+  arma::Col<size_t> groupOffsets;
+
+  //! How far each centroid moved in the last iteration.
+  arma::vec clusterMovements;
+  //! How far the furthest moving centroid of each group moved in the last
+  //! iteration.
+  arma::vec groupMovements;
+
+  //! Holds the index of the cluster that owns each point.
+  arma::Col<size_t> assignments;
+  //! Upper bounds on the distance between each point and its closest cluster.
+  arma::vec upperBounds;
+  //! Lower bounds on the distance between each point and the clusters of each
+  //! group (one column per point).
+  arma::fmat lowerBounds;
+
+  //! Track distance calculations.
+  size_t distanceCalculations;
+
+  //! Split the given centroids into groups by running a few Lloyd iterations on
+  //! them.
+  void MakeGroups(const arma::mat& centroids);
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "yinyang_kmeans_impl.hpp"
+
+#endif
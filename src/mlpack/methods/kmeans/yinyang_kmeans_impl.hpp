@@ -0,0 +1,318 @@
+/**
+ * @file yinyang_kmeans_impl.hpp
+ *
+ * An implementation of Yinyang k-means for exact Lloyd iterations.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "yinyang_kmeans.hpp"
+#include "accumulate_point.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * Convert the given lower bound to a float that is not greater than it, so that
+ * it is still a lower bound.
+ */
+inline float LowerBoundToFloat(const double bound)
+{
+  if (bound >= (double) FLT_MAX)
+    return FLT_MAX;
+  if (bound <= -(double) FLT_MAX)
+    return -std::numeric_limits<float>::infinity();
+
+  const float rounded = (float) bound;
+  return ((double) rounded > bound) ? nextafterf(rounded, -FLT_MAX) : rounded;
+}
+
+template<typename MetricType, typename MatType>
+YinyangKMeans<MetricType, MatType>::YinyangKMeans(const MatType& dataset,
+                                                  MetricType& metric,
+                                                  const size_t numGroups) :
+    dataset(dataset),
+    metric(metric),
+    requestedGroups(numGroups),
+    distanceCalculations(0)
+{
+
+}
+
+template<typename MetricType, typename MatType>
+void YinyangKMeans<MetricType, MatType>::MakeGroups(const arma::mat& centroids)
+{
+  const size_t numClusters = centroids.n_cols;
+  size_t numGroups = (requestedGroups == 0) ? (numClusters + 9) / 10 :
+      requestedGroups;
+  numGroups = std::max((size_t) 1, std::min(numGroups, numClusters));
+
+  // Start from evenly spaced centroids, and run five Lloyd iterations on the
+  // centroids, as in the paper.
+  arma::mat groupCentroids(centroids.n_rows, numGroups);
+  for (size_t g = 0; g < numGroups; ++g)
+    groupCentroids.col(g) = centroids.col(g * numClusters / numGroups);
+
+  clusterGroups.set_size(numClusters);
+  arma::Col<size_t> groupCounts(numGroups);
+  for (size_t iteration = 0; iteration < 5; ++iteration)
+  {
+    for (size_t c = 0; c < numClusters; ++c)
+    {
+      double bestDistance = DBL_MAX;
+      for (size_t g = 0; g < numGroups; ++g)
+      {
+        const double distance = metric.Evaluate(centroids.col(c),
+                                                groupCentroids.col(g));
+        if (distance < bestDistance)
+        {
+          bestDistance = distance;
+          clusterGroups[c] = g;
+        }
+      }
+    }
+    distanceCalculations += numClusters * numGroups;
+
+    arma::mat sums;
+    sums.zeros(centroids.n_rows, numGroups);
+    groupCounts.zeros();
+    for (size_t c = 0; c < numClusters; ++c)
+    {
+      sums.col(clusterGroups[c]) += centroids.col(c);
+      ++groupCounts[clusterGroups[c]];
+    }
+
+    for (size_t g = 0; g < numGroups; ++g)
+      if (groupCounts[g] > 0)
+        groupCentroids.col(g) = sums.col(g) / groupCounts[g];
+  }
+
+  // Drop the empty groups, and list the centroids of each group.
+  arma::Col<size_t> groupIndices(numGroups);
+  size_t nonEmptyGroups = 0;
+  for (size_t g = 0; g < numGroups; ++g)
+    if (groupCounts[g] > 0)
+      groupIndices[g] = nonEmptyGroups++;
+
+  groupOffsets.zeros(nonEmptyGroups + 1);
+  for (size_t c = 0; c < numClusters; ++c)
+  {
+    clusterGroups[c] = groupIndices[clusterGroups[c]];
+    ++groupOffsets[clusterGroups[c] + 1];
+  }
+  for (size_t g = 0; g < nonEmptyGroups; ++g)
+    groupOffsets[g + 1] += groupOffsets[g];
+
+  arma::Col<size_t> nextMember = groupOffsets.subvec(0, nonEmptyGroups - 1);
+  groupMembers.set_size(numClusters);
+  for (size_t c = 0; c < numClusters; ++c)
+    groupMembers[nextMember[clusterGroups[c]]++] = c;
+
+  clusterMovements.zeros(numClusters);
+  groupMovements.zeros(nonEmptyGroups);
+
+  Log::Info << "Yinyang k-means: split " << numClusters << " centroids into "
+      << nonEmptyGroups << " groups." << std::endl;
+}
+
+// Run a single iteration of Yinyang k-means.
+template<typename MetricType, typename MatType>
+double YinyangKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
+                                                   arma::mat& newCentroids,
+                                                   arma::Col<size_t>& counts)
+{
+  // If this is the first iteration, make the groups and reset all the bounds.
+  // With every point assigned to cluster 0 and all lower bounds 0, the first
+  // iteration computes every distance.
+  if (clusterGroups.n_elem != centroids.n_cols)
+  {
+    MakeGroups(centroids);
+    assignments.zeros(dataset.n_cols);
+    upperBounds.set_size(dataset.n_cols);
+    upperBounds.fill(DBL_MAX);
+    lowerBounds.zeros(groupMovements.n_elem, dataset.n_cols);
+  }
+
+  const size_t numClusters = centroids.n_cols;
+  const size_t numGroups = groupMovements.n_elem;
+
+  // Clear new centroids.
+  newCentroids.zeros(centroids.n_rows, numClusters);
+  counts.zeros(numClusters);
+
+  // The bounds and assignment of each point are only used by the thread
+  // handling that point, and each thread sums its points into its own
+  // centroids and counts, which are added together at the end.
+  size_t pointDistanceCalculations = 0;
+  #pragma omp parallel
+  {
+    arma::mat threadCentroids;
+    threadCentroids.zeros(centroids.n_rows, numClusters);
+    arma::Col<size_t> threadCounts;
+    threadCounts.zeros(numClusters);
+    size_t threadDistanceCalculations = 0;
+
+    // For the searched groups of the current point: the two smallest distances
+    // (or lower bounds on them) and the cluster with the smallest.
+    std::vector<bool> searched(numGroups);
+    arma::vec groupBest(numGroups);
+    arma::vec groupSecondBest(numGroups);
+    arma::Col<size_t> groupBestCluster(numGroups);
+
+    #pragma omp for schedule(dynamic, 256)
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+    {
+      float* lowerBound = lowerBounds.colptr(i);
+      const size_t oldAssignment = assignments[i];
+
+      // Global filter: no cluster can be closer than the smallest lower bound.
+      float globalLowerBound = lowerBound[0];
+      for (size_t g = 1; g < numGroups; ++g)
+        globalLowerBound = std::min(globalLowerBound, lowerBound[g]);
+
+      if (upperBounds(i) <= globalLowerBound)
+      {
+        AccumulatePoint(dataset, i, threadCentroids, oldAssignment);
+        ++threadCounts(oldAssignment);
+        continue;
+      }
+
+      // Tighten the upper bound and try again.
+      const double oldDistance = metric.Evaluate(dataset.col(i),
+          centroids.col(oldAssignment));
+      ++threadDistanceCalculations;
+      upperBounds(i) = oldDistance;
+      if (oldDistance <= globalLowerBound)
+      {
+        AccumulatePoint(dataset, i, threadCentroids, oldAssignment);
+        ++threadCounts(oldAssignment);
+        continue;
+      }
+
+      size_t assignment = oldAssignment;
+      double bestDistance = oldDistance;
+      for (size_t g = 0; g < numGroups; ++g)
+      {
+        // Group filter: no cluster of this group can be closer.
+        searched[g] = (lowerBound[g] < bestDistance);
+        if (!searched[g])
+          continue;
+
+        groupBest[g] = DBL_MAX;
+        groupSecondBest[g] = DBL_MAX;
+        groupBestCluster[g] = numClusters;
+
+        // The lower bound of the group before the movement of its furthest
+        // moving cluster was subtracted; the distance to each cluster is at
+        // least this minus the movement of that cluster.
+        const double previousBound = lowerBound[g] + groupMovements[g];
+        for (size_t j = groupOffsets[g]; j < groupOffsets[g + 1]; ++j)
+        {
+          const size_t c = groupMembers[j];
+          double distance;
+          if (c == oldAssignment)
+          {
+            distance = oldDistance;
+          }
+          else if (previousBound - clusterMovements[c] >= bestDistance)
+          {
+            // Local filter: this cluster cannot be closer, and its bound is
+            // good enough for the new lower bound of the group.
+            distance = previousBound - clusterMovements[c];
+          }
+          else
+          {
+            distance = metric.Evaluate(dataset.col(i), centroids.col(c));
+            ++threadDistanceCalculations;
+          }
+
+          if (distance < groupBest[g])
+          {
+            groupSecondBest[g] = groupBest[g];
+            groupBest[g] = distance;
+            groupBestCluster[g] = c;
+          }
+          else if (distance < groupSecondBest[g])
+          {
+            groupSecondBest[g] = distance;
+          }
+
+          if (distance < bestDistance)
+          {
+            bestDistance = distance;
+            assignment = c;
+          }
+        }
+      }
+
+      assignments[i] = assignment;
+      upperBounds(i) = bestDistance;
+
+      // The lower bound of each searched group is its smallest distance to a
+      // cluster other than the new assignment.  If the point moved, the old
+      // cluster also bounds its group, which may not have been searched.
+      for (size_t g = 0; g < numGroups; ++g)
+      {
+        if (searched[g])
+          lowerBound[g] = LowerBoundToFloat((groupBestCluster[g] ==
+              assignment) ? groupSecondBest[g] : groupBest[g]);
+        else if (assignment != oldAssignment &&
+                 g == clusterGroups[oldAssignment])
+          lowerBound[g] = std::min(lowerBound[g],
+              LowerBoundToFloat(oldDistance));
+      }
+
+      AccumulatePoint(dataset, i, threadCentroids, assignment);
+      ++threadCounts(assignment);
+    }
+
+    #pragma omp critical
+    {
+      newCentroids += threadCentroids;
+      counts += threadCounts;
+      pointDistanceCalculations += threadDistanceCalculations;
+    }
+  }
+  distanceCalculations += pointDistanceCalculations;
+
+  // Now, normalize and calculate the distance each cluster (and the furthest
+  // moving cluster of each group) has moved.
+  double cNorm = 0.0; // Cluster movement for residual.
+  groupMovements.zeros();
+  for (size_t c = 0; c < numClusters; ++c)
+  {
+    if (counts[c] > 0)
+      newCentroids.col(c) /= counts[c];
+    else
+      newCentroids.col(c).fill(DBL_MAX); // Empty cluster.
+
+    clusterMovements[c] = metric.Evaluate(newCentroids.col(c),
+                                          centroids.col(c));
+    cNorm += std::pow(clusterMovements[c], 2.0);
+    ++distanceCalculations;
+
+    const size_t g = clusterGroups[c];
+    groupMovements[g] = std::max(groupMovements[g], clusterMovements[c]);
+  }
+
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    upperBounds(i) += clusterMovements[assignments[i]];
+    for (size_t g = 0; g < numGroups; ++g)
+      lowerBounds(g, i) = LowerBoundToFloat((double) lowerBounds(g, i) -
+          groupMovements[g]);
+  }
+
+  return std::sqrt(cNorm);
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
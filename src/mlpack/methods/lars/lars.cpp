@@ -6,9 +6,28 @@
  */
 #include "lars.hpp"
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::regression;
 
+namespace {
+
+//! The timers are not thread-safe, so LARS is not timed when it is run inside
+//! a parallel region (as by LocalCoordinateCoding).
+bool Timed()
+{
+#ifdef HAS_OPENMP
+  return !omp_in_parallel();
+#else
+  return true;
+#endif
+}
+
+} // anonymous namespace
+
 LARS::LARS(const bool useCholesky,
            const double lambda1,
            const double lambda2,
@@ -41,7 +60,9 @@ void LARS::Regress(const arma::mat& matX,
                    arma::vec& beta,
                    const bool transposeData)
 {
-  Timer::Start("lars_regression");
+  const bool timed = Timed();
+  if (timed)
+    Timer::Start("lars_regression");
 
   // This matrix may end up holding the transpose -- if necessary.
   arma::mat dataTrans;
@@ -51,14 +72,131 @@ void LARS::Regress(const arma::mat& matX,
     dataTrans = trans(matX);
 
   // Compute X' * y.
-  arma::vec vecXTy = trans(dataRef) * y;
+  const arma::vec vecXTy = trans(dataRef) * y;
+
+  RegressInternal(dataRef, vecXTy, beta);
+
+  if (timed)
+    Timer::Stop("lars_regression");
+}
+
+void LARS::Regress(const arma::mat& matX,
+                   const arma::mat& responses,
+                   arma::mat& beta,
+                   const bool transposeData)
+{
+  Timer::Start("lars_regression");
+
+  arma::mat dataTrans;
+  const arma::mat& dataRef = (transposeData ? dataTrans : matX);
+  if (transposeData)
+    dataTrans = trans(matX);
+
+  // Compute X' * y for every right-hand side with one product, and the Gram
+  // matrix once, instead of once for each right-hand side.
+  const arma::mat matXTy = trans(dataRef) * responses;
+  if (matGram.n_elem == 0)
+    ComputeGram(dataRef);
+
+  beta.set_size(dataRef.n_cols, responses.n_cols);
+
+  // Each right-hand side is solved by its own LARS object, which shares the
+  // Gram matrix.  The number of steps varies a lot between right-hand sides,
+  // so they are scheduled dynamically.
+  #pragma omp parallel for schedule(dynamic, 16)
+  for (size_t i = 0; i < responses.n_cols; ++i)
+  {
+    LARS lars(useCholesky, matGram, lambda1, lambda2, tolerance);
+    arma::vec b = beta.unsafe_col(i);
+    lars.RegressInternal(dataRef, matXTy.col(i), b);
+  }
+
+  // The paths of the individual right-hand sides are not kept.
+  betaPath.clear();
+  lambdaPath.clear();
+  activeSet.clear();
+  ignoreSet.clear();
+  matUtriCholFactor.reset();
+
+  Timer::Stop("lars_regression");
+}
+
+void LARS::Regress(const arma::mat& matX,
+                   const arma::mat& responses,
+                   arma::sp_mat& beta,
+                   const bool transposeData)
+{
+  Timer::Start("lars_regression");
+
+  arma::mat dataTrans;
+  const arma::mat& dataRef = (transposeData ? dataTrans : matX);
+  if (transposeData)
+    dataTrans = trans(matX);
+
+  if (matGram.n_elem == 0)
+    ComputeGram(dataRef);
+
+  // The nonzero coefficients of each solution, in increasing order of
+  // dimension.  The coefficients that the final interpolation of the path
+  // brings back need not be in the active set, so each solution is scanned;
+  // it is only as long as the number of dimensions.
+  std::vector<std::vector<std::pair<size_t, double> > > nonzeros(
+      responses.n_cols);
+
+  const size_t blockSize = 1024;
+  for (size_t begin = 0; begin < responses.n_cols; begin += blockSize)
+  {
+    const size_t end = std::min(begin + blockSize, (size_t) responses.n_cols);
+    const arma::mat matXTy = trans(dataRef) * responses.cols(begin, end - 1);
+
+    #pragma omp parallel
+    {
+      arma::vec b;
+
+      #pragma omp for schedule(dynamic, 16)
+      for (size_t i = begin; i < end; ++i)
+      {
+        LARS lars(useCholesky, matGram, lambda1, lambda2, tolerance);
+        lars.RegressInternal(dataRef, matXTy.col(i - begin), b);
+
+        nonzeros[i].reserve(lars.ActiveSet().size());
+        for (size_t j = 0; j < b.n_elem; ++j)
+          if (b[j] != 0.0)
+            nonzeros[i].push_back(std::make_pair(j, b[j]));
+      }
+    }
+  }
+
+  math::SparseFromColumns(nonzeros, dataRef.n_cols, beta);
+
+  // The paths of the individual right-hand sides are not kept.
+  betaPath.clear();
+  lambdaPath.clear();
+  activeSet.clear();
+  ignoreSet.clear();
+  matUtriCholFactor.reset();
+
+  Timer::Stop("lars_regression");
+}
+
+void LARS::RegressInternal(const arma::mat& dataRef,
+                           const arma::vec& vecXTy,
+                           arma::vec& beta)
+{
+  // Reset the state of any previous regression, so that the same object can
+  // be used for many right-hand sides.
+  betaPath.clear();
+  lambdaPath.clear();
+  activeSet.clear();
+  ignoreSet.clear();
+  matUtriCholFactor.reset();
 
   // Set up active set variables.  In the beginning, the active set has size 0
   // (all dimensions are inactive).
-  isActive.resize(dataRef.n_cols, false);
+  isActive.assign(dataRef.n_cols, false);
 
   // Set up ignores set variables. Initialized empty.
-  isIgnored.resize(dataRef.n_cols, false);
+  isIgnored.assign(dataRef.n_cols, false);
 
   // Initialize yHat and beta.
   beta = arma::zeros(dataRef.n_cols);
@@ -87,20 +225,11 @@ void LARS::Regress(const arma::mat& matX,
   if (maxCorr < lambda1)
   {
     lambdaPath[0] = lambda1;
-    Timer::Stop("lars_regression");
     return;
   }
 
-  // Compute the Gram matrix.  If this is the elastic net problem, we will add
-  // lambda2 * I_n to the matrix.
   if (matGram.n_elem == 0)
-  {
-    // In this case, matGram should reference matGramInternal.
-    matGramInternal = trans(dataRef) * dataRef;
-
-    if (elasticNet && !useCholesky)
-      matGramInternal += lambda2 * arma::eye(dataRef.n_cols, dataRef.n_cols);
-  }
+    ComputeGram(dataRef);
 
   // Main loop.
   while (((activeSet.size() + ignoreSet.size()) < dataRef.n_cols) &&
@@ -318,11 +447,19 @@ void LARS::Regress(const arma::mat& matX,
 
   // Unfortunate copy...
   beta = betaPath.back();
-
-  Timer::Stop("lars_regression");
 }
 
 // Private functions.
+void LARS::ComputeGram(const arma::mat& dataRef)
+{
+  // In this case, matGram should reference matGramInternal.  If this is the
+  // elastic net problem, we will add lambda2 * I_n to the matrix.
+  matGramInternal = trans(dataRef) * dataRef;
+
+  if (elasticNet && !useCholesky)
+    matGramInternal += lambda2 * arma::eye(dataRef.n_cols, dataRef.n_cols);
+}
+
 void LARS::Deactivate(const size_t activeVarInd)
 {
   isActive[activeSet[activeVarInd]] = false;
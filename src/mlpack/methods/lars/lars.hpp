@@ -125,6 +125,10 @@ class LARS
    * necessary (i.e., you want to pass in a row-major matrix), pass 'false' for
    * the transposeData parameter.
    *
+   * The same LARS object can be used for many calls to Regress(); if it
+   * computed the Gram matrix itself, that Gram matrix is kept for later calls,
+   * which must then be made with the same data.
+   *
    * @param data Column-major input data (or row-major input data if rowMajor =
    *     true).
    * @param responses A vector of targets.
@@ -136,6 +140,46 @@ class LARS
                arma::vec& beta,
                const bool transposeData = true);
 
+  /**
+   * Run LARS for many right-hand sides with the same data, as in sparse coding
+   * with a fixed dictionary.  X^T y is computed for all the right-hand sides
+   * with one matrix product, the Gram matrix is computed only once (if it was
+   * not given to the constructor), and the right-hand sides are solved in
+   * parallel with OpenMP.  The solution paths are not kept, so ActiveSet(),
+   * BetaPath() and LambdaPath() are empty afterwards.
+   *
+   * @param data Column-major input data (or row-major input data if
+   *     transposeData = false).
+   * @param responses Matrix of targets, one column for each right-hand side.
+   * @param beta Matrix to store the solutions in, one column for each
+   *     right-hand side.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  void Regress(const arma::mat& data,
+               const arma::mat& responses,
+               arma::mat& beta,
+               const bool transposeData = true);
+
+  /**
+   * Run LARS for many right-hand sides with the same data, as above, but store
+   * the solutions in a sparse matrix, which is assembled directly from the
+   * nonzero coefficients of each solution.  With lambda1 > 0 most coefficients
+   * are zero, so for many right-hand sides this takes much less memory than a
+   * dense matrix of solutions.  The right-hand sides are solved in blocks, so
+   * X^T y is never held for all of them at once.
+   *
+   * @param data Column-major input data (or row-major input data if
+   *     transposeData = false).
+   * @param responses Matrix of targets, one column for each right-hand side.
+   * @param beta Sparse matrix to store the solutions in, one column for each
+   *     right-hand side.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  void Regress(const arma::mat& data,
+               const arma::mat& responses,
+               arma::sp_mat& beta,
+               const bool transposeData = true);
+
   //! Access the set of active dimensions.
   const std::vector<size_t>& ActiveSet() const { return activeSet; }
 
@@ -199,6 +243,21 @@ class LARS
   //! Membership indicator for set of ignored variables.
   std::vector<bool> isIgnored;
 
+  /**
+   * Run LARS on row-major data with precomputed X^T y.  Any state from a
+   * previous regression is reset first.
+   *
+   * @param dataRef Row-major input data.
+   * @param vecXTy X^T y.
+   * @param beta Vector to store the solution in.
+   */
+  void RegressInternal(const arma::mat& dataRef,
+                       const arma::vec& vecXTy,
+                       arma::vec& beta);
+
+  //! Compute the Gram matrix of the row-major data into matGramInternal.
+  void ComputeGram(const arma::mat& dataRef);
+
   /**
    * Remove activeVarInd'th element from active set.
    *
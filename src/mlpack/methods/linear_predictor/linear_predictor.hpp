@@ -0,0 +1,137 @@
+/**
+ * @file linear_predictor.hpp
+ *
+ * A blocked, parallel prediction engine for linear classifiers such as
+ * LogisticRegression and SoftmaxRegression.
+ */
+#ifndef __MLPACK_METHODS_LINEAR_PREDICTOR_LINEAR_PREDICTOR_HPP
+#define __MLPACK_METHODS_LINEAR_PREDICTOR_LINEAR_PREDICTOR_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace regression {
+
+/**
+ * The LinearPredictor class computes the predictions of a linear classifier
+ * with k rows of weights W and an optional bias vector b.  The scores of a
+ * point x are s = W x + b; with one row of weights (as in logistic
+ * regression) the probability of class 1 is sigmoid(s), and with more than one
+ * row (as in softmax regression) the class probabilities are softmax(s).
+ *
+ * The points are processed in blocks of BlockSize() columns: the scores of a
+ * block are computed with one matrix-matrix product into a k x BlockSize()
+ * buffer that stays in cache, and the probabilities (with the log-sum-exp
+ * shift, so that large scores don't overflow) or the most likely classes are
+ * computed from the buffer, without building any temporaries the size of the
+ * dataset.  The blocks are processed in parallel with OpenMP.  If the output
+ * object already has the right size, no memory is allocated for it, so the
+ * same output buffers can be reused for each batch of requests.
+ *
+ * The weights can be stored in single precision (eT = float), which halves
+ * the memory traffic of the products; points in a different precision than
+ * the weights are converted one block at a time.  Sparse points (arma::sp_mat)
+ * are supported too, and only their non-zero entries are visited.
+ *
+ * @code
+ * SoftmaxRegression<> sr(data, labels, inputSize, numClasses);
+ * LinearPredictor<float> predictor(sr.Parameters());
+ *
+ * arma::vec predictions;
+ * predictor.Classify(testData, predictions);
+ * @endcode
+ *
+ * @tparam eT Element type of the weights (double or float).
+ */
+template<typename eT = double>
+class LinearPredictor
+{
+ public:
+  /**
+   * Create the predictor with the given weights, which are copied (and
+   * converted to eT).
+   *
+   * @param weights Weights of the classifier, one row for each score.
+   * @param bias Bias of each score; if empty, no bias is added.
+   * @param blockSize Number of points in each block.
+   */
+  LinearPredictor(const arma::mat& weights,
+                  const arma::vec& bias = arma::vec(),
+                  const size_t blockSize = 256);
+
+  /**
+   * Compute the class probabilities of each point.  With one row of weights,
+   * the probability of class 1 is stored, in a matrix with one row; otherwise,
+   * the probability of each class is stored, one column for each point.
+   *
+   * @param data Points to compute the probabilities of.
+   * @param probabilities Matrix to store the probabilities in.
+   */
+  template<typename MatType>
+  void Probabilities(const MatType& data, arma::Mat<eT>& probabilities) const;
+
+  /**
+   * Predict the class of each point.  With more than one row of weights, the
+   * class with the highest score is predicted.  With one row of weights, the
+   * prediction is 1 if sigmoid(s) is at least the decision boundary, and 0
+   * otherwise.
+   *
+   * @param data Points to classify.
+   * @param predictions Vector to store the predictions in.
+   * @param decisionBoundary Decision boundary for one row of weights.
+   */
+  template<typename MatType>
+  void Classify(const MatType& data,
+                arma::vec& predictions,
+                const double decisionBoundary = 0.5) const;
+
+  //! Get the weights.
+  const arma::Mat<eT>& Weights() const { return weights; }
+  //! Get the bias (empty if there is none).
+  const arma::Col<eT>& Bias() const { return bias; }
+
+  //! Get the number of points in each block.
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of points in each block.
+  size_t& BlockSize() { return blockSize; }
+
+ private:
+  //! Weights of the classifier.
+  arma::Mat<eT> weights;
+  //! Bias of each score.
+  arma::Col<eT> bias;
+  //! Number of points in each block.
+  size_t blockSize;
+
+  //! Compute the scores of points begin through (end - 1), which are in the
+  //! same precision as the weights.
+  void Scores(const arma::Mat<eT>& data,
+              const size_t begin,
+              const size_t end,
+              arma::Mat<eT>& block,
+              arma::Mat<eT>& scores) const;
+
+  //! Compute the scores of points begin through (end - 1), converting them to
+  //! the precision of the weights in the given block buffer first.
+  template<typename InputType>
+  void Scores(const arma::Mat<InputType>& data,
+              const size_t begin,
+              const size_t end,
+              arma::Mat<eT>& block,
+              arma::Mat<eT>& scores) const;
+
+  //! Compute the scores of points begin through (end - 1) of a sparse matrix.
+  void Scores(const arma::sp_mat& data,
+              const size_t begin,
+              const size_t end,
+              arma::Mat<eT>& block,
+              arma::Mat<eT>& scores) const;
+};
+
+}; // namespace regression
+}; // namespace mlpack
+
+// Include implementation.
+#include "linear_predictor_impl.hpp"
+
+#endif
@@ -0,0 +1,182 @@
+/**
+ * @file linear_predictor_impl.hpp
+ *
+ * Implementation of the LinearPredictor class.
+ */
+#ifndef __MLPACK_METHODS_LINEAR_PREDICTOR_LINEAR_PREDICTOR_IMPL_HPP
+#define __MLPACK_METHODS_LINEAR_PREDICTOR_LINEAR_PREDICTOR_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "linear_predictor.hpp"
+
+namespace mlpack {
+namespace regression {
+
+template<typename eT>
+LinearPredictor<eT>::LinearPredictor(const arma::mat& weights,
+                                     const arma::vec& bias,
+                                     const size_t blockSize) :
+    weights(arma::conv_to<arma::Mat<eT> >::from(weights)),
+    bias(arma::conv_to<arma::Col<eT> >::from(bias)),
+    blockSize(blockSize)
+{
+  if (!bias.is_empty() && (bias.n_elem != weights.n_rows))
+    Log::Fatal << "LinearPredictor: the bias must have one element for each "
+        << "row of the weights (" << weights.n_rows << "), not "
+        << bias.n_elem << "!" << std::endl;
+
+  if (blockSize == 0)
+    Log::Fatal << "LinearPredictor: the block size must be positive!"
+        << std::endl;
+}
+
+template<typename eT>
+template<typename MatType>
+void LinearPredictor<eT>::Probabilities(const MatType& data,
+                                        arma::Mat<eT>& probabilities) const
+{
+  const size_t numBlocks = (data.n_cols + blockSize - 1) / blockSize;
+  probabilities.set_size(weights.n_rows, data.n_cols);
+
+  #pragma omp parallel
+  {
+    // Each thread has its own buffers, allocated once.
+    arma::Mat<eT> block, scores;
+
+    #pragma omp for schedule(static)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min((size_t) data.n_cols, begin + blockSize);
+      Scores(data, begin, end, block, scores);
+
+      for (size_t i = 0; i < end - begin; ++i)
+      {
+        const eT* s = scores.colptr(i);
+        eT* p = probabilities.colptr(begin + i);
+
+        if (weights.n_rows == 1)
+        {
+          p[0] = 1 / (1 + std::exp(-s[0]));
+          continue;
+        }
+
+        // Shift the scores by their maximum before taking the exponentials.
+        eT maxScore = s[0];
+        for (size_t j = 1; j < weights.n_rows; ++j)
+          maxScore = std::max(maxScore, s[j]);
+
+        eT sum = 0;
+        for (size_t j = 0; j < weights.n_rows; ++j)
+        {
+          p[j] = std::exp(s[j] - maxScore);
+          sum += p[j];
+        }
+
+        for (size_t j = 0; j < weights.n_rows; ++j)
+          p[j] /= sum;
+      }
+    }
+  }
+}
+
+template<typename eT>
+template<typename MatType>
+void LinearPredictor<eT>::Classify(const MatType& data,
+                                   arma::vec& predictions,
+                                   const double decisionBoundary) const
+{
+  const size_t numBlocks = (data.n_cols + blockSize - 1) / blockSize;
+  predictions.set_size(data.n_cols);
+
+  #pragma omp parallel
+  {
+    arma::Mat<eT> block, scores;
+
+    #pragma omp for schedule(static)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min((size_t) data.n_cols, begin + blockSize);
+      Scores(data, begin, end, block, scores);
+
+      for (size_t i = 0; i < end - begin; ++i)
+      {
+        const eT* s = scores.colptr(i);
+
+        if (weights.n_rows == 1)
+        {
+          // The (1.0 - decisionBoundary) term sets an offset so that floor()
+          // returns 0 or 1 correctly.
+          predictions[begin + i] = std::floor(1.0 / (1.0 + std::exp(-s[0])) +
+              (1.0 - decisionBoundary));
+          continue;
+        }
+
+        // The softmax is monotonic, so the class with the highest probability
+        // is the class with the highest score.
+        size_t maxClass = 0;
+        for (size_t j = 1; j < weights.n_rows; ++j)
+          if (s[j] > s[maxClass])
+            maxClass = j;
+
+        predictions[begin + i] = maxClass;
+      }
+    }
+  }
+}
+
+template<typename eT>
+void LinearPredictor<eT>::Scores(const arma::Mat<eT>& data,
+                                 const size_t begin,
+                                 const size_t end,
+                                 arma::Mat<eT>& /* block */,
+                                 arma::Mat<eT>& scores) const
+{
+  // Use the columns of the block in place.
+  const arma::Mat<eT> points(const_cast<eT*>(data.colptr(begin)), data.n_rows,
+      end - begin, false, true);
+
+  scores = weights * points;
+  if (!bias.is_empty())
+    scores.each_col() += bias;
+}
+
+template<typename eT>
+template<typename InputType>
+void LinearPredictor<eT>::Scores(const arma::Mat<InputType>& data,
+                                 const size_t begin,
+                                 const size_t end,
+                                 arma::Mat<eT>& block,
+                                 arma::Mat<eT>& scores) const
+{
+  block = arma::conv_to<arma::Mat<eT> >::from(data.cols(begin, end - 1));
+
+  scores = weights * block;
+  if (!bias.is_empty())
+    scores.each_col() += bias;
+}
+
+template<typename eT>
+void LinearPredictor<eT>::Scores(const arma::sp_mat& data,
+                                 const size_t begin,
+                                 const size_t end,
+                                 arma::Mat<eT>& /* block */,
+                                 arma::Mat<eT>& scores) const
+{
+  if (bias.is_empty())
+    scores.zeros(weights.n_rows, end - begin);
+  else
+    scores = arma::repmat(bias, 1, end - begin);
+
+  // Each non-zero entry adds a scaled column of the weights.
+  for (size_t i = begin; i < end; ++i)
+    for (arma::sp_mat::const_iterator it = data.begin_col(i);
+         it != data.end_col(i); ++it)
+      scores.col(i - begin) += ((eT) *it) * weights.col(it.row());
+}
+
+}; // namespace regression
+}; // namespace mlpack
+
+#endif
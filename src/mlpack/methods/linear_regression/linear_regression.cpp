@@ -78,9 +78,67 @@ LinearRegression::LinearRegression(const arma::mat& predictors,
   }
 }
 
+LinearRegression::LinearRegression(data::ChunkReader& reader,
+                                   const double lambda,
+                                   const bool intercept,
+                                   const size_t chunkSize,
+                                   const bool weighted) :
+    lambda(lambda),
+    intercept(intercept)
+{
+  // Accumulate X W X^T and X W y over the chunks.
+  const size_t extraRows = (weighted ? 2 : 1);
+  NormalEquations equations(intercept);
+  arma::mat chunk;
+  while (reader.Read(chunk, chunkSize))
+  {
+    if (chunk.n_rows < extraRows + 1)
+      Log::Fatal << "LinearRegression::LinearRegression(): the dataset must "
+          << "have at least one predictor and the responses"
+          << (weighted ? " and weights." : ".") << std::endl;
+
+    const size_t d = chunk.n_rows - extraRows;
+    if (weighted)
+      equations.Add(chunk.rows(0, d - 1), arma::trans(chunk.row(d)),
+          arma::trans(chunk.row(d + 1)));
+    else
+      equations.Add(chunk.rows(0, d - 1), arma::trans(chunk.row(d)));
+  }
+
+  if (reader.Failed() || equations.Points() == 0)
+    Log::Fatal << "LinearRegression::LinearRegression(): could not read the "
+        << "dataset." << std::endl;
+
+  Log::Info << "Accumulated the normal equations over " << equations.Points()
+      << " points." << std::endl;
+
+  equations.Solve(lambda, parameters);
+}
+
+LinearRegression::LinearRegression(const NormalEquations& equations,
+                                   const double lambda) :
+    lambda(lambda),
+    intercept(equations.Intercept())
+{
+  equations.Solve(lambda, parameters);
+}
+
 LinearRegression::LinearRegression(const std::string& filename) :
-    lambda(0.0)
+    lambda(0.0),
+    intercept(true)
 {
+  const bool xml = (filename.size() >= 4 &&
+      filename.substr(filename.size() - 4) == ".xml");
+  if (xml || util::SaveRestoreUtility::IsBinaryFile(filename))
+  {
+    util::SaveRestoreUtility sr;
+    if (!sr.ReadFile(filename))
+      Log::Fatal << "LinearRegression::LinearRegression(): could not read "
+          << "file '" << filename << "'!" << std::endl;
+    Load(sr);
+    return;
+  }
+
   arma::mat parameter;
   data::Load(filename, parameter, true);
   parameters = parameter.unsafe_col(0);
@@ -88,9 +146,42 @@ LinearRegression::LinearRegression(const std::string& filename) :
 
 LinearRegression::LinearRegression(const LinearRegression& linearRegression) :
     parameters(linearRegression.parameters),
-    lambda(linearRegression.lambda)
+    lambda(linearRegression.lambda),
+    intercept(linearRegression.intercept)
 { /* Nothing to do. */ }
 
+void LinearRegression::Save(const std::string& filename) const
+{
+  const std::string extension = (filename.size() >= 4) ?
+      filename.substr(filename.size() - 4) : "";
+  if (extension == ".xml" || extension == ".bin")
+  {
+    util::SaveRestoreUtility sr;
+    Save(sr);
+    if (!sr.WriteFile(filename))
+      Log::Fatal << "LinearRegression::Save(): error saving to '" << filename
+          << "'." << std::endl;
+  }
+  else
+  {
+    data::Save(filename, parameters, true);
+  }
+}
+
+void LinearRegression::Save(util::SaveRestoreUtility& sr) const
+{
+  sr.SaveParameter(parameters, "parameters");
+  sr.SaveParameter(lambda, "lambda");
+  sr.SaveParameter(intercept, "intercept");
+}
+
+void LinearRegression::Load(const util::SaveRestoreUtility& sr)
+{
+  sr.LoadParameter(parameters, "parameters");
+  sr.LoadParameter(lambda, "lambda");
+  sr.LoadParameter(intercept, "intercept");
+}
+
 void LinearRegression::Predict(const arma::mat& points, arma::vec& predictions)
     const
 {
@@ -10,6 +10,8 @@
 
 #include <mlpack/core.hpp>
 
+#include "normal_equations.hpp"
+
 namespace mlpack {
 namespace regression /** Regression methods. */ {
 
@@ -38,7 +40,41 @@ class LinearRegression
                    );
 
   /**
-   * Initialize the model from a file.
+   * Creates the model from a dataset that is read a chunk at a time, so that
+   * the dataset never has to be held in memory.  The responses are taken to be
+   * the last row of each chunk (that is, the last column of the file), or, if
+   * the points are weighted, the second-to-last row, with the observation
+   * weights in the last row.  Instead of taking the QR decomposition of the
+   * predictors, the normal equations (X W X^T + lambda I) B = X W y are
+   * accumulated over the chunks with NormalEquations and then solved, which is
+   * less accurate when X is badly conditioned.
+   *
+   * @param reader Reader for the file holding the predictors and responses.
+   * @param lambda regularization constant
+   * @param intercept include intercept?
+   * @param chunkSize Number of points to read at a time.
+   * @param weighted Whether the last column of the file holds observation
+   *     weights.
+   */
+  LinearRegression(data::ChunkReader& reader,
+                   const double lambda = 0,
+                   const bool intercept = true,
+                   const size_t chunkSize = 100000,
+                   const bool weighted = false);
+
+  /**
+   * Creates the model by solving normal equations that have already been
+   * accumulated, with the given regularization constant.  The same normal
+   * equations can be solved for several values of lambda.
+   *
+   * @param equations Accumulated normal equations.
+   * @param lambda regularization constant
+   */
+  LinearRegression(const NormalEquations& equations, const double lambda = 0);
+
+  /**
+   * Initialize the model from a file.  This may be a model saved with Save()
+   * to an XML or binary model file, or a file holding just the parameters.
    *
    * @param filename the name of the file to load the model from.
    */
@@ -84,6 +120,21 @@ class LinearRegression
   double ComputeError(const arma::mat& points,
                       const arma::vec& responses) const;
 
+  /**
+   * Save the model to a file.  If the filename ends in ".xml" or ".bin", the
+   * whole model is saved with a SaveRestoreUtility (as XML or in the binary
+   * format); otherwise, just the parameters are saved with data::Save().
+   *
+   * @param filename the name of the file to save the model to.
+   */
+  void Save(const std::string& filename) const;
+
+  //! Save the model to a SaveRestoreUtility.
+  void Save(util::SaveRestoreUtility& sr) const;
+
+  //! Load the model from a SaveRestoreUtility.
+  void Load(const util::SaveRestoreUtility& sr);
+
   //! Return the parameters (the b vector).
   const arma::vec& Parameters() const { return parameters; }
   //! Modify the parameters (the b vector).
@@ -94,6 +145,9 @@ class LinearRegression
   //! Modify the Tikhonov regularization parameter for ridge regression.
   double& Lambda() { return lambda; }
 
+  //! Return whether or not the first parameter is the intercept.
+  bool Intercept() const { return intercept; }
+
   // Returns a string representation of this object. 
   std::string ToString() const;
 
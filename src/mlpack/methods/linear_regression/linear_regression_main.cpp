@@ -33,7 +33,8 @@ PARAM_STRING("input_responses", "Optional file containing y (responses). If "
 PARAM_STRING("model_file", "File containing existing model (parameters).", "m",
     "");
 
-PARAM_STRING("output_file", "File where parameters (b) will be saved.",
+PARAM_STRING("output_file", "File where parameters (b) will be saved (or the "
+    "whole model, if the file ends in .xml or .bin).",
     "o", "parameters.csv");
 
 PARAM_STRING("test_file", "File containing X' (test regressors).", "t", "");
@@ -134,8 +135,8 @@ int main(int argc, char* argv[])
     lr = LinearRegression(regressors, responses.unsafe_col(0));
     Timer::Stop("regression");
 
-    // Save the parameters.
-    data::Save(outputFile, lr.Parameters(), true);
+    // Save the parameters (or the whole model, for .xml and .bin files).
+    lr.Save(outputFile);
   }
 
   // Did we want to predict, too?
@@ -0,0 +1,165 @@
+/**
+ * @file normal_equations.cpp
+ *
+ * Implementation of the NormalEquations class.
+ */
+#include "normal_equations.hpp"
+
+#include <mlpack/core/optimizers/parallel_sum/parallel_sum.hpp>
+
+using namespace mlpack;
+using namespace mlpack::regression;
+
+namespace {
+
+/**
+ * Sums the terms of blocks of points of the normal equations, for
+ * optimization::ParallelSum().  The sum holds X W X^T in its first columns and
+ * X W y in its last column.
+ */
+class NormalEquationsBlock
+{
+ public:
+  NormalEquationsBlock(const arma::vec& responses,
+                       const arma::vec& weights,
+                       const bool intercept,
+                       const bool stacked) :
+      responses(responses),
+      weights(weights),
+      intercept(intercept),
+      stacked(stacked)
+  { }
+
+  double Block(const arma::mat& predictors,
+               const size_t begin,
+               const size_t end,
+               arma::mat& sum) const
+  {
+    // Copy the block, with the row of ones for the intercept, and scale each
+    // point and response by the square root of its weight.  If the responses
+    // are stacked, they are the first row of the matrix.
+    const size_t offset = intercept ? 1 : 0;
+    const size_t firstRow = stacked ? 1 : 0;
+    arma::mat points(predictors.n_rows - firstRow + offset, end - begin);
+    if (intercept)
+      points.row(0).ones();
+    if (points.n_rows > offset)
+      points.rows(offset, points.n_rows - 1) = predictors.submat(firstRow,
+          begin, predictors.n_rows - 1, end - 1);
+
+    arma::vec r = stacked ?
+        arma::vec(arma::trans(predictors.submat(0, begin, 0, end - 1))) :
+        arma::vec(responses.subvec(begin, end - 1));
+    if (!weights.is_empty())
+    {
+      for (size_t i = begin; i < end; ++i)
+      {
+        const double root = std::sqrt(weights[i]);
+        points.col(i - begin) *= root;
+        r[i - begin] *= root;
+      }
+    }
+
+    sum.cols(0, points.n_rows - 1) += points * arma::trans(points);
+    sum.col(points.n_rows) += points * r;
+
+    return arma::dot(r, r);
+  }
+
+ private:
+  const arma::vec& responses;
+  const arma::vec& weights;
+  const bool intercept;
+  const bool stacked;
+};
+
+} // anonymous namespace
+
+NormalEquations::NormalEquations(const bool intercept) :
+    intercept(intercept),
+    points(0),
+    ywy(0.0)
+{ /* Nothing to do. */ }
+
+void NormalEquations::Add(const arma::mat& predictors,
+                          const arma::vec& responses,
+                          const arma::vec& weights)
+{
+  if (responses.n_elem != predictors.n_cols)
+    Log::Fatal << "NormalEquations::Add(): there must be one response for each "
+        << "point!" << std::endl;
+
+  Accumulate(predictors, predictors.n_rows, responses, weights, false);
+}
+
+void NormalEquations::AddStacked(const arma::mat& observations,
+                                 const arma::vec& weights)
+{
+  if (observations.n_rows == 0)
+    Log::Fatal << "NormalEquations::AddStacked(): the observations must have "
+        << "a row of responses!" << std::endl;
+
+  Accumulate(observations, observations.n_rows - 1, arma::vec(), weights,
+      true);
+}
+
+void NormalEquations::Accumulate(const arma::mat& matrix,
+                                 const size_t predictorRows,
+                                 const arma::vec& responses,
+                                 const arma::vec& weights,
+                                 const bool stacked)
+{
+  if (!weights.is_empty() && (weights.n_elem != matrix.n_cols))
+    Log::Fatal << "NormalEquations::Add(): there must be one weight for each "
+        << "point!" << std::endl;
+
+  const size_t dimensionality = predictorRows + (intercept ? 1 : 0);
+  if (points == 0)
+  {
+    xwxt.zeros(dimensionality, dimensionality);
+    xwy.zeros(dimensionality);
+  }
+  else if (xwxt.n_rows != dimensionality)
+  {
+    Log::Fatal << "NormalEquations::Add(): the points have dimensionality "
+        << predictorRows << ", but earlier points had dimensionality "
+        << (xwxt.n_rows - (intercept ? 1 : 0)) << "!" << std::endl;
+  }
+
+  if (matrix.n_cols == 0)
+    return;
+
+  NormalEquationsBlock block(responses, weights, intercept, stacked);
+  arma::mat sum(dimensionality, dimensionality + 1);
+  ywy += optimization::ParallelSum(block, &NormalEquationsBlock::Block,
+      matrix, matrix.n_cols, sum, 1024);
+
+  xwxt += sum.cols(0, dimensionality - 1);
+  xwy += sum.col(dimensionality);
+  points += matrix.n_cols;
+}
+
+void NormalEquations::Solve(const double lambda, arma::vec& parameters) const
+{
+  if (points == 0)
+    Log::Fatal << "NormalEquations::Solve(): no points have been added!"
+        << std::endl;
+
+  // The intercept is not penalized.
+  arma::mat a = xwxt;
+  for (size_t i = (intercept ? 1 : 0); i < a.n_rows; ++i)
+    a(i, i) += lambda;
+
+  // X W X^T + lambda I = R^T R; solve R^T z = X W y, then R B = z.
+  arma::mat r;
+  if (!arma::chol(r, a))
+  {
+    Log::Warn << "NormalEquations::Solve(): X W X^T + lambda I is not positive "
+        << "definite; solving with a general solver instead." << std::endl;
+    arma::solve(parameters, a, xwy);
+    return;
+  }
+
+  const arma::vec z = arma::solve(arma::trimatl(arma::trans(r)), xwy);
+  parameters = arma::solve(arma::trimatu(r), z);
+}
@@ -0,0 +1,128 @@
+/**
+ * @file normal_equations.hpp
+ *
+ * Accumulation of the normal equations of (weighted, ridge) least-squares
+ * linear regression over chunks of points.
+ */
+#ifndef __MLPACK_METHODS_LINEAR_REGRESSION_NORMAL_EQUATIONS_HPP
+#define __MLPACK_METHODS_LINEAR_REGRESSION_NORMAL_EQUATIONS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace regression {
+
+/**
+ * The NormalEquations class accumulates the normal equations
+ *
+ * \f[
+ * (X W X^T + \lambda I) B = X W y
+ * \f]
+ *
+ * of weighted least-squares linear regression, where the columns of X are the
+ * points (with a row of ones for the intercept, if it is used) and W holds the
+ * observation weights.  The points can be given a chunk at a time, so only
+ * X W X^T and X W y (of size (d + 1) x (d + 1) and d + 1) are ever held in
+ * memory; the points of each chunk are summed in parallel, over blocks of
+ * points, with one accumulator per thread, and only one block of points per
+ * thread is copied at a time.
+ * The regularization is only applied when the equations are solved, so one
+ * pass over the data can be solved for several values of lambda.
+ *
+ * @code
+ * NormalEquations equations;
+ * data::ChunkReader reader("dataset.csv", true);
+ * arma::mat chunk;
+ * while (reader.Read(chunk, 100000))
+ *   equations.Add(chunk.rows(0, chunk.n_rows - 2),
+ *                 arma::trans(chunk.row(chunk.n_rows - 1)));
+ *
+ * LinearRegression lr(equations, 0.5);
+ * @endcode
+ *
+ * Solving the normal equations is less accurate than the QR decomposition that
+ * the other LinearRegression constructors use when X is badly conditioned.
+ */
+class NormalEquations
+{
+ public:
+  /**
+   * Create empty normal equations.
+   *
+   * @param intercept Whether or not the model has an intercept.
+   */
+  NormalEquations(const bool intercept = true);
+
+  /**
+   * Add the given points to the normal equations.  The dimensionality of the
+   * points must be the same for each call.
+   *
+   * @param predictors Points to add (one column for each point).
+   * @param responses Response of each point.
+   * @param weights Observation weight of each point (if empty, each point has
+   *     weight 1).
+   */
+  void Add(const arma::mat& predictors,
+           const arma::vec& responses,
+           const arma::vec& weights = arma::vec());
+
+  /**
+   * Add the given points to the normal equations, where the first row of
+   * observations holds the responses and the other rows hold the predictors
+   * (as in the observations of distribution::RegressionDistribution).  The
+   * observations are used in place; only one block per thread is copied.
+   *
+   * @param observations Responses and points to add (one column for each
+   *     point).
+   * @param weights Observation weight of each point (if empty, each point has
+   *     weight 1).
+   */
+  void AddStacked(const arma::mat& observations,
+                  const arma::vec& weights = arma::vec());
+
+  /**
+   * Solve the normal equations with the Cholesky decomposition of
+   * X W X^T + lambda I.  The intercept is not penalized.
+   *
+   * @param lambda Regularization constant for ridge regression.
+   * @param parameters Vector to store the solution B in.
+   */
+  void Solve(const double lambda, arma::vec& parameters) const;
+
+  //! Get whether or not the model has an intercept.
+  bool Intercept() const { return intercept; }
+  //! Get the number of points added so far.
+  size_t Points() const { return points; }
+  //! Get X W X^T.
+  const arma::mat& XWXt() const { return xwxt; }
+  //! Get X W y.
+  const arma::vec& XWy() const { return xwy; }
+  //! Get y^T W y (with X W X^T and X W y, this gives the training error of
+  //! any model).
+  double YWy() const { return ywy; }
+
+ private:
+  //! Whether or not the model has an intercept.
+  bool intercept;
+  //! The number of points added so far.
+  size_t points;
+  //! X W X^T.
+  arma::mat xwxt;
+  //! X W y.
+  arma::vec xwy;
+  //! y^T W y.
+  double ywy;
+
+  //! Add the points of the given matrix, which has the given number of rows of
+  //! predictors (after the row of responses, if they are stacked).
+  void Accumulate(const arma::mat& matrix,
+                  const size_t predictorRows,
+                  const arma::vec& responses,
+                  const arma::vec& weights,
+                  const bool stacked);
+};
+
+}; // namespace regression
+}; // namespace mlpack
+
+#endif
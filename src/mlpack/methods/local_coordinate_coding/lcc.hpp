@@ -99,36 +99,38 @@ class LocalCoordinateCoding
               const double objTolerance = 0.01);
 
   /**
-   * Code each point via distance-weighted LARS.
+   * Code each point via distance-weighted LARS.  The squared distances from
+   * the points to the atoms are computed for blocks of points, with one matrix
+   * multiplication for each block.
    */
   void OptimizeCode();
 
   /**
-   * Learn dictionary by solving linear system.
-   *
-   * @param adjacencies Indices of entries (unrolled column by column) of
-   *    the coding matrix Z that are non-zero (the adjacency matrix for the
-   *    bipartite graph of points and atoms)
+   * Learn dictionary by solving linear system.  The system is built from the
+   * non-zero entries of the sparse codes only.
    */
-  void OptimizeDictionary(arma::uvec adjacencies);
+  void OptimizeDictionary();
 
   /**
-   * Compute objective function given the list of adjacencies.
+   * Compute objective function.  The distances are only needed for the
+   * non-zero codes, and are computed from the cached norms of the points and
+   * atoms.
    */
-  double Objective(arma::uvec adjacencies) const;
+  double Objective() const;
 
   //! Access the data.
   const arma::mat& Data() const { return data; }
 
   //! Accessor for dictionary.
   const arma::mat& Dictionary() const { return dictionary; }
-  //! Mutator for dictionary.
-  arma::mat& Dictionary() { return dictionary; }
+  //! Mutator for dictionary.  The cached norms of the atoms are recomputed
+  //! when they are next needed.
+  arma::mat& Dictionary() { atomSqNormsValid = false; return dictionary; }
 
   //! Accessor the codes.
-  const arma::mat& Codes() const { return codes; }
+  const arma::sp_mat& Codes() const { return codes; }
   //! Modify the codes.
-  arma::mat& Codes() { return codes; }
+  arma::sp_mat& Codes() { return codes; }
 
   // Returns a string representation of this object. 
   std::string ToString() const;
@@ -143,11 +145,37 @@ class LocalCoordinateCoding
   //! Dictionary (columns are atoms).
   arma::mat dictionary;
 
-  //! Codes (columns are points).
-  arma::mat codes;
+  //! Codes (columns are points), stored by column.
+  arma::sp_mat codes;
 
   //! l1 regularization term.
   double lambda;
+
+  //! Squared norms of the points (the data does not change).
+  arma::rowvec dataSqNorms;
+  //! Squared norms of the atoms, kept while the dictionary does not change.
+  mutable arma::vec atomSqNorms;
+  //! Whether atomSqNorms holds the norms of the current dictionary.
+  mutable bool atomSqNormsValid;
+
+  //! Get the squared norms of the atoms, computing them if the dictionary has
+  //! changed since they were last computed.
+  const arma::vec& AtomSqNorms() const;
+
+  /**
+   * Compute the squared distances between every atom and the points in the
+   * given block, as ||d||^2 + ||x||^2 - 2 D^T X with one matrix
+   * multiplication.
+   *
+   * @param atomNorms Squared norms of the atoms (see AtomSqNorms()).
+   * @param begin Index of the first point of the block.
+   * @param end Index after the last point of the block.
+   * @param sqDists Matrix to store the distances in (atoms x block size).
+   */
+  void SquaredDistances(const arma::vec& atomNorms,
+                        const size_t begin,
+                        const size_t end,
+                        arma::mat& sqDists) const;
 };
 
 }; // namespace lcc
@@ -21,7 +21,9 @@ LocalCoordinateCoding<DictionaryInitializer>::LocalCoordinateCoding(
     atoms(atoms),
     data(data),
     codes(atoms, data.n_cols),
-    lambda(lambda)
+    lambda(lambda),
+    dataSqNorms(arma::sum(arma::square(data))),
+    atomSqNormsValid(false)
 {
   // Initialize the dictionary.
   DictionaryInitializer::Initialize(data, atoms, dictionary);
@@ -41,12 +43,10 @@ void LocalCoordinateCoding<DictionaryInitializer>::Encode(
   Log::Info << "Initial Coding Step." << std::endl;
 
   OptimizeCode();
-  arma::uvec adjacencies = find(codes);
 
-  Log::Info << "  Sparsity level: " << 100.0 * ((double)(adjacencies.n_elem)) /
+  Log::Info << "  Sparsity level: " << 100.0 * ((double)(codes.n_nonzero)) /
       ((double)(atoms * data.n_cols)) << "%.\n";
-  Log::Info << "  Objective value: " << Objective(adjacencies) << "."
-      << std::endl;
+  Log::Info << "  Objective value: " << Objective() << "." << std::endl;
 
   for (size_t t = 1; t != maxIterations; t++)
   {
@@ -55,20 +55,18 @@ void LocalCoordinateCoding<DictionaryInitializer>::Encode(
 
     // First step: optimize the dictionary.
     Log::Info << "Performing dictionary step..." << std::endl;
-    OptimizeDictionary(adjacencies);
-    double dsObjVal = Objective(adjacencies);
-    Log::Info << "  Objective value: " << Objective(adjacencies) << "."
-        << std::endl;
+    OptimizeDictionary();
+    double dsObjVal = Objective();
+    Log::Info << "  Objective value: " << dsObjVal << "." << std::endl;
 
     // Second step: perform the coding.
     Log::Info << "Performing coding step..." << std::endl;
     OptimizeCode();
-    adjacencies = find(codes);
-    Log::Info << "  Sparsity level: " << 100.0 * ((double) (adjacencies.n_elem))
+    Log::Info << "  Sparsity level: " << 100.0 * ((double) (codes.n_nonzero))
         / ((double)(atoms * data.n_cols)) << "%.\n";
 
     // Terminate if the objective increased in the coding step.
-    double curObjVal = Objective(adjacencies);
+    double curObjVal = Objective();
     if (curObjVal > dsObjVal)
     {
       Log::Warn << "Objective increased in coding step!  Terminating."
@@ -97,176 +95,130 @@ void LocalCoordinateCoding<DictionaryInitializer>::Encode(
 template<typename DictionaryInitializer>
 void LocalCoordinateCoding<DictionaryInitializer>::OptimizeCode()
 {
-  arma::mat invSqDists = 1.0 / (repmat(trans(sum(square(dictionary))), 1,
-      data.n_cols) + repmat(sum(square(data)), atoms, 1) - 2 * trans(dictionary)
-      * data);
-
-  arma::mat dictGram = trans(dictionary) * dictionary;
-  arma::mat dictGramTD(dictGram.n_rows, dictGram.n_cols);
-
-  for (size_t i = 0; i < data.n_cols; i++)
+  // The norms are computed here, before the threads need them.
+  const arma::vec& atomNorms = AtomSqNorms();
+  const arma::mat dictGram = trans(dictionary) * dictionary;
+
+  // The points are coded independently, so blocks of points are coded in
+  // parallel.  Each thread has its own weighted dictionary and Gram matrix,
+  // allocated once and overwritten for each point, and its own LARS object,
+  // which references the thread's Gram matrix.  The nonzero codes of each
+  // point are collected, and the sparse codes are assembled from them.
+  const size_t blockSize = 256;
+  const size_t numBlocks = (data.n_cols + blockSize - 1) / blockSize;
+  std::vector<std::vector<std::pair<size_t, double> > > nonzeros(data.n_cols);
+
+  #pragma omp parallel
   {
-    // report progress
-    if ((i % 100) == 0)
-    {
-      Log::Debug << "Optimization at point " << i << "." << std::endl;
-    }
-
-    arma::vec invW = invSqDists.unsafe_col(i);
-    arma::mat dictPrime = dictionary * diagmat(invW);
-
-    arma::mat dictGramTD = diagmat(invW) * dictGram * diagmat(invW);
+    arma::mat dictPrime(dictionary.n_rows, dictionary.n_cols);
+    arma::mat dictGramTD(dictGram.n_rows, dictGram.n_cols);
+    arma::mat invSqDists;
+    arma::vec beta;
 
     bool useCholesky = false;
     regression::LARS lars(useCholesky, dictGramTD, 0.5 * lambda);
 
-    // Run LARS for this point, by making an alias of the point and passing
-    // that.
-    arma::vec beta = codes.unsafe_col(i);
-    lars.Regress(dictPrime, data.unsafe_col(i), beta, false);
-    beta %= invW; // Remember, beta is an alias of codes.col(i).
-  }
-}
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t block = 0; block < numBlocks; ++block)
+    {
+      const size_t begin = block * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t) data.n_cols);
 
-template<typename DictionaryInitializer>
-void LocalCoordinateCoding<DictionaryInitializer>::OptimizeDictionary(
-    arma::uvec adjacencies)
-{
-  // Count number of atomic neighbors for each point x^i.
-  arma::uvec neighborCounts = arma::zeros<arma::uvec>(data.n_cols, 1);
-  if (adjacencies.n_elem > 0)
-  {
-    // This gets the column index.  Intentional integer division.
-    size_t curPointInd = (size_t) (adjacencies(0) / atoms);
-    ++neighborCounts(curPointInd);
+      SquaredDistances(atomNorms, begin, end, invSqDists);
+      invSqDists = 1.0 / invSqDists;
 
-    size_t nextColIndex = (curPointInd + 1) * atoms;
-    for (size_t l = 1; l < adjacencies.n_elem; l++)
-    {
-      // If l no longer refers to an element in this column, advance the column
-      // number accordingly.
-      if (adjacencies(l) >= nextColIndex)
+      for (size_t i = begin; i < end; ++i)
       {
-        curPointInd = (size_t) (adjacencies(l) / atoms);
-        nextColIndex = (curPointInd + 1) * atoms;
+        // The weights scale the atoms and the Gram matrix in place.
+        const double* invW = invSqDists.colptr(i - begin);
+        for (size_t j = 0; j < dictionary.n_cols; ++j)
+        {
+          dictPrime.col(j) = dictionary.col(j) * invW[j];
+          for (size_t k = 0; k < dictGram.n_rows; ++k)
+            dictGramTD(k, j) = dictGram(k, j) * invW[k] * invW[j];
+        }
+
+        // Run LARS for this point, by making an alias of the point and passing
+        // that.
+        lars.Regress(dictPrime, data.unsafe_col(i), beta, false);
+        for (size_t j = 0; j < beta.n_elem; ++j)
+          if (beta[j] != 0.0)
+            nonzeros[i].push_back(std::make_pair(j, beta[j] * invW[j]));
       }
-
-      ++neighborCounts(curPointInd);
     }
   }
 
-  // Build dataPrime := [X x^1 ... x^1 ... x^n ... x^n]
-  // where each x^i is repeated for the number of neighbors x^i has.
-  arma::mat dataPrime = arma::zeros(data.n_rows,
-      data.n_cols + adjacencies.n_elem);
-
-  dataPrime(arma::span::all, arma::span(0, data.n_cols - 1)) = data;
+  math::SparseFromColumns(nonzeros, atoms, codes);
+}
 
-  size_t curCol = data.n_cols;
-  for (size_t i = 0; i < data.n_cols; i++)
+template<typename DictionaryInitializer>
+void LocalCoordinateCoding<DictionaryInitializer>::OptimizeDictionary()
+{
+  // The dictionary minimizes the objective for fixed codes Z:
+  //
+  //   ||X - D Z||_F^2 + lambda sum_{i, j} |z_ij| ||x_j - d_i||^2,
+  //
+  // so it solves D A = B with A = Z Z^T + diag(lambda sum_j |z_ij|) and
+  // B = sum_{i, j} (z_ij + lambda |z_ij|) x_j e_i^T.  Both only need the
+  // nonzero codes, which are visited point by point.
+  arma::mat A = arma::zeros(atoms, atoms);
+  arma::mat B = arma::zeros(data.n_rows, atoms);
+  arma::uvec atomCounts = arma::zeros<arma::uvec>(atoms);
+  for (size_t j = 0; j < data.n_cols; ++j)
   {
-    if (neighborCounts(i) > 0)
+    for (size_t l = codes.col_ptrs[j]; l < codes.col_ptrs[j + 1]; ++l)
     {
-      dataPrime(arma::span::all, arma::span(curCol, curCol + neighborCounts(i)
-          - 1)) = repmat(data.col(i), 1, neighborCounts(i));
+      const size_t atomInd = codes.row_indices[l];
+      const double code = codes.values[l];
+      const double weight = lambda * std::abs(code);
+
+      A(atomInd, atomInd) += weight;
+      for (size_t m = codes.col_ptrs[j]; m < codes.col_ptrs[j + 1]; ++m)
+        A(atomInd, codes.row_indices[m]) += code * codes.values[m];
+
+      B.col(atomInd) += (code + weight) * data.col(j);
+      ++atomCounts[atomInd];
     }
-    curCol += neighborCounts(i);
   }
 
   // Handle the case of inactive atoms (atoms not used in the given coding).
   std::vector<size_t> inactiveAtoms;
   for (size_t j = 0; j < atoms; ++j)
-    if (accu(codes.row(j) != 0) == 0)
+    if (atomCounts[j] == 0)
       inactiveAtoms.push_back(j);
 
   const size_t nInactiveAtoms = inactiveAtoms.size();
-  const size_t nActiveAtoms = atoms - nInactiveAtoms;
-
-  // Efficient construction of codes restricted to active atoms.
-  arma::mat codesPrime = arma::zeros(nActiveAtoms, data.n_cols +
-      adjacencies.n_elem);
-  arma::vec wSquared = arma::ones(data.n_cols + adjacencies.n_elem, 1);
-
-  if (nInactiveAtoms > 0)
-  {
-    Log::Warn << "There are " << nInactiveAtoms
-        << " inactive atoms.  They will be re-initialized randomly.\n";
-
-    // Create matrix holding only active codes.
-    arma::mat activeCodes;
-    math::RemoveRows(codes, inactiveAtoms, activeCodes);
-
-    // Create reverse atom lookup for active atoms.
-    arma::uvec atomReverseLookup(atoms);
-    size_t inactiveOffset = 0;
-    for (size_t i = 0; i < atoms; ++i)
-    {
-      if (inactiveAtoms[inactiveOffset] == i)
-        ++inactiveOffset;
-      else
-        atomReverseLookup(i - inactiveOffset) = i;
-    }
-
-    codesPrime(arma::span::all, arma::span(0, data.n_cols - 1)) = activeCodes;
-
-    // Fill the rest of codesPrime.
-    for (size_t l = 0; l < adjacencies.n_elem; ++l)
-    {
-      // Recover the location in the codes matrix that this adjacency refers to.
-      size_t atomInd = adjacencies(l) % atoms;
-      size_t pointInd = (size_t) (adjacencies(l) / atoms);
-
-      // Fill matrix.
-      codesPrime(atomReverseLookup(atomInd), data.n_cols + l) = 1.0;
-      wSquared(data.n_cols + l) = codes(atomInd, pointInd);
-    }
-  }
-  else
-  {
-    // All atoms are active.
-    codesPrime(arma::span::all, arma::span(0, data.n_cols - 1)) = codes;
-
-    for (size_t l = 0; l < adjacencies.n_elem; ++l)
-    {
-      // Recover the location in the codes matrix that this adjacency refers to.
-      size_t atomInd = adjacencies(l) % atoms;
-      size_t pointInd = (size_t) (adjacencies(l) / atoms);
-
-      // Fill matrix.
-      codesPrime(atomInd, data.n_cols + l) = 1.0;
-      wSquared(data.n_cols + l) = codes(atomInd, pointInd);
-    }
-  }
-
-  wSquared.subvec(data.n_cols, wSquared.n_elem - 1) = lambda *
-      abs(wSquared.subvec(data.n_cols, wSquared.n_elem - 1));
 
   // Solve system.
   if (nInactiveAtoms == 0)
   {
     // No inactive atoms.  We can solve directly.
-    arma::mat A = codesPrime * diagmat(wSquared) * trans(codesPrime);
-    arma::mat B = codesPrime * diagmat(wSquared) * trans(dataPrime);
-
-    dictionary = trans(solve(A, B));
-    /*
-    dictionary = trans(solve(codesPrime * diagmat(wSquared) * trans(codesPrime),
-        codesPrime * diagmat(wSquared) * trans(dataPrime)));
-    */
+    dictionary = trans(solve(A, trans(B)));
   }
   else
   {
+    Log::Warn << "There are " << nInactiveAtoms
+        << " inactive atoms.  They will be re-initialized randomly.\n";
+
     // Inactive atoms must be reinitialized randomly, so we cannot solve
-    // directly for the entire dictionary estimate.
-    arma::mat dictionaryActive =
-      trans(solve(codesPrime * diagmat(wSquared) * trans(codesPrime),
-                  codesPrime * diagmat(wSquared) * trans(dataPrime)));
+    // directly for the entire dictionary estimate.  Their (zero) rows and
+    // columns are removed from the system.
+    arma::mat activeA;
+    math::RemoveRows(A, inactiveAtoms, activeA);
+    A = trans(activeA);
+    math::RemoveRows(A, inactiveAtoms, activeA);
+
+    arma::mat activeBT;
+    math::RemoveRows(arma::mat(trans(B)), inactiveAtoms, activeBT);
+
+    arma::mat dictionaryActive = trans(solve(activeA, activeBT));
 
     // Update all atoms.
     size_t currentInactiveIndex = 0;
     for (size_t i = 0; i < atoms; ++i)
     {
-      if (inactiveAtoms[currentInactiveIndex] == i)
+      if (currentInactiveIndex < nInactiveAtoms &&
+          inactiveAtoms[currentInactiveIndex] == i)
       {
         // This atom is inactive.  Reinitialize it randomly.
         dictionary.col(i) = (data.col(math::RandInt(data.n_cols)) +
@@ -286,27 +238,66 @@ void LocalCoordinateCoding<DictionaryInitializer>::OptimizeDictionary(
       }
     }
   }
+  // The atoms have changed.
+  atomSqNormsValid = false;
 }
 
 template<typename DictionaryInitializer>
-double LocalCoordinateCoding<DictionaryInitializer>::Objective(
-    arma::uvec adjacencies) const
+double LocalCoordinateCoding<DictionaryInitializer>::Objective() const
 {
+  const arma::vec& atomNorms = AtomSqNorms();
   double weightedL1NormZ = 0;
 
-  for (size_t l = 0; l < adjacencies.n_elem; l++)
+  // Visit the nonzero codes point by point.
+  for (size_t pointInd = 0; pointInd < data.n_cols; ++pointInd)
   {
-    // Map adjacency back to its location in the codes matrix.
-    const size_t atomInd = adjacencies(l) % atoms;
-    const size_t pointInd = (size_t) (adjacencies(l) / atoms);
-
-    weightedL1NormZ += fabs(codes(atomInd, pointInd)) * arma::as_scalar(
-        arma::sum(arma::square(dictionary.col(atomInd) - data.col(pointInd))));
+    for (size_t l = codes.col_ptrs[pointInd]; l < codes.col_ptrs[pointInd + 1];
+        ++l)
+    {
+      const size_t atomInd = codes.row_indices[l];
+      const double sqDist = atomNorms[atomInd] + dataSqNorms[pointInd] - 2.0 *
+          arma::dot(dictionary.unsafe_col(atomInd), data.unsafe_col(pointInd));
+      weightedL1NormZ += fabs(codes.values[l]) * std::max(sqDist, 0.0);
+    }
   }
 
   double froNormResidual = norm(data - dictionary * codes, "fro");
   return std::pow(froNormResidual, 2.0) + lambda * weightedL1NormZ;
 }
+
+template<typename DictionaryInitializer>
+const arma::vec& LocalCoordinateCoding<DictionaryInitializer>::AtomSqNorms()
+    const
+{
+  if (!atomSqNormsValid)
+  {
+    atomSqNorms = trans(arma::sum(arma::square(dictionary)));
+    atomSqNormsValid = true;
+  }
+
+  return atomSqNorms;
+}
+
+template<typename DictionaryInitializer>
+void LocalCoordinateCoding<DictionaryInitializer>::SquaredDistances(
+    const arma::vec& atomNorms,
+    const size_t begin,
+    const size_t end,
+    arma::mat& sqDists) const
+{
+  sqDists = -2.0 * trans(dictionary) * data.cols(begin, end - 1);
+
+  // Rounding can make the distance of a point to an atom at the same place
+  // slightly negative.
+  for (size_t i = 0; i < sqDists.n_cols; ++i)
+  {
+    double* column = sqDists.colptr(i);
+    for (size_t j = 0; j < sqDists.n_rows; ++j)
+      column[j] = std::max(column[j] + atomNorms[j] + dataSqNorms[begin + i],
+          0.0);
+  }
+}
+
 template<typename DictionaryInitializer>
 std::string LocalCoordinateCoding<DictionaryInitializer>::ToString() const
 {
@@ -138,7 +138,7 @@ int main(int argc, char* argv[])
     Log::Info << "Saving dictionary matrix to '" << dictionaryFile << "'.\n";
     data::Save(dictionaryFile, lcc.Dictionary());
     Log::Info << "Saving sparse codes to '" << codesFile << "'.\n";
-    data::Save(codesFile, lcc.Codes());
+    data::Save(codesFile, mat(lcc.Codes()));
   }
   else
   {
@@ -152,6 +152,6 @@ int main(int argc, char* argv[])
     Log::Info << "Saving dictionary matrix to '" << dictionaryFile << "'.\n";
     data::Save(dictionaryFile, lcc.Dictionary());
     Log::Info << "Saving sparse codes to '" << codesFile << "'.\n";
-    data::Save(codesFile, lcc.Codes());
+    data::Save(codesFile, mat(lcc.Codes()));
   }
 }
@@ -10,14 +10,25 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/lbfgs/lbfgs.hpp>
+#include <mlpack/methods/linear_predictor/linear_predictor.hpp>
 
 #include "logistic_regression_function.hpp"
 
 namespace mlpack {
 namespace regression {
 
+/**
+ * An implementation of L2-regularized logistic regression for two-class
+ * problems.
+ *
+ * @tparam OptimizerType Optimizer used to train the model.
+ * @tparam MatType Type of the matrix of predictors (arma::mat or
+ *     arma::sp_mat).  Sparse predictors are only visited at their non-zero
+ *     entries, both when training and when predicting.
+ */
 template<
-  template<typename> class OptimizerType = mlpack::optimization::L_BFGS
+  template<typename> class OptimizerType = mlpack::optimization::L_BFGS,
+  typename MatType = arma::mat
 >
 class LogisticRegression
 {
@@ -32,7 +43,7 @@ class LogisticRegression
    * @param responses Outputs resulting from input training variables.
    * @param lambda L2-regularization parameter.
    */
-  LogisticRegression(const arma::mat& predictors,
+  LogisticRegression(const MatType& predictors,
                      const arma::vec& responses,
                      const double lambda = 0);
 
@@ -47,7 +58,7 @@ class LogisticRegression
    * @param initialPoint Initial model to train with.
    * @param lambda L2-regularization parameter.
    */
-  LogisticRegression(const arma::mat& predictors,
+  LogisticRegression(const MatType& predictors,
                      const arma::vec& responses,
                      const arma::mat& initialPoint,
                      const double lambda = 0);
@@ -63,7 +74,8 @@ class LogisticRegression
    *
    * @param optimizer Instantiated optimizer with instantiated error function.
    */
-  LogisticRegression(OptimizerType<LogisticRegressionFunction>& optimizer);
+  LogisticRegression(
+      OptimizerType<LogisticRegressionFunction<MatType> >& optimizer);
 
   /**
    * Construct a logistic regression model from the given parameters, without
@@ -93,11 +105,15 @@ class LogisticRegression
    * the decision boundary, the response is taken to be 1; otherwise, it is 0.
    * By default the decision boundary is 0.5.
    *
+   * The points are classified in parallel blocks by a LinearPredictor; to
+   * classify many batches of points (or to use single-precision weights),
+   * create a LinearPredictor once (see Predictor()) and use it directly.
+   *
    * @param predictors Input predictors.
    * @param responses Vector to put output predictions of responses into.
    * @param decisionBoundary Decision boundary (default 0.5).
    */
-  void Predict(const arma::mat& predictors,
+  void Predict(const MatType& predictors,
                arma::vec& responses,
                const double decisionBoundary = 0.5) const;
 
@@ -115,7 +131,7 @@ class LogisticRegression
    * @param decisionBoundary Decision boundary (default 0.5).
    * @return Percentage of responses that are predicted correctly.
    */
-  double ComputeAccuracy(const arma::mat& predictors,
+  double ComputeAccuracy(const MatType& predictors,
                          const arma::vec& responses,
                          const double decisionBoundary = 0.5) const;
 
@@ -127,9 +143,16 @@ class LogisticRegression
    * @param predictors Input predictors.
    * @param responses Vector of responses.
    */
-  double ComputeError(const arma::mat& predictors,
+  double ComputeError(const MatType& predictors,
                       const arma::vec& responses) const;
 
+  /**
+   * Create a LinearPredictor for the model, with weights of the given element
+   * type (double or float).
+   */
+  template<typename eT>
+  LinearPredictor<eT> Predictor() const;
+
   // Returns a string representation of this object. 
   std::string ToString() const;
 
@@ -10,23 +10,87 @@
 #define __MLPACK_METHODS_LOGISTIC_REGRESSION_LOGISTIC_REGRESSION_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/parallel_sum/parallel_sum.hpp>
 
 namespace mlpack {
 namespace regression {
 
+/**
+ * Compute the linear terms w_0 + x_i' w of the logistic regression model with
+ * the given parameters (w_0 is the intercept, parameters(0)) for points begin
+ * through (end - 1) of the given dense predictors.
+ *
+ * @param predictors Matrix of points.
+ * @param parameters Vector of logistic regression parameters.
+ * @param begin Index of the first point.
+ * @param end One past the index of the last point.
+ * @param terms Vector to store the terms in.
+ */
+void LinearTerms(const arma::mat& predictors,
+                 const arma::mat& parameters,
+                 const size_t begin,
+                 const size_t end,
+                 arma::vec& terms);
+
+/**
+ * Compute the linear terms w_0 + x_i' w of the logistic regression model for
+ * points begin through (end - 1) of the given sparse predictors.  Only the
+ * non-zero entries of the points are visited.
+ */
+void LinearTerms(const arma::sp_mat& predictors,
+                 const arma::mat& parameters,
+                 const size_t begin,
+                 const size_t end,
+                 arma::vec& terms);
+
+/**
+ * Add sum_i weights[i - begin] * [1; x_i] to the given gradient, for points
+ * begin through (end - 1) of the given dense predictors.
+ *
+ * @param predictors Matrix of points.
+ * @param begin Index of the first point.
+ * @param end One past the index of the last point.
+ * @param weights Weight of each point.
+ * @param gradient Gradient to add the weighted points to.
+ */
+void AddWeightedPoints(const arma::mat& predictors,
+                       const size_t begin,
+                       const size_t end,
+                       const arma::vec& weights,
+                       arma::mat& gradient);
+
+/**
+ * Add sum_i weights[i - begin] * [1; x_i] to the given gradient, for points
+ * begin through (end - 1) of the given sparse predictors.  Only the entries of
+ * the gradient where the points are non-zero are touched.
+ */
+void AddWeightedPoints(const arma::sp_mat& predictors,
+                       const size_t begin,
+                       const size_t end,
+                       const arma::vec& weights,
+                       arma::mat& gradient);
+
 /**
  * The log-likelihood function for the logistic regression objective function.
  * This is used by various mlpack optimizers to train a logistic regression
  * model.
+ *
+ * The predictors may be dense or sparse; for sparse predictors (such as
+ * high-dimensional bag-of-words or one-hot features), the objective and the
+ * gradient only visit the non-zero entries of each point.  The parameters and
+ * the gradient are always dense.
+ *
+ * @tparam MatType Type of the matrix of predictors (arma::mat or arma::sp_mat).
  */
+template<typename MatType = arma::mat>
 class LogisticRegressionFunction
 {
  public:
-  LogisticRegressionFunction(const arma::mat& predictors,
+  LogisticRegressionFunction(const MatType& predictors,
                              const arma::vec& responses,
                              const double lambda = 0);
 
-  LogisticRegressionFunction(const arma::mat& predictors,
+  LogisticRegressionFunction(const MatType& predictors,
                              const arma::vec& responses,
                              const arma::mat& initialPoint,
                              const double lambda = 0);
@@ -42,7 +106,7 @@ class LogisticRegressionFunction
   double& Lambda() { return lambda; }
 
   //! Return the matrix of predictors.
-  const arma::mat& Predictors() const { return predictors; }
+  const MatType& Predictors() const { return predictors; }
   //! Return the vector of responses.
   const arma::vec& Responses() const { return responses; }
 
@@ -55,6 +119,9 @@ class LogisticRegressionFunction
    * The optimum (minimum) of this function is 0.0, and occurs when each point
    * is classified correctly with very high probability.
    *
+   * The terms of the points are summed in parallel (see
+   * optimization::ParallelSum()).
+   *
    * @param parameters Vector of logistic regression parameters.
    */
   double Evaluate(const arma::mat& parameters) const;
@@ -77,13 +144,26 @@ class LogisticRegressionFunction
 
   /**
    * Evaluate the gradient of the logistic regression log-likelihood function
-   * with the given parameters.
+   * with the given parameters.  The terms of the points are summed in
+   * parallel.
    *
    * @param parameters Vector of logistic regression parameters.
    * @param gradient Vector to output gradient into.
    */
   void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
 
+  /**
+   * Evaluate the logistic regression log-likelihood function and its gradient
+   * with the given parameters, in one pass over the data.  This is used by
+   * L_BFGS, which needs both at each point it visits.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param gradient Vector to output gradient into.
+   * @return Objective function value.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
   /**
    * Evaluate the gradient of the logistic regression log-likelihood function
    * with the given parameters, and with respect to only one point in the
@@ -98,6 +178,23 @@ class LogisticRegressionFunction
                 const size_t i,
                 arma::mat& gradient) const;
 
+  /**
+   * Evaluate the sum of the gradients of the logistic regression log-likelihood
+   * function with respect to the points begin through (begin + batchSize - 1),
+   * with the given parameters.  This is the same as summing the individual
+   * gradients, but it is done in one pass over the points of the batch; it is
+   * used by SGD for mini-batches.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   * @param gradient Vector to output gradient into.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
@@ -105,10 +202,23 @@ class LogisticRegressionFunction
   size_t NumFunctions() const { return predictors.n_cols; }
 
  private:
+  //! Return the unregularized objective terms of points begin through
+  //! (end - 1).
+  double EvaluateBlock(const arma::mat& parameters,
+                       const size_t begin,
+                       const size_t end) const;
+
+  //! Return the unregularized objective terms of points begin through
+  //! (end - 1), and add their gradient terms to the given gradient.
+  double EvaluateWithGradientBlock(const arma::mat& parameters,
+                                   const size_t begin,
+                                   const size_t end,
+                                   arma::mat& gradient) const;
+
   //! The initial point, from which to start the optimization.
   arma::mat initialPoint;
   //! The matrix of data points (predictors).
-  const arma::mat& predictors;
+  const MatType& predictors;
   //! The vector of responses to the input data points.
   const arma::vec& responses;
   //! The regularization parameter for L2-regularization.
@@ -118,4 +228,7 @@ class LogisticRegressionFunction
 }; // namespace regression
 }; // namespace mlpack
 
+// Include implementation.
+#include "logistic_regression_function_impl.hpp"
+
 #endif // __MLPACK_METHODS_LOGISTIC_REGRESSION_LOGISTIC_REGRESSION_FUNCTION_HPP
@@ -0,0 +1,219 @@
+/**
+ * @file logistic_regression_function_impl.hpp
+ * @author Sumedh Ghaisas
+ *
+ * Implementation of the LogisticRegressionFunction class.
+ */
+#ifndef __MLPACK_METHODS_LOGISTIC_REGRESSION_LOGISTIC_REGRESSION_FUNCTION_IMPL_HPP
+#define __MLPACK_METHODS_LOGISTIC_REGRESSION_LOGISTIC_REGRESSION_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "logistic_regression_function.hpp"
+
+namespace mlpack {
+namespace regression {
+
+template<typename MatType>
+LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
+    const MatType& predictors,
+    const arma::vec& responses,
+    const double lambda) :
+    predictors(predictors),
+    responses(responses),
+    lambda(lambda)
+{
+  initialPoint = arma::zeros<arma::mat>(predictors.n_rows + 1, 1);
+}
+
+template<typename MatType>
+LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
+    const MatType& predictors,
+    const arma::vec& responses,
+    const arma::mat& initialPoint,
+    const double lambda) :
+    initialPoint(initialPoint),
+    predictors(predictors),
+    responses(responses),
+    lambda(lambda)
+{
+  //to check if initialPoint is compatible with predictors
+  if (initialPoint.n_rows != (predictors.n_rows + 1) ||
+      initialPoint.n_cols != 1)
+    this->initialPoint = arma::zeros<arma::mat>(predictors.n_rows + 1, 1);
+}
+
+/**
+ * Evaluate the logistic regression objective function given the estimated
+ * parameters.
+ */
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::Evaluate(
+    const arma::mat& parameters) const
+{
+  // The objective function is the log-likelihood function (w is the parameters
+  // vector for the model; y is the responses; x is the predictors; sig() is the
+  // sigmoid function):
+  //   f(w) = sum(y log(sig(w'x)) + (1 - y) log(sig(1 - w'x))).
+  // We want to minimize this function.  L2-regularization is just lambda
+  // multiplied by the squared l2-norm of the parameters then divided by two.
+
+  // For the regularization, we ignore the first term, which is the intercept
+  // term.
+  const double regularization = 0.5 * lambda *
+      arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
+                parameters.col(0).subvec(1, parameters.n_elem - 1));
+
+  // Often the objective function and the regularization as given are divided
+  // by the number of features, but this doesn't actually affect the
+  // optimization result, so we'll just ignore those terms for computational
+  // efficiency.
+  return optimization::ParallelSum(*this,
+      &LogisticRegressionFunction::EvaluateBlock, parameters,
+      predictors.n_cols) + regularization;
+}
+
+/**
+ * Evaluate the logistic regression objective function, but with only one point.
+ * This is useful for optimizers that use a separable objective function, such
+ * as SGD.
+ */
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::Evaluate(
+    const arma::mat& parameters,
+    const size_t i) const
+{
+  // Calculate the regularization term.  We must divide by the number of points,
+  // so that sum(Evaluate(parameters, [1:points])) == Evaluate(parameters).
+  const double regularization = lambda * (1.0 / (2.0 * predictors.n_cols)) *
+      arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
+                parameters.col(0).subvec(1, parameters.n_elem - 1));
+
+  return EvaluateBlock(parameters, i, i + 1) + regularization;
+}
+
+//! Evaluate the gradient of the logistic regression objective function.
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::Gradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  EvaluateWithGradient(parameters, gradient);
+}
+
+/**
+ * Evaluate the logistic regression objective function and its gradient in one
+ * pass over the points.
+ */
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  // As in Evaluate(), the intercept term is not regularized.
+  const double regularization = 0.5 * lambda *
+      arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
+                parameters.col(0).subvec(1, parameters.n_elem - 1));
+
+  gradient.set_size(parameters.n_elem, 1);
+  const double objective = optimization::ParallelSum(*this,
+      &LogisticRegressionFunction::EvaluateWithGradientBlock, parameters,
+      predictors.n_cols, gradient);
+
+  gradient.col(0).subvec(1, parameters.n_elem - 1) += lambda *
+      parameters.col(0).subvec(1, parameters.n_elem - 1);
+
+  return objective + regularization;
+}
+
+/**
+ * Evaluate the individual gradients of the logistic regression objective
+ * function with respect to individual points.  This is useful for optimizers
+ * that use a separable objective function, such as SGD.
+ */
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::Gradient(
+    const arma::mat& parameters,
+    const size_t i,
+    arma::mat& gradient) const
+{
+  Gradient(parameters, i, 1, gradient);
+}
+
+/**
+ * Evaluate the sum of the individual gradients of the logistic regression
+ * objective function with respect to a batch of consecutive points.  This is
+ * useful for mini-batch SGD.
+ */
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::Gradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize,
+    arma::mat& gradient) const
+{
+  // Each point contributes its share of the regularization term.
+  gradient.set_size(parameters.n_elem, 1);
+  gradient[0] = 0.0;
+  gradient.col(0).subvec(1, parameters.n_elem - 1) = lambda *
+      parameters.col(0).subvec(1, parameters.n_elem - 1) *
+      ((double) batchSize / predictors.n_cols);
+
+  EvaluateWithGradientBlock(parameters, begin, begin + batchSize, gradient);
+}
+
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::EvaluateBlock(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t end) const
+{
+  // Calculate vectors of sigmoids.  The intercept term is parameters(0, 0) and
+  // does not need to be multiplied by any of the predictors.
+  arma::vec exponents;
+  LinearTerms(predictors, parameters, begin, end, exponents);
+  const arma::vec sigmoid = 1.0 / (1.0 + arma::exp(-exponents));
+
+  double result = 0.0;
+  for (size_t i = begin; i < end; ++i)
+  {
+    if (responses[i] == 1)
+      result += log(sigmoid[i - begin]);
+    else
+      result += log(1.0 - sigmoid[i - begin]);
+  }
+
+  // Invert the result, because it's a minimization.
+  return -result;
+}
+
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::EvaluateWithGradientBlock(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t end,
+    arma::mat& gradient) const
+{
+  arma::vec exponents;
+  LinearTerms(predictors, parameters, begin, end, exponents);
+  const arma::vec sigmoids = 1.0 / (1.0 + arma::exp(-exponents));
+
+  // The gradient of each term is (sig(w'x) - y) [1; x].
+  AddWeightedPoints(predictors, begin, end,
+      sigmoids - responses.subvec(begin, end - 1), gradient);
+
+  double result = 0.0;
+  for (size_t i = begin; i < end; ++i)
+  {
+    if (responses[i] == 1)
+      result += log(sigmoids[i - begin]);
+    else
+      result += log(1.0 - sigmoids[i - begin]);
+  }
+
+  return -result;
+}
+
+}; // namespace regression
+}; // namespace mlpack
+
+#endif
@@ -14,16 +14,18 @@
 namespace mlpack {
 namespace regression {
 
-template<template<typename> class OptimizerType>
-LogisticRegression<OptimizerType>::LogisticRegression(
-    const arma::mat& predictors,
+template<template<typename> class OptimizerType, typename MatType>
+LogisticRegression<OptimizerType, MatType>::LogisticRegression(
+    const MatType& predictors,
     const arma::vec& responses,
     const double lambda) :
     parameters(arma::zeros<arma::vec>(predictors.n_rows + 1)),
     lambda(lambda)
 {
-  LogisticRegressionFunction errorFunction(predictors, responses, lambda);
-  OptimizerType<LogisticRegressionFunction> optimizer(errorFunction);
+  LogisticRegressionFunction<MatType> errorFunction(predictors, responses,
+      lambda);
+  OptimizerType<LogisticRegressionFunction<MatType> > optimizer(
+      errorFunction);
 
   // Train the model.
   Timer::Start("logistic_regression_optimization");
@@ -34,18 +36,20 @@ LogisticRegression<OptimizerType>::LogisticRegression(
       << "trained model is " << out << "." << std::endl;
 }
 
-template<template<typename> class OptimizerType>
-LogisticRegression<OptimizerType>::LogisticRegression(
-    const arma::mat& predictors,
+template<template<typename> class OptimizerType, typename MatType>
+LogisticRegression<OptimizerType, MatType>::LogisticRegression(
+    const MatType& predictors,
     const arma::vec& responses,
     const arma::mat& initialPoint,
     const double lambda) :
     parameters(arma::zeros<arma::vec>(predictors.n_rows + 1)),
     lambda(lambda)
 {
-  LogisticRegressionFunction errorFunction(predictors, responses, lambda);
+  LogisticRegressionFunction<MatType> errorFunction(predictors, responses,
+      lambda);
   errorFunction.InitialPoint() = initialPoint;
-  OptimizerType<LogisticRegressionFunction> optimizer(errorFunction);
+  OptimizerType<LogisticRegressionFunction<MatType> > optimizer(
+      errorFunction);
 
   // Train the model.
   Timer::Start("logistic_regression_optimization");
@@ -56,9 +60,9 @@ LogisticRegression<OptimizerType>::LogisticRegression(
       << "trained model is " << out << "." << std::endl;
 }
 
-template<template<typename> class OptimizerType>
-LogisticRegression<OptimizerType>::LogisticRegression(
-    OptimizerType<LogisticRegressionFunction>& optimizer) :
+template<template<typename> class OptimizerType, typename MatType>
+LogisticRegression<OptimizerType, MatType>::LogisticRegression(
+    OptimizerType<LogisticRegressionFunction<MatType> >& optimizer) :
     parameters(optimizer.Function().GetInitialPoint()),
     lambda(optimizer.Function().Lambda())
 {
@@ -70,8 +74,8 @@ LogisticRegression<OptimizerType>::LogisticRegression(
       << "trained model is " << out << "." << std::endl;
 }
 
-template<template<typename> class OptimizerType>
-LogisticRegression<OptimizerType>::LogisticRegression(
+template<template<typename> class OptimizerType, typename MatType>
+LogisticRegression<OptimizerType, MatType>::LogisticRegression(
     const arma::vec& parameters,
     const double lambda) :
     parameters(parameters),
@@ -80,34 +84,41 @@ LogisticRegression<OptimizerType>::LogisticRegression(
   // Nothing to do.
 }
 
-template<template<typename> class OptimizerType>
-void LogisticRegression<OptimizerType>::Predict(const arma::mat& predictors,
-                                                arma::vec& responses,
-                                                const double decisionBoundary)
+template<template<typename> class OptimizerType, typename MatType>
+void LogisticRegression<OptimizerType, MatType>::Predict(
+    const MatType& predictors,
+    arma::vec& responses,
+    const double decisionBoundary) const
+{
+  Predictor<double>().Classify(predictors, responses, decisionBoundary);
+}
+
+template<template<typename> class OptimizerType, typename MatType>
+template<typename eT>
+LinearPredictor<eT> LogisticRegression<OptimizerType, MatType>::Predictor()
     const
 {
-  // Calculate sigmoid function for each point.  The (1.0 - decisionBoundary)
-  // term correctly sets an offset so that floor() returns 0 or 1 correctly.
-  responses = arma::floor((1.0 / (1.0 + arma::exp(-parameters(0)
-      - predictors.t() * parameters.subvec(1, parameters.n_elem - 1))))
-      + (1.0 - decisionBoundary));
+  // The intercept is the bias of the single score.
+  return LinearPredictor<eT>(
+      arma::trans(parameters.subvec(1, parameters.n_elem - 1)),
+      parameters.subvec(0, 0));
 }
 
-template <template<typename> class OptimizerType>
-double LogisticRegression<OptimizerType>::ComputeError(
-    const arma::mat& predictors,
+template<template<typename> class OptimizerType, typename MatType>
+double LogisticRegression<OptimizerType, MatType>::ComputeError(
+    const MatType& predictors,
     const arma::vec& responses) const
 {
   // Construct a new error function.
-  LogisticRegressionFunction newErrorFunction(predictors, responses,
+  LogisticRegressionFunction<MatType> newErrorFunction(predictors, responses,
       lambda);
 
   return newErrorFunction.Evaluate(parameters);
 }
 
-template <template<typename> class OptimizerType>
-double LogisticRegression<OptimizerType>::ComputeAccuracy(
-    const arma::mat& predictors,
+template<template<typename> class OptimizerType, typename MatType>
+double LogisticRegression<OptimizerType, MatType>::ComputeAccuracy(
+    const MatType& predictors,
     const arma::vec& responses,
     const double decisionBoundary) const
 {
@@ -124,8 +135,8 @@ double LogisticRegression<OptimizerType>::ComputeAccuracy(
   return (double) (count * 100) / responses.n_rows;
 }
 
-template <template<typename> class OptimizerType>
-std::string LogisticRegression<OptimizerType>::ToString() const
+template<template<typename> class OptimizerType, typename MatType>
+std::string LogisticRegression<OptimizerType, MatType>::ToString() const
 {
   std::ostringstream convert;
   convert << "Logistic Regression [" << this << "]" << std::endl;
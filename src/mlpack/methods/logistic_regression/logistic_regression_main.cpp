@@ -38,6 +38,14 @@ PROGRAM_INFO("L2-regularized Logistic Regression and Prediction",
     "each iteration by the optimizer.  If the objective function for your data "
     "is oscillating between Inf and 0, the step size is probably too large.\n"
     "\n"
+    "If --sparse is given, the input and test datasets are read as sparse "
+    "matrices, from coordinate lists with one non-zero entry per line: the "
+    "dimension, the index of the point (both starting at 0), and the value.  "
+    "For sparse input, the responses must be given with --input_responses.  "
+    "Only the non-zero entries are visited during training and prediction, so "
+    "this is a lot faster for high-dimensional sparse data (such as "
+    "bag-of-words or one-hot features).\n"
+    "\n"
     "This implementation of logistic regression supports L2-regularization, "
     "which can help the parameter vector b from overfitting.  This parameter "
     "is specified with the --lambda option; by default, it is 0 (which means "
@@ -79,6 +87,126 @@ PARAM_DOUBLE("tolerance", "Convergence tolerance for optimizer.", "T", 1e-10);
 PARAM_INT("max_iterations", "Maximum iterations for optimizer (0 indicates no "
     "limit).", "M", 0);
 PARAM_DOUBLE("step_size", "Step size for SGD optimizer.", "s", 0.01);
+PARAM_INT("batch_size", "Number of points in each mini-batch of the SGD "
+    "optimizer.", "b", 1);
+PARAM_FLAG("sparse", "If set, --input_file and --test_file are coordinate "
+    "lists of sparse matrices.", "S");
+
+/**
+ * Load a sparse matrix from a coordinate list file, with one non-zero entry
+ * (dimension, point, value) on each line.  The matrix has at least the given
+ * number of rows and exactly the given number of columns, if that is not 0.
+ */
+arma::sp_mat LoadSparse(const string& filename,
+                        const size_t minRows,
+                        const size_t cols)
+{
+  arma::mat coordinates;
+  data::Load(filename, coordinates, true);
+  if (coordinates.n_rows != 3)
+    Log::Fatal << "Sparse dataset '" << filename << "' must have three columns "
+        << "(dimension, point, value)." << endl;
+
+  arma::umat locations = arma::conv_to<arma::umat>::from(
+      coordinates.rows(0, 1));
+  const arma::vec values = trans(coordinates.row(2));
+
+  size_t rows = minRows;
+  size_t points = cols;
+  if (locations.n_cols > 0)
+  {
+    rows = std::max(rows, (size_t) max(locations.row(0)) + 1);
+    const size_t maxPoint = (size_t) max(locations.row(1)) + 1;
+    if (cols == 0)
+      points = maxPoint;
+    else if (maxPoint > cols)
+      Log::Fatal << "Sparse dataset '" << filename << "' has a point index "
+          << "larger than the number of responses." << endl;
+  }
+
+  return arma::sp_mat(locations, values, rows, points);
+}
+
+/**
+ * Train a model on the given predictors with the optimizer given on the
+ * command line.  If the model is not empty, it is used as the initial point.
+ */
+template<typename MatType>
+void Train(const MatType& regressors, const arma::vec& responses,
+           arma::mat& model)
+{
+  const double lambda = CLI::GetParam<double>("lambda");
+  const string optimizerType = CLI::GetParam<string>("optimizer");
+  const double tolerance = CLI::GetParam<double>("tolerance");
+  const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
+  const double stepSize = CLI::GetParam<double>("step_size");
+  const int batchSize = CLI::GetParam<int>("batch_size");
+
+  // Prepare the optimizers.
+  LogisticRegressionFunction<MatType> lrf(regressors, responses, lambda);
+  // Set the initial point, if necessary.
+  if (!model.empty())
+  {
+    lrf.InitialPoint() = model;
+    Log::Info << "Using model from '" << CLI::GetParam<string>("model_file")
+        << "' as initial model for training." << endl;
+  }
+
+  if (optimizerType == "lbfgs")
+  {
+    L_BFGS<LogisticRegressionFunction<MatType> > lbfgsOpt(lrf);
+    lbfgsOpt.MaxIterations() = maxIterations;
+    lbfgsOpt.MinGradientNorm() = tolerance;
+    Log::Info << "Training model with L-BFGS optimizer." << endl;
+
+    // This will train the model.
+    LogisticRegression<L_BFGS, MatType> lr(lbfgsOpt);
+    // Extract the newly trained model.
+    model = lr.Parameters();
+  }
+  else if (optimizerType == "sgd")
+  {
+    SGD<LogisticRegressionFunction<MatType> > sgdOpt(lrf);
+    sgdOpt.MaxIterations() = maxIterations;
+    sgdOpt.Tolerance() = tolerance;
+    sgdOpt.StepSize() = stepSize;
+    sgdOpt.BatchSize() = (size_t) batchSize;
+    Log::Info << "Training model with SGD optimizer." << endl;
+
+    // This will train the model.
+    LogisticRegression<SGD, MatType> lr(sgdOpt);
+    // Extract the newly trained model.
+    model = lr.Parameters();
+  }
+}
+
+/**
+ * Predict the responses of the given test set with the given model, and save
+ * them if requested.
+ */
+template<typename MatType>
+void Predict(const MatType& testSet, const arma::mat& model)
+{
+  const string outputPredictionsFile =
+      CLI::GetParam<string>("output_predictions");
+
+  if (model.n_rows != testSet.n_rows + 1)
+    Log::Fatal << "The model must have dimensionality of one more than the "
+        << "test dataset (the extra dimension is the intercept)." << endl;
+
+  // Training (and the optimizer) are irrelevant here; we'll pass in the model
+  // we have.
+  LogisticRegression<L_BFGS, MatType> lr(model);
+
+  Log::Info << "Predicting classes of points in '"
+      << CLI::GetParam<string>("test_file") << "'." << endl;
+  arma::vec predictions;
+  lr.Predict(testSet, predictions, CLI::GetParam<double>("decision_boundary"));
+
+  // Save the results, if necessary.  Don't transpose.
+  if (!outputPredictionsFile.empty())
+    data::Save(outputPredictionsFile, predictions, false, false);
+}
 
 int main(int argc, char** argv)
 {
@@ -95,9 +223,9 @@ int main(int argc, char** argv)
   const double lambda = CLI::GetParam<double>("lambda");
   const string optimizerType = CLI::GetParam<string>("optimizer");
   const double tolerance = CLI::GetParam<double>("tolerance");
-  const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
   const double decisionBoundary = CLI::GetParam<double>("decision_boundary");
   const double stepSize = CLI::GetParam<double>("step_size");
+  const int batchSize = CLI::GetParam<int>("batch_size");
 
   // One of inputFile and modelFile must be specified.
   if (inputFile.empty() && modelFile.empty())
@@ -139,15 +267,26 @@ int main(int argc, char** argv)
     Log::Fatal << "Step size (--step_size) must be positive (received "
         << stepSize << ")." << endl;
 
+  if ((batchSize <= 0) && (optimizerType == "sgd"))
+    Log::Fatal << "Batch size (--batch_size) must be positive (received "
+        << batchSize << ")." << endl;
+
+  const bool sparse = CLI::HasParam("sparse");
+  if (sparse && !inputFile.empty() && inputResponsesFile.empty())
+    Log::Fatal << "--input_responses must be given for sparse input (--sparse)."
+        << endl;
+
   // These are the matrices we might use.
   arma::mat regressors;
+  arma::sp_mat sparseRegressors;
   arma::mat responses;
   arma::mat model;
   arma::mat testSet;
-  arma::vec predictions;
+  arma::sp_mat sparseTestSet;
 
-  // Load matrices.
-  if (!inputFile.empty())
+  // Load matrices.  Sparse datasets are loaded once the number of points
+  // (from the responses) and the dimensionality (from the model) are known.
+  if (!inputFile.empty() && !sparse)
     data::Load(inputFile, regressors, true);
 
   // Check if the responses are in a separate file.
@@ -156,87 +295,70 @@ int main(int argc, char** argv)
     data::Load(inputResponsesFile, responses, true);
     if (responses.n_rows == 1)
       responses = responses.t();
-    if (responses.n_rows != regressors.n_cols)
+    if (!sparse && (responses.n_rows != regressors.n_cols))
       Log::Fatal << "The responses (--input_responses) must have the same "
           << "number of points as the input dataset (--input_file)." << endl;
   }
-  else
+  else if (!regressors.empty())
   {
     // The initial predictors for y, Nx1.
     responses = trans(regressors.row(regressors.n_rows - 1));
     regressors.shed_row(regressors.n_rows - 1);
   }
 
-  if (!testFile.empty())
+  if (!testFile.empty() && !sparse)
     data::Load(testFile, testSet, true);
   if (!modelFile.empty())
   {
     data::Load(modelFile, model, true);
     if (model.n_rows == 1)
       model = model.t();
-    if ((!regressors.empty()) && (model.n_rows != regressors.n_rows + 1))
+  }
+
+  if (sparse)
+  {
+    const size_t dimensionality = model.empty() ? 0 : model.n_rows - 1;
+    if (!inputFile.empty())
+      sparseRegressors = LoadSparse(inputFile, dimensionality,
+          responses.n_rows);
+    if (!testFile.empty())
+      sparseTestSet = LoadSparse(testFile, std::max(dimensionality,
+          (size_t) sparseRegressors.n_rows), 0);
+  }
+
+  const size_t inputDimensionality = sparse ? sparseRegressors.n_rows :
+      regressors.n_rows;
+  const size_t testDimensionality = sparse ? sparseTestSet.n_rows :
+      testSet.n_rows;
+  if (!model.empty())
+  {
+    if ((!inputFile.empty()) && (model.n_rows != inputDimensionality + 1))
       Log::Fatal << "The model (--model) must have dimensionality of one more "
           << "than the input dataset (the extra dimension is the intercept)."
           << endl;
-    if ((!testSet.empty()) && (model.n_rows != testSet.n_rows + 1))
+    if ((!testFile.empty()) && (model.n_rows != testDimensionality + 1))
       Log::Fatal << "The model (--model) must have dimensionality of one more "
           << "than the test dataset (the extra dimension is the intercept)."
           << endl;
   }
 
-  if (!regressors.empty())
+  if (!inputFile.empty())
   {
-    // We need to train the model.  Prepare the optimizers.
+    // We need to train the model.
     arma::vec responsesVec = responses.unsafe_col(0);
-    LogisticRegressionFunction lrf(regressors, responsesVec, lambda);
-    // Set the initial point, if necessary.
-    if (!model.empty())
-    {
-      lrf.InitialPoint() = model;
-      Log::Info << "Using model from '" << modelFile << "' as initial model "
-          << "for training." << endl;
-    }
-
-    if (optimizerType == "lbfgs")
-    {
-      L_BFGS<LogisticRegressionFunction> lbfgsOpt(lrf);
-      lbfgsOpt.MaxIterations() = maxIterations;
-      lbfgsOpt.MinGradientNorm() = tolerance;
-      Log::Info << "Training model with L-BFGS optimizer." << endl;
-
-      // This will train the model.
-      LogisticRegression<L_BFGS> lr(lbfgsOpt);
-      // Extract the newly trained model.
-      model = lr.Parameters();
-    }
-    else if (optimizerType == "sgd")
-    {
-      SGD<LogisticRegressionFunction> sgdOpt(lrf);
-      sgdOpt.MaxIterations() = maxIterations;
-      sgdOpt.Tolerance() = tolerance;
-      sgdOpt.StepSize() = stepSize;
-      Log::Info << "Training model with SGD optimizer." << endl;
-
-      // This will train the model.
-      LogisticRegression<SGD> lr(sgdOpt);
-      // Extract the newly trained model.
-      model = lr.Parameters();
-    }
+    if (sparse)
+      Train(sparseRegressors, responsesVec, model);
+    else
+      Train(regressors, responsesVec, model);
   }
 
-  if (!testSet.empty())
+  if (!testFile.empty())
   {
-    // We must perform predictions on the test set.  Training (and the
-    // optimizer) are irrelevant here; we'll pass in the model we have.
-    LogisticRegression<> lr(model);
-
-    Log::Info << "Predicting classes of points in '" << testFile << "'."
-        << endl;
-    lr.Predict(testSet, predictions, decisionBoundary);
-
-    // Save the results, if necessary.  Don't transpose.
-    if (!outputPredictionsFile.empty())
-      data::Save(outputPredictionsFile, predictions, false, false);
+    // We must perform predictions on the test set.
+    if (sparse)
+      Predict(sparseTestSet, model);
+    else
+      Predict(testSet, model);
   }
 
   if (!outputFile.empty())
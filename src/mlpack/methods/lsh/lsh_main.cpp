@@ -41,7 +41,13 @@ PROGRAM_INFO("All K-Approximate-Nearest-Neighbor Search with LSH",
     "\n\n"
     "Because this is approximate-nearest-neighbors search, results may be "
     "different from run to run.  Thus, the --seed option can be specified to "
-    "set the random seed.");
+    "set the random seed.  Alternatively, the hash can be saved with "
+    "--save_index and reused in later runs with --load_index; this gives the "
+    "same results and skips building the hash."
+    "\n\n"
+    "$ lsh -k 5 -r input.csv --save_index input.lsh -n neighbors.csv\n"
+    "$ lsh -k 5 -r input.csv --load_index input.lsh -q queries.csv "
+    "-n query_neighbors.csv");
 
 // Define our input parameters that this program will take.
 PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
@@ -61,9 +67,18 @@ PARAM_DOUBLE("hash_width", "The hash width for the first-level hashing in the "
     "hash width for its use.", "H", 0.0);
 PARAM_INT("second_hash_size", "The size of the second level hash table.", "M",
     99901);
-PARAM_INT("bucket_size", "The size of a bucket in the second level hash.", "B",
-    500);
+PARAM_INT("bucket_size", "The maximum number of points in a bucket of the "
+    "second level hash; if 0, there is no limit.", "B", 0);
+PARAM_INT("probes", "The number of additional buckets to probe for each "
+    "query (multi-probe LSH).  Probing the buckets next to the query's own "
+    "buckets gives better recall with fewer tables.", "T", 0);
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+PARAM_STRING("save_index", "If specified, the hash built on the reference set "
+    "is saved to this file, so that it can be reused with --load_index.", "",
+    "");
+PARAM_STRING("load_index", "If specified, the hash is loaded from this file "
+    "(written by --save_index with the same reference set) instead of being "
+    "built.  The hash parameters are then taken from the file.", "", "");
 
 int main(int argc, char *argv[])
 {
@@ -105,6 +120,18 @@ int main(int argc, char *argv[])
   const size_t numTables = CLI::GetParam<int>("tables");
   const double hashWidth = CLI::GetParam<double>("hash_width");
 
+  // Sanity check on the number of probes.
+  if (CLI::GetParam<int>("probes") < 0)
+  {
+    Log::Fatal << "Invalid number of probes: " << CLI::GetParam<int>("probes")
+        << ".  Must be 0 or greater." << endl;
+  }
+  const size_t numProbes = (size_t) CLI::GetParam<int>("probes");
+
+  // The search is only run with several threads if the global --threads
+  // option is given (which sets the number of OpenMP threads).
+  const size_t numThreads = CLI::HasParam("threads") ? util::NumThreads() : 1;
+
   arma::Mat<size_t> neighbors;
   arma::mat distances;
 
@@ -117,29 +144,56 @@ int main(int argc, char *argv[])
               << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
   }
 
-  if (hashWidth == 0.0)
-    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
-        numTables << " tables (L) with default hash width." << endl;
-  else
-    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
-        numTables << " tables (L) with hash width(r): " << hashWidth << endl;
-
-  Timer::Start("hash_building");
+  const string saveIndexFile = CLI::GetParam<string>("save_index");
+  const string loadIndexFile = CLI::GetParam<string>("load_index");
 
   LSHSearch<>* allkann;
 
-  if (CLI::GetParam<string>("query_file") != "")
-    allkann = new LSHSearch<>(referenceData, queryData, numProj, numTables,
-                              hashWidth, secondHashSize, bucketSize);
+  if (loadIndexFile != "")
+  {
+    Timer::Start("index_loading");
+
+    if (CLI::GetParam<string>("query_file") != "")
+      allkann = new LSHSearch<>(referenceData, queryData, loadIndexFile);
+    else
+      allkann = new LSHSearch<>(referenceData, loadIndexFile);
+
+    Timer::Stop("index_loading");
+  }
   else
-    allkann = new LSHSearch<>(referenceData, numProj, numTables, hashWidth,
-                              secondHashSize, bucketSize);
+  {
+    if (hashWidth == 0.0)
+      Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
+          numTables << " tables (L) with default hash width." << endl;
+    else
+      Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
+          numTables << " tables (L) with hash width(r): " << hashWidth << endl;
+
+    Timer::Start("hash_building");
+
+    if (CLI::GetParam<string>("query_file") != "")
+      allkann = new LSHSearch<>(referenceData, queryData, numProj, numTables,
+                                hashWidth, secondHashSize, bucketSize);
+    else
+      allkann = new LSHSearch<>(referenceData, numProj, numTables, hashWidth,
+                                secondHashSize, bucketSize);
+
+    Timer::Stop("hash_building");
+  }
+
+  if (saveIndexFile != "")
+  {
+    Log::Info << "Saving LSH index to '" << saveIndexFile << "'." << endl;
+    if (!allkann->Save(saveIndexFile))
+      Log::Fatal << "Could not save LSH index to '" << saveIndexFile << "'."
+          << endl;
+  }
 
-  Timer::Stop("hash_building");
+  allkann->NumThreads() = numThreads;
 
   Log::Info << "Computing " << k << " distance approximate nearest neighbors "
       << endl;
-  allkann->Search(k, neighbors, distances);
+  allkann->Search(k, neighbors, distances, 0, numProbes);
 
   Log::Info << "Neighbors computed." << endl;
 
@@ -61,9 +61,9 @@ class LSHSearch
    *     upper bound on the nearest-neighbor distance in general.
    * @param secondHashSize The size of the second hash table. This should be a
    *     large prime number.
-   * @param bucketSize The size of the bucket in the second hash table. This is
-   *     the maximum number of points that can be hashed into single bucket.
-   *     Default values are already provided here.
+   * @param bucketSize The maximum number of points that can be hashed into a
+   *     single bucket of the second hash table; any further points are
+   *     dropped.  If 0 (the default), buckets can hold any number of points.
    */
   LSHSearch(const arma::mat& referenceSet,
             const arma::mat& querySet,
@@ -71,7 +71,7 @@ class LSHSearch
             const size_t numTables,
             const double hashWidth = 0.0,
             const size_t secondHashSize = 99901,
-            const size_t bucketSize = 500);
+            const size_t bucketSize = 0);
 
   /**
    * This function initializes the LSH class. It builds the hash on the
@@ -89,16 +89,52 @@ class LSHSearch
    *     upper bound on the nearest-neighbor distance in general.
    * @param secondHashSize The size of the second hash table. This should be a
    *     large prime number.
-   * @param bucketSize The size of the bucket in the second hash table. This is
-   *     the maximum number of points that can be hashed into single bucket.
-   *     Default values are already provided here.
+   * @param bucketSize The maximum number of points that can be hashed into a
+   *     single bucket of the second hash table; any further points are
+   *     dropped.  If 0 (the default), buckets can hold any number of points.
    */
   LSHSearch(const arma::mat& referenceSet,
             const size_t numProj,
             const size_t numTables,
             const double hashWidth = 0.0,
             const size_t secondHashSize = 99901,
-            const size_t bucketSize = 500);
+            const size_t bucketSize = 0);
+
+  /**
+   * Load a hash built earlier from the given index file (see Save()), instead
+   * of building a new one.  The reference set must be the one the index was
+   * built on.  Log::Fatal is used if the file cannot be read, is not a valid
+   * index file, or does not match the reference set.
+   *
+   * @param referenceSet Set of reference points the index was built on.
+   * @param querySet Set of query points.
+   * @param indexFile Name of the index file to load.
+   */
+  LSHSearch(const arma::mat& referenceSet,
+            const arma::mat& querySet,
+            const std::string& indexFile);
+
+  /**
+   * Load a hash built earlier from the given index file (see Save()), instead
+   * of building a new one, and use the reference set as the set of queries.
+   * The reference set must be the one the index was built on.  Log::Fatal is
+   * used if the file cannot be read, is not a valid index file, or does not
+   * match the reference set.
+   *
+   * @param referenceSet Set of reference points the index was built on.
+   * @param indexFile Name of the index file to load.
+   */
+  LSHSearch(const arma::mat& referenceSet, const std::string& indexFile);
+
+  /**
+   * Save the hash (the projections, offsets, and both levels of hashing) to an
+   * index file, so that it can be loaded later without being rebuilt and
+   * searches give the same results.  The reference set itself is not saved.
+   *
+   * @param indexFile Name of the index file to write.
+   * @return false if the file could not be written.
+   */
+  bool Save(const std::string& indexFile) const;
 
   /**
    * Compute the nearest neighbors and store the output in the given matrices.
@@ -117,11 +153,31 @@ class LSHSearch
    *     available without having to build hashing for every table size.
    *     By default, this is set to zero in which case all tables are
    *     considered.
+   * @param numProbes Number of additional buckets to probe for each query,
+   *     over all of the tables searched (multi-probe LSH).  The buckets next to
+   *     the query's own buckets are probed in order of how close the query is
+   *     to their boundaries, so a few tables with some probes can give the same
+   *     recall as many more tables without them.  By default no additional
+   *     buckets are probed.
    */
   void Search(const size_t k,
               arma::Mat<size_t>& resultingNeighbors,
               arma::mat& distances,
-              const size_t numTablesToSearch = 0);
+              const size_t numTablesToSearch = 0,
+              const size_t numProbes = 0);
+
+  //! Get the number of threads used for search.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for search.  This only has an effect if
+  //! mlpack was compiled with OpenMP.
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the offset of each bucket's points in SecondHashTable(); bucket i
+  //! holds the points from BucketOffsets()[i] to BucketOffsets()[i + 1] - 1.
+  const arma::Col<size_t>& BucketOffsets() const { return bucketOffsets; }
+  //! Get the points in each bucket of the second hash table, in order.
+  const arma::Col<arma::u32>& SecondHashTable() const
+  { return secondHashTable; }
 
   // Returns a string representation of this object. 
   std::string ToString() const;
@@ -143,19 +199,58 @@ class LSHSearch
   void BuildHash();
 
   /**
-   * This function takes a query and hashes it into each of the hash tables to
-   * get keys for the query and then the key is hashed to a bucket of the second
-   * hash table and all the points (if any) in those buckets are collected as
-   * the potential neighbor candidates.
+   * Load the hash from an index file written by Save().  This is used by the
+   * constructors that take an index file.
    *
-   * @param queryIndex The index of the query currently being processed.
+   * @param indexFile Name of the index file to load.
+   */
+  void Load(const std::string& indexFile);
+
+  /**
+   * This function takes the key of a query in each of the hash tables, hashes
+   * each key to a bucket of the second hash table, and collects all the points
+   * (if any) in those buckets as the potential neighbor candidates.
+   *
+   * @param projectedQuery The query's projections in each table searched,
+   *     shifted by the offsets and divided by the hash width (numProj x
+   *     tables).  The key in each table is the floor of its column.
    * @param referenceIndices The list of neighbor candidates obtained from
    *    hashing the query into all the hash tables and eventually into
    *    multiple buckets of the second hash table.
+   * @param numProbes The number of additional buckets to probe.
    */
-  void ReturnIndicesFromTable(const size_t queryIndex,
+  void ReturnIndicesFromTable(const arma::mat& projectedQuery,
                               arma::uvec& referenceIndices,
-                              size_t numTablesToSearch);
+                              const size_t numProbes) const;
+
+  /**
+   * Find the buckets to probe in addition to the ones the query hashes to,
+   * using the query-directed probing sequence of Lv et al. (2007).  A probe
+   * changes some of the components of the query's key in one table by +1 or
+   * -1; its score is the sum of the squared distances (in units of the hash
+   * width) from the query's projections to the boundaries that are crossed.
+   * The probes with the lowest scores over all of the tables are returned.
+   *
+   * @param projectedQuery The query's projections in each table, shifted by
+   *     the offsets and divided by the hash width (numProj x tables).
+   * @param numProbes Number of buckets to return.
+   * @param buckets The buckets of the second hash table to probe.
+   */
+  void GetAdditionalProbes(const arma::mat& projectedQuery,
+                           const size_t numProbes,
+                           std::vector<size_t>& buckets) const;
+
+  /**
+   * Return the bucket of the second hash table that the given key hashes to.
+   * The key is given as the dot product of the second hash weights with the
+   * integer key.
+   *
+   * @param weightedKey Dot product of the second hash weights with the key.
+   */
+  size_t SecondHash(const double weightedKey) const
+  {
+    return (size_t) weightedKey % secondHashSize;
+  }
 
   /**
    * This is a helper function that computes the distance of the query to the
@@ -188,10 +283,10 @@ class LSHSearch
   const arma::mat& querySet;
 
   //! The number of projections
-  const size_t numProj;
+  size_t numProj;
 
   //! The number of hash tables
-  const size_t numTables;
+  size_t numTables;
 
   //! The std::vector containing the projection matrix of each table
   std::vector<arma::mat> projections; // should be [numProj x dims] x numTables
@@ -203,27 +298,30 @@ class LSHSearch
   double hashWidth;
 
   //! The big prime representing the size of the second hash
-  const size_t secondHashSize;
+  size_t secondHashSize;
 
   //! The weights of the second hash
   arma::vec secondHashWeights;
 
-  //! The bucket size of the second hash
-  const size_t bucketSize;
+  //! The maximum number of points in a bucket of the second hash (0 means no
+  //! limit).
+  size_t bucketSize;
 
   //! Instantiation of the metric.
   metric::SquaredEuclideanDistance metric;
 
-  //! The final hash table; should be (< secondHashSize) x bucketSize.
-  arma::Mat<size_t> secondHashTable;
+  //! The final hash table: the indices of the points in each bucket, stored
+  //! one bucket after another, so no space is spent on empty buckets.  Indices
+  //! are 32-bit to halve the size of the table.
+  arma::Col<arma::u32> secondHashTable;
 
-  //! The number of elements present in each hash bucket; should be
-  //! secondHashSize.
-  arma::Col<size_t> bucketContentSize;
+  //! For a particular hash value, the position in secondHashTable where its
+  //! bucket starts.  Should be secondHashSize + 1, so that the end of bucket i
+  //! is bucketOffsets[i + 1].
+  arma::Col<size_t> bucketOffsets;
 
-  //! For a particular hash value, points to the row in secondHashTable
-  //! corresponding to this value.  Should be secondHashSize.
-  arma::Col<size_t> bucketRowInHashTable;
+  //! The number of threads to use for search.
+  size_t numThreads;
 
   //! The pointer to the nearest neighbor distances.
   arma::mat* distancePtr;
@@ -9,6 +9,13 @@
 
 #include <mlpack/core.hpp>
 
+#include <queue>
+#include <limits>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+
 namespace mlpack {
 namespace neighbor {
 
@@ -28,7 +35,8 @@ LSHSearch(const arma::mat& referenceSet,
   numTables(numTables),
   hashWidth(hashWidthIn),
   secondHashSize(secondHashSize),
-  bucketSize(bucketSize)
+  bucketSize(bucketSize),
+  numThreads(1)
 {
   if (hashWidth == 0.0) // The user has not provided any value.
   {
@@ -64,7 +72,8 @@ LSHSearch(const arma::mat& referenceSet,
   numTables(numTables),
   hashWidth(hashWidthIn),
   secondHashSize(secondHashSize),
-  bucketSize(bucketSize)
+  bucketSize(bucketSize),
+  numThreads(1)
 {
   if (hashWidth == 0.0) // The user has not provided any value.
   {
@@ -86,6 +95,38 @@ LSHSearch(const arma::mat& referenceSet,
   BuildHash();
 }
 
+template<typename SortPolicy>
+LSHSearch<SortPolicy>::
+LSHSearch(const arma::mat& referenceSet,
+          const arma::mat& querySet,
+          const std::string& indexFile) :
+  referenceSet(referenceSet),
+  querySet(querySet),
+  numProj(0),
+  numTables(0),
+  hashWidth(0.0),
+  secondHashSize(0),
+  bucketSize(0),
+  numThreads(1)
+{
+  Load(indexFile);
+}
+
+template<typename SortPolicy>
+LSHSearch<SortPolicy>::
+LSHSearch(const arma::mat& referenceSet, const std::string& indexFile) :
+  referenceSet(referenceSet),
+  querySet(referenceSet),
+  numProj(0),
+  numTables(0),
+  hashWidth(0.0),
+  secondHashSize(0),
+  bucketSize(0),
+  numThreads(1)
+{
+  Load(indexFile);
+}
+
 template<typename SortPolicy>
 void LSHSearch<SortPolicy>::
 InsertNeighbor(const size_t queryIndex,
@@ -139,65 +180,146 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
 
 template<typename SortPolicy>
 void LSHSearch<SortPolicy>::
-ReturnIndicesFromTable(const size_t queryIndex,
+ReturnIndicesFromTable(const arma::mat& projectedQuery,
                        arma::uvec& referenceIndices,
-                       size_t numTablesToSearch)
+                       const size_t numProbes) const
 {
-  // Decide on the number of tables to look into.
-  if (numTablesToSearch == 0) // If no user input is given, search all.
-    numTablesToSearch = numTables;
+  // Compute the hash value of each key of the query into a bucket of the
+  // 'secondHashTable' using the 'secondHashWeights'.
+  arma::rowvec hashVec = secondHashWeights.t() * arma::floor(projectedQuery);
 
-  // Sanity check to make sure that the existing number of tables is not
-  // exceeded.
-  if (numTablesToSearch > numTables)
-    numTablesToSearch = numTables;
+  std::vector<size_t> buckets(hashVec.n_elem);
+  for (size_t i = 0; i < hashVec.n_elem; i++)
+    buckets[i] = SecondHash(hashVec[i]);
 
-  // Hash the query in each of the 'numTablesToSearch' hash tables using the
-  // 'numProj' projections for each table. This gives us 'numTablesToSearch'
-  // keys for the query where each key is a 'numProj' dimensional integer
-  // vector.
+  // Add the neighboring buckets, if we are doing multi-probe LSH.
+  if (numProbes > 0)
+    GetAdditionalProbes(projectedQuery, numProbes, buckets);
 
-  // Compute the projection of the query in each table.
-  arma::mat allProjInTables(numProj, numTablesToSearch);
-  for (size_t i = 0; i < numTablesToSearch; i++)
+  // For all the buckets that the query is hashed into, sequentially
+  // collect the indices in those buckets.  The candidates are then sorted and
+  // duplicates are removed, so that the cost depends only on the number of
+  // candidates and not on the size of the reference set.
+  size_t numCandidates = 0;
+  for (size_t i = 0; i < buckets.size(); i++)
+    numCandidates += bucketOffsets[buckets[i] + 1] - bucketOffsets[buckets[i]];
+
+  referenceIndices.set_size(numCandidates);
+  size_t position = 0;
+  for (size_t i = 0; i < buckets.size(); i++) // For all buckets.
   {
-    allProjInTables.unsafe_col(i) = projections[i].t() *
-        querySet.unsafe_col(queryIndex);
+    // Pick the indices in the bucket corresponding to 'hashInd'.
+    const size_t hashInd = buckets[i];
+    for (size_t j = bucketOffsets[hashInd]; j < bucketOffsets[hashInd + 1];
+        j++)
+      referenceIndices[position++] = secondHashTable[j];
   }
-  allProjInTables += offsets.cols(0, numTablesToSearch - 1);
-  allProjInTables /= hashWidth;
 
-  // Compute the hash value of each key of the query into a bucket of the
-  // 'secondHashTable' using the 'secondHashWeights'.
-  arma::rowvec hashVec = secondHashWeights.t() * arma::floor(allProjInTables);
+  arma::uword* begin = referenceIndices.memptr();
+  std::sort(begin, begin + numCandidates);
+  const size_t numUnique = std::unique(begin, begin + numCandidates) - begin;
+  referenceIndices.resize(numUnique);
+}
 
-  for (size_t i = 0; i < hashVec.n_elem; i++)
-    hashVec[i] = (double) ((size_t) hashVec[i] % secondHashSize);
+//! A set of perturbed key components, for multi-probe LSH.
+struct LSHProbe
+{
+  //! The score of this probe; lower scores are probed first.
+  double score;
+  //! The table this probe is for.
+  size_t table;
+  //! Positions (in the table's sorted list of boundaries) that are crossed.
+  std::vector<size_t> positions;
 
-  Log::Assert(hashVec.n_elem == numTablesToSearch);
+  //! Order probes so that std::priority_queue returns the lowest score first.
+  bool operator<(const LSHProbe& other) const { return score > other.score; }
+};
 
-  // For all the buckets that the query is hashed into, sequentially
-  // collect the indices in those buckets.
-  arma::Col<size_t> refPointsConsidered;
-  refPointsConsidered.zeros(referenceSet.n_cols);
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::
+GetAdditionalProbes(const arma::mat& projectedQuery,
+                    const size_t numProbes,
+                    std::vector<size_t>& buckets) const
+{
+  // For each table, sort the 2 * numProj boundaries of the query's bucket by
+  // their distance from the query.  Boundary 2 * j is the lower boundary in
+  // projection j (its key component decreases by one), and boundary 2 * j + 1
+  // is the upper boundary (its key component increases by one).
+  const size_t numBoundaries = 2 * numProj;
+  std::vector<std::vector<std::pair<double, size_t> > > boundaries(
+      projectedQuery.n_cols);
+  arma::rowvec weightedKeys = secondHashWeights.t() *
+      arma::floor(projectedQuery);
+
+  std::priority_queue<LSHProbe> probes;
+  for (size_t t = 0; t < projectedQuery.n_cols; ++t)
+  {
+    boundaries[t].resize(numBoundaries);
+    for (size_t j = 0; j < numProj; ++j)
+    {
+      const double lower = projectedQuery(j, t) -
+          std::floor(projectedQuery(j, t));
+      boundaries[t][2 * j] = std::make_pair(lower * lower, 2 * j);
+      boundaries[t][2 * j + 1] = std::make_pair((1 - lower) * (1 - lower),
+          2 * j + 1);
+    }
+    std::sort(boundaries[t].begin(), boundaries[t].end());
+
+    // The best probe in each table crosses only its nearest boundary.
+    LSHProbe probe;
+    probe.score = boundaries[t][0].first;
+    probe.table = t;
+    probe.positions.push_back(0);
+    probes.push(probe);
+  }
 
-  for (size_t i = 0; i < hashVec.n_elem; i++) // For all tables.
+  size_t numFound = 0;
+  while (numFound < numProbes && !probes.empty())
   {
-    size_t hashInd = (size_t) hashVec[i];
+    const LSHProbe probe = probes.top();
+    probes.pop();
+
+    // Generate the next probes in this table: replace the last boundary with
+    // the next one (shift), or add the next one (expand).  Every set of
+    // boundaries is generated exactly once this way, in order of score.
+    const std::vector<std::pair<double, size_t> >& sorted =
+        boundaries[probe.table];
+    const size_t last = probe.positions.back();
+    if (last + 1 < numBoundaries)
+    {
+      LSHProbe shift(probe);
+      shift.positions.back() = last + 1;
+      shift.score += sorted[last + 1].first - sorted[last].first;
+      probes.push(shift);
+
+      LSHProbe expand(probe);
+      expand.positions.push_back(last + 1);
+      expand.score += sorted[last + 1].first;
+      probes.push(expand);
+    }
 
-    if (bucketContentSize[hashInd] > 0)
+    // A probe can't cross both boundaries of the same projection.
+    bool valid = true;
+    double weightedKey = weightedKeys[probe.table];
+    for (size_t i = 0; i < probe.positions.size() && valid; ++i)
     {
-      // Pick the indices in the bucket corresponding to 'hashInd'.
-      size_t tableRow = bucketRowInHashTable[hashInd];
-      assert(tableRow < secondHashSize);
-      assert(tableRow < secondHashTable.n_rows);
+      const size_t boundary = sorted[probe.positions[i]].second;
+      for (size_t j = 0; j < i; ++j)
+        if (sorted[probe.positions[j]].second / 2 == boundary / 2)
+          valid = false;
 
-      for (size_t j = 0; j < bucketContentSize[hashInd]; j++)
-        refPointsConsidered[secondHashTable(tableRow, j)]++;
+      if (boundary % 2 == 0)
+        weightedKey -= secondHashWeights[boundary / 2];
+      else
+        weightedKey += secondHashWeights[boundary / 2];
     }
-  }
 
-  referenceIndices = arma::find(refPointsConsidered > 0);
+    if (valid)
+    {
+      buckets.push_back(SecondHash(weightedKey));
+      ++numFound;
+    }
+  }
 }
 
 
@@ -206,7 +328,8 @@ void LSHSearch<SortPolicy>::
 Search(const size_t k,
        arma::Mat<size_t>& resultingNeighbors,
        arma::mat& distances,
-       const size_t numTablesToSearch)
+       const size_t numTablesToSearch,
+       const size_t numProbes)
 {
   neighborPtr = &resultingNeighbors;
   distancePtr = &distances;
@@ -217,26 +340,83 @@ Search(const size_t k,
   distancePtr->fill(SortPolicy::WorstDistance());
   neighborPtr->fill(referenceSet.n_cols);
 
+  // Decide on the number of tables to look into.
+  size_t tablesToSearch = numTablesToSearch;
+  if (tablesToSearch == 0) // If no user input is given, search all.
+    tablesToSearch = numTables;
+
+  // Sanity check to make sure that the existing number of tables is not
+  // exceeded.
+  if (tablesToSearch > numTables)
+    tablesToSearch = numTables;
+
   size_t avgIndicesReturned = 0;
 
   Timer::Start("computing_neighbors");
 
-  // Go through every query point sequentially.
-  for (size_t i = 0; i < querySet.n_cols; i++)
+  // The queries are hashed a block at a time, so that projecting a block into
+  // each table takes one matrix multiplication instead of one per query.  When
+  // there are several threads, the blocks are made small enough that each
+  // thread gets a few of them.
+  size_t blockSize = 1024;
+  if (numThreads > 1)
+    blockSize = std::max((size_t) 1, std::min(blockSize,
+        querySet.n_cols / (4 * numThreads)));
+  const size_t numBlocks = (querySet.n_cols + blockSize - 1) / blockSize;
+
+  // The blocks are independent, and each query only writes to its own column
+  // of the results, so no locking is necessary.
+  #pragma omp parallel num_threads(numThreads)
   {
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
+    arma::cube blockProjections;
+    arma::mat queryProjections(numProj, tablesToSearch);
     arma::uvec refIndices;
-    ReturnIndicesFromTable(i, refIndices, numTablesToSearch);
+    size_t threadIndicesReturned = 0;
 
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    avgIndicesReturned += refIndices.n_elem;
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t) querySet.n_cols);
+
+      // Hash every query of the block in each of the 'tablesToSearch' hash
+      // tables using the 'numProj' projections for each table.  This gives us
+      // 'tablesToSearch' keys for each query where each key is a 'numProj'
+      // dimensional integer vector.
+      blockProjections.set_size(numProj, end - begin, tablesToSearch);
+      for (size_t t = 0; t < tablesToSearch; ++t)
+      {
+        blockProjections.slice(t) = projections[t].t() *
+            querySet.cols(begin, end - 1);
+        blockProjections.slice(t).each_col() += offsets.unsafe_col(t);
+      }
+      blockProjections /= hashWidth;
+
+      for (size_t i = begin; i < end; ++i)
+      {
+        for (size_t t = 0; t < tablesToSearch; ++t)
+          queryProjections.unsafe_col(t) =
+              blockProjections.slice(t).unsafe_col(i - begin);
+
+        // Hash the keys into the 'secondHashTable' to obtain the neighbor
+        // candidates.
+        ReturnIndicesFromTable(queryProjections, refIndices, numProbes);
+
+        // An informative book-keeping for the number of neighbor candidates
+        // returned on average.
+        threadIndicesReturned += refIndices.n_elem;
+
+        // Sequentially go through all the candidates and save the best 'k'
+        // candidates.
+        for (size_t j = 0; j < refIndices.n_elem; j++)
+          BaseCase(i, (size_t) refIndices[j]);
+      }
+    }
 
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    for (size_t j = 0; j < refIndices.n_elem; j++)
-      BaseCase(i, (size_t) refIndices[j]);
+    #pragma omp critical
+    {
+      avgIndicesReturned += threadIndicesReturned;
+    }
   }
 
   Timer::Stop("computing_neighbors");
@@ -271,39 +451,34 @@ BuildHash()
   secondHashWeights = arma::floor(arma::randu(numProj) *
                                   (double) secondHashSize);
 
-  // The 'secondHashTable' is initially an empty matrix of size
-  // ('secondHashSize' x 'bucketSize'). But by only filling the buckets
-  // as points land in them allows us to shrink the size of the
-  // 'secondHashTable' at the end of the hashing.
+  // The points are hashed into buckets table by table, but they are only put
+  // into the 'secondHashTable' once all of the buckets are known.  Then the
+  // points of each bucket can be stored one after another with no padding, and
+  // 'bucketOffsets' gives the position where each bucket starts.
+  if (referenceSet.n_cols > (size_t) std::numeric_limits<arma::u32>::max() ||
+      secondHashSize > (size_t) std::numeric_limits<arma::u32>::max())
+  {
+    Log::Fatal << "LSHSearch: the reference set and the second hash size must "
+        << "each be less than " << std::numeric_limits<arma::u32>::max()
+        << "." << std::endl;
+  }
 
-  // Fill the second hash table n = referenceSet.n_cols.  This is because no
-  // point has index 'n' so the presence of this in the bucket denotes that
-  // there are no more points in this bucket.
-  secondHashTable.set_size(secondHashSize, bucketSize);
-  secondHashTable.fill(referenceSet.n_cols);
+  // The bucket of each point in each table.
+  arma::Mat<arma::u32> pointBuckets(numTables, referenceSet.n_cols);
 
   // Keep track of the size of each bucket in the hash.  At the end of hashing
   // most buckets will be empty.
+  arma::Col<size_t> bucketContentSize;
   bucketContentSize.zeros(secondHashSize);
 
-  // Instead of putting the points in the row corresponding to the bucket, we
-  // chose the next empty row and keep track of the row in which the bucket
-  // lies. This allows us to stack together and slice out the empty buckets at
-  // the end of the hashing.
-  bucketRowInHashTable.set_size(secondHashSize);
-  bucketRowInHashTable.fill(secondHashSize);
-
-  // Keep track of number of non-empty rows in the 'secondHashTable'.
-  size_t numRowsInTable = 0;
-
   // Step II: The offsets for all projections in all tables.
   // Since the 'offsets' are in [0, hashWidth], we obtain the 'offsets'
   // as randu(numProj, numTables) * hashWidth.
   offsets.randu(numProj, numTables);
   offsets *= hashWidth;
 
-  // Step III: Create each hash table in the first level hash one by one and
-  // putting them directly into the 'secondHashTable' for memory efficiency.
+  // Step III: Create each hash table in the first level hash one by one,
+  // keeping only the bucket of each point.
   for (size_t i = 0; i < numTables; i++)
   {
     // Step IV: Obtain the 'numProj' projections for each table.
@@ -333,61 +508,237 @@ BuildHash()
     hashMat += offsetMat;
     hashMat /= hashWidth;
 
-    // Step VI: Putting the points in the 'secondHashTable' by hashing the key.
-    // Now we hash every key, point ID to its corresponding bucket.
+    // Step VI: Find the bucket of the 'secondHashTable' for every point by
+    // hashing its key.
     arma::rowvec secondHashVec = secondHashWeights.t()
       * arma::floor(hashMat);
 
-    // This gives us the bucket for the corresponding point ID.
-    for (size_t j = 0; j < secondHashVec.n_elem; j++)
-      secondHashVec[j] = (double)((size_t) secondHashVec[j] % secondHashSize);
-
     Log::Assert(secondHashVec.n_elem == referenceSet.n_cols);
 
-    // Insert the point in the corresponding row to its bucket in the
-    // 'secondHashTable'.
     for (size_t j = 0; j < secondHashVec.n_elem; j++)
     {
       // This is the bucket number.
-      size_t hashInd = (size_t) secondHashVec[j];
-      // The point ID is 'j'.
+      const size_t hashInd = SecondHash(secondHashVec[j]);
+      pointBuckets(i, j) = (arma::u32) hashInd;
 
-      // If this is currently an empty bucket, start a new row keep track of
-      // which row corresponds to the bucket.
-      if (bucketContentSize[hashInd] == 0)
-      {
-        // Start a new row for hash.
-        bucketRowInHashTable[hashInd] = numRowsInTable;
-        secondHashTable(numRowsInTable, 0) = j;
+      // Count the point, unless the bucket is full.
+      if (bucketSize == 0 || bucketContentSize[hashInd] < bucketSize)
+        bucketContentSize[hashInd]++;
+    } // Loop over all points in the reference set.
+  } // Loop over tables.
 
-        numRowsInTable++;
-      }
+  // Step VII: Lay out the buckets one after another, and fill them in the same
+  // order the points were hashed in (so that, if a bucket is full, the same
+  // points are kept as before).
+  bucketOffsets.set_size(secondHashSize + 1);
+  bucketOffsets[0] = 0;
+  size_t numNonEmptyBuckets = 0;
+  for (size_t i = 0; i < secondHashSize; i++)
+  {
+    bucketOffsets[i + 1] = bucketOffsets[i] + bucketContentSize[i];
+    if (bucketContentSize[i] > 0)
+      numNonEmptyBuckets++;
+  }
 
-      else
+  secondHashTable.set_size(bucketOffsets[secondHashSize]);
+  bucketContentSize.zeros();
+  for (size_t i = 0; i < numTables; i++)
+  {
+    for (size_t j = 0; j < referenceSet.n_cols; j++)
+    {
+      const size_t hashInd = pointBuckets(i, j);
+      const size_t position = bucketOffsets[hashInd] +
+          bucketContentSize[hashInd];
+      if (position < bucketOffsets[hashInd + 1])
       {
-        // If bucket is already present in the 'secondHashTable', find the
-        // corresponding row and insert the point ID in this row unless the
-        // bucket is full, in which case, do nothing.
-        if (bucketContentSize[hashInd] < bucketSize)
-          secondHashTable(bucketRowInHashTable[hashInd],
-                          bucketContentSize[hashInd]) = j;
+        secondHashTable[position] = (arma::u32) j;
+        bucketContentSize[hashInd]++;
       }
+    }
+  }
 
-      // Increment the count of the points in this bucket.
-      if (bucketContentSize[hashInd] < bucketSize)
-        bucketContentSize[hashInd]++;
-    } // Loop over all points in the reference set.
-  } // Loop over tables.
+  Log::Info << "Final hash table size: " << secondHashTable.n_elem
+      << " points in " << numNonEmptyBuckets << " buckets." << std::endl;
+}
 
-  // Step VII: Condensing the 'secondHashTable'.
-  size_t maxBucketSize = 0;
-  for (size_t i = 0; i < bucketContentSize.n_elem; i++)
-    if (bucketContentSize[i] > maxBucketSize)
-      maxBucketSize = bucketContentSize[i];
+/**
+ * The layout of an LSH index file is:
+ *
+ *  - the 8 characters "MLPACKLS";
+ *  - the version (1), the number of rows and columns of the reference set, the
+ *    number of projections, the number of tables, the second hash size, the
+ *    bucket size, and the number of elements of the second hash table, as
+ *    64-bit unsigned integers;
+ *  - the hash width, the projection matrix of each table, the offsets, and the
+ *    second hash weights, as doubles;
+ *  - the bucket offsets, as 64-bit unsigned integers;
+ *  - the second hash table, as 32-bit unsigned integers.
+ *
+ * Every section is stored as it is held in memory (in the native byte order)
+ * and starts at a multiple of 8 bytes, so each one is loaded with a single
+ * read, and the file could also be mapped directly.
+ */
+namespace lsh_index {
+
+static const char magic[8] = { 'M', 'L', 'P', 'A', 'C', 'K', 'L', 'S' };
+static const boost::uint64_t version = 1;
+
+}; // namespace lsh_index
+
+template<typename SortPolicy>
+bool LSHSearch<SortPolicy>::Save(const std::string& indexFile) const
+{
+  std::ofstream stream(indexFile.c_str(), std::ios::out | std::ios::binary |
+      std::ios::trunc);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << indexFile << "' to save LSH index to."
+        << std::endl;
+    return false;
+  }
+
+  stream.write(lsh_index::magic, sizeof(lsh_index::magic));
+  const boost::uint64_t header[8] = { lsh_index::version, referenceSet.n_rows,
+      referenceSet.n_cols, numProj, numTables, secondHashSize, bucketSize,
+      secondHashTable.n_elem };
+  stream.write((const char*) header, sizeof(header));
+
+  stream.write((const char*) &hashWidth, sizeof(double));
+  for (size_t i = 0; i < numTables; ++i)
+    stream.write((const char*) projections[i].memptr(),
+        projections[i].n_elem * sizeof(double));
+  stream.write((const char*) offsets.memptr(), offsets.n_elem * sizeof(double));
+  stream.write((const char*) secondHashWeights.memptr(),
+      secondHashWeights.n_elem * sizeof(double));
+
+  // size_t may not be 64 bits wide.
+  std::vector<boost::uint64_t> offsetBuffer(bucketOffsets.begin(),
+      bucketOffsets.end());
+  stream.write((const char*) &offsetBuffer[0],
+      offsetBuffer.size() * sizeof(boost::uint64_t));
+
+  stream.write((const char*) secondHashTable.memptr(),
+      secondHashTable.n_elem * sizeof(arma::u32));
+
+  if (!stream.good())
+  {
+    Log::Warn << "Error while writing LSH index to '" << indexFile << "'."
+        << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Load(const std::string& indexFile)
+{
+  std::ifstream stream(indexFile.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open LSH index file '" << indexFile << "'."
+        << std::endl;
+
+  stream.seekg(0, std::ios::end);
+  const size_t fileSize = (size_t) stream.tellg();
+  stream.seekg(0, std::ios::beg);
+
+  // Check the header.
+  char fileMagic[sizeof(lsh_index::magic)];
+  boost::uint64_t header[8];
+  stream.read(fileMagic, sizeof(fileMagic));
+  stream.read((char*) header, sizeof(header));
+  if (!stream.good() ||
+      (memcmp(fileMagic, lsh_index::magic, sizeof(lsh_index::magic)) != 0))
+  {
+    Log::Fatal << "'" << indexFile << "' is not an LSH index file."
+        << std::endl;
+  }
+
+  if (header[0] != lsh_index::version)
+  {
+    Log::Fatal << "LSH index file '" << indexFile << "' has unknown version "
+        << header[0] << "." << std::endl;
+  }
+
+  if (header[1] != referenceSet.n_rows || header[2] != referenceSet.n_cols)
+  {
+    Log::Fatal << "LSH index file '" << indexFile << "' was built on a "
+        << "reference set of size " << header[1] << " x " << header[2]
+        << ", but the reference set has size " << referenceSet.n_rows << " x "
+        << referenceSet.n_cols << "." << std::endl;
+  }
+
+  numProj = (size_t) header[3];
+  numTables = (size_t) header[4];
+  secondHashSize = (size_t) header[5];
+  bucketSize = (size_t) header[6];
+  const size_t tableSize = (size_t) header[7];
+
+  // Make sure the file is as long as the header says before allocating
+  // anything, so a corrupt header can't make us allocate huge amounts.
+  const size_t expectedSize = sizeof(lsh_index::magic) + sizeof(header) +
+      (1 + numTables * referenceSet.n_rows * numProj + numProj * numTables +
+      numProj) * sizeof(double) +
+      (secondHashSize + 1) * sizeof(boost::uint64_t) +
+      tableSize * sizeof(arma::u32);
+  if (numProj == 0 || numTables == 0 || secondHashSize == 0 ||
+      fileSize != expectedSize)
+  {
+    Log::Fatal << "LSH index file '" << indexFile << "' has size " << fileSize
+        << " but should have size " << expectedSize << "." << std::endl;
+  }
+
+  stream.read((char*) &hashWidth, sizeof(double));
+
+  projections.resize(numTables);
+  for (size_t i = 0; i < numTables; ++i)
+  {
+    projections[i].set_size(referenceSet.n_rows, numProj);
+    stream.read((char*) projections[i].memptr(),
+        projections[i].n_elem * sizeof(double));
+  }
+
+  offsets.set_size(numProj, numTables);
+  stream.read((char*) offsets.memptr(), offsets.n_elem * sizeof(double));
+  secondHashWeights.set_size(numProj);
+  stream.read((char*) secondHashWeights.memptr(),
+      secondHashWeights.n_elem * sizeof(double));
+
+  std::vector<boost::uint64_t> offsetBuffer(secondHashSize + 1);
+  stream.read((char*) &offsetBuffer[0],
+      offsetBuffer.size() * sizeof(boost::uint64_t));
+  bucketOffsets.set_size(secondHashSize + 1);
+  for (size_t i = 0; i < offsetBuffer.size(); ++i)
+    bucketOffsets[i] = (size_t) offsetBuffer[i];
+
+  secondHashTable.set_size(tableSize);
+  stream.read((char*) secondHashTable.memptr(),
+      secondHashTable.n_elem * sizeof(arma::u32));
+
+  if (!stream.good())
+  {
+    Log::Fatal << "Cannot read LSH index file '" << indexFile << "'."
+        << std::endl;
+  }
+
+  // Searching trusts the index, so make sure every bucket and every point in
+  // it is valid.
+  bool valid = (bucketOffsets[0] == 0) &&
+      (bucketOffsets[secondHashSize] == tableSize);
+  for (size_t i = 0; i < secondHashSize && valid; ++i)
+    if (bucketOffsets[i + 1] < bucketOffsets[i])
+      valid = false;
+  for (size_t i = 0; i < tableSize && valid; ++i)
+    if (secondHashTable[i] >= referenceSet.n_cols)
+      valid = false;
+
+  if (!valid)
+    Log::Fatal << "LSH index file '" << indexFile << "' is corrupt."
+        << std::endl;
 
-  Log::Info << "Final hash table size: (" << numRowsInTable << " x "
-            << maxBucketSize << ")" << std::endl;
-  secondHashTable.resize(numRowsInTable, maxBucketSize);
+  Log::Info << "Loaded LSH index with " << numProj << " projections, "
+      << numTables << " tables, and hash width " << hashWidth << " from '"
+      << indexFile << "'." << std::endl;
 }
 
 template<typename SortPolicy>
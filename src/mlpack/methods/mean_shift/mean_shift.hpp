@@ -0,0 +1,181 @@
+/**
+ * @file mean_shift.hpp
+ *
+ * An implementation of mean shift clustering with a flat kernel, in which each
+ * shift is one range search against a tree built on the dataset.
+ *
+ * @code
+ * @article{comaniciu2002mean,
+ *   title={Mean shift: A robust approach toward feature space analysis},
+ *   author={Comaniciu, D. and Meer, P.},
+ *   journal={IEEE Transactions on Pattern Analysis and Machine Intelligence},
+ *   volume={24},
+ *   number={5},
+ *   pages={603--619},
+ *   year={2002}
+ * }
+ * @endcode
+ */
+#ifndef __MLPACK_METHODS_MEAN_SHIFT_MEAN_SHIFT_HPP
+#define __MLPACK_METHODS_MEAN_SHIFT_MEAN_SHIFT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <mlpack/methods/range_search/range_search.hpp>
+
+namespace mlpack {
+namespace meanshift /** Mean shift clustering. */ {
+
+/**
+ * Mean shift finds the modes of the density of a dataset by repeatedly moving
+ * each of a set of seeds to the mean of the points within a given radius of it
+ * (a flat kernel), until the seeds stop moving.  Every point is then assigned
+ * to the closest mode.
+ *
+ * Done naively, each shift of each seed looks at every point.  Here the points
+ * are put in a tree once, and every iteration shifts all of the seeds that are
+ * still moving with a single RangeSearch::Search(), which prunes every node
+ * outside the radius of a seed.  The cost of each iteration is kept down in
+ * three ways:
+ *
+ *  - Seeds are not taken from every point, but from a grid of cells with
+ *    sides equal to the radius: each cell holding at least minBinFrequency
+ *    points gives one seed, at the mean of its points.
+ *  - A seed that has moved less than 1e-3 times the radius is frozen, and is
+ *    no longer searched for.
+ *  - A seed that comes within the radius of a frozen seed would end at the
+ *    same mode, so it is merged with it in a UnionFind structure and frozen
+ *    too.  Frozen seeds within the radius of each other are merged in the same
+ *    way after the last iteration, and each set of merged seeds is one
+ *    cluster, whose centroid is the seed of the set with the most points in
+ *    its radius.
+ *
+ * @code
+ * extern arma::mat data;
+ * MeanShift<> meanShift(0.5); // Radius of 0.5.
+ *
+ * arma::Col<size_t> assignments;
+ * arma::mat centroids;
+ * const size_t clusters = meanShift.Cluster(data, assignments, centroids);
+ * @endcode
+ *
+ * @tparam MetricType The metric to use.
+ * @tparam TreeType Type of tree to use for the range searches.
+ */
+template<typename MetricType = metric::EuclideanDistance,
+         typename TreeType = tree::BinarySpaceTree<bound::HRectBound<2>,
+                                                   range::RangeSearchStat> >
+class MeanShift
+{
+ public:
+  /**
+   * Create the MeanShift object with the given parameters.
+   *
+   * @param radius Radius of the flat kernel, which is also the side of the
+   *     cells of the seeding grid.
+   * @param maxIterations Maximum number of shifts of each seed (0 for no
+   *     limit).
+   * @param minBinFrequency Smallest number of points in a cell of the seeding
+   *     grid for the cell to give a seed.
+   * @param naive If true, every point is compared with every seed, instead of
+   *     using a tree.
+   * @param leafSize Leaf size of the tree.
+   * @param metric Instantiated distance metric.
+   */
+  MeanShift(const double radius,
+            const size_t maxIterations = 1000,
+            const size_t minBinFrequency = 1,
+            const bool naive = false,
+            const size_t leafSize = 20,
+            const MetricType metric = MetricType());
+
+  /**
+   * Cluster the given dataset.  Clusters are numbered in order of the seeds
+   * they were found from.
+   *
+   * @param data Dataset to cluster.
+   * @param assignments Vector to store the cluster of each point in.
+   * @param centroids Matrix to store the mode of each cluster in.
+   * @return Number of clusters found.
+   */
+  size_t Cluster(const typename TreeType::Mat& data,
+                 arma::Col<size_t>& assignments,
+                 arma::mat& centroids);
+
+  /**
+   * Compute the seeds of the given dataset: the mean of the points in each
+   * cell of a grid with sides equal to the radius that holds at least
+   * minBinFrequency points.  If no cell holds that many points, every point is
+   * a seed.
+   *
+   * @param data Dataset to seed.
+   * @param seeds Matrix to store the seeds in.
+   */
+  void Seeds(const typename TreeType::Mat& data, arma::mat& seeds) const;
+
+  //! Get the radius of the flat kernel.
+  double Radius() const { return radius; }
+  //! Modify the radius of the flat kernel.
+  double& Radius() { return radius; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the smallest number of points in a cell that gives a seed.
+  size_t MinBinFrequency() const { return minBinFrequency; }
+  //! Modify the smallest number of points in a cell that gives a seed.
+  size_t& MinBinFrequency() { return minBinFrequency; }
+
+  //! Get whether naive search is used.
+  bool Naive() const { return naive; }
+  //! Modify whether naive search is used.
+  bool& Naive() { return naive; }
+
+  //! Get the leaf size of the tree.
+  size_t LeafSize() const { return leafSize; }
+  //! Modify the leaf size of the tree.
+  size_t& LeafSize() { return leafSize; }
+
+  //! Get the number of threads used for each range search.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for each range search.  This only has
+  //! an effect if mlpack was compiled with OpenMP.
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the traversal statistics of the last clustering.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+
+  // Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! The radius of the flat kernel.
+  double radius;
+  //! The maximum number of iterations.
+  size_t maxIterations;
+  //! The smallest number of points in a cell that gives a seed.
+  size_t minBinFrequency;
+  //! If true, every point is compared with every seed.
+  bool naive;
+  //! The leaf size of the tree.
+  size_t leafSize;
+  //! Instantiated distance metric.
+  MetricType metric;
+  //! The number of threads used for each range search.
+  size_t numThreads;
+
+  //! The traversal statistics of the last clustering.
+  tree::TraversalStatistics statistics;
+};
+
+}; // namespace meanshift
+}; // namespace mlpack
+
+// Include implementation.
+#include "mean_shift_impl.hpp"
+
+#endif
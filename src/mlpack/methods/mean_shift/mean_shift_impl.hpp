@@ -0,0 +1,353 @@
+/**
+ * @file mean_shift_impl.hpp
+ *
+ * Implementation of the MeanShift class.
+ */
+#ifndef __MLPACK_METHODS_MEAN_SHIFT_MEAN_SHIFT_IMPL_HPP
+#define __MLPACK_METHODS_MEAN_SHIFT_MEAN_SHIFT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mean_shift.hpp"
+
+#include <mlpack/methods/emst/union_find.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#include <map>
+
+namespace mlpack {
+namespace meanshift {
+
+template<typename MetricType, typename TreeType>
+MeanShift<MetricType, TreeType>::MeanShift(const double radius,
+                                           const size_t maxIterations,
+                                           const size_t minBinFrequency,
+                                           const bool naive,
+                                           const size_t leafSize,
+                                           const MetricType metric) :
+    radius(radius),
+    maxIterations(maxIterations),
+    minBinFrequency(minBinFrequency),
+    naive(naive),
+    leafSize(leafSize),
+    metric(metric),
+    numThreads(1)
+{
+  if (radius <= 0.0)
+  {
+    Log::Fatal << "MeanShift::MeanShift(): radius (" << radius << ") must be "
+        << "positive!" << std::endl;
+  }
+}
+
+template<typename MetricType, typename TreeType>
+size_t MeanShift<MetricType, TreeType>::Cluster(
+    const typename TreeType::Mat& data,
+    arma::Col<size_t>& assignments,
+    arma::mat& centroids)
+{
+  statistics.Reset();
+
+  // The tree is built on a copy of the data, because it rearranges the points.
+  // Only the means of the points are needed, so their order does not matter.
+  typename TreeType::Mat dataset(data);
+  TreeType* tree = NULL;
+  if (!naive)
+  {
+    statistics.StartPhase("tree_building");
+    tree = new TreeType(dataset, leafSize);
+    statistics.StopPhase("tree_building");
+  }
+
+  arma::mat seeds;
+  Seeds(data, seeds);
+  const size_t numSeeds = seeds.n_cols;
+  Log::Info << "Shifting " << numSeeds << " seeds." << std::endl;
+
+  // The number of points within the radius of each seed at its last position
+  // (0 if there were none, in which case the seed is dropped), whether it has
+  // converged, and whether it was merged with a mode before converging.
+  std::vector<size_t> seedCounts(numSeeds, 0);
+  std::vector<bool> converged(numSeeds, false);
+  std::vector<bool> merged(numSeeds, false);
+  std::vector<size_t> modes; // The seeds that have converged.
+  emst::UnionFind connections(numSeeds);
+
+  std::vector<size_t> active(numSeeds);
+  for (size_t i = 0; i < numSeeds; ++i)
+    active[i] = i;
+
+  typedef range::RangeSearch<MetricType, TreeType> RangeSearchType;
+  const math::Range range(0.0, radius);
+  const double tolerance = 1e-3 * radius;
+
+  statistics.StartPhase("shifting");
+  size_t iteration = 0;
+  while (!active.empty() &&
+      (maxIterations == 0 || iteration < maxIterations))
+  {
+    ++iteration;
+
+    arma::mat activeSeeds(seeds.n_rows, active.size());
+    for (size_t i = 0; i < active.size(); ++i)
+      activeSeeds.col(i) = seeds.col(active[i]);
+
+    // Find the points within the radius of every active seed at once.
+    arma::Col<size_t> offsets;
+    arma::Col<size_t> neighbors;
+    arma::vec distances;
+    {
+      RangeSearchType* rangeSearch = naive ?
+          new RangeSearchType(dataset, activeSeeds, true, false, metric) :
+          new RangeSearchType(tree, NULL, dataset, activeSeeds, true, metric);
+      rangeSearch->NumThreads() = numThreads;
+      rangeSearch->Search(range, offsets, neighbors, distances);
+      statistics += rangeSearch->Statistics();
+      delete rangeSearch;
+    }
+
+    // Move each seed to the mean of its points.
+    std::vector<size_t> stillActive;
+    std::vector<size_t> newModes;
+    arma::vec mean(seeds.n_rows);
+    for (size_t i = 0; i < active.size(); ++i)
+    {
+      const size_t seed = active[i];
+      seedCounts[seed] = offsets[i + 1] - offsets[i];
+      if (seedCounts[seed] == 0)
+        continue;
+
+      mean.zeros();
+      for (size_t j = offsets[i]; j < offsets[i + 1]; ++j)
+        mean += dataset.col(neighbors[j]);
+      mean /= seedCounts[seed];
+
+      const double shift = metric.Evaluate(mean, seeds.col(seed));
+      seeds.col(seed) = mean;
+
+      if (shift < tolerance)
+      {
+        converged[seed] = true;
+        newModes.push_back(seed);
+      }
+      else
+      {
+        stillActive.push_back(seed);
+      }
+    }
+    modes.insert(modes.end(), newModes.begin(), newModes.end());
+
+    // Any seed that is now within the radius of a mode would end at it, so it
+    // is merged with the closest such mode and is not shifted again.
+    active.clear();
+    if (!modes.empty() && !stillActive.empty())
+    {
+      arma::mat modeSeeds(seeds.n_rows, modes.size());
+      for (size_t i = 0; i < modes.size(); ++i)
+        modeSeeds.col(i) = seeds.col(modes[i]);
+      arma::mat movingSeeds(seeds.n_rows, stillActive.size());
+      for (size_t i = 0; i < stillActive.size(); ++i)
+        movingSeeds.col(i) = seeds.col(stillActive[i]);
+
+      RangeSearchType modeSearch(modeSeeds, movingSeeds, naive, false, metric);
+      std::vector<std::vector<size_t> > modeNeighbors;
+      std::vector<std::vector<double> > modeDistances;
+      modeSearch.Search(range, modeNeighbors, modeDistances);
+
+      for (size_t i = 0; i < stillActive.size(); ++i)
+      {
+        if (modeNeighbors[i].empty())
+        {
+          active.push_back(stillActive[i]);
+          continue;
+        }
+
+        size_t closest = 0;
+        for (size_t j = 1; j < modeNeighbors[i].size(); ++j)
+          if (modeDistances[i][j] < modeDistances[i][closest])
+            closest = j;
+
+        connections.Union(stillActive[i], modes[modeNeighbors[i][closest]]);
+        merged[stillActive[i]] = true;
+      }
+    }
+    else
+    {
+      active = stillActive;
+    }
+
+    Log::Debug << "Mean shift iteration " << iteration << ": "
+        << newModes.size() << " seeds converged, " << active.size()
+        << " still moving." << std::endl;
+  }
+  statistics.StopPhase("shifting");
+
+  if (!naive)
+    delete tree;
+
+  if (!active.empty())
+  {
+    Log::Warn << "MeanShift::Cluster(): " << active.size() << " seeds did not "
+        << "converge in " << maxIterations << " iterations." << std::endl;
+  }
+
+  // Merge the modes (and the seeds that did not converge) that are within the
+  // radius of each other.
+  std::vector<size_t> valid;
+  for (size_t i = 0; i < numSeeds; ++i)
+    if (seedCounts[i] > 0 && !merged[i])
+      valid.push_back(i);
+
+  if (valid.empty())
+  {
+    Log::Fatal << "MeanShift::Cluster(): no seed has any point within the "
+        << "radius (" << radius << ")!" << std::endl;
+  }
+
+  {
+    arma::mat validSeeds(seeds.n_rows, valid.size());
+    for (size_t i = 0; i < valid.size(); ++i)
+      validSeeds.col(i) = seeds.col(valid[i]);
+
+    RangeSearchType mergeSearch(validSeeds, naive, false, metric);
+    std::vector<std::vector<size_t> > mergeNeighbors;
+    std::vector<std::vector<double> > mergeDistances;
+    mergeSearch.Search(range, mergeNeighbors, mergeDistances);
+
+    for (size_t i = 0; i < valid.size(); ++i)
+      for (size_t j = 0; j < mergeNeighbors[i].size(); ++j)
+        connections.Union(valid[i], valid[mergeNeighbors[i][j]]);
+  }
+
+  // The centroid of each cluster is its converged seed with the most points in
+  // its radius (or its seed with the most points, if none converged).
+  std::vector<size_t> representative(numSeeds, numSeeds);
+  for (size_t i = 0; i < numSeeds; ++i)
+  {
+    if (seedCounts[i] == 0)
+      continue;
+
+    const size_t root = connections.Find(i);
+    const size_t current = representative[root];
+    if (current == numSeeds ||
+        (converged[i] && !converged[current]) ||
+        (converged[i] == converged[current] &&
+         seedCounts[i] > seedCounts[current]))
+      representative[root] = i;
+  }
+
+  // Number the clusters in order of their lowest seed.
+  std::vector<size_t> clusterSeeds;
+  std::vector<bool> numbered(numSeeds, false);
+  for (size_t i = 0; i < numSeeds; ++i)
+  {
+    const size_t root = connections.Find(i);
+    if (seedCounts[i] > 0 && !numbered[root])
+    {
+      numbered[root] = true;
+      clusterSeeds.push_back(representative[root]);
+    }
+  }
+
+  const size_t numClusters = clusterSeeds.size();
+  centroids.set_size(seeds.n_rows, numClusters);
+  for (size_t i = 0; i < numClusters; ++i)
+    centroids.col(i) = seeds.col(clusterSeeds[i]);
+
+  Log::Info << "Found " << numClusters << " clusters in " << iteration
+      << " iterations." << std::endl;
+
+  // Each point belongs to its closest centroid.
+  statistics.StartPhase("assignment");
+  {
+    neighbor::NeighborSearch<neighbor::NearestNeighborSort, MetricType> knn(
+        centroids, data, naive, false, metric);
+    arma::Mat<size_t> closest;
+    arma::mat closestDistances;
+    knn.Search(1, closest, closestDistances);
+    assignments = trans(closest.row(0));
+  }
+  statistics.StopPhase("assignment");
+
+  return numClusters;
+}
+
+template<typename MetricType, typename TreeType>
+void MeanShift<MetricType, TreeType>::Seeds(
+    const typename TreeType::Mat& data,
+    arma::mat& seeds) const
+{
+  // Find the cell of each point.
+  std::map<std::vector<long>, size_t> cellIndices;
+  std::vector<size_t> cells(data.n_cols);
+  std::vector<long> cell(data.n_rows);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t d = 0; d < data.n_rows; ++d)
+      cell[d] = (long) std::floor(data(d, i) / radius);
+
+    std::map<std::vector<long>, size_t>::const_iterator it =
+        cellIndices.find(cell);
+    if (it == cellIndices.end())
+    {
+      const size_t index = cellIndices.size();
+      cellIndices[cell] = index;
+      cells[i] = index;
+    }
+    else
+    {
+      cells[i] = it->second;
+    }
+  }
+
+  // Sum the points of each cell.
+  arma::mat sums(data.n_rows, cellIndices.size());
+  sums.zeros();
+  arma::Col<size_t> counts(cellIndices.size());
+  counts.zeros();
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    sums.col(cells[i]) += data.col(i);
+    ++counts[cells[i]];
+  }
+
+  size_t numSeeds = 0;
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    if (counts[i] >= minBinFrequency)
+      ++numSeeds;
+
+  if (numSeeds == 0)
+  {
+    Log::Warn << "MeanShift::Seeds(): no cell holds " << minBinFrequency
+        << " points; every point is used as a seed." << std::endl;
+    seeds = data;
+    return;
+  }
+
+  seeds.set_size(data.n_rows, numSeeds);
+  size_t seed = 0;
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    if (counts[i] >= minBinFrequency)
+      seeds.col(seed++) = sums.col(i) / counts[i];
+}
+
+template<typename MetricType, typename TreeType>
+std::string MeanShift<MetricType, TreeType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "MeanShift [" << this << "]" << std::endl;
+  convert << "  Radius: " << radius << std::endl;
+  convert << "  Maximum iterations: " << maxIterations << std::endl;
+  convert << "  Minimum bin frequency: " << minBinFrequency << std::endl;
+  if (naive)
+    convert << "  Naive: TRUE" << std::endl;
+  else
+    convert << "  Leaf size: " << leafSize << std::endl;
+  convert << "  Metric: " << std::endl <<
+      mlpack::util::Indent(metric.ToString(), 2);
+  return convert.str();
+}
+
+}; // namespace meanshift
+}; // namespace mlpack
+
+#endif
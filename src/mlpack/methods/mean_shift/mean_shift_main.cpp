@@ -0,0 +1,107 @@
+/**
+ * @file mean_shift_main.cpp
+ *
+ * Executable for running mean shift clustering on a dataset.
+ */
+#include <mlpack/core.hpp>
+
+#include "mean_shift.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::meanshift;
+
+PROGRAM_INFO("Mean shift clustering",
+    "This program clusters the points of a dataset with mean shift: seeds are "
+    "repeatedly moved to the mean of the points within --radius (-R) of them, "
+    "until they stop moving at the modes of the density of the dataset, and "
+    "each point is then assigned to the closest mode.  Modes within the radius "
+    "of each other are merged."
+    "\n\n"
+    "The seeds are the means of the points in each cell of a grid with sides "
+    "equal to the radius that holds at least --min_bin_frequency (-b) points. "
+    "Each iteration shifts every seed that is still moving with a single range "
+    "search on a kd-tree; seeds that have converged, or that have come within "
+    "the radius of a mode, are not searched for again."
+    "\n\n"
+    "The cluster of each point is saved to --output_file (-o), one label per "
+    "line, and the modes can be saved with --centroid_file (-C).");
+
+PARAM_STRING_REQ("input_file", "Input dataset to cluster.", "i");
+PARAM_STRING("output_file", "File to save the cluster of each point to.", "o",
+    "assignments.csv");
+PARAM_STRING("centroid_file", "If specified, save the mode of each cluster to "
+    "this file.", "C", "");
+
+PARAM_DOUBLE_REQ("radius", "Radius of the flat kernel.", "R");
+PARAM_INT("max_iterations", "Maximum number of shifts of each seed (0 for no "
+    "limit).", "m", 1000);
+PARAM_INT("min_bin_frequency", "Smallest number of points in a cell of the "
+    "seeding grid for it to give a seed.", "b", 1);
+
+PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
+PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string inputFile = CLI::GetParam<string>("input_file");
+  const string outputFile = CLI::GetParam<string>("output_file");
+  const string centroidFile = CLI::GetParam<string>("centroid_file");
+  const double radius = CLI::GetParam<double>("radius");
+
+  // Sanity checks on the parameters.
+  if (radius <= 0.0)
+  {
+    Log::Fatal << "Invalid radius: " << radius << ".  Must be greater than 0."
+        << endl;
+  }
+
+  if (CLI::GetParam<int>("max_iterations") < 0)
+  {
+    Log::Fatal << "Invalid maximum number of iterations: "
+        << CLI::GetParam<int>("max_iterations") << ".  Must be greater than "
+        << "or equal to 0." << endl;
+  }
+  const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
+
+  if (CLI::GetParam<int>("min_bin_frequency") < 1)
+  {
+    Log::Fatal << "Invalid minimum bin frequency: "
+        << CLI::GetParam<int>("min_bin_frequency") << ".  Must be greater than "
+        << "0." << endl;
+  }
+  const size_t minBinFrequency =
+      (size_t) CLI::GetParam<int>("min_bin_frequency");
+
+  if (CLI::GetParam<int>("leaf_size") <= 0)
+  {
+    Log::Fatal << "Invalid leaf size: " << CLI::GetParam<int>("leaf_size")
+        << ".  Must be greater than 0." << endl;
+  }
+  const size_t leafSize = (size_t) CLI::GetParam<int>("leaf_size");
+
+  arma::mat dataset;
+  data::Load(inputFile, dataset, true);
+
+  MeanShift<> meanShift(radius, maxIterations, minBinFrequency,
+      CLI::HasParam("naive"), leafSize);
+  meanShift.NumThreads() = CLI::HasParam("threads") ? util::NumThreads() : 1;
+
+  arma::Col<size_t> assignments;
+  arma::mat centroids;
+  Timer::Start("clustering");
+  const size_t clusters = meanShift.Cluster(dataset, assignments, centroids);
+  Timer::Stop("clustering");
+  meanShift.Statistics().Print();
+
+  Log::Info << "Found " << clusters << " clusters." << endl;
+
+  // Save the labels as one column.
+  arma::Mat<size_t> output = trans(assignments);
+  data::Save(outputFile, output);
+
+  if (centroidFile != "")
+    data::Save(centroidFile, centroids);
+}
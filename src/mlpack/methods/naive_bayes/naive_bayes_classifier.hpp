@@ -37,6 +37,20 @@ namespace naive_bayes /** The Naive Bayes Classifier. */ {
  *
  * nbc.Classify(testing_data, results);
  * @endcode
+ *
+ * The model can also be updated with new points, with Train(), without
+ * visiting the old points again: the number of points of each class is kept,
+ * and the means and variances of the new points are merged into those of the
+ * model with the pairwise update of Chan, Golub and LeVeque, which is
+ * numerically stable.  In the same way, models trained on parts of a dataset
+ * (for instance, in parallel) can be combined with Merge(); the result is the
+ * same as that of training on the whole dataset, up to rounding.
+ *
+ * @code
+ * NaiveBayesClassifier<> nbc(dimensionality, classes);
+ * while (...) // Each new batch of points.
+ *   nbc.Train(batch, batchLabels);
+ * @endcode
  */
 template<typename MatType = arma::mat>
 class NaiveBayesClassifier
@@ -51,6 +65,21 @@ class NaiveBayesClassifier
   //! Class probabilities.
   arma::vec probabilities;
 
+  //! Number of training points of each class.
+  arma::vec counts;
+
+  /**
+   * Merge the statistics of a set of points into the model, and update the
+   * class probabilities.
+   *
+   * @param otherCounts Number of points of each class.
+   * @param otherMeans Sample mean of the points of each class.
+   * @param otherVariances Sample variance of the points of each class.
+   */
+  void MergeStatistics(const arma::vec& otherCounts,
+                       const MatType& otherMeans,
+                       const MatType& otherVariances);
+
  public:
   /**
    * Initializes the classifier as per the input and then trains it by
@@ -77,9 +106,58 @@ class NaiveBayesClassifier
                        const size_t classes,
                        const bool incrementalVariance = false);
 
+  /**
+   * Initializes the classifier and trains it on a dataset that is read a chunk
+   * at a time, so that the dataset never has to be held in memory.  The labels
+   * are taken to be the last row of each chunk, and must be between 0 and
+   * the number of classes minus one.  The incremental algorithm is used to
+   * calculate the variance, so the model is the same as the one given by the
+   * other constructor with incrementalVariance set to true.
+   *
+   * @param reader Reader for the file holding the training points and labels.
+   * @param classes Number of classes in this classifier.
+   * @param chunkSize Number of points to read at a time.
+   */
+  NaiveBayesClassifier(data::ChunkReader& reader,
+                       const size_t classes,
+                       const size_t chunkSize = 100000);
+
+  /**
+   * Initializes an empty classifier, which has seen no training points; it is
+   * trained with Train() (or Merge()).
+   *
+   * @param dimensionality Number of features of the points.
+   * @param classes Number of classes in this classifier.
+   */
+  NaiveBayesClassifier(const size_t dimensionality, const size_t classes);
+
+  /**
+   * Train the classifier on the given points.  If incremental is true, the
+   * points are added to those the model has already been trained on (without
+   * visiting those again); otherwise the model is trained on the given points
+   * only.  The labels must be between 0 and the number of classes minus one.
+   *
+   * @param data Training data points.
+   * @param labels Labels corresponding to training data points.
+   * @param incremental Whether or not to keep the current model.
+   */
+  void Train(const MatType& data,
+             const arma::Col<size_t>& labels,
+             const bool incremental = true);
+
+  /**
+   * Merge another model, with the same dimensionality and number of classes,
+   * into this one.  The result is the model of the training points of both.
+   *
+   * @param other Model to merge into this one.
+   */
+  void Merge(const NaiveBayesClassifier& other);
+
   /**
    * Given a bunch of data points, this function evaluates the class of each of
-   * those data points, and puts it in the vector 'results'.
+   * those data points, and puts it in the vector 'results'.  The joint
+   * probabilities are compared in log space, and the points are classified in
+   * parallel, in blocks.
    *
    * @code
    * arma::mat test_data; // each column is a test point
@@ -107,6 +185,10 @@ class NaiveBayesClassifier
   const arma::vec& Probabilities() const { return probabilities; }
   //! Modify the prior probabilities for each class.
   arma::vec& Probabilities() { return probabilities; }
+
+  //! Get the number of training points of each class.  Train() and Merge()
+  //! recompute the prior probabilities from these.
+  const arma::vec& Counts() const { return counts; }
 };
 
 }; // namespace naive_bayes
@@ -97,9 +97,202 @@ NaiveBayesClassifier<MatType>::NaiveBayesClassifier(
     if (variances[i] == 0.0)
       variances[i] = 1e-50;
 
+  counts = probabilities;
   probabilities /= data.n_cols;
 }
 
+template<typename MatType>
+NaiveBayesClassifier<MatType>::NaiveBayesClassifier(
+    data::ChunkReader& reader,
+    const size_t classes,
+    const size_t chunkSize)
+{
+  size_t points = 0;
+  arma::Mat<typename MatType::elem_type> chunk;
+  while (reader.Read(chunk, chunkSize))
+  {
+    if (points == 0)
+    {
+      if (chunk.n_rows < 2)
+        Log::Fatal << "NaiveBayesClassifier::NaiveBayesClassifier(): the "
+            << "dataset must have at least one feature and the labels."
+            << std::endl;
+
+      probabilities.zeros(classes);
+      means.zeros(chunk.n_rows - 1, classes);
+      variances.zeros(chunk.n_rows - 1, classes);
+    }
+
+    // Use the incremental algorithm, since there is only one pass.
+    for (size_t j = 0; j < chunk.n_cols; ++j)
+    {
+      const double labelValue = chunk(chunk.n_rows - 1, j);
+      const size_t label = (size_t) labelValue;
+      if (labelValue < 0 || label >= classes || labelValue != (double) label)
+        Log::Fatal << "NaiveBayesClassifier::NaiveBayesClassifier(): invalid "
+            << "label " << labelValue << " for point " << (points + j) << "."
+            << std::endl;
+
+      ++probabilities[label];
+
+      arma::Col<typename MatType::elem_type> delta =
+          chunk.col(j).rows(0, chunk.n_rows - 2) - means.col(label);
+      means.col(label) += delta / probabilities[label];
+      variances.col(label) += delta % (chunk.col(j).rows(0, chunk.n_rows - 2) -
+          means.col(label));
+    }
+
+    points += chunk.n_cols;
+  }
+
+  if (reader.Failed() || points == 0)
+    Log::Fatal << "NaiveBayesClassifier::NaiveBayesClassifier(): could not "
+        << "read the dataset." << std::endl;
+
+  Log::Info << "Trained Naive Bayes classifier on " << points << " examples "
+      << "with " << means.n_rows << " features each." << std::endl;
+
+  for (size_t i = 0; i < classes; ++i)
+  {
+    if (probabilities[i] > 2)
+      variances.col(i) /= (probabilities[i] - 1);
+  }
+
+  // Ensure that the variances are invertible.
+  for (size_t i = 0; i < variances.n_elem; ++i)
+    if (variances[i] == 0.0)
+      variances[i] = 1e-50;
+
+  counts = probabilities;
+  probabilities /= points;
+}
+
+template<typename MatType>
+NaiveBayesClassifier<MatType>::NaiveBayesClassifier(
+    const size_t dimensionality,
+    const size_t classes)
+{
+  probabilities.zeros(classes);
+  counts.zeros(classes);
+  means.zeros(dimensionality, classes);
+  variances.zeros(dimensionality, classes);
+}
+
+template<typename MatType>
+void NaiveBayesClassifier<MatType>::Train(const MatType& data,
+                                          const arma::Col<size_t>& labels,
+                                          const bool incremental)
+{
+  if (data.n_rows != means.n_rows)
+    Log::Fatal << "NaiveBayesClassifier::Train(): the points have "
+        << data.n_rows << " features, but the model has " << means.n_rows
+        << "!" << std::endl;
+
+  if (labels.n_elem != data.n_cols)
+    Log::Fatal << "NaiveBayesClassifier::Train(): there are " << data.n_cols
+        << " points, but " << labels.n_elem << " labels!" << std::endl;
+
+  if (!incremental)
+  {
+    probabilities.zeros();
+    counts.zeros();
+    means.zeros();
+    variances.zeros();
+  }
+
+  Log::Info << "Training Naive Bayes classifier on " << data.n_cols
+      << " new examples with " << data.n_rows << " features each." << std::endl;
+
+  // The statistics of the new points are computed with the two-pass
+  // algorithm, and then merged into the model.
+  const size_t classes = counts.n_elem;
+  arma::vec batchCounts = arma::zeros<arma::vec>(classes);
+  MatType batchMeans;
+  MatType batchVariances;
+  batchMeans.zeros(data.n_rows, classes);
+  batchVariances.zeros(data.n_rows, classes);
+
+  for (size_t j = 0; j < data.n_cols; ++j)
+  {
+    const size_t label = labels[j];
+    if (label >= classes)
+      Log::Fatal << "NaiveBayesClassifier::Train(): invalid label " << label
+          << " for point " << j << "." << std::endl;
+
+    ++batchCounts[label];
+    batchMeans.col(label) += data.col(j);
+  }
+
+  for (size_t i = 0; i < classes; ++i)
+    if (batchCounts[i] != 0.0)
+      batchMeans.col(i) /= batchCounts[i];
+
+  for (size_t j = 0; j < data.n_cols; ++j)
+  {
+    const size_t label = labels[j];
+    batchVariances.col(label) += square(data.col(j) - batchMeans.col(label));
+  }
+
+  for (size_t i = 0; i < classes; ++i)
+    if (batchCounts[i] > 1)
+      batchVariances.col(i) /= (batchCounts[i] - 1);
+
+  MergeStatistics(batchCounts, batchMeans, batchVariances);
+}
+
+template<typename MatType>
+void NaiveBayesClassifier<MatType>::Merge(const NaiveBayesClassifier& other)
+{
+  if ((other.means.n_rows != means.n_rows) ||
+      (other.counts.n_elem != counts.n_elem))
+    Log::Fatal << "NaiveBayesClassifier::Merge(): the other model has "
+        << other.means.n_rows << " features and " << other.counts.n_elem
+        << " classes, but this one has " << means.n_rows << " features and "
+        << counts.n_elem << " classes!" << std::endl;
+
+  MergeStatistics(other.counts, other.means, other.variances);
+}
+
+template<typename MatType>
+void NaiveBayesClassifier<MatType>::MergeStatistics(
+    const arma::vec& otherCounts,
+    const MatType& otherMeans,
+    const MatType& otherVariances)
+{
+  for (size_t i = 0; i < counts.n_elem; ++i)
+  {
+    if (otherCounts[i] == 0.0)
+      continue;
+
+    // The sums of the squared deviations from the means of both sets of points
+    // are merged, and then normalized again.
+    const double total = counts[i] + otherCounts[i];
+    const arma::vec delta = otherMeans.col(i) - means.col(i);
+    arma::vec scatter = ((counts[i] * otherCounts[i]) / total) *
+        arma::square(delta);
+    if (counts[i] > 1)
+      scatter += (counts[i] - 1) * variances.col(i);
+    if (otherCounts[i] > 1)
+      scatter += (otherCounts[i] - 1) * otherVariances.col(i);
+
+    means.col(i) += (otherCounts[i] / total) * delta;
+    if (total > 1)
+      variances.col(i) = scatter / (total - 1);
+    else
+      variances.col(i).zeros();
+    counts[i] = total;
+  }
+
+  // Ensure that the variances are invertible.
+  for (size_t i = 0; i < variances.n_elem; ++i)
+    if (variances[i] == 0.0)
+      variances[i] = 1e-50;
+
+  const double points = arma::accu(counts);
+  if (points > 0)
+    probabilities = counts / points;
+}
+
 template<typename MatType>
 void NaiveBayesClassifier<MatType>::Classify(const MatType& data,
                                              arma::Col<size_t>& results)
@@ -108,46 +301,53 @@ void NaiveBayesClassifier<MatType>::Classify(const MatType& data,
   // training data.
   Log::Assert(data.n_rows == means.n_rows);
 
-  arma::vec probs = arma::log(probabilities);
-  arma::mat invVar = 1.0 / variances;
-
-  arma::mat testProbs = arma::repmat(probs.t(), data.n_cols, 1);
-
   results.set_size(data.n_cols); // No need to fill with anything yet.
 
   Log::Info << "Running Naive Bayes classifier on " << data.n_cols
       << " data points with " << data.n_rows << " features each." << std::endl;
 
-  // Calculate the joint probability for each of the data points for each of the
-  // means.n_cols.
+  // This is an adaptation of gmm::phi() for the case where the covariance is
+  // a diagonal matrix.  The log of the joint probability of a point x and
+  // class i is
+  //   log P(Y = i) - (d / 2) log(2 pi) - (1 / 2) log |Sigma_i| -
+  //       (1 / 2) (x - mu_i)^T Sigma_i^{-1} (x - mu_i),
+  // so all but the quadratic form is precomputed for each class.  Working in
+  // log space, the terms of points far from a mean never underflow.
+  const arma::mat invVar = 1.0 / variances;
+  const arma::vec logNormalizers = arma::log(probabilities) -
+      ((double) data.n_rows / 2.0) * std::log(2 * M_PI) -
+      0.5 * arma::trans(arma::sum(arma::log(variances), 0));
 
-  // Loop over every class.
-  for (size_t i = 0; i < means.n_cols; i++)
-  {
-    // This is an adaptation of gmm::phi() for the case where the covariance is
-    // a diagonal matrix.
-    arma::mat diffs = data - arma::repmat(means.col(i), 1, data.n_cols);
-    arma::mat rhs = -0.5 * arma::diagmat(invVar.col(i)) * diffs;
-    arma::vec exponents(diffs.n_cols);
-    for (size_t j = 0; j < diffs.n_cols; ++j)
-      exponents(j) = std::exp(arma::accu(diffs.col(j) % rhs.unsafe_col(j)));
-
-    testProbs.col(i) += log(pow(2 * M_PI, (double) data.n_rows / -2.0) *
-        pow(det(arma::diagmat(invVar.col(i))), -0.5) * exponents);
-  }
+  // The points are split into blocks, which are classified in parallel; the
+  // quadratic forms of the points of a block are one matrix-vector product
+  // for each class.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (data.n_cols + blockSize - 1) / blockSize;
 
-  // Now calculate the label.
-  for (size_t i = 0; i < data.n_cols; ++i)
+  #pragma omp parallel for schedule(static)
+  for (size_t b = 0; b < numBlocks; ++b)
   {
-    // Find the index of the class with maximum probability for this point.
-    arma::uword maxIndex = 0;
-    arma::vec pointProbs = testProbs.row(i).t();
-    pointProbs.max(maxIndex);
+    const size_t begin = b * blockSize;
+    const size_t end = std::min((size_t) data.n_cols, begin + blockSize);
 
-    results[i] = maxIndex;
-  }
+    arma::mat logProbs(means.n_cols, end - begin);
+    arma::mat diffs;
+    for (size_t i = 0; i < means.n_cols; ++i)
+    {
+      diffs = data.cols(begin, end - 1);
+      diffs.each_col() -= means.col(i);
+      logProbs.row(i) = logNormalizers[i] - 0.5 *
+          (arma::trans(invVar.col(i)) * arma::square(diffs));
+    }
 
-  return;
+    // Find the index of the class with maximum probability for each point.
+    for (size_t j = begin; j < end; ++j)
+    {
+      arma::uword maxIndex = 0;
+      logProbs.col(j - begin).max(maxIndex);
+      results[j] = maxIndex;
+    }
+  }
 }
 
 }; // namespace naive_bayes
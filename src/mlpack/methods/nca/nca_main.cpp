@@ -59,7 +59,13 @@ PROGRAM_INFO("Neighborhood Components Analysis (NCA)",
     "documentation (in lbfgs.hpp) or the vast set of published literature on "
     "L-BFGS.\n"
     "\n"
-    "By default, the SGD optimizer is used.");
+    "By default, the SGD optimizer is used.\n"
+    "\n"
+    "For large datasets, the sums over all pairs of points can be truncated to "
+    "the k nearest neighbors of each point (in the space of the current "
+    "distance), with --neighbors (-k); the neighbors are found with a tree, "
+    "which is rebuilt periodically.  This makes each evaluation O(n k) instead "
+    "of O(n^2).");
 
 PARAM_STRING_REQ("input_file", "Input dataset to run NCA on.", "i");
 PARAM_STRING_REQ("output_file", "Output file for learned distance matrix.",
@@ -80,6 +86,7 @@ PARAM_DOUBLE("step_size", "Step size for stochastic gradient descent (alpha).",
     "a", 0.01);
 PARAM_FLAG("linear_scan", "Don't shuffle the order in which data points are "
     "visited for SGD.", "L");
+PARAM_INT("batch_size", "Number of points in each mini-batch of SGD.", "b", 1);
 
 PARAM_INT("num_basis", "Number of memory points to be stored for L-BFGS.", "B",
     5);
@@ -90,6 +97,9 @@ PARAM_INT("max_line_search_trials", "Maximum number of line search trials for "
 PARAM_DOUBLE("min_step", "Minimum step of line search for L-BFGS.", "m", 1e-20);
 PARAM_DOUBLE("max_step", "Maximum step of line search for L-BFGS.", "M", 1e20);
 
+PARAM_INT("neighbors", "If nonzero, truncate the sums of the objective to this "
+    "many nearest neighbors of each point.", "k", 0);
+
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 
 
@@ -156,6 +166,10 @@ int main(int argc, char* argv[])
     if (CLI::HasParam("linear_scan"))
       Log::Warn << "Parameter --linear_scan ignored (not using 'sgd' "
           << "optimizer)." << std::endl;
+
+    if (CLI::HasParam("batch_size"))
+      Log::Warn << "Parameter --batch_size ignored (not using 'sgd' "
+          << "optimizer)." << std::endl;
   }
 
   const double stepSize = CLI::GetParam<double>("step_size");
@@ -163,12 +177,19 @@ int main(int argc, char* argv[])
   const double tolerance = CLI::GetParam<double>("tolerance");
   const bool normalize = CLI::HasParam("normalize");
   const bool shuffle = !CLI::HasParam("linear_scan");
+  const int batchSize = CLI::GetParam<int>("batch_size");
+  if (batchSize <= 0)
+    Log::Fatal << "Batch size (" << batchSize << ") must be positive!" << endl;
   const int numBasis = CLI::GetParam<int>("num_basis");
   const double armijoConstant = CLI::GetParam<double>("armijo_constant");
   const double wolfe = CLI::GetParam<double>("wolfe");
   const int maxLineSearchTrials = CLI::GetParam<int>("max_line_search_trials");
   const double minStep = CLI::GetParam<double>("min_step");
   const double maxStep = CLI::GetParam<double>("max_step");
+  const int neighbors = CLI::GetParam<int>("neighbors");
+  if (neighbors < 0)
+    Log::Fatal << "Number of neighbors (" << neighbors << ") must be "
+        << "non-negative!" << endl;
 
   // Load data.
   arma::mat data;
@@ -222,17 +243,19 @@ int main(int argc, char* argv[])
   // Now create the NCA object and run the optimization.
   if (optimizerType == "sgd")
   {
-    NCA<LMetric<2> > nca(data, labels);
+    NCA<LMetric<2> > nca(data, labels, LMetric<2>(), (size_t) neighbors);
     nca.Optimizer().StepSize() = stepSize;
     nca.Optimizer().MaxIterations() = maxIterations;
     nca.Optimizer().Tolerance() = tolerance;
     nca.Optimizer().Shuffle() = shuffle;
+    nca.Optimizer().BatchSize() = (size_t) batchSize;
 
     nca.LearnDistance(distance);
   }
   else if (optimizerType == "lbfgs")
   {
-    NCA<LMetric<2>, L_BFGS> nca(data, labels);
+    NCA<LMetric<2>, L_BFGS> nca(data, labels, LMetric<2>(),
+        (size_t) neighbors);
     nca.Optimizer().NumBasis() = numBasis;
     nca.Optimizer().MaxIterations() = maxIterations;
     nca.Optimizer().ArmijoConstant() = armijoConstant;
@@ -9,6 +9,12 @@
 #define __MLPACK_METHODS_NCA_NCA_SOFTMAX_ERROR_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/parallel_sum/parallel_sum.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace nca {
@@ -31,7 +37,30 @@ namespace nca {
  * In addition to the standard Evaluate() and Gradient() functions which MLPACK
  * optimizers use, overloads of Evaluate() and Gradient() are given which only
  * operate on one point in the dataset.  This is useful for optimizers like
- * stochastic gradient descent (see mlpack::optimization::SGD).
+ * stochastic gradient descent (see mlpack::optimization::SGD).  The stretched
+ * dataset they use is kept until the coordinates change, so consecutive
+ * evaluations at the same coordinates (such as the evaluations of SGD after
+ * each step and the gradient of the next step) stretch it only once.  A
+ * mini-batch Gradient() is also given, which sums the terms of a batch of
+ * points in parallel.
+ *
+ * The O(n^2) pairwise sums of the non-separable Evaluate() and Gradient() are
+ * computed in parallel, over blocks of points (see
+ * mlpack::optimization::ParallelSum()), so the metric's Evaluate() is called
+ * from several threads at once.
+ *
+ * If a number of neighbors k is given, the sums over k of p_ik are truncated
+ * to the k nearest neighbors of each point i in the stretched space, so each
+ * evaluation takes O(n k) time (and each gradient O(n k d^2)) instead of
+ * O(n^2).  The neighbors are found with a tree (see
+ * mlpack::neighbor::NeighborSearch), and are searched for again once the
+ * function has been evaluated at rebuildInterval * n points since the last
+ * search (a non-separable evaluation counts as n points).  Since the terms
+ * left out are no larger than that of the furthest neighbor kept, the
+ * truncated part of each denominator is at most (n - 1 - k) times that term;
+ * the largest such bound relative to the denominator is given by
+ * TruncationBound().  The neighbors are nearest in the Euclidean sense, so the
+ * truncation is meant for the default squared Euclidean metric.
  */
 template<typename MetricType = metric::SquaredEuclideanDistance>
 class SoftmaxErrorFunction
@@ -46,10 +75,16 @@ class SoftmaxErrorFunction
    * @param dataset Matrix containing the dataset.
    * @param labels Vector of class labels for each point in the dataset.
    * @param kernel Instantiated kernel (optional).
+   * @param neighbors Number of nearest neighbors to truncate the sums to (0
+   *     means all the points are used).
+   * @param rebuildInterval Number of passes over the dataset between searches
+   *     for the nearest neighbors.
    */
   SoftmaxErrorFunction(const arma::mat& dataset,
                        const arma::Col<size_t>& labels,
-                       MetricType metric = MetricType());
+                       MetricType metric = MetricType(),
+                       const size_t neighbors = 0,
+                       const size_t rebuildInterval = 10);
 
   /**
    * Evaluate the softmax function for the given covariance matrix.  This is the
@@ -97,6 +132,22 @@ class SoftmaxErrorFunction
                 const size_t i,
                 arma::mat& gradient);
 
+  /**
+   * Evaluate the sum of the gradients of the softmax function for the given
+   * covariance matrix on the points begin through (begin + batchSize - 1).
+   * The points share one stretched dataset, and their terms are computed in
+   * parallel.  This is used by mlpack::optimization::SGD for mini-batches.
+   *
+   * @param covariance Covariance matrix of Mahalanobis distance.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   * @param gradient Matrix to store the calculated gradient in.
+   */
+  void Gradient(const arma::mat& covariance,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient) const;
+
   /**
    * Get the initial point.
    */
@@ -108,6 +159,14 @@ class SoftmaxErrorFunction
    */
   size_t NumFunctions() const { return dataset.n_cols; }
 
+  //! Get the number of neighbors the sums are truncated to (0 for none).
+  size_t Neighbors() const { return neighbors; }
+  //! Get the number of passes over the dataset between neighbor searches.
+  size_t RebuildInterval() const { return rebuildInterval; }
+  //! Get the largest bound on the truncated part of a denominator, relative to
+  //! the denominator, in the last non-separable evaluation.
+  double TruncationBound() const { return truncationBound; }
+
   // convert the obkect into a string
   std::string ToString() const;
 
@@ -117,13 +176,18 @@ class SoftmaxErrorFunction
   //! Labels for each point in the dataset.
   const arma::Col<size_t>& labels;
 
-  //! The instantiated metric.
-  MetricType metric;
+  //! The instantiated metric.  Some metrics don't declare Evaluate() const,
+  //! although it does not change them, so the const pairwise sums need this to
+  //! be mutable.
+  mutable MetricType metric;
 
   //! Last coordinates.  Used for the non-separable Evaluate() and Gradient().
   arma::mat lastCoordinates;
-  //! Stretched dataset.  Kept internal to avoid memory reallocations.
-  arma::mat stretchedDataset;
+  //! Stretched dataset.  Kept internal to avoid memory reallocations, and
+  //! reused while the coordinates do not change.
+  mutable arma::mat stretchedDataset;
+  //! The coordinates the dataset was last stretched with.
+  mutable arma::mat stretchedCoordinates;
   //! Holds calculated p_i, for the non-separable Evaluate() and Gradient().
   arma::vec p;
   //! Holds denominators for calculation of p_ij, for the non-separable
@@ -133,6 +197,18 @@ class SoftmaxErrorFunction
   //! False if nothing has ever been precalculated (only at construction time).
   bool precalculated;
 
+  //! Number of nearest neighbors the sums are truncated to (0 for none).
+  size_t neighbors;
+  //! Number of passes over the dataset between neighbor searches.
+  size_t rebuildInterval;
+  //! The nearest neighbors of each point (one column for each point).  Like
+  //! the stretched dataset, this is a cache, so it is mutable.
+  mutable arma::Mat<size_t> neighborIndices;
+  //! The number of points evaluated since the last neighbor search.
+  mutable size_t evaluations;
+  //! The bound on the truncated part of the denominators.
+  double truncationBound;
+
   /**
    * Precalculate the denominators and numerators that will make up the p_ij,
    * but only if the coordinates matrix is different than the last coordinates
@@ -147,6 +223,66 @@ class SoftmaxErrorFunction
    * @param coordinates Coordinates matrix to use for precalculation.
    */
   void Precalculate(const arma::mat& coordinates);
+
+  /**
+   * Stretch the dataset with the given coordinates, unless it was last
+   * stretched with the same coordinates.
+   *
+   * @param coordinates Coordinates matrix to stretch the dataset with.
+   */
+  void Stretch(const arma::mat& coordinates) const;
+
+  /**
+   * Add the pairwise terms of the denominators and numerators of p_i for the
+   * pairs (i, k) with begin <= i < end and k > i, with the stretched dataset,
+   * to the first and second columns of the given matrix.  Returns 0.
+   */
+  double PrecalculateBlock(const arma::mat& coordinates,
+                           const size_t begin,
+                           const size_t end,
+                           arma::mat& sums) const;
+
+  /**
+   * Add the terms of the gradient sum for the pairs (i, k) with
+   * begin <= i < end and k > i to the given matrix, using the precalculated p_i
+   * and denominators.  Returns 0.
+   */
+  double GradientBlock(const arma::mat& coordinates,
+                       const size_t begin,
+                       const size_t end,
+                       arma::mat& sum) const;
+
+  /**
+   * Search for the nearest neighbors of each point again if they have not been
+   * found yet or if rebuildInterval passes have been made since the last
+   * search, and then count the given number of points as evaluated.
+   *
+   * @param coordinates Coordinates matrix to stretch the dataset with.
+   * @param count Number of points to count as evaluated.
+   */
+  void UpdateNeighbors(const arma::mat& coordinates,
+                       const size_t count) const;
+
+  /**
+   * Add the term p_i sum_k (p_ik x_ik x_ik^T) -
+   * sum_{k in class of i} (p_ik x_ik x_ik^T) of the separable gradient of
+   * point i to the given matrix, using the stretched dataset (or, if the sums
+   * are truncated, the neighbors of i).  Returns false, and adds nothing, if
+   * the denominator of p_i is 0.
+   */
+  bool PointGradient(const arma::mat& coordinates,
+                     const size_t i,
+                     arma::mat& sum) const;
+
+  /**
+   * Add the terms of the gradient sum for the neighbors of the points
+   * begin <= i < end to the given matrix, using the precalculated p_i and
+   * denominators.  Returns 0.
+   */
+  double NeighborGradientBlock(const arma::mat& coordinates,
+                               const size_t begin,
+                               const size_t end,
+                               arma::mat& sum) const;
 };
 
 }; // namespace nca
@@ -18,11 +18,17 @@ template<typename MetricType>
 SoftmaxErrorFunction<MetricType>::SoftmaxErrorFunction(
     const arma::mat& dataset,
     const arma::Col<size_t>& labels,
-    MetricType metric) :
+    MetricType metric,
+    const size_t neighbors,
+    const size_t rebuildInterval) :
     dataset(dataset),
     labels(labels),
     metric(metric),
-    precalculated(false)
+    precalculated(false),
+    neighbors(neighbors),
+    rebuildInterval(rebuildInterval),
+    evaluations(0),
+    truncationBound(0.0)
 { /* nothing to do */ }
 
 //! The non-separable implementation, which uses Precalculate() to save time.
@@ -46,24 +52,50 @@ double SoftmaxErrorFunction<MetricType>::Evaluate(const arma::mat& coordinates,
   double denominator = 0;
   double numerator = 0;
 
-  // It's quicker to do this now than one point at a time later.
-  stretchedDataset = coordinates * dataset;
+  if (neighbors > 0)
+  {
+    // Only the nearest neighbors of the point are used, so only they need to
+    // be stretched; column 0 of stretchedPoints holds the point itself.
+    UpdateNeighbors(coordinates, 1);
+    arma::mat points(dataset.n_rows, neighborIndices.n_rows + 1);
+    points.col(0) = dataset.col(i);
+    for (size_t t = 0; t < neighborIndices.n_rows; ++t)
+      points.col(t + 1) = dataset.col(neighborIndices(t, i));
+    const arma::mat stretchedPoints = coordinates * points;
+
+    for (size_t t = 0; t < neighborIndices.n_rows; ++t)
+    {
+      double eval = std::exp(-metric.Evaluate(stretchedPoints.unsafe_col(0),
+          stretchedPoints.unsafe_col(t + 1)));
 
-  for (size_t k = 0; k < dataset.n_cols; ++k)
+      if (labels[i] == labels[neighborIndices(t, i)])
+        numerator += eval;
+
+      denominator += eval;
+    }
+  }
+  else
   {
-    // Don't consider the case where the points are the same.
-    if (k == i)
-      continue;
+    // It's quicker to do this now than one point at a time later; the
+    // stretched dataset is kept while the coordinates do not change.
+    Stretch(coordinates);
 
-    // We want to evaluate exp(-D(A x_i, A x_k)).
-    double eval = std::exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                            stretchedDataset.unsafe_col(k)));
+    for (size_t k = 0; k < dataset.n_cols; ++k)
+    {
+      // Don't consider the case where the points are the same.
+      if (k == i)
+        continue;
 
-    // If they are in the same
-    if (labels[i] == labels[k])
-      numerator += eval;
+      // We want to evaluate exp(-D(A x_i, A x_k)).
+      double eval = std::exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+                                              stretchedDataset.unsafe_col(k)));
 
-    denominator += eval;
+      // If they are in the same
+      if (labels[i] == labels[k])
+        numerator += eval;
+
+      denominator += eval;
+    }
   }
 
   // Now the result is just a simple division, but we have to be sure that the
@@ -98,29 +130,18 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
   //     (((p_i - (1 / p_i)) p_ik) + ((p_k - (1 / p_k)) p_ki)) x_ik x_ik^T
   //   otherwise, add
   //     (p_i p_ik + p_k p_ki) x_ik x_ik^T
-  arma::mat sum;
-  sum.zeros(stretchedDataset.n_rows, stretchedDataset.n_rows);
-  for (size_t i = 0; i < stretchedDataset.n_cols; i++)
-  {
-    for (size_t k = (i + 1); k < stretchedDataset.n_cols; k++)
-    {
-      // Calculate p_ik and p_ki first.
-      double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                         stretchedDataset.unsafe_col(k)));
-      double p_ik = 0, p_ki = 0;
-      p_ik = eval / denominators(i);
-      p_ki = eval / denominators(k);
-
-      // Subtract x_i from x_k.  We are not using stretched points here.
-      arma::vec x_ik = dataset.col(i) - dataset.col(k);
-      arma::mat secondTerm = (x_ik * trans(x_ik));
-
-      if (labels[i] == labels[k])
-        sum += ((p[i] - 1) * p_ik + (p[k] - 1) * p_ki) * secondTerm;
-      else
-        sum += (p[i] * p_ik + p[k] * p_ki) * secondTerm;
-    }
-  }
+  // The rows i are split into small blocks, since the work for each i shrinks
+  // as i grows.
+  // With truncated sums, each point i only adds the terms of its neighbors:
+  //   ((p_i - [class of i is the class of k]) p_ik) x_ik x_ik^T.
+  arma::mat sum(stretchedDataset.n_rows, stretchedDataset.n_rows);
+  if (neighbors > 0)
+    optimization::ParallelSum(*this,
+        &SoftmaxErrorFunction::NeighborGradientBlock, coordinates,
+        stretchedDataset.n_cols, sum, 256);
+  else
+    optimization::ParallelSum(*this, &SoftmaxErrorFunction::GradientBlock,
+        coordinates, stretchedDataset.n_cols, sum, 16);
 
   // Assemble the final gradient.
   gradient = -2 * coordinates * sum;
@@ -132,68 +153,83 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
                                                 const size_t i,
                                                 arma::mat& gradient)
 {
-  // We will need to calculate p_i before this evaluation is done, so these two
-  // variables will hold the information necessary for that.
-  double numerator = 0;
-  double denominator = 0;
+  // Find the stretched dataset (or, if the sums are truncated, the neighbors
+  // of the point) that the term of the point is computed with.
+  if (neighbors > 0)
+    UpdateNeighbors(coordinates, 1);
+  else
+    Stretch(coordinates);
 
-  // The gradient involves two matrix terms which are eventually combined into
-  // one.
-  arma::mat firstTerm;
-  arma::mat secondTerm;
+  arma::mat sum = arma::zeros<arma::mat>(coordinates.n_cols,
+      coordinates.n_cols);
+  if (!PointGradient(coordinates, i, sum))
+  {
+    // If the denominator is zero, then all p_ik should be zero and there is
+    // no gradient contribution from this point.
+    Log::Warn << "Denominator of p_" << i << " is 0!" << std::endl;
+    gradient.zeros(coordinates.n_rows, coordinates.n_rows);
+    return;
+  }
 
-  firstTerm.zeros(coordinates.n_rows, coordinates.n_cols);
-  secondTerm.zeros(coordinates.n_rows, coordinates.n_cols);
+  // Multiply by 2 * A.  We negate it though, because our optimizer is a
+  // minimizer.
+  gradient = -2 * coordinates * sum;
+}
 
-  // Compute the stretched dataset.
-  stretchedDataset = coordinates * dataset;
+//! The mini-batch implementation.
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
+                                                const size_t begin,
+                                                const size_t batchSize,
+                                                arma::mat& gradient) const
+{
+  // All the points of the batch use the same stretched dataset (or
+  // neighbors), so it is only computed once.
+  if (neighbors > 0)
+    UpdateNeighbors(coordinates, batchSize);
+  else
+    Stretch(coordinates);
 
-  for (size_t k = 0; k < dataset.n_cols; ++k)
-  {
-    // Don't consider the case where the points are the same.
-    if (i == k)
-      continue;
+  size_t numThreads = 1;
+#ifdef HAS_OPENMP
+  numThreads = std::max((size_t) 1, std::min(batchSize,
+      (size_t) omp_get_max_threads()));
+#endif
 
-    // Calculate the numerator of p_ik.
-    double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                       stretchedDataset.unsafe_col(k)));
+  // Each thread sums the terms of its points into its own accumulator, and
+  // the accumulators are added in thread order at the end.
+  std::vector<arma::mat> threadSums(numThreads);
+  std::vector<size_t> threadFailures(numThreads, 0);
+  for (size_t t = 0; t < numThreads; ++t)
+    threadSums[t].zeros(coordinates.n_cols, coordinates.n_cols);
 
-    // If the points are in the same class, we must add to the second term of
-    // the gradient as well as the numerator of p_i.  We will divide by the
-    // denominator of p_ik later.  For x_ik we are not using stretched points.
-    arma::vec x_ik = dataset.col(i) - dataset.col(k);
-    if (labels[i] == labels[k])
-    {
-      numerator += eval;
-      secondTerm += eval * x_ik * trans(x_ik);
-    }
+  #pragma omp parallel num_threads(numThreads) if (numThreads > 1)
+  {
+    size_t thread = 0;
+#ifdef HAS_OPENMP
+    thread = (size_t) omp_get_thread_num();
+#endif
 
-    // We always have to add to the denominator of p_i and the first term of the
-    // gradient computation.  We will divide by the denominator of p_ik later.
-    denominator += eval;
-    firstTerm += eval * x_ik * trans(x_ik);
+    #pragma omp for schedule(static, 1)
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      if (!PointGradient(coordinates, i, threadSums[thread]))
+        ++threadFailures[thread];
   }
 
-  // Calculate p_i.
-  double p = 0;
-  if (denominator == 0)
-  {
-    Log::Warn << "Denominator of p_" << i << " is 0!" << std::endl;
-    // If the denominator is zero, then all p_ik should be zero and there is
-    // no gradient contribution from this point.
-    gradient.zeros(coordinates.n_rows, coordinates.n_rows);
-    return;
-  }
-  else
+  arma::mat sum = threadSums[0];
+  size_t failures = threadFailures[0];
+  for (size_t t = 1; t < numThreads; ++t)
   {
-    p = numerator / denominator;
-    firstTerm /= denominator;
-    secondTerm /= denominator;
+    sum += threadSums[t];
+    failures += threadFailures[t];
   }
 
-  // Now multiply the first term by p_i, and add the two together and multiply
-  // all by 2 * A.  We negate it though, because our optimizer is a minimizer.
-  gradient = -2 * coordinates * (p * firstTerm - secondTerm);
+  // Points with a zero denominator make no contribution to the gradient.
+  if (failures > 0)
+    Log::Warn << "Denominators of p_i for " << failures << " points of the "
+        << "batch are 0!" << std::endl;
+
+  gradient = -2 * coordinates * sum;
 }
 
 template<typename MetricType>
@@ -206,6 +242,10 @@ template<typename MetricType>
 void SoftmaxErrorFunction<MetricType>::Precalculate(
     const arma::mat& coordinates)
 {
+  // The separable functions may have stretched the dataset with other
+  // coordinates since the last precalculation.
+  Stretch(coordinates);
+
   // Ensure it is the right size.
   lastCoordinates.set_size(coordinates.n_rows, coordinates.n_cols);
 
@@ -214,19 +254,91 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
       precalculated)
     return; // No need to calculate; we already have this stuff saved.
 
-  // Coordinates are different; save the new ones, and stretch the dataset.
+  // Coordinates are different; save the new ones.
   lastCoordinates = coordinates;
-  stretchedDataset = coordinates * dataset;
 
   // For each point i, we must evaluate the softmax function:
   //   p_ij = exp( -K(x_i, x_j) ) / ( sum_{k != i} ( exp( -K(x_i, x_k) )))
   //   p_i = sum_{j in class of i} p_ij
   // We will do this by keeping track of the denominators for each i as well as
   // the numerators (the sum for all j in class of i).  This will be on the
-  // order of O((n * (n + 1)) / 2), which really isn't all that great.
-  p.zeros(stretchedDataset.n_cols);
-  denominators.zeros(stretchedDataset.n_cols);
+  // order of O((n * (n + 1)) / 2), which really isn't all that great,
+  // unless the sums are truncated to the neighbors of each point.
+  if (neighbors > 0)
+  {
+    // Each p_i is summed over the neighbors of i only; the points are
+    // independent, so they are computed in parallel.
+    UpdateNeighbors(coordinates, stretchedDataset.n_cols);
+    denominators.set_size(stretchedDataset.n_cols);
+    p.set_size(stretchedDataset.n_cols);
+    arma::vec bounds(stretchedDataset.n_cols);
+
+    const size_t remainder = stretchedDataset.n_cols - 1 -
+        neighborIndices.n_rows;
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < stretchedDataset.n_cols; i++)
+    {
+      double denominator = 0, numerator = 0;
+      double smallest = 1.0;
+      for (size_t t = 0; t < neighborIndices.n_rows; t++)
+      {
+        const size_t j = neighborIndices(t, i);
+        const double eval = exp(-metric.Evaluate(
+            stretchedDataset.unsafe_col(i), stretchedDataset.unsafe_col(j)));
+
+        denominator += eval;
+        if (labels[i] == labels[j])
+          numerator += eval;
+        smallest = std::min(smallest, eval);
+      }
+
+      denominators[i] = denominator;
+      p[i] = numerator / denominator;
+      bounds[i] = (denominator > 0) ? remainder * smallest / denominator : 0;
+    }
+
+    truncationBound = (bounds.n_elem > 0) ? bounds.max() : 0.0;
+    Log::Debug << "SoftmaxErrorFunction: truncated denominators are within a "
+        << "relative " << truncationBound << " of the full sums." << std::endl;
+  }
+  else
+  {
+    // The pairs are summed in parallel, in small blocks of rows i.
+    arma::mat sums(stretchedDataset.n_cols, 2);
+    optimization::ParallelSum(*this, &SoftmaxErrorFunction::PrecalculateBlock,
+        coordinates, stretchedDataset.n_cols, sums, 16);
+    denominators = sums.col(0);
+
+    // Divide p_i by their denominators.
+    p = sums.col(1) / denominators;
+  }
+
+  // Clean up any bad values.
   for (size_t i = 0; i < stretchedDataset.n_cols; i++)
+  {
+    if (denominators[i] == 0.0)
+    {
+      Log::Debug << "Denominator of p_{" << i << ", j} is 0." << std::endl;
+
+      // Set to usable values.
+      denominators[i] = std::numeric_limits<double>::infinity();
+      p[i] = 0;
+    }
+  }
+
+  // We've done a precalculation.  Mark it as done.
+  precalculated = true;
+}
+
+template<typename MetricType>
+double SoftmaxErrorFunction<MetricType>::PrecalculateBlock(
+    const arma::mat& /* coordinates */,
+    const size_t begin,
+    const size_t end,
+    arma::mat& sums) const
+{
+  for (size_t i = begin; i < end; i++)
   {
     for (size_t j = (i + 1); j < stretchedDataset.n_cols; j++)
     {
@@ -235,36 +347,192 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
                                          stretchedDataset.unsafe_col(j)));
 
       // Add this to the denominators of both p_i and p_j: K(i, j) = K(j, i).
-      denominators[i] += eval;
-      denominators[j] += eval;
+      sums(i, 0) += eval;
+      sums(j, 0) += eval;
 
       // If i and j are the same class, add to numerator of both.
       if (labels[i] == labels[j])
       {
-        p[i] += eval;
-        p[j] += eval;
+        sums(i, 1) += eval;
+        sums(j, 1) += eval;
       }
     }
   }
 
-  // Divide p_i by their denominators.
-  p /= denominators;
+  return 0.0;
+}
 
-  // Clean up any bad values.
-  for (size_t i = 0; i < stretchedDataset.n_cols; i++)
+template<typename MetricType>
+double SoftmaxErrorFunction<MetricType>::GradientBlock(
+    const arma::mat& /* coordinates */,
+    const size_t begin,
+    const size_t end,
+    arma::mat& sum) const
+{
+  for (size_t i = begin; i < end; i++)
   {
-    if (denominators[i] == 0.0)
+    for (size_t k = (i + 1); k < stretchedDataset.n_cols; k++)
     {
-      Log::Debug << "Denominator of p_{" << i << ", j} is 0." << std::endl;
+      // Calculate p_ik and p_ki first.
+      double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+                                         stretchedDataset.unsafe_col(k)));
+      double p_ik = 0, p_ki = 0;
+      p_ik = eval / denominators(i);
+      p_ki = eval / denominators(k);
 
-      // Set to usable values.
-      denominators[i] = std::numeric_limits<double>::infinity();
-      p[i] = 0;
+      // Subtract x_i from x_k.  We are not using stretched points here.
+      arma::vec x_ik = dataset.col(i) - dataset.col(k);
+      arma::mat secondTerm = (x_ik * trans(x_ik));
+
+      if (labels[i] == labels[k])
+        sum += ((p[i] - 1) * p_ik + (p[k] - 1) * p_ki) * secondTerm;
+      else
+        sum += (p[i] * p_ik + p[k] * p_ki) * secondTerm;
     }
   }
 
-  // We've done a precalculation.  Mark it as done.
-  precalculated = true;
+  return 0.0;
+}
+
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::Stretch(
+    const arma::mat& coordinates) const
+{
+  if ((stretchedCoordinates.n_rows == coordinates.n_rows) &&
+      (stretchedCoordinates.n_cols == coordinates.n_cols) &&
+      (accu(coordinates == stretchedCoordinates) == coordinates.n_elem))
+    return; // The dataset is already stretched with these coordinates.
+
+  stretchedCoordinates = coordinates;
+  stretchedDataset = coordinates * dataset;
+}
+
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::UpdateNeighbors(
+    const arma::mat& coordinates,
+    const size_t count) const
+{
+  if ((neighborIndices.n_cols != dataset.n_cols) ||
+      (evaluations >= rebuildInterval * dataset.n_cols))
+  {
+    // The tree is built on the stretched dataset; the point itself is not
+    // returned as one of its neighbors.
+    Stretch(coordinates);
+    neighbor::AllkNN search(stretchedDataset);
+    arma::mat distances;
+    search.Search(std::min(neighbors, (size_t) dataset.n_cols - 1),
+        neighborIndices, distances);
+
+    evaluations = 0;
+  }
+
+  evaluations += count;
+}
+
+template<typename MetricType>
+double SoftmaxErrorFunction<MetricType>::NeighborGradientBlock(
+    const arma::mat& /* coordinates */,
+    const size_t begin,
+    const size_t end,
+    arma::mat& sum) const
+{
+  // The terms of the neighbors of each point are one weighted outer product of
+  // the differences.
+  arma::mat differences(dataset.n_rows, neighborIndices.n_rows);
+  arma::vec weights(neighborIndices.n_rows);
+
+  for (size_t i = begin; i < end; i++)
+  {
+    for (size_t t = 0; t < neighborIndices.n_rows; t++)
+    {
+      const size_t k = neighborIndices(t, i);
+      const double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+                                               stretchedDataset.unsafe_col(k)));
+      const double p_ik = eval / denominators(i);
+
+      if (labels[i] == labels[k])
+        weights[t] = (p[i] - 1) * p_ik;
+      else
+        weights[t] = p[i] * p_ik;
+
+      // We are not using stretched points here.
+      differences.col(t) = dataset.col(i) - dataset.col(k);
+    }
+
+    sum += differences * arma::diagmat(weights) * arma::trans(differences);
+  }
+
+  return 0.0;
+}
+
+template<typename MetricType>
+bool SoftmaxErrorFunction<MetricType>::PointGradient(
+    const arma::mat& coordinates,
+    const size_t i,
+    arma::mat& sum) const
+{
+  // The candidates for k are all the points, or, if the sums are truncated,
+  // the neighbors of i; then only the point (in column 0) and its neighbors
+  // are stretched.
+  const size_t numCandidates = (neighbors > 0) ? neighborIndices.n_rows :
+      dataset.n_cols;
+  arma::mat stretchedPoints;
+  if (neighbors > 0)
+  {
+    arma::mat points(dataset.n_rows, numCandidates + 1);
+    points.col(0) = dataset.col(i);
+    for (size_t t = 0; t < numCandidates; ++t)
+      points.col(t + 1) = dataset.col(neighborIndices(t, i));
+    stretchedPoints = coordinates * points;
+  }
+  const arma::mat& stretched = (neighbors > 0) ? stretchedPoints :
+      stretchedDataset;
+  const size_t self = (neighbors > 0) ? 0 : i;
+  const size_t offset = (neighbors > 0) ? 1 : 0;
+
+  // Calculate the numerators of p_ik, and the numerator and denominator of
+  // p_i.  For x_ik we are not using stretched points.
+  arma::vec evals(numCandidates);
+  arma::mat differences(dataset.n_rows, numCandidates);
+  double numerator = 0;
+  double denominator = 0;
+  for (size_t t = 0; t < numCandidates; ++t)
+  {
+    const size_t k = (neighbors > 0) ? neighborIndices(t, i) : t;
+
+    // Don't consider the case where the points are the same.
+    if (k == i)
+    {
+      evals[t] = 0;
+      differences.col(t).zeros();
+      continue;
+    }
+
+    evals[t] = exp(-metric.Evaluate(stretched.unsafe_col(self),
+                                    stretched.unsafe_col(t + offset)));
+    differences.col(t) = dataset.col(i) - dataset.col(k);
+
+    if (labels[i] == labels[k])
+      numerator += evals[t];
+    denominator += evals[t];
+  }
+
+  if (denominator == 0)
+    return false;
+
+  // The term is p_i sum_k (p_ik x_ik x_ik^T) -
+  // sum_{k in class of i} (p_ik x_ik x_ik^T), which is one weighted outer
+  // product of the differences.
+  const double p = numerator / denominator;
+  for (size_t t = 0; t < numCandidates; ++t)
+  {
+    const size_t k = (neighbors > 0) ? neighborIndices(t, i) : t;
+    const double p_ik = evals[t] / denominator;
+    evals[t] = (labels[i] == labels[k]) ? (p - 1) * p_ik : p * p_ik;
+  }
+
+  sum += differences * arma::diagmat(evals) * arma::trans(differences);
+  return true;
 }
 
 template<typename MetricType>
@@ -276,6 +544,7 @@ std::string SoftmaxErrorFunction<MetricType>::ToString() const{
   convert << "  Labels: " << labels.n_elem << std::endl;
   //convert << "Metric: " << metric << std::endl;
   convert << "  Precalculated: " << precalculated << std::endl;
+  convert << "  Neighbors: " << neighbors << std::endl;
   return convert.str();
 }
 
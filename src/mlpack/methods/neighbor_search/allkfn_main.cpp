@@ -40,8 +40,8 @@ PROGRAM_INFO("All K-Furthest-Neighbors",
     "corresponds to the distance between those two points.");
 
 // Define our input parameters that this program will take.
-PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
-    "r");
+PARAM_STRING("reference_file", "File containing the reference dataset (not "
+    "needed if --load_tree is given).", "r", "");
 PARAM_INT_REQ("k", "Number of furthest neighbors to find.", "k");
 PARAM_STRING_REQ("distances_file", "File to output distances into.", "d");
 PARAM_STRING_REQ("neighbors_file", "File to output neighbors into.", "n");
@@ -54,6 +54,16 @@ PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "s");
 PARAM_FLAG("r_tree", "If true, use an R-Tree to perform the search "
     "(experimental, may be slow.).", "T");
+PARAM_DOUBLE("epsilon", "Relative error allowed in tree-based searches; if "
+    "greater than 0, the search is approximate, and each kth neighbor distance "
+    "returned is at least the true kth furthest neighbor distance divided by "
+    "(1 + epsilon).", "e", 0.0);
+PARAM_STRING("save_tree", "If specified, the kd-tree built on the reference "
+    "set is saved (along with the reordered reference set) to this file, so "
+    "that it can be reused with --load_tree.", "", "");
+PARAM_STRING("load_tree", "If specified, the reference kd-tree and reference "
+    "set are loaded (memory-mapped) from this file, which was written with "
+    "--save_tree, instead of being built from --reference_file.", "", "");
 
 int main(int argc, char *argv[])
 {
@@ -62,6 +72,8 @@ int main(int argc, char *argv[])
 
   // Get all the parameters.
   string referenceFile = CLI::GetParam<string>("reference_file");
+  const string saveTreeFile = CLI::GetParam<string>("save_tree");
+  const string loadTreeFile = CLI::GetParam<string>("load_tree");
 
   string distancesFile = CLI::GetParam<string>("distances_file");
   string neighborsFile = CLI::GetParam<string>("neighbors_file");
@@ -73,20 +85,60 @@ int main(int argc, char *argv[])
   bool naive = CLI::HasParam("naive");
   bool singleMode = CLI::HasParam("single_mode");
 
+  // Saved trees are kd-trees built on the reference set as it is given.
+  if ((saveTreeFile != "" || loadTreeFile != "") && (naive ||
+      CLI::HasParam("r_tree")))
+  {
+    Log::Fatal << "--save_tree and --load_tree can't be used with --naive or "
+        << "--r_tree." << endl;
+  }
+
   arma::mat referenceData;
   arma::mat queryData; // So it doesn't go out of scope.
-  data::Load(referenceFile, referenceData, true);
 
-  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
-      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
+  // If the reference tree is loaded from a file, the reference set is held by
+  // the MappedTree object.
+  typedef BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<FurthestNeighborSort> > KDTreeType;
+  MappedTree<KDTreeType>* mappedTree = NULL;
+  if (loadTreeFile != "")
+  {
+    if (referenceFile != "")
+      Log::Warn << "--reference_file ignored because --load_tree is present."
+          << endl;
+
+    Timer::Start("tree_loading");
+    mappedTree = new MappedTree<KDTreeType>(loadTreeFile);
+    Timer::Stop("tree_loading");
+
+    Log::Info << "Loaded reference tree and data from '" << loadTreeFile
+        << "' (" << mappedTree->Dataset().n_rows << " x "
+        << mappedTree->Dataset().n_cols << ")." << endl;
+  }
+  else if (referenceFile != "")
+  {
+    data::Load(referenceFile, referenceData, true);
+
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << referenceData.n_rows << " x " << referenceData.n_cols << ")."
+        << endl;
+  }
+  else
+  {
+    Log::Fatal << "Either --reference_file or --load_tree must be specified."
+        << endl;
+  }
+
+  const size_t numReferencePoints = (mappedTree) ?
+      mappedTree->Dataset().n_cols : referenceData.n_cols;
 
   // Sanity check on k value: must be greater than 0, must be less than the
   // number of reference points.
-  if (k > referenceData.n_cols)
+  if (k > numReferencePoints)
   {
     Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
     Log::Fatal << "than or equal to the number of reference points (";
-    Log::Fatal << referenceData.n_cols << ")." << endl;
+    Log::Fatal << numReferencePoints << ")." << endl;
   }
 
   // Sanity check on leaf size.
@@ -97,12 +149,34 @@ int main(int argc, char *argv[])
   }
   size_t leafSize = lsInt;
 
+  // Sanity check on epsilon.
+  const double epsilon = CLI::GetParam<double>("epsilon");
+  if (epsilon < 0)
+  {
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be 0 or greater."
+        << endl;
+  }
+  if (epsilon > 0 && naive)
+    Log::Warn << "--epsilon ignored because --naive is present." << endl;
+
+  // The search is only run with several threads if the global --threads
+  // option is given (which sets the number of OpenMP threads).
+  const size_t numThreads = CLI::HasParam("threads") ? util::NumThreads() : 1;
+
   // Naive mode overrides single mode.
   if (singleMode && naive)
   {
     Log::Warn << "--single_mode ignored because --naive is present." << endl;
   }
 
+  // Naive search and dual-tree search with anything other than kd-trees can't
+  // use multiple threads.
+  if (numThreads > 1 && (naive || (!singleMode && CLI::HasParam("r_tree"))))
+  {
+    Log::Warn << "--threads ignored because it is only used for single-tree "
+        << "search or dual-tree search with kd-trees." << endl;
+  }
+
   if (naive)
     leafSize = referenceData.n_cols;
 
@@ -116,18 +190,30 @@ int main(int argc, char *argv[])
     std::vector<size_t> oldFromNewRefs;
 
     // Build trees by hand, so we can save memory: if we pass a tree to
-    // NeighborSearch, it does not copy the matrix.
-    Log::Info << "Building reference tree..." << endl;
-    Timer::Start("reference_tree_building");
+    // NeighborSearch, it does not copy the matrix.  A loaded reference tree can
+    // be used directly.
+    KDTreeType* refTree = NULL;
+    if (mappedTree)
+    {
+      refTree = &mappedTree->Tree();
+      oldFromNewRefs = mappedTree->OldFromNew();
+    }
+    else
+    {
+      Log::Info << "Building reference tree..." << endl;
+      Timer::Start("reference_tree_building");
 
-    BinarySpaceTree<bound::HRectBound<2>,
-        NeighborSearchStat<FurthestNeighborSort> >
-        refTree(referenceData, oldFromNewRefs, leafSize);
-    BinarySpaceTree<bound::HRectBound<2>,
-        NeighborSearchStat<FurthestNeighborSort> >*
-        queryTree = NULL; // Empty for now.
+      refTree = new KDTreeType(referenceData, oldFromNewRefs, leafSize);
 
-    Timer::Stop("reference_tree_building");
+      Timer::Stop("reference_tree_building");
+    }
+
+    if (saveTreeFile != "" &&
+        MappedTree<KDTreeType>::Save(saveTreeFile, *refTree, oldFromNewRefs))
+      Log::Info << "Saved reference tree to '" << saveTreeFile << "'."
+          << endl;
+
+    KDTreeType* queryTree = NULL; // Empty for now.
 
     std::vector<size_t> oldFromNewQueries;
 
@@ -155,49 +241,52 @@ int main(int argc, char *argv[])
 
       Timer::Stop("query_tree_building");
 
-      allkfn = new AllkFN(&refTree, queryTree, referenceData, queryData,
+      allkfn = new AllkFN(refTree, queryTree, refTree->Dataset(), queryData,
           singleMode);
 
       Log::Info << "Tree built." << endl;
     }
     else
     {
-      allkfn = new AllkFN(&refTree, referenceData, singleMode);
+      allkfn = new AllkFN(refTree, refTree->Dataset(), singleMode);
 
       Log::Info << "Trees built." << endl;
     }
 
     Log::Info << "Computing " << k << " furthest neighbors..." << endl;
+    allkfn->NumThreads() = numThreads;
+    allkfn->Epsilon() = epsilon;
     allkfn->Search(k, neighbors, distances);
 
     Log::Info << "Neighbors computed." << endl;
+    allkfn->Statistics().Print();
 
     // We have to map back to the original indices from before the tree
     // construction.
     Log::Info << "Re-mapping indices..." << endl;
 
-    arma::mat distancesOut(distances.n_rows, distances.n_cols);
-    arma::Mat<size_t> neighborsOut(neighbors.n_rows, neighbors.n_cols);
-
-    // Map the points back to their original locations.
+    // Map the points back to their original locations, in place.
     if ((CLI::GetParam<string>("query_file") != "") && !singleMode)
-      Unmap(neighbors, distances, oldFromNewRefs, oldFromNewQueries, neighborsOut,
-          distancesOut);
+      Unmap(neighbors, distances, oldFromNewRefs, oldFromNewQueries);
     else if ((CLI::GetParam<string>("query_file") != "") && singleMode)
-      Unmap(neighbors, distances, oldFromNewRefs, neighborsOut, distancesOut);
+      Unmap(neighbors, distances, oldFromNewRefs);
     else
-      Unmap(neighbors, distances, oldFromNewRefs, oldFromNewRefs, neighborsOut,
-          distancesOut);
+      Unmap(neighbors, distances, oldFromNewRefs, oldFromNewRefs);
 
     // Clean up.
     if (queryTree)
       delete queryTree;
 
     delete allkfn;
-    
+
+    if (mappedTree)
+      delete mappedTree;
+    else
+      delete refTree;
+
       // Save output.
-  data::Save(distancesFile, distancesOut);
-  data::Save(neighborsFile, neighborsOut);
+  data::Save(distancesFile, distances);
+  data::Save(neighborsFile, neighbors);
     
   } else {  // Use the R tree.
     Log::Info << "Using R tree for furthest-neighbor calculation." << endl;
@@ -273,9 +362,12 @@ int main(int argc, char *argv[])
     //arma::Mat<size_t> neighborsOut;
     
     Log::Info << "Computing " << k << " nearest neighbors..." << endl;
+    allkfn->NumThreads() = numThreads;
+    allkfn->Epsilon() = epsilon;
     allkfn->Search(k, neighbors, distances);
     
     Log::Info << "Neighbors computed." << endl;
+    allkfn->Statistics().Print();
     
     
     if(queryTree)
@@ -13,7 +13,13 @@
 #include <iostream>
 
 #include "neighbor_search.hpp"
+#include "search_tuner.hpp"
 #include "unmap.hpp"
+#include "expand_neighbors.hpp"
+
+#ifdef HAS_CUDA
+  #include <mlpack/core/gpu/knn.hpp>
+#endif
 
 using namespace std;
 using namespace mlpack;
@@ -39,11 +45,31 @@ PROGRAM_INFO("All K-Nearest-Neighbors",
     "neighbors output file corresponds to the index of the point in the "
     "reference set which is the i'th nearest neighbor from the point in the "
     "query set with index j.  Row i and column j in the distances output file "
-    "corresponds to the distance between those two points.");
+    "corresponds to the distance between those two points.  For large "
+    "results, output files with the .mlb extension (mlpack matrix files) are "
+    "much faster to write than text, and hold the neighbors as integers."
+    "\n\n"
+    "If mlpack was compiled with CUDA, --gpu (-g) runs the --naive search on "
+    "the GPU; the datasets are copied to the device in tiles, so they may be "
+    "larger than the device memory."
+    "\n\n"
+    "If --auto is given, the search is chosen automatically: each of naive "
+    "search and single-tree and dual-tree search with kd-trees of several leaf "
+    "sizes, cover trees, and R-trees is timed on a random sample of "
+    "--auto_sample_size points of each dataset, and the one predicted to be "
+    "the fastest on the whole datasets (given the estimated intrinsic "
+    "dimension of the reference set) is run.  The trials and the choice are "
+    "printed with --verbose."
+    "\n\n"
+    "If --deduplicate is given, duplicate points are collapsed before the "
+    "trees are built, and the search is run on the unique points only; the "
+    "results are then expanded back to the original points, so the output is "
+    "the same (up to the order of neighbors at equal distances).  This is much "
+    "faster for datasets with many duplicates.");
 
 // Define our input parameters that this program will take.
-PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
-    "r");
+PARAM_STRING("reference_file", "File containing the reference dataset (not "
+    "needed if --load_tree is given).", "r", "");
 PARAM_STRING_REQ("distances_file", "File to output distances into.", "d");
 PARAM_STRING_REQ("neighbors_file", "File to output neighbors into.", "n");
 
@@ -53,6 +79,8 @@ PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
 
 PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
+PARAM_FLAG("gpu", "If true, the naive search is run on the GPU (use with "
+    "--naive; requires CUDA).", "g");
 PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "S");
 PARAM_FLAG("cover_tree", "If true, use cover trees to perform the search "
@@ -62,6 +90,245 @@ PARAM_FLAG("r_tree", "If true, use an R-Tree to perform the search "
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
 PARAM_INT("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
+PARAM_DOUBLE("epsilon", "Relative error allowed in tree-based searches; if "
+    "greater than 0, the search is approximate, and each kth neighbor distance "
+    "returned is at most (1 + epsilon) times the true kth nearest neighbor "
+    "distance.", "e", 0.0);
+PARAM_STRING("save_tree", "If specified, the kd-tree built on the reference "
+    "set is saved (along with the reordered reference set) to this file, so "
+    "that it can be reused with --load_tree.", "", "");
+PARAM_STRING("load_tree", "If specified, the reference kd-tree and reference "
+    "set are loaded (memory-mapped) from this file, which was written with "
+    "--save_tree, instead of being built from --reference_file.", "", "");
+PARAM_FLAG("auto", "If true, choose between --naive, --single_mode, "
+    "--cover_tree, --r_tree, and --leaf_size automatically, from timed trials "
+    "on a sample of the data.", "");
+PARAM_INT("auto_sample_size", "Number of points of each dataset used for the "
+    "trials of --auto.", "", 2000);
+PARAM_FLAG("deduplicate", "If true, collapse duplicate points before the "
+    "search and expand the results back to the original points afterwards.",
+    "");
+PARAM_INT("query_chunk_size", "If greater than 0, the query points are read "
+    "from --query_file this many at a time, and the results for each chunk are "
+    "written out before the next chunk is read, so the query set never has to "
+    "fit in memory.  Only kd-trees are supported, and the query, distances, "
+    "and neighbors files must be .csv or .txt files.", "", 0);
+
+typedef BinarySpaceTree<bound::HRectBound<2>,
+    NeighborSearchStat<NearestNeighborSort> > KDTreeType;
+typedef CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
+    NeighborSearchStat<NearestNeighborSort> > CoverTreeType;
+typedef RectangleTree<tree::RStarTreeSplit<tree::RStarTreeDescentHeuristic,
+    NeighborSearchStat<NearestNeighborSort>, arma::mat>,
+    tree::RStarTreeDescentHeuristic, NeighborSearchStat<NearestNeighborSort>,
+    arma::mat> RTreeType;
+
+//! Build a kd-tree for a trial of --auto.
+void BuildTree(arma::mat& data, const size_t leafSize, KDTreeType*& tree)
+{
+  std::vector<size_t> oldFromNew;
+  tree = new KDTreeType(data, oldFromNew, leafSize);
+}
+
+//! Build a cover tree for a trial of --auto.
+void BuildTree(arma::mat& data, const size_t /* leafSize */,
+               CoverTreeType*& tree)
+{
+  tree = new CoverTreeType(data, 1.3);
+}
+
+//! Build an R-tree for a trial of --auto.
+void BuildTree(arma::mat& data, const size_t leafSize, RTreeType*& tree)
+{
+  tree = new RTreeType(data, leafSize, leafSize * 0.4, 5, 2, 0);
+}
+
+/**
+ * Runs the candidates of --auto (see SearchTuner): each candidate searches for
+ * the k nearest neighbors, with the same options as the full search will.
+ */
+class KNNTrial
+{
+ public:
+  KNNTrial(const size_t k, const double epsilon, const size_t numThreads) :
+      k(k), epsilon(epsilon), numThreads(numThreads) { }
+
+  void Run(const SearchCandidate& candidate,
+           const arma::mat& referenceSet,
+           const arma::mat* querySet,
+           double& buildTime,
+           double& searchTime)
+  {
+    // The sample may have fewer points than k.
+    const size_t sampleK = std::min(k, (size_t) referenceSet.n_cols - 1);
+
+    switch (candidate.Type())
+    {
+      case SearchCandidate::NAIVE:
+      {
+        buildTime = 0.0;
+        arma::wall_clock timer;
+        timer.tic();
+        arma::Mat<size_t> neighbors;
+        arma::mat distances;
+        if (querySet)
+        {
+          AllkNN allknn(referenceSet, *querySet, true);
+          allknn.Search(sampleK, neighbors, distances);
+        }
+        else
+        {
+          AllkNN allknn(referenceSet, true);
+          allknn.Search(sampleK, neighbors, distances);
+        }
+        searchTime = timer.toc();
+        break;
+      }
+      case SearchCandidate::KD_TREE:
+        RunTrees<KDTreeType>(candidate, sampleK, referenceSet, querySet,
+            buildTime, searchTime);
+        break;
+      case SearchCandidate::COVER_TREE:
+        RunTrees<CoverTreeType>(candidate, sampleK, referenceSet, querySet,
+            buildTime, searchTime);
+        break;
+      case SearchCandidate::R_TREE:
+        RunTrees<RTreeType>(candidate, sampleK, referenceSet, querySet,
+            buildTime, searchTime);
+        break;
+    }
+  }
+
+ private:
+  //! Run a candidate with the given type of tree.
+  template<typename TreeType>
+  void RunTrees(const SearchCandidate& candidate,
+                const size_t sampleK,
+                const arma::mat& referenceSet,
+                const arma::mat* querySet,
+                double& buildTime,
+                double& searchTime)
+  {
+    typedef NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>,
+        TreeType> SearchType;
+
+    // Some trees rearrange the points they are built on.
+    arma::mat referenceCopy(referenceSet);
+    arma::mat queryCopy;
+    if (querySet)
+      queryCopy = *querySet;
+
+    arma::wall_clock timer;
+    timer.tic();
+    TreeType* referenceTree = NULL;
+    TreeType* queryTree = NULL;
+    BuildTree(referenceCopy, candidate.LeafSize(), referenceTree);
+    if (querySet && !candidate.SingleMode())
+      BuildTree(queryCopy, candidate.LeafSize(), queryTree);
+    buildTime = timer.toc();
+
+    timer.tic();
+    SearchType* search = (querySet) ? new SearchType(referenceTree, queryTree,
+        referenceTree->Dataset(), (queryTree) ? queryTree->Dataset() :
+        queryCopy, candidate.SingleMode()) :
+        new SearchType(referenceTree, referenceTree->Dataset(),
+        candidate.SingleMode());
+    search->NumThreads() = numThreads;
+    search->Epsilon() = epsilon;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    search->Search(sampleK, neighbors, distances);
+    searchTime = timer.toc();
+
+    delete search;
+    delete queryTree;
+    delete referenceTree;
+  }
+
+  //! The number of neighbors to find.
+  size_t k;
+  //! The relative error allowed in tree-based searches.
+  double epsilon;
+  //! The number of threads to search with.
+  size_t numThreads;
+};
+
+/**
+ * Find the k nearest neighbors of the points in queryFile, reading chunkSize
+ * query points at a time, and append the results for each chunk to the
+ * distances and neighbors files.  Only one chunk's worth of queries and results
+ * is in memory at any time.
+ */
+void SearchQueryChunks(KDTreeType& referenceTree,
+                       const std::vector<size_t>& oldFromNewReferences,
+                       const string& queryFile,
+                       const string& distancesFile,
+                       const string& neighborsFile,
+                       const size_t k,
+                       const size_t chunkSize,
+                       const size_t leafSize,
+                       const bool naive,
+                       const bool singleMode,
+                       const double epsilon,
+                       const size_t numThreads)
+{
+  data::ChunkReader queryReader(queryFile, true);
+  // The results of each chunk are written while the next one is searched.
+  data::ChunkWriter distancesWriter(distancesFile, true, true);
+  data::ChunkWriter neighborsWriter(neighborsFile, true, true);
+
+  Log::Info << "Computing " << k << " nearest neighbors of the points in '"
+      << queryFile << "', " << chunkSize << " at a time..." << endl;
+
+  arma::mat queryChunk;
+  while (queryReader.Read(queryChunk, chunkSize))
+  {
+    if (queryChunk.n_rows != referenceTree.Dataset().n_rows)
+    {
+      Log::Fatal << "Query points in '" << queryFile << "' have dimensionality "
+          << queryChunk.n_rows << ", but the reference points have "
+          << "dimensionality " << referenceTree.Dataset().n_rows << "."
+          << endl;
+    }
+
+    // The query tree only has to hold this chunk.
+    KDTreeType* queryTree = NULL;
+    std::vector<size_t> oldFromNewQueries;
+    if (!singleMode)
+    {
+      Timer::Start("tree_building");
+      queryTree = new KDTreeType(queryChunk, oldFromNewQueries, (naive) ?
+          std::max(leafSize, (size_t) queryChunk.n_cols) : leafSize);
+      Timer::Stop("tree_building");
+    }
+
+    AllkNN allknn(&referenceTree, queryTree, referenceTree.Dataset(),
+        queryChunk, singleMode);
+    allknn.NumThreads() = numThreads;
+    allknn.Epsilon() = epsilon;
+
+    arma::mat distances;
+    arma::Mat<size_t> neighbors;
+    allknn.Search(k, neighbors, distances);
+    allknn.Statistics().Print();
+
+    // Map the results back to the original indices, in place.
+    if (singleMode)
+      Unmap(neighbors, distances, oldFromNewReferences);
+    else
+      Unmap(neighbors, distances, oldFromNewReferences, oldFromNewQueries);
+
+    distancesWriter.Write(distances);
+    neighborsWriter.Write(neighbors);
+
+    delete queryTree;
+
+    Log::Info << queryReader.PointsRead() << " query points done." << endl;
+  }
+
+  Log::Info << "Neighbors computed." << endl;
+}
 
 int main(int argc, char *argv[])
 {
@@ -76,6 +343,8 @@ int main(int argc, char *argv[])
   // Get all the parameters.
   const string referenceFile = CLI::GetParam<string>("reference_file");
   const string queryFile = CLI::GetParam<string>("query_file");
+  const string saveTreeFile = CLI::GetParam<string>("save_tree");
+  const string loadTreeFile = CLI::GetParam<string>("load_tree");
 
   const string distancesFile = CLI::GetParam<string>("distances_file");
   const string neighborsFile = CLI::GetParam<string>("neighbors_file");
@@ -86,16 +355,125 @@ int main(int argc, char *argv[])
 
   bool naive = CLI::HasParam("naive");
   bool singleMode = CLI::HasParam("single_mode");
+  bool coverTree = CLI::HasParam("cover_tree");
+  bool rTree = CLI::HasParam("r_tree");
   const bool randomBasis = CLI::HasParam("random_basis");
+  const bool autoSelect = CLI::HasParam("auto");
+  const bool deduplicate = CLI::HasParam("deduplicate");
+
+  const bool gpu = CLI::HasParam("gpu");
+  if (gpu && !naive)
+    Log::Fatal << "--gpu can only be used with --naive." << endl;
+  if (gpu && CLI::HasParam("query_chunk_size"))
+    Log::Fatal << "--gpu can't be used with --query_chunk_size." << endl;
+#ifdef HAS_CUDA
+  if (gpu && !gpu::DeviceAvailable())
+    Log::Fatal << "--gpu specified, but no CUDA device was found." << endl;
+#else
+  if (gpu)
+    Log::Fatal << "--gpu requires CUDA, but mlpack was compiled without CUDA "
+        << "support." << endl;
+#endif
+
+  // Sanity check on the query chunk size.
+  if (CLI::GetParam<int>("query_chunk_size") < 0)
+  {
+    Log::Fatal << "Invalid query chunk size: "
+        << CLI::GetParam<int>("query_chunk_size") << ".  Must be 0 or greater."
+        << endl;
+  }
+  size_t queryChunkSize = (size_t) CLI::GetParam<int>("query_chunk_size");
+
+  if (queryChunkSize > 0 && queryFile == "")
+  {
+    Log::Warn << "--query_chunk_size ignored because --query_file is not "
+        << "given." << endl;
+    queryChunkSize = 0;
+  }
+
+  if (queryChunkSize > 0 && (randomBasis || coverTree || rTree))
+  {
+    Log::Fatal << "--query_chunk_size can't be used with --random_basis, "
+        << "--cover_tree, or --r_tree." << endl;
+  }
+
+  // Saved trees are kd-trees built on the reference set as it is given.
+  if ((saveTreeFile != "" || loadTreeFile != "") && (naive || randomBasis ||
+      coverTree || rTree))
+  {
+    Log::Fatal << "--save_tree and --load_tree can't be used with --naive, "
+        << "--random_basis, --cover_tree, or --r_tree." << endl;
+  }
+
+  // The trials of --auto need all the points in memory, and may not pick a
+  // kd-tree.
+  if (autoSelect && (gpu || queryChunkSize > 0 || saveTreeFile != "" ||
+      loadTreeFile != ""))
+  {
+    Log::Fatal << "--auto can't be used with --gpu, --query_chunk_size, "
+        << "--save_tree, or --load_tree." << endl;
+  }
+  if (autoSelect && CLI::GetParam<int>("auto_sample_size") < 20)
+  {
+    Log::Fatal << "Invalid auto sample size: "
+        << CLI::GetParam<int>("auto_sample_size") << ".  Must be at least 20."
+        << endl;
+  }
+  if (autoSelect && (naive || singleMode || coverTree || rTree ||
+      CLI::HasParam("leaf_size")))
+  {
+    Log::Warn << "--naive, --single_mode, --cover_tree, --r_tree, and "
+        << "--leaf_size ignored because --auto is present." << endl;
+    naive = singleMode = coverTree = rTree = false;
+  }
+
+  // The duplicates are found in the whole datasets, in memory.
+  if (deduplicate && (queryChunkSize > 0 || saveTreeFile != "" ||
+      loadTreeFile != ""))
+  {
+    Log::Fatal << "--deduplicate can't be used with --query_chunk_size, "
+        << "--save_tree, or --load_tree." << endl;
+  }
 
   arma::mat referenceData;
   arma::mat queryData; // So it doesn't go out of scope.
-  data::Load(referenceFile, referenceData, true);
 
-  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
-      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
+  // If the reference tree is loaded from a file, the reference set is held by
+  // the MappedTree object.
+  MappedTree<KDTreeType>* mappedTree = NULL;
+  if (loadTreeFile != "")
+  {
+    if (referenceFile != "")
+      Log::Warn << "--reference_file ignored because --load_tree is present."
+          << endl;
+
+    Timer::Start("tree_loading");
+    mappedTree = new MappedTree<KDTreeType>(loadTreeFile);
+    Timer::Stop("tree_loading");
 
-  if (queryFile != "")
+    Log::Info << "Loaded reference tree and data from '" << loadTreeFile
+        << "' (" << mappedTree->Dataset().n_rows << " x "
+        << mappedTree->Dataset().n_cols << ")." << endl;
+  }
+  else if (referenceFile != "")
+  {
+    data::Load(referenceFile, referenceData, true);
+
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << referenceData.n_rows << " x " << referenceData.n_cols << ")."
+        << endl;
+  }
+  else
+  {
+    Log::Fatal << "Either --reference_file or --load_tree must be specified."
+        << endl;
+  }
+
+  const size_t numReferencePoints = (mappedTree) ?
+      mappedTree->Dataset().n_cols : referenceData.n_cols;
+
+  // In chunked mode the query set is read later, a chunk at a time.
+  if (queryFile != "" && queryChunkSize == 0)
   {
     data::Load(queryFile, queryData, true);
     Log::Info << "Loaded query data from '" << queryFile << "' ("
@@ -104,11 +482,11 @@ int main(int argc, char *argv[])
 
   // Sanity check on k value: must be greater than 0, must be less than the
   // number of reference points.  Since it is unsigned, we only test the upper bound.
-  if (k > referenceData.n_cols)
+  if (k > numReferencePoints)
   {
     Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
     Log::Fatal << "than or equal to the number of reference points (";
-    Log::Fatal << referenceData.n_cols << ")." << endl;
+    Log::Fatal << numReferencePoints << ")." << endl;
   }
 
   // Sanity check on leaf size.
@@ -119,6 +497,51 @@ int main(int argc, char *argv[])
   }
   size_t leafSize = lsInt;
 
+  // Collapse the duplicate points, so that the search is run on the unique
+  // points only; the results are expanded back to the original points before
+  // they are saved.
+  data::UniquePoints uniqueReferences, uniqueQueries;
+  const size_t originalK = k;
+  if (deduplicate)
+  {
+    Timer::Start("deduplication");
+    arma::mat uniqueData;
+    uniqueReferences.Find(referenceData);
+    uniqueReferences.Extract(referenceData, uniqueData);
+    referenceData.steal_mem(uniqueData);
+    if (queryFile != "")
+    {
+      uniqueQueries.Find(queryData);
+      uniqueQueries.Extract(queryData, uniqueData);
+      queryData.steal_mem(uniqueData);
+    }
+    Timer::Stop("deduplication");
+
+    Log::Info << uniqueReferences.NumPoints() << " reference points collapsed "
+        << "into " << uniqueReferences.NumUnique() << " unique points." << endl;
+    if (queryFile != "")
+    {
+      Log::Info << uniqueQueries.NumPoints() << " query points collapsed into "
+          << uniqueQueries.NumUnique() << " unique points." << endl;
+    }
+
+    k = UniqueNeighbors(originalK, uniqueReferences, queryFile == "");
+  }
+
+  // Sanity check on epsilon.
+  const double epsilon = CLI::GetParam<double>("epsilon");
+  if (epsilon < 0)
+  {
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be 0 or greater."
+        << endl;
+  }
+  if (epsilon > 0 && naive)
+    Log::Warn << "--epsilon ignored because --naive is present." << endl;
+
+  // The search is only run with several threads if the global --threads
+  // option is given (which sets the number of OpenMP threads).
+  const size_t numThreads = CLI::HasParam("threads") ? util::NumThreads() : 1;
+
   // Naive mode overrides single mode.
   if (singleMode && naive)
   {
@@ -126,13 +549,19 @@ int main(int argc, char *argv[])
   }
  
    // cover_tree overrides r_tree.
-  if (CLI::HasParam("cover_tree") && CLI::HasParam("r_tree"))
+  if (coverTree && rTree)
   {
     Log::Warn << "--cover_tree overrides --r_tree." << endl;
   }
   
-  if (naive)
-    leafSize = referenceData.n_cols;
+  // Naive search and dual-tree search with anything other than kd-trees can't
+  // use multiple threads.
+  const bool otherTree = coverTree || rTree;
+  if (numThreads > 1 && (naive || (!singleMode && otherTree)))
+  {
+    Log::Warn << "--threads ignored because it is only used for single-tree "
+        << "search or dual-tree search with kd-trees." << endl;
+  }
 
   // See if we want to project onto a random basis.
   if (randomBasis)
@@ -171,12 +600,50 @@ int main(int argc, char *argv[])
     }
   }
 
+  // Pick the search with timed trials on a sample of the (projected) points.
+  if (autoSelect)
+  {
+    Timer::Start("auto_selection");
+    SearchTuner tuner(referenceData, queryData,
+        (size_t) CLI::GetParam<int>("auto_sample_size"));
+    KNNTrial trial(k, epsilon, numThreads);
+    const vector<SearchCandidate> candidates = tuner.Candidates(true);
+    const SearchCandidate& best = candidates[tuner.Select(trial, candidates)];
+    Timer::Stop("auto_selection");
+
+    naive = (best.Type() == SearchCandidate::NAIVE);
+    singleMode = best.SingleMode();
+    coverTree = (best.Type() == SearchCandidate::COVER_TREE);
+    rTree = (best.Type() == SearchCandidate::R_TREE);
+    leafSize = best.LeafSize();
+  }
+
+  if (naive)
+    leafSize = referenceData.n_cols;
+
   arma::Mat<size_t> neighbors;
   arma::mat distances;
 
-  if (!CLI::HasParam("cover_tree"))
+  if (gpu)
   {
-    if(!CLI::HasParam("r_tree"))
+#ifdef HAS_CUDA
+    Log::Info << "Computing " << k << " nearest neighbors on the GPU..."
+        << endl;
+    Timer::Start("gpu_search");
+    if (queryFile != "")
+      gpu::KNearestNeighbors(queryData, referenceData, k, neighbors,
+          distances);
+    else
+      gpu::KNearestNeighbors(referenceData, referenceData, k, neighbors,
+          distances, true);
+    Timer::Stop("gpu_search");
+
+    Log::Info << "Neighbors computed." << endl;
+#endif
+  }
+  else if (!coverTree)
+  {
+    if (!rTree)
     {
       // Because we may construct it differently, we need a pointer.
       AllkNN* allknn = NULL;
@@ -185,83 +652,109 @@ int main(int argc, char *argv[])
       std::vector<size_t> oldFromNewRefs;
 
       // Build trees by hand, so we can save memory: if we pass a tree to
-      // NeighborSearch, it does not copy the matrix.
-      Log::Info << "Building reference tree..." << endl;
-      Timer::Start("tree_building");
+      // NeighborSearch, it does not copy the matrix.  A loaded reference tree
+      // can be used directly.
+      KDTreeType* refTree = NULL;
+      if (mappedTree)
+      {
+        refTree = &mappedTree->Tree();
+        oldFromNewRefs = mappedTree->OldFromNew();
+      }
+      else
+      {
+        Log::Info << "Building reference tree..." << endl;
+        Timer::Start("tree_building");
 
-      BinarySpaceTree<bound::HRectBound<2>,
-	  NeighborSearchStat<NearestNeighborSort> >
-	  refTree(referenceData, oldFromNewRefs, leafSize);
-      BinarySpaceTree<bound::HRectBound<2>,
-	  NeighborSearchStat<NearestNeighborSort> >*
-	  queryTree = NULL; // Empty for now.
+        refTree = new KDTreeType(referenceData, oldFromNewRefs, leafSize);
 
-      Timer::Stop("tree_building");
+        Timer::Stop("tree_building");
+      }
 
-      std::vector<size_t> oldFromNewQueries;
+      if (saveTreeFile != "" &&
+          MappedTree<KDTreeType>::Save(saveTreeFile, *refTree, oldFromNewRefs))
+        Log::Info << "Saved reference tree to '" << saveTreeFile << "'."
+            << endl;
 
-      if (CLI::GetParam<string>("query_file") != "")
+      if (queryChunkSize > 0)
       {
-	if (naive && leafSize < queryData.n_cols)
-	  leafSize = queryData.n_cols;
+        // The query set is never held in memory all at once.
+        SearchQueryChunks(*refTree, oldFromNewRefs, queryFile, distancesFile,
+            neighborsFile, k, queryChunkSize, leafSize, naive, singleMode,
+            epsilon, numThreads);
+      }
+      else
+      {
+        KDTreeType* queryTree = NULL; // Empty for now.
 
-	Log::Info << "Loaded query data from '" << queryFile << "' ("
-	    << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
+        std::vector<size_t> oldFromNewQueries;
 
-	Log::Info << "Building query tree..." << endl;
+        if (CLI::GetParam<string>("query_file") != "")
+        {
+          if (naive && leafSize < queryData.n_cols)
+            leafSize = queryData.n_cols;
 
-	// Build trees by hand, so we can save memory: if we pass a tree to
-	// NeighborSearch, it does not copy the matrix.
-	if (!singleMode)
-	{
-	  Timer::Start("tree_building");
+          Log::Info << "Loaded query data from '" << queryFile << "' ("
+              << queryData.n_rows << " x " << queryData.n_cols << ")."
+              << endl;
 
-	  queryTree = new BinarySpaceTree<bound::HRectBound<2>,
-	      NeighborSearchStat<NearestNeighborSort> >(queryData,
-	      oldFromNewQueries, leafSize);
+          Log::Info << "Building query tree..." << endl;
 
-	  Timer::Stop("tree_building");
-	}
+          // Build trees by hand, so we can save memory: if we pass a tree to
+          // NeighborSearch, it does not copy the matrix.
+          if (!singleMode)
+          {
+            Timer::Start("tree_building");
 
-	allknn = new AllkNN(&refTree, queryTree, referenceData, queryData,
-	    singleMode);
+            queryTree = new BinarySpaceTree<bound::HRectBound<2>,
+                NeighborSearchStat<NearestNeighborSort> >(queryData,
+                oldFromNewQueries, leafSize);
 
-	Log::Info << "Tree built." << endl;
-      }
-      else
-      {
-	allknn = new AllkNN(&refTree, referenceData, singleMode);
+            Timer::Stop("tree_building");
+          }
 
-	Log::Info << "Trees built." << endl;
-      }
+          allknn = new AllkNN(refTree, queryTree, refTree->Dataset(),
+              queryData, singleMode);
 
-      arma::mat distancesOut;
-      arma::Mat<size_t> neighborsOut;
+          Log::Info << "Tree built." << endl;
+        }
+        else
+        {
+          allknn = new AllkNN(refTree, refTree->Dataset(), singleMode);
 
-      Log::Info << "Computing " << k << " nearest neighbors..." << endl;
-      allknn->Search(k, neighborsOut, distancesOut);
+          Log::Info << "Trees built." << endl;
+        }
 
-      Log::Info << "Neighbors computed." << endl;
+        Log::Info << "Computing " << k << " nearest neighbors..." << endl;
+        allknn->NumThreads() = numThreads;
+        allknn->Epsilon() = epsilon;
+        allknn->Search(k, neighbors, distances);
 
-      // We have to map back to the original indices from before the tree
-      // construction.
-      Log::Info << "Re-mapping indices..." << endl;
+        Log::Info << "Neighbors computed." << endl;
+        allknn->Statistics().Print();
 
-      // Map the results back to the correct places.
-      if ((CLI::GetParam<string>("query_file") != "") && !singleMode)
-	Unmap(neighborsOut, distancesOut, oldFromNewRefs, oldFromNewQueries,
-	    neighbors, distances);
-      else if ((CLI::GetParam<string>("query_file") != "") && singleMode)
-	Unmap(neighborsOut, distancesOut, oldFromNewRefs, neighbors, distances);
-      else
-	Unmap(neighborsOut, distancesOut, oldFromNewRefs, oldFromNewRefs,
-	    neighbors, distances);
+        // We have to map back to the original indices from before the tree
+        // construction.
+        Log::Info << "Re-mapping indices..." << endl;
 
-      // Clean up.
-      if (queryTree)
-	delete queryTree;
+        // Map the results back to the correct places, in place.
+        if ((CLI::GetParam<string>("query_file") != "") && !singleMode)
+          Unmap(neighbors, distances, oldFromNewRefs, oldFromNewQueries);
+        else if ((CLI::GetParam<string>("query_file") != "") && singleMode)
+          Unmap(neighbors, distances, oldFromNewRefs);
+        else
+          Unmap(neighbors, distances, oldFromNewRefs, oldFromNewRefs);
 
-      delete allknn;
+        // Clean up.
+        if (queryTree)
+          delete queryTree;
+
+        delete allknn;
+      }
+
+      if (mappedTree)
+        delete mappedTree;
+      else
+        delete refTree;
     } else { // R tree.
       // Make sure to notify the user that they are using an r tree.
       Log::Info << "Using R tree for nearest-neighbor calculation." << endl;
@@ -333,9 +826,12 @@ int main(int argc, char *argv[])
       //arma::Mat<size_t> neighborsOut;
 
       Log::Info << "Computing " << k << " nearest neighbors..." << endl;
+      allknn->NumThreads() = numThreads;
+      allknn->Epsilon() = epsilon;
       allknn->Search(k, neighbors, distances);
 
       Log::Info << "Neighbors computed." << endl;
+      allknn->Statistics().Print();
 
       if(queryTree)
         delete queryTree;
@@ -389,9 +885,12 @@ int main(int argc, char *argv[])
     }
 
     Log::Info << "Computing " << k << " nearest neighbors..." << endl;
+    allknn->NumThreads() = numThreads;
+    allknn->Epsilon() = epsilon;
     allknn->Search(k, neighbors, distances);
 
     Log::Info << "Neighbors computed." << endl;
+    allknn->Statistics().Print();
 
     delete allknn;
 
@@ -399,7 +898,29 @@ int main(int argc, char *argv[])
       delete queryTree;
   }
 
-  // Save put.
-  data::Save(distancesFile, distances);
-  data::Save(neighborsFile, neighbors);
+  // Expand the results on the unique points to the original points.
+  if (deduplicate)
+  {
+    arma::Mat<size_t> uniqueNeighbors;
+    arma::mat uniqueDistances;
+    uniqueNeighbors.steal_mem(neighbors);
+    uniqueDistances.steal_mem(distances);
+    if (queryFile != "")
+    {
+      ExpandNeighbors<NearestNeighborSort>(uniqueReferences, uniqueQueries,
+          originalK, uniqueNeighbors, uniqueDistances, neighbors, distances);
+    }
+    else
+    {
+      ExpandNeighbors<NearestNeighborSort>(uniqueReferences, originalK,
+          uniqueNeighbors, uniqueDistances, neighbors, distances);
+    }
+  }
+
+  // Save put, unless the results have already been written chunk by chunk.
+  if (queryChunkSize == 0)
+  {
+    data::Save(distancesFile, distances);
+    data::Save(neighborsFile, neighbors);
+  }
 }
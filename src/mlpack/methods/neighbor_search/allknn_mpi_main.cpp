@@ -0,0 +1,158 @@
+/**
+ * @file allknn_mpi_main.cpp
+ *
+ * Executable for all-k-nearest-neighbors search with MPI, when the reference
+ * set is split across several processes.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/mpi_reducer.hpp>
+
+#include <string>
+
+#include "distributed_neighbor_search.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+using namespace mlpack::util;
+
+// Information about the program itself.
+PROGRAM_INFO("Distributed All K-Nearest-Neighbors",
+    "This program will calculate the k-nearest-neighbors of a set of points "
+    "with MPI, when the reference set is split into shards held by different "
+    "processes.  Each process builds a kd-tree on its own shard; the query "
+    "points are broadcast to every process in blocks of --block_size points, "
+    "and the candidates found by each process are merged.  Bounds on the k'th "
+    "neighbor distance of each query, computed from --sample_size points of "
+    "each shard, are shared between the processes before each block is "
+    "searched, to prune more of each tree."
+    "\n\n"
+    "If --reference_file contains '%r', it is replaced with the rank of each "
+    "process, so that each process loads its own shard; otherwise each process "
+    "loads the whole file and keeps an equal part of it.  The reference points "
+    "are numbered in rank order, so the neighbor indices refer to the "
+    "concatenation of the shards."
+    "\n\n"
+    "If --query_file is given, it is loaded by the first process only, and the "
+    "first process saves the results.  Otherwise the k nearest neighbors of "
+    "each reference point (excluding the point itself) are found, and each "
+    "process saves the results of its own shard: '%r' in --neighbors_file and "
+    "--distances_file is then replaced with the rank."
+    "\n\n"
+    "For example, the following will use four processes to find the 5 nearest "
+    "neighbors of the points in 'queries.csv' among the points in "
+    "'shard0.csv' to 'shard3.csv':"
+    "\n\n"
+    "$ mpirun -np 4 allknn_mpi -k 5 -r shard%r.csv -q queries.csv "
+    "-n neighbors.csv -d distances.csv");
+
+// Define our input parameters that this program will take.
+PARAM_STRING_REQ("reference_file", "File containing the reference dataset "
+    "('%r' is replaced with the rank).", "r");
+PARAM_STRING("query_file", "File containing query points (optional; loaded by "
+    "the first process).", "q", "");
+PARAM_STRING("distances_file", "File to output distances into.", "d", "");
+PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
+PARAM_INT_REQ("k", "Number of nearest neighbors to find.", "k");
+
+PARAM_INT("block_size", "Number of query points broadcast at once.", "b",
+    1024);
+PARAM_INT("sample_size", "Number of points of each shard used to compute the "
+    "shared bounds (0 to share no bounds).", "S", 100);
+
+int main(int argc, char* argv[])
+{
+  MPI_Init(&argc, &argv);
+
+  int rank, numRanks;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+
+  // Give CLI the command line parameters the user passed in.
+  CLI::ParseCommandLine(argc, argv);
+
+  const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string queryFile = CLI::GetParam<string>("query_file");
+  const string distancesFile = CLI::GetParam<string>("distances_file");
+  const string neighborsFile = CLI::GetParam<string>("neighbors_file");
+
+  if (CLI::GetParam<int>("k") <= 0)
+  {
+    Log::Fatal << "Invalid k: " << CLI::GetParam<int>("k") << "; must be "
+        << "greater than 0." << endl;
+  }
+  const size_t k = (size_t) CLI::GetParam<int>("k");
+
+  if (CLI::GetParam<int>("block_size") <= 0)
+  {
+    Log::Fatal << "Invalid block size: " << CLI::GetParam<int>("block_size")
+        << "; must be greater than 0." << endl;
+  }
+
+  if (CLI::GetParam<int>("sample_size") < 0)
+  {
+    Log::Fatal << "Invalid sample size: " << CLI::GetParam<int>("sample_size")
+        << "; must be 0 or greater." << endl;
+  }
+
+  // Without a query set, every process saves its own results.
+  if (queryFile == "" && numRanks > 1 &&
+      ((distancesFile != "" && distancesFile.find("%r") == string::npos) ||
+       (neighborsFile != "" && neighborsFile.find("%r") == string::npos)))
+  {
+    Log::Fatal << "Without --query_file, the output file names must contain "
+        << "'%r', so that each process saves its results to its own file."
+        << endl;
+  }
+
+  // Load the shard of this process.
+  arma::mat referenceData;
+  if (referenceFile.find("%r") != string::npos)
+  {
+    data::Load(RankFileName(referenceFile, rank), referenceData, true);
+  }
+  else
+  {
+    arma::mat fullData;
+    data::Load(referenceFile, fullData, true);
+
+    const size_t begin = rank * fullData.n_cols / numRanks;
+    const size_t end = (rank + 1) * fullData.n_cols / numRanks;
+    if (end > begin)
+      referenceData = fullData.cols(begin, end - 1);
+    else
+      referenceData.set_size(fullData.n_rows, 0);
+  }
+
+  Log::Info << "Rank " << rank << " loaded " << referenceData.n_cols
+      << " reference points." << endl;
+
+  arma::mat queryData;
+  if (queryFile != "" && rank == 0)
+  {
+    data::Load(queryFile, queryData, true);
+    Log::Info << "Loaded query data from '" << queryFile << "' ("
+        << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
+  }
+
+  DistributedNeighborSearch<> search(referenceData);
+  search.BlockSize() = (size_t) CLI::GetParam<int>("block_size");
+  search.SampleSize() = (size_t) CLI::GetParam<int>("sample_size");
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  search.Search(queryData, k, neighbors, distances, (queryFile == ""));
+
+  // Save output: the first process holds the results of the query set, and
+  // every process holds the results of its own shard otherwise.
+  if (queryFile == "" || rank == 0)
+  {
+    if (distancesFile != "")
+      data::Save(RankFileName(distancesFile, rank), distances);
+
+    if (neighborsFile != "")
+      data::Save(RankFileName(neighborsFile, rank), neighbors);
+  }
+
+  MPI_Finalize();
+}
@@ -0,0 +1,124 @@
+/**
+ * @file candidate_heap.hpp
+ *
+ * Definition of the CandidateHeap class, which maintains a fixed-size list of
+ * the k best neighbor candidates for each query point as a binary heap.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_HEAP_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_HEAP_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The CandidateHeap class provides static utilities to maintain the k best
+ * candidates for each query point, where "best" is defined by the IsBetter()
+ * function of the given SortPolicy.  The candidates for query point i are
+ * stored in column i of a distances matrix and a neighbors matrix, each with k
+ * rows, so they are contiguous in memory.  Each column is a binary heap with
+ * the worst candidate at the top (row 0), so the pruning bound for a query
+ * point can be read in O(1) and a new candidate can be inserted in O(log k)
+ * instead of the O(k) shift required by a sorted list.
+ *
+ * Candidates with equal distances are ordered by their index, and empty slots
+ * are denoted by the index (size_t() - 1), so they are always the worst
+ * candidates.  Thus, before any search, the neighbors matrix should be filled
+ * with (size_t() - 1) and the distances matrix should be filled with
+ * SortPolicy::WorstDistance(); this is a valid heap.
+ *
+ * Once the search is finished, Sort() should be called to turn each heap into
+ * a sorted list, with the best candidate in the first row.
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ */
+template<typename SortPolicy>
+class CandidateHeap
+{
+ public:
+  /**
+   * Return the distance of the worst candidate currently held for the given
+   * query point (this is the k'th best distance found so far).
+   *
+   * @param distances Matrix of candidate distances.
+   * @param queryIndex Index of query point.
+   */
+  static double WorstDistance(const arma::mat& distances,
+                              const size_t queryIndex)
+  {
+    return distances(0, queryIndex);
+  }
+
+  /**
+   * Return the index of the worst candidate currently held for the given query
+   * point, or (size_t() - 1) if there is still an empty slot.
+   *
+   * @param neighbors Matrix of candidate indices.
+   * @param queryIndex Index of query point.
+   */
+  static size_t WorstNeighbor(const arma::Mat<size_t>& neighbors,
+                              const size_t queryIndex)
+  {
+    return neighbors(0, queryIndex);
+  }
+
+  /**
+   * Try to insert a candidate into the list of the given query point.  If it
+   * is better than the current worst candidate, the worst candidate is
+   * replaced and the heap is restored.
+   *
+   * @param neighbors Matrix of candidate indices.
+   * @param distances Matrix of candidate distances.
+   * @param queryIndex Index of query point.
+   * @param neighbor Index of the new candidate.
+   * @param distance Distance between the query point and the new candidate.
+   * @return true if the candidate was inserted.
+   */
+  static bool Insert(arma::Mat<size_t>& neighbors,
+                     arma::mat& distances,
+                     const size_t queryIndex,
+                     const size_t neighbor,
+                     const double distance);
+
+  /**
+   * Sort the candidates of every query point, so that the best candidate is in
+   * the first row.  After this is called, the matrices are no longer heaps.
+   *
+   * @param neighbors Matrix of candidate indices.
+   * @param distances Matrix of candidate distances.
+   */
+  static void Sort(arma::Mat<size_t>& neighbors, arma::mat& distances);
+
+ private:
+  /**
+   * Return whether or not the candidate (distanceA, neighborA) should come
+   * before the candidate (distanceB, neighborB) in the final sorted results.
+   */
+  static bool Before(const double distanceA,
+                     const size_t neighborA,
+                     const double distanceB,
+                     const size_t neighborB)
+  {
+    if (SortPolicy::IsBetter(distanceA, distanceB))
+      return true;
+    if (SortPolicy::IsBetter(distanceB, distanceA))
+      return false;
+    return (neighborA < neighborB);
+  }
+
+  //! Comparator for sorting (distance, index) pairs with Before().
+  static bool PairBefore(const std::pair<double, size_t>& a,
+                         const std::pair<double, size_t>& b)
+  {
+    return Before(a.first, a.second, b.first, b.second);
+  }
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "candidate_heap_impl.hpp"
+
+#endif
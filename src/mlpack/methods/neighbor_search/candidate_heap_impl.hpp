@@ -0,0 +1,86 @@
+/**
+ * @file candidate_heap_impl.hpp
+ *
+ * Implementation of the CandidateHeap class.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_HEAP_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_HEAP_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "candidate_heap.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy>
+inline bool CandidateHeap<SortPolicy>::Insert(arma::Mat<size_t>& neighbors,
+                                              arma::mat& distances,
+                                              const size_t queryIndex,
+                                              const size_t neighbor,
+                                              const double distance)
+{
+  double* candidateDistances = distances.colptr(queryIndex);
+  size_t* candidateNeighbors = neighbors.colptr(queryIndex);
+  const size_t k = distances.n_rows;
+
+  // The top of the heap is the worst candidate; if the new candidate isn't
+  // better than that, there is nothing to do.
+  if (!Before(distance, neighbor, candidateDistances[0], candidateNeighbors[0]))
+    return false;
+
+  // Replace the top of the heap and sift the new candidate down to its place.
+  size_t pos = 0;
+  while (true)
+  {
+    size_t child = 2 * pos + 1;
+    if (child >= k)
+      break;
+
+    // Pick the worse of the two children.
+    if ((child + 1 < k) && Before(candidateDistances[child],
+        candidateNeighbors[child], candidateDistances[child + 1],
+        candidateNeighbors[child + 1]))
+      ++child;
+
+    // Stop if the new candidate is worse than both children.
+    if (Before(candidateDistances[child], candidateNeighbors[child], distance,
+        neighbor))
+      break;
+
+    candidateDistances[pos] = candidateDistances[child];
+    candidateNeighbors[pos] = candidateNeighbors[child];
+    pos = child;
+  }
+
+  candidateDistances[pos] = distance;
+  candidateNeighbors[pos] = neighbor;
+
+  return true;
+}
+
+template<typename SortPolicy>
+void CandidateHeap<SortPolicy>::Sort(arma::Mat<size_t>& neighbors,
+                                     arma::mat& distances)
+{
+  std::vector<std::pair<double, size_t> > candidates(distances.n_rows);
+  for (size_t i = 0; i < distances.n_cols; ++i)
+  {
+    for (size_t j = 0; j < distances.n_rows; ++j)
+      candidates[j] = std::make_pair(distances(j, i), neighbors(j, i));
+
+    std::sort(candidates.begin(), candidates.end(), PairBefore);
+
+    for (size_t j = 0; j < distances.n_rows; ++j)
+    {
+      distances(j, i) = candidates[j].first;
+      neighbors(j, i) = candidates[j].second;
+    }
+  }
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ * @file distributed_neighbor_search.hpp
+ *
+ * Defines the DistributedNeighborSearch class, which performs k-neighbor
+ * searches with MPI when the reference set is split across several processes.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_DISTRIBUTED_NEIGHBOR_SEARCH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_DISTRIBUTED_NEIGHBOR_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <mpi.h>
+
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The DistributedNeighborSearch class performs k-neighbor searches when the
+ * reference set is too large for one machine.  Each MPI process (rank) holds
+ * one shard of the reference set, in rank order, and builds a tree on it.  The
+ * reference points are numbered globally: the points of rank r come after the
+ * points of ranks 0 to r - 1.
+ *
+ * The query points may also be split across the ranks: each rank passes the
+ * queries it owns (possibly none) to Search().  The queries of each rank are
+ * broadcast to all ranks in blocks; every rank searches its own shard with a
+ * dual-tree traversal, and the candidate lists of all ranks are merged at the
+ * owner of the queries.  Before a block is searched, each rank computes the
+ * k'th distance of every query to a small sample of its shard; the best of
+ * these over all ranks is a bound on the final k'th distance, and each rank
+ * starts its search from that bound, so that much more of its tree is pruned
+ * than if it only used its own results.
+ *
+ * All ranks must construct the object and call Search() collectively.
+ *
+ * @code
+ * MPI_Init(&argc, &argv);
+ * // Each rank loads its own shard of the reference set.
+ * arma::mat shard;
+ * data::Load(shardFile, shard);
+ *
+ * DistributedNeighborSearch<> dns(shard);
+ *
+ * // Find the 10 nearest neighbors of the queries held by rank 0.
+ * arma::mat queries; // Loaded on rank 0 only.
+ * arma::Mat<size_t> neighbors; // Global reference indices.
+ * arma::mat distances;
+ * dns.Search(queries, 10, neighbors, distances);
+ * MPI_Finalize();
+ * @endcode
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam MetricType The metric to use for computation.
+ * @tparam TreeType The tree type to build on each shard.
+ */
+template<typename SortPolicy = NearestNeighborSort,
+         typename MetricType = mlpack::metric::EuclideanDistance,
+         typename TreeType = tree::BinarySpaceTree<bound::HRectBound<2>,
+             NeighborSearchStat<SortPolicy> > >
+class DistributedNeighborSearch
+{
+ public:
+  /**
+   * Build the tree on the shard of the reference set held by this rank.  This
+   * is collective: every rank of the communicator must call it.  The shard is
+   * copied, since tree building may rearrange it.
+   *
+   * @param localReferenceSet The reference points held by this rank.
+   * @param communicator MPI communicator of the ranks holding the shards.
+   * @param metric An optional instance of the MetricType class.
+   */
+  DistributedNeighborSearch(const typename TreeType::Mat& localReferenceSet,
+                            const MPI_Comm communicator = MPI_COMM_WORLD,
+                            const MetricType metric = MetricType());
+
+  /**
+   * Delete the tree of the shard.
+   */
+  ~DistributedNeighborSearch();
+
+  /**
+   * Find the k best neighbors in the whole reference set of the query points
+   * held by this rank.  This is collective: every rank must call it, with its
+   * own (possibly empty) query set.  The neighbors are global reference
+   * indices, and column i of the results holds the neighbors of query point i
+   * of this rank.
+   *
+   * If monochromatic is true, the query points are the reference shard given
+   * to the constructor, and no point is returned as its own neighbor.  Then
+   * the querySet argument is ignored.
+   *
+   * @param querySet Query points held by this rank.
+   * @param k Number of neighbors to find.
+   * @param neighbors Matrix to store the global indices of the neighbors in.
+   * @param distances Matrix to store the distances of the neighbors in.
+   * @param monochromatic If true, search for the neighbors of the shard itself.
+   */
+  void Search(const typename TreeType::Mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances,
+              const bool monochromatic = false);
+
+  //! Get the rank of this process.
+  int Rank() const { return rank; }
+  //! Get the number of ranks.
+  int NumRanks() const { return numRanks; }
+  //! Get the global index of the first point of the shard of this rank.
+  size_t ReferenceOffset() const { return referenceOffset; }
+  //! Get the total number of reference points over all ranks.
+  size_t NumReferences() const { return numReferences; }
+
+  //! Get the number of query points broadcast at once.
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of query points broadcast at once.
+  size_t& BlockSize() { return blockSize; }
+
+  //! Get the size of the sample of the shard used to compute bounds (0 means
+  //! that no bounds are shared; otherwise at least k points are used).
+  size_t SampleSize() const { return sampleSize; }
+  //! Modify the size of the sample of the shard used to compute bounds.
+  size_t& SampleSize() { return sampleSize; }
+
+  //! Get the number of base cases computed by this rank in the last search.
+  size_t BaseCases() const { return baseCases; }
+
+  //! Return a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  /**
+   * Search the shard for the neighbors of a block of queries, starting from
+   * the given bounds, and store the candidates with global indices.
+   */
+  void SearchBlock(const typename TreeType::Mat& block,
+                   const size_t k,
+                   const arma::rowvec& bounds,
+                   arma::Mat<size_t>& neighbors,
+                   arma::mat& distances);
+
+  /**
+   * Compute the bound on the k'th distance of each query of the block from the
+   * sample of the shard, and share it with all ranks, keeping the best one.
+   */
+  void ShareBounds(const typename TreeType::Mat& block,
+                   const size_t k,
+                   arma::rowvec& bounds);
+
+  //! The communicator of the ranks.
+  MPI_Comm communicator;
+  //! The rank of this process.
+  int rank;
+  //! The number of ranks.
+  int numRanks;
+
+  //! The (rearranged) copy of the shard of this rank.
+  typename TreeType::Mat referenceSet;
+  //! The tree built on the shard.
+  TreeType* referenceTree;
+  //! The original shard index of each point of the rearranged shard.
+  std::vector<size_t> oldFromNewReferences;
+  //! The global index of the first point of the shard.
+  size_t referenceOffset;
+  //! The total number of reference points.
+  size_t numReferences;
+
+  //! Instantiated metric.
+  MetricType metric;
+
+  //! The number of query points broadcast at once.
+  size_t blockSize;
+  //! The size of the sample used to compute bounds.
+  size_t sampleSize;
+  //! The number of base cases computed by this rank in the last search.
+  size_t baseCases;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "distributed_neighbor_search_impl.hpp"
+
+#endif
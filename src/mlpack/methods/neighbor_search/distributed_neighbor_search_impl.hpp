@@ -0,0 +1,353 @@
+/**
+ * @file distributed_neighbor_search_impl.hpp
+ *
+ * Implementation of the DistributedNeighborSearch class.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_DISTRIBUTED_NEIGHBOR_SEARCH_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_DISTRIBUTED_NEIGHBOR_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "distributed_neighbor_search.hpp"
+
+#include "neighbor_search_rules.hpp"
+#include "candidate_heap.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+DistributedNeighborSearch<SortPolicy, MetricType, TreeType>::
+DistributedNeighborSearch(const typename TreeType::Mat& localReferenceSet,
+                          const MPI_Comm communicator,
+                          const MetricType metric) :
+    communicator(communicator),
+    referenceSet(localReferenceSet),
+    referenceTree(NULL),
+    referenceOffset(0),
+    numReferences(0),
+    metric(metric),
+    blockSize(1024),
+    sampleSize(100),
+    baseCases(0)
+{
+  MPI_Comm_rank(communicator, &rank);
+  MPI_Comm_size(communicator, &numRanks);
+
+  // Number the reference points globally, in rank order.
+  unsigned long long localCount = referenceSet.n_cols;
+  unsigned long long offset = 0;
+  unsigned long long total = 0;
+  MPI_Exscan(&localCount, &offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+      communicator);
+  MPI_Allreduce(&localCount, &total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+      communicator);
+
+  // The result of MPI_Exscan() is undefined on the first rank.
+  referenceOffset = (rank == 0) ? 0 : (size_t) offset;
+  numReferences = (size_t) total;
+
+  Timer::Start("tree_building");
+
+  // A rank may hold no reference points at all; then it has no tree.
+  if (referenceSet.n_cols > 0)
+    referenceTree = BuildTree<TreeType>(referenceSet, oldFromNewReferences);
+
+  Timer::Stop("tree_building");
+
+  Log::Info << "Rank " << rank << " holds reference points " << referenceOffset
+      << " to " << (referenceOffset + referenceSet.n_cols) << " of "
+      << numReferences << "." << std::endl;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+DistributedNeighborSearch<SortPolicy, MetricType, TreeType>::
+~DistributedNeighborSearch()
+{
+  if (referenceTree)
+    delete referenceTree;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void DistributedNeighborSearch<SortPolicy, MetricType, TreeType>::Search(
+    const typename TreeType::Mat& querySet,
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances,
+    const bool monochromatic)
+{
+  // In monochromatic mode, one more neighbor is searched for, since each point
+  // will find itself.
+  const size_t searchK = monochromatic ? k + 1 : k;
+  if (k == 0 || searchK > numReferences)
+  {
+    Log::Fatal << "DistributedNeighborSearch::Search(): invalid k (" << k
+        << "); must be greater than 0 and at most the number of reference "
+        << "points (" << numReferences << ")" << (monochromatic ? ", minus one"
+        : "") << "." << std::endl;
+  }
+
+  if (blockSize == 0)
+  {
+    Log::Fatal << "DistributedNeighborSearch::Search(): block size must be "
+        << "greater than 0." << std::endl;
+  }
+
+  Timer::Start("computing_neighbors");
+  baseCases = 0;
+
+  // In monochromatic mode the queries are the rearranged shard, which is put
+  // back in order at the end.
+  const typename TreeType::Mat& queries = monochromatic ? referenceSet :
+      querySet;
+
+  neighbors.set_size(k, queries.n_cols);
+  neighbors.fill(size_t() - 1);
+  distances.set_size(k, queries.n_cols);
+  distances.fill(SortPolicy::WorstDistance());
+
+  typename TreeType::Mat block;
+  arma::rowvec bounds;
+  arma::Mat<size_t> blockNeighbors;
+  arma::mat blockDistances;
+  arma::Mat<size_t> allNeighbors;
+  arma::mat allDistances;
+
+  // Every rank takes its turn as the owner of the queries being searched.
+  for (int owner = 0; owner < numRanks; ++owner)
+  {
+    unsigned long long size[2];
+    size[0] = (rank == owner) ? queries.n_rows : 0;
+    size[1] = (rank == owner) ? queries.n_cols : 0;
+    MPI_Bcast(size, 2, MPI_UNSIGNED_LONG_LONG, owner, communicator);
+
+    const size_t dimensionality = (size_t) size[0];
+    const size_t numQueries = (size_t) size[1];
+    if (numQueries > 0 && referenceSet.n_cols > 0 &&
+        dimensionality != referenceSet.n_rows)
+    {
+      Log::Fatal << "DistributedNeighborSearch::Search(): the queries of rank "
+          << owner << " have " << dimensionality << " dimensions, but the "
+          << "reference points of rank " << rank << " have "
+          << referenceSet.n_rows << "!" << std::endl;
+    }
+
+    for (size_t begin = 0; begin < numQueries; begin += blockSize)
+    {
+      const size_t end = std::min(begin + blockSize, numQueries);
+      const size_t numBlockQueries = end - begin;
+
+      if (rank == owner)
+        block = queries.cols(begin, end - 1);
+      else
+        block.set_size(dimensionality, numBlockQueries);
+      MPI_Bcast(block.memptr(), (int) block.n_elem, MPI_DOUBLE, owner,
+          communicator);
+
+      // Find a bound on the k'th distance of each query, then search this
+      // shard from it.
+      ShareBounds(block, searchK, bounds);
+      SearchBlock(block, searchK, bounds, blockNeighbors, blockDistances);
+
+      // Collect the candidates of every rank at the owner.
+      if (rank == owner)
+      {
+        allNeighbors.set_size(searchK, numBlockQueries * numRanks);
+        allDistances.set_size(searchK, numBlockQueries * numRanks);
+      }
+
+      MPI_Gather(blockNeighbors.memptr(),
+          (int) (blockNeighbors.n_elem * sizeof(size_t)), MPI_BYTE,
+          allNeighbors.memptr(),
+          (int) (blockNeighbors.n_elem * sizeof(size_t)), MPI_BYTE, owner,
+          communicator);
+      MPI_Gather(blockDistances.memptr(), (int) blockDistances.n_elem,
+          MPI_DOUBLE, allDistances.memptr(), (int) blockDistances.n_elem,
+          MPI_DOUBLE, owner, communicator);
+
+      if (rank != owner)
+        continue;
+
+      // Merge the candidates into the lists of the queries.
+      for (size_t q = 0; q < numBlockQueries; ++q)
+      {
+        const size_t query = begin + q;
+        size_t self = size_t() - 1;
+        if (monochromatic)
+          self = referenceOffset + (tree::TreeTraits<TreeType>::
+              RearrangesDataset ? oldFromNewReferences[query] : query);
+
+        for (int r = 0; r < numRanks; ++r)
+        {
+          const size_t col = r * numBlockQueries + q;
+          for (size_t j = 0; j < searchK; ++j)
+          {
+            const size_t candidate = allNeighbors(j, col);
+            if (candidate == size_t() - 1 || candidate == self)
+              continue;
+
+            CandidateHeap<SortPolicy>::Insert(neighbors, distances, query,
+                candidate, allDistances(j, col));
+          }
+        }
+      }
+    }
+  }
+
+  CandidateHeap<SortPolicy>::Sort(neighbors, distances);
+
+  // Put the results of a monochromatic search back in the order of the shard.
+  if (monochromatic && tree::TreeTraits<TreeType>::RearrangesDataset)
+  {
+    const arma::Mat<size_t> rearrangedNeighbors(neighbors);
+    const arma::mat rearrangedDistances(distances);
+
+    for (size_t i = 0; i < rearrangedNeighbors.n_cols; ++i)
+    {
+      neighbors.col(oldFromNewReferences[i]) = rearrangedNeighbors.col(i);
+      distances.col(oldFromNewReferences[i]) = rearrangedDistances.col(i);
+    }
+  }
+
+  Timer::Stop("computing_neighbors");
+
+  Log::Info << "Rank " << rank << " calculated " << baseCases << " base cases."
+      << std::endl;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void DistributedNeighborSearch<SortPolicy, MetricType, TreeType>::ShareBounds(
+    const typename TreeType::Mat& block,
+    const size_t k,
+    arma::rowvec& bounds)
+{
+  bounds.set_size(block.n_cols);
+  bounds.fill(SortPolicy::WorstDistance());
+
+  // Evaluate the queries against evenly spaced points of the shard; the
+  // rearranged shard is ordered by the tree, so these are spread over the
+  // space it covers.  With fewer than k points, there is no bound.
+  const size_t numSamples = std::min((size_t) referenceSet.n_cols,
+      std::max(sampleSize, k));
+  if (sampleSize > 0 && numSamples >= k)
+  {
+    arma::Mat<size_t> sampleNeighbors(k, block.n_cols);
+    sampleNeighbors.fill(size_t() - 1);
+    arma::mat sampleDistances(k, block.n_cols);
+    sampleDistances.fill(SortPolicy::WorstDistance());
+
+    for (size_t s = 0; s < numSamples; ++s)
+    {
+      const size_t point = s * referenceSet.n_cols / numSamples;
+      for (size_t q = 0; q < block.n_cols; ++q)
+      {
+        CandidateHeap<SortPolicy>::Insert(sampleNeighbors, sampleDistances, q,
+            point, metric.Evaluate(block.unsafe_col(q),
+            referenceSet.unsafe_col(point)));
+      }
+    }
+    baseCases += numSamples * block.n_cols;
+
+    for (size_t q = 0; q < block.n_cols; ++q)
+      bounds[q] = CandidateHeap<SortPolicy>::WorstDistance(sampleDistances, q);
+  }
+
+  if (sampleSize == 0)
+    return;
+
+  // Keep the best bound of any rank.  Candidates must be strictly better than
+  // the bound to be inserted, so it is loosened a little to keep the points at
+  // exactly the bound.
+  arma::mat allBounds(block.n_cols, numRanks);
+  MPI_Allgather(bounds.memptr(), (int) bounds.n_elem, MPI_DOUBLE,
+      allBounds.memptr(), (int) bounds.n_elem, MPI_DOUBLE, communicator);
+
+  for (size_t q = 0; q < block.n_cols; ++q)
+  {
+    double bound = SortPolicy::WorstDistance();
+    for (int r = 0; r < numRanks; ++r)
+      if (SortPolicy::IsBetter(allBounds(q, r), bound))
+        bound = allBounds(q, r);
+
+    if (bound != SortPolicy::WorstDistance())
+      bound = SortPolicy::CombineWorst(bound, 1e-10 * (1.0 + bound));
+
+    bounds[q] = bound;
+  }
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void DistributedNeighborSearch<SortPolicy, MetricType, TreeType>::SearchBlock(
+    const typename TreeType::Mat& block,
+    const size_t k,
+    const arma::rowvec& bounds,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances)
+{
+  neighbors.set_size(k, block.n_cols);
+  neighbors.fill(size_t() - 1);
+  distances.set_size(k, block.n_cols);
+  distances.fill(SortPolicy::WorstDistance());
+
+  if (!referenceTree)
+    return;
+
+  typename TreeType::Mat queryCopy(block);
+  std::vector<size_t> oldFromNewQueries;
+  TreeType* queryTree = BuildTree<TreeType>(queryCopy, oldFromNewQueries);
+  const bool mapQueries = tree::TreeTraits<TreeType>::RearrangesDataset;
+
+  // Start every candidate list from the shared bound; the rules will only
+  // insert candidates which are better than it.
+  arma::Mat<size_t> treeNeighbors(k, block.n_cols);
+  treeNeighbors.fill(size_t() - 1);
+  arma::mat treeDistances(k, block.n_cols);
+  for (size_t i = 0; i < block.n_cols; ++i)
+    treeDistances.col(i).fill(bounds[mapQueries ? oldFromNewQueries[i] : i]);
+
+  typedef NeighborSearchRules<SortPolicy, MetricType, TreeType> RuleType;
+  RuleType rules(referenceSet, queryCopy, treeNeighbors, treeDistances, metric);
+
+  typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
+  traverser.Traverse(*queryTree, *referenceTree);
+  baseCases += rules.BaseCases();
+
+  delete queryTree;
+
+  // Store the candidates in the order of the block, with global indices.
+  for (size_t i = 0; i < block.n_cols; ++i)
+  {
+    const size_t query = mapQueries ? oldFromNewQueries[i] : i;
+    for (size_t j = 0; j < k; ++j)
+    {
+      const size_t candidate = treeNeighbors(j, i);
+      if (candidate == size_t() - 1)
+        continue;
+
+      neighbors(j, query) = referenceOffset + (mapQueries ?
+          oldFromNewReferences[candidate] : candidate);
+      distances(j, query) = treeDistances(j, i);
+    }
+  }
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+std::string DistributedNeighborSearch<SortPolicy, MetricType, TreeType>::
+ToString() const
+{
+  std::ostringstream convert;
+  convert << "DistributedNeighborSearch [" << this << "]" << std::endl;
+  convert << "  Rank: " << rank << " of " << numRanks << std::endl;
+  convert << "  Local reference points: " << referenceSet.n_cols << std::endl;
+  convert << "  Reference offset: " << referenceOffset << std::endl;
+  convert << "  Total reference points: " << numReferences << std::endl;
+  convert << "  Block size: " << blockSize << std::endl;
+  convert << "  Sample size: " << sampleSize << std::endl;
+  convert << "  Metric: " << std::endl <<
+      mlpack::util::Indent(metric.ToString(), 2);
+  return convert.str();
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
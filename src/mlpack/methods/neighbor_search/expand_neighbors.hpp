@@ -0,0 +1,97 @@
+/**
+ * @file expand_neighbors.hpp
+ *
+ * Expand the results of a neighbor search on the unique points of datasets
+ * with duplicates (see data::UniquePoints) into the results of the search on
+ * the original points.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_EXPAND_NEIGHBORS_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_EXPAND_NEIGHBORS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * Return the number of neighbors to search for among the unique reference
+ * points, so that the results can be expanded into k neighbors of each
+ * original point: each unique neighbor stands for at least one original
+ * neighbor, so k are enough, but there may be fewer unique points than that
+ * (and, in the monochromatic case, a point is not its own neighbor).
+ *
+ * @param k Number of neighbors wanted for each original point.
+ * @param references Unique points of the reference set.
+ * @param monochromatic Whether the reference set is the query set.
+ */
+inline size_t UniqueNeighbors(const size_t k,
+                              const data::UniquePoints& references,
+                              const bool monochromatic)
+{
+  const size_t available = (monochromatic && references.NumUnique() > 0) ?
+      (references.NumUnique() - 1) : references.NumUnique();
+  return std::min(k, available);
+}
+
+/**
+ * Expand the results of a bichromatic search of the unique query points among
+ * the unique reference points into k neighbors of each original query point.
+ * Each unique neighbor is replaced by its copies, in increasing order of index
+ * (they are all at the same distance), until k neighbors are found; the copies
+ * of a query point all get the same neighbors.  The unique search must have
+ * found UniqueNeighbors(k, references, false) neighbors of each unique query
+ * point.
+ *
+ * @tparam SortPolicy The sort policy of the search.
+ * @param references Unique points of the reference set.
+ * @param queries Unique points of the query set.
+ * @param k Number of neighbors wanted for each original point.
+ * @param uniqueNeighbors Neighbors of each unique query point.
+ * @param uniqueDistances Distances to the neighbors of each unique query point.
+ * @param neighbors Matrix to store the neighbors of each original query point
+ *     in.
+ * @param distances Matrix to store the distances to the neighbors of each
+ *     original query point in.
+ */
+template<typename SortPolicy>
+void ExpandNeighbors(const data::UniquePoints& references,
+                     const data::UniquePoints& queries,
+                     const size_t k,
+                     const arma::Mat<size_t>& uniqueNeighbors,
+                     const arma::mat& uniqueDistances,
+                     arma::Mat<size_t>& neighbors,
+                     arma::mat& distances);
+
+/**
+ * Expand the results of a monochromatic search among the unique points into k
+ * neighbors of each original point.  The other copies of a point are its
+ * neighbors at distance 0 (ahead of the unique neighbors that are not better
+ * than that, under the sort policy), and each unique neighbor is replaced by
+ * its copies, in increasing order of index, until k neighbors are found.  The
+ * unique search must have found UniqueNeighbors(k, points, true) neighbors of
+ * each unique point.
+ *
+ * @tparam SortPolicy The sort policy of the search.
+ * @param points Unique points of the dataset.
+ * @param k Number of neighbors wanted for each original point.
+ * @param uniqueNeighbors Neighbors of each unique point.
+ * @param uniqueDistances Distances to the neighbors of each unique point.
+ * @param neighbors Matrix to store the neighbors of each original point in.
+ * @param distances Matrix to store the distances to the neighbors of each
+ *     original point in.
+ */
+template<typename SortPolicy>
+void ExpandNeighbors(const data::UniquePoints& points,
+                     const size_t k,
+                     const arma::Mat<size_t>& uniqueNeighbors,
+                     const arma::mat& uniqueDistances,
+                     arma::Mat<size_t>& neighbors,
+                     arma::mat& distances);
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "expand_neighbors_impl.hpp"
+
+#endif
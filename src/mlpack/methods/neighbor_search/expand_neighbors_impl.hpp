@@ -0,0 +1,149 @@
+/**
+ * @file expand_neighbors_impl.hpp
+ *
+ * Implementation of the expansion of neighbor search results on unique points.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_EXPAND_NEIGHBORS_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_EXPAND_NEIGHBORS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "expand_neighbors.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * Expand the unique neighbors of the given unique query point into the first k
+ * neighbors of an original point.  If self is a valid index, the search is
+ * monochromatic, and the other copies of the query point (all but self) are
+ * neighbors too, at distance 0.
+ */
+template<typename SortPolicy>
+void ExpandNeighborColumn(const data::UniquePoints& references,
+                          const size_t k,
+                          const arma::Mat<size_t>& uniqueNeighbors,
+                          const arma::mat& uniqueDistances,
+                          const size_t query,
+                          const size_t self,
+                          size_t* neighbors,
+                          double* distances)
+{
+  const bool monochromatic = (self < references.NumPoints());
+  bool ownCopiesAdded = !monochromatic;
+  size_t found = 0;
+  for (size_t j = 0; j <= uniqueNeighbors.n_rows && found < k; ++j)
+  {
+    const bool last = (j == uniqueNeighbors.n_rows);
+    const double distance = last ? 0.0 : uniqueDistances(j, query);
+
+    // The other copies of the query point go before the first unique neighbor
+    // that is not better than them.
+    if (!ownCopiesAdded && (last || !SortPolicy::IsBetter(distance, 0.0)))
+    {
+      for (size_t c = 0; c < references.Count(query) && found < k; ++c)
+      {
+        const size_t copy = references.Copy(query, c);
+        if (copy == self)
+          continue;
+
+        neighbors[found] = copy;
+        distances[found] = 0.0;
+        ++found;
+      }
+      ownCopiesAdded = true;
+    }
+
+    if (last)
+      break;
+
+    // Searches that cannot find enough neighbors leave invalid indices, which
+    // are kept as they are.
+    const size_t unique = uniqueNeighbors(j, query);
+    if (unique >= references.NumUnique())
+    {
+      if (found < k)
+      {
+        neighbors[found] = unique;
+        distances[found] = distance;
+        ++found;
+      }
+      continue;
+    }
+
+    for (size_t c = 0; c < references.Count(unique) && found < k; ++c)
+    {
+      neighbors[found] = references.Copy(unique, c);
+      distances[found] = distance;
+      ++found;
+    }
+  }
+
+  if (found < k)
+  {
+    Log::Fatal << "ExpandNeighbors(): only " << found << " neighbors of a "
+        << "point could be found, but " << k << " were requested; search for "
+        << "UniqueNeighbors() unique neighbors." << std::endl;
+  }
+}
+
+template<typename SortPolicy>
+void ExpandNeighbors(const data::UniquePoints& references,
+                     const data::UniquePoints& queries,
+                     const size_t k,
+                     const arma::Mat<size_t>& uniqueNeighbors,
+                     const arma::mat& uniqueDistances,
+                     arma::Mat<size_t>& neighbors,
+                     arma::mat& distances)
+{
+  if (uniqueNeighbors.n_cols != queries.NumUnique())
+  {
+    Log::Fatal << "ExpandNeighbors(): results given for "
+        << uniqueNeighbors.n_cols << " query points, but there are "
+        << queries.NumUnique() << " unique query points!" << std::endl;
+  }
+
+  // Expand the neighbors of each unique query point once, and then copy them
+  // to each of its copies.
+  arma::Mat<size_t> expandedNeighbors(k, queries.NumUnique());
+  arma::mat expandedDistances(k, queries.NumUnique());
+  for (size_t q = 0; q < queries.NumUnique(); ++q)
+  {
+    ExpandNeighborColumn<SortPolicy>(references, k, uniqueNeighbors,
+        uniqueDistances, q, references.NumPoints(),
+        expandedNeighbors.colptr(q), expandedDistances.colptr(q));
+  }
+
+  queries.ExpandColumns(expandedNeighbors, neighbors);
+  queries.ExpandColumns(expandedDistances, distances);
+}
+
+template<typename SortPolicy>
+void ExpandNeighbors(const data::UniquePoints& points,
+                     const size_t k,
+                     const arma::Mat<size_t>& uniqueNeighbors,
+                     const arma::mat& uniqueDistances,
+                     arma::Mat<size_t>& neighbors,
+                     arma::mat& distances)
+{
+  if (uniqueNeighbors.n_cols != points.NumUnique())
+  {
+    Log::Fatal << "ExpandNeighbors(): results given for "
+        << uniqueNeighbors.n_cols << " points, but there are "
+        << points.NumUnique() << " unique points!" << std::endl;
+  }
+
+  // Every copy has different neighbors, since it is not its own neighbor.
+  neighbors.set_size(k, points.NumPoints());
+  distances.set_size(k, points.NumPoints());
+  for (size_t i = 0; i < points.NumPoints(); ++i)
+  {
+    ExpandNeighborColumn<SortPolicy>(points, k, uniqueNeighbors,
+        uniqueDistances, points.UniqueIndices()[i], i, neighbors.colptr(i),
+        distances.colptr(i));
+  }
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
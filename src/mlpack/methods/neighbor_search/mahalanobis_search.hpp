@@ -0,0 +1,122 @@
+/**
+ * @file mahalanobis_search.hpp
+ *
+ * Defines the MahalanobisSearch class, which performs neighbor searches with a
+ * Mahalanobis distance by whitening the data once and searching with the
+ * Euclidean distance.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_MAHALANOBIS_SEARCH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_MAHALANOBIS_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/metrics/mahalanobis_distance.hpp>
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * Neighbor search with a Mahalanobis distance.  NeighborSearch can be used with
+ * a MahalanobisDistance directly, but then each base case multiplies by the d x
+ * d covariance matrix, and the tree bounds do not know about the covariance.
+ * This class instead computes the whitening transformation W of the distance
+ * once (see MahalanobisDistance::Whitening()), under which the Mahalanobis
+ * distance is the Euclidean distance, and runs a NeighborSearch with the
+ * Euclidean distance on the transformed points.  The transformation does not
+ * change the order of the points, so the results are the same as those of
+ * NeighborSearch with the MahalanobisDistance, up to roundoff.
+ *
+ * This makes metrics learned with NCA (or any other Mahalanobis distance)
+ * about as cheap to use as the Euclidean distance.  The transformed datasets
+ * take as much memory as the originals; the originals may be freed once this
+ * object is built.
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam TakeRoot Whether or not the root of the distances is taken (as in
+ *     MahalanobisDistance).
+ */
+template<typename SortPolicy = NearestNeighborSort, bool TakeRoot = true>
+class MahalanobisSearch
+{
+ public:
+  //! The type of the search that is run on the transformed points.
+  typedef NeighborSearch<SortPolicy, metric::LMetric<2, TakeRoot> > SearchType;
+
+  /**
+   * Whiten the given reference and query sets with the given distance, and
+   * build the trees on the transformed points (unless naive is true).
+   *
+   * @param referenceSet Set of reference points.
+   * @param querySet Set of query points.
+   * @param metric The Mahalanobis distance to search with.
+   * @param naive If true, O(n^2) naive search is used.
+   * @param singleMode If true, single-tree search is used.
+   */
+  MahalanobisSearch(const arma::mat& referenceSet,
+                    const arma::mat& querySet,
+                    const metric::MahalanobisDistance<TakeRoot>& metric,
+                    const bool naive = false,
+                    const bool singleMode = false);
+
+  /**
+   * Whiten the given reference set with the given distance, and build a tree
+   * on the transformed points (unless naive is true).  The reference set is
+   * also used as the query set.
+   *
+   * @param referenceSet Set of reference points.
+   * @param metric The Mahalanobis distance to search with.
+   * @param naive If true, O(n^2) naive search is used.
+   * @param singleMode If true, single-tree search is used.
+   */
+  MahalanobisSearch(const arma::mat& referenceSet,
+                    const metric::MahalanobisDistance<TakeRoot>& metric,
+                    const bool naive = false,
+                    const bool singleMode = false);
+
+  //! Delete the search object.
+  ~MahalanobisSearch();
+
+  /**
+   * Compute the k nearest (or furthest) neighbors of each query point under the
+   * Mahalanobis distance, and store the results in the given matrices, exactly
+   * as NeighborSearch::Search() does.
+   *
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void Search(const size_t k,
+              arma::Mat<size_t>& resultingNeighbors,
+              arma::mat& distances);
+
+  //! Get the whitening transformation.
+  const arma::mat& Transformation() const { return transformation; }
+
+  //! Get the search that runs on the transformed points.
+  const SearchType& Searcher() const { return *searcher; }
+  //! Modify the search that runs on the transformed points (for instance, to
+  //! set the number of threads).
+  SearchType& Searcher() { return *searcher; }
+
+ private:
+  //! The whitening transformation.
+  arma::mat transformation;
+
+  //! The search on the transformed points, which holds them.
+  SearchType* searcher;
+
+  // The search can't be shared between copies.
+  MahalanobisSearch(const MahalanobisSearch& other);
+  MahalanobisSearch& operator=(const MahalanobisSearch& other);
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "mahalanobis_search_impl.hpp"
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file mahalanobis_search_impl.hpp
+ *
+ * Implementation of the MahalanobisSearch class.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_MAHALANOBIS_SEARCH_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_MAHALANOBIS_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mahalanobis_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy, bool TakeRoot>
+MahalanobisSearch<SortPolicy, TakeRoot>::MahalanobisSearch(
+    const arma::mat& referenceSet,
+    const arma::mat& querySet,
+    const metric::MahalanobisDistance<TakeRoot>& metric,
+    const bool naive,
+    const bool singleMode) :
+    searcher(NULL)
+{
+  metric.Whitening(transformation);
+
+  // The search takes the memory of the transformed matrices.
+  Timer::Start("whitening");
+  arma::mat whitenedReferences = transformation * referenceSet;
+  arma::mat whitenedQueries = transformation * querySet;
+  Timer::Stop("whitening");
+
+  searcher = new SearchType(&whitenedReferences, &whitenedQueries, naive,
+      singleMode);
+}
+
+template<typename SortPolicy, bool TakeRoot>
+MahalanobisSearch<SortPolicy, TakeRoot>::MahalanobisSearch(
+    const arma::mat& referenceSet,
+    const metric::MahalanobisDistance<TakeRoot>& metric,
+    const bool naive,
+    const bool singleMode) :
+    searcher(NULL)
+{
+  metric.Whitening(transformation);
+
+  Timer::Start("whitening");
+  arma::mat whitenedReferences = transformation * referenceSet;
+  Timer::Stop("whitening");
+
+  searcher = new SearchType(&whitenedReferences, naive, singleMode);
+}
+
+template<typename SortPolicy, bool TakeRoot>
+MahalanobisSearch<SortPolicy, TakeRoot>::~MahalanobisSearch()
+{
+  delete searcher;
+}
+
+template<typename SortPolicy, bool TakeRoot>
+void MahalanobisSearch<SortPolicy, TakeRoot>::Search(
+    const size_t k,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances)
+{
+  // The distances between the transformed points are the Mahalanobis
+  // distances, and the indices are the same, so there is nothing to map back.
+  searcher->Search(k, resultingNeighbors, distances);
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
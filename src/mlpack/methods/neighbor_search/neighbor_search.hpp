@@ -13,7 +13,10 @@
 #include <string>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/indexed_binary_space_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/core/tree/spill_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include "neighbor_search_stat.hpp"
@@ -101,6 +104,47 @@ class NeighborSearch
                  const bool singleMode = false,
                  const MetricType metric = MetricType());
 
+  /**
+   * Initialize the NeighborSearch object with the given reference and query
+   * sets, taking the memory of the matrices instead of copying them: the given
+   * matrices are left empty, and the points are rearranged in place during
+   * tree-building.  The rearranged sets, and the mappings from their new
+   * indices to the original indices, can be taken from ReferenceSet(),
+   * QuerySet(), OldFromNewReferences() and OldFromNewQueries(); the results of
+   * Search() are still given in terms of the original indices.  The two
+   * matrices must be different.
+   *
+   * @param referenceSet Set of reference points (which is emptied).
+   * @param querySet Set of query points (which is emptied).
+   * @param naive If true, O(n^2) naive search will be used (as opposed to
+   *      dual-tree search).  This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param metric An optional instance of the MetricType class.
+   */
+  NeighborSearch(typename TreeType::Mat* referenceSet,
+                 typename TreeType::Mat* querySet,
+                 const bool naive = false,
+                 const bool singleMode = false,
+                 const MetricType metric = MetricType());
+
+  /**
+   * Initialize the NeighborSearch object with only one dataset, which is used
+   * as both the query and the reference dataset, taking the memory of the
+   * matrix instead of copying it (see the constructor above).
+   *
+   * @param referenceSet Set of reference points (which is emptied).
+   * @param naive If true, O(n^2) naive search will be used (as opposed to
+   *      dual-tree search).  This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param metric An optional instance of the MetricType class.
+   */
+  NeighborSearch(typename TreeType::Mat* referenceSet,
+                 const bool naive = false,
+                 const bool singleMode = false,
+                 const MetricType metric = MetricType());
+
   /**
    * Initialize the NeighborSearch object with the given datasets and
    * pre-constructed trees.  It is assumed that the points in referenceSet and
@@ -192,19 +236,136 @@ class NeighborSearch
               arma::Mat<size_t>& resultingNeighbors,
               arma::mat& distances);
 
+  /**
+   * Compute the nearest neighbors of the points of another query set in the
+   * reference set, without rebuilding the reference tree; the query set given
+   * to the constructor (if any) is not changed.  For dual-tree search a tree is
+   * built on a copy of the new query set, and for naive and single-tree search
+   * the points are searched for one by one.  The results are given in terms of
+   * the original indices of both sets, as with the other overload.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void Search(const typename TreeType::Mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& resultingNeighbors,
+              arma::mat& distances);
+
+  /**
+   * Add the given points to the end of the reference set, without rebuilding
+   * the reference tree: the points are inserted into the existing tree (see
+   * BinarySpaceTree::InsertPoints()).  In the results of later searches the new
+   * points have the indices n, n + 1, ..., where n was the number of reference
+   * points before.  If there is no separate query set, the new points are also
+   * queried.
+   *
+   * This is only possible if the reference set was given as a matrix (not as a
+   * tree); the tree type must support insertion.
+   *
+   * @param points Points to add to the reference set.
+   */
+  void Insert(const typename TreeType::Mat& points);
+
+  /**
+   * Remove the points with the given indices from the reference set, without
+   * rebuilding the reference tree (see BinarySpaceTree::RemovePoints()).  The
+   * other points are renumbered as if the columns had been removed from the
+   * original reference set.  As with Insert(), this is only possible if the
+   * reference set was given as a matrix.
+   *
+   * @param indices Indices of the reference points to remove.
+   */
+  void Remove(const std::vector<size_t>& indices);
+
   //! Returns a string representation of this object.
   std::string ToString() const;
 
   //! Return the total number of base case evaluations performed during
   //! searches.
-  size_t BaseCases() const { return baseCases; }
+  size_t BaseCases() const { return statistics.BaseCases(); }
   //! Modify the total number of base case evaluations.
-  size_t& BaseCases() { return baseCases; }
+  size_t& BaseCases() { return statistics.BaseCases(); }
 
   //! Return the number of node combination scores during the search.
-  size_t Scores() const { return scores; }
+  size_t Scores() const { return statistics.Scores(); }
   //! Modify the number of node combination scores.
-  size_t& Scores() { return scores; }
+  size_t& Scores() { return statistics.Scores(); }
+
+  //! Get the traversal statistics of tree building and all searches.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of tree building and all searches.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+  //! Get the reference set.  If this object built the reference tree, this is
+  //! its rearranged copy of the reference set.
+  const typename TreeType::Mat& ReferenceSet() const { return referenceSet; }
+  //! Get the query set (this is the reference set if no query set was given).
+  const typename TreeType::Mat& QuerySet() const { return querySet; }
+  //! Get the original index of each point of ReferenceSet() (empty if the
+  //! reference set was not rearranged).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNewReferences; }
+  //! Get the original index of each point of QuerySet() (empty if the query
+  //! set was not rearranged).
+  const std::vector<size_t>& OldFromNewQueries() const
+  { return oldFromNewQueries; }
+
+  //! Get the number of threads used for search.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for search.  This only has an effect if
+  //! mlpack was compiled with OpenMP.  Single-tree search can use multiple
+  //! threads with any tree type; dual-tree search can only use multiple
+  //! threads if the tree's dual-tree traverser supports parallel traversal
+  //! (i.e. BinarySpaceTree).
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the relative error allowed in the results of tree-based searches.
+  double Epsilon() const { return epsilon; }
+  //! Modify the relative error allowed in the results of tree-based searches.
+  //! With epsilon > 0, nodes are pruned unless they can improve on the current
+  //! kth candidate by more than a factor of (1 + epsilon), so each distance
+  //! found is within a factor of (1 + epsilon) of the true kth distance.  This
+  //! is 0 (exact search) by default, and must not be negative.
+  double& Epsilon() { return epsilon; }
+
+  //! Get whether the results of exact searches are kept for later searches.
+  bool ReuseResults() const { return reuseResults; }
+  //! Modify whether the results of exact searches are kept for later searches.
+  //! If true, each exact Search() of the query set given to the constructor
+  //! keeps a copy of its results (taking as much memory as the results).  A
+  //! later search for at most as many neighbors then just returns the first
+  //! rows of the kept results, and a search for more neighbors starts from
+  //! them: the known neighbors are not offered as candidates again, and only
+  //! the remaining ones are searched for.  The kept results are dropped by
+  //! Insert() and Remove().
+  bool& ReuseResults() { return reuseResults; }
+
+  //! Get whether single-tree searches visit the queries along the Hilbert
+  //! curve.
+  bool ReorderQueries() const { return reorderQueries; }
+  //! Modify whether single-tree searches visit the queries along the Hilbert
+  //! curve (see tree::HilbertOrder()) instead of in the order they were given.
+  //! Consecutive queries then reach the same parts of the reference tree, so
+  //! more of it is still in the cache.  The results are the same (and in the
+  //! same order); only the order of the work changes.  This is false by
+  //! default.
+  bool& ReorderQueries() { return reorderQueries; }
+
+  //! Get whether single-tree searches are seeded with earlier results.
+  bool SeedQueries() const { return seedQueries; }
+  //! Modify whether single-tree searches are seeded with earlier results.  If
+  //! true, the neighbors found for the last query searched (by the same
+  //! thread) are offered as candidates to each query before it is searched
+  //! (see NeighborSearchRules::Seed()), so that it starts with a bound instead
+  //! of none.  This costs about k more base cases per query, and pays off when
+  //! consecutive queries are close, as with ReorderQueries().  This is false
+  //! by default.
+  bool& SeedQueries() { return seedQueries; }
 
  private:
   //! Copy of reference dataset (if we need it, because tree building modifies
@@ -241,10 +402,66 @@ class NeighborSearch
   //! Permutations of query points during tree building.
   std::vector<size_t> oldFromNewQueries;
 
-  //! The total number of base cases.
-  size_t baseCases;
-  //! The total number of scores (applicable for non-naive search).
-  size_t scores;
+  //! The traversal statistics of tree building and all searches.
+  tree::TraversalStatistics statistics;
+
+  //! The number of threads to use for search.
+  size_t numThreads;
+
+  //! The relative error allowed in the results.
+  double epsilon;
+
+  //! If true, the results of exact searches are kept for later searches.
+  bool reuseResults;
+  //! The kept neighbors of the last exact search of the query set, sorted and
+  //! in terms of the rearranged sets.
+  arma::Mat<size_t> lastNeighbors;
+  //! The kept distances of the last exact search of the query set.
+  arma::mat lastDistances;
+
+  //! If true, single-tree searches visit the queries along the Hilbert curve.
+  bool reorderQueries;
+  //! If true, single-tree searches are seeded with the results of the last
+  //! query searched.
+  bool seedQueries;
+
+  /**
+   * Search for the neighbors of the given query set, with rules that keep the
+   * candidates of each query point with the given CandidateListType, and sort
+   * the results (which are not unmapped).
+   *
+   * @param querySet Set of query points.
+   * @param queryRoot Root of the tree built on the query set (unused for naive
+   *     and single-tree search).
+   * @param monochromatic Whether the query set is the reference set.
+   * @param resultingNeighbors Candidate neighbors, set up for the search.
+   * @param distances Candidate distances, set up for the search.
+   * @param knownNeighbors Neighbors that are not offered as candidates (see
+   *     NeighborSearchRules::KnownNeighbors()), or NULL.
+   */
+  template<typename CandidateListType>
+  void RunSearch(const typename TreeType::Mat& querySet,
+                 TreeType* queryRoot,
+                 const bool monochromatic,
+                 arma::Mat<size_t>& resultingNeighbors,
+                 arma::mat& distances,
+                 const arma::Mat<size_t>* knownNeighbors);
+
+  /**
+   * Run the search of the given rules with the traversal of this object's mode
+   * (naive, single-tree, or dual-tree), and accumulate the statistics.
+   *
+   * @param rules Rules of the search, holding the candidates.
+   * @param querySet Set of query points of the rules.
+   * @param queryRoot Root of the tree built on the query set (unused for naive
+   *     and single-tree search).
+   * @param monochromatic Whether the query set is the reference set.
+   */
+  template<typename RuleType>
+  void Traverse(RuleType& rules,
+                const typename TreeType::Mat& querySet,
+                TreeType* queryRoot,
+                const bool monochromatic);
 
 }; // class NeighborSearch
 
@@ -10,7 +10,13 @@
 
 #include <mlpack/core.hpp>
 
+#include <mlpack/core/tree/count_nodes.hpp>
+#include <mlpack/core/tree/hilbert_curve.hpp>
+#include <mlpack/core/tree/symmetric_dual_tree_traverser.hpp>
+
 #include "neighbor_search_rules.hpp"
+#include "single_candidate.hpp"
+#include "unmap.hpp"
 
 namespace mlpack {
 namespace neighbor {
@@ -24,7 +30,9 @@ TreeType* BuildTree(
         tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
     >::type = 0)
 {
-  return new TreeType(dataset, oldFromNew);
+  TreeType* root = new TreeType(dataset, oldFromNew);
+  MemoryTracker::AddCounter("tree_nodes", tree::CountNodes(*root));
+  return root;
 }
 
 //! Call the tree constructor that does not do mapping.
@@ -36,7 +44,62 @@ TreeType* BuildTree(
         tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
     >::type = 0)
 {
-  return new TreeType(dataset);
+  TreeType* root = new TreeType(dataset);
+  MemoryTracker::AddCounter("tree_nodes", tree::CountNodes(*root));
+  return root;
+}
+
+//! Detect whether a dual-tree traverser can split its work into OpenMP tasks.
+HAS_MEM_FUNC(TraverseParallel, HasTraverseParallel);
+
+//! Run the dual-tree traversal in parallel, splitting the query tree into
+//! OpenMP tasks.
+template<typename TraverserType, typename TreeType>
+void DualTreeTraversal(
+    TraverserType& traverser,
+    TreeType& queryTree,
+    TreeType& referenceTree,
+    const size_t numThreads,
+    const typename boost::enable_if_c<
+        HasTraverseParallel<TraverserType,
+            void (TraverserType::*)(TreeType&, TreeType&, const size_t)>::value,
+        TraverserType*
+    >::type = 0)
+{
+  if (numThreads <= 1)
+  {
+    traverser.Traverse(queryTree, referenceTree);
+    return;
+  }
+
+  // Split the query tree deep enough that there are a few tasks for each
+  // thread; this gives the OpenMP runtime some slack to balance the load when
+  // the subtrees take different amounts of time.
+  size_t splitDepth = 0;
+  while (((size_t) 1 << splitDepth) < 4 * numThreads)
+    ++splitDepth;
+
+  #pragma omp parallel num_threads(numThreads)
+  {
+    #pragma omp single
+    traverser.TraverseParallel(queryTree, referenceTree, splitDepth);
+  }
+}
+
+//! Run the dual-tree traversal serially; the traverser has no parallel mode.
+template<typename TraverserType, typename TreeType>
+void DualTreeTraversal(
+    TraverserType& traverser,
+    TreeType& queryTree,
+    TreeType& referenceTree,
+    const size_t /* numThreads */,
+    const typename boost::enable_if_c<
+        !HasTraverseParallel<TraverserType,
+            void (TraverserType::*)(TreeType&, TreeType&, const size_t)>::value,
+        TraverserType*
+    >::type = 0)
+{
+  traverser.Traverse(queryTree, referenceTree);
 }
 
 // Construct the object.
@@ -58,20 +121,26 @@ NeighborSearch(const typename TreeType::Mat& referenceSetIn,
     naive(naive),
     singleMode(!naive && singleMode), // No single mode if naive.
     metric(metric),
-    baseCases(0),
-    scores(0)
+    numThreads(1),
+    epsilon(0.0),
+    reuseResults(false),
+    reorderQueries(false),
+    seedQueries(false)
 {
   // C++11 will allow us to call out to other constructors so we can avoid this
   // copypasta problem.
 
   // We'll time tree building, but only if we are building trees.
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   // Copy the datasets, if they will be modified during tree building.
   if (tree::TreeTraits<TreeType>::RearrangesDataset)
   {
     referenceCopy = referenceSetIn;
     queryCopy = querySetIn;
+    MemoryTracker::AddCounter("dataset_copy_bytes", (referenceCopy.n_elem +
+        queryCopy.n_elem) * sizeof(typename TreeType::Mat::elem_type));
   }
 
   // If not in naive mode, then we need to build trees.
@@ -90,6 +159,7 @@ NeighborSearch(const typename TreeType::Mat& referenceSetIn,
   }
 
   // Stop the timer we started above (if we need to).
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
 }
 
@@ -111,15 +181,23 @@ NeighborSearch(const typename TreeType::Mat& referenceSetIn,
     naive(naive),
     singleMode(!naive && singleMode), // No single mode if naive.
     metric(metric),
-    baseCases(0),
-    scores(0)
+    numThreads(1),
+    epsilon(0.0),
+    reuseResults(false),
+    reorderQueries(false),
+    seedQueries(false)
 {
   // We'll time tree building, but only if we are building trees.
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   // Copy the dataset, if it will be modified during tree building.
   if (tree::TreeTraits<TreeType>::RearrangesDataset)
+  {
     referenceCopy = referenceSetIn;
+    MemoryTracker::AddCounter("dataset_copy_bytes", referenceCopy.n_elem *
+        sizeof(typename TreeType::Mat::elem_type));
+  }
 
   // If not in naive mode, then we may need to construct trees.
   if (!naive)
@@ -132,10 +210,106 @@ NeighborSearch(const typename TreeType::Mat& referenceSetIn,
         oldFromNewReferences);
 
     if (!singleMode)
+    {
       queryTree = new TreeType(*referenceTree);
+      MemoryTracker::AddCounter("tree_nodes", tree::CountNodes(*queryTree));
+    }
   }
 
   // Stop the timer we started above.
+  statistics.StopPhase("tree_building");
+  Timer::Stop("tree_building");
+}
+
+// Construct the object, taking the memory of the datasets.
+template<typename SortPolicy, typename MetricType, typename TreeType>
+NeighborSearch<SortPolicy, MetricType, TreeType>::
+NeighborSearch(typename TreeType::Mat* referenceSetIn,
+               typename TreeType::Mat* querySetIn,
+               const bool naive,
+               const bool singleMode,
+               const MetricType metric) :
+    referenceSet(referenceCopy),
+    querySet(queryCopy),
+    referenceTree(NULL),
+    queryTree(NULL),
+    treeOwner(!naive), // If naive, then we are not building any trees.
+    hasQuerySet(true),
+    naive(naive),
+    singleMode(!naive && singleMode), // No single mode if naive.
+    metric(metric),
+    numThreads(1),
+    epsilon(0.0),
+    reuseResults(false),
+    reorderQueries(false),
+    seedQueries(false)
+{
+  if (referenceSetIn == querySetIn)
+    Log::Fatal << "NeighborSearch::NeighborSearch(): the reference set and "
+        << "the query set must be different matrices!" << std::endl;
+
+  // We'll time tree building, but only if we are building trees.
+  Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
+
+  // The trees are built on the memory of the given datasets; nothing is copied
+  // (unless the memory cannot be taken, as with matrices using auxiliary
+  // memory).
+  referenceCopy.steal_mem(*referenceSetIn);
+  queryCopy.steal_mem(*querySetIn);
+
+  if (!naive)
+  {
+    referenceTree = BuildTree<TreeType>(referenceCopy, oldFromNewReferences);
+
+    if (!singleMode)
+      queryTree = BuildTree<TreeType>(queryCopy, oldFromNewQueries);
+  }
+
+  statistics.StopPhase("tree_building");
+  Timer::Stop("tree_building");
+}
+
+// Construct the object, taking the memory of the dataset.
+template<typename SortPolicy, typename MetricType, typename TreeType>
+NeighborSearch<SortPolicy, MetricType, TreeType>::
+NeighborSearch(typename TreeType::Mat* referenceSetIn,
+               const bool naive,
+               const bool singleMode,
+               const MetricType metric) :
+    referenceSet(referenceCopy),
+    querySet(referenceCopy),
+    referenceTree(NULL),
+    queryTree(NULL),
+    treeOwner(!naive), // If naive, then we are not building any trees.
+    hasQuerySet(false),
+    naive(naive),
+    singleMode(!naive && singleMode), // No single mode if naive.
+    metric(metric),
+    numThreads(1),
+    epsilon(0.0),
+    reuseResults(false),
+    reorderQueries(false),
+    seedQueries(false)
+{
+  // We'll time tree building, but only if we are building trees.
+  Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
+
+  referenceCopy.steal_mem(*referenceSetIn);
+
+  if (!naive)
+  {
+    referenceTree = BuildTree<TreeType>(referenceCopy, oldFromNewReferences);
+
+    if (!singleMode)
+    {
+      queryTree = new TreeType(*referenceTree);
+      MemoryTracker::AddCounter("tree_nodes", tree::CountNodes(*queryTree));
+    }
+  }
+
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
 }
 
@@ -157,8 +331,11 @@ NeighborSearch<SortPolicy, MetricType, TreeType>::NeighborSearch(
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    baseCases(0),
-    scores(0)
+    numThreads(1),
+    epsilon(0.0),
+    reuseResults(false),
+    reorderQueries(false),
+    seedQueries(false)
 {
   // Nothing else to initialize.
 }
@@ -179,15 +356,20 @@ NeighborSearch<SortPolicy, MetricType, TreeType>::NeighborSearch(
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    baseCases(0),
-    scores(0)
+    numThreads(1),
+    epsilon(0.0),
+    reuseResults(false),
+    reorderQueries(false),
+    seedQueries(false)
 {
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   // The query tree cannot be the same as the reference tree.
   if (referenceTree && !singleMode)
     queryTree = new TreeType(*referenceTree);
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
 }
 
@@ -222,43 +404,240 @@ void NeighborSearch<SortPolicy, MetricType, TreeType>::Search(
     arma::Mat<size_t>& resultingNeighbors,
     arma::mat& distances)
 {
+  if (epsilon < 0)
+  {
+    Log::Fatal << "NeighborSearch::Search(): epsilon must be non-negative ("
+        << epsilon << " given)." << std::endl;
+  }
+
   Timer::Start("computing_neighbors");
+  statistics.StartPhase("traversal");
 
   // If we have built the trees ourselves, then we will have to map all the
   // indices back to their original indices when this computation is finished.
-  // To avoid an extra copy, we will store the neighbors and distances in a
-  // separate matrix.
-  arma::Mat<size_t>* neighborPtr = &resultingNeighbors;
-  arma::mat* distancePtr = &distances;
+  // The results are mapped in place, so no extra copy of them is made.
 
-  // Mapping is only necessary if the tree rearranges points.
-  if (tree::TreeTraits<TreeType>::RearrangesDataset)
+  // The kept results of an earlier exact search can only be used by an exact
+  // search.
+  const bool reuse = reuseResults && (epsilon == 0.0) &&
+      (lastNeighbors.n_rows > 0) && (lastNeighbors.n_cols == querySet.n_cols);
+
+  // Set the size of the neighbor and distance matrices.
+  resultingNeighbors.set_size(k, querySet.n_cols);
+  distances.set_size(k, querySet.n_cols);
+
+  if (reuse && k <= lastNeighbors.n_rows)
+  {
+    // The kept results are sorted, so their first k rows are the results.
+    if (k > 0)
+    {
+      resultingNeighbors = lastNeighbors.rows(0, k - 1);
+      distances = lastDistances.rows(0, k - 1);
+    }
+  }
+  else
   {
-    if (treeOwner && !(singleMode && hasQuerySet))
-      distancePtr = new arma::mat; // Query indices need to be mapped.
+    resultingNeighbors.fill(size_t() - 1);
+    distances.fill(SortPolicy::WorstDistance());
+
+    // To extend the kept results, the heap of each query point starts with
+    // its kept neighbors, which the rules will not offer as candidates again.
+    // A column whose candidates never get worse from top to bottom is a valid
+    // heap, so the kept neighbors go after the empty slots, worst first.
+    arma::Mat<size_t> known;
+    if (reuse)
+    {
+      const size_t lastK = lastNeighbors.n_rows;
+      for (size_t i = 0; i < querySet.n_cols; ++i)
+      {
+        for (size_t j = 0; j < lastK; ++j)
+        {
+          resultingNeighbors(k - 1 - j, i) = lastNeighbors(j, i);
+          distances(k - 1 - j, i) = lastDistances(j, i);
+        }
+      }
+
+      known = arma::sort(lastNeighbors);
+    }
+
+    // The bounds cached in the query tree by an earlier search don't hold for a
+    // search for more neighbors, so they are reset.  A query tree that was
+    // given to us is left as it is, so that its owner can carry the bounds
+    // from one search to the next (as DTNNKMeans does).
+    if (queryTree != NULL && (treeOwner || !hasQuerySet))
+      NeighborSearchRules<SortPolicy, MetricType, TreeType>::ResetBounds(
+          *queryTree);
 
-    if (treeOwner)
-      neighborPtr = new arma::Mat<size_t>; // All indices need mapping.
+    // With k = 1, only the best candidate of each query point is kept.
+    if (k == 1)
+    {
+      RunSearch<SingleCandidate<SortPolicy> >(querySet, queryTree,
+          !hasQuerySet, resultingNeighbors, distances,
+          reuse ? &known : NULL);
+    }
+    else
+    {
+      RunSearch<CandidateHeap<SortPolicy> >(querySet, queryTree, !hasQuerySet,
+          resultingNeighbors, distances, reuse ? &known : NULL);
+    }
+
+    if (reuseResults && epsilon == 0.0)
+    {
+      lastNeighbors = resultingNeighbors;
+      lastDistances = distances;
+    }
   }
 
-  // Set the size of the neighbor and distance matrices.
-  neighborPtr->set_size(k, querySet.n_cols);
-  neighborPtr->fill(size_t() - 1);
-  distancePtr->set_size(k, querySet.n_cols);
-  distancePtr->fill(SortPolicy::WorstDistance());
+  statistics.StopPhase("traversal");
+  Timer::Stop("computing_neighbors");
 
+  // Now, do we need to do mapping of indices?
+  if (!treeOwner || !tree::TreeTraits<TreeType>::RearrangesDataset)
+  {
+    // No mapping needed.  We are done.
+    return;
+  }
+  else if (treeOwner && hasQuerySet && !singleMode) // Map both sets.
+  {
+    Unmap(resultingNeighbors, distances, oldFromNewReferences,
+        oldFromNewQueries);
+  }
+  else if (treeOwner && !hasQuerySet)
+  {
+    Unmap(resultingNeighbors, distances, oldFromNewReferences,
+        oldFromNewReferences);
+  }
+  else if (treeOwner && hasQuerySet && singleMode) // Map only references.
+  {
+    Unmap(resultingNeighbors, distances, oldFromNewReferences);
+  }
+} // Search
+
+/**
+ * Computes the best neighbors of the points of another query set and stores
+ * them in resultingNeighbors and distances.
+ */
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearch<SortPolicy, MetricType, TreeType>::Search(
+    const typename TreeType::Mat& querySetIn,
+    const size_t k,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances)
+{
+  if (epsilon < 0)
+  {
+    Log::Fatal << "NeighborSearch::Search(): epsilon must be non-negative ("
+        << epsilon << " given)." << std::endl;
+  }
+
+  // Dual-tree search needs a tree on the new query points, which is built on a
+  // copy of them (it may be rearranged).
+  typename TreeType::Mat batchCopy;
+  std::vector<size_t> oldFromNewBatch;
+  TreeType* batchTree = NULL;
+  if (!naive && !singleMode)
+  {
+    Timer::Start("tree_building");
+    statistics.StartPhase("tree_building");
+
+    batchCopy = querySetIn;
+    MemoryTracker::AddCounter("dataset_copy_bytes", batchCopy.n_elem *
+        sizeof(typename TreeType::Mat::elem_type));
+    batchTree = BuildTree<TreeType>(batchCopy, oldFromNewBatch);
+
+    statistics.StopPhase("tree_building");
+    Timer::Stop("tree_building");
+  }
+  const typename TreeType::Mat& batch = (batchTree == NULL) ? querySetIn :
+      batchCopy;
+
+  Timer::Start("computing_neighbors");
+  statistics.StartPhase("traversal");
+
+  resultingNeighbors.set_size(k, batch.n_cols);
+  resultingNeighbors.fill(size_t() - 1);
+  distances.set_size(k, batch.n_cols);
+  distances.fill(SortPolicy::WorstDistance());
+
+  if (k == 1)
+  {
+    RunSearch<SingleCandidate<SortPolicy> >(batch, batchTree, false,
+        resultingNeighbors, distances, NULL);
+  }
+  else
+  {
+    RunSearch<CandidateHeap<SortPolicy> >(batch, batchTree, false,
+        resultingNeighbors, distances, NULL);
+  }
+
+  const bool mapQueries = (batchTree != NULL) &&
+      tree::TreeTraits<TreeType>::RearrangesDataset;
+  delete batchTree;
+
+  statistics.StopPhase("traversal");
+  Timer::Stop("computing_neighbors");
+
+  // The reference set was rearranged if we built the reference tree.
+  const bool mapReferences = treeOwner &&
+      tree::TreeTraits<TreeType>::RearrangesDataset;
+  if (mapQueries && mapReferences)
+  {
+    Unmap(resultingNeighbors, distances, oldFromNewReferences,
+        oldFromNewBatch);
+  }
+  else if (mapQueries)
+  {
+    // The reference indices are already the original ones.
+    std::vector<size_t> identity(referenceSet.n_cols);
+    for (size_t i = 0; i < identity.size(); ++i)
+      identity[i] = i;
+
+    Unmap(resultingNeighbors, distances, identity, oldFromNewBatch);
+  }
+  else if (mapReferences)
+  {
+    Unmap(resultingNeighbors, distances, oldFromNewReferences);
+  }
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+template<typename CandidateListType>
+void NeighborSearch<SortPolicy, MetricType, TreeType>::RunSearch(
+    const typename TreeType::Mat& querySetIn,
+    TreeType* queryRoot,
+    const bool monochromatic,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances,
+    const arma::Mat<size_t>* knownNeighbors)
+{
   // Create the helper object for the tree traversal.
-  typedef NeighborSearchRules<SortPolicy, MetricType, TreeType> RuleType;
-  RuleType rules(referenceSet, querySet, *neighborPtr, *distancePtr, metric);
+  typedef NeighborSearchRules<SortPolicy, MetricType, TreeType,
+      CandidateListType> RuleType;
+  RuleType rules(referenceSet, querySetIn, resultingNeighbors, distances,
+      metric, epsilon);
+  rules.KnownNeighbors() = knownNeighbors;
+
+  Traverse(rules, querySetIn, queryRoot, monochromatic);
+
+  // The candidates for each query point may be held as a heap during the
+  // search; now turn them into sorted lists.
+  CandidateListType::Sort(resultingNeighbors, distances);
+}
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+template<typename RuleType>
+void NeighborSearch<SortPolicy, MetricType, TreeType>::Traverse(
+    RuleType& rules,
+    const typename TreeType::Mat& querySetIn,
+    TreeType* queryRoot,
+    const bool monochromatic)
+{
   if (naive)
   {
     // The naive brute-force traversal.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
+    for (size_t i = 0; i < querySetIn.n_cols; ++i)
       for (size_t j = 0; j < referenceSet.n_cols; ++j)
         rules.BaseCase(i, j);
-
-    baseCases += querySet.n_cols * referenceSet.n_cols;
   }
   else if (singleMode)
   {
@@ -266,15 +645,73 @@ void NeighborSearch<SortPolicy, MetricType, TreeType>::Search(
     // If this is the case, it is suggested that you use the naive method.
     Log::Assert(!(referenceTree->IsLeaf()));
 
-    // Create the traverser.
-    typename TreeType::template SingleTreeTraverser<RuleType> traverser(rules);
+    // Visit the query points along the Hilbert curve, if requested, so that
+    // consecutive query points (which a thread mostly takes one after another)
+    // are close, and reach the same parts of the reference tree.  Each query
+    // point still writes its results to its own column, so nothing has to be
+    // put back in order afterwards.
+    std::vector<size_t> order;
+    if (reorderQueries)
+      tree::HilbertOrder(querySetIn, order);
+
+    // The query points are independent, so we can split them across threads.
+    // Each thread gets its own copy of the rules and its own traverser, and
+    // each query point only writes to its own column of the results, so no
+    // locking is necessary.
+    #pragma omp parallel num_threads(numThreads)
+    {
+      RuleType threadRules(rules);
+
+      // Trees with self-children cache per-query base case results in the
+      // statistics of the reference nodes, so each thread must use its own
+      // copy of the reference tree (this does not copy the dataset).
+      TreeType* threadTree = referenceTree;
+      if (tree::TreeTraits<TreeType>::HasSelfChildren && numThreads > 1)
+        threadTree = new TreeType(*referenceTree);
+
+      // Create the traverser.
+      typename TreeType::template SingleTreeTraverser<RuleType>
+          traverser(threadRules);
+
+      // Now have it traverse for each point.  If seeding is requested, each
+      // search starts from the neighbors of the last query point this thread
+      // searched, whose results are final.
+      size_t lastQuery = size_t() - 1;
+      #pragma omp for schedule(dynamic, 16)
+      for (size_t i = 0; i < querySetIn.n_cols; ++i)
+      {
+        const size_t queryIndex = order.empty() ? i : order[i];
+        if (seedQueries && lastQuery != size_t() - 1)
+          threadRules.Seed(queryIndex, lastQuery);
 
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+        traverser.Traverse(queryIndex, *threadTree);
+        lastQuery = queryIndex;
+      }
 
-    scores += rules.Scores();
-    baseCases += rules.BaseCases();
+      if (threadTree != referenceTree)
+        delete threadTree;
+
+      #pragma omp critical
+      {
+        rules.Statistics() += threadRules.Statistics();
+      }
+    }
+
+    Log::Info << rules.Scores() << " node combinations were scored.\n";
+    Log::Info << rules.BaseCases() << " base cases were calculated.\n";
+  }
+  else if (monochromatic && numThreads <= 1 &&
+           !tree::TreeTraits<TreeType>::HasSelfChildren &&
+           !tree::TreeTraits<TreeType>::HasDuplicatedPoints)
+  {
+    // The query set is the reference set, so traverse the tree against itself
+    // and evaluate each distance once, for both points.  The symmetric
+    // traversal is serial, and trees that hold a point in several leaves would
+    // evaluate some pairs more than once, so they use the dual-tree traverser.
+    RuleType::ResetSymmetricBounds(*queryRoot);
+
+    tree::SymmetricDualTreeTraverser<TreeType, RuleType> traverser(rules);
+    traverser.Traverse(*queryRoot);
 
     Log::Info << rules.Scores() << " node combinations were scored.\n";
     Log::Info << rules.BaseCases() << " base cases were calculated.\n";
@@ -282,89 +719,104 @@ void NeighborSearch<SortPolicy, MetricType, TreeType>::Search(
   else // Dual-tree recursion.
   {
     // Create the traverser.
-    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
-
-    traverser.Traverse(*queryTree, *referenceTree);
+    typedef typename TreeType::template DualTreeTraverser<RuleType>
+        TraverserType;
+    TraverserType traverser(rules);
 
-    scores += rules.Scores();
-    baseCases += rules.BaseCases();
+    DualTreeTraversal(traverser, *queryRoot, *referenceTree, numThreads);
 
     Log::Info << rules.Scores() << " node combinations were scored.\n";
     Log::Info << rules.BaseCases() << " base cases were calculated.\n";
   }
 
-  Timer::Stop("computing_neighbors");
+  statistics += rules.Statistics();
+}
 
-  // Now, do we need to do mapping of indices?
-  if (!treeOwner || !tree::TreeTraits<TreeType>::RearrangesDataset)
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearch<SortPolicy, MetricType, TreeType>::Insert(
+    const typename TreeType::Mat& points)
+{
+  // We can only change the reference set if it is our own copy.
+  if (&referenceSet != &referenceCopy)
   {
-    // No mapping needed.  We are done.
-    return;
+    Log::Fatal << "NeighborSearch::Insert(): the reference set can only be "
+        << "changed if it was given as a matrix and copied." << std::endl;
   }
-  else if (treeOwner && hasQuerySet && !singleMode) // Map both sets.
-  {
-    // Set size of output matrices correctly.
-    resultingNeighbors.set_size(k, querySet.n_cols);
-    distances.set_size(k, querySet.n_cols);
 
-    for (size_t i = 0; i < distances.n_cols; i++)
-    {
-      // Map distances (copy a column).
-      distances.col(oldFromNewQueries[i]) = distancePtr->col(i);
+  // The kept results are for the old reference set.
+  lastNeighbors.reset();
+  lastDistances.reset();
 
-      // Map indices of neighbors.
-      for (size_t j = 0; j < distances.n_rows; j++)
-      {
-        resultingNeighbors(j, oldFromNewQueries[i]) =
-            oldFromNewReferences[(*neighborPtr)(j, i)];
-      }
-    }
+  Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
-    // Finished with temporary matrices.
-    delete neighborPtr;
-    delete distancePtr;
+  if (naive)
+  {
+    referenceCopy.insert_cols(referenceCopy.n_cols, points);
   }
-  else if (treeOwner && !hasQuerySet)
+  else
   {
-    resultingNeighbors.set_size(k, querySet.n_cols);
-    distances.set_size(k, querySet.n_cols);
+    referenceTree->InsertPoints(points, oldFromNewReferences);
 
-    for (size_t i = 0; i < distances.n_cols; i++)
+    // For monochromatic dual-tree search, the query tree is a copy of the
+    // reference tree, so it has to be copied again.
+    if (!hasQuerySet && !singleMode)
     {
-      // Map distances (copy a column).
-      distances.col(oldFromNewReferences[i]) = distancePtr->col(i);
-
-      // Map indices of neighbors.
-      for (size_t j = 0; j < distances.n_rows; j++)
-      {
-        resultingNeighbors(j, oldFromNewReferences[i]) =
-            oldFromNewReferences[(*neighborPtr)(j, i)];
-      }
+      delete queryTree;
+      queryTree = new TreeType(*referenceTree);
     }
+  }
+
+  statistics.StopPhase("tree_building");
+  Timer::Stop("tree_building");
+}
 
-    // Finished with temporary matrices.
-    delete neighborPtr;
-    delete distancePtr;
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearch<SortPolicy, MetricType, TreeType>::Remove(
+    const std::vector<size_t>& indices)
+{
+  if (&referenceSet != &referenceCopy)
+  {
+    Log::Fatal << "NeighborSearch::Remove(): the reference set can only be "
+        << "changed if it was given as a matrix and copied." << std::endl;
   }
-  else if (treeOwner && hasQuerySet && singleMode) // Map only references.
+
+  // The kept results are for the old reference set.
+  lastNeighbors.reset();
+  lastDistances.reset();
+
+  Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
+
+  if (naive)
   {
-    // Set size of neighbor indices matrix correctly.
-    resultingNeighbors.set_size(k, querySet.n_cols);
+    // The points are in their original order, so just drop the columns.
+    std::vector<bool> removed(referenceCopy.n_cols, false);
+    for (size_t i = 0; i < indices.size(); ++i)
+      removed[indices[i]] = true;
 
-    // Map indices of neighbors.
-    for (size_t i = 0; i < resultingNeighbors.n_cols; i++)
+    size_t next = 0;
+    for (size_t i = 0; i < referenceCopy.n_cols; ++i)
+      if (!removed[i])
+        referenceCopy.col(next++) = referenceCopy.col(i);
+
+    referenceCopy.resize(referenceCopy.n_rows, next);
+  }
+  else
+  {
+    referenceTree->RemovePoints(indices, oldFromNewReferences);
+
+    if (!hasQuerySet && !singleMode)
     {
-      for (size_t j = 0; j < resultingNeighbors.n_rows; j++)
-      {
-        resultingNeighbors(j, i) = oldFromNewReferences[(*neighborPtr)(j, i)];
-      }
+      delete queryTree;
+      queryTree = new TreeType(*referenceTree);
     }
-
-    // Finished with temporary matrix.
-    delete neighborPtr;
   }
-} // Search
 
+  statistics.StopPhase("tree_building");
+  Timer::Stop("tree_building");
+}
 
 //Return a String of the Object.
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -8,12 +8,33 @@
 #ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_RULES_HPP
 #define __MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_RULES_HPP
 
+#include <mlpack/core/tree/leaf_block_distances.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
 #include "ns_traversal_info.hpp"
+#include "candidate_heap.hpp"
+#include "single_candidate.hpp"
 
 namespace mlpack {
 namespace neighbor {
 
-template<typename SortPolicy, typename MetricType, typename TreeType>
+/**
+ * The rules for a tree-based search for the k best neighbors of each query
+ * point.  The candidates for each query point are kept by the
+ * CandidateListType: by default a CandidateHeap, which holds any number of
+ * candidates; a SingleCandidate holds just the best one, which is all that is
+ * needed when k = 1, without the upkeep of a heap.
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam MetricType The metric to use for computation.
+ * @tparam TreeType The tree type to use.
+ * @tparam CandidateListType The way the candidates of each query point are
+ *     kept; CandidateHeap<SortPolicy> or SingleCandidate<SortPolicy>.
+ */
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType = CandidateHeap<SortPolicy> >
 class NeighborSearchRules
 {
  public:
@@ -21,17 +42,41 @@ class NeighborSearchRules
                       const typename TreeType::Mat& querySet,
                       arma::Mat<size_t>& neighbors,
                       arma::mat& distances,
-                      MetricType& metric);
+                      MetricType& metric,
+                      const double epsilon = 0.0);
   /**
    * Get the distance from the query point to the reference point.
    * This will update the "neighbor" matrix with the new point if appropriate
    * and will track the number of base cases (number of points evaluated).
    *
+   * For nearest neighbor search with a metric that has EvaluateBounded() (such
+   * as LMetric), the evaluation stops once the distance is known to be greater
+   * than that of the worst candidate of the query point, and a lower bound on
+   * the distance is returned instead, unless the first point of each node of
+   * the tree is its centroid.
+   *
    * @param queryIndex Index of query point.
    * @param referenceIndex Index of reference point.
    */
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Evaluate the base cases between the given points of the query leaf (those
+   * that Score() did not prune) and every point in the reference leaf at once,
+   * if the metric allows the distances to be computed with a matrix
+   * multiplication (see metric::BlockDistances()).  If it does not, nothing is
+   * done and false is returned, and BaseCase() must be called for each pair
+   * instead.
+   *
+   * @param queryNode Query leaf.
+   * @param queryPoints Offsets in the query leaf of the points to evaluate.
+   * @param referenceNode Reference leaf.
+   * @return true if the base cases were evaluated.
+   */
+  bool BaseCases(TreeType& queryNode,
+                 const std::vector<size_t>& queryPoints,
+                 TreeType& referenceNode);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -82,15 +127,103 @@ class NeighborSearchRules
                  TreeType& referenceNode,
                  const double oldScore) const;
 
+  /**
+   * Evaluate the distance between two distinct points of a monochromatic
+   * search, and offer each point as a candidate to the other; this is used by
+   * tree::SymmetricDualTreeTraverser, which visits each pair of points once.
+   *
+   * @param indexA Index of the first point.
+   * @param indexB Index of the second point.
+   */
+  double SymmetricBaseCase(const size_t indexA, const size_t indexB);
+
+  /**
+   * Score a pair of distinct nodes of a monochromatic search.  The pair is
+   * only pruned (DBL_MAX is returned) if neither node can hold a better
+   * candidate for any point of the other.  The bounds of the nodes are cached
+   * in the FirstBound() of their statistics, so they must be reset (see
+   * ResetSymmetricBounds()) before each traversal.
+   *
+   * @param nodeA First node.
+   * @param nodeB Second node.
+   */
+  double SymmetricScore(TreeType& nodeA, TreeType& nodeB);
+
+  /**
+   * Re-evaluate the score of a pair of distinct nodes of a monochromatic
+   * search against the current bounds of the nodes.
+   *
+   * @param nodeA First node.
+   * @param nodeB Second node.
+   * @param oldScore Old score produced by SymmetricScore() (or
+   *     SymmetricRescore()).
+   */
+  double SymmetricRescore(TreeType& nodeA,
+                          TreeType& nodeB,
+                          const double oldScore);
+
+  /**
+   * Reset the bounds cached by SymmetricScore() in the statistics of the given
+   * node and its descendants.
+   *
+   * @param node Node to reset the bounds of.
+   */
+  static void ResetSymmetricBounds(TreeType& node);
+
+  /**
+   * Reset the bounds cached by Score() in the statistics of the given query
+   * node and its descendants.  The cached bounds of one search are only valid
+   * for later searches of the same query points for at most as many neighbors,
+   * so a query tree must be reset before it is searched again otherwise.
+   *
+   * @param node Node to reset the bounds of.
+   */
+  static void ResetBounds(TreeType& node);
+
+  /**
+   * Offer the candidates of another query point as candidates for the given
+   * query point, before it is searched.  If the two points are close, the
+   * search then starts with a bound that is close to the final one, and prunes
+   * more from the start.  The results of the search are the same: the seeded
+   * candidates are not offered again when the search reaches them.  Only the
+   * last query point seeded is tracked, so it should be searched before the
+   * next one is seeded.
+   *
+   * @param queryIndex Index of the query point to seed.
+   * @param seedIndex Index of the query point whose candidates are offered
+   *     (its search should be done).
+   */
+  void Seed(const size_t queryIndex, const size_t seedIndex);
+
   //! Get the number of base cases that have been performed.
-  size_t BaseCases() const { return baseCases; }
+  size_t BaseCases() const { return statistics.BaseCases(); }
   //! Modify the number of base cases that have been performed.
-  size_t& BaseCases() { return baseCases; }
+  size_t& BaseCases() { return statistics.BaseCases(); }
 
   //! Get the number of scores that have been performed.
-  size_t Scores() const { return scores; }
+  size_t Scores() const { return statistics.Scores(); }
   //! Modify the number of scores that have been performed.
-  size_t& Scores() { return scores; }
+  size_t& Scores() { return statistics.Scores(); }
+
+  //! Get the relative error allowed when pruning.
+  double Epsilon() const { return epsilon; }
+
+  //! Get the query set.  (Defeatist traversals, which follow the query points
+  //! down the reference tree, need their coordinates.)
+  const typename TreeType::Mat& QuerySet() const { return querySet; }
+
+  //! Get the neighbors already known for each query point (or NULL).
+  const arma::Mat<size_t>* KnownNeighbors() const { return knownNeighbors; }
+  //! Modify the neighbors already known for each query point: column i holds
+  //! the known neighbors of query point i, sorted by index.  These are not
+  //! offered as candidates again, so that a search whose heaps hold them can
+  //! find only the neighbors after them.  NULL (the default) means none.
+  const arma::Mat<size_t>*& KnownNeighbors() { return knownNeighbors; }
+
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
 
   //! Convenience typedef.
   typedef NeighborSearchTraversalInfo<TreeType> TraversalInfoType;
@@ -107,15 +240,24 @@ class NeighborSearchRules
   //! The query set.
   const typename TreeType::Mat& querySet;
 
-  //! The matrix the resultant neighbor indices should be stored in.
+  //! The matrix the resultant neighbor indices should be stored in.  Each
+  //! column holds the candidates of a query point; see CandidateListType.
   arma::Mat<size_t>& neighbors;
 
-  //! The matrix the resultant neighbor distances should be stored in.
+  //! The matrix the resultant neighbor distances should be stored in.  Each
+  //! column holds the candidates of a query point; see CandidateListType.
   arma::mat& distances;
 
   //! The instantiated metric.
   MetricType& metric;
 
+  //! The relative error allowed when pruning: a node is pruned unless it can
+  //! improve on a candidate by more than a factor of (1 + epsilon).
+  double epsilon;
+
+  //! The neighbors already known for each query point, or NULL.
+  const arma::Mat<size_t>* knownNeighbors;
+
   //! The last query point BaseCase() was called with.
   size_t lastQueryIndex;
   //! The last reference point BaseCase() was called with.
@@ -123,33 +265,38 @@ class NeighborSearchRules
   //! The last base case result.
   double lastBaseCase;
 
-  //! The number of base cases that have been performed.
-  size_t baseCases;
-  //! The number of scores that have been performed.
-  size_t scores;
+  //! The last query point given to Seed() (or an invalid index); its
+  //! candidates are checked before any is inserted again.
+  size_t seededQueryIndex;
+
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
 
   //! Traversal info for the parent combination; this is updated by the
   //! traversal before each call to Score().
   TraversalInfoType traversalInfo;
 
+  /**
+   * Offer the reference point as a candidate for the query point, unless it is
+   * one of the known neighbors of the query point (or, if the query point was
+   * seeded, already one of its candidates).
+   */
+  void Insert(const size_t queryIndex,
+              const size_t referenceIndex,
+              const double distance);
+
   /**
    * Recalculate the bound for a given query node.
    */
   double CalculateBound(TreeType& queryNode) const;
 
   /**
-   * Insert a point into the neighbors and distances matrices; this is a helper
-   * function.
-   *
-   * @param queryIndex Index of point whose neighbors we are inserting into.
-   * @param pos Position in list to insert into.
-   * @param neighbor Index of reference point which is being inserted.
-   * @param distance Distance from query point to reference point.
+   * Recalculate the bound of the given node for a monochromatic search: the
+   * worst candidate distance of any of its points, computed from the points of
+   * a leaf and from the cached bounds of the children otherwise.  Bounds only
+   * get better during a search, so cached bounds are always valid.
    */
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance);
+  double SymmetricBound(TreeType& node);
 };
 
 }; // namespace neighbor
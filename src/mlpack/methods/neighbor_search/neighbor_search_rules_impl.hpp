@@ -10,25 +10,81 @@
 // In case it hasn't been included yet.
 #include "neighbor_search_rules.hpp"
 
+#include <algorithm>
+#include <mlpack/core/util/sfinae_utility.hpp>
+#include "sort_policies/nearest_neighbor_sort.hpp"
+
 namespace mlpack {
 namespace neighbor {
 
-template<typename SortPolicy, typename MetricType, typename TreeType>
-NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
+//! Detect whether a metric can stop evaluating a distance once it is known to
+//! be greater than a bound.
+HAS_MEM_FUNC(EvaluateBounded, HasEvaluateBounded);
+
+//! Whether MetricType has a (static, const, or non-const) EvaluateBounded().
+template<typename MetricType>
+struct HasEvaluateBoundedMethod
+{
+  static const bool value = HasEvaluateBounded<MetricType,
+      double (*)(const arma::vec&, const arma::vec&, const double)>::value ||
+      HasEvaluateBounded<MetricType,
+      double (MetricType::*)(const arma::vec&, const arma::vec&, const double)
+      const>::value ||
+      HasEvaluateBounded<MetricType,
+      double (MetricType::*)(const arma::vec&, const arma::vec&,
+      const double)>::value;
+};
+
+//! Evaluate the distance between the two points with EvaluateBounded(), which
+//! gives up once the distance is known to be greater than the bound.
+template<typename MetricType, typename VecType1, typename VecType2>
+inline double BoundedDistance(
+    MetricType& metric,
+    const VecType1& a,
+    const VecType2& b,
+    const double bound,
+    const typename boost::enable_if_c<
+        HasEvaluateBoundedMethod<MetricType>::value, MetricType*>::type = 0)
+{
+  return metric.EvaluateBounded(a, b, bound);
+}
+
+//! Evaluate the whole distance between the two points, since the metric has no
+//! EvaluateBounded().
+template<typename MetricType, typename VecType1, typename VecType2>
+inline double BoundedDistance(
+    MetricType& metric,
+    const VecType1& a,
+    const VecType2& b,
+    const double /* bound */,
+    const typename boost::disable_if_c<
+        HasEvaluateBoundedMethod<MetricType>::value, MetricType*>::type = 0)
+{
+  return metric.Evaluate(a, b);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::NeighborSearchRules(
     const typename TreeType::Mat& referenceSet,
     const typename TreeType::Mat& querySet,
     arma::Mat<size_t>& neighbors,
     arma::mat& distances,
-    MetricType& metric) :
+    MetricType& metric,
+    const double epsilon) :
     referenceSet(referenceSet),
     querySet(querySet),
     neighbors(neighbors),
     distances(distances),
     metric(metric),
+    epsilon(epsilon),
+    knownNeighbors(NULL),
     lastQueryIndex(querySet.n_cols),
     lastReferenceIndex(referenceSet.n_cols),
-    baseCases(0),
-    scores(0)
+    seededQueryIndex(querySet.n_cols)
 {
   // We must set the traversal info last query and reference node pointers to
   // something that is both invalid (i.e. not a tree node) and not NULL.  We'll
@@ -37,11 +93,17 @@ NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
   traversalInfo.LastReferenceNode() = (TreeType*) this;
 }
 
-template<typename SortPolicy, typename MetricType, typename TreeType>
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
 inline force_inline // Absolutely MUST be inline so optimizations can happen.
-double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::
 BaseCase(const size_t queryIndex, const size_t referenceIndex)
 {
+  MLPACK_PROFILE_SCOPE("NeighborSearchRules::BaseCase()");
+
   // If the datasets are the same, then this search is only using one dataset
   // and we should not return identical points.
   if ((&querySet == &referenceSet) && (queryIndex == referenceIndex))
@@ -51,20 +113,29 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   if ((lastQueryIndex == queryIndex) && (lastReferenceIndex == referenceIndex))
     return lastBaseCase;
 
-  double distance = metric.Evaluate(querySet.col(queryIndex),
-                                    referenceSet.col(referenceIndex));
-  ++baseCases;
-
-  // If this distance is better than any of the current candidates, the
-  // SortDistance() function will give us the position to insert it into.
-  arma::vec queryDist = distances.unsafe_col(queryIndex);
-  arma::Col<size_t> queryIndices = neighbors.unsafe_col(queryIndex);
-  const size_t insertPosition = SortPolicy::SortDistance(queryDist,
-      queryIndices, distance);
+  // In nearest neighbor search, a distance greater than that of the worst
+  // candidate will not be taken, so its evaluation can be abandoned; the value
+  // returned instead is still a lower bound on the distance.  When the first
+  // point of each node is its centroid, the base cases are used for the bounds
+  // of the nodes too, so they must be whole.
+  double distance;
+  if (boost::is_same<SortPolicy, NearestNeighborSort>::value &&
+      !tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+  {
+    distance = BoundedDistance(metric, querySet.col(queryIndex),
+        referenceSet.col(referenceIndex),
+        CandidateListType::WorstDistance(distances, queryIndex));
+  }
+  else
+  {
+    distance = metric.Evaluate(querySet.col(queryIndex),
+                               referenceSet.col(referenceIndex));
+  }
+  ++statistics.BaseCases();
 
-  // SortDistance() returns (size_t() - 1) if we shouldn't add it.
-  if (insertPosition != (size_t() - 1))
-    InsertNeighbor(queryIndex, insertPosition, referenceIndex, distance);
+  // If this distance is better than the worst of the current candidates, it
+  // will replace it.
+  Insert(queryIndex, referenceIndex, distance);
 
   // Cache this information for the next time BaseCase() is called.
   lastQueryIndex = queryIndex;
@@ -74,12 +145,60 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   return distance;
 }
 
-template<typename SortPolicy, typename MetricType, typename TreeType>
-inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+bool NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::BaseCases(
+    TreeType& queryNode,
+    const std::vector<size_t>& queryPoints,
+    TreeType& referenceNode)
+{
+  if (queryPoints.empty() || referenceNode.NumPoints() == 0)
+    return false;
+
+  // blockDistances(i, k) is the distance between the i'th reference point and
+  // the query point queryPoints[k].
+  arma::mat blockDistances;
+  if (!tree::LeafBlockDistances(metric, referenceSet, referenceNode, querySet,
+      queryNode, queryPoints, blockDistances))
+    return false;
+
+  for (size_t k = 0; k < queryPoints.size(); ++k)
+  {
+    const size_t queryIndex = queryNode.Point(queryPoints[k]);
+    for (size_t i = 0; i < referenceNode.NumPoints(); ++i)
+    {
+      // Don't return identical points if there is only one dataset.
+      const size_t referenceIndex = referenceNode.Point(i);
+      if ((&querySet == &referenceSet) && (queryIndex == referenceIndex))
+        continue;
+
+      Insert(queryIndex, referenceIndex, blockDistances(i, k));
+      ++statistics.BaseCases();
+
+      // Keep the cache of BaseCase() up to date.
+      lastQueryIndex = queryIndex;
+      lastReferenceIndex = referenceIndex;
+      lastBaseCase = blockDistances(i, k);
+    }
+  }
+
+  return true;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::Score(
     const size_t queryIndex,
     TreeType& referenceNode)
 {
-  ++scores; // Count number of Score() calls.
+  MLPACK_PROFILE_SCOPE("NeighborSearchRules::Score() (single-tree)");
+
   double distance;
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
   {
@@ -109,14 +228,21 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
         &referenceNode);
   }
 
-  // Compare against the best k'th distance for this query point so far.
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  // Compare against the best k'th distance for this query point so far,
+  // relaxed by the allowed error.
+  const double bestDistance = SortPolicy::Relax(
+      CandidateListType::WorstDistance(distances, queryIndex), epsilon);
 
-  return (SortPolicy::IsBetter(distance, bestDistance)) ? distance : DBL_MAX;
+  return statistics.Score((SortPolicy::IsBetter(distance, bestDistance)) ?
+      distance : DBL_MAX, referenceNode);
 }
 
-template<typename SortPolicy, typename MetricType, typename TreeType>
-inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::Rescore(
     const size_t queryIndex,
     TreeType& /* referenceNode */,
     const double oldScore) const
@@ -125,18 +251,23 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
   if (oldScore == DBL_MAX)
     return oldScore;
 
-  // Just check the score again against the distances.
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  // Just check the score again against the (relaxed) distances.
+  const double bestDistance = SortPolicy::Relax(
+      CandidateListType::WorstDistance(distances, queryIndex), epsilon);
 
   return (SortPolicy::IsBetter(oldScore, bestDistance)) ? oldScore : DBL_MAX;
 }
 
-template<typename SortPolicy, typename MetricType, typename TreeType>
-inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::Score(
     TreeType& queryNode,
     TreeType& referenceNode)
 {
-  ++scores; // Count number of Score() calls.
+  MLPACK_PROFILE_SCOPE("NeighborSearchRules::Score() (dual-tree)");
 
   // Update our bound.
   const double bestDistance = CalculateBound(queryNode);
@@ -236,7 +367,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
       // There isn't any need to set the traversal information because no
       // descendant combinations will be visited, and those are the only
       // combinations that would depend on the traversal information.
-      return DBL_MAX;
+      return statistics.Score(DBL_MAX, queryNode, referenceNode);
     }
   }
 
@@ -281,19 +412,23 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
     traversalInfo.LastReferenceNode() = &referenceNode;
     traversalInfo.LastScore() = distance;
 
-    return distance;
+    return statistics.Score(distance, queryNode, referenceNode);
   }
   else
   {
     // There isn't any need to set the traversal information because no
     // descendant combinations will be visited, and those are the only
     // combinations that would depend on the traversal information.
-    return DBL_MAX;
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
   }
 }
 
-template<typename SortPolicy, typename MetricType, typename TreeType>
-inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::Rescore(
     TreeType& queryNode,
     TreeType& /* referenceNode */,
     const double oldScore) const
@@ -307,10 +442,75 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
   return (SortPolicy::IsBetter(oldScore, bestDistance)) ? oldScore : DBL_MAX;
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline force_inline
+void NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::Insert(
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double distance)
+{
+  // The known neighbors are only looked up for candidates that could be taken.
+  if (knownNeighbors != NULL && !SortPolicy::IsBetter(
+      CandidateListType::WorstDistance(distances, queryIndex),
+      distance))
+  {
+    const size_t* known = knownNeighbors->colptr(queryIndex);
+    if (std::binary_search(known, known + knownNeighbors->n_rows,
+        referenceIndex))
+      return;
+  }
+
+  // A seeded query point already holds some of the candidates the search will
+  // find again, and the candidate list does not check for them.
+  if (queryIndex == seededQueryIndex && !SortPolicy::IsBetter(
+      CandidateListType::WorstDistance(distances, queryIndex), distance))
+  {
+    const size_t* candidates = neighbors.colptr(queryIndex);
+    if (std::find(candidates, candidates + neighbors.n_rows, referenceIndex) !=
+        candidates + neighbors.n_rows)
+      return;
+  }
+
+  CandidateListType::Insert(neighbors, distances, queryIndex,
+      referenceIndex, distance);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::Seed(
+    const size_t queryIndex,
+    const size_t seedIndex)
+{
+  if (queryIndex == seedIndex)
+    return;
+
+  seededQueryIndex = queryIndex;
+
+  // If the query set is the reference set, the seed point itself is likely to
+  // be one of the best candidates.
+  if (&querySet == &referenceSet)
+    BaseCase(queryIndex, seedIndex);
+
+  for (size_t i = 0; i < neighbors.n_rows; ++i)
+    if (neighbors(i, seedIndex) != size_t() - 1)
+      BaseCase(queryIndex, neighbors(i, seedIndex));
+}
+
 // Calculate the bound for a given query node in its current state and update
 // it.
-template<typename SortPolicy, typename MetricType, typename TreeType>
-inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::
     CalculateBound(TreeType& queryNode) const
 {
   // This is an adapted form of the B(N_q) function in the paper
@@ -346,7 +546,8 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
   // Loop over points held in the node.
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
-    const double distance = distances(distances.n_rows - 1, queryNode.Point(i));
+    const double distance = CandidateListType::WorstDistance(
+        distances, queryNode.Point(i));
     if (SortPolicy::IsBetter(worstDistance, distance))
       worstDistance = distance;
     if (SortPolicy::IsBetter(distance, bestDistance))
@@ -394,46 +595,131 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
       bestDistance = queryNode.Parent()->Stat().SecondBound();
   }
 
-  // Cache bounds for later.
+  // Cache bounds for later.  The cached bounds are exact, so that the
+  // relaxation is not compounded from parent to child.
   queryNode.Stat().FirstBound() = worstDistance;
   queryNode.Stat().SecondBound() = bestDistance;
 
   if (SortPolicy::IsBetter(worstDistance, bestDistance))
-    return worstDistance;
+    return SortPolicy::Relax(worstDistance, epsilon);
   else
-    return bestDistance;
+    return SortPolicy::Relax(bestDistance, epsilon);
 }
 
-/**
- * Helper function to insert a point into the neighbors and distances matrices.
- *
- * @param queryIndex Index of point whose neighbors we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of reference point which is being inserted.
- * @param distance Distance from query point to reference point.
- */
-template<typename SortPolicy, typename MetricType, typename TreeType>
-void NeighborSearchRules<SortPolicy, MetricType, TreeType>::InsertNeighbor(
-    const size_t queryIndex,
-    const size_t pos,
-    const size_t neighbor,
-    const double distance)
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline force_inline
+double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::SymmetricBaseCase(
+    const size_t indexA,
+    const size_t indexB)
+{
+  const double distance = metric.Evaluate(querySet.col(indexA),
+                                          referenceSet.col(indexB));
+  ++statistics.BaseCases();
+
+  Insert(indexA, indexB, distance);
+  Insert(indexB, indexA, distance);
+
+  return distance;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::
+SymmetricScore(TreeType& nodeA, TreeType& nodeB)
+{
+  const double distance = SortPolicy::BestNodeToNodeDistance(&nodeA, &nodeB);
+
+  return statistics.Score(SymmetricRescore(nodeA, nodeB, distance), nodeA,
+      nodeB);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::
+SymmetricRescore(TreeType& nodeA, TreeType& nodeB, const double oldScore)
+{
+  // If we are already pruning, still prune.
+  if (oldScore == DBL_MAX)
+    return oldScore;
+
+  // The pair is useful if either node could improve the candidates of the
+  // points of the other.
+  if (SortPolicy::IsBetter(oldScore, SortPolicy::Relax(SymmetricBound(nodeA),
+      epsilon)))
+    return oldScore;
+
+  if (SortPolicy::IsBetter(oldScore, SortPolicy::Relax(SymmetricBound(nodeB),
+      epsilon)))
+    return oldScore;
+
+  return DBL_MAX;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::
+ResetSymmetricBounds(TreeType& node)
+{
+  node.Stat().FirstBound() = SortPolicy::WorstDistance();
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    ResetSymmetricBounds(node.Child(i));
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::
+ResetBounds(TreeType& node)
 {
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (distances.n_rows - 1))
+  node.Stat().FirstBound() = SortPolicy::WorstDistance();
+  node.Stat().SecondBound() = SortPolicy::WorstDistance();
+  node.Stat().Bound() = SortPolicy::WorstDistance();
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    ResetBounds(node.Child(i));
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename TreeType,
+         typename CandidateListType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType,
+    CandidateListType>::
+SymmetricBound(TreeType& node)
+{
+  // Find the worst candidate distance of any point in the node.
+  double worstDistance = SortPolicy::BestDistance();
+  for (size_t i = 0; i < node.NumPoints(); ++i)
   {
-    int len = (distances.n_rows - 1) - pos;
-    memmove(distances.colptr(queryIndex) + (pos + 1),
-        distances.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(neighbors.colptr(queryIndex) + (pos + 1),
-        neighbors.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
+    const double distance = CandidateListType::WorstDistance(distances,
+        node.Point(i));
+    if (SortPolicy::IsBetter(worstDistance, distance))
+      worstDistance = distance;
+  }
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    const double distance = node.Child(i).Stat().FirstBound();
+    if (SortPolicy::IsBetter(worstDistance, distance))
+      worstDistance = distance;
   }
 
-  // Now put the new information in the right index.
-  distances(pos, queryIndex) = distance;
-  neighbors(pos, queryIndex) = neighbor;
+  node.Stat().FirstBound() = worstDistance;
+  return worstDistance;
 }
 
 }; // namespace neighbor
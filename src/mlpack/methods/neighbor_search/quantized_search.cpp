@@ -0,0 +1,271 @@
+/**
+ * @file quantized_search.cpp
+ *
+ * Implementation of the QuantizedSearch class.
+ */
+#include "quantized_search.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/count_nodes.hpp>
+
+#include "candidate_heap.hpp"
+#include "sort_policies/nearest_neighbor_sort.hpp"
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+template<typename TreeType>
+size_t QuantizedSearch::AddNode(const TreeType& node)
+{
+  const size_t index = nodes.size();
+  nodes.push_back(Node());
+  nodes[index].begin = node.Begin();
+  nodes[index].count = node.Count();
+  nodes[index].left = 0;
+  nodes[index].right = 0;
+
+  if (node.IsLeaf())
+  {
+    // The box of a leaf is the range of the codes of its points.
+    nodeLo.col(index).fill(255);
+    nodeHi.col(index).zeros();
+    for (size_t i = node.Begin(); i < node.Begin() + node.Count(); ++i)
+    {
+      const unsigned char* code = references.Column(i);
+      for (size_t d = 0; d < nodeLo.n_rows; ++d)
+      {
+        nodeLo(d, index) = std::min(nodeLo(d, index), code[d]);
+        nodeHi(d, index) = std::max(nodeHi(d, index), code[d]);
+      }
+    }
+  }
+  else
+  {
+    // The vector of nodes may grow while the children are added.
+    const size_t left = AddNode(*node.Left());
+    const size_t right = AddNode(*node.Right());
+    nodes[index].left = left;
+    nodes[index].right = right;
+
+    for (size_t d = 0; d < nodeLo.n_rows; ++d)
+    {
+      nodeLo(d, index) = std::min(nodeLo(d, left), nodeLo(d, right));
+      nodeHi(d, index) = std::max(nodeHi(d, left), nodeHi(d, right));
+    }
+  }
+
+  return index;
+}
+
+QuantizedSearch::QuantizedSearch(const arma::mat& referenceSet,
+                                 const bool naive,
+                                 const size_t leafSize) :
+    naive(naive),
+    numThreads(1)
+{
+  if (naive)
+  {
+    references.Quantize(referenceSet);
+    return;
+  }
+
+  if (referenceSet.n_cols == 0)
+  {
+    Log::Fatal << "QuantizedSearch::QuantizedSearch(): the reference set is "
+        << "empty!" << std::endl;
+  }
+
+  // The tree is only needed to order the points and to find the nodes, so it
+  // is built on a copy that is dropped once the points are quantized.
+  Timer::Start("tree_building");
+
+  arma::mat copy(referenceSet);
+  tree::BinarySpaceTree<bound::HRectBound<2>, tree::EmptyStatistic>
+      kdTree(copy, oldFromNew, leafSize);
+  references.Quantize(copy);
+
+  const size_t numNodes = tree::CountNodes(kdTree);
+  nodes.reserve(numNodes);
+  nodeLo.set_size(references.Dimensionality(), numNodes);
+  nodeHi.set_size(references.Dimensionality(), numNodes);
+  AddNode(kdTree);
+
+  Timer::Stop("tree_building");
+}
+
+void QuantizedSearch::Search(const arma::mat& querySet,
+                             const size_t k,
+                             arma::Mat<size_t>& resultingNeighbors,
+                             arma::mat& distances) const
+{
+  Timer::Start("computing_neighbors");
+
+  Candidates(querySet, k, resultingNeighbors, distances);
+
+  // The quantized distances are squared; rounding can make them very slightly
+  // negative.
+  for (size_t i = 0; i < distances.n_elem; ++i)
+    if (resultingNeighbors[i] != size_t() - 1)
+      distances[i] = std::sqrt(std::max(distances[i], 0.0));
+
+  Timer::Stop("computing_neighbors");
+}
+
+void QuantizedSearch::Search(const arma::mat& querySet,
+                             const arma::mat& referenceSet,
+                             const size_t k,
+                             const size_t candidates,
+                             arma::Mat<size_t>& resultingNeighbors,
+                             arma::mat& distances) const
+{
+  if (referenceSet.n_rows != references.Dimensionality() ||
+      referenceSet.n_cols != references.NumPoints())
+  {
+    Log::Fatal << "QuantizedSearch::Search(): the full-precision reference set "
+        << "is " << referenceSet.n_rows << " x " << referenceSet.n_cols
+        << ", but the quantized one is " << references.Dimensionality() << " x "
+        << references.NumPoints() << "!" << std::endl;
+  }
+
+  if (candidates < k)
+  {
+    Log::Fatal << "QuantizedSearch::Search(): the number of candidates ("
+        << candidates << ") must be at least k (" << k << ")!" << std::endl;
+  }
+
+  Timer::Start("computing_neighbors");
+
+  arma::Mat<size_t> candidateNeighbors;
+  arma::mat candidateDistances;
+  Candidates(querySet, std::min(candidates, references.NumPoints()),
+      candidateNeighbors, candidateDistances);
+
+  resultingNeighbors.set_size(k, querySet.n_cols);
+  resultingNeighbors.fill(size_t() - 1);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(NearestNeighborSort::WorstDistance());
+
+  // Each query only reads the columns of its own candidates, and writes to its
+  // own column of the results.
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 16)
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    for (size_t j = 0; j < candidateNeighbors.n_rows; ++j)
+    {
+      const size_t candidate = candidateNeighbors(j, i);
+      if (candidate == size_t() - 1)
+        continue;
+
+      const double distance = metric::EuclideanDistance::Evaluate(
+          querySet.unsafe_col(i), referenceSet.unsafe_col(candidate));
+      CandidateHeap<NearestNeighborSort>::Insert(resultingNeighbors, distances,
+          i, candidate, distance);
+    }
+  }
+
+  CandidateHeap<NearestNeighborSort>::Sort(resultingNeighbors, distances);
+
+  Timer::Stop("computing_neighbors");
+}
+
+std::string QuantizedSearch::ToString() const
+{
+  std::ostringstream convert;
+  convert << "QuantizedSearch [" << this << "]" << std::endl;
+  convert << "  Dimensionality: " << references.Dimensionality() << std::endl;
+  convert << "  Points: " << references.NumPoints() << std::endl;
+  convert << "  Naive: " << naive << std::endl;
+  if (!naive)
+    convert << "  Nodes: " << nodes.size() << std::endl;
+  return convert.str();
+}
+
+void QuantizedSearch::SearchNode(const data::QuantizedDistance& distance,
+                                 const size_t nodeIndex,
+                                 const size_t queryIndex,
+                                 arma::Mat<size_t>& neighbors,
+                                 arma::mat& distances) const
+{
+  const Node& node = nodes[nodeIndex];
+  if (node.left == 0)
+  {
+    for (size_t i = node.begin; i < node.begin + node.count; ++i)
+    {
+      CandidateHeap<NearestNeighborSort>::Insert(neighbors, distances,
+          queryIndex, oldFromNew[i], distance.Evaluate(references.Column(i)));
+    }
+    return;
+  }
+
+  // Visit the closer child first, so that the other is more likely to be
+  // pruned.  A node is only pruned if it is further than the worst candidate,
+  // since a point at the same distance may still be taken (if its index is
+  // lower).
+  const double leftDistance = distance.MinDistance(nodeLo.colptr(node.left),
+      nodeHi.colptr(node.left));
+  const double rightDistance = distance.MinDistance(nodeLo.colptr(node.right),
+      nodeHi.colptr(node.right));
+
+  const bool leftFirst = (leftDistance <= rightDistance);
+  const size_t first = leftFirst ? node.left : node.right;
+  const size_t second = leftFirst ? node.right : node.left;
+  const double firstDistance = leftFirst ? leftDistance : rightDistance;
+  const double secondDistance = leftFirst ? rightDistance : leftDistance;
+
+  if (firstDistance <= CandidateHeap<NearestNeighborSort>::WorstDistance(
+      distances, queryIndex))
+    SearchNode(distance, first, queryIndex, neighbors, distances);
+
+  if (secondDistance <= CandidateHeap<NearestNeighborSort>::WorstDistance(
+      distances, queryIndex))
+    SearchNode(distance, second, queryIndex, neighbors, distances);
+}
+
+void QuantizedSearch::Candidates(const arma::mat& querySet,
+                                 const size_t k,
+                                 arma::Mat<size_t>& neighbors,
+                                 arma::mat& distances) const
+{
+  if (querySet.n_rows != references.Dimensionality())
+  {
+    Log::Fatal << "QuantizedSearch::Search(): queries have " << querySet.n_rows
+        << " dimensions, but the reference points have "
+        << references.Dimensionality() << "!" << std::endl;
+  }
+
+  if (k == 0 || k > references.NumPoints())
+  {
+    Log::Fatal << "QuantizedSearch::Search(): invalid k (" << k << "); must "
+        << "be greater than 0 and at most the number of reference points ("
+        << references.NumPoints() << ")." << std::endl;
+  }
+
+  neighbors.set_size(k, querySet.n_cols);
+  neighbors.fill(size_t() - 1);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(NearestNeighborSort::WorstDistance());
+
+  // Each query only writes to its own column of the results, so no locking is
+  // necessary.
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic, 16)
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    const data::QuantizedDistance distance(references, querySet.unsafe_col(i));
+
+    if (naive)
+    {
+      for (size_t j = 0; j < references.NumPoints(); ++j)
+      {
+        CandidateHeap<NearestNeighborSort>::Insert(neighbors, distances, i, j,
+            distance.Evaluate(references.Column(j)));
+      }
+    }
+    else
+    {
+      SearchNode(distance, 0, i, neighbors, distances);
+    }
+  }
+
+  CandidateHeap<NearestNeighborSort>::Sort(neighbors, distances);
+}
@@ -0,0 +1,195 @@
+/**
+ * @file quantized_search.hpp
+ *
+ * Defines the QuantizedSearch class, which computes nearest neighbors among
+ * reference points quantized to one byte per element, optionally re-ranking
+ * them with the full-precision points.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZED_SEARCH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_QUANTIZED_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/data/quantized_matrix.hpp>
+#include <vector>
+#include <string>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The QuantizedSearch class keeps a reference set as a data::QuantizedMatrix
+ * (one byte per element, with a scale and offset for each dimension) and
+ * searches it for the nearest neighbors of full-precision query points.  Only
+ * the quantized points are kept, so the index takes about an eighth of the
+ * memory of the reference set, and each leaf of the tree fits eight times as
+ * many points in the same cache lines.
+ *
+ * Unless the search is naive (a scan of every point), the reference points
+ * are ordered by a kd-tree (a BinarySpaceTree, built once on the
+ * full-precision points), and the bounds of its nodes are kept as boxes of
+ * codes.  A single-tree search then prunes the nodes whose boxes are further
+ * away than the k'th candidate, and finds exactly the neighbors a naive scan
+ * of the quantized points would (see data::QuantizedDistance).
+ *
+ * The quantized distances are within about half a step per dimension of the
+ * true distances, so the neighbors found are approximate.  The overload of
+ * Search() that takes the full-precision reference set searches for more
+ * candidates than needed, computes their exact distances, and keeps the best
+ * k: the full-precision set is only read at the columns of the candidates, so
+ * it can be held in a file (see data::MappedMatrix).
+ *
+ * @code
+ * extern arma::mat referenceSet, queries;
+ * QuantizedSearch search(referenceSet);
+ * data::MappedMatrix::Save("references.mlb", referenceSet);
+ * referenceSet.reset();
+ *
+ * data::MappedMatrix exact("references.mlb");
+ * arma::Mat<size_t> neighbors;
+ * arma::mat distances;
+ * // Find 50 candidates for each query, and re-rank them to find the best 5.
+ * search.Search(queries, exact.Matrix(), 5, 50, neighbors, distances);
+ * @endcode
+ */
+class QuantizedSearch
+{
+ public:
+  /**
+   * Quantize the given reference set and, unless the search is naive, build
+   * the tree that orders it.  The reference set is not kept.
+   *
+   * @param referenceSet Set of reference points.
+   * @param naive If true, every search scans all of the points.
+   * @param leafSize Maximum number of points in each leaf of the tree.
+   */
+  QuantizedSearch(const arma::mat& referenceSet,
+                  const bool naive = false,
+                  const size_t leafSize = 20);
+
+  /**
+   * Compute the nearest neighbors of each query point among the quantized
+   * reference points, and store them in the given matrices, which will be k x
+   * (number of queries).  The distances are the approximate (quantized)
+   * Euclidean distances, and neighbors are given by their index in the
+   * reference set given to the constructor.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing the approximate distances of the neighbors
+   *     for each query point.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& resultingNeighbors,
+              arma::mat& distances) const;
+
+  /**
+   * Compute the given number of candidate neighbors of each query point among
+   * the quantized reference points, then compute the exact distances of the
+   * candidates from the given full-precision reference set, and keep the k
+   * best of them.  The results are exact if the k nearest neighbors are among
+   * the candidates.  Only the columns of the candidates are read from the
+   * full-precision set.
+   *
+   * @param querySet Set of query points.
+   * @param referenceSet The full-precision reference set given to the
+   *     constructor (in the same order).
+   * @param k Number of neighbors to search for.
+   * @param candidates Number of candidates to re-rank (at least k).
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing the exact distances of the neighbors for
+   *     each query point.
+   */
+  void Search(const arma::mat& querySet,
+              const arma::mat& referenceSet,
+              const size_t k,
+              const size_t candidates,
+              arma::Mat<size_t>& resultingNeighbors,
+              arma::mat& distances) const;
+
+  //! Get the quantized reference points, in the order of the tree.
+  const data::QuantizedMatrix& References() const { return references; }
+  //! Get the original index of each point of References() (empty if the
+  //! search is naive, and the points are in their original order).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNew; }
+
+  //! Get the number of nodes in the tree (0 if the search is naive).
+  size_t NumNodes() const { return nodes.size(); }
+
+  //! Get whether every search scans all of the points.
+  bool Naive() const { return naive; }
+
+  //! Get the number of threads used for search.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for search.  This only has an effect
+  //! if mlpack was compiled with OpenMP.
+  size_t& NumThreads() { return numThreads; }
+
+  // Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! A node of the tree: a range of the reference points, and its children.
+  struct Node
+  {
+    //! The first point of the node.
+    size_t begin;
+    //! The number of points of the node.
+    size_t count;
+    //! The index of the left child, or 0 if the node is a leaf.
+    size_t left;
+    //! The index of the right child, or 0 if the node is a leaf.
+    size_t right;
+  };
+
+  /**
+   * Add the given node of the tree and its descendants to the nodes, with
+   * their boxes of codes, and return its index.
+   */
+  template<typename TreeType>
+  size_t AddNode(const TreeType& node);
+
+  /**
+   * Search the given node for better candidates for the given query point.
+   */
+  void SearchNode(const data::QuantizedDistance& distance,
+                  const size_t nodeIndex,
+                  const size_t queryIndex,
+                  arma::Mat<size_t>& neighbors,
+                  arma::mat& distances) const;
+
+  /**
+   * Compute the k best candidates of each query point, with their approximate
+   * squared distances, sorted.
+   */
+  void Candidates(const arma::mat& querySet,
+                  const size_t k,
+                  arma::Mat<size_t>& neighbors,
+                  arma::mat& distances) const;
+
+  //! The quantized reference points.
+  data::QuantizedMatrix references;
+  //! The original index of each reference point (empty if naive).
+  std::vector<size_t> oldFromNew;
+
+  //! The nodes of the tree; the root is the first.
+  std::vector<Node> nodes;
+  //! The smallest code of each dimension in each node (one column per node).
+  arma::Mat<unsigned char> nodeLo;
+  //! The largest code of each dimension in each node (one column per node).
+  arma::Mat<unsigned char> nodeHi;
+
+  //! If true, every search scans all of the points.
+  bool naive;
+  //! The number of threads to use for search.
+  size_t numThreads;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ * @file search_tuner.cpp
+ *
+ * Implementation of the SearchCandidate and SearchTuner classes.
+ */
+#include "search_tuner.hpp"
+#include "neighbor_search.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace neighbor {
+
+std::string SearchCandidate::ToString() const
+{
+  std::ostringstream convert;
+  switch (type)
+  {
+    case NAIVE:
+      return "--naive";
+    case KD_TREE:
+      // The kd-tree is the default, so it has no option of its own.
+      break;
+    case COVER_TREE:
+      convert << "--cover_tree";
+      break;
+    case R_TREE:
+      convert << "--r_tree";
+      break;
+  }
+
+  if (type != COVER_TREE)
+    convert << ((type == KD_TREE) ? "" : " ") << "--leaf_size=" << leafSize;
+  if (singleMode)
+    convert << " --single_mode";
+  return convert.str();
+}
+
+SearchTuner::SearchTuner(const arma::mat& referenceSet,
+                         const arma::mat& querySet,
+                         const size_t sampleSize) :
+    numReferencePoints(referenceSet.n_cols),
+    numQueryPoints(querySet.n_cols),
+    intrinsicDimension(1.0)
+{
+  if (sampleSize < 20)
+  {
+    Log::Fatal << "SearchTuner::SearchTuner(): the sample size ("
+        << sampleSize << ") must be at least 20." << std::endl;
+  }
+
+  Sample(referenceSet, sampleSize, referenceSample);
+  if (numQueryPoints > 0)
+    Sample(querySet, sampleSize, querySample);
+
+  // At least two neighbors of each point are needed for the estimate.
+  if (referenceSample.n_cols > 2)
+  {
+    intrinsicDimension = EstimateIntrinsicDimension(referenceSample,
+        std::min((size_t) 10, (size_t) referenceSample.n_cols - 1));
+  }
+
+  Log::Info << "Estimated intrinsic dimension of the reference points: "
+      << intrinsicDimension << " (of " << referenceSet.n_rows << ")."
+      << std::endl;
+}
+
+std::vector<SearchCandidate> SearchTuner::Candidates(const bool rTree) const
+{
+  std::vector<SearchCandidate> candidates;
+  candidates.push_back(SearchCandidate(SearchCandidate::NAIVE));
+
+  const size_t leafSizes[] = { 5, 10, 20, 40, 80 };
+  for (size_t s = 0; s < 2; ++s)
+  {
+    const bool singleMode = (s == 1);
+    for (size_t i = 0; i < 5; ++i)
+    {
+      candidates.push_back(SearchCandidate(SearchCandidate::KD_TREE,
+          leafSizes[i], singleMode));
+    }
+
+    candidates.push_back(SearchCandidate(SearchCandidate::COVER_TREE, 20,
+        singleMode));
+
+    // R-trees with small leaves take a long time to build.
+    if (rTree)
+    {
+      for (size_t i = 2; i < 5; ++i)
+      {
+        candidates.push_back(SearchCandidate(SearchCandidate::R_TREE,
+            leafSizes[i], singleMode));
+      }
+    }
+  }
+
+  return candidates;
+}
+
+double SearchTuner::PredictTime(const SearchCandidate& candidate,
+                                const double buildTime,
+                                const double searchTime) const
+{
+  const double n = numReferencePoints;
+  const double s = referenceSample.n_cols;
+  const double queryGrowth = Monochromatic() ? (n / s) :
+      ((double) numQueryPoints / querySample.n_cols);
+
+  if (candidate.Type() == SearchCandidate::NAIVE)
+    return (buildTime + searchTime) * queryGrowth * (n / s);
+
+  // Trees are built in O(n log n) time; the query trees of dual-tree searches
+  // are scaled in the same way as the reference trees.
+  const double buildGrowth = (s > 1) ?
+      (n * std::log(n)) / (s * std::log(s)) : 1.0;
+  const double referenceGrowth = std::pow(n / s,
+      1.0 - 1.0 / std::max(intrinsicDimension, 1.0));
+
+  return buildTime * buildGrowth + searchTime * queryGrowth * referenceGrowth;
+}
+
+double SearchTuner::EstimateIntrinsicDimension(const arma::mat& points,
+                                               const size_t k)
+{
+  if (k < 2 || k >= points.n_cols)
+  {
+    Log::Fatal << "SearchTuner::EstimateIntrinsicDimension(): k (" << k
+        << ") must be at least 2 and less than the number of points ("
+        << points.n_cols << ")." << std::endl;
+  }
+
+  AllkNN allknn(points);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(k, neighbors, distances);
+
+  // The estimate at a point x is the inverse of
+  //
+  //   m(x) = 1 / (k - 1) sum_{j < k} log(T_k(x) / T_j(x)),
+  //
+  // where T_j(x) is the distance to its j'th nearest neighbor, and the
+  // estimate for all the points is the inverse of the mean of m(x).
+  double sum = 0.0;
+  size_t count = 0;
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    if (distances(0, i) == 0.0)
+      continue;
+
+    double m = 0.0;
+    for (size_t j = 0; j + 1 < k; ++j)
+      m += std::log(distances(k - 1, i) / distances(j, i));
+
+    sum += m / (k - 1);
+    ++count;
+  }
+
+  // All the neighbors are the same distance away, or too few points are
+  // distinct to tell.
+  if (count == 0 || sum <= 0.0)
+    return 1.0;
+
+  const double estimate = count / sum;
+  return std::max(1.0, std::min(estimate, (double) points.n_rows));
+}
+
+void SearchTuner::Sample(const arma::mat& points,
+                         const size_t sampleSize,
+                         arma::mat& sample)
+{
+  if (points.n_cols <= sampleSize)
+  {
+    sample = points;
+    return;
+  }
+
+  // Draw the sample with the first sampleSize steps of a Fisher-Yates shuffle.
+  std::vector<size_t> order(points.n_cols);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    order[i] = i;
+
+  arma::uvec indices(sampleSize);
+  for (size_t i = 0; i < sampleSize; ++i)
+  {
+    std::swap(order[i], order[(size_t) math::RandInt((int) i,
+        (int) points.n_cols)]);
+    indices[i] = order[i];
+  }
+
+  sample = points.cols(arma::sort(indices));
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
@@ -0,0 +1,210 @@
+/**
+ * @file search_tuner.hpp
+ *
+ * Automatic selection of the search algorithm (naive, or the type of tree, its
+ * leaf size, and single-tree or dual-tree search) for the allknn and
+ * range_search programs, from short timed trials on a sample of the data.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_SEARCH_TUNER_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_SEARCH_TUNER_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * One way of running a search: naively, or with a given type of tree, leaf
+ * size, and traversal.
+ */
+class SearchCandidate
+{
+ public:
+  //! The kinds of search.
+  enum SearchType
+  {
+    NAIVE,
+    KD_TREE,
+    COVER_TREE,
+    R_TREE
+  };
+
+  /**
+   * Create the candidate.
+   *
+   * @param type Kind of search.
+   * @param leafSize Leaf size of the trees (ignored for naive search and cover
+   *     trees).
+   * @param singleMode Whether single-tree search is used (ignored for naive
+   *     search).
+   */
+  SearchCandidate(const SearchType type,
+                  const size_t leafSize = 20,
+                  const bool singleMode = false) :
+      type(type), leafSize(leafSize), singleMode(singleMode) { }
+
+  //! Get the kind of search.
+  SearchType Type() const { return type; }
+  //! Get the leaf size of the trees.
+  size_t LeafSize() const { return leafSize; }
+  //! Get whether single-tree search is used.
+  bool SingleMode() const { return singleMode; }
+
+  //! Describe the candidate, as the options of the programs that select it.
+  std::string ToString() const;
+
+ private:
+  //! The kind of search.
+  SearchType type;
+  //! The leaf size of the trees.
+  size_t leafSize;
+  //! Whether single-tree search is used.
+  bool singleMode;
+};
+
+/**
+ * The SearchTuner class picks the fastest of a set of search candidates for a
+ * given reference set (and query set), for the --auto option of the allknn and
+ * range_search programs.  The fastest choice can differ by an order of
+ * magnitude or more between datasets, so rather than guessing, the tuner
+ * draws a random sample of the reference points (and of the query points),
+ * runs each candidate on the samples, and predicts how long it would take on
+ * the whole datasets.
+ *
+ * The prediction needs an idea of how the cost of a query grows with the size
+ * of the reference set, and that depends on the intrinsic dimension d of the
+ * data, not on the number of dimensions it is given in.  The tuner estimates
+ * d on the sample with the maximum likelihood estimator of Levina and Bickel
+ * ('Maximum Likelihood Estimation of Intrinsic Dimension', NIPS 2004), from the
+ * distances to the nearest neighbors of each point.  The time of a candidate's
+ * trial is then split into building time, which is scaled like n log n, and
+ * search time, which is scaled linearly with the number of query points and,
+ * for each query, like N^(1 - 1 / d) in the number of reference points N (the
+ * worst-case cost of a kd-tree query in d dimensions).  Naive search is scaled
+ * like N, its limit as d grows.
+ *
+ * The candidates are run by a TrialType, which must implement
+ *
+ * @code
+ * // Run the given candidate on the given reference set and query set (or, if
+ * // querySet is NULL, on the reference set alone), and return the time (in
+ * // seconds) spent building trees and searching.
+ * void Run(const SearchCandidate& candidate,
+ *          const arma::mat& referenceSet,
+ *          const arma::mat* querySet,
+ *          double& buildTime,
+ *          double& searchTime);
+ * @endcode
+ *
+ * For example:
+ *
+ * @code
+ * SearchTuner tuner(referenceSet, querySet);
+ * const std::vector<SearchCandidate> candidates = tuner.Candidates(true);
+ * const SearchCandidate& best = candidates[tuner.Select(trial, candidates)];
+ * @endcode
+ */
+class SearchTuner
+{
+ public:
+  /**
+   * Draw the samples of the given datasets and estimate the intrinsic
+   * dimension of the reference sample.
+   *
+   * @param referenceSet Reference points.
+   * @param querySet Query points; if empty, the search is monochromatic (the
+   *     reference points are the query points).
+   * @param sampleSize Number of points in each sample (at least 20); datasets
+   *     that are not larger than this are used whole.
+   */
+  SearchTuner(const arma::mat& referenceSet,
+              const arma::mat& querySet,
+              const size_t sampleSize = 2000);
+
+  /**
+   * Return the candidates worth trying: naive search, and single-tree and
+   * dual-tree search with kd-trees of several leaf sizes, cover trees, and (if
+   * asked for) R-trees of several leaf sizes.
+   *
+   * @param rTree Whether to include R-trees.
+   */
+  std::vector<SearchCandidate> Candidates(const bool rTree) const;
+
+  /**
+   * Run each candidate on the samples and return the index of the one with
+   * the smallest predicted time on the whole datasets.  The trials and the
+   * predictions are printed to Log::Info, and the choice to Log::Info too.
+   *
+   * @param trial Runs the candidates.
+   * @param candidates Candidates to try (at least one).
+   */
+  template<typename TrialType>
+  size_t Select(TrialType& trial,
+                const std::vector<SearchCandidate>& candidates);
+
+  /**
+   * Predict the time a search on the whole datasets would take from the time
+   * it took on the samples.
+   *
+   * @param candidate The candidate that was run.
+   * @param buildTime Time spent building trees on the samples.
+   * @param searchTime Time spent searching on the samples.
+   */
+  double PredictTime(const SearchCandidate& candidate,
+                     const double buildTime,
+                     const double searchTime) const;
+
+  //! Get the sample of the reference points.
+  const arma::mat& ReferenceSample() const { return referenceSample; }
+  //! Get the sample of the query points (empty if the search is
+  //! monochromatic).
+  const arma::mat& QuerySample() const { return querySample; }
+  //! Get whether the search is monochromatic.
+  bool Monochromatic() const { return numQueryPoints == 0; }
+
+  //! Get the estimated intrinsic dimension of the reference points.
+  double IntrinsicDimension() const { return intrinsicDimension; }
+
+  //! Get the predicted time of each candidate, after Select().
+  const arma::vec& PredictedTimes() const { return predictedTimes; }
+
+  /**
+   * Estimate the intrinsic dimension of the given points with the maximum
+   * likelihood estimator of Levina and Bickel, averaged over the points as
+   * suggested by MacKay and Ghahramani.  Points with duplicates among their
+   * neighbors are skipped.  The result is at least 1, and at most the number
+   * of dimensions of the points.
+   *
+   * @param points Points to estimate the intrinsic dimension of.
+   * @param k Number of neighbors to use for each point (at least 2).
+   */
+  static double EstimateIntrinsicDimension(const arma::mat& points,
+                                           const size_t k = 10);
+
+ private:
+  //! Draw a sample of the given size of the columns of the given matrix.
+  static void Sample(const arma::mat& points,
+                     const size_t sampleSize,
+                     arma::mat& sample);
+
+  //! The sample of the reference points.
+  arma::mat referenceSample;
+  //! The sample of the query points.
+  arma::mat querySample;
+  //! The number of reference points.
+  size_t numReferencePoints;
+  //! The number of query points (0 if the search is monochromatic).
+  size_t numQueryPoints;
+  //! The estimated intrinsic dimension of the reference points.
+  double intrinsicDimension;
+  //! The predicted times of the candidates of the last call to Select().
+  arma::vec predictedTimes;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "search_tuner_impl.hpp"
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file search_tuner_impl.hpp
+ *
+ * Implementation of the templated functions of the SearchTuner class.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_SEARCH_TUNER_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_SEARCH_TUNER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "search_tuner.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename TrialType>
+size_t SearchTuner::Select(TrialType& trial,
+                           const std::vector<SearchCandidate>& candidates)
+{
+  if (candidates.empty())
+    Log::Fatal << "SearchTuner::Select(): no candidates given!" << std::endl;
+
+  Log::Info << "Timing " << candidates.size() << " candidate searches on "
+      << referenceSample.n_cols << " reference points";
+  if (!Monochromatic())
+    Log::Info << " and " << querySample.n_cols << " query points";
+  Log::Info << "..." << std::endl;
+
+  predictedTimes.set_size(candidates.size());
+  size_t best = 0;
+  for (size_t i = 0; i < candidates.size(); ++i)
+  {
+    double buildTime = 0.0;
+    double searchTime = 0.0;
+    trial.Run(candidates[i], referenceSample,
+        (Monochromatic() ? NULL : &querySample), buildTime, searchTime);
+
+    predictedTimes[i] = PredictTime(candidates[i], buildTime, searchTime);
+    if (predictedTimes[i] < predictedTimes[best])
+      best = i;
+
+    Log::Info << "  " << candidates[i].ToString() << ": " << buildTime << "s "
+        << "building, " << searchTime << "s searching; predicted "
+        << predictedTimes[i] << "s." << std::endl;
+  }
+
+  Log::Info << "Selected " << candidates[best].ToString() << " (predicted "
+      << predictedTimes[best] << "s)." << std::endl;
+
+  return best;
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file single_candidate.hpp
+ *
+ * Definition of the SingleCandidate class, which keeps only the best neighbor
+ * candidate of each query point, for searches with k = 1.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_SINGLE_CANDIDATE_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_SINGLE_CANDIDATE_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The SingleCandidate class provides the same static utilities as
+ * CandidateHeap, for the case where only the best candidate of each query point
+ * is kept (k = 1).  The distances and neighbors matrices then have one row, so
+ * the candidate of query point i is element i of each matrix: it is both the
+ * best and the worst candidate, an insertion is one comparison, and there is
+ * nothing to sort when the search is finished.
+ *
+ * As with CandidateHeap, candidates with equal distances are ordered by their
+ * index, and before any search the neighbors matrix should be filled with
+ * (size_t() - 1) and the distances matrix with SortPolicy::WorstDistance().
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ */
+template<typename SortPolicy>
+class SingleCandidate
+{
+ public:
+  /**
+   * Return the distance of the candidate held for the given query point.
+   *
+   * @param distances Matrix of candidate distances (with one row).
+   * @param queryIndex Index of query point.
+   */
+  static double WorstDistance(const arma::mat& distances,
+                              const size_t queryIndex)
+  {
+    return distances[queryIndex];
+  }
+
+  /**
+   * Return the index of the candidate held for the given query point, or
+   * (size_t() - 1) if there is none yet.
+   *
+   * @param neighbors Matrix of candidate indices (with one row).
+   * @param queryIndex Index of query point.
+   */
+  static size_t WorstNeighbor(const arma::Mat<size_t>& neighbors,
+                              const size_t queryIndex)
+  {
+    return neighbors[queryIndex];
+  }
+
+  /**
+   * Replace the candidate of the given query point with the given candidate,
+   * if the new one is better.
+   *
+   * @param neighbors Matrix of candidate indices (with one row).
+   * @param distances Matrix of candidate distances (with one row).
+   * @param queryIndex Index of query point.
+   * @param neighbor Index of the new candidate.
+   * @param distance Distance between the query point and the new candidate.
+   * @return true if the candidate was inserted.
+   */
+  static bool Insert(arma::Mat<size_t>& neighbors,
+                     arma::mat& distances,
+                     const size_t queryIndex,
+                     const size_t neighbor,
+                     const double distance)
+  {
+    double& bestDistance = distances[queryIndex];
+    size_t& bestNeighbor = neighbors[queryIndex];
+    if (SortPolicy::IsBetter(distance, bestDistance) ||
+        (!SortPolicy::IsBetter(bestDistance, distance) &&
+         neighbor < bestNeighbor))
+    {
+      bestDistance = distance;
+      bestNeighbor = neighbor;
+      return true;
+    }
+
+    return false;
+  }
+
+  //! A single candidate is already sorted, so there is nothing to do.
+  static void Sort(arma::Mat<size_t>& /* neighbors */,
+                   arma::mat& /* distances */) { }
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -145,6 +145,22 @@ class FurthestNeighborSort
    */
   static inline double CombineWorst(const double a, const double b)
   { return std::max(a - b, 0.0); }
+
+  /**
+   * Return the relaxed version of the given bound, for approximate search with
+   * relative error epsilon: a distance can only improve on the relaxed bound
+   * if it is better than the bound by more than a factor of (1 + epsilon).
+   * In our case, this is value * (1 + epsilon).
+   *
+   * @param value Bound to relax.
+   * @param epsilon Relative error (non-negative).
+   */
+  static inline double Relax(const double value, const double epsilon)
+  {
+    if (value == DBL_MAX)
+      return DBL_MAX;
+    return value * (1 + epsilon);
+  }
 };
 
 }; // namespace neighbor
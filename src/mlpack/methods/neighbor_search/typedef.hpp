@@ -32,6 +32,42 @@ typedef NeighborSearch<NearestNeighborSort, metric::EuclideanDistance> AllkNN;
  */
 typedef NeighborSearch<FurthestNeighborSort, metric::EuclideanDistance> AllkFN;
 
+/**
+ * The AllkNN2D and AllkNN3D classes are the all-k-nearest-neighbors method for
+ * two- and three-dimensional data.  They return the same results as AllkNN,
+ * but the tree bounds and the metric loop over a fixed number of dimensions
+ * (see FixedHRectBound), which is faster for low-dimensional data.  The data
+ * must have the right dimensionality.
+ */
+typedef NeighborSearch<NearestNeighborSort,
+    tree::FixedDimensionKDTree<2>::MetricType,
+    tree::FixedDimensionKDTree<2, NeighborSearchStat<NearestNeighborSort> >::
+    Type> AllkNN2D;
+typedef NeighborSearch<NearestNeighborSort,
+    tree::FixedDimensionKDTree<3>::MetricType,
+    tree::FixedDimensionKDTree<3, NeighborSearchStat<NearestNeighborSort> >::
+    Type> AllkNN3D;
+
+/**
+ * The SpillKNN class is an approximate all-k-nearest-neighbors method: the
+ * reference points are held in a spill tree (see SpillTree), and each query
+ * point is only compared with the points of the one leaf it reaches without
+ * backtracking.  It returns L2 distances (Euclidean distances) for the best k
+ * neighbors found, which are not always the true nearest neighbors.
+ */
+typedef NeighborSearch<NearestNeighborSort, metric::EuclideanDistance,
+    tree::SpillTree<bound::HRectBound<2>,
+    NeighborSearchStat<NearestNeighborSort> > > SpillKNN;
+
+/**
+ * The IndexedKNN class is the all-k-nearest-neighbors method with trees that do
+ * not rearrange their dataset (see IndexedBinarySpaceTree), so the reference
+ * and query sets are not copied.  It returns the same results as AllkNN.
+ */
+typedef NeighborSearch<NearestNeighborSort, metric::EuclideanDistance,
+    tree::IndexedBinarySpaceTree<bound::HRectBound<2>,
+    NeighborSearchStat<NearestNeighborSort> > > IndexedKNN;
+
 }; // namespace neighbor
 }; // namespace mlpack
 
@@ -6,6 +6,8 @@
  */
 #include "unmap.hpp"
 
+#include <algorithm>
+
 namespace mlpack {
 namespace neighbor {
 
@@ -60,5 +62,60 @@ void Unmap(const arma::Mat<size_t>& neighbors,
     neighborsOut[j] = referenceMap[neighbors[j]];
 }
 
+// Useful in the dual-tree setting, without extra matrices.
+void Unmap(arma::Mat<size_t>& neighbors,
+           arma::mat& distances,
+           const std::vector<size_t>& referenceMap,
+           const std::vector<size_t>& queryMap,
+           const bool squareRoot)
+{
+  // Map the indices of the neighbors, and the distances if necessary.
+  Unmap(neighbors, distances, referenceMap, squareRoot);
+
+  // Column i belongs in column queryMap[i].  Each cycle of the permutation is
+  // followed from its first column: the carried column is swapped into its
+  // place, which gives us the column that was there to carry next, until the
+  // cycle comes back to where it started.
+  std::vector<bool> moved(queryMap.size(), false);
+  arma::Col<size_t> neighborsColumn(neighbors.n_rows);
+  arma::vec distancesColumn(distances.n_rows);
+  for (size_t start = 0; start < queryMap.size(); ++start)
+  {
+    if (moved[start])
+      continue;
+
+    neighborsColumn = neighbors.col(start);
+    distancesColumn = distances.col(start);
+
+    size_t i = start;
+    do
+    {
+      const size_t dest = queryMap[i];
+      std::swap_ranges(neighborsColumn.begin(), neighborsColumn.end(),
+          neighbors.colptr(dest));
+      std::swap_ranges(distancesColumn.begin(), distancesColumn.end(),
+          distances.colptr(dest));
+
+      moved[i] = true;
+      i = dest;
+    } while (i != start);
+  }
+}
+
+// Useful in the single-tree setting, without extra matrices.
+void Unmap(arma::Mat<size_t>& neighbors,
+           arma::mat& distances,
+           const std::vector<size_t>& referenceMap,
+           const bool squareRoot)
+{
+  // Take square root of distances, if necessary.
+  if (squareRoot)
+    distances = sqrt(distances);
+
+  // Map neighbors back to original locations.
+  for (size_t j = 0; j < neighbors.n_elem; ++j)
+    neighbors[j] = referenceMap[neighbors[j]];
+}
+
 }; // namespace neighbor
 }; // namespace mlpack
@@ -55,6 +55,42 @@ void Unmap(const arma::Mat<size_t>& neighbors,
            arma::mat& distancesOut,
            const bool squareRoot = false);
 
+/**
+ * Unmap the neighbors and distances matrices in place, as the dual-tree
+ * Unmap() above does into separate matrices.  The columns are moved along the
+ * cycles of the permutation given by queryMap, so only one extra column of
+ * each matrix is needed.
+ *
+ * @param neighbors Matrix of neighbors resulting from neighbor search, which
+ *      is unmapped in place.
+ * @param distances Matrix of distances resulting from neighbor search, which is
+ *      unmapped in place.
+ * @param referenceMap Mapping of reference set to old points.
+ * @param queryMap Mapping of query set to old points.
+ * @param squareRoot If true, take the square root of the distances.
+ */
+void Unmap(arma::Mat<size_t>& neighbors,
+           arma::mat& distances,
+           const std::vector<size_t>& referenceMap,
+           const std::vector<size_t>& queryMap,
+           const bool squareRoot = false);
+
+/**
+ * Unmap the entries of the neighbors matrix in place (and optionally take the
+ * square root of the distances), as the single-tree Unmap() above does into
+ * separate matrices.
+ *
+ * @param neighbors Matrix of neighbors resulting from neighbor search, which
+ *      is unmapped in place.
+ * @param distances Matrix of distances resulting from neighbor search.
+ * @param referenceMap Mapping of reference set to old points.
+ * @param squareRoot If true, take the square root of the distances.
+ */
+void Unmap(arma::Mat<size_t>& neighbors,
+           arma::mat& distances,
+           const std::vector<size_t>& referenceMap,
+           const bool squareRoot = false);
+
 }; // namespace neighbor
 }; // namespace mlpack
 
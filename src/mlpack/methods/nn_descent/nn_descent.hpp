@@ -0,0 +1,188 @@
+/**
+ * @file nn_descent.hpp
+ *
+ * Defines the NNDescent class, which builds an approximate k-nearest-neighbor
+ * graph of a dataset by refining neighbor lists through neighbors of
+ * neighbors.
+ *
+ * @code
+ * @inproceedings{dong2011efficient,
+ *   title={Efficient k-nearest neighbor graph construction for generic
+ *       similarity measures},
+ *   author={Dong, W. and Moses, C. and Li, K.},
+ *   booktitle={Proceedings of the 20th International Conference on World Wide
+ *       Web (WWW '11)},
+ *   pages={577--586},
+ *   year={2011}
+ * }
+ * @endcode
+ */
+#ifndef __MLPACK_METHODS_NN_DESCENT_NN_DESCENT_HPP
+#define __MLPACK_METHODS_NN_DESCENT_NN_DESCENT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * NNDescent computes an approximate k-nearest-neighbor graph of a dataset:
+ * the k approximate nearest neighbors of every point, excluding the point
+ * itself, in the same format as AllkNN in monochromatic mode.  It starts from
+ * random neighbor lists (or lists given by another search, such as RASearch)
+ * and repeatedly improves them on the principle that a neighbor of a neighbor
+ * is likely to be a neighbor.
+ *
+ * In each iteration every point does a "local join": each pair of points in
+ * its neighbor list and its reverse neighbor list (the points that have it as
+ * a neighbor) are compared, and each is offered to the other's list.  Only
+ * pairs in which at least one point is new (was added to a list since the
+ * last iteration) are compared, and only sampleRate * k of the new neighbors
+ * of each point take part in each iteration.  The iterations stop when fewer
+ * than delta * n * k neighbors changed in the last one.
+ *
+ * The local joins of a block of points are computed in parallel, and the
+ * improvements they find are then applied in parallel, with each thread
+ * owning the lists of a set of points, so no locking is needed.
+ *
+ * @code
+ * extern arma::mat dataset;
+ *
+ * NNDescent<> nnDescent(dataset);
+ * arma::Mat<size_t> neighbors;
+ * arma::mat distances;
+ * nnDescent.Search(10, neighbors, distances); // 10 neighbors of each point.
+ * @endcode
+ *
+ * @tparam MetricType The metric to use.
+ * @tparam MatType Type of the dataset.
+ */
+template<typename MetricType = metric::EuclideanDistance,
+         typename MatType = arma::mat>
+class NNDescent
+{
+ public:
+  /**
+   * Create the NNDescent object with the given dataset and parameters.  The
+   * dataset is not copied, so it must stay valid while this object is used.
+   *
+   * @param dataset Dataset to build the graph of.
+   * @param sampleRate Fraction of the k neighbors of each point (and of its
+   *     reverse neighbors) that take part in each local join.
+   * @param delta The iterations stop once fewer than delta * n * k neighbors
+   *     change in an iteration.
+   * @param maxIterations Maximum number of iterations (0 for no limit).
+   * @param metric Instantiated distance metric.
+   */
+  NNDescent(const MatType& dataset,
+            const double sampleRate = 1.0,
+            const double delta = 0.001,
+            const size_t maxIterations = 100,
+            const MetricType metric = MetricType());
+
+  /**
+   * Compute the approximate k nearest neighbors of each point of the dataset.
+   * The matrices will be set to k x n; column i holds the neighbors of point i
+   * and their distances, from the nearest to the furthest.  If initialGuess is
+   * true, the neighbors matrix is taken to hold initial neighbor lists (for
+   * instance, from RASearch or from a search with a smaller k), one column per
+   * point, with any number of rows; invalid entries are ignored, and lists with
+   * fewer than k valid neighbors are completed at random.
+   *
+   * @param k Number of neighbors to find for each point.
+   * @param resultingNeighbors Matrix to store the neighbors in.
+   * @param distances Matrix to store the distances in.
+   * @param initialGuess If true, resultingNeighbors holds initial neighbors.
+   */
+  void Search(const size_t k,
+              arma::Mat<size_t>& resultingNeighbors,
+              arma::mat& distances,
+              const bool initialGuess = false);
+
+  //! Get the sample rate.
+  double SampleRate() const { return sampleRate; }
+  //! Modify the sample rate.
+  double& SampleRate() { return sampleRate; }
+
+  //! Get the termination threshold.
+  double Delta() const { return delta; }
+  //! Modify the termination threshold.
+  double& Delta() { return delta; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of threads used for the local joins.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for the local joins.  This only has an
+  //! effect if mlpack was compiled with OpenMP.
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the number of iterations of the last search.
+  size_t Iterations() const { return iterations; }
+  //! Get the number of distance evaluations of the last search.
+  size_t BaseCases() const { return baseCases; }
+
+  // Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! A pair of points compared in a local join, and their distance.
+  struct JoinResult
+  {
+    size_t first;
+    size_t second;
+    double distance;
+  };
+
+  /**
+   * Offer the given candidate to the neighbor list of the given point, which
+   * is kept sorted by distance.  The candidate is marked as new if it is
+   * inserted.
+   *
+   * @return true if the candidate was inserted.
+   */
+  static bool Insert(arma::Mat<size_t>& neighbors,
+                     arma::mat& distances,
+                     arma::Mat<unsigned char>& isNew,
+                     const size_t point,
+                     const size_t candidate,
+                     const double distance);
+
+  /**
+   * Append up to sampleSize randomly chosen elements of candidates to list.
+   * The order of candidates is changed.
+   */
+  static void Sample(std::vector<size_t>& candidates,
+                     const size_t sampleSize,
+                     std::vector<size_t>& list);
+
+  //! The dataset.
+  const MatType& dataset;
+  //! The fraction of each neighbor list sampled in each iteration.
+  double sampleRate;
+  //! The termination threshold.
+  double delta;
+  //! The maximum number of iterations.
+  size_t maxIterations;
+  //! Instantiated distance metric.
+  MetricType metric;
+  //! The number of threads used for the local joins.
+  size_t numThreads;
+
+  //! The number of iterations of the last search.
+  size_t iterations;
+  //! The number of distance evaluations of the last search.
+  size_t baseCases;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "nn_descent_impl.hpp"
+
+#endif
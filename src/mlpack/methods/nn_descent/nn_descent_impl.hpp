@@ -0,0 +1,355 @@
+/**
+ * @file nn_descent_impl.hpp
+ *
+ * Implementation of the NNDescent class.
+ */
+#ifndef __MLPACK_METHODS_NN_DESCENT_NN_DESCENT_IMPL_HPP
+#define __MLPACK_METHODS_NN_DESCENT_NN_DESCENT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "nn_descent.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename MetricType, typename MatType>
+NNDescent<MetricType, MatType>::NNDescent(const MatType& dataset,
+                                          const double sampleRate,
+                                          const double delta,
+                                          const size_t maxIterations,
+                                          const MetricType metric) :
+    dataset(dataset),
+    sampleRate(sampleRate),
+    delta(delta),
+    maxIterations(maxIterations),
+    metric(metric),
+    numThreads(1),
+    iterations(0),
+    baseCases(0)
+{
+  if (sampleRate <= 0.0 || sampleRate > 1.0)
+  {
+    Log::Fatal << "NNDescent::NNDescent(): sample rate (" << sampleRate
+        << ") must be in (0, 1]!" << std::endl;
+  }
+
+  if (delta < 0.0)
+  {
+    Log::Fatal << "NNDescent::NNDescent(): delta (" << delta << ") must be "
+        << "non-negative!" << std::endl;
+  }
+}
+
+template<typename MetricType, typename MatType>
+void NNDescent<MetricType, MatType>::Search(
+    const size_t k,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances,
+    const bool initialGuess)
+{
+  const size_t n = dataset.n_cols;
+  if (k == 0 || k >= n)
+  {
+    Log::Fatal << "NNDescent::Search(): invalid k (" << k << "); must be "
+        << "greater than 0 and less than the number of points (" << n << ")."
+        << std::endl;
+  }
+
+  if (initialGuess && resultingNeighbors.n_cols != n)
+  {
+    Log::Fatal << "NNDescent::Search(): the initial neighbors have "
+        << resultingNeighbors.n_cols << " columns, but there are " << n
+        << " points!" << std::endl;
+  }
+
+  Timer::Start("computing_neighbors");
+  iterations = 0;
+  baseCases = 0;
+
+  // Start from the initial guess (if there is one), and fill the rest of each
+  // list with random points.
+  const arma::Mat<size_t> guess = initialGuess ? resultingNeighbors :
+      arma::Mat<size_t>();
+  resultingNeighbors.set_size(k, n);
+  resultingNeighbors.fill(size_t() - 1);
+  distances.set_size(k, n);
+  distances.fill(DBL_MAX);
+  arma::Mat<unsigned char> isNew(k, n);
+  isNew.fill(1);
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t filled = 0;
+    for (size_t j = 0; j < guess.n_rows && filled < k; ++j)
+    {
+      const size_t candidate = guess(j, i);
+      if (candidate >= n)
+        continue;
+
+      ++baseCases;
+      if (Insert(resultingNeighbors, distances, isNew, i, candidate,
+          metric.Evaluate(dataset.col(i), dataset.col(candidate))))
+        ++filled;
+    }
+
+    while (filled < k)
+    {
+      const size_t candidate = (size_t) math::RandInt(n);
+      if (candidate == i)
+        continue;
+
+      ++baseCases;
+      if (Insert(resultingNeighbors, distances, isNew, i, candidate,
+          metric.Evaluate(dataset.col(i), dataset.col(candidate))))
+        ++filled;
+    }
+  }
+
+  const size_t sampleSize = std::max((size_t) 1,
+      (size_t) std::ceil(sampleRate * k));
+
+  // The local joins are done a block of points at a time, so that the
+  // improvements found so far are used by the later blocks of the same
+  // iteration, and so that the pairs waiting to be applied take little memory.
+  const size_t blockSize = 4096;
+
+  std::vector<std::vector<size_t> > newLists(n);
+  std::vector<std::vector<size_t> > oldLists(n);
+  std::vector<std::vector<size_t> > newReverse(n);
+  std::vector<std::vector<size_t> > oldReverse(n);
+  std::vector<size_t> positions;
+  std::vector<size_t> sampled;
+
+  while (maxIterations == 0 || iterations < maxIterations)
+  {
+    ++iterations;
+
+    // Sample the new neighbors of each point that take part in this iteration
+    // (they will be old in the next one); all the old neighbors take part.
+    for (size_t i = 0; i < n; ++i)
+    {
+      newLists[i].clear();
+      oldLists[i].clear();
+      newReverse[i].clear();
+      oldReverse[i].clear();
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      positions.clear();
+      for (size_t j = 0; j < k; ++j)
+      {
+        if (resultingNeighbors(j, i) == size_t() - 1)
+          continue;
+
+        if (isNew(j, i))
+          positions.push_back(j);
+        else
+          oldLists[i].push_back(resultingNeighbors(j, i));
+      }
+
+      sampled.clear();
+      Sample(positions, sampleSize, sampled);
+      for (size_t s = 0; s < sampled.size(); ++s)
+      {
+        newLists[i].push_back(resultingNeighbors(sampled[s], i));
+        isNew(sampled[s], i) = 0;
+      }
+    }
+
+    // Add a sample of the reverse neighbors of each point.
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j < newLists[i].size(); ++j)
+        newReverse[newLists[i][j]].push_back(i);
+      for (size_t j = 0; j < oldLists[i].size(); ++j)
+        oldReverse[oldLists[i][j]].push_back(i);
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      Sample(newReverse[i], sampleSize, newLists[i]);
+      Sample(oldReverse[i], sampleSize, oldLists[i]);
+
+      std::sort(newLists[i].begin(), newLists[i].end());
+      newLists[i].erase(std::unique(newLists[i].begin(), newLists[i].end()),
+          newLists[i].end());
+      std::sort(oldLists[i].begin(), oldLists[i].end());
+      oldLists[i].erase(std::unique(oldLists[i].begin(), oldLists[i].end()),
+          oldLists[i].end());
+    }
+
+    size_t changes = 0;
+    for (size_t blockBegin = 0; blockBegin < n; blockBegin += blockSize)
+    {
+      const size_t blockEnd = std::min(blockBegin + blockSize, n);
+      std::vector<std::vector<JoinResult> > threadResults(numThreads);
+
+      // Compare the pairs of each point's lists.  The lists are only read
+      // here, so a pair is kept only if it would improve one of them now.
+      #pragma omp parallel num_threads(numThreads)
+      {
+        size_t thread = 0;
+#ifdef HAS_OPENMP
+        thread = (size_t) omp_get_thread_num();
+#endif
+        std::vector<JoinResult>& results = threadResults[thread];
+        size_t threadBaseCases = 0;
+        JoinResult result;
+
+        #pragma omp for schedule(dynamic, 16)
+        for (size_t i = blockBegin; i < blockEnd; ++i)
+        {
+          const std::vector<size_t>& newList = newLists[i];
+          const std::vector<size_t>& oldList = oldLists[i];
+          for (size_t a = 0; a < newList.size(); ++a)
+          {
+            result.first = newList[a];
+            for (size_t b = a + 1; b < newList.size() + oldList.size(); ++b)
+            {
+              result.second = (b < newList.size()) ? newList[b] :
+                  oldList[b - newList.size()];
+              if (result.second == result.first)
+                continue;
+
+              result.distance = metric.Evaluate(dataset.col(result.first),
+                  dataset.col(result.second));
+              ++threadBaseCases;
+
+              if (result.distance < distances(k - 1, result.first) ||
+                  result.distance < distances(k - 1, result.second))
+                results.push_back(result);
+            }
+          }
+        }
+
+        #pragma omp critical
+        {
+          baseCases += threadBaseCases;
+        }
+      }
+
+      // Apply the improvements; each thread only changes the lists of the
+      // points it owns, so no locking is necessary.
+      #pragma omp parallel num_threads(numThreads)
+      {
+        size_t thread = 0;
+        size_t threads = 1;
+#ifdef HAS_OPENMP
+        thread = (size_t) omp_get_thread_num();
+        threads = (size_t) omp_get_num_threads();
+#endif
+        size_t threadChanges = 0;
+        for (size_t t = 0; t < threadResults.size(); ++t)
+        {
+          const std::vector<JoinResult>& results = threadResults[t];
+          for (size_t r = 0; r < results.size(); ++r)
+          {
+            const JoinResult& result = results[r];
+            if (result.first % threads == thread &&
+                Insert(resultingNeighbors, distances, isNew, result.first,
+                result.second, result.distance))
+              ++threadChanges;
+            if (result.second % threads == thread &&
+                Insert(resultingNeighbors, distances, isNew, result.second,
+                result.first, result.distance))
+              ++threadChanges;
+          }
+        }
+
+        #pragma omp critical
+        {
+          changes += threadChanges;
+        }
+      }
+    }
+
+    Log::Info << "NN-descent iteration " << iterations << ": " << changes
+        << " neighbors changed." << std::endl;
+
+    if (changes <= delta * n * k)
+      break;
+  }
+
+  Timer::Stop("computing_neighbors");
+
+  Log::Info << baseCases << " distance evaluations in " << iterations
+      << " iterations." << std::endl;
+}
+
+template<typename MetricType, typename MatType>
+bool NNDescent<MetricType, MatType>::Insert(arma::Mat<size_t>& neighbors,
+                                            arma::mat& distances,
+                                            arma::Mat<unsigned char>& isNew,
+                                            const size_t point,
+                                            const size_t candidate,
+                                            const double distance)
+{
+  const size_t k = neighbors.n_rows;
+  if (candidate == point || distance >= distances(k - 1, point))
+    return false;
+
+  for (size_t j = 0; j < k; ++j)
+    if (neighbors(j, point) == candidate)
+      return false;
+
+  // Shift the worse neighbors down to make room.
+  size_t pos = k - 1;
+  while (pos > 0 && distances(pos - 1, point) > distance)
+  {
+    neighbors(pos, point) = neighbors(pos - 1, point);
+    distances(pos, point) = distances(pos - 1, point);
+    isNew(pos, point) = isNew(pos - 1, point);
+    --pos;
+  }
+
+  neighbors(pos, point) = candidate;
+  distances(pos, point) = distance;
+  isNew(pos, point) = 1;
+  return true;
+}
+
+template<typename MetricType, typename MatType>
+void NNDescent<MetricType, MatType>::Sample(std::vector<size_t>& candidates,
+                                            const size_t sampleSize,
+                                            std::vector<size_t>& list)
+{
+  if (candidates.size() <= sampleSize)
+  {
+    list.insert(list.end(), candidates.begin(), candidates.end());
+    return;
+  }
+
+  // A partial Fisher-Yates shuffle.
+  for (size_t s = 0; s < sampleSize; ++s)
+  {
+    const size_t chosen = s + (size_t) math::RandInt(candidates.size() - s);
+    std::swap(candidates[s], candidates[chosen]);
+    list.push_back(candidates[s]);
+  }
+}
+
+template<typename MetricType, typename MatType>
+std::string NNDescent<MetricType, MatType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "NNDescent [" << this << "]" << std::endl;
+  convert << "  Sample rate: " << sampleRate << std::endl;
+  convert << "  Delta: " << delta << std::endl;
+  convert << "  Maximum iterations: " << maxIterations << std::endl;
+  convert << "  Metric: " << std::endl <<
+      mlpack::util::Indent(metric.ToString(), 2);
+  return convert.str();
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
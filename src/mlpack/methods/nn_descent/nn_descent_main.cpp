@@ -0,0 +1,126 @@
+/**
+ * @file nn_descent_main.cpp
+ *
+ * Executable for building an approximate k-nearest-neighbor graph with
+ * NN-descent.
+ */
+#include <time.h>
+#include <mlpack/core.hpp>
+#include <string>
+
+#include "nn_descent.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+// Information about the program itself.
+PROGRAM_INFO("Approximate k-Nearest-Neighbor Graph Construction with "
+    "NN-Descent",
+    "This program will calculate the k approximate-nearest-neighbors of each "
+    "point in a dataset (excluding the point itself) with NN-descent, which "
+    "starts from random neighbors and repeatedly compares the neighbors of "
+    "neighbors of each point.  This is much cheaper than exact all-k-nearest-"
+    "neighbors search when only a good k-nearest-neighbor graph is needed."
+    "\n\n"
+    "Each iteration samples --sample_rate times k of the new neighbors of each "
+    "point, and the iterations stop once fewer than --delta times n times k "
+    "neighbors changed in an iteration, or after --max_iterations iterations.  "
+    "The search can be started from the neighbors in --initial_file (for "
+    "instance, the output of allkrann with a smaller k) instead of random "
+    "neighbors."
+    "\n\n"
+    "For example, the following will find 10 neighbors of each point in "
+    "'input.csv' and store the distances in 'distances.csv' and the neighbors "
+    "in 'neighbors.csv':"
+    "\n\n"
+    "$ nn_descent -k 10 -r input.csv -d distances.csv -n neighbors.csv"
+    "\n\n"
+    "The output files are organized in the same way as those of allknn: row i "
+    "and column j in the neighbors output file is the index of the i'th "
+    "nearest neighbor of point j, and row i and column j in the distances "
+    "output file is the distance between those two points.");
+
+// Define our input parameters that this program will take.
+PARAM_STRING_REQ("reference_file", "File containing the dataset.", "r");
+PARAM_STRING("distances_file", "File to output distances into.", "d", "");
+PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
+PARAM_INT_REQ("k", "Number of nearest neighbors to find.", "k");
+
+PARAM_DOUBLE("sample_rate", "Fraction of the neighbors of each point sampled "
+    "in each iteration.", "S", 1.0);
+PARAM_DOUBLE("delta", "Stop once fewer than delta * n * k neighbors change in "
+    "an iteration.", "D", 0.001);
+PARAM_INT("max_iterations", "Maximum number of iterations (0 for no limit).",
+    "m", 100);
+PARAM_STRING("initial_file", "File containing initial neighbors of each point "
+    "(one column per point), to start from instead of random neighbors.", "i",
+    "");
+PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+
+int main(int argc, char *argv[])
+{
+  // Give CLI the command line parameters the user passed in.
+  CLI::ParseCommandLine(argc, argv);
+
+  if (CLI::GetParam<int>("seed") != 0)
+    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
+  else
+    math::RandomSeed((size_t) time(NULL));
+
+  const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string distancesFile = CLI::GetParam<string>("distances_file");
+  const string neighborsFile = CLI::GetParam<string>("neighbors_file");
+  const string initialFile = CLI::GetParam<string>("initial_file");
+  const double sampleRate = CLI::GetParam<double>("sample_rate");
+  const double delta = CLI::GetParam<double>("delta");
+
+  if (CLI::GetParam<int>("k") <= 0)
+  {
+    Log::Fatal << "Invalid k: " << CLI::GetParam<int>("k") << "; must be "
+        << "greater than 0." << endl;
+  }
+  const size_t k = (size_t) CLI::GetParam<int>("k");
+
+  if (CLI::GetParam<int>("max_iterations") < 0)
+  {
+    Log::Fatal << "Invalid number of maximum iterations: "
+        << CLI::GetParam<int>("max_iterations") << ".  Must be 0 or greater."
+        << endl;
+  }
+  const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
+
+  arma::mat referenceData;
+  data::Load(referenceFile, referenceData, true);
+  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
+
+  if (k >= referenceData.n_cols)
+  {
+    Log::Fatal << "Invalid k: " << k << "; must be less than the number of "
+        << "points (" << referenceData.n_cols << ")." << endl;
+  }
+
+  arma::Mat<size_t> neighbors;
+  if (initialFile != "")
+  {
+    data::Load(initialFile, neighbors, true);
+    Log::Info << "Loaded initial neighbors from '" << initialFile << "' ("
+        << neighbors.n_rows << " x " << neighbors.n_cols << ")." << endl;
+  }
+
+  NNDescent<> nnDescent(referenceData, sampleRate, delta, maxIterations);
+  nnDescent.NumThreads() = CLI::HasParam("threads") ? util::NumThreads() : 1;
+
+  Log::Info << "Computing " << k << " approximate nearest neighbors." << endl;
+  arma::mat distances;
+  nnDescent.Search(k, neighbors, distances, (initialFile != ""));
+  Log::Info << "Neighbors computed." << endl;
+
+  // Save output.
+  if (distancesFile != "")
+    data::Save(distancesFile, distances);
+
+  if (neighborsFile != "")
+    data::Save(neighborsFile, neighbors);
+}
@@ -0,0 +1,149 @@
+/**
+ * @file kernel_block.hpp
+ *
+ * Evaluation of blocks of kernel matrices, in parallel, for the Nystroem
+ * method; the Gaussian and polynomial kernels are computed from matrix
+ * products.
+ */
+#ifndef __MLPACK_METHODS_NYSTROEM_METHOD_KERNEL_BLOCK_HPP
+#define __MLPACK_METHODS_NYSTROEM_METHOD_KERNEL_BLOCK_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * Compute the kernel between each column of a and each column of b, so that
+ * block(i, j) = K(a_i, b_j).  The rows of the block are computed in parallel
+ * with OpenMP, so the kernel's Evaluate() must be safe to call concurrently.
+ *
+ * @param kernel Kernel to evaluate.
+ * @param a Points of the rows of the block.
+ * @param b Points of the columns of the block.
+ * @param block Matrix to store the kernel values in.
+ */
+template<typename KernelType>
+void KernelBlock(KernelType& kernel,
+                 const arma::mat& a,
+                 const arma::mat& b,
+                 arma::mat& block)
+{
+  block.set_size(a.n_cols, b.n_cols);
+
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < a.n_cols; ++i)
+    for (size_t j = 0; j < b.n_cols; ++j)
+      block(i, j) = kernel.Evaluate(a.col(i), b.col(j));
+}
+
+/**
+ * Compute the products a_i^T b_j for the columns of a, in parallel blocks of
+ * points, and store f(i, j, a_i^T b_j) for each entry; the products of each
+ * block are one matrix-matrix multiplication.
+ */
+template<typename TransformType>
+void ProductBlock(const arma::mat& a,
+                  const arma::mat& b,
+                  const TransformType& transform,
+                  arma::mat& block)
+{
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (a.n_cols + blockSize - 1) / blockSize;
+  block.set_size(a.n_cols, b.n_cols);
+
+  #pragma omp parallel
+  {
+    arma::mat products;
+
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < numBlocks; ++k)
+    {
+      const size_t begin = k * blockSize;
+      const size_t end = std::min((size_t) a.n_cols, begin + blockSize);
+
+      // Use the columns of the block in place.
+      const arma::mat points(const_cast<double*>(a.colptr(begin)), a.n_rows,
+          end - begin, false, true);
+      products = arma::trans(points) * b;
+
+      for (size_t j = 0; j < b.n_cols; ++j)
+        for (size_t i = begin; i < end; ++i)
+          block(i, j) = transform(i, j, products(i - begin, j));
+    }
+  }
+}
+
+//! Map a product to the Gaussian kernel, with the squared norms of the points.
+class GaussianProductTransform
+{
+ public:
+  GaussianProductTransform(const double gamma,
+                           const arma::rowvec& aNorms,
+                           const arma::rowvec& bNorms) :
+      gamma(gamma), aNorms(aNorms), bNorms(bNorms) { }
+
+  double operator()(const size_t i, const size_t j, const double product) const
+  {
+    // Rounding can make the squared distance slightly negative.
+    return std::exp(gamma * std::max(0.0, aNorms[i] + bNorms[j] -
+        2 * product));
+  }
+
+ private:
+  double gamma;
+  const arma::rowvec& aNorms;
+  const arma::rowvec& bNorms;
+};
+
+//! Map a product to the polynomial kernel.
+class PolynomialProductTransform
+{
+ public:
+  PolynomialProductTransform(const double degree, const double offset) :
+      degree(degree), offset(offset) { }
+
+  double operator()(const size_t /* i */,
+                    const size_t /* j */,
+                    const double product) const
+  {
+    return std::pow(product + offset, degree);
+  }
+
+ private:
+  double degree;
+  double offset;
+};
+
+/**
+ * Compute a block of the Gaussian kernel matrix from the products a^T b, since
+ * ||a_i - b_j||^2 = ||a_i||^2 + ||b_j||^2 - 2 a_i^T b_j.
+ */
+inline void KernelBlock(GaussianKernel& kernel,
+                        const arma::mat& a,
+                        const arma::mat& b,
+                        arma::mat& block)
+{
+  const arma::rowvec aNorms = arma::sum(arma::square(a), 0);
+  const arma::rowvec bNorms = arma::sum(arma::square(b), 0);
+
+  ProductBlock(a, b, GaussianProductTransform(kernel.Gamma(), aNorms, bNorms),
+      block);
+}
+
+/**
+ * Compute a block of the polynomial kernel matrix from the products a^T b.
+ */
+inline void KernelBlock(PolynomialKernel& kernel,
+                        const arma::mat& a,
+                        const arma::mat& b,
+                        arma::mat& block)
+{
+  ProductBlock(a, b, PolynomialProductTransform(kernel.Degree(),
+      kernel.Offset()), block);
+}
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
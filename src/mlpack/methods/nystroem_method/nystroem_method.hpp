@@ -12,6 +12,7 @@
 
 #include <mlpack/core.hpp>
 #include "kmeans_selection.hpp"
+#include "kernel_block.hpp"
 
 namespace mlpack {
 namespace kernel {
@@ -43,6 +44,7 @@ class NystroemMethod
 
   /**
    * Construct the kernel matrix with matrix that contains the selected points.
+   * The kernel blocks are evaluated in parallel (see KernelBlock()).
    *
    * @param data Data matrix pointer.
    * @param miniKernel to store the constructed mini-kernel matrix in.
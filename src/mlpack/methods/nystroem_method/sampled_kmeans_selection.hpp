@@ -0,0 +1,79 @@
+/**
+ * @file sampled_kmeans_selection.hpp
+ *
+ * Use the centroids of K-Means clustering on a random sample of the dataset
+ * for use in the Nystroem method of kernel matrix approximation.
+ */
+#ifndef __MLPACK_METHODS_NYSTROEM_METHOD_SAMPLED_KMEANS_SELECTION_HPP
+#define __MLPACK_METHODS_NYSTROEM_METHOD_SAMPLED_KMEANS_SELECTION_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/kmeans/kmeans.hpp>
+#include <set>
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * Select the points as KMeansSelection does, but cluster only a random sample
+ * of samplesPerPoint * m distinct points of the dataset (or the whole dataset,
+ * if it is smaller), so the cost of the clustering does not grow with the size
+ * of the dataset.  The centroids of a sample of about ten points per cluster
+ * are nearly as good landmarks as those of the whole dataset.
+ *
+ * @tparam ClusteringType Type of clustering.
+ * @tparam maxIterations Maximum number of iterations allowed before giving up.
+ * @tparam samplesPerPoint Number of points sampled for each selected point.
+ */
+template<typename ClusteringType = kmeans::KMeans<>,
+         size_t maxIterations = 5,
+         size_t samplesPerPoint = 10>
+class SampledKMeansSelection
+{
+ public:
+  /**
+   * Use the K-Means clustering method on a random sample of the dataset to
+   * select the specified number of points.  You are responsible for deleting
+   * the returned matrix!
+   *
+   * @param data Dataset to sample from.
+   * @param m Number of points to select.
+   * @return Matrix pointer in which centroids are stored.
+   */
+  const static arma::mat* Select(const arma::mat& data, const size_t m)
+  {
+    arma::Col<size_t> assignments;
+    arma::mat* centroids = new arma::mat;
+    ClusteringType kmeans(maxIterations);
+
+    const size_t samples = samplesPerPoint * m;
+    if (samples >= data.n_cols)
+    {
+      kmeans.Cluster(data, m, assignments, *centroids);
+      return centroids;
+    }
+
+    // Floyd's algorithm picks distinct points in O(samples log samples) time.
+    std::set<size_t> chosen;
+    for (size_t j = data.n_cols - samples; j < data.n_cols; ++j)
+    {
+      const size_t t = (size_t) math::RandInt(0, (int) j + 1);
+      if (!chosen.insert(t).second)
+        chosen.insert(j);
+    }
+
+    arma::mat sample(data.n_rows, samples);
+    size_t i = 0;
+    for (std::set<size_t>::const_iterator it = chosen.begin();
+         it != chosen.end(); ++it, ++i)
+      sample.col(i) = data.col(*it);
+
+    kmeans.Cluster(sample, m, assignments, *centroids);
+    return centroids;
+  }
+};
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
@@ -36,21 +36,7 @@ void PCA::Apply(const arma::mat& data,
 
   // Center the data into a temporary matrix.
   arma::mat centeredData;
-  math::Center(data, centeredData);
-
-  if (scaleData)
-  {
-    // Scaling the data is when we reduce the variance of each dimension to 1.
-    // We do this by dividing each dimension by its standard deviation.
-    arma::vec stdDev = arma::stddev(centeredData, 0, 1 /* for each dimension */);
-
-    // If there are any zeroes, make them very small.
-    for (size_t i = 0; i < stdDev.n_elem; ++i)
-      if (stdDev[i] == 0)
-        stdDev[i] = 1e-50;
-
-    centeredData /= arma::repmat(stdDev, 1, centeredData.n_cols);
-  }
+  Center(data, centeredData);
 
   // Do singular value decomposition.  Use the economical singular value
   // decomposition if the columns are much larger than the rows.
@@ -116,6 +102,28 @@ double PCA::Apply(arma::mat& data, const size_t newDimension) const
   arma::mat coeffs;
   arma::vec eigVal;
 
+  // When few dimensions are kept, only the leading singular vectors are
+  // computed, with the randomized SVD.
+  if (math::PreferRandomizedSVD(newDimension, data.n_rows, data.n_cols))
+  {
+    Timer::Start("pca");
+
+    // The data is overwritten anyway, so it is centered in place.
+    arma::mat v;
+    math::Center(data);
+    math::RandomizedSVD(data, newDimension, coeffs, eigVal, v);
+
+    // The total variance is the squared Frobenius norm of the centered data
+    // (the factor 1 / (N - 1) of the eigenvalues cancels).
+    const double totalVariance = arma::accu(arma::square(data));
+
+    data = arma::trans(coeffs) * data;
+
+    Timer::Stop("pca");
+
+    return arma::accu(arma::square(eigVal)) / totalVariance;
+  }
+
   Apply(data, data, eigVal, coeffs);
 
   if (newDimension < coeffs.n_rows)
@@ -172,6 +180,29 @@ double PCA::Apply(arma::mat& data, const double varRetained) const
   return varSum;
 }
 
+/**
+ * Center the data, and scale each dimension by its standard deviation if
+ * scaleData is set.
+ */
+void PCA::Center(const arma::mat& data, arma::mat& centeredData) const
+{
+  math::Center(data, centeredData);
+
+  if (scaleData)
+  {
+    // Scaling the data is when we reduce the variance of each dimension to 1.
+    // We do this by dividing each dimension by its standard deviation.
+    arma::vec stdDev = arma::stddev(centeredData, 0, 1 /* for each dimension */);
+
+    // If there are any zeroes, make them very small.
+    for (size_t i = 0; i < stdDev.n_elem; ++i)
+      if (stdDev[i] == 0)
+        stdDev[i] = 1e-50;
+
+    centeredData /= arma::repmat(stdDev, 1, centeredData.n_cols);
+  }
+}
+
 // return a string of this object.
 std::string PCA::ToString() const
 {
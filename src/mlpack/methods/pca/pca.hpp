@@ -64,6 +64,10 @@ class PCA
    * retained; this is a value between 0 and 1.  For instance, a value of 0.9
    * indicates that 90% of the variance present in the data was retained.
    *
+   * If newDimension is much smaller than the dimensionality (and the number of
+   * points), only the leading principal components are computed, with
+   * math::RandomizedSVD().
+   *
    * @param data Data matrix.
    * @param newDimension New dimension of the data.
    * @return Amount of the variance of the data retained (between 0 and 1).
@@ -108,6 +112,9 @@ class PCA
   //! performed.
   bool scaleData;
 
+  //! Center the data, and scale it if scaleData is set.
+  void Center(const arma::mat& data, arma::mat& centeredData) const;
+
 }; // class PCA
 
 }; // namespace pca
@@ -7,6 +7,7 @@
 #include <mlpack/core.hpp>
 
 #include "pca.hpp"
+#include "streaming_pca.hpp"
 
 using namespace mlpack;
 using namespace mlpack::pca;
@@ -17,7 +18,11 @@ PROGRAM_INFO("Principal Components Analysis", "This program performs principal "
     "components analysis on the given dataset.  It will transform the data "
     "onto its principal components, optionally performing dimensionality "
     "reduction by ignoring the principal components with the smallest "
-    "eigenvalues.");
+    "eigenvalues."
+    "\n\n"
+    "If --chunk_size (-c) is given, the dataset is read that many points at a "
+    "time, in two passes (one to compute the covariance matrix, and one to "
+    "transform the points), so it never has to fit in memory.");
 
 // Parameters for program.
 PARAM_STRING_REQ("input_file", "Input dataset to perform PCA on.", "i");
@@ -29,6 +34,63 @@ PARAM_DOUBLE("var_to_retain", "Amount of variance to retain; should be between "
 
 PARAM_FLAG("scale", "If set, the data will be scaled before running PCA, such "
     "that the variance of each feature is 1.", "s");
+PARAM_INT("chunk_size", "If nonzero, stream the dataset from disk this many "
+    "points at a time.", "c", 0);
+
+// Perform streaming PCA, reading the input file twice.
+void StreamingTransform(const string& inputFile,
+                        const string& outputFile,
+                        const size_t chunkSize,
+                        const bool scale)
+{
+  StreamingPCA p(scale);
+  data::ChunkReader reader(inputFile, true);
+  arma::mat chunk;
+
+  Log::Info << "Computing the covariance of the dataset..." << endl;
+  while (reader.Read(chunk, chunkSize))
+    p.Add(chunk);
+  if (reader.Failed())
+    Log::Fatal << "Could not read '" << inputFile << "'!" << endl;
+
+  p.Fit();
+
+  // Find out what dimension we want.
+  size_t newDimension = p.Mean().n_elem; // No reduction, by default.
+  if (CLI::GetParam<double>("var_to_retain") != 0)
+  {
+    if (CLI::GetParam<int>("new_dimensionality") != 0)
+      Log::Warn << "New dimensionality (-d) ignored because -V was specified."
+          << endl;
+
+    newDimension = p.Dimension(CLI::GetParam<double>("var_to_retain"));
+  }
+  else if (CLI::GetParam<int>("new_dimensionality") != 0)
+  {
+    newDimension = (size_t) CLI::GetParam<int>("new_dimensionality");
+    if (newDimension > p.Mean().n_elem)
+    {
+      Log::Fatal << "New dimensionality (" << newDimension
+          << ") cannot be greater than existing dimensionality ("
+          << p.Mean().n_elem << ")!" << endl;
+    }
+  }
+
+  Log::Info << (p.VarianceRetained(newDimension) * 100) << "% of variance "
+      << "retained (" << newDimension << " dimensions)." << endl;
+
+  // Transform the points in a second pass.
+  data::ChunkWriter writer(outputFile, true, true);
+  arma::mat transformed;
+  reader.Reset();
+  while (reader.Read(chunk, chunkSize))
+  {
+    p.Transform(chunk, transformed, newDimension);
+    writer.Write(transformed);
+  }
+  if (reader.Failed())
+    Log::Fatal << "Could not read '" << inputFile << "'!" << endl;
+}
 
 int main(int argc, char** argv)
 {
@@ -37,6 +99,18 @@ int main(int argc, char** argv)
 
   // Load input dataset.
   string inputFile = CLI::GetParam<string>("input_file");
+
+  if (CLI::GetParam<int>("chunk_size") < 0)
+    Log::Fatal << "Invalid chunk size (" << CLI::GetParam<int>("chunk_size")
+        << "); must be nonnegative." << endl;
+
+  if (CLI::GetParam<int>("chunk_size") > 0)
+  {
+    StreamingTransform(inputFile, CLI::GetParam<string>("output_file"),
+        (size_t) CLI::GetParam<int>("chunk_size"), CLI::HasParam("scale"));
+    return 0;
+  }
+
   arma::mat dataset;
   data::Load(inputFile, dataset);
 
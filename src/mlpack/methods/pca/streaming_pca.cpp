@@ -0,0 +1,191 @@
+/**
+ * @file streaming_pca.cpp
+ *
+ * Implementation of the StreamingPCA class.
+ */
+#include "streaming_pca.hpp"
+
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::pca;
+
+StreamingPCA::StreamingPCA(const bool scaleData) :
+    scaleData(scaleData),
+    points(0)
+{ }
+
+void StreamingPCA::Add(const arma::mat& chunk)
+{
+  if (chunk.n_cols == 0)
+    return;
+
+  if (points > 0 && chunk.n_rows != mean.n_elem)
+    Log::Fatal << "StreamingPCA::Add(): the points have dimensionality "
+        << chunk.n_rows << ", but the points added before have dimensionality "
+        << mean.n_elem << "!" << endl;
+
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (chunk.n_cols + blockSize - 1) / blockSize;
+
+  size_t numThreads = 1;
+#ifdef HAS_OPENMP
+  numThreads = std::max((size_t) 1, std::min(numBlocks,
+      (size_t) omp_get_max_threads()));
+#endif
+
+  // Each thread merges the moments of its blocks into its own totals.
+  std::vector<size_t> threadPoints(numThreads, 0);
+  std::vector<arma::vec> threadMeans(numThreads);
+  std::vector<arma::mat> threadScatters(numThreads);
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    threadMeans[t].zeros(chunk.n_rows);
+    threadScatters[t].zeros(chunk.n_rows, chunk.n_rows);
+  }
+
+  #pragma omp parallel num_threads(numThreads) if (numThreads > 1)
+  {
+    size_t thread = 0;
+#ifdef HAS_OPENMP
+    thread = (size_t) omp_get_thread_num();
+#endif
+
+    arma::mat centered;
+    arma::vec blockMean;
+
+    #pragma omp for schedule(static, 1)
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min((size_t) chunk.n_cols, begin + blockSize);
+
+      blockMean = arma::mean(chunk.cols(begin, end - 1), 1);
+      centered = chunk.cols(begin, end - 1);
+      centered.each_col() -= blockMean;
+
+      Merge(threadPoints[thread], threadMeans[thread], threadScatters[thread],
+          end - begin, blockMean, centered * arma::trans(centered));
+    }
+  }
+
+  // The totals of the threads are merged in order, so the result is the same
+  // in each run with the same number of threads.
+  if (points == 0)
+  {
+    mean.zeros(chunk.n_rows);
+    scatter.zeros(chunk.n_rows, chunk.n_rows);
+  }
+
+  for (size_t t = 0; t < numThreads; ++t)
+    Merge(points, mean, scatter, threadPoints[t], threadMeans[t],
+        threadScatters[t]);
+}
+
+void StreamingPCA::Fit()
+{
+  if (points < 2)
+    Log::Fatal << "StreamingPCA::Fit(): at least two points are needed, but "
+        << points << " were added!" << endl;
+
+  Timer::Start("streaming_pca_fit");
+
+  arma::mat covariance = scatter / (points - 1);
+
+  if (scaleData)
+  {
+    // Scaling the data divides each dimension by its standard deviation, so
+    // the covariance of the scaled data is the correlation matrix.
+    stdDev = arma::sqrt(covariance.diag());
+
+    // If there are any zeroes, make them very small.
+    for (size_t i = 0; i < stdDev.n_elem; ++i)
+      if (stdDev[i] == 0)
+        stdDev[i] = 1e-50;
+
+    covariance /= stdDev * arma::trans(stdDev);
+  }
+
+  arma::eig_sym(eigVal, eigVec, covariance);
+
+  // The eigenvalues are in increasing order; we need largest to smallest.
+  eigVal = arma::flipud(eigVal);
+  eigVec = arma::fliplr(eigVec);
+
+  Timer::Stop("streaming_pca_fit");
+}
+
+void StreamingPCA::Transform(const arma::mat& data,
+                             arma::mat& transformedData,
+                             const size_t newDimension) const
+{
+  if (eigVec.n_elem == 0)
+    Log::Fatal << "StreamingPCA::Transform(): Fit() must be called first!"
+        << endl;
+
+  if (data.n_rows != mean.n_elem)
+    Log::Fatal << "StreamingPCA::Transform(): the points have dimensionality "
+        << data.n_rows << ", but the model has dimensionality " << mean.n_elem
+        << "!" << endl;
+
+  if (newDimension > eigVec.n_cols)
+    Log::Fatal << "StreamingPCA::Transform(): newDimension (" << newDimension
+        << ") cannot be greater than the dimensionality of the data ("
+        << eigVec.n_cols << ")!" << endl;
+
+  const size_t dimension = (newDimension == 0) ? eigVec.n_cols : newDimension;
+
+  arma::mat centered = data;
+  centered.each_col() -= mean;
+  if (scaleData)
+    centered.each_col() /= stdDev;
+
+  transformedData = arma::trans(eigVec.cols(0, dimension - 1)) * centered;
+}
+
+double StreamingPCA::VarianceRetained(const size_t newDimension) const
+{
+  if (newDimension == 0 || newDimension > eigVal.n_elem)
+    Log::Fatal << "StreamingPCA::VarianceRetained(): newDimension ("
+        << newDimension << ") must be between 1 and the dimensionality of the "
+        << "data (" << eigVal.n_elem << ")!" << endl;
+
+  return arma::sum(eigVal.subvec(0, newDimension - 1)) / arma::sum(eigVal);
+}
+
+size_t StreamingPCA::Dimension(const double varRetained) const
+{
+  // This is the same rule as PCA::Apply(data, varRetained).
+  size_t dimension = 0;
+  double varSum = 0.0;
+  const double total = arma::sum(eigVal);
+  while ((varSum < varRetained) && (dimension < eigVal.n_elem))
+  {
+    varSum += eigVal[dimension] / total;
+    ++dimension;
+  }
+
+  return std::max((size_t) 1, dimension);
+}
+
+void StreamingPCA::Merge(size_t& points,
+                         arma::vec& mean,
+                         arma::mat& scatter,
+                         const size_t otherPoints,
+                         const arma::vec& otherMean,
+                         const arma::mat& otherScatter)
+{
+  if (otherPoints == 0)
+    return;
+
+  const size_t total = points + otherPoints;
+  const arma::vec delta = otherMean - mean;
+
+  scatter += otherScatter + (((double) points * otherPoints) / total) *
+      (delta * arma::trans(delta));
+  mean += (((double) otherPoints) / total) * delta;
+  points = total;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file streaming_pca.hpp
+ *
+ * Principal components analysis of datasets given a chunk of points at a time.
+ */
+#ifndef __MLPACK_METHODS_PCA_STREAMING_PCA_HPP
+#define __MLPACK_METHODS_PCA_STREAMING_PCA_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace pca {
+
+/**
+ * The StreamingPCA class performs principal components analysis on data that
+ * is given a chunk of points at a time, so the dataset never has to be held in
+ * memory.  Add() merges the mean and the scatter matrix (the sum of the outer
+ * products of the centered points) of each chunk into the totals; the moments
+ * of each chunk are computed in parallel, over blocks of points, and merged
+ * with the pairwise update of Chan, Golub and LeVeque, which (unlike summing
+ * the raw outer products) is numerically stable.  Only the d x d scatter matrix
+ * is stored.
+ *
+ * Once all the points have been added, Fit() eigendecomposes the covariance
+ * matrix (or, if the data is scaled, the correlation matrix), and the points
+ * can then be transformed, a chunk at a time, with Transform().  The results
+ * are the same as those of PCA on the whole dataset (up to the signs of the
+ * components).
+ *
+ * @code
+ * StreamingPCA p;
+ * data::ChunkReader reader("dataset.csv", true);
+ * arma::mat chunk, transformed;
+ * while (reader.Read(chunk, 100000))
+ *   p.Add(chunk);
+ * p.Fit();
+ *
+ * reader.Reset();
+ * while (reader.Read(chunk, 100000))
+ *   p.Transform(chunk, transformed, 10);
+ * @endcode
+ */
+class StreamingPCA
+{
+ public:
+  /**
+   * Create the StreamingPCA object, specifying if the data should be scaled in
+   * each dimension by standard deviation when PCA is performed.
+   *
+   * @param scaleData Whether or not to scale the data.
+   */
+  StreamingPCA(const bool scaleData = false);
+
+  /**
+   * Add the given points to the mean and the scatter matrix.  The
+   * dimensionality of the points must be the same for each call.
+   *
+   * @param chunk Points to add (one column for each point).
+   */
+  void Add(const arma::mat& chunk);
+
+  /**
+   * Compute the principal components of the points added so far.  At least two
+   * points must have been added.
+   */
+  void Fit();
+
+  /**
+   * Project the given points onto the newDimension leading principal
+   * components.  Fit() must be called first.
+   *
+   * @param data Points to transform.
+   * @param transformedData Matrix to store the transformed points in.
+   * @param newDimension Number of components to keep (0 keeps all of them).
+   */
+  void Transform(const arma::mat& data,
+                 arma::mat& transformedData,
+                 const size_t newDimension = 0) const;
+
+  /**
+   * Return the amount of the variance (between 0 and 1) which is retained by
+   * the newDimension leading principal components.
+   *
+   * @param newDimension Number of components kept.
+   */
+  double VarianceRetained(const size_t newDimension) const;
+
+  /**
+   * Return the smallest number of leading principal components which retain
+   * at least the given amount of variance (between 0 and 1).
+   *
+   * @param varRetained Lower bound on the amount of variance to retain.
+   */
+  size_t Dimension(const double varRetained) const;
+
+  //! Get whether or not the data is scaled by standard deviation.
+  bool ScaleData() const { return scaleData; }
+  //! Get the number of points added so far.
+  size_t Points() const { return points; }
+  //! Get the mean of the points added so far.
+  const arma::vec& Mean() const { return mean; }
+  //! Get the scatter matrix of the points added so far.
+  const arma::mat& Scatter() const { return scatter; }
+  //! Get the eigenvalues computed by Fit(), largest first.
+  const arma::vec& EigenValues() const { return eigVal; }
+  //! Get the eigenvectors (loadings) computed by Fit().
+  const arma::mat& EigenVectors() const { return eigVec; }
+
+ private:
+  //! Whether or not the data is scaled by standard deviation.
+  bool scaleData;
+  //! The number of points added so far.
+  size_t points;
+  //! The mean of the points added so far.
+  arma::vec mean;
+  //! The scatter matrix of the points added so far.
+  arma::mat scatter;
+  //! The standard deviation of each dimension, if the data is scaled.
+  arma::vec stdDev;
+  //! The eigenvalues of the covariance matrix, largest first.
+  arma::vec eigVal;
+  //! The eigenvectors of the covariance matrix.
+  arma::mat eigVec;
+
+  //! Merge the moments of a set of points into the given totals.
+  static void Merge(size_t& points,
+                    arma::vec& mean,
+                    arma::mat& scatter,
+                    const size_t otherPoints,
+                    const arma::vec& otherMean,
+                    const arma::mat& otherScatter);
+};
+
+}; // namespace pca
+}; // namespace mlpack
+
+#endif
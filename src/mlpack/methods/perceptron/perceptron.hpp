@@ -21,6 +21,14 @@ namespace perceptron {
  * network).  It converges if the supplied training dataset is linearly
  * separable.
  *
+ * The perceptron can also be trained in parallel, with the iterative parameter
+ * mixing of McDonald, Hall and Mann ('Distributed Training Strategies for the
+ * Structured Perceptron', 2010): the points are dealt into shards (point j
+ * goes to shard j mod shards), each iteration makes one pass over each shard
+ * in parallel, starting from the current weights, and the new weights are the
+ * average of the weights of the shards.  This also converges on linearly
+ * separable datasets, and the result does not depend on the number of threads.
+ *
  * @tparam LearnPolicy Options of SimpleWeightUpdate and GradientDescent.
  * @tparam WeightInitializationPolicy Option of ZeroInitialization and
  *      RandomInitialization.
@@ -40,12 +48,19 @@ class Perceptron
    * @param labels Labels of dataset.
    * @param iterations Maximum number of iterations for the perceptron learning
    *     algorithm.
+   * @param shards Number of shards to train on in parallel; 1 gives the usual
+   *     sequential algorithm, and 0 uses one shard for each OpenMP thread.
    */
-  Perceptron(const MatType& data, const arma::Row<size_t>& labels, int iterations);
+  Perceptron(const MatType& data,
+             const arma::Row<size_t>& labels,
+             int iterations,
+             const size_t shards = 1);
 
   /**
    * Classification function. After training, use the weightVectors matrix to
-   * classify test, and put the predicted classes in predictedLabels.
+   * classify test, and put the predicted classes in predictedLabels.  The
+   * points are classified in parallel, in blocks, with one matrix product for
+   * each block.
    *
    * @param test Testing data or data to classify.
    * @param predictedLabels Vector to store the predicted classes after
@@ -65,10 +80,18 @@ class Perceptron
    */
   Perceptron(const Perceptron<>& other, MatType& data, const arma::rowvec& D, const arma::Row<size_t>& labels);
 
+  //! Get the number of shards trained on in parallel.
+  size_t Shards() const { return shards; }
+  //! Get the weight vectors (the first column holds the bias weights).
+  const arma::mat& Weights() const { return weightVectors; }
+
 private:
   //! To store the number of iterations
   size_t iter;
 
+  //! The number of shards trained on in parallel (0 for one per thread).
+  size_t shards;
+
   //! Stores the class labels for the input data.
   arma::Row<size_t> classLabels;
 
@@ -84,6 +107,15 @@ private:
    *  @param D Cost matrix. Stores the cost of mispredicting instances
    */
   void Train(const arma::rowvec& D);
+
+  /**
+   *  Training function with iterative parameter mixing. It trains on trainData
+   *  over numShards shards in parallel, using the cost matrix D.
+   *
+   *  @param D Cost matrix. Stores the cost of mispredicting instances
+   *  @param numShards Number of shards to train on in parallel.
+   */
+  void TrainShards(const arma::rowvec& D, const size_t numShards);
 };
 
 } // namespace perceptron
@@ -9,6 +9,10 @@
 
 #include "perceptron.hpp"
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace perceptron {
 
@@ -22,6 +26,8 @@ namespace perceptron {
  * @param labels Labels of dataset.
  * @param iterations Maximum number of iterations for the perceptron learning
  *      algorithm.
+ * @param shards Number of shards to train on in parallel (0 for one per
+ *      thread).
  */
 template<
     typename LearnPolicy,
@@ -31,7 +37,9 @@ template<
 Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Perceptron(
     const MatType& data,
     const arma::Row<size_t>& labels,
-    int iterations)
+    int iterations,
+    const size_t shards) :
+    shards(shards)
 {
   WeightInitializationPolicy WIP;
   WIP.Initialize(weightVectors, arma::max(labels) + 1, data.n_rows + 1);
@@ -66,18 +74,30 @@ void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Classify(
     const MatType& test,
     arma::Row<size_t>& predictedLabels)
 {
-  arma::mat tempLabelMat;
-  arma::uword maxIndexRow, maxIndexCol;
+  predictedLabels.set_size(test.n_cols);
+
+  // The scores of a block of points are one matrix product; the blocks are
+  // classified in parallel.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (test.n_cols + blockSize - 1) / blockSize;
 
-  for (size_t i = 0; i < test.n_cols; i++)
+  #pragma omp parallel for schedule(static)
+  for (size_t b = 0; b < numBlocks; ++b)
   {
-    tempLabelMat = weightVectors.submat(0, 1, weightVectors.n_rows - 1,
-                                        weightVectors.n_cols - 1) * 
-                                        test.col(i) + weightVectors.col(0);
-    tempLabelMat.max(maxIndexRow, maxIndexCol);
-    predictedLabels(0, i) = maxIndexRow;
+    const size_t begin = b * blockSize;
+    const size_t end = std::min((size_t) test.n_cols, begin + blockSize);
+
+    arma::mat scores = weightVectors.cols(1, weightVectors.n_cols - 1) *
+        test.cols(begin, end - 1);
+    scores.each_col() += weightVectors.col(0);
+
+    for (size_t i = begin; i < end; i++)
+    {
+      arma::uword maxIndex = 0;
+      scores.col(i - begin).max(maxIndex);
+      predictedLabels(0, i) = maxIndex;
+    }
   }
-  // predictedLabels.print("These are the labels predicted by the perceptron");
 }
 
 /**
@@ -98,6 +118,7 @@ Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Perceptron(
   classLabels = labels;
   trainData = data;
   iter = other.iter;
+  shards = other.shards;
 
   // Insert a row of ones at the top of the training data set.
   MatType zOnes(1, data.n_cols);
@@ -129,6 +150,24 @@ void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
   arma::uword maxIndexRow, maxIndexCol;
   arma::mat tempLabelMat;
 
+  // Find the number of shards to train on.
+  size_t numShards = shards;
+  if (numShards == 0)
+  {
+    numShards = 1;
+#ifdef HAS_OPENMP
+    numShards = (size_t) omp_get_max_threads();
+#endif
+  }
+  numShards = std::max((size_t) 1, std::min(numShards,
+      (size_t) trainData.n_cols));
+
+  if (numShards > 1)
+  {
+    TrainShards(D, numShards);
+    return;
+  }
+
   LearnPolicy LP;
 
   while ((i < iter) && (!converged))
@@ -162,6 +201,66 @@ void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
   }
 }
 
+/**
+ * Train on trainData with iterative parameter mixing over the given number of
+ * shards, using the cost matrix D.
+ *
+ * @param D Cost matrix. Stores the cost of mispredicting instances
+ * @param numShards Number of shards to train on in parallel.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::TrainShards(
+    const arma::rowvec& D,
+    const size_t numShards)
+{
+  std::vector<arma::mat> shardWeights(numShards);
+  std::vector<size_t> shardMistakes(numShards);
+
+  bool converged = false;
+  for (size_t i = 0; (i < iter) && (!converged); i++)
+  {
+    // Each shard makes one pass over its points, starting from the current
+    // weights.
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t s = 0; s < numShards; s++)
+    {
+      LearnPolicy LP;
+      arma::mat tempLabelMat;
+      arma::uword maxIndexRow, maxIndexCol;
+
+      shardWeights[s] = weightVectors;
+      shardMistakes[s] = 0;
+      for (size_t j = s; j < trainData.n_cols; j += numShards)
+      {
+        tempLabelMat = shardWeights[s] * trainData.col(j);
+        tempLabelMat.max(maxIndexRow, maxIndexCol);
+
+        if (maxIndexRow != classLabels(0, j))
+        {
+          ++shardMistakes[s];
+          LP.UpdateWeights(trainData, shardWeights[s], j, classLabels(0, j),
+              maxIndexRow, D);
+        }
+      }
+    }
+
+    // Mix the weights of the shards uniformly, in shard order.  If no shard
+    // made a mistake, the weights have not changed and we have converged.
+    converged = (shardMistakes[0] == 0);
+    weightVectors = shardWeights[0];
+    for (size_t s = 1; s < numShards; s++)
+    {
+      converged = converged && (shardMistakes[s] == 0);
+      weightVectors += shardWeights[s];
+    }
+    weightVectors /= numShards;
+  }
+}
+
 }; // namespace perceptron
 }; // namespace mlpack
 
@@ -50,6 +50,8 @@ PARAM_STRING("output", "The file in which the predicted labels for the test set"
     " will be written.", "o", "output.csv");
 PARAM_INT("iterations","The maximum number of iterations the perceptron is "
   "to be run", "i", 1000);
+PARAM_INT("shards", "The number of shards to train on in parallel, with "
+    "iterative parameter mixing (0 uses one shard for each thread).", "s", 1);
 
 int main(int argc, char** argv)
 {
@@ -102,10 +104,14 @@ int main(int argc, char** argv)
   }
 
   int iterations = CLI::GetParam<int>("iterations");
+  const int shards = CLI::GetParam<int>("shards");
+  if (shards < 0)
+    Log::Fatal << "Number of shards (" << shards << ") must be non-negative!"
+        << std::endl;
   
   // Create and train the classifier.
   Timer::Start("Training");
-  Perceptron<> p(trainingData, labels.t(), iterations);
+  Perceptron<> p(trainingData, labels.t(), iterations, (size_t) shards);
   Timer::Stop("Training");
 
   // Time the running of the Perceptron Classifier.
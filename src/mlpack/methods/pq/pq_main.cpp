@@ -0,0 +1,197 @@
+/**
+ * @file pq_main.cpp
+ *
+ * This file computes the approximate nearest-neighbors using a
+ * product-quantized index.
+ */
+#include <time.h>
+#include <mlpack/core.hpp>
+#include <string>
+
+#include "pq_search.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+// Information about the program itself.
+PROGRAM_INFO("All K-Approximate-Nearest-Neighbor Search with Product "
+    "Quantization",
+    "This program will calculate the k approximate-nearest-neighbors of a set "
+    "of points using a product-quantized index.  You may specify a separate set"
+    " of reference points and query points, or just a reference set which will "
+    "be used as both the reference and query set."
+    "\n\n"
+    "Each reference point is split into --subvectors subvectors, and each "
+    "subvector is stored as the index of the closest of --centroids centroids "
+    "(at most 256) found with k-means, so each point takes one byte per "
+    "subvector.  If --lists is given, the points are first divided into that "
+    "many lists with k-means, and each query only scans the --probes lists "
+    "closest to it.  The codebooks are trained on --training_size random "
+    "reference points (or all of them, if it is 0)."
+    "\n\n"
+    "For example, the following will return 5 neighbors from the data for each "
+    "point in 'input.csv', with 8 subvectors and 100 lists of which 4 are "
+    "scanned, and store the distances in 'distances.csv' and the neighbors in "
+    "the file 'neighbors.csv':"
+    "\n\n"
+    "$ pq -k 5 -r input.csv -S 8 -L 100 -P 4 -d distances.csv -n neighbors.csv"
+    "\n\n"
+    "The output files are organized such that row i and column j in the "
+    "neighbors output file corresponds to the index of the point in the "
+    "reference set which is the i'th nearest neighbor from the point in the "
+    "query set with index j.  Row i and column j in the distances output file "
+    "corresponds to the (approximate) distance between those two points."
+    "\n\n"
+    "Because the codebooks are trained with k-means from random starting "
+    "points, results may be different from run to run.  Thus, the --seed "
+    "option can be specified to set the random seed.");
+
+// Define our input parameters that this program will take.
+PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
+    "r");
+PARAM_STRING("distances_file", "File to output distances into.", "d", "");
+PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
+PARAM_INT_REQ("k", "Number of nearest neighbors to find.", "k");
+PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
+
+PARAM_INT("subvectors", "The number of subvectors each point is split into.",
+    "S", 8);
+PARAM_INT("centroids", "The number of centroids of the codebook of each "
+    "subvector (at most 256).", "C", 256);
+PARAM_INT("lists", "The number of lists of the inverted file; if 0, every "
+    "point is scanned by each query.", "L", 0);
+PARAM_INT("probes", "The number of lists scanned by each query.", "P", 1);
+PARAM_INT("training_size", "The number of random reference points the "
+    "codebooks are trained on; if 0, all of them are used.", "t", 0);
+PARAM_INT("max_iterations", "The maximum number of iterations of each k-means "
+    "run.", "m", 100);
+PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+
+int main(int argc, char *argv[])
+{
+  // Give CLI the command line parameters the user passed in.
+  CLI::ParseCommandLine(argc, argv);
+
+  if (CLI::GetParam<int>("seed") != 0)
+    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
+  else
+    math::RandomSeed((size_t) time(NULL));
+
+  // Get all the parameters.
+  const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string distancesFile = CLI::GetParam<string>("distances_file");
+  const string neighborsFile = CLI::GetParam<string>("neighbors_file");
+  const size_t k = CLI::GetParam<int>("k");
+
+  // Sanity checks on the integer parameters.
+  const char* counts[] = { "subvectors", "centroids", "lists", "probes",
+      "training_size", "max_iterations" };
+  for (size_t i = 0; i < 6; ++i)
+  {
+    if (CLI::GetParam<int>(counts[i]) < 0)
+    {
+      Log::Fatal << "Invalid --" << counts[i] << ": "
+          << CLI::GetParam<int>(counts[i]) << ".  Must be 0 or greater."
+          << endl;
+    }
+  }
+
+  const size_t numSubvectors = (size_t) CLI::GetParam<int>("subvectors");
+  const size_t numCentroids = (size_t) CLI::GetParam<int>("centroids");
+  const size_t numLists = (size_t) CLI::GetParam<int>("lists");
+  const size_t numProbes = (size_t) CLI::GetParam<int>("probes");
+  const size_t trainingSize = (size_t) CLI::GetParam<int>("training_size");
+  const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
+
+  arma::mat referenceData;
+  data::Load(referenceFile, referenceData, true);
+  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
+
+  arma::mat queryData;
+  const bool monochromatic = (CLI::GetParam<string>("query_file") == "");
+  if (!monochromatic)
+  {
+    const string queryFile = CLI::GetParam<string>("query_file");
+    data::Load(queryFile, queryData, true);
+    Log::Info << "Loaded query data from '" << queryFile << "' ("
+        << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
+  }
+
+  // Sanity check on k value: must be greater than 0, must be less than the
+  // number of reference points.
+  const size_t maxK = monochromatic ? referenceData.n_cols - 1 :
+      referenceData.n_cols;
+  if (k == 0 || k > maxK)
+  {
+    Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less "
+        << "than or equal to " << maxK << "." << endl;
+  }
+
+  PQSearch pq(numSubvectors, numCentroids, numLists, numProbes, maxIterations);
+  pq.NumThreads() = CLI::HasParam("threads") ? util::NumThreads() : 1;
+
+  Log::Info << "Training codebooks with " << numSubvectors << " subvectors "
+      << "and " << numCentroids << " centroids each." << endl;
+  if (trainingSize > 0 && trainingSize < referenceData.n_cols)
+  {
+    // Draw the training points without replacement.
+    const arma::uvec order = arma::shuffle(arma::linspace<arma::uvec>(0,
+        referenceData.n_cols - 1, referenceData.n_cols));
+    arma::mat trainingData(referenceData.n_rows, trainingSize);
+    for (size_t i = 0; i < trainingSize; ++i)
+      trainingData.col(i) = referenceData.col(order[i]);
+
+    pq.Train(trainingData);
+  }
+  else
+  {
+    pq.Train(referenceData);
+  }
+
+  Timer::Start("encoding");
+  pq.Add(referenceData);
+  Timer::Stop("encoding");
+
+  Log::Info << "Computing " << k << " distance approximate nearest neighbors."
+      << endl;
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  if (monochromatic)
+  {
+    // Each point is in the index, so it is almost always among its own
+    // neighbors; search for one more and drop it.
+    arma::Mat<size_t> allNeighbors;
+    arma::mat allDistances;
+    pq.Search(referenceData, k + 1, allNeighbors, allDistances);
+
+    neighbors.set_size(k, referenceData.n_cols);
+    distances.set_size(k, referenceData.n_cols);
+    for (size_t i = 0; i < referenceData.n_cols; ++i)
+    {
+      size_t row = 0;
+      for (size_t j = 0; j <= k && row < k; ++j)
+      {
+        if (allNeighbors(j, i) == i)
+          continue;
+        neighbors(row, i) = allNeighbors(j, i);
+        distances(row, i) = allDistances(j, i);
+        ++row;
+      }
+    }
+  }
+  else
+  {
+    pq.Search(queryData, k, neighbors, distances);
+  }
+  Log::Info << "Neighbors computed." << endl;
+
+  // Save output.
+  if (distancesFile != "")
+    data::Save(distancesFile, distances);
+
+  if (neighborsFile != "")
+    data::Save(neighborsFile, neighbors);
+}
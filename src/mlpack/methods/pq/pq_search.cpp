@@ -0,0 +1,255 @@
+/**
+ * @file pq_search.cpp
+ *
+ * Implementation of the PQSearch class.
+ */
+#include "pq_search.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/methods/kmeans/kmeans.hpp>
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+PQSearch::PQSearch(const arma::mat& referenceSet,
+                   const arma::mat& querySet,
+                   const size_t numSubvectors,
+                   const size_t numCentroids,
+                   const size_t numLists,
+                   const size_t numProbes,
+                   const size_t maxIterations) :
+    querySet(&querySet),
+    monochromatic(false),
+    dimensionality(0),
+    numSubvectors(numSubvectors),
+    numCentroids(numCentroids),
+    numLists(numLists),
+    numProbes(numProbes),
+    maxIterations(maxIterations),
+    numPoints(0),
+    numThreads(1)
+{
+  CheckParameters();
+
+  Train(referenceSet);
+  Add(referenceSet);
+}
+
+PQSearch::PQSearch(const arma::mat& referenceSet,
+                   const size_t numSubvectors,
+                   const size_t numCentroids,
+                   const size_t numLists,
+                   const size_t numProbes,
+                   const size_t maxIterations) :
+    querySet(&referenceSet),
+    monochromatic(true),
+    dimensionality(0),
+    numSubvectors(numSubvectors),
+    numCentroids(numCentroids),
+    numLists(numLists),
+    numProbes(numProbes),
+    maxIterations(maxIterations),
+    numPoints(0),
+    numThreads(1)
+{
+  CheckParameters();
+
+  Train(referenceSet);
+  Add(referenceSet);
+}
+
+PQSearch::PQSearch(const size_t numSubvectors,
+                   const size_t numCentroids,
+                   const size_t numLists,
+                   const size_t numProbes,
+                   const size_t maxIterations) :
+    querySet(NULL),
+    monochromatic(false),
+    dimensionality(0),
+    numSubvectors(numSubvectors),
+    numCentroids(numCentroids),
+    numLists(numLists),
+    numProbes(numProbes),
+    maxIterations(maxIterations),
+    numPoints(0),
+    numThreads(1)
+{
+  CheckParameters();
+}
+
+void PQSearch::CheckParameters() const
+{
+  if (numSubvectors == 0)
+  {
+    Log::Fatal << "PQSearch::PQSearch(): the number of subvectors must be "
+        << "greater than 0!" << std::endl;
+  }
+
+  // Each code of a subvector is one byte.
+  if (numCentroids == 0 || numCentroids > 256)
+  {
+    Log::Fatal << "PQSearch::PQSearch(): invalid number of centroids ("
+        << numCentroids << "); must be between 1 and 256." << std::endl;
+  }
+
+  if (numLists > 0 && numProbes == 0)
+  {
+    Log::Fatal << "PQSearch::PQSearch(): the number of probes must be greater "
+        << "than 0!" << std::endl;
+  }
+}
+
+void PQSearch::Train(const arma::mat& trainingSet)
+{
+  if (numSubvectors > trainingSet.n_rows)
+  {
+    Log::Fatal << "PQSearch::Train(): cannot split " << trainingSet.n_rows
+        << "-dimensional points into " << numSubvectors << " subvectors!"
+        << std::endl;
+  }
+
+  if (trainingSet.n_cols < std::max(numCentroids, numLists))
+  {
+    Log::Fatal << "PQSearch::Train(): the training set must hold at least "
+        << std::max(numCentroids, numLists) << " points, but it only holds "
+        << trainingSet.n_cols << "!" << std::endl;
+  }
+
+  dimensionality = trainingSet.n_rows;
+
+  // Split the dimensions as evenly as possible.
+  subvectorStart.set_size(numSubvectors + 1);
+  for (size_t m = 0; m <= numSubvectors; ++m)
+    subvectorStart[m] = (m * dimensionality) / numSubvectors;
+
+  Timer::Start("pq_training");
+
+  kmeans::KMeans<> kmeans(maxIterations);
+
+  // The codebooks are trained on the residuals of the points from their
+  // coarse centroids, since that is what is encoded.
+  arma::mat residuals;
+  if (numLists > 0)
+  {
+    Log::Info << "Training coarse quantizer with " << numLists << " lists."
+        << std::endl;
+    arma::Col<size_t> assignments;
+    kmeans.Cluster(trainingSet, numLists, assignments, coarseCentroids);
+
+    residuals = trainingSet;
+    for (size_t i = 0; i < residuals.n_cols; ++i)
+      residuals.col(i) -= coarseCentroids.unsafe_col(assignments[i]);
+  }
+  else
+  {
+    coarseCentroids.reset();
+    residuals = trainingSet;
+  }
+
+  codebooks.resize(numSubvectors);
+  codebookNorms.set_size(numCentroids, numSubvectors);
+  for (size_t m = 0; m < numSubvectors; ++m)
+  {
+    Log::Info << "Training codebook " << (m + 1) << " of " << numSubvectors
+        << "." << std::endl;
+
+    const arma::mat subvectors = residuals.rows(subvectorStart[m],
+        subvectorStart[m + 1] - 1);
+    kmeans.Cluster(subvectors, numCentroids, codebooks[m]);
+
+    codebookNorms.col(m) = arma::trans(arma::sum(arma::square(codebooks[m]),
+        0));
+  }
+
+  Timer::Stop("pq_training");
+
+  // Any points encoded with the old codebooks are no longer valid.
+  const size_t lists = std::max(numLists, (size_t) 1);
+  listIndices.assign(lists, std::vector<arma::u32>());
+  listCodes.assign(lists, std::vector<unsigned char>());
+  numPoints = 0;
+}
+
+void PQSearch::Search(const size_t k,
+                      arma::Mat<size_t>& resultingNeighbors,
+                      arma::mat& distances)
+{
+  if (querySet == NULL)
+  {
+    Log::Fatal << "PQSearch::Search(): no query set was given to the "
+        << "constructor; use Search(querySet, k, ...) instead." << std::endl;
+  }
+
+  ComputeNeighbors(*querySet, k, monochromatic, resultingNeighbors,
+      distances);
+}
+
+void PQSearch::ProbedLists(const arma::vec& query,
+                           const size_t probes,
+                           std::vector<size_t>& lists) const
+{
+  lists.clear();
+  if (numLists == 0)
+  {
+    lists.push_back(0);
+    return;
+  }
+
+  arma::vec coarseDistances(numLists);
+  for (size_t l = 0; l < numLists; ++l)
+    coarseDistances[l] = metric::SquaredEuclideanDistance::Evaluate(query,
+        coarseCentroids.unsafe_col(l));
+
+  if (probes == 1)
+  {
+    arma::uword closest;
+    coarseDistances.min(closest);
+    lists.push_back((size_t) closest);
+    return;
+  }
+
+  const arma::uvec order = arma::sort_index(coarseDistances);
+  for (size_t p = 0; p < probes; ++p)
+    lists.push_back(order[p]);
+}
+
+void PQSearch::Encode(const arma::vec& point, unsigned char* code) const
+{
+  for (size_t m = 0; m < numSubvectors; ++m)
+  {
+    // The closest centroid minimizes ||c||^2 - 2 c^T x.
+    const arma::vec scores = codebookNorms.col(m) - 2.0 *
+        arma::trans(codebooks[m]) * point.subvec(subvectorStart[m],
+        subvectorStart[m + 1] - 1);
+    arma::uword closest;
+    scores.min(closest);
+    code[m] = (unsigned char) closest;
+  }
+}
+
+void PQSearch::DistanceTable(const arma::vec& query, arma::mat& table) const
+{
+  for (size_t m = 0; m < numSubvectors; ++m)
+  {
+    const arma::vec subvector = query.subvec(subvectorStart[m],
+        subvectorStart[m + 1] - 1);
+    table.col(m) = codebookNorms.col(m) - 2.0 * arma::trans(codebooks[m]) *
+        subvector + arma::dot(subvector, subvector);
+  }
+}
+
+std::string PQSearch::ToString() const
+{
+  std::ostringstream convert;
+  convert << "PQSearch [" << this << "]" << std::endl;
+  convert << "  Dimensionality: " << dimensionality << std::endl;
+  convert << "  Subvectors: " << numSubvectors << std::endl;
+  convert << "  Centroids per codebook: " << numCentroids << std::endl;
+  if (numLists > 0)
+  {
+    convert << "  Lists: " << numLists << std::endl;
+    convert << "  Probes: " << numProbes << std::endl;
+  }
+  convert << "  Points: " << numPoints << std::endl;
+  return convert.str();
+}
@@ -0,0 +1,337 @@
+/**
+ * @file pq_search.hpp
+ *
+ * Defines the PQSearch class, which computes approximate nearest neighbors
+ * with a (possibly inverted-file) product-quantized index.
+ *
+ * @code
+ * @article{jegou2011product,
+ *   title={Product quantization for nearest neighbor search},
+ *   author={J{\'e}gou, H. and Douze, M. and Schmid, C.},
+ *   journal={IEEE Transactions on Pattern Analysis and Machine Intelligence},
+ *   volume={33},
+ *   number={1},
+ *   pages={117--128},
+ *   year={2011}
+ * }
+ * @endcode
+ */
+#ifndef __MLPACK_METHODS_PQ_PQ_SEARCH_HPP
+#define __MLPACK_METHODS_PQ_PQ_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <vector>
+#include <string>
+
+#include <mlpack/methods/neighbor_search/candidate_heap.hpp>
+#include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The PQSearch class builds a product-quantized index of a set of points and
+ * uses it to compute the approximate nearest neighbors of query points.  Only
+ * the codes of the points are kept, not the points themselves: each point is
+ * split into numSubvectors subvectors, and each subvector is replaced by the
+ * index of the closest of numCentroids centroids (at most 256, so one byte)
+ * of a codebook trained with k-means for that subvector.  A 128-dimensional
+ * point with 16 subvectors then takes 16 bytes (plus a 4 byte index) instead
+ * of 1024.
+ *
+ * If numLists is not 0, the index is an inverted file (IVF-PQ): a coarse
+ * quantizer with numLists centroids is trained with k-means first, each point
+ * is stored in the list of its closest coarse centroid, and the residual of
+ * the point from that centroid is what is product-quantized.  A query then
+ * only scans the numProbes lists whose coarse centroids are closest to it.
+ *
+ * Distances are computed asymmetrically: the query is not quantized.  For each
+ * query (and each list scanned), a table of the squared distances from each
+ * subvector of the query to each centroid of its codebook is computed, and
+ * the approximate squared distance to a point is the sum of one entry of the
+ * table per subvector.
+ *
+ * The index can be built all at once from a reference set (like LSHSearch and
+ * NeighborSearch), or, when the reference set does not fit in memory, trained
+ * on a sample with Train() and then filled a batch at a time with Add(); the
+ * batches may be single-precision (arma::fmat).
+ *
+ * @code
+ * extern arma::mat sample; // A sample of the reference set.
+ * extern arma::mat queries;
+ *
+ * // 16 subvectors of 256 centroids each, in 1024 lists; scan 8 lists.
+ * PQSearch pq(16, 256, 1024, 8);
+ * pq.Train(sample);
+ * for (size_t b = 0; b < numBatches; ++b)
+ * {
+ *   arma::fmat batch;
+ *   data::Load(batchFiles[b], batch);
+ *   pq.Add(batch); // Points are numbered in the order they are added.
+ * }
+ *
+ * arma::Mat<size_t> neighbors;
+ * arma::mat distances;
+ * pq.Search(queries, 10, neighbors, distances);
+ * @endcode
+ */
+class PQSearch
+{
+ public:
+  /**
+   * Train the index on the given reference set and add every reference point
+   * to it.  Search() will then search for the neighbors of each query point.
+   *
+   * @param referenceSet Set of reference points.
+   * @param querySet Set of query points.
+   * @param numSubvectors Number of subvectors each point is split into (the
+   *     number of bytes in each code).
+   * @param numCentroids Number of centroids in the codebook of each subvector
+   *     (at most 256).
+   * @param numLists Number of lists of the inverted file; if 0, the index is
+   *     a single list of product-quantized points.
+   * @param numProbes Number of lists scanned by each query.
+   * @param maxIterations Maximum number of iterations of each k-means run.
+   */
+  PQSearch(const arma::mat& referenceSet,
+           const arma::mat& querySet,
+           const size_t numSubvectors,
+           const size_t numCentroids = 256,
+           const size_t numLists = 0,
+           const size_t numProbes = 1,
+           const size_t maxIterations = 100);
+
+  /**
+   * Train the index on the given reference set and add every reference point
+   * to it.  Search() will then search for the neighbors of each reference
+   * point (excluding the point itself).
+   *
+   * @param referenceSet Set of reference points and the set of queries.
+   * @param numSubvectors Number of subvectors each point is split into (the
+   *     number of bytes in each code).
+   * @param numCentroids Number of centroids in the codebook of each subvector
+   *     (at most 256).
+   * @param numLists Number of lists of the inverted file; if 0, the index is
+   *     a single list of product-quantized points.
+   * @param numProbes Number of lists scanned by each query.
+   * @param maxIterations Maximum number of iterations of each k-means run.
+   */
+  PQSearch(const arma::mat& referenceSet,
+           const size_t numSubvectors,
+           const size_t numCentroids = 256,
+           const size_t numLists = 0,
+           const size_t numProbes = 1,
+           const size_t maxIterations = 100);
+
+  /**
+   * Create an empty index, which must be trained with Train() before any
+   * points are added to it with Add().
+   *
+   * @param numSubvectors Number of subvectors each point is split into (the
+   *     number of bytes in each code).
+   * @param numCentroids Number of centroids in the codebook of each subvector
+   *     (at most 256).
+   * @param numLists Number of lists of the inverted file; if 0, the index is
+   *     a single list of product-quantized points.
+   * @param numProbes Number of lists scanned by each query.
+   * @param maxIterations Maximum number of iterations of each k-means run.
+   */
+  PQSearch(const size_t numSubvectors,
+           const size_t numCentroids = 256,
+           const size_t numLists = 0,
+           const size_t numProbes = 1,
+           const size_t maxIterations = 100);
+
+  /**
+   * Train the coarse quantizer (if there is one) and the codebooks on the
+   * given points, emptying the index.  The training set only has to be a
+   * representative sample of the points that will be added, but must hold at
+   * least numCentroids and numLists points.
+   *
+   * @param trainingSet Set of points to train on.
+   */
+  void Train(const arma::mat& trainingSet);
+
+  /**
+   * Encode the given points and add them to the index.  The points are given
+   * the indices NumPoints() to NumPoints() + points.n_cols - 1, in order, so
+   * a reference set can be added one batch at a time.  Points are encoded in
+   * parallel with NumThreads() threads.
+   *
+   * @tparam MatType Type of the matrix of points (arma::mat or arma::fmat).
+   * @param points Points to add.
+   */
+  template<typename MatType>
+  void Add(const MatType& points);
+
+  /**
+   * Compute the approximate nearest neighbors of the query set given to the
+   * constructor (or of each reference point, if no query set was given) and
+   * store them in the given matrices, which will be k x (number of queries).
+   * If fewer than k points are in the lists scanned for a query, the rest of
+   * its neighbors are (size_t() - 1), with distance DBL_MAX.
+   *
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing the approximate distances of the neighbors
+   *     for each query point.
+   */
+  void Search(const size_t k,
+              arma::Mat<size_t>& resultingNeighbors,
+              arma::mat& distances);
+
+  /**
+   * Compute the approximate nearest neighbors of the given query points, in
+   * the same way as the other overload of Search().  The queries are split
+   * across NumThreads() threads.
+   *
+   * @tparam MatType Type of the matrix of queries (arma::mat or arma::fmat).
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing the approximate distances of the neighbors
+   *     for each query point.
+   */
+  template<typename MatType>
+  void Search(const MatType& querySet,
+              const size_t k,
+              arma::Mat<size_t>& resultingNeighbors,
+              arma::mat& distances);
+
+  //! Get the number of points in the index.
+  size_t NumPoints() const { return numPoints; }
+  //! Get the dimensionality of the points (0 if the index is not trained).
+  size_t Dimensionality() const { return dimensionality; }
+  //! Get the number of subvectors of each point.
+  size_t NumSubvectors() const { return numSubvectors; }
+  //! Get the number of centroids of each codebook.
+  size_t NumCentroids() const { return numCentroids; }
+  //! Get the number of lists of the inverted file (0 if there is none).
+  size_t NumLists() const { return numLists; }
+
+  //! Get the number of lists scanned by each query.
+  size_t NumProbes() const { return numProbes; }
+  //! Modify the number of lists scanned by each query.
+  size_t& NumProbes() { return numProbes; }
+
+  //! Get the number of threads used for encoding and search.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for encoding and search.  This only has
+  //! an effect if mlpack was compiled with OpenMP.
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the centroids of the coarse quantizer (empty if there is none).
+  const arma::mat& CoarseCentroids() const { return coarseCentroids; }
+  //! Get the codebook of the given subvector; each column is a centroid.
+  const arma::mat& Codebook(const size_t subvector) const
+  { return codebooks[subvector]; }
+
+  // Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! Check the parameters given to the constructor.
+  void CheckParameters() const;
+
+  /**
+   * Find the lists to scan for the given query: the numProbes lists whose
+   * coarse centroids are closest to it, or the only list if there is no
+   * coarse quantizer.
+   */
+  void ProbedLists(const arma::vec& query,
+                   const size_t probes,
+                   std::vector<size_t>& lists) const;
+
+  /**
+   * Encode the given point (or residual from its coarse centroid) into
+   * numSubvectors bytes, each the index of the closest centroid of the
+   * codebook of that subvector.
+   */
+  void Encode(const arma::vec& point, unsigned char* code) const;
+
+  /**
+   * Compute the table of the squared distances from each subvector of the
+   * given query (or residual of the query from a coarse centroid) to each
+   * centroid of its codebook.  The table is numCentroids x numSubvectors.
+   */
+  void DistanceTable(const arma::vec& query, arma::mat& table) const;
+
+  /**
+   * Return the approximate squared distance of a code from the query whose
+   * distance table is given.
+   */
+  double TableDistance(const double* table, const unsigned char* code) const
+  {
+    // One lookup per subvector into its own column of the table; the loop has
+    // no branches so that the compiler can vectorize it.
+    double distance = 0.0;
+    for (size_t m = 0; m < numSubvectors; ++m)
+      distance += table[m * numCentroids + code[m]];
+
+    return distance;
+  }
+
+  /**
+   * Search for the neighbors of the given query points; if monochromatic is
+   * true, the query points are the points of the index, and each is excluded
+   * from its own neighbors.
+   */
+  template<typename MatType>
+  void ComputeNeighbors(const MatType& querySet,
+                        const size_t k,
+                        const bool monochromatic,
+                        arma::Mat<size_t>& resultingNeighbors,
+                        arma::mat& distances) const;
+
+  //! Query dataset given to the constructor (NULL if it was not given).
+  const arma::mat* querySet;
+  //! If true, the queries are the reference points given to the constructor.
+  bool monochromatic;
+
+  //! The dimensionality of the points.
+  size_t dimensionality;
+  //! The number of subvectors of each point.
+  size_t numSubvectors;
+  //! The number of centroids of each codebook.
+  size_t numCentroids;
+  //! The number of lists of the inverted file (0 for none).
+  size_t numLists;
+  //! The number of lists scanned by each query.
+  size_t numProbes;
+  //! The maximum number of iterations of each k-means run.
+  size_t maxIterations;
+
+  //! The first dimension of each subvector; subvector m covers dimensions
+  //! subvectorStart[m] to subvectorStart[m + 1] - 1.
+  arma::Col<size_t> subvectorStart;
+  //! The centroids of the coarse quantizer.
+  arma::mat coarseCentroids;
+  //! The codebook of each subvector.
+  std::vector<arma::mat> codebooks;
+  //! The squared norm of each centroid of each codebook (numCentroids x
+  //! numSubvectors), so that each distance table is one matrix-vector product
+  //! per subvector.
+  arma::mat codebookNorms;
+
+  //! The indices of the points in each list.  Indices are 32-bit to keep the
+  //! index small.
+  std::vector<std::vector<arma::u32> > listIndices;
+  //! The codes of the points in each list, numSubvectors bytes per point, in
+  //! the same order as listIndices.
+  std::vector<std::vector<unsigned char> > listCodes;
+  //! The number of points in the index.
+  size_t numPoints;
+
+  //! The number of threads to use for encoding and search.
+  size_t numThreads;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation of templated functions.
+#include "pq_search_impl.hpp"
+
+#endif
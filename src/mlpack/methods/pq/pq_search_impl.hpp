@@ -0,0 +1,172 @@
+/**
+ * @file pq_search_impl.hpp
+ *
+ * Implementation of the templated functions of the PQSearch class.
+ */
+#ifndef __MLPACK_METHODS_PQ_PQ_SEARCH_IMPL_HPP
+#define __MLPACK_METHODS_PQ_PQ_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "pq_search.hpp"
+
+#include <limits>
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename MatType>
+void PQSearch::Add(const MatType& points)
+{
+  if (codebooks.empty())
+  {
+    Log::Fatal << "PQSearch::Add(): the index must be trained before points "
+        << "are added!" << std::endl;
+  }
+
+  if (points.n_rows != dimensionality)
+  {
+    Log::Fatal << "PQSearch::Add(): points have " << points.n_rows
+        << " dimensions, but the index was trained on " << dimensionality
+        << "-dimensional points!" << std::endl;
+  }
+
+  if (numPoints + points.n_cols >
+      (size_t) std::numeric_limits<arma::u32>::max())
+  {
+    Log::Fatal << "PQSearch::Add(): the index cannot hold more than "
+        << std::numeric_limits<arma::u32>::max() << " points!" << std::endl;
+  }
+
+  // Each point is encoded independently, so the batch is encoded in parallel;
+  // the codes are then appended to their lists in order, so that each list
+  // stays sorted by index.
+  arma::Col<size_t> lists(points.n_cols);
+  arma::Mat<unsigned char> codes(numSubvectors, points.n_cols);
+
+  #pragma omp parallel num_threads(numThreads)
+  {
+    arma::vec point;
+    std::vector<size_t> closest;
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < points.n_cols; ++i)
+    {
+      point = arma::conv_to<arma::vec>::from(points.col(i));
+
+      ProbedLists(point, 1, closest);
+      lists[i] = closest[0];
+      if (numLists > 0)
+        point -= coarseCentroids.unsafe_col(lists[i]);
+
+      Encode(point, codes.colptr(i));
+    }
+  }
+
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    listIndices[lists[i]].push_back((arma::u32) (numPoints + i));
+    listCodes[lists[i]].insert(listCodes[lists[i]].end(), codes.colptr(i),
+        codes.colptr(i) + numSubvectors);
+  }
+
+  numPoints += points.n_cols;
+}
+
+template<typename MatType>
+void PQSearch::Search(const MatType& querySet,
+                      const size_t k,
+                      arma::Mat<size_t>& resultingNeighbors,
+                      arma::mat& distances)
+{
+  ComputeNeighbors(querySet, k, false, resultingNeighbors, distances);
+}
+
+template<typename MatType>
+void PQSearch::ComputeNeighbors(const MatType& querySet,
+                                const size_t k,
+                                const bool monochromatic,
+                                arma::Mat<size_t>& resultingNeighbors,
+                                arma::mat& distances) const
+{
+  if (querySet.n_rows != dimensionality)
+  {
+    Log::Fatal << "PQSearch::Search(): queries have " << querySet.n_rows
+        << " dimensions, but the index was trained on " << dimensionality
+        << "-dimensional points!" << std::endl;
+  }
+
+  const size_t maxK = monochromatic ? numPoints - 1 : numPoints;
+  if (k == 0 || numPoints == 0 || k > maxK)
+  {
+    Log::Fatal << "PQSearch::Search(): invalid k (" << k << "); must be "
+        << "greater than 0 and at most the number of points in the index ("
+        << maxK << ")." << std::endl;
+  }
+
+  resultingNeighbors.set_size(k, querySet.n_cols);
+  resultingNeighbors.fill(size_t() - 1);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(NearestNeighborSort::WorstDistance());
+
+  const size_t probes = (numLists == 0) ? 1 : std::min(numProbes, numLists);
+
+  Timer::Start("computing_neighbors");
+
+  // Each query only writes to its own column of the results, so no locking is
+  // necessary.
+  #pragma omp parallel num_threads(numThreads)
+  {
+    arma::vec query;
+    arma::vec residual;
+    arma::mat table(numCentroids, numSubvectors);
+    std::vector<size_t> lists;
+
+    #pragma omp for schedule(dynamic, 16)
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      query = arma::conv_to<arma::vec>::from(querySet.col(i));
+      ProbedLists(query, probes, lists);
+
+      for (size_t p = 0; p < lists.size(); ++p)
+      {
+        const std::vector<arma::u32>& indices = listIndices[lists[p]];
+        if (indices.empty())
+          continue;
+
+        // The points of a list are encoded as residuals from its coarse
+        // centroid, so the table is built from the residual of the query.
+        if (numLists > 0)
+          residual = query - coarseCentroids.unsafe_col(lists[p]);
+        else
+          residual = query;
+        DistanceTable(residual, table);
+
+        const double* tablePtr = table.memptr();
+        const unsigned char* code = &listCodes[lists[p]][0];
+        for (size_t j = 0; j < indices.size(); ++j, code += numSubvectors)
+        {
+          if (monochromatic && indices[j] == i)
+            continue;
+
+          CandidateHeap<NearestNeighborSort>::Insert(resultingNeighbors,
+              distances, i, indices[j], TableDistance(tablePtr, code));
+        }
+      }
+    }
+  }
+
+  CandidateHeap<NearestNeighborSort>::Sort(resultingNeighbors, distances);
+
+  // The tables hold squared distances, which can be slightly negative after
+  // the expansion in DistanceTable().
+  for (size_t i = 0; i < distances.n_elem; ++i)
+    if (resultingNeighbors[i] != size_t() - 1)
+      distances[i] = std::sqrt(std::max(distances[i], 0.0));
+
+  Timer::Stop("computing_neighbors");
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
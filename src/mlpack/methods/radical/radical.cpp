@@ -7,6 +7,10 @@
 
 #include "radical.hpp"
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 using namespace std;
 using namespace arma;
 using namespace mlpack;
@@ -38,7 +42,8 @@ void Radical::CopyAndPerturb(mat& xNew, const mat& x) const
 
 double Radical::Vasicek(vec& z) const
 {
-  z = sort(z);
+  // Sorting in place avoids allocating a sorted copy for each angle.
+  std::sort(z.begin(), z.end());
 
   // Apparently slower.
   /*
@@ -63,26 +68,32 @@ double Radical::DoRadical2D(const mat& matX)
 {
   CopyAndPerturb(perturbed, matX);
 
-  mat::fixed<2, 2> matJacobi;
+  return SearchAngles(perturbed, true);
+}
 
+double Radical::SearchAngles(const mat& data, const bool parallel) const
+{
   vec values(angles);
 
-  for (size_t i = 0; i < angles; i++)
+  // Each angle is independent, so the angles are searched in parallel, each
+  // thread with its own buffers for the rotated (and sorted) coordinates.
+  #pragma omp parallel if (parallel)
   {
-    const double theta = (i / (double) angles) * M_PI / 2.0;
-    const double cosTheta = cos(theta);
-    const double sinTheta = sin(theta);
+    vec candidateY1, candidateY2;
 
-    matJacobi(0, 0) = cosTheta;
-    matJacobi(1, 0) = -sinTheta;
-    matJacobi(0, 1) = sinTheta;
-    matJacobi(1, 1) = cosTheta;
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < angles; i++)
+    {
+      const double theta = (i / (double) angles) * M_PI / 2.0;
+      const double cosTheta = cos(theta);
+      const double sinTheta = sin(theta);
 
-    candidate = perturbed * matJacobi;
-    vec candidateY1 = candidate.unsafe_col(0);
-    vec candidateY2 = candidate.unsafe_col(1);
+      // This is the product of the perturbed data and the Jacobi rotation.
+      candidateY1 = cosTheta * data.col(0) - sinTheta * data.col(1);
+      candidateY2 = sinTheta * data.col(0) + cosTheta * data.col(1);
 
-    values(i) = Vasicek(candidateY1) + Vasicek(candidateY2);
+      values(i) = Vasicek(candidateY1) + Vasicek(candidateY2);
+    }
   }
 
   uword indOpt;
@@ -125,42 +136,94 @@ void Radical::DoRadical(const mat& matXT, mat& matY, mat& matW)
   Timer::Start("radical_do_radical");
   matW = matWhitening;
 
-  mat matYSubspace(nPoints, 2);
-
-  mat matJ = eye(nDims, nDims);
+  // The pairs of dimensions of each sweep are processed in the rounds of a
+  // round-robin tournament: each round is a set of disjoint pairs, whose
+  // rotations commute, so the pairs of a round are processed in parallel.  (If
+  // there are fewer pairs in a round than threads, the pairs are processed one
+  // at a time, and the angles of each pair are searched in parallel.)  With an
+  // odd number of dimensions, the dimension paired with the extra player sits
+  // out the round.
+  const size_t players = nDims + (nDims % 2);
+  std::vector<size_t> order(players);
+  std::vector<std::pair<size_t, size_t> > pairs;
+  std::vector<uint32_t> seeds;
+
+  size_t numThreads = 1;
+#ifdef HAS_OPENMP
+  numThreads = (size_t) omp_get_max_threads();
+#endif
 
   for (size_t sweepNum = 0; sweepNum < sweeps; sweepNum++)
   {
     Log::Info << "RADICAL: sweep " << sweepNum << "." << std::endl;
 
-    for (size_t i = 0; i < nDims - 1; i++)
+    for (size_t round = 0; round + 1 < players; round++)
     {
-      for (size_t j = i + 1; j < nDims; j++)
-      {
-        Log::Debug << "RADICAL 2D on dimensions " << i << " and " << j << "."
-            << std::endl;
-
-        matYSubspace.col(0) = matY.col(i);
-        matYSubspace.col(1) = matY.col(j);
-
-        const double thetaOpt = DoRadical2D(matYSubspace);
+      order[0] = 0;
+      for (size_t k = 1; k < players; k++)
+        order[k] = 1 + (k - 1 + round) % (players - 1);
 
-        const double cosThetaOpt = cos(thetaOpt);
-        const double sinThetaOpt = sin(thetaOpt);
+      pairs.clear();
+      for (size_t k = 0; k < players / 2; k++)
+      {
+        const size_t a = order[k];
+        const size_t b = order[players - 1 - k];
+        if (a < nDims && b < nDims)
+          pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+      }
 
-        // Set elements of transformation matrix.
-        matJ(i, i) = cosThetaOpt;
-        matJ(j, i) = -sinThetaOpt;
-        matJ(i, j) = sinThetaOpt;
-        matJ(j, j) = cosThetaOpt;
+      // The noise of each pair comes from its own generator, whose seed is
+      // drawn here, so the results do not depend on the number of threads.
+      seeds.resize(pairs.size());
+      for (size_t p = 0; p < pairs.size(); p++)
+        seeds[p] = (uint32_t) math::RandInt(std::numeric_limits<int>::max());
 
-        matY *= matJ;
+      const bool parallelPairs = (pairs.size() >= numThreads);
 
-        // Unset elements of transformation matrix, so matJ = eye() again.
-        matJ(i, i) = 1;
-        matJ(j, i) = 0;
-        matJ(i, j) = 0;
-        matJ(j, j) = 1;
+      #pragma omp parallel if (parallelPairs)
+      {
+        mat matYSubspace(replicates * nPoints, 2);
+        vec yi, wi;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t p = 0; p < pairs.size(); p++)
+        {
+          const size_t i = pairs[p].first;
+          const size_t j = pairs[p].second;
+
+          // Copy and perturb the two dimensions (see CopyAndPerturb()).
+          boost::mt19937 generator(seeds[p]);
+          boost::normal_distribution<> normal;
+          boost::variate_generator<boost::mt19937&,
+              boost::normal_distribution<> > noise(generator, normal);
+
+          for (size_t r = 0; r < replicates; r++)
+          {
+            for (size_t k = 0; k < nPoints; k++)
+            {
+              matYSubspace(r * nPoints + k, 0) = matY(k, i);
+              matYSubspace(r * nPoints + k, 1) = matY(k, j);
+            }
+          }
+          for (size_t k = 0; k < matYSubspace.n_elem; k++)
+            matYSubspace[k] += noiseStdDev * noise();
+
+          const double thetaOpt = SearchAngles(matYSubspace, !parallelPairs);
+
+          const double cosThetaOpt = cos(thetaOpt);
+          const double sinThetaOpt = sin(thetaOpt);
+
+          // Apply the Jacobi rotation of dimensions i and j to matY and matW;
+          // this is multiplying each by the identity with the rotation set in
+          // those dimensions, but only the two columns are touched.
+          yi = matY.col(i);
+          matY.col(i) = cosThetaOpt * yi - sinThetaOpt * matY.col(j);
+          matY.col(j) = sinThetaOpt * yi + cosThetaOpt * matY.col(j);
+
+          wi = matW.col(i);
+          matW.col(i) = cosThetaOpt * wi - sinThetaOpt * matW.col(j);
+          matW.col(j) = sinThetaOpt * wi + cosThetaOpt * matW.col(j);
+        }
       }
     }
   }
@@ -47,8 +47,9 @@ class Radical
    *    point) in Radical2D
    * @param angles Number of angles to consider in brute-force search during
    *    Radical2D
-   * @param sweeps Number of sweeps.  Each sweep calls Radical2D once for each
-   *    pair of dimensions
+   * @param sweeps Number of sweeps.  Each sweep searches the best rotation once
+   *    for each pair of dimensions, visiting the pairs in the rounds of a
+   *    round-robin tournament
    * @param m The variable m from Vasicek's m-spacing estimator of entropy.
    */
   Radical(const double noiseStdDev = 0.175,
@@ -58,13 +59,19 @@ class Radical
           const size_t m = 0);
 
   /**
-   * Run RADICAL.
+   * Run RADICAL.  The data is whitened, and then each sweep rotates each pair
+   * of dimensions of the whitened data by the angle that minimizes the sum of
+   * the entropies of the pair; the pairs of a sweep are visited in the rounds
+   * of a round-robin tournament, and the noise added to each pair comes from
+   * its own generator, seeded from math::RandInt().
    *
    * @param matX Input data into the algorithm - a matrix where each column is
    *    a point and each row is a dimension.
    * @param matY Estimated independent components - a matrix where each column
    *    is a point and each row is an estimated independent component.
-   * @param matW Estimated unmixing matrix, where matY = matW * matX.
+   * @param matW Estimated unmixing matrix, where matY = matW * matX: the
+   *    rotations of the sweeps applied to the whitening matrix (and not the
+   *    whitening matrix alone).
    */
   void DoRadical(const arma::mat& matX, arma::mat& matY, arma::mat& matW);
 
@@ -129,8 +136,15 @@ class Radical
 
   //! Internal matrix, held as member variable to prevent memory reallocations.
   arma::mat perturbed;
-  //! Internal matrix, held as member variable to prevent memory reallocations.
-  arma::mat candidate;
+
+  /**
+   * Find the angle of the rotation of the given perturbed two-dimensional data
+   * which minimizes the sum of the entropies of the two coordinates.
+   *
+   * @param data Perturbed data (one row for each point).
+   * @param parallel Whether or not to search the angles in parallel.
+   */
+  double SearchAngles(const arma::mat& data, const bool parallel) const;
 };
 
 void WhitenFeatureMajorMatrix(const arma::mat& matX,
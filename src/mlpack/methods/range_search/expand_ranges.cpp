@@ -0,0 +1,105 @@
+/**
+ * @file expand_ranges.cpp
+ *
+ * Implementation of the expansion of range search results on unique points.
+ */
+#include "expand_ranges.hpp"
+
+namespace mlpack {
+namespace range {
+
+//! Append the copies of each unique neighbor to the given results.
+static void ExpandUniqueNeighbors(const data::UniquePoints& references,
+                                  const std::vector<size_t>& uniqueNeighbors,
+                                  const std::vector<double>& uniqueDistances,
+                                  std::vector<size_t>& neighbors,
+                                  std::vector<double>& distances)
+{
+  for (size_t j = 0; j < uniqueNeighbors.size(); ++j)
+  {
+    const size_t unique = uniqueNeighbors[j];
+    for (size_t c = 0; c < references.Count(unique); ++c)
+    {
+      neighbors.push_back(references.Copy(unique, c));
+      distances.push_back(uniqueDistances[j]);
+    }
+  }
+}
+
+void ExpandRanges(const data::UniquePoints& references,
+                  const data::UniquePoints& queries,
+                  const std::vector<std::vector<size_t> >& uniqueNeighbors,
+                  const std::vector<std::vector<double> >& uniqueDistances,
+                  std::vector<std::vector<size_t> >& neighbors,
+                  std::vector<std::vector<double> >& distances)
+{
+  if (uniqueNeighbors.size() != queries.NumUnique())
+  {
+    Log::Fatal << "ExpandRanges(): results given for " << uniqueNeighbors.size()
+        << " query points, but there are " << queries.NumUnique()
+        << " unique query points!" << std::endl;
+  }
+
+  neighbors.clear();
+  distances.clear();
+  neighbors.resize(queries.NumPoints());
+  distances.resize(queries.NumPoints());
+
+  // Expand the results of each unique query point into its first copy, and
+  // then copy them to the others.
+  for (size_t q = 0; q < queries.NumUnique(); ++q)
+  {
+    const size_t first = queries.Copy(q, 0);
+    ExpandUniqueNeighbors(references, uniqueNeighbors[q], uniqueDistances[q],
+        neighbors[first], distances[first]);
+
+    for (size_t c = 1; c < queries.Count(q); ++c)
+    {
+      neighbors[queries.Copy(q, c)] = neighbors[first];
+      distances[queries.Copy(q, c)] = distances[first];
+    }
+  }
+}
+
+void ExpandRanges(const data::UniquePoints& points,
+                  const math::Range& range,
+                  const std::vector<std::vector<size_t> >& uniqueNeighbors,
+                  const std::vector<std::vector<double> >& uniqueDistances,
+                  std::vector<std::vector<size_t> >& neighbors,
+                  std::vector<std::vector<double> >& distances)
+{
+  if (uniqueNeighbors.size() != points.NumUnique())
+  {
+    Log::Fatal << "ExpandRanges(): results given for " << uniqueNeighbors.size()
+        << " points, but there are " << points.NumUnique() << " unique points!"
+        << std::endl;
+  }
+
+  neighbors.clear();
+  distances.clear();
+  neighbors.resize(points.NumPoints());
+  distances.resize(points.NumPoints());
+
+  const bool copiesInRange = range.Contains(0.0);
+  for (size_t i = 0; i < points.NumPoints(); ++i)
+  {
+    const size_t unique = points.UniqueIndices()[i];
+    if (copiesInRange)
+    {
+      for (size_t c = 0; c < points.Count(unique); ++c)
+      {
+        if (points.Copy(unique, c) == i)
+          continue;
+
+        neighbors[i].push_back(points.Copy(unique, c));
+        distances[i].push_back(0.0);
+      }
+    }
+
+    ExpandUniqueNeighbors(points, uniqueNeighbors[unique],
+        uniqueDistances[unique], neighbors[i], distances[i]);
+  }
+}
+
+}; // namespace range
+}; // namespace mlpack
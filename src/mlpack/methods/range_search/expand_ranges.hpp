@@ -0,0 +1,63 @@
+/**
+ * @file expand_ranges.hpp
+ *
+ * Expand the results of a range search on the unique points of datasets with
+ * duplicates (see data::UniquePoints) into the results of the search on the
+ * original points.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_EXPAND_RANGES_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_EXPAND_RANGES_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace range {
+
+/**
+ * Expand the results of a bichromatic range search of the unique query points
+ * among the unique reference points into the results of each original query
+ * point: each unique neighbor is replaced by all its copies, at the same
+ * distance, and the copies of a query point all get the same results.
+ *
+ * @param references Unique points of the reference set.
+ * @param queries Unique points of the query set.
+ * @param uniqueNeighbors Neighbors in range of each unique query point.
+ * @param uniqueDistances Distances to the neighbors of each unique query point.
+ * @param neighbors Object to store the neighbors of each original query point
+ *     in.
+ * @param distances Object to store the distances to the neighbors of each
+ *     original query point in.
+ */
+void ExpandRanges(const data::UniquePoints& references,
+                  const data::UniquePoints& queries,
+                  const std::vector<std::vector<size_t> >& uniqueNeighbors,
+                  const std::vector<std::vector<double> >& uniqueDistances,
+                  std::vector<std::vector<size_t> >& neighbors,
+                  std::vector<std::vector<double> >& distances);
+
+/**
+ * Expand the results of a monochromatic range search among the unique points
+ * into the results of each original point.  Each unique neighbor is replaced by
+ * all its copies, at the same distance, and if the range contains 0, the other
+ * copies of a point are in its range too (but, as in a monochromatic search, a
+ * point is not in its own range).
+ *
+ * @param points Unique points of the dataset.
+ * @param range Range of distances that was searched.
+ * @param uniqueNeighbors Neighbors in range of each unique point.
+ * @param uniqueDistances Distances to the neighbors of each unique point.
+ * @param neighbors Object to store the neighbors of each original point in.
+ * @param distances Object to store the distances to the neighbors of each
+ *     original point in.
+ */
+void ExpandRanges(const data::UniquePoints& points,
+                  const math::Range& range,
+                  const std::vector<std::vector<size_t> >& uniqueNeighbors,
+                  const std::vector<std::vector<double> >& uniqueDistances,
+                  std::vector<std::vector<size_t> >& neighbors,
+                  std::vector<std::vector<double> >& distances);
+
+}; // namespace range
+}; // namespace mlpack
+
+#endif
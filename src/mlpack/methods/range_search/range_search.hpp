@@ -9,9 +9,13 @@
 #define __MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_HPP
 
 #include <mlpack/core.hpp>
+#include <list>
+
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 #include "range_search_stat.hpp"
+#include "range_search_rules.hpp"
 
 namespace mlpack {
 namespace range /** Range-search routines. */ {
@@ -77,6 +81,47 @@ class RangeSearch
               const bool singleMode = false,
               const MetricType metric = MetricType());
 
+  /**
+   * Initialize the RangeSearch object with the given reference and query sets,
+   * taking the memory of the matrices instead of copying them: the given
+   * matrices are left empty, and the points are rearranged in place during
+   * tree-building.  The rearranged sets, and the mappings from their new
+   * indices to the original indices, can be taken from ReferenceSet(),
+   * QuerySet(), OldFromNewReferences() and OldFromNewQueries(); the results of
+   * Search() are still given in terms of the original indices.  The two
+   * matrices must be different.
+   *
+   * @param referenceSet Set of reference points (which is emptied).
+   * @param querySet Set of query points (which is emptied).
+   * @param naive If true, O(n^2) naive search will be used (as opposed to
+   *      dual-tree search).  This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param metric An optional instance of the MetricType class.
+   */
+  RangeSearch(typename TreeType::Mat* referenceSet,
+              typename TreeType::Mat* querySet,
+              const bool naive = false,
+              const bool singleMode = false,
+              const MetricType metric = MetricType());
+
+  /**
+   * Initialize the RangeSearch object with only one dataset, which is used as
+   * both the query and the reference dataset, taking the memory of the matrix
+   * instead of copying it (see the constructor above).
+   *
+   * @param referenceSet Set of reference points (which is emptied).
+   * @param naive If true, O(n^2) naive search will be used (as opposed to
+   *      dual-tree search).  This overrides singleMode (if it is set to true).
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param metric An optional instance of the MetricType class.
+   */
+  RangeSearch(typename TreeType::Mat* referenceSet,
+              const bool naive = false,
+              const bool singleMode = false,
+              const MetricType metric = MetricType());
+
   /**
    * Initialize the RangeSearch object with the given datasets and
    * pre-constructed trees.  It is assumed that the points in referenceSet and
@@ -181,10 +226,101 @@ class RangeSearch
               std::vector<std::vector<size_t> >& neighbors,
               std::vector<std::vector<double> >& distances);
 
+  /**
+   * Search for all points in the given range, returning the results in
+   * compressed sparse row (CSR) format.  This avoids allocating a separate
+   * vector for each query point, which matters when there are many query
+   * points or many results.  The results for query point i are stored at
+   * positions offsets[i] to offsets[i + 1] - 1 of neighbors and distances;
+   * that is:
+   *
+   * - offsets.n_elem is the number of query points plus one, offsets[0] is 0,
+   *   and offsets[offsets.n_elem - 1] is the total number of results.
+   *
+   * - neighbors[j] is the index of a reference point which has a distance
+   *   inside the given range to its query point, and distances[j] is that
+   *   distance.
+   *
+   * - The results of each query point are not sorted in any particular order.
+   *
+   * During single-tree search each thread appends its results to its own
+   * buffer, so no locking is needed; the buffers are merged (and mapped back to
+   * the original point indices, if necessary) once the search is finished.
+   *
+   * @param range Range of distances in which to search.
+   * @param offsets Vector which will hold the offset of the results of each
+   *      query point.
+   * @param neighbors Vector which will hold the indices of the results.
+   * @param distances Vector which will hold the distances of the results.
+   */
+  void Search(const math::Range& range,
+              arma::Col<size_t>& offsets,
+              arma::Col<size_t>& neighbors,
+              arma::vec& distances);
+
+  /**
+   * Count the points in the given range of each query point, without storing
+   * the points themselves.  This is much faster than Search() when only the
+   * counts are needed (for instance, to find the core points of DBSCAN),
+   * because any reference node entirely inside the range is counted at once
+   * with NumDescendants(), without computing any of its distances.
+   *
+   * @param range Range of distances in which to search.
+   * @param counts Vector which will hold the number of reference points that
+   *      have distances inside the given range, for each query point.
+   */
+  void Count(const math::Range& range, arma::Col<size_t>& counts);
+
   // Returns a string representation of this object. 
   std::string ToString() const;
 
+  //! Get the number of threads used for single-tree search.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for single-tree search.  This only has
+  //! an effect if mlpack was compiled with OpenMP.
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get whether single-tree searches visit the queries along the Hilbert
+  //! curve.
+  bool ReorderQueries() const { return reorderQueries; }
+  //! Modify whether single-tree searches visit the queries along the Hilbert
+  //! curve (see tree::HilbertOrder()) instead of in the order they were given,
+  //! so that consecutive queries reach the same parts of the reference tree.
+  //! The results are the same.  This is false by default.
+  bool& ReorderQueries() { return reorderQueries; }
+
+  //! Get the traversal statistics of tree building and all searches.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of tree building and all searches.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+  //! Get the reference set.  If this object built the reference tree, this is
+  //! its rearranged copy of the reference set.
+  const typename TreeType::Mat& ReferenceSet() const { return referenceSet; }
+  //! Get the query set (this is the reference set if no query set was given).
+  const typename TreeType::Mat& QuerySet() const { return querySet; }
+  //! Get the original index of each point of ReferenceSet() (empty if the
+  //! reference set was not rearranged).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNewReferences; }
+  //! Get the original index of each point of QuerySet() (empty if the query
+  //! set was not rearranged).
+  const std::vector<size_t>& OldFromNewQueries() const
+  { return oldFromNewQueries; }
+
  private:
+  /**
+   * Run the search with the given rules, in whichever mode was selected.  If
+   * threadBuffers is not NULL, each thread of a single-tree search appends its
+   * results to its own buffer, and those buffers are added to threadBuffers
+   * when the thread is finished; otherwise the rules are copied as they are.
+   *
+   * @param rules Rules to search with (the statistics are collected here).
+   * @param threadBuffers List to add the buffers of each thread to, or NULL.
+   */
+  void Traverse(RangeSearchRules<MetricType, TreeType>& rules,
+                std::list<RangeSearchBuffer>* threadBuffers);
+
   //! Copy of reference matrix; used when a tree is built internally.
   typename TreeType::Mat referenceCopy;
   //! Copy of query matrix; used when a tree is built internally.
@@ -221,6 +357,15 @@ class RangeSearch
 
   //! The number of pruned nodes during computation.
   size_t numPrunes;
+
+  //! The number of threads to use for single-tree search.
+  size_t numThreads;
+
+  //! If true, single-tree searches visit the queries along the Hilbert curve.
+  bool reorderQueries;
+
+  //! The traversal statistics of tree building and all searches.
+  tree::TraversalStatistics statistics;
 };
 
 }; // namespace range
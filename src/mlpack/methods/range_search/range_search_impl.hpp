@@ -10,8 +10,9 @@
 // Just in case it hasn't been included.
 #include "range_search.hpp"
 
-// The rules for traversal.
-#include "range_search_rules.hpp"
+#include <mlpack/core/tree/count_nodes.hpp>
+#include <mlpack/core/tree/hilbert_curve.hpp>
+#include <mlpack/core/tree/symmetric_dual_tree_traverser.hpp>
 
 namespace mlpack {
 namespace range {
@@ -24,7 +25,9 @@ TreeType* BuildTree(
         tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
     >::type = 0)
 {
-  return new TreeType(dataset, oldFromNew);
+  TreeType* root = new TreeType(dataset, oldFromNew);
+  MemoryTracker::AddCounter("tree_nodes", tree::CountNodes(*root));
+  return root;
 }
 
 //! Call the tree constructor that does not do mapping.
@@ -36,7 +39,9 @@ TreeType* BuildTree(
         tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
     >::type = 0)
 {
-  return new TreeType(dataset);
+  TreeType* root = new TreeType(dataset);
+  MemoryTracker::AddCounter("tree_nodes", tree::CountNodes(*root));
+  return root;
 }
 
 template<typename MetricType, typename TreeType>
@@ -55,16 +60,21 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
     naive(naive),
     singleMode(!naive && singleMode), // Naive overrides single mode.
     metric(metric),
-    numPrunes(0)
+    numPrunes(0),
+    numThreads(1),
+    reorderQueries(false)
 {
   // Build the trees.
   Timer::Start("range_search/tree_building");
+  statistics.StartPhase("tree_building");
 
   // Copy the datasets, if they will be modified during tree building.
   if (tree::TreeTraits<TreeType>::RearrangesDataset)
   {
     referenceCopy = referenceSetIn;
     queryCopy = querySetIn;
+    MemoryTracker::AddCounter("dataset_copy_bytes", (referenceCopy.n_elem +
+        queryCopy.n_elem) * sizeof(typename TreeType::Mat::elem_type));
   }
 
   // If in naive mode, then we do not need to build trees.
@@ -82,6 +92,7 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
           const_cast<typename TreeType::Mat&>(querySet), oldFromNewQueries);
   }
 
+  statistics.StopPhase("tree_building");
   Timer::Stop("range_search/tree_building");
 }
 
@@ -101,14 +112,21 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
     naive(naive),
     singleMode(!naive && singleMode), // Naive overrides single mode.
     metric(metric),
-    numPrunes(0)
+    numPrunes(0),
+    numThreads(1),
+    reorderQueries(false)
 {
   // Build the trees.
   Timer::Start("range_search/tree_building");
+  statistics.StartPhase("tree_building");
 
   // Copy the dataset, if it will be modified during tree building.
   if (tree::TreeTraits<TreeType>::RearrangesDataset)
+  {
     referenceCopy = referenceSetIn;
+    MemoryTracker::AddCounter("dataset_copy_bytes", referenceCopy.n_elem *
+        sizeof(typename TreeType::Mat::elem_type));
+  }
 
   // If in naive mode, then we do not need to build trees.
   if (!naive)
@@ -121,8 +139,100 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
         oldFromNewReferences);
 
     if (!singleMode)
+    {
       queryTree = new TreeType(*referenceTree);
+      MemoryTracker::AddCounter("tree_nodes", tree::CountNodes(*queryTree));
+    }
   }
+  statistics.StopPhase("tree_building");
+  Timer::Stop("range_search/tree_building");
+}
+
+// Construct the object, taking the memory of the datasets.
+template<typename MetricType, typename TreeType>
+RangeSearch<MetricType, TreeType>::RangeSearch(
+    typename TreeType::Mat* referenceSetIn,
+    typename TreeType::Mat* querySetIn,
+    const bool naive,
+    const bool singleMode,
+    const MetricType metric) :
+    referenceSet(referenceCopy),
+    querySet(queryCopy),
+    referenceTree(NULL),
+    queryTree(NULL),
+    treeOwner(!naive), // If naive, then we are not building any trees.
+    hasQuerySet(true),
+    naive(naive),
+    singleMode(!naive && singleMode), // No single mode if naive.
+    metric(metric),
+    numPrunes(0),
+    numThreads(1),
+    reorderQueries(false)
+{
+  if (referenceSetIn == querySetIn)
+    Log::Fatal << "RangeSearch::RangeSearch(): the reference set and "
+        << "the query set must be different matrices!" << std::endl;
+
+  // We'll time tree building, but only if we are building trees.
+  Timer::Start("range_search/tree_building");
+  statistics.StartPhase("tree_building");
+
+  // The trees are built on the memory of the given datasets; nothing is copied
+  // (unless the memory cannot be taken, as with matrices using auxiliary
+  // memory).
+  referenceCopy.steal_mem(*referenceSetIn);
+  queryCopy.steal_mem(*querySetIn);
+
+  if (!naive)
+  {
+    referenceTree = BuildTree<TreeType>(referenceCopy, oldFromNewReferences);
+
+    if (!singleMode)
+      queryTree = BuildTree<TreeType>(queryCopy, oldFromNewQueries);
+  }
+
+  statistics.StopPhase("tree_building");
+  Timer::Stop("range_search/tree_building");
+}
+
+// Construct the object, taking the memory of the dataset.
+template<typename MetricType, typename TreeType>
+RangeSearch<MetricType, TreeType>::RangeSearch(
+    typename TreeType::Mat* referenceSetIn,
+    const bool naive,
+    const bool singleMode,
+    const MetricType metric) :
+    referenceSet(referenceCopy),
+    querySet(referenceCopy),
+    referenceTree(NULL),
+    queryTree(NULL),
+    treeOwner(!naive), // If naive, then we are not building any trees.
+    hasQuerySet(false),
+    naive(naive),
+    singleMode(!naive && singleMode), // No single mode if naive.
+    metric(metric),
+    numPrunes(0),
+    numThreads(1),
+    reorderQueries(false)
+{
+  // We'll time tree building, but only if we are building trees.
+  Timer::Start("range_search/tree_building");
+  statistics.StartPhase("tree_building");
+
+  referenceCopy.steal_mem(*referenceSetIn);
+
+  if (!naive)
+  {
+    referenceTree = BuildTree<TreeType>(referenceCopy, oldFromNewReferences);
+
+    if (!singleMode)
+    {
+      queryTree = new TreeType(*referenceTree);
+      MemoryTracker::AddCounter("tree_nodes", tree::CountNodes(*queryTree));
+    }
+  }
+
+  statistics.StopPhase("tree_building");
   Timer::Stop("range_search/tree_building");
 }
 
@@ -143,7 +253,9 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    numPrunes(0)
+    numPrunes(0),
+    numThreads(1),
+    reorderQueries(false)
 {
   // Nothing else to initialize.
 }
@@ -163,11 +275,16 @@ RangeSearch<MetricType, TreeType>::RangeSearch(
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    numPrunes(0)
+    numPrunes(0),
+    numThreads(1),
+    reorderQueries(false)
 {
   // If doing dual-tree range search, we must clone the reference tree.
   if (!singleMode)
+  {
     queryTree = new TreeType(*referenceTree);
+    MemoryTracker::AddCounter("tree_nodes", tree::CountNodes(*queryTree));
+  }
 }
 
 template<typename MetricType, typename TreeType>
@@ -193,6 +310,7 @@ void RangeSearch<MetricType, TreeType>::Search(
     std::vector<std::vector<double> >& distances)
 {
   Timer::Start("range_search/computing_neighbors");
+  statistics.StartPhase("traversal");
 
   // Set size of prunes to 0.
   numPrunes = 0;
@@ -225,34 +343,11 @@ void RangeSearch<MetricType, TreeType>::Search(
   RuleType rules(referenceSet, querySet, range, *neighborPtr, *distancePtr,
       metric);
 
-  if (naive)
-  {
-    // The naive brute-force solution.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      for (size_t j = 0; j < referenceSet.n_cols; ++j)
-        rules.BaseCase(i, j);
-  }
-  else if (singleMode)
-  {
-    // Create the traverser.
-    typename TreeType::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+  Traverse(rules, NULL);
 
-    numPrunes = traverser.NumPrunes();
-  }
-  else // Dual-tree recursion.
-  {
-    // Create the traverser.
-    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
-
-    traverser.Traverse(*queryTree, *referenceTree);
-
-    numPrunes = traverser.NumPrunes();
-  }
+  statistics += rules.Statistics();
 
+  statistics.StopPhase("traversal");
   Timer::Stop("range_search/computing_neighbors");
 
   // Output number of prunes.
@@ -336,6 +431,222 @@ void RangeSearch<MetricType, TreeType>::Search(
   }
 }
 
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Search(
+    const math::Range& range,
+    arma::Col<size_t>& offsets,
+    arma::Col<size_t>& neighbors,
+    arma::vec& distances)
+{
+  Timer::Start("range_search/computing_neighbors");
+  statistics.StartPhase("traversal");
+
+  // Set size of prunes to 0.
+  numPrunes = 0;
+
+  // The naive and dual-tree searches append to this buffer; each thread of a
+  // single-tree search adds its own buffer to the list.
+  std::list<RangeSearchBuffer> buffers(1);
+
+  typedef RangeSearchRules<MetricType, TreeType> RuleType;
+  RuleType rules(referenceSet, querySet, range, buffers.front(), metric);
+
+  Traverse(rules, &buffers);
+
+  statistics += rules.Statistics();
+
+  statistics.StopPhase("traversal");
+  Timer::Stop("range_search/computing_neighbors");
+
+  // Output number of prunes.
+  Log::Info << "Number of pruned nodes during computation: " << numPrunes
+      << "." << std::endl;
+
+  // If we built the trees, the results must be mapped back to the original
+  // indices; this is done while the buffers are scattered into place.  As in
+  // the other Search(), the query points are not rearranged during single-tree
+  // search with a separate query set.
+  const bool mapReferences = treeOwner &&
+      tree::TreeTraits<TreeType>::RearrangesDataset;
+  const bool mapQueries = mapReferences && !(hasQuerySet && singleMode);
+  const std::vector<size_t>& queryMapping = hasQuerySet ? oldFromNewQueries :
+      oldFromNewReferences;
+
+  // Count the results of each query point, and turn the counts into offsets.
+  offsets.zeros(querySet.n_cols + 1);
+  for (std::list<RangeSearchBuffer>::const_iterator it = buffers.begin();
+       it != buffers.end(); ++it)
+  {
+    for (size_t i = 0; i < it->queries.size(); ++i)
+    {
+      const size_t query = mapQueries ? queryMapping[it->queries[i]] :
+          it->queries[i];
+      ++offsets[query + 1];
+    }
+  }
+
+  for (size_t i = 1; i < offsets.n_elem; ++i)
+    offsets[i] += offsets[i - 1];
+
+  // Now scatter each result into place, releasing each buffer once it has been
+  // copied.
+  neighbors.set_size(offsets[querySet.n_cols]);
+  distances.set_size(offsets[querySet.n_cols]);
+  arma::Col<size_t> next(offsets.memptr(), querySet.n_cols);
+  while (!buffers.empty())
+  {
+    const RangeSearchBuffer& buffer = buffers.front();
+    for (size_t i = 0; i < buffer.queries.size(); ++i)
+    {
+      const size_t query = mapQueries ? queryMapping[buffer.queries[i]] :
+          buffer.queries[i];
+      const size_t position = next[query]++;
+
+      neighbors[position] = mapReferences ?
+          oldFromNewReferences[buffer.neighbors[i]] : buffer.neighbors[i];
+      distances[position] = buffer.distances[i];
+    }
+
+    buffers.pop_front();
+  }
+}
+
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Count(const math::Range& range,
+                                              arma::Col<size_t>& counts)
+{
+  Timer::Start("range_search/computing_neighbors");
+  statistics.StartPhase("traversal");
+
+  // Set size of prunes to 0.
+  numPrunes = 0;
+
+  // Each query point is only handled by one thread, so the threads of a
+  // single-tree search can all count into the same vector.
+  arma::Col<size_t> treeCounts(querySet.n_cols);
+  treeCounts.zeros();
+
+  typedef RangeSearchRules<MetricType, TreeType> RuleType;
+  RuleType rules(referenceSet, querySet, range, treeCounts, metric);
+
+  Traverse(rules, NULL);
+
+  statistics += rules.Statistics();
+
+  statistics.StopPhase("traversal");
+  Timer::Stop("range_search/computing_neighbors");
+
+  // Output number of prunes.
+  Log::Info << "Number of pruned nodes during computation: " << numPrunes
+      << "." << std::endl;
+
+  // Map the counts back to the original query indices, if necessary; as in
+  // Search(), the query points are not rearranged during single-tree search
+  // with a separate query set.
+  if (!treeOwner || !tree::TreeTraits<TreeType>::RearrangesDataset ||
+      (hasQuerySet && singleMode))
+  {
+    counts.swap(treeCounts);
+    return;
+  }
+
+  const std::vector<size_t>& queryMapping = hasQuerySet ? oldFromNewQueries :
+      oldFromNewReferences;
+  counts.set_size(querySet.n_cols);
+  for (size_t i = 0; i < treeCounts.n_elem; ++i)
+    counts[queryMapping[i]] = treeCounts[i];
+}
+
+template<typename MetricType, typename TreeType>
+void RangeSearch<MetricType, TreeType>::Traverse(
+    RangeSearchRules<MetricType, TreeType>& rules,
+    std::list<RangeSearchBuffer>* threadBuffers)
+{
+  typedef RangeSearchRules<MetricType, TreeType> RuleType;
+
+  if (naive)
+  {
+    // The naive brute-force solution.
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      for (size_t j = 0; j < referenceSet.n_cols; ++j)
+        rules.BaseCase(i, j);
+  }
+  else if (singleMode)
+  {
+    // Visit the query points along the Hilbert curve, if requested, so that
+    // consecutive query points reach the same parts of the reference tree.
+    // The results are kept by query index, so their order does not change.
+    std::vector<size_t> order;
+    if (reorderQueries)
+      tree::HilbertOrder(querySet, order);
+
+    // The query points are independent, so we can split them across threads.
+    // Each thread gets its own copy of the rules and its own traverser, and
+    // each query point only writes to its own result vectors (or each thread
+    // to its own buffer), so no locking is necessary.
+    #pragma omp parallel num_threads(numThreads)
+    {
+      RuleType threadRules(rules);
+      RangeSearchBuffer threadBuffer;
+      if (threadBuffers)
+        threadRules.Buffer() = &threadBuffer;
+
+      // Trees with self-children cache per-query base case results in the
+      // statistics of the reference nodes, so each thread must use its own
+      // copy of the reference tree (this does not copy the dataset).
+      TreeType* threadTree = referenceTree;
+      if (tree::TreeTraits<TreeType>::HasSelfChildren && numThreads > 1)
+        threadTree = new TreeType(*referenceTree);
+
+      // Create the traverser.
+      typename TreeType::template SingleTreeTraverser<RuleType>
+          traverser(threadRules);
+
+      // Now have it traverse for each point.
+      #pragma omp for schedule(dynamic, 16)
+      for (size_t i = 0; i < querySet.n_cols; ++i)
+        traverser.Traverse(order.empty() ? i : order[i], *threadTree);
+
+      if (threadTree != referenceTree)
+        delete threadTree;
+
+      #pragma omp critical
+      {
+        numPrunes += traverser.NumPrunes();
+        rules.Statistics() += threadRules.Statistics();
+
+        // Hand the results over without copying them.
+        if (threadBuffers)
+        {
+          threadBuffers->push_back(RangeSearchBuffer());
+          threadBuffers->back().queries.swap(threadBuffer.queries);
+          threadBuffers->back().neighbors.swap(threadBuffer.neighbors);
+          threadBuffers->back().distances.swap(threadBuffer.distances);
+        }
+      }
+    }
+  }
+  else if (!hasQuerySet && !tree::TreeTraits<TreeType>::HasSelfChildren)
+  {
+    // The query set is the reference set, so traverse the tree against itself
+    // and evaluate each distance once, for both points.
+    tree::SymmetricDualTreeTraverser<TreeType, RuleType> traverser(rules);
+
+    traverser.Traverse(*referenceTree);
+
+    numPrunes = traverser.NumPrunes();
+  }
+  else // Dual-tree recursion.
+  {
+    // Create the traverser.
+    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
+
+    traverser.Traverse(*queryTree, *referenceTree);
+
+    numPrunes = traverser.NumPrunes();
+  }
+}
+
 template<typename MetricType, typename TreeType>
 std::string RangeSearch<MetricType, TreeType>::ToString() const
 {
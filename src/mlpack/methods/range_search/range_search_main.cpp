@@ -10,11 +10,14 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 
+#include <mlpack/methods/neighbor_search/search_tuner.hpp>
+
 #include "range_search.hpp"
 
 using namespace std;
 using namespace mlpack;
 using namespace mlpack::range;
+using namespace mlpack::neighbor;
 using namespace mlpack::tree;
 
 // Information about the program itself.
@@ -45,11 +48,18 @@ PROGRAM_INFO("Range Search",
     " resultant CSV-like files may not be loadable by many programs.  However, "
     "at this time a better way to store this non-square result is not known.  "
     "As a result, any output files will be written as CSVs in this manner, "
-    "regardless of the given extension.");
+    "regardless of the given extension."
+    "\n\n"
+    "If --auto is given, the search is chosen automatically: each of naive "
+    "search and single-tree and dual-tree search with kd-trees of several leaf "
+    "sizes and cover trees is timed on a random sample of --auto_sample_size "
+    "points of each dataset, and the one predicted to be the fastest on the "
+    "whole datasets (given the estimated intrinsic dimension of the reference "
+    "set) is run.  The trials and the choice are printed with --verbose.");
 
 // Define our input parameters that this program will take.
-PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
-    "r");
+PARAM_STRING("reference_file", "File containing the reference dataset (not "
+    "needed if --load_tree is given).", "r", "");
 PARAM_STRING_REQ("distances_file", "File to output distances into.", "d");
 PARAM_STRING_REQ("neighbors_file", "File to output neighbors into.", "n");
 
@@ -64,12 +74,193 @@ PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "s");
 PARAM_FLAG("cover_tree", "If true, use a cover tree for range searching "
     "(instead of a kd-tree).", "c");
+PARAM_STRING("save_tree", "If specified, the kd-tree built on the reference "
+    "set is saved (along with the reordered reference set) to this file, so "
+    "that it can be reused with --load_tree.", "", "");
+PARAM_STRING("load_tree", "If specified, the reference kd-tree and reference "
+    "set are loaded (memory-mapped) from this file, which was written with "
+    "--save_tree, instead of being built from --reference_file.", "", "");
+PARAM_FLAG("auto", "If true, choose between --naive, --single_mode, "
+    "--cover_tree, and --leaf_size automatically, from timed trials on a "
+    "sample of the data.", "");
+PARAM_INT("auto_sample_size", "Number of points of each dataset used for the "
+    "trials of --auto.", "", 2000);
 
 typedef RangeSearch<> RSType;
+typedef BinarySpaceTree<bound::HRectBound<2>, RangeSearchStat> KDTreeType;
 typedef CoverTree<metric::EuclideanDistance, tree::FirstPointIsRoot,
     RangeSearchStat> CoverTreeType;
 typedef RangeSearch<metric::EuclideanDistance, CoverTreeType> RSCoverType;
 
+//! Build a kd-tree for a trial of --auto.
+void BuildTree(arma::mat& data, const size_t leafSize, KDTreeType*& tree)
+{
+  std::vector<size_t> oldFromNew;
+  tree = new KDTreeType(data, oldFromNew, leafSize);
+}
+
+//! Build a cover tree for a trial of --auto.
+void BuildTree(arma::mat& data, const size_t /* leafSize */,
+               CoverTreeType*& tree)
+{
+  tree = new CoverTreeType(data);
+}
+
+/**
+ * Runs the candidates of --auto (see SearchTuner): each candidate finds the
+ * points in the range, with the same options as the full search will.
+ */
+class RangeTrial
+{
+ public:
+  RangeTrial(const math::Range& range, const size_t numThreads) :
+      range(range), numThreads(numThreads) { }
+
+  void Run(const SearchCandidate& candidate,
+           const arma::mat& referenceSet,
+           const arma::mat* querySet,
+           double& buildTime,
+           double& searchTime)
+  {
+    switch (candidate.Type())
+    {
+      case SearchCandidate::NAIVE:
+      {
+        buildTime = 0.0;
+        arma::wall_clock timer;
+        timer.tic();
+        arma::Col<size_t> offsets, neighbors;
+        arma::vec distances;
+        if (querySet)
+        {
+          RSType rangeSearch(referenceSet, *querySet, true);
+          rangeSearch.Search(range, offsets, neighbors, distances);
+        }
+        else
+        {
+          RSType rangeSearch(referenceSet, true);
+          rangeSearch.Search(range, offsets, neighbors, distances);
+        }
+        searchTime = timer.toc();
+        break;
+      }
+      case SearchCandidate::KD_TREE:
+        RunTrees<KDTreeType>(candidate, referenceSet, querySet,
+            buildTime, searchTime);
+        break;
+      case SearchCandidate::COVER_TREE:
+        RunTrees<CoverTreeType>(candidate, referenceSet, querySet,
+            buildTime, searchTime);
+        break;
+      default:
+        Log::Fatal << "RangeTrial::Run(): unsupported candidate "
+            << candidate.ToString() << "!" << endl;
+    }
+  }
+
+ private:
+  //! Run a candidate with the given type of tree.
+  template<typename TreeType>
+  void RunTrees(const SearchCandidate& candidate,
+                const arma::mat& referenceSet,
+                const arma::mat* querySet,
+                double& buildTime,
+                double& searchTime)
+  {
+    typedef RangeSearch<metric::EuclideanDistance, TreeType> SearchType;
+
+    // Some trees rearrange the points they are built on.
+    arma::mat referenceCopy(referenceSet);
+    arma::mat queryCopy;
+    if (querySet)
+      queryCopy = *querySet;
+
+    arma::wall_clock timer;
+    timer.tic();
+    TreeType* referenceTree = NULL;
+    TreeType* queryTree = NULL;
+    BuildTree(referenceCopy, candidate.LeafSize(), referenceTree);
+    if (querySet && !candidate.SingleMode())
+      BuildTree(queryCopy, candidate.LeafSize(), queryTree);
+    buildTime = timer.toc();
+
+    timer.tic();
+    SearchType* search = (querySet) ? new SearchType(referenceTree, queryTree,
+        referenceTree->Dataset(), (queryTree) ? queryTree->Dataset() :
+        queryCopy, candidate.SingleMode()) :
+        new SearchType(referenceTree, referenceTree->Dataset(),
+        candidate.SingleMode());
+    search->NumThreads() = numThreads;
+
+    arma::Col<size_t> offsets, neighbors;
+    arma::vec distances;
+    search->Search(range, offsets, neighbors, distances);
+    searchTime = timer.toc();
+
+    delete search;
+    delete queryTree;
+    delete referenceTree;
+  }
+
+  //! The range to search in.
+  math::Range range;
+  //! The number of threads to search with.
+  size_t numThreads;
+};
+
+/**
+ * Write the results to a file, one line per query point, as comma-separated
+ * values.  Because sometimes 0 points may be found for a query point, lines may
+ * be empty.
+ *
+ * @param filename File to write to.
+ * @param description What the values are (for the warning if the file cannot
+ *      be opened).
+ * @param offsets Offset of the results of each row, as given by
+ *      RangeSearch::Search().
+ * @param values Values of the results.
+ * @param newFromOldQueries Row holding each query point; if empty, row i holds
+ *      query point i.
+ * @param valueMapping Mapping applied to each value before it is written; if
+ *      empty, the values are written as they are.
+ */
+template<typename eT>
+void SaveResults(const string& filename,
+                 const string& description,
+                 const arma::Col<size_t>& offsets,
+                 const arma::Col<eT>& values,
+                 const vector<size_t>& newFromOldQueries,
+                 const vector<size_t>& valueMapping)
+{
+  fstream stream(filename.c_str(), fstream::out);
+  if (!stream.is_open())
+  {
+    Log::Warn << "Cannot open file '" << filename << "' to save output "
+        << description << " to!" << endl;
+    return;
+  }
+
+  // Loop over each point.
+  for (size_t i = 0; i + 1 < offsets.n_elem; ++i)
+  {
+    const size_t row = newFromOldQueries.empty() ? i : newFromOldQueries[i];
+    for (size_t j = offsets[row]; j < offsets[row + 1]; ++j)
+    {
+      if (j != offsets[row])
+        stream << ", ";
+
+      if (valueMapping.empty())
+        stream << values[j];
+      else
+        stream << valueMapping[(size_t) values[j]];
+    }
+
+    stream << endl;
+  }
+
+  stream.close();
+}
+
 int main(int argc, char *argv[])
 {
   // Give CLI the command line parameters the user passed in.
@@ -77,6 +268,8 @@ int main(int argc, char *argv[])
 
   // Get all the parameters.
   string referenceFile = CLI::GetParam<string>("reference_file");
+  const string saveTreeFile = CLI::GetParam<string>("save_tree");
+  const string loadTreeFile = CLI::GetParam<string>("load_tree");
 
   string distancesFile = CLI::GetParam<string>("distances_file");
   string neighborsFile = CLI::GetParam<string>("neighbors_file");
@@ -86,16 +279,77 @@ int main(int argc, char *argv[])
   double max = CLI::GetParam<double>("max");
   double min = CLI::GetParam<double>("min");
 
-  const bool naive = CLI::HasParam("naive");
-  const bool singleMode = CLI::HasParam("single_mode");
+  bool naive = CLI::HasParam("naive");
+  bool singleMode = CLI::HasParam("single_mode");
   bool coverTree = CLI::HasParam("cover_tree");
+  const bool autoSelect = CLI::HasParam("auto");
+
+  // Saved trees are kd-trees built on the reference set as it is given.
+  if ((saveTreeFile != "" || loadTreeFile != "") && (naive || coverTree))
+  {
+    Log::Fatal << "--save_tree and --load_tree can't be used with --naive or "
+        << "--cover_tree." << endl;
+  }
+
+  // The trials of --auto may not pick a kd-tree.
+  if (autoSelect && (saveTreeFile != "" || loadTreeFile != ""))
+  {
+    Log::Fatal << "--auto can't be used with --save_tree or --load_tree."
+        << endl;
+  }
+  if (autoSelect && CLI::GetParam<int>("auto_sample_size") < 20)
+  {
+    Log::Fatal << "Invalid auto sample size: "
+        << CLI::GetParam<int>("auto_sample_size") << ".  Must be at least 20."
+        << endl;
+  }
+  if (autoSelect && (naive || singleMode || coverTree ||
+      CLI::HasParam("leaf_size")))
+  {
+    Log::Warn << "--naive, --single_mode, --cover_tree, and --leaf_size "
+        << "ignored because --auto is present." << endl;
+    naive = singleMode = coverTree = false;
+  }
 
   arma::mat referenceData;
   arma::mat queryData; // So it doesn't go out of scope.
-  if (!data::Load(referenceFile, referenceData))
-    Log::Fatal << "Reference file " << referenceFile << "not found." << endl;
 
-  Log::Info << "Loaded reference data from '" << referenceFile << "'." << endl;
+  // If the reference tree is loaded from a file, the reference set is held by
+  // the MappedTree object.
+  MappedTree<KDTreeType>* mappedTree = NULL;
+  if (loadTreeFile != "")
+  {
+    if (referenceFile != "")
+      Log::Warn << "--reference_file ignored because --load_tree is present."
+          << endl;
+
+    Timer::Start("tree_loading");
+    mappedTree = new MappedTree<KDTreeType>(loadTreeFile);
+    Timer::Stop("tree_loading");
+
+    Log::Info << "Loaded reference tree and data from '" << loadTreeFile
+        << "'." << endl;
+  }
+  else if (referenceFile != "")
+  {
+    if (!data::Load(referenceFile, referenceData))
+      Log::Fatal << "Reference file " << referenceFile << "not found." << endl;
+
+    Log::Info << "Loaded reference data from '" << referenceFile << "'."
+        << endl;
+  }
+  else
+  {
+    Log::Fatal << "Either --reference_file or --load_tree must be specified."
+        << endl;
+  }
+
+  const string queryFile = CLI::GetParam<string>("query_file");
+  if (queryFile != "")
+  {
+    data::Load(queryFile, queryData, true);
+    Log::Info << "Loaded query data from '" << queryFile << "'." << endl;
+  }
 
   // Sanity check on range value: max must be greater than min.
   if (max <= min)
@@ -112,12 +366,39 @@ int main(int argc, char *argv[])
   }
   size_t leafSize = lsInt;
 
+  // The search is only run with several threads if the global --threads
+  // option is given (which sets the number of OpenMP threads).
+  const size_t numThreads = CLI::HasParam("threads") ? util::NumThreads() : 1;
+
+  if (numThreads > 1 && !singleMode)
+  {
+    Log::Warn << "--threads ignored because it is only used for single-tree "
+        << "search." << endl;
+  }
+
   // Naive mode overrides single mode.
   if (singleMode && naive)
   {
     Log::Warn << "--single_mode ignored because --naive is present." << endl;
   }
 
+  // Pick the search with timed trials on a sample of the points.
+  if (autoSelect)
+  {
+    Timer::Start("auto_selection");
+    SearchTuner tuner(referenceData, queryData,
+        (size_t) CLI::GetParam<int>("auto_sample_size"));
+    RangeTrial trial(math::Range(min, max), numThreads);
+    const vector<SearchCandidate> candidates = tuner.Candidates(false);
+    const SearchCandidate& best = candidates[tuner.Select(trial, candidates)];
+    Timer::Stop("auto_selection");
+
+    naive = (best.Type() == SearchCandidate::NAIVE);
+    singleMode = best.SingleMode();
+    coverTree = (best.Type() == SearchCandidate::COVER_TREE);
+    leafSize = best.LeafSize();
+  }
+
   if (naive)
     leafSize = referenceData.n_cols;
 
@@ -127,8 +408,18 @@ int main(int argc, char *argv[])
     coverTree = false;
   }
 
-  vector<vector<size_t> > neighbors;
-  vector<vector<double> > distances;
+  // The results are kept in compressed sparse row format (see
+  // RangeSearch::Search()) and each line of the output is streamed straight
+  // from it, so no per-point vectors are ever allocated.
+  arma::Col<size_t> offsets;
+  arma::Col<size_t> neighbors;
+  arma::vec distances;
+
+  // The row of the results that holds each query point (in its original
+  // order), and the original index of each reference point.  These are empty
+  // if the trees do not rearrange the points.
+  vector<size_t> newFromOldQueries;
+  vector<size_t> oldFromNewRefs;
 
   // The cover tree implies different types, so we must split this section.
   if (coverTree)
@@ -141,7 +432,7 @@ int main(int argc, char *argv[])
     CoverTreeType referenceTree(referenceData);
     CoverTreeType* queryTree = NULL;
 
-    if (CLI::GetParam<string>("query_file") == "")
+    if (queryFile == "")
     {
       // Single dataset.
       rangeSearch = new RSCoverType(&referenceTree, referenceData, singleMode);
@@ -149,8 +440,6 @@ int main(int argc, char *argv[])
     else
     {
       // Two datasets.
-      const string queryFile = CLI::GetParam<string>("query_file");
-      data::Load(queryFile, queryData, true);
       queryTree = new CoverTreeType(queryData);
 
       rangeSearch = new RSCoverType(&referenceTree, queryTree, referenceData,
@@ -160,7 +449,9 @@ int main(int argc, char *argv[])
     Log::Info << "Trees built." << endl;
 
     const math::Range r(min, max);
-    rangeSearch->Search(r, neighbors, distances);
+    rangeSearch->NumThreads() = numThreads;
+    rangeSearch->Search(r, offsets, neighbors, distances);
+    rangeSearch->Statistics().Print();
 
     if (queryTree)
       delete queryTree;
@@ -171,52 +462,60 @@ int main(int argc, char *argv[])
     // Because we may construct it differently, we need a pointer.
     RSType* rangeSearch = NULL;
 
-    // Mappings for when we build the tree.
-    vector<size_t> oldFromNewRefs;
-
     // Build trees by hand, so we can save memory: if we pass a tree to
-    // NeighborSearch, it does not copy the matrix.
-    Log::Info << "Building reference tree..." << endl;
-    Timer::Start("tree_building");
+    // NeighborSearch, it does not copy the matrix.  A loaded reference tree can
+    // be used directly.
+    KDTreeType* refTree = NULL;
+    if (mappedTree)
+    {
+      refTree = &mappedTree->Tree();
+      oldFromNewRefs = mappedTree->OldFromNew();
+    }
+    else
+    {
+      Log::Info << "Building reference tree..." << endl;
+      Timer::Start("tree_building");
+
+      refTree = new KDTreeType(referenceData, oldFromNewRefs, leafSize);
+
+      Timer::Stop("tree_building");
+    }
 
-    BinarySpaceTree<bound::HRectBound<2>, RangeSearchStat>
-        refTree(referenceData, oldFromNewRefs, leafSize);
-    BinarySpaceTree<bound::HRectBound<2>, RangeSearchStat>*
-        queryTree = NULL; // Empty for now.
+    if (saveTreeFile != "" &&
+        MappedTree<KDTreeType>::Save(saveTreeFile, *refTree, oldFromNewRefs))
+      Log::Info << "Saved reference tree to '" << saveTreeFile << "'."
+          << endl;
 
-    Timer::Stop("tree_building");
+    KDTreeType* queryTree = NULL; // Empty for now.
 
     vector<size_t> oldFromNewQueries;
 
-    if (CLI::GetParam<string>("query_file") != "")
+    if (queryFile != "")
     {
-      const string queryFile = CLI::GetParam<string>("query_file");
-      data::Load(queryFile, queryData, true);
-
       if (naive && leafSize < queryData.n_cols)
         leafSize = queryData.n_cols;
 
-      Log::Info << "Loaded query data from '" << queryFile << "'." << endl;
-
       Log::Info << "Building query tree..." << endl;
 
       // Build trees by hand, so we can save memory: if we pass a tree to
       // NeighborSearch, it does not copy the matrix.
       Timer::Start("tree_building");
 
-      queryTree = new BinarySpaceTree<bound::HRectBound<2>,
-          RangeSearchStat>(queryData, oldFromNewQueries, leafSize);
+      queryTree = new KDTreeType(queryData, oldFromNewQueries, leafSize);
 
       Timer::Stop("tree_building");
 
-      rangeSearch = new RSType(&refTree, queryTree, referenceData, queryData,
-          singleMode);
+      rangeSearch = new RSType(refTree, queryTree, refTree->Dataset(),
+          queryData, singleMode);
 
       Log::Info << "Tree built." << endl;
     }
     else
     {
-      rangeSearch = new RSType(&refTree, referenceData, singleMode);
+      rangeSearch = new RSType(refTree, refTree->Dataset(), singleMode);
+
+      // The query points are the reference points.
+      oldFromNewQueries = oldFromNewRefs;
 
       Log::Info << "Trees built." << endl;
     }
@@ -224,113 +523,33 @@ int main(int argc, char *argv[])
     Log::Info << "Computing neighbors within range [" << min << ", " << max
         << "]." << endl;
 
-    // Collect the results in these vectors before remapping.
-    vector<vector<double> > distancesOut;
-    vector<vector<size_t> > neighborsOut;
-
     const math::Range r(min, max);
-    rangeSearch->Search(r, neighborsOut, distancesOut);
+    rangeSearch->NumThreads() = numThreads;
+    rangeSearch->Search(r, offsets, neighbors, distances);
 
     Log::Info << "Neighbors computed." << endl;
+    rangeSearch->Statistics().Print();
 
-    // We have to map back to the original indices from before the tree
-    // construction.
-    Log::Info << "Re-mapping indices..." << endl;
-
-    distances.resize(distancesOut.size());
-    neighbors.resize(neighborsOut.size());
-
-    // Do the actual remapping.
-    if (CLI::GetParam<string>("query_file") != "")
-    {
-      for (size_t i = 0; i < distances.size(); ++i)
-      {
-        // Map distances (copy a column).
-        distances[oldFromNewQueries[i]] = distancesOut[i];
-
-        // Map indices of neighbors.
-        neighbors[oldFromNewQueries[i]].resize(neighborsOut[i].size());
-        for (size_t j = 0; j < distancesOut[i].size(); ++j)
-        {
-          neighbors[oldFromNewQueries[i]][j] =
-              oldFromNewRefs[neighborsOut[i][j]];
-        }
-      }
-    }
-    else
-    {
-      for (size_t i = 0; i < distances.size(); ++i)
-      {
-        // Map distances (copy a column).
-        distances[oldFromNewRefs[i]] = distancesOut[i];
-
-        // Map indices of neighbors.
-        neighbors[oldFromNewRefs[i]].resize(neighborsOut[i].size());
-        for (size_t j = 0; j < distancesOut[i].size(); ++j)
-        {
-          neighbors[oldFromNewRefs[i]][j] = oldFromNewRefs[neighborsOut[i][j]];
-        }
-      }
-    }
+    // Rather than rearranging the results, we write the rows in the original
+    // order of the query points, mapping the neighbors as they are written.
+    newFromOldQueries.resize(oldFromNewQueries.size());
+    for (size_t i = 0; i < oldFromNewQueries.size(); ++i)
+      newFromOldQueries[oldFromNewQueries[i]] = i;
 
     // Clean up.
     if (queryTree)
       delete queryTree;
     delete rangeSearch;
-  }
-
-  // Save output.  We have to do this by hand.
-  fstream distancesStr(distancesFile.c_str(), fstream::out);
-  if (!distancesStr.is_open())
-  {
-    Log::Warn << "Cannot open file '" << distancesFile << "' to save output "
-        << "distances to!" << endl;
-  }
-  else
-  {
-    // Loop over each point.
-    for (size_t i = 0; i < distances.size(); ++i)
-    {
-      // Store the distances of each point.  We may have 0 points to store, so
-      // we must account for that possibility.
-      for (size_t j = 0; j + 1 < distances[i].size(); ++j)
-      {
-        distancesStr << distances[i][j] << ", ";
-      }
-
-      if (distances[i].size() > 0)
-        distancesStr << distances[i][distances[i].size() - 1];
 
-      distancesStr << endl;
-    }
-
-    distancesStr.close();
-  }
-
-  fstream neighborsStr(neighborsFile.c_str(), fstream::out);
-  if (!neighborsStr.is_open())
-  {
-    Log::Warn << "Cannot open file '" << neighborsFile << "' to save output "
-        << "neighbor indices to!" << endl;
+    if (mappedTree)
+      delete mappedTree;
+    else
+      delete refTree;
   }
-  else
-  {
-    // Loop over each point.
-    for (size_t i = 0; i < neighbors.size(); ++i)
-    {
-      // Store the neighbors of each point.  We may have 0 points to store, so
-      // we must account for that possibility.
-      for (size_t j = 0; j + 1 < neighbors[i].size(); ++j)
-      {
-        neighborsStr << neighbors[i][j] << ", ";
-      }
-
-      if (neighbors[i].size() > 0)
-        neighborsStr << neighbors[i][neighbors[i].size() - 1];
 
-      neighborsStr << endl;
-    }
-
-    neighborsStr.close();
-  }
+  // Save output.  We have to do this by hand.
+  SaveResults(distancesFile, "distances", offsets, distances,
+      newFromOldQueries, vector<size_t>());
+  SaveResults(neighborsFile, "neighbor indices", offsets, neighbors,
+      newFromOldQueries, oldFromNewRefs);
 }
@@ -7,11 +7,30 @@
 #ifndef __MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_RULES_HPP
 #define __MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_RULES_HPP
 
+#include <mlpack/core/tree/leaf_block_distances.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
 #include "../neighbor_search/ns_traversal_info.hpp"
 
 namespace mlpack {
 namespace range {
 
+/**
+ * A flat buffer of range search results: result i is the reference point
+ * neighbors[i], at distance distances[i] from the query point queries[i].
+ * Results are appended in the order they are found, so one buffer per thread
+ * can be filled without any locking, and the buffers can be merged into a
+ * compressed sparse row structure afterwards (see RangeSearch::Search()).
+ */
+struct RangeSearchBuffer
+{
+  //! The query point of each result.
+  std::vector<size_t> queries;
+  //! The reference point of each result.
+  std::vector<size_t> neighbors;
+  //! The distance of each result.
+  std::vector<double> distances;
+};
 
 template<typename MetricType, typename TreeType>
 class RangeSearchRules
@@ -28,13 +47,47 @@ class RangeSearchRules
    * @param distances Vector to store resulting distances in.
    * @param metric Instantiated metric.
    */
-  RangeSearchRules(const arma::mat& referenceSet,
-                   const arma::mat& querySet,
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
                    const math::Range& range,
                    std::vector<std::vector<size_t> >& neighbors,
                    std::vector<std::vector<double> >& distances,
                    MetricType& metric);
 
+  /**
+   * Construct the RangeSearchRules object so that results are appended to the
+   * given buffer instead of being stored per query point.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param buffer Buffer to append results to.
+   * @param metric Instantiated metric.
+   */
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
+                   const math::Range& range,
+                   RangeSearchBuffer& buffer,
+                   MetricType& metric);
+
+  /**
+   * Construct the RangeSearchRules object so that only the number of results
+   * of each query point is kept.  Reference nodes that are entirely inside the
+   * range are then counted with NumDescendants(), without computing any of
+   * their distances.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param counts Vector to add the number of results of each query point to.
+   * @param metric Instantiated metric.
+   */
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
+                   const math::Range& range,
+                   arma::Col<size_t>& counts,
+                   MetricType& metric);
+
   /**
    * Compute the base case between the given query point and reference point.
    *
@@ -43,6 +96,21 @@ class RangeSearchRules
    */
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Compute the base cases between the given points of the query leaf (those
+   * that Score() did not prune) and every point in the reference leaf at once,
+   * if the metric allows it (see metric::BlockDistances()).  If it does not,
+   * nothing is done and false is returned.
+   *
+   * @param queryNode Query leaf.
+   * @param queryPoints Offsets in the query leaf of the points to compute.
+   * @param referenceNode Reference leaf.
+   * @return true if the base cases were computed.
+   */
+  bool BaseCases(TreeType& queryNode,
+                 const std::vector<size_t>& queryPoints,
+                 TreeType& referenceNode);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -93,26 +161,80 @@ class RangeSearchRules
                  TreeType& referenceNode,
                  const double oldScore) const;
 
+  /**
+   * Compute the base case between two distinct points of a monochromatic
+   * search, and add each point to the results of the other if it is in range;
+   * this is used by tree::SymmetricDualTreeTraverser, which visits each pair of
+   * points once.
+   *
+   * @param indexA Index of the first point.
+   * @param indexB Index of the second point.
+   */
+  double SymmetricBaseCase(const size_t indexA, const size_t indexB);
+
+  /**
+   * Score a pair of distinct nodes of a monochromatic search.  If every pair of
+   * points of the two nodes is in range, the results are added for both nodes
+   * and the pair is pruned.
+   *
+   * @param nodeA First node.
+   * @param nodeB Second node.
+   */
+  double SymmetricScore(TreeType& nodeA, TreeType& nodeB);
+
+  /**
+   * Re-evaluate the score of a pair of distinct nodes of a monochromatic
+   * search.  Nothing changes during range search, so this is the old score.
+   *
+   * @param nodeA First node.
+   * @param nodeB Second node.
+   * @param oldScore Old score produced by SymmetricScore().
+   */
+  double SymmetricRescore(TreeType& nodeA,
+                          TreeType& nodeB,
+                          const double oldScore) const;
+
   typedef neighbor::NeighborSearchTraversalInfo<TreeType> TraversalInfoType;
 
   const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
   TraversalInfoType& TraversalInfo() { return traversalInfo; }
 
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+  //! Get the buffer results are appended to (NULL if they are stored in the
+  //! neighbors and distances vectors).
+  RangeSearchBuffer* Buffer() const { return buffer; }
+  //! Modify the buffer results are appended to.  This is how each thread of a
+  //! parallel search is given its own buffer.
+  RangeSearchBuffer*& Buffer() { return buffer; }
+
  private:
   //! The reference set.
-  const arma::mat& referenceSet;
+  const typename TreeType::Mat& referenceSet;
 
   //! The query set.
-  const arma::mat& querySet;
+  const typename TreeType::Mat& querySet;
 
   //! The range of distances for which we are searching.
   const math::Range& range;
 
-  //! The vector the resultant neighbor indices should be stored in.
-  std::vector<std::vector<size_t> >& neighbors;
+  //! The vector the resultant neighbor indices should be stored in (NULL if
+  //! results are appended to a buffer).
+  std::vector<std::vector<size_t> >* neighbors;
+
+  //! The vector the resultant neighbor distances should be stored in (NULL if
+  //! results are appended to a buffer).
+  std::vector<std::vector<double> >* distances;
+
+  //! The buffer results are appended to, if not NULL.
+  RangeSearchBuffer* buffer;
 
-  //! The vector the resultant neighbor distances should be stored in.
-  std::vector<std::vector<double> >& distances;
+  //! The number of results of each query point, if only results are counted
+  //! (NULL otherwise).
+  arma::Col<size_t>* counts;
 
   //! The instantiated metric.
   MetricType& metric;
@@ -128,7 +250,16 @@ class RangeSearchRules
   void AddResult(const size_t queryIndex,
                  TreeType& referenceNode);
 
+  //! Store a single result, either in the buffer or in the neighbors and
+  //! distances vectors.
+  void AddResult(const size_t queryIndex,
+                 const size_t referenceIndex,
+                 const double distance);
+
   TraversalInfoType traversalInfo;
+
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
 };
 
 }; // namespace range
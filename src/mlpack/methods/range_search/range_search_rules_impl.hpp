@@ -15,8 +15,8 @@ namespace range {
 
 template<typename MetricType, typename TreeType>
 RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
-    const arma::mat& referenceSet,
-    const arma::mat& querySet,
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
     const math::Range& range,
     std::vector<std::vector<size_t> >& neighbors,
     std::vector<std::vector<double> >& distances,
@@ -24,8 +24,52 @@ RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
     referenceSet(referenceSet),
     querySet(querySet),
     range(range),
-    neighbors(neighbors),
-    distances(distances),
+    neighbors(&neighbors),
+    distances(&distances),
+    buffer(NULL),
+    counts(NULL),
+    metric(metric),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType>
+RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const math::Range& range,
+    RangeSearchBuffer& buffer,
+    MetricType& metric) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    buffer(&buffer),
+    counts(NULL),
+    metric(metric),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType>
+RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const math::Range& range,
+    arma::Col<size_t>& counts,
+    MetricType& metric) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    buffer(NULL),
+    counts(&counts),
     metric(metric),
     lastQueryIndex(querySet.n_cols),
     lastReferenceIndex(referenceSet.n_cols)
@@ -51,18 +95,56 @@ double RangeSearchRules<MetricType, TreeType>::BaseCase(
 
   const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
       referenceSet.unsafe_col(referenceIndex));
+  ++statistics.BaseCases();
 
   // Update last indices, so we don't accidentally perform a base case twice.
   lastQueryIndex = queryIndex;
   lastReferenceIndex = referenceIndex;
 
   if (range.Contains(distance))
+    AddResult(queryIndex, referenceIndex, distance);
+
+  return distance;
+}
+
+//! Batched base cases between two leaves.
+template<typename MetricType, typename TreeType>
+bool RangeSearchRules<MetricType, TreeType>::BaseCases(
+    TreeType& queryNode,
+    const std::vector<size_t>& queryPoints,
+    TreeType& referenceNode)
+{
+  if (queryPoints.empty() || referenceNode.NumPoints() == 0)
+    return false;
+
+  // blockDistances(i, k) is the distance between the i'th reference point and
+  // the query point queryPoints[k].
+  arma::mat blockDistances;
+  if (!tree::LeafBlockDistances(metric, referenceSet, referenceNode, querySet,
+      queryNode, queryPoints, blockDistances))
+    return false;
+
+  for (size_t k = 0; k < queryPoints.size(); ++k)
   {
-    neighbors[queryIndex].push_back(referenceIndex);
-    distances[queryIndex].push_back(distance);
+    const size_t queryIndex = queryNode.Point(queryPoints[k]);
+    for (size_t i = 0; i < referenceNode.NumPoints(); ++i)
+    {
+      // Don't return the point as in its own range.
+      const size_t referenceIndex = referenceNode.Point(i);
+      if ((&referenceSet == &querySet) && (queryIndex == referenceIndex))
+        continue;
+
+      ++statistics.BaseCases();
+      if (range.Contains(blockDistances(i, k)))
+        AddResult(queryIndex, referenceIndex, blockDistances(i, k));
+
+      // Keep the last indices of BaseCase() up to date.
+      lastQueryIndex = queryIndex;
+      lastReferenceIndex = referenceIndex;
+    }
   }
 
-  return distance;
+  return true;
 }
 
 //! Single-tree scoring function.
@@ -109,19 +191,21 @@ double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
 
   // If the ranges do not overlap, prune this node.
   if (!distances.Contains(range))
-    return DBL_MAX;
+    return statistics.Score(DBL_MAX, referenceNode);
 
   // In this case, all of the points in the reference node will be part of the
   // results.
   if ((distances.Lo() >= range.Lo()) && (distances.Hi() <= range.Hi()))
   {
     AddResult(queryIndex, referenceNode);
-    return DBL_MAX; // We don't need to go any deeper.
+
+    // We don't need to go any deeper.
+    return statistics.Score(DBL_MAX, referenceNode);
   }
 
   // Otherwise the score doesn't matter.  Recursion order is irrelevant in
   // range search.
-  return 0.0;
+  return statistics.Score(0.0, referenceNode);
 }
 
 //! Single-tree rescoring function.
@@ -178,7 +262,7 @@ double RangeSearchRules<MetricType, TreeType>::Score(TreeType& queryNode,
 
   // If the ranges do not overlap, prune this node.
   if (!distances.Contains(range))
-    return DBL_MAX;
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
 
   // In this case, all of the points in the reference node will be part of all
   // the results for each point in the query node.
@@ -186,14 +270,16 @@ double RangeSearchRules<MetricType, TreeType>::Score(TreeType& queryNode,
   {
     for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
       AddResult(queryNode.Descendant(i), referenceNode);
-    return DBL_MAX; // We don't need to go any deeper.
+
+    // We don't need to go any deeper.
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
   }
 
   // Otherwise the score doesn't matter.  Recursion order is irrelevant in range
   // search.
   traversalInfo.LastQueryNode() = &queryNode;
   traversalInfo.LastReferenceNode() = &referenceNode;
-  return 0.0;
+  return statistics.Score(0.0, queryNode, referenceNode);
 }
 
 //! Dual-tree rescoring function.
@@ -207,6 +293,84 @@ double RangeSearchRules<MetricType, TreeType>::Rescore(
   return oldScore;
 }
 
+//! Symmetric base case, for monochromatic searches.
+template<typename MetricType, typename TreeType>
+inline force_inline
+double RangeSearchRules<MetricType, TreeType>::SymmetricBaseCase(
+    const size_t indexA,
+    const size_t indexB)
+{
+  const double distance = metric.Evaluate(querySet.unsafe_col(indexA),
+      referenceSet.unsafe_col(indexB));
+  ++statistics.BaseCases();
+
+  if (range.Contains(distance))
+  {
+    AddResult(indexA, indexB, distance);
+    AddResult(indexB, indexA, distance);
+  }
+
+  return distance;
+}
+
+//! Symmetric scoring function, for monochromatic searches.
+template<typename MetricType, typename TreeType>
+double RangeSearchRules<MetricType, TreeType>::SymmetricScore(TreeType& nodeA,
+                                                              TreeType& nodeB)
+{
+  const math::Range distances = nodeA.RangeDistance(&nodeB);
+
+  // If the ranges do not overlap, prune this pair.
+  if (!distances.Contains(range))
+    return statistics.Score(DBL_MAX, nodeA, nodeB);
+
+  // In this case, every point of each node is in the range of every point of
+  // the other.  The nodes are distinct, so no point is paired with itself.
+  if ((distances.Lo() >= range.Lo()) && (distances.Hi() <= range.Hi()))
+  {
+    if (counts)
+    {
+      for (size_t i = 0; i < nodeA.NumDescendants(); ++i)
+        (*counts)[nodeA.Descendant(i)] += nodeB.NumDescendants();
+      for (size_t j = 0; j < nodeB.NumDescendants(); ++j)
+        (*counts)[nodeB.Descendant(j)] += nodeA.NumDescendants();
+    }
+    else
+    {
+      for (size_t i = 0; i < nodeA.NumDescendants(); ++i)
+      {
+        const size_t indexA = nodeA.Descendant(i);
+        for (size_t j = 0; j < nodeB.NumDescendants(); ++j)
+        {
+          const size_t indexB = nodeB.Descendant(j);
+          const double distance = metric.Evaluate(querySet.unsafe_col(indexA),
+              referenceSet.unsafe_col(indexB));
+
+          AddResult(indexA, indexB, distance);
+          AddResult(indexB, indexA, distance);
+        }
+      }
+    }
+
+    // We don't need to go any deeper.
+    return statistics.Score(DBL_MAX, nodeA, nodeB);
+  }
+
+  // Otherwise the score doesn't matter.
+  return statistics.Score(0.0, nodeA, nodeB);
+}
+
+//! Symmetric rescoring function.
+template<typename MetricType, typename TreeType>
+double RangeSearchRules<MetricType, TreeType>::SymmetricRescore(
+    TreeType& /* nodeA */,
+    TreeType& /* nodeB */,
+    const double oldScore) const
+{
+  // If it wasn't pruned before, it isn't pruned now.
+  return oldScore;
+}
+
 //! Add all the points in the given node to the results for the given query
 //! point.
 template<typename MetricType, typename TreeType>
@@ -224,14 +388,50 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
     baseCaseMod = 1;
   }
 
+  // When counting, every point is in the range, so no distances are needed.
+  if (counts)
+  {
+    size_t count = referenceNode.NumDescendants() - baseCaseMod;
+
+    // The query point is never in its own range, but it can only be in this
+    // node if the range contains a distance of 0.
+    if ((&referenceSet == &querySet) && (range.Lo() <= 0.0))
+    {
+      for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
+      {
+        if (referenceNode.Descendant(i) == queryIndex)
+        {
+          --count;
+          break;
+        }
+      }
+    }
+
+    (*counts)[queryIndex] += count;
+    return;
+  }
+
   // Resize distances and neighbors vectors appropriately.  We have to use
   // reserve() and not resize(), because we don't know if we will encounter the
   // case where the datasets and points are the same (and we skip in that case).
-  const size_t oldSize = neighbors[queryIndex].size();
-  neighbors[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
-  distances[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
+  if (buffer)
+  {
+    const size_t oldSize = buffer->queries.size();
+    buffer->queries.reserve(oldSize + referenceNode.NumDescendants() -
+        baseCaseMod);
+    buffer->neighbors.reserve(oldSize + referenceNode.NumDescendants() -
+        baseCaseMod);
+    buffer->distances.reserve(oldSize + referenceNode.NumDescendants() -
+        baseCaseMod);
+  }
+  else
+  {
+    const size_t oldSize = (*neighbors)[queryIndex].size();
+    (*neighbors)[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
+        baseCaseMod);
+    (*distances)[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
+        baseCaseMod);
+  }
 
   for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
   {
@@ -242,8 +442,32 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
     const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
         referenceNode.Dataset().unsafe_col(referenceNode.Descendant(i)));
 
-    neighbors[queryIndex].push_back(referenceNode.Descendant(i));
-    distances[queryIndex].push_back(distance);
+    AddResult(queryIndex, referenceNode.Descendant(i), distance);
+  }
+}
+
+//! Store a single result.
+template<typename MetricType, typename TreeType>
+inline force_inline
+void RangeSearchRules<MetricType, TreeType>::AddResult(
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double distance)
+{
+  if (counts)
+  {
+    ++(*counts)[queryIndex];
+  }
+  else if (buffer)
+  {
+    buffer->queries.push_back(queryIndex);
+    buffer->neighbors.push_back(referenceIndex);
+    buffer->distances.push_back(distance);
+  }
+  else
+  {
+    (*neighbors)[queryIndex].push_back(referenceIndex);
+    (*distances)[queryIndex].push_back(distance);
   }
 }
 
@@ -0,0 +1,161 @@
+/**
+ * @file window_search.hpp
+ *
+ * Defines the WindowSearch class, which finds the points of a reference set
+ * that are inside given windows (boxes), with a RectangleTree.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include "window_search_stat.hpp"
+#include "window_search_rules.hpp"
+
+namespace mlpack {
+namespace range {
+
+/**
+ * The WindowSearch class answers window queries: for each query window (a
+ * bound::HRectBound), it finds every reference point inside the window,
+ * borders included.  The reference points are indexed by a RectangleTree,
+ * whose nodes are pruned when their bounds do not overlap the window, and
+ * whose points are all taken without checking them when their bounds are
+ * entirely inside it (see WindowSearchRules).
+ *
+ * A batch of windows can be searched at once with a dual-tree traversal: a
+ * RectangleTree is built on the centers of the windows, and each of its nodes
+ * holds the union and the intersection of its windows (see WindowSearchStat),
+ * so a pair of nodes is pruned, or taken whole, for all of its windows at once.
+ * This is the default; in single-tree mode, the reference tree is traversed
+ * once for each window instead.
+ *
+ * @code
+ * extern arma::mat points; // Two-dimensional.
+ * WindowSearch<> search(points);
+ *
+ * bound::HRectBound<> window(2);
+ * window[0] = math::Range(0.0, 1.0);
+ * window[1] = math::Range(-1.0, 1.0);
+ * std::vector<size_t> results;
+ * search.Search(window, results);
+ * @endcode
+ *
+ * @tparam TreeType The tree type to use; a RectangleTree with a
+ *     WindowSearchStat.
+ */
+template<typename TreeType = tree::RectangleTree<
+    tree::RStarTreeSplit<tree::RStarTreeDescentHeuristic, WindowSearchStat,
+        arma::mat>,
+    tree::RStarTreeDescentHeuristic, WindowSearchStat, arma::mat> >
+class WindowSearch
+{
+ public:
+  /**
+   * Initialize the WindowSearch object with the given reference set, which is
+   * copied, and build the reference tree on it (unless search is naive).  The
+   * tree is bulk-loaded.
+   *
+   * @param referenceSet Set of reference points.
+   * @param naive If true, every window is checked against every point.
+   * @param singleMode If true, batches of windows are searched with one
+   *     single-tree traversal for each window, instead of a dual-tree
+   *     traversal.
+   */
+  WindowSearch(const arma::mat& referenceSet,
+               const bool naive = false,
+               const bool singleMode = false);
+
+  /**
+   * Initialize the WindowSearch object with a reference tree that has already
+   * been built (with its own parameters).  The tree is not copied, and it will
+   * not be deleted when this object is destroyed.
+   *
+   * @param referenceTree Pre-built tree on the reference points.
+   * @param singleMode If true, batches of windows are searched with one
+   *     single-tree traversal for each window.
+   */
+  WindowSearch(TreeType* referenceTree, const bool singleMode = false);
+
+  //! Delete the reference tree, if it was built by this object.
+  ~WindowSearch();
+
+  /**
+   * Find the reference points inside the given window, with a single-tree
+   * traversal (unless search is naive).  The results are indices of points in
+   * the reference set, in increasing order.
+   *
+   * @param window The query window.
+   * @param results Vector to store the indices of the points inside it in.
+   */
+  void Search(const bound::HRectBound<>& window, std::vector<size_t>& results);
+
+  /**
+   * Find the reference points inside each of the given windows.  Unless search
+   * is naive or in single-tree mode, a tree is built on the windows and
+   * traversed with the reference tree.  The results of window i are indices of
+   * points in the reference set, in increasing order, and are stored in
+   * results[i].
+   *
+   * @param windows The query windows.
+   * @param results Vector to store the points inside each window in.
+   */
+  void Search(const std::vector<bound::HRectBound<> >& windows,
+              std::vector<std::vector<size_t> >& results);
+
+  //! Get the reference set.
+  const arma::mat& ReferenceSet() const { return referenceSet; }
+  //! Get the reference tree (NULL if search is naive).
+  const TreeType* ReferenceTree() const { return referenceTree; }
+
+  //! Get whether every window is checked against every point.
+  bool Naive() const { return naive; }
+  //! Get whether batches of windows are searched with single-tree traversals.
+  bool SingleMode() const { return singleMode; }
+  //! Modify whether batches of windows are searched with single-tree
+  //! traversals.
+  bool& SingleMode() { return singleMode; }
+
+  //! Get the traversal statistics of tree building and all searches.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of tree building and all searches.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+  // Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! The copy of the reference set, if it was given to the constructor.
+  arma::mat referenceCopy;
+  //! The reference set.
+  const arma::mat& referenceSet;
+
+  //! The tree built on the reference set (NULL if search is naive).
+  TreeType* referenceTree;
+  //! If true, this object built the reference tree and must delete it.
+  bool treeOwner;
+
+  //! If true, every window is checked against every point.
+  bool naive;
+  //! If true, batches are searched with single-tree traversals.
+  bool singleMode;
+
+  //! The traversal statistics of tree building and all searches.
+  tree::TraversalStatistics statistics;
+
+  /**
+   * Set the union and the intersection of the windows in the given node of a
+   * tree built on the window centers, and in its descendants.
+   */
+  static void SetWindowBounds(TreeType& node,
+                              const std::vector<bound::HRectBound<> >& windows);
+};
+
+}; // namespace range
+}; // namespace mlpack
+
+// Include implementation.
+#include "window_search_impl.hpp"
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * @file window_search_impl.hpp
+ *
+ * Implementation of the WindowSearch class.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_IMPL_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "window_search.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace range {
+
+template<typename TreeType>
+WindowSearch<TreeType>::WindowSearch(const arma::mat& referenceSetIn,
+                                     const bool naive,
+                                     const bool singleMode) :
+    referenceCopy(referenceSetIn),
+    referenceSet(referenceCopy),
+    referenceTree(NULL),
+    treeOwner(!naive),
+    naive(naive),
+    singleMode(!naive && singleMode)
+{
+  if (naive)
+    return;
+
+  Timer::Start("window_search/tree_building");
+  statistics.StartPhase("tree_building");
+
+  // Bulk loading gives nearly full nodes with little overlap, which is what
+  // window queries need most.
+  referenceTree = new TreeType(referenceCopy, 20, 8, 5, 2, 0, true);
+
+  statistics.StopPhase("tree_building");
+  Timer::Stop("window_search/tree_building");
+}
+
+template<typename TreeType>
+WindowSearch<TreeType>::WindowSearch(TreeType* referenceTree,
+                                     const bool singleMode) :
+    referenceSet(referenceTree->Dataset()),
+    referenceTree(referenceTree),
+    treeOwner(false),
+    naive(false),
+    singleMode(singleMode)
+{
+  // Nothing to do.
+}
+
+template<typename TreeType>
+WindowSearch<TreeType>::~WindowSearch()
+{
+  if (treeOwner && referenceTree)
+    delete referenceTree;
+}
+
+template<typename TreeType>
+void WindowSearch<TreeType>::Search(const bound::HRectBound<>& window,
+                                    std::vector<size_t>& results)
+{
+  std::vector<bound::HRectBound<> > windows(1, window);
+  std::vector<std::vector<size_t> > windowResults;
+
+  // A single window is always searched with a single-tree traversal.
+  const bool oldSingleMode = singleMode;
+  singleMode = true;
+  Search(windows, windowResults);
+  singleMode = oldSingleMode;
+
+  results.swap(windowResults[0]);
+}
+
+template<typename TreeType>
+void WindowSearch<TreeType>::Search(
+    const std::vector<bound::HRectBound<> >& windows,
+    std::vector<std::vector<size_t> >& results)
+{
+  for (size_t i = 0; i < windows.size(); ++i)
+  {
+    if (windows[i].Dim() != referenceSet.n_rows)
+    {
+      Log::Fatal << "WindowSearch::Search(): window " << i << " has "
+          << windows[i].Dim() << " dimensions, but the reference points have "
+          << referenceSet.n_rows << "!" << std::endl;
+    }
+  }
+
+  results.clear();
+  results.resize(windows.size());
+  if (windows.empty())
+    return;
+
+  Timer::Start("window_search/computing_neighbors");
+  statistics.StartPhase("traversal");
+
+  typedef WindowSearchRules<TreeType> RuleType;
+  RuleType rules(referenceSet, windows, results);
+
+  if (naive)
+  {
+    for (size_t i = 0; i < windows.size(); ++i)
+      for (size_t j = 0; j < referenceSet.n_cols; ++j)
+        rules.BaseCase(i, j);
+  }
+  else if (singleMode)
+  {
+    typename TreeType::template SingleTreeTraverser<RuleType> traverser(rules);
+
+    for (size_t i = 0; i < windows.size(); ++i)
+    {
+      // The traverser does not score the root.
+      if (rules.Score(i, *referenceTree) != DBL_MAX)
+        traverser.Traverse(i, *referenceTree);
+    }
+  }
+  else
+  {
+    // The query tree is built on the centers of the windows, in the same
+    // order, so the indices of its points are the indices of the windows.
+    statistics.StartPhase("tree_building");
+
+    arma::mat centers(referenceSet.n_rows, windows.size());
+    for (size_t i = 0; i < windows.size(); ++i)
+    {
+      arma::vec center;
+      windows[i].Centroid(center);
+      centers.col(i) = center;
+    }
+
+    TreeType queryTree(centers, 20, 8, 5, 2, 0, true);
+    SetWindowBounds(queryTree, windows);
+
+    statistics.StopPhase("tree_building");
+
+    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
+    if (rules.Score(queryTree, *referenceTree) != DBL_MAX)
+      traverser.Traverse(queryTree, *referenceTree);
+  }
+
+  statistics += rules.Statistics();
+
+  // The points are found in the order of the tree.
+  for (size_t i = 0; i < results.size(); ++i)
+    std::sort(results[i].begin(), results[i].end());
+
+  statistics.StopPhase("traversal");
+  Timer::Stop("window_search/computing_neighbors");
+}
+
+template<typename TreeType>
+std::string WindowSearch<TreeType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "WindowSearch [" << this << "]" << std::endl;
+  convert << "  Dimensionality: " << referenceSet.n_rows << std::endl;
+  convert << "  Points: " << referenceSet.n_cols << std::endl;
+  convert << "  Naive: " << naive << std::endl;
+  convert << "  Single mode: " << singleMode << std::endl;
+  return convert.str();
+}
+
+template<typename TreeType>
+void WindowSearch<TreeType>::SetWindowBounds(
+    TreeType& node,
+    const std::vector<bound::HRectBound<> >& windows)
+{
+  const size_t dim = windows[0].Dim();
+  bound::HRectBound<>& windowUnion = node.Stat().Bound();
+  bound::HRectBound<>& common = node.Stat().Common();
+
+  // The union starts empty, and the intersection starts as all of space.
+  windowUnion = bound::HRectBound<>(dim);
+  common = bound::HRectBound<>(dim);
+  for (size_t d = 0; d < dim; ++d)
+    common[d] = math::Range(-DBL_MAX, DBL_MAX);
+
+  std::vector<const bound::HRectBound<>*> parts;
+  if (node.IsLeaf())
+  {
+    for (size_t i = 0; i < node.Count(); ++i)
+    {
+      windowUnion |= windows[node.Points()[i]];
+      parts.push_back(&windows[node.Points()[i]]);
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+    {
+      SetWindowBounds(node.Child(i), windows);
+      windowUnion |= node.Child(i).Stat().Bound();
+      parts.push_back(&node.Child(i).Stat().Common());
+    }
+  }
+
+  for (size_t i = 0; i < parts.size(); ++i)
+  {
+    for (size_t d = 0; d < dim; ++d)
+    {
+      common[d] = math::Range(std::max(common[d].Lo(), (*parts[i])[d].Lo()),
+          std::min(common[d].Hi(), (*parts[i])[d].Hi()));
+    }
+  }
+}
+
+}; // namespace range
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file window_search_rules.hpp
+ *
+ * Rules for window search: the reference points inside each of a set of query
+ * windows (boxes), with a RectangleTree.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_RULES_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_RULES_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_info.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+namespace mlpack {
+namespace range {
+
+/**
+ * The base case and pruning rules for window search.  The queries are windows
+ * (a bound::HRectBound for each), and the results of each window are the
+ * reference points inside it, borders included.  A reference node is pruned
+ * if its bound does not overlap the window (or, for a node of the query tree,
+ * the union of its windows, given by WindowSearchStat::Bound()); if its bound
+ * is entirely inside the window (or inside every window of the query node,
+ * WindowSearchStat::Common()), all of its points are added without any
+ * further checks, and it is pruned too.
+ *
+ * The query indices given to BaseCase() and Score() are indices into the
+ * vector of windows, so a dual-tree traversal must use a query tree built on
+ * the window centers (in the same order), whose statistics have been set.
+ *
+ * @tparam TreeType The tree type (a RectangleTree with a WindowSearchStat).
+ */
+template<typename TreeType>
+class WindowSearchRules
+{
+ public:
+  /**
+   * Construct the rules.
+   *
+   * @param referenceSet Set of reference points.
+   * @param windows The query windows.
+   * @param results Vector to store the reference points inside each window in
+   *     (its size must be the number of windows).
+   */
+  WindowSearchRules(const arma::mat& referenceSet,
+                    const std::vector<bound::HRectBound<> >& windows,
+                    std::vector<std::vector<size_t> >& results);
+
+  //! Add the reference point to the results of the window if it is inside.
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  /**
+   * Get the score for recursion order.  Only 0 (recurse) and DBL_MAX (prune)
+   * are returned, since every point inside the window must be found anyway.
+   *
+   * @param queryIndex Index of the query window.
+   * @param referenceNode Candidate node to be recursed into.
+   */
+  double Score(const size_t queryIndex, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.  Nothing changes during window
+   * search, so this is the old score.
+   */
+  double Rescore(const size_t /* queryIndex */,
+                 TreeType& /* referenceNode */,
+                 const double oldScore) const { return oldScore; }
+
+  /**
+   * Get the score for recursion order of a node combination.  Only 0 (recurse)
+   * and DBL_MAX (prune) are returned.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   */
+  double Score(TreeType& queryNode, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order of a node combination.  Nothing
+   * changes during window search, so this is the old score.
+   */
+  double Rescore(TreeType& /* queryNode */,
+                 TreeType& /* referenceNode */,
+                 const double oldScore) const { return oldScore; }
+
+  //! Return whether the two boxes overlap (borders included).
+  static bool Overlaps(const bound::HRectBound<>& a,
+                       const bound::HRectBound<>& b);
+
+  //! Return whether the inner box is entirely inside the outer box.
+  static bool Within(const bound::HRectBound<>& inner,
+                     const bound::HRectBound<>& outer);
+
+  typedef tree::TraversalInfo<TreeType> TraversalInfoType;
+
+  const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
+  TraversalInfoType& TraversalInfo() { return traversalInfo; }
+
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+ private:
+  //! The reference set.
+  const arma::mat& referenceSet;
+  //! The query windows.
+  const std::vector<bound::HRectBound<> >& windows;
+  //! The reference points inside each window.
+  std::vector<std::vector<size_t> >& results;
+
+  //! Add every point of the given reference node to the results of the given
+  //! window.
+  void AddResults(const size_t queryIndex, const TreeType& referenceNode);
+
+  //! Add every point of the given reference node to the results of every
+  //! window of the given query node.
+  void AddResults(const TreeType& queryNode, const TreeType& referenceNode);
+
+  TraversalInfoType traversalInfo;
+
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
+};
+
+}; // namespace range
+}; // namespace mlpack
+
+// Include implementation.
+#include "window_search_rules_impl.hpp"
+
+#endif
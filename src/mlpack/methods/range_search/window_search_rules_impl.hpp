@@ -0,0 +1,131 @@
+/**
+ * @file window_search_rules_impl.hpp
+ *
+ * Implementation of the rules for window search.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_RULES_IMPL_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_RULES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "window_search_rules.hpp"
+
+namespace mlpack {
+namespace range {
+
+template<typename TreeType>
+WindowSearchRules<TreeType>::WindowSearchRules(
+    const arma::mat& referenceSet,
+    const std::vector<bound::HRectBound<> >& windows,
+    std::vector<std::vector<size_t> >& results) :
+    referenceSet(referenceSet),
+    windows(windows),
+    results(results)
+{
+  // Nothing to do.
+}
+
+template<typename TreeType>
+inline force_inline
+double WindowSearchRules<TreeType>::BaseCase(const size_t queryIndex,
+                                             const size_t referenceIndex)
+{
+  ++statistics.BaseCases();
+  if (windows[queryIndex].Contains(referenceSet.unsafe_col(referenceIndex)))
+    results[queryIndex].push_back(referenceIndex);
+
+  return 0.0;
+}
+
+template<typename TreeType>
+double WindowSearchRules<TreeType>::Score(const size_t queryIndex,
+                                          TreeType& referenceNode)
+{
+  const bound::HRectBound<>& window = windows[queryIndex];
+  if (!Overlaps(window, referenceNode.Bound()))
+    return statistics.Score(DBL_MAX, referenceNode);
+
+  // In this case, all of the points in the reference node are results.
+  if (Within(referenceNode.Bound(), window))
+  {
+    AddResults(queryIndex, referenceNode);
+    return statistics.Score(DBL_MAX, referenceNode);
+  }
+
+  return statistics.Score(0.0, referenceNode);
+}
+
+template<typename TreeType>
+double WindowSearchRules<TreeType>::Score(TreeType& queryNode,
+                                          TreeType& referenceNode)
+{
+  if (!Overlaps(queryNode.Stat().Bound(), referenceNode.Bound()))
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
+
+  // In this case, all of the points in the reference node are results of
+  // every window in the query node.
+  if (Within(referenceNode.Bound(), queryNode.Stat().Common()))
+  {
+    AddResults(queryNode, referenceNode);
+    return statistics.Score(DBL_MAX, queryNode, referenceNode);
+  }
+
+  return statistics.Score(0.0, queryNode, referenceNode);
+}
+
+template<typename TreeType>
+bool WindowSearchRules<TreeType>::Overlaps(const bound::HRectBound<>& a,
+                                           const bound::HRectBound<>& b)
+{
+  for (size_t d = 0; d < a.Dim(); ++d)
+    if (!a[d].Contains(b[d]))
+      return false;
+
+  return true;
+}
+
+template<typename TreeType>
+bool WindowSearchRules<TreeType>::Within(const bound::HRectBound<>& inner,
+                                         const bound::HRectBound<>& outer)
+{
+  for (size_t d = 0; d < inner.Dim(); ++d)
+    if ((inner[d].Lo() < outer[d].Lo()) || (inner[d].Hi() > outer[d].Hi()))
+      return false;
+
+  return true;
+}
+
+template<typename TreeType>
+void WindowSearchRules<TreeType>::AddResults(const size_t queryIndex,
+                                             const TreeType& referenceNode)
+{
+  // Only the leaves of a RectangleTree hold points.
+  if (referenceNode.IsLeaf())
+  {
+    for (size_t i = 0; i < referenceNode.Count(); ++i)
+      results[queryIndex].push_back(referenceNode.Points()[i]);
+    return;
+  }
+
+  for (size_t i = 0; i < referenceNode.NumChildren(); ++i)
+    AddResults(queryIndex, referenceNode.Child(i));
+}
+
+template<typename TreeType>
+void WindowSearchRules<TreeType>::AddResults(const TreeType& queryNode,
+                                             const TreeType& referenceNode)
+{
+  if (queryNode.IsLeaf())
+  {
+    for (size_t i = 0; i < queryNode.Count(); ++i)
+      AddResults(queryNode.Points()[i], referenceNode);
+    return;
+  }
+
+  for (size_t i = 0; i < queryNode.NumChildren(); ++i)
+    AddResults(queryNode.Child(i), referenceNode);
+}
+
+}; // namespace range
+}; // namespace mlpack
+
+#endif
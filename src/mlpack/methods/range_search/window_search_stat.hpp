@@ -0,0 +1,57 @@
+/**
+ * @file window_search_stat.hpp
+ *
+ * Statistic class for WindowSearch, which holds the union and the intersection
+ * of the query windows in a node of a tree built on the window centers.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_STAT_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_WINDOW_SEARCH_STAT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace range {
+
+/**
+ * Statistic class for WindowSearch, to be set to the StatisticType of the tree
+ * type that window search is being performed with.  In a tree built on the
+ * centers of a batch of query windows, Bound() is the smallest box that holds
+ * every window of the node and its descendants, and Common() is the part of
+ * space that is inside all of them (empty if they do not all overlap).  Both
+ * are set by WindowSearch after the tree is built; in the reference tree, the
+ * statistic is unused.
+ */
+class WindowSearchStat
+{
+ public:
+  //! Initialize the statistic.
+  WindowSearchStat() { }
+
+  /**
+   * Initialize the statistic given a tree node that this statistic belongs to.
+   * In this case, we ignore the node.
+   */
+  template<typename TreeType>
+  WindowSearchStat(TreeType& /* node */) { }
+
+  //! Get the union of the windows in the node.
+  const bound::HRectBound<>& Bound() const { return bound; }
+  //! Modify the union of the windows in the node.
+  bound::HRectBound<>& Bound() { return bound; }
+
+  //! Get the intersection of the windows in the node.
+  const bound::HRectBound<>& Common() const { return common; }
+  //! Modify the intersection of the windows in the node.
+  bound::HRectBound<>& Common() { return common; }
+
+ private:
+  //! The union of the windows in the node.
+  bound::HRectBound<> bound;
+  //! The intersection of the windows in the node.
+  bound::HRectBound<> common;
+};
+
+}; // namespace range
+}; // namespace mlpack
+
+#endif
@@ -14,6 +14,8 @@
 #include <fstream>
 #include <iostream>
 
+#include <mlpack/methods/neighbor_search/unmap.hpp>
+
 #include "ra_search.hpp"
 
 using namespace std;
@@ -49,8 +51,8 @@ PROGRAM_INFO("All K-Rank-Approximate-Nearest-Neighbors",
     "corresponds to the distance between those two points.");
 
 // Define our input parameters that this program will take.
-PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
-                 "r");
+PARAM_STRING("reference_file", "File containing the reference dataset (not "
+             "needed if --load_tree is given).", "r", "");
 PARAM_STRING("distances_file", "File to output distances into.", "d", "");
 PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
 
@@ -70,6 +72,12 @@ PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
            "dual-tree search.", "s");
 PARAM_FLAG("cover_tree", "If true, use cover trees to perform the search.",
            "c");
+PARAM_STRING("save_tree", "If specified, the kd-tree built on the reference "
+    "set is saved (along with the reordered reference set) to this file, so "
+    "that it can be reused with --load_tree.", "", "");
+PARAM_STRING("load_tree", "If specified, the reference kd-tree and reference "
+    "set are loaded (memory-mapped) from this file, which was written with "
+    "--save_tree, instead of being built from --reference_file.", "", "");
 
 PARAM_FLAG("sample_at_leaves", "The flag to trigger sampling at leaves.", "L");
 PARAM_FLAG("first_leaf_exact", "The flag to trigger sampling only after "
@@ -85,6 +93,8 @@ int main(int argc, char *argv[])
 
   // Get all the parameters.
   string referenceFile = CLI::GetParam<string>("reference_file");
+  const string saveTreeFile = CLI::GetParam<string>("save_tree");
+  const string loadTreeFile = CLI::GetParam<string>("load_tree");
   string distancesFile = CLI::GetParam<string>("distances_file");
   string neighborsFile = CLI::GetParam<string>("neighbors_file");
 
@@ -101,27 +111,67 @@ int main(int argc, char *argv[])
   bool sampleAtLeaves = CLI::HasParam("sample_at_leaves");
   bool firstLeafExact = CLI::HasParam("first_leaf_exact");
 
+  // Saved trees are kd-trees built on the reference set as it is given.
+  if ((saveTreeFile != "" || loadTreeFile != "") && (naive ||
+      CLI::HasParam("cover_tree")))
+  {
+    Log::Fatal << "--save_tree and --load_tree can't be used with --naive or "
+        << "--cover_tree." << endl;
+  }
+
   arma::mat referenceData;
   arma::mat queryData; // So it doesn't go out of scope.
-  data::Load(referenceFile, referenceData, true);
 
-  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
-      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
+  // If the reference tree is loaded from a file, the reference set is held by
+  // the MappedTree object.
+  typedef BinarySpaceTree<bound::HRectBound<2, false>,
+      RAQueryStat<NearestNeighborSort> > KDTreeType;
+  MappedTree<KDTreeType>* mappedTree = NULL;
+  if (loadTreeFile != "")
+  {
+    if (referenceFile != "")
+      Log::Warn << "--reference_file ignored because --load_tree is present."
+          << endl;
+
+    Timer::Start("tree_loading");
+    mappedTree = new MappedTree<KDTreeType>(loadTreeFile);
+    Timer::Stop("tree_loading");
+
+    Log::Info << "Loaded reference tree and data from '" << loadTreeFile
+        << "' (" << mappedTree->Dataset().n_rows << " x "
+        << mappedTree->Dataset().n_cols << ")." << endl;
+  }
+  else if (referenceFile != "")
+  {
+    data::Load(referenceFile, referenceData, true);
+
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << referenceData.n_rows << " x " << referenceData.n_cols << ")."
+        << endl;
+  }
+  else
+  {
+    Log::Fatal << "Either --reference_file or --load_tree must be specified."
+        << endl;
+  }
+
+  const size_t numReferencePoints = (mappedTree) ?
+      mappedTree->Dataset().n_cols : referenceData.n_cols;
 
   // Sanity check on k value: must be greater than 0, must be less than the
   // number of reference points.
-  if (k > referenceData.n_cols)
+  if (k > numReferencePoints)
   {
     Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
     Log::Fatal << "than or equal to the number of reference points (";
-    Log::Fatal << referenceData.n_cols << ")." << endl;
+    Log::Fatal << numReferencePoints << ")." << endl;
   }
 
   // Sanity check on the value of 'tau' with respect to 'k' so that
   // 'k' neighbors are not requested from the top-'rank_error' neighbors
   // where 'rank_error' <= 'k'.
   size_t rank_error = (size_t) ceil(tau *
-      (double) referenceData.n_cols / 100.0);
+      (double) numReferencePoints / 100.0);
   if (rank_error <= k)
     Log::Fatal << "Invalid 'tau' (" << tau << ") - k (" << k << ") " <<
       "combination. Increase 'tau' or decrease 'k'." << endl;
@@ -132,6 +182,10 @@ int main(int argc, char *argv[])
       "than or equal to 0." << endl;
   size_t leafSize = lsInt;
 
+  // The search is only run with several threads if the global --threads
+  // option is given (which sets the number of OpenMP threads).
+  const size_t numThreads = CLI::HasParam("threads") ? util::NumThreads() : 1;
+
   // Naive mode overrides single mode.
   if (singleMode && naive)
     Log::Warn << "--single_mode ignored because --naive is present." << endl;
@@ -160,19 +214,17 @@ int main(int argc, char *argv[])
     Log::Info << "Computing " << k << " nearest neighbors " << "with " <<
       tau << "% rank approximation..." << endl;
 
+    allkrann->NumThreads() = numThreads;
+
     allkrann->Search(k, neighbors, distances, tau, alpha);
 
     Log::Info << "Neighbors computed." << endl;
+    allkrann->Statistics().Print();
 
     delete allkrann;
   }
   else
   {
-    // The results output by the AllkRANN class
-    // shuffled because the tree construction shuffles the point sets.
-    arma::Mat<size_t> neighborsOut;
-    arma::mat distancesOut;
-
     if (!CLI::HasParam("cover_tree"))
     {
       // Because we may construct it differently, we need a pointer.
@@ -182,18 +234,30 @@ int main(int argc, char *argv[])
       std::vector<size_t> oldFromNewRefs;
 
       // Build trees by hand, so we can save memory: if we pass a tree to
-      // NeighborSearch, it does not copy the matrix.
-      Log::Info << "Building reference tree..." << endl;
-      Timer::Start("tree_building");
+      // NeighborSearch, it does not copy the matrix.  A loaded reference tree
+      // can be used directly.
+      KDTreeType* refTree = NULL;
+      if (mappedTree)
+      {
+        refTree = &mappedTree->Tree();
+        oldFromNewRefs = mappedTree->OldFromNew();
+      }
+      else
+      {
+        Log::Info << "Building reference tree..." << endl;
+        Timer::Start("tree_building");
+
+        refTree = new KDTreeType(referenceData, oldFromNewRefs, leafSize);
 
-      BinarySpaceTree<bound::HRectBound<2, false>,
-          RAQueryStat<NearestNeighborSort> >
-          refTree(referenceData, oldFromNewRefs, leafSize);
-      BinarySpaceTree<bound::HRectBound<2, false>,
-          RAQueryStat<NearestNeighborSort> >*
-          queryTree = NULL; // Empty for now.
+        Timer::Stop("tree_building");
+      }
 
-      Timer::Stop("tree_building");
+      if (saveTreeFile != "" &&
+          MappedTree<KDTreeType>::Save(saveTreeFile, *refTree, oldFromNewRefs))
+        Log::Info << "Saved reference tree to '" << saveTreeFile << "'."
+            << endl;
+
+      KDTreeType* queryTree = NULL; // Empty for now.
 
       std::vector<size_t> oldFromNewQueries;
 
@@ -215,74 +279,51 @@ int main(int argc, char *argv[])
         // NeighborSearch, it does not copy the matrix.
         Timer::Start("tree_building");
 
-        queryTree = new BinarySpaceTree<bound::HRectBound<2, false>,
-            RAQueryStat<NearestNeighborSort> >
-            (queryData, oldFromNewQueries, leafSize);
+        queryTree = new KDTreeType(queryData, oldFromNewQueries, leafSize);
         Timer::Stop("tree_building");
 
-        allkrann = new AllkRANN(&refTree, queryTree, referenceData, queryData,
-                                singleMode);
+        allkrann = new AllkRANN(refTree, queryTree, refTree->Dataset(),
+                                queryData, singleMode);
 
         Log::Info << "Tree built." << endl;
       }
       else
       {
-        allkrann = new AllkRANN(&refTree, referenceData, singleMode);
+        allkrann = new AllkRANN(refTree, refTree->Dataset(), singleMode);
         Log::Info << "Trees built." << endl;
       }
 
       Log::Info << "Computing " << k << " nearest neighbors " << "with " <<
         tau << "% rank approximation..." << endl;
-      allkrann->Search(k, neighborsOut, distancesOut,
+      allkrann->NumThreads() = numThreads;
+      allkrann->Search(k, neighbors, distances,
                        tau, alpha, sampleAtLeaves,
                        firstLeafExact, singleSampleLimit);
 
       Log::Info << "Neighbors computed." << endl;
+      allkrann->Statistics().Print();
 
       // We have to map back to the original indices from before the tree
       // construction.
       Log::Info << "Re-mapping indices..." << endl;
 
-      neighbors.set_size(neighborsOut.n_rows, neighborsOut.n_cols);
-      distances.set_size(distancesOut.n_rows, distancesOut.n_cols);
-
-      // Do the actual remapping.
+      // The results are shuffled because the tree construction shuffles the
+      // point sets; they are mapped back in place.
       if (CLI::GetParam<string>("query_file") != "")
-      {
-        for (size_t i = 0; i < distancesOut.n_cols; ++i)
-        {
-          // Map distances (copy a column).
-          distances.col(oldFromNewQueries[i]) = distancesOut.col(i);
-
-          // Map indices of neighbors.
-          for (size_t j = 0; j < distancesOut.n_rows; ++j)
-          {
-            neighbors(j, oldFromNewQueries[i])
-              = oldFromNewRefs[neighborsOut(j, i)];
-          }
-        }
-      }
+        Unmap(neighbors, distances, oldFromNewRefs, oldFromNewQueries);
       else
-      {
-        for (size_t i = 0; i < distancesOut.n_cols; ++i)
-        {
-          // Map distances (copy a column).
-          distances.col(oldFromNewRefs[i]) = distancesOut.col(i);
-
-          // Map indices of neighbors.
-          for (size_t j = 0; j < distancesOut.n_rows; ++j)
-          {
-            neighbors(j, oldFromNewRefs[i])
-              = oldFromNewRefs[neighborsOut(j, i)];
-          }
-        }
-      }
+        Unmap(neighbors, distances, oldFromNewRefs, oldFromNewRefs);
 
       // Clean up.
       if (queryTree)
         delete queryTree;
 
       delete allkrann;
+
+      if (mappedTree)
+        delete mappedTree;
+      else
+        delete refTree;
     }
     else // Cover trees.
     {
@@ -21,6 +21,7 @@
 #include <mlpack/core.hpp>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
@@ -110,6 +111,49 @@ class RASearch
            const bool singleMode = false,
            const MetricType metric = MetricType());
 
+  /**
+   * Initialize the RASearch object with the given reference and query sets,
+   * taking the memory of the matrices instead of copying them: the given
+   * matrices are left empty, and the points are rearranged in place during
+   * tree-building.  The rearranged sets, and the mappings from their new
+   * indices to the original indices, can be taken from ReferenceSet(),
+   * QuerySet(), OldFromNewReferences() and OldFromNewQueries(); the results of
+   * Search() are still given in terms of the original indices.  The two
+   * matrices must be different.
+   *
+   * @param referenceSet Set of reference points (which is emptied).
+   * @param querySet Set of query points (which is emptied).
+   * @param naive If true, the rank-approximate search will be performed
+   *      by directly sampling the whole set instead of using the stratified
+   *      sampling on the tree.
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param metric An optional instance of the MetricType class.
+   */
+  RASearch(typename TreeType::Mat* referenceSet,
+           typename TreeType::Mat* querySet,
+           const bool naive = false,
+           const bool singleMode = false,
+           const MetricType metric = MetricType());
+
+  /**
+   * Initialize the RASearch object with only one dataset, which is used as both
+   * the query and the reference dataset, taking the memory of the matrix
+   * instead of copying it (see the constructor above).
+   *
+   * @param referenceSet Set of reference points (which is emptied).
+   * @param naive If true, the rank-approximate search will be performed
+   *      by directly sampling the whole set instead of using the stratified
+   *      sampling on the tree.
+   * @param singleMode If true, single-tree search will be used (as opposed to
+   *      dual-tree search).
+   * @param metric An optional instance of the MetricType class.
+   */
+  RASearch(typename TreeType::Mat* referenceSet,
+           const bool naive = false,
+           const bool singleMode = false,
+           const MetricType metric = MetricType());
+
   /**
    * Initialize the RASearch object with the given datasets and
    * pre-constructed trees.  It is assumed that the points in referenceSet and
@@ -241,6 +285,34 @@ class RASearch
   // Returns a string representation of this object.
   std::string ToString() const;
 
+  //! Get the number of threads used for search.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for search.  This only has an effect if
+  //! mlpack was compiled with OpenMP.  Naive and single-tree results do not
+  //! depend on the number of threads; dual-tree search splits the query tree
+  //! into more subtrees when there are more threads, so its samples (but not
+  //! its guarantee) change with the number of threads.
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the traversal statistics of tree building and all searches.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics of tree building and all searches.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+  //! Get the reference set.  If this object built the reference tree, this is
+  //! its rearranged copy of the reference set.
+  const arma::mat& ReferenceSet() const { return referenceSet; }
+  //! Get the query set (this is the reference set if no query set was given).
+  const arma::mat& QuerySet() const { return querySet; }
+  //! Get the original index of each point of ReferenceSet() (empty if the
+  //! reference set was not rearranged).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNewReferences; }
+  //! Get the original index of each point of QuerySet() (empty if the query
+  //! set was not rearranged).
+  const std::vector<size_t>& OldFromNewQueries() const
+  { return oldFromNewQueries; }
+
  private:
   //! Copy of reference dataset (if we need it, because tree building modifies
   //! it).
@@ -279,11 +351,28 @@ class RASearch
   //! Total number of pruned nodes during the neighbor search.
   size_t numberOfPrunes;
 
+  //! The number of threads to use for search.
+  size_t numThreads;
+
+  //! The traversal statistics of tree building and all searches.
+  tree::TraversalStatistics statistics;
+
   /**
    * @param treeNode The node of the tree whose RAQueryStat is reset
    *     and whose children are to be explored recursively.
    */
   void ResetRAQueryStat(TreeType* treeNode);
+
+  /**
+   * Split the query tree into at least minNodes disjoint subtrees (if it is
+   * deep enough), so that they can be searched in parallel.
+   *
+   * @param queryNodes Roots of the subtrees; this should hold the root of the
+   *     query tree when called.
+   * @param minNodes Number of subtrees to aim for.
+   */
+  void SplitQueryTree(std::vector<TreeType*>& queryNodes,
+                      const size_t minNodes);
 }; // class RASearch
 
 }; // namespace neighbor
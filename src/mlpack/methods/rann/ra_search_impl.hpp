@@ -10,6 +10,8 @@
 
 #include <mlpack/core.hpp>
 
+#include <mlpack/methods/neighbor_search/unmap.hpp>
+
 #include "ra_search_rules.hpp"
 
 namespace mlpack {
@@ -62,10 +64,12 @@ RASearch(const typename TreeType::Mat& referenceSetIn,
     naive(naive),
     singleMode(!naive && singleMode), // No single mode if naive.
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    numThreads(1)
 {
   // We'll time tree building.
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   if (tree::TreeTraits<TreeType>::RearrangesDataset)
   {
@@ -86,6 +90,7 @@ RASearch(const typename TreeType::Mat& referenceSetIn,
   }
 
   // Stop the timer we started above.
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
 }
 
@@ -107,10 +112,12 @@ RASearch(const typename TreeType::Mat& referenceSetIn,
     naive(naive),
     singleMode(!naive && singleMode), // No single mode if naive.
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    numThreads(1)
 {
   // We'll time tree building.
   Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
 
   if (tree::TreeTraits<TreeType>::RearrangesDataset)
     referenceCopy = referenceSetIn;
@@ -121,6 +128,87 @@ RASearch(const typename TreeType::Mat& referenceSetIn,
         TreeType::Mat&>(referenceSet), oldFromNewReferences);
 
   // Stop the timer we started above.
+  statistics.StopPhase("tree_building");
+  Timer::Stop("tree_building");
+}
+
+// Construct the object, taking the memory of the datasets.
+template<typename SortPolicy, typename MetricType, typename TreeType>
+RASearch<SortPolicy, MetricType, TreeType>::
+RASearch(typename TreeType::Mat* referenceSetIn,
+         typename TreeType::Mat* querySetIn,
+         const bool naive,
+         const bool singleMode,
+         const MetricType metric) :
+    referenceSet(referenceCopy),
+    querySet(queryCopy),
+    referenceTree(NULL),
+    queryTree(NULL),
+    treeOwner(!naive), // If naive, then we are not building any trees.
+    hasQuerySet(true),
+    naive(naive),
+    singleMode(!naive && singleMode), // No single mode if naive.
+    metric(metric),
+    numberOfPrunes(0),
+    numThreads(1)
+{
+  if (referenceSetIn == querySetIn)
+    Log::Fatal << "RASearch::RASearch(): the reference set and "
+        << "the query set must be different matrices!" << std::endl;
+
+  // We'll time tree building, but only if we are building trees.
+  Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
+
+  // The trees are built on the memory of the given datasets; nothing is copied
+  // (unless the memory cannot be taken, as with matrices using auxiliary
+  // memory).
+  referenceCopy.steal_mem(*referenceSetIn);
+  queryCopy.steal_mem(*querySetIn);
+
+  if (!naive)
+  {
+    referenceTree = aux::BuildTree<TreeType>(referenceCopy,
+        oldFromNewReferences);
+
+    if (!singleMode)
+      queryTree = aux::BuildTree<TreeType>(queryCopy, oldFromNewQueries);
+  }
+
+  statistics.StopPhase("tree_building");
+  Timer::Stop("tree_building");
+}
+
+// Construct the object, taking the memory of the dataset.
+template<typename SortPolicy, typename MetricType, typename TreeType>
+RASearch<SortPolicy, MetricType, TreeType>::
+RASearch(typename TreeType::Mat* referenceSetIn,
+         const bool naive,
+         const bool singleMode,
+         const MetricType metric) :
+    referenceSet(referenceCopy),
+    querySet(referenceCopy),
+    referenceTree(NULL),
+    queryTree(NULL),
+    treeOwner(!naive), // If naive, then we are not building any trees.
+    hasQuerySet(false),
+    naive(naive),
+    singleMode(!naive && singleMode), // No single mode if naive.
+    metric(metric),
+    numberOfPrunes(0),
+    numThreads(1)
+{
+  // We'll time tree building, but only if we are building trees.
+  Timer::Start("tree_building");
+  statistics.StartPhase("tree_building");
+
+  referenceCopy.steal_mem(*referenceSetIn);
+
+  if (!naive)
+    referenceTree = aux::BuildTree<TreeType>(referenceCopy,
+        oldFromNewReferences);
+
+  statistics.StopPhase("tree_building");
   Timer::Stop("tree_building");
 }
 
@@ -142,7 +230,8 @@ RASearch(TreeType* referenceTree,
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    numThreads(1)
 // Nothing else to initialize.
 {  }
 
@@ -162,7 +251,8 @@ RASearch(TreeType* referenceTree,
     naive(false),
     singleMode(singleMode),
     metric(metric),
-    numberOfPrunes(0)
+    numberOfPrunes(0),
+    numThreads(1)
 // Nothing else to initialize.
 { }
 
@@ -199,39 +289,37 @@ Search(const size_t k,
        const size_t singleSampleLimit)
 {
   Timer::Start("computing_neighbors");
+  statistics.StartPhase("traversal");
 
   // If we have built the trees ourselves, then we will have to map all the
   // indices back to their original indices when this computation is finished.
-  // To avoid an extra copy, we will store the neighbors and distances in a
-  // separate matrix.
-  arma::Mat<size_t>* neighborPtr = &resultingNeighbors;
-  arma::mat* distancePtr = &distances;
-
-  // Mapping is only required if this tree type rearranges points and we are not
-  // in naive mode.
-  if (tree::TreeTraits<TreeType>::RearrangesDataset)
-  {
-    if (treeOwner && !(singleMode && hasQuerySet))
-      distancePtr = new arma::mat; // Query indices need to be mapped.
-    if (treeOwner)
-      neighborPtr = new arma::Mat<size_t>; // All indices need mapping.
-  }
+  // The results are mapped in place, so no extra copy of them is made.
 
   // Set the size of the neighbor and distance matrices.
-  neighborPtr->set_size(k, querySet.n_cols);
-  distancePtr->set_size(k, querySet.n_cols);
-  distancePtr->fill(SortPolicy::WorstDistance());
+  resultingNeighbors.set_size(k, querySet.n_cols);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(SortPolicy::WorstDistance());
 
   size_t numPrunes = 0;
 
+  // Each part of the search that may run on its own thread (a block of query
+  // points, or a query subtree) draws its samples from its own random stream,
+  // which is seeded from this.  Because the base seed comes from the global
+  // random number generator, math::RandomSeed() still makes the search
+  // reproducible.
+  const size_t baseSeed = (size_t) math::RandInt(
+      std::numeric_limits<int>::max());
+
+  typedef RASearchRules<SortPolicy, MetricType, TreeType> RuleType;
+
   if (naive)
   {
     // We don't need to run the base case on every possible combination of
     // points; we can achieve the rank approximation guarantee with probability
-    // alpha by sampling the reference set.
-    typedef RASearchRules<SortPolicy, MetricType, TreeType> RuleType;
-    RuleType rules(referenceSet, querySet, *neighborPtr, *distancePtr,
-                   metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
+    // alpha by sampling the reference set.  The rules are told that this is
+    // not a naive search, so that they do not do their own sampling too.
+    RuleType rules(referenceSet, querySet, resultingNeighbors, distances,
+                   metric, tau, alpha, false, sampleAtLeaves, firstLeafExact,
                    singleSampleLimit);
 
     // Find how many samples from the reference set we need and sample uniformly
@@ -239,21 +327,64 @@ Search(const size_t k,
     const size_t numSamples = rules.MinimumSamplesReqd(referenceSet.n_cols, k,
         tau, alpha);
     arma::uvec distinctSamples;
+    rules.Seed(baseSeed);
     rules.ObtainDistinctSamples(numSamples, referenceSet.n_cols,
         distinctSamples);
 
-    // Run the base case on each combination of query point and sampled
-    // reference point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      for (size_t j = 0; j < distinctSamples.n_elem; ++j)
-        rules.BaseCase(i, (size_t) distinctSamples[j]);
+    // Every query point uses the same samples, so the distances to a whole
+    // block of query points can be computed at once (see
+    // metric::BlockDistances()).  Each thread handles its own blocks with its
+    // own copy of the rules, and each query point only writes to its own
+    // column of the results.
+    arma::mat samples(referenceSet.n_rows, distinctSamples.n_elem);
+    for (size_t i = 0; i < distinctSamples.n_elem; ++i)
+      samples.col(i) = referenceSet.unsafe_col(distinctSamples[i]);
+
+    const size_t blockSize = 256;
+    const size_t numBlocks = (querySet.n_cols + blockSize - 1) / blockSize;
+    #pragma omp parallel num_threads(numThreads)
+    {
+      RuleType threadRules(rules);
+
+      #pragma omp for schedule(dynamic, 1)
+      for (size_t b = 0; b < numBlocks; ++b)
+      {
+        const size_t begin = b * blockSize;
+        const size_t end = std::min(begin + blockSize,
+            (size_t) querySet.n_cols);
+
+        // blockDistances(i, j) is the distance between the i'th sample and the
+        // j'th query point of the block.
+        arma::mat blockDistances;
+        const bool block = metric::BlockDistances(metric, samples,
+            querySet.cols(begin, end - 1), blockDistances);
+
+        for (size_t j = begin; j < end; ++j)
+        {
+          for (size_t i = 0; i < distinctSamples.n_elem; ++i)
+          {
+            const size_t referenceIndex = (size_t) distinctSamples[i];
+            if (!block)
+              threadRules.BaseCase(j, referenceIndex);
+            else if ((&querySet != &referenceSet) || (j != referenceIndex))
+              threadRules.AddSample(j, referenceIndex,
+                  blockDistances(i, j - begin));
+          }
+        }
+      }
+
+      #pragma omp critical
+      {
+        rules.Statistics() += threadRules.Statistics();
+      }
+    }
+
+    statistics += rules.Statistics();
   }
   else if (singleMode)
   {
-    // Create the helper object for the tree traversal.  Initialization of
-    // RASearchRules already implicitly performs the naive tree traversal.
-    typedef RASearchRules<SortPolicy, MetricType, TreeType> RuleType;
-    RuleType rules(referenceSet, querySet, *neighborPtr, *distancePtr,
+    // Create the helper object for the tree traversal.
+    RuleType rules(referenceSet, querySet, resultingNeighbors, distances,
                    metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
                    singleSampleLimit);
 
@@ -263,53 +394,108 @@ Search(const size_t k,
     {
       Log::Info << "Performing single-tree traversal..." << std::endl;
 
-      // Create the traverser.
-      typename TreeType::template SingleTreeTraverser<RuleType>
-        traverser(rules);
-
-      // Now have it traverse for each point.
-      for (size_t i = 0; i < querySet.n_cols; ++i)
-        traverser.Traverse(i, *referenceTree);
-
-      numPrunes = traverser.NumPrunes();
+      // The query points are independent, so we can split them across
+      // threads.  Each thread gets its own copy of the rules and its own
+      // traverser, and each query point only writes to its own column of the
+      // results, so no locking is necessary.  Each block of query points is
+      // sampled with its own random stream, so the results do not depend on
+      // the number of threads.
+      const size_t blockSize = 16;
+      const size_t numBlocks = (querySet.n_cols + blockSize - 1) / blockSize;
+      size_t numDistComputations = rules.NumDistComputations();
+      #pragma omp parallel num_threads(numThreads)
+      {
+        RuleType threadRules(rules);
+        const size_t initialDistComputations =
+            threadRules.NumDistComputations();
+        threadRules.Statistics().Reset();
+
+        // Create the traverser.
+        typename TreeType::template SingleTreeTraverser<RuleType>
+          traverser(threadRules);
+
+        // Now have it traverse for each point.
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t b = 0; b < numBlocks; ++b)
+        {
+          threadRules.Seed(baseSeed + b);
+
+          const size_t end = std::min((b + 1) * blockSize,
+              (size_t) querySet.n_cols);
+          for (size_t i = b * blockSize; i < end; ++i)
+            traverser.Traverse(i, *referenceTree);
+        }
+
+        #pragma omp critical
+        {
+          numPrunes += traverser.NumPrunes();
+          numDistComputations += threadRules.NumDistComputations() -
+              initialDistComputations;
+          rules.Statistics() += threadRules.Statistics();
+        }
+      }
 
       Log::Info << "Single-tree traversal complete." << std::endl;
       Log::Info << "Average number of distance calculations per query point: "
-          << (rules.NumDistComputations() / querySet.n_cols) << "."
-          << std::endl;
+          << (numDistComputations / querySet.n_cols) << "." << std::endl;
     }
+
+    statistics += rules.Statistics();
   }
   else // Dual-tree recursion.
   {
     Log::Info << "Performing dual-tree traversal..." << std::endl;
 
-    typedef RASearchRules<SortPolicy, MetricType, TreeType> RuleType;
-    RuleType rules(referenceSet, querySet, *neighborPtr, *distancePtr,
-                   metric, tau, alpha, sampleAtLeaves, firstLeafExact,
+    RuleType rules(referenceSet, querySet, resultingNeighbors, distances,
+                   metric, tau, alpha, false, sampleAtLeaves, firstLeafExact,
                    singleSampleLimit);
 
-    typename TreeType::template DualTreeTraverser<RuleType> traverser(rules);
+    TreeType* queryRoot = (queryTree != NULL) ? queryTree : referenceTree;
+    Log::Info << "Query statistic pre-search: "
+        << queryRoot->Stat().NumSamplesMade() << std::endl;
 
-    if (queryTree)
-    {
-      Log::Info << "Query statistic pre-search: "
-          << queryTree->Stat().NumSamplesMade() << std::endl;
-      traverser.Traverse(*queryTree, *referenceTree);
-    }
-    else
+    // The search for each query subtree only touches the statistics of that
+    // subtree and the results of its points, so the subtrees can be searched
+    // in parallel, each with its own copy of the rules, traverser, and random
+    // stream.  With one thread the whole tree is searched at once.
+    std::vector<TreeType*> queryNodes(1, queryRoot);
+    if (numThreads > 1)
+      SplitQueryTree(queryNodes, 8 * numThreads);
+
+    size_t numDistComputations = 0;
+    #pragma omp parallel num_threads(numThreads)
     {
-      Log::Info << "Query statistic pre-search: "
-          << referenceTree->Stat().NumSamplesMade() << std::endl;
-      traverser.Traverse(*referenceTree, *referenceTree);
-    }
+      RuleType threadRules(rules);
+      threadRules.Statistics().Reset();
+      size_t threadPrunes = 0;
+
+      #pragma omp for schedule(dynamic, 1)
+      for (size_t i = 0; i < queryNodes.size(); ++i)
+      {
+        threadRules.Seed(baseSeed + i);
 
-    numPrunes = traverser.NumPrunes();
+        typename TreeType::template DualTreeTraverser<RuleType>
+            traverser(threadRules);
+        traverser.Traverse(*queryNodes[i], *referenceTree);
+        threadPrunes += traverser.NumPrunes();
+      }
+
+      #pragma omp critical
+      {
+        numPrunes += threadPrunes;
+        numDistComputations += threadRules.NumDistComputations();
+        rules.Statistics() += threadRules.Statistics();
+      }
+    }
 
     Log::Info << "Dual-tree traversal complete." << std::endl;
     Log::Info << "Average number of distance calculations per query point: "
-        << (rules.NumDistComputations() / querySet.n_cols) << "." << std::endl;
+        << (numDistComputations / querySet.n_cols) << "." << std::endl;
+
+    statistics += rules.Statistics();
   }
 
+  statistics.StopPhase("traversal");
   Timer::Stop("computing_neighbors");
   Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
 
@@ -321,64 +507,52 @@ Search(const size_t k,
   }
   else if (treeOwner && hasQuerySet && !singleMode) // Map both sets.
   {
-    // Set size of output matrices correctly.
-    resultingNeighbors.set_size(k, querySet.n_cols);
-    distances.set_size(k, querySet.n_cols);
-
-    for (size_t i = 0; i < distances.n_cols; i++)
-    {
-      // Map distances (copy a column).
-      distances.col(oldFromNewQueries[i]) = distancePtr->col(i);
-
-      // Map indices of neighbors.
-      for (size_t j = 0; j < distances.n_rows; j++)
-      {
-        resultingNeighbors(j, oldFromNewQueries[i]) =
-            oldFromNewReferences[(*neighborPtr)(j, i)];
-      }
-    }
-
-    // Finished with temporary matrices.
-    delete neighborPtr;
-    delete distancePtr;
+    Unmap(resultingNeighbors, distances, oldFromNewReferences,
+        oldFromNewQueries);
   }
   else if (treeOwner && !hasQuerySet)
   {
     // No query tree -- map both references and queries.
-    resultingNeighbors.set_size(k, querySet.n_cols);
-    distances.set_size(k, querySet.n_cols);
-
-    for (size_t i = 0; i < distances.n_cols; i++)
-    {
-      // Map distances (copy a column).
-      distances.col(oldFromNewReferences[i]) = distancePtr->col(i);
-
-      // Map indices of neighbors.
-      for (size_t j = 0; j < distances.n_rows; j++)
-      {
-        resultingNeighbors(j, oldFromNewReferences[i]) =
-            oldFromNewReferences[(*neighborPtr)(j, i)];
-      }
-    }
+    Unmap(resultingNeighbors, distances, oldFromNewReferences,
+        oldFromNewReferences);
   }
   else if (treeOwner && hasQuerySet && singleMode) // Map only references.
   {
-    // Set size of neighbor indices matrix correctly.
-    resultingNeighbors.set_size(k, querySet.n_cols);
+    Unmap(resultingNeighbors, distances, oldFromNewReferences);
+  }
+} // Search
 
-    // Map indices of neighbors.
-    for (size_t i = 0; i < resultingNeighbors.n_cols; i++)
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void RASearch<SortPolicy, MetricType, TreeType>::SplitQueryTree(
+    std::vector<TreeType*>& queryNodes,
+    const size_t minNodes)
+{
+  // Replace each node by its children, one level at a time, until there are
+  // enough subtrees.  Only nodes that hold no points of their own can be
+  // replaced, so that every query point stays in exactly one subtree.
+  while (queryNodes.size() < minNodes)
+  {
+    std::vector<TreeType*> nextNodes;
+    bool split = false;
+    for (size_t i = 0; i < queryNodes.size(); ++i)
     {
-      for (size_t j = 0; j < resultingNeighbors.n_rows; j++)
+      if (queryNodes[i]->NumChildren() > 0 && queryNodes[i]->NumPoints() == 0)
+      {
+        for (size_t j = 0; j < queryNodes[i]->NumChildren(); ++j)
+          nextNodes.push_back(&queryNodes[i]->Child(j));
+        split = true;
+      }
+      else
       {
-        resultingNeighbors(j, i) = oldFromNewReferences[(*neighborPtr)(j, i)];
+        nextNodes.push_back(queryNodes[i]);
       }
     }
 
-    // Finished with temporary matrix.
-    delete neighborPtr;
+    if (!split)
+      break;
+    queryNodes.swap(nextNodes);
   }
-} // Search
+}
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
 void RASearch<SortPolicy, MetricType, TreeType>::ResetQueryTree()
@@ -9,6 +9,9 @@
 #ifndef __MLPACK_METHODS_RANN_RA_SEARCH_RULES_HPP
 #define __MLPACK_METHODS_RANN_RA_SEARCH_RULES_HPP
 
+#include <mlpack/core/metrics/block_distances.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
 #include "../neighbor_search/ns_traversal_info.hpp"
 #include "ra_search.hpp" // For friend declaration.
 
@@ -192,6 +195,20 @@ class RASearchRules
   const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
   TraversalInfoType& TraversalInfo() { return traversalInfo; }
 
+  //! Get the traversal statistics.
+  const tree::TraversalStatistics& Statistics() const { return statistics; }
+  //! Modify the traversal statistics.
+  tree::TraversalStatistics& Statistics() { return statistics; }
+
+  /**
+   * Restart the random stream that samples are drawn from.  Each copy of the
+   * rules has its own stream, so copies used by different threads (or for
+   * different parts of the search) should be given different seeds.
+   *
+   * @param seed Seed for the random number generator.
+   */
+  void Seed(const size_t seed) { randGen.seed((uint32_t) seed); }
+
  private:
   //! The reference set.
   const arma::mat& referenceSet;
@@ -231,6 +248,38 @@ class RASearchRules
 
   TraversalInfoType traversalInfo;
 
+  //! The traversal statistics (base cases, scores, prunes, and so on).
+  tree::TraversalStatistics statistics;
+
+  //! The random stream samples are drawn from.
+  boost::mt19937 randGen;
+
+  /**
+   * Record the distance between a query point and a reference point as a
+   * sample; this is the part of BaseCase() after the distance is computed.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceIndex Index of reference point.
+   * @param distance Distance between the two points.
+   */
+  void AddSample(const size_t queryIndex,
+                 const size_t referenceIndex,
+                 const double distance);
+
+  /**
+   * Approximate the reference node by sampling the given number of its points
+   * for every query point in the query node.  One set of samples is drawn for
+   * the whole query node, so all of the distances can be computed with one
+   * block evaluation (see metric::BlockDistances()).
+   *
+   * @param queryNode Query node to sample for.
+   * @param referenceNode Reference node to sample from.
+   * @param numSamples Number of samples (with replacement) to draw.
+   */
+  void SampleNode(TreeType& queryNode,
+                  TreeType& referenceNode,
+                  const size_t numSamples);
+
   /**
    * Insert a point into the neighbors and distances matrices; this is a helper
    * function.
@@ -284,7 +333,7 @@ class RASearchRules
    */
   void ObtainDistinctSamples(const size_t numSamples,
                              const size_t rangeUpperBound,
-                             arma::uvec& distinctSamples) const;
+                             arma::uvec& distinctSamples);
 
   /**
    * Perform actual scoring for single-tree case.
@@ -66,6 +66,11 @@ RASearchRules(const arma::mat& referenceSet,
   Log::Info << "Minimum samples required per query: " << numSamplesReqd <<
     ", sampling ratio: " << samplingRatio << std::endl;
 
+  // Start the random stream from the global random number generator, so that
+  // math::RandomSeed() makes the search reproducible.  RASearch gives each
+  // thread its own stream with Seed().
+  Seed((size_t) math::RandInt(std::numeric_limits<int>::max()));
+
   if (naive) // No tree traversal; just do naive sampling here.
   {
     // Sample enough points.
@@ -85,14 +90,18 @@ inline force_inline
 void RASearchRules<SortPolicy, MetricType, TreeType>::
 ObtainDistinctSamples(const size_t numSamples,
                       const size_t rangeUpperBound,
-                      arma::uvec& distinctSamples) const
+                      arma::uvec& distinctSamples)
 {
   // Keep track of the points that are sampled.
   arma::Col<size_t> sampledPoints;
   sampledPoints.zeros(rangeUpperBound);
 
+  // The samples come from this object's own random stream, so no locking is
+  // needed when each thread has its own copy of the rules.  The generator
+  // gives 32-bit values, which are scaled to [0, rangeUpperBound).
   for (size_t i = 0; i < numSamples; i++)
-    sampledPoints[(size_t) math::RandInt(rangeUpperBound)]++;
+    sampledPoints[(size_t) (((double) randGen() / 4294967296.0) *
+        (double) rangeUpperBound)]++;
 
   distinctSamples = arma::find(sampledPoints > 0);
   return;
@@ -271,9 +280,20 @@ double RASearchRules<SortPolicy, MetricType, TreeType>::BaseCase(
   if ((&querySet == &referenceSet) && (queryIndex == referenceIndex))
     return 0.0;
 
-  double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
-                                    referenceSet.unsafe_col(referenceIndex));
+  const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
+      referenceSet.unsafe_col(referenceIndex));
+  AddSample(queryIndex, referenceIndex, distance);
 
+  return distance;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline force_inline
+void RASearchRules<SortPolicy, MetricType, TreeType>::AddSample(
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double distance)
+{
   // If this distance is better than any of the current candidates, the
   // SortDistance() function will give us the position to insert it into.
   arma::vec queryDist = distances.unsafe_col(queryIndex);
@@ -289,8 +309,53 @@ double RASearchRules<SortPolicy, MetricType, TreeType>::BaseCase(
 
   // TO REMOVE
   numDistComputations++;
+  ++statistics.BaseCases();
+}
 
-  return distance;
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void RASearchRules<SortPolicy, MetricType, TreeType>::SampleNode(
+    TreeType& queryNode,
+    TreeType& referenceNode,
+    const size_t numSamples)
+{
+  // All of the query points share one set of samples; each query point still
+  // gets a uniform sample of the reference node, which is all the rank
+  // guarantee needs.
+  arma::uvec distinctSamples;
+  ObtainDistinctSamples(numSamples, referenceNode.NumDescendants(),
+      distinctSamples);
+
+  // Gather the points, so that all of the distances can be computed at once.
+  arma::mat queries(querySet.n_rows, queryNode.NumDescendants());
+  for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
+    queries.col(i) = querySet.unsafe_col(queryNode.Descendant(i));
+
+  arma::mat samples(referenceSet.n_rows, distinctSamples.n_elem);
+  for (size_t i = 0; i < distinctSamples.n_elem; ++i)
+    samples.col(i) = referenceSet.unsafe_col(
+        referenceNode.Descendant(distinctSamples[i]));
+
+  // blockDistances(i, j) is the distance between the i'th sample and the j'th
+  // query point.
+  arma::mat blockDistances;
+  const bool block = metric::BlockDistances(metric, samples, queries,
+      blockDistances);
+
+  for (size_t j = 0; j < queryNode.NumDescendants(); ++j)
+  {
+    const size_t queryIndex = queryNode.Descendant(j);
+    for (size_t i = 0; i < distinctSamples.n_elem; ++i)
+    {
+      // The counting of the samples is done in AddSample() (or BaseCase()), so
+      // no book-keeping is required here.
+      const size_t referenceIndex =
+          referenceNode.Descendant(distinctSamples[i]);
+      if (!block)
+        BaseCase(queryIndex, referenceIndex);
+      else if ((&querySet != &referenceSet) || (queryIndex != referenceIndex))
+        AddSample(queryIndex, referenceIndex, blockDistances(i, j));
+    }
+  }
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -303,7 +368,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
       &referenceNode);
   const double bestDistance = distances(distances.n_rows - 1, queryIndex);
 
-  return Score(queryIndex, referenceNode, distance, bestDistance);
+  return statistics.Score(Score(queryIndex, referenceNode, distance,
+      bestDistance), referenceNode);
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -317,7 +383,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
       &referenceNode, baseCaseResult);
   const double bestDistance = distances(distances.n_rows - 1, queryIndex);
 
-  return Score(queryIndex, referenceNode, distance, bestDistance);
+  return statistics.Score(Score(queryIndex, referenceNode, distance,
+      bestDistance), referenceNode);
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -544,7 +611,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   queryNode.Stat().Bound() = std::min(pointBound, childBound);
   const double bestDistance = queryNode.Stat().Bound();
 
-  return Score(queryNode, referenceNode, distance, bestDistance);
+  return statistics.Score(Score(queryNode, referenceNode, distance,
+      bestDistance), queryNode, referenceNode);
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -583,7 +651,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   queryNode.Stat().Bound() = std::min(pointBound, childBound);
   const double bestDistance = queryNode.Stat().Bound();
 
-  return Score(queryNode, referenceNode, distance, bestDistance);
+  return statistics.Score(Score(queryNode, referenceNode, distance,
+      bestDistance), queryNode, referenceNode);
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -660,18 +729,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
         {
           // Then samplesReqd <= singleSampleLimit.  Hence, approximate node by
           // sampling enough number of points for every query in the query node.
-          for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
-          {
-            const size_t queryIndex = queryNode.Descendant(i);
-            arma::uvec distinctSamples;
-            ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-                                  distinctSamples);
-            for (size_t j = 0; j < distinctSamples.n_elem; j++)
-              // The counting of the samples are done in the 'BaseCase' function
-              // so no book-keeping is required here.
-              BaseCase(queryIndex,
-                  referenceNode.Descendant(distinctSamples[j]));
-          }
+          SampleNode(queryNode, referenceNode, samplesReqd);
 
           // Update the number of samples made for the queryNode and also update
           // the number of sample made for the child nodes.
@@ -690,18 +748,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           {
             // Approximate node by sampling enough number of points for every
             // query in the query node.
-            for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
-            {
-              const size_t queryIndex = queryNode.Descendant(i);
-              arma::uvec distinctSamples;
-              ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-                                    distinctSamples);
-              for (size_t j = 0; j < distinctSamples.n_elem; j++)
-                // The counting of the samples are done in the 'BaseCase'
-                // function so no book-keeping is required here.
-                BaseCase(queryIndex,
-                    referenceNode.Descendant(distinctSamples[j]));
-            }
+            SampleNode(queryNode, referenceNode, samplesReqd);
 
             // Update the number of samples made for the queryNode and also
             // update the number of sample made for the child nodes.
@@ -865,17 +912,7 @@ Rescore(TreeType& queryNode,
       {
         // then samplesReqd <= singleSampleLimit.  Hence, approximate the node
         // by sampling enough points for every query in the query node.
-        for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
-        {
-          const size_t queryIndex = queryNode.Descendant(i);
-          arma::uvec distinctSamples;
-          ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-              distinctSamples);
-          for (size_t j = 0; j < distinctSamples.n_elem; j++)
-            // The counting of the samples are done in the 'BaseCase'
-            // function so no book-keeping is required here.
-            BaseCase(queryIndex, referenceNode.Descendant(distinctSamples[j]));
-        }
+        SampleNode(queryNode, referenceNode, samplesReqd);
 
         // Update the number of samples made for the query node and also update
         // the number of samples made for the child nodes.
@@ -894,18 +931,7 @@ Rescore(TreeType& queryNode,
         {
           // Approximate node by sampling enough points for every query in the
           // query node.
-          for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
-          {
-            const size_t queryIndex = queryNode.Descendant(i);
-            arma::uvec distinctSamples;
-            ObtainDistinctSamples(samplesReqd, referenceNode.NumDescendants(),
-                                  distinctSamples);
-            for (size_t j = 0; j < distinctSamples.n_elem; j++)
-              // The counting of the samples are done in BaseCase() so no
-              // book-keeping is required here.
-              BaseCase(queryIndex,
-                  referenceNode.Descendant(distinctSamples[j]));
-          }
+          SampleNode(queryNode, referenceNode, samplesReqd);
 
           // Update the number of samples made for the query node and also
           // update the number of samples made for the child nodes.
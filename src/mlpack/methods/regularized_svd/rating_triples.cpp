@@ -0,0 +1,87 @@
+/**
+ * @file rating_triples.cpp
+ *
+ * Implementation of the RatingTriples class.
+ */
+#include "rating_triples.hpp"
+
+using namespace mlpack;
+using namespace mlpack::svd;
+
+RatingTriples::RatingTriples() : numUsers(0), numItems(0)
+{
+  // Nothing to do.
+}
+
+RatingTriples::RatingTriples(const arma::mat& data) : numUsers(0), numItems(0)
+{
+  Add(data);
+}
+
+void RatingTriples::Add(const arma::mat& data)
+{
+  if (data.n_cols == 0)
+    return;
+
+  if (data.n_rows != 3)
+    Log::Fatal << "RatingTriples::Add(): the coordinate list must have three "
+        << "rows (user, item, rating), not " << data.n_rows << "!"
+        << std::endl;
+
+  const size_t size = ratings.size();
+  users.resize(size + data.n_cols);
+  items.resize(size + data.n_cols);
+  ratings.resize(size + data.n_cols);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    const double user = data(0, i);
+    const double item = data(1, i);
+    if (user < 0 || item < 0 || user > 4294967295.0 || item > 4294967295.0)
+      Log::Fatal << "RatingTriples::Add(): the user and item of rating " << i
+          << " (" << user << ", " << item << ") must be non-negative "
+          << "integers which fit in 32 bits!" << std::endl;
+
+    users[size + i] = (boost::uint32_t) user;
+    items[size + i] = (boost::uint32_t) item;
+    ratings[size + i] = (float) data(2, i);
+
+    numUsers = std::max(numUsers, (size_t) users[size + i] + 1);
+    numItems = std::max(numItems, (size_t) items[size + i] + 1);
+  }
+}
+
+bool RatingTriples::Load(const std::string& filename,
+                         const size_t chunkSize,
+                         const bool fatal)
+{
+  data::ChunkReader reader(filename, fatal);
+  if (!reader.IsOpen())
+    return false;
+
+  arma::mat chunk;
+  while (reader.Read(chunk, chunkSize))
+    Add(chunk);
+
+  return !reader.Failed();
+}
+
+void RatingTriples::Shuffle()
+{
+  // Fisher-Yates shuffle; math::RandInt() only returns ints, so the index is
+  // taken from a uniform double instead.
+  for (size_t i = ratings.size(); i > 1; --i)
+  {
+    const size_t j = std::min(i - 1, (size_t) (math::Random() * i));
+    std::swap(users[i - 1], users[j]);
+    std::swap(items[i - 1], items[j]);
+    std::swap(ratings[i - 1], ratings[j]);
+  }
+}
+
+void RatingTriples::Clear()
+{
+  users.clear();
+  items.clear();
+  ratings.clear();
+}
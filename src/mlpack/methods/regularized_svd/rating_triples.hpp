@@ -0,0 +1,105 @@
+/**
+ * @file rating_triples.hpp
+ *
+ * A compact store of (user, item, rating) triples for Regularized SVD.
+ */
+#ifndef __MLPACK_METHODS_REGULARIZED_SVD_RATING_TRIPLES_HPP
+#define __MLPACK_METHODS_REGULARIZED_SVD_RATING_TRIPLES_HPP
+
+#include <mlpack/core.hpp>
+#include <boost/cstdint.hpp>
+
+namespace mlpack {
+namespace svd {
+
+/**
+ * The RatingTriples class stores ratings as a struct of arrays: 32-bit user
+ * and item indices and single-precision ratings, so that each rating takes 12
+ * bytes (instead of the 24 bytes of a column of an arma::mat coordinate list),
+ * and the indices never have to be converted from doubles.  The numbers of
+ * users and items are tracked as ratings are added.
+ *
+ * @code
+ * RatingTriples ratings;
+ * ratings.Load("ratings.csv");
+ * ratings.Shuffle();
+ *
+ * RegularizedSVD<> rSVD(10, 0.01, 0.02);
+ * rSVD.Apply(ratings, 20, u, v);
+ * @endcode
+ */
+class RatingTriples
+{
+ public:
+  //! Create an empty set of ratings.
+  RatingTriples();
+
+  /**
+   * Create the ratings from a coordinate list, with one (user, item, rating)
+   * column for each rating.
+   *
+   * @param data Rating data in the form of a coordinate list.
+   */
+  RatingTriples(const arma::mat& data);
+
+  /**
+   * Add the ratings of a coordinate list, with one (user, item, rating) column
+   * for each rating.  The user and item indices must be non-negative integers
+   * which fit in 32 bits.
+   *
+   * @param data Rating data in the form of a coordinate list.
+   */
+  void Add(const arma::mat& data);
+
+  /**
+   * Add the ratings stored in the given file, one (user, item, rating) point at
+   * a time, reading chunkSize points at a time so that the coordinate list is
+   * never held in memory all at once.
+   *
+   * @param filename Name of the file to load.
+   * @param chunkSize Number of ratings to read at a time.
+   * @param fatal If an error should be reported as fatal (default false).
+   * @return Whether or not the whole file was loaded.
+   */
+  bool Load(const std::string& filename,
+            const size_t chunkSize = 100000,
+            const bool fatal = false);
+
+  //! Shuffle the order of the ratings, in place.
+  void Shuffle();
+
+  //! Remove all the ratings (the numbers of users and items are kept).
+  void Clear();
+
+  //! Get the number of ratings.
+  size_t Size() const { return ratings.size(); }
+  //! Get the number of users (one more than the largest user index).
+  size_t NumUsers() const { return numUsers; }
+  //! Get the number of items (one more than the largest item index).
+  size_t NumItems() const { return numItems; }
+
+  //! Get the user of the i'th rating.
+  size_t User(const size_t i) const { return users[i]; }
+  //! Get the item of the i'th rating.
+  size_t Item(const size_t i) const { return items[i]; }
+  //! Get the i'th rating.
+  double Rating(const size_t i) const { return ratings[i]; }
+
+ private:
+  //! The user of each rating.
+  std::vector<boost::uint32_t> users;
+  //! The item of each rating.
+  std::vector<boost::uint32_t> items;
+  //! The value of each rating.
+  std::vector<float> ratings;
+
+  //! The number of users.
+  size_t numUsers;
+  //! The number of items.
+  size_t numItems;
+};
+
+}; // namespace svd
+}; // namespace mlpack
+
+#endif
@@ -10,9 +10,11 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/parallel_sgd/parallel_sgd.hpp>
 #include <mlpack/methods/cf/cf.hpp>
 
 #include "regularized_svd_function.hpp"
+#include "rating_triples.hpp"
 
 namespace mlpack {
 namespace svd {
@@ -48,6 +50,11 @@ namespace svd {
  * // Use the Apply() method to get a factorization.
  * rSVD.Apply(data, rank, u, v);
  * @endcode
+ *
+ * Large rating sets can be trained on as RatingTriples, which take half the
+ * memory of a coordinate list, or streamed from disk a chunk at a time, with
+ * the ratings of each chunk shuffled; both paths use plain SGD, whatever the
+ * OptimizerType is.
  */
 
 template<
@@ -62,6 +69,8 @@ class RegularizedSVD
    * training on the passed data. The constructor initiates an object of class
    * RegularizedSVDFunction for optimization. It uses the SGD optimizer by
    * default. The optimizer uses a template specialization of Optimize().
+   * RegularizedSVD<mlpack::optimization::ParallelSGD> trains with lock-free
+   * parallel SGD instead.
    *
    * @param iterations Number of optimization iterations.
    * @param alpha Learning rate for the SGD optimizer.
@@ -83,6 +92,40 @@ class RegularizedSVD
              const size_t rank,
              arma::mat& u,
              arma::mat& v);
+
+  /**
+   * Obtains the user and item matrices from the given ratings, making the
+   * given number of SGD passes over them in their stored order (so they should
+   * be shuffled first; see RatingTriples::Shuffle()).
+   *
+   * @param ratings Ratings to train on.
+   * @param rank Rank parameter to be used for optimization.
+   * @param u Item matrix obtained on decomposition.
+   * @param v User matrix obtained on decomposition.
+   */
+  void Apply(const RatingTriples& ratings,
+             const size_t rank,
+             arma::mat& u,
+             arma::mat& v);
+
+  /**
+   * Obtains the user and item matrices from the (user, item, rating) points of
+   * the given file, which is read chunkSize points at a time, so that only one
+   * chunk is held in memory.  One pass over the file finds the numbers of users
+   * and items; then each SGD pass reads the file again, shuffling the ratings
+   * of each chunk before they are used.
+   *
+   * @param filename Name of the file holding the ratings.
+   * @param rank Rank parameter to be used for optimization.
+   * @param u Item matrix obtained on decomposition.
+   * @param v User matrix obtained on decomposition.
+   * @param chunkSize Number of ratings to read at a time.
+   */
+  void Apply(const std::string& filename,
+             const size_t rank,
+             arma::mat& u,
+             arma::mat& v,
+             const size_t chunkSize = 1000000);
                  
  private:
   //! Number of optimization iterations.
@@ -91,6 +134,18 @@ class RegularizedSVD
   double alpha;
   //! Regularization parameter for the optimization.
   double lambda;
+
+  //! Make one SGD pass over the given ratings.  The parameter matrix holds the
+  //! user vectors, followed by the item vectors.
+  void Pass(const RatingTriples& ratings,
+            const size_t numUsers,
+            arma::mat& parameters) const;
+
+  //! Extract the user and item matrices from the parameters.
+  void Extract(const arma::mat& parameters,
+               const size_t numUsers,
+               arma::mat& u,
+               arma::mat& v) const;
 };
 
 }; // namespace svd
@@ -108,6 +163,16 @@ class FactorizerTraits<mlpack::svd::RegularizedSVD<> >
   static const bool UsesCoordinateList = true;
 };
 
+//! Factorizer traits of Regularized SVD trained with parallel SGD.
+template<>
+class FactorizerTraits<mlpack::svd::RegularizedSVD<
+    mlpack::optimization::ParallelSGD> >
+{
+ public:
+  //! Data provided to RegularizedSVD need not be cleaned.
+  static const bool UsesCoordinateList = true;
+};
+
 }; // namespace cf
 }; // namespace mlpack
 
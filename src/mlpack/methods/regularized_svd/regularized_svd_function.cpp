@@ -116,6 +116,79 @@ void RegularizedSVDFunction::Gradient(const arma::mat& parameters,
   }
 }
 
+void RegularizedSVDFunction::Gradient(const arma::mat& parameters,
+                                      const size_t i,
+                                      arma::sp_mat& gradient) const
+{
+  // Indices for accessing the the correct parameter columns.
+  const size_t user = data(0, i);
+  const size_t item = data(1, i) + numUsers;
+
+  // Prediction error for the example.
+  const double rating = data(2, i);
+  const double ratingError = rating - arma::dot(parameters.col(user),
+                                                parameters.col(item));
+
+  // The user column comes before the item column, so the locations are
+  // already in column-major order.
+  arma::umat locations(2, 2 * rank);
+  arma::vec values(2 * rank);
+  for (size_t j = 0; j < rank; j++)
+  {
+    locations(0, j) = j;
+    locations(1, j) = user;
+    values[j] = 2 * (lambda * parameters(j, user) -
+                     ratingError * parameters(j, item));
+
+    locations(0, rank + j) = j;
+    locations(1, rank + j) = item;
+    values[rank + j] = 2 * (lambda * parameters(j, item) -
+                            ratingError * parameters(j, user));
+  }
+
+  gradient = arma::sp_mat(locations, values, rank, numUsers + numItems);
+}
+
+void RegularizedSVDFunction::BatchErrors(const arma::mat& parameters,
+                                         const size_t begin,
+                                         const size_t batchSize,
+                                         arma::uvec& users,
+                                         arma::uvec& items,
+                                         arma::vec& errors) const
+{
+  const size_t end = begin + batchSize - 1;
+
+  // Indices for accessing the the correct parameter columns.
+  users = arma::conv_to<arma::uvec>::from(data.row(0).subvec(begin, end));
+  items = arma::conv_to<arma::uvec>::from(data.row(1).subvec(begin, end)) +
+      numUsers;
+
+  // The predictions are the column-wise dot products of the user and item
+  // vectors.
+  errors = data.row(2).subvec(begin, end).t() - arma::sum(
+      parameters.cols(users) % parameters.cols(items), 0).t();
+}
+
+void RegularizedSVDFunction::Gradient(const arma::mat& parameters,
+                                      const size_t begin,
+                                      const size_t batchSize,
+                                      arma::mat& gradient) const
+{
+  arma::uvec users, items;
+  arma::vec errors;
+  BatchErrors(parameters, begin, batchSize, users, items, errors);
+
+  // Only the parameter columns of the batch have non-zero gradients.
+  gradient.zeros(rank, numUsers + numItems);
+  for (size_t i = 0; i < batchSize; i++)
+  {
+    gradient.col(users[i]) += 2 * (lambda * parameters.col(users[i]) -
+                                   errors[i] * parameters.col(items[i]));
+    gradient.col(items[i]) += 2 * (lambda * parameters.col(items[i]) -
+                                   errors[i] * parameters.col(users[i]));
+  }
+}
+
 }; // namespace svd
 }; // namespace mlpack
 
@@ -137,7 +210,52 @@ double SGD<mlpack::svd::RegularizedSVDFunction>::Optimize(arma::mat& parameters)
   for(size_t i = 0; i < numFunctions; i++)
     overallObjective += function.Evaluate(parameters, i);
     
-  const arma::mat data = function.Dataset();
+  const arma::mat& data = function.Dataset();
+
+  if (batchSize > 1)
+  {
+    const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+    const double lambda = function.Lambda();
+    arma::uvec users, items;
+    arma::vec errors;
+
+    size_t currentBatch = 0;
+    for (size_t i = 1; i != maxIterations; i++, currentBatch++)
+    {
+      // Is this iteration the start of a sequence?
+      if ((currentBatch % numBatches) == 0)
+      {
+        // Reset the counter variables.
+        overallObjective = 0;
+        currentBatch = 0;
+      }
+
+      const size_t begin = currentBatch * batchSize;
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - begin);
+
+      // The errors are computed with the parameters before the update, so the
+      // update is the average gradient of the batch.
+      function.BatchErrors(parameters, begin, effectiveBatchSize, users, items,
+          errors);
+      const arma::mat userColumns = parameters.cols(users);
+      const arma::mat itemColumns = parameters.cols(items);
+      const double batchStepSize = stepSize / effectiveBatchSize;
+      for (size_t j = 0; j < effectiveBatchSize; j++)
+      {
+        parameters.col(users[j]) -= batchStepSize * (lambda *
+            userColumns.col(j) - errors[j] * itemColumns.col(j));
+        parameters.col(items[j]) -= batchStepSize * (lambda *
+            itemColumns.col(j) - errors[j] * userColumns.col(j));
+      }
+
+      // Now add that to the overall objective function.
+      for (size_t j = begin; j < begin + effectiveBatchSize; j++)
+        overallObjective += function.Evaluate(parameters, j);
+    }
+
+    return overallObjective;
+  }
 
   // Now iterate!
   for(size_t i = 1; i != maxIterations; i++, currentFunction++)
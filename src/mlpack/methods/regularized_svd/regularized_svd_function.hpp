@@ -10,6 +10,7 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/parallel_sgd/parallel_sgd.hpp>
 
 namespace mlpack {
 namespace svd {
@@ -57,6 +58,53 @@ class RegularizedSVDFunction
    */
   void Gradient(const arma::mat& parameters,
                 arma::mat& gradient) const;
+
+  /**
+   * Evaluates the gradient of the cost function for one training example.  Only
+   * the parameter columns of the user and the item of the example are
+   * non-zero, so the gradient is sparse; the ParallelSGD optimizer uses this.
+   *
+   * @param parameters Parameters(user/item matrices) of the decomposition.
+   * @param i Index of the training example to be used.
+   * @param gradient Calculated gradient for the parameters.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::sp_mat& gradient) const;
+
+  /**
+   * Evaluates the sum of the gradients of the cost function over the training
+   * examples begin through (begin + batchSize - 1).  The prediction errors of
+   * the whole batch are computed at once.
+   *
+   * @param parameters Parameters(user/item matrices) of the decomposition.
+   * @param begin Index of the first training example of the batch.
+   * @param batchSize Number of training examples in the batch.
+   * @param gradient Calculated gradient for the parameters.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient) const;
+
+  /**
+   * Compute the prediction errors of the training examples begin through
+   * (begin + batchSize - 1), and the indices of the parameter columns of their
+   * users and items.
+   *
+   * @param parameters Parameters(user/item matrices) of the decomposition.
+   * @param begin Index of the first training example of the batch.
+   * @param batchSize Number of training examples in the batch.
+   * @param users Indices of the user parameter columns.
+   * @param items Indices of the item parameter columns.
+   * @param errors Prediction errors of the examples.
+   */
+  void BatchErrors(const arma::mat& parameters,
+                   const size_t begin,
+                   const size_t batchSize,
+                   arma::uvec& users,
+                   arma::uvec& items,
+                   arma::vec& errors) const;
   
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
@@ -103,7 +151,9 @@ namespace optimization {
   /**
    * Template specialization for SGD optimizer. Used because the gradient
    * affects only a small number of parameters per example, and thus the normal
-   * abstraction does not work as fast as we might like it to.
+   * abstraction does not work as fast as we might like it to.  With a batch
+   * size larger than one, the prediction errors of each mini-batch are computed
+   * at once, and only the parameter columns of the batch are updated.
    */
   template<>
   double SGD<mlpack::svd::RegularizedSVDFunction>::Optimize(
@@ -30,7 +30,7 @@ void RegularizedSVD<OptimizerType>::Apply(const arma::mat& data,
 {
   // Make the optimizer object using a RegularizedSVDFunction object.
   RegularizedSVDFunction rSVDFunc(data, rank, lambda);
-  mlpack::optimization::SGD<RegularizedSVDFunction> optimizer(rSVDFunc, alpha,
+  OptimizerType<RegularizedSVDFunction> optimizer(rSVDFunc, alpha,
       iterations * data.n_cols);
   
   // Get optimized parameters.
@@ -46,6 +46,100 @@ void RegularizedSVD<OptimizerType>::Apply(const arma::mat& data,
   v = parameters.submat(0, 0, rank - 1, numUsers - 1);
 }
 
+template<template<typename> class OptimizerType>
+void RegularizedSVD<OptimizerType>::Apply(const RatingTriples& ratings,
+                                          const size_t rank,
+                                          arma::mat& u,
+                                          arma::mat& v)
+{
+  if (ratings.Size() == 0)
+    Log::Fatal << "RegularizedSVD::Apply(): no ratings given!" << std::endl;
+
+  // The parameters are initialized as RegularizedSVDFunction does.
+  arma::mat parameters;
+  parameters.randu(rank, ratings.NumUsers() + ratings.NumItems());
+
+  for (size_t i = 0; i < iterations; ++i)
+    Pass(ratings, ratings.NumUsers(), parameters);
+
+  Extract(parameters, ratings.NumUsers(), u, v);
+}
+
+template<template<typename> class OptimizerType>
+void RegularizedSVD<OptimizerType>::Apply(const std::string& filename,
+                                          const size_t rank,
+                                          arma::mat& u,
+                                          arma::mat& v,
+                                          const size_t chunkSize)
+{
+  data::ChunkReader reader(filename, true);
+  RatingTriples chunkRatings;
+  arma::mat chunk;
+
+  // The first pass only finds the numbers of users and items; clearing the
+  // ratings keeps them.
+  while (reader.Read(chunk, chunkSize))
+  {
+    chunkRatings.Add(chunk);
+    chunkRatings.Clear();
+  }
+
+  const size_t numUsers = chunkRatings.NumUsers();
+  if (numUsers == 0)
+    Log::Fatal << "RegularizedSVD::Apply(): no ratings in '" << filename
+        << "'!" << std::endl;
+
+  arma::mat parameters;
+  parameters.randu(rank, numUsers + chunkRatings.NumItems());
+
+  for (size_t i = 0; i < iterations; ++i)
+  {
+    reader.Reset();
+    while (reader.Read(chunk, chunkSize))
+    {
+      chunkRatings.Clear();
+      chunkRatings.Add(chunk);
+      chunkRatings.Shuffle();
+
+      Pass(chunkRatings, numUsers, parameters);
+    }
+  }
+
+  Extract(parameters, numUsers, u, v);
+}
+
+template<template<typename> class OptimizerType>
+void RegularizedSVD<OptimizerType>::Pass(const RatingTriples& ratings,
+                                         const size_t numUsers,
+                                         arma::mat& parameters) const
+{
+  // These are the updates of the SGD<RegularizedSVDFunction> specialization.
+  for (size_t i = 0; i < ratings.Size(); ++i)
+  {
+    const size_t user = ratings.User(i);
+    const size_t item = ratings.Item(i) + numUsers;
+
+    const double ratingError = ratings.Rating(i) -
+        arma::dot(parameters.col(user), parameters.col(item));
+
+    parameters.col(user) -= alpha * (lambda * parameters.col(user) -
+                                     ratingError * parameters.col(item));
+    parameters.col(item) -= alpha * (lambda * parameters.col(item) -
+                                     ratingError * parameters.col(user));
+  }
+}
+
+template<template<typename> class OptimizerType>
+void RegularizedSVD<OptimizerType>::Extract(const arma::mat& parameters,
+                                            const size_t numUsers,
+                                            arma::mat& u,
+                                            arma::mat& v) const
+{
+  const size_t rank = parameters.n_rows;
+  u = parameters.submat(0, numUsers, rank - 1, parameters.n_cols - 1).t();
+  v = parameters.submat(0, 0, rank - 1, numUsers - 1);
+}
+
 }; // namespace svd
 }; // namespace mlpack
 
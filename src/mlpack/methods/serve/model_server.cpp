@@ -0,0 +1,257 @@
+/**
+ * @file model_server.cpp
+ *
+ * Implementation of the ModelServer.
+ */
+#include "model_server.hpp"
+
+#include <mlpack/methods/hmm/hmm_util.hpp>
+
+#include <sstream>
+
+using namespace mlpack;
+using namespace mlpack::serve;
+using namespace mlpack::distribution;
+
+ModelServer::ModelServer(const size_t maxBatchPoints,
+                         const size_t batchDelay) :
+    maxBatchPoints(maxBatchPoints),
+    batchDelay(batchDelay),
+    cache(NULL),
+    running(false),
+    batches(0),
+    requests(0)
+{
+  // Nothing to do.
+}
+
+ModelServer::~ModelServer()
+{
+  Stop();
+
+  for (std::map<std::string, ServedModel*>::iterator it = models.begin();
+       it != models.end(); ++it)
+    delete it->second;
+
+  delete cache;
+}
+
+void ModelServer::AddModel(const std::string& name, ServedModel* model)
+{
+  if (models.count(name) > 0)
+    delete models[name];
+  models[name] = model;
+}
+
+void ModelServer::LoadGMM(const std::string& name, const std::string& filename)
+{
+  gmm::GMM<> gmm;
+  gmm.Load(filename);
+  AddModel(name, new GMMModel(gmm));
+
+  Log::Info << "Serving GMM from '" << filename << "' as '" << name << "'."
+      << std::endl;
+}
+
+void ModelServer::LoadHMM(const std::string& name, const std::string& filename)
+{
+  // The type of HMM is stored in the file.
+  util::SaveRestoreUtility sr;
+  if (!sr.ReadFile(filename))
+    Log::Fatal << "Could not read HMM file '" << filename << "'!" << std::endl;
+
+  std::string type;
+  sr.LoadParameter(type, "hmm_type");
+
+  if (type == "discrete")
+  {
+    hmm::HMM<DiscreteDistribution> hmm(1, DiscreteDistribution(1));
+    hmm::LoadHMM(hmm, sr);
+    AddModel(name, new HMMModel<DiscreteDistribution>(hmm));
+  }
+  else if (type == "gaussian")
+  {
+    hmm::HMM<GaussianDistribution> hmm(1, GaussianDistribution(1));
+    hmm::LoadHMM(hmm, sr);
+    AddModel(name, new HMMModel<GaussianDistribution>(hmm));
+  }
+  else if (type == "gmm")
+  {
+    hmm::HMM<gmm::GMM<> > hmm(1, gmm::GMM<>(1, 1));
+    hmm::LoadHMM(hmm, sr);
+    AddModel(name, new HMMModel<gmm::GMM<> >(hmm));
+  }
+  else
+  {
+    Log::Fatal << "Unknown HMM type '" << type << "' in file '" << filename
+        << "'!" << std::endl;
+  }
+
+  Log::Info << "Serving " << type << " HMM from '" << filename << "' as '"
+      << name << "'." << std::endl;
+}
+
+void ModelServer::LoadLinearRegression(const std::string& name,
+                                       const std::string& filename)
+{
+  AddModel(name, new LinearRegressionModel(
+      regression::LinearRegression(filename)));
+
+  Log::Info << "Serving linear regression model from '" << filename << "' as '"
+      << name << "'." << std::endl;
+}
+
+void ModelServer::LoadKNN(const std::string& name,
+                          const std::string& filename,
+                          const size_t leafSize)
+{
+  KNNModel* model = new KNNModel(filename, leafSize);
+  AddModel(name, model);
+
+  Log::Info << "Serving kd-tree on " << model->NumReferences() << " points "
+      << "from '" << filename << "' as '" << name << "'." << std::endl;
+}
+
+void ModelServer::EnableCache(const size_t capacity,
+                              const double resolution,
+                              const size_t shards)
+{
+  delete cache;
+  cache = new QueryCache(capacity, resolution, shards);
+}
+
+CacheStatistics ModelServer::CacheStats() const
+{
+  return (cache == NULL) ? CacheStatistics() : cache->Statistics();
+}
+
+void ModelServer::Start()
+{
+  if (running)
+    return;
+
+  if (pthread_create(&worker, NULL, Work, this) != 0)
+    Log::Fatal << "Could not start the model server's worker thread!"
+        << std::endl;
+  running = true;
+}
+
+void ModelServer::Stop()
+{
+  queue.Shutdown();
+
+  if (running)
+  {
+    pthread_join(worker, NULL);
+    running = false;
+  }
+}
+
+void ModelServer::Handle(Request& request)
+{
+  std::map<std::string, ServedModel*>::const_iterator it =
+      models.find(request.model);
+  if (it == models.end())
+    request.error = "unknown model '" + request.model + "'";
+  else
+    request.error = it->second->Check(request);
+
+  if (!request.error.empty())
+  {
+    request.done = true;
+    return;
+  }
+
+  if (cache != NULL && it->second->Pointwise(request.command))
+  {
+    HandleCached(request);
+    return;
+  }
+
+  queue.Push(request);
+  queue.WaitFor(request);
+}
+
+void ModelServer::HandleCached(Request& request)
+{
+  std::ostringstream oss;
+  oss << request.model << ' ' << request.command << ' ' << request.k;
+  const std::string prefix = oss.str();
+
+  // Look up every point, and collect the ones that are not cached.
+  const arma::mat& points = request.points;
+  std::vector<arma::vec> results(points.n_cols);
+  std::vector<size_t> misses;
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    const arma::vec point(const_cast<double*>(points.colptr(i)), points.n_rows,
+        false, true);
+    if (!cache->Lookup(prefix, point, results[i]))
+      misses.push_back(i);
+  }
+
+  if (!misses.empty())
+  {
+    Request missed;
+    missed.model = request.model;
+    missed.command = request.command;
+    missed.k = request.k;
+    missed.points.set_size(points.n_rows, misses.size());
+    for (size_t j = 0; j < misses.size(); ++j)
+      missed.points.col(j) = points.col(misses[j]);
+
+    queue.Push(missed);
+    queue.WaitFor(missed);
+    if (!missed.error.empty())
+    {
+      request.error = missed.error;
+      request.done = true;
+      return;
+    }
+
+    for (size_t j = 0; j < misses.size(); ++j)
+    {
+      results[misses[j]] = missed.results.col(j);
+      cache->Insert(prefix, missed.points.col(j), results[misses[j]]);
+    }
+  }
+
+  request.results.set_size(results[0].n_elem, points.n_cols);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    request.results.col(i) = results[i];
+  request.done = true;
+}
+
+const ServedModel* ModelServer::Model(const std::string& name) const
+{
+  std::map<std::string, ServedModel*>::const_iterator it = models.find(name);
+  return (it == models.end()) ? NULL : it->second;
+}
+
+std::vector<std::string> ModelServer::Names() const
+{
+  std::vector<std::string> names;
+  for (std::map<std::string, ServedModel*>::const_iterator it = models.begin();
+       it != models.end(); ++it)
+    names.push_back(it->first);
+
+  return names;
+}
+
+void* ModelServer::Work(void* server)
+{
+  ModelServer& s = *((ModelServer*) server);
+
+  std::vector<Request*> batch;
+  while (s.queue.PopBatch(batch, s.maxBatchPoints, s.batchDelay))
+  {
+    // Every request was checked before it was queued, so its model exists.
+    s.models[batch[0]->model]->Process(batch);
+
+    ++s.batches;
+    s.requests += batch.size();
+    s.queue.Complete(batch);
+  }
+
+  return NULL;
+}
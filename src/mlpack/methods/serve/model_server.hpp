@@ -0,0 +1,162 @@
+/**
+ * @file model_server.hpp
+ *
+ * The ModelServer, which keeps trained models in memory and answers requests
+ * for them in batches.
+ */
+#ifndef __MLPACK_METHODS_SERVE_MODEL_SERVER_HPP
+#define __MLPACK_METHODS_SERVE_MODEL_SERVER_HPP
+
+#include <mlpack/core.hpp>
+
+#include <map>
+
+#include "query_cache.hpp"
+#include "request_queue.hpp"
+#include "served_model.hpp"
+
+namespace mlpack {
+namespace serve {
+
+/**
+ * Keeps a set of named models in memory and answers requests for them.  Any
+ * number of threads (one for each connection, say) can call Handle(); each
+ * request is checked, then queued, and a single worker thread takes the
+ * requests off the queue in batches (see RequestQueue) and gives each batch to
+ * its model.  Because only the worker uses the models, they need not be
+ * thread-safe, and the cost of each call to a model (such as building a query
+ * tree) is shared by every request in the batch.
+ *
+ * With EnableCache(), the result of each point is also kept in a QueryCache
+ * (for the commands whose results are pointwise; see ServedModel::Pointwise()).
+ * Handle() then looks up the points of each request itself, and only the
+ * points that are not in the cache are queued, so requests that are entirely
+ * cached are answered without waiting for the worker at all.
+ *
+ * @code
+ * ModelServer server(10000);
+ * server.LoadGMM("gmm", "gmm.xml");
+ * server.Start();
+ *
+ * Request request; // On any thread.
+ * request.model = "gmm";
+ * request.command = "classify";
+ * request.points = points;
+ * server.Handle(request); // Now request.results (or request.error) is set.
+ * @endcode
+ */
+class ModelServer
+{
+ public:
+  /**
+   * Create a server with no models.
+   *
+   * @param maxBatchPoints Number of points after which a batch is full.
+   * @param batchDelay Microseconds the worker waits for a batch to fill.
+   */
+  ModelServer(const size_t maxBatchPoints = 10000,
+              const size_t batchDelay = 0);
+
+  //! Stop the worker (if it is running) and destroy the models.
+  ~ModelServer();
+
+  //! Serve the given model under the given name; the server takes ownership.
+  //! Models must be added before the worker is started.
+  void AddModel(const std::string& name, ServedModel* model);
+
+  //! Load a GMM (saved by gmm) and serve it under the given name.
+  void LoadGMM(const std::string& name, const std::string& filename);
+  //! Load an HMM of any type (saved by hmm_train) and serve it under the given
+  //! name.
+  void LoadHMM(const std::string& name, const std::string& filename);
+  //! Load a linear regression model (saved by linear_regression) and serve it
+  //! under the given name.
+  void LoadLinearRegression(const std::string& name,
+                            const std::string& filename);
+  //! Load a tree file (saved by allknn --save_tree) and serve it under the
+  //! given name.
+  void LoadKNN(const std::string& name,
+               const std::string& filename,
+               const size_t leafSize = 20);
+
+  /**
+   * Cache the result of every point for which a pointwise command is run.
+   * This must be called before the worker is started.
+   *
+   * @param capacity Number of results to hold.
+   * @param resolution Coordinates are rounded to multiples of this to make the
+   *     keys (0 for exact keys; see QueryCache).
+   * @param shards Number of independently locked shards of the cache.
+   */
+  void EnableCache(const size_t capacity,
+                   const double resolution = 0.0,
+                   const size_t shards = 16);
+
+  //! Start the worker thread.
+  void Start();
+
+  //! Answer every queued request with an error and stop the worker thread.
+  void Stop();
+
+  /**
+   * Answer the given request, waiting until it is answered.  If it cannot be
+   * answered, its error is set instead of its results.  This is thread-safe,
+   * but the worker must have been started.
+   *
+   * @param request Request to answer.
+   */
+  void Handle(Request& request);
+
+  //! Return the served model with the given name, or NULL if there is none.
+  const ServedModel* Model(const std::string& name) const;
+
+  //! Return the names of the served models.
+  std::vector<std::string> Names() const;
+
+  //! Get the number of batches answered.
+  size_t Batches() const { return batches; }
+  //! Get the number of requests answered.
+  size_t Requests() const { return requests; }
+
+  //! Return the statistics of the cache (all zero if there is no cache).
+  CacheStatistics CacheStats() const;
+
+ private:
+  //! The served models, by name.
+  std::map<std::string, ServedModel*> models;
+  //! The queue of checked requests.
+  RequestQueue queue;
+  //! Number of points after which a batch is full.
+  size_t maxBatchPoints;
+  //! Microseconds the worker waits for a batch to fill.
+  size_t batchDelay;
+  //! The cache of results (NULL if there is none).
+  QueryCache* cache;
+
+  //! Whether or not the worker thread is running.
+  bool running;
+  //! The worker thread.
+  pthread_t worker;
+
+  //! Number of batches answered (only changed by the worker).
+  size_t batches;
+  //! Number of requests answered (only changed by the worker).
+  size_t requests;
+
+  //! Answer the given checked request, with the results of its points that
+  //! are in the cache, and by queueing the rest.
+  void HandleCached(Request& request);
+
+  //! Take batches off the queue and answer them until the queue is shut down.
+  static void* Work(void* server);
+
+  //! Not copyable.
+  ModelServer(const ModelServer& other);
+  //! Not copyable.
+  ModelServer& operator=(const ModelServer& other);
+};
+
+}; // namespace serve
+}; // namespace mlpack
+
+#endif
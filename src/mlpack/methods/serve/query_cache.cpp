@@ -0,0 +1,166 @@
+/**
+ * @file query_cache.cpp
+ *
+ * Implementation of the QueryCache.
+ */
+#include "query_cache.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <boost/cstdint.hpp>
+
+using namespace mlpack;
+using namespace mlpack::serve;
+
+void CacheStatistics::Print() const
+{
+  Log::Info << "Query cache: " << hits << " hits and " << misses << " misses "
+      << "(hit rate " << (100.0 * HitRate()) << "%), " << insertions
+      << " insertions, " << evictions << " evictions, " << entries
+      << " entries." << std::endl;
+}
+
+CacheStatistics& CacheStatistics::operator+=(const CacheStatistics& other)
+{
+  hits += other.hits;
+  misses += other.misses;
+  insertions += other.insertions;
+  evictions += other.evictions;
+  entries += other.entries;
+  return *this;
+}
+
+QueryCache::QueryCache(const size_t capacity,
+                       const double resolution,
+                       const size_t shardCount) :
+    resolution(resolution)
+{
+  const size_t count = std::max(shardCount, (size_t) 1);
+  shardCapacity = std::max((capacity + count - 1) / count, (size_t) 1);
+
+  shards.resize(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    shards[i] = new Shard;
+    pthread_mutex_init(&shards[i]->lock, NULL);
+  }
+}
+
+QueryCache::~QueryCache()
+{
+  for (size_t i = 0; i < shards.size(); ++i)
+  {
+    pthread_mutex_destroy(&shards[i]->lock);
+    delete shards[i];
+  }
+}
+
+bool QueryCache::Lookup(const std::string& prefix,
+                        const arma::vec& point,
+                        arma::vec& result)
+{
+  const std::string key = Key(prefix, point);
+  Shard& shard = ShardOf(key);
+
+  pthread_mutex_lock(&shard.lock);
+  boost::unordered_map<std::string, std::list<Entry>::iterator>::iterator it =
+      shard.index.find(key);
+  const bool found = (it != shard.index.end());
+  if (found)
+  {
+    // This is now the most recently used result.
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    result = it->second->result;
+    ++shard.statistics.hits;
+  }
+  else
+  {
+    ++shard.statistics.misses;
+  }
+  pthread_mutex_unlock(&shard.lock);
+
+  return found;
+}
+
+void QueryCache::Insert(const std::string& prefix,
+                        const arma::vec& point,
+                        const arma::vec& result)
+{
+  const std::string key = Key(prefix, point);
+  Shard& shard = ShardOf(key);
+
+  pthread_mutex_lock(&shard.lock);
+  boost::unordered_map<std::string, std::list<Entry>::iterator>::iterator it =
+      shard.index.find(key);
+  if (it != shard.index.end())
+  {
+    // Another thread got here first; keep the newer result.
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    it->second->result = result;
+  }
+  else
+  {
+    if (shard.entries.size() >= shardCapacity)
+    {
+      shard.index.erase(shard.entries.back().key);
+      shard.entries.pop_back();
+      ++shard.statistics.evictions;
+      --shard.statistics.entries;
+    }
+
+    shard.entries.push_front(Entry());
+    shard.entries.front().key = key;
+    shard.entries.front().result = result;
+    shard.index[key] = shard.entries.begin();
+    ++shard.statistics.entries;
+  }
+  ++shard.statistics.insertions;
+  pthread_mutex_unlock(&shard.lock);
+}
+
+CacheStatistics QueryCache::Statistics() const
+{
+  CacheStatistics statistics;
+  for (size_t i = 0; i < shards.size(); ++i)
+  {
+    pthread_mutex_lock(&shards[i]->lock);
+    statistics += shards[i]->statistics;
+    pthread_mutex_unlock(&shards[i]->lock);
+  }
+
+  return statistics;
+}
+
+std::string QueryCache::Key(const std::string& prefix,
+                            const arma::vec& point) const
+{
+  // The prefix, a separator, and the bytes of the rounded coordinates.
+  std::string key(prefix);
+  key += '\0';
+  key.reserve(key.size() + point.n_elem * sizeof(double));
+  for (size_t i = 0; i < point.n_elem; ++i)
+  {
+    double value = (resolution > 0.0) ?
+        std::floor(point[i] / resolution + 0.5) : point[i];
+    value += 0.0; // So that -0 and 0 have the same key.
+
+    char bytes[sizeof(double)];
+    memcpy(bytes, &value, sizeof(double));
+    key.append(bytes, sizeof(double));
+  }
+
+  return key;
+}
+
+QueryCache::Shard& QueryCache::ShardOf(const std::string& key) const
+{
+  // FNV-1a; the shards' maps use boost::hash, so the two are independent.
+  boost::uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < key.size(); ++i)
+  {
+    hash ^= (unsigned char) key[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return *shards[hash % shards.size()];
+}
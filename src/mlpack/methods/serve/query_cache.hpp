@@ -0,0 +1,161 @@
+/**
+ * @file query_cache.hpp
+ *
+ * A thread-safe LRU cache of the results of single points, for the model
+ * server.
+ */
+#ifndef __MLPACK_METHODS_SERVE_QUERY_CACHE_HPP
+#define __MLPACK_METHODS_SERVE_QUERY_CACHE_HPP
+
+#include <mlpack/core.hpp>
+
+#include <list>
+#include <pthread.h>
+#include <boost/unordered_map.hpp>
+
+namespace mlpack {
+namespace serve {
+
+/**
+ * Counts of what a QueryCache has done.
+ */
+struct CacheStatistics
+{
+  CacheStatistics() : hits(0), misses(0), insertions(0), evictions(0),
+      entries(0) { }
+
+  //! Number of lookups that found a result.
+  size_t hits;
+  //! Number of lookups that found nothing.
+  size_t misses;
+  //! Number of results inserted.
+  size_t insertions;
+  //! Number of results evicted to make room for others.
+  size_t evictions;
+  //! Number of results held.
+  size_t entries;
+
+  //! Return the fraction of lookups that found a result (0 if there were
+  //! none).
+  double HitRate() const
+  {
+    return (hits + misses == 0) ? 0.0 : (double) hits / (hits + misses);
+  }
+
+  //! Print the statistics to Log::Info.
+  void Print() const;
+
+  //! Add the counts of the given statistics to these.
+  CacheStatistics& operator+=(const CacheStatistics& other);
+};
+
+/**
+ * A cache of the result (a vector) of each point that a command has been run
+ * on, so that the results of repeated queries can be returned without running
+ * the command again.  The least recently used results are evicted once the
+ * cache holds 'capacity' results.
+ *
+ * Each point is looked up by a key made of a prefix (which should identify the
+ * model, the command and its parameter) and the point's coordinates, each
+ * rounded to a multiple of the resolution.  With a resolution of 0, only points
+ * that are exactly the same share results; with a larger resolution, points
+ * that round to the same coordinates (that is, near-identical points) share
+ * the result of whichever of them was run first, so the results are
+ * approximate.
+ *
+ * The cache is split into shards by the hash of the key, each with its own
+ * lock and its own share of the capacity, so that many threads can use it at
+ * once without waiting for each other.
+ */
+class QueryCache
+{
+ public:
+  /**
+   * Create an empty cache.
+   *
+   * @param capacity Number of results to hold (divided between the shards).
+   * @param resolution Coordinates are rounded to multiples of this in keys
+   *     (0 for exact keys).
+   * @param shards Number of independently locked shards.
+   */
+  QueryCache(const size_t capacity,
+             const double resolution = 0.0,
+             const size_t shards = 16);
+
+  //! Destroy the cache.  No thread may still be using it.
+  ~QueryCache();
+
+  /**
+   * Look up the result of the given point.
+   *
+   * @param prefix Prefix of the key (the model, command and parameter).
+   * @param point Point to look up.
+   * @param result Vector to store the result in, if it is found.
+   * @return Whether or not the result was found.
+   */
+  bool Lookup(const std::string& prefix,
+              const arma::vec& point,
+              arma::vec& result);
+
+  /**
+   * Store the result of the given point, evicting the least recently used
+   * result of its shard if the shard is full.
+   *
+   * @param prefix Prefix of the key (the model, command and parameter).
+   * @param point Point the result is for.
+   * @param result Result to store.
+   */
+  void Insert(const std::string& prefix,
+              const arma::vec& point,
+              const arma::vec& result);
+
+  //! Return the statistics of every shard, combined.
+  CacheStatistics Statistics() const;
+
+  //! Get the resolution of the keys.
+  double Resolution() const { return resolution; }
+
+ private:
+  //! A result, and its key.
+  struct Entry
+  {
+    std::string key;
+    arma::vec result;
+  };
+
+  //! One independently locked part of the cache.
+  struct Shard
+  {
+    //! The results, from most to least recently used.
+    std::list<Entry> entries;
+    //! The results by key.
+    boost::unordered_map<std::string, std::list<Entry>::iterator> index;
+    //! The counts for this shard.
+    CacheStatistics statistics;
+    //! Lock for everything above.
+    pthread_mutex_t lock;
+  };
+
+  //! The shards.
+  std::vector<Shard*> shards;
+  //! Number of results each shard holds.
+  size_t shardCapacity;
+  //! Coordinates are rounded to multiples of this (0 for exact keys).
+  double resolution;
+
+  //! Make the key of the given point.
+  std::string Key(const std::string& prefix, const arma::vec& point) const;
+
+  //! Return the shard the given key belongs to.
+  Shard& ShardOf(const std::string& key) const;
+
+  //! Not copyable.
+  QueryCache(const QueryCache& other);
+  //! Not copyable.
+  QueryCache& operator=(const QueryCache& other);
+};
+
+}; // namespace serve
+}; // namespace mlpack
+
+#endif
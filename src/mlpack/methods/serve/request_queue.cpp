@@ -0,0 +1,143 @@
+/**
+ * @file request_queue.cpp
+ *
+ * Implementation of the RequestQueue.
+ */
+#include "request_queue.hpp"
+
+#include <sys/time.h>
+
+using namespace mlpack;
+using namespace mlpack::serve;
+
+RequestQueue::RequestQueue() : shutdown(false)
+{
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&pushed, NULL);
+  pthread_cond_init(&completed, NULL);
+}
+
+RequestQueue::~RequestQueue()
+{
+  pthread_cond_destroy(&completed);
+  pthread_cond_destroy(&pushed);
+  pthread_mutex_destroy(&lock);
+}
+
+void RequestQueue::Push(Request& request)
+{
+  pthread_mutex_lock(&lock);
+  if (shutdown)
+  {
+    request.error = "the server is shutting down";
+    request.done = true;
+  }
+  else
+  {
+    request.done = false;
+    requests.push_back(&request);
+    pthread_cond_signal(&pushed);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+bool RequestQueue::PopBatch(std::vector<Request*>& batch,
+                            const size_t maxPoints,
+                            const size_t delay)
+{
+  batch.clear();
+
+  pthread_mutex_lock(&lock);
+  while (requests.empty() && !shutdown)
+    pthread_cond_wait(&pushed, &lock);
+
+  if (shutdown)
+  {
+    pthread_mutex_unlock(&lock);
+    return false;
+  }
+
+  size_t points = 0;
+  Collect(batch, points, maxPoints);
+
+  if (delay > 0 && points < maxPoints)
+  {
+    // Wait until the deadline for more requests that can join the batch.
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    const size_t microseconds = (size_t) now.tv_usec + delay;
+    struct timespec deadline;
+    deadline.tv_sec = now.tv_sec + (time_t) (microseconds / 1000000);
+    deadline.tv_nsec = (long) (microseconds % 1000000) * 1000;
+
+    while (points < maxPoints && !shutdown &&
+           pthread_cond_timedwait(&pushed, &lock, &deadline) == 0)
+      Collect(batch, points, maxPoints);
+    if (points < maxPoints)
+      Collect(batch, points, maxPoints);
+  }
+
+  pthread_mutex_unlock(&lock);
+  return true;
+}
+
+void RequestQueue::Collect(std::vector<Request*>& batch,
+                           size_t& points,
+                           const size_t maxPoints)
+{
+  std::list<Request*>::iterator it = requests.begin();
+  while (it != requests.end() && (batch.empty() || points < maxPoints))
+  {
+    if (batch.empty() || (*it)->Batches(*batch[0]))
+    {
+      points += (*it)->points.n_cols;
+      batch.push_back(*it);
+      it = requests.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void RequestQueue::Complete(const std::vector<Request*>& batch)
+{
+  pthread_mutex_lock(&lock);
+  for (size_t i = 0; i < batch.size(); ++i)
+    batch[i]->done = true;
+  pthread_cond_broadcast(&completed);
+  pthread_mutex_unlock(&lock);
+}
+
+void RequestQueue::WaitFor(const Request& request)
+{
+  pthread_mutex_lock(&lock);
+  while (!request.done)
+    pthread_cond_wait(&completed, &lock);
+  pthread_mutex_unlock(&lock);
+}
+
+void RequestQueue::Shutdown()
+{
+  pthread_mutex_lock(&lock);
+  shutdown = true;
+  for (std::list<Request*>::iterator it = requests.begin();
+       it != requests.end(); ++it)
+  {
+    (*it)->error = "the server is shutting down";
+    (*it)->done = true;
+  }
+  requests.clear();
+  pthread_cond_broadcast(&pushed);
+  pthread_cond_broadcast(&completed);
+  pthread_mutex_unlock(&lock);
+}
+
+size_t RequestQueue::Size()
+{
+  pthread_mutex_lock(&lock);
+  const size_t size = requests.size();
+  pthread_mutex_unlock(&lock);
+  return size;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file request_queue.hpp
+ *
+ * The queue of prediction and search requests that the model server answers in
+ * batches.
+ */
+#ifndef __MLPACK_METHODS_SERVE_REQUEST_QUEUE_HPP
+#define __MLPACK_METHODS_SERVE_REQUEST_QUEUE_HPP
+
+#include <mlpack/core.hpp>
+
+#include <list>
+#include <pthread.h>
+
+namespace mlpack {
+namespace serve {
+
+/**
+ * A request for one of the served models: a command, its parameter, and the
+ * points it is to be run on.  Once it has been answered, either the results
+ * hold one column for each line of the answer, or the error is set.
+ */
+struct Request
+{
+  Request() : k(0), done(false) { }
+
+  //! Name of the model the request is for.
+  std::string model;
+  //! Command to run ("classify", "knn", and so on).
+  std::string command;
+  //! Parameter of the command (the number of neighbors, for "knn").
+  size_t k;
+  //! Points (or, for HMMs, the observation sequence), one per column.
+  arma::mat points;
+
+  //! The answer, one column per line.
+  arma::mat results;
+  //! Why the request could not be answered (empty if it was).
+  std::string error;
+  //! Whether or not the request has been answered.
+  bool done;
+
+  //! Return whether or not the request can be answered in the same batch as
+  //! the given request.
+  bool Batches(const Request& other) const
+  {
+    return (model == other.model) && (command == other.command) &&
+        (k == other.k);
+  }
+};
+
+/**
+ * A thread-safe queue of requests.  Connections Push() requests and wait in
+ * WaitFor() while a worker takes them off the queue in batches with PopBatch():
+ * the requests of a batch all have the same model, command and parameter, so a
+ * batch can be answered with one call to the model (one tree search, say)
+ * instead of one call per request.
+ *
+ * To collect larger batches when requests are arriving quickly, PopBatch() can
+ * wait a little for more requests after the first one arrives.
+ */
+class RequestQueue
+{
+ public:
+  //! Create an empty queue.
+  RequestQueue();
+
+  //! Destroy the queue.  No thread may still be using it.
+  ~RequestQueue();
+
+  //! Add the given request to the end of the queue.  If the queue has been
+  //! shut down, the request is answered with an error immediately.
+  void Push(Request& request);
+
+  /**
+   * Wait for a request, then take it off the queue along with the requests
+   * behind it that can be answered in the same batch, until the batch has
+   * maxPoints points (the first request is always taken, however many points it
+   * has).  If the batch is not full, wait up to 'delay' microseconds for more
+   * requests to join it.
+   *
+   * @param batch Vector to store the requests of the batch in.
+   * @param maxPoints Number of points after which the batch is full.
+   * @param delay Microseconds to wait for a batch to fill.
+   * @return false if the queue has been shut down (so there is no batch).
+   */
+  bool PopBatch(std::vector<Request*>& batch,
+                const size_t maxPoints,
+                const size_t delay = 0);
+
+  //! Mark the requests of the given batch as answered, waking the threads
+  //! waiting for them.
+  void Complete(const std::vector<Request*>& batch);
+
+  //! Wait until the given request (which must have been pushed) is answered.
+  void WaitFor(const Request& request);
+
+  //! Answer every queued request with an error, and make PopBatch() return
+  //! false from now on.
+  void Shutdown();
+
+  //! Return the number of queued requests.
+  size_t Size();
+
+ private:
+  //! The queued requests.
+  std::list<Request*> requests;
+  //! Whether or not Shutdown() has been called.
+  bool shutdown;
+
+  //! Lock for everything above, and for the 'done' flag of every request.
+  pthread_mutex_t lock;
+  //! Signalled when a request is pushed (or the queue is shut down).
+  pthread_cond_t pushed;
+  //! Signalled when requests are answered.
+  pthread_cond_t completed;
+
+  //! Take the requests that can join the batch off the queue; the lock must be
+  //! held.
+  void Collect(std::vector<Request*>& batch,
+               size_t& points,
+               const size_t maxPoints);
+
+  //! Not copyable.
+  RequestQueue(const RequestQueue& other);
+  //! Not copyable.
+  RequestQueue& operator=(const RequestQueue& other);
+};
+
+}; // namespace serve
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,511 @@
+/**
+ * @file serve_main.cpp
+ *
+ * A long-running server that loads trained models once and answers batched
+ * prediction and search requests for them over a socket.
+ */
+#include <mlpack/core.hpp>
+
+#include "model_server.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace mlpack;
+using namespace mlpack::serve;
+using namespace std;
+
+PROGRAM_INFO("Model Server", "This program loads trained models once and "
+    "keeps them in memory, answering prediction and search requests for them "
+    "over a TCP socket (--port) or a UNIX socket (--socket) until it is "
+    "interrupted.  The models it can serve are a GMM saved by gmm "
+    "(--gmm_file), an HMM saved by hmm_train (--hmm_file), a linear regression "
+    "model saved by linear_regression (--linear_regression_file), and a "
+    "kd-tree saved by allknn --save_tree (--tree_file).  Each is served under "
+    "the name 'gmm', 'hmm', 'linear_regression' or 'knn'."
+    "\n\n"
+    "Each request is a header line, followed by the points, one per line, with "
+    "values separated by commas or spaces:"
+    "\n\n"
+    "  <model> <command> <number of points> [<k>]"
+    "\n\n"
+    "The commands are 'probability' and 'classify' (GMM), 'viterbi' and "
+    "'loglik' (HMM; the points are one sequence of observations), 'predict' "
+    "(linear regression), and 'knn' (which takes the number of neighbors, k, "
+    "and gives the indices of the k nearest neighbors of each point followed "
+    "by their distances).  The answer is either 'ok <number of lines>', "
+    "followed by that many lines (one per point, except for 'loglik'), or "
+    "'error <reason>'.  The header 'models' lists the served models and their "
+    "dimensionalities, and 'quit' closes the connection."
+    "\n\n"
+    "Requests are queued, and requests for the same model, command and k are "
+    "answered together in batches of up to --max_batch points (so, for "
+    "instance, one tree search answers many small 'knn' requests).  When "
+    "requests are arriving quickly, --batch_delay gives the queue time to "
+    "fill a batch."
+    "\n\n"
+    "With --cache_size, the results of up to that many points are cached (for "
+    "every command but those of HMMs), and requests whose points have all been "
+    "seen before are answered from the cache without being queued.  With "
+    "--cache_resolution, coordinates are rounded to multiples of that value "
+    "before they are looked up, so that near-identical points share results.  "
+    "The header 'stats' gives the number of requests and batches the models "
+    "have answered, and the hits, misses and hit rate of the cache.");
+
+PARAM_STRING("gmm_file", "File containing a GMM to serve.", "g", "");
+PARAM_STRING("hmm_file", "File containing an HMM to serve.", "m", "");
+PARAM_STRING("linear_regression_file", "File containing a linear regression "
+    "model to serve.", "r", "");
+PARAM_STRING("tree_file", "Tree file saved by allknn --save_tree to serve "
+    "nearest neighbor searches on.", "t", "");
+PARAM_INT("leaf_size", "Leaf size of the query trees built for nearest "
+    "neighbor searches.", "l", 20);
+
+PARAM_INT("port", "TCP port to listen on.", "p", 0);
+PARAM_FLAG("all_interfaces", "Listen on every network interface, instead of "
+    "only the loopback interface (with --port).", "a");
+PARAM_STRING("socket", "Path of a UNIX socket to listen on.", "s", "");
+
+PARAM_INT("max_batch", "Number of points after which a batch is full.", "b",
+    10000);
+PARAM_INT("batch_delay", "Microseconds to wait for a batch to fill once its "
+    "first request has arrived.", "d", 0);
+
+PARAM_INT("cache_size", "Number of point results to cache (0 for no cache).",
+    "c", 0);
+PARAM_DOUBLE("cache_resolution", "Coordinates are rounded to multiples of this "
+    "to look up cached results (0 for exact lookups).", "", 0.0);
+PARAM_INT("cache_shards", "Number of independently locked shards of the cache.",
+    "", 16);
+
+// Set when the server is interrupted.
+static volatile sig_atomic_t interrupted = 0;
+
+static void Interrupt(int /* signal */)
+{
+  interrupted = 1;
+}
+
+/**
+ * The open connections, so that they can be closed when the server is
+ * interrupted.
+ */
+class Connections
+{
+ public:
+  Connections()
+  {
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&closed, NULL);
+  }
+
+  ~Connections()
+  {
+    pthread_cond_destroy(&closed);
+    pthread_mutex_destroy(&lock);
+  }
+
+  void Add(const int fd)
+  {
+    pthread_mutex_lock(&lock);
+    fds.insert(fd);
+    pthread_mutex_unlock(&lock);
+  }
+
+  void Remove(const int fd)
+  {
+    pthread_mutex_lock(&lock);
+    fds.erase(fd);
+    close(fd);
+    pthread_cond_broadcast(&closed);
+    pthread_mutex_unlock(&lock);
+  }
+
+  //! Shut down every connection, and wait for them all to be closed.
+  void CloseAll()
+  {
+    pthread_mutex_lock(&lock);
+    for (std::set<int>::iterator it = fds.begin(); it != fds.end(); ++it)
+      shutdown(*it, SHUT_RDWR);
+    while (!fds.empty())
+      pthread_cond_wait(&closed, &lock);
+    pthread_mutex_unlock(&lock);
+  }
+
+ private:
+  std::set<int> fds;
+  pthread_mutex_t lock;
+  pthread_cond_t closed;
+};
+
+/**
+ * Reads lines from a socket, through a buffer.
+ */
+class LineReader
+{
+ public:
+  LineReader(const int fd) : fd(fd), begin(0), end(0) { }
+
+  //! Read the next line (without its newline); return false at the end.
+  bool ReadLine(std::string& line)
+  {
+    line.clear();
+    while (true)
+    {
+      if (begin == end)
+      {
+        const ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR)
+          continue;
+        if (count <= 0)
+          return !line.empty();
+
+        begin = 0;
+        end = (size_t) count;
+      }
+
+      const char* newline = (const char*) memchr(buffer + begin, '\n',
+          end - begin);
+      if (newline == NULL)
+      {
+        line.append(buffer + begin, end - begin);
+        begin = end;
+        continue;
+      }
+
+      line.append(buffer + begin, newline - (buffer + begin));
+      begin = (newline - buffer) + 1;
+      if (!line.empty() && line[line.size() - 1] == '\r')
+        line.erase(line.size() - 1);
+      return true;
+    }
+  }
+
+ private:
+  int fd;
+  char buffer[65536];
+  size_t begin;
+  size_t end;
+};
+
+//! Write all of the given string to the socket.
+static bool WriteAll(const int fd, const std::string& data)
+{
+  size_t written = 0;
+  while (written < data.size())
+  {
+    const ssize_t count = write(fd, data.data() + written,
+        data.size() - written);
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count <= 0)
+      return false;
+    written += (size_t) count;
+  }
+
+  return true;
+}
+
+//! Parse a line of values separated by commas or whitespace.
+static bool ParsePoint(const std::string& line, std::vector<double>& values)
+{
+  const char* position = line.c_str();
+  while (true)
+  {
+    while (*position == ',' || *position == ' ' || *position == '\t')
+      ++position;
+    if (*position == '\0')
+      return true;
+
+    char* next;
+    const double value = strtod(position, &next);
+    if (next == position)
+      return false;
+    values.push_back(value);
+    position = next;
+  }
+}
+
+//! The state of a connection thread.
+struct Connection
+{
+  int fd;
+  ModelServer* server;
+  Connections* connections;
+};
+
+//! Answer the requests of one connection until it is closed.
+static void* Serve(void* argument)
+{
+  Connection* connection = (Connection*) argument;
+  const int fd = connection->fd;
+  ModelServer& server = *connection->server;
+
+  LineReader reader(fd);
+  std::string line;
+  while (reader.ReadLine(line))
+  {
+    std::istringstream header(line);
+    Request request;
+    size_t count = 0;
+    if (!(header >> request.model))
+      continue; // Blank line.
+    if (request.model == "quit")
+      break;
+
+    std::ostringstream answer;
+    if (request.model == "models")
+    {
+      const std::vector<std::string> names = server.Names();
+      answer << "ok " << names.size() << "\n";
+      for (size_t i = 0; i < names.size(); ++i)
+        answer << names[i] << " " << server.Model(names[i])->Dimensionality()
+            << "\n";
+      if (!WriteAll(fd, answer.str()))
+        break;
+      continue;
+    }
+
+    if (request.model == "stats")
+    {
+      const CacheStatistics cache = server.CacheStats();
+      answer << "ok 6\n" << "requests " << server.Requests() << "\n"
+          << "batches " << server.Batches() << "\n"
+          << "cache_hits " << cache.hits << "\n"
+          << "cache_misses " << cache.misses << "\n"
+          << "cache_hit_rate " << cache.HitRate() << "\n"
+          << "cache_entries " << cache.entries << "\n";
+      if (!WriteAll(fd, answer.str()))
+        break;
+      continue;
+    }
+
+    if (!(header >> request.command >> count))
+    {
+      WriteAll(fd, "error malformed header '" + line + "'\n");
+      break;
+    }
+    header >> request.k;
+
+    // Read the points; their dimensionality is set by the first.  After an
+    // error, the rest of the points are still read (and ignored).
+    std::vector<double> values;
+    size_t dimensionality = 0;
+    size_t read = 0;
+    for (; read < count && reader.ReadLine(line); ++read)
+    {
+      if (!request.error.empty())
+        continue;
+
+      const size_t before = values.size();
+      if (!ParsePoint(line, values))
+        request.error = "cannot parse point '" + line + "'";
+      else if (read == 0)
+        dimensionality = values.size();
+      else if (values.size() - before != dimensionality)
+        request.error = "points have different dimensionalities";
+    }
+    if (read < count)
+      break;
+
+    if (request.error.empty())
+    {
+      request.points.set_size(dimensionality, count);
+      if (count > 0)
+        std::copy(values.begin(), values.end(), request.points.begin());
+      server.Handle(request);
+    }
+
+    if (request.error.empty())
+    {
+      answer << "ok " << request.results.n_cols << "\n";
+      data::FormatText(answer, request.results, ' ', true, false);
+    }
+    else
+    {
+      answer << "error " << request.error << "\n";
+    }
+
+    if (!WriteAll(fd, answer.str()))
+      break;
+  }
+
+  connection->connections->Remove(fd);
+  delete connection;
+  return NULL;
+}
+
+//! Open the listening socket given by the options.
+static int Listen()
+{
+  const size_t port = (size_t) CLI::GetParam<int>("port");
+  const string socketFile = CLI::GetParam<string>("socket");
+
+  if ((port == 0) == socketFile.empty())
+    Log::Fatal << "Exactly one of --port and --socket must be specified."
+        << endl;
+
+  int fd;
+  if (port != 0)
+  {
+    if (port > 65535)
+      Log::Fatal << "Invalid port " << port << "." << endl;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    const int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t) port);
+    address.sin_addr.s_addr = htonl(CLI::HasParam("all_interfaces") ?
+        INADDR_ANY : INADDR_LOOPBACK);
+
+    if (fd < 0 || bind(fd, (sockaddr*) &address, sizeof(address)) != 0)
+      Log::Fatal << "Cannot listen on port " << port << ": "
+          << strerror(errno) << "." << endl;
+  }
+  else
+  {
+    sockaddr_un address;
+    if (socketFile.size() >= sizeof(address.sun_path))
+      Log::Fatal << "Socket path '" << socketFile << "' is too long." << endl;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketFile.c_str());
+    unlink(socketFile.c_str());
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (sockaddr*) &address, sizeof(address)) != 0)
+      Log::Fatal << "Cannot listen on socket '" << socketFile << "': "
+          << strerror(errno) << "." << endl;
+  }
+
+  if (listen(fd, SOMAXCONN) != 0)
+    Log::Fatal << "Cannot listen: " << strerror(errno) << "." << endl;
+
+  return fd;
+}
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const int leafSize = CLI::GetParam<int>("leaf_size");
+  const int maxBatch = CLI::GetParam<int>("max_batch");
+  const int batchDelay = CLI::GetParam<int>("batch_delay");
+  if (leafSize <= 0)
+    Log::Fatal << "Invalid leaf size " << leafSize << "; must be greater than "
+        << "0." << endl;
+  if (maxBatch <= 0)
+    Log::Fatal << "Invalid batch size " << maxBatch << "; must be greater "
+        << "than 0." << endl;
+  if (batchDelay < 0)
+    Log::Fatal << "Invalid batch delay " << batchDelay << "; must be at least "
+        << "0." << endl;
+
+  const int cacheSize = CLI::GetParam<int>("cache_size");
+  const double cacheResolution = CLI::GetParam<double>("cache_resolution");
+  const int cacheShards = CLI::GetParam<int>("cache_shards");
+  if (cacheSize < 0)
+    Log::Fatal << "Invalid cache size " << cacheSize << "; must be at least 0."
+        << endl;
+  if (cacheResolution < 0.0)
+    Log::Fatal << "Invalid cache resolution " << cacheResolution << "; must be "
+        << "at least 0." << endl;
+  if (cacheShards <= 0)
+    Log::Fatal << "Invalid number of cache shards " << cacheShards << "; must "
+        << "be greater than 0." << endl;
+
+  ModelServer server((size_t) maxBatch, (size_t) batchDelay);
+  if (cacheSize > 0)
+    server.EnableCache((size_t) cacheSize, cacheResolution,
+        (size_t) cacheShards);
+
+  Timer::Start("loading");
+  if (CLI::HasParam("gmm_file"))
+    server.LoadGMM("gmm", CLI::GetParam<string>("gmm_file"));
+  if (CLI::HasParam("hmm_file"))
+    server.LoadHMM("hmm", CLI::GetParam<string>("hmm_file"));
+  if (CLI::HasParam("linear_regression_file"))
+    server.LoadLinearRegression("linear_regression",
+        CLI::GetParam<string>("linear_regression_file"));
+  if (CLI::HasParam("tree_file"))
+    server.LoadKNN("knn", CLI::GetParam<string>("tree_file"),
+        (size_t) leafSize);
+  Timer::Stop("loading");
+
+  if (server.Names().empty())
+    Log::Fatal << "No models given; specify at least one of --gmm_file, "
+        << "--hmm_file, --linear_regression_file, and --tree_file." << endl;
+
+  const int listener = Listen();
+
+  // Closed connections must not kill the server, and interruption must stop
+  // accept() (so SA_RESTART is not given).
+  signal(SIGPIPE, SIG_IGN);
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = Interrupt;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  server.Start();
+  Log::Info << "Serving requests." << endl;
+
+  Connections connections;
+  while (!interrupted)
+  {
+    const int fd = accept(listener, NULL, NULL);
+    if (fd < 0)
+    {
+      if (errno != EINTR)
+        Log::Warn << "Cannot accept connection: " << strerror(errno) << "."
+            << endl;
+      continue;
+    }
+
+    Connection* connection = new Connection;
+    connection->fd = fd;
+    connection->server = &server;
+    connection->connections = &connections;
+    connections.Add(fd);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, Serve, connection) != 0)
+    {
+      Log::Warn << "Cannot start a thread for a new connection." << endl;
+      connections.Remove(fd);
+      delete connection;
+      continue;
+    }
+    pthread_detach(thread);
+  }
+
+  Log::Info << "Interrupted; shutting down." << endl;
+  close(listener);
+  if (CLI::HasParam("socket"))
+    unlink(CLI::GetParam<string>("socket").c_str());
+
+  // Requests still in the queue are answered with an error.
+  server.Stop();
+  connections.CloseAll();
+
+  Log::Info << server.Requests() << " requests answered in " << server.Batches()
+      << " batches." << endl;
+  if (cacheSize > 0)
+    server.CacheStats().Print();
+}
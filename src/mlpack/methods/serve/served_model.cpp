@@ -0,0 +1,154 @@
+/**
+ * @file served_model.cpp
+ *
+ * Implementation of the models the model server serves.
+ */
+#include "served_model.hpp"
+
+#include <mlpack/methods/neighbor_search/unmap.hpp>
+
+#include <sstream>
+
+using namespace mlpack;
+using namespace mlpack::serve;
+
+std::string ServedModel::Check(const Request& request) const
+{
+  std::ostringstream oss;
+  if (!HasCommand(request.command))
+    oss << "unknown command '" << request.command << "' for model '"
+        << request.model << "'";
+  else if (request.points.n_cols == 0)
+    oss << "no points given";
+  else if (request.points.n_rows != Dimensionality())
+    oss << "points have dimensionality " << request.points.n_rows << ", but "
+        << "model '" << request.model << "' has dimensionality "
+        << Dimensionality();
+
+  return oss.str();
+}
+
+void ServedModel::Concatenate(const std::vector<Request*>& batch,
+                              arma::mat& points)
+{
+  size_t total = 0;
+  for (size_t i = 0; i < batch.size(); ++i)
+    total += batch[i]->points.n_cols;
+
+  points.set_size(batch[0]->points.n_rows, total);
+  size_t column = 0;
+  for (size_t i = 0; i < batch.size(); ++i)
+  {
+    const size_t count = batch[i]->points.n_cols;
+    points.cols(column, column + count - 1) = batch[i]->points;
+    column += count;
+  }
+}
+
+void ServedModel::Split(const arma::mat& results,
+                        const std::vector<Request*>& batch)
+{
+  size_t column = 0;
+  for (size_t i = 0; i < batch.size(); ++i)
+  {
+    const size_t count = batch[i]->points.n_cols;
+    batch[i]->results = results.cols(column, column + count - 1);
+    column += count;
+  }
+}
+
+bool GMMModel::HasCommand(const std::string& command) const
+{
+  return (command == "probability") || (command == "classify");
+}
+
+void GMMModel::Process(const std::vector<Request*>& batch)
+{
+  arma::mat points;
+  Concatenate(batch, points);
+
+  arma::mat results(1, points.n_cols);
+  if (batch[0]->command == "probability")
+  {
+    #pragma omp parallel for
+    for (size_t i = 0; i < points.n_cols; ++i)
+      results[i] = gmm.Probability(points.unsafe_col(i));
+  }
+  else
+  {
+    arma::Col<size_t> labels;
+    gmm.Classify(points, labels);
+    for (size_t i = 0; i < labels.n_elem; ++i)
+      results[i] = (double) labels[i];
+  }
+
+  Split(results, batch);
+}
+
+bool LinearRegressionModel::HasCommand(const std::string& command) const
+{
+  return (command == "predict");
+}
+
+void LinearRegressionModel::Process(const std::vector<Request*>& batch)
+{
+  arma::mat points;
+  Concatenate(batch, points);
+
+  arma::vec predictions;
+  model.Predict(points, predictions);
+
+  Split(arma::trans(predictions), batch);
+}
+
+KNNModel::KNNModel(const std::string& filename, const size_t leafSize) :
+    tree(filename),
+    leafSize(leafSize)
+{
+  // Nothing to do.
+}
+
+bool KNNModel::HasCommand(const std::string& command) const
+{
+  return (command == "knn");
+}
+
+std::string KNNModel::Check(const Request& request) const
+{
+  const std::string error = ServedModel::Check(request);
+  if (!error.empty())
+    return error;
+
+  std::ostringstream oss;
+  if (request.k == 0 || request.k > NumReferences())
+    oss << "invalid k " << request.k << "; must be between 1 and the number "
+        << "of reference points (" << NumReferences() << ")";
+
+  return oss.str();
+}
+
+void KNNModel::Process(const std::vector<Request*>& batch)
+{
+  // The query tree rearranges the points.
+  arma::mat queries;
+  Concatenate(batch, queries);
+
+  std::vector<size_t> oldFromNewQueries;
+  TreeType queryTree(queries, oldFromNewQueries, leafSize);
+
+  neighbor::AllkNN allknn(&tree.Tree(), &queryTree, tree.Dataset(), queries);
+
+  const size_t k = batch[0]->k;
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(k, neighbors, distances);
+  neighbor::Unmap(neighbors, distances, tree.OldFromNew(), oldFromNewQueries);
+
+  // The neighbors are followed by their distances.
+  arma::mat results(2 * k, queries.n_cols);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    results[i + (i / k) * k] = (double) neighbors[i];
+  results.rows(k, 2 * k - 1) = distances;
+
+  Split(results, batch);
+}
@@ -0,0 +1,191 @@
+/**
+ * @file served_model.hpp
+ *
+ * The models that the model server can serve, each of which answers whole
+ * batches of requests at once.
+ */
+#ifndef __MLPACK_METHODS_SERVE_SERVED_MODEL_HPP
+#define __MLPACK_METHODS_SERVE_SERVED_MODEL_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree/mapped_tree.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/hmm/hmm.hpp>
+#include <mlpack/methods/linear_regression/linear_regression.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#include "request_queue.hpp"
+
+namespace mlpack {
+namespace serve {
+
+/**
+ * A model loaded by the model server.  Each model has a dimensionality and a
+ * set of commands; a request is checked with Check() before it is queued, and
+ * then answered by Process() along with the rest of its batch.  Process() is
+ * only ever called by one thread at a time, so models may keep state (such as
+ * a tree's statistics) between batches.
+ */
+class ServedModel
+{
+ public:
+  virtual ~ServedModel() { }
+
+  //! Return the dimensionality of the points the model takes.
+  virtual size_t Dimensionality() const = 0;
+
+  //! Return whether or not the model has the given command.
+  virtual bool HasCommand(const std::string& command) const = 0;
+
+  //! Return whether or not the result of the given command for each point
+  //! depends only on that point (so that it can be cached).  By default, this
+  //! is true.
+  virtual bool Pointwise(const std::string& /* command */) const
+  {
+    return true;
+  }
+
+  /**
+   * Check that the given request can be answered; if it cannot, return the
+   * reason.  By default, this checks the command, that there are points, and
+   * their dimensionality.
+   *
+   * @param request Request to check.
+   * @return An empty string if the request can be answered, or the error.
+   */
+  virtual std::string Check(const Request& request) const;
+
+  /**
+   * Answer each of the requests of the given batch, which have all been
+   * checked and all have the same command and parameter.
+   *
+   * @param batch Requests to answer.
+   */
+  virtual void Process(const std::vector<Request*>& batch) = 0;
+
+ protected:
+  //! Store the points of every request of the batch, one after the other, in
+  //! the given matrix.
+  static void Concatenate(const std::vector<Request*>& batch,
+                          arma::mat& points);
+
+  //! Give each request of the batch the columns of the given results that
+  //! correspond to its points (which were concatenated with Concatenate()).
+  static void Split(const arma::mat& results,
+                    const std::vector<Request*>& batch);
+};
+
+/**
+ * A GMM.  'probability' gives the probability of each point, and 'classify'
+ * the component each point most likely came from.
+ */
+class GMMModel : public ServedModel
+{
+ public:
+  //! Serve a copy of the given GMM.
+  GMMModel(const gmm::GMM<>& gmm) : gmm(gmm) { }
+
+  size_t Dimensionality() const { return gmm.Dimensionality(); }
+  bool HasCommand(const std::string& command) const;
+  void Process(const std::vector<Request*>& batch);
+
+ private:
+  //! The GMM.
+  gmm::GMM<> gmm;
+};
+
+/**
+ * An HMM.  The points of each request are one sequence of observations;
+ * 'viterbi' gives the most likely hidden state of each observation, and
+ * 'loglik' the log-likelihood of the sequence.  A batch is answered with the
+ * batch HMM::Predict() or HMM::LogLikelihood(), which divide it between OpenMP
+ * threads.
+ *
+ * @tparam Distribution Emission distribution of the HMM.
+ */
+template<typename Distribution>
+class HMMModel : public ServedModel
+{
+ public:
+  //! Serve a copy of the given HMM.
+  HMMModel(const hmm::HMM<Distribution>& hmm) : hmm(hmm) { }
+
+  size_t Dimensionality() const { return hmm.Dimensionality(); }
+  bool HasCommand(const std::string& command) const;
+  //! The results of an HMM depend on the whole sequence.
+  bool Pointwise(const std::string& /* command */) const { return false; }
+  void Process(const std::vector<Request*>& batch);
+
+ private:
+  //! The HMM.
+  hmm::HMM<Distribution> hmm;
+};
+
+/**
+ * A linear regression model.  'predict' gives the prediction for each point.
+ */
+class LinearRegressionModel : public ServedModel
+{
+ public:
+  //! Serve a copy of the given model.
+  LinearRegressionModel(const regression::LinearRegression& model) :
+      model(model) { }
+
+  size_t Dimensionality() const
+  {
+    return model.Parameters().n_elem - (model.Intercept() ? 1 : 0);
+  }
+
+  bool HasCommand(const std::string& command) const;
+  void Process(const std::vector<Request*>& batch);
+
+ private:
+  //! The model.
+  regression::LinearRegression model;
+};
+
+/**
+ * A kd-tree on a reference set, loaded from a tree file saved by allknn
+ * --save_tree, which stays in memory (mapped) for as long as the server runs.
+ * 'knn' with parameter k gives the indices (in the original reference set) of
+ * the k nearest neighbors of each point, followed by their distances.  A batch
+ * is answered with one dual-tree search, with a query tree built on all of its
+ * points.
+ */
+class KNNModel : public ServedModel
+{
+ public:
+  //! The type of tree that allknn saves.
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      neighbor::NeighborSearchStat<neighbor::NearestNeighborSort> > TreeType;
+
+  /**
+   * Load the given tree file.  Log::Fatal is used if it cannot be loaded.
+   *
+   * @param filename Name of the tree file.
+   * @param leafSize Leaf size of the query trees.
+   */
+  KNNModel(const std::string& filename, const size_t leafSize = 20);
+
+  size_t Dimensionality() const { return tree.Dataset().n_rows; }
+  bool HasCommand(const std::string& command) const;
+  std::string Check(const Request& request) const;
+  void Process(const std::vector<Request*>& batch);
+
+  //! Get the number of reference points.
+  size_t NumReferences() const { return tree.Dataset().n_cols; }
+
+ private:
+  //! The reference tree and dataset.
+  tree::MappedTree<TreeType> tree;
+  //! Leaf size of the query trees.
+  size_t leafSize;
+};
+
+}; // namespace serve
+}; // namespace mlpack
+
+// Include implementation of HMMModel.
+#include "served_model_impl.hpp"
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file served_model_impl.hpp
+ *
+ * Implementation of the HMMModel, which is templated on the emission
+ * distribution.
+ */
+#ifndef __MLPACK_METHODS_SERVE_SERVED_MODEL_IMPL_HPP
+#define __MLPACK_METHODS_SERVE_SERVED_MODEL_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "served_model.hpp"
+
+namespace mlpack {
+namespace serve {
+
+template<typename Distribution>
+bool HMMModel<Distribution>::HasCommand(const std::string& command) const
+{
+  return (command == "viterbi") || (command == "loglik");
+}
+
+template<typename Distribution>
+void HMMModel<Distribution>::Process(const std::vector<Request*>& batch)
+{
+  // Each request is a sequence, so the sequences are not concatenated.
+  std::vector<arma::mat> sequences(batch.size());
+  for (size_t i = 0; i < batch.size(); ++i)
+    sequences[i] = batch[i]->points;
+
+  arma::vec logLikelihoods;
+  if (batch[0]->command == "viterbi")
+  {
+    std::vector<arma::Col<size_t> > stateSequences;
+    hmm.Predict(sequences, stateSequences, logLikelihoods);
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      batch[i]->results.set_size(1, stateSequences[i].n_elem);
+      for (size_t j = 0; j < stateSequences[i].n_elem; ++j)
+        batch[i]->results[j] = (double) stateSequences[i][j];
+    }
+  }
+  else
+  {
+    hmm.LogLikelihood(sequences, logLikelihoods);
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      batch[i]->results.set_size(1, 1);
+      batch[i]->results[0] = logLikelihoods[i];
+    }
+  }
+}
+
+}; // namespace serve
+}; // namespace mlpack
+
+#endif
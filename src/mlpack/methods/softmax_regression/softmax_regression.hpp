@@ -9,6 +9,7 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/lbfgs/lbfgs.hpp>
+#include <mlpack/methods/linear_predictor/linear_predictor.hpp>
 
 #include "softmax_regression_function.hpp"
 
@@ -42,8 +43,9 @@ namespace regression {
  * const size_t numIterations = 100; // Maximum number of iterations.
  *
  * // Use an instantiated optimizer for the training.
- * SoftmaxRegressionFunction srf(train_data, labels, inputSize, numClasses);
- * L_BFGS<SoftmaxRegressionFunction> optimizer(srf, numBasis, numIterations);
+ * SoftmaxRegressionFunction<> srf(train_data, labels, inputSize, numClasses);
+ * L_BFGS<SoftmaxRegressionFunction<> > optimizer(srf, numBasis,
+ *     numIterations);
  * SoftmaxRegression<L_BFGS> regressor2(optimizer);
  *
  * arma::mat test_data; // Test data matrix.
@@ -53,10 +55,17 @@ namespace regression {
  * regressor1.Predict(test_data, predictions1);
  * regressor2.Predict(test_data, predictions2);
  * @endcode
+ *
+ * The training examples can also be sparse (MatType = arma::sp_mat) or stored
+ * in single precision (MatType = arma::fmat); see SoftmaxRegressionFunction.
+ *
+ * @tparam OptimizerType The optimizer to use; by default this is L-BFGS.
+ * @tparam MatType Type of the matrix of training examples.
  */
 
 template<
-  template<typename> class OptimizerType = mlpack::optimization::L_BFGS
+  template<typename> class OptimizerType = mlpack::optimization::L_BFGS,
+  typename MatType = arma::mat
 >
 class SoftmaxRegression
 {
@@ -74,7 +83,7 @@ class SoftmaxRegression
    * @param numClasses Number of classes for classification.
    * @param lambda L2-regularization constant.
    */
-  SoftmaxRegression(const arma::mat& data,
+  SoftmaxRegression(const MatType& data,
                     const arma::vec& labels,
                     const size_t inputSize,
                     const size_t numClasses,
@@ -89,17 +98,21 @@ class SoftmaxRegression
    *
    * @param optimizer Instantiated optimizer with instantiated error function.
    */
-  SoftmaxRegression(OptimizerType<SoftmaxRegressionFunction>& optimizer);
+  SoftmaxRegression(
+      OptimizerType<SoftmaxRegressionFunction<MatType> >& optimizer);
   
   /**
    * Predict the class labels for the provided feature points. The function
    * calculates the probabilities for every class, given a data point. It then
-   * chooses the class which has the highest probability among all.
+   * chooses the class which has the highest probability among all.  The points
+   * are classified in parallel blocks by a LinearPredictor; to classify many
+   * batches of points (or to use single-precision weights), create a
+   * LinearPredictor from Parameters() once and use it directly.
    *
    * @param testData Matrix of data points for which predictions are to be made.
    * @param predictions Vector to store the predictions in.
    */
-  void Predict(const arma::mat& testData, arma::vec& predictions);
+  void Predict(const MatType& testData, arma::vec& predictions);
   
   /**
    * Computes accuracy of the learned model given the feature data and the
@@ -109,8 +122,11 @@ class SoftmaxRegression
    * @param testData Matrix of data points using which predictions are made.
    * @param labels Vector of labels associated with the data.
    */
-  double ComputeAccuracy(const arma::mat& testData, const arma::vec& labels);
+  double ComputeAccuracy(const MatType& testData, const arma::vec& labels);
                     
+  //! Get the parameters of the model (one row for each class).
+  const arma::mat& Parameters() const { return parameters; }
+
   //! Sets the size of the input vector.
   void InputSize(const size_t input)
   {
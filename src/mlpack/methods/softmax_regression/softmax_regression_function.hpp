@@ -9,10 +9,26 @@
 #define __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/parallel_sum/parallel_sum.hpp>
 
 namespace mlpack {
 namespace regression {
 
+/**
+ * The objective function of softmax regression: the average negative log
+ * likelihood of the labels of the training examples, with L2-regularization.
+ *
+ * The training examples can be stored in any dense matrix type, or in an
+ * arma::sp_mat.  The parameters are always in double precision, as the
+ * optimizers require, so examples stored in another precision (such as an
+ * arma::fmat, which halves the memory the dataset takes) are converted one
+ * block at a time.  For sparse examples, the products with the parameters
+ * only visit the non-zero entries, so a high-dimensional sparse dataset (such
+ * as bag-of-words text features) never has to be made dense.
+ *
+ * @tparam MatType Type of the matrix of training examples.
+ */
+template<typename MatType = arma::mat>
 class SoftmaxRegressionFunction
 {
  public:
@@ -26,7 +42,7 @@ class SoftmaxRegressionFunction
    * @param numClasses Number of classes for classification.
    * @param lambda L2-regularization constant.
    */
-  SoftmaxRegressionFunction(const arma::mat& data,
+  SoftmaxRegressionFunction(const MatType& data,
                             const arma::vec& labels,
                             const size_t inputSize,
                             const size_t numClasses,
@@ -48,7 +64,8 @@ class SoftmaxRegressionFunction
    * given parameters. The cost function has terms for the log likelihood error
    * and the regularization cost. The objective function takes a low value when
    * the model generalizes well for the given training data, while having small
-   * parameter values.
+   * parameter values.  The terms of the training examples are summed in
+   * parallel (see optimization::ParallelSum()).
    *
    * @param parameters Current values of the model parameters.
    */
@@ -58,13 +75,66 @@ class SoftmaxRegressionFunction
    * Evaluates the gradient values of the objective function given the current
    * set of parameters. The function calculates the probabilities for each class
    * given the parameters, and computes the gradients based on the difference
-   * from the ground truth.
+   * from the ground truth.  The terms of the training examples are summed in
+   * parallel.
    *
    * @param parameters Current values of the model parameters.
    * @param gradient Matrix where gradient values will be stored.
    */
   void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
-  
+
+  /**
+   * Evaluates the objective function and its gradient given the current set of
+   * parameters, computing the class probabilities only once.  This is used by
+   * L_BFGS, which needs both at each point it visits.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param gradient Matrix where gradient values will be stored.
+   * @return Objective function value.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  /**
+   * Evaluates the objective function for only one training example, so that
+   * the objective function is separable, as SGD requires.  The sum of the
+   * values over all examples is Evaluate(parameters).
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the training example.
+   */
+  double Evaluate(const arma::mat& parameters, const size_t i) const;
+
+  /**
+   * Evaluates the gradient of the objective function for only one training
+   * example.  The sum of the gradients over all examples is the full gradient.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the training example.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::mat& gradient) const;
+
+  /**
+   * Evaluates the sum of the gradients of the objective function for the
+   * training examples begin through (begin + batchSize - 1), with
+   * matrix-matrix products.  This is used by SGD for mini-batches.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first example of the batch.
+   * @param batchSize Number of examples in the batch.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient) const;
+
+  //! Return the number of separable functions (the number of examples).
+  size_t NumFunctions() const { return data.n_cols; }
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
   
@@ -105,8 +175,71 @@ class SoftmaxRegressionFunction
   }
                             
  private:
+  //! Return the negative log likelihood of training examples begin through
+  //! (end - 1), without the regularization and the division by the number of
+  //! examples.
+  double EvaluateBlock(const arma::mat& parameters,
+                       const size_t begin,
+                       const size_t end) const;
+
+  //! Return the negative log likelihood of training examples begin through
+  //! (end - 1), and add their gradient terms to the given gradient, both
+  //! without the regularization and the division by the number of examples.
+  double EvaluateWithGradientBlock(const arma::mat& parameters,
+                                   const size_t begin,
+                                   const size_t end,
+                                   arma::mat& gradient) const;
+
+  //! Compute the scores parameters * x of training examples begin through
+  //! (end - 1).
+  static void Scores(const arma::mat& parameters,
+                     const arma::mat& data,
+                     const size_t begin,
+                     const size_t end,
+                     arma::mat& scores);
+
+  //! Compute the scores of training examples begin through (end - 1), which
+  //! are converted to double precision first.
+  template<typename eT>
+  static void Scores(const arma::mat& parameters,
+                     const arma::Mat<eT>& data,
+                     const size_t begin,
+                     const size_t end,
+                     arma::mat& scores);
+
+  //! Compute the scores of sparse training examples begin through (end - 1).
+  static void Scores(const arma::mat& parameters,
+                     const arma::sp_mat& data,
+                     const size_t begin,
+                     const size_t end,
+                     arma::mat& scores);
+
+  //! Add residuals * x' for training examples begin through (end - 1) (one
+  //! column of residuals for each example) to the given gradient.
+  static void AddGradient(const arma::mat& residuals,
+                          const arma::mat& data,
+                          const size_t begin,
+                          const size_t end,
+                          arma::mat& gradient);
+
+  //! Add residuals * x' for training examples begin through (end - 1), which
+  //! are converted to double precision first.
+  template<typename eT>
+  static void AddGradient(const arma::mat& residuals,
+                          const arma::Mat<eT>& data,
+                          const size_t begin,
+                          const size_t end,
+                          arma::mat& gradient);
+
+  //! Add residuals * x' for sparse training examples begin through (end - 1).
+  static void AddGradient(const arma::mat& residuals,
+                          const arma::sp_mat& data,
+                          const size_t begin,
+                          const size_t end,
+                          arma::mat& gradient);
+
   //! Training data matrix.
-  const arma::mat& data;
+  const MatType& data;
   //! Labels associated with the training data.
   const arma::vec& labels;
   //! Label matrix for the provided data.
@@ -124,4 +257,7 @@ class SoftmaxRegressionFunction
 }; // namespace regression
 }; // namespace mlpack
 
+// Include implementation.
+#include "softmax_regression_function_impl.hpp"
+
 #endif
@@ -0,0 +1,346 @@
+/**
+ * @file softmax_regression_function_impl.hpp
+ * @author Siddharth Agrawal
+ *
+ * Implementation of function to be optimized for softmax regression.
+ */
+#ifndef __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_FUNCTION_IMPL_HPP
+#define __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "softmax_regression_function.hpp"
+
+namespace mlpack {
+namespace regression {
+
+template<typename MatType>
+SoftmaxRegressionFunction<MatType>::SoftmaxRegressionFunction(
+    const MatType& data,
+    const arma::vec& labels,
+    const size_t inputSize,
+    const size_t numClasses,
+    const double lambda) :
+    data(data),
+    labels(labels),
+    inputSize(inputSize),
+    numClasses(numClasses),
+    lambda(lambda)
+{
+  // Intialize the parameters to suitable values.
+  initialPoint = InitializeWeights();
+
+  // Calculate the label matrix.
+  GetGroundTruthMatrix(labels, groundTruth);
+}
+
+/**
+ * Initializes parameter weights to random values taken from a scaled standard
+ * normal distribution. The weights cannot be initialized to zero, as that will
+ * lead to each class output being the same.
+ */
+template<typename MatType>
+const arma::mat SoftmaxRegressionFunction<MatType>::InitializeWeights()
+{
+  // Initialize values to 0.005 * r. 'r' is a matrix of random values taken from
+  // a Gaussian distribution with mean zero and variance one.
+  arma::mat parameters;
+  parameters.randn(numClasses, inputSize);
+  parameters = 0.005 * parameters;
+
+  return parameters;
+}
+
+/**
+ * This is equivalent to applying the indicator function to the training
+ * labels. The output is in the form of a matrix, which leads to simpler
+ * calculations in the Evaluate() and Gradient() methods.
+ */
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::GetGroundTruthMatrix(
+    const arma::vec& labels,
+    arma::sp_mat& groundTruth)
+{
+  // Calculate the ground truth matrix according to the labels passed. The
+  // ground truth matrix is a matrix of dimensions 'numClasses * numExamples',
+  // where each column contains a single entry of '1', marking the label
+  // corresponding to that example.
+
+  // Row pointers and column pointers corresponding to the entries.
+  arma::uvec rowPointers(labels.n_elem);
+  arma::uvec colPointers(labels.n_elem + 1);
+
+  // Row pointers are the labels of the examples, and column pointers are the
+  // number of cumulative entries made uptil that column.
+  colPointers(0) = 0;
+  for(size_t i = 0; i < labels.n_elem; i++)
+  {
+    rowPointers(i) = labels(i, 0);
+    colPointers(i+1) = i + 1;
+  }
+
+  // All entries are '1'.
+  arma::vec values;
+  values.ones(labels.n_elem);
+
+  // Calculate the matrix.
+  groundTruth = arma::sp_mat(rowPointers, colPointers, values, numClasses,
+                             labels.n_elem);
+}
+
+/**
+ * Evaluates the objective function given the parameters.
+ */
+template<typename MatType>
+double SoftmaxRegressionFunction<MatType>::Evaluate(
+    const arma::mat& parameters) const
+{
+  // The objective function is the negative log likelihood of the model
+  // calculated over all the training examples. Mathematically it is as follows:
+  // log likelihood = sum(1{y_i = j} * log(probability(j))) / m
+  // The sum is over all 'i's and 'j's, where 'i' points to a training example
+  // and 'j' points to a particular class. 1{x} is an indicator function whose
+  // value is 1 only when 'x' is satisfied, otherwise it is 0.
+  // 'm' is the number of training examples.
+  // The cost also takes into account the regularization to control the
+  // parameter weights.
+
+  // Calculate the log likelihood and regularization terms.  The log likelihood
+  // terms of the training examples are summed in parallel.
+  double logLikelihood, weightDecay, cost;
+
+  logLikelihood = -optimization::ParallelSum(*this,
+      &SoftmaxRegressionFunction::EvaluateBlock, parameters, data.n_cols) /
+      data.n_cols;
+  weightDecay = 0.5 * lambda * arma::accu(parameters % parameters);
+
+  // The cost is the sum of the negative log likelihood and the regularization
+  // terms.
+  cost = -logLikelihood + weightDecay;
+
+  return cost;
+}
+
+/**
+ * Calculates and stores the gradient values given a set of parameters.
+ */
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::Gradient(const arma::mat& parameters,
+                                                  arma::mat& gradient) const
+{
+  EvaluateWithGradient(parameters, gradient);
+}
+
+/**
+ * Evaluates the objective function and its gradient, with one pass over the
+ * training examples.
+ */
+template<typename MatType>
+double SoftmaxRegressionFunction<MatType>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  const double logLikelihood = -optimization::ParallelSum(*this,
+      &SoftmaxRegressionFunction::EvaluateWithGradientBlock, parameters,
+      data.n_cols, gradient) / data.n_cols;
+
+  // Calculate the parameter gradients.
+  gradient /= data.n_cols;
+  gradient += lambda * parameters;
+
+  return -logLikelihood + 0.5 * lambda * arma::accu(parameters % parameters);
+}
+
+/**
+ * Evaluates the objective function for one training example.  Both the log
+ * likelihood and the regularization are split evenly over the examples.
+ */
+template<typename MatType>
+double SoftmaxRegressionFunction<MatType>::Evaluate(
+    const arma::mat& parameters,
+    const size_t i) const
+{
+  arma::mat hypothesis;
+  Scores(parameters, data, i, i + 1, hypothesis);
+  hypothesis = arma::exp(hypothesis);
+
+  const double logLikelihood = std::log(hypothesis((size_t) labels(i)) /
+      arma::accu(hypothesis));
+  const double weightDecay = 0.5 * lambda * arma::accu(parameters %
+      parameters);
+
+  return (-logLikelihood + weightDecay) / data.n_cols;
+}
+
+/**
+ * Calculates the gradient for one training example.
+ */
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::Gradient(const arma::mat& parameters,
+                                                  const size_t i,
+                                                  arma::mat& gradient) const
+{
+  Gradient(parameters, i, 1, gradient);
+}
+
+/**
+ * Calculates the summed gradient of a batch of training examples.
+ */
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::Gradient(const arma::mat& parameters,
+                                                  const size_t begin,
+                                                  const size_t batchSize,
+                                                  arma::mat& gradient) const
+{
+  const size_t end = begin + batchSize;
+
+  // Calculate the class probabilities for each example of the batch, and
+  // subtract the ground truth from them.
+  arma::mat probabilities;
+  Scores(parameters, data, begin, end, probabilities);
+  probabilities = arma::exp(probabilities);
+  probabilities /= arma::repmat(arma::sum(probabilities, 0), numClasses, 1);
+  for (size_t i = 0; i < batchSize; ++i)
+    probabilities((size_t) labels(begin + i), i) -= 1.0;
+
+  gradient = (lambda * batchSize) * parameters;
+  AddGradient(probabilities, data, begin, end, gradient);
+  gradient /= data.n_cols;
+}
+
+template<typename MatType>
+double SoftmaxRegressionFunction<MatType>::EvaluateBlock(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t end) const
+{
+  // Calculate the class probabilities for each training example. The
+  // probabilities for each of the classes are given by:
+  // p_j = exp(theta_j' * x_i) / sum(exp(theta_k' * x_i))
+  // The sum is calculated over all the classes.
+  // x_i is the input vector for a particular training example.
+  // theta_j is the parameter vector associated with a particular class.
+  arma::mat hypothesis;
+  Scores(parameters, data, begin, end, hypothesis);
+  hypothesis = arma::exp(hypothesis);
+  const arma::rowvec sums = arma::sum(hypothesis, 0);
+
+  // Only the probability of the label of each example counts.
+  double logLikelihood = 0.0;
+  for (size_t i = begin; i < end; ++i)
+    logLikelihood += std::log(hypothesis((size_t) labels(i), i - begin) /
+        sums[i - begin]);
+
+  return -logLikelihood;
+}
+
+template<typename MatType>
+double SoftmaxRegressionFunction<MatType>::EvaluateWithGradientBlock(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t end,
+    arma::mat& gradient) const
+{
+  arma::mat probabilities;
+  Scores(parameters, data, begin, end, probabilities);
+  probabilities = arma::exp(probabilities);
+  probabilities /= arma::repmat(arma::sum(probabilities, 0), numClasses, 1);
+
+  // Take the log likelihood of each example, then subtract the ground truth
+  // from its probabilities.
+  double logLikelihood = 0.0;
+  for (size_t i = begin; i < end; ++i)
+  {
+    const size_t label = (size_t) labels(i);
+    logLikelihood += std::log(probabilities(label, i - begin));
+    probabilities(label, i - begin) -= 1.0;
+  }
+
+  AddGradient(probabilities, data, begin, end, gradient);
+
+  return -logLikelihood;
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::Scores(const arma::mat& parameters,
+                                                const arma::mat& data,
+                                                const size_t begin,
+                                                const size_t end,
+                                                arma::mat& scores)
+{
+  scores = parameters * data.cols(begin, end - 1);
+}
+
+template<typename MatType>
+template<typename eT>
+void SoftmaxRegressionFunction<MatType>::Scores(const arma::mat& parameters,
+                                                const arma::Mat<eT>& data,
+                                                const size_t begin,
+                                                const size_t end,
+                                                arma::mat& scores)
+{
+  // The examples are converted to double precision one block at a time.
+  scores = parameters *
+      arma::conv_to<arma::mat>::from(data.cols(begin, end - 1));
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::Scores(const arma::mat& parameters,
+                                                const arma::sp_mat& data,
+                                                const size_t begin,
+                                                const size_t end,
+                                                arma::mat& scores)
+{
+  scores.zeros(parameters.n_rows, end - begin);
+
+  // Each non-zero entry adds a scaled column of the parameters.
+  for (size_t i = begin; i < end; ++i)
+    for (arma::sp_mat::const_iterator it = data.begin_col(i);
+         it != data.end_col(i); ++it)
+      scores.col(i - begin) += (*it) * parameters.col(it.row());
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::AddGradient(
+    const arma::mat& residuals,
+    const arma::mat& data,
+    const size_t begin,
+    const size_t end,
+    arma::mat& gradient)
+{
+  gradient += residuals * data.cols(begin, end - 1).t();
+}
+
+template<typename MatType>
+template<typename eT>
+void SoftmaxRegressionFunction<MatType>::AddGradient(
+    const arma::mat& residuals,
+    const arma::Mat<eT>& data,
+    const size_t begin,
+    const size_t end,
+    arma::mat& gradient)
+{
+  gradient += residuals *
+      arma::conv_to<arma::mat>::from(data.cols(begin, end - 1)).t();
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::AddGradient(
+    const arma::mat& residuals,
+    const arma::sp_mat& data,
+    const size_t begin,
+    const size_t end,
+    arma::mat& gradient)
+{
+  // Each non-zero entry x_ij adds x_ij times the residuals of example j to
+  // column i of the gradient.
+  for (size_t i = begin; i < end; ++i)
+    for (arma::sp_mat::const_iterator it = data.begin_col(i);
+         it != data.end_col(i); ++it)
+      gradient.col(it.row()) += (*it) * residuals.col(i - begin);
+}
+
+}; // namespace regression
+}; // namespace mlpack
+
+#endif
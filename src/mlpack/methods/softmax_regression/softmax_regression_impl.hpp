@@ -13,19 +13,20 @@
 namespace mlpack {
 namespace regression {
 
-template<template<typename> class OptimizerType>
-SoftmaxRegression<OptimizerType>::SoftmaxRegression(const arma::mat& data,
-                                                    const arma::vec& labels,
-                                                    const size_t inputSize,
-                                                    const size_t numClasses,
-                                                    const double lambda) :
+template<template<typename> class OptimizerType, typename MatType>
+SoftmaxRegression<OptimizerType, MatType>::SoftmaxRegression(
+    const MatType& data,
+    const arma::vec& labels,
+    const size_t inputSize,
+    const size_t numClasses,
+    const double lambda) :
     inputSize(inputSize),
     numClasses(numClasses),
     lambda(lambda)
 {
-  SoftmaxRegressionFunction regressor(data, labels, inputSize, numClasses,
-                                      lambda);
-  OptimizerType<SoftmaxRegressionFunction> optimizer(regressor);
+  SoftmaxRegressionFunction<MatType> regressor(data, labels, inputSize,
+      numClasses, lambda);
+  OptimizerType<SoftmaxRegressionFunction<MatType> > optimizer(regressor);
   
   parameters = regressor.GetInitialPoint();
 
@@ -38,9 +39,9 @@ SoftmaxRegression<OptimizerType>::SoftmaxRegression(const arma::mat& data,
       << "trained model is " << out << "." << std::endl;
 }
 
-template<template<typename> class OptimizerType>
-SoftmaxRegression<OptimizerType>::SoftmaxRegression(
-    OptimizerType<SoftmaxRegressionFunction>& optimizer) :
+template<template<typename> class OptimizerType, typename MatType>
+SoftmaxRegression<OptimizerType, MatType>::SoftmaxRegression(
+    OptimizerType<SoftmaxRegressionFunction<MatType> >& optimizer) :
     parameters(optimizer.Function().GetInitialPoint()),
     inputSize(optimizer.Function().InputSize()),
     numClasses(optimizer.Function().NumClasses()),
@@ -55,43 +56,20 @@ SoftmaxRegression<OptimizerType>::SoftmaxRegression(
       << "trained model is " << out << "." << std::endl;
 }
 
-template<template<typename> class OptimizerType>
-void SoftmaxRegression<OptimizerType>::Predict(const arma::mat& testData,
-                                               arma::vec& predictions)
+template<template<typename> class OptimizerType, typename MatType>
+void SoftmaxRegression<OptimizerType, MatType>::Predict(
+    const MatType& testData,
+    arma::vec& predictions)
 {
-  // Calculate the probabilities for each test input.
-  arma::mat hypothesis, probabilities;
-  
-  hypothesis = arma::exp(parameters * testData);
-  probabilities = hypothesis / arma::repmat(arma::sum(hypothesis, 0),
-                                            numClasses, 1);
-  
-  // Prepare necessary data.
-  predictions.zeros(testData.n_cols);
-  double maxProbability = 0;
-  
-  // For each test input.
-  for(size_t i = 0; i < testData.n_cols; i++)
-  {
-    // For each class.
-    for(size_t j = 0; j < numClasses; j++)
-    {
-      // If a higher class probability is encountered, change prediction.
-      if(probabilities(j, i) > maxProbability)
-      {
-        maxProbability = probabilities(j, i);
-        predictions(i) = j;
-      }
-    }
-    
-    // Set maximum probability to zero for the next input.
-    maxProbability = 0;
-  }
+  // The class with the highest probability is the class with the highest
+  // score, so no probabilities need to be computed.
+  LinearPredictor<> predictor(parameters);
+  predictor.Classify(testData, predictions);
 }
 
-template<template<typename> class OptimizerType>
-double SoftmaxRegression<OptimizerType>::ComputeAccuracy(
-    const arma::mat& testData,
+template<template<typename> class OptimizerType, typename MatType>
+double SoftmaxRegression<OptimizerType, MatType>::ComputeAccuracy(
+    const MatType& testData,
     const arma::vec& labels)
 {
   arma::vec predictions;
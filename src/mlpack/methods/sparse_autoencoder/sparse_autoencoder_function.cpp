@@ -78,36 +78,38 @@ double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters) const
   // The cost also takes into account the regularization and KL divergence terms
   // to control the parameter weights and sparsity of the model respectively.
 
-  // Compute the limits for the parameters w1, w2, b1 and b2.
-  const size_t l1 = hiddenSize;
-  const size_t l2 = visibleSize;
-  const size_t l3 = 2 * hiddenSize;
-
-  // w1, w2, b1 and b2 are not extracted separately, 'parameters' is directly
-  // used in their place to avoid copying data. The following representations
-  // are used:
-  // w1 <- parameters.submat(0, 0, l1-1, l2-1)
-  // w2 <- parameters.submat(l1, 0, l3-1, l2-1).t()
-  // b1 <- parameters.submat(0, l2, l1-1, l2)
-  // b2 <- parameters.submat(l3, 0, l3, l2-1).t()
-
-  arma::mat hiddenLayer, outputLayer;
+  // The squared error and the sums of the hidden layer activations are summed
+  // over the data points in parallel.
+  arma::mat sums(hiddenSize, 1);
+  const double squaredError = ParallelSum(*this,
+      &SparseAutoencoderFunction::EvaluateBlock, parameters, data.n_cols,
+      sums);
+
+  return Cost(parameters, squaredError, sums, data.n_cols);
+}
 
-  // Compute activations of the hidden and output layers.
-  Sigmoid(parameters.submat(0, 0, l1 - 1, l2 - 1) * data +
-      arma::repmat(parameters.submat(0, l2, l1 - 1, l2), 1, data.n_cols),
-      hiddenLayer);
+/** Evaluates the objective function given the parameters, on one data point.
+  */
+double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters,
+                                           const size_t i) const
+{
+  arma::mat sums = arma::zeros<arma::mat>(hiddenSize, 1);
+  const double squaredError = EvaluateBlock(parameters, i, i + 1, sums);
 
-  Sigmoid(parameters.submat(l1, 0, l3 - 1, l2 - 1).t() * hiddenLayer +
-      arma::repmat(parameters.submat(l3, 0, l3, l2 - 1).t(), 1, data.n_cols),
-      outputLayer);
+  return Cost(parameters, squaredError, sums, 1);
+}
 
-  arma::mat rhoCap, diff;
+double SparseAutoencoderFunction::Cost(const arma::mat& parameters,
+                                       const double squaredError,
+                                       const arma::mat& sums,
+                                       const size_t points) const
+{
+  // Compute the limits for the parameters w1, w2.
+  const size_t l2 = visibleSize;
+  const size_t l3 = 2 * hiddenSize;
 
   // Average activations of the hidden layer.
-  rhoCap = arma::sum(hiddenLayer, 1) / data.n_cols;
-  // Difference between the reconstructed data and the original data.
-  diff = outputLayer - data;
+  const arma::mat rhoCap = sums / points;
 
   double wL2SquaredNorm;
 
@@ -123,7 +125,7 @@ double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters) const
   // of the weights w1 and w2. 'klDivergence' is the cost of the hidden layer
   // activations not being low. It is given by the following formula:
   // KL = sum_over_hSize(rho*log(rho/rhoCaq) + (1-rho)*log((1-rho)/(1-rhoCap)))
-  sumOfSquaresError = 0.5 * arma::accu(diff % diff) / data.n_cols;
+  sumOfSquaresError = 0.5 * squaredError / points;
   weightDecay = 0.5 * lambda * wL2SquaredNorm;
   klDivergence = beta * arma::accu(rho * arma::log(rho / rhoCap) + (1 - rho) *
       arma::log((1 - rho) / (1 - rhoCap)));
@@ -138,6 +140,46 @@ double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters) const
   */
 void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
                                          arma::mat& gradient) const
+{
+  EvaluateWithGradient(parameters, gradient);
+}
+
+/** Calculates and stores the gradient values given a set of parameters, on one
+  * data point.
+  */
+void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
+                                         const size_t i,
+                                         arma::mat& gradient) const
+{
+  Gradient(parameters, i, 1, gradient);
+}
+
+/** Calculates and stores the gradient values given a set of parameters, on a
+  * mini-batch of data points.
+  */
+void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
+                                         const size_t begin,
+                                         const size_t batchSize,
+                                         arma::mat& gradient) const
+{
+  // The whole batch is one block: its forward and backward passes are one set
+  // of matrix products.
+  arma::mat sums = arma::zeros<arma::mat>(3 * hiddenSize + 1,
+      visibleSize + 1);
+  const double squaredError = EvaluateWithGradientBlock(parameters, begin,
+      begin + batchSize, sums);
+
+  // SGD divides by the batch size.
+  GradientFromSums(parameters, squaredError, sums, batchSize, gradient);
+  gradient *= batchSize;
+}
+
+/** Evaluates the objective function and calculates the gradient values given a
+  * set of parameters.
+  */
+double SparseAutoencoderFunction::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
 {
   // Performs a feedforward pass of the neural network, and computes the
   // activations of the output layer as in the Evaluate() method. It uses the
@@ -145,11 +187,64 @@ void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
   // except for the input layer. The delta values are then used with input layer
   // and hidden layer activations to get the parameter gradients.
 
+  // The per-point terms are summed in parallel; see
+  // EvaluateWithGradientBlock() for the layout of the sums.
+  arma::mat sums(3 * hiddenSize + 1, visibleSize + 1);
+  const double squaredError = ParallelSum(*this,
+      &SparseAutoencoderFunction::EvaluateWithGradientBlock, parameters,
+      data.n_cols, sums);
+
+  return GradientFromSums(parameters, squaredError, sums, data.n_cols,
+      gradient);
+}
+
+double SparseAutoencoderFunction::GradientFromSums(
+    const arma::mat& parameters,
+    const double squaredError,
+    const arma::mat& sums,
+    const size_t points,
+    arma::mat& gradient) const
+{
   // Compute the limits for the parameters w1, w2, b1 and b2.
   const size_t l1 = hiddenSize;
   const size_t l2 = visibleSize;
   const size_t l3 = 2 * hiddenSize;
 
+  // Average activations of the hidden layer.
+  const arma::vec rhoCap = sums.submat(l1, l2, l3 - 1, l2) / points;
+
+  // Since our cost function also includes the KL divergence term, the delta
+  // values of the hidden layer each have klDivGrad * f'(z) added to them.
+  const arma::vec klDivGrad = beta * (-(rho / rhoCap) + (1 - rho) /
+      (1 - rhoCap));
+
+  gradient = sums.rows(0, l3);
+  gradient.submat(l1, l2, l3, l2).zeros();
+  gradient.rows(0, l1 - 1) += arma::repmat(klDivGrad, 1, l2 + 1) %
+      sums.rows(l3 + 1, l3 + hiddenSize);
+  gradient /= points;
+
+  // The formula also accounts for the regularization terms in the objective
+  // function.
+  gradient.submat(0, 0, l3 - 1, l2 - 1) += lambda *
+      parameters.submat(0, 0, l3 - 1, l2 - 1);
+
+  // Calculate the cost terms as in Evaluate().
+  return Cost(parameters, squaredError, sums.submat(l1, l2, l3 - 1, l2),
+      points);
+}
+
+double SparseAutoencoderFunction::EvaluateBlock(const arma::mat& parameters,
+                                                const size_t begin,
+                                                const size_t end,
+                                                arma::mat& sums) const
+{
+  // Compute the limits for the parameters w1, w2, b1 and b2.
+  const size_t l1 = hiddenSize;
+  const size_t l2 = visibleSize;
+  const size_t l3 = 2 * hiddenSize;
+  const size_t points = end - begin;
+
   // w1, w2, b1 and b2 are not extracted separately, 'parameters' is directly
   // used in their place to avoid copying data. The following representations
   // are used:
@@ -161,45 +256,71 @@ void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
   arma::mat hiddenLayer, outputLayer;
 
   // Compute activations of the hidden and output layers.
-  Sigmoid(parameters.submat(0, 0, l1 - 1, l2 - 1) * data +
-      arma::repmat(parameters.submat(0, l2, l1 - 1, l2), 1, data.n_cols),
+  Sigmoid(parameters.submat(0, 0, l1 - 1, l2 - 1) * data.cols(begin, end - 1) +
+      arma::repmat(parameters.submat(0, l2, l1 - 1, l2), 1, points),
       hiddenLayer);
 
   Sigmoid(parameters.submat(l1, 0, l3 - 1, l2 - 1).t() * hiddenLayer +
-      arma::repmat(parameters.submat(l3, 0, l3, l2 - 1).t(), 1, data.n_cols),
+      arma::repmat(parameters.submat(l3, 0, l3, l2 - 1).t(), 1, points),
       outputLayer);
 
-  arma::mat rhoCap, diff;
+  sums += arma::sum(hiddenLayer, 1);
 
-  // Average activations of the hidden layer.
-  rhoCap = arma::sum(hiddenLayer, 1) / data.n_cols;
   // Difference between the reconstructed data and the original data.
-  diff = outputLayer - data;
+  const arma::mat diff = outputLayer - data.cols(begin, end - 1);
 
-  arma::mat klDivGrad, delOut, delHid;
+  return arma::accu(diff % diff);
+}
+
+double SparseAutoencoderFunction::EvaluateWithGradientBlock(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t end,
+    arma::mat& sums) const
+{
+  // Compute the limits for the parameters w1, w2, b1 and b2.
+  const size_t l1 = hiddenSize;
+  const size_t l2 = visibleSize;
+  const size_t l3 = 2 * hiddenSize;
+  const size_t points = end - begin;
+
+  arma::mat hiddenLayer, outputLayer;
+
+  // Compute activations of the hidden and output layers, as in
+  // EvaluateBlock().
+  Sigmoid(parameters.submat(0, 0, l1 - 1, l2 - 1) * data.cols(begin, end - 1) +
+      arma::repmat(parameters.submat(0, l2, l1 - 1, l2), 1, points),
+      hiddenLayer);
+
+  Sigmoid(parameters.submat(l1, 0, l3 - 1, l2 - 1).t() * hiddenLayer +
+      arma::repmat(parameters.submat(l3, 0, l3, l2 - 1).t(), 1, points),
+      outputLayer);
+
+  // Difference between the reconstructed data and the original data.
+  const arma::mat diff = outputLayer - data.cols(begin, end - 1);
 
   // The delta vector for the output layer is given by diff * f'(z), where z is
   // the preactivation and f is the activation function. The derivative of the
   // sigmoid function turns out to be f(z) * (1 - f(z)). For every other layer
   // in the neural network which comes before the output layer, the delta values
-  // are given del_n = w_n' * del_(n+1) * f'(z_n). Since our cost function also
-  // includes the KL divergence term, we adjust for that in the formula below.
-  klDivGrad = beta * (-(rho / rhoCap) + (1 - rho) / (1 - rhoCap));
-  delOut = diff % outputLayer % (1 - outputLayer);
-  delHid = (parameters.submat(l1, 0, l3 - 1, l2 - 1) * delOut +
-      arma::repmat(klDivGrad, 1, data.n_cols)) % hiddenLayer %
-      (1 - hiddenLayer);
-
-  gradient.zeros(2 * hiddenSize + 1, visibleSize + 1);
-
-  // Compute the gradient values using the activations and the delta values. The
-  // formula also accounts for the regularization terms in the objective.
-  // function.
-  gradient.submat(0, 0, l1 - 1, l2 - 1) = delHid * data.t() / data.n_cols +
-      lambda * parameters.submat(0, 0, l1 - 1, l2 - 1);
-  gradient.submat(l1, 0, l3 - 1, l2 - 1) =
-      (delOut * hiddenLayer.t() / data.n_cols +
-      lambda * parameters.submat(l1, 0, l3 - 1, l2 - 1).t()).t();
-  gradient.submat(0, l2, l1 - 1, l2) = arma::sum(delHid, 1) / data.n_cols;
-  gradient.submat(l3, 0, l3, l2 - 1) = (arma::sum(delOut, 1) / data.n_cols).t();
+  // are given del_n = w_n' * del_(n+1) * f'(z_n).  The KL divergence term is
+  // added later, with the sums of f'(z) for the hidden layer.
+  const arma::mat delOut = diff % outputLayer % (1 - outputLayer);
+  const arma::mat hiddenDerivative = hiddenLayer % (1 - hiddenLayer);
+  const arma::mat delHid = (parameters.submat(l1, 0, l3 - 1, l2 - 1) *
+      delOut) % hiddenDerivative;
+
+  // Compute the gradient terms using the activations and the delta values.
+  sums.submat(0, 0, l1 - 1, l2 - 1) += delHid * data.cols(begin, end - 1).t();
+  sums.submat(l1, 0, l3 - 1, l2 - 1) += hiddenLayer * delOut.t();
+  sums.submat(0, l2, l1 - 1, l2) += arma::sum(delHid, 1);
+  sums.submat(l3, 0, l3, l2 - 1) += arma::sum(delOut, 1).t();
+
+  // Terms for the average activations and the KL divergence.
+  sums.submat(l1, l2, l3 - 1, l2) += arma::sum(hiddenLayer, 1);
+  sums.submat(l3 + 1, 0, l3 + l1, l2 - 1) += hiddenDerivative *
+      data.cols(begin, end - 1).t();
+  sums.submat(l3 + 1, l2, l3 + l1, l2) += arma::sum(hiddenDerivative, 1);
+
+  return arma::accu(diff % diff);
 }
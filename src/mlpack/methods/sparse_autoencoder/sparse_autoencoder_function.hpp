@@ -9,6 +9,7 @@
 #define __MLPACK_METHODS_SPARSE_AUTOENCODER_SPARSE_AUTOENCODER_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/parallel_sum/parallel_sum.hpp>
 
 namespace mlpack {
 namespace nn {
@@ -17,6 +18,15 @@ namespace nn {
  * This is a class for the sparse autoencoder objective function. It can be used
  * to create learning models like self-taught learning, stacked autoencoders,
  * conditional random fields (CRFs), and so forth.
+ *
+ * Besides the functions used by L_BFGS, the objective can be evaluated on one
+ * data point or on a mini-batch of consecutive points, so that it can be
+ * optimized with optimization::SGD.  The sparsity (KL divergence) term
+ * depends on the average activations of the hidden layer, which are then
+ * estimated from that point or the points of that mini-batch only; so, with
+ * larger mini-batches, the estimate is better.  Each mini-batch is handled with
+ * one forward and one backward pass, so the memory needed only depends on the
+ * batch size.
  */
 class SparseAutoencoderFunction
 {
@@ -49,6 +59,8 @@ class SparseAutoencoderFunction
    * takes a low value when the model is able to reconstruct the data well
    * using weights which are low in value and when the average activations of
    * neurons in the hidden layers agrees well with the sparsity parameter 'rho'.
+   * The terms of the data points are summed in parallel (see
+   * optimization::ParallelSum()).
    *
    * @param parameters Current values of the model parameters.
    */
@@ -58,13 +70,67 @@ class SparseAutoencoderFunction
    * Evaluates the gradient values of the objective function given the current
    * set of parameters. The function performs a feedforward pass and computes
    * the error in reconstructing the data points. It then uses the
-   * backpropagation algorithm to compute the gradient values.
+   * backpropagation algorithm to compute the gradient values.  The terms of
+   * the data points are summed in parallel.
    *
    * @param parameters Current values of the model parameters.
    * @param gradient Matrix where gradient values will be stored.
    */
   void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
 
+  /**
+   * Evaluates the objective function on data point i only; the average
+   * activations of the hidden layer in the sparsity term are the activations
+   * for that point.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the data point.
+   */
+  double Evaluate(const arma::mat& parameters, const size_t i) const;
+
+  /**
+   * Evaluates the gradient of the objective function on data point i only.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the data point.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::mat& gradient) const;
+
+  /**
+   * Evaluates the gradient of the objective function on the mini-batch of data
+   * points begin through (begin + batchSize - 1), with the average activations
+   * of the batch in the sparsity term, multiplied by batchSize (since SGD
+   * divides by it).  The batch is handled with one feedforward and one
+   * backpropagation pass.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first data point of the batch.
+   * @param batchSize Number of data points in the batch.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient) const;
+
+  //! Return the number of data points, for SGD.
+  size_t NumFunctions() const { return data.n_cols; }
+
+  /**
+   * Evaluates the objective function and its gradient given the current set of
+   * parameters, with one feedforward pass over the data.  This is used by
+   * L_BFGS, which needs both at each point it visits.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param gradient Matrix where gradient values will be stored.
+   * @return Objective function value.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
   /**
    * Returns the elementwise sigmoid of the passed matrix, where the sigmoid
    * function of a real number 'x' is [1 / (1 + exp(-x))].
@@ -140,6 +206,51 @@ class SparseAutoencoderFunction
   }
 
  private:
+  /**
+   * Return the cost, given the squared reconstruction error and the sums of
+   * the hidden layer activations of the given number of points.
+   */
+  double Cost(const arma::mat& parameters,
+              const double squaredError,
+              const arma::mat& sums,
+              const size_t points) const;
+
+  /**
+   * Assemble the gradient from the sums of EvaluateWithGradientBlock() over
+   * the given number of points, and return the cost.
+   */
+  double GradientFromSums(const arma::mat& parameters,
+                          const double squaredError,
+                          const arma::mat& sums,
+                          const size_t points,
+                          arma::mat& gradient) const;
+
+  /**
+   * Return the squared reconstruction error of data points begin through
+   * (end - 1), and add the sums of their hidden layer activations to the given
+   * hiddenSize x 1 vector.
+   */
+  double EvaluateBlock(const arma::mat& parameters,
+                       const size_t begin,
+                       const size_t end,
+                       arma::mat& sums) const;
+
+  /**
+   * Return the squared reconstruction error of data points begin through
+   * (end - 1), and add their terms of the gradient to the given
+   * (3 * hiddenSize + 1) x (visibleSize + 1) matrix.  The KL divergence term
+   * depends on the average activations over all the points, so it can't be
+   * added here; instead, the first (2 * hiddenSize + 1) rows hold the gradient
+   * without the KL divergence term (in the layout of the parameters), the
+   * empty cells of the w2 rows hold the sums of the hidden layer activations,
+   * and the last hiddenSize rows hold the sums of f'(z) * [x' 1] for the
+   * hidden layer, which the KL divergence term is scaled by.
+   */
+  double EvaluateWithGradientBlock(const arma::mat& parameters,
+                                   const size_t begin,
+                                   const size_t end,
+                                   arma::mat& sums) const;
+
   //! The matrix of data points.
   const arma::mat& data;
   //! Intial parameter vector.
@@ -0,0 +1,186 @@
+/**
+ * @file online_sparse_coding.hpp
+ *
+ * Definition of the OnlineSparseCoding class, which learns a dictionary for
+ * l1 (LASSO) or l1+l2 (Elastic Net)-regularized sparse coding from a stream of
+ * mini-batches of points.
+ */
+#ifndef __MLPACK_METHODS_SPARSE_CODING_ONLINE_SPARSE_CODING_HPP
+#define __MLPACK_METHODS_SPARSE_CODING_ONLINE_SPARSE_CODING_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/lars/lars.hpp>
+
+#include "nothing_initializer.hpp"
+#include "data_dependent_random_initializer.hpp"
+#include "random_initializer.hpp"
+
+namespace mlpack {
+namespace sparse_coding {
+
+/**
+ * An implementation of online dictionary learning for sparse coding, which
+ * minimizes the same objective as SparseCoding,
+ *
+ * \f[
+ * \min_{D,Z} 0.5 ||X - D Z||_{F}^2\ + \lambda_1 \sum_{i=1}^m ||Z_i||_1
+ *                                    + 0.5 \lambda_2 \sum_{i=1}^m ||Z_i||_2^2
+ * \f]
+ *
+ * subject to \f$ ||D_j||_2 <= 1 \f$ for \f$ 1 <= j <= k \f$, but sees the
+ * points X one mini-batch at a time, so the whole dataset never has to be held
+ * in memory.  Each mini-batch is coded with LARS using the current dictionary,
+ * and its codes are added to the sufficient statistics
+ *
+ * \f[
+ * A = \sum_i Z_i Z_i^T, \quad B = \sum_i X_i Z_i^T
+ * \f]
+ *
+ * of all the points seen so far (of size k x k and d x k).  The dictionary is
+ * then updated by block coordinate descent on the atoms, which only needs A
+ * and B; no Newton steps on the dual, and no matrices over the points, are
+ * needed.  For more details, see the following paper:
+ *
+ * @code
+ * @article{mairal2010online,
+ *   title={Online learning for matrix factorization and sparse coding},
+ *   author={Mairal, J. and Bach, F. and Ponce, J. and Sapiro, G.},
+ *   journal={Journal of Machine Learning Research},
+ *   volume={11},
+ *   pages={19--60},
+ *   year={2010}
+ * }
+ * @endcode
+ *
+ * The dictionary is initialized from the first mini-batch with the
+ * DictionaryInitializer policy (as in SparseCoding); to start from a given
+ * dictionary, use the NothingInitializer and set the dictionary with the
+ * Dictionary() mutator before the first call to Step().
+ *
+ * @code
+ * OnlineSparseCoding<> osc(200, 0.1);
+ * data::ChunkReader reader("patches.csv", true);
+ * arma::mat batch;
+ * while (reader.Read(batch, 1000))
+ *   osc.Step(batch);
+ * @endcode
+ *
+ * @tparam DictionaryInitializer The class to use to initialize the
+ *     dictionary; must have 'void Initialize(const arma::mat& data, const
+ *     size_t atoms, arma::mat& dictionary)' function.
+ */
+template<typename DictionaryInitializer = DataDependentRandomInitializer>
+class OnlineSparseCoding
+{
+ public:
+  /**
+   * Set the parameters to OnlineSparseCoding.  lambda2 defaults to 0.
+   *
+   * @param atoms Number of atoms in dictionary.
+   * @param lambda1 Regularization parameter for l1-norm penalty.
+   * @param lambda2 Regularization parameter for l2-norm penalty.
+   * @param maxDictionaryIterations Maximum number of passes of block
+   *     coordinate descent over the atoms for each mini-batch.
+   * @param dictionaryTolerance The block coordinate descent stops when the
+   *     norm of the change of the dictionary in one pass is less than this.
+   */
+  OnlineSparseCoding(const size_t atoms,
+                     const double lambda1,
+                     const double lambda2 = 0,
+                     const size_t maxDictionaryIterations = 10,
+                     const double dictionaryTolerance = 1e-6);
+
+  /**
+   * Code the given mini-batch with the current dictionary, add its codes to
+   * the sufficient statistics, and update the dictionary.
+   *
+   * @param batch Mini-batch of points (one column for each point).
+   */
+  void Step(const arma::mat& batch);
+
+  /**
+   * Code the given points with the current dictionary, without changing the
+   * model.
+   *
+   * @param data Points to code.
+   * @param codes Matrix to store the codes in (one column for each point).
+   */
+  void Encode(const arma::mat& data, arma::mat& codes) const;
+
+  /**
+   * Compute the objective function on the given points and codes.
+   *
+   * @param data Points.
+   * @param codes Codes of the points.
+   */
+  double Objective(const arma::mat& data, const arma::mat& codes) const;
+
+  //! Access the dictionary.
+  const arma::mat& Dictionary() const { return dictionary; }
+  //! Modify the dictionary.
+  arma::mat& Dictionary() { return dictionary; }
+
+  //! Access A, the sum of Z_i Z_i^T over the points seen so far.
+  const arma::mat& CodesZT() const { return codesZT; }
+  //! Access B, the sum of X_i Z_i^T over the points seen so far.
+  const arma::mat& DataZT() const { return dataZT; }
+
+  //! Get the number of points seen so far.
+  size_t Points() const { return points; }
+
+  //! Get the maximum number of block coordinate descent passes per batch.
+  size_t MaxDictionaryIterations() const { return maxDictionaryIterations; }
+  //! Modify the maximum number of block coordinate descent passes per batch.
+  size_t& MaxDictionaryIterations() { return maxDictionaryIterations; }
+
+  //! Get the tolerance of the block coordinate descent.
+  double DictionaryTolerance() const { return dictionaryTolerance; }
+  //! Modify the tolerance of the block coordinate descent.
+  double& DictionaryTolerance() { return dictionaryTolerance; }
+
+  // Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! Number of atoms.
+  size_t atoms;
+
+  //! l1 regularization term.
+  double lambda1;
+
+  //! l2 regularization term.
+  double lambda2;
+
+  //! Maximum number of block coordinate descent passes per batch.
+  size_t maxDictionaryIterations;
+
+  //! Tolerance of the block coordinate descent.
+  double dictionaryTolerance;
+
+  //! Dictionary (columns are atoms).
+  arma::mat dictionary;
+
+  //! Sum of Z_i Z_i^T over the points seen so far.
+  arma::mat codesZT;
+
+  //! Sum of X_i Z_i^T over the points seen so far.
+  arma::mat dataZT;
+
+  //! Number of points seen so far.
+  size_t points;
+
+  /**
+   * Update the dictionary by block coordinate descent on the atoms, using the
+   * sufficient statistics.  Atoms that have never been used are reinitialized
+   * from random points of the given batch.
+   */
+  void UpdateDictionary(const arma::mat& batch);
+};
+
+}; // namespace sparse_coding
+}; // namespace mlpack
+
+// Include implementation.
+#include "online_sparse_coding_impl.hpp"
+
+#endif
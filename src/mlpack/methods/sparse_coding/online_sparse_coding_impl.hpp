@@ -0,0 +1,161 @@
+/**
+ * @file online_sparse_coding_impl.hpp
+ *
+ * Implementation of online dictionary learning for sparse coding.
+ */
+#ifndef __MLPACK_METHODS_SPARSE_CODING_ONLINE_SPARSE_CODING_IMPL_HPP
+#define __MLPACK_METHODS_SPARSE_CODING_ONLINE_SPARSE_CODING_IMPL_HPP
+
+// In case it hasn't already been included.
+#include "online_sparse_coding.hpp"
+
+namespace mlpack {
+namespace sparse_coding {
+
+template<typename DictionaryInitializer>
+OnlineSparseCoding<DictionaryInitializer>::OnlineSparseCoding(
+    const size_t atoms,
+    const double lambda1,
+    const double lambda2,
+    const size_t maxDictionaryIterations,
+    const double dictionaryTolerance) :
+    atoms(atoms),
+    lambda1(lambda1),
+    lambda2(lambda2),
+    maxDictionaryIterations(maxDictionaryIterations),
+    dictionaryTolerance(dictionaryTolerance),
+    points(0)
+{ /* Nothing to do. */ }
+
+template<typename DictionaryInitializer>
+void OnlineSparseCoding<DictionaryInitializer>::Step(const arma::mat& batch)
+{
+  if (batch.n_cols == 0)
+    return;
+
+  // Initialize the dictionary and the sufficient statistics with the first
+  // batch.
+  if (points == 0)
+  {
+    DictionaryInitializer::Initialize(batch, atoms, dictionary);
+
+    if (dictionary.n_rows != batch.n_rows || dictionary.n_cols != atoms)
+      Log::Fatal << "OnlineSparseCoding::Step(): the dictionary is "
+          << dictionary.n_rows << "x" << dictionary.n_cols << ", but the data "
+          << "has " << batch.n_rows << " dimensions and there are " << atoms
+          << " atoms!" << std::endl;
+
+    codesZT.zeros(atoms, atoms);
+    dataZT.zeros(batch.n_rows, atoms);
+  }
+  else if (batch.n_rows != dictionary.n_rows)
+  {
+    Log::Fatal << "OnlineSparseCoding::Step(): the batch has " << batch.n_rows
+        << " dimensions, but the dictionary has " << dictionary.n_rows << "!"
+        << std::endl;
+  }
+
+  arma::mat codes;
+  Encode(batch, codes);
+
+  codesZT += codes * trans(codes);
+  dataZT += batch * trans(codes);
+  points += batch.n_cols;
+
+  UpdateDictionary(batch);
+}
+
+template<typename DictionaryInitializer>
+void OnlineSparseCoding<DictionaryInitializer>::Encode(const arma::mat& data,
+                                                       arma::mat& codes) const
+{
+  // As in SparseCoding, the Gram matrix is correct for the Cholesky version of
+  // LARS even if lambda2 > 0.  All the points are coded in parallel.
+  const arma::mat matGram = trans(dictionary) * dictionary;
+  regression::LARS lars(true, matGram, lambda1, lambda2);
+  lars.Regress(dictionary, data, codes, false);
+}
+
+template<typename DictionaryInitializer>
+void OnlineSparseCoding<DictionaryInitializer>::UpdateDictionary(
+    const arma::mat& batch)
+{
+  // Atoms that no point has used yet get no update; start them again from
+  // random points, as SparseCoding does.
+  size_t inactiveAtoms = 0;
+  for (size_t j = 0; j < atoms; ++j)
+  {
+    if (codesZT(j, j) != 0)
+      continue;
+
+    dictionary.col(j) = (batch.col(math::RandInt(batch.n_cols)) +
+                         batch.col(math::RandInt(batch.n_cols)) +
+                         batch.col(math::RandInt(batch.n_cols)));
+    dictionary.col(j) /= arma::norm(dictionary.col(j), 2);
+    ++inactiveAtoms;
+  }
+
+  if (inactiveAtoms > 0)
+    Log::Debug << "Reinitialized " << inactiveAtoms << " inactive atoms."
+        << std::endl;
+
+  // Each atom minimizes the objective with the others fixed:
+  //   d_j = Project(d_j + (B_j - D A_j) / A_jj),
+  // where Project() shrinks the atom onto the unit ball.
+  arma::vec atom;
+  for (size_t t = 0; t < maxDictionaryIterations; ++t)
+  {
+    double change = 0;
+    for (size_t j = 0; j < atoms; ++j)
+    {
+      if (codesZT(j, j) == 0)
+        continue;
+
+      atom = dictionary.col(j) + (dataZT.col(j) - dictionary *
+          codesZT.col(j)) / codesZT(j, j);
+
+      const double atomNorm = arma::norm(atom, 2);
+      if (atomNorm > 1)
+        atom /= atomNorm;
+
+      change += arma::accu(arma::square(atom - dictionary.col(j)));
+      dictionary.col(j) = atom;
+    }
+
+    Log::Debug << "Block coordinate descent pass " << t << ": dictionary change"
+        << " " << std::sqrt(change) << "." << std::endl;
+
+    if (std::sqrt(change) < dictionaryTolerance)
+      break;
+  }
+}
+
+template<typename DictionaryInitializer>
+double OnlineSparseCoding<DictionaryInitializer>::Objective(
+    const arma::mat& data,
+    const arma::mat& codes) const
+{
+  const double l11NormZ = arma::accu(arma::abs(codes));
+  const double froNormResidual = arma::norm(data - (dictionary * codes), "fro");
+  const double froNormZ = arma::norm(codes, "fro");
+
+  return 0.5 * (std::pow(froNormResidual, 2.0) + (lambda2 *
+      std::pow(froNormZ, 2.0))) + (lambda1 * l11NormZ);
+}
+
+template<typename DictionaryInitializer>
+std::string OnlineSparseCoding<DictionaryInitializer>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "Online Sparse Coding  [" << this << "]" << std::endl;
+  convert << "  Atoms: " << atoms << std::endl;
+  convert << "  Points seen: " << points << std::endl;
+  convert << "  Lambda 1: " << lambda1 << std::endl;
+  convert << "  Lambda 2: " << lambda2 << std::endl;
+  return convert.str();
+}
+
+}; // namespace sparse_coding
+}; // namespace mlpack
+
+#endif
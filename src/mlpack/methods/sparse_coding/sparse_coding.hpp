@@ -138,19 +138,17 @@ class SparseCoding
   void OptimizeCode();
 
   /**
-   * Learn dictionary via Newton method based on Lagrange dual.
+   * Learn dictionary via Newton method based on Lagrange dual.  The products
+   * of the codes with the data and with themselves use only the nonzero
+   * entries of the sparse codes.
    *
-   * @param adjacencies Indices of entries (unrolled column by column) of
-   *    the coding matrix Z that are non-zero (the adjacency matrix for the
-   *    bipartite graph of points and atoms).
    * @param newtonTolerance Tolerance of the Newton's method optimizer.
    * @param maxIterations Maximum number of iterations to run the Newton's method.
    *     If 0, the method will run until convergence (or forever).
    * @return the norm of the gradient of the Lagrange dual with respect to
    *    the dual variables
    */
-  double OptimizeDictionary(const arma::uvec& adjacencies,
-                            const double newtonTolerance = 1e-6,
+  double OptimizeDictionary(const double newtonTolerance = 1e-6,
                             const size_t maxIterations = 50);
 
   /**
@@ -172,9 +170,9 @@ class SparseCoding
   arma::mat& Dictionary() { return dictionary; }
 
   //! Access the sparse codes.
-  const arma::mat& Codes() const { return codes; }
+  const arma::sp_mat& Codes() const { return codes; }
   //! Modify the sparse codes.
-  arma::mat& Codes() { return codes; }
+  arma::sp_mat& Codes() { return codes; }
 
   // Returns a string representation of this object. 
   std::string ToString() const;
@@ -189,8 +187,8 @@ class SparseCoding
   //! Dictionary (columns are atoms).
   arma::mat dictionary;
 
-  //! Sparse codes (columns are points).
-  arma::mat codes;
+  //! Sparse codes (columns are points), stored by column.
+  arma::sp_mat codes;
 
   //! l1 regularization term.
   double lambda1;
@@ -43,9 +43,8 @@ void SparseCoding<DictionaryInitializer>::Encode(const size_t maxIterations,
   Log::Info << "Initial Coding Step." << std::endl;
 
   OptimizeCode();
-  arma::uvec adjacencies = find(codes);
 
-  Log::Info << "  Sparsity level: " << 100.0 * ((double) (adjacencies.n_elem))
+  Log::Info << "  Sparsity level: " << 100.0 * ((double) (codes.n_nonzero))
       / ((double) (atoms * data.n_cols)) << "%." << std::endl;
   Log::Info << "  Objective value: " << Objective() << "." << std::endl;
 
@@ -60,15 +59,13 @@ void SparseCoding<DictionaryInitializer>::Encode(const size_t maxIterations,
 
     // First step: optimize the dictionary.
     Log::Info << "Performing dictionary step... " << std::endl;
-    OptimizeDictionary(adjacencies, newtonTolerance);
+    OptimizeDictionary(newtonTolerance);
     Log::Info << "  Objective value: " << Objective() << "." << std::endl;
 
     // Second step: perform the coding.
     Log::Info << "Performing coding step..." << std::endl;
     OptimizeCode();
-    // Get the indices of all the nonzero elements in the codes.
-    adjacencies = find(codes);
-    Log::Info << "  Sparsity level: " << 100.0 * ((double) (adjacencies.n_elem))
+    Log::Info << "  Sparsity level: " << 100.0 * ((double) (codes.n_nonzero))
         / ((double) (atoms * data.n_cols)) << "%." << std::endl;
 
     // Find the new objective value and improvement so we can check for
@@ -98,72 +95,36 @@ void SparseCoding<DictionaryInitializer>::OptimizeCode()
   // lambda2 > 0.
   arma::mat matGram = trans(dictionary) * dictionary;
 
-  for (size_t i = 0; i < data.n_cols; ++i)
-  {
-    // Report progress.
-    if ((i % 100) == 0)
-      Log::Debug << "Optimization at point " << i << "." << std::endl;
-
-    bool useCholesky = true;
-    regression::LARS lars(useCholesky, matGram, lambda1, lambda2);
-
-    // Create an alias of the code (using the same memory), and then LARS will
-    // place the result directly into that; then we will not need to have an
-    // extra copy.
-    arma::vec code = codes.unsafe_col(i);
-    lars.Regress(dictionary, data.unsafe_col(i), code, false);
-  }
+  // The Gram matrix is shared by every point, and the points are coded in
+  // parallel; the codes are assembled directly from the nonzero coefficients.
+  bool useCholesky = true;
+  regression::LARS lars(useCholesky, matGram, lambda1, lambda2);
+  lars.Regress(dictionary, data, codes, false);
 }
 
 // Dictionary step for optimization.
 template<typename DictionaryInitializer>
 double SparseCoding<DictionaryInitializer>::OptimizeDictionary(
-    const arma::uvec& adjacencies,
     const double newtonTolerance,
     const size_t maxIterations)
 {
-  // Count the number of atomic neighbors for each point x^i.
-  arma::uvec neighborCounts = arma::zeros<arma::uvec>(data.n_cols, 1);
-
-  if (adjacencies.n_elem > 0)
-  {
-    // This gets the column index.  Intentional integer division.
-    size_t curPointInd = (size_t) (adjacencies(0) / atoms);
-
-    size_t nextColIndex = (curPointInd + 1) * atoms;
-    for (size_t l = 1; l < adjacencies.n_elem; ++l)
-    {
-      // If l no longer refers to an element in this column, advance the column
-      // number accordingly.
-      if (adjacencies(l) >= nextColIndex)
-      {
-        curPointInd = (size_t) (adjacencies(l) / atoms);
-        nextColIndex = (curPointInd + 1) * atoms;
-      }
-
-      ++neighborCounts(curPointInd);
-    }
-  }
-
   // Handle the case of inactive atoms (atoms not used in the given coding).
-  std::vector<size_t> inactiveAtoms;
+  // The codes are stored by column, so count the nonzero coefficients of each
+  // atom.
+  arma::uvec atomCounts = arma::zeros<arma::uvec>(atoms);
+  for (size_t i = 0; i < codes.n_nonzero; ++i)
+    ++atomCounts[codes.row_indices[i]];
 
+  std::vector<size_t> inactiveAtoms;
   for (size_t j = 0; j < atoms; ++j)
   {
-    if (arma::accu(codes.row(j) != 0) == 0)
+    if (atomCounts[j] == 0)
       inactiveAtoms.push_back(j);
   }
 
   const size_t nInactiveAtoms = inactiveAtoms.size();
   const size_t nActiveAtoms = atoms - nInactiveAtoms;
 
-  // Efficient construction of Z restricted to active atoms.
-  arma::mat matActiveZ;
-  if (nInactiveAtoms > 0)
-  {
-    math::RemoveRows(codes, inactiveAtoms, matActiveZ);
-  }
-
   if (nInactiveAtoms > 0)
   {
     Log::Warn << "There are " << nInactiveAtoms
@@ -192,19 +153,22 @@ double SparseCoding<DictionaryInitializer>::OptimizeDictionary(
 
   bool converged = false;
 
-  // If we have any inactive atoms, we must construct these differently.
-  arma::mat codesXT;
-  arma::mat codesZT;
+  // Both products only touch the nonzero coefficients of the codes.  If we
+  // have any inactive atoms, their (zero) rows and columns are removed.
+  arma::mat codesXT = codes * trans(data);
+  arma::mat codesZT(codes * trans(codes));
 
-  if (inactiveAtoms.empty())
+  if (!inactiveAtoms.empty())
   {
-    codesXT = codes * trans(data);
-    codesZT = codes * trans(codes);
-  }
-  else
-  {
-    codesXT = matActiveZ * trans(data);
-    codesZT = matActiveZ * trans(matActiveZ);
+    arma::mat activeXT;
+    math::RemoveRows(codesXT, inactiveAtoms, activeXT);
+    codesXT = activeXT;
+
+    arma::mat activeZT;
+    math::RemoveRows(codesZT, inactiveAtoms, activeZT);
+    codesZT = trans(activeZT);
+    math::RemoveRows(codesZT, inactiveAtoms, activeZT);
+    codesZT = activeZT;
   }
 
   double normGradient = 0;
@@ -319,14 +283,21 @@ void SparseCoding<DictionaryInitializer>::ProjectDictionary()
 template<typename DictionaryInitializer>
 double SparseCoding<DictionaryInitializer>::Objective() const
 {
-  double l11NormZ = arma::sum(arma::sum(arma::abs(codes)));
+  // Only the nonzero coefficients of the codes contribute to their norms.
+  double l11NormZ = 0.0;
+  double sqFroNormZ = 0.0;
+  for (size_t i = 0; i < codes.n_nonzero; ++i)
+  {
+    l11NormZ += std::abs(codes.values[i]);
+    sqFroNormZ += codes.values[i] * codes.values[i];
+  }
+
   double froNormResidual = arma::norm(data - (dictionary * codes), "fro");
 
   if (lambda2 > 0)
   {
-    double froNormZ = arma::norm(codes, "fro");
-    return 0.5 * (std::pow(froNormResidual, 2.0) + (lambda2 *
-        std::pow(froNormZ, 2.0))) + (lambda1 * l11NormZ);
+    return 0.5 * (std::pow(froNormResidual, 2.0) + (lambda2 * sqFroNormZ)) +
+        (lambda1 * l11NormZ);
   }
   else // It can be simpler.
   {
@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include "sparse_coding.hpp"
+#include "online_sparse_coding.hpp"
 
 PROGRAM_INFO("Sparse Coding", "An implementation of Sparse Coding with "
     "Dictionary Learning, which achieves sparsity via an l1-norm regularizer on"
@@ -34,7 +35,13 @@ PROGRAM_INFO("Sparse Coding", "An implementation of Sparse Coding with "
     "\n\n"
     "The maximum number of iterations may be specified with the -n option. "
     "Optionally, the input data matrix X can be normalized before coding with "
-    "the -N option.");
+    "the -N option."
+    "\n\n"
+    "If a batch size is given with --batch_size (-b), the dictionary is instead"
+    " learned online, reading the input file a mini-batch at a time, so that "
+    "X is never held in memory; the file is read the number of times given by "
+    "--passes (-p), and the codes are then computed and written a mini-batch "
+    "at a time.");
 
 PARAM_STRING_REQ("input_file", "Filename of the input data.", "i");
 PARAM_INT_REQ("atoms", "Number of atoms in the dictionary.", "k");
@@ -65,12 +72,91 @@ PARAM_DOUBLE("objective_tolerance", "Tolerance for convergence of the objective"
 PARAM_DOUBLE("newton_tolerance", "Tolerance for convergence of Newton method.",
     "w", 1e-6);
 
+PARAM_INT("batch_size", "If nonzero, learn the dictionary online from "
+    "mini-batches of this many points.", "b", 0);
+PARAM_INT("passes", "Number of passes over the input file for online "
+    "dictionary learning.", "p", 1);
+
 using namespace arma;
 using namespace std;
 using namespace mlpack;
 using namespace mlpack::math;
 using namespace mlpack::sparse_coding;
 
+// Learn the dictionary from mini-batches of the input file, then code the
+// points a mini-batch at a time.
+void OnlineEncode(const string& inputFile,
+                  const size_t atoms,
+                  const double lambda1,
+                  const double lambda2,
+                  const bool normalize,
+                  const string& initialDictionaryFile,
+                  const size_t batchSize,
+                  const size_t passes,
+                  const string& dictionaryFile,
+                  const string& codesFile)
+{
+  OnlineSparseCoding<NothingInitializer> osc(atoms, lambda1, lambda2);
+
+  data::ChunkReader reader(inputFile, true);
+  mat batch;
+  if (!reader.Read(batch, batchSize))
+    Log::Fatal << "Could not read any points from '" << inputFile << "'!"
+        << endl;
+
+  // The dictionary is initialized from the first batch, unless one was given.
+  if (initialDictionaryFile != "")
+    data::Load(initialDictionaryFile, osc.Dictionary(), true);
+  else
+    DataDependentRandomInitializer::Initialize(batch, atoms, osc.Dictionary());
+
+  for (size_t pass = 0; pass < passes; ++pass)
+  {
+    Log::Info << "Pass " << pass + 1 << " of " << passes << "." << endl;
+
+    if (pass > 0)
+    {
+      reader.Reset();
+      reader.Read(batch, batchSize);
+    }
+
+    do
+    {
+      if (normalize)
+        for (size_t i = 0; i < batch.n_cols; ++i)
+          batch.col(i) /= norm(batch.col(i), 2);
+
+      osc.Step(batch);
+    } while (reader.Read(batch, batchSize));
+
+    if (reader.Failed())
+      Log::Fatal << "Could not read '" << inputFile << "'!" << endl;
+
+    Log::Info << "  Learned from " << osc.Points() << " points." << endl;
+  }
+
+  Log::Info << "Saving dictionary matrix to '" << dictionaryFile << "'.\n";
+  data::Save(dictionaryFile, osc.Dictionary());
+
+  Log::Info << "Saving sparse codes to '" << codesFile << "'.\n";
+  data::ChunkWriter writer(codesFile, true, true);
+  reader.Reset();
+  mat codes;
+  double objective = 0;
+  while (reader.Read(batch, batchSize))
+  {
+    if (normalize)
+      for (size_t i = 0; i < batch.n_cols; ++i)
+        batch.col(i) /= norm(batch.col(i), 2);
+
+    osc.Encode(batch, codes);
+    objective += osc.Objective(batch, codes);
+    writer.Write(codes);
+  }
+
+  Log::Info << "Objective value: " << objective << "." << endl;
+}
+
 int main(int argc, char* argv[])
 {
   CLI::ParseCommandLine(argc, argv);
@@ -97,6 +183,14 @@ int main(int argc, char* argv[])
   const double objTolerance = CLI::GetParam<double>("objective_tolerance");
   const double newtonTolerance = CLI::GetParam<double>("newton_tolerance");
 
+  if (CLI::GetParam<int>("batch_size") > 0)
+  {
+    OnlineEncode(inputFile, atoms, lambda1, lambda2, normalize,
+        initialDictionaryFile, (size_t) CLI::GetParam<int>("batch_size"),
+        (size_t) CLI::GetParam<int>("passes"), dictionaryFile, codesFile);
+    return 0;
+  }
+
   mat matX;
   data::Load(inputFile, matX, true);
 
@@ -141,7 +235,7 @@ int main(int argc, char* argv[])
     Log::Info << "Saving dictionary matrix to '" << dictionaryFile << "'.\n";
     data::Save(dictionaryFile, sc.Dictionary());
     Log::Info << "Saving sparse codes to '" << codesFile << "'.\n";
-    data::Save(codesFile, sc.Codes());
+    data::Save(codesFile, mat(sc.Codes()));
   }
   else
   {
@@ -155,6 +249,6 @@ int main(int argc, char* argv[])
     Log::Info << "Saving dictionary matrix to '" << dictionaryFile << "'.\n";
     data::Save(dictionaryFile, sc.Dictionary());
     Log::Info << "Saving sparse codes to '" << codesFile << "'.\n";
-    data::Save(codesFile, sc.Codes());
+    data::Save(codesFile, mat(sc.Codes()));
   }
 }
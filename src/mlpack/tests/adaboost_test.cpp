@@ -323,6 +323,44 @@ BOOST_AUTO_TEST_CASE(HammingLossIris_DS)
   BOOST_REQUIRE(hammingLoss <= ztP);
 }
 
+/**
+ *  This test case runs the AdaBoost.mh algorithm on the UCI Iris dataset, with
+ *  quantized Decision Stumps, which bin the data once for all the rounds.
+ *  It checks whether the hamming loss breaches the upperbound, which
+ *  is provided by ztAccumulator.
+ */
+BOOST_AUTO_TEST_CASE(HammingLossIris_QuantizedDS)
+{
+  arma::mat inputData;
+
+  if (!data::Load("iris.txt", inputData))
+    BOOST_FAIL("Cannot load test dataset iris.txt!");
+
+  arma::Mat<size_t> labels;
+
+  if (!data::Load("iris_labels.txt",labels))
+    BOOST_FAIL("Cannot load labels for iris_labels.txt");
+
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 6;
+
+  decision_stump::DecisionStump<> ds(inputData, labels.row(0),
+                                     numClasses, inpBucketSize, 16);
+  int iterations = 50;
+  double tolerance = 1e-10;
+
+  AdaBoost<arma::mat, mlpack::decision_stump::DecisionStump<> > a(inputData,
+          labels.row(0), iterations, tolerance, ds);
+  int countError = 0;
+  for (size_t i = 0; i < labels.n_cols; i++)
+    if(labels(i) != a.finalHypothesis(i))
+      countError++;
+  double hammingLoss = (double) countError / labels.n_cols;
+
+  double ztP = a.GetztProduct();
+  BOOST_REQUIRE(hammingLoss <= ztP);
+}
+
 /**
  *  This test case runs the AdaBoost.mh algorithm on a non-linearly
  *  separable dataset.
@@ -441,6 +441,39 @@ BOOST_AUTO_TEST_CASE(SingleTreeVsNaive)
   }
 }
 
+/**
+ * Make sure that with epsilon > 0, dual-tree and single-tree search return
+ * neighbors whose distances are at least the true distances divided by
+ * (1 + epsilon).
+ */
+BOOST_AUTO_TEST_CASE(ApproximateEpsilonTest)
+{
+  arma::mat dataset;
+  dataset.randu(10, 2000);
+
+  AllkFN naive(dataset, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  const double epsilon = 0.1;
+  for (size_t singleMode = 0; singleMode < 2; ++singleMode)
+  {
+    AllkFN allkfn(dataset, false, singleMode == 1);
+    allkfn.Epsilon() = epsilon;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allkfn.Search(5, neighbors, distances);
+
+    for (size_t i = 0; i < distances.n_elem; ++i)
+    {
+      BOOST_REQUIRE_GE(distances[i], naiveDistances[i] / (1 + epsilon) - 1e-5);
+      BOOST_REQUIRE_LE(distances[i], naiveDistances[i] + 1e-5);
+    }
+  }
+}
+
 /**
  * Test the cover tree single-tree furthest-neighbors method against the naive
  * method.  This uses only a random reference dataset.
@@ -6,10 +6,18 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 #include <mlpack/methods/neighbor_search/unmap.hpp>
+#include <mlpack/methods/neighbor_search/mahalanobis_search.hpp>
+#include <mlpack/methods/neighbor_search/search_tuner.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/core/tree/example_tree.hpp>
+#include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/core/tree/best_first_single_tree_traverser.hpp>
+#ifdef HAS_CUDA
+  #include <mlpack/core/gpu/knn.hpp>
+#endif
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
+#include <algorithm>
 
 using namespace mlpack;
 using namespace mlpack::neighbor;
@@ -160,6 +168,63 @@ BOOST_AUTO_TEST_CASE(SingleTreeUnmapTest)
   }
 }
 
+/**
+ * Check that the in-place Unmap() overloads give the same results as the
+ * copying ones, for permutations with cycles of many different lengths.
+ */
+BOOST_AUTO_TEST_CASE(InPlaceUnmapTest)
+{
+  std::vector<size_t> refMap(50);
+  std::vector<size_t> queryMap(70);
+  for (size_t i = 0; i < refMap.size(); ++i)
+    refMap[i] = i;
+  for (size_t i = 0; i < queryMap.size(); ++i)
+    queryMap[i] = i;
+  std::random_shuffle(refMap.begin(), refMap.end());
+  std::random_shuffle(queryMap.begin(), queryMap.end());
+
+  arma::Mat<size_t> neighbors(5, 70);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    neighbors[i] = math::RandInt(50);
+  arma::mat distances(5, 70);
+  distances.randu();
+
+  arma::Mat<size_t> neighborsOut;
+  arma::mat distancesOut;
+  arma::Mat<size_t> neighborsInPlace;
+  arma::mat distancesInPlace;
+
+  for (size_t squareRoot = 0; squareRoot < 2; ++squareRoot)
+  {
+    // The dual-tree case.
+    Unmap(neighbors, distances, refMap, queryMap, neighborsOut, distancesOut,
+        squareRoot == 1);
+    neighborsInPlace = neighbors;
+    distancesInPlace = distances;
+    Unmap(neighborsInPlace, distancesInPlace, refMap, queryMap,
+        squareRoot == 1);
+
+    for (size_t i = 0; i < neighborsOut.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighborsInPlace[i], neighborsOut[i]);
+      BOOST_REQUIRE_CLOSE(distancesInPlace[i], distancesOut[i], 1e-5);
+    }
+
+    // The single-tree case.
+    Unmap(neighbors, distances, refMap, neighborsOut, distancesOut,
+        squareRoot == 1);
+    neighborsInPlace = neighbors;
+    distancesInPlace = distances;
+    Unmap(neighborsInPlace, distancesInPlace, refMap, squareRoot == 1);
+
+    for (size_t i = 0; i < neighborsOut.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighborsInPlace[i], neighborsOut[i]);
+      BOOST_REQUIRE_CLOSE(distancesInPlace[i], distancesOut[i], 1e-5);
+    }
+  }
+}
+
 /**
  * Simple nearest-neighbors test with small, synthetic dataset.  This is an
  * exhaustive test, which checks that each method for performing the calculation
@@ -548,6 +613,94 @@ BOOST_AUTO_TEST_CASE(DualTreeVsNaive2)
   }
 }
 
+/**
+ * Make sure that building the trees on the memory of the given datasets gives
+ * the same results as building them on copies, and that the rearranged sets
+ * and the mappings to their original indices are given back.
+ */
+BOOST_AUTO_TEST_CASE(DualTreeTakeDatasetsTest)
+{
+  arma::mat dataForTree;
+  if (!data::Load("test_data_3_1000.csv", dataForTree))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::mat references = dataForTree.cols(0, 499);
+  arma::mat query = dataForTree.cols(500, 999);
+  arma::mat referencesTaken(references);
+  arma::mat queryTaken(query);
+
+  AllkNN allknn(references, query);
+  AllkNN taken(&referencesTaken, &queryTaken);
+
+  // The memory of the matrices was taken.
+  BOOST_REQUIRE(referencesTaken.is_empty());
+  BOOST_REQUIRE(queryTaken.is_empty());
+
+  arma::Mat<size_t> neighbors, neighborsTaken;
+  arma::mat distances, distancesTaken;
+  allknn.Search(15, neighbors, distances);
+  taken.Search(15, neighborsTaken, distancesTaken);
+
+  for (size_t i = 0; i < neighbors.n_elem; i++)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], neighborsTaken[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], distancesTaken[i], 1e-5);
+  }
+
+  // The rearranged sets hold the original points, in the order given by the
+  // mappings.
+  BOOST_REQUIRE_EQUAL(taken.OldFromNewReferences().size(), (size_t) 500);
+  BOOST_REQUIRE_EQUAL(taken.OldFromNewQueries().size(), (size_t) 500);
+  for (size_t i = 0; i < 500; i++)
+  {
+    for (size_t d = 0; d < references.n_rows; d++)
+    {
+      BOOST_REQUIRE_EQUAL(taken.ReferenceSet()(d, i),
+          references(d, taken.OldFromNewReferences()[i]));
+      BOOST_REQUIRE_EQUAL(taken.QuerySet()(d, i),
+          query(d, taken.OldFromNewQueries()[i]));
+    }
+  }
+}
+
+/**
+ * Test the multithreaded dual-tree nearest-neighbors method against the naive
+ * method.  The results and the total number of base cases should not depend on
+ * the number of threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeVsNaive)
+{
+  arma::mat dataForTree;
+
+  if (!data::Load("test_data_3_1000.csv", dataForTree))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::mat dualQuery(dataForTree);
+  arma::mat naiveQuery(dataForTree);
+
+  AllkNN allknn(dualQuery);
+  allknn.NumThreads() = 4;
+
+  AllkNN naive(naiveQuery, true);
+
+  arma::Mat<size_t> resultingNeighborsTree;
+  arma::mat distancesTree;
+  allknn.Search(15, resultingNeighborsTree, distancesTree);
+
+  arma::Mat<size_t> resultingNeighborsNaive;
+  arma::mat distancesNaive;
+  naive.Search(15, resultingNeighborsNaive, distancesNaive);
+
+  BOOST_REQUIRE_GT(allknn.BaseCases(), 0);
+  BOOST_REQUIRE_LE(allknn.BaseCases(), naive.BaseCases());
+
+  for (size_t i = 0; i < resultingNeighborsTree.n_elem; i++)
+  {
+    BOOST_REQUIRE(resultingNeighborsTree(i) == resultingNeighborsNaive(i));
+    BOOST_REQUIRE_CLOSE(distancesTree(i), distancesNaive(i), 1e-5);
+  }
+}
+
 /**
  * Test the single-tree nearest-neighbors method with the naive method.  This
  * uses only a reference dataset.
@@ -587,6 +740,510 @@ BOOST_AUTO_TEST_CASE(SingleTreeVsNaive)
   }
 }
 
+/**
+ * Make sure that with epsilon > 0, dual-tree and single-tree search return
+ * neighbors whose distances are within a factor of (1 + epsilon) of the true
+ * distances.
+ */
+BOOST_AUTO_TEST_CASE(ApproximateEpsilonTest)
+{
+  arma::mat dataset;
+  dataset.randu(10, 2000);
+
+  AllkNN naive(dataset, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  const double epsilon = 0.1;
+  for (size_t singleMode = 0; singleMode < 2; ++singleMode)
+  {
+    AllkNN allknn(dataset, false, singleMode == 1);
+    allknn.Epsilon() = epsilon;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allknn.Search(5, neighbors, distances);
+
+    for (size_t i = 0; i < distances.n_elem; ++i)
+    {
+      BOOST_REQUIRE_LE(distances[i], (1 + epsilon) * naiveDistances[i] + 1e-5);
+      BOOST_REQUIRE_GE(distances[i], naiveDistances[i] - 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that single-tree search gives the same results whether or not the
+ * queries are visited along the Hilbert curve and seeded with the results of
+ * the last query, with one neighbor and with several, with and without a
+ * separate query set.
+ */
+BOOST_AUTO_TEST_CASE(ReorderedSeededSingleTreeTest)
+{
+  arma::mat references;
+  references.randu(3, 2000);
+  arma::mat queries;
+  queries.randu(3, 500);
+
+  for (size_t k = 1; k <= 10; k += 9)
+  {
+    for (size_t monochromatic = 0; monochromatic < 2; ++monochromatic)
+    {
+      AllkNN naive(references, true);
+      arma::Mat<size_t> naiveNeighbors;
+      arma::mat naiveDistances;
+      if (monochromatic == 1)
+        naive.Search(k, naiveNeighbors, naiveDistances);
+      else
+        naive.Search(queries, k, naiveNeighbors, naiveDistances);
+
+      for (size_t options = 0; options < 4; ++options)
+      {
+        AllkNN allknn(references, false, true);
+        allknn.ReorderQueries() = (options % 2 == 1);
+        allknn.SeedQueries() = (options / 2 == 1);
+        allknn.NumThreads() = 4;
+
+        arma::Mat<size_t> neighbors;
+        arma::mat distances;
+        if (monochromatic == 1)
+          allknn.Search(k, neighbors, distances);
+        else
+          allknn.Search(queries, k, neighbors, distances);
+
+        BOOST_REQUIRE_EQUAL(neighbors.n_rows, naiveNeighbors.n_rows);
+        BOOST_REQUIRE_EQUAL(neighbors.n_cols, naiveNeighbors.n_cols);
+        for (size_t i = 0; i < neighbors.n_elem; ++i)
+        {
+          BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+          BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Test the dual-tree nearest-neighbors method against the single-tree method on
+ * high-dimensional data, where the base cases between two leaves are computed
+ * with a matrix multiplication.
+ *
+ * Errors are produced if the results are not identical.
+ */
+BOOST_AUTO_TEST_CASE(DualTreeBlockBaseCasesTest)
+{
+  arma::mat dataForTree;
+  dataForTree.randu(20, 1000);
+
+  arma::mat dualReferences(dataForTree);
+  arma::mat singleReferences(dataForTree);
+
+  AllkNN allknn(dualReferences);
+  AllkNN single(singleReferences, false, true);
+
+  arma::Mat<size_t> resultingNeighborsTree;
+  arma::mat distancesTree;
+  allknn.Search(10, resultingNeighborsTree, distancesTree);
+
+  arma::Mat<size_t> resultingNeighborsSingle;
+  arma::mat distancesSingle;
+  single.Search(10, resultingNeighborsSingle, distancesSingle);
+
+  for (size_t i = 0; i < resultingNeighborsTree.n_elem; i++)
+  {
+    BOOST_REQUIRE(resultingNeighborsTree[i] == resultingNeighborsSingle[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesSingle[i], 1e-5);
+  }
+}
+
+//! The Euclidean distance, with no way to compute blocks of distances at once,
+//! so the base cases between leaves are evaluated one by one.
+class PointwiseEuclidean
+{
+ public:
+  template<typename VecType1, typename VecType2>
+  double Evaluate(const VecType1& a, const VecType2& b) const
+  {
+    return EuclideanDistance::Evaluate(a, b);
+  }
+
+  std::string ToString() const { return "PointwiseEuclidean"; }
+};
+
+/**
+ * Make sure that the base cases between two leaves computed with a matrix
+ * multiplication are pruned point by point like the base cases evaluated one by
+ * one: both searches find the same neighbors with (nearly) the same number of
+ * base cases, and far fewer than the naive search.
+ */
+BOOST_AUTO_TEST_CASE(DualTreeBlockBaseCasesPruneTest)
+{
+  arma::mat dataset;
+  dataset.randu(8, 3000);
+
+  AllkNN block(dataset);
+  NeighborSearch<NearestNeighborSort, PointwiseEuclidean> pointwise(
+      dataset);
+
+  arma::Mat<size_t> blockNeighbors, pointwiseNeighbors;
+  arma::mat blockDistances, pointwiseDistances;
+  block.Search(5, blockNeighbors, blockDistances);
+  pointwise.Search(5, pointwiseNeighbors, pointwiseDistances);
+
+  for (size_t i = 0; i < blockNeighbors.n_elem; i++)
+  {
+    BOOST_REQUIRE_EQUAL(blockNeighbors[i], pointwiseNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(blockDistances[i], pointwiseDistances[i], 1e-5);
+  }
+
+  // Pruning decisions can only differ where rounding changes the order of two
+  // candidates, so the numbers of base cases are nearly the same.
+  BOOST_REQUIRE_GT(block.BaseCases(), 0);
+  BOOST_REQUIRE_CLOSE((double) block.BaseCases(),
+      (double) pointwise.BaseCases(), 1.0);
+  BOOST_REQUIRE_LT(block.BaseCases(), dataset.n_cols * (dataset.n_cols - 1));
+}
+
+/**
+ * Make sure that the traversal statistics of a dual-tree search are consistent:
+ * every Score() call is either a prune or a visit, and the prunes at each depth
+ * add up to the total.
+ */
+BOOST_AUTO_TEST_CASE(TraversalStatisticsTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 500);
+
+  AllkNN allknn(dataset);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(5, neighbors, distances);
+
+  const TraversalStatistics& statistics = allknn.Statistics();
+  BOOST_REQUIRE_EQUAL(statistics.BaseCases(), allknn.BaseCases());
+  BOOST_REQUIRE_GT(statistics.BaseCases(), 0);
+  BOOST_REQUIRE_GT(statistics.Scores(), 0);
+  BOOST_REQUIRE_EQUAL(statistics.Prunes() + statistics.NodeVisits(),
+      statistics.Scores());
+  BOOST_REQUIRE_LE(statistics.LeafPairs(), statistics.NodeVisits());
+
+  size_t prunes = 0;
+  for (size_t i = 0; i < statistics.PrunesByDepth().size(); ++i)
+    prunes += statistics.PrunesByDepth()[i];
+  BOOST_REQUIRE_EQUAL(prunes, statistics.Prunes());
+
+  BOOST_REQUIRE_EQUAL(statistics.PhaseTimes().count("tree_building"), 1);
+  BOOST_REQUIRE_EQUAL(statistics.PhaseTimes().count("traversal"), 1);
+  BOOST_REQUIRE_GE(statistics.PhaseTime("traversal"), 0.0);
+
+  // Adding the statistics to themselves should double the counts.
+  TraversalStatistics doubled(statistics);
+  doubled += statistics;
+  BOOST_REQUIRE_EQUAL(doubled.BaseCases(), 2 * statistics.BaseCases());
+  BOOST_REQUIRE_EQUAL(doubled.Scores(), 2 * statistics.Scores());
+  BOOST_REQUIRE_EQUAL(doubled.Prunes(), 2 * statistics.Prunes());
+
+  doubled.Reset();
+  BOOST_REQUIRE_EQUAL(doubled.BaseCases(), 0);
+  BOOST_REQUIRE_EQUAL(doubled.Scores(), 0);
+  BOOST_REQUIRE_EQUAL(doubled.Prunes(), 0);
+}
+
+/**
+ * Insert points into and remove points from the reference set of a dual-tree
+ * AllkNN object, and make sure the results still match a naive search on the
+ * equivalent dataset.
+ */
+BOOST_AUTO_TEST_CASE(DualTreeInsertRemoveVsNaive)
+{
+  arma::mat dataset;
+  dataset.randu(3, 1000);
+  arma::mat references(dataset);
+
+  AllkNN allknn(references);
+
+  for (size_t b = 0; b < 3; ++b)
+  {
+    arma::mat points;
+    points.randu(3, 300);
+    points *= 1.2;
+
+    allknn.Insert(points);
+    dataset.insert_cols(dataset.n_cols, points);
+  }
+
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < dataset.n_cols; i += 4)
+    indices.push_back(i);
+
+  allknn.Remove(indices);
+  for (size_t i = indices.size(); i > 0; --i)
+    dataset.shed_col(indices[i - 1]);
+
+  arma::mat naiveReferences(dataset);
+  AllkNN naive(naiveReferences, true);
+
+  arma::Mat<size_t> neighborsTree;
+  arma::mat distancesTree;
+  allknn.Search(5, neighborsTree, distancesTree);
+
+  arma::Mat<size_t> neighborsNaive;
+  arma::mat distancesNaive;
+  naive.Search(5, neighborsNaive, distancesNaive);
+
+  BOOST_REQUIRE_EQUAL(neighborsTree.n_cols, dataset.n_cols);
+  for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighborsTree[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesNaive[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that dual-tree and single-tree search with a kd-tree built on
+ * sparse data give the same results as naive search on the same data stored
+ * densely.
+ */
+BOOST_AUTO_TEST_CASE(SparseKDTreeVsNaive)
+{
+  arma::sp_mat dataset;
+  dataset.sprandu(40, 800, 0.1);
+  const arma::mat denseDataset(dataset);
+
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance,
+      BinarySpaceTree<HRectBound<2>, NeighborSearchStat<NearestNeighborSort>,
+      arma::sp_mat> > SparseAllkNN;
+
+  SparseAllkNN dual(dataset);
+  SparseAllkNN single(dataset, false, true);
+  AllkNN naive(denseDataset, true);
+
+  arma::Mat<size_t> neighborsDual, neighborsSingle, neighborsNaive;
+  arma::mat distancesDual, distancesSingle, distancesNaive;
+  dual.Search(5, neighborsDual, distancesDual);
+  single.Search(5, neighborsSingle, distancesSingle);
+  naive.Search(5, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighborsNaive.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighborsDual[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesDual[i], distancesNaive[i], 1e-5);
+    BOOST_REQUIRE_EQUAL(neighborsSingle[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesSingle[i], distancesNaive[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that the dual-tree nearest-neighbors method works on
+ * single-precision data, by comparing it with the naive method.
+ */
+BOOST_AUTO_TEST_CASE(FloatDualTreeVsNaive)
+{
+  arma::mat dataForTree;
+  if (!data::Load("test_data_3_1000.csv", dataForTree))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::fmat dualQuery = arma::conv_to<arma::fmat>::from(dataForTree);
+  arma::fmat naiveQuery(dualQuery);
+
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance,
+      BinarySpaceTree<HRectBound<2>, NeighborSearchStat<NearestNeighborSort>,
+      arma::fmat> > FloatAllkNN;
+  FloatAllkNN allknn(dualQuery);
+  FloatAllkNN naive(naiveQuery, true);
+
+  arma::Mat<size_t> resultingNeighborsTree;
+  arma::mat distancesTree;
+  allknn.Search(15, resultingNeighborsTree, distancesTree);
+
+  arma::Mat<size_t> resultingNeighborsNaive;
+  arma::mat distancesNaive;
+  naive.Search(15, resultingNeighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < resultingNeighborsTree.n_elem; i++)
+  {
+    BOOST_REQUIRE(resultingNeighborsTree[i] == resultingNeighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesNaive[i], 1e-5);
+  }
+}
+
+/**
+ * Run the best-first single-tree traverser on the given tree, with the given
+ * budget, and check the results: with no budget, they must be the same as the
+ * results of the naive search; otherwise they must be points whose distances
+ * are correct, and no better than the true nearest neighbors.
+ */
+template<typename TreeType>
+void CheckBestFirstTraversal(TreeType& tree,
+                             const size_t maxLeaves,
+                             const size_t maxBaseCases)
+{
+  const arma::mat& data = tree.Dataset();
+
+  AllkNN naive(data, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  arma::Mat<size_t> neighbors(5, data.n_cols);
+  neighbors.fill(size_t() - 1);
+  arma::mat distances(5, data.n_cols);
+  distances.fill(DBL_MAX);
+
+  typedef NeighborSearchRules<NearestNeighborSort, EuclideanDistance, TreeType>
+      RuleType;
+  EuclideanDistance metric;
+  RuleType rules(data, data, neighbors, distances, metric);
+
+  BestFirstSingleTreeTraverser<TreeType, RuleType> traverser(rules, maxLeaves,
+      maxBaseCases);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    traverser.Traverse(i, tree);
+
+  CandidateHeap<NearestNeighborSort>::Sort(neighbors, distances);
+
+  if (maxLeaves == 0 && maxBaseCases == 0)
+  {
+    BOOST_REQUIRE_EQUAL(traverser.NumStopped(), (size_t) 0);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+
+    return;
+  }
+
+  if (maxLeaves != 0)
+    BOOST_REQUIRE_LE(traverser.NumLeaves(), maxLeaves * data.n_cols);
+  if (maxBaseCases != 0 && !TreeTraits<TreeType>::FirstPointIsCentroid)
+    BOOST_REQUIRE_LE(traverser.NumBaseCases(), maxBaseCases * data.n_cols);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    // The best leaf always holds at least the nearest candidate found.
+    BOOST_REQUIRE_NE(neighbors(0, i), size_t() - 1);
+
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      if (neighbors(j, i) == size_t() - 1)
+        continue;
+
+      BOOST_REQUIRE_NE(neighbors(j, i), i);
+      BOOST_REQUIRE_CLOSE(distances(j, i), metric.Evaluate(data.col(i),
+          data.col(neighbors(j, i))), 1e-5);
+      BOOST_REQUIRE_GE(distances(j, i), naiveDistances(j, i) * (1 - 1e-5));
+    }
+  }
+}
+
+/**
+ * Make sure the best-first traverser finds the exact nearest neighbors when it
+ * has no budget, and respects its budget, with kd-trees, cover trees, and R
+ * trees.
+ */
+BOOST_AUTO_TEST_CASE(BestFirstSingleTreeTraverserTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 500);
+
+  typedef BinarySpaceTree<HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > KDTreeType;
+  arma::mat kdData(dataset);
+  KDTreeType kdTree(kdData);
+
+  CheckBestFirstTraversal(kdTree, 0, 0);
+  CheckBestFirstTraversal(kdTree, 1, 0);
+  CheckBestFirstTraversal(kdTree, 3, 0);
+  CheckBestFirstTraversal(kdTree, 0, 7);
+
+  typedef CoverTree<LMetric<2>, FirstPointIsRoot,
+      NeighborSearchStat<NearestNeighborSort> > CoverTreeType;
+  CoverTreeType coverTree(dataset);
+
+  CheckBestFirstTraversal(coverTree, 0, 0);
+  CheckBestFirstTraversal(coverTree, 5, 0);
+  CheckBestFirstTraversal(coverTree, 0, 20);
+
+  typedef RectangleTree<RTreeSplit<RTreeDescentHeuristic,
+      NeighborSearchStat<NearestNeighborSort>, arma::mat>,
+      RTreeDescentHeuristic, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> RTreeType;
+  RTreeType rTree(dataset, 20, 6, 5, 2, 0);
+
+  CheckBestFirstTraversal(rTree, 0, 0);
+  CheckBestFirstTraversal(rTree, 2, 0);
+  CheckBestFirstTraversal(rTree, 0, 10);
+}
+
+/**
+ * Run the serial and the level-by-level parallel breadth-first traversals of a
+ * kd-tree search with the given number of threads, and make sure both find
+ * the same neighbors as a naive search.
+ */
+BOOST_AUTO_TEST_CASE(BreadthFirstTraverseLevelsTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 1200);
+  arma::mat queryData;
+  queryData.randu(3, 800);
+
+  typedef BinarySpaceTree<HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > TreeType;
+  typedef NeighborSearchRules<NearestNeighborSort, EuclideanDistance, TreeType>
+      RuleType;
+
+  const size_t threads = util::NumThreads();
+  for (size_t parallel = 0; parallel < 2; ++parallel)
+  {
+    // The trees rearrange their datasets, so the naive search uses the same
+    // rearranged datasets.
+    arma::mat references(referenceData);
+    arma::mat queries(queryData);
+    TreeType referenceTree(references, 10);
+    TreeType queryTree(queries, 10);
+
+    AllkNN naive(references, queries, true);
+    arma::Mat<size_t> naiveNeighbors;
+    arma::mat naiveDistances;
+    naive.Search(5, naiveNeighbors, naiveDistances);
+
+    arma::Mat<size_t> neighbors(5, queries.n_cols);
+    neighbors.fill(size_t() - 1);
+    arma::mat distances(5, queries.n_cols);
+    distances.fill(DBL_MAX);
+
+    EuclideanDistance metric;
+    RuleType rules(references, queries, neighbors, distances, metric);
+    TreeType::BreadthFirstDualTreeTraverser<RuleType> traverser(rules);
+
+    if (parallel == 1)
+    {
+      util::SetNumThreads(4);
+      traverser.TraverseLevels(queryTree, referenceTree);
+      util::SetNumThreads(threads);
+    }
+    else
+    {
+      traverser.Traverse(queryTree, referenceTree);
+    }
+
+    CandidateHeap<NearestNeighborSort>::Sort(neighbors, distances);
+
+    BOOST_REQUIRE_GT(traverser.NumBaseCases(), 0);
+    BOOST_REQUIRE_LT(traverser.NumBaseCases(), references.n_cols *
+        queries.n_cols);
+    BOOST_REQUIRE_GT(rules.Statistics().Scores(), 0);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
 /**
  * Test the cover tree single-tree nearest-neighbors method against the naive
  * method.  This uses only a random reference dataset.
@@ -625,6 +1282,49 @@ BOOST_AUTO_TEST_CASE(SingleCoverTreeTest)
   }
 }
 
+/**
+ * Grow a cover tree by inserting points, and make sure searches with it give
+ * the same results as naive search.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeInsertSearchTest)
+{
+  arma::mat data;
+  data.randu(10, 300);
+
+  typedef CoverTree<LMetric<2>, FirstPointIsRoot,
+      NeighborSearchStat<NearestNeighborSort> > TreeType;
+  TreeType tree(data);
+
+  arma::mat newPoints;
+  newPoints.randu(10, 700);
+  data.insert_cols(300, newPoints);
+  for (size_t i = 300; i < 400; ++i)
+    tree.Insert(i);
+  tree.Insert(400, 600);
+
+  NeighborSearch<NearestNeighborSort, LMetric<2>, TreeType> singleSearch(&tree,
+      data, true);
+  NeighborSearch<NearestNeighborSort, LMetric<2>, TreeType> dualSearch(&tree,
+      data);
+
+  arma::mat naiveQuery(data);
+  AllkNN naive(naiveQuery, true);
+
+  arma::Mat<size_t> singleNeighbors, dualNeighbors, naiveNeighbors;
+  arma::mat singleDistances, dualDistances, naiveDistances;
+  singleSearch.Search(5, singleNeighbors, singleDistances);
+  dualSearch.Search(5, dualNeighbors, dualDistances);
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < naiveNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(singleNeighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(singleDistances[i], naiveDistances[i], 1e-5);
+    BOOST_REQUIRE_EQUAL(dualNeighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(dualDistances[i], naiveDistances[i], 1e-5);
+  }
+}
+
 /**
  * Test the cover tree dual-tree nearest neighbors method against the naive
  * method.
@@ -736,6 +1436,171 @@ BOOST_AUTO_TEST_CASE(DualBallTreeTest)
   }
 }
 
+/**
+ * Run dual-tree and single-tree search with the given tree type, which builds
+ * its own trees, and compare the results with the naive method.
+ */
+template<typename TreeType>
+void CheckTreeTypeVsNaive(const arma::mat& dataset)
+{
+  AllkNN naive(dataset, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  for (size_t singleMode = 0; singleMode < 2; ++singleMode)
+  {
+    NeighborSearch<NearestNeighborSort, EuclideanDistance, TreeType>
+        search(dataset, false, singleMode == 1);
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    search.Search(5, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that random projection trees and PCA trees give the right results.
+ */
+BOOST_AUTO_TEST_CASE(HyperplaneSplitTreesVsNaive)
+{
+  arma::mat dataset;
+  dataset.randu(20, 1000);
+
+  typedef BallBound<arma::vec, LMetric<2, true> > BoundType;
+  typedef NeighborSearchStat<NearestNeighborSort> StatType;
+
+  CheckTreeTypeVsNaive<BinarySpaceTree<BoundType, StatType, arma::mat,
+      RPTreeSplit<BoundType, arma::mat> > >(dataset);
+  CheckTreeTypeVsNaive<BinarySpaceTree<BoundType, StatType, arma::mat,
+      PCASplit<BoundType, arma::mat> > >(dataset);
+  CheckTreeTypeVsNaive<BinarySpaceTree<HRectBound<2>, StatType, arma::mat,
+      PCASplit<HRectBound<2>, arma::mat> > >(dataset);
+}
+
+/**
+ * Make sure that vantage point trees give the right results, with the
+ * Euclidean distance and with the Manhattan distance.
+ */
+BOOST_AUTO_TEST_CASE(VPTreeVsNaive)
+{
+  arma::mat dataset;
+  dataset.randu(20, 1000);
+
+  typedef NeighborSearchStat<NearestNeighborSort> StatType;
+  typedef HollowBallBound<arma::vec, EuclideanDistance> L2Bound;
+  CheckTreeTypeVsNaive<BinarySpaceTree<L2Bound, StatType, arma::mat,
+      VPTreeSplit<L2Bound, arma::mat> > >(dataset);
+
+  typedef HollowBallBound<arma::vec, ManhattanDistance> L1Bound;
+  typedef BinarySpaceTree<L1Bound, StatType, arma::mat,
+      VPTreeSplit<L1Bound, arma::mat> > L1VPTree;
+
+  NeighborSearch<NearestNeighborSort, ManhattanDistance, L1VPTree>
+      naive(dataset, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  for (size_t singleMode = 0; singleMode < 2; ++singleMode)
+  {
+    NeighborSearch<NearestNeighborSort, ManhattanDistance, L1VPTree>
+        search(dataset, false, singleMode == 1);
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    search.Search(5, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that AllkNN2D and AllkNN3D give the same results as AllkNN, in
+ * dual-tree and single-tree mode.
+ */
+BOOST_AUTO_TEST_CASE(FixedDimensionAllkNNTest)
+{
+  for (size_t dims = 2; dims <= 3; ++dims)
+  {
+    arma::mat dataset;
+    dataset.randu(dims, 2000);
+
+    AllkNN naive(dataset, true);
+    arma::Mat<size_t> naiveNeighbors;
+    arma::mat naiveDistances;
+    naive.Search(5, naiveNeighbors, naiveDistances);
+
+    for (size_t singleMode = 0; singleMode < 2; ++singleMode)
+    {
+      arma::Mat<size_t> neighbors;
+      arma::mat distances;
+      if (dims == 2)
+      {
+        AllkNN2D allknn(dataset, false, singleMode == 1);
+        allknn.Search(5, neighbors, distances);
+      }
+      else
+      {
+        AllkNN3D allknn(dataset, false, singleMode == 1);
+        allknn.Search(5, neighbors, distances);
+      }
+
+      for (size_t i = 0; i < neighbors.n_elem; ++i)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+        BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that MahalanobisSearch gives the same results as a naive search
+ * with the MahalanobisDistance, in dual-tree and single-tree mode.
+ */
+BOOST_AUTO_TEST_CASE(MahalanobisSearchTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 500);
+  arma::mat querySet;
+  querySet.randu(5, 100);
+
+  arma::mat factor;
+  factor.randn(5, 5);
+  MahalanobisDistance<true> metric(trans(factor) * factor +
+      arma::eye<arma::mat>(5, 5));
+
+  NeighborSearch<NearestNeighborSort, MahalanobisDistance<true> >
+      naive(dataset, querySet, true, false, metric);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  for (size_t singleMode = 0; singleMode < 2; ++singleMode)
+  {
+    MahalanobisSearch<> search(dataset, querySet, metric, false,
+        singleMode == 1);
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    search.Search(5, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
 // Make sure sparse nearest neighbors works with kd trees.
 BOOST_AUTO_TEST_CASE(SparseAllkNNKDTreeTest)
 {
@@ -816,4 +1681,380 @@ BOOST_AUTO_TEST_CASE(SparseAllkNNCoverTreeTest)
 }
 */
 
+/**
+ * A monochromatic dual-tree search with one thread traverses the tree against
+ * itself, visiting each pair of points once; make sure that it gives the same
+ * results as the usual traversal (used with several threads), for both nearest
+ * and furthest neighbors, with fewer base cases than a naive search.
+ */
+BOOST_AUTO_TEST_CASE(SymmetricDualTreeTest)
+{
+  arma::mat dataset;
+  dataset.randu(4, 1000);
+
+  for (size_t k = 1; k <= 10; k += 9)
+  {
+    AllkNN symmetric(dataset);
+    AllkNN parallel(dataset);
+    parallel.NumThreads() = 2;
+
+    arma::Mat<size_t> neighbors, parallelNeighbors;
+    arma::mat distances, parallelDistances;
+    symmetric.Search(k, neighbors, distances);
+    parallel.Search(k, parallelNeighbors, parallelDistances);
+
+    BOOST_REQUIRE_LT(symmetric.BaseCases(),
+        dataset.n_cols * (dataset.n_cols - 1) / 2);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], parallelNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], parallelDistances[i], 1e-5);
+    }
+
+    AllkFN symmetricFurthest(dataset);
+    AllkFN naiveFurthest(dataset, true);
+    symmetricFurthest.Search(k, neighbors, distances);
+    naiveFurthest.Search(k, parallelNeighbors, parallelDistances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], parallelNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], parallelDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that repeated searches of the same object, for more and then fewer
+ * neighbors, give the same results as naive searches, both when the results
+ * are kept and extended and when they are not.
+ */
+BOOST_AUTO_TEST_CASE(RepeatedSearchTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 1000);
+  arma::mat querySet;
+  querySet.randu(3, 300);
+
+  const size_t k[] = { 10, 20, 5, 25 };
+  for (size_t mode = 0; mode < 6; ++mode)
+  {
+    // Monochromatic then bichromatic, in dual-tree, single-tree, and naive
+    // mode.
+    const bool bichromatic = (mode >= 3);
+    const bool singleMode = (mode % 3 == 1);
+    const bool naiveMode = (mode % 3 == 2);
+    AllkNN* allknn = bichromatic ?
+        new AllkNN(dataset, querySet, naiveMode, singleMode) :
+        new AllkNN(dataset, naiveMode, singleMode);
+    AllkNN* naive = bichromatic ? new AllkNN(dataset, querySet, true) :
+        new AllkNN(dataset, true);
+
+    for (size_t reuse = 0; reuse < 2; ++reuse)
+    {
+      allknn->ReuseResults() = (reuse == 1);
+      for (size_t i = 0; i < 4; ++i)
+      {
+        arma::Mat<size_t> neighbors, naiveNeighbors;
+        arma::mat distances, naiveDistances;
+        const size_t baseCases = allknn->BaseCases();
+        allknn->Search(k[i], neighbors, distances);
+        naive->Search(k[i], naiveNeighbors, naiveDistances);
+
+        // Fewer neighbors than before are taken from the kept results.
+        if (reuse == 1 && i == 2)
+          BOOST_REQUIRE_EQUAL(allknn->BaseCases(), baseCases);
+
+        BOOST_REQUIRE_EQUAL(neighbors.n_rows, k[i]);
+        for (size_t j = 0; j < neighbors.n_elem; ++j)
+        {
+          BOOST_REQUIRE_EQUAL(neighbors[j], naiveNeighbors[j]);
+          BOOST_REQUIRE_CLOSE(distances[j], naiveDistances[j], 1e-5);
+        }
+      }
+    }
+
+    delete allknn;
+    delete naive;
+  }
+}
+
+/**
+ * Make sure that searching a new query set against the trees of an existing
+ * object gives the same results as a new object would, and leaves the results
+ * for the original query set unchanged.
+ */
+BOOST_AUTO_TEST_CASE(NewQuerySetSearchTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 1000);
+  arma::mat querySet;
+  querySet.randu(3, 300);
+
+  AllkNN naive(dataset, querySet, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(7, naiveNeighbors, naiveDistances);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    AllkNN allknn(dataset, (mode == 2), (mode == 1));
+    arma::Mat<size_t> monoNeighbors, neighbors;
+    arma::mat monoDistances, distances;
+    allknn.Search(3, monoNeighbors, monoDistances);
+    allknn.Search(querySet, 7, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_cols, querySet.n_cols);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+
+    arma::Mat<size_t> monoNeighbors2;
+    arma::mat monoDistances2;
+    allknn.Search(3, monoNeighbors2, monoDistances2);
+    for (size_t i = 0; i < monoNeighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(monoNeighbors[i], monoNeighbors2[i]);
+      BOOST_REQUIRE_CLOSE(monoDistances[i], monoDistances2[i], 1e-5);
+    }
+  }
+
+  // The same with a cover tree, which doesn't rearrange the query set.
+  typedef NeighborSearch<NearestNeighborSort, LMetric<2>, CoverTree<LMetric<2>,
+      FirstPointIsRoot, NeighborSearchStat<NearestNeighborSort> > >
+      CoverTreeAllkNN;
+  CoverTreeAllkNN coverTreeSearch(dataset);
+  CoverTreeAllkNN coverTreeNaive(dataset, querySet, true);
+  arma::Mat<size_t> neighbors, coverTreeNeighbors;
+  arma::mat distances, coverTreeDistances;
+  coverTreeSearch.Search(querySet, 7, neighbors, distances);
+  coverTreeNaive.Search(7, coverTreeNeighbors, coverTreeDistances);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], coverTreeNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], coverTreeDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Searches with k = 1 keep only the best candidate of each query point; make
+ * sure that they find the same neighbor as the first of two neighbors found
+ * with the usual candidate heaps, for nearest and furthest neighbors.
+ */
+BOOST_AUTO_TEST_CASE(SingleNeighborTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 800);
+  arma::mat querySet;
+  querySet.randu(3, 200);
+
+  AllkNN naive(dataset, true);
+  AllkNN naiveBichromatic(dataset, querySet, true);
+  AllkFN naiveFurthest(dataset, querySet, true);
+  arma::Mat<size_t> naiveNeighbors, naiveBichromaticNeighbors,
+      naiveFurthestNeighbors;
+  arma::mat naiveDistances, naiveBichromaticDistances, naiveFurthestDistances;
+  naive.Search(2, naiveNeighbors, naiveDistances);
+  naiveBichromatic.Search(2, naiveBichromaticNeighbors,
+      naiveBichromaticDistances);
+  naiveFurthest.Search(2, naiveFurthestNeighbors, naiveFurthestDistances);
+
+  for (size_t mode = 0; mode < 4; ++mode)
+  {
+    // Dual-tree, single-tree, naive, and parallel dual-tree search.
+    const bool singleMode = (mode == 1);
+    const bool naiveMode = (mode == 2);
+    AllkNN allknn(dataset, naiveMode, singleMode);
+    AllkNN bichromatic(dataset, querySet, naiveMode, singleMode);
+    AllkFN furthest(dataset, querySet, naiveMode, singleMode);
+    if (mode == 3)
+    {
+      allknn.NumThreads() = 2;
+      bichromatic.NumThreads() = 2;
+      furthest.NumThreads() = 2;
+    }
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allknn.Search(1, neighbors, distances);
+    BOOST_REQUIRE_EQUAL(neighbors.n_rows, 1);
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors(0, i));
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances(0, i), 1e-5);
+    }
+
+    bichromatic.Search(1, neighbors, distances);
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveBichromaticNeighbors(0, i));
+      BOOST_REQUIRE_CLOSE(distances[i], naiveBichromaticDistances(0, i), 1e-5);
+    }
+
+    furthest.Search(1, neighbors, distances);
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveFurthestNeighbors(0, i));
+      BOOST_REQUIRE_CLOSE(distances[i], naiveFurthestDistances(0, i), 1e-5);
+    }
+  }
+}
+
+#ifdef HAS_CUDA
+/**
+ * Make sure that the search on the GPU gives the same results as naive search,
+ * both with the datasets on the device at once and when they are copied to the
+ * device in small tiles.
+ */
+BOOST_AUTO_TEST_CASE(GPUVsNaiveTest)
+{
+  if (!gpu::DeviceAvailable())
+  {
+    BOOST_TEST_MESSAGE("No CUDA device found; skipping.");
+    return;
+  }
+
+  arma::mat queries = arma::randu<arma::mat>(3, 1000);
+  arma::mat references = arma::randu<arma::mat>(3, 1200);
+
+  AllkNN naive(references, queries, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(15, naiveNeighbors, naiveDistances);
+
+  AllkNN naiveMonochromatic(references, true);
+  arma::Mat<size_t> naiveMonoNeighbors;
+  arma::mat naiveMonoDistances;
+  naiveMonochromatic.Search(15, naiveMonoNeighbors, naiveMonoDistances);
+
+  // 0 uses the free memory of the device; 200 kB needs several tiles.
+  const size_t deviceMemory[] = { 0, 200000 };
+  for (size_t m = 0; m < 2; ++m)
+  {
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    gpu::KNearestNeighbors(queries, references, 15, neighbors, distances,
+        false, deviceMemory[m]);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-3);
+    }
+
+    gpu::KNearestNeighbors(references, references, 15, neighbors, distances,
+        true, deviceMemory[m]);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveMonoNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveMonoDistances[i], 1e-3);
+    }
+  }
+}
+#endif
+
+/**
+ * The intrinsic dimension of points on a plane in ten dimensions should be
+ * estimated as about two, and that of points filling the ten dimensions as much
+ * higher.
+ */
+BOOST_AUTO_TEST_CASE(SearchTunerIntrinsicDimensionTest)
+{
+  arma::mat basis(10, 2, arma::fill::randn);
+  arma::mat plane = basis * arma::randu<arma::mat>(2, 2000);
+
+  const double planeDimension = SearchTuner::EstimateIntrinsicDimension(plane);
+  BOOST_REQUIRE_GT(planeDimension, 1.5);
+  BOOST_REQUIRE_LT(planeDimension, 2.5);
+
+  arma::mat cube(10, 2000, arma::fill::randu);
+  const double cubeDimension = SearchTuner::EstimateIntrinsicDimension(cube);
+  BOOST_REQUIRE_GT(cubeDimension, 5.0);
+  BOOST_REQUIRE_LE(cubeDimension, 10.0);
+
+  // Duplicate points have no intrinsic dimension to speak of.
+  arma::mat same(3, 100, arma::fill::ones);
+  BOOST_REQUIRE_EQUAL(SearchTuner::EstimateIntrinsicDimension(same), 1.0);
+}
+
+/**
+ * A trial in which single-tree search with kd-trees of leaf size 40 is much
+ * faster than anything else.
+ */
+class FakeTrial
+{
+ public:
+  FakeTrial() : runs(0) { }
+
+  void Run(const SearchCandidate& candidate,
+           const arma::mat& referenceSet,
+           const arma::mat* querySet,
+           double& buildTime,
+           double& searchTime)
+  {
+    BOOST_REQUIRE_EQUAL(referenceSet.n_cols, 100);
+    BOOST_REQUIRE(querySet != NULL);
+    BOOST_REQUIRE_EQUAL(querySet->n_cols, 50);
+
+    buildTime = 0.01;
+    searchTime = (candidate.Type() == SearchCandidate::KD_TREE &&
+        candidate.LeafSize() == 40 && candidate.SingleMode()) ? 0.001 : 1.0;
+    ++runs;
+  }
+
+  size_t runs;
+};
+
+/**
+ * The tuner should try every candidate on samples of the right size, and pick
+ * the fastest one.
+ */
+BOOST_AUTO_TEST_CASE(SearchTunerSelectTest)
+{
+  arma::mat referenceSet(4, 1000, arma::fill::randu);
+  arma::mat querySet(4, 50, arma::fill::randu);
+
+  SearchTuner tuner(referenceSet, querySet, 100);
+  BOOST_REQUIRE(!tuner.Monochromatic());
+  BOOST_REQUIRE_EQUAL(tuner.ReferenceSample().n_rows, 4);
+  BOOST_REQUIRE_EQUAL(tuner.ReferenceSample().n_cols, 100);
+
+  // The query set is small enough to be used whole.
+  BOOST_REQUIRE_EQUAL(arma::accu(tuner.QuerySample() != querySet), 0);
+
+  // Each point of the reference sample is a point of the reference set.
+  for (size_t i = 0; i < tuner.ReferenceSample().n_cols; ++i)
+  {
+    bool found = false;
+    for (size_t j = 0; j < referenceSet.n_cols && !found; ++j)
+      found = (arma::accu(tuner.ReferenceSample().col(i) !=
+          referenceSet.col(j)) == 0);
+    BOOST_REQUIRE(found);
+  }
+
+  // R-trees are only tried if asked for.
+  const std::vector<SearchCandidate> candidates = tuner.Candidates(false);
+  for (size_t i = 0; i < candidates.size(); ++i)
+    BOOST_REQUIRE(candidates[i].Type() != SearchCandidate::R_TREE);
+  BOOST_REQUIRE_GT(tuner.Candidates(true).size(), candidates.size());
+
+  FakeTrial trial;
+  const size_t best = tuner.Select(trial, candidates);
+  BOOST_REQUIRE_EQUAL(trial.runs, candidates.size());
+  BOOST_REQUIRE_EQUAL(tuner.PredictedTimes().n_elem, candidates.size());
+  BOOST_REQUIRE_EQUAL(candidates[best].Type(), SearchCandidate::KD_TREE);
+  BOOST_REQUIRE_EQUAL(candidates[best].LeafSize(), 40);
+  BOOST_REQUIRE(candidates[best].SingleMode());
+
+  // Naive search grows faster with the reference set than any tree.
+  const double naiveTime = tuner.PredictTime(
+      SearchCandidate(SearchCandidate::NAIVE), 0.0, 1.0);
+  const double treeTime = tuner.PredictTime(
+      SearchCandidate(SearchCandidate::KD_TREE), 0.0, 1.0);
+  BOOST_REQUIRE_GT(naiveTime, treeTime);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
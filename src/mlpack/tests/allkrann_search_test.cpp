@@ -25,7 +25,9 @@ BOOST_AUTO_TEST_SUITE(AllkRANNTest);
 
 // Test AllkRANN in naive mode for exact results when the random seeds are set
 // the same.  This may not be the best test; if the implementation of RANN-RS
-// gets random numbers in a different way, then this test might fail.
+// gets random numbers in a different way, then this test might fail.  At the
+// moment, the search seeds its own random stream from the global generator,
+// and naive search draws one set of samples for all of the query points.
 BOOST_AUTO_TEST_CASE(NaiveSearchExact)
 {
   // First test on a small set.
@@ -53,24 +55,30 @@ BOOST_AUTO_TEST_CASE(NaiveSearchExact)
   size_t numSamples = (size_t) ceil(log(1.0 / (1.0 - successProb)) /
       log(1.0 / (1.0 - (rankApproximation / 100.0))));
 
-  arma::Mat<size_t> samples(qdata.n_cols, numSamples);
-  for (size_t j = 0; j < qdata.n_cols; j++)
-    for (size_t i = 0; i < numSamples; i++)
-      samples(j, i) = (size_t) math::RandInt(10);
+  boost::mt19937 generator((uint32_t) math::RandInt(
+      std::numeric_limits<int>::max()));
+  arma::Col<size_t> sampled(10);
+  sampled.zeros();
+  for (size_t i = 0; i < numSamples; i++)
+    sampled[(size_t) (((double) generator() / 4294967296.0) * 10.0)]++;
 
   arma::Col<size_t> rann(qdata.n_cols);
   arma::vec rannDistances(qdata.n_cols);
   rannDistances.fill(DBL_MAX);
 
+  // The distinct samples are used in order of their index.
   for (size_t j = 0; j < qdata.n_cols; j++)
   {
-    for (size_t i = 0; i < numSamples; i++)
+    for (size_t i = 0; i < 10; i++)
     {
+      if (sampled[i] == 0)
+        continue;
+
       double dist = dMetric.Evaluate(qdata.unsafe_col(j),
-                                     rdata.unsafe_col(samples(j, i)));
+                                     rdata.unsafe_col(i));
       if (dist < rannDistances[j])
       {
-        rann[j] = samples(j, i);
+        rann[j] = i;
         rannDistances[j] = dist;
       }
     }
@@ -328,6 +336,49 @@ BOOST_AUTO_TEST_CASE(SingleDatasetSearch)
   BOOST_REQUIRE_EQUAL(distances.n_cols, 2500);
 }
 
+// Naive and single-tree search draw their samples from streams that depend
+// only on the random seed, so the results must not change with the number of
+// threads.  Dual-tree search must still run with many threads.
+BOOST_AUTO_TEST_CASE(ThreadedSearchTest)
+{
+  arma::mat dataset(3, 2000);
+  dataset.randu();
+
+  arma::Mat<size_t> neighbors, threadedNeighbors;
+  arma::mat distances, threadedDistances;
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    RASearch<> allkrann(dataset, (mode == 0), (mode == 1));
+
+    allkrann.NumThreads() = 1;
+    math::RandomSeed(42);
+    allkrann.Search(3, neighbors, distances, 5.0);
+
+    allkrann.NumThreads() = 4;
+    math::RandomSeed(42);
+    allkrann.Search(3, threadedNeighbors, threadedDistances, 5.0);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], threadedNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], threadedDistances[i], 1e-5);
+    }
+  }
+
+  RASearch<> allkrann(dataset);
+  allkrann.NumThreads() = 4;
+  allkrann.Search(3, neighbors, distances, 5.0);
+
+  BOOST_REQUIRE_EQUAL(neighbors.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(neighbors.n_cols, 2000);
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    BOOST_REQUIRE_NE(neighbors(0, i), i);
+    BOOST_REQUIRE_LT(neighbors(0, i), 2000);
+  }
+}
+
 // Test single-tree rank-approximate search with cover trees.
 BOOST_AUTO_TEST_CASE(SingleCoverTreeTest)
 {
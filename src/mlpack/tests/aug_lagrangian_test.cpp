@@ -61,5 +61,88 @@ BOOST_AUTO_TEST_CASE(GockenbachFunctionTest)
   BOOST_REQUIRE_CLOSE(coords[2], 0.015099932, 1e-3);
 }
 
+/**
+ * EvaluateWithGradient() of the augmented Lagrangian function should give the
+ * same results as Evaluate() and Gradient().
+ */
+BOOST_AUTO_TEST_CASE(AugLagrangianFunctionEvaluateWithGradient)
+{
+  GockenbachFunction f;
+  arma::vec lambda("1.5 -2.0");
+  AugLagrangianFunction<GockenbachFunction> augFunction(f, lambda, 7.0);
+
+  arma::mat coords = arma::randu<arma::mat>(3, 1);
+  arma::mat gradient(3, 1), combinedGradient(3, 1);
+  augFunction.Gradient(coords, gradient);
+  const double objective = augFunction.EvaluateWithGradient(coords,
+      combinedGradient);
+
+  BOOST_REQUIRE_CLOSE(objective, augFunction.Evaluate(coords), 1e-5);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(combinedGradient[i], gradient[i], 1e-5);
+}
+
+/**
+ * Keeping the L-BFGS curvature pairs between outer iterations should give the
+ * same solution of the Gockenbach function.
+ */
+BOOST_AUTO_TEST_CASE(GockenbachFunctionKeepHistoryTest)
+{
+  GockenbachFunction f;
+  AugLagrangian<GockenbachFunction> aug(f);
+  aug.LBFGS().KeepHistory() = true;
+
+  arma::vec coords = f.GetInitialPoint();
+
+  if (!aug.Optimize(coords, 0))
+    BOOST_FAIL("Optimization reported failure.");
+
+  double finalValue = f.Evaluate(coords);
+
+  BOOST_REQUIRE_CLOSE(finalValue, 29.633926, 1e-5);
+  BOOST_REQUIRE_CLOSE(coords[0], 0.12288178, 1e-3);
+  BOOST_REQUIRE_CLOSE(coords[1], -1.10778185, 1e-5);
+  BOOST_REQUIRE_CLOSE(coords[2], 0.015099932, 1e-3);
+}
+
+/**
+ * Stop an optimization of the Gockenbach function after a checkpoint, then
+ * resume it from the checkpoint file with a new optimizer.
+ */
+BOOST_AUTO_TEST_CASE(GockenbachFunctionCheckpointTest)
+{
+  GockenbachFunction f;
+  AugLagrangian<GockenbachFunction> aug(f);
+  aug.LBFGS().KeepHistory() = true;
+  aug.CheckpointInterval() = 2;
+  aug.CheckpointFile() = "aug_lagrangian_checkpoint.bin";
+
+  // Three outer iterations; the checkpoint is written after the second.
+  arma::vec coords = f.GetInitialPoint();
+  aug.Optimize(coords, 4);
+  BOOST_REQUIRE_EQUAL(aug.Iteration(), 3);
+
+  util::SaveRestoreUtility sr;
+  BOOST_REQUIRE(sr.ReadFile("aug_lagrangian_checkpoint.bin"));
+  remove("aug_lagrangian_checkpoint.bin");
+
+  AugLagrangian<GockenbachFunction> resumed(f);
+  resumed.LBFGS().KeepHistory() = true;
+  resumed.Load(sr);
+  BOOST_REQUIRE_EQUAL(resumed.Iteration(), 2);
+  BOOST_REQUIRE_EQUAL(resumed.Lambda().n_elem, aug.Lambda().n_elem);
+
+  arma::vec resumedCoords;
+  if (!resumed.Resume(resumedCoords, 0))
+    BOOST_FAIL("Optimization reported failure.");
+
+  double finalValue = f.Evaluate(resumedCoords);
+
+  BOOST_REQUIRE_CLOSE(finalValue, 29.633926, 1e-5);
+  BOOST_REQUIRE_CLOSE(resumedCoords[0], 0.12288178, 1e-3);
+  BOOST_REQUIRE_CLOSE(resumedCoords[1], -1.10778185, 1e-5);
+  BOOST_REQUIRE_CLOSE(resumedCoords[2], 0.015099932, 1e-3);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
 
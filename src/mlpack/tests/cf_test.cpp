@@ -84,6 +84,226 @@ BOOST_AUTO_TEST_CASE(CFGetRecommendationsQueriedUserTest)
   BOOST_REQUIRE_EQUAL(recommendations.n_cols, numUsers);
 }
 
+/**
+ * Create a small (user, item, rating) dataset, in which each user rated about a
+ * third of the items.
+ */
+void SmallRatings(const size_t numUsers,
+                  const size_t numItems,
+                  arma::mat& dataset)
+{
+  std::vector<arma::vec> ratings;
+  for (size_t u = 0; u < numUsers; ++u)
+  {
+    for (size_t i = 0; i < numItems; ++i)
+    {
+      // The last user rates the last item, so that the sizes are right.
+      if ((u + 2 * i) % 3 != 0 && !(u == numUsers - 1 && i == numItems - 1))
+        continue;
+
+      arma::vec rating(3);
+      rating[0] = u;
+      rating[1] = i;
+      rating[2] = 1.0 + 4.0 * math::Random();
+      ratings.push_back(rating);
+    }
+  }
+
+  dataset.set_size(3, ratings.size());
+  for (size_t i = 0; i < ratings.size(); ++i)
+    dataset.col(i) = ratings[i];
+}
+
+/**
+ * Make sure that the recommendations, which are computed without forming the
+ * rating matrix, are the same as those found from the rating matrix by brute
+ * force.
+ */
+BOOST_AUTO_TEST_CASE(CFRecommendationsMatchRatingMatrixTest)
+{
+  const size_t numUsers = 30;
+  const size_t numItems = 40;
+  arma::mat dataset;
+  SmallRatings(numUsers, numItems, dataset);
+
+  CF<> c(dataset, amf::NMFALSFactorizer(), 4, 5);
+
+  const size_t numRecs = 5;
+  arma::Mat<size_t> recommendations;
+  c.GetRecommendations(numRecs, recommendations);
+
+  BOOST_REQUIRE_EQUAL(recommendations.n_rows, numRecs);
+  BOOST_REQUIRE_EQUAL(recommendations.n_cols, numUsers);
+
+  // Find the neighborhoods and the best items from the rating matrix.  As in
+  // GetRecommendations(), the users are both the query and reference set, so
+  // each user is in its own neighborhood.
+  const arma::mat rating = c.Rating();
+  neighbor::AllkNN a(rating, rating);
+  arma::Mat<size_t> neighborhood;
+  arma::mat distances;
+  a.Search(4, neighborhood, distances);
+
+  for (size_t u = 0; u < numUsers; ++u)
+  {
+    arma::vec averages = arma::zeros<arma::vec>(numItems);
+    for (size_t j = 0; j < neighborhood.n_rows; ++j)
+      averages += rating.col(neighborhood(j, u));
+    averages /= neighborhood.n_rows;
+
+    for (size_t r = 0; r < numRecs; ++r)
+    {
+      size_t best = numItems;
+      for (size_t i = 0; i < numItems; ++i)
+      {
+        if (c.CleanedData()(i, u) != 0.0)
+          continue;
+
+        bool taken = false;
+        for (size_t k = 0; k < r; ++k)
+          if (recommendations(k, u) == i)
+            taken = true;
+
+        if (!taken && (best == numItems || averages[i] > averages[best]))
+          best = i;
+      }
+
+      BOOST_REQUIRE_EQUAL(recommendations(r, u), best);
+    }
+  }
+}
+
+/**
+ * Make sure that the recommendations found with FastMKS are the un-rated items
+ * with the highest predicted ratings.
+ */
+BOOST_AUTO_TEST_CASE(CFFactorRecommendationsTest)
+{
+  const size_t numUsers = 30;
+  const size_t numItems = 40;
+  arma::mat dataset;
+  SmallRatings(numUsers, numItems, dataset);
+
+  CF<> c(dataset, amf::NMFALSFactorizer(), 4, 5);
+
+  const size_t numRecs = 5;
+  arma::Mat<size_t> recommendations;
+  c.GetFactorRecommendations(numRecs, recommendations);
+
+  BOOST_REQUIRE_EQUAL(recommendations.n_rows, numRecs);
+  BOOST_REQUIRE_EQUAL(recommendations.n_cols, numUsers);
+
+  const arma::mat rating = c.Rating();
+  for (size_t u = 0; u < numUsers; ++u)
+  {
+    // Find the best un-rated items by brute force.
+    std::vector<std::pair<double, size_t> > candidates;
+    for (size_t i = 0; i < numItems; ++i)
+      if (c.CleanedData()(i, u) == 0.0)
+        candidates.push_back(std::make_pair(rating(i, u), i));
+    std::sort(candidates.rbegin(), candidates.rend());
+
+    for (size_t r = 0; r < numRecs; ++r)
+      BOOST_REQUIRE_EQUAL(recommendations(r, u), candidates[r].second);
+  }
+
+  // Recommendations for a subset of users are the same.
+  arma::Col<size_t> users("3 17 29");
+  arma::Mat<size_t> userRecommendations;
+  c.GetFactorRecommendations(numRecs, userRecommendations, users);
+
+  BOOST_REQUIRE_EQUAL(userRecommendations.n_cols, 3);
+  for (size_t i = 0; i < users.n_elem; ++i)
+    for (size_t r = 0; r < numRecs; ++r)
+      BOOST_REQUIRE_EQUAL(userRecommendations(r, i),
+          recommendations(r, users[i]));
+}
+
+/**
+ * Make sure that folding in a user or item gives the regularized least-squares
+ * solution, and that added users and items are part of the model.
+ */
+BOOST_AUTO_TEST_CASE(CFFoldInTest)
+{
+  const size_t numUsers = 30;
+  const size_t numItems = 40;
+  arma::mat dataset;
+  SmallRatings(numUsers, numItems, dataset);
+
+  CF<> c(dataset, amf::NMFALSFactorizer(), 4, 5);
+  const double lambda = 0.1;
+
+  // Fold in the ratings of user 3 again; the new factors must be at least as
+  // good as the trained ones for the regularized objective.
+  arma::mat ratings(2, c.CleanedData().col(3).n_nonzero);
+  size_t n = 0;
+  for (arma::sp_mat::const_iterator it = c.CleanedData().begin_col(3);
+       it != c.CleanedData().end_col(3); ++it, ++n)
+  {
+    ratings(0, n) = it.row();
+    ratings(1, n) = *it;
+  }
+
+  arma::vec factors;
+  c.FoldInUser(ratings, factors, lambda);
+  BOOST_REQUIRE_EQUAL(factors.n_elem, c.H().n_rows);
+
+  const arma::vec trained = c.H().col(3);
+  double foldedObjective = lambda * arma::dot(factors, factors);
+  double trainedObjective = lambda * arma::dot(trained, trained);
+  for (size_t i = 0; i < ratings.n_cols; ++i)
+  {
+    const arma::rowvec item = c.W().row((size_t) ratings(0, i));
+    foldedObjective += std::pow(ratings(1, i) - arma::dot(item, factors), 2.0);
+    trainedObjective += std::pow(ratings(1, i) - arma::dot(item, trained),
+        2.0);
+  }
+  BOOST_REQUIRE_LE(foldedObjective, trainedObjective + 1e-8);
+
+  // The gradient of the regularized objective is zero at the solution.
+  arma::vec gradient = lambda * factors;
+  for (size_t i = 0; i < ratings.n_cols; ++i)
+  {
+    const arma::rowvec item = c.W().row((size_t) ratings(0, i));
+    gradient -= (ratings(1, i) - arma::dot(item, factors)) * arma::trans(item);
+  }
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(gradient[i], 1e-8);
+
+  // Add the ratings as a new user.
+  const size_t user = c.AddUser(ratings, lambda);
+  BOOST_REQUIRE_EQUAL(user, numUsers);
+  BOOST_REQUIRE_EQUAL(c.H().n_cols, numUsers + 1);
+  BOOST_REQUIRE_EQUAL(c.CleanedData().n_cols, numUsers + 1);
+  for (size_t i = 0; i < factors.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(c.H()(i, user), factors[i], 1e-5);
+  for (size_t i = 0; i < numItems; ++i)
+    BOOST_REQUIRE_EQUAL(c.CleanedData()(i, user), c.CleanedData()(i, 3));
+
+  // The new user is not recommended the items it rated.
+  arma::Col<size_t> users(1);
+  users[0] = user;
+  arma::Mat<size_t> recommendations;
+  c.GetFactorRecommendations(3, recommendations, users);
+  for (size_t r = 0; r < 3; ++r)
+    BOOST_REQUIRE_EQUAL(c.CleanedData()(recommendations(r, 0), user), 0.0);
+
+  // Add a new item, rated by a few users.
+  arma::mat itemRatings("0 5 12; 4.0 2.0 3.5");
+  arma::rowvec itemFactors;
+  c.FoldInItem(itemRatings, itemFactors, lambda);
+  BOOST_REQUIRE_EQUAL(itemFactors.n_elem, c.W().n_cols);
+
+  const size_t item = c.AddItem(itemRatings, lambda);
+  BOOST_REQUIRE_EQUAL(item, numItems);
+  BOOST_REQUIRE_EQUAL(c.W().n_rows, numItems + 1);
+  BOOST_REQUIRE_EQUAL(c.CleanedData().n_rows, numItems + 1);
+  BOOST_REQUIRE_EQUAL(c.CleanedData()(item, 5), 2.0);
+  BOOST_REQUIRE_EQUAL(c.CleanedData()(item, 1), 0.0);
+  BOOST_REQUIRE_EQUAL(c.CleanedData().n_nonzero, dataset.n_cols +
+      ratings.n_cols + 3);
+}
+
 /**
  * Make sure recommendations that are generated are reasonably accurate.
  */
@@ -5,7 +5,9 @@
  * Test for the CLI input parameter system.
  */
 
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #ifndef _WIN32
   #include <sys/time.h>
@@ -269,4 +271,171 @@ BOOST_AUTO_TEST_CASE(MultiRunTimerTest)
   BOOST_REQUIRE_GE(Timer::Get("test_timer").tv_usec, 40000);
 }
 
+/**
+ * The profiler should count nested scopes (from several threads) and estimate
+ * their durations, and write a trace holding every run.
+ */
+BOOST_AUTO_TEST_CASE(ProfilerTest)
+{
+  Profiler::Reset();
+  const size_t outer = Profiler::Register("profiler_test_outer");
+  const size_t inner = Profiler::Register("profiler_test_inner");
+  BOOST_REQUIRE_EQUAL(Profiler::Register("profiler_test_outer"), outer);
+  BOOST_REQUIRE_NE(inner, outer);
+
+  #pragma omp parallel for
+  for (size_t i = 0; i < 100; ++i)
+  {
+    ProfileScope outerScope(outer);
+    for (size_t j = 0; j < 3; ++j)
+    {
+      ProfileScope innerScope(inner);
+    }
+  }
+
+  {
+    ProfileScope sleepScope(outer);
+    #ifdef _WIN32
+    Sleep(10);
+    #else
+    usleep(10000);
+    #endif
+  }
+
+  const std::vector<Profiler::Statistics> summary = Profiler::Summary();
+  size_t outerCalls = 0, innerCalls = 0;
+  for (size_t i = 0; i < summary.size(); ++i)
+  {
+    if (summary[i].name == "profiler_test_outer")
+    {
+      outerCalls = summary[i].calls;
+      // The sleep alone takes 10ms.
+      BOOST_REQUIRE_GE(summary[i].total, 0.009);
+      BOOST_REQUIRE_LE(summary[i].p50, summary[i].p90);
+      BOOST_REQUIRE_LE(summary[i].p90, summary[i].p99);
+    }
+    else if (summary[i].name == "profiler_test_inner")
+    {
+      innerCalls = summary[i].calls;
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(outerCalls, 101);
+  BOOST_REQUIRE_EQUAL(innerCalls, 300);
+
+  // Each run should be in the trace.
+  BOOST_REQUIRE(Profiler::WriteTrace("profiler_test.json"));
+  std::ifstream trace("profiler_test.json");
+  std::string contents((std::istreambuf_iterator<char>(trace)),
+      std::istreambuf_iterator<char>());
+  trace.close();
+
+  BOOST_REQUIRE_EQUAL(contents.find("{\"traceEvents\":["), 0);
+  size_t events = 0;
+  for (size_t pos = contents.find("\"ph\":\"X\""); pos != std::string::npos;
+       pos = contents.find("\"ph\":\"X\"", pos + 1))
+    ++events;
+  BOOST_REQUIRE_EQUAL(events, 401);
+
+  remove("profiler_test.json");
+  Profiler::Reset();
+}
+
+//! Square each index of a block into an output vector.
+struct SquareBlock
+{
+  SquareBlock(arma::vec& output) : output(output) { }
+
+  void operator()(const size_t begin, const size_t end) const
+  {
+    for (size_t i = begin; i < end; ++i)
+      output[i] = (double) i * i;
+  }
+
+  arma::vec& output;
+};
+
+//! Add each index and its square to a sum.
+struct SumBlock
+{
+  void operator()(const size_t begin, const size_t end, arma::vec& sum) const
+  {
+    for (size_t i = begin; i < end; ++i)
+    {
+      sum[0] += (double) i;
+      sum[1] += (double) i * i;
+    }
+  }
+};
+
+//! Count the nodes of a complete binary tree of the given depth, recursively.
+struct CountNodes
+{
+  CountNodes(const size_t depth, size_t* count) : depth(depth), count(count)
+  { }
+
+  void operator()() const
+  {
+    size_t left = 0, right = 0;
+    if (depth > 0)
+    {
+      TaskGroup group;
+      group.Run(CountNodes(depth - 1, &left));
+      group.Run(CountNodes(depth - 1, &right));
+      group.Wait();
+    }
+
+    *count = left + right + 1;
+  }
+
+  size_t depth;
+  size_t* count;
+};
+
+/**
+ * Make sure ParallelFor() visits each index once, for sizes which are and are
+ * not multiples of the grain size.
+ */
+BOOST_AUTO_TEST_CASE(ParallelForTest)
+{
+  for (size_t grain = 1; grain <= 64; grain *= 4)
+  {
+    arma::vec output(1000);
+    output.fill(-1.0);
+    ParallelFor(3, 1000, grain, SquareBlock(output));
+
+    for (size_t i = 0; i < 3; ++i)
+      BOOST_REQUIRE_EQUAL(output[i], -1.0);
+    for (size_t i = 3; i < 1000; ++i)
+      BOOST_REQUIRE_EQUAL(output[i], (double) i * i);
+  }
+}
+
+/**
+ * Make sure ParallelReduce() gives the same sums as a serial loop.
+ */
+BOOST_AUTO_TEST_CASE(ParallelReduceTest)
+{
+  const arma::vec zero = arma::zeros<arma::vec>(2);
+  const arma::vec sum = ParallelReduce(0, 10001, 100, zero, SumBlock());
+  BOOST_REQUIRE_CLOSE(sum[0], 10000.0 * 10001.0 / 2.0, 1e-10);
+  BOOST_REQUIRE_CLOSE(sum[1], 10000.0 * 10001.0 * 20001.0 / 6.0, 1e-10);
+
+  // An empty range gives the identity.
+  const arma::vec empty = ParallelReduce(5, 5, 100, zero, SumBlock());
+  BOOST_REQUIRE_EQUAL(empty[0], 0.0);
+  BOOST_REQUIRE_EQUAL(empty[1], 0.0);
+}
+
+/**
+ * Make sure the tasks of a recursion with TaskGroup all finish before
+ * RunTasks() returns.
+ */
+BOOST_AUTO_TEST_CASE(TaskGroupTest)
+{
+  size_t count = 0;
+  RunTasks(CountNodes(10, &count));
+  BOOST_REQUIRE_EQUAL(count, 2047);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -117,6 +117,55 @@ BOOST_AUTO_TEST_CASE(CosineNodeCosineSplit)
   }
 }
 
+/**
+ * Checks that the columns of each split node are the columns of its left child
+ * followed by those of its right child, and that the split point is one of the
+ * columns of the node.
+ */
+BOOST_AUTO_TEST_CASE(CosineNodeIndexRanges)
+{
+  arma::mat data = arma::randu(20, 300);
+  CosineTree root(data);
+
+  std::vector<size_t> rootIndices = root.VectorIndices();
+  std::sort(rootIndices.begin(), rootIndices.end());
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(rootIndices[i], i);
+
+  std::vector<CosineTree*> nodeStack;
+  nodeStack.push_back(&root);
+  while (nodeStack.size())
+  {
+    CosineTree* currentNode = nodeStack.back();
+    nodeStack.pop_back();
+
+    const std::vector<size_t> before = currentNode->VectorIndices();
+    BOOST_REQUIRE(std::find(before.begin(), before.end(),
+        currentNode->SplitPointIndex()) != before.end());
+
+    currentNode->CosineNodeSplit();
+    if (!currentNode->Left() || !currentNode->Right())
+      continue;
+
+    // The split only reorders the columns of the node.
+    const std::vector<size_t> after = currentNode->VectorIndices();
+    std::vector<size_t> children = currentNode->Left()->VectorIndices();
+    const std::vector<size_t> right = currentNode->Right()->VectorIndices();
+    children.insert(children.end(), right.begin(), right.end());
+    BOOST_REQUIRE(after == children);
+
+    std::vector<size_t> sortedBefore(before), sortedAfter(after);
+    std::sort(sortedBefore.begin(), sortedBefore.end());
+    std::sort(sortedAfter.begin(), sortedAfter.end());
+    BOOST_REQUIRE(sortedBefore == sortedAfter);
+
+    if (currentNode->Left()->NumColumns() > 0)
+      nodeStack.push_back(currentNode->Left());
+    if (currentNode->Right()->NumColumns() > 0)
+      nodeStack.push_back(currentNode->Right());
+  }
+}
+
 /**
  * Checks CosineTree::ModifiedGramSchmidt() by creating a random basis for the
  * vector subspace and checking if all the vectors are orthogonal to each other.
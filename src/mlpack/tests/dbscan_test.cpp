@@ -0,0 +1,123 @@
+/**
+ * @file dbscan_test.cpp
+ *
+ * Tests for DBSCAN.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/dbscan/dbscan.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::dbscan;
+
+BOOST_AUTO_TEST_SUITE(DBSCANTest);
+
+/**
+ * Two dense, well-separated groups of points and one far away point should
+ * give two clusters and one noise point, with both naive and tree-based
+ * clustering.
+ */
+BOOST_AUTO_TEST_CASE(SimpleClusterTest)
+{
+  arma::mat data(2, 41);
+  for (size_t i = 0; i < 20; ++i)
+  {
+    data(0, i) = 0.05 * (i % 5);
+    data(1, i) = 0.05 * (i / 5);
+    data(0, i + 20) = 10.0 + 0.05 * (i % 5);
+    data(1, i + 20) = 10.0 + 0.05 * (i / 5);
+  }
+  data(0, 40) = 5.0;
+  data(1, 40) = 5.0;
+
+  for (size_t naive = 0; naive < 2; ++naive)
+  {
+    DBSCAN<> dbscan(0.1, 3, (naive == 1), 4);
+
+    arma::Col<size_t> assignments;
+    std::vector<bool> corePoints;
+    const size_t clusters = dbscan.Cluster(data, assignments, corePoints);
+
+    BOOST_REQUIRE_EQUAL(clusters, 2);
+    BOOST_REQUIRE_EQUAL(assignments.n_elem, 41);
+    for (size_t i = 0; i < 20; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(assignments[i], 0);
+      BOOST_REQUIRE_EQUAL(assignments[i + 20], 1);
+      BOOST_REQUIRE_EQUAL(corePoints[i], true);
+      BOOST_REQUIRE_EQUAL(corePoints[i + 20], true);
+    }
+
+    // The far away point is noise.
+    BOOST_REQUIRE_EQUAL(assignments[40], 2);
+    BOOST_REQUIRE_EQUAL(corePoints[40], false);
+  }
+}
+
+/**
+ * Compare the tree-based clustering with the naive clustering on random data.
+ * The core points and their clusters must be the same; a border point may be
+ * attached to any cluster with a core point within epsilon of it, so for
+ * border points we only check that such a core point exists.
+ */
+BOOST_AUTO_TEST_CASE(NaiveVsTreeTest)
+{
+  arma::mat data;
+  data.randu(2, 1000);
+
+  const double epsilon = 0.04;
+  DBSCAN<> naive(epsilon, 6, true);
+  DBSCAN<> dbscan(epsilon, 6, false, 10);
+
+  arma::Col<size_t> naiveAssignments, assignments;
+  std::vector<bool> naiveCorePoints, corePoints;
+  const size_t naiveClusters = naive.Cluster(data, naiveAssignments,
+      naiveCorePoints);
+  const size_t clusters = dbscan.Cluster(data, assignments, corePoints);
+
+  BOOST_REQUIRE_EQUAL(clusters, naiveClusters);
+
+  // Clusters are numbered by their lowest point, which is not necessarily a
+  // core point, so match the cluster numbers through the core points.
+  arma::Col<size_t> matching(clusters + 1);
+  matching.fill(clusters + 1);
+  matching[clusters] = naiveClusters; // Noise.
+  metric::EuclideanDistance metric;
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(corePoints[i], naiveCorePoints[i]);
+    if (corePoints[i])
+    {
+      if (matching[assignments[i]] == clusters + 1)
+        matching[assignments[i]] = naiveAssignments[i];
+      BOOST_REQUIRE_EQUAL(matching[assignments[i]], naiveAssignments[i]);
+    }
+  }
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    if (corePoints[i])
+      continue;
+
+    // Noise points must be noise in both.
+    BOOST_REQUIRE_EQUAL((assignments[i] == clusters),
+        (naiveAssignments[i] == naiveClusters));
+    if (assignments[i] == clusters)
+      continue;
+
+    bool found = false;
+    for (size_t j = 0; j < data.n_cols; ++j)
+    {
+      if (corePoints[j] && (assignments[j] == assignments[i]) &&
+          (metric.Evaluate(data.col(i), data.col(j)) <= epsilon))
+      {
+        found = true;
+        break;
+      }
+    }
+    BOOST_REQUIRE(found);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
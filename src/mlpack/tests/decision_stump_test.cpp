@@ -307,4 +307,88 @@ BOOST_AUTO_TEST_CASE(DimensionSelectionTest)
   }
 }
 
+/**
+ * This tests the quantized mode on non-overlapping classes: every value gets
+ * its own bin, so the ranges must start halfway between the classes.
+ */
+BOOST_AUTO_TEST_CASE(QuantizedPerfectMultiClassSplit)
+{
+  const size_t numClasses = 4;
+  const size_t inpBucketSize = 3;
+
+  mat trainingData;
+  trainingData << -8 << -7 << -6 << -5 << -4 << -3 << -2 << -1
+               << 0  << 1  << 2  << 3  << 4  << 5  << 6  << 7;
+
+  Mat<size_t> labelsIn;
+  labelsIn << 0 << 0 << 0 << 0 << 1 << 1 << 1 << 1
+           << 2 << 2 << 2 << 2 << 3 << 3 << 3 << 3;
+
+  mat testingData;
+  testingData << -6.1 << -2.1 << 1.1 << 5.1;
+
+  DecisionStump<> ds(trainingData, labelsIn.row(0), numClasses, inpBucketSize,
+      256);
+
+  BOOST_REQUIRE_EQUAL(ds.Binned().NumBins(0), 16);
+  BOOST_REQUIRE_EQUAL(ds.Split().n_elem, 4);
+  BOOST_REQUIRE_CLOSE(ds.Split()[0], -8.0, 1e-10);
+  BOOST_REQUIRE_CLOSE(ds.Split()[1], -4.5, 1e-10);
+  BOOST_REQUIRE_CLOSE(ds.Split()[2], -0.5, 1e-10);
+  BOOST_REQUIRE_CLOSE(ds.Split()[3], 3.5, 1e-10);
+
+  Row<size_t> predictedLabels(testingData.n_cols);
+  ds.Classify(testingData, predictedLabels);
+
+  BOOST_CHECK_EQUAL(predictedLabels(0, 0), 0);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 1), 1);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 2), 2);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 3), 3);
+}
+
+/**
+ * This tests that the quantized mode chooses the most separable dimension, and
+ * that a weighted stump built from a quantized one uses its bins; with equal
+ * weights, it must find the same split.
+ */
+BOOST_AUTO_TEST_CASE(QuantizedDimensionSelectionTest)
+{
+  const size_t numClasses = 2;
+  const size_t inpBucketSize = 2500;
+
+  // The dimensions have progressing levels of separation; dimension 1 is the
+  // most separable and dimension 2 is not separable at all.
+  arma::mat dataset(4, 5000);
+  dataset.randn();
+  const double offsets[] = { 1.0, 5.0, 0.0, 3.0 };
+  arma::Row<size_t> labels(5000);
+  for (size_t i = 0; i < 5000; ++i)
+  {
+    labels[i] = (i < 2500) ? 0 : 1;
+    for (size_t d = 0; d < 4; ++d)
+      dataset(d, i) += (i < 2500) ? -offsets[d] : offsets[d];
+  }
+
+  DecisionStump<> ds(dataset, labels, numClasses, inpBucketSize, 64);
+  BOOST_CHECK_EQUAL(ds.SplitAttribute(), 1);
+  BOOST_REQUIRE_EQUAL(ds.MaxBins(), 64);
+  BOOST_REQUIRE_EQUAL(ds.Binned().NumPoints(), 5000);
+  for (size_t d = 0; d < 4; ++d)
+    BOOST_REQUIRE_LE(ds.Binned().NumBins(d), 64);
+
+  arma::rowvec weights(5000);
+  weights.fill(1.0 / 5000);
+  DecisionStump<> weighted(ds, dataset, weights, labels);
+
+  BOOST_REQUIRE_EQUAL(weighted.MaxBins(), 64);
+  BOOST_REQUIRE_EQUAL(weighted.Binned().NumPoints(), 0);
+  BOOST_REQUIRE_EQUAL(weighted.SplitAttribute(), ds.SplitAttribute());
+  BOOST_REQUIRE_EQUAL(weighted.Split().n_elem, ds.Split().n_elem);
+  for (size_t i = 0; i < ds.Split().n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(weighted.Split()[i], ds.Split()[i]);
+    BOOST_REQUIRE_EQUAL(weighted.BinLabels()[i], ds.BinLabels()[i]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
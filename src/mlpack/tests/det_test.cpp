@@ -6,6 +6,7 @@
  * using this class.
  */
 #include <mlpack/core.hpp>
+#include <stack>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -24,6 +25,8 @@
   #undef private
 #endif
 
+#include <mlpack/methods/det/flat_dtree.hpp>
+
 using namespace mlpack;
 using namespace mlpack::det;
 using namespace std;
@@ -310,6 +313,259 @@ BOOST_AUTO_TEST_CASE(TestVariableImportance)
   BOOST_REQUIRE_CLOSE((double) (rootError - (lError + rError)), imps[2], 1e-10);
 }
 
+// Grow a tree large enough for its subtrees to be grown in parallel, and make
+// sure that the points are still consistently reordered and that the leaves
+// partition the points.
+BOOST_AUTO_TEST_CASE(TestLargeGrow)
+{
+  arma::mat data(3, 30000);
+  data.randu();
+  arma::mat testData(data);
+
+  arma::Col<size_t> oTest(data.n_cols);
+  for (size_t i = 0; i < oTest.n_elem; ++i)
+    oTest[i] = i;
+
+  DTree testDTree(testData);
+  testDTree.Grow(testData, oTest, false, 10, 5);
+
+  // The mapping must be a permutation that matches the reordered points.
+  std::vector<bool> seen(data.n_cols, false);
+  for (size_t i = 0; i < oTest.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LT(oTest[i], data.n_cols);
+    BOOST_REQUIRE_EQUAL(seen[oTest[i]], false);
+    seen[oTest[i]] = true;
+
+    for (size_t d = 0; d < data.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(testData(d, i), data(d, oTest[i]));
+  }
+
+  // The children of each node must split its points in two.
+  std::stack<const DTree*> nodes;
+  nodes.push(&testDTree);
+  size_t leafPoints = 0;
+  while (!nodes.empty())
+  {
+    const DTree* node = nodes.top();
+    nodes.pop();
+
+    if (node->SubtreeLeaves() == 1)
+    {
+      BOOST_REQUIRE_GE(node->End() - node->Start(), 5);
+      leafPoints += node->End() - node->Start();
+      continue;
+    }
+
+    BOOST_REQUIRE_EQUAL(node->Left()->Start(), node->Start());
+    BOOST_REQUIRE_EQUAL(node->Left()->End(), node->Right()->Start());
+    BOOST_REQUIRE_EQUAL(node->Right()->End(), node->End());
+    nodes.push(node->Left());
+    nodes.push(node->Right());
+  }
+
+  BOOST_REQUIRE_EQUAL(leafPoints, data.n_cols);
+}
+
+// Presorting the dimensions must give exactly the same tree.
+BOOST_AUTO_TEST_CASE(TestPresortedGrow)
+{
+  arma::mat data(4, 2000);
+  data.randu();
+  // Make sure there are duplicate values in some dimension.
+  data.row(3) = arma::floor(10.0 * data.row(3));
+
+  arma::mat testData(data);
+  arma::mat presortedData(data);
+
+  arma::Col<size_t> oTest(data.n_cols), presortedOTest(data.n_cols);
+  for (size_t i = 0; i < oTest.n_elem; ++i)
+  {
+    oTest[i] = i;
+    presortedOTest[i] = i;
+  }
+
+  DTree testDTree(testData);
+  DTree presortedDTree(presortedData);
+  const double alpha = testDTree.Grow(testData, oTest, false, 10, 5);
+  const double presortedAlpha = presortedDTree.Grow(presortedData,
+      presortedOTest, false, 10, 5, true);
+
+  BOOST_REQUIRE_EQUAL(alpha, presortedAlpha);
+  for (size_t i = 0; i < oTest.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(oTest[i], presortedOTest[i]);
+
+  std::stack<std::pair<const DTree*, const DTree*> > nodes;
+  nodes.push(std::make_pair(&testDTree, &presortedDTree));
+  while (!nodes.empty())
+  {
+    const DTree* node = nodes.top().first;
+    const DTree* presortedNode = nodes.top().second;
+    nodes.pop();
+
+    BOOST_REQUIRE_EQUAL(node->Start(), presortedNode->Start());
+    BOOST_REQUIRE_EQUAL(node->End(), presortedNode->End());
+    BOOST_REQUIRE_EQUAL(node->SubtreeLeaves(), presortedNode->SubtreeLeaves());
+    if (node->SubtreeLeaves() == 1)
+      continue;
+
+    BOOST_REQUIRE_EQUAL(node->SplitDim(), presortedNode->SplitDim());
+    BOOST_REQUIRE_EQUAL(node->SplitValue(), presortedNode->SplitValue());
+    nodes.push(std::make_pair(node->Left(), presortedNode->Left()));
+    nodes.push(std::make_pair(node->Right(), presortedNode->Right()));
+  }
+}
+
+// When every value of the node has its own bin, the binned split search must
+// find the same split as the exact one.  This uses private functions too.
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(TestFindBinnedSplit)
+{
+  arma::mat testData(3,5);
+
+  testData << 4 << 5 << 7 << 3 << 5 << arma::endr
+           << 5 << 0 << 1 << 7 << 1 << arma::endr
+           << 5 << 6 << 7 << 1 << 8 << arma::endr;
+
+  DTree testDTree(testData);
+  testDTree.logVolume = log(7.0) + log(4.0) + log(7.0);
+
+  arma::Col<size_t> oldFromNew(testData.n_cols);
+  DTree::BinnedDimensions binned;
+  binned.bins.Bin(testData);
+  binned.rows.resize(testData.n_cols);
+  for (size_t i = 0; i < oldFromNew.n_elem; ++i)
+  {
+    oldFromNew[i] = i;
+    binned.rows[i] = i;
+  }
+
+  size_t dim, binnedDim;
+  double split, leftError, rightError, binnedSplit, binnedLeftError,
+      binnedRightError;
+  BOOST_REQUIRE(testDTree.FindSplit(testData, dim, split, leftError,
+      rightError, 1));
+  BOOST_REQUIRE(testDTree.FindBinnedSplit(testData, oldFromNew, binned,
+      binnedDim, binnedSplit, binnedLeftError, binnedRightError, 1));
+
+  BOOST_REQUIRE_EQUAL(binnedDim, dim);
+  BOOST_REQUIRE_CLOSE(binnedSplit, split, 1e-10);
+  BOOST_REQUIRE_CLOSE(binnedLeftError, leftError, 1e-10);
+  BOOST_REQUIRE_CLOSE(binnedRightError, rightError, 1e-10);
+}
+#endif
+
+// A tree grown on binned dimensions must be a valid tree whose splits are all
+// cut points between bins.
+BOOST_AUTO_TEST_CASE(TestBinnedGrow)
+{
+  arma::mat data(3, 5000);
+  data.randu();
+  arma::mat testData(data);
+
+  arma::Col<size_t> oTest(data.n_cols);
+  for (size_t i = 0; i < oTest.n_elem; ++i)
+    oTest[i] = i;
+
+  DTree testDTree(testData);
+  testDTree.Grow(testData, oTest, false, 10, 5, false, 32);
+
+  std::vector<bool> seen(data.n_cols, false);
+  for (size_t i = 0; i < oTest.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LT(oTest[i], data.n_cols);
+    BOOST_REQUIRE_EQUAL(seen[oTest[i]], false);
+    seen[oTest[i]] = true;
+
+    for (size_t d = 0; d < data.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(testData(d, i), data(d, oTest[i]));
+  }
+
+  const data::BinnedMatrix bins(data, 32);
+  std::stack<const DTree*> nodes;
+  nodes.push(&testDTree);
+  size_t leafPoints = 0;
+  while (!nodes.empty())
+  {
+    const DTree* node = nodes.top();
+    nodes.pop();
+
+    if (node->SubtreeLeaves() == 1)
+    {
+      BOOST_REQUIRE_GE(node->End() - node->Start(), 5);
+      leafPoints += node->End() - node->Start();
+      continue;
+    }
+
+    const arma::vec& cuts = bins.Cuts(node->SplitDim());
+    BOOST_REQUIRE(std::find(cuts.begin(), cuts.end(), node->SplitValue()) !=
+        cuts.end());
+
+    for (size_t i = node->Start(); i < node->End(); ++i)
+    {
+      const bool left = (i < node->Left()->End());
+      BOOST_REQUIRE_EQUAL(testData(node->SplitDim(), i) <= node->SplitValue(),
+          left);
+    }
+
+    nodes.push(node->Left());
+    nodes.push(node->Right());
+  }
+
+  BOOST_REQUIRE_EQUAL(leafPoints, data.n_cols);
+}
+
+// The flattened tree must give the same density estimates and leaf tags as the
+// tree it was built from, before and after being saved and loaded.
+BOOST_AUTO_TEST_CASE(TestFlatDTree)
+{
+  arma::mat data(3, 1000);
+  data.randu();
+  arma::mat testData(data);
+
+  arma::Col<size_t> oTest(data.n_cols);
+  for (size_t i = 0; i < oTest.n_elem; ++i)
+    oTest[i] = i;
+
+  DTree testDTree(testData);
+  testDTree.Grow(testData, oTest, false, 10, 5);
+  const int numLeaves = testDTree.TagTree();
+
+  // Some of the queries are outside of the bounding box of the tree.
+  arma::mat queries(3, 500);
+  queries.randu();
+  queries.cols(0, 99) *= 1.5;
+  queries = arma::join_rows(queries, data);
+
+  FlatDTree flatTree(testDTree);
+  BOOST_REQUIRE_EQUAL(flatTree.NumLeaves(), (size_t) numLeaves);
+  BOOST_REQUIRE_EQUAL(flatTree.NumNodes(), (size_t) (2 * numLeaves - 1));
+  BOOST_REQUIRE(flatTree.Save("test_flat_dtree.bin"));
+  FlatDTree loadedTree("test_flat_dtree.bin");
+  remove("test_flat_dtree.bin");
+
+  arma::vec values, loadedValues;
+  arma::Col<size_t> buckets, loadedBuckets;
+  flatTree.ComputeValues(queries, values);
+  flatTree.FindBuckets(queries, buckets);
+  loadedTree.ComputeValues(queries, loadedValues);
+  loadedTree.FindBuckets(queries, loadedBuckets);
+
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    const arma::vec query = queries.col(i);
+    const double value = testDTree.ComputeValue(query);
+    const size_t bucket = (size_t) testDTree.FindBucket(query);
+
+    BOOST_REQUIRE_EQUAL(flatTree.ComputeValue(query), value);
+    BOOST_REQUIRE_EQUAL(values[i], value);
+    BOOST_REQUIRE_EQUAL(loadedValues[i], value);
+    BOOST_REQUIRE_EQUAL(flatTree.FindBucket(query), bucket);
+    BOOST_REQUIRE_EQUAL(buckets[i], bucket);
+    BOOST_REQUIRE_EQUAL(loadedBuckets[i], bucket);
+  }
+}
+
 /**
  * These are not yet implemented.
  *
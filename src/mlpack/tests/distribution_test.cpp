@@ -5,6 +5,7 @@
  * Test for the mlpack::distribution::DiscreteDistribution class.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/core/dists/regression_distribution.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -187,16 +188,16 @@ BOOST_AUTO_TEST_CASE(GaussianUnivariateProbabilityTest)
       1e-5);
 
   // A few more cases...
-  g.Covariance().fill(2.0);
+  g.Covariance(arma::mat("2.0"));
   BOOST_REQUIRE_CLOSE(g.Probability(arma::vec("0.0")), 0.282094791773878, 1e-5);
   BOOST_REQUIRE_CLOSE(g.Probability(arma::vec("1.0")), 0.219695644733861, 1e-5);
   BOOST_REQUIRE_CLOSE(g.Probability(arma::vec("-1.0")), 0.219695644733861,
       1e-5);
 
   g.Mean().fill(1.0);
-  g.Covariance().fill(1.0);
+  g.Covariance(arma::mat("1.0"));
   BOOST_REQUIRE_CLOSE(g.Probability(arma::vec("1.0")), 0.398942280401433, 1e-5);
-  g.Covariance().fill(2.0);
+  g.Covariance(arma::mat("2.0"));
   BOOST_REQUIRE_CLOSE(g.Probability(arma::vec("-1.0")), 0.103776874355149,
       1e-5);
 }
@@ -215,7 +216,7 @@ BOOST_AUTO_TEST_CASE(GaussianMultivariateProbabilityTest)
 
   BOOST_REQUIRE_CLOSE(g.Probability(x), 0.159154943091895, 1e-5);
 
-  g.Covariance() = "2 0; 0 2";
+  g.Covariance(arma::mat("2 0; 0 2"));
 
   BOOST_REQUIRE_CLOSE(g.Probability(x), 0.0795774715459477, 1e-5);
 
@@ -230,33 +231,33 @@ BOOST_AUTO_TEST_CASE(GaussianMultivariateProbabilityTest)
   BOOST_REQUIRE_CLOSE(g.Probability(-x), 0.0795774715459477, 1e-5);
 
   g.Mean() = "1 1";
-  g.Covariance() = "2 1.5; 1 4";
+  g.Covariance(arma::mat("2 1.5; 1.5 4"));
 
-  BOOST_REQUIRE_CLOSE(g.Probability(x), 0.0624257046546403, 1e-5);
+  BOOST_REQUIRE_CLOSE(g.Probability(x), 0.0663721994061873, 1e-5);
   g.Mean() *= -1;
-  BOOST_REQUIRE_CLOSE(g.Probability(-x), 0.0624257046546403, 1e-5);
+  BOOST_REQUIRE_CLOSE(g.Probability(-x), 0.0663721994061873, 1e-5);
 
   g.Mean() = "1 1";
   x = "-1 4";
 
-  BOOST_REQUIRE_CLOSE(g.Probability(x), 0.00144014867515135, 1e-5);
-  BOOST_REQUIRE_CLOSE(g.Probability(-x), 0.00133352162064845, 1e-5);
+  BOOST_REQUIRE_CLOSE(g.Probability(x), 0.000721472623563794, 1e-5);
+  BOOST_REQUIRE_CLOSE(g.Probability(-x), 0.000858517854286744, 1e-5);
 
   // Higher-dimensional case.
   x = "0 1 2 3 4";
   g.Mean() = "5 6 3 3 2";
-  g.Covariance() = "6 1 1 0 2;"
-                   "0 7 1 0 1;"
-                   "1 1 4 1 1;"
-                   "1 0 1 7 0;"
-                   "2 0 1 1 6";
+  g.Covariance(arma::mat("6 1 1 0 2;"
+                          "1 7 1 0 1;"
+                          "1 1 4 1 1;"
+                          "0 0 1 7 0;"
+                          "2 1 1 0 6"));
 
-  BOOST_REQUIRE_CLOSE(g.Probability(x), 1.02531207499358e-6, 1e-5);
-  BOOST_REQUIRE_CLOSE(g.Probability(-x), 1.06784794079363e-8, 1e-5);
+  BOOST_REQUIRE_CLOSE(g.Probability(x), 1.00045989905947e-6, 1e-5);
+  BOOST_REQUIRE_CLOSE(g.Probability(-x), 1.13331787011632e-8, 1e-5);
 
   g.Mean() *= -1;
-  BOOST_REQUIRE_CLOSE(g.Probability(-x), 1.02531207499358e-6, 1e-5);
-  BOOST_REQUIRE_CLOSE(g.Probability(x), 1.06784794079363e-8, 1e-5);
+  BOOST_REQUIRE_CLOSE(g.Probability(-x), 1.00045989905947e-6, 1e-5);
+  BOOST_REQUIRE_CLOSE(g.Probability(x), 1.13331787011632e-8, 1e-5);
 
 }
 
@@ -268,7 +269,7 @@ BOOST_AUTO_TEST_CASE(GaussianMultipointMultivariateProbabilityTest)
 {
   // Same case as before.
   arma::vec mean = "5 6 3 3 2";
-  arma::mat cov = "6 1 1 0 2; 0 7 1 0 1; 1 1 4 1 1; 1 0 1 7 0; 2 0 1 1 6";
+  arma::mat cov = "6 1 1 0 2; 1 7 1 0 1; 1 1 4 1 1; 0 0 1 7 0; 2 1 1 0 6";
 
   arma::mat points = "0 3 2 2 3 4;"
                      "1 2 2 1 0 0;"
@@ -282,12 +283,52 @@ BOOST_AUTO_TEST_CASE(GaussianMultipointMultivariateProbabilityTest)
 
   BOOST_REQUIRE_EQUAL(phis.n_elem, 6);
 
-  BOOST_REQUIRE_CLOSE(phis(0), 1.02531207499358e-6, 1e-5);
-  BOOST_REQUIRE_CLOSE(phis(1), 1.82353695848039e-7, 1e-5);
-  BOOST_REQUIRE_CLOSE(phis(2), 1.29759261892949e-6, 1e-5);
-  BOOST_REQUIRE_CLOSE(phis(3), 1.33218060268258e-6, 1e-5);
-  BOOST_REQUIRE_CLOSE(phis(4), 1.12120427975708e-6, 1e-5);
-  BOOST_REQUIRE_CLOSE(phis(5), 4.57951032485297e-7, 1e-5);
+  BOOST_REQUIRE_CLOSE(phis(0), 1.00045989905947e-6, 1e-5);
+  BOOST_REQUIRE_CLOSE(phis(1), 1.04482372777734e-7, 1e-5);
+  BOOST_REQUIRE_CLOSE(phis(2), 1.42564801825359e-6, 1e-5);
+  BOOST_REQUIRE_CLOSE(phis(3), 1.44721565867444e-6, 1e-5);
+  BOOST_REQUIRE_CLOSE(phis(4), 1.30576440750675e-6, 1e-5);
+  BOOST_REQUIRE_CLOSE(phis(5), 5.22599644545646e-7, 1e-5);
+}
+
+/**
+ * Make sure GaussianDistribution::LogProbability() gives the log of the
+ * probability, for one point and for many, and that it doesn't underflow for
+ * points far from the mean.
+ */
+BOOST_AUTO_TEST_CASE(GaussianLogProbabilityTest)
+{
+  arma::vec mean = "5 6 3 3 2";
+  arma::mat cov = "6 1 1 0 2; 1 7 1 0 1; 1 1 4 1 1; 0 0 1 7 0; 2 1 1 0 6";
+
+  arma::mat points = "0 3 2 2 3 4;"
+                     "1 2 2 1 0 0;"
+                     "2 3 0 5 5 6;"
+                     "3 7 8 0 1 1;"
+                     "4 8 1 1 0 0;";
+
+  GaussianDistribution g(mean, cov);
+
+  BOOST_REQUIRE_CLOSE(g.LogProbability(points.col(0)), -13.815050764626,
+      1e-5);
+  BOOST_REQUIRE_CLOSE(g.LogProbability(arma::vec(-points.col(0))),
+      -18.2955312451064, 1e-5);
+
+  arma::vec logPhis;
+  g.LogProbability(points, logPhis);
+
+  BOOST_REQUIRE_EQUAL(logPhis.n_elem, 6);
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(logPhis[i], g.LogProbability(points.col(i)), 1e-5);
+    BOOST_REQUIRE_CLOSE(logPhis[i], log(g.Probability(points.col(i))), 1e-5);
+  }
+
+  // The probability of this point underflows, but its log-probability doesn't.
+  GaussianDistribution h(arma::vec("0.0"), arma::mat("1.0"));
+  BOOST_REQUIRE_EQUAL(h.Probability(arma::vec("100.0")), 0.0);
+  BOOST_REQUIRE_CLOSE(h.LogProbability(arma::vec("100.0")), -5000.9189385332,
+      1e-5);
 }
 
 /**
@@ -356,4 +397,141 @@ BOOST_AUTO_TEST_CASE(GaussianDistributionEstimateTest)
       BOOST_REQUIRE_SMALL(d.Covariance()(i, j) - actualCov(i, j), 1e-5);
 }
 
+/**
+ * Make sure DiagonalGaussianDistribution gives the same probabilities as a
+ * GaussianDistribution with the same (diagonal) covariance.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGaussianProbabilityTest)
+{
+  arma::vec mean = "5 6 3 3 2";
+  arma::vec variances = "6 7 4 7 0.5";
+
+  DiagonalGaussianDistribution d(mean, variances);
+  GaussianDistribution g(mean, arma::diagmat(variances));
+
+  BOOST_REQUIRE_EQUAL(d.Dimensionality(), 5);
+  BOOST_REQUIRE_CLOSE(d.LogDetCovariance(), g.LogDetCovariance(), 1e-5);
+
+  arma::mat points = "0 3 2 2 3 4;"
+                     "1 2 2 1 0 0;"
+                     "2 3 0 5 5 6;"
+                     "3 7 8 0 1 1;"
+                     "4 8 1 1 0 0;";
+
+  arma::vec logPhis, gLogPhis, phis;
+  d.LogProbability(points, logPhis);
+  g.LogProbability(points, gLogPhis);
+  d.Probability(points, phis);
+
+  BOOST_REQUIRE_EQUAL(logPhis.n_elem, 6);
+  BOOST_REQUIRE_EQUAL(phis.n_elem, 6);
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(logPhis[i], gLogPhis[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(d.LogProbability(points.col(i)), gLogPhis[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(d.Probability(points.col(i)),
+        g.Probability(points.col(i)), 1e-5);
+    BOOST_REQUIRE_CLOSE(phis[i], g.Probability(points.col(i)), 1e-5);
+  }
+}
+
+/**
+ * Make sure DiagonalGaussianDistribution estimates the same mean and variances
+ * as GaussianDistribution, with and without probabilities.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGaussianEstimateTest)
+{
+  arma::mat observations(4, 1000);
+  observations.randn();
+  observations.row(1) *= 3.0;
+  observations.row(2) += 2.0;
+
+  arma::vec probabilities(1000);
+  probabilities.randu();
+
+  DiagonalGaussianDistribution d;
+  GaussianDistribution g;
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    if (trial == 0)
+    {
+      d.Estimate(observations);
+      g.Estimate(observations);
+    }
+    else
+    {
+      d.Estimate(observations, probabilities);
+      g.Estimate(observations, probabilities);
+    }
+
+    BOOST_REQUIRE_EQUAL(d.Mean().n_elem, 4);
+    BOOST_REQUIRE_EQUAL(d.Covariance().n_elem, 4);
+    for (size_t i = 0; i < 4; ++i)
+    {
+      BOOST_REQUIRE_SMALL(d.Mean()[i] - g.Mean()[i], 1e-5);
+      BOOST_REQUIRE_CLOSE(d.Covariance()[i], g.Covariance()(i, i), 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure random observations from DiagonalGaussianDistribution have the
+ * right mean and variances.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGaussianRandomTest)
+{
+  arma::vec mean("1.0 2.25 -3.0");
+  arma::vec variances("0.85 1.45 4.0");
+
+  DiagonalGaussianDistribution d(mean, variances);
+
+  arma::mat obs(3, 5000);
+  for (size_t i = 0; i < 5000; ++i)
+    obs.col(i) = d.Random();
+
+  // Now make sure that reflects the actual distribution.
+  arma::vec obsMean = arma::mean(obs, 1);
+  arma::vec obsVariances = arma::var(obs, 0, 1);
+
+  // 10% tolerance because this can be noisy.
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(obsMean[i], mean[i], 10.0);
+    BOOST_REQUIRE_CLOSE(obsVariances[i], variances[i], 10.0);
+  }
+}
+
+/**
+ * The weighted fit of a RegressionDistribution, from the normal equations,
+ * should match weighted least-squares linear regression, and the batch
+ * log-probabilities should match the probability of each observation.
+ */
+BOOST_AUTO_TEST_CASE(RegressionDistributionWeightedEstimateTest)
+{
+  arma::mat predictors(3, 500, arma::fill::randn);
+  const arma::vec b("1.5 -2.0 0.5");
+  arma::vec responses = arma::trans(predictors) * b + 3.0 +
+      0.1 * arma::randn<arma::vec>(500);
+  arma::vec weights = arma::randu<arma::vec>(500);
+
+  arma::mat observations(4, 500);
+  observations.row(0) = arma::trans(responses);
+  observations.rows(1, 3) = predictors;
+
+  RegressionDistribution rd;
+  rd.Estimate(observations, weights);
+
+  regression::LinearRegression lr(predictors, responses, 0, true, weights);
+  BOOST_REQUIRE_EQUAL(rd.Parameters().n_elem, 4);
+  for (size_t i = 0; i < 4; ++i)
+    BOOST_REQUIRE_CLOSE(rd.Parameters()[i], lr.Parameters()[i], 1e-5);
+
+  arma::vec logProbabilities;
+  rd.LogProbability(observations, logProbabilities);
+  BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, 500);
+  for (size_t i = 0; i < observations.n_cols; ++i)
+    BOOST_REQUIRE_CLOSE(logProbabilities[i],
+        log(rd.Probability(observations.unsafe_col(i))), 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -10,6 +10,10 @@
 
 #include <mlpack/core/tree/cover_tree.hpp>
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::emst;
 using namespace mlpack::tree;
@@ -277,4 +281,189 @@ BOOST_AUTO_TEST_CASE(BallTreeTest)
 
 }
 
+/**
+ * Make sure the parallel traversal gives the same tree (and the same number of
+ * base cases, for the naive computation) as a single thread.
+ */
+BOOST_AUTO_TEST_CASE(ThreadCountTest)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  DualTreeBoruvka<> serialDTB(inputData);
+  DualTreeBoruvka<> parallelDTB(inputData);
+  DualTreeBoruvka<> serialNaive(inputData, true);
+  DualTreeBoruvka<> parallelNaive(inputData, true);
+
+  arma::mat serialResults, parallelResults, serialNaiveResults,
+      parallelNaiveResults;
+#ifdef HAS_OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  serialDTB.ComputeMST(serialResults);
+  serialNaive.ComputeMST(serialNaiveResults);
+  omp_set_num_threads(std::max(threads, 4));
+  parallelDTB.ComputeMST(parallelResults);
+  parallelNaive.ComputeMST(parallelNaiveResults);
+  omp_set_num_threads(threads);
+#else
+  serialDTB.ComputeMST(serialResults);
+  serialNaive.ComputeMST(serialNaiveResults);
+  parallelDTB.ComputeMST(parallelResults);
+  parallelNaive.ComputeMST(parallelNaiveResults);
+#endif
+
+  BOOST_REQUIRE_EQUAL(parallelResults.n_cols, serialResults.n_cols);
+  BOOST_REQUIRE_EQUAL(parallelNaiveResults.n_cols, serialResults.n_cols);
+  for (size_t i = 0; i < serialResults.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(parallelResults(0, i), serialResults(0, i));
+    BOOST_REQUIRE_EQUAL(parallelResults(1, i), serialResults(1, i));
+    BOOST_REQUIRE_CLOSE(parallelResults(2, i), serialResults(2, i), 1e-5);
+
+    BOOST_REQUIRE_EQUAL(parallelNaiveResults(0, i), serialResults(0, i));
+    BOOST_REQUIRE_EQUAL(parallelNaiveResults(1, i), serialResults(1, i));
+    BOOST_REQUIRE_CLOSE(parallelNaiveResults(2, i), serialResults(2, i),
+        1e-5);
+  }
+
+  BOOST_REQUIRE_EQUAL(parallelNaive.Statistics().BaseCases(),
+      serialNaive.Statistics().BaseCases());
+}
+
+/**
+ * Make sure an approximate MST, with kd-trees and cover trees, is a spanning
+ * tree whose length is within a factor of (1 + epsilon) of the exact one.
+ */
+BOOST_AUTO_TEST_CASE(ApproximateMSTTest)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  const double epsilon = 0.5;
+
+  DualTreeBoruvka<> exact(inputData, true);
+  DualTreeBoruvka<> kd(inputData);
+  DualTreeBoruvka<EuclideanDistance, CoverTree<EuclideanDistance,
+      FirstPointIsRoot, DTBStat> > cover(inputData);
+  kd.Epsilon() = epsilon;
+  cover.Epsilon() = epsilon;
+
+  arma::mat exactResults, kdResults, coverResults;
+  exact.ComputeMST(exactResults);
+  kd.ComputeMST(kdResults);
+  cover.ComputeMST(coverResults);
+
+  const double exactLength = arma::accu(exactResults.row(2));
+  const arma::mat* results[2] = { &kdResults, &coverResults };
+  for (size_t r = 0; r < 2; ++r)
+  {
+    BOOST_REQUIRE_EQUAL(results[r]->n_cols, inputData.n_cols - 1);
+
+    // Every point must be connected.
+    UnionFind connections(inputData.n_cols);
+    for (size_t i = 0; i < results[r]->n_cols; ++i)
+    {
+      const size_t a = (size_t) (*results[r])(0, i);
+      const size_t b = (size_t) (*results[r])(1, i);
+      BOOST_REQUIRE_NE(connections.Find(a), connections.Find(b));
+      connections.Union(a, b);
+    }
+
+    const double length = arma::accu(results[r]->row(2));
+    BOOST_REQUIRE_GE(length, exactLength * (1 - 1e-10));
+    BOOST_REQUIRE_LE(length, (1 + epsilon) * exactLength);
+  }
+
+  BOOST_REQUIRE_LE(kd.Statistics().MaxRelativeError(), epsilon);
+  BOOST_REQUIRE_LE(cover.Statistics().MaxRelativeError(), epsilon);
+}
+
+/**
+ * Check the single-linkage dendrogram and its cuts on a small hand-computed
+ * example.
+ */
+BOOST_AUTO_TEST_CASE(DendrogramTest)
+{
+  // One-dimensional points 0, 1, 3, 10, 11; the edges are not sorted.
+  arma::mat mst("1 0 3 2;"
+                "2 1 4 3;"
+                "2 1 1 7");
+
+  Dendrogram dendrogram(mst, 5);
+  const arma::mat& merges = dendrogram.Merges();
+
+  BOOST_REQUIRE_EQUAL(merges.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(merges.n_cols, 4);
+
+  const double expected[4][4] = { { 0, 1, 1, 2 },
+                                  { 3, 4, 1, 2 },
+                                  { 2, 5, 2, 3 },
+                                  { 6, 7, 7, 5 } };
+  for (size_t i = 0; i < 4; ++i)
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_CLOSE(merges(j, i), expected[i][j], 1e-5);
+
+  arma::Col<size_t> labels;
+  BOOST_REQUIRE_EQUAL(dendrogram.Cut(1.5, labels), 3);
+  BOOST_REQUIRE_EQUAL(labels[0], 0);
+  BOOST_REQUIRE_EQUAL(labels[1], 0);
+  BOOST_REQUIRE_EQUAL(labels[2], 1);
+  BOOST_REQUIRE_EQUAL(labels[3], 2);
+  BOOST_REQUIRE_EQUAL(labels[4], 2);
+
+  // The singleton cluster becomes noise, with the label after the last
+  // cluster.
+  BOOST_REQUIRE_EQUAL(dendrogram.Cut(1.5, labels, 2), 2);
+  BOOST_REQUIRE_EQUAL(labels[0], 0);
+  BOOST_REQUIRE_EQUAL(labels[1], 0);
+  BOOST_REQUIRE_EQUAL(labels[2], 2);
+  BOOST_REQUIRE_EQUAL(labels[3], 1);
+  BOOST_REQUIRE_EQUAL(labels[4], 1);
+
+  BOOST_REQUIRE_EQUAL(dendrogram.CutClusters(2, labels), 2);
+  BOOST_REQUIRE_EQUAL(labels[0], 0);
+  BOOST_REQUIRE_EQUAL(labels[1], 0);
+  BOOST_REQUIRE_EQUAL(labels[2], 0);
+  BOOST_REQUIRE_EQUAL(labels[3], 1);
+  BOOST_REQUIRE_EQUAL(labels[4], 1);
+
+  BOOST_REQUIRE_EQUAL(dendrogram.Cut(7.0, labels), 1);
+  for (size_t i = 0; i < 5; ++i)
+    BOOST_REQUIRE_EQUAL(labels[i], 0);
+}
+
+/**
+ * Make sure the dendrogram from DualTreeBoruvka has the MST edge lengths as its
+ * heights and ends with a single cluster holding every point.
+ */
+BOOST_AUTO_TEST_CASE(DTBDendrogramTest)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  DualTreeBoruvka<> dtb(inputData);
+
+  arma::mat results;
+  arma::mat dendrogram;
+  dtb.ComputeMST(results, dendrogram);
+
+  BOOST_REQUIRE_EQUAL(dendrogram.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(dendrogram.n_cols, results.n_cols);
+  for (size_t i = 0; i < results.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(dendrogram(2, i), results(2, i), 1e-5);
+
+    // Each merge uses clusters that already exist.
+    BOOST_REQUIRE_LT(dendrogram(0, i), dendrogram(1, i));
+    BOOST_REQUIRE_LT(dendrogram(1, i), inputData.n_cols + i);
+  }
+
+  BOOST_REQUIRE_CLOSE(dendrogram(3, results.n_cols - 1),
+      (double) inputData.n_cols, 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -8,6 +8,8 @@
 #include <mlpack/methods/fastmks/fastmks.hpp>
 #include <mlpack/core/kernels/linear_kernel.hpp>
 #include <mlpack/core/kernels/polynomial_kernel.hpp>
+#include <mlpack/core/kernels/cosine_distance.hpp>
+#include <mlpack/core/kernels/cached_kernel.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -54,6 +56,95 @@ BOOST_AUTO_TEST_CASE(SingleTreeVsNaive)
   }
 }
 
+/**
+ * Compare single-tree search with the queries visited along the Hilbert curve
+ * and naive search.
+ */
+BOOST_AUTO_TEST_CASE(ReorderedSingleTreeVsNaive)
+{
+  arma::mat references;
+  references.randn(5, 1000);
+  arma::mat queries;
+  queries.randn(5, 200);
+  LinearKernel lk;
+
+  FastMKS<LinearKernel> naive(references, queries, lk, false, true);
+
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(10, naiveIndices, naiveProducts);
+
+  FastMKS<LinearKernel> single(references, queries, lk, true);
+  single.ReorderQueries() = true;
+
+  arma::Mat<size_t> singleIndices;
+  arma::mat singleProducts;
+  single.Search(10, singleIndices, singleProducts);
+
+  for (size_t q = 0; q < singleIndices.n_cols; ++q)
+  {
+    for (size_t r = 0; r < singleIndices.n_rows; ++r)
+    {
+      BOOST_REQUIRE_EQUAL(singleIndices(r, q), naiveIndices(r, q));
+      BOOST_REQUIRE_CLOSE(singleProducts(r, q), naiveProducts(r, q), 1e-5);
+    }
+  }
+}
+
+/**
+ * With epsilon > 0, single-tree and dual-tree search make approximate prunes,
+ * and each kernel found is within a factor of (1 + epsilon) of the exact one
+ * (the kernels are positive, since the points are).
+ */
+BOOST_AUTO_TEST_CASE(ApproximateVsNaive)
+{
+  arma::mat references;
+  references.randu(5, 1000);
+  arma::mat queries;
+  queries.randu(5, 200);
+  LinearKernel lk;
+  const double epsilon = 0.1;
+
+  FastMKS<LinearKernel> naive(references, queries, lk, false, true);
+
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(10, naiveIndices, naiveProducts);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    FastMKS<LinearKernel> fastmks(references, queries, lk, (mode == 0));
+    fastmks.Epsilon() = epsilon;
+
+    arma::Mat<size_t> indices;
+    arma::mat products;
+    fastmks.Search(10, indices, products);
+
+    const TraversalStatistics& statistics = fastmks.Statistics();
+    BOOST_REQUIRE_GT(statistics.ApproximatePrunes(), 0);
+    BOOST_REQUIRE_LE(statistics.MaxRelativeError(), epsilon);
+
+    for (size_t q = 0; q < indices.n_cols; ++q)
+    {
+      for (size_t r = 0; r < indices.n_rows; ++r)
+      {
+        BOOST_REQUIRE_CLOSE(products(r, q), arma::dot(queries.col(q),
+            references.col(indices(r, q))), 1e-5);
+        BOOST_REQUIRE_GE(products(r, q) * (1 + epsilon) + 1e-10,
+            naiveProducts(r, q));
+      }
+    }
+  }
+
+  // Exact search makes no approximate prunes.
+  FastMKS<LinearKernel> exact(references, queries, lk);
+  arma::Mat<size_t> indices;
+  arma::mat products;
+  exact.Search(10, indices, products);
+  BOOST_REQUIRE_EQUAL(exact.Statistics().ApproximatePrunes(), 0);
+  BOOST_REQUIRE_EQUAL(exact.Statistics().MaxRelativeError(), 0.0);
+}
+
 /**
  * Compare dual-tree and naive.
  */
@@ -121,4 +212,160 @@ BOOST_AUTO_TEST_CASE(DualTreeVsSingleTree)
   }
 }
 
+/**
+ * Naive search with a block-evaluated kernel, over more points than fit into
+ * one block, should agree with dual-tree search, and repeated tree searches
+ * (which reuse the cached self-kernels) should give the same results.
+ */
+BOOST_AUTO_TEST_CASE(BlockNaiveVsDualTree)
+{
+  arma::mat referenceData;
+  referenceData.randn(6, 1500);
+  arma::mat queryData;
+  queryData.randn(6, 400);
+  PolynomialKernel pk(2.0, 1.0);
+
+  FastMKS<PolynomialKernel> naive(referenceData, queryData, pk, false, true);
+
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(5, naiveIndices, naiveProducts);
+
+  FastMKS<PolynomialKernel> dual(referenceData, queryData, pk);
+
+  arma::Mat<size_t> dualIndices, secondIndices;
+  arma::mat dualProducts, secondProducts;
+  dual.Search(5, dualIndices, dualProducts);
+  dual.Search(5, secondIndices, secondProducts);
+
+  for (size_t q = 0; q < dualIndices.n_cols; ++q)
+  {
+    for (size_t r = 0; r < dualIndices.n_rows; ++r)
+    {
+      BOOST_REQUIRE_EQUAL(dualIndices(r, q), naiveIndices(r, q));
+      BOOST_REQUIRE_CLOSE(dualProducts(r, q), naiveProducts(r, q), 1e-5);
+      BOOST_REQUIRE_EQUAL(secondIndices(r, q), dualIndices(r, q));
+      BOOST_REQUIRE_CLOSE(secondProducts(r, q), dualProducts(r, q), 1e-5);
+    }
+  }
+}
+
+/**
+ * The block cosine similarity in naive search should match the pairwise
+ * evaluations used by single-tree search.
+ */
+BOOST_AUTO_TEST_CASE(CosineBlockNaiveVsSingleTree)
+{
+  arma::mat data;
+  data.randn(5, 1100);
+  CosineDistance cd;
+
+  FastMKS<CosineDistance> naive(data, cd, false, true);
+
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(3, naiveIndices, naiveProducts);
+
+  FastMKS<CosineDistance> single(data, cd, true);
+
+  arma::Mat<size_t> singleIndices;
+  arma::mat singleProducts;
+  single.Search(3, singleIndices, singleProducts);
+
+  for (size_t q = 0; q < singleIndices.n_cols; ++q)
+  {
+    for (size_t r = 0; r < singleIndices.n_rows; ++r)
+    {
+      BOOST_REQUIRE_EQUAL(singleIndices(r, q), naiveIndices(r, q));
+      BOOST_REQUIRE_CLOSE(singleProducts(r, q), naiveProducts(r, q), 1e-5);
+    }
+  }
+}
+
+/**
+ * Search batches of queries concurrently with single-tree and dual-tree
+ * objects built once on the reference set, and make sure the results match
+ * naive search.
+ */
+BOOST_AUTO_TEST_CASE(ConcurrentBatchSearchTest)
+{
+  arma::mat referenceData;
+  referenceData.randn(5, 1000);
+  arma::mat queryData;
+  queryData.randn(5, 300);
+  LinearKernel lk;
+
+  FastMKS<LinearKernel> naive(referenceData, queryData, lk, false, true);
+
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(10, naiveIndices, naiveProducts);
+
+  FastMKS<LinearKernel> single(referenceData, lk, true);
+  FastMKS<LinearKernel> dual(referenceData, lk);
+
+  std::vector<arma::Mat<size_t> > batchIndices(6);
+  std::vector<arma::mat> batchProducts(6);
+
+  #pragma omp parallel for
+  for (size_t b = 0; b < 6; ++b)
+  {
+    const arma::mat batch = queryData.cols(50 * b, 50 * b + 49);
+    FastMKS<LinearKernel>& server = (b % 2 == 0) ? single : dual;
+    server.Search(batch, 10, batchIndices[b], batchProducts[b]);
+  }
+
+  for (size_t b = 0; b < 6; ++b)
+  {
+    BOOST_REQUIRE_EQUAL(batchIndices[b].n_cols, 50);
+    for (size_t q = 0; q < 50; ++q)
+    {
+      for (size_t r = 0; r < 10; ++r)
+      {
+        BOOST_REQUIRE_EQUAL(batchIndices[b](r, q),
+            naiveIndices(r, 50 * b + q));
+        BOOST_REQUIRE_CLOSE(batchProducts[b](r, q),
+            naiveProducts(r, 50 * b + q), 1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * Dual-tree search with a cached kernel should give the same results as with
+ * the kernel it wraps.
+ */
+BOOST_AUTO_TEST_CASE(CachedKernelVsPlain)
+{
+  arma::mat referenceData;
+  referenceData.randu(5, 1000);
+  arma::mat queryData;
+  queryData.randu(5, 200);
+  PolynomialKernel pk(3.0, 1.5);
+
+  FastMKS<PolynomialKernel> plain(referenceData, queryData, pk);
+
+  arma::Mat<size_t> plainIndices;
+  arma::mat plainProducts;
+  plain.Search(10, plainIndices, plainProducts);
+
+  CachedKernel<PolynomialKernel> ck(pk);
+  ck.Cache(queryData, referenceData);
+  FastMKS<CachedKernel<PolynomialKernel> > cached(referenceData, queryData,
+      ck);
+
+  arma::Mat<size_t> cachedIndices;
+  arma::mat cachedProducts;
+  cached.Search(10, cachedIndices, cachedProducts);
+
+  for (size_t q = 0; q < cachedIndices.n_cols; ++q)
+  {
+    for (size_t r = 0; r < cachedIndices.n_rows; ++r)
+    {
+      BOOST_REQUIRE_EQUAL(cachedIndices(r, q), plainIndices(r, q));
+      BOOST_REQUIRE_CLOSE(cachedProducts(r, q), plainProducts(r, q), 1e-5);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -8,6 +8,8 @@
 #include <mlpack/core.hpp>
 
 #include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/gmm/online_em_fit.hpp>
+#include <mlpack/methods/gmm/tree_em_fit.hpp>
 
 #include <mlpack/methods/gmm/no_constraint.hpp>
 #include <mlpack/methods/gmm/positive_definite_constraint.hpp>
@@ -490,7 +492,9 @@ BOOST_AUTO_TEST_CASE(GMMLoadSaveTest)
   for (size_t i = 0; i < gmm.Gaussians(); ++i)
   {
     gmm.Component(i).Mean().randu();
-    gmm.Component(i).Covariance().randu();
+    arma::mat covariance = arma::randu<arma::mat>(4, 4);
+    gmm.Component(i).Covariance(covariance * trans(covariance) +
+        arma::eye<arma::mat>(4, 4));
   }
 
   gmm.Save("test-gmm-save.xml");
@@ -597,6 +601,154 @@ BOOST_AUTO_TEST_CASE(EigenvalueRatioConstraintTest)
   }
 }
 
+BOOST_AUTO_TEST_CASE(DiagonalCovarianceConstraintTest)
+{
+  // The constraints must also work on the variances of diagonal covariances.
+  arma::vec ratios("1.0 0.7 0.4 0.2 0.1 0.1 0.05 0.01");
+  EigenvalueRatioConstraint erc(ratios);
+
+  for (size_t i = 0; i < 30; ++i)
+  {
+    arma::vec variances(8);
+    variances.randu();
+    variances[math::RandInt(8)] = -1.0;
+
+    arma::vec newVariances(variances);
+    NoConstraint::ApplyConstraint(newVariances);
+    DiagonalConstraint::ApplyConstraint(newVariances);
+    for (size_t j = 0; j < 8; ++j)
+      BOOST_REQUIRE_CLOSE(newVariances[j], variances[j], 1e-20);
+
+    PositiveDefiniteConstraint::ApplyConstraint(newVariances);
+    BOOST_REQUIRE_GT(newVariances.min(), 1e-50);
+
+    // The eigenvalues of a diagonal covariance are its variances.
+    erc.ApplyConstraint(variances);
+    const arma::vec eigenvalues = arma::sort(variances);
+    for (size_t j = 0; j < 8; ++j)
+      BOOST_REQUIRE_CLOSE(eigenvalues[j] / eigenvalues[0], ratios[j], 1e-5);
+  }
+}
+
+/**
+ * Make sure that EMFit with diagonal Gaussians gives the same model as EMFit
+ * with full Gaussians and the DiagonalConstraint.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGMMMatchesDiagonalConstraintTest)
+{
+  arma::mat data(4, 2000);
+  data.randn();
+  data.cols(1000, 1999) *= 2.0;
+  data.cols(1000, 1999) += 4.0;
+
+  arma::vec probabilities;
+  probabilities.randu(data.n_cols);
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    const bool useProbabilities = (trial == 1);
+
+    std::vector<distribution::GaussianDistribution> dists(2,
+        distribution::GaussianDistribution(4));
+    arma::vec weights(2);
+    EMFit<kmeans::KMeans<>, DiagonalConstraint> fitter(10);
+
+    std::vector<distribution::DiagonalGaussianDistribution> diagDists(2,
+        distribution::DiagonalGaussianDistribution(4));
+    arma::vec diagWeights(2);
+    EMFit<kmeans::KMeans<>, NoConstraint,
+        distribution::DiagonalGaussianDistribution> diagFitter(10);
+
+    // Both initial clusterings must be the same.
+    math::RandomSeed(std::time(NULL));
+    const size_t seed = math::RandInt(100000);
+    math::RandomSeed(seed);
+    if (useProbabilities)
+      fitter.Estimate(data, probabilities, dists, weights);
+    else
+      fitter.Estimate(data, dists, weights);
+
+    math::RandomSeed(seed);
+    if (useProbabilities)
+      diagFitter.Estimate(data, probabilities, diagDists, diagWeights);
+    else
+      diagFitter.Estimate(data, diagDists, diagWeights);
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(diagWeights[i], weights[i], 1e-3);
+      for (size_t j = 0; j < 4; ++j)
+      {
+        BOOST_REQUIRE_CLOSE(diagDists[i].Mean()[j], dists[i].Mean()[j], 1e-3);
+        BOOST_REQUIRE_CLOSE(diagDists[i].Covariance()[j],
+            dists[i].Covariance()(j, j), 1e-3);
+      }
+    }
+  }
+}
+
+/**
+ * Train a DiagonalGMM on two well-separated Gaussians, and make sure the
+ * components are recovered and it can be saved and loaded.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGMMTrainTest)
+{
+  arma::mat data(3, 4000);
+  data.randn();
+  data.submat(1, 0, 1, 1999) *= 2.0;
+  data.submat(2, 0, 2, 1999) *= 0.5;
+  const arma::vec mean("10.0 -10.0 10.0");
+  data.cols(2000, 3999) += mean * arma::ones<arma::rowvec>(2000);
+
+  DiagonalGMM gmm(2, 3);
+  gmm.Estimate(data);
+
+  // Find which component is which.
+  const size_t first = (gmm.Component(0).Mean()[0] < 5.0) ? 0 : 1;
+  const size_t second = 1 - first;
+
+  BOOST_REQUIRE_CLOSE(gmm.Weights()[first], 0.5, 5.0);
+  BOOST_REQUIRE_CLOSE(gmm.Weights()[second], 0.5, 5.0);
+
+  const arma::vec variances("1.0 4.0 0.25");
+  for (size_t j = 0; j < 3; ++j)
+  {
+    BOOST_REQUIRE_SMALL(gmm.Component(first).Mean()[j], 0.2);
+    BOOST_REQUIRE_CLOSE(gmm.Component(first).Covariance()[j], variances[j],
+        10.0);
+    BOOST_REQUIRE_CLOSE(gmm.Component(second).Mean()[j], mean[j], 2.0);
+    BOOST_REQUIRE_CLOSE(gmm.Component(second).Covariance()[j], 1.0, 10.0);
+  }
+
+  arma::Col<size_t> labels;
+  gmm.Classify(data, labels);
+  for (size_t i = 0; i < 2000; ++i)
+    BOOST_REQUIRE_EQUAL(labels[i], first);
+  for (size_t i = 2000; i < 4000; ++i)
+    BOOST_REQUIRE_EQUAL(labels[i], second);
+
+  gmm.Save("test-diagonal-gmm-save.xml");
+
+  DiagonalGMM gmm2;
+  gmm2.Load("test-diagonal-gmm-save.xml");
+
+  BOOST_REQUIRE_EQUAL(gmm2.Gaussians(), 2);
+  BOOST_REQUIRE_EQUAL(gmm2.Dimensionality(), 3);
+  for (size_t i = 0; i < 2; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(gmm2.Weights()[i], gmm.Weights()[i], 1e-3);
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(gmm2.Component(i).Mean()[j],
+          gmm.Component(i).Mean()[j], 1e-3);
+      BOOST_REQUIRE_CLOSE(gmm2.Component(i).Covariance()[j],
+          gmm.Component(i).Covariance()[j], 1e-3);
+    }
+  }
+
+  remove("test-diagonal-gmm-save.xml");
+}
+
 BOOST_AUTO_TEST_CASE(UseExistingModelTest)
 {
   // If we run a GMM and it converges, then if we run it again using the
@@ -758,5 +910,500 @@ BOOST_AUTO_TEST_CASE(UseExistingModelTest)
   }
 }
 
+/**
+ * Make sure that one iteration of EM, which is split into blocks of
+ * observations (and across threads), gives the same model as one iteration
+ * computed directly, both with and without observation probabilities.
+ */
+BOOST_AUTO_TEST_CASE(EMFitBlockedIterationTest)
+{
+  // Two overlapping Gaussians, so that every point has some probability of
+  // being from each; this spans several blocks.
+  arma::mat data;
+  data.randn(3, 5000);
+  data.cols(2500, 4999) += 1.0;
+
+  arma::vec probabilities;
+  probabilities.randu(data.n_cols);
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    const bool useProbabilities = (trial == 1);
+
+    std::vector<distribution::GaussianDistribution> dists(2,
+        distribution::GaussianDistribution(3));
+    dists[0].Mean().zeros();
+    dists[1].Mean().fill(1.5);
+    dists[0].Covariance(arma::eye<arma::mat>(3, 3));
+    dists[1].Covariance(2.0 * arma::eye<arma::mat>(3, 3));
+    arma::vec weights("0.3 0.7");
+
+    // Compute one iteration directly.
+    arma::mat condProb(data.n_cols, 2);
+    for (size_t i = 0; i < 2; ++i)
+    {
+      arma::vec condProbAlias = condProb.unsafe_col(i);
+      dists[i].Probability(data, condProbAlias);
+      condProbAlias *= weights[i];
+    }
+    for (size_t j = 0; j < data.n_cols; ++j)
+    {
+      condProb.row(j) /= accu(condProb.row(j));
+      if (useProbabilities)
+        condProb.row(j) *= probabilities[j];
+    }
+
+    std::vector<arma::vec> means(2);
+    std::vector<arma::mat> covariances(2);
+    arma::vec newWeights(2);
+    for (size_t i = 0; i < 2; ++i)
+    {
+      const double sum = accu(condProb.col(i));
+      means[i] = (data * condProb.col(i)) / sum;
+      arma::mat diffs = data - (means[i] * arma::ones<arma::rowvec>(
+          data.n_cols));
+      covariances[i] = (diffs * diagmat(condProb.col(i)) * trans(diffs)) / sum;
+      newWeights[i] = sum / (useProbabilities ? accu(probabilities) :
+          data.n_cols);
+    }
+
+    // Now run one iteration of EMFit.
+    EMFit<> fitter(2, 1e-10);
+    if (useProbabilities)
+      fitter.Estimate(data, probabilities, dists, weights, true);
+    else
+      fitter.Estimate(data, dists, weights, true);
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+      for (size_t j = 0; j < 3; ++j)
+        BOOST_REQUIRE_CLOSE(dists[i].Mean()[j], means[i][j], 1e-5);
+
+      for (size_t j = 0; j < 9; ++j)
+        BOOST_REQUIRE_CLOSE(dists[i].Covariance()[j], covariances[i][j], 1e-5);
+
+      BOOST_REQUIRE_CLOSE(weights[i], newWeights[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * A reducer for the tests of the distributed EM, which acts as if there
+ * were a second node holding a copy of the data of this node: every sum is
+ * doubled.
+ */
+class DoublingReducer
+{
+ public:
+  void Sum(double* values, const size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      values[i] *= 2;
+  }
+
+  size_t Rank() const { return 0; }
+  size_t NumNodes() const { return 2; }
+};
+
+/**
+ * Make sure that the distributed EMFit gives the same model as EMFit on the
+ * whole dataset, when every node holds the same observations, for both full
+ * and diagonal covariances.
+ */
+BOOST_AUTO_TEST_CASE(DistributedEMFitTest)
+{
+  arma::mat data;
+  data.randn(3, 2000);
+  data.cols(1000, 1999) += 3.0;
+
+  std::vector<distribution::GaussianDistribution> dists(2,
+      distribution::GaussianDistribution(3));
+  dists[0].Mean().zeros();
+  dists[1].Mean().fill(2.0);
+  dists[0].Covariance(arma::eye<arma::mat>(3, 3));
+  dists[1].Covariance(2.0 * arma::eye<arma::mat>(3, 3));
+  arma::vec weights("0.4 0.6");
+
+  std::vector<distribution::GaussianDistribution> doubledDists(dists);
+  arma::vec doubledWeights(weights);
+
+  EMFit<> fitter(30, 1e-10);
+  fitter.Estimate(data, dists, weights, true);
+  DoublingReducer reducer;
+  fitter.Estimate(data, doubledDists, doubledWeights, reducer, true);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+      BOOST_REQUIRE_CLOSE(doubledDists[i].Mean()[j], dists[i].Mean()[j], 1e-5);
+
+    for (size_t j = 0; j < 9; ++j)
+      BOOST_REQUIRE_CLOSE(doubledDists[i].Covariance()[j],
+          dists[i].Covariance()[j], 1e-5);
+
+    BOOST_REQUIRE_CLOSE(doubledWeights[i], weights[i], 1e-5);
+  }
+
+  std::vector<distribution::DiagonalGaussianDistribution> diagDists(2,
+      distribution::DiagonalGaussianDistribution(3));
+  diagDists[0].Mean().zeros();
+  diagDists[1].Mean().fill(2.0);
+  diagDists[0].Covariance(arma::ones<arma::vec>(3));
+  diagDists[1].Covariance(2.0 * arma::ones<arma::vec>(3));
+  arma::vec diagWeights("0.4 0.6");
+
+  std::vector<distribution::DiagonalGaussianDistribution> doubledDiagDists(
+      diagDists);
+  arma::vec doubledDiagWeights(diagWeights);
+
+  EMFit<kmeans::KMeans<>, NoConstraint,
+      distribution::DiagonalGaussianDistribution> diagFitter(30, 1e-10);
+  diagFitter.Estimate(data, diagDists, diagWeights, true);
+  diagFitter.Estimate(data, doubledDiagDists, doubledDiagWeights, reducer,
+      true);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(doubledDiagDists[i].Mean()[j],
+          diagDists[i].Mean()[j], 1e-5);
+      BOOST_REQUIRE_CLOSE(doubledDiagDists[i].Covariance()[j],
+          diagDists[i].Covariance()[j], 1e-5);
+    }
+
+    BOOST_REQUIRE_CLOSE(doubledDiagWeights[i], diagWeights[i], 1e-5);
+  }
+}
+
+/**
+ * EMFit on the unique points of a dataset with duplicates, with their counts as
+ * their probabilities, should give the same model as EMFit on the whole
+ * dataset.
+ */
+BOOST_AUTO_TEST_CASE(EMFitDuplicatesTest)
+{
+  arma::mat points;
+  points.randn(3, 400);
+  points.cols(200, 399) += 3.0;
+  arma::mat data(3, 1500);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) = points.col((i < 800) ? (i % 400) : (i % 70 + 200));
+
+  data::UniquePoints unique(data);
+  arma::mat uniqueData;
+  unique.Extract(data, uniqueData);
+
+  std::vector<distribution::GaussianDistribution> dists(2,
+      distribution::GaussianDistribution(3));
+  dists[0].Mean().zeros();
+  dists[1].Mean().fill(2.0);
+  dists[0].Covariance(arma::eye<arma::mat>(3, 3));
+  dists[1].Covariance(2.0 * arma::eye<arma::mat>(3, 3));
+  arma::vec weights("0.4 0.6");
+
+  std::vector<distribution::GaussianDistribution> uniqueDists(dists);
+  arma::vec uniqueWeights(weights);
+
+  EMFit<> fitter(30, 1e-10);
+  fitter.Estimate(data, dists, weights, true);
+  fitter.Estimate(uniqueData, unique.Weights(), uniqueDists, uniqueWeights,
+      true);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+      BOOST_REQUIRE_CLOSE(uniqueDists[i].Mean()[j], dists[i].Mean()[j], 1e-5);
+
+    for (size_t j = 0; j < 9; ++j)
+      BOOST_REQUIRE_CLOSE(uniqueDists[i].Covariance()[j],
+          dists[i].Covariance()[j], 1e-5);
+
+    BOOST_REQUIRE_CLOSE(uniqueWeights[i], weights[i], 1e-5);
+  }
+}
+
+/**
+ * With tau = 0, no node can be pruned, so an iteration of TreeEMFit should be
+ * the same as an iteration of EMFit.
+ */
+BOOST_AUTO_TEST_CASE(TreeEMFitExactIterationTest)
+{
+  arma::mat data;
+  data.randn(2, 1000);
+  data.cols(500, 999) += 1.0;
+
+  std::vector<distribution::GaussianDistribution> dists(2,
+      distribution::GaussianDistribution(2));
+  dists[0].Mean().zeros();
+  dists[1].Mean().fill(1.5);
+  dists[0].Covariance(arma::eye<arma::mat>(2, 2));
+  dists[1].Covariance(arma::mat("2.0 0.5; 0.5 1.0"));
+  arma::vec weights("0.3 0.7");
+
+  std::vector<distribution::GaussianDistribution> treeDists(dists);
+  arma::vec treeWeights(weights);
+
+  EMFit<> fitter(3, 1e-10);
+  fitter.Estimate(data, dists, weights, true);
+
+  TreeEMFit<> treeFitter(3, 1e-10, 0.0, 5);
+  treeFitter.Estimate(data, treeDists, treeWeights, true);
+
+  BOOST_REQUIRE_EQUAL(treeFitter.Statistics().Prunes(), 0);
+  for (size_t i = 0; i < 2; ++i)
+  {
+    for (size_t j = 0; j < 2; ++j)
+      BOOST_REQUIRE_CLOSE(treeDists[i].Mean()[j], dists[i].Mean()[j], 1e-5);
+
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_CLOSE(treeDists[i].Covariance()[j],
+          dists[i].Covariance()[j], 1e-5);
+
+    BOOST_REQUIRE_CLOSE(treeWeights[i], weights[i], 1e-5);
+  }
+}
+
+/**
+ * Train a GMM with TreeEMFit on well-separated Gaussians, where most of the
+ * tree should be pruned, and make sure the model is close to the one trained
+ * with EMFit.
+ */
+BOOST_AUTO_TEST_CASE(TreeEMFitTrainTest)
+{
+  arma::mat data(2, 6000);
+  data.randn();
+  data.submat(0, 0, 0, 1999) *= 2.0;
+  data.cols(2000, 3999) += arma::vec("15.0 0.0") *
+      arma::ones<arma::rowvec>(2000);
+  data.cols(4000, 5999) += arma::vec("0.0 15.0") *
+      arma::ones<arma::rowvec>(2000);
+
+  // Use the same initial clustering for both.
+  GMM<> gmm(3, 2);
+  math::RandomSeed(0);
+  gmm.Estimate(data);
+
+  GMM<TreeEMFit<> > treeGMM(3, 2);
+  math::RandomSeed(0);
+  treeGMM.Estimate(data);
+
+  BOOST_REQUIRE_GT(treeGMM.Fitter().Statistics().Prunes(), 0);
+
+  // Match the components by their means.
+  for (size_t i = 0; i < 3; ++i)
+  {
+    size_t closest = 0;
+    double closestDistance = DBL_MAX;
+    for (size_t j = 0; j < 3; ++j)
+    {
+      const double distance = metric::EuclideanDistance::Evaluate(
+          gmm.Component(i).Mean(), treeGMM.Component(j).Mean());
+      if (distance < closestDistance)
+      {
+        closestDistance = distance;
+        closest = j;
+      }
+    }
+
+    BOOST_REQUIRE_SMALL(closestDistance, 0.1);
+    BOOST_REQUIRE_CLOSE(treeGMM.Weights()[closest], gmm.Weights()[i], 2.0);
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_SMALL(treeGMM.Component(closest).Covariance()[j] -
+          gmm.Component(i).Covariance()[j], 0.1);
+  }
+}
+
+/**
+ * The batch log-probabilities of a GMM should match the probabilities of each
+ * observation.
+ */
+BOOST_AUTO_TEST_CASE(GMMBatchLogProbabilityTest)
+{
+  GMM<> gmm(3, 2);
+  gmm.Weights() = arma::vec("0.2 0.5 0.3");
+  gmm.Component(0) = distribution::GaussianDistribution("0.0 0.0",
+      "1.0 0.0; 0.0 1.0");
+  gmm.Component(1) = distribution::GaussianDistribution("2.0 -1.0",
+      "2.0 0.4; 0.4 1.0");
+  gmm.Component(2) = distribution::GaussianDistribution("-3.0 1.5",
+      "0.5 0.1; 0.1 0.5");
+
+  arma::mat observations(2, 100, arma::fill::randn);
+  observations *= 3.0;
+
+  arma::vec logProbabilities;
+  gmm.LogProbability(observations, logProbabilities);
+
+  BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, 100);
+  for (size_t i = 0; i < observations.n_cols; ++i)
+    BOOST_REQUIRE_CLOSE(logProbabilities[i],
+        log(gmm.Probability(observations.unsafe_col(i))), 1e-5);
+
+  // Points far from every component still get a finite log-probability.
+  gmm.LogProbability(arma::mat("100.0; 100.0"), logProbabilities);
+  BOOST_REQUIRE(logProbabilities[0] > -std::numeric_limits<double>::infinity());
+}
+
+/**
+ * The block-parallel log-responsibilities should agree with the single-point
+ * probabilities, and Classify() and LogLikelihood() should agree with them,
+ * across several blocks of observations.
+ */
+BOOST_AUTO_TEST_CASE(GMMLogResponsibilitiesTest)
+{
+  GMM<> gmm(3, 2);
+  gmm.Weights() = arma::vec("0.2 0.5 0.3");
+  gmm.Component(0) = distribution::GaussianDistribution("0.0 0.0",
+      "1.0 0.0; 0.0 1.0");
+  gmm.Component(1) = distribution::GaussianDistribution("2.0 -1.0",
+      "2.0 0.4; 0.4 1.0");
+  gmm.Component(2) = distribution::GaussianDistribution("-3.0 1.5",
+      "0.5 0.1; 0.1 0.5");
+
+  arma::mat observations(2, 2500, arma::fill::randn);
+  observations *= 3.0;
+  observations.col(10) = arma::vec("1000.0 1000.0");
+
+  arma::mat logResponsibilities;
+  arma::vec logProbabilities;
+  gmm.LogResponsibilities(observations, logResponsibilities,
+      logProbabilities);
+  BOOST_REQUIRE_EQUAL(logResponsibilities.n_rows, 2500);
+  BOOST_REQUIRE_EQUAL(logResponsibilities.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, 2500);
+
+  arma::Col<size_t> labels;
+  gmm.Classify(observations, labels);
+  BOOST_REQUIRE_EQUAL(labels.n_elem, 2500);
+
+  double logLikelihood = 0.0;
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    logLikelihood += logProbabilities[i];
+    if (i == 10)
+      continue;
+
+    const double probability = gmm.Probability(observations.unsafe_col(i));
+    BOOST_REQUIRE_CLOSE(logProbabilities[i], log(probability), 1e-5);
+
+    size_t best = 0;
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(exp(logResponsibilities(i, j)), gmm.Probability(
+          observations.unsafe_col(i), j) / probability, 1e-5);
+      if (logResponsibilities(i, j) >= logResponsibilities(i, best))
+        best = j;
+    }
+    BOOST_REQUIRE_EQUAL(labels[i], best);
+  }
+
+  // The distant point still has a finite log-probability.
+  BOOST_REQUIRE(logProbabilities[10] >
+      -std::numeric_limits<double>::infinity());
+  BOOST_REQUIRE_CLOSE(gmm.LogLikelihood(observations), logLikelihood, 1e-8);
+}
+
+/**
+ * Train a GMM with OnlineEMFit from a stream of mini-batches, classifying each
+ * mini-batch before it is used, and make sure the model approaches the true
+ * one.
+ */
+BOOST_AUTO_TEST_CASE(OnlineEMFitStreamTest)
+{
+  math::RandomSeed(1);
+
+  GMM<> trueGMM(2, 2);
+  trueGMM.Weights() = arma::vec("0.3 0.7");
+  trueGMM.Component(0) = distribution::GaussianDistribution("0.0 0.0",
+      "1.0 0.3; 0.3 1.0");
+  trueGMM.Component(1) = distribution::GaussianDistribution("8.0 4.0",
+      "2.0 -0.5; -0.5 1.0");
+
+  arma::mat batch(2, 500);
+  for (size_t j = 0; j < batch.n_cols; ++j)
+    batch.col(j) = trueGMM.Random();
+
+  // Start from the first mini-batch.
+  OnlineEMFit<> fitter(100, 1);
+  GMM<OnlineEMFit<> > gmm(2, 2, fitter);
+  gmm.Estimate(batch);
+  const size_t first = (gmm.Component(0).Mean()[0] < 4.0) ? 0 : 1;
+
+  arma::Col<size_t> labels;
+  for (size_t b = 0; b < 50; ++b)
+  {
+    for (size_t j = 0; j < batch.n_cols; ++j)
+      batch.col(j) = trueGMM.Random();
+
+    // The model is usable between updates; the components are far apart, so
+    // nearly every point is classified by which side it is on.
+    gmm.Classify(batch, labels);
+    size_t correct = 0;
+    for (size_t j = 0; j < batch.n_cols; ++j)
+      if ((labels[j] == first) == (batch(0, j) < 4.0))
+        ++correct;
+    BOOST_REQUIRE_GT(correct, 490);
+    BOOST_REQUIRE_GT(gmm.Probability(arma::vec("8.0 4.0")),
+        gmm.Probability(arma::vec("4.0 8.0")));
+
+    gmm.Update(batch);
+  }
+
+  BOOST_REQUIRE_GT(gmm.Fitter().Updates(), 50);
+  for (size_t i = 0; i < 2; ++i)
+  {
+    const size_t c = (i == 0) ? first : 1 - first;
+    BOOST_REQUIRE_SMALL(gmm.Weights()[c] - trueGMM.Weights()[i], 0.03);
+    for (size_t j = 0; j < 2; ++j)
+      BOOST_REQUIRE_SMALL(gmm.Component(c).Mean()[j] -
+          trueGMM.Component(i).Mean()[j], 0.15);
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_SMALL(gmm.Component(c).Covariance()[j] -
+          trueGMM.Component(i).Covariance()[j], 0.25);
+  }
+}
+
+/**
+ * OnlineEMFit should also fit diagonal components, and the constraint should
+ * be applied after each update.
+ */
+BOOST_AUTO_TEST_CASE(OnlineEMFitDiagonalTest)
+{
+  math::RandomSeed(2);
+
+  arma::mat data(3, 4000);
+  data.randn();
+  data.row(1) *= 2.0;
+  data.cols(2000, 3999) += arma::vec("10.0 0.0 -10.0") *
+      arma::ones<arma::rowvec>(2000);
+
+  typedef OnlineEMFit<kmeans::KMeans<>, PositiveDefiniteConstraint,
+      distribution::DiagonalGaussianDistribution> FitterType;
+  FitterType fitter(200, 3);
+  GMM<FitterType, distribution::DiagonalGaussianDistribution> gmm(2, 3,
+      fitter);
+  gmm.Estimate(data);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    const arma::vec mean = (gmm.Component(i).Mean()[0] < 5.0) ?
+        arma::vec("0.0 0.0 0.0") : arma::vec("10.0 0.0 -10.0");
+    BOOST_REQUIRE_SMALL(gmm.Weights()[i] - 0.5, 0.03);
+    for (size_t j = 0; j < 3; ++j)
+      BOOST_REQUIRE_SMALL(gmm.Component(i).Mean()[j] - mean[j], 0.15);
+    BOOST_REQUIRE_SMALL(gmm.Component(i).Covariance()[0] - 1.0, 0.2);
+    BOOST_REQUIRE_SMALL(gmm.Component(i).Covariance()[1] - 4.0, 0.6);
+    BOOST_REQUIRE_SMALL(gmm.Component(i).Covariance()[2] - 1.0, 0.2);
+  }
+
+  // A mini-batch of one repeated point would give zero variances, but the
+  // constraint keeps them positive.
+  gmm.Fitter().StepOffset() = 0.0;
+  gmm.Fitter().Reset();
+  gmm.Update(arma::mat(3, 10, arma::fill::zeros));
+  for (size_t i = 0; i < 2; ++i)
+    BOOST_REQUIRE_GT(gmm.Component(i).Covariance().min(), 0.0);
+}
 
 BOOST_AUTO_TEST_SUITE_END();
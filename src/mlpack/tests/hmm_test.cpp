@@ -7,6 +7,10 @@
 #include <mlpack/methods/hmm/hmm.hpp>
 #include <mlpack/methods/gmm/gmm.hpp>
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -209,6 +213,52 @@ BOOST_AUTO_TEST_CASE(SimpleBaumWelchDiscreteHMM)
   BOOST_REQUIRE_CLOSE(hmm.Initial()[0], 1.0, 1e-5);
 }
 
+/**
+ * Make sure that training on many sequences (so that they are split into
+ * several chunks) gives exactly the same model with one thread as with many.
+ */
+BOOST_AUTO_TEST_CASE(BaumWelchThreadCountTest)
+{
+  HMM<DiscreteDistribution> hmm(3, DiscreteDistribution(4));
+  hmm.Transition() = arma::randu<arma::mat>(3, 3) + 0.1;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    hmm.Transition().col(i) /= accu(hmm.Transition().col(i));
+    hmm.Emission()[i].Probabilities() = arma::randu<arma::vec>(4) + 0.1;
+    hmm.Emission()[i].Probabilities() /=
+        accu(hmm.Emission()[i].Probabilities());
+  }
+
+  // Sequences of varying lengths.
+  std::vector<arma::mat> observations(100);
+  for (size_t seq = 0; seq < 100; ++seq)
+  {
+    observations[seq].set_size(1, 20 + math::RandInt(30));
+    for (size_t t = 0; t < observations[seq].n_cols; ++t)
+      observations[seq](0, t) = math::RandInt(4);
+  }
+
+  HMM<DiscreteDistribution> serialHMM(hmm);
+#ifdef HAS_OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  serialHMM.Train(observations);
+  omp_set_num_threads(std::max(threads, 4));
+  hmm.Train(observations);
+  omp_set_num_threads(threads);
+#else
+  serialHMM.Train(observations);
+  hmm.Train(observations);
+#endif
+
+  for (size_t i = 0; i < 9; ++i)
+    BOOST_REQUIRE_EQUAL(hmm.Transition()[i], serialHMM.Transition()[i]);
+  for (size_t i = 0; i < 3; ++i)
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_EQUAL(hmm.Emission()[i].Probabilities()[j],
+          serialHMM.Emission()[i].Probabilities()[j]);
+}
+
 /**
  * Increasing complexity, but still simple; 4 emissions, 2 states; the state can
  * be determined directly by the emission.
@@ -494,6 +544,75 @@ BOOST_AUTO_TEST_CASE(DiscreteHMMGenerateTest)
   }
 }
 
+/**
+ * Make sure the batch Generate() samples the transitions with the right
+ * frequencies (including zero-probability transitions, which a sparse
+ * transition matrix leaves out), and gives the same sequences for the same
+ * seed.
+ */
+BOOST_AUTO_TEST_CASE(DiscreteHMMBatchGenerateTest)
+{
+  arma::vec initial("1 0 0");
+  arma::mat transition("0.5 0.0 0.1;"
+                       "0.2 0.6 0.2;"
+                       "0.3 0.4 0.7");
+  std::vector<DiscreteDistribution> emission(3);
+  emission[0].Probabilities() = "0.75 0.25 0.00 0.00";
+  emission[1].Probabilities() = "0.00 0.25 0.25 0.50";
+  emission[2].Probabilities() = "0.10 0.40 0.40 0.10";
+
+  HMM<DiscreteDistribution> denseHMM(initial, transition, emission);
+  HMM<DiscreteDistribution, arma::sp_mat> sparseHMM(initial,
+      arma::sp_mat(transition), emission);
+
+  std::vector<size_t> lengths(200);
+  for (size_t i = 0; i < lengths.size(); ++i)
+    lengths[i] = 500 + i;
+
+  std::vector<arma::mat> sequences, sparseSequences;
+  std::vector<arma::Col<size_t> > states, sparseStates;
+  math::RandomSeed(10);
+  denseHMM.Generate(lengths, sequences, states, 1);
+  math::RandomSeed(10);
+  sparseHMM.Generate(lengths, sparseSequences, sparseStates, 1);
+
+  BOOST_REQUIRE_EQUAL(sequences.size(), lengths.size());
+  BOOST_REQUIRE_EQUAL(states.size(), lengths.size());
+
+  arma::mat counts(3, 3);
+  counts.zeros();
+  for (size_t i = 0; i < lengths.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(sequences[i].n_cols, lengths[i]);
+    BOOST_REQUIRE_EQUAL(states[i].n_elem, lengths[i]);
+    BOOST_REQUIRE_EQUAL(states[i][0], (size_t) 1);
+
+    // The alias tables of the dense and sparse transitions are the same, so
+    // the sequences must be too.
+    for (size_t t = 0; t < lengths[i]; ++t)
+    {
+      BOOST_REQUIRE_EQUAL(states[i][t], sparseStates[i][t]);
+      BOOST_REQUIRE_EQUAL(sequences[i](0, t), sparseSequences[i](0, t));
+
+      // Each observation must be possible in its state.
+      arma::vec obs(1);
+      obs[0] = sequences[i](0, t);
+      BOOST_REQUIRE_GT(emission[states[i][t]].Probability(obs), 0.0);
+
+      if (t > 0)
+        counts(states[i][t], states[i][t - 1])++;
+    }
+  }
+
+  // Normalize the counts of the transitions from each state.
+  for (size_t col = 0; col < 3; ++col)
+    counts.col(col) /= accu(counts.col(col));
+
+  for (size_t row = 0; row < 3; ++row)
+    for (size_t col = 0; col < 3; ++col)
+      BOOST_REQUIRE_SMALL(counts(row, col) - transition(row, col), 0.01);
+}
+
 BOOST_AUTO_TEST_CASE(DiscreteHMMLogLikelihoodTest)
 {
   // Create a simple HMM with three states and four emissions.
@@ -764,6 +883,61 @@ BOOST_AUTO_TEST_CASE(GaussianHMMGenerateTest)
   }
 }
 
+/**
+ * Make sure HMMs work with diagonal Gaussian emissions: generate a sequence and
+ * then estimate the HMM from it.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGaussianHMMGenerateTest)
+{
+  // Our distribution will have three two-dimensional output Gaussians.
+  HMM<DiagonalGaussianDistribution> hmm(3, DiagonalGaussianDistribution(2));
+  hmm.Transition() = arma::mat("0.4 0.6 0.8; 0.2 0.2 0.1; 0.4 0.2 0.1");
+  hmm.Emission()[0] = DiagonalGaussianDistribution("0.0 0.0", "1.0 1.0");
+  hmm.Emission()[1] = DiagonalGaussianDistribution("2.0 2.0", "1.0 1.2");
+  hmm.Emission()[2] = DiagonalGaussianDistribution("-2.0 1.0", "2.0 1.0");
+
+  // Now we will generate a long sequence.
+  std::vector<arma::mat> observations(1);
+  std::vector<arma::Col<size_t> > states(1);
+
+  // Start in state 1 (no reason).
+  hmm.Generate(10000, observations[0], states[0], 1);
+
+  HMM<DiagonalGaussianDistribution> hmm2(3, DiagonalGaussianDistribution(2));
+
+  // Now estimate the HMM from the generated sequence.
+  hmm2.Train(observations, states);
+
+  // Check that the estimated matrices are the same.
+  for (size_t row = 0; row < 3; row++)
+    for (size_t col = 0; col < 3; col++)
+      BOOST_REQUIRE_SMALL(hmm.Transition()(row, col) - hmm2.Transition()(row,
+          col), 0.03);
+
+  // Check that each Gaussian is the same.
+  for (size_t em = 0; em < 3; em++)
+  {
+    for (size_t i = 0; i < 2; i++)
+    {
+      BOOST_REQUIRE_SMALL(hmm.Emission()[em].Mean()(i) -
+          hmm2.Emission()[em].Mean()(i), 0.09);
+      BOOST_REQUIRE_SMALL(hmm.Emission()[em].Covariance()(i) -
+          hmm2.Emission()[em].Covariance()(i), 0.2);
+    }
+  }
+
+  // The log-likelihood of the sequence must be the same as under the
+  // equivalent full-covariance HMM.
+  HMM<GaussianDistribution> fullHMM(3, GaussianDistribution(2));
+  fullHMM.Transition() = hmm.Transition();
+  for (size_t em = 0; em < 3; em++)
+    fullHMM.Emission()[em] = GaussianDistribution(hmm.Emission()[em].Mean(),
+        arma::diagmat(hmm.Emission()[em].Covariance()));
+
+  BOOST_REQUIRE_CLOSE(hmm.LogLikelihood(observations[0]),
+      fullHMM.LogLikelihood(observations[0]), 1e-5);
+}
+
 /**
  * Test that HMMs work with Gaussian mixture models.  We'll try putting in a
  * simple model by hand and making sure that prediction of observation sequences
@@ -992,7 +1166,9 @@ BOOST_AUTO_TEST_CASE(GMMHMMLoadSaveTest)
     for (size_t i = 0; i < hmm.Emission()[j].Gaussians(); ++i)
     {
       hmm.Emission()[j].Component(i).Mean().randu();
-      hmm.Emission()[j].Component(i).Covariance().randu();
+      arma::mat covariance = arma::randu<arma::mat>(3, 3);
+      hmm.Emission()[j].Component(i).Covariance(covariance * trans(covariance) +
+          arma::eye<arma::mat>(3, 3));
     }
   }
 
@@ -1048,7 +1224,9 @@ BOOST_AUTO_TEST_CASE(GaussianHMMLoadSaveTest)
   for(size_t j = 0; j < hmm.Emission().size(); ++j)
   {
     hmm.Emission()[j].Mean().randu();
-    hmm.Emission()[j].Covariance().randu();
+    arma::mat covariance = arma::randu<arma::mat>(2, 2);
+    hmm.Emission()[j].Covariance(covariance * trans(covariance) +
+        arma::eye<arma::mat>(2, 2));
   }
 
   util::SaveRestoreUtility sr;
@@ -1132,5 +1310,241 @@ BOOST_AUTO_TEST_CASE(DiscreteHMMLoadSaveTest)
   }
 }
 
+/**
+ * Make sure the batch Predict() and LogLikelihood() give the same results as
+ * calling Predict() and LogLikelihood() for each sequence.
+ */
+BOOST_AUTO_TEST_CASE(HMMBatchPredictLogLikelihoodTest)
+{
+  std::vector<GaussianDistribution> emission;
+  emission.push_back(GaussianDistribution("0.0 0.0", "1.0 0.0; 0.0 1.0"));
+  emission.push_back(GaussianDistribution("2.0 1.0", "1.0 0.5; 0.5 2.0"));
+  emission.push_back(GaussianDistribution("-1.0 3.0", "0.5 0.0; 0.0 0.5"));
+  arma::mat transition("0.5 0.2 0.3;"
+                       "0.3 0.6 0.1;"
+                       "0.2 0.2 0.6");
+  HMM<GaussianDistribution> hmm(arma::vec("0.4 0.3 0.3"), transition,
+      emission);
+
+  // Sequences of varying lengths, so the workspaces are bigger than most of
+  // them.
+  std::vector<arma::mat> sequences(50);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    arma::Col<size_t> states;
+    hmm.Generate(1 + math::RandInt(100), sequences[i], states,
+        math::RandInt(3));
+  }
+
+  std::vector<arma::Col<size_t> > stateSeqs;
+  arma::vec viterbiLogLikelihoods;
+  hmm.Predict(sequences, stateSeqs, viterbiLogLikelihoods);
+
+  arma::vec logLikelihoods;
+  hmm.LogLikelihood(sequences, logLikelihoods);
+
+  BOOST_REQUIRE_EQUAL(stateSeqs.size(), 50);
+  BOOST_REQUIRE_EQUAL(viterbiLogLikelihoods.n_elem, 50);
+  BOOST_REQUIRE_EQUAL(logLikelihoods.n_elem, 50);
+  for (size_t i = 0; i < 50; ++i)
+  {
+    arma::Col<size_t> stateSeq;
+    const double viterbiLogLikelihood = hmm.Predict(sequences[i], stateSeq);
+
+    BOOST_REQUIRE_EQUAL(stateSeqs[i].n_elem, sequences[i].n_cols);
+    for (size_t t = 0; t < stateSeq.n_elem; ++t)
+      BOOST_REQUIRE_EQUAL(stateSeqs[i][t], stateSeq[t]);
+    BOOST_REQUIRE_CLOSE(viterbiLogLikelihoods[i], viterbiLogLikelihood, 1e-5);
+    BOOST_REQUIRE_CLOSE(logLikelihoods[i], hmm.LogLikelihood(sequences[i]),
+        1e-5);
+  }
+}
+
+/**
+ * Make sure that FilterStep() gives the same state probabilities as the forward
+ * algorithm, and the same log-likelihood as LogLikelihood().
+ */
+BOOST_AUTO_TEST_CASE(HMMFilterStepTest)
+{
+  std::vector<GaussianDistribution> emission;
+  emission.push_back(GaussianDistribution("0.0 0.0", "1.0 0.0; 0.0 1.0"));
+  emission.push_back(GaussianDistribution("2.0 1.0", "1.0 0.5; 0.5 2.0"));
+  arma::mat transition("0.7 0.4;"
+                       "0.3 0.6");
+  HMM<GaussianDistribution> hmm(arma::vec("0.6 0.4"), transition, emission);
+
+  arma::mat dataSeq;
+  arma::Col<size_t> states;
+  hmm.Generate(200, dataSeq, states);
+
+  arma::mat stateProb, forwardProb, backwardProb;
+  arma::vec scales;
+  hmm.Estimate(dataSeq, stateProb, forwardProb, backwardProb, scales);
+
+  arma::vec filterProb, workspace;
+  double logLikelihood = 0.0;
+  for (size_t t = 0; t < dataSeq.n_cols; ++t)
+  {
+    logLikelihood += hmm.FilterStep(dataSeq.unsafe_col(t), filterProb,
+        workspace);
+
+    BOOST_REQUIRE_EQUAL(filterProb.n_elem, 2);
+    for (size_t j = 0; j < 2; ++j)
+    {
+      if (forwardProb(j, t) < 1e-10)
+        BOOST_REQUIRE_SMALL(filterProb[j], 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(filterProb[j], forwardProb(j, t), 1e-5);
+    }
+  }
+
+  BOOST_REQUIRE_CLOSE(logLikelihood, hmm.LogLikelihood(dataSeq), 1e-5);
+}
+
+/**
+ * The emissions of an HMM with GMM emissions are evaluated in batches; make
+ * sure the results match step-by-step filtering, which evaluates one
+ * observation at a time.
+ */
+BOOST_AUTO_TEST_CASE(GMMHMMBatchEmissionTest)
+{
+  std::vector<GMM<> > gmms(2, GMM<>(2, 2));
+  gmms[0].Weights() = arma::vec("0.3 0.7");
+  gmms[0].Component(0) = GaussianDistribution("0.0 0.0", "1.0 0.2; 0.2 1.0");
+  gmms[0].Component(1) = GaussianDistribution("3.0 1.0", "0.5 0.0; 0.0 2.0");
+  gmms[1].Weights() = arma::vec("0.5 0.5");
+  gmms[1].Component(0) = GaussianDistribution("-2.0 4.0",
+      "1.5 0.3; 0.3 1.0");
+  gmms[1].Component(1) = GaussianDistribution("1.0 -3.0",
+      "1.0 0.0; 0.0 1.0");
+  arma::mat transition("0.8 0.3;"
+                       "0.2 0.7");
+  HMM<GMM<> > hmm(arma::vec("0.5 0.5"), transition, gmms);
+
+  arma::mat dataSeq;
+  arma::Col<size_t> states;
+  hmm.Generate(150, dataSeq, states);
+
+  arma::mat stateProb, forwardProb, backwardProb;
+  arma::vec scales;
+  const double estimated = hmm.Estimate(dataSeq, stateProb, forwardProb,
+      backwardProb, scales);
+
+  // Each column of the state probabilities sums to one.
+  for (size_t t = 0; t < dataSeq.n_cols; ++t)
+    BOOST_REQUIRE_CLOSE(accu(stateProb.col(t)), 1.0, 1e-5);
+
+  arma::vec filterProb, workspace;
+  double logLikelihood = 0.0;
+  for (size_t t = 0; t < dataSeq.n_cols; ++t)
+  {
+    logLikelihood += hmm.FilterStep(dataSeq.unsafe_col(t), filterProb,
+        workspace);
+
+    for (size_t j = 0; j < 2; ++j)
+    {
+      if (forwardProb(j, t) < 1e-10)
+        BOOST_REQUIRE_SMALL(filterProb[j], 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(filterProb[j], forwardProb(j, t), 1e-5);
+    }
+  }
+
+  BOOST_REQUIRE_CLOSE(estimated, logLikelihood, 1e-5);
+  BOOST_REQUIRE_CLOSE(hmm.LogLikelihood(dataSeq), logLikelihood, 1e-5);
+}
+
+/**
+ * Make sure an HMM with a sparse transition matrix gives the same results as
+ * one with the same dense transition matrix, and that Baum-Welch training keeps
+ * the transition matrix sparse.
+ */
+BOOST_AUTO_TEST_CASE(SparseTransitionHMMTest)
+{
+  // A left-to-right HMM with 20 states, each with its own Gaussian.
+  const size_t states = 20;
+  arma::sp_mat sparseTransition(states, states);
+  std::vector<GaussianDistribution> emission;
+  for (size_t i = 0; i < states; ++i)
+  {
+    if (i < states - 1)
+    {
+      sparseTransition(i, i) = 0.7;
+      sparseTransition(i + 1, i) = 0.3;
+    }
+    else
+    {
+      sparseTransition(i, i) = 1.0;
+    }
+
+    arma::vec mean(2);
+    mean.fill(3.0 * i);
+    emission.push_back(GaussianDistribution(mean, arma::eye<arma::mat>(2, 2)));
+  }
+
+  arma::vec initial(states);
+  initial.zeros();
+  initial[0] = 1.0;
+
+  HMM<GaussianDistribution, arma::sp_mat> sparseHMM(initial, sparseTransition,
+      emission);
+  HMM<GaussianDistribution> denseHMM(initial, arma::mat(sparseTransition),
+      emission);
+
+  std::vector<arma::mat> sequences(10);
+  std::vector<arma::Col<size_t> > stateSeqs(10);
+  for (size_t i = 0; i < 10; ++i)
+    denseHMM.Generate(200, sequences[i], stateSeqs[i]);
+
+  for (size_t i = 0; i < 10; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(sparseHMM.LogLikelihood(sequences[i]),
+        denseHMM.LogLikelihood(sequences[i]), 1e-5);
+
+    arma::Col<size_t> sparseStates, denseStates;
+    BOOST_REQUIRE_CLOSE(sparseHMM.Predict(sequences[i], sparseStates),
+        denseHMM.Predict(sequences[i], denseStates), 1e-5);
+    for (size_t t = 0; t < sparseStates.n_elem; ++t)
+      BOOST_REQUIRE_EQUAL(sparseStates[t], denseStates[t]);
+
+    arma::mat sparseStateProb, denseStateProb;
+    sparseHMM.Estimate(sequences[i], sparseStateProb);
+    denseHMM.Estimate(sequences[i], denseStateProb);
+    for (size_t j = 0; j < sparseStateProb.n_elem; ++j)
+    {
+      if (denseStateProb[j] < 1e-10)
+        BOOST_REQUIRE_SMALL(sparseStateProb[j], 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(sparseStateProb[j], denseStateProb[j], 1e-5);
+    }
+  }
+
+  // Train both with Baum-Welch.
+  sparseHMM.Train(sequences);
+  denseHMM.Train(sequences);
+
+  const arma::sp_mat& trainedTransition = sparseHMM.Transition();
+  BOOST_REQUIRE_LE(trainedTransition.n_nonzero, 2 * states - 1);
+  for (size_t i = 0; i < states; ++i)
+  {
+    for (size_t j = 0; j < states; ++j)
+    {
+      const double sparseValue = trainedTransition(i, j);
+      if (denseHMM.Transition()(i, j) < 1e-10)
+        BOOST_REQUIRE_SMALL(sparseValue, 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(sparseValue, denseHMM.Transition()(i, j), 1e-3);
+    }
+  }
+
+  // Now labeled training.
+  sparseHMM.Train(sequences, stateSeqs);
+  denseHMM.Train(sequences, stateSeqs);
+  for (size_t i = 0; i < states; ++i)
+    for (size_t j = 0; j < states; ++j)
+      BOOST_REQUIRE_CLOSE(trainedTransition(i, j) + 1.0,
+          denseHMM.Transition()(i, j) + 1.0, 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
 
@@ -0,0 +1,307 @@
+/**
+ * @file indexed_binary_space_tree_test.cpp
+ *
+ * Tests for the IndexedBinarySpaceTree class, and for neighbor search and range
+ * search with it.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/indexed_binary_space_tree.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/range_search/range_search.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::tree;
+using namespace mlpack::bound;
+using namespace mlpack::neighbor;
+using namespace mlpack::range;
+using namespace mlpack::metric;
+
+BOOST_AUTO_TEST_SUITE(IndexedBinarySpaceTreeTest);
+
+typedef IndexedBinarySpaceTree<HRectBound<2> > TreeType;
+typedef BinarySpaceTree<HRectBound<2> > KDTreeType;
+
+/**
+ * Check that the subtree rooted at the given node has the same structure as the
+ * kd-tree built on a copy of the dataset, whose points were rearranged as given
+ * by oldFromNew.
+ */
+void CheckSameTree(const TreeType& node,
+                   const KDTreeType& kdNode,
+                   const std::vector<size_t>& oldFromNew)
+{
+  BOOST_REQUIRE_EQUAL(node.IsLeaf(), kdNode.IsLeaf());
+  BOOST_REQUIRE_EQUAL(node.NumPoints(), kdNode.NumPoints());
+  BOOST_REQUIRE_EQUAL(node.NumDescendants(), kdNode.NumDescendants());
+  BOOST_REQUIRE_EQUAL(node.Bound().Dim(), kdNode.Bound().Dim());
+  for (size_t d = 0; d < node.Bound().Dim(); ++d)
+  {
+    BOOST_REQUIRE_CLOSE(node.Bound()[d].Lo(), kdNode.Bound()[d].Lo(), 1e-5);
+    BOOST_REQUIRE_CLOSE(node.Bound()[d].Hi(), kdNode.Bound()[d].Hi(), 1e-5);
+  }
+  BOOST_REQUIRE_CLOSE(node.FurthestDescendantDistance(),
+      kdNode.FurthestDescendantDistance(), 1e-5);
+
+  for (size_t i = 0; i < node.NumDescendants(); ++i)
+    BOOST_REQUIRE_EQUAL(node.Descendant(i), oldFromNew[kdNode.Descendant(i)]);
+
+  if (node.IsLeaf())
+  {
+    for (size_t i = 0; i < node.NumPoints(); ++i)
+      BOOST_REQUIRE_EQUAL(node.Point(i), oldFromNew[kdNode.Point(i)]);
+    return;
+  }
+
+  BOOST_REQUIRE_EQUAL(node.SplitDimension(), kdNode.SplitDimension());
+  BOOST_REQUIRE_EQUAL(node.Left()->Parent(), &node);
+  BOOST_REQUIRE_EQUAL(node.Right()->Parent(), &node);
+  BOOST_REQUIRE_CLOSE(node.Left()->ParentDistance(),
+      kdNode.Left()->ParentDistance(), 1e-5);
+  BOOST_REQUIRE_CLOSE(node.Right()->ParentDistance(),
+      kdNode.Right()->ParentDistance(), 1e-5);
+
+  CheckSameTree(*node.Left(), *kdNode.Left(), oldFromNew);
+  CheckSameTree(*node.Right(), *kdNode.Right(), oldFromNew);
+}
+
+/**
+ * Check that every leaf of the subtree rooted at the given node holds a copy of
+ * its points, or that no node does.
+ */
+void CheckLocalDataset(const TreeType& node, const bool copyLeafPoints)
+{
+  if (!node.IsLeaf())
+  {
+    BOOST_REQUIRE(node.LocalDataset() == NULL);
+    CheckLocalDataset(*node.Left(), copyLeafPoints);
+    CheckLocalDataset(*node.Right(), copyLeafPoints);
+    return;
+  }
+
+  if (!copyLeafPoints)
+  {
+    BOOST_REQUIRE(node.LocalDataset() == NULL);
+    return;
+  }
+
+  const arma::mat* local = node.LocalDataset();
+  BOOST_REQUIRE(local != NULL);
+  BOOST_REQUIRE_EQUAL(local->n_rows, node.Dataset().n_rows);
+  BOOST_REQUIRE_EQUAL(local->n_cols, node.NumPoints());
+  for (size_t i = 0; i < node.NumPoints(); ++i)
+    for (size_t d = 0; d < local->n_rows; ++d)
+      BOOST_REQUIRE_EQUAL((*local)(d, i), node.Dataset()(d, node.Point(i)));
+}
+
+/**
+ * The tree has the same structure as a kd-tree built on the same points, and
+ * the dataset is not modified.
+ */
+BOOST_AUTO_TEST_CASE(IndexedTreeMatchesKDTreeTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 2000);
+  const arma::mat original(dataset);
+
+  arma::mat kdDataset(dataset);
+  std::vector<size_t> oldFromNew;
+  KDTreeType kdTree(kdDataset, oldFromNew, 10);
+
+  TreeType tree(dataset, 10);
+
+  BOOST_REQUIRE_EQUAL(&tree.Dataset(), &dataset);
+  BOOST_REQUIRE_EQUAL(arma::accu(dataset != original), 0);
+  BOOST_REQUIRE_EQUAL(tree.TreeSize(), kdTree.TreeSize());
+  BOOST_REQUIRE_EQUAL(tree.TreeDepth(), kdTree.TreeDepth());
+
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    BOOST_REQUIRE_EQUAL(tree.Indices()[i], oldFromNew[i]);
+
+  CheckSameTree(tree, kdTree, oldFromNew);
+  CheckLocalDataset(tree, false);
+}
+
+/**
+ * Large datasets are built in parallel (when OpenMP is available), which must
+ * give the same tree.
+ */
+BOOST_AUTO_TEST_CASE(IndexedTreeLargeDatasetTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 30000);
+
+  arma::mat kdDataset(dataset);
+  std::vector<size_t> oldFromNew;
+  KDTreeType kdTree(kdDataset, oldFromNew);
+
+  TreeType tree(dataset);
+
+  CheckSameTree(tree, kdTree, oldFromNew);
+}
+
+/**
+ * The leaves hold copies of their points when asked to.
+ */
+BOOST_AUTO_TEST_CASE(IndexedTreeLeafPointsTest)
+{
+  arma::mat dataset;
+  dataset.randu(12, 1000);
+
+  TreeType tree(dataset, 15, true);
+  CheckLocalDataset(tree, true);
+
+  // Copying a tree copies the leaf points too.
+  TreeType* copy = new TreeType(tree);
+  CheckLocalDataset(*copy, true);
+
+  std::vector<size_t> oldFromNew(tree.Indices());
+  arma::mat kdDataset(dataset);
+  std::vector<size_t> kdOldFromNew;
+  KDTreeType kdTree(kdDataset, kdOldFromNew, 15);
+  BOOST_REQUIRE(oldFromNew == kdOldFromNew);
+
+  delete copy;
+}
+
+/**
+ * A copy of a tree is the same as the original, and does not depend on it.
+ */
+BOOST_AUTO_TEST_CASE(IndexedTreeCopyTest)
+{
+  arma::mat dataset;
+  dataset.randu(4, 500);
+
+  arma::mat kdDataset(dataset);
+  std::vector<size_t> oldFromNew;
+  KDTreeType kdTree(kdDataset, oldFromNew, 5);
+
+  TreeType* tree = new TreeType(dataset, 5);
+  TreeType copy(*tree);
+  BOOST_REQUIRE(&copy.Indices() != &tree->Indices());
+  delete tree;
+
+  BOOST_REQUIRE(copy.Parent() == NULL);
+  CheckSameTree(copy, kdTree, oldFromNew);
+}
+
+/**
+ * Make sure that IndexedKNN gives the same results as naive search, with and
+ * without leaf copies and with every traversal.  The points have enough
+ * dimensions that the leaves are compared with block distances.
+ */
+BOOST_AUTO_TEST_CASE(IndexedKNNTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(10, 1200);
+  arma::mat queryData;
+  queryData.randu(10, 400);
+
+  AllkNN naive(referenceData, queryData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(5, naiveNeighbors, naiveDistances);
+
+  AllkNN naiveMono(referenceData, true);
+  arma::Mat<size_t> naiveMonoNeighbors;
+  arma::mat naiveMonoDistances;
+  naiveMono.Search(5, naiveMonoNeighbors, naiveMonoDistances);
+
+  typedef IndexedBinarySpaceTree<HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > KNNTreeType;
+
+  for (size_t copies = 0; copies < 2; ++copies)
+  {
+    for (size_t single = 0; single < 2; ++single)
+    {
+      KNNTreeType referenceTree(referenceData, 20, copies == 1);
+      KNNTreeType queryTree(queryData, 20, copies == 1);
+
+      arma::Mat<size_t> neighbors;
+      arma::mat distances;
+      if (single == 1)
+      {
+        IndexedKNN knn(&referenceTree, referenceData, true);
+        knn.Search(queryData, 5, neighbors, distances);
+      }
+      else
+      {
+        IndexedKNN knn(&referenceTree, &queryTree, referenceData, queryData);
+        knn.Search(5, neighbors, distances);
+      }
+
+      BOOST_REQUIRE_EQUAL(neighbors.n_rows, naiveNeighbors.n_rows);
+      BOOST_REQUIRE_EQUAL(neighbors.n_cols, naiveNeighbors.n_cols);
+      for (size_t i = 0; i < neighbors.n_elem; ++i)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+        BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+      }
+
+      // Now the monochromatic search.
+      IndexedKNN mono(&referenceTree, referenceData, single == 1);
+      mono.Search(5, neighbors, distances);
+
+      for (size_t i = 0; i < neighbors.n_elem; ++i)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors[i], naiveMonoNeighbors[i]);
+        BOOST_REQUIRE_CLOSE(distances[i], naiveMonoDistances[i], 1e-5);
+      }
+    }
+  }
+
+  // The tree can also be built by NeighborSearch itself.
+  IndexedKNN knn(referenceData, queryData);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  knn.Search(5, neighbors, distances);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Range search with the tree gives the same results as naive search.
+ */
+BOOST_AUTO_TEST_CASE(IndexedRangeSearchTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(9, 800);
+  arma::mat queryData;
+  queryData.randu(9, 200);
+
+  typedef RangeSearch<EuclideanDistance, IndexedBinarySpaceTree<HRectBound<2>,
+      RangeSearchStat> > IndexedRangeSearch;
+
+  const math::Range range(0.5, 0.9);
+
+  RangeSearch<> naive(referenceData, queryData, true);
+  std::vector<std::vector<size_t> > naiveNeighbors;
+  std::vector<std::vector<double> > naiveDistances;
+  naive.Search(range, naiveNeighbors, naiveDistances);
+
+  for (size_t single = 0; single < 2; ++single)
+  {
+    IndexedRangeSearch rs(referenceData, queryData, false, single == 1);
+    std::vector<std::vector<size_t> > neighbors;
+    std::vector<std::vector<double> > distances;
+    rs.Search(range, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.size(), naiveNeighbors.size());
+    for (size_t i = 0; i < neighbors.size(); ++i)
+    {
+      std::vector<size_t> sorted(neighbors[i]);
+      std::vector<size_t> naiveSorted(naiveNeighbors[i]);
+      std::sort(sorted.begin(), sorted.end());
+      std::sort(naiveSorted.begin(), naiveSorted.end());
+      BOOST_REQUIRE(sorted == naiveSorted);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
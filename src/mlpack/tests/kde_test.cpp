@@ -0,0 +1,169 @@
+/**
+ * @file kde_test.cpp
+ *
+ * Test file for the KDE<> class.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/epanechnikov_kernel.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/triangular_kernel.hpp>
+#include <mlpack/methods/kde/kde.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::kde;
+using namespace mlpack::kernel;
+using namespace mlpack::metric;
+using namespace mlpack::tree;
+
+BOOST_AUTO_TEST_SUITE(KDETest);
+
+/**
+ * Compute the estimates by brute force, for comparison.
+ */
+template<typename KernelType>
+void BruteForceKDE(const arma::mat& referenceSet,
+                   const arma::mat& querySet,
+                   KernelType& kernel,
+                   arma::vec& estimates)
+{
+  estimates.zeros(querySet.n_cols);
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+    for (size_t j = 0; j < referenceSet.n_cols; ++j)
+      estimates[i] += kernel.Evaluate(EuclideanDistance::Evaluate(
+          querySet.unsafe_col(i), referenceSet.unsafe_col(j)));
+
+  estimates /= referenceSet.n_cols;
+}
+
+/**
+ * With no error tolerance, the dual-tree and single-tree estimates must be the
+ * same as the brute-force estimates, even though nodes outside the support of
+ * the kernel are pruned.
+ */
+BOOST_AUTO_TEST_CASE(ExactKDETest)
+{
+  arma::mat referenceSet(3, 500);
+  referenceSet.randu();
+  arma::mat querySet(3, 300);
+  querySet.randu();
+
+  EpanechnikovKernel kernel(0.3);
+  arma::vec trueEstimates;
+  BruteForceKDE(referenceSet, querySet, kernel, trueEstimates);
+
+  typedef KDE<EpanechnikovKernel> KDEType;
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    KDEType kde(referenceSet, kernel, 0.0, 0.0, (mode == 0), (mode == 1));
+
+    arma::vec estimates;
+    kde.Evaluate(querySet, estimates);
+
+    BOOST_REQUIRE_EQUAL(estimates.n_elem, querySet.n_cols);
+    for (size_t i = 0; i < estimates.n_elem; ++i)
+    {
+      if (trueEstimates[i] == 0.0)
+        BOOST_REQUIRE_SMALL(estimates[i], 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(estimates[i], trueEstimates[i], 1e-7);
+    }
+
+    // The trees should have pruned something.
+    if (mode != 0)
+      BOOST_REQUIRE_GT(kde.Statistics().Prunes(), 0);
+  }
+}
+
+/**
+ * Make sure that the relative error tolerance is respected, for the dual-tree
+ * and single-tree estimates.
+ */
+BOOST_AUTO_TEST_CASE(RelativeErrorKDETest)
+{
+  arma::mat referenceSet(2, 1000);
+  referenceSet.randn();
+  arma::mat querySet(2, 500);
+  querySet.randn();
+
+  GaussianKernel kernel(0.4);
+  arma::vec trueEstimates;
+  BruteForceKDE(referenceSet, querySet, kernel, trueEstimates);
+
+  const double relError = 0.05;
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    KDE<> kde(referenceSet, kernel, relError, 0.0, false, (mode == 1));
+
+    arma::vec estimates;
+    kde.Evaluate(querySet, estimates);
+
+    BOOST_REQUIRE_EQUAL(estimates.n_elem, querySet.n_cols);
+    for (size_t i = 0; i < estimates.n_elem; ++i)
+      BOOST_REQUIRE_LE(fabs(estimates[i] - trueEstimates[i]),
+          relError * trueEstimates[i] + 1e-12);
+
+    BOOST_REQUIRE_GT(kde.Statistics().Prunes(), 0);
+  }
+}
+
+/**
+ * Make sure that the absolute error tolerance is respected.
+ */
+BOOST_AUTO_TEST_CASE(AbsoluteErrorKDETest)
+{
+  arma::mat referenceSet(3, 800);
+  referenceSet.randu();
+  arma::mat querySet(3, 400);
+  querySet.randu();
+
+  TriangularKernel kernel(0.5);
+  arma::vec trueEstimates;
+  BruteForceKDE(referenceSet, querySet, kernel, trueEstimates);
+
+  const double absError = 0.01;
+  KDE<TriangularKernel> kde(referenceSet, kernel, 0.0, absError);
+
+  arma::vec estimates;
+  kde.Evaluate(querySet, estimates);
+
+  for (size_t i = 0; i < estimates.n_elem; ++i)
+    BOOST_REQUIRE_LE(fabs(estimates[i] - trueEstimates[i]), absError + 1e-12);
+}
+
+/**
+ * Estimate the density at each reference point by giving the reference tree as
+ * the query tree, twice (so any statistics left over from the first evaluation
+ * would show up in the second).
+ */
+BOOST_AUTO_TEST_CASE(MonochromaticTreeKDETest)
+{
+  arma::mat dataset(4, 600);
+  dataset.randu();
+
+  typedef BinarySpaceTree<bound::HRectBound<2>, KDEStat> TreeType;
+  arma::mat treeDataset(dataset);
+  std::vector<size_t> oldFromNew;
+  TreeType tree(treeDataset, oldFromNew);
+
+  GaussianKernel kernel(0.25);
+  arma::vec trueEstimates;
+  BruteForceKDE(dataset, dataset, kernel, trueEstimates);
+
+  const double relError = 0.01;
+  KDE<> kde(&tree, treeDataset, kernel, relError);
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    arma::vec estimates;
+    kde.Evaluate(&tree, estimates);
+
+    BOOST_REQUIRE_EQUAL(estimates.n_elem, dataset.n_cols);
+    for (size_t i = 0; i < estimates.n_elem; ++i)
+      BOOST_REQUIRE_LE(fabs(estimates[i] - trueEstimates[oldFromNew[i]]),
+          relError * trueEstimates[oldFromNew[i]] + 1e-12);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -7,6 +7,8 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
 #include <mlpack/methods/kernel_pca/kernel_rules/nystroem_method.hpp>
+#include <mlpack/methods/kernel_pca/kernel_rules/matrix_free_method.hpp>
+#include <mlpack/methods/kernel_pca/kernel_rules/random_features_method.hpp>
 #include <mlpack/methods/kernel_pca/kernel_pca.hpp>
 
 #include <boost/test/unit_test.hpp>
@@ -145,4 +147,178 @@ BOOST_AUTO_TEST_CASE(CircleTransformationTestNystroem)
   BOOST_REQUIRE_EQUAL(ranges[1].Contains(ranges[2]), false);
 }
 
+/**
+ * Make sure that the matrix-free kernel rule finds the same leading components
+ * as the naive kernel rule (up to sign), with more points than one block.
+ */
+BOOST_AUTO_TEST_CASE(MatrixFreeKernelRuleTest)
+{
+  // The scales of the dimensions are different, so the leading eigenvalues are
+  // well separated.
+  arma::mat dataset;
+  dataset.randn(3, 700);
+  dataset.row(0) *= 4.0;
+  dataset.row(1) *= 2.0;
+
+  GaussianKernel kernel(10.0);
+  arma::mat naiveData, matrixFreeData, naiveVectors, matrixFreeVectors;
+  arma::vec naiveValues, matrixFreeValues;
+
+  // Take all of the components from the naive rule, so they are exact.
+  NaiveKernelRule<GaussianKernel>::ApplyKernelMatrix(dataset, naiveData,
+      naiveValues, naiveVectors, dataset.n_cols, kernel);
+  MatrixFreeKernelRule<GaussianKernel, 100, 256>::ApplyKernelMatrix(dataset,
+      matrixFreeData, matrixFreeValues, matrixFreeVectors, 3, kernel);
+
+  BOOST_REQUIRE_EQUAL(matrixFreeValues.n_elem, 3);
+  BOOST_REQUIRE_EQUAL(matrixFreeData.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(matrixFreeData.n_cols, 700);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(matrixFreeValues[i], naiveValues[i], 1e-2);
+
+    const double sign = (arma::dot(matrixFreeData.row(i),
+        naiveData.row(i)) < 0) ? -1.0 : 1.0;
+    BOOST_REQUIRE_SMALL(arma::norm(sign * matrixFreeData.row(i) -
+        naiveData.row(i), 2) / arma::norm(naiveData.row(i), 2), 1e-2);
+  }
+}
+
+/**
+ * Make sure that the dot products of random Fourier features approximate the
+ * Gaussian and Laplacian kernels.
+ */
+BOOST_AUTO_TEST_CASE(RandomFourierFeaturesTest)
+{
+  arma::mat dataset;
+  dataset.randn(3, 50);
+
+  GaussianKernel gk(1.5);
+  LaplacianKernel lk(2.0);
+  RandomFourierFeatures<GaussianKernel> gaussianMap(gk, 3, 20000);
+  RandomFourierFeatures<LaplacianKernel> laplacianMap(lk, 3, 20000);
+
+  arma::mat gaussianFeatures, laplacianFeatures;
+  gaussianMap.Map(dataset, gaussianFeatures);
+  laplacianMap.Map(dataset, laplacianFeatures);
+
+  BOOST_REQUIRE_EQUAL(gaussianFeatures.n_rows, 20000);
+  BOOST_REQUIRE_EQUAL(gaussianFeatures.n_cols, 50);
+
+  // The error of each approximation is about 1 / sqrt(20000) = 0.007.
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+    {
+      BOOST_REQUIRE_SMALL(arma::dot(gaussianFeatures.col(i),
+          gaussianFeatures.col(j)) - gk.Evaluate(dataset.col(i),
+          dataset.col(j)), 0.05);
+      BOOST_REQUIRE_SMALL(arma::dot(laplacianFeatures.col(i),
+          laplacianFeatures.col(j)) - lk.Evaluate(dataset.col(i),
+          dataset.col(j)), 0.05);
+    }
+  }
+}
+
+/**
+ * Make sure that the random features kernel rule gives components of the right
+ * size, whose eigenvalues approximate those of the naive kernel rule.
+ */
+BOOST_AUTO_TEST_CASE(RandomFeaturesKernelRuleTest)
+{
+  arma::mat dataset;
+  dataset.randn(3, 300);
+  dataset.row(0) *= 4.0;
+  dataset.row(1) *= 2.0;
+
+  GaussianKernel kernel(3.0);
+  arma::mat naiveData, randomData, naiveVectors, randomVectors;
+  arma::vec naiveValues, randomValues;
+
+  NaiveKernelRule<GaussianKernel>::ApplyKernelMatrix(dataset, naiveData,
+      naiveValues, naiveVectors, dataset.n_cols, kernel);
+  RandomFeaturesKernelRule<GaussianKernel, 4096>::ApplyKernelMatrix(dataset,
+      randomData, randomValues, randomVectors, 2, kernel);
+
+  BOOST_REQUIRE_EQUAL(randomValues.n_elem, 2);
+  BOOST_REQUIRE_EQUAL(randomData.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(randomData.n_cols, 300);
+  BOOST_REQUIRE_EQUAL(randomVectors.n_rows, 300);
+  BOOST_REQUIRE_EQUAL(randomVectors.n_cols, 2);
+
+  BOOST_REQUIRE_GE(randomValues[0], randomValues[1]);
+  for (size_t i = 0; i < 2; ++i)
+    BOOST_REQUIRE_CLOSE(randomValues[i], naiveValues[i], 10.0);
+}
+
+/**
+ * Make sure that a model fit with Train() projects the training points as
+ * Apply() transforms them, with and without centering.  The dataset is small
+ * enough for both to use the full eigendecomposition.
+ */
+BOOST_AUTO_TEST_CASE(KernelPCATransformTest)
+{
+  arma::mat dataset;
+  dataset.randn(3, 40);
+  dataset.row(0) *= 4.0;
+  dataset.row(1) *= 2.0;
+
+  for (size_t center = 0; center < 2; ++center)
+  {
+    KernelPCA<GaussianKernel> kpca(GaussianKernel(2.0), center == 1);
+
+    arma::mat applied, vectors;
+    arma::vec values;
+    kpca.Apply(dataset, applied, values, vectors, 3);
+
+    kpca.Train(dataset, 3);
+    BOOST_REQUIRE_EQUAL(kpca.Projection().n_cols, 3);
+    BOOST_REQUIRE_EQUAL(kpca.TrainingData().n_cols, 40);
+
+    arma::mat transformed;
+    kpca.Transform(dataset, transformed);
+    BOOST_REQUIRE_EQUAL(transformed.n_rows, 3);
+    BOOST_REQUIRE_EQUAL(transformed.n_cols, 40);
+
+    const arma::mat expected = applied.rows(0, 2);
+    BOOST_REQUIRE_SMALL(arma::norm(transformed - expected, "fro") /
+        arma::norm(expected, "fro"), 1e-8);
+  }
+}
+
+/**
+ * Make sure that a fitted model gives the same projections of new points after
+ * it is saved and loaded.
+ */
+BOOST_AUTO_TEST_CASE(KernelPCASaveLoadTest)
+{
+  arma::mat dataset, newPoints;
+  dataset.randn(3, 100);
+  newPoints.randn(3, 30);
+
+  KernelPCA<GaussianKernel> kpca(GaussianKernel(2.0), true);
+  kpca.Train(dataset, 4);
+
+  arma::mat transformed;
+  kpca.Transform(newPoints, transformed);
+
+  util::SaveRestoreUtility sr;
+  kpca.Save(sr);
+  BOOST_REQUIRE(sr.WriteFile("kernel_pca_model.bin"));
+
+  util::SaveRestoreUtility loadedSr;
+  BOOST_REQUIRE(loadedSr.ReadFile("kernel_pca_model.bin"));
+  remove("kernel_pca_model.bin");
+
+  KernelPCA<GaussianKernel> loaded(GaussianKernel(2.0));
+  loaded.Load(loadedSr);
+  BOOST_REQUIRE_EQUAL(loaded.CenterTransformedData(), true);
+
+  arma::mat loadedTransformed;
+  loaded.Transform(newPoints, loadedTransformed);
+  BOOST_REQUIRE_SMALL(arma::norm(loadedTransformed - transformed, "fro") /
+      arma::norm(transformed, "fro"), 1e-10);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
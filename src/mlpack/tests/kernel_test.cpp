@@ -5,6 +5,8 @@
  *
  * Tests for the various kernel classes.
  */
+#include <mlpack/core/kernels/block_kernels.hpp>
+#include <mlpack/core/kernels/cached_kernel.hpp>
 #include <mlpack/core/kernels/cosine_distance.hpp>
 #include <mlpack/core/kernels/epanechnikov_kernel.hpp>
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
@@ -15,6 +17,7 @@
 #include <mlpack/core/kernels/polynomial_kernel.hpp>
 #include <mlpack/core/kernels/spherical_kernel.hpp>
 #include <mlpack/core/kernels/pspectrum_string_kernel.hpp>
+#include <mlpack/core/kernels/triangular_kernel.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/metrics/mahalanobis_distance.hpp>
 
@@ -107,6 +110,41 @@ BOOST_AUTO_TEST_CASE(lmetric_zeros)
   BOOST_REQUIRE((LMetric<5, true>::Evaluate(a, a)) == 0);
 }
 
+/**
+ * Make sure the L-metrics give the same results for sparse points as for the
+ * equivalent dense points, including when only one point is nonzero in some
+ * dimension.
+ */
+BOOST_AUTO_TEST_CASE(sparse_lmetric)
+{
+  arma::sp_mat data;
+  data.sprandu(100, 20, 0.1);
+  data.col(3).zeros();
+  const arma::mat dense(data);
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t j = 0; j < data.n_cols; ++j)
+    {
+      BOOST_REQUIRE_CLOSE((LMetric<1, false>::Evaluate(data.col(i),
+          data.col(j))), (LMetric<1, false>::Evaluate(dense.col(i),
+          dense.col(j))), 1e-5);
+      BOOST_REQUIRE_CLOSE((LMetric<2, false>::Evaluate(data.col(i),
+          data.col(j))), (LMetric<2, false>::Evaluate(dense.col(i),
+          dense.col(j))), 1e-5);
+      BOOST_REQUIRE_CLOSE((LMetric<2, true>::Evaluate(data.col(i),
+          data.col(j))), (LMetric<2, true>::Evaluate(dense.col(i),
+          dense.col(j))), 1e-5);
+      BOOST_REQUIRE_CLOSE((LMetric<3, true>::Evaluate(data.col(i),
+          data.col(j))), (LMetric<3, true>::Evaluate(dense.col(i),
+          dense.col(j))), 1e-5);
+      BOOST_REQUIRE_CLOSE((LMetric<INT_MAX, false>::Evaluate(data.col(i),
+          data.col(j))), (LMetric<INT_MAX, false>::Evaluate(dense.col(i),
+          dense.col(j))), 1e-5);
+    }
+  }
+}
+
 /**
  * Simple test of Mahalanobis distance with unset covariance matrix in
  * constructor.
@@ -203,6 +241,40 @@ BOOST_AUTO_TEST_CASE(md_full_covariance)
   BOOST_REQUIRE_CLOSE(md.Evaluate(b, a), 15.7, 1e-5);
 }
 
+/**
+ * Make sure the whitening transformation of a Mahalanobis distance turns it
+ * into the Euclidean distance, for a positive definite covariance matrix (which
+ * is factored with a Cholesky decomposition) and for a singular one (which is
+ * not).
+ */
+BOOST_AUTO_TEST_CASE(md_whitening)
+{
+  arma::mat factor;
+  factor.randn(5, 5);
+  arma::mat singularFactor;
+  singularFactor.randn(2, 5);
+
+  arma::mat data;
+  data.randn(5, 20);
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    const arma::mat cov = (trial == 0) ? arma::mat(trans(factor) * factor +
+        arma::eye<arma::mat>(5, 5)) : arma::mat(trans(singularFactor) *
+        singularFactor);
+    MahalanobisDistance<false> md(cov);
+
+    arma::mat transformation;
+    md.Whitening(transformation);
+    const arma::mat whitened = transformation * data;
+
+    for (size_t i = 1; i < data.n_cols; ++i)
+      BOOST_REQUIRE_CLOSE(md.Evaluate(data.col(0), data.col(i)),
+          SquaredEuclideanDistance::Evaluate(whitened.col(0),
+          whitened.col(i)), 1e-5);
+  }
+}
+
 /**
  * Simple test case for the cosine distance.
  */
@@ -346,6 +418,27 @@ BOOST_AUTO_TEST_CASE(epanechnikov_kernel)
   BOOST_REQUIRE_CLOSE(ek.ConvolutionIntegral(b,c), 1.5263455690698258, 1e-5);
 }
 
+BOOST_AUTO_TEST_CASE(triangular_kernel)
+{
+  arma::vec a = "1.0 0.0";
+  arma::vec b = "0.0 1.0";
+  arma::vec c = "0.1 0.9";
+
+  TriangularKernel tk(.5);
+  BOOST_REQUIRE_CLOSE(tk.Evaluate(a, b), 0.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(tk.Evaluate(b, c), 0.71715728752538097, 1e-5);
+  BOOST_REQUIRE_CLOSE(tk.Evaluate(a, c), 0.0, 1e-5);
+  /* check the single dimension evaluate function */
+  BOOST_REQUIRE_CLOSE(tk.Evaluate(0.10), 0.8, 1e-5);
+  BOOST_REQUIRE_CLOSE(tk.Evaluate(0.25), 0.5, 1e-5);
+  BOOST_REQUIRE_CLOSE(tk.Evaluate(0.50), 0.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(tk.Evaluate(1.00), 0.0, 1e-5);
+  /* check the normalization constant */
+  BOOST_REQUIRE_CLOSE(tk.Normalizer(1), 0.5, 1e-5);
+  BOOST_REQUIRE_CLOSE(tk.Normalizer(2), 0.26179938779914941, 1e-5);
+  BOOST_REQUIRE_CLOSE(tk.Normalizer(3), 0.13089969389957471, 1e-5);
+}
+
 BOOST_AUTO_TEST_CASE(polynomial_kernel)
 {
   arma::vec a = "0 0 1";
@@ -402,135 +495,135 @@ BOOST_AUTO_TEST_CASE(PSpectrumSubstringExtractionTest)
   PSpectrumStringKernel p(datasets, 3);
 
   // Ensure the sizes are correct.
-  BOOST_REQUIRE_EQUAL(p.Counts().size(), 2);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0].size(), 4);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1].size(), 7);
+  BOOST_REQUIRE_EQUAL(p.Datasets(), 2);
+  BOOST_REQUIRE_EQUAL(p.Strings(0), 4);
+  BOOST_REQUIRE_EQUAL(p.Strings(1), 7);
 
   // herpgle: her, erp, rpg, pgl, gle
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0].size(), 5);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["her"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["erp"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["rpg"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["pgl"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["gle"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(0, 0), 5);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "her"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "erp"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "rpg"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "pgl"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "gle"), 1);
 
   // herpagkle: her, erp, rpa, pag, agk, gkl, kle
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1].size(), 7);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["her"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["erp"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["rpa"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["pag"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["agk"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["gkl"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["kle"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(0, 1), 7);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "her"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "erp"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "rpa"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "pag"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "agk"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "gkl"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "kle"), 1);
 
   // klunktor: klu, lun, unk, nkt, kto, tor
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2].size(), 6);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["klu"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["lun"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["unk"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["nkt"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["kto"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["tor"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(0, 2), 6);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "klu"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "lun"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "unk"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "nkt"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "kto"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "tor"), 1);
 
   // flibbynopple: fli lib ibb bby byn yno nop opp ppl ple
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3].size(), 10);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["fli"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["lib"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["ibb"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["bby"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["byn"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["yno"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["nop"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["opp"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["ppl"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["ple"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(0, 3), 10);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "fli"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "lib"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "ibb"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "bby"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "byn"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "yno"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "nop"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "opp"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "ppl"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "ple"), 1);
 
   // floggy3245: flo log ogg ggy gy3 y32 324 245
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0].size(), 8);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["flo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["log"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["ogg"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["ggy"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["gy3"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["y32"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["324"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["245"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(1, 0), 8);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "flo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "log"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "ogg"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "ggy"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "gy3"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "y32"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "324"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "245"), 1);
 
   // flippydopflip: fli lip ipp ppy pyd ydo dop opf pfl fli lip
   // fli(2) lip(2) ipp ppy pyd ydo dop opf pfl
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1].size(), 9);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["fli"], 2);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["lip"], 2);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["ipp"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["ppy"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["pyd"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["ydo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["dop"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["opf"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["pfl"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(1, 1), 9);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "fli"), 2);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "lip"), 2);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "ipp"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "ppy"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "pyd"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "ydo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "dop"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "opf"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "pfl"), 1);
 
   // stupid fricking cat: stu tup upi pid fri ric ick cki kin ing cat
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2].size(), 11);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["stu"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["tup"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["upi"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["pid"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["fri"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["ric"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["ick"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["cki"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["kin"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["ing"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["cat"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(1, 2), 11);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "stu"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "tup"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "upi"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "pid"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "fri"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "ric"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "ick"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "cki"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "kin"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "ing"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "cat"), 1);
 
   // food time isn't until later: foo ood tim ime isn unt nti til lat ate ter
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3].size(), 11);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["foo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["ood"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["tim"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["ime"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["isn"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["unt"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["nti"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["til"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["lat"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["ate"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["ter"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(1, 3), 11);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "foo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "ood"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "tim"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "ime"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "isn"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "unt"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "nti"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "til"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "lat"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "ate"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "ter"), 1);
 
   // leave me alone until 6:00: lea eav ave alo lon one unt nti til
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4].size(), 9);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["lea"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["eav"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["ave"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["alo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["lon"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["one"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["unt"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["nti"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["til"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(1, 4), 9);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "lea"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "eav"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "ave"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "alo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "lon"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "one"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "unt"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "nti"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "til"), 1);
 
   // only after that do you get any food.:
   // onl nly aft fte ter tha hat you get any foo ood
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5].size(), 12);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["onl"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["nly"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["aft"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["fte"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["ter"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["tha"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["hat"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["you"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["get"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["any"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["foo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["ood"], 1);
+  BOOST_REQUIRE_EQUAL(p.Substrings(1, 5), 12);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "onl"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "nly"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "aft"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "fte"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "ter"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "tha"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "hat"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "you"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "get"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "any"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "foo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "ood"), 1);
 
   // obloblobloblobloblobloblob: obl(8) blo(8) lob(8)
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][6].size(), 3);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][6]["obl"], 8);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][6]["blo"], 8);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][6]["lob"], 8);
+  BOOST_REQUIRE_EQUAL(p.Substrings(1, 6), 3);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 6, "obl"), 8);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 6, "blo"), 8);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 6, "lob"), 8);
 }
 
 BOOST_AUTO_TEST_CASE(PSpectrumStringEvaluateTest)
@@ -588,6 +681,237 @@ BOOST_AUTO_TEST_CASE(PSpectrumStringEvaluateTest)
   a = "0 3";
   BOOST_REQUIRE_CLOSE(p.Evaluate(a, b), 11.0, 1e-5);
   BOOST_REQUIRE_CLOSE(p.Evaluate(b, a), 11.0, 1e-5);
+
+  // Evaluate a whole row at once.
+  arma::mat strings("0 0 0 0; 0 1 2 3");
+  arma::vec row;
+  a = "0 1";
+  p.Evaluate(a, strings, row);
+  BOOST_REQUIRE_EQUAL(row.n_elem, 4);
+  BOOST_REQUIRE_CLOSE(row[0], 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(row[1], 3.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(row[2], 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(row[3], 5.0, 1e-5);
+
+  // And the whole kernel matrix.
+  arma::mat kernels;
+  BOOST_REQUIRE(BlockKernels(p, strings, strings, kernels));
+  for (size_t i = 0; i < 4; ++i)
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_CLOSE(kernels(i, j),
+          p.Evaluate(strings.unsafe_col(i), strings.unsafe_col(j)), 1e-5);
+}
+
+/**
+ * Substrings longer than 12 characters do not fit into integer codes, so they
+ * are kept as strings; make sure they are still counted correctly, along with
+ * case and characters that are not alphanumeric.
+ */
+BOOST_AUTO_TEST_CASE(PSpectrumStringLongSubstringTest)
+{
+  std::vector<std::vector<std::string> > dataset(1);
+  dataset[0].push_back("abcdefghijklmnopqrstuvwxyz0123456789");
+  dataset[0].push_back("ABCDEFGHIJKLMNOP qrstuvwxyz0123456789");
+  dataset[0].push_back("zyxwvutsrqponmlkjihgfedcba");
+
+  PSpectrumStringKernel p(dataset, 15);
+
+  BOOST_REQUIRE_EQUAL(p.Substrings(0, 0), 22);
+  BOOST_REQUIRE_EQUAL(p.Substrings(0, 1), 8);
+  BOOST_REQUIRE_EQUAL(p.Substrings(0, 2), 12);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "ABCDEFGHIJKLMNO"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "bcdefghijklmnop"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "cdefghijklmnop "), 0);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "abcdefghijklmno"), 0);
+
+  // The second string shares all eight of its substrings with the first.
+  arma::vec a("0 0");
+  arma::vec b("0 1");
+  BOOST_REQUIRE_CLOSE(p.Evaluate(a, b), 8.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(p.Evaluate(a, a), 22.0, 1e-5);
+  b = "0 2";
+  BOOST_REQUIRE_SMALL(p.Evaluate(a, b), 1e-5);
+}
+
+/**
+ * Substrings of more than 32 characters that differ only in their first
+ * characters must not be counted as the same substring (base 36 codes wrapped
+ * modulo 2^64 would lose those characters).
+ */
+BOOST_AUTO_TEST_CASE(PSpectrumStringVeryLongSubstringTest)
+{
+  const std::string tail(39, 'q');
+  std::vector<std::vector<std::string> > dataset(1);
+  dataset[0].push_back("a" + tail);
+  dataset[0].push_back("b" + tail);
+  dataset[0].push_back("A" + tail);
+  dataset[0].push_back("ab" + tail.substr(1));
+
+  PSpectrumStringKernel p(dataset, 40);
+
+  for (size_t i = 0; i < 4; ++i)
+    BOOST_REQUIRE_EQUAL(p.Substrings(0, i), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "a" + tail), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "b" + tail), 0);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "B" + tail), 1);
+
+  arma::vec a("0 0");
+  arma::vec b("0 1");
+  BOOST_REQUIRE_SMALL(p.Evaluate(a, b), 1e-5);
+  b = "0 3";
+  BOOST_REQUIRE_SMALL(p.Evaluate(a, b), 1e-5);
+  b = "0 2";
+  BOOST_REQUIRE_CLOSE(p.Evaluate(a, b), 1.0, 1e-5); // Case is ignored.
+  BOOST_REQUIRE_CLOSE(p.Evaluate(a, a), 1.0, 1e-5);
+
+  const std::vector<std::vector<std::map<std::string, int> > > counts =
+      p.Counts();
+  BOOST_REQUIRE_EQUAL(counts[0][1].size(), 1);
+  BOOST_REQUIRE_EQUAL(counts[0][1].find("b" + tail)->second, 1);
+}
+
+/**
+ * Make sure that Counts() gives the same counts as Count(), with the
+ * substrings lowercased.
+ */
+BOOST_AUTO_TEST_CASE(PSpectrumStringCountsTest)
+{
+  std::vector<std::vector<std::string> > dataset(1);
+  dataset[0].push_back("Hello, hello world");
+  dataset[0].push_back("9lives");
+
+  PSpectrumStringKernel p(dataset, 3);
+  const std::vector<std::vector<std::map<std::string, int> > > counts =
+      p.Counts();
+
+  BOOST_REQUIRE_EQUAL(counts.size(), 1);
+  BOOST_REQUIRE_EQUAL(counts[0].size(), 2);
+  for (size_t i = 0; i < 2; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(counts[0][i].size(), p.Substrings(0, i));
+    for (std::map<std::string, int>::const_iterator it = counts[0][i].begin();
+        it != counts[0][i].end(); ++it)
+      BOOST_REQUIRE_EQUAL(it->second, (int) p.Count(0, i, it->first));
+  }
+
+  BOOST_REQUIRE_EQUAL(counts[0][0].find("hel")->second, 2);
+  BOOST_REQUIRE_EQUAL(counts[0][1].find("9li")->second, 1);
+}
+
+/**
+ * Make sure the block evaluations match the pairwise evaluations, and that
+ * kernels without a block evaluation are left to the caller.
+ */
+BOOST_AUTO_TEST_CASE(BlockKernelsTest)
+{
+  arma::mat a(4, 10, arma::fill::randn);
+  arma::mat b(4, 15, arma::fill::randn);
+  b.col(3).zeros(); // Zero norm, for the cosine similarity.
+
+  LinearKernel lk;
+  PolynomialKernel pk(3.0, 1.5);
+  CosineDistance cd;
+
+  arma::mat linearKernels, polynomialKernels, cosineKernels;
+  BOOST_REQUIRE(BlockKernels(lk, a, b, linearKernels));
+  BOOST_REQUIRE(BlockKernels(pk, a.cols(2, 7), b, polynomialKernels));
+  BOOST_REQUIRE(BlockKernels(cd, a, b, cosineKernels));
+
+  BOOST_REQUIRE_EQUAL(linearKernels.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(linearKernels.n_cols, 15);
+  BOOST_REQUIRE_EQUAL(polynomialKernels.n_rows, 6);
+  BOOST_REQUIRE_EQUAL(polynomialKernels.n_cols, 15);
+
+  for (size_t j = 0; j < b.n_cols; ++j)
+  {
+    for (size_t i = 0; i < a.n_cols; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(linearKernels(i, j),
+          lk.Evaluate(a.unsafe_col(i), b.unsafe_col(j)), 1e-5);
+      if (j == 3)
+        BOOST_REQUIRE_SMALL(cosineKernels(i, j), 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(cosineKernels(i, j),
+            cd.Evaluate(a.unsafe_col(i), b.unsafe_col(j)), 1e-5);
+    }
+
+    for (size_t i = 2; i < 8; ++i)
+      BOOST_REQUIRE_CLOSE(polynomialKernels(i - 2, j),
+          pk.Evaluate(a.unsafe_col(i), b.unsafe_col(j)), 1e-5);
+  }
+
+  GaussianKernel gk;
+  arma::mat gaussianKernels;
+  BOOST_REQUIRE(!BlockKernels(gk, a, b, gaussianKernels));
+}
+
+/**
+ * Make sure the cached kernel gives the same evaluations as the kernel it
+ * wraps, answers repeated evaluations from the cache (in either order, and for
+ * self-kernels), and passes vectors outside the cached datasets through.
+ */
+BOOST_AUTO_TEST_CASE(CachedKernelTest)
+{
+  arma::mat a(3, 20, arma::fill::randn);
+  arma::mat b(3, 30, arma::fill::randn);
+
+  GaussianKernel gk(1.5);
+  // Room for only five rows, so rows are dropped while evaluating.
+  CachedKernel<GaussianKernel> ck(gk, 5 * b.n_cols * sizeof(double));
+  ck.Cache(a, b);
+
+  for (size_t pass = 0; pass < 2; ++pass)
+    for (size_t i = 0; i < a.n_cols; ++i)
+      for (size_t j = 0; j < b.n_cols; ++j)
+        BOOST_REQUIRE_CLOSE(ck.Evaluate(a.unsafe_col(i), b.unsafe_col(j)),
+            gk.Evaluate(a.unsafe_col(i), b.unsafe_col(j)), 1e-5);
+
+  // Row by row, each evaluation is computed once per pass.
+  const size_t misses = ck.Misses();
+  BOOST_REQUIRE_EQUAL(ck.Hits(), 0);
+  BOOST_REQUIRE_EQUAL(misses, 2 * a.n_cols * b.n_cols);
+
+  // The same row again, in the other order; it is the most recent row.
+  for (size_t j = 0; j < b.n_cols; ++j)
+    BOOST_REQUIRE_CLOSE(ck.Evaluate(b.col(j), a.col(a.n_cols - 1)),
+        gk.Evaluate(b.col(j), a.col(a.n_cols - 1)), 1e-5);
+  BOOST_REQUIRE_EQUAL(ck.Hits(), b.n_cols);
+  BOOST_REQUIRE_EQUAL(ck.Misses(), misses);
+
+  // Self-kernels do not touch the rows.
+  BOOST_REQUIRE_CLOSE(ck.Evaluate(a.unsafe_col(3), a.unsafe_col(3)), 1.0,
+      1e-5);
+  BOOST_REQUIRE_CLOSE(ck.Evaluate(b.unsafe_col(7), b.unsafe_col(7)), 1.0,
+      1e-5);
+
+  // Vectors that are not points of the cached datasets.
+  arma::vec x = a.col(2);
+  BOOST_REQUIRE_CLOSE(ck.Evaluate(x, b.unsafe_col(4)),
+      gk.Evaluate(a.unsafe_col(2), b.unsafe_col(4)), 1e-5);
+  BOOST_REQUIRE_CLOSE(ck.Evaluate(a.unsafe_col(2), a.unsafe_col(5)),
+      gk.Evaluate(a.unsafe_col(2), a.unsafe_col(5)), 1e-5);
+  BOOST_REQUIRE_EQUAL(ck.Misses(), misses);
+
+  // With a single dataset, K(x, y) found in the row of y is a hit.
+  ck.Cache(a);
+  BOOST_REQUIRE_CLOSE(ck.Evaluate(a.unsafe_col(1), a.unsafe_col(6)),
+      gk.Evaluate(a.unsafe_col(1), a.unsafe_col(6)), 1e-5);
+  BOOST_REQUIRE_CLOSE(ck.Evaluate(a.unsafe_col(6), a.unsafe_col(1)),
+      gk.Evaluate(a.unsafe_col(6), a.unsafe_col(1)), 1e-5);
+  BOOST_REQUIRE_EQUAL(ck.Hits(), 1);
+  BOOST_REQUIRE_EQUAL(ck.Misses(), 1);
+
+  // Evaluations from many threads at once.
+  arma::mat kernels(a.n_cols, a.n_cols);
+  #pragma omp parallel for
+  for (size_t i = 0; i < a.n_cols; ++i)
+    for (size_t j = 0; j < a.n_cols; ++j)
+      kernels(i, j) = ck.Evaluate(a.col(i), a.col(j));
+
+  for (size_t i = 0; i < a.n_cols; ++i)
+    for (size_t j = 0; j < a.n_cols; ++j)
+      BOOST_REQUIRE_CLOSE(kernels(i, j),
+          gk.Evaluate(a.unsafe_col(i), a.unsafe_col(j)), 1e-5);
 }
 
 BOOST_AUTO_TEST_SUITE_END();
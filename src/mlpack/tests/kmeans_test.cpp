@@ -7,13 +7,20 @@
 #include <mlpack/methods/kmeans/kmeans.hpp>
 #include <mlpack/methods/kmeans/allow_empty_clusters.hpp>
 #include <mlpack/methods/kmeans/refined_start.hpp>
+#include <mlpack/methods/kmeans/kmeans_plus_plus.hpp>
+#include <mlpack/methods/kmeans/kmeans_parallel.hpp>
 #include <mlpack/methods/kmeans/elkan_kmeans.hpp>
 #include <mlpack/methods/kmeans/hamerly_kmeans.hpp>
+#include <mlpack/methods/kmeans/yinyang_kmeans.hpp>
 #include <mlpack/methods/kmeans/pelleg_moore_kmeans.hpp>
 #include <mlpack/methods/kmeans/dtnn_kmeans.hpp>
 #include <mlpack/methods/kmeans/dual_tree_kmeans.hpp>
+#include <mlpack/methods/kmeans/subtree_split.hpp>
+#include <mlpack/methods/kmeans/mini_batch_kmeans.hpp>
+#include <mlpack/methods/kmeans/gpu_naive_kmeans.hpp>
 
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
+#include <mlpack/core/util/local_reducer.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -111,7 +118,7 @@ BOOST_AUTO_TEST_CASE(AllowEmptyClusterTest)
   // Make sure the method doesn't modify any points.
   metric::LMetric<2, true> metric;
   BOOST_REQUIRE_EQUAL(AllowEmptyClusters::EmptyCluster(kMeansData, 2, centroids,
-      counts, metric), 0);
+      counts, metric, 0), 0);
 
   // Make sure no assignments were changed.
   for (size_t i = 0; i < assignments.n_elem; i++)
@@ -145,8 +152,9 @@ BOOST_AUTO_TEST_CASE(MaxVarianceNewClusterTest)
   metric::LMetric<2, true> metric;
 
   // This should only change one point.
-  BOOST_REQUIRE_EQUAL(MaxVarianceNewCluster::EmptyCluster(data, 2, centroids,
-      counts, metric), 1);
+  MaxVarianceNewCluster mvnc;
+  BOOST_REQUIRE_EQUAL(mvnc.EmptyCluster(data, 2, centroids, counts, metric, 0),
+      1);
 
   // Add the variance of each point's distance away from the cluster.  I think
   // this is the sensible thing to do.
@@ -182,6 +190,98 @@ BOOST_AUTO_TEST_CASE(MaxVarianceNewClusterTest)
   BOOST_REQUIRE_EQUAL(counts[2], 1);
 }
 
+/**
+ * Make sure the max variance method fills two empty clusters in the same
+ * iteration with different points, using the updated variances.
+ */
+BOOST_AUTO_TEST_CASE(MaxVarianceNewClusterTwoEmptyTest)
+{
+  arma::mat data("0.0 1.0 10.0  0.0  0.0;"
+                 "0.0 0.0  0.0 10.0 11.0;");
+
+  arma::mat centroids(2, 4);
+  centroids.col(0) = (1.0 / 3.0) * (data.col(0) + data.col(1) + data.col(2));
+  centroids.col(1) = 0.5 * (data.col(3) + data.col(4));
+  centroids.cols(2, 3).fill(DBL_MAX);
+
+  arma::Col<size_t> counts("3 2 0 0");
+
+  metric::LMetric<2, true> metric;
+  MaxVarianceNewCluster mvnc;
+
+  // The furthest point of cluster 0 is taken first, and cluster 0 still has
+  // the largest variance, so the second point is taken from it too.
+  BOOST_REQUIRE_EQUAL(mvnc.EmptyCluster(data, 2, centroids, counts, metric, 0),
+      1);
+  BOOST_REQUIRE_EQUAL(mvnc.EmptyCluster(data, 3, centroids, counts, metric, 0),
+      1);
+
+  BOOST_REQUIRE_EQUAL(counts[0], 1);
+  BOOST_REQUIRE_EQUAL(counts[1], 2);
+  BOOST_REQUIRE_EQUAL(counts[2], 1);
+  BOOST_REQUIRE_EQUAL(counts[3], 1);
+
+  BOOST_REQUIRE_CLOSE(centroids(0, 2), 10.0, 1e-5);
+  BOOST_REQUIRE_SMALL(centroids(1, 2), 1e-5);
+  BOOST_REQUIRE_SMALL(centroids(0, 3), 1e-5);
+  BOOST_REQUIRE_SMALL(centroids(1, 3), 1e-5);
+
+  // The remaining point of cluster 0 is its centroid.
+  BOOST_REQUIRE_CLOSE(centroids(0, 0), 1.0, 1e-5);
+  BOOST_REQUIRE_SMALL(centroids(1, 0), 1e-5);
+}
+
+/**
+ * Make sure the max variance method does not reuse the variances of an earlier
+ * call to Cluster() when the same KMeans object clusters a second dataset of
+ * the same size, and both runs have an empty cluster in the first iteration.
+ */
+BOOST_AUTO_TEST_CASE(MaxVarianceNewClusterReuseTest)
+{
+  arma::mat data("100.0 101.0 110.0 100.0 100.0;"
+                 "100.0 100.0 100.0 200.0 201.0;");
+  // The same points, but the points of the second cluster come first.
+  arma::mat otherData("100.0 100.0 100.0 101.0 110.0;"
+                      "200.0 201.0 100.0 100.0 100.0;");
+
+  arma::mat initialCentroids("103.0 100.0 0.0;"
+                             "100.0 200.5 0.0;");
+  initialCentroids.col(2).fill(DBL_MAX);
+
+  KMeans<> kmeans;
+  arma::Col<size_t> assignments;
+  arma::mat centroids = initialCentroids;
+  kmeans.Cluster(data, 3, assignments, centroids, false, true);
+
+  // The point furthest from the centroid of the first cluster is taken.
+  BOOST_REQUIRE_EQUAL(assignments[0], 0);
+  BOOST_REQUIRE_EQUAL(assignments[1], 0);
+  BOOST_REQUIRE_EQUAL(assignments[2], 2);
+  BOOST_REQUIRE_EQUAL(assignments[3], 1);
+  BOOST_REQUIRE_EQUAL(assignments[4], 1);
+
+  centroids = initialCentroids;
+  kmeans.Cluster(otherData, 3, assignments, centroids, false, true);
+
+  BOOST_REQUIRE_EQUAL(assignments[0], 1);
+  BOOST_REQUIRE_EQUAL(assignments[1], 1);
+  BOOST_REQUIRE_EQUAL(assignments[2], 0);
+  BOOST_REQUIRE_EQUAL(assignments[3], 0);
+  BOOST_REQUIRE_EQUAL(assignments[4], 2);
+
+  // The result must be the same as with a new KMeans object.
+  KMeans<> otherKMeans;
+  arma::Col<size_t> otherAssignments;
+  arma::mat otherCentroids = initialCentroids;
+  otherKMeans.Cluster(otherData, 3, otherAssignments, otherCentroids, false,
+      true);
+
+  for (size_t i = 0; i < otherData.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], otherAssignments[i]);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(centroids[i], otherCentroids[i], 1e-5);
+}
+
 /**
  * Make sure the random partitioner seems to return valid results.
  */
@@ -560,6 +660,91 @@ BOOST_AUTO_TEST_CASE(HamerlyTest)
   }
 }
 
+/**
+ * Make sure Yinyang k-means gives the same results as the naive algorithm,
+ * with enough clusters for several groups.
+ */
+BOOST_AUTO_TEST_CASE(YinyangTest)
+{
+  const size_t trials = 5;
+
+  for (size_t t = 0; t < trials; ++t)
+  {
+    arma::mat dataset(10, 1000);
+    dataset.randu();
+
+    const size_t k = 10 * (t + 1);
+    arma::mat centroids(10, k);
+    centroids.randu();
+
+    arma::mat naiveCentroids(centroids);
+    KMeans<> km;
+    arma::Col<size_t> assignments;
+    km.Cluster(dataset, k, assignments, naiveCentroids, false, true);
+
+    KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+        YinyangKMeans> yinyang;
+    arma::Col<size_t> yinyangAssignments;
+    arma::mat yinyangCentroids(centroids);
+    yinyang.Cluster(dataset, k, yinyangAssignments, yinyangCentroids, false,
+        true);
+
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+      BOOST_REQUIRE_EQUAL(assignments[i], yinyangAssignments[i]);
+
+    for (size_t i = 0; i < centroids.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(naiveCentroids[i], yinyangCentroids[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure Hamerly's algorithm gives the same results on a memory-mapped
+ * dataset with the bounds in a file as on the dataset in memory.
+ */
+BOOST_AUTO_TEST_CASE(HamerlyMappedTest)
+{
+  arma::mat dataset(10, 1000);
+  dataset.randu();
+  BOOST_REQUIRE(data::MappedMatrix::Save("test_kmeans.bin", dataset) == true);
+
+  arma::mat centroids(10, 8);
+  centroids.randu();
+
+  {
+    data::MappedMatrix mapped("test_kmeans.bin");
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 10);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 1000);
+
+    metric::EuclideanDistance metric;
+    HamerlyKMeans<metric::EuclideanDistance, arma::mat> step(dataset, metric);
+    HamerlyKMeans<metric::EuclideanDistance, arma::mat> mappedStep(
+        mapped.Matrix(), metric, "test_kmeans_bounds.bin");
+
+    arma::mat current(centroids), next;
+    arma::mat mappedCurrent(centroids), mappedNext;
+    arma::Col<size_t> counts, mappedCounts;
+    for (size_t i = 0; i < 10; ++i)
+    {
+      step.Iterate(current, next, counts);
+      mappedStep.Iterate(mappedCurrent, mappedNext, mappedCounts);
+
+      for (size_t c = 0; c < counts.n_elem; ++c)
+        BOOST_REQUIRE_EQUAL(counts[c], mappedCounts[c]);
+      for (size_t j = 0; j < next.n_elem; ++j)
+        BOOST_REQUIRE_CLOSE(next[j], mappedNext[j], 1e-5);
+
+      current = next;
+      mappedCurrent = mappedNext;
+    }
+
+    BOOST_REQUIRE_EQUAL(step.DistanceCalculations(),
+        mappedStep.DistanceCalculations());
+  }
+
+  remove("test_kmeans.bin");
+  remove("test_kmeans_bounds.bin");
+}
+
 BOOST_AUTO_TEST_CASE(PellegMooreTest)
 {
   const size_t trials = 5;
@@ -690,4 +875,406 @@ BOOST_AUTO_TEST_CASE(DualTreeKMeansTest)
   }
 }
 
+/**
+ * Make sure the dual-tree Lloyd steps give the same results as the naive step
+ * when the centroid tree is refitted every iteration instead of rebuilt.
+ */
+BOOST_AUTO_TEST_CASE(RefitCentroidTreeTest)
+{
+  arma::mat dataset(10, 1000);
+  dataset.randu();
+
+  arma::mat centroids(10, 10);
+  centroids.randu();
+
+  metric::EuclideanDistance metric;
+  NaiveKMeans<metric::EuclideanDistance, arma::mat> naive(dataset, metric);
+  DefaultDualTreeKMeans<metric::EuclideanDistance, arma::mat> dualTree(dataset,
+      metric, DBL_MAX);
+  DefaultDTNNKMeans<metric::EuclideanDistance, arma::mat> dtnn(dataset, metric,
+      DBL_MAX);
+
+  arma::mat current(centroids), next, dualTreeNext, dtnnNext;
+  arma::Col<size_t> counts, dualTreeCounts, dtnnCounts;
+  for (size_t i = 0; i < 10; ++i)
+  {
+    naive.Iterate(current, next, counts);
+    dualTree.Iterate(current, dualTreeNext, dualTreeCounts);
+    dtnn.Iterate(current, dtnnNext, dtnnCounts);
+
+    for (size_t c = 0; c < counts.n_elem; ++c)
+    {
+      BOOST_REQUIRE_EQUAL(counts[c], dualTreeCounts[c]);
+      BOOST_REQUIRE_EQUAL(counts[c], dtnnCounts[c]);
+    }
+
+    for (size_t j = 0; j < next.n_elem; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(next[j], dualTreeNext[j], 1e-5);
+      BOOST_REQUIRE_CLOSE(next[j], dtnnNext[j], 1e-5);
+    }
+
+    current = next;
+  }
+
+  // The centroid trees were only built in the first iteration.
+  BOOST_REQUIRE_EQUAL(dualTree.CentroidTreeBuilds(), 1);
+  BOOST_REQUIRE_EQUAL(dtnn.CentroidTreeBuilds(), 1);
+}
+
+/**
+ * The subtrees given by SplitIntoSubtrees() should hold every point of the tree
+ * exactly once, and the ancestors should come after their parents.
+ */
+BOOST_AUTO_TEST_CASE(SubtreeSplitTest)
+{
+  arma::mat dataset(3, 1000);
+  dataset.randu();
+
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      DualTreeKMeansStatistic> TreeType;
+  TreeType tree(dataset);
+
+  std::vector<TreeType*> subtrees, ancestors;
+  SplitIntoSubtrees(tree, subtrees, ancestors);
+  BOOST_REQUIRE_GT(subtrees.size(), 0);
+
+  arma::Col<size_t> covered(dataset.n_cols);
+  covered.zeros();
+  for (size_t i = 0; i < subtrees.size(); ++i)
+    for (size_t j = 0; j < subtrees[i]->NumDescendants(); ++j)
+      ++covered[subtrees[i]->Descendant(j)];
+  for (size_t i = 0; i < covered.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(covered[i], 1);
+
+  for (size_t i = 0; i < ancestors.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(ancestors[i]->NumPoints(), 0);
+    if (i == 0)
+      BOOST_REQUIRE(ancestors[i] == &tree);
+    else
+      BOOST_REQUIRE(std::find(ancestors.begin(), ancestors.begin() + i,
+          ancestors[i]->Parent()) != ancestors.begin() + i);
+  }
+}
+
+/**
+ * Make sure the Pelleg-Moore Lloyd steps (whose traversal is split between the
+ * threads) give the same results as the naive step.
+ */
+BOOST_AUTO_TEST_CASE(PellegMooreIterateTest)
+{
+  arma::mat dataset(4, 3000);
+  dataset.randu();
+
+  arma::mat centroids(4, 12);
+  centroids.randu();
+
+  metric::EuclideanDistance metric;
+  NaiveKMeans<metric::EuclideanDistance, arma::mat> naive(dataset, metric);
+  PellegMooreKMeans<metric::EuclideanDistance, arma::mat> pellegMoore(dataset,
+      metric);
+
+  arma::mat current(centroids), next, pellegMooreNext;
+  arma::Col<size_t> counts, pellegMooreCounts;
+  for (size_t i = 0; i < 5; ++i)
+  {
+    naive.Iterate(current, next, counts);
+    pellegMoore.Iterate(current, pellegMooreNext, pellegMooreCounts);
+
+    for (size_t c = 0; c < counts.n_elem; ++c)
+      BOOST_REQUIRE_EQUAL(counts[c], pellegMooreCounts[c]);
+    for (size_t j = 0; j < next.n_elem; ++j)
+      BOOST_REQUIRE_CLOSE(next[j], pellegMooreNext[j], 1e-5);
+
+    current = next;
+  }
+}
+
+/**
+ * Generate four tight, well-separated clusters of 100 points each; point i
+ * belongs to cluster i % 4.
+ */
+arma::mat SeparatedClusters()
+{
+  arma::mat centers("0.0 50.0  0.0 50.0;"
+                    "0.0  0.0 50.0 50.0");
+  arma::mat dataset(2, 400);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) = centers.col(i % 4) + 0.1 * arma::randn<arma::vec>(2);
+
+  return dataset;
+}
+
+/**
+ * Make sure that the given assignments put the points of each of the clusters
+ * made by SeparatedClusters() together, and the clusters apart.
+ */
+void CheckSeparatedClusters(const arma::Col<size_t>& assignments)
+{
+  BOOST_REQUIRE_EQUAL(assignments.n_elem, 400);
+  for (size_t i = 4; i < assignments.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[i % 4]);
+
+  for (size_t i = 0; i < 4; ++i)
+  {
+    BOOST_REQUIRE_LT(assignments[i], 4);
+    for (size_t j = 0; j < i; ++j)
+      BOOST_REQUIRE_NE(assignments[i], assignments[j]);
+  }
+}
+
+/**
+ * Make sure that clustering a dataset read in chunks gives the same centroids
+ * as clustering the whole dataset, with different Lloyd steps.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedKMeansTest)
+{
+  arma::mat dataset(10, 1000);
+  dataset.randu();
+  data::Save("test_kmeans.mlb", dataset);
+
+  const size_t k = 5;
+  arma::mat centroids = dataset.cols(0, k - 1);
+
+  arma::mat naiveCentroids(centroids);
+  KMeans<> km;
+  km.Cluster(dataset, k, naiveCentroids, true);
+
+  data::ChunkReader reader("test_kmeans.mlb", true);
+  arma::mat chunkedCentroids(centroids);
+  km.Cluster(reader, k, chunkedCentroids, true, 77);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(naiveCentroids[i], chunkedCentroids[i], 1e-5);
+
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      HamerlyKMeans> hamerly;
+  arma::mat hamerlyCentroids(centroids);
+  hamerly.Cluster(reader, k, hamerlyCentroids, true, 300);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(naiveCentroids[i], hamerlyCentroids[i], 1e-5);
+
+  // Without an initial guess, the first chunk gives the initial centroids.
+  arma::mat guessedCentroids;
+  km.Cluster(reader, k, guessedCentroids, false, 200);
+  BOOST_REQUIRE_EQUAL(guessedCentroids.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(guessedCentroids.n_cols, k);
+
+  remove("test_kmeans.mlb");
+}
+
+/**
+ * A reducer for the tests of the distributed k-means, which acts as if there
+ * were a second node holding a copy of the data of this node: every sum is
+ * doubled.
+ */
+class DoublingReducer
+{
+ public:
+  void Sum(double* values, const size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      values[i] *= 2;
+  }
+
+  size_t Rank() const { return 0; }
+  size_t NumNodes() const { return 2; }
+};
+
+/**
+ * Make sure that distributed k-means gives the same centroids as k-means on the
+ * whole dataset, both on one node and when every node holds the same points.
+ */
+BOOST_AUTO_TEST_CASE(DistributedKMeansTest)
+{
+  arma::mat dataset(10, 1000);
+  dataset.randu();
+
+  const size_t k = 5;
+  arma::mat centroids = dataset.cols(0, k - 1);
+
+  arma::mat naiveCentroids(centroids);
+  KMeans<> km;
+  km.Cluster(dataset, k, naiveCentroids, true);
+
+  util::LocalReducer localReducer;
+  arma::mat localCentroids(centroids);
+  km.Cluster(dataset, k, localCentroids, localReducer, true);
+
+  DoublingReducer doublingReducer;
+  arma::mat doubledCentroids(centroids);
+  km.Cluster(dataset, k, doubledCentroids, doublingReducer, true);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(naiveCentroids[i], localCentroids[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(naiveCentroids[i], doubledCentroids[i], 1e-5);
+  }
+
+  // Without an initial guess, the partitioner of each node is used.
+  arma::mat guessedCentroids;
+  km.Cluster(dataset, k, guessedCentroids, doublingReducer);
+  BOOST_REQUIRE_EQUAL(guessedCentroids.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(guessedCentroids.n_cols, k);
+}
+
+/**
+ * Weighted k-means on the unique points of a dataset with duplicates, weighted
+ * by their counts, should give the same clustering as k-means on the whole
+ * dataset.
+ */
+BOOST_AUTO_TEST_CASE(WeightedKMeansDuplicatesTest)
+{
+  arma::mat points(4, 300);
+  points.randu();
+  arma::mat dataset(4, 1000);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) = points.col((i < 600) ? (i % 300) : (i % 40));
+
+  data::UniquePoints unique(dataset);
+  BOOST_REQUIRE_EQUAL(unique.NumUnique(), 300);
+  arma::mat uniqueDataset;
+  unique.Extract(dataset, uniqueDataset);
+
+  const size_t k = 6;
+  arma::mat centroids = uniqueDataset.cols(0, k - 1);
+
+  KMeans<> km;
+  arma::Col<size_t> assignments;
+  arma::mat fullCentroids(centroids);
+  km.Cluster(dataset, k, assignments, fullCentroids, false, true);
+
+  arma::Col<size_t> uniqueAssignments, expandedAssignments;
+  arma::mat weightedCentroids(centroids);
+  km.Cluster(uniqueDataset, unique.Weights(), k, uniqueAssignments,
+      weightedCentroids, true);
+  unique.Expand(uniqueAssignments, expandedAssignments);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(weightedCentroids[i], fullCentroids[i], 1e-5);
+
+  BOOST_REQUIRE_EQUAL(expandedAssignments.n_elem, dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(expandedAssignments[i], assignments[i]);
+
+  // With unit weights, the weighted clustering is the unweighted one.
+  arma::mat unitCentroids(centroids);
+  arma::mat naiveCentroids(centroids);
+  km.Cluster(uniqueDataset, arma::ones<arma::vec>(uniqueDataset.n_cols), k,
+      uniqueAssignments, unitCentroids, true);
+  km.Cluster(uniqueDataset, k, naiveCentroids, true);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(unitCentroids[i], naiveCentroids[i], 1e-5);
+}
+
+#ifdef HAS_CUDA
+/**
+ * Make sure that the naive Lloyd step on the GPU gives the same centroids as
+ * the naive Lloyd step on the CPU.
+ */
+BOOST_AUTO_TEST_CASE(GPUNaiveKMeansTest)
+{
+  if (!gpu::DeviceAvailable())
+  {
+    BOOST_TEST_MESSAGE("No CUDA device found; skipping.");
+    return;
+  }
+
+  arma::mat dataset(10, 1000);
+  dataset.randu();
+
+  const size_t k = 5;
+  arma::mat naiveCentroids = dataset.cols(0, k - 1);
+  arma::mat gpuCentroids(naiveCentroids);
+
+  KMeans<> km;
+  km.Cluster(dataset, k, naiveCentroids, true);
+
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      GPUNaiveKMeans> gpuKM;
+  gpuKM.Cluster(dataset, k, gpuCentroids, true);
+
+  for (size_t i = 0; i < naiveCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(naiveCentroids[i], gpuCentroids[i], 1e-5);
+}
+#endif
+
+/**
+ * k-means++ should give each of several well-separated clusters its own seed.
+ */
+BOOST_AUTO_TEST_CASE(KMeansPlusPlusTest)
+{
+  arma::mat dataset = SeparatedClusters();
+
+  arma::Col<size_t> assignments;
+  KMeansPlusPlus().Cluster(dataset, 4, assignments);
+  CheckSeparatedClusters(assignments);
+
+  // It should also work as the initial partition policy of KMeans.
+  KMeans<metric::EuclideanDistance, KMeansPlusPlus> kmeans;
+  arma::Col<size_t> kmeansAssignments;
+  kmeans.Cluster(dataset, 4, kmeansAssignments);
+  CheckSeparatedClusters(kmeansAssignments);
+}
+
+/**
+ * k-means|| should give each of several well-separated clusters its own seed.
+ */
+BOOST_AUTO_TEST_CASE(KMeansParallelTest)
+{
+  arma::mat dataset = SeparatedClusters();
+
+  arma::Col<size_t> assignments;
+  KMeansParallel(2.0, 5).Cluster(dataset, 4, assignments);
+  CheckSeparatedClusters(assignments);
+
+  KMeans<metric::EuclideanDistance, KMeansParallel> kmeans;
+  arma::Col<size_t> kmeansAssignments;
+  kmeans.Cluster(dataset, 4, kmeansAssignments);
+  CheckSeparatedClusters(kmeansAssignments);
+}
+
+/**
+ * Make sure that mini-batch k-means finds the centers of well-separated
+ * clusters, and that the counts are the number of points seen so far.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchKMeansTest)
+{
+  // Three Gaussian clusters, far apart.
+  arma::mat centers("0.0 10.0 20.0;"
+                    "0.0 10.0  0.0;"
+                    "0.0  0.0 10.0");
+  arma::mat dataset(3, 3000);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) = centers.col(i % 3) + arma::randn<arma::vec>(3);
+
+  // Start each centroid near a different cluster.
+  arma::mat centroids = centers + 2.0;
+
+  KMeans<metric::EuclideanDistance, RandomPartition, AllowEmptyClusters,
+      MiniBatchKMeans> km(200);
+  arma::Col<size_t> assignments;
+  km.Cluster(dataset, 3, assignments, centroids, false, true);
+
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], i % 3);
+
+  for (size_t i = 0; i < centers.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(centroids[i] - centers[i], 0.2);
+
+  // With a batch of 50 points, after two iterations 100 points have been
+  // assigned.
+  metric::EuclideanDistance metric;
+  MiniBatchKMeans<metric::EuclideanDistance, arma::mat> step(dataset, metric,
+      50);
+  arma::mat newCentroids, otherCentroids;
+  arma::Col<size_t> counts;
+  step.Iterate(centers, newCentroids, counts);
+  step.Iterate(newCentroids, otherCentroids, counts);
+  BOOST_REQUIRE_EQUAL(arma::accu(counts), 100);
+  BOOST_REQUIRE_EQUAL(step.DistanceCalculations(), 2 * (50 * 3 + 3));
+}
+
 BOOST_AUTO_TEST_SUITE_END();
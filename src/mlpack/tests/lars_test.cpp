@@ -155,4 +155,64 @@ BOOST_AUTO_TEST_CASE(NoCholeskySingularityTest)
   }
 }
 
+/**
+ * Make sure that solving many right-hand sides at once gives the same solutions
+ * as solving them one at a time, and that one LARS object can be reused.
+ */
+BOOST_AUTO_TEST_CASE(LARSMultipleResponsesTest)
+{
+  arma::mat X = arma::randn(10, 50);
+  arma::mat responses = trans(X) * arma::randn(10, 30);
+
+  for (size_t cholesky = 0; cholesky < 2; ++cholesky)
+  {
+    LARS lars(cholesky == 1, 0.1, 0.05);
+    arma::mat betas;
+    lars.Regress(X, responses, betas);
+
+    BOOST_REQUIRE_EQUAL(betas.n_rows, 10);
+    BOOST_REQUIRE_EQUAL(betas.n_cols, 30);
+
+    LARS singleLars(cholesky == 1, 0.1, 0.05);
+    for (size_t i = 0; i < responses.n_cols; ++i)
+    {
+      arma::vec beta;
+      singleLars.Regress(X, responses.unsafe_col(i), beta);
+
+      for (size_t j = 0; j < beta.n_elem; ++j)
+        BOOST_REQUIRE_SMALL(betas(j, i) - beta[j], 1e-10);
+    }
+  }
+}
+
+/**
+ * Make sure that the sparse solutions of many right-hand sides hold exactly the
+ * nonzero coefficients of the dense solutions.
+ */
+BOOST_AUTO_TEST_CASE(LARSSparseMultipleResponsesTest)
+{
+  arma::mat X = arma::randn(20, 50);
+  arma::mat responses = trans(X) * arma::randn(20, 30);
+
+  for (size_t cholesky = 0; cholesky < 2; ++cholesky)
+  {
+    LARS lars(cholesky == 1, 0.5);
+    arma::mat betas;
+    lars.Regress(X, responses, betas);
+
+    arma::sp_mat sparseBetas;
+    lars.Regress(X, responses, sparseBetas);
+
+    BOOST_REQUIRE_EQUAL(sparseBetas.n_rows, 20);
+    BOOST_REQUIRE_EQUAL(sparseBetas.n_cols, 30);
+    BOOST_REQUIRE_EQUAL(sparseBetas.n_nonzero,
+        (size_t) arma::accu(betas != 0));
+
+    const arma::mat denseBetas(sparseBetas);
+    for (size_t i = 0; i < betas.n_cols; ++i)
+      for (size_t j = 0; j < betas.n_rows; ++j)
+        BOOST_REQUIRE_SMALL(denseBetas(j, i) - betas(j, i), 1e-10);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -40,6 +40,27 @@ BOOST_AUTO_TEST_CASE(RosenbrockFunctionTest)
 /**
  * Tests the L-BFGS optimizer using the Wood Function.
  */
+/**
+ * The workspace of the optimizer is reused between calls to Optimize(), so
+ * optimizing twice from the same point should give exactly the same result.
+ */
+BOOST_AUTO_TEST_CASE(RepeatedOptimizeTest)
+{
+  RosenbrockFunction f;
+  L_BFGS<RosenbrockFunction> lbfgs(f);
+  lbfgs.MaxIterations() = 10000;
+
+  arma::mat coords1 = f.GetInitialPoint();
+  const double value1 = lbfgs.Optimize(coords1);
+  arma::mat coords2 = f.GetInitialPoint();
+  const double value2 = lbfgs.Optimize(coords2);
+
+  BOOST_REQUIRE_EQUAL(value1, value2);
+  BOOST_REQUIRE_EQUAL(coords1[0], coords2[0]);
+  BOOST_REQUIRE_EQUAL(coords1[1], coords2[1]);
+  BOOST_REQUIRE_SMALL(value1, 1e-5);
+}
+
 BOOST_AUTO_TEST_CASE(WoodFunctionTest)
 {
   WoodFunction f;
@@ -8,6 +8,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/math/lin_alg.hpp>
+#include <mlpack/core/math/randomized_svd.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -73,6 +74,70 @@ BOOST_AUTO_TEST_CASE(TestCenterB)
       BOOST_REQUIRE_CLOSE(tmp_out(row, col), (double) (col - 2.5) * row, 1e-5);
 }
 
+/**
+ * Centering in-place should give the same result as centering into another
+ * matrix.
+ */
+BOOST_AUTO_TEST_CASE(TestCenterInPlace)
+{
+  mat tmp(7, 3000, fill::randu);
+  tmp.row(2) += 100.0;
+
+  mat tmp_out;
+  Center(tmp, tmp_out);
+  Center(tmp);
+
+  BOOST_REQUIRE_EQUAL(tmp.n_rows, 7);
+  BOOST_REQUIRE_EQUAL(tmp.n_cols, 3000);
+  for (size_t i = 0; i < tmp.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(tmp[i], tmp_out[i], 1e-5);
+
+  const vec means = sum(tmp, 1) / tmp.n_cols;
+  for (size_t i = 0; i < means.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(means[i], 1e-10);
+}
+
+/**
+ * The blocked covariance, in one pass and in two, should match ccov(), over
+ * more points than fit in one block.
+ */
+BOOST_AUTO_TEST_CASE(TestCovariance)
+{
+  mat data(6, 2500, fill::randn);
+  data.row(1) *= 5.0;
+  data.row(4) += 3.0;
+
+  const mat expected = ccov(data);
+  const vec expectedMean = sum(data, 1) / data.n_cols;
+
+  mat covariance;
+  vec mean;
+  for (size_t twoPass = 0; twoPass < 2; ++twoPass)
+  {
+    Covariance(data, covariance, mean, (twoPass == 1));
+
+    BOOST_REQUIRE_EQUAL(covariance.n_rows, 6);
+    BOOST_REQUIRE_EQUAL(covariance.n_cols, 6);
+    BOOST_REQUIRE_EQUAL(mean.n_elem, 6);
+    for (size_t i = 0; i < covariance.n_elem; ++i)
+    {
+      if (std::abs(expected[i]) < 1e-5)
+        BOOST_REQUIRE_SMALL(covariance[i], 1e-5);
+      else
+        BOOST_REQUIRE_CLOSE(covariance[i], expected[i], 1e-5);
+    }
+    for (size_t i = 0; i < mean.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(mean[i], expectedMean[i], 1e-5);
+  }
+
+  // With a large offset, the two-pass covariance keeps its precision.
+  mat shifted(data);
+  shifted.row(0) += 1e8;
+  Covariance(shifted, covariance, mean, true);
+  BOOST_REQUIRE_CLOSE(covariance(0, 0), expected(0, 0), 1e-3);
+  BOOST_REQUIRE_CLOSE(covariance(1, 1), expected(1, 1), 1e-5);
+}
+
 BOOST_AUTO_TEST_CASE(TestWhitenUsingEig)
 {
   // After whitening using eigendecomposition, the covariance of
@@ -185,4 +250,37 @@ BOOST_AUTO_TEST_CASE(TestRemoveRows)
   }
 }
 
+/**
+ * Make sure the randomized SVD finds the leading singular values and vectors of
+ * a nearly low-rank matrix.
+ */
+BOOST_AUTO_TEST_CASE(TestRandomizedSVD)
+{
+  mat data = randn<mat>(200, 8) * randn<mat>(8, 150) +
+      1e-3 * randn<mat>(200, 150);
+
+  mat u, v, fullU, fullV;
+  vec s, fullS;
+  svd(fullU, fullS, fullV, data);
+  RandomizedSVD(data, 5, u, s, v);
+
+  BOOST_REQUIRE_EQUAL(u.n_rows, 200);
+  BOOST_REQUIRE_EQUAL(u.n_cols, 5);
+  BOOST_REQUIRE_EQUAL(s.n_elem, 5);
+  BOOST_REQUIRE_EQUAL(v.n_rows, 150);
+  BOOST_REQUIRE_EQUAL(v.n_cols, 5);
+
+  for (size_t i = 0; i < 5; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(s[i], fullS[i], 1e-3);
+
+    // The singular vectors are only defined up to their sign.
+    BOOST_REQUIRE_CLOSE(std::abs(dot(u.col(i), fullU.col(i))), 1.0, 1e-3);
+    BOOST_REQUIRE_CLOSE(std::abs(dot(v.col(i), fullV.col(i))), 1.0, 1e-3);
+  }
+
+  BOOST_REQUIRE(PreferRandomizedSVD(5, 200, 150));
+  BOOST_REQUIRE(!PreferRandomizedSVD(50, 200, 150));
+}
+
 BOOST_AUTO_TEST_SUITE_END();
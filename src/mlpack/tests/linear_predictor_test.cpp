@@ -0,0 +1,139 @@
+/**
+ * @file linear_predictor_test.cpp
+ *
+ * Tests for the LinearPredictor class.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/linear_predictor/linear_predictor.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::regression;
+
+BOOST_AUTO_TEST_SUITE(LinearPredictorTest);
+
+/**
+ * The probabilities of several classes should be the softmax of the scores,
+ * also for points in the last (partial) block.
+ */
+BOOST_AUTO_TEST_CASE(LinearPredictorSoftmaxProbabilities)
+{
+  const size_t points = 1000;
+  const size_t dimension = 10;
+  const size_t numClasses = 5;
+
+  arma::mat data = arma::randn<arma::mat>(dimension, points);
+  arma::mat weights = arma::randn<arma::mat>(numClasses, dimension);
+  arma::vec bias = arma::randn<arma::vec>(numClasses);
+
+  LinearPredictor<> predictor(weights, bias, 64);
+  arma::mat probabilities;
+  predictor.Probabilities(data, probabilities);
+
+  BOOST_REQUIRE_EQUAL(probabilities.n_rows, numClasses);
+  BOOST_REQUIRE_EQUAL(probabilities.n_cols, points);
+
+  for (size_t i = 0; i < points; ++i)
+  {
+    const arma::vec exponentials = arma::exp(weights * data.col(i) + bias);
+    const arma::vec expected = exponentials / arma::accu(exponentials);
+    for (size_t j = 0; j < numClasses; ++j)
+      BOOST_REQUIRE_CLOSE(probabilities(j, i), expected[j], 1e-5);
+  }
+}
+
+/**
+ * Very large scores should not overflow the probabilities.
+ */
+BOOST_AUTO_TEST_CASE(LinearPredictorLargeScores)
+{
+  arma::mat data("1 -1");
+  arma::mat weights("1000; 999; -1000");
+
+  LinearPredictor<> predictor(weights);
+  arma::mat probabilities;
+  predictor.Probabilities(data, probabilities);
+
+  BOOST_REQUIRE_CLOSE(probabilities(0, 0), 1.0 / (1.0 + std::exp(-1.0)), 1e-5);
+  BOOST_REQUIRE_CLOSE(probabilities(1, 0), 1.0 / (1.0 + std::exp(1.0)), 1e-5);
+  BOOST_REQUIRE_SMALL(probabilities(2, 0), 1e-10);
+  BOOST_REQUIRE_CLOSE(probabilities(2, 1), 1.0, 1e-5);
+}
+
+/**
+ * The predicted classes should be the same for dense points, sparse points,
+ * and single-precision weights.
+ */
+BOOST_AUTO_TEST_CASE(LinearPredictorClassify)
+{
+  const size_t points = 1000;
+  const size_t dimension = 20;
+  const size_t numClasses = 4;
+
+  arma::sp_mat sparseData = arma::sprandu<arma::sp_mat>(dimension, points,
+      0.2);
+  arma::mat data(sparseData);
+  arma::mat weights = arma::randn<arma::mat>(numClasses, dimension);
+
+  LinearPredictor<> predictor(weights, arma::vec(), 100);
+  arma::vec predictions;
+  predictor.Classify(data, predictions);
+  BOOST_REQUIRE_EQUAL(predictions.n_elem, points);
+
+  const arma::mat scores = weights * data;
+  for (size_t i = 0; i < points; ++i)
+  {
+    arma::uword maxClass;
+    scores.col(i).max(maxClass);
+    BOOST_REQUIRE_EQUAL(predictions[i], (double) maxClass);
+  }
+
+  arma::vec sparsePredictions;
+  predictor.Classify(sparseData, sparsePredictions);
+  for (size_t i = 0; i < points; ++i)
+    BOOST_REQUIRE_EQUAL(sparsePredictions[i], predictions[i]);
+
+  // Single precision can only disagree when two scores are very close.
+  LinearPredictor<float> floatPredictor(weights, arma::vec(), 100);
+  arma::vec floatPredictions;
+  floatPredictor.Classify(data, floatPredictions);
+  for (size_t i = 0; i < points; ++i)
+  {
+    if (floatPredictions[i] != predictions[i])
+      BOOST_REQUIRE_SMALL(scores((size_t) floatPredictions[i], i) -
+          scores((size_t) predictions[i], i), 1e-4);
+  }
+}
+
+/**
+ * With one row of weights, the predictions should be those of logistic
+ * regression.
+ */
+BOOST_AUTO_TEST_CASE(LinearPredictorLogisticRegression)
+{
+  const size_t points = 500;
+  const size_t dimension = 5;
+
+  arma::mat data = arma::randn<arma::mat>(dimension, points);
+  arma::vec parameters = arma::randn<arma::vec>(dimension + 1);
+  LogisticRegression<> lr(parameters);
+
+  const arma::vec sigmoids = 1.0 / (1.0 + arma::exp(-parameters[0] -
+      data.t() * parameters.subvec(1, dimension)));
+
+  arma::fmat probabilities;
+  lr.Predictor<float>().Probabilities(data, probabilities);
+  BOOST_REQUIRE_EQUAL(probabilities.n_rows, 1);
+  for (size_t i = 0; i < points; ++i)
+    BOOST_REQUIRE_CLOSE(probabilities[i], sigmoids[i], 1e-3);
+
+  arma::vec predictions;
+  lr.Predict(data, predictions, 0.3);
+  for (size_t i = 0; i < points; ++i)
+    BOOST_REQUIRE_EQUAL(predictions[i], (sigmoids[i] >= 0.3) ? 1.0 : 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -173,4 +173,142 @@ BOOST_AUTO_TEST_CASE(RidgeRegressionTestCase)
     BOOST_REQUIRE_SMALL(predictions(i) - responses(i), .05);
 }
 
+/**
+ * Make sure that training on a dataset read in chunks gives the same model as
+ * training on the whole dataset, with and without ridge regression.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedLinearRegressionTest)
+{
+  arma::mat dataset(5, 1000);
+  dataset.randu();
+  dataset.row(4) = 2.0 * dataset.row(0) - 3.0 * dataset.row(1) +
+      0.5 * dataset.row(3) + 1.0 + 0.01 * arma::randn<arma::rowvec>(1000);
+  data::Save("test_lr.csv", dataset);
+
+  const arma::mat predictors = dataset.rows(0, 3);
+  const arma::vec responses = arma::trans(dataset.row(4));
+
+  const double lambdas[] = { 0.0, 0.5 };
+  for (size_t i = 0; i < 2; ++i)
+  {
+    // The saved dataset is slightly rounded, so compare with a model trained
+    // on what was saved.
+    arma::mat saved;
+    data::Load("test_lr.csv", saved, true);
+    LinearRegression lr(saved.rows(0, 3), arma::trans(saved.row(4)),
+        lambdas[i]);
+
+    data::ChunkReader reader("test_lr.csv", true);
+    LinearRegression chunkedLr(reader, lambdas[i], true, 73);
+
+    BOOST_REQUIRE_EQUAL(chunkedLr.Parameters().n_elem, 5);
+    for (size_t j = 0; j < 5; ++j)
+      BOOST_REQUIRE_SMALL(chunkedLr.Parameters()[j] - lr.Parameters()[j],
+          1e-8);
+
+    arma::vec predictions;
+    chunkedLr.Predict(predictors, predictions);
+    for (size_t j = 0; j < predictions.n_elem; ++j)
+      BOOST_REQUIRE_SMALL(predictions[j] - responses[j], 0.1);
+  }
+
+  remove("test_lr.csv");
+}
+
+/**
+ * Make sure weighted normal equations accumulated over several chunks give the
+ * same model as the weighted QR solution.
+ */
+BOOST_AUTO_TEST_CASE(WeightedNormalEquationsTest)
+{
+  arma::mat predictors;
+  predictors.randu(4, 1000);
+  const arma::vec responses = arma::trans(2.0 * predictors.row(0) -
+      predictors.row(2) + 0.5 + 0.1 * arma::randn<arma::rowvec>(1000));
+  const arma::vec weights = 0.1 + arma::randu<arma::vec>(1000);
+
+  NormalEquations equations;
+  for (size_t begin = 0; begin < 1000; begin += 300)
+  {
+    const size_t end = std::min((size_t) 1000, begin + 300) - 1;
+    equations.Add(predictors.cols(begin, end), responses.subvec(begin, end),
+        weights.subvec(begin, end));
+  }
+
+  BOOST_REQUIRE_EQUAL(equations.Points(), 1000);
+
+  LinearRegression lr(predictors, responses, 0.0, true, weights);
+  LinearRegression normalLr(equations);
+
+  BOOST_REQUIRE_EQUAL(normalLr.Parameters().n_elem, 5);
+  for (size_t i = 0; i < 5; ++i)
+    BOOST_REQUIRE_SMALL(normalLr.Parameters()[i] - lr.Parameters()[i], 1e-8);
+}
+
+/**
+ * Make sure one pass of the normal equations can be solved for several values
+ * of lambda, with and without the intercept.
+ */
+BOOST_AUTO_TEST_CASE(NormalEquationsRidgePathTest)
+{
+  arma::mat predictors;
+  predictors.randu(3, 500);
+  const arma::vec responses = arma::trans(predictors.row(0) +
+      3.0 * predictors.row(1) + 0.1 * arma::randn<arma::rowvec>(500));
+
+  for (size_t intercept = 0; intercept < 2; ++intercept)
+  {
+    NormalEquations equations(intercept == 1);
+    equations.Add(predictors, responses);
+
+    const double lambdas[] = { 0.0, 0.1, 1.0, 10.0 };
+    for (size_t i = 0; i < 4; ++i)
+    {
+      LinearRegression lr(predictors, responses, lambdas[i], intercept == 1);
+      LinearRegression normalLr(equations, lambdas[i]);
+
+      BOOST_REQUIRE_EQUAL(normalLr.Parameters().n_elem,
+          lr.Parameters().n_elem);
+      for (size_t j = 0; j < lr.Parameters().n_elem; ++j)
+        BOOST_REQUIRE_SMALL(normalLr.Parameters()[j] - lr.Parameters()[j],
+            1e-8);
+    }
+  }
+}
+
+/**
+ * Make sure a model saved to an XML or binary model file is loaded correctly.
+ */
+BOOST_AUTO_TEST_CASE(LinearRegressionSaveLoadTest)
+{
+  arma::mat predictors;
+  predictors.randu(4, 100);
+  arma::vec responses;
+  responses.randu(100);
+
+  LinearRegression lr(predictors, responses, 0.1, false);
+
+  const char* filenames[] = { "test_lr_model.xml", "test_lr_model.bin" };
+  for (size_t f = 0; f < 2; ++f)
+  {
+    lr.Save(filenames[f]);
+
+    LinearRegression loaded(filenames[f]);
+    BOOST_REQUIRE_CLOSE(loaded.Lambda(), 0.1, 1e-5);
+    BOOST_REQUIRE_EQUAL(loaded.Parameters().n_elem, 4);
+    for (size_t i = 0; i < 4; ++i)
+      BOOST_REQUIRE_CLOSE(loaded.Parameters()[i], lr.Parameters()[i], 1e-5);
+
+    // The model has no intercept, so the predictions are the same only if that
+    // was loaded too.
+    arma::vec predictions, loadedPredictions;
+    lr.Predict(predictors, predictions);
+    loaded.Predict(predictors, loadedPredictions);
+    for (size_t i = 0; i < predictions.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(loadedPredictions[i], predictions[i], 1e-5);
+
+    remove(filenames[f]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
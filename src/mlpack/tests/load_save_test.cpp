@@ -4,6 +4,8 @@
  *
  * Tests for data::Load() and data::Save().
  */
+#include <fstream>
+#include <iomanip>
 #include <sstream>
 
 #include <mlpack/core.hpp>
@@ -493,6 +495,69 @@ BOOST_AUTO_TEST_CASE(SaveHDF5Test)
   remove("test_file.hdf5");
   remove("test_file.he5");
 }
+
+/**
+ * Make sure a chunked HDF5 file from data::Save() can be loaded whole, and read
+ * a range of points at a time with data::Load() and ChunkReader.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedHDF5Test)
+{
+  // Large enough to be split into several chunks.
+  arma::mat test;
+  test.randu(7, 30000);
+  BOOST_REQUIRE(data::Save("test_file.h5", test) == true);
+
+  arma::mat loaded;
+  BOOST_REQUIRE(data::Load("test_file.h5", loaded) == true);
+  BOOST_REQUIRE_EQUAL(loaded.n_rows, 7);
+  BOOST_REQUIRE_EQUAL(loaded.n_cols, 30000);
+  for (size_t i = 0; i < test.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], test[i]);
+
+  // A slab that crosses chunks, converted to floats.
+  arma::fmat slab;
+  BOOST_REQUIRE(data::Load("test_file.h5", slab, arma::span(18000, 26999))
+      == true);
+  BOOST_REQUIRE_EQUAL(slab.n_rows, 7);
+  BOOST_REQUIRE_EQUAL(slab.n_cols, 9000);
+  for (size_t i = 0; i < slab.n_cols; ++i)
+    for (size_t j = 0; j < 7; ++j)
+      BOOST_REQUIRE_EQUAL(slab(j, i), (float) test(j, 18000 + i));
+
+  // Points past the end can't be loaded.
+  BOOST_REQUIRE(data::Load("test_file.h5", loaded, arma::span(29990, 30009))
+      == false);
+
+  data::ChunkReader reader("test_file.h5");
+  BOOST_REQUIRE(reader.IsOpen());
+  BOOST_REQUIRE_EQUAL(reader.Dimensionality(), 7);
+  arma::mat chunk;
+  size_t numChunks = 0;
+  while (reader.Read(chunk, 7000))
+  {
+    BOOST_REQUIRE_EQUAL(chunk.n_rows, 7);
+    BOOST_REQUIRE_EQUAL(chunk.n_cols,
+        std::min((size_t) 7000, 30000 - 7000 * numChunks));
+    for (size_t i = 0; i < chunk.n_cols; ++i)
+      for (size_t j = 0; j < 7; ++j)
+        BOOST_REQUIRE_EQUAL(chunk(j, i), test(j, 7000 * numChunks + i));
+    ++numChunks;
+  }
+  BOOST_REQUIRE_EQUAL(numChunks, 5);
+  BOOST_REQUIRE(!reader.Failed());
+
+  // Without transposition, the points are the rows of the dataset.
+  BOOST_REQUIRE(data::Save("test_file.h5", test, false, false) == true);
+  BOOST_REQUIRE(data::Load("test_file.h5", slab, arma::span(5, 9), false,
+      false) == true);
+  BOOST_REQUIRE_EQUAL(slab.n_rows, 7);
+  BOOST_REQUIRE_EQUAL(slab.n_cols, 5);
+  for (size_t i = 0; i < slab.n_cols; ++i)
+    for (size_t j = 0; j < 7; ++j)
+      BOOST_REQUIRE_EQUAL(slab(j, i), (float) test(j, 5 + i));
+
+  remove("test_file.h5");
+}
 #else
 /**
  * Ensure saving as HDF5 fails.
@@ -563,4 +628,633 @@ BOOST_AUTO_TEST_CASE(NormalizeLabelTest)
     BOOST_REQUIRE_EQUAL(randLabels[i], revertedLabels[i]);
 }
 
+/**
+ * Make sure a LabelMapping normalizes test labels like the training labels,
+ * also after it is saved and loaded.
+ */
+BOOST_AUTO_TEST_CASE(LabelMappingTest)
+{
+  arma::ivec trainLabels(5000);
+  for (size_t i = 0; i < 5000; ++i)
+    trainLabels[i] = math::RandInt(-500, 500);
+
+  arma::Col<size_t> newLabels;
+  data::LabelMapping<arma::sword> mapping(trainLabels, newLabels);
+
+  // The mapping is the same as the one given by NormalizeLabels().
+  arma::Col<size_t> normalizedLabels;
+  arma::ivec mappings;
+  data::NormalizeLabels(trainLabels, normalizedLabels, mappings);
+  BOOST_REQUIRE_EQUAL(mapping.NumClasses(), mappings.n_elem);
+  for (size_t i = 0; i < mappings.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(mapping.Mapping()[i], mappings[i]);
+  for (size_t i = 0; i < 5000; ++i)
+    BOOST_REQUIRE_EQUAL(newLabels[i], normalizedLabels[i]);
+
+  // Test labels drawn from the training labels map to the same classes.
+  arma::ivec testLabels(1000);
+  for (size_t i = 0; i < 1000; ++i)
+    testLabels[i] = trainLabels[math::RandInt(0, 5000)];
+
+  util::SaveRestoreUtility sr;
+  mapping.Save(sr);
+  data::LabelMapping<arma::sword> loadedMapping;
+  loadedMapping.Load(sr);
+
+  arma::Col<size_t> testNewLabels, loadedNewLabels;
+  mapping.Map(testLabels, testNewLabels);
+  loadedMapping.Map(testLabels, loadedNewLabels);
+
+  arma::ivec revertedLabels;
+  loadedMapping.Revert(loadedNewLabels, revertedLabels);
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(testNewLabels[i], loadedNewLabels[i]);
+    BOOST_REQUIRE_EQUAL(revertedLabels[i], testLabels[i]);
+  }
+}
+
+/**
+ * Make sure a CSV read chunk by chunk gives the same points as data::Load(),
+ * and writing the chunks back out gives the same file as data::Save().
+ */
+BOOST_AUTO_TEST_CASE(ChunkedCSVTest)
+{
+  arma::mat test;
+  test.randu(4, 25);
+  BOOST_REQUIRE(data::Save("test_file.csv", test) == true);
+
+  arma::mat loaded;
+  BOOST_REQUIRE(data::Load("test_file.csv", loaded) == true);
+
+  // The writer is destroyed at the end of this block, so everything has been
+  // written before the file is loaded.
+  {
+    data::ChunkReader reader("test_file.csv");
+    BOOST_REQUIRE(reader.IsOpen());
+
+    data::ChunkWriter writer("test_chunks.txt");
+    BOOST_REQUIRE(writer.IsOpen());
+
+    arma::mat chunk;
+    size_t numChunks = 0;
+    while (reader.Read(chunk, 7))
+    {
+      BOOST_REQUIRE_EQUAL(chunk.n_rows, 4);
+      BOOST_REQUIRE_EQUAL(chunk.n_cols,
+          std::min((size_t) 7, 25 - 7 * numChunks));
+
+      for (size_t i = 0; i < chunk.n_cols; ++i)
+        for (size_t j = 0; j < 4; ++j)
+          BOOST_REQUIRE_CLOSE(chunk(j, i), loaded(j, 7 * numChunks + i), 1e-5);
+
+      BOOST_REQUIRE(writer.Write(chunk) == true);
+      ++numChunks;
+    }
+
+    BOOST_REQUIRE_EQUAL(numChunks, 4);
+    BOOST_REQUIRE_EQUAL(reader.PointsRead(), 25);
+    BOOST_REQUIRE_EQUAL(reader.Dimensionality(), 4);
+    BOOST_REQUIRE(chunk.n_elem == 0);
+  }
+
+  arma::mat written;
+  BOOST_REQUIRE(data::Load("test_chunks.txt", written) == true);
+
+  BOOST_REQUIRE_EQUAL(written.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(written.n_cols, 25);
+  for (size_t i = 0; i < written.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(written[i], loaded[i], 1e-5);
+
+  remove("test_file.csv");
+  remove("test_chunks.txt");
+}
+
+/**
+ * Make sure reading in chunks fails when the points do not all have the same
+ * dimensionality.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedCSVBadDimensionalityTest)
+{
+  std::fstream f;
+  f.open("test_file.csv", std::fstream::out);
+
+  f << "1, 2, 3" << std::endl;
+  f << "4, 5, 6" << std::endl;
+  f << "7, 8" << std::endl;
+
+  f.close();
+
+  data::ChunkReader reader("test_file.csv");
+
+  arma::mat chunk;
+  BOOST_REQUIRE(reader.Read(chunk, 2) == true);
+  BOOST_REQUIRE_EQUAL(chunk.n_cols, 2);
+  BOOST_REQUIRE(reader.Read(chunk, 2) == false);
+  BOOST_REQUIRE(chunk.n_elem == 0);
+
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure binary files can be read in chunks, and read again after Reset().
+ */
+BOOST_AUTO_TEST_CASE(ChunkedBinaryTest)
+{
+  arma::mat dataset(5, 23);
+  dataset.randu();
+
+  const char* filenames[] = { "test_file.bin", "test_file.mlb" };
+  for (size_t f = 0; f < 2; ++f)
+  {
+    BOOST_REQUIRE(data::Save(filenames[f], dataset) == true);
+
+    data::ChunkReader reader(filenames[f]);
+    BOOST_REQUIRE(reader.IsOpen());
+    BOOST_REQUIRE_EQUAL(reader.Dimensionality(), 5);
+
+    for (size_t pass = 0; pass < 2; ++pass)
+    {
+      arma::mat chunk;
+      size_t numChunks = 0;
+      while (reader.Read(chunk, 7))
+      {
+        BOOST_REQUIRE_EQUAL(chunk.n_rows, 5);
+        BOOST_REQUIRE_EQUAL(chunk.n_cols,
+            std::min((size_t) 7, 23 - 7 * numChunks));
+
+        for (size_t i = 0; i < chunk.n_cols; ++i)
+          for (size_t j = 0; j < chunk.n_rows; ++j)
+            BOOST_REQUIRE_EQUAL(chunk(j, i), dataset(j, 7 * numChunks + i));
+
+        ++numChunks;
+      }
+
+      BOOST_REQUIRE_EQUAL(numChunks, 4);
+      BOOST_REQUIRE_EQUAL(reader.PointsRead(), 23);
+      BOOST_REQUIRE(!reader.Failed());
+      BOOST_REQUIRE(reader.Reset());
+    }
+
+    // The elements are converted if need be.
+    arma::fmat floatChunk;
+    BOOST_REQUIRE(reader.Read(floatChunk, 30) == true);
+    BOOST_REQUIRE_EQUAL(floatChunk.n_cols, 23);
+    for (size_t i = 0; i < dataset.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(floatChunk[i], (float) dataset[i]);
+
+    remove(filenames[f]);
+  }
+}
+
+/**
+ * Make sure values saved as text are read back exactly, and look like what
+ * Armadillo would have written for integers.
+ */
+BOOST_AUTO_TEST_CASE(FormatTextTest)
+{
+  // Enough columns that the lines are formatted in several pieces.
+  arma::mat test;
+  test.randn(3, 30000);
+  test.col(0) = arma::vec("1 -2 0");
+  test(0, 1) = 1e20;
+  test(1, 1) = -1.5e-300;
+  test(2, 1) = 0.1;
+
+  std::ostringstream oss;
+  BOOST_REQUIRE(data::FormatText(oss, test, ',') == true);
+  BOOST_REQUIRE_EQUAL(oss.str().substr(0, 7), "1,-2,0\n");
+
+  BOOST_REQUIRE(data::Save("test_file.csv", test) == true);
+  arma::mat loaded;
+  BOOST_REQUIRE(data::Load("test_file.csv", loaded) == true);
+
+  BOOST_REQUIRE_EQUAL(loaded.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(loaded.n_cols, 30000);
+  for (size_t i = 0; i < test.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], test[i]);
+
+  // Index matrices are written as integers.
+  arma::Mat<size_t> indices(2, 3);
+  for (size_t i = 0; i < indices.n_elem; ++i)
+    indices[i] = i * 1000000007;
+
+  BOOST_REQUIRE(data::Save("test_file.txt", indices, false, false) == true);
+  std::ifstream f("test_file.txt");
+  std::string line;
+  std::getline(f, line);
+  BOOST_REQUIRE_EQUAL(line, "0 2000000014 4000000028");
+  std::getline(f, line);
+  BOOST_REQUIRE_EQUAL(line, "1000000007 3000000021 5000000035");
+  f.close();
+
+  remove("test_file.csv");
+  remove("test_file.txt");
+}
+
+/**
+ * Make sure an asynchronous ChunkWriter writes the same text as data::Save(),
+ * and a ChunkWriter for a matrix file writes the same matrix.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedWriterTest)
+{
+  arma::mat test;
+  test.randu(5, 100);
+  arma::Mat<size_t> indices(4, 100);
+  for (size_t i = 0; i < indices.n_elem; ++i)
+    indices[i] = 3 * i;
+
+  BOOST_REQUIRE(data::Save("test_file.csv", test) == true);
+
+  {
+    data::ChunkWriter textWriter("test_chunks.csv", false, true);
+    BOOST_REQUIRE(textWriter.IsOpen());
+    data::ChunkWriter binaryWriter("test_chunks.mlb");
+    BOOST_REQUIRE(binaryWriter.IsOpen());
+
+    for (size_t i = 0; i < 100; i += 30)
+    {
+      const size_t end = std::min((size_t) 100, i + 30) - 1;
+
+      // The chunk is reused right away, so the writer has to have copied it.
+      arma::mat chunk = test.cols(i, end);
+      BOOST_REQUIRE(textWriter.Write(chunk) == true);
+      chunk.zeros();
+
+      BOOST_REQUIRE(binaryWriter.Write(arma::Mat<size_t>(indices.cols(i, end)))
+          == true);
+    }
+
+    BOOST_REQUIRE(textWriter.Flush() == true);
+
+    // A chunk of another size can't be added to the matrix file.
+    BOOST_REQUIRE(binaryWriter.Write(arma::Mat<size_t>(3, 2)) == false);
+  }
+
+  std::ifstream expected("test_file.csv"), written("test_chunks.csv");
+  std::ostringstream expectedText, writtenText;
+  expectedText << expected.rdbuf();
+  writtenText << written.rdbuf();
+  BOOST_REQUIRE(expectedText.str() == writtenText.str());
+  expected.close();
+  written.close();
+
+  arma::Mat<size_t> loaded;
+  BOOST_REQUIRE(data::Load("test_chunks.mlb", loaded) == true);
+  BOOST_REQUIRE_EQUAL(loaded.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(loaded.n_cols, 100);
+  for (size_t i = 0; i < loaded.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], indices[i]);
+
+  remove("test_file.csv");
+  remove("test_chunks.csv");
+  remove("test_chunks.mlb");
+}
+
+/**
+ * Make sure a matrix file written with Save() or Convert() can be mapped, and a
+ * created matrix file holds what was written to its matrix.
+ */
+BOOST_AUTO_TEST_CASE(MappedMatrixTest)
+{
+  arma::mat test;
+  test.randu(4, 25);
+  BOOST_REQUIRE(data::Save("test_file.csv", test) == true);
+  BOOST_REQUIRE(data::MappedMatrix::Save("test_file.bin", test) == true);
+
+  {
+    data::MappedMatrix mapped("test_file.bin");
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 4);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 25);
+    for (size_t i = 0; i < test.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], test[i]);
+  }
+
+  // Convert the CSV a few points at a time.
+  arma::mat loaded;
+  BOOST_REQUIRE(data::Load("test_file.csv", loaded) == true);
+  BOOST_REQUIRE(data::MappedMatrix::Convert("test_file.csv", "test_file.bin",
+      7) == true);
+
+  {
+    data::MappedMatrix mapped("test_file.bin");
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 4);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 25);
+    for (size_t i = 0; i < loaded.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], loaded[i]);
+  }
+
+  // Create a matrix file and fill it.
+  {
+    data::MappedMatrix created("test_file.bin", 3, 5);
+    BOOST_REQUIRE_EQUAL(created.Matrix().n_rows, 3);
+    BOOST_REQUIRE_EQUAL(created.Matrix().n_cols, 5);
+    BOOST_REQUIRE_EQUAL(arma::accu(created.Matrix()), 0.0);
+    for (size_t i = 0; i < created.Matrix().n_elem; ++i)
+      created.Matrix()[i] = (double) i;
+  }
+
+  {
+    data::MappedMatrix mapped("test_file.bin");
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 3);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 5);
+    for (size_t i = 0; i < mapped.Matrix().n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], (double) i);
+  }
+
+  remove("test_file.csv");
+  remove("test_file.bin");
+}
+
+/**
+ * Make sure mlpack matrix files round-trip through data::Save() and
+ * data::Load(), with and without labels, and without being transposed.
+ */
+BOOST_AUTO_TEST_CASE(MatrixFileTest)
+{
+  arma::mat test;
+  test.randu(5, 30);
+
+  BOOST_REQUIRE(data::Save("test_file.mlb", test) == true);
+
+  arma::mat loaded;
+  BOOST_REQUIRE(data::Load("test_file.mlb", loaded) == true);
+  BOOST_REQUIRE_EQUAL(loaded.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(loaded.n_cols, 30);
+  for (size_t i = 0; i < test.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], test[i]);
+
+  // Loading into another type converts the elements.
+  arma::fmat floatLoaded;
+  BOOST_REQUIRE(data::Load("test_file.mlb", floatLoaded) == true);
+  BOOST_REQUIRE_EQUAL(floatLoaded.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(floatLoaded.n_cols, 30);
+  for (size_t i = 0; i < test.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(floatLoaded[i], (float) test[i], 1e-5);
+
+  // The file can be memory-mapped too.
+  {
+    data::MappedMatrix mapped("test_file.mlb");
+    for (size_t i = 0; i < test.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], test[i]);
+  }
+
+  // There are no labels in the file.
+  arma::Row<size_t> labels;
+  BOOST_REQUIRE(data::Load("test_file.mlb", loaded, labels) == true);
+  BOOST_REQUIRE_EQUAL(labels.n_elem, 0);
+
+  arma::Row<size_t> testLabels(30);
+  for (size_t i = 0; i < testLabels.n_elem; ++i)
+    testLabels[i] = 3 * i;
+
+  // A .bin extension works too when loading.
+  BOOST_REQUIRE(data::Save("test_file.bin", test, testLabels) == true);
+  BOOST_REQUIRE(data::Load("test_file.bin", loaded, labels) == true);
+  BOOST_REQUIRE_EQUAL(loaded.n_rows, 5);
+  BOOST_REQUIRE_EQUAL(loaded.n_cols, 30);
+  BOOST_REQUIRE_EQUAL(labels.n_elem, 30);
+  for (size_t i = 0; i < test.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], test[i]);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(labels[i], 3 * i);
+
+  BOOST_REQUIRE(data::Load("test_file.bin", loaded) == true);
+  BOOST_REQUIRE_EQUAL(loaded.n_cols, 30);
+
+  // Labels can't be loaded from other files.
+  BOOST_REQUIRE(data::Save("test_file.csv", test) == true);
+  BOOST_REQUIRE(data::Load("test_file.csv", loaded, labels) == false);
+
+  remove("test_file.mlb");
+  remove("test_file.bin");
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure the parallel text parser gives exactly what strtod() would, for
+ * numbers in many formats, and handles blank lines and CRLF line endings.
+ */
+BOOST_AUTO_TEST_CASE(ParseTextTest)
+{
+  arma::mat values(3, 2000);
+  std::vector<std::string> written(values.n_elem);
+  std::fstream f;
+  f.open("test_file.csv", std::fstream::out);
+  for (size_t i = 0; i < values.n_cols; ++i)
+  {
+    for (size_t j = 0; j < values.n_rows; ++j)
+    {
+      // Mix short decimals (the fast path), full precision, and exponents.
+      std::ostringstream oss;
+      const double value = (math::Random() - 0.5) * std::pow(10.0,
+          math::RandInt(-30, 30));
+      if (j == 0)
+        oss << std::fixed << std::setprecision(4) << (value / 1e25);
+      else if (j == 1)
+        oss << std::setprecision(17) << value;
+      else
+        oss << std::scientific << std::setprecision(6) << value;
+
+      written[i * values.n_rows + j] = oss.str();
+      values(j, i) = strtod(oss.str().c_str(), NULL);
+      f << oss.str() << ((j == values.n_rows - 1) ? "" : ", ");
+    }
+    f << ((i % 3 == 0) ? "\r\n" : "\n");
+    if (i % 100 == 0)
+      f << std::endl; // A blank line.
+  }
+  f.close();
+
+  arma::mat parsed;
+  BOOST_REQUIRE(data::ParseText("test_file.csv", parsed) == true);
+  BOOST_REQUIRE_EQUAL(parsed.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(parsed.n_cols, 2000);
+  for (size_t i = 0; i < values.n_elem; ++i)
+  {
+    BOOST_REQUIRE_MESSAGE(parsed[i] == values[i], "value '" << written[i]
+        << "' parsed as " << parsed[i]);
+  }
+
+  // data::Load() uses the parser too.
+  arma::mat loaded;
+  BOOST_REQUIRE(data::Load("test_file.csv", loaded) == true);
+  BOOST_REQUIRE_EQUAL(loaded.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(loaded.n_cols, 2000);
+  for (size_t i = 0; i < values.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], values[i]);
+
+  // Whitespace-separated values work too.
+  f.open("test_file.txt", std::fstream::out);
+  f << "1 2.5\t-3" << std::endl << "4e2 5 6" << std::endl;
+  f.close();
+
+  BOOST_REQUIRE(data::ParseText("test_file.txt", parsed) == true);
+  BOOST_REQUIRE_EQUAL(parsed.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(parsed.n_cols, 2);
+  BOOST_REQUIRE_EQUAL(parsed(0, 0), 1.0);
+  BOOST_REQUIRE_EQUAL(parsed(1, 0), 2.5);
+  BOOST_REQUIRE_EQUAL(parsed(2, 0), -3.0);
+  BOOST_REQUIRE_EQUAL(parsed(0, 1), 400.0);
+  BOOST_REQUIRE_EQUAL(parsed(1, 1), 5.0);
+  BOOST_REQUIRE_EQUAL(parsed(2, 1), 6.0);
+
+  // A header, empty values, or a wrong number of values make the parser give
+  // up, so data::Load() can fall back to Armadillo.
+  f.open("test_file.csv", std::fstream::out);
+  f << "a, b, c" << std::endl << "1, 2, 3" << std::endl;
+  f.close();
+  BOOST_REQUIRE(data::ParseText("test_file.csv", parsed) == false);
+
+  f.open("test_file.csv", std::fstream::out);
+  f << "1, , 3" << std::endl << "1, 2, 3" << std::endl;
+  f.close();
+  BOOST_REQUIRE(data::ParseText("test_file.csv", parsed) == false);
+
+  f.open("test_file.csv", std::fstream::out);
+  f << "1, 2, 3" << std::endl << "1, 2" << std::endl;
+  f.close();
+  BOOST_REQUIRE(data::ParseText("test_file.csv", parsed) == false);
+
+  remove("test_file.csv");
+  remove("test_file.txt");
+}
+
+/**
+ * Make sure a CSV with string values is loaded with the strings of each
+ * categorical dimension mapped to indices in the order they first appear.
+ */
+BOOST_AUTO_TEST_CASE(LoadCategoricalTest)
+{
+  std::fstream f;
+  f.open("test_file.csv", std::fstream::out);
+  f << "1, hello, 3.5, \"a b\"" << std::endl;
+  f << "2, goodbye, 4, c" << std::endl;
+  f << std::endl;
+  f << "3, hello, -1e2, 7" << std::endl;
+  f.close();
+
+  arma::mat matrix;
+  data::DatasetInfo info;
+  BOOST_REQUIRE(data::Load("test_file.csv", matrix, info) == true);
+
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(info.Dimensionality(), 4);
+
+  BOOST_REQUIRE(info.Type(0) == data::NUMERIC);
+  BOOST_REQUIRE(info.Type(1) == data::CATEGORICAL);
+  BOOST_REQUIRE(info.Type(2) == data::NUMERIC);
+  BOOST_REQUIRE(info.Type(3) == data::CATEGORICAL);
+
+  BOOST_REQUIRE_EQUAL(matrix(0, 0), 1.0);
+  BOOST_REQUIRE_EQUAL(matrix(0, 1), 2.0);
+  BOOST_REQUIRE_EQUAL(matrix(0, 2), 3.0);
+  BOOST_REQUIRE_EQUAL(matrix(2, 0), 3.5);
+  BOOST_REQUIRE_EQUAL(matrix(2, 1), 4.0);
+  BOOST_REQUIRE_EQUAL(matrix(2, 2), -100.0);
+
+  BOOST_REQUIRE_EQUAL(info.NumMappings(1), 2);
+  BOOST_REQUIRE_EQUAL(matrix(1, 0), 0.0);
+  BOOST_REQUIRE_EQUAL(matrix(1, 1), 1.0);
+  BOOST_REQUIRE_EQUAL(matrix(1, 2), 0.0);
+  BOOST_REQUIRE_EQUAL(info.UnmapString(0, 1), "hello");
+  BOOST_REQUIRE_EQUAL(info.UnmapString(1, 1), "goodbye");
+
+  // Numbers in a categorical dimension are strings too.
+  BOOST_REQUIRE_EQUAL(info.NumMappings(3), 3);
+  BOOST_REQUIRE_EQUAL(info.UnmapString((size_t) matrix(3, 0), 3), "a b");
+  BOOST_REQUIRE_EQUAL(info.UnmapString((size_t) matrix(3, 1), 3), "c");
+  BOOST_REQUIRE_EQUAL(info.UnmapString((size_t) matrix(3, 2), 3), "7");
+
+  // A line with the wrong number of values makes the load fail.
+  f.open("test_file.csv", std::fstream::out);
+  f << "1, a" << std::endl << "2, b, 3" << std::endl;
+  f.close();
+  BOOST_REQUIRE(data::Load("test_file.csv", matrix, info) == false);
+
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure the indices of the strings of a file large enough to be split
+ * between threads are the same as if it were parsed sequentially.
+ */
+BOOST_AUTO_TEST_CASE(LoadLargeCategoricalTest)
+{
+  std::fstream f;
+  f.open("test_file.txt", std::fstream::out);
+  std::vector<size_t> categories(20000);
+  for (size_t i = 0; i < categories.size(); ++i)
+  {
+    categories[i] = (size_t) math::RandInt(0, 1000);
+    f << i << " category" << categories[i] << std::endl;
+  }
+  f.close();
+
+  arma::mat matrix;
+  data::DatasetInfo info;
+  BOOST_REQUIRE(data::Load("test_file.txt", matrix, info) == true);
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, categories.size());
+  BOOST_REQUIRE(info.Type(0) == data::NUMERIC);
+  BOOST_REQUIRE(info.Type(1) == data::CATEGORICAL);
+
+  // Map the strings sequentially to get the expected indices.
+  data::DatasetInfo expected(2);
+  for (size_t i = 0; i < categories.size(); ++i)
+  {
+    std::ostringstream category;
+    category << "category" << categories[i];
+
+    BOOST_REQUIRE_EQUAL(matrix(0, i), (double) i);
+    BOOST_REQUIRE_EQUAL((size_t) matrix(1, i), expected.MapString(
+        category.str(), 1));
+  }
+  BOOST_REQUIRE_EQUAL(info.NumMappings(1), expected.NumMappings(1));
+
+  remove("test_file.txt");
+}
+
+/**
+ * Make sure that placing a loaded matrix on the NUMA nodes does not change it,
+ * and that small matrices are left alone.
+ */
+BOOST_AUTO_TEST_CASE(PlaceMatrixTest)
+{
+  arma::mat dataset(100, 2000);
+  dataset.randu();
+  BOOST_REQUIRE(data::Save("test_file.bin", dataset) == true);
+
+  util::SetMemoryPlacement(util::FIRST_TOUCH_PLACEMENT);
+  util::SetHugePages(true);
+
+  // data::Load() places the matrix it loads.
+  arma::mat loaded;
+  BOOST_REQUIRE(data::Load("test_file.bin", loaded) == true);
+  BOOST_REQUIRE_EQUAL(loaded.n_rows, dataset.n_rows);
+  BOOST_REQUIRE_EQUAL(loaded.n_cols, dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded[i], dataset[i]);
+
+  arma::mat placed = dataset;
+  util::PlaceMatrix(placed);
+  BOOST_REQUIRE_EQUAL(placed.n_rows, dataset.n_rows);
+  BOOST_REQUIRE_EQUAL(placed.n_cols, dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(placed[i], dataset[i]);
+
+  // A matrix below the threshold keeps its memory.
+  arma::mat small(10, 10);
+  small.randu();
+  const double* memory = small.memptr();
+  util::PlaceMatrix(small);
+  BOOST_REQUIRE(small.memptr() == memory);
+
+  util::SetMemoryPlacement(util::DEFAULT_PLACEMENT);
+  util::SetHugePages(false);
+
+  remove("test_file.bin");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -63,7 +63,7 @@ BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestCodingStep)
   lcc.OptimizeCode();
 
   mat D = lcc.Dictionary();
-  mat Z = lcc.Codes();
+  mat Z(lcc.Codes());
 
   for(uword i = 0; i < nPoints; i++) {
     vec sq_dists = vec(nAtoms);
@@ -98,9 +98,8 @@ BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestDictionaryStep)
 
   LocalCoordinateCoding<> lcc(X, nAtoms, lambda);
   lcc.OptimizeCode();
-  mat Z = lcc.Codes();
-  uvec adjacencies = find(Z);
-  lcc.OptimizeDictionary(adjacencies);
+  mat Z(lcc.Codes());
+  lcc.OptimizeDictionary();
 
   mat D = lcc.Dictionary();
 
@@ -116,6 +115,54 @@ BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestDictionaryStep)
 
 }
 
+/**
+ * The objective computed from the cached norms is the objective computed from
+ * the differences of the points and atoms, also after the dictionary is
+ * changed through Dictionary().
+ */
+BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestObjective)
+{
+  double lambda = 0.1;
+  uword nAtoms = 25;
+
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+  uword nPoints = X.n_cols;
+
+  // normalize each point since these are images
+  for (uword i = 0; i < nPoints; i++)
+  {
+    X.col(i) /= norm(X.col(i), 2);
+  }
+
+  LocalCoordinateCoding<> lcc(X, nAtoms, lambda);
+  lcc.OptimizeCode();
+
+  // Reading the dictionary through a const reference keeps the cached norms.
+  const LocalCoordinateCoding<>& constLcc = lcc;
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    const mat& D = constLcc.Dictionary();
+    const mat Z(constLcc.Codes());
+
+    double weightedL1NormZ = 0.0;
+    for (uword i = 0; i < nPoints; i++)
+    {
+      for (uword j = 0; j < nAtoms; j++)
+      {
+        vec diff = D.unsafe_col(j) - X.unsafe_col(i);
+        weightedL1NormZ += fabs(Z(j, i)) * dot(diff, diff);
+      }
+    }
+    const double objective = std::pow(norm(X - D * Z, "fro"), 2.0) +
+        lambda * weightedL1NormZ;
+
+    BOOST_REQUIRE_CLOSE(lcc.Objective(), objective, 1e-8);
+
+    lcc.Dictionary() *= 2.0;
+  }
+}
+
 /*
 BOOST_AUTO_TEST_CASE(LocalCoordinateCodingTestWhole)
 {
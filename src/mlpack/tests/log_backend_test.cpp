@@ -0,0 +1,189 @@
+/**
+ * @file log_backend_test.cpp
+ *
+ * Tests for the asynchronous backend of the Log streams, the ProgressReporter,
+ * and the logging macros.
+ */
+#include <mlpack/core.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+#include <sstream>
+
+using namespace mlpack;
+using namespace mlpack::util;
+
+BOOST_AUTO_TEST_SUITE(LogBackendTest);
+
+/**
+ * An asynchronous stream writes each line once it is finished, with the
+ * prefix, and applies manipulators to the values after them.
+ */
+BOOST_AUTO_TEST_CASE(AsynchronousLineTest)
+{
+  std::stringstream ss;
+  PrefixedOutStream pss(ss, "[TEST] ");
+
+  BOOST_REQUIRE(LogBackend::Start());
+  BOOST_REQUIRE(LogBackend::Asynchronous());
+
+  pss << "hello world I am ";
+  pss << 7;
+  LogBackend::Flush();
+  BOOST_REQUIRE_EQUAL(ss.str(), "");
+
+  pss << std::endl;
+  LogBackend::Flush();
+  BOOST_REQUIRE_EQUAL(ss.str(), "[TEST] hello world I am 7\n");
+
+  ss.str("");
+  pss << "a number: " << std::setw(6) << std::setfill('0') << 156
+      << "\nand another line\n" << "and the start of a third";
+  LogBackend::Flush();
+  BOOST_REQUIRE_EQUAL(ss.str(), "[TEST] a number: 000156\n"
+      "[TEST] and another line\n");
+
+  pss << "." << std::endl;
+  LogBackend::Stop();
+  BOOST_REQUIRE(!LogBackend::Asynchronous());
+  BOOST_REQUIRE_EQUAL(ss.str(), "[TEST] a number: 000156\n"
+      "[TEST] and another line\n"
+      "[TEST] and the start of a third.\n");
+
+  // Once stopped, the stream is synchronous again.
+  ss.str("");
+  pss << "now";
+  BOOST_REQUIRE_EQUAL(ss.str(), "[TEST] now");
+  pss << std::endl;
+}
+
+/**
+ * Lines written by several threads at once are never mixed, and none are
+ * lost.
+ */
+BOOST_AUTO_TEST_CASE(AsynchronousThreadsTest)
+{
+  std::stringstream ss;
+  PrefixedOutStream pss(ss, "[TEST] ");
+
+  BOOST_REQUIRE(LogBackend::Start());
+
+  const int lines = 2000;
+  #pragma omp parallel for
+  for (int i = 0; i < lines; ++i)
+    pss << "line " << i << " of " << lines << std::endl;
+
+  LogBackend::Stop();
+
+  std::vector<size_t> seen(lines, 0);
+  std::string line;
+  size_t count = 0;
+  while (std::getline(ss, line))
+  {
+    std::istringstream parse(line);
+    std::string prefix, word, of;
+    int i = -1, total = 0;
+    parse >> prefix >> word >> i >> of >> total;
+    BOOST_REQUIRE_EQUAL(prefix, "[TEST]");
+    BOOST_REQUIRE_EQUAL(word, "line");
+    BOOST_REQUIRE_EQUAL(of, "of");
+    BOOST_REQUIRE_EQUAL(total, lines);
+    BOOST_REQUIRE(i >= 0 && i < lines);
+    BOOST_REQUIRE(parse.eof());
+    ++seen[i];
+    ++count;
+  }
+
+  BOOST_REQUIRE_EQUAL(count, (size_t) lines);
+  for (int i = 0; i < lines; ++i)
+    BOOST_REQUIRE_EQUAL(seen[i], 1);
+}
+
+/**
+ * The ProgressReporter reports nothing when Log::Info is not shown, and at
+ * most once per interval when it is.
+ */
+BOOST_AUTO_TEST_CASE(ProgressReporterTest)
+{
+  const bool ignoring = Log::Info.ignoreInput;
+
+  // Catch the output of Log::Info.
+  std::stringstream ss;
+  std::streambuf* coutBuffer = std::cout.rdbuf(ss.rdbuf());
+
+  Log::Info.ignoreInput = true;
+  ProgressReporter hidden("hidden", 10, 0.0);
+  for (size_t i = 0; i < 10; ++i)
+    hidden.Update(i + 1);
+  hidden.Finish(10);
+  BOOST_REQUIRE_EQUAL(hidden.Reports(), 0);
+
+  Log::Info.ignoreInput = false;
+  ProgressReporter rare("rare", 100, 1000.0);
+  for (size_t i = 0; i < 100; ++i)
+    rare.Update(i + 1);
+  BOOST_REQUIRE_EQUAL(rare.Reports(), 0);
+  BOOST_REQUIRE(!rare.Due());
+
+  ProgressReporter always("always", 4, 0.0);
+  for (size_t i = 0; i < 4; ++i)
+    always.Update(i + 1);
+  always.Finish(4);
+  BOOST_REQUIRE_EQUAL(always.Reports(), 5);
+
+  std::cout.rdbuf(coutBuffer);
+  Log::Info.ignoreInput = ignoring;
+
+  const std::string output = ss.str();
+  BOOST_REQUIRE(output.find("hidden") == std::string::npos);
+  BOOST_REQUIRE(output.find("rare") == std::string::npos);
+  BOOST_REQUIRE(output.find("always: 1/4 (25.0%)") != std::string::npos);
+  BOOST_REQUIRE(output.find("always: 4 done in ") != std::string::npos);
+}
+
+//! Count the number of times it is called.
+size_t CountCall(size_t& calls)
+{
+  return ++calls;
+}
+
+/**
+ * The values given to MLPACK_LOG_INFO are not computed when Log::Info is not
+ * shown, and those given to MLPACK_LOG_DEBUG only in debug mode.
+ */
+BOOST_AUTO_TEST_CASE(LogMacroTest)
+{
+  const bool ignoring = Log::Info.ignoreInput;
+  size_t calls = 0;
+
+  Log::Info.ignoreInput = true;
+  MLPACK_LOG_INFO << "Call " << CountCall(calls) << "." << std::endl;
+  BOOST_REQUIRE_EQUAL(calls, 0);
+
+  // The macro is a single statement.
+  if (calls == 0)
+    MLPACK_LOG_INFO << "Call " << CountCall(calls) << "." << std::endl;
+  else
+    calls = 10;
+  BOOST_REQUIRE_EQUAL(calls, 0);
+
+  std::stringstream ss;
+  std::streambuf* coutBuffer = std::cout.rdbuf(ss.rdbuf());
+
+  Log::Info.ignoreInput = false;
+  MLPACK_LOG_INFO << "Call " << CountCall(calls) << "." << std::endl;
+  BOOST_REQUIRE_EQUAL(calls, 1);
+
+  MLPACK_LOG_DEBUG << "Call " << CountCall(calls) << "." << std::endl;
+#ifdef DEBUG
+  BOOST_REQUIRE_EQUAL(calls, 2);
+#else
+  BOOST_REQUIRE_EQUAL(calls, 1);
+#endif
+
+  std::cout.rdbuf(coutBuffer);
+  Log::Info.ignoreInput = ignoring;
+}
+
+BOOST_AUTO_TEST_SUITE_END();
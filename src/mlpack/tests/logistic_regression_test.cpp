@@ -7,6 +7,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/logistic_regression/logistic_regression.hpp>
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/distributed_function/distributed_function.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -29,7 +30,7 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionEvaluate)
   arma::vec responses("1 1 0");
 
   // Create a LogisticRegressionFunction.
-  LogisticRegressionFunction lrf(data, responses, 0.0 /* no regularization */);
+  LogisticRegressionFunction<> lrf(data, responses, 0.0 /* no reg. */);
 
   // These were hand-calculated using Octave.
   BOOST_REQUIRE_CLOSE(lrf.Evaluate(arma::vec("1 1 1")), 7.0562141665, 1e-5);
@@ -57,7 +58,7 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionRandomEvaluate)
   for (size_t i = 0; i < points; ++i)
     responses[i] = math::RandInt(0, 2);
 
-  LogisticRegressionFunction lrf(data, responses, 0.0 /* no regularization */);
+  LogisticRegressionFunction<> lrf(data, responses, 0.0 /* no reg. */);
 
   // Run a bunch of trials.
   for (size_t i = 0; i < trials; ++i)
@@ -99,9 +100,9 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionRegularizationEvaluate)
   for (size_t i = 0; i < points; ++i)
     responses[i] = math::RandInt(0, 2);
 
-  LogisticRegressionFunction lrfNoReg(data, responses, 0.0);
-  LogisticRegressionFunction lrfSmallReg(data, responses, 0.5);
-  LogisticRegressionFunction lrfBigReg(data, responses, 20.0);
+  LogisticRegressionFunction<> lrfNoReg(data, responses, 0.0);
+  LogisticRegressionFunction<> lrfSmallReg(data, responses, 0.5);
+  LogisticRegressionFunction<> lrfBigReg(data, responses, 20.0);
 
   for (size_t i = 0; i < trials; ++i)
   {
@@ -133,7 +134,7 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionGradient)
   arma::vec responses("1 1 0");
 
   // Create a LogisticRegressionFunction.
-  LogisticRegressionFunction lrf(data, responses, 0.0 /* no regularization */);
+  LogisticRegressionFunction<> lrf(data, responses, 0.0 /* no reg. */);
   arma::vec gradient;
 
   // If the model is at the optimum, then the gradient should be zero.
@@ -182,7 +183,7 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionSeparableEvaluate)
   arma::vec responses("1 1 0");
 
   // Create a LogisticRegressionFunction.
-  LogisticRegressionFunction lrf(data, responses, 0.0 /* no regularization */);
+  LogisticRegressionFunction<> lrf(data, responses, 0.0 /* no reg. */);
 
   // These were hand-calculated using Octave.
   BOOST_REQUIRE_CLOSE(lrf.Evaluate(arma::vec("1 1 1"), 0), 4.85873516e-2, 1e-5);
@@ -231,9 +232,9 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionRegularizationSeparableEvaluate)
   for (size_t i = 0; i < points; ++i)
     responses[i] = math::RandInt(0, 2);
 
-  LogisticRegressionFunction lrfNoReg(data, responses, 0.0);
-  LogisticRegressionFunction lrfSmallReg(data, responses, 0.5);
-  LogisticRegressionFunction lrfBigReg(data, responses, 20.0);
+  LogisticRegressionFunction<> lrfNoReg(data, responses, 0.0);
+  LogisticRegressionFunction<> lrfSmallReg(data, responses, 0.5);
+  LogisticRegressionFunction<> lrfBigReg(data, responses, 20.0);
 
   // Check that the number of functions is correct.
   BOOST_REQUIRE_EQUAL(lrfNoReg.NumFunctions(), points);
@@ -273,7 +274,7 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionSeparableGradient)
   arma::vec responses("1 1 0");
 
   // Create a LogisticRegressionFunction.
-  LogisticRegressionFunction lrf(data, responses, 0.0 /* no regularization */);
+  LogisticRegressionFunction<> lrf(data, responses, 0.0 /* no reg. */);
   arma::vec gradient;
 
   // If the model is at the optimum, then the gradient should be zero.
@@ -354,9 +355,9 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionRegularizationGradient)
   for (size_t i = 0; i < points; ++i)
     responses[i] = math::RandInt(0, 2);
 
-  LogisticRegressionFunction lrfNoReg(data, responses, 0.0);
-  LogisticRegressionFunction lrfSmallReg(data, responses, 0.5);
-  LogisticRegressionFunction lrfBigReg(data, responses, 20.0);
+  LogisticRegressionFunction<> lrfNoReg(data, responses, 0.0);
+  LogisticRegressionFunction<> lrfSmallReg(data, responses, 0.5);
+  LogisticRegressionFunction<> lrfBigReg(data, responses, 20.0);
 
   for (size_t i = 0; i < trials; ++i)
   {
@@ -416,9 +417,9 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionRegularizationSeparableGradient)
   for (size_t i = 0; i < points; ++i)
     responses[i] = math::RandInt(0, 2);
 
-  LogisticRegressionFunction lrfNoReg(data, responses, 0.0);
-  LogisticRegressionFunction lrfSmallReg(data, responses, 0.5);
-  LogisticRegressionFunction lrfBigReg(data, responses, 20.0);
+  LogisticRegressionFunction<> lrfNoReg(data, responses, 0.0);
+  LogisticRegressionFunction<> lrfSmallReg(data, responses, 0.5);
+  LogisticRegressionFunction<> lrfBigReg(data, responses, 20.0);
 
   for (size_t i = 0; i < trials; ++i)
   {
@@ -497,8 +498,8 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionSGDSimpleTest)
 
   // Create a logistic regression object using a custom SGD object with a much
   // smaller tolerance.
-  LogisticRegressionFunction lrf(data, responses, 0.001);
-  SGD<LogisticRegressionFunction> sgd(lrf, 0.005, 500000, 1e-10);
+  LogisticRegressionFunction<> lrf(data, responses, 0.001);
+  SGD<LogisticRegressionFunction<> > sgd(lrf, 0.005, 500000, 1e-10);
   LogisticRegression<SGD> lr(sgd);
 
   // Test sigmoid function.
@@ -513,6 +514,136 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionSGDSimpleTest)
   BOOST_REQUIRE_SMALL(sigmoids[2], 0.1);
 }
 
+/**
+ * The batch gradient of the logistic regression function should be the sum of
+ * the gradients of the points in the batch.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionBatchGradient)
+{
+  arma::mat data;
+  data.randu(5, 100);
+  arma::vec responses(100);
+  for (size_t i = 0; i < 100; ++i)
+    responses[i] = math::RandInt(0, 2);
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.3);
+  arma::mat parameters;
+  parameters.randn(6, 1);
+
+  const size_t begins[3] = { 0, 17, 91 };
+  const size_t batchSizes[3] = { 1, 40, 9 };
+  for (size_t b = 0; b < 3; ++b)
+  {
+    arma::mat gradient, pointGradient;
+    arma::mat sum = arma::zeros<arma::mat>(6, 1);
+    for (size_t i = begins[b]; i < begins[b] + batchSizes[b]; ++i)
+    {
+      lrf.Gradient(parameters, i, pointGradient);
+      sum += pointGradient;
+    }
+
+    lrf.Gradient(parameters, begins[b], batchSizes[b], gradient);
+    BOOST_REQUIRE_EQUAL(gradient.n_rows, 6);
+    BOOST_REQUIRE_EQUAL(gradient.n_cols, 1);
+    for (size_t i = 0; i < 6; ++i)
+      BOOST_REQUIRE_CLOSE(gradient[i], sum[i], 1e-5);
+  }
+}
+
+/**
+ * EvaluateWithGradient() should give the same objective and gradient as
+ * Evaluate() and the separable gradients, also when the points are split over
+ * several blocks.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionEvaluateWithGradient)
+{
+  const size_t points = 1000;
+
+  arma::mat data;
+  data.randu(5, points);
+  arma::vec responses(points);
+  for (size_t i = 0; i < points; ++i)
+    responses[i] = math::RandInt(0, 2);
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.3);
+  arma::mat parameters;
+  parameters.randn(6, 1);
+
+  arma::mat pointGradient;
+  arma::mat sum = arma::zeros<arma::mat>(6, 1);
+  for (size_t i = 0; i < points; ++i)
+  {
+    lrf.Gradient(parameters, i, pointGradient);
+    sum += pointGradient;
+  }
+
+  arma::mat gradient;
+  const double objective = lrf.EvaluateWithGradient(parameters, gradient);
+  BOOST_REQUIRE_CLOSE(objective, lrf.Evaluate(parameters), 1e-5);
+  BOOST_REQUIRE_EQUAL(gradient.n_rows, 6);
+  BOOST_REQUIRE_EQUAL(gradient.n_cols, 1);
+  for (size_t i = 0; i < 6; ++i)
+    BOOST_REQUIRE_CLOSE(gradient[i], sum[i], 1e-5);
+
+  lrf.Gradient(parameters, gradient);
+  for (size_t i = 0; i < 6; ++i)
+    BOOST_REQUIRE_CLOSE(gradient[i], sum[i], 1e-5);
+}
+
+/**
+ * Mini-batch SGD should be able to train on the simple dataset too.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionMiniBatchSGDSimpleTest)
+{
+  // Very simple fake dataset.
+  arma::mat data("1 2 3;"
+                 "1 2 3");
+  arma::vec responses("1 1 0");
+
+  // The batch gradient is averaged, so the step size is larger than for
+  // regular SGD.
+  LogisticRegressionFunction<> lrf(data, responses, 0.001);
+  SGD<LogisticRegressionFunction<> > sgd(lrf, 0.01, 500000, 1e-10, true, 2);
+  LogisticRegression<SGD> lr(sgd);
+
+  arma::vec sigmoids = 1 / (1 + arma::exp(-lr.Parameters()[0]
+      - data.t() * lr.Parameters().subvec(1, lr.Parameters().n_elem - 1)));
+
+  BOOST_REQUIRE_CLOSE(sigmoids[0], 1.0, 3.0);
+  BOOST_REQUIRE_CLOSE(sigmoids[1], 1.0, 12.0);
+  BOOST_REQUIRE_SMALL(sigmoids[2], 0.1);
+}
+
+/**
+ * SGD with a fixed update policy should work as the optimizer of logistic
+ * regression too.
+ */
+template<template<typename> class OptimizerType>
+void UpdatePolicySGDSimpleTest(const double stepSize)
+{
+  arma::mat data("1 2 3;"
+                 "1 2 3");
+  arma::vec responses("1 1 0");
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.001);
+  OptimizerType<LogisticRegressionFunction<> > sgd(lrf, stepSize, 500000,
+      1e-10);
+  LogisticRegression<OptimizerType> lr(sgd);
+
+  arma::vec sigmoids = 1 / (1 + arma::exp(-lr.Parameters()[0]
+      - data.t() * lr.Parameters().subvec(1, lr.Parameters().n_elem - 1)));
+
+  BOOST_REQUIRE_CLOSE(sigmoids[0], 1.0, 3.0);
+  BOOST_REQUIRE_CLOSE(sigmoids[1], 1.0, 12.0);
+  BOOST_REQUIRE_SMALL(sigmoids[2], 0.1);
+}
+
+BOOST_AUTO_TEST_CASE(LogisticRegressionUpdatePolicySGDSimpleTest)
+{
+  UpdatePolicySGDSimpleTest<MomentumSGD>(0.005);
+  UpdatePolicySGDSimpleTest<AdamSGD>(0.01);
+}
+
 // Test training of logistic regression on a simple dataset with regularization.
 BOOST_AUTO_TEST_CASE(LogisticRegressionLBFGSRegularizationSimpleTest)
 {
@@ -546,8 +677,8 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionSGDRegularizationSimpleTest)
 
   // Create a logistic regression object using custom SGD with a much smaller
   // tolerance.
-  LogisticRegressionFunction lrf(data, responses, 0.001);
-  SGD<LogisticRegressionFunction> sgd(lrf, 0.005, 500000, 1e-10);
+  LogisticRegressionFunction<> lrf(data, responses, 0.001);
+  SGD<LogisticRegressionFunction<> > sgd(lrf, 0.005, 500000, 1e-10);
   LogisticRegression<SGD> lr(sgd);
 
   // Test sigmoid function.
@@ -666,8 +797,8 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionInstantiatedOptimizer)
   arma::vec responses("1 1 0");
 
   // Create an optimizer and function.
-  LogisticRegressionFunction lrf(data, responses, 0.0005);
-  L_BFGS<LogisticRegressionFunction> lbfgsOpt(lrf);
+  LogisticRegressionFunction<> lrf(data, responses, 0.0005);
+  L_BFGS<LogisticRegressionFunction<> > lbfgsOpt(lrf);
   lbfgsOpt.MinGradientNorm() = 1e-50;
   LogisticRegression<L_BFGS> lr(lbfgsOpt);
 
@@ -681,7 +812,7 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionInstantiatedOptimizer)
   BOOST_REQUIRE_SMALL(sigmoids[2], 0.1);
 
   // Now do the same with SGD.
-  SGD<LogisticRegressionFunction> sgdOpt(lrf);
+  SGD<LogisticRegressionFunction<> > sgdOpt(lrf);
   sgdOpt.StepSize() = 0.15;
   sgdOpt.Tolerance() = 1e-75;
   LogisticRegression<SGD> lr2(sgdOpt);
@@ -696,4 +827,205 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionInstantiatedOptimizer)
   BOOST_REQUIRE_SMALL(sigmoids[2], 0.1);
 }
 
+/**
+ * The LogisticRegressionFunction should give the same objective and gradients
+ * for sparse predictors as for the same predictors stored densely.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionSparsePredictors)
+{
+  const size_t points = 1000;
+  const size_t dimension = 50;
+
+  arma::sp_mat sparseData = arma::sprandu<arma::sp_mat>(dimension, points,
+      0.05);
+  arma::mat data(sparseData);
+  arma::vec responses(points);
+  for (size_t i = 0; i < points; ++i)
+    responses[i] = math::RandInt(0, 2);
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.3);
+  LogisticRegressionFunction<arma::sp_mat> sparseLrf(sparseData, responses,
+      0.3);
+
+  arma::mat parameters = arma::randn<arma::mat>(dimension + 1, 1);
+  BOOST_REQUIRE_CLOSE(sparseLrf.Evaluate(parameters), lrf.Evaluate(parameters),
+      1e-5);
+  BOOST_REQUIRE_CLOSE(sparseLrf.Evaluate(parameters, 11),
+      lrf.Evaluate(parameters, 11), 1e-5);
+
+  arma::mat gradient, sparseGradient;
+  lrf.Gradient(parameters, gradient);
+  sparseLrf.Gradient(parameters, sparseGradient);
+  BOOST_REQUIRE_EQUAL(sparseGradient.n_elem, dimension + 1);
+  for (size_t j = 0; j < gradient.n_elem; ++j)
+    BOOST_REQUIRE_CLOSE(sparseGradient[j], gradient[j], 1e-5);
+
+  lrf.Gradient(parameters, 11, gradient);
+  sparseLrf.Gradient(parameters, 11, sparseGradient);
+  for (size_t j = 0; j < gradient.n_elem; ++j)
+  {
+    if (std::abs(gradient[j]) < 1e-10)
+      BOOST_REQUIRE_SMALL(sparseGradient[j], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(sparseGradient[j], gradient[j], 1e-5);
+  }
+
+  lrf.Gradient(parameters, 100, 37, gradient);
+  sparseLrf.Gradient(parameters, 100, 37, sparseGradient);
+  for (size_t j = 0; j < gradient.n_elem; ++j)
+    BOOST_REQUIRE_CLOSE(sparseGradient[j], gradient[j], 1e-5);
+}
+
+/**
+ * Training on sparse predictors should give the same model as training on the
+ * same predictors stored densely, and the model should predict the same
+ * responses for both.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionSparseTraining)
+{
+  const size_t points = 500;
+  const size_t dimension = 20;
+
+  arma::sp_mat sparseData = arma::sprandu<arma::sp_mat>(dimension, points,
+      0.2);
+  arma::mat data(sparseData);
+
+  // Label the points by a random hyperplane.
+  arma::vec weights = arma::randn<arma::vec>(dimension);
+  arma::vec responses(points);
+  for (size_t i = 0; i < points; ++i)
+    responses[i] = (arma::dot(data.col(i), weights) > 0) ? 1.0 : 0.0;
+
+  LogisticRegression<> lr(data, responses, 0.5);
+  LogisticRegression<L_BFGS, arma::sp_mat> sparseLr(sparseData, responses,
+      0.5);
+
+  for (size_t j = 0; j < lr.Parameters().n_elem; ++j)
+  {
+    if (std::abs(lr.Parameters()[j]) < 1e-5)
+      BOOST_REQUIRE_SMALL(sparseLr.Parameters()[j], 1e-5);
+    else
+      BOOST_REQUIRE_CLOSE(sparseLr.Parameters()[j], lr.Parameters()[j], 1e-3);
+  }
+
+  arma::vec predictions, sparsePredictions;
+  lr.Predict(data, predictions);
+  sparseLr.Predict(sparseData, sparsePredictions);
+  for (size_t i = 0; i < points; ++i)
+    BOOST_REQUIRE_EQUAL(sparsePredictions[i], predictions[i]);
+
+  BOOST_REQUIRE_CLOSE(sparseLr.ComputeError(sparseData, responses),
+      lr.ComputeError(data, responses), 1e-3);
+}
+
+/**
+ * A reducer for two nodes, in which this node is given and the values of the
+ * other node are set by hand.
+ */
+class TwoNodeReducer
+{
+ public:
+  TwoNodeReducer(const size_t rank = 0) : rank(rank) { }
+
+  void Sum(double* values, const size_t n)
+  {
+    BOOST_REQUIRE_EQUAL(n, other.n_elem);
+    for (size_t i = 0; i < n; ++i)
+      values[i] += other[i];
+  }
+
+  size_t Rank() const { return rank; }
+  size_t NumNodes() const { return 2; }
+
+  //! The values of the other node, for the next call to Sum().
+  arma::vec other;
+
+ private:
+  size_t rank;
+};
+
+/**
+ * The objective and gradient of the logistic regression function of one shard
+ * of the data, summed with those of the other shard by DistributedFunction,
+ * should be those of the whole dataset.
+ */
+BOOST_AUTO_TEST_CASE(DistributedLogisticRegressionFunctionTest)
+{
+  arma::mat data(3, 200, arma::fill::randn);
+  arma::vec responses(200);
+  for (size_t i = 0; i < 200; ++i)
+    responses[i] = (data(0, i) + 0.5 * data(2, i) > 0) ? 1 : 0;
+
+  // Each shard has half of the regularization.
+  LogisticRegressionFunction<> f(data, responses, 0.5);
+  arma::mat data1 = data.cols(0, 119);
+  arma::mat data2 = data.cols(120, 199);
+  arma::vec responses1 = responses.subvec(0, 119);
+  arma::vec responses2 = responses.subvec(120, 199);
+  LogisticRegressionFunction<> f1(data1, responses1, 0.25);
+  LogisticRegressionFunction<> f2(data2, responses2, 0.25);
+
+  // The initial point is that of the rank 0 node; this one is rank 1.
+  TwoNodeReducer reducer(1);
+  reducer.other.set_size(f1.GetInitialPoint().n_elem);
+  reducer.other.fill(0.3);
+  DistributedFunction<LogisticRegressionFunction<>, TwoNodeReducer> df(f1,
+      reducer);
+  for (size_t i = 0; i < df.GetInitialPoint().n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(df.GetInitialPoint()[i], 0.3, 1e-5);
+
+  const arma::mat point("0.1; -0.4; 0.7; 0.2");
+
+  arma::mat gradient, otherGradient, fullGradient;
+  const double otherObjective = f2.EvaluateWithGradient(point, otherGradient);
+  const double fullObjective = f.EvaluateWithGradient(point, fullGradient);
+
+  df.Reducer().other = arma::vec(1);
+  df.Reducer().other[0] = otherObjective;
+  BOOST_REQUIRE_CLOSE(df.Evaluate(point), fullObjective, 1e-5);
+
+  df.Reducer().other = arma::vectorise(otherGradient);
+  df.Gradient(point, gradient);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(gradient[i], fullGradient[i], 1e-5);
+
+  // The objective and gradient are reduced together.
+  df.Reducer().other.set_size(otherGradient.n_elem + 1);
+  df.Reducer().other.subvec(0, otherGradient.n_elem - 1) =
+      arma::vectorise(otherGradient);
+  df.Reducer().other[otherGradient.n_elem] = otherObjective;
+  gradient.zeros();
+  BOOST_REQUIRE_CLOSE(df.EvaluateWithGradient(point, gradient), fullObjective,
+      1e-5);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(gradient[i], fullGradient[i], 1e-5);
+}
+
+/**
+ * On a single node, optimizing through DistributedFunction should give exactly
+ * the same result as optimizing the function itself.
+ */
+BOOST_AUTO_TEST_CASE(DistributedLogisticRegressionLocalTest)
+{
+  arma::mat data(4, 300, arma::fill::randn);
+  arma::vec responses(300);
+  for (size_t i = 0; i < 300; ++i)
+    responses[i] = (data(1, i) - data(3, i) > 0.2) ? 1 : 0;
+
+  LogisticRegressionFunction<> f(data, responses, 0.1);
+  L_BFGS<LogisticRegressionFunction<> > lbfgs(f);
+  arma::mat parameters = f.GetInitialPoint();
+  const double objective = lbfgs.Optimize(parameters);
+
+  DistributedFunction<LogisticRegressionFunction<> > df(f);
+  L_BFGS<DistributedFunction<LogisticRegressionFunction<> > > distributed(df);
+  arma::mat distributedParameters = df.GetInitialPoint();
+  const double distributedObjective =
+      distributed.Optimize(distributedParameters);
+
+  BOOST_REQUIRE_EQUAL(objective, distributedObjective);
+  for (size_t i = 0; i < parameters.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(parameters[i], distributedParameters[i]);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
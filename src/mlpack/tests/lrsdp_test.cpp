@@ -131,6 +131,109 @@ BOOST_AUTO_TEST_CASE(Johnson844LovaszThetaSDP)
   }
 }
 
+/**
+ * The specialized EvaluateWithGradient() of the augmented Lagrangian LR-SDP
+ * function should give the same results as Evaluate() and Gradient().
+ */
+BOOST_AUTO_TEST_CASE(LRSDPEvaluateWithGradient)
+{
+  arma::mat edges;
+  data::Load("johnson8-4-4.csv", edges, true);
+
+  arma::mat coordinates;
+  createLovaszThetaInitialPoint(edges, coordinates);
+
+  LRSDP lovasz(edges.n_cols + 1, coordinates);
+  setupLovaszTheta(edges, lovasz);
+
+  AugLagrangianFunction<LRSDPFunction> augFunction(lovasz.Function(),
+      lovasz.AugLag().Lambda(), 10.0);
+
+  // Move away from the initial point, so that no constraint is satisfied.
+  coordinates += 0.1 * arma::randu<arma::mat>(coordinates.n_rows,
+      coordinates.n_cols);
+
+  arma::mat gradient, combinedGradient;
+  augFunction.Gradient(coordinates, gradient);
+  const double objective = augFunction.EvaluateWithGradient(coordinates,
+      combinedGradient);
+
+  BOOST_REQUIRE_CLOSE(objective, augFunction.Evaluate(coordinates), 1e-5);
+  BOOST_REQUIRE_EQUAL(combinedGradient.n_rows, gradient.n_rows);
+  BOOST_REQUIRE_EQUAL(combinedGradient.n_cols, gradient.n_cols);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(combinedGradient[i], gradient[i], 1e-5);
+}
+
+/**
+ * Dense, sparse, and low-rank representations of the same matrices should give
+ * the same constraints, objective, and gradients, and the gradient of the
+ * augmented Lagrangian should match a finite-difference estimate.
+ */
+BOOST_AUTO_TEST_CASE(LRSDPConstraintModes)
+{
+  const size_t n = 10;
+  const size_t rank = 3;
+
+  arma::mat v = arma::randu<arma::mat>(n, 2);
+  arma::mat dense = v * trans(v);
+
+  // All of the entries of the dense matrix.
+  arma::mat entries(3, n * n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      entries(0, i * n + j) = i;
+      entries(1, i * n + j) = j;
+      entries(2, i * n + j) = dense(i, j);
+    }
+  }
+
+  arma::mat coordinates = arma::randu<arma::mat>(n, rank);
+  LRSDPFunction f(3, coordinates);
+  f.A()[0] = dense;
+  f.A()[1] = entries;
+  f.A()[2] = v;
+  f.AModes()[0] = 0;
+  f.AModes()[1] = 1;
+  f.AModes()[2] = 2;
+  f.B().fill(1.5);
+  f.C() = entries;
+  f.CMode() = 1;
+
+  const double expected = trace(dense * coordinates * trans(coordinates));
+  BOOST_REQUIRE_CLOSE(f.Evaluate(coordinates), expected, 1e-5);
+
+  arma::mat gradient, constraintGradient;
+  f.Gradient(coordinates, gradient);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(f.EvaluateConstraint(i, coordinates), expected - 1.5,
+        1e-5);
+
+    f.GradientConstraint(i, coordinates, constraintGradient);
+    for (size_t j = 0; j < gradient.n_elem; ++j)
+      BOOST_REQUIRE_CLOSE(constraintGradient[j], gradient[j], 1e-5);
+  }
+
+  arma::vec lambda("0.5 -1.0 2.0");
+  AugLagrangianFunction<LRSDPFunction> augFunction(f, lambda, 3.0);
+  augFunction.Gradient(coordinates, gradient);
+
+  const double epsilon = 1e-6;
+  for (size_t j = 0; j < coordinates.n_elem; ++j)
+  {
+    coordinates[j] += epsilon;
+    const double plus = augFunction.Evaluate(coordinates);
+    coordinates[j] -= 2 * epsilon;
+    const double minus = augFunction.Evaluate(coordinates);
+    coordinates[j] += epsilon;
+
+    BOOST_REQUIRE_CLOSE((plus - minus) / (2 * epsilon), gradient[j], 1e-2);
+  }
+}
+
 /**
  * keller4.co test case for Lovasz-Theta LRSDP.
  * This is commented out because it takes a long time to run.
@@ -9,6 +9,7 @@
 #include "old_boost_test_definitions.hpp"
 
 #include <mlpack/methods/lsh/lsh_search.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 
 using namespace std;
 using namespace mlpack;
@@ -61,16 +62,14 @@ BOOST_AUTO_TEST_CASE(LSHSearchTest)
   LSHSearch<> lsh_test(rdata, qdata, 3, 2, hashWidth, 11, 3);
 //   LSHSearch<> lsh_test(rdata, qdata, 3, 2, 0.0, 11, 3);
 
-  // Given this, the 'LSHSearch::bucketRowInHashTable' should be:
-  // COR.SOL.: [2 11 4 7 6 3 11 0 5 1 8]
-  //
-  // The 'LSHSearch::bucketContentSize' should be:
+  // Given this, the number of points in each bucket should be:
   // COR.SOL.: [2 0 1 1 3 1 0 3 3 3 1]
   //
-  // The final hash table 'LSHSearch::secondHashTable' should be
-  // of size (3 x 9) with the following content:
-  // COR.SOL.:
-  // [0 2 4; 1 7 8; 3 9 10; 5 10 10; 6 10 10; 0 5 6; 1 2 8; 3 10 10; 4 10 10]
+  // So 'LSHSearch::bucketOffsets' should be:
+  // COR.SOL.: [0 2 2 3 4 7 8 8 11 14 17 18]
+  //
+  // The final hash table 'LSHSearch::secondHashTable' should hold the points
+  // of each bucket, one bucket after another.
 
   arma::Mat<size_t> neighbors;
   arma::mat distances;
@@ -108,4 +107,149 @@ BOOST_AUTO_TEST_CASE(LSHSearchTest)
   }
 }
 
+/**
+ * Make sure that probing additional buckets finds at least as many of the true
+ * nearest neighbors as probing only the query's own buckets, and that it finds
+ * more when there are only a few tables.
+ */
+BOOST_AUTO_TEST_CASE(LSHMultiProbeTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat rdata;
+  rdata.randu(4, 1000);
+  arma::mat qdata;
+  qdata.randu(4, 100);
+
+  // Find the true neighbors.
+  AllkNN knn(rdata, qdata);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  knn.Search(5, trueNeighbors, trueDistances);
+
+  LSHSearch<> lsh(rdata, qdata, 10, 2);
+
+  size_t found[3] = { 0, 0, 0 };
+  const size_t numProbes[3] = { 0, 10, 50 };
+  for (size_t p = 0; p < 3; ++p)
+  {
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    lsh.Search(5, neighbors, distances, 0, numProbes[p]);
+
+    for (size_t i = 0; i < qdata.n_cols; ++i)
+      for (size_t j = 0; j < 5; ++j)
+        for (size_t l = 0; l < 5; ++l)
+          if (neighbors(l, i) == trueNeighbors(j, i))
+            ++found[p];
+  }
+
+  BOOST_REQUIRE_GE(found[1], found[0]);
+  BOOST_REQUIRE_GE(found[2], found[1]);
+  BOOST_REQUIRE_GT(found[2], found[0]);
+}
+
+/**
+ * Make sure that when buckets have no size limit every point is stored once
+ * per table, and that a bucket size limit is respected.
+ */
+BOOST_AUTO_TEST_CASE(LSHBucketLayoutTest)
+{
+  arma::mat rdata;
+  rdata.randu(3, 500);
+
+  LSHSearch<> lsh(rdata, 5, 4, 0.0, 101);
+
+  const arma::Col<size_t>& offsets = lsh.BucketOffsets();
+  const arma::Col<arma::u32>& table = lsh.SecondHashTable();
+  BOOST_REQUIRE_EQUAL(offsets.n_elem, 102);
+  BOOST_REQUIRE_EQUAL(offsets[0], 0);
+  BOOST_REQUIRE_EQUAL(offsets[101], 4 * 500);
+  BOOST_REQUIRE_EQUAL(table.n_elem, 4 * 500);
+
+  arma::Col<size_t> counts;
+  counts.zeros(500);
+  for (size_t i = 0; i < table.n_elem; ++i)
+    counts[table[i]]++;
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 4);
+
+  LSHSearch<> limited(rdata, 5, 4, 0.0, 101, 3);
+  const arma::Col<size_t>& limitedOffsets = limited.BucketOffsets();
+  for (size_t i = 0; i < 101; ++i)
+    BOOST_REQUIRE_LE(limitedOffsets[i + 1] - limitedOffsets[i], 3);
+  BOOST_REQUIRE_EQUAL(limited.SecondHashTable().n_elem, limitedOffsets[101]);
+}
+
+/**
+ * Make sure that searching with several threads (and so with smaller blocks of
+ * queries) gives the same results as searching with one thread.  There are
+ * enough queries that the single-threaded search uses several blocks too.
+ */
+BOOST_AUTO_TEST_CASE(LSHParallelSearchTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat rdata;
+  rdata.randu(5, 2000);
+  arma::mat qdata;
+  qdata.randu(5, 3000);
+
+  LSHSearch<> lsh(rdata, qdata, 8, 6);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  lsh.Search(3, neighbors, distances, 0, 5);
+
+  lsh.NumThreads() = 4;
+  arma::Mat<size_t> parallelNeighbors;
+  arma::mat parallelDistances;
+  lsh.Search(3, parallelNeighbors, parallelDistances, 0, 5);
+
+  BOOST_REQUIRE_EQUAL(parallelNeighbors.n_cols, neighbors.n_cols);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(parallelNeighbors[i], neighbors[i]);
+    BOOST_REQUIRE_CLOSE(parallelDistances[i], distances[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that an index saved to a file and loaded again gives the same hash
+ * and the same search results as the original.
+ */
+BOOST_AUTO_TEST_CASE(LSHSaveLoadTest)
+{
+  arma::mat rdata;
+  rdata.randu(4, 800);
+  arma::mat qdata;
+  qdata.randu(4, 200);
+
+  LSHSearch<> lsh(rdata, qdata, 6, 5, 0.0, 1009);
+  BOOST_REQUIRE(lsh.Save("test-lsh-index.bin"));
+
+  LSHSearch<> loaded(rdata, qdata, "test-lsh-index.bin");
+  remove("test-lsh-index.bin");
+
+  BOOST_REQUIRE_EQUAL(loaded.BucketOffsets().n_elem,
+      lsh.BucketOffsets().n_elem);
+  for (size_t i = 0; i < lsh.BucketOffsets().n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded.BucketOffsets()[i], lsh.BucketOffsets()[i]);
+  BOOST_REQUIRE_EQUAL(loaded.SecondHashTable().n_elem,
+      lsh.SecondHashTable().n_elem);
+  for (size_t i = 0; i < lsh.SecondHashTable().n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(loaded.SecondHashTable()[i], lsh.SecondHashTable()[i]);
+
+  arma::Mat<size_t> neighbors, loadedNeighbors;
+  arma::mat distances, loadedDistances;
+  lsh.Search(4, neighbors, distances, 0, 3);
+  loaded.Search(4, loadedNeighbors, loadedDistances, 0, 3);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(loadedNeighbors[i], neighbors[i]);
+    BOOST_REQUIRE_CLOSE(loadedDistances[i], distances[i], 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -5,6 +5,7 @@
  * Tests for everything in the math:: namespace.
  */
 #include <mlpack/core/math/clamp.hpp>
+#include <mlpack/core/math/power.hpp>
 #include <mlpack/core/math/random.hpp>
 #include <mlpack/core/math/range.hpp>
 #include <boost/test/unit_test.hpp>
@@ -578,4 +579,96 @@ BOOST_AUTO_TEST_CASE(RangeContainsRange)
   BOOST_REQUIRE_EQUAL(b.Contains(a), true);
 }
 
+/**
+ * Make sure the compile-time integer powers and roots match pow().
+ */
+BOOST_AUTO_TEST_CASE(IntPowTest)
+{
+  const double values[] = { 0.0, 0.5, 1.0, 1.7, 3.0, 123.456 };
+  for (size_t i = 0; i < 6; ++i)
+  {
+    const double x = values[i];
+    BOOST_REQUIRE_CLOSE(IntPow<1>(x) + 1.0, x + 1.0, 1e-10);
+    BOOST_REQUIRE_CLOSE(IntPow<2>(x) + 1.0, pow(x, 2.0) + 1.0, 1e-10);
+    BOOST_REQUIRE_CLOSE(IntPow<3>(x) + 1.0, pow(x, 3.0) + 1.0, 1e-10);
+    BOOST_REQUIRE_CLOSE(IntPow<6>(x) + 1.0, pow(x, 6.0) + 1.0, 1e-10);
+    BOOST_REQUIRE_CLOSE(IntPow<7>(x) + 1.0, pow(x, 7.0) + 1.0, 1e-10);
+
+    BOOST_REQUIRE_CLOSE(IntRoot<1>(x) + 1.0, x + 1.0, 1e-10);
+    BOOST_REQUIRE_CLOSE(IntRoot<2>(x) + 1.0, sqrt(x) + 1.0, 1e-10);
+    BOOST_REQUIRE_CLOSE(IntRoot<3>(x) + 1.0, pow(x, 1.0 / 3.0) + 1.0, 1e-10);
+  }
+}
+
+/**
+ * Make sure the bulk generators of a RandomStream draw the same numbers as the
+ * scalar generators, and that streams split from the same seed differ.
+ */
+BOOST_AUTO_TEST_CASE(RandomStreamTest)
+{
+  RandomStream a(RandomStream::StreamSeed(42, 0));
+  RandomStream b(RandomStream::StreamSeed(42, 0));
+  RandomStream c(RandomStream::StreamSeed(42, 1));
+  BOOST_REQUIRE_NE(RandomStream::StreamSeed(42, 0),
+      RandomStream::StreamSeed(42, 1));
+  BOOST_REQUIRE_NE(RandomStream::StreamSeed(42, 0),
+      RandomStream::StreamSeed(43, 0));
+
+  arma::vec uniform(1000), normal(1000), other(1000);
+  a.Random(uniform);
+  a.RandNormal(normal);
+  c.Random(other);
+
+  size_t same = 0;
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(uniform[i], b.Random());
+    BOOST_REQUIRE_GE(uniform[i], 0.0);
+    BOOST_REQUIRE_LT(uniform[i], 1.0);
+    if (uniform[i] == other[i])
+      ++same;
+  }
+  for (size_t i = 0; i < 1000; ++i)
+    BOOST_REQUIRE_EQUAL(normal[i], b.RandNormal());
+  BOOST_REQUIRE_EQUAL(same, (size_t) 0);
+
+  // Rough checks of the moments.
+  BOOST_REQUIRE_SMALL(arma::mean(uniform) - 0.5, 0.05);
+  BOOST_REQUIRE_SMALL(arma::mean(normal), 0.15);
+  BOOST_REQUIRE_SMALL(arma::var(normal) - 1.0, 0.2);
+}
+
+/**
+ * Make sure random numbers drawn inside a parallel region come from the
+ * streams of the threads, so they are the same for the same seed.
+ */
+BOOST_AUTO_TEST_CASE(ThreadStreamTest)
+{
+  arma::mat first(100, 16), second(100, 16);
+
+  RandomSeed(7);
+  #pragma omp parallel for schedule(static, 1)
+  for (size_t i = 0; i < 16; ++i)
+    for (size_t j = 0; j < 100; ++j)
+      first(j, i) = Random() + RandNormal();
+
+  RandomSeed(7);
+  #pragma omp parallel for schedule(static, 1)
+  for (size_t i = 0; i < 16; ++i)
+    for (size_t j = 0; j < 100; ++j)
+      second(j, i) = Random() + RandNormal();
+
+  for (size_t i = 0; i < first.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(first[i], second[i]);
+
+  // Outside of a parallel region, the global generator is used, and the bulk
+  // generator draws the same numbers as Random().
+  arma::vec bulk(50);
+  RandomSeed(7);
+  math::Random(bulk);
+  RandomSeed(7);
+  for (size_t i = 0; i < 50; ++i)
+    BOOST_REQUIRE_EQUAL(bulk[i], Random());
+}
+
 BOOST_AUTO_TEST_SUITE_END();
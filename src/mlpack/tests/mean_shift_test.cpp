@@ -0,0 +1,79 @@
+/**
+ * @file mean_shift_test.cpp
+ *
+ * Tests for mean shift clustering.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/mean_shift/mean_shift.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::meanshift;
+
+BOOST_AUTO_TEST_SUITE(MeanShiftTest);
+
+/**
+ * Only the cells of the seeding grid with enough points should give seeds, at
+ * the mean of their points.
+ */
+BOOST_AUTO_TEST_CASE(SeedsTest)
+{
+  arma::mat data("0.1 0.2 0.3 0.4 0.5 3.5;"
+                 "0.5 0.4 0.3 0.2 0.1 3.5");
+
+  MeanShift<> meanShift(1.0, 1000, 2);
+  arma::mat seeds;
+  meanShift.Seeds(data, seeds);
+
+  BOOST_REQUIRE_EQUAL(seeds.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(seeds.n_cols, 1);
+  BOOST_REQUIRE_CLOSE(seeds(0, 0), 0.3, 1e-5);
+  BOOST_REQUIRE_CLOSE(seeds(1, 0), 0.3, 1e-5);
+
+  // With a frequency of 1, the far away point gives a seed too.
+  meanShift.MinBinFrequency() = 1;
+  meanShift.Seeds(data, seeds);
+  BOOST_REQUIRE_EQUAL(seeds.n_cols, 2);
+  BOOST_REQUIRE_CLOSE(seeds(0, 1), 3.5, 1e-5);
+  BOOST_REQUIRE_CLOSE(seeds(1, 1), 3.5, 1e-5);
+}
+
+/**
+ * Three well-separated Gaussian blobs should give three clusters, centered on
+ * the blobs, with both naive and tree-based clustering.
+ */
+BOOST_AUTO_TEST_CASE(GaussianBlobsTest)
+{
+  arma::mat centers("0.0 5.0 10.0;"
+                    "0.0 5.0 0.0");
+  const size_t pointsPerBlob = 200;
+  arma::mat data(2, 3 * pointsPerBlob);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) = centers.col(i / pointsPerBlob) +
+        0.2 * arma::randn<arma::vec>(2);
+
+  for (size_t naive = 0; naive < 2; ++naive)
+  {
+    MeanShift<> meanShift(1.0, 1000, 1, (naive == 1), 10);
+
+    arma::Col<size_t> assignments;
+    arma::mat centroids;
+    const size_t clusters = meanShift.Cluster(data, assignments, centroids);
+
+    BOOST_REQUIRE_EQUAL(clusters, 3);
+    BOOST_REQUIRE_EQUAL(centroids.n_cols, 3);
+    BOOST_REQUIRE_EQUAL(assignments.n_elem, data.n_cols);
+
+    // The clusters are numbered in the order of the blobs, since the first
+    // seeds come from the first points.
+    for (size_t i = 0; i < data.n_cols; ++i)
+      BOOST_REQUIRE_EQUAL(assignments[i], i / pointsPerBlob);
+
+    for (size_t c = 0; c < 3; ++c)
+      BOOST_REQUIRE_SMALL(arma::norm(centroids.col(c) - centers.col(c), 2),
+          0.2);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
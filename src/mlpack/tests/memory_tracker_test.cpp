@@ -0,0 +1,172 @@
+/**
+ * @file memory_tracker_test.cpp
+ *
+ * Tests for the MemoryTracker, which records the memory used during each timer
+ * phase, and its counters.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/count_nodes.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+#include <fstream>
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+BOOST_AUTO_TEST_SUITE(MemoryTrackerTest);
+
+//! Find the statistics of the named phase, or return false.
+bool FindPhase(const std::string& name, MemoryTracker::PhaseStatistics& phase)
+{
+  const std::vector<MemoryTracker::PhaseStatistics> phases =
+      MemoryTracker::Phases();
+  for (size_t i = 0; i < phases.size(); ++i)
+  {
+    if (phases[i].name == name)
+    {
+      phase = phases[i];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * A timer phase that allocates a matrix should see the heap grow by the size
+ * of the matrix, and the peak resident set hold it.
+ */
+BOOST_AUTO_TEST_CASE(PhaseAllocationTest)
+{
+  MemoryTracker::Reset();
+
+  Timer::Start("memory_tracker_test/allocate");
+  arma::mat matrix(1000, 1000);
+  matrix.fill(1.0); // Touch the pages, so they are resident.
+  Timer::Stop("memory_tracker_test/allocate");
+
+  MemoryTracker::PhaseStatistics phase;
+  BOOST_REQUIRE(FindPhase("memory_tracker_test/allocate", phase));
+  BOOST_REQUIRE_EQUAL(phase.runs, 1);
+
+  const size_t bytes = matrix.n_elem * sizeof(double);
+  if (MemoryTracker::LiveBytes() > 0)
+  {
+    BOOST_REQUIRE_GE(phase.heapGrowth, (boost::int64_t) bytes);
+    BOOST_REQUIRE_GE(phase.liveBytes, bytes);
+  }
+
+  if (MemoryTracker::ResidentBytes() > 0)
+    BOOST_REQUIRE_GE(phase.peakResidentBytes, bytes);
+
+  // A second run that frees nothing and allocates nothing adds a run.
+  Timer::Start("memory_tracker_test/allocate");
+  Timer::Stop("memory_tracker_test/allocate");
+  BOOST_REQUIRE(FindPhase("memory_tracker_test/allocate", phase));
+  BOOST_REQUIRE_EQUAL(phase.runs, 2);
+
+  // A phase that was never started isn't reported.
+  MemoryTracker::StopPhase("memory_tracker_test/never_started");
+  BOOST_REQUIRE(!FindPhase("memory_tracker_test/never_started", phase));
+}
+
+/**
+ * The peak of a phase includes the peaks of the phases inside it, even if the
+ * memory was freed before the outer phase ended.
+ */
+BOOST_AUTO_TEST_CASE(NestedPhasePeakTest)
+{
+  MemoryTracker::Reset();
+
+  Timer::Start("memory_tracker_test/outer");
+  Timer::Start("memory_tracker_test/inner");
+  {
+    arma::mat temporary(2000, 1000);
+    temporary.fill(2.0);
+  }
+  Timer::Stop("memory_tracker_test/inner");
+  Timer::Stop("memory_tracker_test/outer");
+
+  MemoryTracker::PhaseStatistics inner, outer;
+  BOOST_REQUIRE(FindPhase("memory_tracker_test/inner", inner));
+  BOOST_REQUIRE(FindPhase("memory_tracker_test/outer", outer));
+  BOOST_REQUIRE_GE(outer.peakResidentBytes, inner.peakResidentBytes);
+
+  // The temporary matrix was freed, so the heap did not keep it.
+  if (MemoryTracker::LiveBytes() > 0)
+    BOOST_REQUIRE_LT(inner.heapGrowth, (boost::int64_t) (2000 * 1000 *
+        sizeof(double)));
+}
+
+/**
+ * Check that counters accumulate, and that NeighborSearch counts the tree
+ * nodes it builds and the dataset copies it makes.
+ */
+BOOST_AUTO_TEST_CASE(CounterTest)
+{
+  MemoryTracker::Reset();
+
+  BOOST_REQUIRE_EQUAL(MemoryTracker::Counter("memory_tracker_test"), 0);
+  MemoryTracker::AddCounter("memory_tracker_test", 3);
+  MemoryTracker::AddCounter("memory_tracker_test", 4);
+  BOOST_REQUIRE_EQUAL(MemoryTracker::Counter("memory_tracker_test"), 7);
+  BOOST_REQUIRE_EQUAL(MemoryTracker::Counters().size(), 1);
+
+  MemoryTracker::Reset();
+
+  arma::mat referenceSet(3, 500);
+  referenceSet.randu();
+  arma::mat querySet(3, 200);
+  querySet.randu();
+
+  AllkNN knn(referenceSet, querySet);
+
+  // The same trees, built again: tree building is deterministic.
+  typedef tree::BinarySpaceTree<bound::HRectBound<2>,
+      NeighborSearchStat<NearestNeighborSort> > TreeType;
+  arma::mat referenceCopy(referenceSet), queryCopy(querySet);
+  std::vector<size_t> oldFromNew;
+  TreeType referenceTree(referenceCopy, oldFromNew);
+  TreeType queryTree(queryCopy, oldFromNew);
+
+  const size_t nodes = tree::CountNodes(referenceTree) +
+      tree::CountNodes(queryTree);
+  BOOST_REQUIRE_EQUAL(MemoryTracker::Counter("tree_nodes"), nodes);
+  BOOST_REQUIRE_EQUAL(MemoryTracker::Counter("dataset_copy_bytes"),
+      (referenceSet.n_elem + querySet.n_elem) * sizeof(double));
+}
+
+/**
+ * Make sure the JSON output holds the phases and the counters.
+ */
+BOOST_AUTO_TEST_CASE(WriteJSONTest)
+{
+  MemoryTracker::Reset();
+
+  Timer::Start("memory_tracker_test/\"quoted\"");
+  Timer::Stop("memory_tracker_test/\"quoted\"");
+  MemoryTracker::AddCounter("tree_nodes", 12);
+
+  BOOST_REQUIRE(MemoryTracker::WriteJSON("memory_tracker_test.json"));
+
+  std::ifstream stream("memory_tracker_test.json");
+  std::string json((std::istreambuf_iterator<char>(stream)),
+      std::istreambuf_iterator<char>());
+  stream.close();
+  remove("memory_tracker_test.json");
+
+  BOOST_REQUIRE(json.find("\"phases\":[") != std::string::npos);
+  BOOST_REQUIRE(json.find("\"name\":\"memory_tracker_test/\\\"quoted\\\"\"") !=
+      std::string::npos);
+  BOOST_REQUIRE(json.find("\"runs\":1") != std::string::npos);
+  BOOST_REQUIRE(json.find("\"peak_resident_bytes\":") != std::string::npos);
+  BOOST_REQUIRE(json.find("\"counters\":{") != std::string::npos);
+  BOOST_REQUIRE(json.find("\"tree_nodes\":12") != std::string::npos);
+
+  MemoryTracker::Reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END();
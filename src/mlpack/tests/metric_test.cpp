@@ -5,6 +5,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/metrics/mahalanobis_distance.hpp>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -82,4 +83,92 @@ BOOST_AUTO_TEST_CASE(LINFMetricTest)
                       lMetric.Evaluate(a2, b2), 1e-5);
 }
 
+/**
+ * Make sure EvaluateBounded() gives the distance when it is within the bound,
+ * and a lower bound greater than the bound when it is not.
+ */
+template<typename MetricType>
+void CheckBounded(MetricType& metric, const arma::vec& a, const arma::vec& b)
+{
+  const double distance = metric.Evaluate(a, b);
+
+  BOOST_REQUIRE_CLOSE(metric.EvaluateBounded(a, b, DBL_MAX), distance, 1e-8);
+  BOOST_REQUIRE_CLOSE(metric.EvaluateBounded(a, b, 2.0 * distance), distance,
+      1e-8);
+
+  for (size_t i = 1; i < 10; ++i)
+  {
+    const double bound = 0.1 * i * distance;
+    const double result = metric.EvaluateBounded(a, b, bound);
+    BOOST_REQUIRE_GT(result, bound);
+    BOOST_REQUIRE_LE(result, distance * (1 + 1e-8));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BoundedMetricTest)
+{
+  // The dimensionality is not a multiple of the block size, so the last block
+  // is partial.
+  arma::vec a(103);
+  a.randn();
+  arma::vec b(103);
+  b.randn();
+
+  ManhattanDistance manhattan;
+  SquaredEuclideanDistance squaredEuclidean;
+  EuclideanDistance euclidean;
+  ChebyshevDistance chebyshev;
+  LMetric<3, true> l3;
+
+  CheckBounded(manhattan, a, b);
+  CheckBounded(squaredEuclidean, a, b);
+  CheckBounded(euclidean, a, b);
+  CheckBounded(chebyshev, a, b);
+  CheckBounded(l3, a, b);
+
+  // The whitened form of the Mahalanobis distance must agree with the usual
+  // one for a positive definite covariance.
+  arma::mat factor(103, 103);
+  factor.randu();
+  MahalanobisDistance<> mahalanobis(trans(factor) * factor +
+      arma::eye<arma::mat>(103, 103));
+  MahalanobisDistance<false> squaredMahalanobis(mahalanobis.Covariance());
+
+  CheckBounded(mahalanobis, a, b);
+  CheckBounded(squaredMahalanobis, a, b);
+}
+
+/**
+ * Make sure the whitening used by MahalanobisDistance::EvaluateBounded() is
+ * computed when the covariance matrix is set, so that EvaluateBounded() can be
+ * called on a const object and follows changes of the covariance matrix.
+ */
+BOOST_AUTO_TEST_CASE(BoundedMahalanobisCovarianceTest)
+{
+  arma::vec a(20);
+  a.randn();
+  arma::vec b(20);
+  b.randn();
+
+  // Without a covariance matrix, the identity is used.
+  MahalanobisDistance<> mahalanobis;
+  const MahalanobisDistance<>& constMahalanobis = mahalanobis;
+  BOOST_REQUIRE_CLOSE(constMahalanobis.EvaluateBounded(a, b, DBL_MAX),
+      arma::norm(a - b, 2), 1e-8);
+
+  arma::mat factor(20, 20);
+  factor.randu();
+  mahalanobis.Covariance(trans(factor) * factor +
+      arma::eye<arma::mat>(20, 20));
+  BOOST_REQUIRE_CLOSE(constMahalanobis.EvaluateBounded(a, b, DBL_MAX),
+      mahalanobis.Evaluate(a, b), 1e-8);
+
+  // Setting another covariance matrix must replace the whitening.
+  mahalanobis.Covariance(4.0 * arma::eye<arma::mat>(20, 20));
+  BOOST_REQUIRE_CLOSE(constMahalanobis.EvaluateBounded(a, b, DBL_MAX),
+      2.0 * arma::norm(a - b, 2), 1e-8);
+  BOOST_REQUIRE_CLOSE(mahalanobis.Evaluate(a, b), 2.0 * arma::norm(a - b, 2),
+      1e-8);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -122,4 +122,136 @@ BOOST_AUTO_TEST_CASE(NaiveBayesClassifierIncrementalTest)
     BOOST_REQUIRE_EQUAL(testRes(i), calcVec(i));
 }
 
+// The same test, but the training set is read in chunks.
+BOOST_AUTO_TEST_CASE(NaiveBayesClassifierChunkedTest)
+{
+  const char* trainFilename = "trainSet.csv";
+  const char* testFilename = "testSet.csv";
+  const char* trainResultFilename = "trainRes.csv";
+  const char* testResultFilename = "testRes.csv";
+  size_t classes = 2;
+
+  arma::mat trainRes, calcMat;
+  data::Load(trainResultFilename, trainRes, true);
+
+  data::ChunkReader reader(trainFilename, true);
+  NaiveBayesClassifier<> nbcTest(reader, classes, 17);
+
+  size_t dimension = nbcTest.Means().n_rows;
+  calcMat.zeros(2 * dimension + 1, classes);
+
+  for (size_t i = 0; i < dimension; i++)
+  {
+    for (size_t j = 0; j < classes; j++)
+    {
+      calcMat(i, j) = nbcTest.Means()(i, j);
+      calcMat(i + dimension, j) = nbcTest.Variances()(i, j);
+    }
+  }
+
+  for (size_t i = 0; i < classes; i++)
+    calcMat(2 * dimension, i) = nbcTest.Probabilities()(i);
+
+  for (size_t i = 0; i < calcMat.n_rows; i++)
+    for (size_t j = 0; j < classes; j++)
+      BOOST_REQUIRE_CLOSE(trainRes(i, j) + .00001, calcMat(i, j), 0.01);
+
+  arma::mat testData;
+  arma::Mat<size_t> testRes;
+  arma::Col<size_t> calcVec;
+  data::Load(testFilename, testData, true);
+  data::Load(testResultFilename, testRes, true);
+
+  testData.shed_row(testData.n_rows - 1); // Remove the labels.
+
+  nbcTest.Classify(testData, calcVec);
+
+  for (size_t i = 0; i < testData.n_cols; i++)
+    BOOST_REQUIRE_EQUAL(testRes(i), calcVec(i));
+}
+
+/**
+ * Training in batches with Train(), and merging models trained on parts of the
+ * dataset, should give the model trained on the whole dataset.
+ */
+BOOST_AUTO_TEST_CASE(NaiveBayesClassifierTrainMergeTest)
+{
+  arma::mat data = arma::randu<arma::mat>(4, 300);
+  arma::Col<size_t> labels(300);
+  for (size_t i = 0; i < 300; ++i)
+  {
+    labels[i] = (i * 7) % 3;
+    data.col(i) += labels[i];
+  }
+
+  NaiveBayesClassifier<> nbc(data, labels, 3);
+
+  // Train on three batches of different sizes.
+  NaiveBayesClassifier<> online(4, 3);
+  online.Train(data.cols(0, 9), labels.subvec(0, 9));
+  online.Train(data.cols(10, 149), labels.subvec(10, 149));
+  online.Train(data.cols(150, 299), labels.subvec(150, 299));
+
+  // Train two models on the halves, and merge them.
+  NaiveBayesClassifier<> merged(data.cols(0, 99), labels.subvec(0, 99), 3);
+  NaiveBayesClassifier<> other(4, 3);
+  other.Train(data.cols(100, 299), labels.subvec(100, 299));
+  merged.Merge(other);
+
+  for (size_t i = 0; i < nbc.Means().n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(online.Means()[i], nbc.Means()[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(online.Variances()[i], nbc.Variances()[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(merged.Means()[i], nbc.Means()[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(merged.Variances()[i], nbc.Variances()[i], 1e-8);
+  }
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(online.Counts()[i], nbc.Counts()[i]);
+    BOOST_REQUIRE_CLOSE(online.Probabilities()[i], nbc.Probabilities()[i],
+        1e-8);
+    BOOST_REQUIRE_CLOSE(merged.Probabilities()[i], nbc.Probabilities()[i],
+        1e-8);
+  }
+
+  // A non-incremental Train() forgets the old points.
+  online.Train(data.cols(0, 99), labels.subvec(0, 99), false);
+  NaiveBayesClassifier<> first(data.cols(0, 99), labels.subvec(0, 99), 3);
+  for (size_t i = 0; i < first.Means().n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(online.Means()[i], first.Means()[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(online.Variances()[i], first.Variances()[i], 1e-8);
+  }
+}
+
+/**
+ * Points far from the means of all classes, whose likelihoods underflow as
+ * doubles, should still be given the class with the largest log-likelihood;
+ * there are enough points for several blocks.
+ */
+BOOST_AUTO_TEST_CASE(NaiveBayesClassifierFarPointsTest)
+{
+  arma::mat trainData(1, 40);
+  arma::Col<size_t> labels(40);
+  for (size_t i = 0; i < 40; ++i)
+  {
+    labels[i] = i % 2;
+    trainData(0, i) = labels[i] + 0.01 * ((i / 2) % 5);
+  }
+
+  NaiveBayesClassifier<> nbc(trainData, labels, 2);
+
+  arma::mat testData(1, 3000);
+  for (size_t i = 0; i < testData.n_cols; ++i)
+    testData(0, i) = (i % 2 == 0) ? -10.0 - i : 10.0 + i;
+
+  arma::Col<size_t> results;
+  nbc.Classify(testData, results);
+
+  BOOST_REQUIRE_EQUAL(results.n_elem, testData.n_cols);
+  for (size_t i = 0; i < testData.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(results[i], i % 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
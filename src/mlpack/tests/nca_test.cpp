@@ -244,6 +244,92 @@ BOOST_AUTO_TEST_CASE(SoftmaxSeparableGradient)
   BOOST_REQUIRE_CLOSE(gradient(1, 1), -2.0 * -0.1435886, 0.01);
 }
 
+/**
+ * When the sums are truncated to n - 1 neighbors, nothing is left out, so the
+ * truncated objective and gradients must be the same as the exact ones.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxNeighborTruncation)
+{
+  arma::mat data;
+  data.randu(3, 40);
+  arma::Col<size_t> labels(40);
+  for (size_t i = 0; i < 40; ++i)
+    labels[i] = (data(0, i) > 0.5) ? 1 : 0;
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+  SoftmaxErrorFunction<SquaredEuclideanDistance> tsef(data, labels,
+      SquaredEuclideanDistance(), 39, 1);
+
+  arma::mat coordinates = arma::randu<arma::mat>(3, 3) + 2 *
+      arma::eye<arma::mat>(3, 3);
+
+  BOOST_REQUIRE_CLOSE(tsef.Evaluate(coordinates), sef.Evaluate(coordinates),
+      1e-5);
+  BOOST_REQUIRE_SMALL(tsef.TruncationBound(), 1e-10);
+
+  arma::mat gradient, truncatedGradient;
+  sef.Gradient(coordinates, gradient);
+  tsef.Gradient(coordinates, truncatedGradient);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(truncatedGradient[i] - gradient[i], 1e-8);
+
+  for (size_t i = 0; i < 40; i += 7)
+  {
+    BOOST_REQUIRE_CLOSE(tsef.Evaluate(coordinates, i),
+        sef.Evaluate(coordinates, i), 1e-5);
+
+    sef.Gradient(coordinates, i, gradient);
+    tsef.Gradient(coordinates, i, truncatedGradient);
+    for (size_t j = 0; j < gradient.n_elem; ++j)
+      BOOST_REQUIRE_SMALL(truncatedGradient[j] - gradient[j], 1e-8);
+  }
+}
+
+/**
+ * The mini-batch gradient should be the sum of the separable gradients of the
+ * points in the batch, with and without truncated sums, and the stretched
+ * dataset kept by the separable functions should follow the coordinates.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxBatchGradient)
+{
+  arma::mat data;
+  data.randu(3, 40);
+  arma::Col<size_t> labels(40);
+  for (size_t i = 0; i < 40; ++i)
+    labels[i] = (data(0, i) > 0.5) ? 1 : 0;
+
+  for (size_t neighbors = 0; neighbors <= 10; neighbors += 10)
+  {
+    SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels,
+        SquaredEuclideanDistance(), neighbors);
+
+    arma::mat coordinates = arma::randu<arma::mat>(3, 3) +
+        arma::eye<arma::mat>(3, 3);
+
+    arma::mat batchGradient;
+    sef.Gradient(coordinates, 5, 12, batchGradient);
+
+    arma::mat sum = arma::zeros<arma::mat>(3, 3);
+    arma::mat gradient;
+    for (size_t i = 5; i < 17; ++i)
+    {
+      sef.Gradient(coordinates, i, gradient);
+      sum += gradient;
+    }
+
+    for (size_t i = 0; i < sum.n_elem; ++i)
+      BOOST_REQUIRE_SMALL(batchGradient[i] - sum[i], 1e-10);
+
+    // Evaluating with other coordinates must not reuse the old stretched
+    // dataset.
+    SoftmaxErrorFunction<SquaredEuclideanDistance> other(data, labels,
+        SquaredEuclideanDistance(), neighbors);
+    arma::mat newCoordinates = 2 * coordinates;
+    BOOST_REQUIRE_CLOSE(sef.Evaluate(newCoordinates, 3),
+        other.Evaluate(newCoordinates, 3), 1e-5);
+  }
+}
+
 //
 // Tests for the NCA algorithm.
 //
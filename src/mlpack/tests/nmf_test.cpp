@@ -7,6 +7,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/amf/amf.hpp>
 #include <mlpack/methods/amf/init_rules/random_acol_init.hpp>
+#include <mlpack/methods/amf/init_rules/nndsvd_init.hpp>
 #include <mlpack/methods/amf/update_rules/nmf_mult_div.hpp>
 #include <mlpack/methods/amf/update_rules/nmf_als.hpp>
 #include <mlpack/methods/amf/update_rules/nmf_mult_dist.hpp>
@@ -213,4 +214,168 @@ BOOST_AUTO_TEST_CASE(SparseNMFALSTest)
       1e-5);
 }
 
+/**
+ * Make sure the reconstruction error that GramResidueTermination computes from
+ * the Gram matrices is the error of the factorization, for dense and sparse
+ * matrices.
+ */
+BOOST_AUTO_TEST_CASE(NMFGramResidueTerminationTest)
+{
+  mat w = randu<mat>(20, 12);
+  mat h = randu<mat>(12, 20);
+  mat v = w * h;
+  const size_t r = 12;
+
+  GramResidueTermination<> grt(1e-6, 500);
+  AMF<GramResidueTermination<> > nmf(grt);
+  nmf.Apply(v, r, w, h);
+
+  const double error = arma::norm(v - w * h, "fro") / arma::norm(v, "fro");
+  BOOST_REQUIRE_SMALL(error, 0.05);
+
+  GramResidueTermination<> check;
+  check.Initialize(v);
+  check.IsConverged(w, h);
+  BOOST_REQUIRE_SMALL(check.Index() - error, 1e-6);
+
+  sp_mat sv = sprandu<sp_mat>(50, 40, 0.2);
+  mat sw = randu<mat>(50, 5);
+  mat sh = randu<mat>(5, 40);
+  GramResidueTermination<sp_mat> sparseCheck;
+  sparseCheck.Initialize(sv);
+  sparseCheck.IsConverged(sw, sh);
+
+  const mat dv(sv);
+  BOOST_REQUIRE_CLOSE(sparseCheck.Index(), arma::norm(dv - sw * sh, "fro") /
+      arma::norm(dv, "fro"), 1e-5);
+}
+
+/**
+ * Make sure that one step of the multiplicative distance update rules gives
+ * the same result as the element-wise formulas.
+ */
+BOOST_AUTO_TEST_CASE(NMFMultiplicativeDistanceStepTest)
+{
+  mat v = randu<mat>(30, 25);
+  mat w = randu<mat>(30, 4);
+  mat h = randu<mat>(4, 25);
+
+  mat expectedW = (w % (v * h.t())) / (w * h * h.t());
+  mat expectedH = (h % (expectedW.t() * v)) / (expectedW.t() * expectedW * h);
+
+  NMFMultiplicativeDistanceUpdate update;
+  update.Initialize(v, 4);
+  update.WUpdate(v, w, h);
+  update.HUpdate(v, w, h);
+
+  BOOST_REQUIRE_SMALL(arma::norm(w - expectedW, "fro") /
+      arma::norm(expectedW, "fro"), 1e-10);
+  BOOST_REQUIRE_SMALL(arma::norm(h - expectedH, "fro") /
+      arma::norm(expectedH, "fro"), 1e-10);
+}
+
+/**
+ * Make sure the blocked dense and the sparse multiplicative divergence update
+ * rules give the same result as the element-wise formulas, with blocks that
+ * don't divide the matrix evenly.
+ */
+BOOST_AUTO_TEST_CASE(NMFMultiplicativeDivergenceStepTest)
+{
+  // A sparse matrix with no zeros has the same ratios as the dense matrix.
+  mat v = randu<mat>(30, 25) + 0.1;
+  sp_mat sv(v);
+  mat w = randu<mat>(30, 4);
+  mat h = randu<mat>(4, 25);
+
+  mat expectedW = w % ((v / (w * h)) * h.t());
+  expectedW.each_row() /= trans(sum(h, 1));
+  mat expectedH = h % (expectedW.t() * (v / (expectedW * h)));
+  expectedH.each_col() /= trans(sum(expectedW, 0));
+
+  NMFMultiplicativeDivergenceUpdate update(7);
+  mat dw(w), dh(h);
+  update.Initialize(v, 4);
+  update.WUpdate(v, dw, dh);
+  update.HUpdate(v, dw, dh);
+
+  NMFMultiplicativeDivergenceUpdate sparseUpdate;
+  mat sw(w), sh(h);
+  sparseUpdate.Initialize(sv, 4);
+  sparseUpdate.WUpdate(sv, sw, sh);
+  sparseUpdate.HUpdate(sv, sw, sh);
+
+  BOOST_REQUIRE_SMALL(arma::norm(dw - expectedW, "fro") /
+      arma::norm(expectedW, "fro"), 1e-10);
+  BOOST_REQUIRE_SMALL(arma::norm(dh - expectedH, "fro") /
+      arma::norm(expectedH, "fro"), 1e-10);
+  BOOST_REQUIRE_SMALL(arma::norm(sw - expectedW, "fro") /
+      arma::norm(expectedW, "fro"), 1e-10);
+  BOOST_REQUIRE_SMALL(arma::norm(sh - expectedH, "fro") /
+      arma::norm(expectedH, "fro"), 1e-10);
+}
+
+/**
+ * The NNDSVD of a positive rank-one matrix is exact, and in general it must be
+ * non-negative, with no zeros if they are filled.
+ */
+BOOST_AUTO_TEST_CASE(NNDSVDInitializationTest)
+{
+  const vec a = randu<vec>(20) + 0.1;
+  const vec b = randu<vec>(15) + 0.1;
+  const mat v = a * b.t();
+
+  mat w, h;
+  NNDSVDInitialization exact(false);
+  exact.Initialize(v, 1, w, h);
+  BOOST_REQUIRE_EQUAL(w.n_rows, 20);
+  BOOST_REQUIRE_EQUAL(w.n_cols, 1);
+  BOOST_REQUIRE_EQUAL(h.n_rows, 1);
+  BOOST_REQUIRE_EQUAL(h.n_cols, 15);
+  BOOST_REQUIRE_SMALL(arma::norm(v - w * h, "fro") / arma::norm(v, "fro"),
+      1e-10);
+
+  const mat u = randu<mat>(60, 50);
+  NNDSVDInitialization init;
+  init.Initialize(u, 8, w, h);
+  BOOST_REQUIRE_EQUAL(w.n_cols, 8);
+  BOOST_REQUIRE_EQUAL(h.n_rows, 8);
+  BOOST_REQUIRE_GT(w.min(), 0.0);
+  BOOST_REQUIRE_GT(h.min(), 0.0);
+
+  // A sparse matrix gives the same start as the dense one.
+  mat sparseW, sparseH;
+  exact.Initialize(v, 1, w, h);
+  exact.Initialize(sp_mat(v), 1, sparseW, sparseH);
+  BOOST_REQUIRE_SMALL(arma::norm(w - sparseW, "fro"), 1e-10);
+  BOOST_REQUIRE_SMALL(arma::norm(h - sparseH, "fro"), 1e-10);
+}
+
+/**
+ * Starting from the NNDSVD, NMF must reach a good factorization in fewer
+ * iterations than from a random start.  The matrix is large enough for the
+ * randomized SVD to be used.
+ */
+BOOST_AUTO_TEST_CASE(NMFNNDSVDTest)
+{
+  mlpack::math::RandomSeed(17);
+  mat w = randu<mat>(100, 5);
+  mat h = randu<mat>(5, 80);
+  mat v = w * h;
+  const size_t r = 5;
+
+  SimpleResidueTermination srt(1e-6, 10000);
+  AMF<SimpleResidueTermination, NNDSVDInitialization> nmf(srt);
+  nmf.Apply(v, r, w, h);
+
+  BOOST_REQUIRE_SMALL(arma::norm(v - w * h, "fro") / arma::norm(v, "fro"),
+      0.015);
+
+  mat randomW, randomH;
+  AMF<SimpleResidueTermination> randomNMF(srt);
+  randomNMF.Apply(v, r, randomW, randomH);
+
+  BOOST_REQUIRE_LT(nmf.TerminationPolicy().Iteration(),
+      randomNMF.TerminationPolicy().Iteration());
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,115 @@
+/**
+ * @file nn_descent_test.cpp
+ *
+ * Unit tests for the 'NNDescent' class.
+ */
+#include <mlpack/core.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+#include <mlpack/methods/nn_descent/nn_descent.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+BOOST_AUTO_TEST_SUITE(NNDescentTest);
+
+/**
+ * Return the fraction of the true neighbors of each point that are among its
+ * approximate neighbors.
+ */
+double GraphRecall(const arma::Mat<size_t>& trueNeighbors,
+                   const arma::Mat<size_t>& neighbors)
+{
+  size_t found = 0;
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+      for (size_t l = 0; l < trueNeighbors.n_rows; ++l)
+        if (neighbors(j, i) == trueNeighbors(l, i))
+          ++found;
+
+  return (double) found / trueNeighbors.n_elem;
+}
+
+/**
+ * Make sure that most of the true neighbors are found, and that the results
+ * are in the format of AllkNN: no point is its own neighbor, no neighbor is
+ * repeated, and the neighbors are sorted by their (correct) distances.
+ */
+BOOST_AUTO_TEST_CASE(NNDescentRecallTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat dataset(5, 2000);
+  dataset.randu();
+
+  AllkNN allknn(dataset);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  allknn.Search(10, trueNeighbors, trueDistances);
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    // The second trial samples half of the neighbors in each iteration.
+    NNDescent<> nnDescent(dataset, (trial == 0) ? 1.0 : 0.5);
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    nnDescent.Search(10, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_rows, 10);
+    BOOST_REQUIRE_EQUAL(neighbors.n_cols, dataset.n_cols);
+    BOOST_REQUIRE_GE(GraphRecall(trueNeighbors, neighbors), 0.9);
+
+    // It should be much cheaper than comparing every pair.
+    BOOST_REQUIRE_LT(nnDescent.BaseCases(),
+        dataset.n_cols * (dataset.n_cols - 1) / 2);
+
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      for (size_t j = 0; j < neighbors.n_rows; ++j)
+      {
+        BOOST_REQUIRE_NE(neighbors(j, i), i);
+        BOOST_REQUIRE_LT(neighbors(j, i), dataset.n_cols);
+        BOOST_REQUIRE_CLOSE(distances(j, i),
+            metric::EuclideanDistance::Evaluate(dataset.col(i),
+            dataset.col(neighbors(j, i))), 1e-5);
+
+        for (size_t l = 0; l < j; ++l)
+        {
+          BOOST_REQUIRE_NE(neighbors(l, i), neighbors(j, i));
+          BOOST_REQUIRE_LE(distances(l, i), distances(j, i));
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Starting from the exact neighbors, nothing should change.
+ */
+BOOST_AUTO_TEST_CASE(NNDescentInitialGuessTest)
+{
+  arma::mat dataset(3, 500);
+  dataset.randu();
+
+  AllkNN allknn(dataset);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  allknn.Search(5, trueNeighbors, trueDistances);
+
+  NNDescent<> nnDescent(dataset);
+  arma::Mat<size_t> neighbors = trueNeighbors;
+  arma::mat distances;
+  nnDescent.Search(5, neighbors, distances, true);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], trueNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], trueDistances[i], 1e-5);
+  }
+  BOOST_REQUIRE_EQUAL(nnDescent.Iterations(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -13,6 +13,7 @@
 #include <mlpack/methods/nystroem_method/ordered_selection.hpp>
 #include <mlpack/methods/nystroem_method/random_selection.hpp>
 #include <mlpack/methods/nystroem_method/kmeans_selection.hpp>
+#include <mlpack/methods/nystroem_method/sampled_kmeans_selection.hpp>
 #include <mlpack/methods/nystroem_method/nystroem_method.hpp>
 
 using namespace mlpack;
@@ -179,4 +180,80 @@ BOOST_AUTO_TEST_CASE(GermanTest)
   }
 }
 
+/**
+ * Make sure that the kernel blocks computed from matrix products for the
+ * Gaussian and polynomial kernels are the same as those computed with
+ * Evaluate(), using more points than one block of products.
+ */
+BOOST_AUTO_TEST_CASE(KernelBlockProductTest)
+{
+  arma::mat a = arma::randu<arma::mat>(5, 1500);
+  arma::mat b = arma::randu<arma::mat>(5, 20);
+
+  GaussianKernel gk(0.7);
+  PolynomialKernel pk(3.0, 1.5);
+  LinearKernel lk;
+
+  arma::mat gaussianBlock, polynomialBlock, linearBlock;
+  KernelBlock(gk, a, b, gaussianBlock);
+  KernelBlock(pk, a, b, polynomialBlock);
+  KernelBlock(lk, a, b, linearBlock);
+
+  BOOST_REQUIRE_EQUAL(gaussianBlock.n_rows, 1500);
+  BOOST_REQUIRE_EQUAL(gaussianBlock.n_cols, 20);
+  BOOST_REQUIRE_EQUAL(polynomialBlock.n_rows, 1500);
+  BOOST_REQUIRE_EQUAL(polynomialBlock.n_cols, 20);
+
+  for (size_t i = 0; i < a.n_cols; ++i)
+  {
+    for (size_t j = 0; j < b.n_cols; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(gaussianBlock(i, j),
+          gk.Evaluate(a.col(i), b.col(j)), 1e-5);
+      BOOST_REQUIRE_CLOSE(polynomialBlock(i, j),
+          pk.Evaluate(a.col(i), b.col(j)), 1e-5);
+      BOOST_REQUIRE_CLOSE(linearBlock(i, j),
+          arma::dot(a.col(i), b.col(j)), 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure the sampled K-Means selection returns the right number of points,
+ * and that the approximation of a Gaussian kernel matrix with it is about as
+ * good as with the full K-Means selection.
+ */
+BOOST_AUTO_TEST_CASE(SampledKMeansSelectionTest)
+{
+  arma::mat dataset;
+  data::Load("german.csv", dataset, true);
+
+  const arma::mat* selected =
+      SampledKMeansSelection<>::Select(dataset, 20);
+  BOOST_REQUIRE_EQUAL(selected->n_rows, dataset.n_rows);
+  BOOST_REQUIRE_EQUAL(selected->n_cols, 20);
+  delete selected;
+
+  GaussianKernel gk(16.461);
+  arma::mat kernel;
+  KernelBlock(gk, dataset, dataset, kernel);
+
+  // Average over a few trials, since both selections are random.
+  double sampledError = 0.0, fullError = 0.0;
+  for (size_t trial = 0; trial < 5; ++trial)
+  {
+    arma::mat g;
+    NystroemMethod<GaussianKernel, SampledKMeansSelection<> > snm(dataset, gk,
+        20);
+    snm.Apply(g);
+    sampledError += arma::norm(kernel - g * g.t(), "fro");
+
+    NystroemMethod<GaussianKernel, KMeansSelection<> > nm(dataset, gk, 20);
+    nm.Apply(g);
+    fullError += arma::norm(kernel - g * g.t(), "fro");
+  }
+
+  BOOST_REQUIRE_LT(sampledError, 1.5 * fullError);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,135 @@
+/**
+ * @file parallel_sgd_test.cpp
+ *
+ * Test file for lock-free parallel SGD.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/parallel_sgd/parallel_sgd.hpp>
+#include <mlpack/core/optimizers/sgd/test_function.hpp>
+#include <mlpack/methods/regularized_svd/regularized_svd.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::optimization;
+using namespace mlpack::optimization::test;
+using namespace mlpack::svd;
+
+BOOST_AUTO_TEST_SUITE(ParallelSGDTest);
+
+/**
+ * The simple SGD test function has a dense gradient, so this tests the dense
+ * update path.
+ */
+BOOST_AUTO_TEST_CASE(SimpleParallelSGDTestFunction)
+{
+  SGDTestFunction f;
+  ParallelSGD<SGDTestFunction> s(f, 0.0003, 5000000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(coordinates);
+
+  BOOST_REQUIRE_CLOSE(result, -1.0, 0.05);
+  BOOST_REQUIRE_SMALL(coordinates[0], 1e-3);
+  BOOST_REQUIRE_SMALL(coordinates[1], 1e-7);
+  BOOST_REQUIRE_SMALL(coordinates[2], 1e-7);
+}
+
+/**
+ * The sparse per-example gradients of RegularizedSVDFunction should add up to
+ * its full gradient.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionSparseGradient)
+{
+  const size_t numUsers = 50;
+  const size_t numItems = 50;
+  const size_t numRatings = 100;
+  const size_t maxRating = 5;
+  const size_t rank = 10;
+
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data.row(2) = floor(data.row(2) * maxRating + 0.5);
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+
+  arma::mat parameters = arma::randu(rank, numUsers + numItems);
+  RegularizedSVDFunction rSVDFunc(data, rank, 0.5);
+
+  arma::mat gradient;
+  rSVDFunc.Gradient(parameters, gradient);
+
+  arma::sp_mat pointGradient;
+  arma::mat sum = arma::zeros<arma::mat>(rank, numUsers + numItems);
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    rSVDFunc.Gradient(parameters, i, pointGradient);
+    BOOST_REQUIRE_EQUAL(pointGradient.n_rows, rank);
+    BOOST_REQUIRE_EQUAL(pointGradient.n_cols, numUsers + numItems);
+    BOOST_REQUIRE_LE(pointGradient.n_nonzero, 2 * rank);
+    sum += pointGradient;
+  }
+
+  for (size_t i = 0; i < gradient.n_elem; i++)
+  {
+    if (std::abs(gradient[i]) <= 1e-6)
+      BOOST_REQUIRE_SMALL(sum[i], 1e-5);
+    else
+      BOOST_REQUIRE_CLOSE(sum[i], gradient[i], 1e-5);
+  }
+}
+
+/**
+ * Parallel SGD should recover a low-rank rating matrix, like SGD does in
+ * regularized_svd_test.cpp.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDParallelSGDOptimize)
+{
+  const size_t numUsers = 50;
+  const size_t numItems = 50;
+  const size_t numRatings = 100;
+  const size_t iterations = 30;
+  const size_t rank = 10;
+  // The SGD specialization for RegularizedSVDFunction takes half gradient
+  // steps, so this is the same step size.
+  const double alpha = 0.005;
+  const double lambda = 0.01;
+
+  arma::mat parameters = arma::randu(rank, numUsers + numItems);
+
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+
+  // Make rating entries based on the parameters.
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    data(2, i) = arma::dot(parameters.col(data(0, i)),
+                           parameters.col(numUsers + data(1, i)));
+  }
+
+  RegularizedSVDFunction rSVDFunc(data, rank, lambda);
+  ParallelSGD<RegularizedSVDFunction> optimizer(rSVDFunc, alpha,
+      iterations * numRatings, 1e-10);
+
+  arma::mat optParameters = arma::randu(rank, numUsers + numItems);
+  optimizer.Optimize(optParameters);
+
+  arma::mat predictedData(1, numRatings);
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    predictedData(0, i) = arma::dot(optParameters.col(data(0, i)),
+                                    optParameters.col(numUsers + data(1, i)));
+  }
+
+  const double relativeError = arma::norm(data.row(2) - predictedData, "frob") /
+                               arma::norm(data, "frob");
+
+  BOOST_REQUIRE_SMALL(relativeError, 1e-2);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,269 @@
+/**
+ * @file parameter_sweep_test.cpp
+ *
+ * Tests for the ParameterSweep cross-validation harness.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/parameter_sweep.hpp>
+#include <mlpack/methods/linear_regression/linear_regression.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::util;
+using namespace mlpack::regression;
+using namespace mlpack::neighbor;
+
+BOOST_AUTO_TEST_SUITE(ParameterSweepTest);
+
+/**
+ * Ridge regression with a different lambda for each configuration; the score
+ * is the negated squared error on the test points.
+ */
+class RidgeTask
+{
+ public:
+  typedef int FoldDataType;
+
+  RidgeTask(const arma::mat& predictors,
+            const arma::vec& responses,
+            const arma::vec& lambdas) :
+      predictors(predictors), responses(responses), lambdas(lambdas) { }
+
+  FoldDataType* Prepare(const arma::uvec& /* training */,
+                        const arma::uvec& /* test */) const
+  {
+    return NULL;
+  }
+
+  double Evaluate(const size_t configuration,
+                  const FoldDataType* /* foldData */,
+                  const arma::uvec& training,
+                  const arma::uvec& test) const
+  {
+    const arma::mat trainingPredictors = predictors.cols(training);
+    const arma::vec trainingResponses = responses.elem(training);
+    LinearRegression lr(trainingPredictors, trainingResponses,
+        lambdas[configuration]);
+
+    const arma::mat testPredictors = predictors.cols(test);
+    const arma::vec testResponses = responses.elem(test);
+    return -lr.ComputeError(testPredictors, testResponses);
+  }
+
+ private:
+  const arma::mat& predictors;
+  const arma::vec& responses;
+  const arma::vec& lambdas;
+};
+
+/**
+ * k-nearest-neighbor classification with a different k for each
+ * configuration.  The neighbors of the test points among the training points
+ * are found once for each fold (for the largest k), and shared by the
+ * configurations.
+ */
+class KNNClassificationTask
+{
+ public:
+  typedef arma::Mat<size_t> FoldDataType;
+
+  KNNClassificationTask(const arma::mat& data,
+                        const arma::Row<size_t>& labels,
+                        const std::vector<size_t>& k,
+                        std::vector<size_t>& prepareCalls) :
+      data(data), labels(labels), k(k), prepareCalls(prepareCalls) { }
+
+  FoldDataType* Prepare(const arma::uvec& training,
+                        const arma::uvec& test) const
+  {
+    // Each fold has its own counter, so this is safe.
+    for (size_t f = 0; f < prepareCalls.size(); ++f)
+      if (test[0] == testFirst[f])
+        ++prepareCalls[f];
+
+    const arma::mat referenceSet = data.cols(training);
+    const arma::mat querySet = data.cols(test);
+    AllkNN knn(referenceSet, querySet);
+
+    FoldDataType* neighbors = new FoldDataType();
+    arma::mat distances;
+    knn.Search(*std::max_element(k.begin(), k.end()), *neighbors, distances);
+    return neighbors;
+  }
+
+  double Evaluate(const size_t configuration,
+                  const FoldDataType* neighbors,
+                  const arma::uvec& training,
+                  const arma::uvec& test) const
+  {
+    size_t correct = 0;
+    for (size_t i = 0; i < test.n_elem; ++i)
+    {
+      // Two classes: a majority vote of the first k neighbors.
+      size_t votes = 0;
+      for (size_t j = 0; j < k[configuration]; ++j)
+        votes += labels[training[(*neighbors)(j, i)]];
+      const size_t prediction = (2 * votes > k[configuration]) ? 1 : 0;
+      if (prediction == labels[test[i]])
+        ++correct;
+    }
+
+    return double(correct) / test.n_elem;
+  }
+
+  //! The first test point of each fold, to identify the folds.
+  std::vector<size_t> testFirst;
+
+ private:
+  const arma::mat& data;
+  const arma::Row<size_t>& labels;
+  const std::vector<size_t>& k;
+  std::vector<size_t>& prepareCalls;
+};
+
+/**
+ * Make sure the folds partition the points.
+ */
+BOOST_AUTO_TEST_CASE(FoldSplitTest)
+{
+  const size_t numPoints = 103;
+  ParameterSweep<RidgeTask> sweep(numPoints, 10);
+
+  BOOST_REQUIRE_EQUAL(sweep.Folds(), 10);
+
+  std::vector<size_t> testCount(numPoints, 0);
+  for (size_t f = 0; f < sweep.Folds(); ++f)
+  {
+    const arma::uvec& test = sweep.TestIndices(f);
+    const arma::uvec& training = sweep.TrainingIndices(f);
+
+    // The first three folds get the three extra points.
+    BOOST_REQUIRE_EQUAL(test.n_elem, (f < 3) ? 11 : 10);
+    BOOST_REQUIRE_EQUAL(training.n_elem + test.n_elem, numPoints);
+
+    std::vector<bool> inFold(numPoints, false);
+    for (size_t i = 0; i < test.n_elem; ++i)
+    {
+      if (i > 0)
+        BOOST_REQUIRE_LT(test[i - 1], test[i]);
+      inFold[test[i]] = true;
+      ++testCount[test[i]];
+    }
+
+    for (size_t i = 0; i < training.n_elem; ++i)
+    {
+      if (i > 0)
+        BOOST_REQUIRE_LT(training[i - 1], training[i]);
+      BOOST_REQUIRE(!inFold[training[i]]);
+    }
+  }
+
+  for (size_t i = 0; i < numPoints; ++i)
+    BOOST_REQUIRE_EQUAL(testCount[i], 1);
+
+  // Without shuffling, each fold is a block of points.
+  ParameterSweep<RidgeTask> blocks(numPoints, 10, false);
+  BOOST_REQUIRE_EQUAL(blocks.TestIndices(0)[0], 0);
+  BOOST_REQUIRE_EQUAL(blocks.TestIndices(0)[10], 10);
+  BOOST_REQUIRE_EQUAL(blocks.TestIndices(3)[0], 33);
+  BOOST_REQUIRE_EQUAL(blocks.TestIndices(9)[9], 102);
+}
+
+/**
+ * Sweep lambda for ridge regression, and check each score against a serial
+ * evaluation of the same configuration and fold.
+ */
+BOOST_AUTO_TEST_CASE(RidgeSweepTest)
+{
+  arma::mat predictors(3, 200);
+  predictors.randu();
+  arma::vec weights("1.0 -2.0 3.0");
+  arma::vec noise(200);
+  noise.randn();
+  const arma::vec responses = predictors.t() * weights + 0.01 * noise;
+
+  const arma::vec lambdas("0.0 0.001 10.0 1000.0");
+  const RidgeTask task(predictors, responses, lambdas);
+
+  ParameterSweep<RidgeTask> sweep(predictors.n_cols, 5);
+  sweep.Run(task, lambdas.n_elem);
+  sweep.Report();
+
+  BOOST_REQUIRE_EQUAL(sweep.Scores().n_rows, lambdas.n_elem);
+  BOOST_REQUIRE_EQUAL(sweep.Scores().n_cols, 5);
+  BOOST_REQUIRE_EQUAL(sweep.Times().n_rows, lambdas.n_elem);
+  BOOST_REQUIRE_EQUAL(sweep.PrepareTimes().n_elem, 5);
+  BOOST_REQUIRE_GE(sweep.TotalTime(), 0.0);
+
+  for (size_t c = 0; c < lambdas.n_elem; ++c)
+  {
+    for (size_t f = 0; f < 5; ++f)
+    {
+      const double score = task.Evaluate(c, NULL, sweep.TrainingIndices(f),
+          sweep.TestIndices(f));
+      BOOST_REQUIRE_CLOSE(sweep.Scores()(c, f), score, 1e-5);
+      BOOST_REQUIRE_GE(sweep.Times()(c, f), 0.0);
+    }
+  }
+
+  // Heavy regularization is much worse on noiseless data.
+  const size_t best = sweep.BestConfiguration();
+  BOOST_REQUIRE_LT(best, 2);
+  BOOST_REQUIRE_EQUAL(sweep.BestConfiguration(false), 3);
+  BOOST_REQUIRE_GT(sweep.MeanScores()[best], sweep.MeanScores()[3]);
+}
+
+/**
+ * Sweep k for nearest neighbor classification, with the neighbors of each fold
+ * found once and shared by all the configurations.
+ */
+BOOST_AUTO_TEST_CASE(SharedFoldDataTest)
+{
+  // Two well-separated classes.
+  arma::mat data(2, 300);
+  data.randn();
+  arma::Row<size_t> labels(300);
+  for (size_t i = 0; i < 300; ++i)
+  {
+    labels[i] = i % 2;
+    data(0, i) += 10.0 * labels[i];
+  }
+
+  std::vector<size_t> k;
+  k.push_back(1);
+  k.push_back(3);
+  k.push_back(5);
+  k.push_back(9);
+
+  ParameterSweep<KNNClassificationTask> sweep(data.n_cols, 6);
+  std::vector<size_t> prepareCalls(6, 0);
+  KNNClassificationTask task(data, labels, k, prepareCalls);
+  for (size_t f = 0; f < 6; ++f)
+    task.testFirst.push_back(sweep.TestIndices(f)[0]);
+
+  sweep.Run(task, k.size());
+
+  for (size_t f = 0; f < 6; ++f)
+    BOOST_REQUIRE_EQUAL(prepareCalls[f], 1);
+
+  for (size_t i = 0; i < sweep.Scores().n_elem; ++i)
+  {
+    BOOST_REQUIRE_GE(sweep.Scores()[i], 0.95);
+    BOOST_REQUIRE_LE(sweep.Scores()[i], 1.0);
+  }
+
+  // Running again with one thread gives the same scores.
+  const arma::mat scores = sweep.Scores();
+  const size_t threads = NumThreads();
+  SetNumThreads(1);
+  sweep.Run(task, k.size());
+  SetNumThreads(threads);
+
+  for (size_t i = 0; i < scores.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(sweep.Scores()[i], scores[i], 1e-5);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/pca/pca.hpp>
+#include <mlpack/methods/pca/streaming_pca.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -85,6 +86,41 @@ BOOST_AUTO_TEST_CASE(PCADimensionalityReductionTest)
   BOOST_REQUIRE_CLOSE(varRetained, 0.904876047045906, 1e-5);
 }
 
+/**
+ * Make sure that reducing to a few dimensions of a high-dimensional dataset,
+ * which uses the randomized SVD, gives the same projection and variance
+ * retained as the full PCA.
+ */
+BOOST_AUTO_TEST_CASE(PCARandomizedDimensionalityReductionTest)
+{
+  // The variance is concentrated in a few directions, so the leading principal
+  // components are well separated.
+  mat data = randn<mat>(100, 6) * diagmat(linspace<vec>(10, 5, 6)) *
+      randn<mat>(6, 300) + 0.01 * randn<mat>(100, 300);
+
+  PCA p;
+  mat transformed;
+  vec eigVal;
+  p.Apply(data, transformed, eigVal);
+
+  mat reduced(data);
+  const double varRetained = p.Apply(reduced, 3);
+  BOOST_REQUIRE_EQUAL(reduced.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(reduced.n_cols, 300);
+  BOOST_REQUIRE_CLOSE(varRetained, sum(eigVal.subvec(0, 2)) / sum(eigVal),
+      1e-3);
+
+  // Each component is only defined up to its sign.
+  for (size_t i = 0; i < 3; ++i)
+  {
+    if (dot(reduced.row(i), transformed.row(i)) < 0)
+      reduced.row(i) *= -1;
+
+    BOOST_REQUIRE_SMALL(norm(reduced.row(i) - transformed.row(i), 2) /
+        norm(transformed.row(i), 2), 1e-3);
+  }
+}
+
 /**
  * Test that setting the variance retained parameter to perform dimensionality
  * reduction works.
@@ -198,4 +234,52 @@ BOOST_AUTO_TEST_CASE(PCAScalingTest)
 }
 
 
+/**
+ * Make sure that StreamingPCA, given the data in uneven chunks, finds the same
+ * eigenvalues and transformed data as PCA on the whole dataset, with and
+ * without scaling.
+ */
+BOOST_AUTO_TEST_CASE(StreamingPCATest)
+{
+  // Different scales and a shifted mean make the scaling matter.
+  mat data = diagmat(linspace<vec>(1, 8, 8)) * randn<mat>(8, 3000);
+  data.row(0) += 10.0;
+  data.row(3) += 0.5 * data.row(1);
+
+  for (size_t scale = 0; scale < 2; ++scale)
+  {
+    PCA p(scale == 1);
+    mat transformed, eigvec;
+    vec eigval;
+    p.Apply(data, transformed, eigval, eigvec);
+
+    StreamingPCA sp(scale == 1);
+    const size_t chunkSize = 1234;
+    for (size_t begin = 0; begin < data.n_cols; begin += chunkSize)
+      sp.Add(data.cols(begin, std::min((size_t) data.n_cols, begin +
+          chunkSize) - 1));
+    sp.Fit();
+
+    BOOST_REQUIRE_EQUAL(sp.Points(), data.n_cols);
+    for (size_t i = 0; i < 8; ++i)
+      BOOST_REQUIRE_CLOSE(sp.EigenValues()[i], eigval[i], 1e-5);
+
+    mat streamed;
+    sp.Transform(data, streamed, 3);
+    BOOST_REQUIRE_EQUAL(streamed.n_rows, 3);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      // Each component is only defined up to its sign.
+      if (dot(streamed.row(i), transformed.row(i)) < 0)
+        streamed.row(i) *= -1;
+
+      BOOST_REQUIRE_SMALL(norm(streamed.row(i) - transformed.row(i), 2) /
+          norm(transformed.row(i), 2), 1e-5);
+    }
+
+    BOOST_REQUIRE_CLOSE(sp.VarianceRetained(3), sum(eigval.subvec(0, 2)) /
+        sum(eigval), 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
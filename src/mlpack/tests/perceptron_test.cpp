@@ -166,4 +166,39 @@ BOOST_AUTO_TEST_CASE(SecondaryConstructor)
   Perceptron<> p2(p1);
 }
 
+/**
+ * The perceptron trained on shards in parallel should also separate a linearly
+ * separable dataset, and the blocked classification should agree with the
+ * weights for each point.
+ */
+BOOST_AUTO_TEST_CASE(ParallelShards)
+{
+  // Two well separated classes in three dimensions.
+  mat trainData = randu<mat>(3, 2000);
+  Row<size_t> labels(2000);
+  for (size_t i = 0; i < 2000; ++i)
+  {
+    labels[i] = i % 2;
+    trainData.col(i) += 3.0 * labels[i];
+  }
+
+  Perceptron<> p(trainData, labels, 1000, 4);
+  BOOST_REQUIRE_EQUAL(p.Shards(), 4);
+
+  Row<size_t> predictedLabels;
+  p.Classify(trainData, predictedLabels);
+
+  BOOST_REQUIRE_EQUAL(predictedLabels.n_elem, 2000);
+  for (size_t i = 0; i < 2000; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(predictedLabels[i], labels[i]);
+
+    vec scores = p.Weights().cols(1, 3) * trainData.col(i) +
+        p.Weights().col(0);
+    uword maxIndex = 0;
+    scores.max(maxIndex);
+    BOOST_REQUIRE_EQUAL(predictedLabels[i], maxIndex);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,138 @@
+/**
+ * @file pq_search_test.cpp
+ *
+ * Unit tests for the 'PQSearch' class.
+ */
+#include <mlpack/core.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+#include <mlpack/methods/pq/pq_search.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+BOOST_AUTO_TEST_SUITE(PQSearchTest);
+
+/**
+ * Return the fraction of queries whose true nearest neighbor is among the
+ * given approximate neighbors.
+ */
+double Recall(const arma::Mat<size_t>& trueNeighbors,
+              const arma::Mat<size_t>& neighbors)
+{
+  size_t found = 0;
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+      if (neighbors(j, i) == trueNeighbors(0, i))
+        ++found;
+
+  return (double) found / neighbors.n_cols;
+}
+
+/**
+ * The true nearest neighbor of most queries should be among the first ten
+ * approximate neighbors, with and without an inverted file; the neighbors
+ * should be sorted by distance.
+ */
+BOOST_AUTO_TEST_CASE(PQRecallTest)
+{
+  math::RandomSeed(0);
+
+  arma::mat referenceSet(8, 2000);
+  referenceSet.randu();
+  arma::mat querySet(8, 200);
+  querySet.randu();
+
+  AllkNN allknn(referenceSet, querySet);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  allknn.Search(1, trueNeighbors, trueDistances);
+
+  for (size_t lists = 0; lists <= 10; lists += 10)
+  {
+    PQSearch pq(referenceSet, querySet, 4, 64, lists, 5);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    pq.Search(10, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_rows, 10);
+    BOOST_REQUIRE_EQUAL(neighbors.n_cols, querySet.n_cols);
+    BOOST_REQUIRE_GE(Recall(trueNeighbors, neighbors), 0.8);
+
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      for (size_t j = 0; j < neighbors.n_rows; ++j)
+      {
+        BOOST_REQUIRE_LT(neighbors(j, i), referenceSet.n_cols);
+        if (j > 0)
+          BOOST_REQUIRE_LE(distances(j - 1, i), distances(j, i));
+      }
+    }
+  }
+}
+
+/**
+ * Adding single-precision points a batch at a time should give the same index
+ * as adding all of them at once.
+ */
+BOOST_AUTO_TEST_CASE(PQBatchAddTest)
+{
+  math::RandomSeed(0);
+
+  arma::fmat points(6, 1000);
+  points.randu();
+  const arma::mat referenceSet = arma::conv_to<arma::mat>::from(points);
+  arma::mat querySet(6, 100);
+  querySet.randu();
+
+  PQSearch pq(3, 32, 8, 2);
+  pq.Train(referenceSet);
+  PQSearch batchPQ(pq);
+
+  pq.Add(referenceSet);
+  batchPQ.Add(points.cols(0, 399));
+  batchPQ.Add(points.cols(400, 999));
+  BOOST_REQUIRE_EQUAL(batchPQ.NumPoints(), referenceSet.n_cols);
+
+  arma::Mat<size_t> neighbors, batchNeighbors;
+  arma::mat distances, batchDistances;
+  pq.Search(querySet, 5, neighbors, distances);
+  batchPQ.Search(querySet, 5, batchNeighbors, batchDistances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], batchNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], batchDistances[i], 1e-5);
+  }
+}
+
+/**
+ * When no query set is given, no point should be its own neighbor.
+ */
+BOOST_AUTO_TEST_CASE(PQMonochromaticTest)
+{
+  arma::mat referenceSet(4, 500);
+  referenceSet.randu();
+
+  PQSearch pq(referenceSet, 2, 16, 4, 4);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  pq.Search(3, neighbors, distances);
+
+  // Every list is scanned, so every query finds three neighbors.
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      BOOST_REQUIRE_NE(neighbors(j, i), i);
+      BOOST_REQUIRE_LT(neighbors(j, i), referenceSet.n_cols);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,165 @@
+/**
+ * @file quantized_search_test.cpp
+ *
+ * Unit tests for the QuantizedMatrix and the QuantizedSearch class.
+ */
+#include <mlpack/core.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+#include <mlpack/methods/neighbor_search/quantized_search.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+using namespace mlpack;
+using namespace mlpack::data;
+using namespace mlpack::neighbor;
+
+BOOST_AUTO_TEST_SUITE(QuantizedSearchTest);
+
+/**
+ * Each element of a quantized matrix is within half a step of the original,
+ * and a dimension in which every point is the same is kept exactly.
+ */
+BOOST_AUTO_TEST_CASE(QuantizedMatrixTest)
+{
+  arma::mat points(4, 500);
+  points.randu();
+  points.row(1) *= 100.0;
+  points.row(2).fill(3.0);
+  points.row(3) -= 10.0;
+
+  QuantizedMatrix quantized(points);
+  BOOST_REQUIRE_EQUAL(quantized.Dimensionality(), 4);
+  BOOST_REQUIRE_EQUAL(quantized.NumPoints(), 500);
+  BOOST_REQUIRE_EQUAL(quantized.Scales()[2], 0.0);
+
+  arma::mat dequantized;
+  quantized.Dequantize(dequantized);
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    for (size_t d = 0; d < points.n_rows; ++d)
+    {
+      BOOST_REQUIRE_LE(std::abs(dequantized(d, i) - points(d, i)),
+          quantized.Scales()[d] / 2 + 1e-10);
+    }
+  }
+
+  arma::vec point;
+  quantized.Dequantize(17, point);
+  for (size_t d = 0; d < points.n_rows; ++d)
+    BOOST_REQUIRE_EQUAL(point[d], dequantized(d, 17));
+}
+
+/**
+ * The quantized distances are the distances to the dequantized points, and the
+ * distance to a box of codes is never more than the distance to any point in
+ * it.
+ */
+BOOST_AUTO_TEST_CASE(QuantizedDistanceTest)
+{
+  arma::mat points(13, 300); // Not a multiple of 8 dimensions.
+  points.randn();
+  QuantizedMatrix quantized(points);
+
+  arma::mat dequantized;
+  quantized.Dequantize(dequantized);
+
+  arma::Col<unsigned char> lo = arma::min(quantized.Codes(), 1);
+  arma::Col<unsigned char> hi = arma::max(quantized.Codes(), 1);
+
+  arma::vec query(13);
+  query.randn();
+  query += 5.0; // Keep the distances away from zero.
+  QuantizedDistance distance(quantized, query);
+
+  const double boxDistance = distance.MinDistance(lo.memptr(), hi.memptr());
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    const double expected = arma::accu(arma::square(query -
+        dequantized.col(i)));
+    const double squared = distance.Evaluate(quantized.Column(i));
+    BOOST_REQUIRE_CLOSE(squared, expected, 1e-3);
+    BOOST_REQUIRE_LE(boxDistance, squared);
+
+    // The box of a single point is the point.
+    BOOST_REQUIRE_EQUAL(distance.MinDistance(quantized.Column(i),
+        quantized.Column(i)), distance.Evaluate(quantized.Column(i)));
+  }
+}
+
+/**
+ * The tree prunes nodes without losing any neighbor: it finds exactly the
+ * neighbors of a scan of every quantized point.
+ */
+BOOST_AUTO_TEST_CASE(TreeVsNaiveTest)
+{
+  arma::mat referenceSet(10, 2000);
+  referenceSet.randu();
+  arma::mat querySet(10, 200);
+  querySet.randu();
+
+  QuantizedSearch naive(referenceSet, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(querySet, 10, naiveNeighbors, naiveDistances);
+  BOOST_REQUIRE_EQUAL(naive.NumNodes(), 0);
+
+  for (size_t leafSize = 1; leafSize <= 41; leafSize += 20)
+  {
+    QuantizedSearch search(referenceSet, false, leafSize);
+    search.NumThreads() = 4;
+    BOOST_REQUIRE_GT(search.NumNodes(), 1);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    search.Search(querySet, 10, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Re-ranking every point gives the exact neighbors, and re-ranking a few
+ * candidates gives almost all of them.
+ */
+BOOST_AUTO_TEST_CASE(RerankTest)
+{
+  arma::mat referenceSet(8, 2000);
+  referenceSet.randu();
+  arma::mat querySet(8, 200);
+  querySet.randu();
+
+  AllkNN allknn(referenceSet, querySet, true);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  allknn.Search(5, trueNeighbors, trueDistances);
+
+  QuantizedSearch search(referenceSet);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  search.Search(querySet, referenceSet, 5, 2000, neighbors, distances);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], trueNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], trueDistances[i], 1e-5);
+  }
+
+  search.Search(querySet, referenceSet, 5, 20, neighbors, distances);
+  size_t found = 0;
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    if (neighbors[i] == trueNeighbors[i])
+    {
+      BOOST_REQUIRE_CLOSE(distances[i], trueDistances[i], 1e-5);
+      ++found;
+    }
+  }
+  BOOST_REQUIRE_GE((double) found / neighbors.n_elem, 0.95);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
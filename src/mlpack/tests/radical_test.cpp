@@ -52,4 +52,41 @@ BOOST_AUTO_TEST_CASE(Radical_Test_Radical3D)
   BOOST_REQUIRE_CLOSE(valBest, valEst, 0.25);
 }
 
+/**
+ * Make sure that the returned unmixing matrix gives the returned independent
+ * components, and that it still whitens the data after the rotations.
+ */
+BOOST_AUTO_TEST_CASE(Radical_Test_UnmixingMatrix)
+{
+  mat matX;
+  data::Load("data_3d_mixed.txt", matX);
+
+  Radical rad(0.175, 5, 100, matX.n_rows - 1);
+
+  mat matY;
+  mat matW;
+  rad.DoRadical(matX, matY, matW);
+
+  BOOST_REQUIRE_EQUAL(matW.n_rows, matX.n_rows);
+  BOOST_REQUIRE_EQUAL(matW.n_cols, matX.n_rows);
+
+  // Y = W X.
+  const mat matWX = matW * matX;
+  for (uword i = 0; i < matY.n_elem; i++)
+    BOOST_REQUIRE_SMALL(matY[i] - matWX[i], 1e-8);
+
+  // The rotations keep the components white, so W is not just any matrix
+  // that maps X to Y.
+  const mat covY = cov(trans(matY));
+  for (uword i = 0; i < covY.n_rows; i++)
+    for (uword j = 0; j < covY.n_cols; j++)
+      BOOST_REQUIRE_SMALL(covY(i, j) - ((i == j) ? 1.0 : 0.0), 1e-8);
+
+  // The sweeps have rotated the whitened data, so W is no longer the
+  // whitening matrix.
+  mat matXWhitened, matWhitening;
+  WhitenFeatureMajorMatrix(trans(matX), matXWhitened, matWhitening);
+  BOOST_REQUIRE_GT(norm(matW - trans(matWhitening), "fro"), 1e-3);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/range_search/range_search.hpp>
+#include <mlpack/methods/range_search/window_search.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -538,6 +539,47 @@ BOOST_AUTO_TEST_CASE(DualTreeVsNaive2)
   }
 }
 
+/**
+ * Make sure that building the tree on the memory of the given dataset gives the
+ * same results as building it on a copy.
+ */
+BOOST_AUTO_TEST_CASE(DualTreeTakeDatasetTest)
+{
+  arma::mat dataForTree;
+  if (!data::Load("test_data_3_1000.csv", dataForTree))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::mat dataTaken(dataForTree);
+
+  RangeSearch<> rs(dataForTree);
+  RangeSearch<> taken(&dataTaken);
+
+  // The memory of the matrix was taken.
+  BOOST_REQUIRE(dataTaken.is_empty());
+  BOOST_REQUIRE_EQUAL(taken.ReferenceSet().n_cols, dataForTree.n_cols);
+  BOOST_REQUIRE_EQUAL(taken.OldFromNewReferences().size(), dataForTree.n_cols);
+
+  vector<vector<size_t> > neighbors, neighborsTaken;
+  vector<vector<double> > distances, distancesTaken;
+  rs.Search(Range(0.25, 1.05), neighbors, distances);
+  taken.Search(Range(0.25, 1.05), neighborsTaken, distancesTaken);
+  vector<vector<pair<double, size_t> > > sorted, sortedTaken;
+  SortResults(neighbors, distances, sorted);
+  SortResults(neighborsTaken, distancesTaken, sortedTaken);
+
+  BOOST_REQUIRE_EQUAL(sorted.size(), sortedTaken.size());
+  for (size_t i = 0; i < sorted.size(); i++)
+  {
+    BOOST_REQUIRE_EQUAL(sorted[i].size(), sortedTaken[i].size());
+
+    for (size_t j = 0; j < sorted[i].size(); j++)
+    {
+      BOOST_REQUIRE_EQUAL(sorted[i][j].second, sortedTaken[i][j].second);
+      BOOST_REQUIRE_CLOSE(sorted[i][j].first, sortedTaken[i][j].first, 1e-5);
+    }
+  }
+}
+
 /**
  * Test the single-tree range search method with the naive method.  This
  * uses only a reference dataset.
@@ -826,8 +868,103 @@ BOOST_AUTO_TEST_CASE(CoverTreeSingleTreeTest)
 }
 
 /**
- * Ensure that single-tree ball tree range search works.
+ * Ensure that multithreaded single-tree range search gives the same results as
+ * naive search, both with kd-trees and with cover trees (which need a copy of
+ * the reference tree for each thread).
  */
+BOOST_AUTO_TEST_CASE(ParallelSingleTreeTest)
+{
+  arma::mat data;
+  data.randu(8, 1000); // 1000 points in 8 dimensions.
+
+  typedef tree::CoverTree<metric::EuclideanDistance, tree::FirstPointIsRoot,
+      RangeSearchStat> CoverTreeType;
+  CoverTreeType tree(data);
+  RangeSearch<metric::EuclideanDistance, CoverTreeType>
+      coversearch(&tree, data, true);
+  coversearch.NumThreads() = 4;
+
+  RangeSearch<> kdsearch(data, false, true);
+  kdsearch.NumThreads() = 4;
+
+  RangeSearch<> naive(data, true);
+
+  const Range range(0.5, 1.0);
+
+  vector<vector<size_t> > naiveNeighbors, kdNeighbors, coverNeighbors;
+  vector<vector<double> > naiveDistances, kdDistances, coverDistances;
+
+  naive.Search(range, naiveNeighbors, naiveDistances);
+  kdsearch.Search(range, kdNeighbors, kdDistances);
+  coversearch.Search(range, coverNeighbors, coverDistances);
+
+  vector<vector<pair<double, size_t> > > naiveSorted, kdSorted, coverSorted;
+  SortResults(naiveNeighbors, naiveDistances, naiveSorted);
+  SortResults(kdNeighbors, kdDistances, kdSorted);
+  SortResults(coverNeighbors, coverDistances, coverSorted);
+
+  for (size_t i = 0; i < naiveSorted.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(naiveSorted[i].size(), kdSorted[i].size());
+    BOOST_REQUIRE_EQUAL(naiveSorted[i].size(), coverSorted[i].size());
+
+    for (size_t j = 0; j < naiveSorted[i].size(); ++j)
+    {
+      BOOST_REQUIRE_EQUAL(naiveSorted[i][j].second, kdSorted[i][j].second);
+      BOOST_REQUIRE_EQUAL(naiveSorted[i][j].second, coverSorted[i][j].second);
+      BOOST_REQUIRE_CLOSE(naiveSorted[i][j].first, kdSorted[i][j].first,
+          1e-5);
+      BOOST_REQUIRE_CLOSE(naiveSorted[i][j].first, coverSorted[i][j].first,
+          1e-5);
+    }
+  }
+}
+
+/**
+ * Ensure that single-tree range search gives the same results when the queries
+ * are visited along the Hilbert curve.
+ */
+BOOST_AUTO_TEST_CASE(ReorderedSingleTreeTest)
+{
+  arma::mat references;
+  references.randu(4, 1000);
+  arma::mat queries;
+  queries.randu(4, 300);
+
+  RangeSearch<> single(references, queries, false, true);
+  single.ReorderQueries() = true;
+  single.NumThreads() = 4;
+
+  RangeSearch<> naive(references, queries, true);
+
+  const Range range(0.2, 0.4);
+
+  vector<vector<size_t> > naiveNeighbors, singleNeighbors;
+  vector<vector<double> > naiveDistances, singleDistances;
+
+  naive.Search(range, naiveNeighbors, naiveDistances);
+  single.Search(range, singleNeighbors, singleDistances);
+
+  vector<vector<pair<double, size_t> > > naiveSorted, singleSorted;
+  SortResults(naiveNeighbors, naiveDistances, naiveSorted);
+  SortResults(singleNeighbors, singleDistances, singleSorted);
+
+  BOOST_REQUIRE_EQUAL(naiveSorted.size(), singleSorted.size());
+  for (size_t i = 0; i < naiveSorted.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(naiveSorted[i].size(), singleSorted[i].size());
+
+    for (size_t j = 0; j < naiveSorted[i].size(); ++j)
+    {
+      BOOST_REQUIRE_EQUAL(naiveSorted[i][j].second, singleSorted[i][j].second);
+      BOOST_REQUIRE_CLOSE(naiveSorted[i][j].first, singleSorted[i][j].first,
+          1e-5);
+    }
+  }
+}
+
+/**
+ * Ensure that single-tree ball tree range search works.
 BOOST_AUTO_TEST_CASE(SingleBallTreeTest)
 {
   arma::mat data;
@@ -1060,4 +1197,310 @@ BOOST_AUTO_TEST_CASE(DualBallTreeTest2)
   }
 }
 
+/**
+ * Make sure that range search works on single-precision data, by comparing the
+ * dual-tree search with the naive search.
+ */
+BOOST_AUTO_TEST_CASE(FloatDualTreeVsNaive)
+{
+  arma::mat dataForTree;
+  if (!data::Load("test_data_3_1000.csv", dataForTree))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::fmat dualQuery = arma::conv_to<arma::fmat>::from(dataForTree);
+  arma::fmat naiveQuery(dualQuery);
+
+  typedef BinarySpaceTree<HRectBound<2>, RangeSearchStat, arma::fmat>
+      FloatTreeType;
+  RangeSearch<metric::EuclideanDistance, FloatTreeType> rs(dualQuery);
+  RangeSearch<metric::EuclideanDistance, FloatTreeType> naive(naiveQuery,
+      true);
+
+  vector<vector<size_t> > neighborsTree;
+  vector<vector<double> > distancesTree;
+  rs.Search(Range(0.25, 1.05), neighborsTree, distancesTree);
+  vector<vector<pair<double, size_t> > > sortedTree;
+  SortResults(neighborsTree, distancesTree, sortedTree);
+
+  vector<vector<size_t> > neighborsNaive;
+  vector<vector<double> > distancesNaive;
+  naive.Search(Range(0.25, 1.05), neighborsNaive, distancesNaive);
+  vector<vector<pair<double, size_t> > > sortedNaive;
+  SortResults(neighborsNaive, distancesNaive, sortedNaive);
+
+  for (size_t i = 0; i < sortedTree.size(); i++)
+  {
+    BOOST_REQUIRE(sortedTree[i].size() == sortedNaive[i].size());
+
+    for (size_t j = 0; j < sortedTree[i].size(); j++)
+    {
+      BOOST_REQUIRE(sortedTree[i][j].second == sortedNaive[i][j].second);
+      BOOST_REQUIRE_CLOSE(sortedTree[i][j].first, sortedNaive[i][j].first,
+          1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that the compressed sparse row output of each search mode holds
+ * the same results as the vector output, both when the query set is the
+ * reference set and when it is separate (so the query points are mapped too).
+ */
+BOOST_AUTO_TEST_CASE(CSRSearchTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 500);
+  arma::mat queryData;
+  queryData.randu(3, 300);
+
+  const Range range(0.1, 0.3);
+
+  // Mode 0 is naive, mode 1 is single-tree (with several threads), and mode 2
+  // is dual-tree.
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    for (size_t separate = 0; separate < 2; ++separate)
+    {
+      RangeSearch<>* rs = NULL;
+      if (separate == 1)
+        rs = new RangeSearch<>(referenceData, queryData, (mode == 0),
+            (mode == 1));
+      else
+        rs = new RangeSearch<>(referenceData, (mode == 0), (mode == 1));
+      rs->NumThreads() = 4;
+
+      vector<vector<size_t> > neighbors;
+      vector<vector<double> > distances;
+      rs->Search(range, neighbors, distances);
+
+      arma::Col<size_t> offsets;
+      arma::Col<size_t> csrNeighbors;
+      arma::vec csrDistances;
+      rs->Search(range, offsets, csrNeighbors, csrDistances);
+
+      delete rs;
+
+      BOOST_REQUIRE_EQUAL(offsets.n_elem, neighbors.size() + 1);
+      BOOST_REQUIRE_EQUAL(offsets[0], (size_t) 0);
+      BOOST_REQUIRE_EQUAL(offsets[neighbors.size()], csrNeighbors.n_elem);
+      BOOST_REQUIRE_EQUAL(csrDistances.n_elem, csrNeighbors.n_elem);
+
+      // Unpack the rows so they can be sorted.
+      vector<vector<size_t> > unpackedNeighbors(neighbors.size());
+      vector<vector<double> > unpackedDistances(neighbors.size());
+      for (size_t i = 0; i < neighbors.size(); ++i)
+      {
+        for (size_t j = offsets[i]; j < offsets[i + 1]; ++j)
+        {
+          unpackedNeighbors[i].push_back(csrNeighbors[j]);
+          unpackedDistances[i].push_back(csrDistances[j]);
+        }
+      }
+
+      vector<vector<pair<double, size_t> > > sorted, csrSorted;
+      SortResults(neighbors, distances, sorted);
+      SortResults(unpackedNeighbors, unpackedDistances, csrSorted);
+
+      for (size_t i = 0; i < sorted.size(); ++i)
+      {
+        BOOST_REQUIRE_EQUAL(sorted[i].size(), csrSorted[i].size());
+        for (size_t j = 0; j < sorted[i].size(); ++j)
+        {
+          BOOST_REQUIRE_EQUAL(sorted[i][j].second, csrSorted[i][j].second);
+          BOOST_REQUIRE_CLOSE(sorted[i][j].first, csrSorted[i][j].first,
+              1e-5);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that Count() gives the number of results that Search() finds, for
+ * each search mode and tree type.  The range starts at 0 so that whole nodes
+ * holding the query point itself are counted.
+ */
+BOOST_AUTO_TEST_CASE(CountTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(3, 500);
+  arma::mat queryData;
+  queryData.randu(3, 300);
+
+  typedef tree::CoverTree<metric::EuclideanDistance, tree::FirstPointIsRoot,
+      RangeSearchStat> CoverTreeType;
+  typedef RangeSearch<metric::EuclideanDistance, CoverTreeType>
+      CoverSearchType;
+
+  for (size_t r = 0; r < 2; ++r)
+  {
+    const Range range((r == 0) ? 0.0 : 0.1, 0.3);
+
+    // Mode 0 is naive, mode 1 is single-tree (with several threads), and mode
+    // 2 is dual-tree.
+    for (size_t mode = 0; mode < 3; ++mode)
+    {
+      for (size_t separate = 0; separate < 2; ++separate)
+      {
+        RangeSearch<>* rs = NULL;
+        CoverSearchType* coverSearch = NULL;
+        if (separate == 1)
+        {
+          rs = new RangeSearch<>(referenceData, queryData, (mode == 0),
+              (mode == 1));
+          coverSearch = new CoverSearchType(referenceData, queryData,
+              (mode == 0), (mode == 1));
+        }
+        else
+        {
+          rs = new RangeSearch<>(referenceData, (mode == 0), (mode == 1));
+          coverSearch = new CoverSearchType(referenceData, (mode == 0),
+              (mode == 1));
+        }
+        rs->NumThreads() = 4;
+        coverSearch->NumThreads() = 4;
+
+        vector<vector<size_t> > neighbors;
+        vector<vector<double> > distances;
+        rs->Search(range, neighbors, distances);
+
+        arma::Col<size_t> counts, coverCounts;
+        rs->Count(range, counts);
+        coverSearch->Count(range, coverCounts);
+
+        delete rs;
+        delete coverSearch;
+
+        BOOST_REQUIRE_EQUAL(counts.n_elem, neighbors.size());
+        BOOST_REQUIRE_EQUAL(coverCounts.n_elem, neighbors.size());
+        for (size_t i = 0; i < neighbors.size(); ++i)
+        {
+          BOOST_REQUIRE_EQUAL(counts[i], neighbors[i].size());
+          BOOST_REQUIRE_EQUAL(coverCounts[i], neighbors[i].size());
+        }
+      }
+    }
+  }
+}
+
+/**
+ * A monochromatic dual-tree search traverses the tree against itself, visiting
+ * each pair of points once; make sure that its results and counts match the
+ * naive search, including when whole pairs of nodes are in range.
+ */
+BOOST_AUTO_TEST_CASE(SymmetricDualTreeTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 800);
+
+  for (size_t r = 0; r < 2; ++r)
+  {
+    const Range range(0.0, (r == 0) ? 0.15 : 0.9);
+
+    RangeSearch<> rs(dataset);
+    RangeSearch<> naive(dataset, true);
+
+    vector<vector<size_t> > neighborsTree, neighborsNaive;
+    vector<vector<double> > distancesTree, distancesNaive;
+    rs.Search(range, neighborsTree, distancesTree);
+    naive.Search(range, neighborsNaive, distancesNaive);
+
+    BOOST_REQUIRE_LT(rs.Statistics().BaseCases(),
+        dataset.n_cols * (dataset.n_cols - 1) / 2);
+
+    vector<vector<pair<double, size_t> > > sortedTree, sortedNaive;
+    SortResults(neighborsTree, distancesTree, sortedTree);
+    SortResults(neighborsNaive, distancesNaive, sortedNaive);
+
+    arma::Col<size_t> counts;
+    rs.Count(range, counts);
+
+    BOOST_REQUIRE_EQUAL(sortedTree.size(), sortedNaive.size());
+    for (size_t i = 0; i < sortedTree.size(); i++)
+    {
+      BOOST_REQUIRE_EQUAL(sortedTree[i].size(), sortedNaive[i].size());
+      BOOST_REQUIRE_EQUAL(counts[i], sortedNaive[i].size());
+
+      for (size_t j = 0; j < sortedTree[i].size(); j++)
+      {
+        BOOST_REQUIRE_EQUAL(sortedTree[i][j].second, sortedNaive[i][j].second);
+        BOOST_REQUIRE_CLOSE(sortedTree[i][j].first, sortedNaive[i][j].first,
+            1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * Window search finds the same points inside each window with a single-tree
+ * traversal, a dual-tree traversal, and a naive scan, including windows that
+ * hold everything, nothing, or a single point on their border.
+ */
+BOOST_AUTO_TEST_CASE(WindowSearchTest)
+{
+  arma::mat points(2, 3000);
+  points.randu();
+
+  std::vector<HRectBound<> > windows;
+  for (size_t i = 0; i < 300; ++i)
+  {
+    arma::vec corner(2, arma::fill::randu);
+    arma::vec size(2, arma::fill::randu);
+    size *= (i % 3 == 0) ? 0.5 : 0.05;
+
+    HRectBound<> window(2);
+    for (size_t d = 0; d < 2; ++d)
+      window[d] = Range(corner[d] - size[d] / 2, corner[d] + size[d] / 2);
+    windows.push_back(window);
+  }
+
+  HRectBound<> all(2);
+  all |= points;
+  windows.push_back(all);
+
+  HRectBound<> none(2);
+  none[0] = Range(2.0, 3.0);
+  none[1] = Range(0.0, 1.0);
+  windows.push_back(none);
+
+  HRectBound<> point(2);
+  point[0] = Range(points(0, 17), points(0, 17));
+  point[1] = Range(points(1, 17), points(1, 17));
+  windows.push_back(point);
+
+  WindowSearch<> naive(points, true);
+  std::vector<std::vector<size_t> > naiveResults;
+  naive.Search(windows, naiveResults);
+
+  BOOST_REQUIRE_EQUAL(naiveResults[300].size(), 3000);
+  BOOST_REQUIRE_EQUAL(naiveResults[301].size(), 0);
+  BOOST_REQUIRE_EQUAL(naiveResults[302].size(), 1);
+  BOOST_REQUIRE_EQUAL(naiveResults[302][0], 17);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    WindowSearch<> search(points, false, (mode == 0));
+    std::vector<std::vector<size_t> > results;
+    search.Search(windows, results);
+
+    BOOST_REQUIRE_EQUAL(results.size(), windows.size());
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(results[i].size(), naiveResults[i].size());
+      for (size_t j = 0; j < results[i].size(); ++j)
+        BOOST_REQUIRE_EQUAL(results[i][j], naiveResults[i][j]);
+    }
+
+    // Most of the points are pruned or taken with their nodes.
+    BOOST_REQUIRE_LT(search.Statistics().BaseCases(),
+        naive.Statistics().BaseCases() / 4);
+
+    std::vector<size_t> single;
+    search.Search(windows[5], single);
+    BOOST_REQUIRE_EQUAL(single.size(), naiveResults[5].size());
+    for (size_t j = 0; j < single.size(); ++j)
+      BOOST_REQUIRE_EQUAL(single[j], naiveResults[5][j]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
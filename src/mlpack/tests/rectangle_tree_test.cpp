@@ -182,10 +182,10 @@ void CheckExactContainment(const TreeType& tree)
       double max = -1.0 * DBL_MAX;
       for(size_t j = 0; j < tree.Count(); j++)
       {
-        if (tree.LocalDataset().col(j)[i] < min)
-          min = tree.LocalDataset().col(j)[i];
-        if (tree.LocalDataset().col(j)[i] > max)
-          max = tree.LocalDataset().col(j)[i];
+        if (tree.Dataset().col(tree.Points()[j])[i] < min)
+          min = tree.Dataset().col(tree.Points()[j])[i];
+        if (tree.Dataset().col(tree.Points()[j])[i] > max)
+          max = tree.Dataset().col(tree.Points()[j])[i];
       }
       BOOST_REQUIRE_EQUAL(max, tree.Bound()[i].Hi());
       BOOST_REQUIRE_EQUAL(min, tree.Bound()[i].Lo());
@@ -248,8 +248,9 @@ BOOST_AUTO_TEST_CASE(RectangleTreeContainmentTest)
 }
 
 /**
- * A function to ensure that the dataset for the tree, and the datasets stored
- * in each leaf node are in sync.
+ * A function to ensure that the point indices stored in each leaf node are
+ * valid indices into the dataset of the tree, and that the points they refer
+ * to are inside the bound of the leaf.
  * @param tree The tree to check.
  */
 template<typename TreeType>
@@ -259,11 +260,9 @@ void CheckSync(const TreeType& tree)
   {
     for (size_t i = 0; i < tree.Count(); i++)
     {
-      for (size_t j = 0; j < tree.LocalDataset().n_rows; j++)
-      {
-        BOOST_REQUIRE_EQUAL(tree.LocalDataset().col(i)[j],
-                            tree.Dataset().col(tree.Points()[i])[j]);
-      }
+      BOOST_REQUIRE_LT(tree.Points()[i], tree.Dataset().n_cols);
+      BOOST_REQUIRE(tree.Bound().Contains(
+          tree.Dataset().col(tree.Points()[i])));
     }
   }
   else
@@ -273,9 +272,9 @@ void CheckSync(const TreeType& tree)
   }
 }
 
-// Test to ensure that the dataset used by the whole tree (and the traversers)
-// is in sync with the datasets stored in each leaf node.
-BOOST_AUTO_TEST_CASE(TreeLocalDatasetInSync)
+// Test to ensure that the point indices stored in each leaf node refer to
+// points of the dataset used by the whole tree (and the traversers).
+BOOST_AUTO_TEST_CASE(TreeLeafPointsInSync)
 {
   arma::mat dataset;
   dataset.randu(8, 1000); // 1000 points in 8 dimensions.
@@ -884,4 +883,209 @@ BOOST_AUTO_TEST_CASE(RStarTreeSplitTest)
       0.9, 1e-15);
 }
 
+// Make sure that the Hilbert keys order the points of a grid along a curve
+// which only ever moves to an adjacent point.
+BOOST_AUTO_TEST_CASE(HilbertKeyOrderTest)
+{
+  typedef HilbertRTreeSplit<RTreeDescentHeuristic,
+                            NeighborSearchStat<NearestNeighborSort>,
+                            arma::mat> SplitType;
+
+  arma::mat grid(2, 64);
+  for (size_t i = 0; i < 64; i++)
+  {
+    grid(0, i) = i % 8;
+    grid(1, i) = i / 8;
+  }
+
+  HRectBound<> bound(2);
+  bound |= grid;
+
+  std::vector<std::vector<uint64_t> > keys(64);
+  std::vector<std::pair<std::vector<uint64_t>, size_t> > order(64);
+  for (size_t i = 0; i < 64; i++)
+  {
+    SplitType::HilbertKey(grid.col(i), bound, keys[i]);
+    order[i] = std::make_pair(keys[i], i);
+  }
+
+  std::sort(order.begin(), order.end());
+
+  // Every point has its own key, and consecutive points are neighbors.
+  for (size_t i = 1; i < 64; i++)
+  {
+    BOOST_REQUIRE(order[i - 1].first < order[i].first);
+    const arma::vec step = grid.col(order[i].second) -
+        grid.col(order[i - 1].second);
+    BOOST_REQUIRE_CLOSE(arma::accu(arma::abs(step)), 1.0, 1e-10);
+  }
+}
+
+// Make sure that HilbertOrder() visits the points of a shuffled grid along a
+// curve which only ever moves to an adjacent point.
+BOOST_AUTO_TEST_CASE(HilbertOrderTest)
+{
+  arma::mat grid(2, 64);
+  for (size_t i = 0; i < 64; i++)
+  {
+    grid(0, i) = i % 8;
+    grid(1, i) = i / 8;
+  }
+  const arma::mat shuffled =
+      grid.cols(arma::shuffle(arma::linspace<arma::uvec>(0, 63, 64)));
+
+  std::vector<size_t> order;
+  HilbertOrder(shuffled, order);
+
+  BOOST_REQUIRE_EQUAL(order.size(), 64);
+  std::vector<bool> seen(64, false);
+  for (size_t i = 0; i < 64; i++)
+  {
+    BOOST_REQUIRE_LT(order[i], 64);
+    BOOST_REQUIRE(!seen[order[i]]);
+    seen[order[i]] = true;
+
+    if (i > 0)
+    {
+      const arma::vec step = shuffled.col(order[i]) -
+          shuffled.col(order[i - 1]);
+      BOOST_REQUIRE_CLOSE(arma::accu(arma::abs(step)), 1.0, 1e-10);
+    }
+  }
+}
+
+// Make sure that a tree split along the Hilbert curve holds every point, has
+// tight bounds, and meets the fill requirements.
+BOOST_AUTO_TEST_CASE(HilbertRTreeSplitTest)
+{
+  arma::mat dataset;
+  dataset.randu(8, 1000); // 1000 points in 8 dimensions.
+
+  typedef RectangleTree<
+      HilbertRTreeSplit<RTreeDescentHeuristic,
+                        NeighborSearchStat<NearestNeighborSort>,
+                        arma::mat>,
+      RTreeDescentHeuristic,
+      NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+
+  TreeType tree(dataset, 20, 6, 5, 2, 0);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1000);
+  CheckContainment(tree);
+  CheckExactContainment(tree);
+  CheckSync(tree);
+  CheckFills(tree);
+  CheckHierarchy(tree);
+}
+
+// Make sure that a bulk-loaded tree holds every point exactly once, is
+// balanced, meets the fill requirements, and gives the same nearest neighbors
+// as a naive search.
+BOOST_AUTO_TEST_CASE(BulkLoadTest)
+{
+  arma::mat dataset;
+  dataset.randu(8, 2000); // 2000 points in 8 dimensions.
+
+  typedef RectangleTree<
+      RStarTreeSplit<RStarTreeDescentHeuristic,
+                     NeighborSearchStat<NearestNeighborSort>,
+                     arma::mat>,
+      RStarTreeDescentHeuristic,
+      NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  TreeType tree(dataset, 20, 6, 5, 2, 0, true);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 2000);
+  CheckContainment(tree);
+  CheckExactContainment(tree);
+  CheckSync(tree);
+  CheckFills(tree);
+  BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+  BOOST_REQUIRE_EQUAL(tree.TreeDepth(), GetMinLevel(tree));
+
+  NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>, TreeType>
+      allknn1(&tree, dataset, true);
+  arma::Mat<size_t> neighbors1;
+  arma::mat distances1;
+  allknn1.Search(5, neighbors1, distances1);
+
+  AllkNN allknn2(dataset, true, true);
+  arma::Mat<size_t> neighbors2;
+  arma::mat distances2;
+  allknn2.Search(5, neighbors2, distances2);
+
+  for (size_t i = 0; i < neighbors1.size(); i++)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors1[i], neighbors2[i]);
+    BOOST_REQUIRE_EQUAL(distances1[i], distances2[i]);
+  }
+}
+
+// Insert and delete points in batches, both small batches (which go through
+// the split policy) and large ones (which rebuild the tree), and make sure the
+// tree stays valid.
+BOOST_AUTO_TEST_CASE(BatchInsertDeleteTest)
+{
+  arma::mat dataset;
+  dataset.randu(8, 1000);
+
+  typedef RectangleTree<
+      RStarTreeSplit<RStarTreeDescentHeuristic,
+                     NeighborSearchStat<NearestNeighborSort>,
+                     arma::mat>,
+      RStarTreeDescentHeuristic,
+      NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  TreeType tree(dataset, 20, 6, 5, 2, 0, true);
+
+  // Make room for the new points first, since the tree refers to the dataset.
+  dataset.reshape(8, 2500);
+  dataset.cols(1000, 2499).randu();
+
+  // A small batch is inserted point by point.
+  std::vector<size_t> newPoints;
+  for (size_t i = 1000; i < 1100; i++)
+    newPoints.push_back(i);
+  tree.InsertPoints(newPoints);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1100);
+  CheckContainment(tree);
+  CheckSync(tree);
+  CheckFills(tree);
+
+  // A large batch rebuilds the tree.
+  newPoints.clear();
+  for (size_t i = 1100; i < 2500; i++)
+    newPoints.push_back(i);
+  tree.InsertPoints(newPoints);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 2500);
+  CheckContainment(tree);
+  CheckExactContainment(tree);
+  CheckSync(tree);
+  CheckFills(tree);
+  BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+
+  // Delete a few points, then most of the rest; the second batch also asks
+  // for points that are no longer in the tree.
+  std::vector<size_t> oldPoints;
+  for (size_t i = 0; i < 50; i++)
+    oldPoints.push_back(i);
+  BOOST_REQUIRE_EQUAL(tree.DeletePoints(oldPoints), 50);
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 2450);
+  CheckContainment(tree);
+  CheckSync(tree);
+
+  oldPoints.clear();
+  for (size_t i = 0; i < 2000; i++)
+    oldPoints.push_back(i);
+  BOOST_REQUIRE_EQUAL(tree.DeletePoints(oldPoints), 1950);
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 500);
+  CheckContainment(tree);
+  CheckExactContainment(tree);
+  CheckSync(tree);
+  CheckFills(tree);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -189,6 +189,49 @@ BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionGradient)
   }
 }
 
+/**
+ * The batch gradients should add up to the full gradient.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionBatchGradient)
+{
+  const size_t numUsers = 50;
+  const size_t numItems = 50;
+  const size_t numRatings = 100;
+  const size_t maxRating = 5;
+  const size_t rank = 10;
+
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data.row(2) = floor(data.row(2) * maxRating + 0.5);
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+
+  arma::mat parameters = arma::randu(rank, numUsers + numItems);
+  RegularizedSVDFunction rSVDFunc(data, rank, 0.5);
+
+  arma::mat gradient, batchGradient;
+  rSVDFunc.Gradient(parameters, gradient);
+
+  // The regularization of the full gradient is applied once per rating, so
+  // the batches add up to it.
+  arma::mat sum = arma::zeros<arma::mat>(rank, numUsers + numItems);
+  for (size_t begin = 0; begin < numRatings; begin += 16)
+  {
+    rSVDFunc.Gradient(parameters, begin,
+        std::min((size_t) 16, numRatings - begin), batchGradient);
+    sum += batchGradient;
+  }
+
+  for (size_t i = 0; i < gradient.n_elem; i++)
+  {
+    if (std::abs(gradient[i]) <= 1e-6)
+      BOOST_REQUIRE_SMALL(sum[i], 1e-5);
+    else
+      BOOST_REQUIRE_CLOSE(sum[i], gradient[i], 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionOptimize)
 {
   // Define useful constants.
@@ -244,4 +287,73 @@ BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionOptimize)
   BOOST_REQUIRE_SMALL(relativeError, 1e-2);
 }
 
+/**
+ * Make sure RatingTriples stores a coordinate list exactly, and that training
+ * on the triples and streaming the ratings from disk both fit the data.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDRatingTriplesTest)
+{
+  const size_t numUsers = 50;
+  const size_t numItems = 50;
+  const size_t numRatings = 200;
+  const size_t rank = 10;
+
+  arma::mat parameters = arma::randu(rank, numUsers + numItems);
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    data(2, i) = arma::dot(parameters.col(data(0, i)),
+                           parameters.col(numUsers + data(1, i)));
+  }
+
+  RatingTriples ratings(data);
+  BOOST_REQUIRE_EQUAL(ratings.Size(), numRatings);
+  BOOST_REQUIRE_EQUAL(ratings.NumUsers(), numUsers);
+  BOOST_REQUIRE_EQUAL(ratings.NumItems(), numItems);
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    BOOST_REQUIRE_EQUAL(ratings.User(i), (size_t) data(0, i));
+    BOOST_REQUIRE_EQUAL(ratings.Item(i), (size_t) data(1, i));
+    BOOST_REQUIRE_CLOSE(ratings.Rating(i), data(2, i), 1e-4);
+  }
+
+  // Shuffling keeps each triple together.
+  ratings.Shuffle();
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    BOOST_REQUIRE_CLOSE(ratings.Rating(i), arma::dot(
+        parameters.col(ratings.User(i)),
+        parameters.col(numUsers + ratings.Item(i))), 1e-4);
+  }
+
+  RegularizedSVD<> rSVD(100, 0.01, 0.0001);
+  arma::mat u, v;
+  rSVD.Apply(ratings, rank, u, v);
+  BOOST_REQUIRE_EQUAL(u.n_rows, numItems);
+  BOOST_REQUIRE_EQUAL(v.n_cols, numUsers);
+
+  arma::rowvec predictions(numRatings);
+  for (size_t i = 0; i < numRatings; i++)
+    predictions[i] = arma::dot(u.row(data(1, i)), v.col(data(0, i)));
+  BOOST_REQUIRE_SMALL(arma::norm(data.row(2) - predictions, 2) /
+      arma::norm(data.row(2), 2), 0.05);
+
+  // Stream the ratings, in chunks that don't divide them evenly.
+  data::Save("regularized_svd_ratings.csv", data);
+  arma::mat su, sv;
+  rSVD.Apply("regularized_svd_ratings.csv", rank, su, sv, 33);
+  remove("regularized_svd_ratings.csv");
+  BOOST_REQUIRE_EQUAL(su.n_rows, numItems);
+  BOOST_REQUIRE_EQUAL(sv.n_cols, numUsers);
+
+  for (size_t i = 0; i < numRatings; i++)
+    predictions[i] = arma::dot(su.row(data(1, i)), sv.col(data(0, i)));
+  BOOST_REQUIRE_SMALL(arma::norm(data.row(2) - predictions, 2) /
+      arma::norm(data.row(2), 2), 0.05);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
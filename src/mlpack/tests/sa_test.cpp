@@ -125,4 +125,74 @@ BOOST_AUTO_TEST_CASE(RastrigrinFunctionTest)
   BOOST_REQUIRE_GE(successes, 1);
 }
 
+/**
+ * The sum of the squares of the coordinates, with EvaluateDelta(), so that SA
+ * only recomputes the term of the coordinate it moves.
+ */
+class SquaredSumFunction
+{
+ public:
+  SquaredSumFunction(const size_t dim) : dim(dim) { }
+
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    return arma::accu(coordinates % coordinates);
+  }
+
+  double EvaluateDelta(const arma::mat& coordinates,
+                       const size_t i,
+                       const double change) const
+  {
+    return change * (2 * coordinates[i] + change);
+  }
+
+  arma::mat GetInitialPoint() const
+  {
+    return 5 * arma::ones<arma::mat>(dim, 1);
+  }
+
+ private:
+  size_t dim;
+};
+
+/**
+ * SA should minimize a function with EvaluateDelta(), and return its true
+ * objective.
+ */
+BOOST_AUTO_TEST_CASE(EvaluateDeltaTest)
+{
+  SquaredSumFunction f(20);
+  ExponentialSchedule schedule(1e-5);
+  SA<SquaredSumFunction>
+      sa(f, schedule, 10000000, 1000., 1000, 100, 1e-11, 3, 20, 0.3, 0.3);
+  arma::mat coordinates = f.GetInitialPoint();
+
+  const double result = sa.Optimize(coordinates);
+
+  BOOST_REQUIRE_CLOSE(result, f.Evaluate(coordinates), 1e-5);
+  BOOST_REQUIRE_SMALL(result, 1e-6);
+  for (size_t j = 0; j < 20; ++j)
+    BOOST_REQUIRE_SMALL(coordinates[j], 1e-3);
+}
+
+/**
+ * The best of several parallel chains should solve the Rosenbrock function, and
+ * the optimizer should keep the schedule state of the best chain.
+ */
+BOOST_AUTO_TEST_CASE(ParallelChainsRosenbrockTest)
+{
+  RosenbrockFunction f;
+  ExponentialSchedule schedule(1e-5);
+  SA<RosenbrockFunction>
+      sa(f, schedule, 10000000, 1000., 1000, 100, 1e-11, 3, 20, 0.3, 0.3);
+  arma::mat coordinates = f.GetInitialPoint();
+
+  const double result = sa.Optimize(coordinates, 4);
+
+  BOOST_REQUIRE_SMALL(result, 1e-6);
+  BOOST_REQUIRE_LT(sa.Temperature(), 1000.);
+  BOOST_REQUIRE_CLOSE(coordinates[0], 1.0, 1e-3);
+  BOOST_REQUIRE_CLOSE(coordinates[1], 1.0, 1e-3);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -171,4 +171,75 @@ BOOST_AUTO_TEST_CASE(SaveRestoreModelChildClassUsage)
   delete loader;
 }
 
+/**
+ * Make sure the binary format restores parameters, matrices (exactly) and
+ * children.
+ */
+BOOST_AUTO_TEST_CASE(SaveRestoreBinary)
+{
+  size_t s = 12;
+  double d = 3.14159;
+  std::string cc = "Hello world!";
+  std::vector<size_t> numbers;
+  numbers.push_back(3);
+  numbers.push_back(5);
+  arma::mat matrix;
+  matrix.randn(17, 9);
+  arma::vec vector;
+  vector.randu(25);
+
+  SaveRestoreUtility child;
+  child.SaveParameter(ARGSTR(vector));
+
+  SaveRestoreUtility sRM;
+  sRM.SaveParameter(ARGSTR(s));
+  sRM.SaveParameter(ARGSTR(d));
+  sRM.SaveParameter(ARGSTR(cc));
+  sRM.SaveParameter(ARGSTR(numbers));
+  sRM.SaveParameter(ARGSTR(matrix));
+  sRM.AddChild(child, "child");
+
+  BOOST_REQUIRE(sRM.WriteFile("test_save_restore.bin"));
+  BOOST_REQUIRE(SaveRestoreUtility::IsBinaryFile("test_save_restore.bin"));
+
+  SaveRestoreUtility loader;
+  BOOST_REQUIRE(loader.ReadFile("test_save_restore.bin"));
+
+  size_t s2 = 0;
+  double d2 = 0.0;
+  std::string cc2;
+  std::vector<size_t> numbers2;
+  arma::mat matrix2;
+  arma::vec vector2;
+  loader.LoadParameter(s2, "s");
+  loader.LoadParameter(d2, "d");
+  loader.LoadParameter(cc2, "cc");
+  loader.LoadParameter(numbers2, "numbers");
+  loader.LoadParameter(matrix2, "matrix");
+  loader.Children()["child"].LoadParameter(vector2, "vector");
+
+  BOOST_REQUIRE_EQUAL(s2, s);
+  BOOST_REQUIRE_CLOSE(d2, d, 1e-5);
+  BOOST_REQUIRE_EQUAL(cc2, cc);
+  BOOST_REQUIRE_EQUAL(numbers2.size(), 2);
+  BOOST_REQUIRE_EQUAL(numbers2[0], 3);
+  BOOST_REQUIRE_EQUAL(numbers2[1], 5);
+
+  BOOST_REQUIRE_EQUAL(matrix2.n_rows, matrix.n_rows);
+  BOOST_REQUIRE_EQUAL(matrix2.n_cols, matrix.n_cols);
+  for (size_t i = 0; i < matrix.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(matrix2[i], matrix[i]);
+
+  BOOST_REQUIRE_EQUAL(vector2.n_elem, vector.n_elem);
+  for (size_t i = 0; i < vector.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(vector2[i], vector[i]);
+
+  // XML files are not binary files.
+  sRM.WriteFile("test_save_restore.xml");
+  BOOST_REQUIRE(!SaveRestoreUtility::IsBinaryFile("test_save_restore.xml"));
+
+  remove("test_save_restore.bin");
+  remove("test_save_restore.xml");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
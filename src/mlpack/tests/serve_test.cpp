@@ -0,0 +1,368 @@
+/**
+ * @file serve_test.cpp
+ *
+ * Tests for the request queue, the query cache, and the model server.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/serve/model_server.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::serve;
+using namespace mlpack::neighbor;
+
+BOOST_AUTO_TEST_SUITE(ServeTest);
+
+/**
+ * Make sure that PopBatch() groups requests for the same model, command and
+ * parameter, in order, and stops once the batch is full.
+ */
+BOOST_AUTO_TEST_CASE(RequestQueueBatchTest)
+{
+  Request requests[5];
+  const char* models[5] = { "knn", "gmm", "knn", "knn", "knn" };
+  const size_t ks[5] = { 3, 0, 3, 5, 3 };
+  const size_t points[5] = { 2, 1, 4, 1, 10 };
+
+  RequestQueue queue;
+  for (size_t i = 0; i < 5; ++i)
+  {
+    requests[i].model = models[i];
+    requests[i].command = (i == 1) ? "classify" : "knn";
+    requests[i].k = ks[i];
+    requests[i].points.zeros(2, points[i]);
+    queue.Push(requests[i]);
+  }
+  BOOST_REQUIRE_EQUAL(queue.Size(), 5);
+
+  // The first batch is full after requests 0 and 2.
+  std::vector<Request*> batch;
+  BOOST_REQUIRE(queue.PopBatch(batch, 6));
+  BOOST_REQUIRE_EQUAL(batch.size(), 2);
+  BOOST_REQUIRE_EQUAL(batch[0], &requests[0]);
+  BOOST_REQUIRE_EQUAL(batch[1], &requests[2]);
+
+  BOOST_REQUIRE(queue.PopBatch(batch, 6));
+  BOOST_REQUIRE_EQUAL(batch.size(), 1);
+  BOOST_REQUIRE_EQUAL(batch[0], &requests[1]);
+
+  BOOST_REQUIRE(queue.PopBatch(batch, 6));
+  BOOST_REQUIRE_EQUAL(batch.size(), 1);
+  BOOST_REQUIRE_EQUAL(batch[0], &requests[3]);
+
+  // The first request of a batch is taken however many points it has.
+  BOOST_REQUIRE(queue.PopBatch(batch, 6));
+  BOOST_REQUIRE_EQUAL(batch.size(), 1);
+  BOOST_REQUIRE_EQUAL(batch[0], &requests[4]);
+
+  queue.Complete(batch);
+  BOOST_REQUIRE(requests[4].done);
+  BOOST_REQUIRE(!requests[3].done);
+
+  // Once the queue is shut down, requests are refused.
+  queue.Shutdown();
+  BOOST_REQUIRE(!queue.PopBatch(batch, 6));
+  Request late;
+  queue.Push(late);
+  BOOST_REQUIRE(late.done);
+  BOOST_REQUIRE(!late.error.empty());
+}
+
+/**
+ * Make sure that invalid requests are refused before they are queued.
+ */
+BOOST_AUTO_TEST_CASE(ModelServerInvalidRequestTest)
+{
+  arma::mat predictors;
+  predictors.randu(3, 50);
+  arma::vec responses = arma::trans(predictors.row(0));
+
+  ModelServer server;
+  server.AddModel("lr", new LinearRegressionModel(
+      regression::LinearRegression(predictors, responses)));
+  server.Start();
+
+  Request unknownModel;
+  unknownModel.model = "gmm";
+  unknownModel.command = "classify";
+  unknownModel.points.randu(3, 2);
+  server.Handle(unknownModel);
+  BOOST_REQUIRE(unknownModel.done);
+  BOOST_REQUIRE(!unknownModel.error.empty());
+
+  Request unknownCommand;
+  unknownCommand.model = "lr";
+  unknownCommand.command = "classify";
+  unknownCommand.points.randu(3, 2);
+  server.Handle(unknownCommand);
+  BOOST_REQUIRE(!unknownCommand.error.empty());
+
+  Request wrongDimensionality;
+  wrongDimensionality.model = "lr";
+  wrongDimensionality.command = "predict";
+  wrongDimensionality.points.randu(4, 2);
+  server.Handle(wrongDimensionality);
+  BOOST_REQUIRE(!wrongDimensionality.error.empty());
+
+  BOOST_REQUIRE_EQUAL(server.Requests(), 0);
+}
+
+/**
+ * Make sure that served GMMs and linear regression models give the same results
+ * as the models themselves.
+ */
+BOOST_AUTO_TEST_CASE(ModelServerPredictionTest)
+{
+  arma::mat data;
+  data.randu(3, 300);
+  data.cols(0, 149) += 5.0;
+
+  gmm::GMM<> gmm(2, 3);
+  gmm.Estimate(data);
+
+  arma::vec responses = arma::trans(2.0 * data.row(0) - data.row(2) + 1.0);
+  regression::LinearRegression lr(data, responses);
+
+  ModelServer server;
+  server.AddModel("gmm", new GMMModel(gmm));
+  server.AddModel("lr", new LinearRegressionModel(lr));
+  BOOST_REQUIRE_EQUAL(server.Names().size(), 2);
+  server.Start();
+
+  arma::mat points;
+  points.randu(3, 20);
+  points.cols(0, 9) += 5.0;
+
+  Request probability;
+  probability.model = "gmm";
+  probability.command = "probability";
+  probability.points = points;
+  server.Handle(probability);
+  BOOST_REQUIRE(probability.error.empty());
+  BOOST_REQUIRE_EQUAL(probability.results.n_rows, 1);
+  BOOST_REQUIRE_EQUAL(probability.results.n_cols, 20);
+  for (size_t i = 0; i < 20; ++i)
+    BOOST_REQUIRE_CLOSE(probability.results[i],
+        gmm.Probability(points.unsafe_col(i)), 1e-5);
+
+  Request classify;
+  classify.model = "gmm";
+  classify.command = "classify";
+  classify.points = points;
+  server.Handle(classify);
+  arma::Col<size_t> labels;
+  gmm.Classify(points, labels);
+  BOOST_REQUIRE_EQUAL(classify.results.n_cols, 20);
+  for (size_t i = 0; i < 20; ++i)
+    BOOST_REQUIRE_EQUAL((size_t) classify.results[i], labels[i]);
+
+  Request predict;
+  predict.model = "lr";
+  predict.command = "predict";
+  predict.points = points;
+  server.Handle(predict);
+  arma::vec predictions;
+  lr.Predict(points, predictions);
+  BOOST_REQUIRE_EQUAL(predict.results.n_cols, 20);
+  for (size_t i = 0; i < 20; ++i)
+    BOOST_REQUIRE_CLOSE(predict.results[i], predictions[i], 1e-5);
+
+  BOOST_REQUIRE_EQUAL(server.Requests(), 3);
+}
+
+//! The arguments of a thread that sends a request to a server.
+struct Client
+{
+  ModelServer* server;
+  Request request;
+};
+
+//! Send the request of the given Client.
+static void* SendRequest(void* client)
+{
+  Client* c = (Client*) client;
+  c->server->Handle(c->request);
+  return NULL;
+}
+
+/**
+ * Make sure that nearest neighbor requests from several threads, which may be
+ * answered in one batch, give the same results as AllkNN.
+ */
+BOOST_AUTO_TEST_CASE(ModelServerKNNTest)
+{
+  arma::mat references;
+  references.randu(3, 500);
+  std::vector<size_t> oldFromNew;
+  KNNModel::TreeType tree(references, oldFromNew, 10);
+  BOOST_REQUIRE(tree::MappedTree<KNNModel::TreeType>::Save("serve-tree.bin",
+      tree, oldFromNew));
+
+  // The tree rearranged the points, so unmap them again.
+  arma::mat originalReferences(references.n_rows, references.n_cols);
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    originalReferences.col(oldFromNew[i]) = references.col(i);
+
+  arma::mat queries;
+  queries.randu(3, 40);
+  AllkNN allknn(originalReferences, queries);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(5, neighbors, distances);
+
+  // A long delay gives the requests time to be batched.
+  ModelServer server(10000, 100000);
+  server.LoadKNN("knn", "serve-tree.bin", 5);
+  server.Start();
+
+  Client clients[4];
+  pthread_t threads[4];
+  for (size_t t = 0; t < 4; ++t)
+  {
+    clients[t].server = &server;
+    clients[t].request.model = "knn";
+    clients[t].request.command = "knn";
+    clients[t].request.k = 5;
+    clients[t].request.points = queries.cols(10 * t, 10 * t + 9);
+    BOOST_REQUIRE_EQUAL(pthread_create(&threads[t], NULL, SendRequest,
+        &clients[t]), 0);
+  }
+  for (size_t t = 0; t < 4; ++t)
+    pthread_join(threads[t], NULL);
+
+  BOOST_REQUIRE_EQUAL(server.Requests(), 4);
+  BOOST_REQUIRE(server.Batches() >= 1 && server.Batches() <= 4);
+
+  for (size_t t = 0; t < 4; ++t)
+  {
+    const arma::mat& results = clients[t].request.results;
+    BOOST_REQUIRE(clients[t].request.error.empty());
+    BOOST_REQUIRE_EQUAL(results.n_rows, 10);
+    BOOST_REQUIRE_EQUAL(results.n_cols, 10);
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+      for (size_t j = 0; j < 5; ++j)
+      {
+        BOOST_REQUIRE_EQUAL((size_t) results(j, i),
+            neighbors(j, 10 * t + i));
+        BOOST_REQUIRE_CLOSE(results(5 + j, i), distances(j, 10 * t + i),
+            1e-5);
+      }
+    }
+  }
+
+  // A k larger than the reference set is refused.
+  Request tooMany;
+  tooMany.model = "knn";
+  tooMany.command = "knn";
+  tooMany.k = 501;
+  tooMany.points = queries;
+  server.Handle(tooMany);
+  BOOST_REQUIRE(!tooMany.error.empty());
+
+  server.Stop();
+  remove("serve-tree.bin");
+}
+
+/**
+ * Make sure that the QueryCache evicts the least recently used result, and that
+ * the prefix and the resolution are respected.
+ */
+BOOST_AUTO_TEST_CASE(QueryCacheLRUTest)
+{
+  // With one shard, the capacity is exact.
+  QueryCache cache(2, 0.0, 1);
+
+  arma::vec a("1 2"), b("3 4"), c("5 6");
+  arma::vec result;
+  cache.Insert("m", a, arma::vec("1"));
+  cache.Insert("m", b, arma::vec("2"));
+  BOOST_REQUIRE(cache.Lookup("m", a, result)); // Now b is the oldest.
+  BOOST_REQUIRE_EQUAL(result[0], 1.0);
+
+  cache.Insert("m", c, arma::vec("3"));
+  BOOST_REQUIRE(!cache.Lookup("m", b, result));
+  BOOST_REQUIRE(cache.Lookup("m", a, result));
+  BOOST_REQUIRE(cache.Lookup("m", c, result));
+  BOOST_REQUIRE_EQUAL(result[0], 3.0);
+
+  // Another prefix is another key, and exact keys do not match near points.
+  BOOST_REQUIRE(!cache.Lookup("n", a, result));
+  BOOST_REQUIRE(!cache.Lookup("m", arma::vec("1.001 2"), result));
+
+  const CacheStatistics statistics = cache.Statistics();
+  BOOST_REQUIRE_EQUAL(statistics.hits, 3);
+  BOOST_REQUIRE_EQUAL(statistics.misses, 3);
+  BOOST_REQUIRE_EQUAL(statistics.insertions, 3);
+  BOOST_REQUIRE_EQUAL(statistics.evictions, 1);
+  BOOST_REQUIRE_EQUAL(statistics.entries, 2);
+  BOOST_REQUIRE_CLOSE(statistics.HitRate(), 0.5, 1e-5);
+
+  // With a resolution, near-identical points share results.
+  QueryCache rounded(10, 0.1);
+  rounded.Insert("m", a, arma::vec("7"));
+  BOOST_REQUIRE(rounded.Lookup("m", arma::vec("1.01 1.99"), result));
+  BOOST_REQUIRE_EQUAL(result[0], 7.0);
+  BOOST_REQUIRE(!rounded.Lookup("m", arma::vec("1.2 2"), result));
+}
+
+/**
+ * Make sure that a server with a cache gives the same results for repeated
+ * points, without running the model again.
+ */
+BOOST_AUTO_TEST_CASE(ModelServerCacheTest)
+{
+  arma::mat data;
+  data.randu(3, 100);
+  arma::vec responses = arma::trans(data.row(1) - 3.0 * data.row(2));
+  regression::LinearRegression lr(data, responses);
+
+  ModelServer server;
+  server.AddModel("lr", new LinearRegressionModel(lr));
+  server.EnableCache(1000);
+  server.Start();
+
+  arma::mat points;
+  points.randu(3, 10);
+  arma::vec predictions;
+  lr.Predict(points, predictions);
+
+  Request first;
+  first.model = "lr";
+  first.command = "predict";
+  first.points = points.cols(0, 5);
+  server.Handle(first);
+  BOOST_REQUIRE(first.error.empty());
+  BOOST_REQUIRE_EQUAL(server.Requests(), 1);
+
+  // Points 0 to 5 are cached, so only 6 to 9 are run.
+  Request second;
+  second.model = "lr";
+  second.command = "predict";
+  second.points = points;
+  server.Handle(second);
+  BOOST_REQUIRE(second.error.empty());
+  BOOST_REQUIRE_EQUAL(server.Requests(), 2);
+  BOOST_REQUIRE_EQUAL(second.results.n_cols, 10);
+  for (size_t i = 0; i < 10; ++i)
+    BOOST_REQUIRE_CLOSE(second.results[i], predictions[i], 1e-5);
+
+  // Everything is cached now, so the worker is not needed.
+  Request third;
+  third.model = "lr";
+  third.command = "predict";
+  third.points = points.cols(2, 8);
+  server.Handle(third);
+  BOOST_REQUIRE_EQUAL(server.Requests(), 2);
+  for (size_t i = 0; i < 7; ++i)
+    BOOST_REQUIRE_CLOSE(third.results[i], predictions[i + 2], 1e-5);
+
+  const CacheStatistics statistics = server.CacheStats();
+  BOOST_REQUIRE_EQUAL(statistics.hits, 13);
+  BOOST_REQUIRE_EQUAL(statistics.misses, 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -58,4 +58,92 @@ BOOST_AUTO_TEST_CASE(GeneralizedRosenbrockTest)
   }
 }
 
+/**
+ * Check the first updates of each update policy against the formulas.
+ */
+BOOST_AUTO_TEST_CASE(SGDUpdatePoliciesTest)
+{
+  const arma::mat gradient("1.0 -2.0 0.5");
+  const double stepSize = 0.1;
+
+  // The vanilla update is a plain step.
+  arma::mat iterate = arma::zeros<arma::mat>(1, 3);
+  VanillaUpdate vanilla;
+  vanilla.Initialize(1, 3);
+  vanilla.Update(iterate, stepSize, gradient);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(iterate[i], -stepSize * gradient[i], 1e-5);
+
+  // With a constant gradient, the second momentum step is (1 + momentum) times
+  // the first.
+  iterate.zeros();
+  MomentumUpdate momentum(0.5);
+  momentum.Initialize(1, 3);
+  momentum.Update(iterate, stepSize, gradient);
+  momentum.Update(iterate, stepSize, gradient);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(iterate[i], -2.5 * stepSize * gradient[i], 1e-5);
+
+  // The first AdaGrad, RMSProp and Adam steps move each coordinate by about
+  // the same amount, whatever the size of its gradient.
+  iterate.zeros();
+  AdaGradUpdate adaGrad;
+  adaGrad.Initialize(1, 3);
+  adaGrad.Update(iterate, stepSize, gradient);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(std::abs(iterate[i]), stepSize, 1e-3);
+
+  iterate.zeros();
+  RMSPropUpdate rmsProp(0.99);
+  rmsProp.Initialize(1, 3);
+  rmsProp.Update(iterate, stepSize, gradient);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(std::abs(iterate[i]), stepSize / std::sqrt(0.01),
+        1e-3);
+
+  iterate.zeros();
+  AdamUpdate adam;
+  adam.Initialize(1, 3);
+  adam.Update(iterate, stepSize, gradient);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(std::abs(iterate[i]), stepSize, 1e-3);
+    BOOST_REQUIRE_EQUAL((iterate[i] < 0), (gradient[i] > 0));
+  }
+
+  // Initialize() resets the state.
+  iterate.zeros();
+  adam.Initialize(1, 3);
+  adam.Update(iterate, stepSize, gradient);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_REQUIRE_CLOSE(std::abs(iterate[i]), stepSize, 1e-3);
+}
+
+/**
+ * Make sure that each update policy can minimize the simple test function.
+ */
+template<typename UpdatePolicyType>
+void SimpleUpdatePolicyTest(UpdatePolicyType updatePolicy,
+                            const double stepSize)
+{
+  SGDTestFunction f;
+  SGD<SGDTestFunction> s(f, stepSize, 5000000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(coordinates, updatePolicy);
+
+  BOOST_REQUIRE_CLOSE(result, -1.0, 0.5);
+  BOOST_REQUIRE_SMALL(coordinates[0], 1e-2);
+  BOOST_REQUIRE_SMALL(coordinates[1], 1e-2);
+  BOOST_REQUIRE_SMALL(coordinates[2], 1e-2);
+}
+
+BOOST_AUTO_TEST_CASE(SGDTestFunctionUpdatePolicies)
+{
+  SimpleUpdatePolicyTest(MomentumUpdate(0.5), 0.0003);
+  SimpleUpdatePolicyTest(AdaGradUpdate(), 1.0);
+  SimpleUpdatePolicyTest(RMSPropUpdate(), 0.0001);
+  SimpleUpdatePolicyTest(AdamUpdate(), 0.0001);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
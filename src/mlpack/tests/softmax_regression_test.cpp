@@ -33,7 +33,7 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionEvaluate)
     labels(i) = math::RandInt(0, numClasses);
 
   // Create a SoftmaxRegressionFunction. Regularization term ignored.
-  SoftmaxRegressionFunction srf(data, labels, inputSize, numClasses, 0);
+  SoftmaxRegressionFunction<> srf(data, labels, inputSize, numClasses, 0);
 
   // Run a number of trials.
   for(size_t i = 0; i < trials; i++)
@@ -78,9 +78,11 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionRegularizationEvaluate)
     labels(i) = math::RandInt(0, numClasses);
 
   // 3 objects for comparing regularization costs.
-  SoftmaxRegressionFunction srfNoReg(data, labels, inputSize, numClasses, 0);
-  SoftmaxRegressionFunction srfSmallReg(data, labels, inputSize, numClasses, 1);
-  SoftmaxRegressionFunction srfBigReg(data, labels, inputSize, numClasses, 20);
+  SoftmaxRegressionFunction<> srfNoReg(data, labels, inputSize, numClasses, 0);
+  SoftmaxRegressionFunction<> srfSmallReg(data, labels, inputSize, numClasses,
+      1);
+  SoftmaxRegressionFunction<> srfBigReg(data, labels, inputSize, numClasses,
+      20);
 
   // Run a number of trials.
   for (size_t i = 0; i < trials; i++)
@@ -120,8 +122,8 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionGradient)
 
   // 2 objects for 2 terms in the cost function. Each term contributes towards
   // the gradient and thus need to be checked independently.
-  SoftmaxRegressionFunction srf1(data, labels, inputSize, numClasses, 0);
-  SoftmaxRegressionFunction srf2(data, labels, inputSize, numClasses, 20);
+  SoftmaxRegressionFunction<> srf1(data, labels, inputSize, numClasses, 0);
+  SoftmaxRegressionFunction<> srf2(data, labels, inputSize, numClasses, 20);
 
   // Create a random set of parameters.
   arma::mat parameters;
@@ -166,6 +168,88 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionGradient)
   }
 }
 
+/**
+ * The per-example objectives and batch gradients should add up to the full
+ * objective and gradient.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionBatchGradient)
+{
+  const size_t points = 200;
+  const size_t inputSize = 10;
+  const size_t numClasses = 5;
+
+  arma::mat data;
+  data.randu(inputSize, points);
+  arma::vec labels(points);
+  for (size_t i = 0; i < points; i++)
+    labels(i) = math::RandInt(0, numClasses);
+
+  SoftmaxRegressionFunction<> srf(data, labels, inputSize, numClasses, 0.5);
+  BOOST_REQUIRE_EQUAL(srf.NumFunctions(), points);
+
+  arma::mat parameters;
+  parameters.randn(numClasses, inputSize);
+
+  double objective = 0.0;
+  for (size_t i = 0; i < points; i++)
+    objective += srf.Evaluate(parameters, i);
+  BOOST_REQUIRE_CLOSE(objective, srf.Evaluate(parameters), 1e-5);
+
+  // Sum the gradients of uneven batches.
+  arma::mat gradient, batchGradient;
+  arma::mat sum = arma::zeros<arma::mat>(numClasses, inputSize);
+  for (size_t begin = 0; begin < points; begin += 30)
+  {
+    srf.Gradient(parameters, begin, std::min((size_t) 30, points - begin),
+        batchGradient);
+    sum += batchGradient;
+  }
+  srf.Gradient(parameters, gradient);
+
+  for (size_t i = 0; i < gradient.n_elem; i++)
+    BOOST_REQUIRE_CLOSE(sum[i], gradient[i], 1e-5);
+}
+
+/**
+ * EvaluateWithGradient() should give the same objective and gradient as the
+ * per-example functions, also when the examples are split over several blocks.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionEvaluateWithGradient)
+{
+  const size_t points = 1000;
+  const size_t inputSize = 10;
+  const size_t numClasses = 5;
+
+  arma::mat data;
+  data.randu(inputSize, points);
+  arma::vec labels(points);
+  for (size_t i = 0; i < points; i++)
+    labels(i) = math::RandInt(0, numClasses);
+
+  SoftmaxRegressionFunction<> srf(data, labels, inputSize, numClasses, 0.5);
+
+  arma::mat parameters;
+  parameters.randn(numClasses, inputSize);
+
+  double objective = 0.0;
+  arma::mat pointGradient;
+  arma::mat sum = arma::zeros<arma::mat>(numClasses, inputSize);
+  for (size_t i = 0; i < points; i++)
+  {
+    objective += srf.Evaluate(parameters, i);
+    srf.Gradient(parameters, i, pointGradient);
+    sum += pointGradient;
+  }
+
+  arma::mat gradient;
+  BOOST_REQUIRE_CLOSE(srf.EvaluateWithGradient(parameters, gradient),
+      objective, 1e-5);
+  BOOST_REQUIRE_EQUAL(gradient.n_rows, numClasses);
+  BOOST_REQUIRE_EQUAL(gradient.n_cols, inputSize);
+  for (size_t i = 0; i < gradient.n_elem; i++)
+    BOOST_REQUIRE_CLOSE(gradient[i], sum[i], 1e-5);
+}
+
 BOOST_AUTO_TEST_CASE(SoftmaxRegressionTwoClasses)
 {
   const size_t points = 1000;
@@ -298,4 +382,81 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionMultipleClasses)
   BOOST_REQUIRE_CLOSE(testAcc, 100.0, 2.0);
 }
 
+/**
+ * The objective and gradients on sparse and single-precision examples should
+ * match those on the same dense examples.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionSparseFloat)
+{
+  const size_t points = 300;
+  const size_t inputSize = 40;
+  const size_t numClasses = 4;
+
+  arma::sp_mat sparseData;
+  sparseData.sprandu(inputSize, points, 0.1);
+  arma::mat data(sparseData);
+  arma::fmat floatData = arma::conv_to<arma::fmat>::from(data);
+  arma::vec labels(points);
+  for (size_t i = 0; i < points; i++)
+    labels(i) = math::RandInt(0, numClasses);
+
+  SoftmaxRegressionFunction<> srf(data, labels, inputSize, numClasses, 0.5);
+  SoftmaxRegressionFunction<arma::sp_mat> sparseSrf(sparseData, labels,
+      inputSize, numClasses, 0.5);
+  SoftmaxRegressionFunction<arma::fmat> floatSrf(floatData, labels,
+      inputSize, numClasses, 0.5);
+
+  arma::mat parameters;
+  parameters.randn(numClasses, inputSize);
+
+  BOOST_REQUIRE_CLOSE(sparseSrf.Evaluate(parameters), srf.Evaluate(parameters),
+      1e-8);
+  BOOST_REQUIRE_CLOSE(floatSrf.Evaluate(parameters), srf.Evaluate(parameters),
+      1e-3);
+  BOOST_REQUIRE_CLOSE(sparseSrf.Evaluate(parameters, 17),
+      srf.Evaluate(parameters, 17), 1e-8);
+
+  arma::mat gradient, sparseGradient, floatGradient;
+  srf.Gradient(parameters, gradient);
+  sparseSrf.Gradient(parameters, sparseGradient);
+  floatSrf.Gradient(parameters, floatGradient);
+  for (size_t i = 0; i < gradient.n_elem; i++)
+  {
+    BOOST_REQUIRE_SMALL(sparseGradient[i] - gradient[i], 1e-10);
+    BOOST_REQUIRE_SMALL(floatGradient[i] - gradient[i], 1e-5);
+  }
+
+  srf.Gradient(parameters, 50, 70, gradient);
+  sparseSrf.Gradient(parameters, 50, 70, sparseGradient);
+  for (size_t i = 0; i < gradient.n_elem; i++)
+    BOOST_REQUIRE_SMALL(sparseGradient[i] - gradient[i], 1e-10);
+}
+
+/**
+ * Softmax regression should also learn well separated classes from sparse
+ * examples.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionSparseTraining)
+{
+  const size_t points = 400;
+  const size_t inputSize = 50;
+  const size_t numClasses = 5;
+
+  // Each class has its own block of ten features, only some of which are set
+  // for each example.
+  arma::sp_mat data(inputSize, points);
+  arma::vec labels(points);
+  for (size_t i = 0; i < points; i++)
+  {
+    labels(i) = i % numClasses;
+    for (size_t j = 0; j < 10; j += 2)
+      data(10 * (i % numClasses) + j + (i / numClasses) % 2, i) = 1.0;
+  }
+
+  SoftmaxRegression<optimization::L_BFGS, arma::sp_mat> sr(data, labels,
+      inputSize, numClasses, 0.0001);
+
+  BOOST_REQUIRE_CLOSE(sr.ComputeAccuracy(data, labels), 100.0, 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -10,6 +10,7 @@
 // Classes to test.
 #include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
 #include <mlpack/methods/neighbor_search/sort_policies/furthest_neighbor_sort.hpp>
+#include <mlpack/methods/neighbor_search/candidate_heap.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -341,4 +342,97 @@ BOOST_AUTO_TEST_CASE(FnsPointToNodeDistance)
       &node), 0.5, 1e-5);
 }
 
+/**
+ * Insert a lot of random distances into a CandidateHeap with
+ * NearestNeighborSort and make sure the worst candidate is tracked correctly
+ * and that the sorted results are the smallest distances.
+ */
+BOOST_AUTO_TEST_CASE(NnsCandidateHeap)
+{
+  const size_t k = 15;
+  arma::mat distances(k, 2);
+  distances.fill(NearestNeighborSort::WorstDistance());
+  arma::Mat<size_t> neighbors(k, 2);
+  neighbors.fill(size_t() - 1);
+
+  // The first query point will get many candidates; the second will get fewer
+  // than k, so some slots stay empty.
+  arma::vec values;
+  values.randu(200);
+  for (size_t i = 0; i < values.n_elem; ++i)
+  {
+    CandidateHeap<NearestNeighborSort>::Insert(neighbors, distances, 0, i,
+        values[i]);
+
+    // The top of the heap should be the k'th smallest distance so far.
+    if (i + 1 >= k)
+    {
+      arma::vec sorted = arma::sort(values.subvec(0, i));
+      BOOST_REQUIRE_CLOSE(CandidateHeap<NearestNeighborSort>::WorstDistance(
+          distances, 0), sorted[k - 1], 1e-5);
+    }
+  }
+
+  for (size_t i = 0; i < 5; ++i)
+    CandidateHeap<NearestNeighborSort>::Insert(neighbors, distances, 1, i,
+        values[i]);
+
+  CandidateHeap<NearestNeighborSort>::Sort(neighbors, distances);
+
+  arma::uvec order = arma::sort_index(values);
+  for (size_t i = 0; i < k; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors(i, 0), order[i]);
+    BOOST_REQUIRE_CLOSE(distances(i, 0), values[order[i]], 1e-5);
+  }
+
+  arma::uvec smallOrder = arma::sort_index(values.subvec(0, 4));
+  for (size_t i = 0; i < 5; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors(i, 1), smallOrder[i]);
+    BOOST_REQUIRE_CLOSE(distances(i, 1), values[smallOrder[i]], 1e-5);
+  }
+  for (size_t i = 5; i < k; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors(i, 1), size_t() - 1);
+    BOOST_REQUIRE_EQUAL(distances(i, 1), DBL_MAX);
+  }
+}
+
+/**
+ * Make sure that a CandidateHeap with FurthestNeighborSort keeps the largest
+ * distances, and that a candidate at the worst distance (0) still fills an
+ * empty slot.
+ */
+BOOST_AUTO_TEST_CASE(FnsCandidateHeap)
+{
+  arma::mat distances(3, 1);
+  distances.fill(FurthestNeighborSort::WorstDistance());
+  arma::Mat<size_t> neighbors(3, 1);
+  neighbors.fill(size_t() - 1);
+
+  BOOST_REQUIRE(CandidateHeap<FurthestNeighborSort>::Insert(neighbors,
+      distances, 0, 0, 0.0));
+  BOOST_REQUIRE(CandidateHeap<FurthestNeighborSort>::Insert(neighbors,
+      distances, 0, 1, 0.5));
+  BOOST_REQUIRE(CandidateHeap<FurthestNeighborSort>::Insert(neighbors,
+      distances, 0, 2, 0.3));
+  BOOST_REQUIRE(CandidateHeap<FurthestNeighborSort>::Insert(neighbors,
+      distances, 0, 3, 0.9));
+  BOOST_REQUIRE(!CandidateHeap<FurthestNeighborSort>::Insert(neighbors,
+      distances, 0, 4, 0.1));
+
+  BOOST_REQUIRE_CLOSE(CandidateHeap<FurthestNeighborSort>::WorstDistance(
+      distances, 0), 0.3, 1e-5);
+
+  CandidateHeap<FurthestNeighborSort>::Sort(neighbors, distances);
+
+  BOOST_REQUIRE_EQUAL(neighbors(0, 0), 3);
+  BOOST_REQUIRE_EQUAL(neighbors(1, 0), 1);
+  BOOST_REQUIRE_EQUAL(neighbors(2, 0), 2);
+  BOOST_REQUIRE_CLOSE(distances(0, 0), 0.9, 1e-5);
+  BOOST_REQUIRE_CLOSE(distances(1, 0), 0.5, 1e-5);
+  BOOST_REQUIRE_CLOSE(distances(2, 0), 0.3, 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -263,4 +263,88 @@ BOOST_AUTO_TEST_CASE(SparseAutoencoderFunctionGradient)
   }
 }
 
+/**
+ * EvaluateWithGradient() should give the same objective as Evaluate() and the
+ * same gradient as Gradient().
+ */
+BOOST_AUTO_TEST_CASE(SparseAutoencoderFunctionEvaluateWithGradient)
+{
+  const size_t points = 1000;
+  const size_t vSize = 20;
+  const size_t hSize = 10;
+
+  arma::mat data;
+  data.randu(vSize, points);
+
+  SparseAutoencoderFunction saf(data, vSize, hSize, 20, 20);
+
+  arma::mat parameters;
+  parameters.randu(2 * hSize + 1, vSize + 1);
+
+  arma::mat gradient, separateGradient;
+  const double objective = saf.EvaluateWithGradient(parameters, gradient);
+  saf.Gradient(parameters, separateGradient);
+
+  BOOST_REQUIRE_CLOSE(objective, saf.Evaluate(parameters), 1e-5);
+  BOOST_REQUIRE_EQUAL(gradient.n_rows, 2 * hSize + 1);
+  BOOST_REQUIRE_EQUAL(gradient.n_cols, vSize + 1);
+  for (size_t i = 0; i < gradient.n_elem; i++)
+  {
+    if (std::abs(separateGradient[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(gradient[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(gradient[i], separateGradient[i], 1e-5);
+  }
+}
+
+/**
+ * The separable objective and the mini-batch gradient should match the
+ * objective and gradient of a function on just those points.
+ */
+BOOST_AUTO_TEST_CASE(SparseAutoencoderFunctionBatchGradient)
+{
+  const size_t vSize = 10;
+  const size_t hSize = 6;
+
+  arma::mat data;
+  data.randu(vSize, 100);
+
+  SparseAutoencoderFunction saf(data, vSize, hSize, 0.1, 3);
+  BOOST_REQUIRE_EQUAL(saf.NumFunctions(), 100);
+
+  arma::mat parameters;
+  parameters.randu(2 * hSize + 1, vSize + 1);
+
+  // A mini-batch of the points 20 through 49.
+  arma::mat batchData = data.cols(20, 49);
+  SparseAutoencoderFunction batchSaf(batchData, vSize, hSize, 0.1, 3);
+
+  arma::mat gradient, batchGradient;
+  saf.Gradient(parameters, 20, 30, gradient);
+  batchSaf.Gradient(parameters, batchGradient);
+  for (size_t i = 0; i < gradient.n_elem; i++)
+  {
+    if (std::abs(batchGradient[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(gradient[i], 1e-8);
+    else
+      BOOST_REQUIRE_CLOSE(gradient[i], 30 * batchGradient[i], 1e-5);
+  }
+
+  // A single point.
+  arma::mat pointData = data.col(7);
+  SparseAutoencoderFunction pointSaf(pointData, vSize, hSize, 0.1, 3);
+
+  BOOST_REQUIRE_CLOSE(saf.Evaluate(parameters, 7),
+      pointSaf.Evaluate(parameters), 1e-5);
+  saf.Gradient(parameters, 7, gradient);
+  pointSaf.Gradient(parameters, batchGradient);
+  for (size_t i = 0; i < gradient.n_elem; i++)
+  {
+    if (std::abs(batchGradient[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(gradient[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(gradient[i], batchGradient[i], 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
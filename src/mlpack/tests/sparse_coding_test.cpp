@@ -9,6 +9,7 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/sparse_coding/sparse_coding.hpp>
+#include <mlpack/methods/sparse_coding/online_sparse_coding.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -62,7 +63,7 @@ BOOST_AUTO_TEST_CASE(SparseCodingTestCodingStepLasso)
   sc.OptimizeCode();
 
   mat D = sc.Dictionary();
-  mat Z = sc.Codes();
+  mat Z(sc.Codes());
 
   for (uword i = 0; i < nPoints; ++i)
   {
@@ -89,7 +90,7 @@ BOOST_AUTO_TEST_CASE(SparseCodingTestCodingStepElasticNet)
   sc.OptimizeCode();
 
   mat D = sc.Dictionary();
-  mat Z = sc.Codes();
+  mat Z(sc.Codes());
 
   for(uword i = 0; i < nPoints; ++i)
   {
@@ -120,14 +121,56 @@ BOOST_AUTO_TEST_CASE(SparseCodingTestDictionaryStep)
   sc.OptimizeCode();
 
   mat D = sc.Dictionary();
-  mat Z = sc.Codes();
+  mat Z(sc.Codes());
 
-  uvec adjacencies = find(Z);
-  double normGradient = sc.OptimizeDictionary(adjacencies, 1e-15);
+  double normGradient = sc.OptimizeDictionary(1e-15);
 
   BOOST_REQUIRE_SMALL(normGradient, tol);
 }
 
+/**
+ * Make sure that online dictionary learning keeps the atoms in the unit ball,
+ * keeps consistent sufficient statistics, and improves the objective over the
+ * initial dictionary.
+ */
+BOOST_AUTO_TEST_CASE(OnlineSparseCodingTest)
+{
+  const double lambda1 = 0.1;
+  const size_t nAtoms = 25;
+
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+  for (uword i = 0; i < X.n_cols; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  OnlineSparseCoding<NothingInitializer> osc(nAtoms, lambda1);
+  DataDependentRandomInitializer::Initialize(X, nAtoms, osc.Dictionary());
+
+  mat codes;
+  osc.Encode(X, codes);
+  const double initialObjective = osc.Objective(X, codes);
+
+  for (size_t pass = 0; pass < 5; ++pass)
+    for (size_t begin = 0; begin < X.n_cols; begin += 50)
+      osc.Step(X.cols(begin, std::min(begin + 50, (size_t) X.n_cols) - 1));
+
+  BOOST_REQUIRE_EQUAL(osc.Points(), 5 * X.n_cols);
+  BOOST_REQUIRE_EQUAL(osc.Dictionary().n_rows, X.n_rows);
+  BOOST_REQUIRE_EQUAL(osc.Dictionary().n_cols, nAtoms);
+  BOOST_REQUIRE_EQUAL(osc.CodesZT().n_rows, nAtoms);
+  BOOST_REQUIRE_EQUAL(osc.DataZT().n_cols, nAtoms);
+
+  for (size_t j = 0; j < nAtoms; ++j)
+    BOOST_REQUIRE_LE(norm(osc.Dictionary().col(j), 2), 1.0 + 1e-10);
+
+  for (size_t i = 0; i < nAtoms; ++i)
+    for (size_t j = 0; j < nAtoms; ++j)
+      BOOST_REQUIRE_SMALL(osc.CodesZT()(i, j) - osc.CodesZT()(j, i), 1e-10);
+
+  osc.Encode(X, codes);
+  BOOST_REQUIRE_LT(osc.Objective(X, codes), initialObjective);
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SparseCodingTestWhole)
 {
@@ -0,0 +1,278 @@
+/**
+ * @file spill_tree_test.cpp
+ *
+ * Tests for the SpillTree class and the approximate neighbor search with its
+ * defeatist traversers.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/spill_tree.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::tree;
+using namespace mlpack::bound;
+using namespace mlpack::neighbor;
+using namespace mlpack::metric;
+
+BOOST_AUTO_TEST_SUITE(SpillTreeTest);
+
+typedef SpillTree<HRectBound<2> > TreeType;
+
+/**
+ * Check the structure of the subtree rooted at the given node, and count the
+ * number of leaves holding each point.
+ */
+void CheckNode(const TreeType& node, std::vector<size_t>& leafCounts)
+{
+  const arma::mat& dataset = node.Dataset();
+
+  if (node.IsLeaf())
+  {
+    BOOST_REQUIRE_EQUAL(node.NumDescendants(), node.NumPoints());
+    for (size_t i = 0; i < node.NumPoints(); ++i)
+    {
+      BOOST_REQUIRE(node.Bound().Contains(dataset.unsafe_col(node.Point(i))));
+      BOOST_REQUIRE_EQUAL(node.Descendant(i), node.Point(i));
+      ++leafCounts[node.Point(i)];
+    }
+    return;
+  }
+
+  BOOST_REQUIRE_EQUAL(node.NumPoints(), 0);
+  BOOST_REQUIRE_EQUAL(node.NumChildren(), 2);
+  BOOST_REQUIRE_EQUAL(node.Left()->Parent(), &node);
+  BOOST_REQUIRE_EQUAL(node.Right()->Parent(), &node);
+
+  const size_t leftCount = node.Left()->NumDescendants();
+  const size_t rightCount = node.Right()->NumDescendants();
+  BOOST_REQUIRE_GT(leftCount, 0);
+  BOOST_REQUIRE_GT(rightCount, 0);
+  BOOST_REQUIRE_EQUAL(node.NumDescendants(), leftCount + rightCount);
+
+  // The descendants of the left child come first.
+  BOOST_REQUIRE_EQUAL(node.Descendant(0), node.Left()->Descendant(0));
+  BOOST_REQUIRE_EQUAL(node.Descendant(leftCount), node.Right()->Descendant(0));
+
+  // Every point of a child is on its side of the overlap buffer.
+  const size_t d = node.SplitDimension();
+  const double overlap = node.Overlapping() ?
+      node.Tau() * node.Bound()[d].Width() : 0.0;
+  for (size_t i = 0; i < leftCount; ++i)
+  {
+    const size_t point = node.Left()->Descendant(i);
+    BOOST_REQUIRE_LT(dataset(d, point), node.SplitValue() + overlap);
+  }
+  for (size_t i = 0; i < rightCount; ++i)
+  {
+    const size_t point = node.Right()->Descendant(i);
+    BOOST_REQUIRE_GE(dataset(d, point), node.SplitValue() - overlap);
+  }
+
+  CheckNode(*node.Left(), leafCounts);
+  CheckNode(*node.Right(), leafCounts);
+}
+
+/**
+ * Make sure that every point is held by some leaf, and that the points within
+ * the overlap buffers are shared by both children.
+ */
+BOOST_AUTO_TEST_CASE(SpillTreeConstructionTest)
+{
+  arma::mat dataset(3, 1000);
+  dataset.randu();
+
+  TreeType tree(dataset, 0.1, 20);
+
+  BOOST_REQUIRE_EQUAL(&tree.Dataset(), &dataset);
+  BOOST_REQUIRE(!tree.IsLeaf());
+  BOOST_REQUIRE_EQUAL(tree.Parent(), (TreeType*) NULL);
+
+  std::vector<size_t> leafCounts(dataset.n_cols, 0);
+  CheckNode(tree, leafCounts);
+
+  size_t total = 0;
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    BOOST_REQUIRE_GE(leafCounts[i], 1);
+    total += leafCounts[i];
+  }
+
+  // Some points are near a hyperplane, so some points are held twice.
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), total);
+  BOOST_REQUIRE_GT(total, dataset.n_cols);
+
+  // The copy holds the same points.
+  TreeType copy(tree);
+  BOOST_REQUIRE_EQUAL(copy.TreeSize(), tree.TreeSize());
+  BOOST_REQUIRE_EQUAL(copy.Left()->Parent(), &copy);
+  std::vector<size_t> copyCounts(dataset.n_cols, 0);
+  CheckNode(copy, copyCounts);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(copyCounts[i], leafCounts[i]);
+}
+
+/**
+ * Without overlap, a spill tree is a kd-tree: each point is in exactly one
+ * leaf.
+ */
+BOOST_AUTO_TEST_CASE(SpillTreeNoOverlapTest)
+{
+  arma::mat dataset(4, 500);
+  dataset.randu();
+
+  TreeType tree(dataset, 0.0, 10);
+
+  std::vector<size_t> leafCounts(dataset.n_cols, 0);
+  CheckNode(tree, leafCounts);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(leafCounts[i], 1);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), dataset.n_cols);
+}
+
+/**
+ * A dataset of identical points can't be split, so the root is a leaf.
+ */
+BOOST_AUTO_TEST_CASE(SpillTreeDuplicatePointsTest)
+{
+  arma::mat dataset(2, 100);
+  dataset.fill(3.0);
+
+  TreeType tree(dataset, 0.1, 10);
+
+  BOOST_REQUIRE(tree.IsLeaf());
+  BOOST_REQUIRE_EQUAL(tree.NumPoints(), 100);
+}
+
+/**
+ * Check the results of an approximate search against the true neighbors: each
+ * distance must be the distance to the returned neighbor and no better than
+ * the true distance, and most of the true nearest neighbors should be found.
+ */
+void CheckApproximateResults(const arma::mat& querySet,
+                             const arma::mat& referenceSet,
+                             const arma::Mat<size_t>& neighbors,
+                             const arma::mat& distances,
+                             const arma::Mat<size_t>& trueNeighbors,
+                             const arma::mat& trueDistances)
+{
+  BOOST_REQUIRE_EQUAL(neighbors.n_rows, trueNeighbors.n_rows);
+  BOOST_REQUIRE_EQUAL(neighbors.n_cols, trueNeighbors.n_cols);
+
+  size_t found = 0;
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      BOOST_REQUIRE_LT(neighbors(j, i), referenceSet.n_cols);
+      const double distance = EuclideanDistance::Evaluate(
+          querySet.unsafe_col(i), referenceSet.unsafe_col(neighbors(j, i)));
+      BOOST_REQUIRE_SMALL(distances(j, i) - distance, 1e-10);
+      BOOST_REQUIRE_GE(distances(j, i), trueDistances(j, i) - 1e-10);
+      if (j > 0)
+        BOOST_REQUIRE_GE(distances(j, i), distances(j - 1, i));
+    }
+
+    if (neighbors(0, i) == trueNeighbors(0, i))
+      ++found;
+  }
+
+  BOOST_REQUIRE_GT(found, neighbors.n_cols / 2);
+}
+
+/**
+ * Search a spill tree with the defeatist traversers, in single-tree and
+ * dual-tree mode, both monochromatically and bichromatically.
+ */
+BOOST_AUTO_TEST_CASE(SpillTreeDefeatistSearchTest)
+{
+  arma::mat referenceSet(3, 2000);
+  referenceSet.randu();
+  arma::mat querySet(3, 500);
+  querySet.randu();
+
+  // The true neighbors.
+  AllkNN naive(referenceSet, querySet, true);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  naive.Search(3, trueNeighbors, trueDistances);
+
+  AllkNN naiveMono(referenceSet, true);
+  arma::Mat<size_t> trueMonoNeighbors;
+  arma::mat trueMonoDistances;
+  naiveMono.Search(3, trueMonoNeighbors, trueMonoDistances);
+
+  // A wide overlap buffer, so that most true neighbors are found.
+  typedef SpillTree<HRectBound<2>, NeighborSearchStat<NearestNeighborSort> >
+      SearchTreeType;
+  SearchTreeType referenceTree(referenceSet, 0.15, 20);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    const bool singleMode = (mode == 1);
+
+    SpillKNN spill(&referenceTree, referenceSet, singleMode);
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    spill.Search(querySet, 3, neighbors, distances);
+
+    CheckApproximateResults(querySet, referenceSet, neighbors, distances,
+        trueNeighbors, trueDistances);
+
+    // No node is scored; only the base cases of the leaves reached are
+    // evaluated.
+    BOOST_REQUIRE_EQUAL(spill.Statistics().Scores(), 0);
+    BOOST_REQUIRE_LT(spill.Statistics().BaseCases(),
+        querySet.n_cols * referenceSet.n_cols / 10);
+
+    spill.Search(3, neighbors, distances);
+
+    CheckApproximateResults(referenceSet, referenceSet, neighbors, distances,
+        trueMonoNeighbors, trueMonoDistances);
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+      for (size_t j = 0; j < neighbors.n_rows; ++j)
+        BOOST_REQUIRE_NE(neighbors(j, i), i);
+  }
+
+  // The trees built by NeighborSearch itself use the default parameters.
+  SpillKNN spill(referenceSet, querySet);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  spill.Search(3, neighbors, distances);
+  BOOST_REQUIRE_EQUAL(neighbors.n_cols, querySet.n_cols);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    BOOST_REQUIRE_GE(distances[i], trueDistances[i] - 1e-10);
+}
+
+/**
+ * A search with several threads must give the same results as a serial one.
+ */
+BOOST_AUTO_TEST_CASE(SpillTreeThreadedSearchTest)
+{
+  arma::mat referenceSet(4, 1000);
+  referenceSet.randu();
+  arma::mat querySet(4, 300);
+  querySet.randu();
+
+  SpillKNN serial(referenceSet, querySet, false, true);
+  arma::Mat<size_t> serialNeighbors;
+  arma::mat serialDistances;
+  serial.Search(5, serialNeighbors, serialDistances);
+
+  SpillKNN threaded(referenceSet, querySet, false, true);
+  threaded.NumThreads() = 4;
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  threaded.Search(5, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], serialNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], serialDistances[i], 1e-5);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
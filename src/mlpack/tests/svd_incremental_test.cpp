@@ -2,6 +2,7 @@
 #include <mlpack/methods/amf/amf.hpp>
 #include <mlpack/methods/amf/update_rules/svd_incomplete_incremental_learning.hpp>
 #include <mlpack/methods/amf/update_rules/svd_complete_incremental_learning.hpp>
+#include <mlpack/methods/amf/update_rules/svd_parallel_incremental_learning.hpp>
 #include <mlpack/methods/amf/init_rules/random_init.hpp>
 #include <mlpack/methods/amf/termination_policies/incomplete_incremental_termination.hpp>
 #include <mlpack/methods/amf/termination_policies/complete_incremental_termination.hpp>
@@ -116,4 +117,83 @@ BOOST_AUTO_TEST_CASE(SVDIncompleteIncrementalRegularizationTest)
   BOOST_REQUIRE_LT(RMSE_2, RMSE_1);
 }
 
+/**
+ * Make sure the parallel stratified schedule gives the same result as
+ * sequential complete incremental learning over the blocks in stratum order,
+ * for dense and sparse matrices.
+ */
+BOOST_AUTO_TEST_CASE(SVDParallelIncrementalStrataTest)
+{
+  mlpack::math::RandomSeed(10);
+  sp_mat data;
+  data.sprandu(50, 40, 0.3);
+  const mat denseData(data);
+
+  const mat w = randu<mat>(50, 3);
+  const mat h = randu<mat>(3, 40);
+  const size_t p = 3;
+  const double u = 0.01, kw = 0.001, kh = 0.002;
+
+  // Sequential passes, visiting the blocks (b, (b + s) mod p) in order.
+  mat seqW(w), seqH(h);
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    for (size_t s = 0; s < p; ++s)
+    {
+      for (size_t b = 0; b < p; ++b)
+      {
+        const size_t c = (b + s) % p;
+        for (size_t j = 0; j < data.n_cols; ++j)
+        {
+          if (j * p / data.n_cols != c)
+            continue;
+
+          for (sp_mat::const_iterator it = data.begin_col(j);
+               it != data.end_col(j); ++it)
+          {
+            const size_t i = it.row();
+            if (i * p / data.n_rows != b)
+              continue;
+
+            double error = (*it) - dot(seqW.row(i), seqH.col(j));
+            seqW.row(i) += u * (error * trans(seqH.col(j)) - kw * seqW.row(i));
+            error = (*it) - dot(seqW.row(i), seqH.col(j));
+            seqH.col(j) += u * (error * trans(seqW.row(i)) - kh * seqH.col(j));
+          }
+        }
+      }
+    }
+  }
+
+  SVDParallelIncrementalLearning svd(u, kw, kh, p);
+  mat sparseW(w), sparseH(h);
+  svd.Initialize(data, 3);
+  BOOST_REQUIRE_EQUAL(svd.Blocks(), p);
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    svd.WUpdate(data, sparseW, sparseH);
+    svd.HUpdate(data, sparseW, sparseH);
+  }
+
+  SVDParallelIncrementalLearning denseSVD(u, kw, kh, p);
+  mat denseW(w), denseH(h);
+  denseSVD.Initialize(denseData, 3);
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    denseSVD.WUpdate(denseData, denseW, denseH);
+    denseSVD.HUpdate(denseData, denseW, denseH);
+  }
+
+  for (size_t i = 0; i < seqW.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(sparseW[i], seqW[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(denseW[i], seqW[i], 1e-8);
+  }
+  for (size_t i = 0; i < seqH.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(sparseH[i], seqH[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(denseH[i], seqH[i], 1e-8);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
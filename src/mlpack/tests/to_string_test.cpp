@@ -298,7 +298,9 @@ BOOST_AUTO_TEST_CASE(MRKDString)
 {
   arma::mat q(2, 50);
   q.randu();
-  mlpack::tree::MRKDStatistic d(q);
+  mlpack::tree::BinarySpaceTree<mlpack::bound::HRectBound<2>,
+      mlpack::tree::MRKDStatistic> tree(q);
+  const mlpack::tree::MRKDStatistic& d = tree.Stat();
   Log::Debug << d;
   testOstream << d;
   std::string s = d.ToString();
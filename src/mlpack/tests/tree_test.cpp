@@ -6,6 +6,10 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/bounds.hpp>
 #include <mlpack/core/tree/binary_space_tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/binary_space_tree/rp_tree_split.hpp>
+#include <mlpack/core/tree/binary_space_tree/pca_split.hpp>
+#include <mlpack/core/tree/binary_space_tree/vp_tree_split.hpp>
+#include <mlpack/core/tree/binary_space_tree/mapped_tree.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
@@ -13,6 +17,10 @@
 #include <queue>
 #include <stack>
 
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -615,6 +623,58 @@ BOOST_AUTO_TEST_CASE(HRectBoundContains)
   BOOST_REQUIRE(b.Contains(point));
 }
 
+/**
+ * Make sure FixedHRectBound gives the same distances as HRectBound, and that
+ * FixedLMetric gives the same distances as LMetric.
+ */
+BOOST_AUTO_TEST_CASE(FixedHRectBoundTest)
+{
+  arma::mat a;
+  a.randn(3, 10);
+  arma::mat b;
+  b.randn(3, 10);
+  b += 1.0;
+  arma::vec point;
+  point.randn(3);
+
+  HRectBound<2> bound(3), otherBound(3);
+  FixedHRectBound<3> fixedBound(3), fixedOtherBound(3);
+  bound |= a;
+  otherBound |= b;
+  fixedBound |= a;
+  fixedOtherBound |= b;
+
+  for (size_t d = 0; d < 3; ++d)
+  {
+    BOOST_REQUIRE_CLOSE(fixedBound[d].Lo(), bound[d].Lo(), 1e-5);
+    BOOST_REQUIRE_CLOSE(fixedBound[d].Hi(), bound[d].Hi(), 1e-5);
+  }
+  BOOST_REQUIRE_CLOSE(fixedBound.MinWidth(), bound.MinWidth(), 1e-5);
+  BOOST_REQUIRE_CLOSE(fixedBound.Diameter(), bound.Diameter(), 1e-5);
+
+  BOOST_REQUIRE_CLOSE(fixedBound.MinDistance(point), bound.MinDistance(point),
+      1e-5);
+  BOOST_REQUIRE_CLOSE(fixedBound.MaxDistance(point), bound.MaxDistance(point),
+      1e-5);
+  BOOST_REQUIRE_CLOSE(fixedBound.MinDistance(fixedOtherBound),
+      bound.MinDistance(otherBound), 1e-5);
+  BOOST_REQUIRE_CLOSE(fixedBound.MaxDistance(fixedOtherBound),
+      bound.MaxDistance(otherBound), 1e-5);
+  BOOST_REQUIRE_CLOSE(fixedBound.RangeDistance(fixedOtherBound).Hi(),
+      bound.RangeDistance(otherBound).Hi(), 1e-5);
+  BOOST_REQUIRE_CLOSE(fixedBound.RangeDistance(point).Hi(),
+      bound.RangeDistance(point).Hi(), 1e-5);
+
+  for (size_t i = 0; i < a.n_cols; ++i)
+  {
+    BOOST_REQUIRE(fixedBound.Contains(a.col(i)));
+    BOOST_REQUIRE_CLOSE(FixedLMetric<3, 2>::Evaluate(a.col(i), b.col(i)),
+        EuclideanDistance::Evaluate(a.col(i), b.col(i)), 1e-5);
+    BOOST_REQUIRE_CLOSE(FixedLMetric<3, 1, false>::Evaluate(a.col(i),
+        b.col(i)), ManhattanDistance::Evaluate(a.col(i), b.col(i)), 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(TestBallBound)
 {
   BallBound<> b1;
@@ -1219,6 +1279,202 @@ BOOST_AUTO_TEST_CASE(ParentDistanceTestWithMapping)
   }
 }
 
+/**
+ * Build a tree that is large enough to be built in parallel (if OpenMP is
+ * available), and make sure that it is identical to a tree built with only one
+ * thread.
+ */
+BOOST_AUTO_TEST_CASE(ParallelBuildTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 50000);
+  arma::mat serialDataset(dataset);
+  std::vector<size_t> oldFromNew;
+  std::vector<size_t> serialOldFromNew;
+
+  typedef BinarySpaceTree<HRectBound<2> > TreeType;
+  TreeType tree(dataset, oldFromNew);
+
+#ifdef HAS_OPENMP
+  const int numThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+
+  TreeType serialTree(serialDataset, serialOldFromNew);
+
+#ifdef HAS_OPENMP
+  omp_set_num_threads(numThreads);
+#endif
+
+  // The mapping and the reordered dataset must be the same.
+  BOOST_REQUIRE_EQUAL(oldFromNew.size(), serialOldFromNew.size());
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    BOOST_REQUIRE_EQUAL(oldFromNew[i], serialOldFromNew[i]);
+
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(dataset[i], serialDataset[i]);
+
+  // Now walk both trees and make sure they have the same structure.
+  std::stack<TreeType*> nodeStack, serialNodeStack;
+  nodeStack.push(&tree);
+  serialNodeStack.push(&serialTree);
+
+  while (!nodeStack.empty())
+  {
+    TreeType* node = nodeStack.top();
+    TreeType* serialNode = serialNodeStack.top();
+    nodeStack.pop();
+    serialNodeStack.pop();
+
+    BOOST_REQUIRE_EQUAL(node->Begin(), serialNode->Begin());
+    BOOST_REQUIRE_EQUAL(node->Count(), serialNode->Count());
+    BOOST_REQUIRE_EQUAL(node->NumChildren(), serialNode->NumChildren());
+    BOOST_REQUIRE_CLOSE(node->ParentDistance(), serialNode->ParentDistance(),
+        1e-5);
+    BOOST_REQUIRE_CLOSE(node->FurthestDescendantDistance(),
+        serialNode->FurthestDescendantDistance(), 1e-5);
+
+    if (node->NumChildren() == 0)
+      continue;
+
+    BOOST_REQUIRE_EQUAL(node->SplitDimension(), serialNode->SplitDimension());
+
+    nodeStack.push(node->Left());
+    nodeStack.push(node->Right());
+    serialNodeStack.push(serialNode->Left());
+    serialNodeStack.push(serialNode->Right());
+  }
+}
+
+/**
+ * Save a tree to a file, load it with MappedTree, and make sure that the
+ * dataset, the mapping, and the tree are all the same as what was saved.
+ */
+BOOST_AUTO_TEST_CASE(MappedTreeSaveLoadTest)
+{
+  arma::mat dataset;
+  dataset.randu(4, 1000);
+  std::vector<size_t> oldFromNew;
+
+  typedef BinarySpaceTree<HRectBound<2> > TreeType;
+  TreeType tree(dataset, oldFromNew, 5);
+
+  BOOST_REQUIRE(MappedTree<TreeType>::Save("test-tree.bin", tree,
+      oldFromNew));
+
+  MappedTree<TreeType> mappedTree("test-tree.bin");
+
+  BOOST_REQUIRE_EQUAL(mappedTree.Dataset().n_rows, dataset.n_rows);
+  BOOST_REQUIRE_EQUAL(mappedTree.Dataset().n_cols, dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(mappedTree.Dataset()[i], dataset[i]);
+
+  BOOST_REQUIRE_EQUAL(mappedTree.OldFromNew().size(), oldFromNew.size());
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    BOOST_REQUIRE_EQUAL(mappedTree.OldFromNew()[i], oldFromNew[i]);
+
+  // The loaded tree must point at the loaded dataset.
+  BOOST_REQUIRE_EQUAL(&mappedTree.Tree().Dataset(), &mappedTree.Dataset());
+
+  std::stack<TreeType*> nodeStack, mappedNodeStack;
+  nodeStack.push(&tree);
+  mappedNodeStack.push(&mappedTree.Tree());
+
+  while (!nodeStack.empty())
+  {
+    TreeType* node = nodeStack.top();
+    TreeType* mappedNode = mappedNodeStack.top();
+    nodeStack.pop();
+    mappedNodeStack.pop();
+
+    BOOST_REQUIRE_EQUAL(node->Begin(), mappedNode->Begin());
+    BOOST_REQUIRE_EQUAL(node->Count(), mappedNode->Count());
+    BOOST_REQUIRE_EQUAL(node->NumChildren(), mappedNode->NumChildren());
+    BOOST_REQUIRE_EQUAL(node->ParentDistance(), mappedNode->ParentDistance());
+    BOOST_REQUIRE_EQUAL(node->FurthestDescendantDistance(),
+        mappedNode->FurthestDescendantDistance());
+
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+    {
+      BOOST_REQUIRE_EQUAL(node->Bound()[d].Lo(), mappedNode->Bound()[d].Lo());
+      BOOST_REQUIRE_EQUAL(node->Bound()[d].Hi(), mappedNode->Bound()[d].Hi());
+    }
+
+    if (node->NumChildren() == 0)
+      continue;
+
+    BOOST_REQUIRE_EQUAL(node->SplitDimension(), mappedNode->SplitDimension());
+    BOOST_REQUIRE_EQUAL(mappedNode->Left()->Parent(), mappedNode);
+    BOOST_REQUIRE_EQUAL(mappedNode->Right()->Parent(), mappedNode);
+
+    nodeStack.push(node->Left());
+    nodeStack.push(node->Right());
+    mappedNodeStack.push(mappedNode->Left());
+    mappedNodeStack.push(mappedNode->Right());
+  }
+
+  remove("test-tree.bin");
+}
+
+/**
+ * Make sure that a flattened tree has the same structure as the original tree,
+ * and that its nodes are stored contiguously in breadth-first order.
+ */
+BOOST_AUTO_TEST_CASE(FlattenTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 2000);
+
+  typedef BinarySpaceTree<HRectBound<2>, EmptyStatistic> TreeType;
+  TreeType tree(dataset, 10);
+  TreeType flatTree(tree);
+  flatTree.Flatten();
+
+  BOOST_REQUIRE_EQUAL(flatTree.TreeSize(), tree.TreeSize());
+
+  // Walk both trees in breadth-first order.
+  std::queue<TreeType*> nodeQueue, flatNodeQueue;
+  nodeQueue.push(&tree);
+  flatNodeQueue.push(&flatTree);
+  TreeType* last = NULL;
+
+  while (!nodeQueue.empty())
+  {
+    TreeType* node = nodeQueue.front();
+    TreeType* flatNode = flatNodeQueue.front();
+    nodeQueue.pop();
+    flatNodeQueue.pop();
+
+    // Each non-root node should directly follow the previous one.
+    if (last != NULL)
+      BOOST_REQUIRE_EQUAL(flatNode, last + 1);
+    if (flatNode != &flatTree)
+      last = flatNode;
+
+    BOOST_REQUIRE_EQUAL(node->Begin(), flatNode->Begin());
+    BOOST_REQUIRE_EQUAL(node->Count(), flatNode->Count());
+    BOOST_REQUIRE_EQUAL(node->NumChildren(), flatNode->NumChildren());
+    BOOST_REQUIRE_EQUAL(&node->Dataset(), &flatNode->Dataset());
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+    {
+      BOOST_REQUIRE_EQUAL(node->Bound()[d].Lo(), flatNode->Bound()[d].Lo());
+      BOOST_REQUIRE_EQUAL(node->Bound()[d].Hi(), flatNode->Bound()[d].Hi());
+    }
+
+    if (node->NumChildren() == 0)
+      continue;
+
+    BOOST_REQUIRE_EQUAL(flatNode->Left()->Parent(), flatNode);
+    BOOST_REQUIRE_EQUAL(flatNode->Right()->Parent(), flatNode);
+    BOOST_REQUIRE_EQUAL(flatNode->Right(), flatNode->Left() + 1);
+
+    nodeQueue.push(node->Left());
+    nodeQueue.push(node->Right());
+    flatNodeQueue.push(flatNode->Left());
+    flatNodeQueue.push(flatNode->Right());
+  }
+}
+
 // Forward declaration of methods we need for the next test.
 template<typename TreeType, typename MatType>
 bool CheckPointBounds(TreeType& node, const MatType& data);
@@ -1337,6 +1593,40 @@ bool CheckPointBounds(TreeType& node, const MatType& data)
   return result;
 }
 
+/**
+ * Build a kd-tree and a ball tree on sparse data, and make sure that every
+ * point is inside the bound of each node that holds it and that the mapping
+ * back to the original points is right.
+ */
+BOOST_AUTO_TEST_CASE(SparseTreeTest)
+{
+  arma::sp_mat dataset;
+  dataset.sprandu(50, 1000, 0.05);
+  const arma::sp_mat original(dataset);
+
+  std::vector<size_t> oldFromNew;
+  BinarySpaceTree<HRectBound<2>, EmptyStatistic, arma::sp_mat> kdTree(dataset,
+      oldFromNew, 10);
+
+  BOOST_REQUIRE_EQUAL(kdTree.NumDescendants(), 1000);
+  BOOST_REQUIRE(CheckPointBounds(kdTree, dataset));
+  BOOST_REQUIRE_EQUAL(dataset.n_nonzero, original.n_nonzero);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    const arma::vec point(dataset.col(i));
+    const arma::vec originalPoint(original.col(oldFromNew[i]));
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(point[d], originalPoint[d]);
+  }
+
+  arma::sp_mat ballDataset(original);
+  BinarySpaceTree<BallBound<>, EmptyStatistic, arma::sp_mat> ballTree(
+      ballDataset, 10);
+
+  BOOST_REQUIRE_EQUAL(ballTree.NumDescendants(), 1000);
+  BOOST_REQUIRE(CheckPointBounds(ballTree, ballDataset));
+}
+
 /**
  * Exhaustive ball tree test based on #125.
  *
@@ -1394,6 +1684,302 @@ BOOST_AUTO_TEST_CASE(BallTreeTest)
   }
 }
 
+/**
+ * Make sure that the nodes of a tree describe contiguous, nested ranges of
+ * points, that the leaves are not too big, and that the parent pointers are
+ * correct.
+ */
+template<typename TreeType>
+void CheckUpdatedStructure(const TreeType& node)
+{
+  if (node.IsLeaf())
+  {
+    BOOST_REQUIRE_LE(node.Count(), node.MaxLeafSize());
+    return;
+  }
+
+  BOOST_REQUIRE_EQUAL(node.Left()->Parent(), &node);
+  BOOST_REQUIRE_EQUAL(node.Right()->Parent(), &node);
+  BOOST_REQUIRE_EQUAL(node.Left()->Begin(), node.Begin());
+  BOOST_REQUIRE_EQUAL(node.Right()->Begin(), node.Left()->End());
+  BOOST_REQUIRE_EQUAL(node.Right()->End(), node.End());
+  BOOST_REQUIRE_GT(node.Left()->Count(), 0);
+  BOOST_REQUIRE_GT(node.Right()->Count(), 0);
+
+  CheckUpdatedStructure(*node.Left());
+  CheckUpdatedStructure(*node.Right());
+}
+
+/**
+ * Make sure that a tree that has had points inserted or removed still matches
+ * the original dataset it should now hold.
+ */
+template<typename TreeType>
+void CheckUpdatedTree(TreeType& tree,
+                      const arma::mat& dataset,
+                      const arma::mat& original,
+                      const std::vector<size_t>& oldFromNew)
+{
+  BOOST_REQUIRE_EQUAL(dataset.n_cols, original.n_cols);
+  BOOST_REQUIRE_EQUAL(oldFromNew.size(), original.n_cols);
+  BOOST_REQUIRE_EQUAL(tree.Begin(), 0);
+  BOOST_REQUIRE_EQUAL(tree.Count(), original.n_cols);
+
+  // The mapping must be a permutation that gives back the original points.
+  std::vector<size_t> sortedMapping(oldFromNew);
+  std::sort(sortedMapping.begin(), sortedMapping.end());
+  for (size_t i = 0; i < sortedMapping.size(); ++i)
+    BOOST_REQUIRE_EQUAL(sortedMapping[i], i);
+
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    for (size_t j = 0; j < dataset.n_rows; ++j)
+      BOOST_REQUIRE_EQUAL(dataset(j, i), original(j, oldFromNew[i]));
+
+  CheckUpdatedStructure(tree);
+  BOOST_REQUIRE(CheckPointBounds(tree, dataset));
+}
+
+/**
+ * Insert batches of points into a kd-tree, some of them outside of the
+ * original bounds, then remove points, including every point of one leaf, and
+ * check the tree after each step.
+ */
+BOOST_AUTO_TEST_CASE(KdTreeInsertRemoveTest)
+{
+  typedef BinarySpaceTree<HRectBound<2>, EmptyStatistic> TreeType;
+
+  arma::mat original;
+  original.randu(4, 1000);
+  arma::mat dataset(original);
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataset, oldFromNew, 10);
+
+  // The later batches are bigger than half the tree, so nodes get rebuilt.
+  for (size_t batch = 0; batch < 4; ++batch)
+  {
+    arma::mat points;
+    points.randu(4, 200 * (batch + 1));
+    points *= 1.5;
+
+    tree.InsertPoints(points, oldFromNew);
+    original.insert_cols(original.n_cols, points);
+    CheckUpdatedTree(tree, dataset, original, oldFromNew);
+  }
+
+  // Remove every third point.
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < original.n_cols; i += 3)
+    indices.push_back(i);
+
+  tree.RemovePoints(indices, oldFromNew);
+  arma::mat remaining(original.n_rows, original.n_cols - indices.size());
+  for (size_t i = 0, next = 0; i < original.n_cols; ++i)
+    if (i % 3 != 0)
+      remaining.col(next++) = original.col(i);
+  CheckUpdatedTree(tree, dataset, remaining, oldFromNew);
+
+  // Now empty out the leftmost leaf, so that it has to be removed.
+  TreeType* leaf = &tree;
+  while (!leaf->IsLeaf())
+    leaf = leaf->Left();
+
+  std::vector<bool> removed(remaining.n_cols, false);
+  indices.clear();
+  for (size_t i = leaf->Begin(); i < leaf->End(); ++i)
+  {
+    indices.push_back(oldFromNew[i]);
+    removed[oldFromNew[i]] = true;
+  }
+
+  tree.RemovePoints(indices, oldFromNew);
+  original = remaining;
+  remaining.set_size(original.n_rows, original.n_cols - indices.size());
+  for (size_t i = 0, next = 0; i < original.n_cols; ++i)
+    if (!removed[i])
+      remaining.col(next++) = original.col(i);
+  CheckUpdatedTree(tree, dataset, remaining, oldFromNew);
+}
+
+/**
+ * Build a tree with a hyperplane split policy on the given points, and check
+ * the tree and the mapping.  If the points are not distinct, leaves of
+ * identical points may be larger than the maximum leaf size.
+ */
+template<typename TreeType>
+void CheckHyperplaneSplitTree(const arma::mat& original, const bool distinct)
+{
+  arma::mat dataset(original);
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataset, oldFromNew, 10);
+
+  BOOST_REQUIRE_EQUAL(tree.SplitDimension(), (size_t) dataset.n_rows);
+  if (distinct)
+  {
+    CheckUpdatedTree(tree, dataset, original, oldFromNew);
+  }
+  else
+  {
+    BOOST_REQUIRE_EQUAL(tree.NumDescendants(), (size_t) original.n_cols);
+    BOOST_REQUIRE(CheckPointBounds(tree, dataset));
+  }
+}
+
+/**
+ * Build trees with RPTreeSplit and PCASplit, with ball bounds and box bounds,
+ * on points near a plane in 30 dimensions, and on points with many duplicates.
+ */
+BOOST_AUTO_TEST_CASE(HyperplaneSplitTreeTest)
+{
+  arma::mat basis;
+  basis.randn(30, 2);
+  arma::mat coordinates;
+  coordinates.randu(2, 2000);
+  arma::mat noise;
+  noise.randn(30, 2000);
+  const arma::mat planar = basis * coordinates + 0.01 * noise;
+
+  // Only a few distinct points, so most projections are tied.
+  arma::mat duplicates(30, 500);
+  for (size_t i = 0; i < duplicates.n_cols; ++i)
+    duplicates.col(i) = planar.col(i % 7);
+
+  typedef RPTreeSplit<BallBound<>, arma::mat> RPBallSplit;
+  typedef PCASplit<BallBound<>, arma::mat> PCABallSplit;
+  typedef RPTreeSplit<HRectBound<2>, arma::mat> RPRectSplit;
+  typedef PCASplit<HRectBound<2>, arma::mat> PCARectSplit;
+
+  CheckHyperplaneSplitTree<BinarySpaceTree<BallBound<>, EmptyStatistic,
+      arma::mat, RPBallSplit> >(planar, true);
+  CheckHyperplaneSplitTree<BinarySpaceTree<BallBound<>, EmptyStatistic,
+      arma::mat, PCABallSplit> >(planar, true);
+  CheckHyperplaneSplitTree<BinarySpaceTree<HRectBound<2>, EmptyStatistic,
+      arma::mat, RPRectSplit> >(planar, true);
+  CheckHyperplaneSplitTree<BinarySpaceTree<HRectBound<2>, EmptyStatistic,
+      arma::mat, PCARectSplit> >(planar, true);
+
+  CheckHyperplaneSplitTree<BinarySpaceTree<BallBound<>, EmptyStatistic,
+      arma::mat, RPBallSplit> >(duplicates, false);
+  CheckHyperplaneSplitTree<BinarySpaceTree<BallBound<>, EmptyStatistic,
+      arma::mat, PCABallSplit> >(duplicates, false);
+}
+
+/**
+ * Build a kd-tree with a FixedHRectBound, and make sure every point is inside
+ * the bounds of the nodes that hold it.
+ */
+BOOST_AUTO_TEST_CASE(FixedDimensionKDTreeTest)
+{
+  arma::mat dataset;
+  dataset.randu(2, 1000);
+  const arma::mat original(dataset);
+
+  std::vector<size_t> oldFromNew;
+  FixedDimensionKDTree<2>::Type tree(dataset, oldFromNew, 10);
+
+  CheckUpdatedTree(tree, dataset, original, oldFromNew);
+}
+
+/**
+ * Check the distances and containment of a hollow ball bound by hand.
+ */
+BOOST_AUTO_TEST_CASE(HollowBallBoundTest)
+{
+  // A ring around the origin: radius 5, with a hole of radius 2.
+  HollowBallBound<> ring(2.0, 5.0, "0.0 0.0", "0.0 0.0");
+  HollowBallBound<> ball(0.0, 0.5, "0.5 0.0", "0.0 0.0");
+
+  arma::vec origin("0.0 0.0");
+  arma::vec far("10.0 0.0");
+
+  BOOST_REQUIRE_CLOSE(ring.MinDistance(origin), 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(ring.MaxDistance(origin), 5.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(ring.MinDistance(far), 5.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(ring.MaxDistance(far), 15.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(ring.RangeDistance(origin).Lo(), 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(ring.RangeDistance(origin).Hi(), 5.0, 1e-5);
+
+  BOOST_REQUIRE(ring.Contains(arma::vec("3.0 0.0")));
+  BOOST_REQUIRE(!ring.Contains(arma::vec("1.0 0.0")));
+  BOOST_REQUIRE(!ring.Contains(arma::vec("6.0 0.0")));
+
+  // The ball lies in the hole, at least 1 from the ring.
+  BOOST_REQUIRE_CLOSE(ring.MinDistance(ball), 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(ball.MinDistance(ring), 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(ring.MaxDistance(ball), 6.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(ring.RangeDistance(ball).Lo(), 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(ring.RangeDistance(ball).Hi(), 6.0, 1e-5);
+
+  // Adding points keeps the first one as the center and shrinks the hole.
+  HollowBallBound<> b(2);
+  b.HollowCenter() = origin;
+  b.InnerRadius() = DBL_MAX;
+  arma::mat points("1.0 3.0 0.0; 0.0 0.0 2.0");
+  b |= points;
+
+  BOOST_REQUIRE_CLOSE(b.Center()[0], 1.0, 1e-5);
+  BOOST_REQUIRE_SMALL(b.Center()[1], 1e-5);
+  BOOST_REQUIRE_CLOSE(b.OuterRadius(), std::sqrt(5.0), 1e-5);
+  BOOST_REQUIRE_CLOSE(b.InnerRadius(), 1.0, 1e-5);
+}
+
+/**
+ * Build vantage point trees with the Euclidean and Manhattan distances, and
+ * check the tree, the mapping, and the holes of the right children.
+ */
+BOOST_AUTO_TEST_CASE(VPTreeTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 2000);
+
+  typedef HollowBallBound<arma::vec, EuclideanDistance> L2Bound;
+  typedef HollowBallBound<arma::vec, ManhattanDistance> L1Bound;
+  typedef BinarySpaceTree<L2Bound, EmptyStatistic, arma::mat,
+      VPTreeSplit<L2Bound, arma::mat> > L2VPTree;
+  typedef BinarySpaceTree<L1Bound, EmptyStatistic, arma::mat,
+      VPTreeSplit<L1Bound, arma::mat> > L1VPTree;
+
+  CheckHyperplaneSplitTree<L2VPTree>(dataset, true);
+  CheckHyperplaneSplitTree<L1VPTree>(dataset, true);
+
+  // Every point of the right child is at least the inner radius from the
+  // center of the root, which is the vantage point of the root.
+  arma::mat data(dataset);
+  L2VPTree tree(data, 10);
+  BOOST_REQUIRE_GT(tree.Right()->Bound().InnerRadius(), 0.0);
+  for (size_t i = 0; i < tree.Right()->NumDescendants(); ++i)
+  {
+    const double distance = EuclideanDistance::Evaluate(tree.Bound().Center(),
+        data.col(tree.Right()->Descendant(i)));
+    BOOST_REQUIRE_GE(distance, tree.Right()->Bound().InnerRadius());
+  }
+
+  // The points are split at the median distance.
+  BOOST_REQUIRE_EQUAL(tree.Left()->NumDescendants(), (size_t) 1000);
+}
+
+/**
+ * Make sure PCASplit finds the principal direction of points spread along a
+ * line.
+ */
+BOOST_AUTO_TEST_CASE(PCASplitPrincipalDirectionTest)
+{
+  arma::vec line;
+  line.randn(20);
+  line /= arma::norm(line, 2);
+
+  arma::rowvec positions;
+  positions.randn(500);
+  arma::mat noise;
+  noise.randn(20, 500);
+  const arma::mat points = line * positions + 0.01 * noise;
+
+  arma::vec direction;
+  PCASplit<BallBound<>, arma::mat>::PrincipalDirection(points, direction);
+
+  BOOST_REQUIRE_CLOSE(arma::norm(direction, 2), 1.0, 1e-5);
+  BOOST_REQUIRE_GT(std::abs(arma::dot(direction, line)), 0.999);
+}
+
 template<int t_pow>
 bool DoBoundsIntersect(HRectBound<t_pow>& a,
                        HRectBound<t_pow>& b,
@@ -1734,6 +2320,63 @@ BOOST_AUTO_TEST_CASE(CoverTreeConstructionTest)
   CheckSeparation<CoverTree<>, LMetric<2, true> >(tree, tree);
 }
 
+/**
+ * Make sure the node pool hands out separate, correctly sized pieces of memory
+ * and allocates them in blocks.
+ */
+BOOST_AUTO_TEST_CASE(NodePoolTest)
+{
+  typedef arma::vec VecType;
+  NodePool<VecType> pool(100);
+  BOOST_REQUIRE_EQUAL(pool.NumBlocks(), 0);
+
+  std::vector<VecType*> vecs;
+  for (size_t i = 0; i < 250; ++i)
+  {
+    vecs.push_back(new (pool.Allocate()) VecType(3));
+    vecs.back()->fill(i);
+  }
+
+  BOOST_REQUIRE_EQUAL(pool.NumBlocks(), 3);
+  for (size_t i = 0; i < 250; ++i)
+  {
+    BOOST_REQUIRE_EQUAL((*vecs[i])[0], (double) i);
+    BOOST_REQUIRE_EQUAL((*vecs[i])[2], (double) i);
+    vecs[i]->~VecType();
+  }
+}
+
+/**
+ * Build a cover tree big enough that the distances at the top levels are
+ * computed in parallel (if OpenMP is available), and make sure that every point
+ * is still a leaf exactly once.  Copies of the tree do not use the node pool,
+ * so check that a copy is still correct too.
+ */
+BOOST_AUTO_TEST_CASE(LargeCoverTreeConstructionTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 15000);
+
+  CoverTree<> tree(dataset);
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 15000);
+
+  arma::vec counts;
+  counts.zeros(15000);
+  RecurseTreeCountLeaves(tree, counts);
+
+  for (size_t i = 0; i < 15000; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+
+  CheckSelfChild<CoverTree<> >(tree);
+
+  CoverTree<> copy(tree);
+  counts.zeros();
+  RecurseTreeCountLeaves(copy, counts);
+
+  for (size_t i = 0; i < 15000; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+}
+
 /**
  * Test the manual constructor.
  */
@@ -1997,4 +2640,86 @@ BOOST_AUTO_TEST_CASE(CoverTreeDescendantTest)
   CheckDescendants(&tree);
 }
 
+//! Make sure the parent distance of each node is right, and that no descendant
+//! of a node is further away than its furthest descendant distance.
+template<typename TreeType>
+void CheckCoverTreeDistances(const TreeType& node)
+{
+  const arma::mat& dataset = node.Dataset();
+  if (node.Parent() != NULL)
+  {
+    const double parentDistance = EuclideanDistance::Evaluate(
+        dataset.col(node.Parent()->Point()), dataset.col(node.Point()));
+    BOOST_REQUIRE_CLOSE(node.ParentDistance() + 1e-10, parentDistance + 1e-10,
+        1e-5);
+  }
+
+  for (size_t i = 0; i < node.NumDescendants(); ++i)
+  {
+    const double distance = EuclideanDistance::Evaluate(
+        dataset.col(node.Point()), dataset.col(node.Descendant(i)));
+    BOOST_REQUIRE_LE(distance, node.FurthestDescendantDistance() + 1e-10);
+  }
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    BOOST_REQUIRE_LT(node.Child(i).Scale(), node.Scale());
+    CheckCoverTreeDistances(node.Child(i));
+  }
+}
+
+/**
+ * Insert points into a cover tree one at a time and in a block, and make sure
+ * the tree is still valid and holds every point once.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeInsertTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 200);
+
+  CoverTree<> tree(dataset);
+
+  // Some of the new points are far away from the others, so the scale of the
+  // root must be raised, and some are duplicates.
+  arma::mat newPoints;
+  newPoints.randu(3, 300);
+  newPoints.cols(0, 9) *= 10.0;
+  newPoints.cols(10, 19) = dataset.cols(0, 9);
+  dataset.insert_cols(200, newPoints);
+
+  for (size_t i = 200; i < 300; ++i)
+    tree.Insert(i);
+  tree.Insert(300, 200);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 500);
+
+  arma::vec counts;
+  counts.zeros(500);
+  RecurseTreeCountLeaves(tree, counts);
+  for (size_t i = 0; i < 500; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+
+  CheckSelfChild<CoverTree<> >(tree);
+  CheckCovering<CoverTree<>, LMetric<2, true> >(tree);
+  CheckCoverTreeDistances(tree);
+  CheckDescendants(&tree);
+
+  // A tree of one point can grow too.
+  arma::mat single;
+  single.randu(3, 1);
+  CoverTree<> singleTree(single);
+  single.insert_cols(1, dataset.cols(0, 49));
+  singleTree.Insert(1, 50);
+
+  BOOST_REQUIRE_EQUAL(singleTree.NumDescendants(), 51);
+  counts.zeros(51);
+  RecurseTreeCountLeaves(singleTree, counts);
+  for (size_t i = 0; i < 51; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+
+  CheckSelfChild<CoverTree<> >(singleTree);
+  CheckCovering<CoverTree<>, LMetric<2, true> >(singleTree);
+  CheckCoverTreeDistances(singleTree);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -12,7 +12,9 @@
 #include <mlpack/core/tree/tree_traits.hpp>
 #include <mlpack/core/tree/binary_space_tree.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/indexed_binary_space_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/core/tree/spill_tree.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -36,6 +38,8 @@ BOOST_AUTO_TEST_CASE(DefaultsTraitsTest)
   BOOST_REQUIRE_EQUAL(b, true);
   b = TreeTraits<int>::HasSelfChildren;
   BOOST_REQUIRE_EQUAL(b, false);
+  b = TreeTraits<int>::HasDuplicatedPoints;
+  BOOST_REQUIRE_EQUAL(b, false);
 }
 
 // Test the binary space tree traits.
@@ -63,4 +67,48 @@ BOOST_AUTO_TEST_CASE(CoverTreeTraitsTest)
   BOOST_REQUIRE_EQUAL(b, true);
 }
 
+// Test the spill tree traits.
+BOOST_AUTO_TEST_CASE(SpillTreeTraitsTest)
+{
+  typedef SpillTree<bound::HRectBound<2> > TreeType;
+
+  // Children overlap in the overlap buffer.
+  bool b = TreeTraits<TreeType>::HasOverlappingChildren;
+  BOOST_REQUIRE_EQUAL(b, true);
+
+  // Points are not contained at multiple levels.
+  b = TreeTraits<TreeType>::HasSelfChildren;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // The dataset is not rearranged.
+  b = TreeTraits<TreeType>::RearrangesDataset;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // Points may be held by more than one leaf.
+  b = TreeTraits<TreeType>::HasDuplicatedPoints;
+  BOOST_REQUIRE_EQUAL(b, true);
+}
+
+// Test the indexed binary space tree traits.
+BOOST_AUTO_TEST_CASE(IndexedBinarySpaceTreeTraitsTest)
+{
+  typedef IndexedBinarySpaceTree<bound::HRectBound<2> > TreeType;
+
+  // Children are non-overlapping.
+  bool b = TreeTraits<TreeType>::HasOverlappingChildren;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // Points are not contained at multiple levels.
+  b = TreeTraits<TreeType>::HasSelfChildren;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // Only the index array is permuted; the dataset is left alone.
+  b = TreeTraits<TreeType>::RearrangesDataset;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // Each point is held by exactly one leaf.
+  b = TreeTraits<TreeType>::HasDuplicatedPoints;
+  BOOST_REQUIRE_EQUAL(b, false);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
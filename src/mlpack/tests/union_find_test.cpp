@@ -46,4 +46,31 @@ BOOST_AUTO_TEST_CASE(TestUnion)
   BOOST_REQUIRE(testUnionFind_.Find(6) == testUnionFind_.Find(3));
 }
 
+/**
+ * Make sure Flatten() does not change any components, and that Find() gives
+ * the same answers when called from several threads after flattening.
+ */
+BOOST_AUTO_TEST_CASE(TestFlatten)
+{
+  static const size_t testSize = 1000;
+  UnionFind unionFind(testSize);
+
+  for (size_t i = 0; i + 3 < testSize; i += 2)
+    unionFind.Union(i, i + 3);
+
+  arma::Col<size_t> components(testSize);
+  for (size_t i = 0; i < testSize; ++i)
+    components[i] = unionFind.Find(i);
+
+  unionFind.Flatten();
+
+  arma::Col<size_t> flatComponents(testSize);
+  #pragma omp parallel for
+  for (size_t i = 0; i < testSize; ++i)
+    flatComponents[i] = unionFind.Find(i);
+
+  for (size_t i = 0; i < testSize; ++i)
+    BOOST_REQUIRE_EQUAL(flatComponents[i], components[i]);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,359 @@
+/**
+ * @file unique_points_test.cpp
+ *
+ * Tests for the UniquePoints class, and for the expansion of neighbor search
+ * and range search results on unique points.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/neighbor_search/expand_neighbors.hpp>
+#include <mlpack/methods/range_search/range_search.hpp>
+#include <mlpack/methods/range_search/expand_ranges.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::data;
+using namespace mlpack::neighbor;
+using namespace mlpack::range;
+using namespace mlpack::metric;
+
+BOOST_AUTO_TEST_SUITE(UniquePointsTest);
+
+/**
+ * Build a dataset in which the first 60 of the given points appear three times
+ * and the others once, in no particular order.
+ */
+arma::mat Duplicate(const arma::mat& points)
+{
+  arma::mat dataset(points.n_rows, points.n_cols + 120);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    const size_t index = (i < points.n_cols) ? i : (i * 7) % 60;
+    dataset.col(i) = points.col(index);
+  }
+
+  return dataset;
+}
+
+/**
+ * Check the unique points of a small dataset by hand.
+ */
+BOOST_AUTO_TEST_CASE(SimpleUniquePointsTest)
+{
+  arma::mat dataset("1 2 1 0 2 0 1;"
+                    "4 5 4 0 5 0 4");
+  dataset(1, 3) = -0.0;
+  dataset(0, 5) = -0.0;
+
+  UniquePoints unique(dataset);
+
+  BOOST_REQUIRE_EQUAL(unique.NumPoints(), 7);
+  BOOST_REQUIRE_EQUAL(unique.NumUnique(), 3);
+
+  // The unique points are numbered by their first copies, and 0 and -0 are the
+  // same.
+  const size_t uniqueIndices[] = { 0, 1, 0, 2, 1, 2, 0 };
+  for (size_t i = 0; i < 7; ++i)
+    BOOST_REQUIRE_EQUAL(unique.UniqueIndices()[i], uniqueIndices[i]);
+
+  BOOST_REQUIRE_EQUAL(unique.Count(0), 3);
+  BOOST_REQUIRE_EQUAL(unique.Count(1), 2);
+  BOOST_REQUIRE_EQUAL(unique.Count(2), 2);
+  BOOST_REQUIRE_CLOSE(unique.Weights()[0], 3.0, 1e-5);
+
+  BOOST_REQUIRE_EQUAL(unique.Copy(0, 0), 0);
+  BOOST_REQUIRE_EQUAL(unique.Copy(0, 1), 2);
+  BOOST_REQUIRE_EQUAL(unique.Copy(0, 2), 6);
+  BOOST_REQUIRE_EQUAL(unique.Copy(1, 0), 1);
+  BOOST_REQUIRE_EQUAL(unique.Copy(1, 1), 4);
+  BOOST_REQUIRE_EQUAL(unique.Copy(2, 0), 3);
+  BOOST_REQUIRE_EQUAL(unique.Copy(2, 1), 5);
+
+  arma::mat uniqueDataset;
+  unique.Extract(dataset, uniqueDataset);
+  BOOST_REQUIRE_EQUAL(uniqueDataset.n_cols, 3);
+  BOOST_REQUIRE_CLOSE(uniqueDataset(0, 0), 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(uniqueDataset(1, 1), 5.0, 1e-5);
+  BOOST_REQUIRE_SMALL(uniqueDataset(0, 2), 1e-5);
+
+  arma::Col<size_t> values("7 8 9");
+  arma::Col<size_t> expanded;
+  unique.Expand(values, expanded);
+  BOOST_REQUIRE_EQUAL(expanded.n_elem, 7);
+  for (size_t i = 0; i < 7; ++i)
+    BOOST_REQUIRE_EQUAL(expanded[i], values[uniqueIndices[i]]);
+
+  arma::mat expandedColumns;
+  unique.ExpandColumns(uniqueDataset, expandedColumns);
+  for (size_t i = 0; i < dataset.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(expandedColumns[i], dataset[i]);
+}
+
+/**
+ * A dataset without duplicates is its own set of unique points.
+ */
+BOOST_AUTO_TEST_CASE(NoDuplicatesTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 1000);
+
+  UniquePoints unique(dataset);
+  BOOST_REQUIRE_EQUAL(unique.NumUnique(), 1000);
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(unique.UniqueIndices()[i], i);
+    BOOST_REQUIRE_EQUAL(unique.Count(i), 1);
+    BOOST_REQUIRE_EQUAL(unique.Copy(i, 0), i);
+  }
+}
+
+/**
+ * Find the copies of a random dataset with duplicates.
+ */
+BOOST_AUTO_TEST_CASE(RandomDuplicatesTest)
+{
+  arma::mat points;
+  points.randu(4, 500);
+  const arma::mat dataset = Duplicate(points);
+
+  UniquePoints unique(dataset);
+  BOOST_REQUIRE_EQUAL(unique.NumUnique(), 500);
+  BOOST_REQUIRE_EQUAL(arma::accu(unique.Counts()), dataset.n_cols);
+  BOOST_REQUIRE_EQUAL(unique.Offsets()[unique.NumUnique()], dataset.n_cols);
+
+  for (size_t u = 0; u < unique.NumUnique(); ++u)
+  {
+    BOOST_REQUIRE_EQUAL(unique.Count(u), (u < 60) ? 3 : 1);
+    for (size_t c = 0; c < unique.Count(u); ++c)
+    {
+      const size_t copy = unique.Copy(u, c);
+      BOOST_REQUIRE_EQUAL(unique.UniqueIndices()[copy], u);
+      BOOST_REQUIRE_EQUAL(arma::accu(dataset.col(copy) != points.col(u)), 0);
+      if (c > 0)
+        BOOST_REQUIRE_LT(unique.Copy(u, c - 1), copy);
+    }
+  }
+}
+
+/**
+ * Check that the expanded results of a search are k distinct neighbors at the
+ * same distances as the neighbors found by naive search on the whole dataset.
+ */
+void CheckExpandedNeighbors(const arma::mat& referenceSet,
+                            const arma::mat& querySet,
+                            const bool monochromatic,
+                            const arma::Mat<size_t>& neighbors,
+                            const arma::mat& distances,
+                            const arma::mat& naiveDistances)
+{
+  BOOST_REQUIRE_EQUAL(neighbors.n_rows, naiveDistances.n_rows);
+  BOOST_REQUIRE_EQUAL(neighbors.n_cols, naiveDistances.n_cols);
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      if (naiveDistances(j, i) == 0.0)
+        BOOST_REQUIRE_SMALL(distances(j, i), 1e-5);
+      else
+        BOOST_REQUIRE_CLOSE(distances(j, i), naiveDistances(j, i), 1e-5);
+
+      const double distance = EuclideanDistance::Evaluate(querySet.col(i),
+          referenceSet.col(neighbors(j, i)));
+      if (distance == 0.0)
+        BOOST_REQUIRE_SMALL(distances(j, i), 1e-5);
+      else
+        BOOST_REQUIRE_CLOSE(distances(j, i), distance, 1e-5);
+
+      if (monochromatic)
+        BOOST_REQUIRE_NE(neighbors(j, i), i);
+      for (size_t l = 0; l < j; ++l)
+        BOOST_REQUIRE_NE(neighbors(l, i), neighbors(j, i));
+    }
+  }
+}
+
+/**
+ * The expanded results of nearest and furthest neighbor search on the unique
+ * points should match naive search on the whole datasets.
+ */
+BOOST_AUTO_TEST_CASE(ExpandNeighborsTest)
+{
+  arma::mat referencePoints, queryPoints;
+  referencePoints.randu(3, 400);
+  queryPoints.randu(3, 150);
+  const arma::mat referenceSet = Duplicate(referencePoints);
+  const arma::mat querySet = Duplicate(queryPoints);
+
+  UniquePoints uniqueReferences(referenceSet);
+  UniquePoints uniqueQueries(querySet);
+  arma::mat uniqueReferenceSet, uniqueQuerySet;
+  uniqueReferences.Extract(referenceSet, uniqueReferenceSet);
+  uniqueQueries.Extract(querySet, uniqueQuerySet);
+
+  const size_t k = 7;
+  arma::Mat<size_t> naiveNeighbors, uniqueNeighbors, neighbors;
+  arma::mat naiveDistances, uniqueDistances, distances;
+
+  // Bichromatic nearest neighbor search.
+  AllkNN naive(referenceSet, querySet, true);
+  naive.Search(k, naiveNeighbors, naiveDistances);
+
+  AllkNN knn(uniqueReferenceSet, uniqueQuerySet);
+  knn.Search(UniqueNeighbors(k, uniqueReferences, false), uniqueNeighbors,
+      uniqueDistances);
+  ExpandNeighbors<NearestNeighborSort>(uniqueReferences, uniqueQueries, k,
+      uniqueNeighbors, uniqueDistances, neighbors, distances);
+  CheckExpandedNeighbors(referenceSet, querySet, false, neighbors, distances,
+      naiveDistances);
+
+  // Monochromatic nearest neighbor search: each point has its other copies as
+  // neighbors at distance 0.
+  AllkNN naiveMono(referenceSet, true);
+  naiveMono.Search(k, naiveNeighbors, naiveDistances);
+
+  AllkNN knnMono(uniqueReferenceSet);
+  knnMono.Search(UniqueNeighbors(k, uniqueReferences, true), uniqueNeighbors,
+      uniqueDistances);
+  ExpandNeighbors<NearestNeighborSort>(uniqueReferences, k, uniqueNeighbors,
+      uniqueDistances, neighbors, distances);
+  CheckExpandedNeighbors(referenceSet, referenceSet, true, neighbors,
+      distances, naiveDistances);
+
+  // Monochromatic furthest neighbor search.
+  AllkFN naiveFurthest(referenceSet, true);
+  naiveFurthest.Search(k, naiveNeighbors, naiveDistances);
+
+  AllkFN kfn(uniqueReferenceSet);
+  kfn.Search(UniqueNeighbors(k, uniqueReferences, true), uniqueNeighbors,
+      uniqueDistances);
+  ExpandNeighbors<FurthestNeighborSort>(uniqueReferences, k, uniqueNeighbors,
+      uniqueDistances, neighbors, distances);
+  CheckExpandedNeighbors(referenceSet, referenceSet, true, neighbors,
+      distances, naiveDistances);
+}
+
+/**
+ * When there are few unique points, the copies of a point fill its neighbors.
+ */
+BOOST_AUTO_TEST_CASE(ExpandNeighborsFewUniqueTest)
+{
+  arma::mat dataset("0 1 0 0 1 0;"
+                    "0 1 0 0 1 0");
+  UniquePoints unique(dataset);
+  arma::mat uniqueDataset;
+  unique.Extract(dataset, uniqueDataset);
+
+  const size_t k = 4;
+  BOOST_REQUIRE_EQUAL(UniqueNeighbors(k, unique, true), 1);
+
+  AllkNN knn(uniqueDataset, true);
+  arma::Mat<size_t> uniqueNeighbors, neighbors;
+  arma::mat uniqueDistances, distances;
+  knn.Search(1, uniqueNeighbors, uniqueDistances);
+  ExpandNeighbors<NearestNeighborSort>(unique, k, uniqueNeighbors,
+      uniqueDistances, neighbors, distances);
+
+  // Point 0 has the other three copies of (0, 0) at distance 0, and then one of
+  // the copies of (1, 1).
+  BOOST_REQUIRE_EQUAL(neighbors(0, 0), 2);
+  BOOST_REQUIRE_EQUAL(neighbors(1, 0), 3);
+  BOOST_REQUIRE_EQUAL(neighbors(2, 0), 5);
+  BOOST_REQUIRE_EQUAL(neighbors(3, 0), 1);
+  BOOST_REQUIRE_SMALL(distances(2, 0), 1e-5);
+  BOOST_REQUIRE_CLOSE(distances(3, 0), std::sqrt(2.0), 1e-5);
+
+  // Point 1 has its only other copy, and then the copies of (0, 0).
+  BOOST_REQUIRE_EQUAL(neighbors(0, 1), 4);
+  BOOST_REQUIRE_EQUAL(neighbors(1, 1), 0);
+  BOOST_REQUIRE_EQUAL(neighbors(2, 1), 2);
+  BOOST_REQUIRE_EQUAL(neighbors(3, 1), 3);
+  BOOST_REQUIRE_SMALL(distances(0, 1), 1e-5);
+  BOOST_REQUIRE_CLOSE(distances(1, 1), std::sqrt(2.0), 1e-5);
+}
+
+/**
+ * Check that the expanded results of a range search hold the same neighbors as
+ * naive search on the whole dataset.
+ */
+void CheckExpandedRanges(const std::vector<std::vector<size_t> >& neighbors,
+                         const std::vector<std::vector<double> >& distances,
+                         const std::vector<std::vector<size_t> >& naive,
+                         const std::vector<std::vector<double> >& naiveDists)
+{
+  BOOST_REQUIRE_EQUAL(neighbors.size(), naive.size());
+  for (size_t i = 0; i < neighbors.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i].size(), naive[i].size());
+    BOOST_REQUIRE_EQUAL(distances[i].size(), naive[i].size());
+
+    std::vector<std::pair<size_t, double> > sorted, naiveSorted;
+    for (size_t j = 0; j < neighbors[i].size(); ++j)
+    {
+      sorted.push_back(std::make_pair(neighbors[i][j], distances[i][j]));
+      naiveSorted.push_back(std::make_pair(naive[i][j], naiveDists[i][j]));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    std::sort(naiveSorted.begin(), naiveSorted.end());
+
+    for (size_t j = 0; j < sorted.size(); ++j)
+    {
+      BOOST_REQUIRE_EQUAL(sorted[j].first, naiveSorted[j].first);
+      if (naiveSorted[j].second == 0.0)
+        BOOST_REQUIRE_SMALL(sorted[j].second, 1e-5);
+      else
+        BOOST_REQUIRE_CLOSE(sorted[j].second, naiveSorted[j].second, 1e-5);
+    }
+  }
+}
+
+/**
+ * The expanded results of range search on the unique points should match
+ * naive search on the whole datasets, with and without 0 in the range.
+ */
+BOOST_AUTO_TEST_CASE(ExpandRangesTest)
+{
+  arma::mat referencePoints, queryPoints;
+  referencePoints.randu(3, 300);
+  queryPoints.randu(3, 100);
+  const arma::mat referenceSet = Duplicate(referencePoints);
+  const arma::mat querySet = Duplicate(queryPoints);
+
+  UniquePoints uniqueReferences(referenceSet);
+  UniquePoints uniqueQueries(querySet);
+  arma::mat uniqueReferenceSet, uniqueQuerySet;
+  uniqueReferences.Extract(referenceSet, uniqueReferenceSet);
+  uniqueQueries.Extract(querySet, uniqueQuerySet);
+
+  const math::Range ranges[] = { math::Range(0.0, 0.3),
+                                 math::Range(0.2, 0.4) };
+  for (size_t r = 0; r < 2; ++r)
+  {
+    std::vector<std::vector<size_t> > naiveNeighbors, uniqueNeighbors,
+        neighbors;
+    std::vector<std::vector<double> > naiveDistances, uniqueDistances,
+        distances;
+
+    RangeSearch<> naive(referenceSet, querySet, true);
+    naive.Search(ranges[r], naiveNeighbors, naiveDistances);
+
+    RangeSearch<> rs(uniqueReferenceSet, uniqueQuerySet);
+    rs.Search(ranges[r], uniqueNeighbors, uniqueDistances);
+    ExpandRanges(uniqueReferences, uniqueQueries, uniqueNeighbors,
+        uniqueDistances, neighbors, distances);
+    CheckExpandedRanges(neighbors, distances, naiveNeighbors, naiveDistances);
+
+    // Now the monochromatic search.
+    RangeSearch<> naiveMono(referenceSet, true);
+    naiveMono.Search(ranges[r], naiveNeighbors, naiveDistances);
+
+    RangeSearch<> rsMono(uniqueReferenceSet);
+    rsMono.Search(ranges[r], uniqueNeighbors, uniqueDistances);
+    ExpandRanges(uniqueReferences, ranges[r], uniqueNeighbors,
+        uniqueDistances, neighbors, distances);
+    CheckExpandedRanges(neighbors, distances, naiveNeighbors, naiveDistances);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
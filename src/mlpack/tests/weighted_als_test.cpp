@@ -0,0 +1,115 @@
+/**
+ * @file weighted_als_test.cpp
+ *
+ * Tests for the weighted alternating least squares update rule of AMF.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/amf/amf.hpp>
+#include <mlpack/methods/amf/update_rules/weighted_als.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+BOOST_AUTO_TEST_SUITE(WeightedALSTest);
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::amf;
+using namespace arma;
+
+/**
+ * Make sure that a low-rank matrix is recovered from a fifth of its entries.
+ */
+BOOST_AUTO_TEST_CASE(WeightedALSExplicitTest)
+{
+  const mat w = randu<mat>(200, 5);
+  const mat h = randu<mat>(5, 150);
+  const mat full = w * h;
+
+  // Observe a random fifth of the entries.
+  sp_mat mask;
+  mask.sprandu(200, 150, 0.2);
+  sp_mat v(200, 150);
+  for (sp_mat::const_iterator it = mask.begin(); it != mask.end(); ++it)
+    v(it.row(), it.col()) = full(it.row(), it.col());
+
+  SimpleToleranceTermination<sp_mat> termination(1e-8, 200);
+  AMF<SimpleToleranceTermination<sp_mat>, RandomInitialization,
+      WeightedALSUpdate> amf(termination, RandomInitialization(),
+      WeightedALSUpdate(1e-6));
+
+  mat wOut, hOut;
+  amf.Apply(v, 5, wOut, hOut);
+
+  // The error on the observed entries must be small, and the other entries
+  // must be recovered too.
+  double observedError = 0.0;
+  for (sp_mat::const_iterator it = v.begin(); it != v.end(); ++it)
+    observedError += std::pow((*it) - dot(wOut.row(it.row()),
+        hOut.col(it.col())), 2.0);
+  BOOST_REQUIRE_SMALL(std::sqrt(observedError / v.n_nonzero), 0.01);
+
+  const mat reconstruction = wOut * hOut;
+  BOOST_REQUIRE_SMALL(norm(full - reconstruction, "fro") / norm(full, "fro"),
+      0.05);
+}
+
+/**
+ * Make sure that the implicit feedback updates solve the weighted normal
+ * equations, and that dense and sparse matrices give the same updates.
+ */
+BOOST_AUTO_TEST_CASE(WeightedALSImplicitTest)
+{
+  sp_mat v;
+  v.sprandu(60, 40, 0.1);
+  const mat dense(v);
+  const mat w = randu<mat>(60, 4);
+
+  const double lambda = 0.1;
+  const double alpha = 2.0;
+  WeightedALSUpdate update(lambda, true, alpha);
+  update.Initialize(v, 4);
+
+  mat h;
+  update.HUpdate(v, w, h);
+  BOOST_REQUIRE_EQUAL(h.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(h.n_cols, 40);
+
+  for (size_t j = 0; j < dense.n_cols; ++j)
+  {
+    // (W^T C_j W + lambda I) h_j = W^T C_j p_j.
+    const vec confidence = 1.0 + alpha * dense.col(j);
+    const vec preference = conv_to<vec>::from(dense.col(j) != 0);
+    const mat a = trans(w) * diagmat(confidence) * w + lambda * eye<mat>(4, 4);
+    const vec b = trans(w) * (confidence % preference);
+    const vec residual = a * h.col(j) - b;
+    for (size_t k = 0; k < 4; ++k)
+      BOOST_REQUIRE_SMALL(residual[k], 1e-8);
+  }
+
+  WeightedALSUpdate denseUpdate(lambda, true, alpha);
+  denseUpdate.Initialize(dense, 4);
+  mat denseH;
+  denseUpdate.HUpdate(dense, w, denseH);
+  for (size_t i = 0; i < h.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(denseH[i] - h[i], 1e-10);
+
+  // The W update works on the rows of V in the same way.
+  mat wOut;
+  update.WUpdate(v, wOut, h);
+  BOOST_REQUIRE_EQUAL(wOut.n_rows, 60);
+  BOOST_REQUIRE_EQUAL(wOut.n_cols, 4);
+  for (size_t i = 0; i < dense.n_rows; ++i)
+  {
+    const vec row = trans(dense.row(i));
+    const vec confidence = 1.0 + alpha * row;
+    const vec preference = conv_to<vec>::from(row != 0);
+    const mat a = h * diagmat(confidence) * trans(h) + lambda * eye<mat>(4, 4);
+    const vec b = h * (confidence % preference);
+    const vec residual = a * trans(wOut.row(i)) - b;
+    for (size_t k = 0; k < 4; ++k)
+      BOOST_REQUIRE_SMALL(residual[k], 1e-8);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();